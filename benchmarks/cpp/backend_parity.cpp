@@ -0,0 +1,403 @@
+// Copyright © 2025 Apple Inc.
+
+// Reports which primitives each backend implements and how fast, as JSON:
+//
+//   backend_parity [--iters <n>] [--out <file>]
+//
+// Each case builds a small graph with a default shape on the CPU and on the
+// GPU, evaluates it and times it. The primitives of the graph are recorded
+// per device, so that a fast op using its fallback on one backend shows up
+// as different primitives. Every primitive class of the headers, collected
+// by CMake in MLX_PRIMITIVE_NAMES, is reported as "ok", "error" or
+// "untested" for each device.
+
+#include <fstream>
+#include <functional>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <typeinfo>
+#include <unordered_set>
+
+#ifdef __GNUG__
+#include <cxxabi.h>
+#endif
+
+#include "mlx/mlx.h"
+#include "mlx/primitives.h"
+#include "time_utils.h"
+
+namespace mx = mlx::core;
+
+struct Case {
+  std::string name;
+  std::function<std::vector<mx::array>(mx::StreamOrDevice)> fn;
+};
+
+struct Result {
+  std::string status;
+  std::string error;
+  double msec{0};
+  std::set<std::string> primitives;
+};
+
+// The class of a primitive, which unlike its name() is the same for all the
+// ops of e.g. Reduce or BitwiseBinary.
+std::string class_name(const mx::Primitive& p) {
+  std::string name = typeid(p).name();
+#ifdef __GNUG__
+  int status = 0;
+  char* demangled =
+      abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+  if (status == 0) {
+    name = demangled;
+  }
+  std::free(demangled);
+#endif
+  if (auto pos = name.rfind("::"); pos != std::string::npos) {
+    name = name.substr(pos + 2);
+  }
+  return name;
+}
+
+std::set<std::string> graph_primitives(const std::vector<mx::array>& outputs) {
+  std::set<std::string> names;
+  std::unordered_set<std::uintptr_t> visited;
+  std::vector<mx::array> stack(outputs.begin(), outputs.end());
+  while (!stack.empty()) {
+    auto a = stack.back();
+    stack.pop_back();
+    if (!visited.insert(a.id()).second || !a.has_primitive()) {
+      continue;
+    }
+    names.insert(class_name(a.primitive()));
+    for (auto& in : a.inputs()) {
+      stack.push_back(in);
+    }
+  }
+  return names;
+}
+
+// The inputs are made once so that only the op of each case is timed.
+std::vector<Case> make_cases() {
+  using A = std::vector<mx::array>;
+  using S = mx::StreamOrDevice;
+  auto x = mx::random::normal({1024, 1024});
+  auto pos = mx::random::uniform(0.1, 0.9, {1024, 1024});
+  auto ints = mx::random::randint(0, 1 << 20, {1024, 1024});
+  auto a = mx::random::normal({64, 64});
+  auto spd = mx::add(mx::matmul(a, mx::transpose(a)), mx::eye(64) * 64.0f);
+  auto rows = mx::random::randint(0, 1024, {4096}, mx::uint32);
+  auto cols = mx::random::randint(0, 1024, {1024, 16}, mx::uint32);
+  auto col_updates = mx::random::normal({1024, 16});
+  auto row_updates = mx::random::normal({4096, 1, 1024});
+  auto mask = mx::random::bernoulli(mx::array(0.5f), {32, 32});
+  auto image = mx::random::normal({8, 64, 64, 32});
+  auto kernel = mx::random::normal({64, 3, 3, 32});
+  auto tokens = mx::random::normal({256, 1, 512});
+  auto experts = mx::random::normal({8, 512, 512});
+  auto expert_idx = mx::random::randint(0, 8, {256}, mx::uint32);
+  auto quantized = mx::quantize(x, 64, 4);
+  auto qw = std::get<0>(quantized);
+  auto qscales = std::get<1>(quantized);
+  auto qbiases = std::get<2>(quantized);
+  auto heads = mx::random::normal({1, 32, 256, 128});
+  auto ones = mx::ones({1024});
+  mx::eval(
+      x,
+      pos,
+      ints,
+      spd,
+      rows,
+      cols,
+      col_updates,
+      row_updates,
+      mask,
+      image,
+      kernel,
+      tokens,
+      experts,
+      expert_idx,
+      qw,
+      qscales,
+      qbiases,
+      heads,
+      ones);
+
+  auto unary = [](std::string name, auto op, mx::array in) {
+    return Case{name, [op, in](S s) { return A{op(in, s)}; }};
+  };
+  auto binary = [](std::string name, auto op, mx::array in) {
+    return Case{name, [op, in](S s) { return A{op(in, in, s)}; }};
+  };
+  auto one = mx::array(1.0f);
+
+  return {
+      unary("abs", mx::abs, x),
+      binary("add", mx::add, x),
+      {"addmm", [=](S s) { return A{mx::addmm(x, x, x, 1.0f, 1.0f, s)}; }},
+      {"arange", [](S s) { return A{mx::arange(1 << 20, mx::float32, s)}; }},
+      unary("arccos", mx::arccos, pos),
+      unary("arccosh", mx::arccosh, mx::add(pos, one)),
+      unary("arcsin", mx::arcsin, pos),
+      unary("arcsinh", mx::arcsinh, x),
+      unary("arctan", mx::arctan, x),
+      binary("arctan2", mx::arctan2, x),
+      unary("arctanh", mx::arctanh, pos),
+      {"argpartition",
+       [=](S s) { return A{mx::argpartition(x, 16, -1, s)}; }},
+      {"argmax", [=](S s) { return A{mx::argmax(x, -1, false, s)}; }},
+      {"argsort", [=](S s) { return A{mx::argsort(x, -1, s)}; }},
+      {"astype", [=](S s) { return A{mx::astype(x, mx::float16, s)}; }},
+      {"as_strided",
+       [=](S s) {
+         auto y = mx::as_strided(x, {512, 1024}, {2048, 1}, 0, s);
+         return A{mx::contiguous(y, false, s)};
+       }},
+      binary("bitwise_and", mx::bitwise_and, ints),
+      unary("bitwise_invert", mx::bitwise_invert, ints),
+      {"block_masked_mm",
+       [=](S s) {
+         return A{mx::block_masked_mm(
+             x, x, 32, mask, std::nullopt, std::nullopt, s)};
+       }},
+      {"broadcast",
+       [=](S s) {
+         auto col = mx::slice(x, mx::Shape{0, 0}, mx::Shape{1024, 1}, s);
+         auto y = mx::broadcast_to(col, {1024, 1024}, s);
+         return A{mx::contiguous(y, false, s)};
+       }},
+      unary("ceil", mx::ceil, x),
+      {"concatenate", [=](S s) { return A{mx::concatenate({x, x}, 0, s)}; }},
+      {"conv2d",
+       [=](S s) {
+         return A{mx::conv2d(image, kernel, {1, 1}, {1, 1}, {1, 1}, 1, s)};
+       }},
+      {"copy", [=](S s) { return A{mx::copy(mx::transpose(x, s), s)}; }},
+      unary("cos", mx::cos, x),
+      unary("cosh", mx::cosh, x),
+      {"cumsum", [=](S s) { return A{mx::cumsum(x, -1, false, true, s)}; }},
+      binary("divide", mx::divide, pos),
+      {"divmod", [=](S s) { return mx::divmod(pos, pos, s); }},
+      binary("equal", mx::equal, x),
+      unary("erf", mx::erf, x),
+      unary("erfinv", mx::erfinv, pos),
+      unary("exp", mx::exp, x),
+      unary("expm1", mx::expm1, x),
+      {"fft", [=](S s) { return A{mx::fft::fft(x, -1, s)}; }},
+      unary("floor", mx::floor, x),
+      {"full",
+       [](S s) { return A{mx::full({1024, 1024}, 1.0f, mx::float32, s)}; }},
+      {"gather", [=](S s) { return A{mx::take(x, rows, 0, s)}; }},
+      {"gather_axis",
+       [=](S s) { return A{mx::take_along_axis(x, cols, -1, s)}; }},
+      {"gather_mm",
+       [=](S s) {
+         return A{mx::gather_mm(
+             tokens, experts, std::nullopt, expert_idx, false, s)};
+       }},
+      binary("greater", mx::greater, x),
+      {"hadamard",
+       [=](S s) { return A{mx::hadamard_transform(x, std::nullopt, s)}; }},
+      unary("log", mx::log, pos),
+      unary("log1p", mx::log1p, pos),
+      binary("logaddexp", mx::logaddexp, x),
+      {"logsumexp", [=](S s) { return A{mx::logsumexp(x, -1, false, s)}; }},
+      binary("logical_and", mx::logical_and, x),
+      {"matmul", [=](S s) { return A{mx::matmul(x, x, s)}; }},
+      binary("maximum", mx::maximum, x),
+      binary("multiply", mx::multiply, x),
+      unary("negative", mx::negative, x),
+      {"pad",
+       [=](S s) {
+         return A{mx::pad(x, 4, mx::array(0.0f), "constant", s)};
+       }},
+      binary("power", mx::power, pos),
+      {"quantized_matmul",
+       [=](S s) {
+         return A{mx::quantized_matmul(
+             x, qw, qscales, qbiases, true, 64, 4, s)};
+       }},
+      {"random_bits",
+       [](S s) {
+         return A{mx::random::bits({1024, 1024}, 4, std::nullopt, s)};
+       }},
+      binary("remainder", mx::remainder, pos),
+      {"round", [=](S s) { return A{mx::round(x, 0, s)}; }},
+      unary("rsqrt", mx::rsqrt, pos),
+      {"scatter",
+       [=](S s) { return A{mx::scatter_add(x, rows, row_updates, 0, s)}; }},
+      {"scatter_axis",
+       [=](S s) {
+         return A{mx::put_along_axis(x, cols, col_updates, -1, s)};
+       }},
+      {"select",
+       [=](S s) {
+         auto cond = mx::greater(x, mx::array(0.0f), s);
+         return A{mx::where(cond, x, pos, s)};
+       }},
+      unary("sigmoid", mx::sigmoid, x),
+      unary("sign", mx::sign, x),
+      unary("sin", mx::sin, x),
+      {"slice_update",
+       [=](S s) {
+         auto y = mx::slice(x, mx::Shape{0, 0}, mx::Shape{512, 512}, s);
+         return A{mx::slice_update(
+             x, y, mx::Shape{512, 512}, mx::Shape{1024, 1024}, s)};
+       }},
+      {"softmax", [=](S s) { return A{mx::softmax(x, -1, false, s)}; }},
+      {"sort", [=](S s) { return A{mx::sort(x, -1, s)}; }},
+      unary("sqrt", mx::sqrt, pos),
+      unary("square", mx::square, x),
+      {"sum", [=](S s) { return A{mx::sum(x, -1, false, s)}; }},
+      {"max", [=](S s) { return A{mx::max(x, 0, false, s)}; }},
+      unary("tan", mx::tan, pos),
+      unary("tanh", mx::tanh, x),
+      {"view", [=](S s) { return A{mx::view(x, mx::int32, s)}; }},
+      {"cholesky",
+       [=](S s) { return A{mx::linalg::cholesky(spd, false, s)}; }},
+      {"inv", [=](S s) { return A{mx::linalg::inv(spd, s)}; }},
+      {"qr",
+       [=](S s) {
+         auto [q, r] = mx::linalg::qr(spd, s);
+         return A{q, r};
+       }},
+      {"svd", [=](S s) { return mx::linalg::svd(spd, s); }},
+      {"eigh",
+       [=](S s) {
+         auto [w, v] = mx::linalg::eigh(spd, "L", s);
+         return A{w, v};
+       }},
+      {"eig",
+       [=](S s) {
+         auto [w, v] = mx::linalg::eig(spd, s);
+         return A{w, v};
+       }},
+      {"rms_norm",
+       [=](S s) { return A{mx::fast::rms_norm(x, ones, 1e-5f, s)}; }},
+      {"layer_norm",
+       [=](S s) {
+         return A{mx::fast::layer_norm(x, ones, ones, 1e-5f, s)};
+       }},
+      {"rope",
+       [=](S s) {
+         return A{mx::fast::rope(heads, 128, false, 10000.0f, 1.0f, 0, {}, s)};
+       }},
+      {"scaled_dot_product_attention",
+       [=](S s) {
+         return A{mx::fast::scaled_dot_product_attention(
+             heads, heads, heads, 0.088f, "causal", {}, 0, 0, s)};
+       }},
+  };
+}
+
+Result run_case(const Case& c, mx::Device device, int num_iters) {
+  Result r;
+  try {
+    auto outputs = c.fn(device);
+    r.primitives = graph_primitives(outputs);
+    mx::eval(outputs);
+    auto samples = time_samples(2, num_iters, [&]() { return c.fn(device); });
+    r.msec = percentile(samples, 50);
+    r.status = "ok";
+  } catch (const std::exception& e) {
+    r.status = "error";
+    r.error = e.what();
+  }
+  return r;
+}
+
+std::string quote(const std::string& s) {
+  std::ostringstream out;
+  out << '"';
+  for (char c : s) {
+    if (c == '"' || c == '\\') {
+      out << '\\' << c;
+    } else if (c == '\n') {
+      out << "\\n";
+    } else {
+      out << c;
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+int main(int argc, char** argv) {
+  int num_iters = 10;
+  std::string out_path;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--iters" && i + 1 < argc) {
+      num_iters = std::atoi(argv[++i]);
+    } else if (arg == "--out" && i + 1 < argc) {
+      out_path = argv[++i];
+    } else {
+      std::cerr << "Usage: backend_parity [--iters <n>] [--out <file>]"
+                << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<std::pair<std::string, mx::Device>> devices = {
+      {"cpu", mx::Device::cpu}};
+  if (mx::is_available(mx::Device::gpu)) {
+    devices.push_back({"gpu", mx::Device::gpu});
+  }
+
+  // The status of each primitive on each device, a primitive which is in
+  // some successful case is "ok".
+  std::map<std::string, std::map<std::string, std::string>> status;
+  std::istringstream names(MLX_PRIMITIVE_NAMES);
+  for (std::string name; std::getline(names, name, ',');) {
+    for (auto& [d, _] : devices) {
+      status[name][d] = "untested";
+    }
+  }
+
+  std::ostringstream json;
+  json << "{\n  \"cases\": [";
+  auto cases = make_cases();
+  for (int i = 0; i < cases.size(); ++i) {
+    json << (i ? ",\n" : "\n") << "    {\"name\": " << quote(cases[i].name);
+    for (auto& [d, device] : devices) {
+      auto r = run_case(cases[i], device, num_iters);
+      json << ", " << quote(d) << ": {\"status\": " << quote(r.status);
+      if (r.status == "ok") {
+        json << ", \"msec\": " << r.msec;
+      } else {
+        json << ", \"error\": " << quote(r.error);
+      }
+      json << ", \"primitives\": [";
+      int j = 0;
+      for (auto& p : r.primitives) {
+        json << (j++ ? ", " : "") << quote(p);
+        auto& st = status[p][d];
+        if (st != "ok") {
+          st = r.status;
+        }
+      }
+      json << "]}";
+    }
+    json << "}";
+  }
+  json << "\n  ],\n  \"primitives\": {";
+  int i = 0;
+  for (auto& [name, per_device] : status) {
+    json << (i++ ? ",\n" : "\n") << "    " << quote(name) << ": {";
+    int j = 0;
+    for (auto& [d, st] : per_device) {
+      json << (j++ ? ", " : "") << quote(d) << ": " << quote(st);
+    }
+    json << "}";
+  }
+  json << "\n  }\n}\n";
+
+  if (out_path.empty()) {
+    std::cout << json.str();
+  } else {
+    std::ofstream(out_path) << json.str();
+  }
+  return 0;
+}
@@ -0,0 +1,110 @@
+// Copyright © 2025 Apple Inc.
+
+// Measures the overhead of dispatching tiny ops to the GPU, with chains of
+// ops too small for their kernels to matter, uncompiled and compiled, and
+// for several numbers of ops per graph:
+//
+//   dispatch [--ops <n>] [--iters <n>]
+//
+// The time per op is split with mx::cu::dispatch_info into the host time
+// of the primitives, of updating, instantiating and launching the graphs,
+// the GPU time of a node and the time of retiring the graphs.
+
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+namespace mx = mlx::core;
+
+struct Options {
+  int num_ops{1000};
+  int num_iters{20};
+};
+
+mx::array chain(const mx::array& x, int num_ops) {
+  auto y = x;
+  for (int i = 0; i < num_ops; ++i) {
+    y = (i % 2) ? y * 1.0001f : y + 1.0f;
+  }
+  return y;
+}
+
+void print_header() {
+  std::cout << std::left << std::setw(12) << "mode" << std::setw(12)
+            << "ops/graph" << std::right << std::setw(10) << "us/op"
+            << std::setw(10) << "dispatch" << std::setw(10) << "update"
+            << std::setw(10) << "instant" << std::setw(10) << "launch"
+            << std::setw(10) << "gpu" << std::setw(10) << "retire"
+            << std::setw(10) << "graphs" << std::endl;
+}
+
+void run(
+    const std::string& mode,
+    const std::string& ops_per_graph,
+    std::function<mx::array()> fn,
+    const Options& opts) {
+  for (int i = 0; i < 3; ++i) {
+    mx::eval(fn());
+  }
+  bool cuda = mx::cu::is_available();
+  if (cuda) {
+    mx::cu::reset_dispatch_info();
+  }
+  auto samples = time_samples(0, opts.num_iters, fn);
+  mx::synchronize();
+  double num_ops = static_cast<double>(opts.num_ops) * opts.num_iters;
+  std::cout << std::left << std::setw(12) << mode << std::setw(12)
+            << ops_per_graph << std::right << std::fixed
+            << std::setprecision(2) << std::setw(10)
+            << percentile(samples, 50) * 1e3 / opts.num_ops;
+  if (cuda) {
+    auto info = mx::cu::dispatch_info();
+    double gpu_nodes = std::max(info["gpu_nodes"], 1.0);
+    std::cout << std::setw(10) << info["dispatch_us"] / num_ops
+              << std::setw(10) << info["update_us"] / num_ops << std::setw(10)
+              << info["instantiate_us"] / num_ops << std::setw(10)
+              << info["launch_us"] / num_ops << std::setw(10)
+              << info["gpu_us"] / gpu_nodes << std::setw(10)
+              << info["retire_us"] / num_ops << std::setw(10)
+              << static_cast<size_t>(info["graphs"]);
+  }
+  std::cout << std::endl;
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--ops") && has_value) {
+      opts.num_ops = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--iters") && has_value) {
+      opts.num_iters = std::stoi(argv[++i]);
+    } else {
+      std::cerr << "Unknown argument " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  auto x = mx::zeros({16}, mx::float32);
+  mx::eval(x);
+  int num_ops = opts.num_ops;
+  auto compiled = mx::compile([num_ops](const std::vector<mx::array>& in) {
+    return std::vector<mx::array>{chain(in[0], num_ops)};
+  });
+
+  print_header();
+  // The command encoders read MLX_MAX_OPS_PER_BUFFER when they are created,
+  // so each value is run on a new stream. 0 is the adaptive default.
+  for (int ops_per_graph : {0, 10, 100, 1000}) {
+    setenv("MLX_MAX_OPS_PER_BUFFER", std::to_string(ops_per_graph).c_str(), 1);
+    mx::set_default_stream(mx::new_stream(mx::Device::gpu));
+    auto label = ops_per_graph ? std::to_string(ops_per_graph) : "adaptive";
+    run("eager", label, [&]() { return chain(x, num_ops); }, opts);
+    run("compiled", label, [&]() { return compiled({x})[0]; }, opts);
+  }
+  return 0;
+}
@@ -0,0 +1,207 @@
+// Copyright © 2025 Apple Inc.
+
+// Measures the latency and the bandwidth of the collectives of a
+// distributed backend for message sizes doubling from --min-bytes to
+// --max-bytes, in the way of nccl-tests. Launch it on every process with
+// mlx.launch, the arguments after -- are the ones of the benchmark:
+//
+//   mlx.launch --hostfile hosts.json --backend ring -- distributed_bench
+//       [--backend any|ring|mpi|nccl] [--op all|all_sum|all_gather|sendrecv]
+//       [--min-bytes 8] [--max-bytes 1G] [--iters 20] [--warmup 5]
+//
+// With the default --backend any the first backend that the processes were
+// launched for is used, in the order ring, MPI and NCCL.
+//
+// The sizes are the bytes of the output of a process. The time of a size is
+// the mean time of an op on the slowest process, the algorithm bandwidth is
+// the size over the time and the bus bandwidth scales it by the share of
+// the data crossing the links of a ring, 2 (n - 1) / n for all_sum and
+// (n - 1) / n for all_gather. The bus bandwidths of the ops are comparable
+// to each other and to the speed of the slowest link.
+
+#include <cstring>
+#include <functional>
+#include <numeric>
+#include <string>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+namespace mx = mlx::core;
+namespace dist = mlx::core::distributed;
+
+struct Options {
+  std::string backend{"any"};
+  std::string op{"all"};
+  size_t min_bytes{8};
+  size_t max_bytes{size_t(1) << 30};
+  int num_iters{20};
+  int num_warmup{5};
+};
+
+// The bytes in |s| with an optional K, M or G suffix.
+size_t parse_bytes(const std::string& s) {
+  size_t pos;
+  size_t bytes = std::stoull(s, &pos);
+  switch (pos < s.size() ? s[pos] : ' ') {
+    case 'G':
+    case 'g':
+      bytes <<= 10;
+      [[fallthrough]];
+    case 'M':
+    case 'm':
+      bytes <<= 10;
+      [[fallthrough]];
+    case 'K':
+    case 'k':
+      bytes <<= 10;
+    default:
+      break;
+  }
+  return bytes;
+}
+
+// Initialize the requested backend, or the first one of the launched
+// processes for "any", and return its name with the group.
+std::pair<std::string, dist::Group> init(const std::string& backend) {
+  if (backend != "any") {
+    return {backend, dist::init(true, backend)};
+  }
+  for (auto bk : {"ring", "mpi", "nccl"}) {
+    auto group = dist::init(false, bk);
+    if (group.size() > 1) {
+      return {bk, group};
+    }
+  }
+  return {backend, dist::init(false)};
+}
+
+void print_header() {
+  std::cout << std::left << std::setw(8) << "backend" << std::setw(12) << "op"
+            << std::right << std::setw(14) << "bytes" << std::setw(12)
+            << "time(us)" << std::setw(12) << "algbw(GB/s)" << std::setw(12)
+            << "busbw(GB/s)" << std::endl;
+}
+
+// Time |fn| on every process and report the slowest one on rank 0.
+void run(
+    const std::string& backend,
+    const std::string& op,
+    size_t bytes,
+    double bus_factor,
+    const dist::Group& group,
+    std::function<std::vector<mx::array>()> fn,
+    const Options& opts) {
+  // Start all the processes together.
+  mx::eval(dist::all_sum(mx::array(0.0f), group));
+  auto samples = time_samples(opts.num_warmup, opts.num_iters, fn);
+  double ms = std::accumulate(samples.begin(), samples.end(), 0.0) /
+      samples.size();
+  auto slowest = dist::all_max(mx::array(static_cast<float>(ms)), group);
+  ms = slowest.item<float>();
+  if (group.rank() != 0) {
+    return;
+  }
+  double algbw = bytes / (ms * 1e6);
+  std::cout << std::left << std::setw(8) << backend << std::setw(12) << op
+            << std::right << std::setw(14) << bytes << std::fixed
+            << std::setprecision(2) << std::setw(12) << ms * 1e3
+            << std::setw(12) << algbw << std::setw(12) << algbw * bus_factor
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--backend") && has_value) {
+      opts.backend = argv[++i];
+    } else if (!std::strcmp(argv[i], "--op") && has_value) {
+      opts.op = argv[++i];
+    } else if (!std::strcmp(argv[i], "--min-bytes") && has_value) {
+      opts.min_bytes = parse_bytes(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--max-bytes") && has_value) {
+      opts.max_bytes = parse_bytes(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--iters") && has_value) {
+      opts.num_iters = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--warmup") && has_value) {
+      opts.num_warmup = std::stoi(argv[++i]);
+    } else {
+      std::cerr << "Unknown argument " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  auto backend_group = init(opts.backend);
+  auto& backend = backend_group.first;
+  auto& group = backend_group.second;
+  int n = group.size();
+  int rank = group.rank();
+  if (n == 1) {
+    std::cerr << "The benchmark needs at least 2 processes, launch it with "
+              << "mlx.launch." << std::endl;
+    return 1;
+  }
+  auto enabled = [&](const std::string& op) {
+    return opts.op == "all" || opts.op == op;
+  };
+  int right = (rank + 1) % n;
+  int left = (rank + n - 1) % n;
+
+  if (rank == 0) {
+    std::cout << "Processes: " << n << std::endl;
+    print_header();
+  }
+  constexpr size_t itemsize = sizeof(float);
+  for (size_t bytes = std::max(opts.min_bytes, itemsize);
+       bytes <= opts.max_bytes;
+       bytes *= 2) {
+    int size = bytes / itemsize;
+    if (enabled("all_sum")) {
+      auto x = mx::ones({size}, mx::float32);
+      mx::eval(x);
+      run(backend,
+          "all_sum",
+          size * itemsize,
+          2.0 * (n - 1) / n,
+          group,
+          [&]() { return std::vector<mx::array>{dist::all_sum(x, group)}; },
+          opts);
+    }
+    if (enabled("all_gather") && size >= n) {
+      auto x = mx::ones({size / n}, mx::float32);
+      mx::eval(x);
+      run(backend,
+          "all_gather",
+          size / n * n * itemsize,
+          (n - 1.0) / n,
+          group,
+          [&]() { return std::vector<mx::array>{dist::all_gather(x, group)}; },
+          opts);
+    }
+    if (enabled("sendrecv")) {
+      // Each process sends to the right and receives from the left, the
+      // even ones sending first so that the ring does not wait on itself.
+      auto x = mx::ones({size}, mx::float32);
+      mx::eval(x);
+      run(backend,
+          "sendrecv",
+          size * itemsize,
+          1.0,
+          group,
+          [&]() {
+            if (rank % 2 == 0) {
+              auto y = dist::send(x, right, group);
+              auto z = dist::recv_like(x, left, group);
+              return std::vector<mx::array>{y, z};
+            } else {
+              auto z = dist::recv_like(x, left, group);
+              auto y = dist::send(x, right, group);
+              return std::vector<mx::array>{z, y};
+            }
+          },
+          opts);
+    }
+  }
+  return 0;
+}
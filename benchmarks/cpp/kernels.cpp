@@ -0,0 +1,276 @@
+// Copyright © 2025 Apple Inc.
+
+// Times the GPU kernels across shapes and dtypes and reports the p50, p90
+// and p99 times with the achieved GB/s and TFLOP/s, as a table or as JSON
+// to compare runs:
+//
+//   kernels [--json] [--filter <substr>] [--iters <n>]
+//           [--peak-gbps <GB/s>] [--peak-tflops <TFLOP/s>]
+//
+// With the peaks of the device, "roofline" is the fraction of the roofline
+// bound reached, the time to move the bytes or to do the flops at the peak
+// over the measured p50.
+
+#include <cstring>
+#include <functional>
+#include <sstream>
+#include <string>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+namespace mx = mlx::core;
+
+struct Options {
+  bool json{false};
+  std::string filter;
+  int num_iters{100};
+  double peak_gbps{0};
+  double peak_tflops{0};
+};
+
+struct Case {
+  std::string name;
+  mx::Dtype dtype;
+  mx::Shape shape;
+  // The inputs are evaluated before timing |fn|.
+  std::vector<mx::array> inputs;
+  std::function<mx::array()> fn;
+  // The flops of an evaluation, 0 for the memory bound kernels.
+  double flops{0};
+};
+
+struct Result {
+  Case c;
+  size_t bytes;
+  double p50;
+  double p90;
+  double p99;
+  double mean;
+};
+
+std::string dtype_name(mx::Dtype dtype) {
+  std::ostringstream os;
+  os << dtype;
+  return os.str();
+}
+
+std::string shape_name(const mx::Shape& shape) {
+  std::string s;
+  for (auto d : shape) {
+    s += (s.empty() ? "" : "x") + std::to_string(d);
+  }
+  return s;
+}
+
+std::vector<Case> make_cases() {
+  std::vector<Case> cases;
+  auto add = [&cases](
+                 std::string name,
+                 mx::Dtype dtype,
+                 mx::Shape shape,
+                 std::vector<mx::array> inputs,
+                 std::function<mx::array()> fn,
+                 double flops = 0) {
+    cases.push_back(
+        {std::move(name),
+         dtype,
+         std::move(shape),
+         std::move(inputs),
+         std::move(fn),
+         flops});
+  };
+
+  std::vector<mx::Dtype> dtypes = {mx::float32, mx::float16, mx::bfloat16};
+  std::vector<mx::Shape> shapes = {{1024, 1024}, {4096, 4096}, {32, 128, 4096}};
+  for (auto dtype : dtypes) {
+    for (auto& shape : shapes) {
+      auto a = mx::random::normal(shape, dtype);
+      auto b = mx::random::normal(shape, dtype);
+      int last = shape.back();
+      int rows = a.size() / last;
+      auto w = mx::ones({last}, dtype);
+      auto bias = mx::zeros({last}, dtype);
+      auto rows_a = mx::reshape(a, {rows, last});
+      auto indices = mx::random::randint(0, rows, {rows}, mx::uint32);
+
+      add("copy", dtype, shape, {a}, [a]() {
+        return mx::copy(mx::swapaxes(a, -1, -2));
+      });
+      add("binary_add", dtype, shape, {a, b}, [a, b]() { return a + b; });
+      add("reduce_sum_last", dtype, shape, {a}, [a]() {
+        return mx::sum(a, -1);
+      });
+      add("reduce_sum_first", dtype, shape, {a}, [a]() {
+        return mx::sum(a, 0);
+      });
+      add("sort", dtype, shape, {a}, [a]() { return mx::sort(a, -1); });
+      add("scan_cumsum", dtype, shape, {a}, [a]() {
+        return mx::cumsum(a, -1);
+      });
+      add("gather_rows", dtype, shape, {rows_a, indices}, [rows_a, indices]() {
+        return mx::take(rows_a, indices, 0);
+      });
+      add("softmax", dtype, shape, {a}, [a]() { return mx::softmax(a, -1); });
+      add("rms_norm", dtype, shape, {a, w}, [a, w]() {
+        return mx::fast::rms_norm(a, w, 1e-5);
+      });
+      add("layer_norm", dtype, shape, {a, w, bias}, [a, w, bias]() {
+        return mx::fast::layer_norm(a, w, bias, 1e-5);
+      });
+    }
+
+    // The rope, matmul and quantized shapes are those of attention and of
+    // the projections of a model.
+    for (int seq : {128, 2048}) {
+      auto x = mx::random::normal({1, 32, seq, 128}, dtype);
+      add("rope", dtype, x.shape(), {x}, [x]() {
+        return mx::fast::rope(x, 128, false, 10000.0f, 1.0f, 0);
+      });
+    }
+    for (int n : {1024, 4096}) {
+      auto a = mx::random::normal({n, n}, dtype);
+      auto b = mx::random::normal({n, n}, dtype);
+      add(
+          "matmul",
+          dtype,
+          {n, n, n},
+          {a, b},
+          [a, b]() { return mx::matmul(a, b); },
+          2.0 * n * n * n);
+    }
+    if (dtype == mx::float32) {
+      continue;
+    }
+    int n = 4096;
+    auto w = mx::random::normal({n, n}, dtype);
+    add("quantize", dtype, {n, n}, {w}, [w]() {
+      return std::get<0>(mx::quantize(w, 64, 4));
+    });
+    auto [wq, scales, biases] = mx::quantize(w, 64, 4);
+    for (int m : {1, 32}) {
+      auto x = mx::random::normal({m, n}, dtype);
+      add(
+          "quantized_matmul",
+          dtype,
+          {m, n, n},
+          {x, wq, scales, biases},
+          [x, wq = wq, scales = scales, biases = biases]() {
+            return mx::quantized_matmul(x, wq, scales, biases, true, 64, 4);
+          },
+          2.0 * m * n * n);
+    }
+  }
+  return cases;
+}
+
+Result run(Case c, const Options& opts) {
+  mx::eval(c.inputs);
+  auto out = c.fn();
+  mx::eval(out);
+  size_t bytes = out.nbytes();
+  for (auto& in : c.inputs) {
+    bytes += in.nbytes();
+  }
+  auto samples = time_samples(5, opts.num_iters, c.fn);
+  double mean = 0;
+  for (auto t : samples) {
+    mean += t / samples.size();
+  }
+  return {
+      std::move(c),
+      bytes,
+      percentile(samples, 50),
+      percentile(samples, 90),
+      percentile(samples, 99),
+      mean};
+}
+
+double roofline(const Result& r, const Options& opts) {
+  if (opts.peak_gbps <= 0 && opts.peak_tflops <= 0) {
+    return 0;
+  }
+  double bound_ms = 0;
+  if (opts.peak_gbps > 0) {
+    bound_ms = std::max(bound_ms, r.bytes / (opts.peak_gbps * 1e6));
+  }
+  if (opts.peak_tflops > 0) {
+    bound_ms = std::max(bound_ms, r.c.flops / (opts.peak_tflops * 1e9));
+  }
+  return bound_ms / r.p50;
+}
+
+void print_json(const std::vector<Result>& results, const Options& opts) {
+  std::ostringstream device;
+  device << mx::default_device();
+  std::cout << std::setprecision(6) << "{\"device\": \"" << device.str()
+            << "\", \"iters\": " << opts.num_iters << ", \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& r = results[i];
+    std::cout << (i ? ",\n  " : "\n  ") << "{\"name\": \"" << r.c.name
+              << "\", \"dtype\": \"" << dtype_name(r.c.dtype)
+              << "\", \"shape\": \"" << shape_name(r.c.shape)
+              << "\", \"bytes\": " << r.bytes << ", \"flops\": " << r.c.flops
+              << ", \"p50_ms\": " << r.p50 << ", \"p90_ms\": " << r.p90
+              << ", \"p99_ms\": " << r.p99 << ", \"mean_ms\": " << r.mean
+              << ", \"gbps\": " << r.bytes / (r.p50 * 1e6)
+              << ", \"tflops\": " << r.c.flops / (r.p50 * 1e9)
+              << ", \"roofline\": " << roofline(r, opts) << "}";
+  }
+  std::cout << "\n]}" << std::endl;
+}
+
+void print_table(const std::vector<Result>& results, const Options& opts) {
+  std::cout << std::left << std::setw(18) << "kernel" << std::setw(10)
+            << "dtype" << std::setw(16) << "shape" << std::right
+            << std::setw(10) << "p50 ms" << std::setw(10) << "p90 ms"
+            << std::setw(10) << "p99 ms" << std::setw(10) << "GB/s"
+            << std::setw(10) << "TFLOP/s" << std::setw(10) << "roofline"
+            << std::endl;
+  for (auto& r : results) {
+    std::cout << std::left << std::setw(18) << r.c.name << std::setw(10)
+              << dtype_name(r.c.dtype) << std::setw(16)
+              << shape_name(r.c.shape) << std::right << std::fixed
+              << std::setprecision(4) << std::setw(10) << r.p50
+              << std::setw(10) << r.p90 << std::setw(10) << r.p99
+              << std::setprecision(1) << std::setw(10)
+              << r.bytes / (r.p50 * 1e6) << std::setprecision(2)
+              << std::setw(10) << r.c.flops / (r.p50 * 1e9)
+              << std::setw(10) << roofline(r, opts) << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--json")) {
+      opts.json = true;
+    } else if (!std::strcmp(argv[i], "--filter") && has_value) {
+      opts.filter = argv[++i];
+    } else if (!std::strcmp(argv[i], "--iters") && has_value) {
+      opts.num_iters = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--peak-gbps") && has_value) {
+      opts.peak_gbps = std::stod(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--peak-tflops") && has_value) {
+      opts.peak_tflops = std::stod(argv[++i]);
+    } else {
+      std::cerr << "Unknown argument " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  std::vector<Result> results;
+  for (auto& c : make_cases()) {
+    if (c.name.find(opts.filter) == std::string::npos) {
+      continue;
+    }
+    results.push_back(run(std::move(c), opts));
+  }
+  if (opts.json) {
+    print_json(results, opts);
+  } else {
+    print_table(results, opts);
+  }
+  return 0;
+}
@@ -2,9 +2,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <chrono>
 #include <iomanip>
 #include <iostream>
+#include <vector>
 
 #include "mlx/mlx.h"
 
@@ -37,3 +39,29 @@ double time_fn(F fn, Args&&... args) {
   auto end = time_now();
   return milliseconds(end - start) / static_cast<double>(num_iters);
 }
+
+// The time in msec of each of |num_iters| evaluations after |num_warmup|
+// warm-ups, to report the spread and not only the mean.
+template <typename F, typename... Args>
+std::vector<double>
+time_samples(int num_warmup, int num_iters, F fn, Args&&... args) {
+  for (int i = 0; i < num_warmup; ++i) {
+    eval(fn(std::forward<Args>(args)...));
+  }
+
+  std::vector<double> samples(num_iters);
+  for (int i = 0; i < num_iters; i++) {
+    auto start = time_now();
+    eval(fn(std::forward<Args>(args)...));
+    samples[i] = milliseconds(time_now() - start);
+  }
+  return samples;
+}
+
+// The |p|-th percentile of |samples|, with |p| in [0, 100].
+inline double percentile(std::vector<double> samples, double p) {
+  std::sort(samples.begin(), samples.end());
+  size_t i = std::min(
+      static_cast<size_t>(p / 100 * samples.size()), samples.size() - 1);
+  return samples[i];
+}
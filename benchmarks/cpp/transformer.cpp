@@ -0,0 +1,341 @@
+// Copyright © 2025 Apple Inc.
+
+// Times a decoder layer, norm -> QKV -> RoPE -> SDPA -> out projection ->
+// MLP, for prefill, decode and a training step across batch sizes and
+// context lengths, uncompiled and compiled, and reports the tokens/s and
+// the peak memory:
+//
+//   transformer [--json] [--mode <prefill|decode|train>] [--bits <0|4|8>]
+//               [--dtype <float16|bfloat16|float32>] [--iters <n>]
+//               [--dims <n>] [--heads <n>] [--kv-heads <n>] [--hidden <n>]
+//
+// The default shapes are those of a layer of an 8B model. With --bits the
+// linear layers are quantized, the training step then only differentiates
+// the norms as the quantized weights are frozen.
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <optional>
+#include <sstream>
+#include <string>
+
+#include "mlx/mlx.h"
+#include "time_utils.h"
+
+namespace mx = mlx::core;
+
+struct Options {
+  bool json{false};
+  std::string mode;
+  int bits{0};
+  mx::Dtype dtype{mx::float16};
+  int num_iters{20};
+  int dims{4096};
+  int heads{32};
+  int kv_heads{8};
+  int hidden{14336};
+};
+
+constexpr int group_size = 64;
+
+struct Linear {
+  mx::array w;
+  // The scales and biases of the quantized weights.
+  std::vector<mx::array> quantized;
+
+  Linear(int out_dims, int in_dims, const Options& opts)
+      : w(mx::random::normal({out_dims, in_dims}, opts.dtype) *
+          (1.0f / std::sqrt(static_cast<float>(in_dims)))) {
+    if (opts.bits) {
+      auto [wq, scales, biases] = mx::quantize(w, group_size, opts.bits);
+      w = wq;
+      quantized = {scales, biases};
+    }
+  }
+
+  mx::array operator()(const mx::array& x, const mx::array& w, int bits)
+      const {
+    if (bits) {
+      return mx::quantized_matmul(
+          x, w, quantized[0], quantized[1], true, group_size, bits);
+    }
+    return mx::matmul(x, mx::transpose(w));
+  }
+};
+
+// The layer, with its parameters gathered in a vector to be passed to the
+// compiled and differentiated functions: the two norms, then the weights of
+// the linear layers in the order of |linears|.
+struct Layer {
+  Options opts;
+  std::vector<Linear> linears;
+  std::vector<mx::array> params;
+
+  explicit Layer(const Options& opts) : opts(opts) {
+    int head_dim = opts.dims / opts.heads;
+    int kv_dims = opts.kv_heads * head_dim;
+    linears = {
+        Linear(opts.dims, opts.dims, opts), // q
+        Linear(kv_dims, opts.dims, opts), // k
+        Linear(kv_dims, opts.dims, opts), // v
+        Linear(opts.dims, opts.dims, opts), // out
+        Linear(opts.hidden, opts.dims, opts), // gate
+        Linear(opts.hidden, opts.dims, opts), // up
+        Linear(opts.dims, opts.hidden, opts), // down
+    };
+    params = {
+        mx::ones({opts.dims}, opts.dtype), mx::ones({opts.dims}, opts.dtype)};
+    for (auto& l : linears) {
+      params.push_back(l.w);
+    }
+    mx::eval(params);
+    for (auto& l : linears) {
+      mx::eval(l.quantized);
+    }
+  }
+
+  size_t nbytes() const {
+    size_t n = 0;
+    for (auto& p : params) {
+      n += p.nbytes();
+    }
+    for (auto& l : linears) {
+      for (auto& q : l.quantized) {
+        n += q.nbytes();
+      }
+    }
+    return n;
+  }
+
+  // The layer applied to |x| of shape (B, L, dims). With a cache of keys
+  // and values of shape (B, kv_heads, offset, head_dim) the new tokens
+  // attend to the cached ones, otherwise the attention is causal.
+  mx::array operator()(
+      const std::vector<mx::array>& p,
+      const mx::array& x,
+      const std::optional<std::pair<mx::array, mx::array>>& cache,
+      int offset) const {
+    int B = x.shape(0);
+    int L = x.shape(1);
+    int head_dim = opts.dims / opts.heads;
+    auto linear = [&](int i, const mx::array& x) {
+      return linears[i](x, p[i + 2], opts.bits);
+    };
+    auto heads = [&](const mx::array& x, int n) {
+      return mx::transpose(mx::reshape(x, {B, L, n, head_dim}), {0, 2, 1, 3});
+    };
+
+    auto h = mx::fast::rms_norm(x, p[0], 1e-5f);
+    auto q = heads(linear(0, h), opts.heads);
+    auto k = heads(linear(1, h), opts.kv_heads);
+    auto v = heads(linear(2, h), opts.kv_heads);
+    q = mx::fast::rope(q, head_dim, false, 10000.0f, 1.0f, offset);
+    k = mx::fast::rope(k, head_dim, false, 10000.0f, 1.0f, offset);
+    if (cache) {
+      k = mx::concatenate({cache->first, k}, 2);
+      v = mx::concatenate({cache->second, v}, 2);
+    }
+    auto o = mx::fast::scaled_dot_product_attention(
+        q, k, v, 1.0f / std::sqrt(head_dim), cache ? "" : "causal");
+    o = mx::reshape(mx::transpose(o, {0, 2, 1, 3}), {B, L, opts.dims});
+    auto y = x + linear(3, o);
+
+    h = mx::fast::rms_norm(y, p[1], 1e-5f);
+    auto gate = linear(4, h);
+    return y + linear(6, gate * mx::sigmoid(gate) * linear(5, h));
+  }
+};
+
+struct Result {
+  std::string mode;
+  bool compiled;
+  int batch;
+  int context;
+  double ms;
+  double tokens_per_s;
+  double peak_mb;
+};
+
+Result run(
+    const Layer& layer,
+    const std::string& mode,
+    bool compiled,
+    int batch,
+    int context,
+    const Options& opts) {
+  int head_dim = opts.dims / opts.heads;
+  bool decode = mode == "decode";
+  int L = decode ? 1 : context;
+  auto x = mx::random::normal({batch, L, opts.dims}, opts.dtype);
+  std::vector<mx::array> inputs = {x};
+  if (decode) {
+    mx::Shape shape = {batch, opts.kv_heads, context, head_dim};
+    inputs.push_back(mx::random::normal(shape, opts.dtype));
+    inputs.push_back(mx::random::normal(shape, opts.dtype));
+  }
+  mx::eval(inputs);
+
+  // The inputs are followed by the parameters.
+  std::function<std::vector<mx::array>(const std::vector<mx::array>&)> fn =
+      [&layer, decode, context, n = inputs.size()](const auto& args) {
+        std::vector<mx::array> p(args.begin() + n, args.end());
+        std::optional<std::pair<mx::array, mx::array>> cache;
+        if (decode) {
+          cache = std::make_pair(args[1], args[2]);
+        }
+        return std::vector<mx::array>{
+            layer(p, args[0], cache, decode ? context : 0)};
+      };
+  if (mode == "train") {
+    // The loss is differentiated with respect to the norms, and to the
+    // linear weights when they are not quantized.
+    int num_params = opts.bits ? 2 : layer.params.size();
+    std::vector<int> argnums;
+    for (int i = 0; i < num_params; ++i) {
+      argnums.push_back(inputs.size() + i);
+    }
+    auto value_and_grad = mx::value_and_grad(
+        [fn](const std::vector<mx::array>& args) {
+          return std::vector<mx::array>{
+              mx::mean(mx::square(mx::astype(fn(args)[0], mx::float32)))};
+        },
+        argnums);
+    fn = [value_and_grad](const std::vector<mx::array>& args) {
+      auto [loss, grads] = value_and_grad(args);
+      grads.push_back(loss[0]);
+      return grads;
+    };
+  }
+  if (compiled) {
+    fn = mx::compile(fn);
+  }
+  inputs.insert(inputs.end(), layer.params.begin(), layer.params.end());
+
+  auto step = [&]() { return fn(inputs); };
+  for (int i = 0; i < 2; ++i) {
+    mx::eval(step());
+  }
+  mx::synchronize();
+  mx::reset_peak_memory();
+  std::vector<double> samples(opts.num_iters);
+  for (auto& t : samples) {
+    auto start = time_now();
+    mx::eval(step());
+    t = milliseconds(time_now() - start);
+  }
+  double ms = percentile(samples, 50);
+  double tokens = static_cast<double>(batch) * L;
+  return {
+      mode,
+      compiled,
+      batch,
+      context,
+      ms,
+      tokens / (ms / 1e3),
+      mx::get_peak_memory() / 1e6};
+}
+
+void print_json(
+    const std::vector<Result>& results,
+    const Layer& layer,
+    const Options& opts) {
+  std::ostringstream device;
+  device << mx::default_device();
+  std::cout << std::setprecision(6) << "{\"device\": \"" << device.str()
+            << "\", \"dtype\": \"" << opts.dtype << "\", \"bits\": "
+            << opts.bits << ", \"dims\": " << opts.dims
+            << ", \"heads\": " << opts.heads
+            << ", \"kv_heads\": " << opts.kv_heads
+            << ", \"hidden\": " << opts.hidden
+            << ", \"weights_mb\": " << layer.nbytes() / 1e6
+            << ", \"results\": [";
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& r = results[i];
+    std::cout << (i ? ",\n  " : "\n  ") << "{\"mode\": \"" << r.mode
+              << "\", \"compiled\": " << (r.compiled ? "true" : "false")
+              << ", \"batch\": " << r.batch << ", \"context\": " << r.context
+              << ", \"p50_ms\": " << r.ms
+              << ", \"tokens_per_s\": " << r.tokens_per_s
+              << ", \"peak_mb\": " << r.peak_mb << "}";
+  }
+  std::cout << "\n]}" << std::endl;
+}
+
+void print_table(const std::vector<Result>& results, const Layer& layer) {
+  std::cout << "weights: " << std::fixed << std::setprecision(1)
+            << layer.nbytes() / 1e6 << " MB" << std::endl;
+  std::cout << std::left << std::setw(10) << "mode" << std::setw(10)
+            << "compiled" << std::right << std::setw(8) << "batch"
+            << std::setw(10) << "context" << std::setw(12) << "p50 ms"
+            << std::setw(14) << "tokens/s" << std::setw(12) << "peak MB"
+            << std::endl;
+  for (auto& r : results) {
+    std::cout << std::left << std::setw(10) << r.mode << std::setw(10)
+              << (r.compiled ? "yes" : "no") << std::right << std::setw(8)
+              << r.batch << std::setw(10) << r.context << std::fixed
+              << std::setprecision(3) << std::setw(12) << r.ms
+              << std::setprecision(1) << std::setw(14) << r.tokens_per_s
+              << std::setw(12) << r.peak_mb << std::endl;
+  }
+}
+
+int main(int argc, char** argv) {
+  Options opts;
+  for (int i = 1; i < argc; ++i) {
+    bool has_value = i + 1 < argc;
+    if (!std::strcmp(argv[i], "--json")) {
+      opts.json = true;
+    } else if (!std::strcmp(argv[i], "--mode") && has_value) {
+      opts.mode = argv[++i];
+    } else if (!std::strcmp(argv[i], "--bits") && has_value) {
+      opts.bits = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--dtype") && has_value) {
+      std::string dtype = argv[++i];
+      opts.dtype = dtype == "float32" ? mx::float32
+          : dtype == "bfloat16"       ? mx::bfloat16
+                                      : mx::float16;
+    } else if (!std::strcmp(argv[i], "--iters") && has_value) {
+      opts.num_iters = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--dims") && has_value) {
+      opts.dims = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--heads") && has_value) {
+      opts.heads = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--kv-heads") && has_value) {
+      opts.kv_heads = std::stoi(argv[++i]);
+    } else if (!std::strcmp(argv[i], "--hidden") && has_value) {
+      opts.hidden = std::stoi(argv[++i]);
+    } else {
+      std::cerr << "Unknown argument " << argv[i] << std::endl;
+      return 1;
+    }
+  }
+
+  Layer layer(opts);
+  // The batch sizes and context lengths of each mode.
+  std::vector<std::tuple<std::string, std::vector<int>, std::vector<int>>>
+      sweeps = {
+          {"prefill", {1, 4}, {512, 2048}},
+          {"decode", {1, 8, 32}, {512, 4096}},
+          {"train", {1, 4}, {512, 2048}},
+      };
+  std::vector<Result> results;
+  for (auto& [mode, batches, contexts] : sweeps) {
+    if (!opts.mode.empty() && opts.mode != mode) {
+      continue;
+    }
+    for (int batch : batches) {
+      for (int context : contexts) {
+        for (bool compiled : {false, true}) {
+          results.push_back(run(layer, mode, compiled, batch, context, opts));
+        }
+      }
+    }
+  }
+  if (opts.json) {
+    print_json(results, layer, opts);
+  } else {
+    print_table(results, layer);
+  }
+  return 0;
+}
@@ -5,6 +5,13 @@ import mlx.core as mx
 import numpy as np
 import torch
 
+if torch.cuda.is_available():
+    torch_device = "cuda"
+    torch_sync = torch.cuda.synchronize
+else:
+    torch_device = "mps"
+    torch_sync = torch.mps.synchronize
+
 N_warmup = 10
 N_iter_bench = 100
 N_iter_func = 5
@@ -13,7 +20,7 @@ N_iter_func = 5
 def bench(f, a, b):
     for i in range(N_warmup):
         f(a, b)
-    torch.mps.synchronize()
+    torch_sync()
 
     s = time.perf_counter_ns()
     for i in range(N_iter_bench):
@@ -41,7 +48,7 @@ def make_pt_conv_2D(strides=(1, 1), padding=(0, 0), groups=1):
         for i in range(N_iter_func):
             y = torch.conv2d(a, b, stride=strides, padding=padding, groups=groups)
             ys.append(y)
-        torch.mps.synchronize()
+        torch_sync()
         return ys
 
     return pt_conv_2D
@@ -57,10 +64,10 @@ def bench_shape(N, H, W, C, kH, kW, O, strides, padding, groups, np_dtype):
     a_mx = mx.array(a_np)
     b_mx = mx.array(b_np)
 
-    a_pt = torch.from_numpy(a_np.transpose((0, 3, 1, 2))).to("mps")
-    b_pt = torch.from_numpy(b_np.transpose((0, 3, 1, 2))).to("mps")
+    a_pt = torch.from_numpy(a_np.transpose((0, 3, 1, 2))).to(torch_device)
+    b_pt = torch.from_numpy(b_np.transpose((0, 3, 1, 2))).to(torch_device)
 
-    torch.mps.synchronize()
+    torch_sync()
 
     f_mx = make_mx_conv_2D(strides, padding, groups)
     f_pt = make_pt_conv_2D(strides, padding, groups)
@@ -1,6 +1,7 @@
 # Copyright © 2023 Apple Inc.
 
 import argparse
+import time
 
 import mlx.core as mx
 from time_utils import time_fn
@@ -111,6 +112,30 @@ def time_reshape_transposed():
     time_fn(reshape_transposed)
 
 
+def time_small_ops():
+    # The overhead of an operation on tiny arrays, in microseconds per op.
+    a = mx.array(1.0)
+    b = mx.array(2.0)
+    mx.eval(a, b)
+    num_ops = 10000
+
+    def per_op(msg, fn):
+        for _ in range(100):
+            fn()
+        tic = time.perf_counter()
+        for _ in range(num_ops):
+            fn()
+        toc = time.perf_counter()
+        print(f"Timing {msg} ... {1e6 * (toc - tic) / num_ops:.3f} usec")
+
+    per_op("array + array", lambda: a + b)
+    per_op("array + int", lambda: a + 1)
+    per_op("array * float", lambda: a * 0.5)
+    per_op("mx.add(array, int)", lambda: mx.add(a, 1))
+    per_op("mx.maximum(array, 0)", lambda: mx.maximum(a, 0))
+    per_op("eval(array + int)", lambda: mx.eval(a + 1))
+
+
 if __name__ == "__main__":
     parser = argparse.ArgumentParser("MLX benchmarks.")
     parser.add_argument("--gpu", action="store_true", help="Use the Metal back-end.")
@@ -130,3 +155,4 @@ if __name__ == "__main__":
     time_logsumexp()
     time_take()
     time_reshape_transposed()
+    time_small_ops()
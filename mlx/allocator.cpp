@@ -21,4 +21,8 @@ void free(Buffer buffer) {
   allocator().free(buffer);
 }
 
+Buffer make_buffer(void* ptr, size_t size) {
+  return allocator().make_buffer(ptr, size);
+}
+
 } // namespace mlx::core::allocator
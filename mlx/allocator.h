@@ -32,12 +32,20 @@ Buffer malloc(size_t size);
 
 void free(Buffer buffer);
 
+// Wrap |size| bytes at |ptr| which the allocator does not own in a buffer,
+// freeing it leaves the memory to its owner. The buffer is null when the
+// allocator cannot use external memory.
+Buffer make_buffer(void* ptr, size_t size);
+
 class Allocator {
   /** Abstract base class for a memory allocator. */
  public:
   virtual Buffer malloc(size_t size) = 0;
   virtual void free(Buffer buffer) = 0;
   virtual size_t size(Buffer buffer) const = 0;
+  virtual Buffer make_buffer(void* ptr, size_t size) {
+    return Buffer{nullptr};
+  }
 
   Allocator() = default;
   Allocator(const Allocator& other) = delete;
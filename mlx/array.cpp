@@ -5,6 +5,7 @@
 #include "mlx/array.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
+#include "mlx/scheduler.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
 
@@ -122,6 +123,7 @@ void array::wait() {
       detach_event();
     }
     set_status(Status::available);
+    scheduler::check_error();
   }
 }
 
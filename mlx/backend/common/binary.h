@@ -34,17 +34,24 @@ inline BinaryOpType get_binary_op_type(const array& a, const array& b) {
   return bopt;
 }
 
+// The scalar outputs only reuse the buffer of a scalar input for the
+// |inplace| ops, the other ops take a new buffer.
 inline void set_binary_op_output_data(
     const array& a,
     const array& b,
     array& out,
-    BinaryOpType bopt) {
+    BinaryOpType bopt,
+    bool inplace = false) {
   bool b_donatable = is_donatable(b, out);
   bool a_donatable = is_donatable(a, out);
   switch (bopt) {
     case BinaryOpType::ScalarScalar:
-      out.set_data(
-          allocator::malloc(out.itemsize()), 1, a.strides(), a.flags());
+      if (inplace && a_donatable && a.size() == out.size()) {
+        out.copy_shared_buffer(a);
+      } else {
+        out.set_data(
+            allocator::malloc(out.itemsize()), 1, a.strides(), a.flags());
+      }
       break;
     case BinaryOpType::ScalarVector:
       if (b_donatable) {
@@ -94,4 +101,19 @@ inline void set_binary_op_output_data(
   }
 }
 
+// The in-place ops need set_binary_op_output_data to write the output over
+// the buffer of the first input.
+inline void check_inplace_binary_op(
+    const array& a,
+    const array& out,
+    const char* op) {
+  if (!is_donatable(a, out) || !a.flags().row_contiguous ||
+      a.size() != out.size()) {
+    throw std::runtime_error(
+        std::string("[") + op +
+        "] The buffer of the first input can't be donated. It must be "
+        "contiguous and not referenced by other arrays.");
+  }
+}
+
 } // namespace mlx::core
@@ -2,98 +2,146 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <functional>
-#include <map>
+#include <unordered_map>
 
 namespace mlx::core {
 
+// The counters of a buffer cache.
+struct BufferCacheStats {
+  // The requests served from the cache, and the requests which were not.
+  size_t hits{0};
+  size_t misses{0};
+  // The cached buffers freed to make room or by clearing the cache.
+  size_t evictions{0};
+  // The bytes requested by the hits, and the bytes of the buffers returned
+  // for them. Their difference is the memory lost to reusing larger buffers.
+  size_t requested_bytes{0};
+  size_t reused_bytes{0};
+};
+
+// A cache of free buffers binned by size class.
+//
+// The classes are the multiples of the page size above it, and 4 classes
+// per power of 2 below it. A buffer is in the largest class not larger than
+// its size, so a request is served in O(1) from its own class when its size
+// is a class, or from the few classes above it within the allowed
+// over-allocation. The buffers are also kept in a least recently used list
+// for the eviction.
 template <typename T>
 class BufferCache {
  public:
   BufferCache(
       size_t page_size,
       std::function<size_t(T*)> get_size,
-      std::function<void(T*)> free)
+      std::function<void(T*)> free,
+      double max_overallocation = 2.0)
       : page_size_(page_size),
+        max_overallocation_(max_overallocation),
         get_size_(std::move(get_size)),
         free_(std::move(free)) {}
 
   ~BufferCache() {
     clear();
+    while (free_holders_) {
+      auto* next = free_holders_->next;
+      delete free_holders_;
+      free_holders_ = next;
+    }
   }
 
   BufferCache(const BufferCache&) = delete;
   BufferCache& operator=(const BufferCache&) = delete;
 
   T* reuse_from_cache(size_t size) {
-    // Find the closest buffer in pool.
-    auto it = buffer_pool_.lower_bound(size);
-    if (it == buffer_pool_.end() ||
-        it->first >= std::min(2 * size, size + 2 * page_size_)) {
+    // The buffers must be smaller than |limit|.
+    size_t limit = std::min(
+        static_cast<size_t>(size * max_overallocation_),
+        size + 2 * page_size_);
+    limit = std::max(limit, size + 1);
+
+    BufferHolder* bh = nullptr;
+    size_t c = floor_class(size);
+    if (c != size) {
+      // The most recent buffer of the class below may still be large enough,
+      // which is the case of the repeated requests of the same size.
+      auto it = bins_.find(c);
+      if (it != bins_.end() && it->second &&
+          it->second->size >= size && it->second->size < limit) {
+        bh = it->second;
+      }
+      c = next_class(c);
+    }
+    for (; !bh && c < limit; c = next_class(c)) {
+      auto it = bins_.find(c);
+      if (it != bins_.end() && it->second && it->second->size < limit) {
+        bh = it->second;
+      }
+    }
+    if (!bh) {
+      stats_.misses++;
       return nullptr;
     }
 
-    // Collect from the cache.
-    T* buf = it->second->buf;
-    pool_size_ -= it->first;
-
-    // Remove from record.
-    remove_from_list(it->second);
-    buffer_pool_.erase(it);
+    T* buf = bh->buf;
+    stats_.hits++;
+    stats_.requested_bytes += size;
+    stats_.reused_bytes += bh->size;
+    pool_size_ -= bh->size;
+    remove(bh);
     return buf;
   }
 
   void recycle_to_cache(T* buf) {
     assert(buf);
-    // Add to cache.
-    BufferHolder* bh = new BufferHolder(buf);
-    add_at_head(bh);
-    size_t size = get_size_(buf);
-    pool_size_ += size;
-    buffer_pool_.emplace(size, bh);
+    BufferHolder* bh = new_holder(buf, get_size_(buf));
+    pool_size_ += bh->size;
+
+    // Add at the head of the least recently used list and of its bin.
+    bh->next = head_;
+    if (head_) {
+      head_->prev = bh;
+    } else {
+      tail_ = bh;
+    }
+    head_ = bh;
+    auto& bin = bins_[floor_class(bh->size)];
+    bh->bin_next = bin;
+    if (bin) {
+      bin->bin_prev = bh;
+    }
+    bin = bh;
   }
 
   int release_cached_buffers(size_t min_bytes_to_free) {
     if (min_bytes_to_free >= 0.9 * pool_size_) {
       return clear();
-    } else {
-      int n_release = 0;
-      size_t total_bytes_freed = 0;
-
-      while (tail_ && (total_bytes_freed < min_bytes_to_free)) {
-        // Release buffer.
-        size_t size = get_size_(tail_->buf);
-        total_bytes_freed += size;
-        free_(tail_->buf);
-        n_release++;
-
-        // Remove from record.
-        auto its = buffer_pool_.equal_range(size);
-        auto it = std::find_if(its.first, its.second, [this](const auto& el) {
-          return el.second == tail_;
-        });
-        assert(it != buffer_pool_.end());
-        buffer_pool_.erase(it);
-        remove_from_list(tail_);
-      }
-
-      pool_size_ -= total_bytes_freed;
-      return n_release;
     }
+    int n_release = 0;
+    size_t total_bytes_freed = 0;
+    while (tail_ && (total_bytes_freed < min_bytes_to_free)) {
+      total_bytes_freed += tail_->size;
+      free_(tail_->buf);
+      n_release++;
+      remove(tail_);
+    }
+    pool_size_ -= total_bytes_freed;
+    stats_.evictions += n_release;
+    return n_release;
   }
 
   int clear() {
     int n_release = 0;
-    for (auto& [size, holder] : buffer_pool_) {
-      free_(holder->buf);
+    while (head_) {
+      free_(head_->buf);
       n_release++;
-      delete holder;
+      remove(head_);
     }
-    buffer_pool_.clear();
+    bins_.clear();
     pool_size_ = 0;
-    head_ = nullptr;
-    tail_ = nullptr;
+    stats_.evictions += n_release;
     return n_release;
   }
 
@@ -105,51 +153,99 @@ class BufferCache {
     return page_size_;
   }
 
+  const BufferCacheStats& stats() const {
+    return stats_;
+  }
+
+  void reset_stats() {
+    stats_ = BufferCacheStats{};
+  }
+
  private:
   struct BufferHolder {
-   public:
-    explicit BufferHolder(T* buf_) : buf(buf_) {}
-
-    BufferHolder* prev{nullptr};
-    BufferHolder* next{nullptr};
+    // The least recently used list.
+    BufferHolder* prev;
+    BufferHolder* next;
+    // The buffers of the same class, most recent first.
+    BufferHolder* bin_prev;
+    BufferHolder* bin_next;
     T* buf;
+    size_t size;
   };
 
-  void add_at_head(BufferHolder* to_add) {
-    if (!head_) {
-      head_ = to_add;
-      tail_ = to_add;
+  // The largest class not larger than |size|.
+  size_t floor_class(size_t size) const {
+    if (size == 0) {
+      return 0;
+    }
+    if (size >= page_size_) {
+      return page_size_ * (size / page_size_);
+    }
+    size_t p = 1;
+    while (2 * p <= size) {
+      p *= 2;
+    }
+    size_t step = std::max<size_t>(p / 4, 1);
+    return p + step * ((size - p) / step);
+  }
+
+  // The class following the class |c|.
+  size_t next_class(size_t c) const {
+    if (c >= page_size_) {
+      return c + page_size_;
+    }
+    size_t p = 1;
+    while (2 * p <= c) {
+      p *= 2;
+    }
+    return std::max<size_t>(c + p / 4, c + 1);
+  }
+
+  // The holders are recycled to not allocate on every recycle.
+  BufferHolder* new_holder(T* buf, size_t size) {
+    BufferHolder* bh = free_holders_;
+    if (bh) {
+      free_holders_ = bh->next;
     } else {
-      head_->prev = to_add;
-      to_add->next = head_;
-      head_ = to_add;
+      bh = new BufferHolder;
     }
+    *bh = BufferHolder{nullptr, nullptr, nullptr, nullptr, buf, size};
+    return bh;
   }
 
-  void remove_from_list(BufferHolder* to_remove) {
-    if (to_remove->prev && to_remove->next) { // if middle
-      to_remove->prev->next = to_remove->next;
-      to_remove->next->prev = to_remove->prev;
-    } else if (to_remove->prev && to_remove == tail_) { // if tail
-      tail_ = to_remove->prev;
-      tail_->next = nullptr;
-    } else if (to_remove == head_ && to_remove->next) { // if head
-      head_ = to_remove->next;
-      head_->prev = nullptr;
-    } else if (to_remove == head_ && to_remove == tail_) { // if only element
-      head_ = nullptr;
-      tail_ = nullptr;
-    }
-
-    delete to_remove;
+  void remove(BufferHolder* bh) {
+    if (bh->prev) {
+      bh->prev->next = bh->next;
+    } else {
+      head_ = bh->next;
+    }
+    if (bh->next) {
+      bh->next->prev = bh->prev;
+    } else {
+      tail_ = bh->prev;
+    }
+    if (bh->bin_prev) {
+      bh->bin_prev->bin_next = bh->bin_next;
+    } else {
+      bins_[floor_class(bh->size)] = bh->bin_next;
+    }
+    if (bh->bin_next) {
+      bh->bin_next->bin_prev = bh->bin_prev;
+    }
+    bh->next = free_holders_;
+    free_holders_ = bh;
   }
 
-  std::multimap<size_t, BufferHolder*> buffer_pool_;
+  // The head of the list of each class.
+  std::unordered_map<size_t, BufferHolder*> bins_;
   BufferHolder* head_{nullptr};
   BufferHolder* tail_{nullptr};
+  BufferHolder* free_holders_{nullptr};
   size_t pool_size_{0};
+  BufferCacheStats stats_;
 
   const size_t page_size_;
+  const double max_overallocation_;
   std::function<size_t(T*)> get_size_;
   std::function<void(T*)> free_;
 };
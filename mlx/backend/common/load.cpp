@@ -1,8 +1,11 @@
 // Copyright © 2023 Apple Inc.
 
 #include <algorithm>
+#include <cstdint>
 #include <utility>
 
+#include "mlx/backend/common/load.h"
+#include "mlx/io/load.h"
 #include "mlx/primitives.h"
 #include "mlx/scheduler.h"
 
@@ -27,7 +30,38 @@ void swap_endianness(uint8_t* data_bytes, size_t N) {
 
 namespace mlx::core {
 
+void swap_endianness(uint8_t* data_bytes, size_t size, int itemsize) {
+  switch (itemsize) {
+    case 2:
+      ::swap_endianness<2>(data_bytes, size);
+      break;
+    case 4:
+      ::swap_endianness<4>(data_bytes, size);
+      break;
+    case 8:
+      ::swap_endianness<8>(data_bytes, size);
+      break;
+  }
+}
+
 void Load::eval_cpu(const std::vector<array>& inputs, array& out) {
+#ifndef _WIN32
+  // Wrap the pages of a mapped file when the allocator can and the data is
+  // aligned, the array holds the mapping.
+  if (auto mapped = std::dynamic_pointer_cast<io::MmapFileReader>(reader_);
+      mapped && !swap_endianness_) {
+    char* ptr = mapped->data(offset_, out.nbytes());
+    if (reinterpret_cast<uintptr_t>(ptr) % out.itemsize() == 0) {
+      auto buffer = allocator::make_buffer(ptr, out.nbytes());
+      if (buffer.ptr()) {
+        out.set_data(buffer, [mapped](allocator::Buffer b) {
+          allocator::free(b);
+        });
+        return;
+      }
+    }
+  }
+#endif
   out.set_data(allocator::malloc(out.nbytes()));
   auto read_task = [out_ptr = out.data<char>(),
                     size = out.size(),
@@ -37,17 +71,7 @@ void Load::eval_cpu(const std::vector<array>& inputs, array& out) {
                     swap_endianness_ = swap_endianness_]() mutable {
     reader->read(out_ptr, size * itemsize, offset);
     if (swap_endianness_) {
-      switch (itemsize) {
-        case 2:
-          swap_endianness<2>(reinterpret_cast<uint8_t*>(out_ptr), size);
-          break;
-        case 4:
-          swap_endianness<4>(reinterpret_cast<uint8_t*>(out_ptr), size);
-          break;
-        case 8:
-          swap_endianness<8>(reinterpret_cast<uint8_t*>(out_ptr), size);
-          break;
-      }
+      swap_endianness(reinterpret_cast<uint8_t*>(out_ptr), size, itemsize);
     }
   };
   auto fut = io::thread_pool().enqueue(std::move(read_task)).share();
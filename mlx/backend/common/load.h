@@ -0,0 +1,13 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mlx::core {
+
+// Reverse the bytes of each of the |size| elements of |itemsize| bytes.
+void swap_endianness(uint8_t* data_bytes, size_t size, int itemsize);
+
+} // namespace mlx::core
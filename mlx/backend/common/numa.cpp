@@ -0,0 +1,211 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mlx/backend/common/numa.h"
+#include "mlx/utils.h"
+
+#ifdef __linux__
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace mlx::core::numa {
+
+namespace {
+
+#ifdef __linux__
+
+// The modes of mbind from <numaif.h>, which is part of libnuma.
+constexpr int MPOL_BIND_ = 2;
+constexpr int MPOL_INTERLEAVE_ = 3;
+
+// Parse a list of the sysfs such as "0-15,32-47".
+std::vector<int> parse_list(const std::string& list) {
+  std::vector<int> items;
+  std::stringstream ss(list);
+  std::string range;
+  while (std::getline(ss, range, ',')) {
+    if (range.empty() || range == "\n") {
+      continue;
+    }
+    auto dash = range.find('-');
+    int first = std::stoi(range.substr(0, dash));
+    int last = dash == std::string::npos ? first
+                                         : std::stoi(range.substr(dash + 1));
+    for (int i = first; i <= last; ++i) {
+      items.push_back(i);
+    }
+  }
+  return items;
+}
+
+std::string read_file(const std::string& path) {
+  std::ifstream f(path);
+  std::string s;
+  std::getline(f, s);
+  return s;
+}
+
+struct Topology {
+  // The ids of the nodes in the kernel and their CPUs, restricted to the
+  // CPUs the process was allowed to run on when it started.
+  std::vector<int> node_ids;
+  std::vector<std::vector<int>> node_cpus;
+  std::vector<int> all_cpus;
+
+  Topology() {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+      return;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        all_cpus.push_back(cpu);
+      }
+    }
+    std::vector<int> online;
+    try {
+      online = parse_list(read_file("/sys/devices/system/node/online"));
+    } catch (const std::exception&) {
+      return;
+    }
+    for (int node : online) {
+      std::vector<int> cpus;
+      try {
+        auto path = "/sys/devices/system/node/node" + std::to_string(node) +
+            "/cpulist";
+        for (int cpu : parse_list(read_file(path))) {
+          if (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed)) {
+            cpus.push_back(cpu);
+          }
+        }
+      } catch (const std::exception&) {
+        continue;
+      }
+      if (!cpus.empty()) {
+        node_ids.push_back(node);
+        node_cpus.push_back(std::move(cpus));
+      }
+    }
+  }
+};
+
+const Topology& topology() {
+  static Topology topology;
+  return topology;
+}
+
+void mbind_nodes(
+    void* ptr,
+    size_t size,
+    int mode,
+    const std::vector<int>& ids) {
+  // The policy applies to whole pages, the ones at the ends are shared with
+  // the neighbouring allocations.
+  static size_t page = sysconf(_SC_PAGESIZE);
+  auto begin = (reinterpret_cast<uintptr_t>(ptr) + page - 1) / page * page;
+  auto end = (reinterpret_cast<uintptr_t>(ptr) + size) / page * page;
+  if (end <= begin) {
+    return;
+  }
+  int max_id = 0;
+  for (int id : ids) {
+    max_id = std::max(max_id, id);
+  }
+  constexpr int bits = 8 * sizeof(unsigned long);
+  std::vector<unsigned long> mask(max_id / bits + 1, 0);
+  for (int id : ids) {
+    mask[id / bits] |= 1UL << (id % bits);
+  }
+  // Best effort, the pages are placed by first touch when it fails.
+  syscall(
+      SYS_mbind,
+      begin,
+      end - begin,
+      mode,
+      mask.data(),
+      mask.size() * bits + 1,
+      0);
+}
+
+#endif
+
+thread_local int thread_node = -1;
+
+std::mutex stream_nodes_mtx;
+std::unordered_map<int, int> stream_nodes;
+
+} // namespace
+
+int num_nodes() {
+#ifdef __linux__
+  return std::max<int>(topology().node_ids.size(), 1);
+#else
+  return 1;
+#endif
+}
+
+void bind_thread(int node) {
+#ifdef __linux__
+  if (env::cpu_numa() == 0 || topology().node_ids.empty()) {
+    return;
+  }
+  auto& cpus = node < 0 ? topology().all_cpus : topology().node_cpus.at(node);
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    CPU_SET(cpu, &set);
+  }
+  sched_setaffinity(0, sizeof(set), &set);
+#endif
+}
+
+int stream_node(int stream) {
+  std::lock_guard lk(stream_nodes_mtx);
+  auto it = stream_nodes.find(stream);
+  return it == stream_nodes.end() ? -1 : it->second;
+}
+
+void set_stream_node(int stream, int node) {
+  std::lock_guard lk(stream_nodes_mtx);
+  if (node < 0) {
+    stream_nodes.erase(stream);
+  } else {
+    stream_nodes[stream] = node;
+  }
+}
+
+void place(void* ptr, size_t size) {
+#ifdef __linux__
+  if (ptr == nullptr || size < min_bind_size || env::cpu_numa() < 2 ||
+      topology().node_ids.size() < 2) {
+    return;
+  }
+  auto& ids = topology().node_ids;
+  if (thread_node >= 0) {
+    mbind_nodes(ptr, size, MPOL_BIND_, {ids.at(thread_node)});
+  } else {
+    mbind_nodes(ptr, size, MPOL_INTERLEAVE_, ids);
+  }
+#endif
+}
+
+NodeScope::NodeScope(int node) : prev_(thread_node) {
+  thread_node = node;
+}
+
+NodeScope::~NodeScope() {
+  thread_node = prev_;
+}
+
+} // namespace mlx::core::numa
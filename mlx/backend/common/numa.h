@@ -0,0 +1,42 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cstddef>
+
+namespace mlx::core::numa {
+
+// The allocations from which the memory policy of the node is applied with
+// mbind, the smaller ones share pages with others.
+constexpr size_t min_bind_size = 1 << 20;
+
+// The number of NUMA nodes with CPUs the process may run on, 1 when the
+// topology is unknown.
+int num_nodes();
+
+// Run the calling thread on the CPUs of |node|, or on any of them for -1.
+void bind_thread(int node);
+
+// The node of the CPU stream with the given index, -1 when it has none.
+int stream_node(int stream);
+void set_stream_node(int stream, int node);
+
+// Apply the memory policy of the node of the calling thread to the pages of
+// a new allocation, before they are touched. The pages of the streams with
+// a node are bound to it and the others interleaved over all the nodes.
+void place(void* ptr, size_t size);
+
+// Set the node of the allocations of the calling thread while in scope.
+class NodeScope {
+ public:
+  explicit NodeScope(int node);
+  ~NodeScope();
+
+  NodeScope(const NodeScope&) = delete;
+  NodeScope& operator=(const NodeScope&) = delete;
+
+ private:
+  int prev_;
+};
+
+} // namespace mlx::core::numa
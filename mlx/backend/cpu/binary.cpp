@@ -17,9 +17,15 @@ namespace mlx::core {
 namespace {
 
 template <typename Op>
-void binary(const array& a, const array& b, array& out, Op op, Stream stream) {
+void binary(
+    const array& a,
+    const array& b,
+    array& out,
+    Op op,
+    Stream stream,
+    bool inplace = false) {
   auto bopt = get_binary_op_type(a, b);
-  set_binary_op_output_data(a, b, out, bopt);
+  set_binary_op_output_data(a, b, out, bopt, inplace);
 
   auto& encoder = cpu::get_command_encoder(stream);
   encoder.set_input_array(a);
@@ -240,7 +246,10 @@ void Add::eval_cpu(const std::vector<array>& inputs, array& out) {
   assert(inputs.size() == 2);
   auto& a = inputs[0];
   auto& b = inputs[1];
-  binary(a, b, out, detail::Add(), stream());
+  if (inplace_) {
+    check_inplace_binary_op(a, out, "add_inplace");
+  }
+  binary(a, b, out, detail::Add(), stream(), inplace_);
 }
 
 void DivMod::eval_cpu(
@@ -8,6 +8,7 @@
 #include "mlx/backend/common/utils.h"
 
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 
 namespace mlx::core {
 
@@ -162,19 +163,28 @@ void binary_op(const array& a, const array& b, array& out, BinaryOpType bopt) {
 
   // The full computation is scalar vector so delegate to the op
   if (bopt == BinaryOpType::ScalarVector) {
-    ScalarVector<Op>{}(a_ptr, b_ptr, out_ptr, b.data_size());
+    cpu::parallel_for(
+        b.data_size(), cpu::min_parallel_size, [&](size_t i, size_t end) {
+          ScalarVector<Op>{}(a_ptr, b_ptr + i, out_ptr + i, end - i);
+        });
     return;
   }
 
   // The full computation is vector scalar so delegate to the op
   if (bopt == BinaryOpType::VectorScalar) {
-    VectorScalar<Op>{}(a_ptr, b_ptr, out_ptr, a.data_size());
+    cpu::parallel_for(
+        a.data_size(), cpu::min_parallel_size, [&](size_t i, size_t end) {
+          VectorScalar<Op>{}(a_ptr + i, b_ptr, out_ptr + i, end - i);
+        });
     return;
   }
 
   // The full computation is vector vector so delegate to the op
   if (bopt == BinaryOpType::VectorVector) {
-    VectorVector<Op>{}(a_ptr, b_ptr, out_ptr, a.size());
+    cpu::parallel_for(
+        a.size(), cpu::min_parallel_size, [&](size_t i, size_t end) {
+          VectorVector<Op>{}(a_ptr + i, b_ptr + i, out_ptr + i, end - i);
+        });
     return;
   }
 
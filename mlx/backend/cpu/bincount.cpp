@@ -0,0 +1,97 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Sum the weights, or ones without weights, of the values of |x| in the
+// bins of |out|. The chunks of |x| are counted in histograms of their own
+// which are then added to |out|, so the chunks are at least as long as
+// |out| for the adds to be a small part of the work.
+template <typename IdxT, typename T>
+void bincount(
+    const IdxT* x,
+    const T* weights,
+    T* out,
+    size_t size,
+    int length) {
+  std::fill(out, out + length, T(0));
+  std::mutex mtx;
+  size_t grain = std::max<size_t>(cpu::min_parallel_size, length);
+  cpu::parallel_for(size, grain, [&](size_t begin, size_t end) {
+    std::vector<T> hist(length, T(0));
+    for (size_t i = begin; i < end; ++i) {
+      auto bin = static_cast<int64_t>(x[i]);
+      if (bin >= 0 && bin < length) {
+        hist[bin] += weights ? weights[i] : T(1);
+      }
+    }
+    std::lock_guard lock(mtx);
+    for (int j = 0; j < length; ++j) {
+      out[j] += hist[j];
+    }
+  });
+}
+
+} // namespace
+
+void BinCount::eval_cpu(const std::vector<array>& inputs, array& out) {
+  auto& encoder = cpu::get_command_encoder(stream());
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy(x.shape(), x.dtype(), nullptr, {});
+    copy_cpu(x, x_copy, CopyType::General, stream());
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  auto x = ensure_row_contiguous(inputs[0]);
+  std::optional<array> weights;
+  if (inputs.size() > 1) {
+    weights = ensure_row_contiguous(inputs[1]);
+    encoder.set_input_array(*weights);
+  }
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  encoder.set_input_array(x);
+  encoder.set_output_array(out);
+  dispatch_int_types(x.dtype(), "[BinCount::eval_cpu]", [&](auto idx_tag) {
+    using IdxT = MLX_GET_TYPE(idx_tag);
+    auto run = [&](auto type_tag) {
+      using T = decltype(type_tag);
+      encoder.dispatch([x = x.data<IdxT>(),
+                        weights = weights ? weights->data<T>() : nullptr,
+                        out = out.data<T>(),
+                        size = x.size(),
+                        length = length_]() {
+        bincount(x, weights, out, size, length);
+      });
+    };
+    switch (out.dtype()) {
+      case int32:
+        return run(int32_t{});
+      case int64:
+        return run(int64_t{});
+      case float32:
+        return run(float{});
+      case float64:
+        return run(double{});
+      default:
+        throw std::invalid_argument("[BinCount::eval_cpu] Unsupported type.");
+    }
+  });
+}
+
+} // namespace mlx::core
@@ -4,11 +4,86 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/lapack.h"
+#include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/linalg.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
+// The matrices of at most small_cholesky_max_size rows are factorized
+// without lapack, see small_cholesky.
+constexpr int small_cholesky_max_size = 4;
+
+// Factorize the |num_matrices| N x N matrices at |matrix| in place with an
+// unrolled Cholesky–Banachiewicz, simd::max_size<T> matrices at a time with
+// one matrix per lane. Like potrf only the triangle of the factor is read.
+template <typename T, int N>
+void small_cholesky(T* matrix, size_t num_matrices, bool upper) {
+  constexpr int S = simd::max_size<T>;
+  using V = simd::Simd<T, S>;
+  for (size_t m = 0; m < num_matrices; m += S) {
+    int lanes = std::min<size_t>(S, num_matrices - m);
+    T* mats = matrix + m * N * N;
+
+    // Transpose the lower triangles into the lanes, the missing lanes are
+    // identities.
+    T buf[N * N][S];
+    for (int r = 0; r < N; ++r) {
+      for (int c = 0; c <= r; ++c) {
+        int e = upper ? c * N + r : r * N + c;
+        for (int l = 0; l < S; ++l) {
+          buf[r * N + c][l] = l < lanes ? mats[l * N * N + e] : T(r == c);
+        }
+      }
+    }
+    V a[N][N];
+    for (int r = 0; r < N; ++r) {
+      for (int c = 0; c <= r; ++c) {
+        a[r][c] = simd::load<T, S>(buf[r * N + c]);
+      }
+    }
+
+    // Like potrf a lane stops at the first pivot which is not positive,
+    // keeping it and the following columns unfactorized.
+    V alive(1);
+    for (int j = 0; j < N; ++j) {
+      V d = a[j][j];
+      for (int k = 0; k < j; ++k) {
+        d = d - a[j][k] * a[j][k];
+      }
+      auto pos = d > V(0);
+      V diag = simd::select(pos, simd::sqrt(d), d);
+      a[j][j] = simd::select(alive > V(0), diag, a[j][j]);
+      alive = simd::select(pos, alive, V(0));
+      V p = V(1) / a[j][j];
+      for (int i = j + 1; i < N; ++i) {
+        V x = a[i][j];
+        for (int k = 0; k < j; ++k) {
+          x = x - a[i][k] * a[j][k];
+        }
+        a[i][j] = simd::select(alive > V(0), x * p, a[i][j]);
+      }
+    }
+
+    for (int r = 0; r < N; ++r) {
+      for (int c = 0; c <= r; ++c) {
+        simd::store(buf[r * N + c], a[r][c]);
+      }
+    }
+    for (int l = 0; l < lanes; ++l) {
+      T* out = mats + l * N * N;
+      for (int r = 0; r < N; ++r) {
+        for (int c = 0; c < N; ++c) {
+          int lr = upper ? c : r;
+          int lc = upper ? r : c;
+          out[r * N + c] = lc <= lr ? buf[lr * N + lc][l] : T(0);
+        }
+      }
+    }
+  }
+}
+
 template <typename T>
 void cholesky_impl(const array& a, array& factor, bool upper, Stream stream) {
   // Lapack uses the column-major convention. We take advantage of the fact that
@@ -28,43 +103,73 @@ void cholesky_impl(const array& a, array& factor, bool upper, Stream stream) {
 
   auto& encoder = cpu::get_command_encoder(stream);
   encoder.set_output_array(factor);
-  encoder.dispatch([matrix = factor.data<T>(),
-                    upper,
-                    N = a.shape(-1),
-                    size = a.size()]() mutable {
+  auto matrix = factor.data<T>();
+  int N = a.shape(-1);
+  size_t num_matrices = a.size() / (N * N);
+  size_t grain =
+      std::max<size_t>(cpu::min_parallel_size / (size_t(N) * N * N), 1);
+  if (N <= small_cholesky_max_size) {
+    constexpr int S = simd::max_size<T>;
+    grain = (grain + S - 1) / S * S;
+    encoder.dispatch([matrix, upper, N, num_matrices, grain]() {
+      cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+        T* mats = matrix + size_t(N) * N * i;
+        switch (N) {
+          case 1:
+            small_cholesky<T, 1>(mats, end - i, upper);
+            break;
+          case 2:
+            small_cholesky<T, 2>(mats, end - i, upper);
+            break;
+          case 3:
+            small_cholesky<T, 3>(mats, end - i, upper);
+            break;
+          default:
+            small_cholesky<T, 4>(mats, end - i, upper);
+            break;
+        }
+      });
+    });
+    return;
+  }
+
+  encoder.dispatch([matrix, upper, N, num_matrices, grain]() {
     char uplo = (upper) ? 'L' : 'U';
-    size_t num_matrices = size / (N * N);
-    for (int i = 0; i < num_matrices; i++) {
-      // Compute Cholesky factorization.
-      int info;
-      potrf<T>(
-          /* uplo = */ &uplo,
-          /* n = */ &N,
-          /* a = */ matrix,
-          /* lda = */ &N,
-          /* info = */ &info);
-
-      // TODO: We do nothing when the matrix is not positive semi-definite
-      // because throwing an error would result in a crash. If we figure out how
-      // to catch errors from the implementation we should throw.
-      if (info < 0) {
-        std::stringstream msg;
-        msg << "[Cholesky::eval_cpu] Cholesky decomposition failed with error code "
-            << info;
-        throw std::runtime_error(msg.str());
-      }
+    cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+      int n = N;
+      for (; i < end; i++) {
+        T* mat = matrix + size_t(N) * N * i;
+
+        // Compute Cholesky factorization.
+        int info;
+        potrf<T>(
+            /* uplo = */ &uplo,
+            /* n = */ &n,
+            /* a = */ mat,
+            /* lda = */ &n,
+            /* info = */ &info);
 
-      // Zero out the upper/lower triangle while advancing the pointer to the
-      // next matrix at the same time.
-      for (int row = 0; row < N; row++) {
-        if (upper) {
-          std::fill(matrix, matrix + row, 0);
-        } else {
-          std::fill(matrix + row + 1, matrix + N, 0);
+        // TODO: We do nothing when the matrix is not positive semi-definite
+        // because throwing an error would result in a crash. If we figure out
+        // how to catch errors from the implementation we should throw.
+        if (info < 0) {
+          std::stringstream msg;
+          msg << "[Cholesky::eval_cpu] Cholesky decomposition failed with "
+              << "error code " << info;
+          throw std::runtime_error(msg.str());
+        }
+
+        // Zero out the upper/lower triangle.
+        for (int row = 0; row < N; row++) {
+          if (upper) {
+            std::fill(mat, mat + row, 0);
+          } else {
+            std::fill(mat + row + 1, mat + N, 0);
+          }
+          mat += N;
         }
-        matrix += N;
       }
-    }
+    });
   });
 }
 
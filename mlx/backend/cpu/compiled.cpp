@@ -5,6 +5,7 @@
 #include <fstream>
 #include <list>
 #include <mutex>
+#include <random>
 #include <shared_mutex>
 
 #include <fmt/format.h>
@@ -13,6 +14,7 @@
 #include "mlx/backend/cpu/compiled_preamble.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/jit_compiler.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/device.h"
 #include "mlx/graph_utils.h"
 
@@ -94,7 +96,19 @@ void* compile(
     kernel_file_name = kernel_name;
   }
 
-  auto output_dir = std::filesystem::temp_directory_path();
+  // Kernels of the same name built from another source, by an older build
+  // of MLX for instance, get a file of their own.
+  auto source_id = std::hash<std::string>{}(source_code);
+  {
+    std::ostringstream file_name;
+    file_name << kernel_file_name << "_" << std::hex << source_id;
+    kernel_file_name = file_name.str();
+  }
+
+  auto output_dir = JitCompiler::cache_dir();
+  if (output_dir.empty()) {
+    output_dir = std::filesystem::temp_directory_path();
+  }
 
   std::string shared_lib_name = "lib" + kernel_file_name + ".so";
   auto shared_lib_path = (output_dir / shared_lib_name).string();
@@ -105,9 +119,12 @@ void* compile(
   }
 
   if (!lib_exists) {
-    // Open source file and write source code to it
-    std::string source_file_name = kernel_file_name + ".cpp";
-    auto source_file_path = (output_dir / source_file_name).string();
+    // Build under names of our own and move the library in place once it is
+    // complete, as other processes may be building or loading the same one.
+    auto build_id = fmt::format("{:x}", std::random_device{}());
+    std::string source_file_name = kernel_file_name + "_" + build_id + ".cpp";
+    std::string tmp_lib_name = shared_lib_name + "." + build_id + ".tmp";
+    auto source_file_path = output_dir / source_file_name;
 
     std::ofstream source_file(source_file_path);
     source_file << source_code;
@@ -115,13 +132,29 @@ void* compile(
 
     try {
       JitCompiler::exec(JitCompiler::build_command(
-          output_dir, source_file_name, shared_lib_name));
+          output_dir, source_file_name, tmp_lib_name));
     } catch (const std::exception& error) {
+      std::error_code ec;
+      std::filesystem::remove(source_file_path, ec);
+      std::filesystem::remove(output_dir / tmp_lib_name, ec);
       throw std::runtime_error(fmt::format(
           "[Compile::eval_cpu] Failed to compile function {0}: {1}",
           kernel_name,
           error.what()));
     }
+    std::error_code ec;
+    std::filesystem::remove(source_file_path, ec);
+    std::filesystem::rename(output_dir / tmp_lib_name, shared_lib_path, ec);
+    if (ec && std::filesystem::exists(shared_lib_path)) {
+      // Another process moved its library in place first.
+      std::filesystem::remove(output_dir / tmp_lib_name, ec);
+    } else if (ec) {
+      throw std::runtime_error(fmt::format(
+          "[Compile::eval_cpu] Failed to move the library of {0} to {1}: {2}",
+          kernel_name,
+          shared_lib_path,
+          ec.message()));
+    }
   }
 
   // load library
@@ -156,8 +189,10 @@ inline void build_kernel(
   os << "__declspec(dllexport) ";
 #endif
 
-  // Start the kernel
-  os << "void " << kernel_name << "(void** args) {" << std::endl;
+  // Start the kernel, which computes the elements [start, end) of the
+  // contiguous outputs or the rows [start, end) of the first dimension.
+  os << "void " << kernel_name
+     << "(void** args, size_t start, size_t end) {" << std::endl;
 
   // Add the input arguments
   int cnt = 0;
@@ -189,14 +224,33 @@ inline void build_kernel(
   // Add output strides and shape to extract the indices.
   if (!contiguous) {
     os << "  const int* shape = (int*)args[" << cnt++ << "];" << std::endl;
-  } else {
-    os << "  const size_t size = (size_t)args[" << cnt++ << "];" << std::endl;
   }
 
   if (contiguous) {
-    os << "  for (size_t i = 0; i < size; ++i) {" << std::endl;
+    // The loop has no dependence between the elements, the outputs only
+    // alias the inputs at the same index.
+    os << "  #pragma omp simd" << std::endl;
+    os << "  for (size_t i = start; i < end; ++i) {" << std::endl;
   } else {
-    for (int d = 0; d < ndim; ++d) {
+    // Move the pointers to the first row of the chunk.
+    os << "  size_t row_size = 1;" << std::endl;
+    for (int d = 1; d < ndim; ++d) {
+      os << "  row_size *= shape[" << d << "];" << std::endl;
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      if (is_constant(i) || is_scalar(x)) {
+        continue;
+      }
+      auto& xname = namer.get_name(x);
+      os << "  " << xname << " += start * " << xname << "_strides[0];"
+         << std::endl;
+    }
+    for (auto& x : outputs) {
+      os << "  " << namer.get_name(x) << " += start * row_size;" << std::endl;
+    }
+    os << "  for (size_t i0 = start; i0 < end; ++i0) {" << std::endl;
+    for (int d = 1; d < ndim; ++d) {
       os << "  for (int i" << d << " = 0; i" << d << " < shape[" << d
          << "]; ++i" << d << ") {" << std::endl;
     }
@@ -335,16 +389,34 @@ void Compiled::eval_cpu(
     args.push_back(x.data<void>());
     encoder.set_output_array(x);
   }
+  // The contiguous kernels are split by elements and the strided ones by
+  // rows of the first dimension, in chunks of at least min_parallel_size
+  // elements.
+  size_t n;
+  size_t grain;
   if (!contiguous) {
     args.push_back((void*)shape.data());
+    size_t row_size = 1;
+    for (int d = 1; d < ndim; ++d) {
+      row_size *= shape[d];
+    }
+    n = shape[0];
+    grain = cpu::min_parallel_size / std::max<size_t>(row_size, 1);
   } else {
-    args.push_back((void*)outputs[0].data_size());
+    n = outputs[0].data_size();
+    grain = cpu::min_parallel_size;
   }
-  auto fun = (void (*)(void**))fn_ptr;
+  auto fun = (void (*)(void**, size_t, size_t))fn_ptr;
   encoder.dispatch([fun,
+                    n,
+                    grain,
                     args = std::move(args),
                     strides = std::move(strides),
-                    shape = std::move(shape)]() mutable { fun(args.data()); });
+                    shape = std::move(shape)]() mutable {
+    cpu::parallel_for(n, grain, [&](size_t start, size_t end) {
+      fun(args.data(), start, end);
+    });
+  });
 }
 
 } // namespace mlx::core
@@ -6,6 +6,8 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/lapack.h"
+#include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
 
@@ -1289,6 +1291,416 @@ void explicit_gemm_conv_ND_cpu(
   encoder.add_temporaries(std::move(temps));
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// Direct conv
+///////////////////////////////////////////////////////////////////////////////
+
+// The output channels and pixels of a row computed at once by the direct
+// conv, which stay in registers over the inner loop on the input channels.
+constexpr int direct_conv_o_block = 2 * simd::max_size<float>;
+constexpr int direct_conv_w_block = 4;
+
+// The size of the unfolded input of the gemm conv from which the direct
+// conv is used instead.
+constexpr size_t direct_conv_unfolded_size = 1 << 24;
+
+// Make |x| row contiguous for the kernels indexing it by its shape.
+array contiguous_conv_input(
+    const array& x,
+    std::vector<array>& temps,
+    Stream stream) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy_cpu(x, x_copy, CopyType::General, stream);
+  temps.push_back(x_copy);
+  return x_copy;
+}
+
+// The 2D conv computing the outputs from the input in place, with no
+// unfolded copy of the input. The weights are packed to float in
+// [wH][wW][C][O] so the output channels are contiguous, and each task
+// computes rows of the output a block of pixels and channels at a time.
+template <typename T>
+void direct_conv_2D(
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding_lo,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    bool flip,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  std::vector<array> temps;
+  auto in_c = contiguous_conv_input(in, temps, stream);
+  encoder.set_input_array(in_c);
+  encoder.set_input_array(wt);
+  encoder.set_output_array(out);
+
+  encoder.dispatch([in_ptr = in_c.data<T>(),
+                    wt_ptr = wt.data<T>(),
+                    out_ptr = out.data<T>(),
+                    N = in.shape(0),
+                    iH = in.shape(1),
+                    iW = in.shape(2),
+                    C = in.shape(3),
+                    oH = out.shape(1),
+                    oW = out.shape(2),
+                    O = wt.shape(0),
+                    wH = wt.shape(1),
+                    wW = wt.shape(2),
+                    wt_strides_ = wt.strides(),
+                    out_strides = out.strides(),
+                    padding_lo,
+                    wt_strides,
+                    wt_dilation,
+                    flip]() {
+    constexpr int S = simd::max_size<float>;
+    constexpr int OB = direct_conv_o_block;
+    constexpr int WB = direct_conv_w_block;
+    int O_padded = (O + OB - 1) / OB * OB;
+
+    std::vector<float> w_pack(size_t(wH) * wW * C * O_padded, 0.0f);
+    for (int kh = 0; kh < wH; ++kh) {
+      for (int kw = 0; kw < wW; ++kw) {
+        int fh = flip ? wH - kh - 1 : kh;
+        int fw = flip ? wW - kw - 1 : kw;
+        const T* w = wt_ptr + fh * wt_strides_[1] + fw * wt_strides_[2];
+        float* dst = w_pack.data() + (size_t(kh) * wW + kw) * C * O_padded;
+        for (int c = 0; c < C; ++c) {
+          for (int o = 0; o < O; ++o) {
+            dst[c * O_padded + o] = static_cast<float>(
+                w[o * wt_strides_[0] + c * wt_strides_[3]]);
+          }
+        }
+      }
+    }
+
+    // The pixels out of the input read zeros.
+    std::vector<T> zeros(C, T(0));
+    size_t row_cost = size_t(oW) * O_padded * C * wH * wW;
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / row_cost, 1);
+    cpu::parallel_for(size_t(N) * oH, grain, [&](size_t r, size_t end) {
+      for (; r < end; ++r) {
+        int n = r / oH;
+        int oh = r % oH;
+        const T* in_n = in_ptr + size_t(n) * iH * iW * C;
+        T* out_row = out_ptr + n * out_strides[0] + oh * out_strides[1];
+        int ih_base = oh * wt_strides[0] - padding_lo[0];
+
+        for (int ow0 = 0; ow0 < oW; ow0 += WB) {
+          int wb = std::min(WB, oW - ow0);
+          for (int o0 = 0; o0 < O_padded; o0 += OB) {
+            simd::Simd<float, S> acc[WB][2];
+            for (int t = 0; t < WB; ++t) {
+              acc[t][0] = acc[t][1] = simd::Simd<float, S>(0.0f);
+            }
+            for (int kh = 0; kh < wH; ++kh) {
+              int ih = ih_base + kh * wt_dilation[0];
+              if (ih < 0 || ih >= iH) {
+                continue;
+              }
+              for (int kw = 0; kw < wW; ++kw) {
+                const T* x[WB];
+                for (int t = 0; t < WB; ++t) {
+                  int iw = (ow0 + t) * wt_strides[1] - padding_lo[1] +
+                      kw * wt_dilation[1];
+                  x[t] = (t < wb && iw >= 0 && iw < iW)
+                      ? in_n + (size_t(ih) * iW + iw) * C
+                      : zeros.data();
+                }
+                const float* w = w_pack.data() +
+                    (size_t(kh) * wW + kw) * C * O_padded + o0;
+                for (int c = 0; c < C; ++c, w += O_padded) {
+                  auto w0 = simd::load<float, S>(w);
+                  auto w1 = simd::load<float, S>(w + S);
+                  for (int t = 0; t < WB; ++t) {
+                    simd::Simd<float, S> xt(static_cast<float>(x[t][c]));
+                    acc[t][0] = simd::fma(xt, w0, acc[t][0]);
+                    acc[t][1] = simd::fma(xt, w1, acc[t][1]);
+                  }
+                }
+              }
+            }
+            int ob = std::min(OB, O - o0);
+            for (int t = 0; t < wb; ++t) {
+              float res[OB];
+              simd::store(res, acc[t][0]);
+              simd::store(res + S, acc[t][1]);
+              T* dst = out_row + (ow0 + t) * out_strides[2] + o0;
+              for (int o = 0; o < ob; ++o) {
+                dst[o * out_strides[3]] = static_cast<T>(res[o]);
+              }
+            }
+          }
+        }
+      }
+    });
+  });
+  encoder.add_temporaries(std::move(temps));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Winograd conv
+///////////////////////////////////////////////////////////////////////////////
+
+// The transforms of F(4x4, 3x3), which computes a tile of 4x4 outputs from
+// a tile of 6x6 inputs with 36 products per pair of channels instead of 144.
+constexpr float winograd_BT[6][6] = {
+    {4, 0, -5, 0, 1, 0},
+    {0, -4, -4, 1, 1, 0},
+    {0, 4, -4, -1, 1, 0},
+    {0, -2, -1, 2, 1, 0},
+    {0, 2, -1, -2, 1, 0},
+    {0, 4, 0, -5, 0, 1}};
+
+constexpr float winograd_G[6][3] = {
+    {1.0f / 4, 0, 0},
+    {-1.0f / 6, -1.0f / 6, -1.0f / 6},
+    {-1.0f / 6, 1.0f / 6, -1.0f / 6},
+    {1.0f / 24, 1.0f / 12, 1.0f / 6},
+    {1.0f / 24, -1.0f / 12, 1.0f / 6},
+    {0, 0, 1}};
+
+constexpr float winograd_AT[4][6] = {
+    {1, 1, 1, 1, 1, 0},
+    {0, 1, -1, 2, -2, 0},
+    {0, 1, 1, 4, 4, 0},
+    {0, 1, -1, 8, -8, 1}};
+
+// The tiles of a row transformed and multiplied at once.
+constexpr int winograd_tile_block = 8;
+
+// y = L x R^T for the |L| of M x K and the |R| of N x K.
+template <int M, int N, int K>
+void winograd_transform(
+    const float (&L)[M][K],
+    const float (&R)[N][K],
+    const float (&x)[K][K],
+    float (&y)[M][N]) {
+  float tmp[M][K];
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < K; ++j) {
+      float s = 0;
+      for (int k = 0; k < K; ++k) {
+        s += L[i][k] * x[k][j];
+      }
+      tmp[i][j] = s;
+    }
+  }
+  for (int i = 0; i < M; ++i) {
+    for (int j = 0; j < N; ++j) {
+      float s = 0;
+      for (int k = 0; k < K; ++k) {
+        s += tmp[i][k] * R[j][k];
+      }
+      y[i][j] = s;
+    }
+  }
+}
+
+// The 2D conv of 3x3 kernels with unit strides and dilations in tiles of
+// F(4x4, 3x3). The transformed weights U are kept in [36][C][O], the tiles
+// of the input of a task are transformed to V in [36][tiles][C] and their
+// products M = V U are 36 small GEMMs over the input channels.
+template <typename T>
+void winograd_conv_2D(
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding_lo,
+    bool flip,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  std::vector<array> temps;
+  auto in_c = contiguous_conv_input(in, temps, stream);
+  encoder.set_input_array(in_c);
+  encoder.set_input_array(wt);
+  encoder.set_output_array(out);
+
+  encoder.dispatch([in_ptr = in_c.data<T>(),
+                    wt_ptr = wt.data<T>(),
+                    out_ptr = out.data<T>(),
+                    N = in.shape(0),
+                    iH = in.shape(1),
+                    iW = in.shape(2),
+                    C = in.shape(3),
+                    oH = out.shape(1),
+                    oW = out.shape(2),
+                    O = wt.shape(0),
+                    wt_strides_ = wt.strides(),
+                    out_strides = out.strides(),
+                    padding_lo,
+                    flip]() {
+    constexpr int S = simd::max_size<float>;
+    constexpr int OB = 2 * S;
+    constexpr int TB = winograd_tile_block;
+    int O_padded = (O + OB - 1) / OB * OB;
+
+    std::vector<float> U(36 * size_t(C) * O_padded, 0.0f);
+    for (int c = 0; c < C; ++c) {
+      for (int o = 0; o < O; ++o) {
+        float g[3][3];
+        for (int kh = 0; kh < 3; ++kh) {
+          for (int kw = 0; kw < 3; ++kw) {
+            int fh = flip ? 2 - kh : kh;
+            int fw = flip ? 2 - kw : kw;
+            g[kh][kw] = static_cast<float>(
+                wt_ptr
+                    [o * wt_strides_[0] + fh * wt_strides_[1] +
+                     fw * wt_strides_[2] + c * wt_strides_[3]]);
+          }
+        }
+        float u[6][6];
+        winograd_transform(winograd_G, winograd_G, g, u);
+        for (int xi = 0; xi < 36; ++xi) {
+          U[(size_t(xi) * C + c) * O_padded + o] = u[xi / 6][xi % 6];
+        }
+      }
+    }
+
+    int tH = (oH + 3) / 4;
+    int tW = (oW + 3) / 4;
+    int tW_blocks = (tW + TB - 1) / TB;
+    size_t block_cost = size_t(36) * TB * C * O_padded;
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / block_cost, 1);
+    cpu::parallel_for(
+        size_t(N) * tH * tW_blocks, grain, [&](size_t b, size_t end) {
+          std::vector<float> V(36 * size_t(TB) * C);
+          std::vector<float> M(36 * size_t(TB) * O_padded);
+          for (; b < end; ++b) {
+            int n = b / (tH * tW_blocks);
+            int th = (b / tW_blocks) % tH;
+            int tw0 = (b % tW_blocks) * TB;
+            int tb = std::min(TB, tW - tw0);
+            const T* in_n = in_ptr + size_t(n) * iH * iW * C;
+
+            // Transform the input tiles
+            for (int t = 0; t < tb; ++t) {
+              int ih0 = th * 4 - padding_lo[0];
+              int iw0 = (tw0 + t) * 4 - padding_lo[1];
+              for (int c = 0; c < C; ++c) {
+                float d[6][6];
+                for (int i = 0; i < 6; ++i) {
+                  int ih = ih0 + i;
+                  for (int j = 0; j < 6; ++j) {
+                    int iw = iw0 + j;
+                    d[i][j] = (ih >= 0 && ih < iH && iw >= 0 && iw < iW)
+                        ? static_cast<float>(
+                              in_n[(size_t(ih) * iW + iw) * C + c])
+                        : 0.0f;
+                  }
+                }
+                float v[6][6];
+                winograd_transform(winograd_BT, winograd_BT, d, v);
+                for (int xi = 0; xi < 36; ++xi) {
+                  V[(size_t(xi) * TB + t) * C + c] = v[xi / 6][xi % 6];
+                }
+              }
+            }
+
+            // Multiply them with the weights, each block of weights loaded
+            // once for all the tiles
+            for (int xi = 0; xi < 36; ++xi) {
+              const float* v = V.data() + size_t(xi) * TB * C;
+              float* m = M.data() + size_t(xi) * TB * O_padded;
+              for (int o0 = 0; o0 < O_padded; o0 += OB) {
+                simd::Simd<float, S> acc[TB][2];
+                for (int t = 0; t < TB; ++t) {
+                  acc[t][0] = acc[t][1] = simd::Simd<float, S>(0.0f);
+                }
+                const float* u =
+                    U.data() + size_t(xi) * C * O_padded + o0;
+                for (int c = 0; c < C; ++c, u += O_padded) {
+                  auto u0 = simd::load<float, S>(u);
+                  auto u1 = simd::load<float, S>(u + S);
+                  for (int t = 0; t < TB; ++t) {
+                    simd::Simd<float, S> vt(v[t * C + c]);
+                    acc[t][0] = simd::fma(vt, u0, acc[t][0]);
+                    acc[t][1] = simd::fma(vt, u1, acc[t][1]);
+                  }
+                }
+                for (int t = 0; t < tb; ++t) {
+                  simd::store(m + t * O_padded + o0, acc[t][0]);
+                  simd::store(m + t * O_padded + o0 + S, acc[t][1]);
+                }
+              }
+            }
+
+            // Transform the products back to the output tiles
+            for (int t = 0; t < tb; ++t) {
+              int oh0 = th * 4;
+              int ow0 = (tw0 + t) * 4;
+              T* out_tile = out_ptr + n * out_strides[0] +
+                  oh0 * out_strides[1] + ow0 * out_strides[2];
+              for (int o = 0; o < O; ++o) {
+                float m[6][6];
+                for (int xi = 0; xi < 36; ++xi) {
+                  m[xi / 6][xi % 6] = M[(size_t(xi) * TB + t) * O_padded + o];
+                }
+                float y[4][4];
+                winograd_transform(winograd_AT, winograd_AT, m, y);
+                for (int i = 0; i < std::min(4, oH - oh0); ++i) {
+                  for (int j = 0; j < std::min(4, oW - ow0); ++j) {
+                    out_tile
+                        [i * out_strides[1] + j * out_strides[2] +
+                         o * out_strides[3]] = static_cast<T>(y[i][j]);
+                  }
+                }
+              }
+            }
+          }
+        });
+  });
+  encoder.add_temporaries(std::move(temps));
+}
+
+void dispatch_direct_conv_2D(
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding_lo,
+    const std::vector<int>& wt_strides,
+    const std::vector<int>& wt_dilation,
+    bool flip,
+    Stream stream) {
+  if (in.dtype() == float32) {
+    return direct_conv_2D<float>(
+        in, wt, out, padding_lo, wt_strides, wt_dilation, flip, stream);
+  } else if (in.dtype() == float16) {
+    return direct_conv_2D<float16_t>(
+        in, wt, out, padding_lo, wt_strides, wt_dilation, flip, stream);
+  } else if (in.dtype() == bfloat16) {
+    return direct_conv_2D<bfloat16_t>(
+        in, wt, out, padding_lo, wt_strides, wt_dilation, flip, stream);
+  } else {
+    throw std::invalid_argument(
+        "[Convolution::eval] got unsupported data type.");
+  }
+}
+
+void dispatch_winograd_conv_2D(
+    const array& in,
+    const array& wt,
+    array out,
+    const std::vector<int>& padding_lo,
+    bool flip,
+    Stream stream) {
+  if (in.dtype() == float32) {
+    return winograd_conv_2D<float>(in, wt, out, padding_lo, flip, stream);
+  } else if (in.dtype() == float16) {
+    return winograd_conv_2D<float16_t>(in, wt, out, padding_lo, flip, stream);
+  } else if (in.dtype() == bfloat16) {
+    return winograd_conv_2D<bfloat16_t>(
+        in, wt, out, padding_lo, flip, stream);
+  } else {
+    throw std::invalid_argument(
+        "[Convolution::eval] got unsupported data type.");
+  }
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // Conv routing
 ///////////////////////////////////////////////////////////////////////////////
@@ -1347,8 +1759,33 @@ void conv_2D_cpu(
     bool flip,
     Stream stream) {
   const int groups = in.shape().back() / wt.shape().back();
-  if (wt_dilation[0] == 1 && wt_dilation[1] == 1 && in_dilation[0] == 1 &&
-      in_dilation[1] == 1 && groups == 1) {
+  const int C = in.shape(3);
+  const int O = wt.shape(0);
+  const int wH = wt.shape(1);
+  const int wW = wt.shape(2);
+  bool no_in_dilation = in_dilation[0] == 1 && in_dilation[1] == 1;
+  bool no_wt_dilation = wt_dilation[0] == 1 && wt_dilation[1] == 1;
+  if (no_in_dilation && groups == 1 && in.dtype() != float64) {
+    // The kernels below only beat the BLAS gemm with the vector units, the
+    // Winograd tiles paying for their transforms with enough channels.
+    constexpr bool has_simd = simd::max_size<float> >= 8;
+    if (has_simd && wH == 3 && wW == 3 && wt_strides[0] == 1 &&
+        wt_strides[1] == 1 && no_wt_dilation && C >= 64 && O >= 64 &&
+        out.shape(1) >= 4 && out.shape(2) >= 4) {
+      return dispatch_winograd_conv_2D(in, wt, out, padding_lo, flip, stream);
+    }
+    // The direct conv avoids the unfolded input, which is the bulk of the
+    // work of the gemm conv with few channels and too large to keep with
+    // large inputs.
+    size_t unfolded_size = out.size() / O * wH * wW * C;
+    if (wH * wW > 1 &&
+        ((has_simd && (C < 16 || O < 16)) ||
+         unfolded_size > direct_conv_unfolded_size)) {
+      return dispatch_direct_conv_2D(
+          in, wt, out, padding_lo, wt_strides, wt_dilation, flip, stream);
+    }
+  }
+  if (no_wt_dilation && no_in_dilation && groups == 1) {
     return explicit_gemm_conv_ND_cpu(
         in,
         wt,
@@ -7,6 +7,7 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 
 namespace mlx::core {
 
@@ -18,7 +19,9 @@ void copy_single(const array& src, array& dst) {
   auto dst_ptr = dst.data<DstT>();
   auto size = dst.size();
   auto val = static_cast<DstT>(src_ptr[0]);
-  std::fill_n(dst_ptr, size, val);
+  cpu::parallel_for(size, cpu::min_parallel_size, [&](size_t i, size_t end) {
+    std::fill_n(dst_ptr + i, end - i, val);
+  });
 }
 
 template <typename SrcT, typename DstT>
@@ -26,7 +29,9 @@ void copy_vector(const array& src, array& dst) {
   auto src_ptr = src.data<SrcT>();
   auto dst_ptr = dst.data<DstT>();
   auto size = src.data_size();
-  std::copy(src_ptr, src_ptr + size, dst_ptr);
+  cpu::parallel_for(size, cpu::min_parallel_size, [&](size_t i, size_t end) {
+    std::copy(src_ptr + i, src_ptr + end, dst_ptr + i);
+  });
 }
 
 template <typename SrcT, typename DstT, int D>
@@ -76,7 +81,10 @@ void copy_general_general(
     *dst_ptr = val;
     return;
   }
-  auto [shape, strides] =
+  // Not a structured binding, as it is captured by the chunks.
+  Shape shape;
+  std::vector<Strides> strides;
+  std::tie(shape, strides) =
       collapse_contiguous_dims(data_shape, {i_strides, o_strides});
 
   int ndim = shape.size();
@@ -107,21 +115,29 @@ void copy_general_general(
     dst_ptr += o_offset_ptr[0];
   }
 
-  ContiguousIterator in(shape, strides[0], ndim - 3);
-  ContiguousIterator out(shape, strides[1], ndim - 3);
   auto stride = std::accumulate(
       shape.end() - 3, shape.end(), 1, std::multiplies<int64_t>());
-  for (int64_t elem = 0; elem < size; elem += stride) {
-    copy_dims<SrcT, DstT, 3>(
-        src_ptr + in.loc,
-        dst_ptr + out.loc,
-        shape,
-        strides[0],
-        strides[1],
-        ndim - 3);
-    in.step();
-    out.step();
-  }
+  // The blocks of the last 3 dims are split, each chunk seeking its
+  // iterators to its first block.
+  size_t num_blocks = (size + stride - 1) / stride;
+  size_t grain = (cpu::min_parallel_size + stride - 1) / stride;
+  cpu::parallel_for(num_blocks, grain, [&](size_t block, size_t end) {
+    ContiguousIterator in(shape, strides[0], ndim - 3);
+    ContiguousIterator out(shape, strides[1], ndim - 3);
+    in.seek(block);
+    out.seek(block);
+    for (; block < end; ++block) {
+      copy_dims<SrcT, DstT, 3>(
+          src_ptr + in.loc,
+          dst_ptr + out.loc,
+          shape,
+          strides[0],
+          strides[1],
+          ndim - 3);
+      in.step();
+      out.step();
+    }
+  });
 }
 
 template <typename SrcT, typename DstT>
@@ -44,7 +44,12 @@ void AllReduce::eval_cpu(
   auto in = donate_or_copy(inputs[0], outputs[0]);
   switch (reduce_type_) {
     case Sum:
-      distributed::detail::all_sum(group(), in, outputs[0], stream());
+      if (compression_) {
+        distributed::detail::compressed_all_sum(
+            group(), in, outputs[0], *compression_, stream());
+      } else {
+        distributed::detail::all_sum(group(), in, outputs[0], stream());
+      }
       break;
     case Max:
       distributed::detail::all_max(group(), in, outputs[0], stream());
@@ -73,6 +78,38 @@ void AllGather::eval_cpu(
   }
 }
 
+void ReduceScatter::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto [in, copied] = ensure_row_contiguous(inputs[0], stream());
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::reduce_scatter(group(), in, outputs[0], stream());
+  if (copied) {
+    auto& enc = cpu::get_command_encoder(stream());
+    enc.add_temporary(in);
+  }
+}
+
+void AllToAll::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto [in, copied] = ensure_row_contiguous(inputs[0], stream());
+  auto [send_counts, recv_counts] = counts(in);
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::all_to_all(
+      group(), in, outputs[0], send_counts, recv_counts, stream());
+  if (copied) {
+    auto& enc = cpu::get_command_encoder(stream());
+    enc.add_temporary(in);
+  }
+}
+
 void Send::eval_cpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
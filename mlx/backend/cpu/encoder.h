@@ -2,6 +2,10 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <unordered_map>
 
 #include "mlx/array.h"
@@ -9,8 +13,11 @@
 
 namespace mlx::core::cpu {
 
-// Number of dispatches per scheduler task
+// Number of dispatches per scheduler task before any is timed, the batches
+// then hold as many dispatches as run in about |TARGET_TASK_NS|.
 constexpr int DISPATCHES_PER_TASK = 10;
+constexpr int MAX_DISPATCHES_PER_TASK = 1024;
+constexpr int64_t TARGET_TASK_NS = 100'000;
 
 struct CommandEncoder {
   CommandEncoder(Stream stream) : stream_(stream) {}
@@ -42,24 +49,76 @@ struct CommandEncoder {
 
   template <class F, class... Args>
   void dispatch(F&& f, Args&&... args) {
-    num_ops_ = (num_ops_ + 1) % DISPATCHES_PER_TASK;
-    auto task = std::bind(std::forward<F>(f), std::forward<Args>(args)...);
-    if (num_ops_ == 0) {
-      scheduler::notify_new_task(stream_);
-      auto task_wrap = [s = stream_, task = std::move(task)]() mutable {
-        task();
-        scheduler::notify_task_completion(s);
-      };
-      scheduler::enqueue(stream_, std::move(task_wrap));
+    if constexpr (sizeof...(Args) == 0) {
+      dispatch_task(std::forward<F>(f));
     } else {
-      scheduler::enqueue(stream_, std::move(task));
+      dispatch_task(
+          std::bind(std::forward<F>(f), std::forward<Args>(args)...));
     }
   }
 
  private:
+  // Written by the stream thread when a batch starts and ends and read by
+  // the encoder when it starts the next batch.
+  struct BatchTiming {
+    std::atomic<int64_t> start_ns{0};
+    std::atomic<int64_t> op_ns{0};
+  };
+
+  static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+
+  // The first task of a batch records the time it starts and the last one
+  // the time per dispatch of the batch, which sets the size of the next
+  // batches. The scheduler is only notified once per batch.
+  template <class F>
+  void dispatch_task(F&& task) {
+    if (num_ops_ == 0) {
+      if (auto op_ns = timing_->op_ns.load(std::memory_order_relaxed)) {
+        batch_size_ = std::clamp<int64_t>(
+            TARGET_TASK_NS / op_ns, 1, MAX_DISPATCHES_PER_TASK);
+      }
+    }
+    bool first = num_ops_ == 0;
+    bool last = ++num_ops_ == batch_size_;
+    if (!first && !last) {
+      scheduler::enqueue(stream_, std::forward<F>(task));
+      return;
+    }
+    auto task_wrap = [s = stream_,
+                      timing = timing_,
+                      n = batch_size_,
+                      first,
+                      last,
+                      task = std::forward<F>(task)]() mutable {
+      if (first) {
+        timing->start_ns.store(now_ns(), std::memory_order_relaxed);
+      }
+      task();
+      if (last) {
+        auto elapsed =
+            now_ns() - timing->start_ns.load(std::memory_order_relaxed);
+        timing->op_ns.store(
+            std::max<int64_t>(elapsed / n, 1), std::memory_order_relaxed);
+        scheduler::notify_task_completion(s);
+      }
+    };
+    if (last) {
+      num_ops_ = 0;
+      scheduler::notify_new_task(stream_);
+    }
+    scheduler::enqueue(stream_, std::move(task_wrap));
+  }
+
   Stream stream_;
   std::vector<array> temporaries_;
   int num_ops_{0};
+  int batch_size_{DISPATCHES_PER_TASK};
+  // Shared with the tasks in flight which may outlive the encoder at exit.
+  std::shared_ptr<BatchTiming> timing_{std::make_shared<BatchTiming>()};
 };
 
 CommandEncoder& get_command_encoder(Stream stream);
@@ -1,5 +1,6 @@
 // Copyright © 2025 Apple Inc.
 #include "mlx/backend/cpu/eval.h"
+#include "mlx/backend/common/numa.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/primitives.h"
 #include "mlx/scheduler.h"
@@ -18,6 +19,8 @@ void eval(array& arr) {
     if (arr.is_tracer()) {
       inputs = arr.inputs();
     }
+    // The outputs are allocated on the node of the stream.
+    numa::NodeScope scope(numa::stream_node(s.index));
     arr.primitive().eval_cpu(arr.inputs(), outputs);
   }
 
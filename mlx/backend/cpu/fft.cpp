@@ -1,14 +1,60 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
 #include <numeric>
 
 #include "mlx/3rdparty/pocketfft.h"
 #include "mlx/allocator.h"
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
+namespace {
+
+// Run |fft(shape, in, out)| on chunks of the largest axis not transformed,
+// the lines along the other axes being independent. The strides are in
+// bytes.
+template <typename In, typename Out, typename F>
+void parallel_fft(
+    const std::vector<size_t>& shape,
+    const std::vector<std::ptrdiff_t>& strides_in,
+    const std::vector<std::ptrdiff_t>& strides_out,
+    const std::vector<size_t>& axes,
+    const In* in,
+    Out* out,
+    F fft) {
+  int ndim = shape.size();
+  int batch_axis = -1;
+  for (int i = 0; i < ndim; ++i) {
+    if (std::find(axes.begin(), axes.end(), i) == axes.end() &&
+        (batch_axis < 0 || shape[i] > shape[batch_axis])) {
+      batch_axis = i;
+    }
+  }
+  size_t size = std::accumulate(
+      shape.begin(), shape.end(), size_t(1), std::multiplies<>());
+  if (batch_axis < 0 || size < cpu::min_parallel_size) {
+    fft(shape, in, out);
+    return;
+  }
+  size_t batch = shape[batch_axis];
+  size_t grain = std::max<size_t>(
+      cpu::min_parallel_size / (size / std::max<size_t>(batch, 1)), 1);
+  cpu::parallel_for(batch, grain, [&](size_t b, size_t end) {
+    auto chunk_shape = shape;
+    chunk_shape[batch_axis] = end - b;
+    fft(chunk_shape,
+        reinterpret_cast<const In*>(
+            reinterpret_cast<const char*>(in) + b * strides_in[batch_axis]),
+        reinterpret_cast<Out*>(
+            reinterpret_cast<char*>(out) + b * strides_out[batch_axis]));
+  });
+}
+
+} // namespace
+
 void FFT::eval_cpu(const std::vector<array>& inputs, array& out) {
   auto& in = inputs[0];
   std::vector<std::ptrdiff_t> strides_in(
@@ -57,15 +103,24 @@ void FFT::eval_cpu(const std::vector<array>& inputs, array& out) {
                       in_ptr,
                       out_ptr,
                       scale]() {
-      pocketfft::c2c(
+      parallel_fft(
           shape,
           strides_in,
           strides_out,
           axes,
-          !inverse,
           in_ptr,
           out_ptr,
-          scale);
+          [&](const auto& chunk_shape, auto in, auto out) {
+            pocketfft::c2c(
+                chunk_shape,
+                strides_in,
+                strides_out,
+                axes,
+                !inverse,
+                in,
+                out,
+                scale);
+          });
     });
   } else if (in.dtype() == float32 && out.dtype() == complex64) {
     auto in_ptr = in.data<float>();
@@ -79,15 +134,24 @@ void FFT::eval_cpu(const std::vector<array>& inputs, array& out) {
                       in_ptr,
                       out_ptr,
                       scale]() {
-      pocketfft::r2c(
+      parallel_fft(
           shape,
           strides_in,
           strides_out,
           axes,
-          !inverse,
           in_ptr,
           out_ptr,
-          scale);
+          [&](const auto& chunk_shape, auto in, auto out) {
+            pocketfft::r2c(
+                chunk_shape,
+                strides_in,
+                strides_out,
+                axes,
+                !inverse,
+                in,
+                out,
+                scale);
+          });
     });
   } else if (in.dtype() == complex64 && out.dtype() == float32) {
     auto in_ptr =
@@ -101,15 +165,24 @@ void FFT::eval_cpu(const std::vector<array>& inputs, array& out) {
                       in_ptr,
                       out_ptr,
                       scale]() {
-      pocketfft::c2r(
+      parallel_fft(
           shape,
           strides_in,
           strides_out,
           axes,
-          !inverse,
           in_ptr,
           out_ptr,
-          scale);
+          [&](const auto& chunk_shape, auto in, auto out) {
+            pocketfft::c2r(
+                chunk_shape,
+                strides_in,
+                strides_out,
+                axes,
+                !inverse,
+                in,
+                out,
+                scale);
+          });
     });
   } else {
     throw std::runtime_error(
@@ -0,0 +1,169 @@
+// Copyright © 2025 Apple Inc.
+
+#include <cmath>
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// The activation of the gate a and, for the vjp, its derivative.
+template <typename AccT>
+AccT activation(GatedActivation::Kind kind, AccT a, AccT* dact = nullptr) {
+  if (kind == GatedActivation::SiLU) {
+    AccT sig = 1 / (1 + std::exp(-a));
+    if (dact) {
+      *dact = sig * (1 + a * (1 - sig));
+    }
+    return a * sig;
+  } else {
+    AccT cdf = 0.5 * (1 + std::erf(a * M_SQRT1_2));
+    if (dact) {
+      *dact = cdf + a * 0.5 * M_2_SQRTPI * M_SQRT1_2 * std::exp(-0.5 * a * a);
+    }
+    return a * cdf;
+  }
+}
+
+// Each row of |x| holds the H gates followed by the H up projections.
+template <typename T, typename AccT>
+void gated_activation(
+    GatedActivation::Kind kind,
+    const array& x,
+    array& out,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(x);
+  encoder.set_output_array(out);
+
+  const T* x_ptr = x.data<T>();
+  T* out_ptr = out.data<T>();
+  int64_t H = out.shape().back();
+  int64_t L = H == 0 ? 0 : out.size() / H;
+
+  encoder.dispatch([kind, x_ptr, out_ptr, H, L]() mutable {
+    for (int64_t i = 0; i < L; i++, x_ptr += 2 * H, out_ptr += H) {
+      for (int64_t j = 0; j < H; j++) {
+        AccT act = activation<AccT>(kind, x_ptr[j]);
+        out_ptr[j] = static_cast<T>(act * static_cast<AccT>(x_ptr[H + j]));
+      }
+    }
+  });
+}
+
+// The gradients of both halves of a row only depend on the same positions
+// of x, so |grad| may share the buffer of x.
+template <typename T, typename AccT>
+void gated_activation_vjp(
+    GatedActivation::Kind kind,
+    const array& x,
+    const array& g,
+    array& grad,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(x);
+  encoder.set_input_array(g);
+  encoder.set_output_array(grad);
+
+  const T* x_ptr = x.data<T>();
+  const T* g_ptr = g.data<T>();
+  T* grad_ptr = grad.data<T>();
+  int64_t H = g.shape().back();
+  int64_t L = H == 0 ? 0 : g.size() / H;
+
+  encoder.dispatch([kind, x_ptr, g_ptr, grad_ptr, H, L]() mutable {
+    for (int64_t i = 0; i < L; i++, x_ptr += 2 * H, g_ptr += H) {
+      for (int64_t j = 0; j < H; j++) {
+        AccT a = x_ptr[j];
+        AccT b = x_ptr[H + j];
+        AccT gi = g_ptr[j];
+        AccT dact;
+        AccT act = activation<AccT>(kind, a, &dact);
+        grad_ptr[j] = static_cast<T>(gi * b * dact);
+        grad_ptr[H + j] = static_cast<T>(gi * act);
+      }
+      grad_ptr += 2 * H;
+    }
+  });
+}
+
+array ensure_row_contiguous(
+    const array& x,
+    cpu::CommandEncoder& encoder,
+    Stream s) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy_cpu(x, x_copy, CopyType::General, s);
+  encoder.add_temporary(x_copy);
+  return x_copy;
+}
+
+} // namespace
+
+void GatedActivation::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto x = ensure_row_contiguous(inputs[0], encoder, s);
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  switch (x.dtype()) {
+    case float32:
+      gated_activation<float, float>(kind_, x, out, s);
+      break;
+    case float16:
+      gated_activation<float16_t, float>(kind_, x, out, s);
+      break;
+    case bfloat16:
+      gated_activation<bfloat16_t, float>(kind_, x, out, s);
+      break;
+    case float64:
+      gated_activation<double, double>(kind_, x, out, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[gated_activation] only supports floating point types");
+  }
+}
+
+void GatedActivationVJP::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto x = ensure_row_contiguous(inputs[0], encoder, s);
+  auto g = ensure_row_contiguous(inputs[1], encoder, s);
+  auto& grad = outputs[0];
+  if (inputs[0].flags().row_contiguous && inputs[0].is_donatable()) {
+    grad.copy_shared_buffer(inputs[0]);
+  } else {
+    grad.set_data(allocator::malloc(grad.nbytes()));
+  }
+
+  switch (x.dtype()) {
+    case float32:
+      gated_activation_vjp<float, float>(kind_, x, g, grad, s);
+      break;
+    case float16:
+      gated_activation_vjp<float16_t, float>(kind_, x, g, grad, s);
+      break;
+    case bfloat16:
+      gated_activation_vjp<bfloat16_t, float>(kind_, x, g, grad, s);
+      break;
+    case float64:
+      gated_activation_vjp<double, double>(kind_, x, g, grad, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[gated_activation] only supports floating point types");
+  }
+}
+
+} // namespace mlx::core::fast
@@ -0,0 +1,150 @@
+// Copyright © 2025 Apple Inc.
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "mlx/backend/cpu/threading.h"
+
+namespace mlx::core {
+
+// The outputs of C computed by a task, and the depth of A and B packed at
+// once so the panels stay in the caches of the core.
+constexpr int packed_gemm_mc = 64;
+constexpr int packed_gemm_nc = 256;
+constexpr int packed_gemm_kc = 256;
+
+// The micro kernel accumulating a tile of MR x NR outputs in float. The
+// panels hold |k_pack| consecutive elements of K per packed element, the
+// panel of A by rows of MR and the panel of B by rows of NR.
+struct FloatGemmKernel {
+  using pack_t = float;
+  static constexpr int mr = 4;
+  static constexpr int nr = 16;
+  static constexpr int k_pack = 1;
+
+  template <typename T>
+  static pack_t pack(const T* x, int n, size_t stride) {
+    return n > 0 ? static_cast<float>(*x) : 0.0f;
+  }
+
+  static void run(int kp, const pack_t* a, const pack_t* b, float* c, int ldc) {
+    float acc[mr][nr] = {};
+    for (int k = 0; k < kp; ++k, a += mr, b += nr) {
+      for (int i = 0; i < mr; ++i) {
+        for (int j = 0; j < nr; ++j) {
+          acc[i][j] += a[i] * b[j];
+        }
+      }
+    }
+    for (int i = 0; i < mr; ++i) {
+      for (int j = 0; j < nr; ++j) {
+        c[i * ldc + j] += acc[i][j];
+      }
+    }
+  }
+};
+
+// C = alpha * A @ B + beta * C with the panels of A and B packed by the
+// |Kernel| and the tiles of C split over the thread pool.
+template <typename Kernel, typename T>
+void packed_gemm(
+    const T* a,
+    const T* b,
+    T* c,
+    bool a_trans,
+    bool b_trans,
+    size_t lda,
+    size_t ldb,
+    size_t ldc,
+    size_t M,
+    size_t N,
+    size_t K,
+    float alpha,
+    float beta) {
+  using P = typename Kernel::pack_t;
+  constexpr int MR = Kernel::mr;
+  constexpr int NR = Kernel::nr;
+  constexpr int KP = Kernel::k_pack;
+  constexpr int MC = packed_gemm_mc;
+  constexpr int NC = packed_gemm_nc;
+  constexpr int KC = packed_gemm_kc;
+  static_assert(MC % MR == 0 && NC % NR == 0 && KC % KP == 0);
+
+  // The element (i, k) of A and its stride along K, and (k, j) of B.
+  auto a_at = [&](size_t i, size_t k) {
+    return a_trans ? a + k * lda + i : a + i * lda + k;
+  };
+  size_t a_kstride = a_trans ? lda : 1;
+  auto b_at = [&](size_t k, size_t j) {
+    return b_trans ? b + j * ldb + k : b + k * ldb + j;
+  };
+  size_t b_kstride = b_trans ? 1 : ldb;
+
+  size_t m_blocks = (M + MC - 1) / MC;
+  size_t n_blocks = (N + NC - 1) / NC;
+  // A task per tile of C, each packing its panels in its own buffers.
+  cpu::parallel_for(m_blocks * n_blocks, 1, [&](size_t t, size_t end) {
+    std::vector<P> a_pack(MC * (KC / KP));
+    std::vector<P> b_pack((KC / KP) * NC);
+    std::vector<float> acc(MC * NC);
+    for (; t < end; ++t) {
+      size_t i0 = (t / n_blocks) * MC;
+      size_t j0 = (t % n_blocks) * NC;
+      int mc = std::min<size_t>(MC, M - i0);
+      int nc = std::min<size_t>(NC, N - j0);
+      int mc_padded = (mc + MR - 1) / MR * MR;
+      int nc_padded = (nc + NR - 1) / NR * NR;
+      std::fill(acc.begin(), acc.end(), 0.0f);
+
+      for (size_t k0 = 0; k0 < K; k0 += KC) {
+        int kc = std::min<size_t>(KC, K - k0);
+        int kp = (kc + KP - 1) / KP;
+        for (int p = 0; p < mc_padded; p += MR) {
+          P* dst = a_pack.data() + p * kp;
+          for (int k = 0; k < kp; ++k) {
+            for (int r = 0; r < MR; ++r) {
+              int n = (p + r < mc) ? kc - k * KP : 0;
+              *dst++ = Kernel::pack(
+                  a_at(i0 + p + r, k0 + k * KP), std::min(n, KP), a_kstride);
+            }
+          }
+        }
+        for (int q = 0; q < nc_padded; q += NR) {
+          P* dst = b_pack.data() + q * kp;
+          for (int k = 0; k < kp; ++k) {
+            for (int r = 0; r < NR; ++r) {
+              int n = (q + r < nc) ? kc - k * KP : 0;
+              *dst++ = Kernel::pack(
+                  b_at(k0 + k * KP, j0 + q + r), std::min(n, KP), b_kstride);
+            }
+          }
+        }
+        for (int p = 0; p < mc_padded; p += MR) {
+          for (int q = 0; q < nc_padded; q += NR) {
+            Kernel::run(
+                kp,
+                a_pack.data() + p * kp,
+                b_pack.data() + q * kp,
+                acc.data() + p * NC + q,
+                NC);
+          }
+        }
+      }
+
+      for (int i = 0; i < mc; ++i) {
+        T* out = c + (i0 + i) * ldc + j0;
+        const float* in = acc.data() + i * NC;
+        for (int j = 0; j < nc; ++j) {
+          float v = alpha * in[j];
+          if (beta != 0.0f) {
+            v += beta * static_cast<float>(out[j]);
+          }
+          out[j] = static_cast<T>(v);
+        }
+      }
+    }
+  });
+}
+
+} // namespace mlx::core
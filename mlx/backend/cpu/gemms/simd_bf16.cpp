@@ -1,11 +1,77 @@
 // Copyright © 2025 Apple Inc.
 
+#include <cstring>
+
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cpu/gemm.h"
-#include "mlx/backend/cpu/gemms/simd_gemm.h"
+#include "mlx/backend/cpu/gemms/packed_gemm.h"
+
+#if defined(__x86_64__) && !defined(_MSC_VER)
+#include <immintrin.h>
+#define MLX_X86_BF16_GEMM
+#endif
 
 namespace mlx::core {
 
+namespace {
+
+#ifdef MLX_X86_BF16_GEMM
+
+// The micro kernel of the CPUs with AVX512-BF16, which multiplies the pairs
+// of bfloat16 along K of A and B and accumulates them in float without
+// converting the inputs.
+struct Bf16GemmKernel {
+  using pack_t = uint32_t;
+  static constexpr int mr = 8;
+  static constexpr int nr = 32;
+  static constexpr int k_pack = 2;
+
+  static pack_t pack(const bfloat16_t* x, int n, size_t stride) {
+    uint16_t lo = 0;
+    uint16_t hi = 0;
+    if (n > 0) {
+      std::memcpy(&lo, x, sizeof(lo));
+    }
+    if (n > 1) {
+      std::memcpy(&hi, x + stride, sizeof(hi));
+    }
+    return lo | (static_cast<uint32_t>(hi) << 16);
+  }
+
+  __attribute__((target("avx512f,avx512bf16"))) static void
+  run(int kp, const pack_t* a, const pack_t* b, float* c, int ldc) {
+    __m512 acc[mr][2];
+    for (int i = 0; i < mr; ++i) {
+      acc[i][0] = _mm512_setzero_ps();
+      acc[i][1] = _mm512_setzero_ps();
+    }
+    for (int k = 0; k < kp; ++k, a += mr, b += nr) {
+      auto b0 = (__m512bh)_mm512_loadu_si512(b);
+      auto b1 = (__m512bh)_mm512_loadu_si512(b + 16);
+      for (int i = 0; i < mr; ++i) {
+        auto ai = (__m512bh)_mm512_set1_epi32(a[i]);
+        acc[i][0] = _mm512_dpbf16_ps(acc[i][0], ai, b0);
+        acc[i][1] = _mm512_dpbf16_ps(acc[i][1], ai, b1);
+      }
+    }
+    for (int i = 0; i < mr; ++i) {
+      float* ci = c + i * ldc;
+      _mm512_storeu_ps(ci, _mm512_add_ps(_mm512_loadu_ps(ci), acc[i][0]));
+      _mm512_storeu_ps(
+          ci + 16, _mm512_add_ps(_mm512_loadu_ps(ci + 16), acc[i][1]));
+    }
+  }
+};
+
+bool has_avx512_bf16() {
+  static bool has = __builtin_cpu_supports("avx512bf16");
+  return has;
+}
+
+#endif
+
+} // namespace
+
 template <>
 void matmul<bfloat16_t>(
     const bfloat16_t* a,
@@ -27,13 +93,22 @@ void matmul<bfloat16_t>(
   size_t M = a_shape[ndim - 2];
   size_t N = b_shape[ndim - 1];
   size_t K = a_shape[ndim - 1];
+  auto gemm = packed_gemm<FloatGemmKernel, bfloat16_t>;
+#ifdef MLX_X86_BF16_GEMM
+  if (has_avx512_bf16()) {
+    gemm = packed_gemm<Bf16GemmKernel, bfloat16_t>;
+  }
+#endif
   for (int i = 0; i < batch_size; ++i) {
-    simd_gemm<bfloat16_t, float>(
+    gemm(
         a + elem_to_loc(M * K * i, a_shape, a_strides),
         b + elem_to_loc(K * N * i, b_shape, b_strides),
         out + M * N * i,
         a_transposed,
         b_transposed,
+        lda,
+        ldb,
+        ldc,
         M,
         N,
         K,
@@ -2,7 +2,7 @@
 
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cpu/gemm.h"
-#include "mlx/backend/cpu/gemms/simd_gemm.h"
+#include "mlx/backend/cpu/gemms/packed_gemm.h"
 
 namespace mlx::core {
 
@@ -28,12 +28,15 @@ void matmul<float16_t>(
   size_t N = b_shape[ndim - 1];
   size_t K = a_shape[ndim - 1];
   for (int i = 0; i < batch_size; ++i) {
-    simd_gemm<float16_t, float>(
+    packed_gemm<FloatGemmKernel>(
         a + elem_to_loc(M * K * i, a_shape, a_strides),
         b + elem_to_loc(K * N * i, b_shape, b_strides),
         out + M * N * i,
         a_transposed,
         b_transposed,
+        lda,
+        ldb,
+        ldc,
         M,
         N,
         K,
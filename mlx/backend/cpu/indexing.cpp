@@ -9,6 +9,7 @@
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
 
 namespace mlx::core {
 
@@ -115,32 +116,44 @@ void gather(
     src_it = ContiguousIterator(slice_sizes, src.strides(), src.ndim());
   }
 
-  size_t out_idx = 0;
-  for (int idx = 0; idx < ind_size; idx++) {
-    size_t src_idx = 0;
-    for (int ii = 0; ii < inds.size(); ++ii) {
-      auto ax = axes[ii];
-      auto idx_loc = its[ii].loc;
-      its[ii].step();
-      auto idx_val =
-          offset_neg_idx(inds[ii].data<IdxT>()[idx_loc], src.shape(ax));
-      src_idx += (idx_val * src.strides()[ax]);
+  // The indices are split between the threads, each with its own iterators
+  // moved to its first index.
+  size_t grain = cpu::min_parallel_size / std::max<size_t>(slice_size, 1);
+  cpu::parallel_for(ind_size, grain, [&](size_t begin, size_t end) {
+    auto chunk_its = its;
+    for (auto& it : chunk_its) {
+      it.seek(begin);
     }
+    auto chunk_src_it = src_it;
+    size_t out_idx = begin * slice_size;
+    for (size_t idx = begin; idx < end; idx++) {
+      size_t src_idx = 0;
+      for (int ii = 0; ii < inds.size(); ++ii) {
+        auto ax = axes[ii];
+        auto idx_loc = chunk_its[ii].loc;
+        chunk_its[ii].step();
+        auto idx_val =
+            offset_neg_idx(inds[ii].data<IdxT>()[idx_loc], src.shape(ax));
+        src_idx += (idx_val * src.strides()[ax]);
+      }
 
-    if (slice_size == 1) {
-      dst_ptr[out_idx++] = src_ptr[src_idx];
-    } else if (can_copy) {
-      std::copy(
-          src_ptr + src_idx, src_ptr + src_idx + slice_size, dst_ptr + out_idx);
-      out_idx += slice_size;
-    } else {
-      for (int jj = 0; jj < slice_size; jj++) {
-        dst_ptr[out_idx++] = src_ptr[src_idx + src_it.loc];
-        src_it.step();
+      if (slice_size == 1) {
+        dst_ptr[out_idx++] = src_ptr[src_idx];
+      } else if (can_copy) {
+        std::copy(
+            src_ptr + src_idx,
+            src_ptr + src_idx + slice_size,
+            dst_ptr + out_idx);
+        out_idx += slice_size;
+      } else {
+        for (int jj = 0; jj < slice_size; jj++) {
+          dst_ptr[out_idx++] = src_ptr[src_idx + chunk_src_it.loc];
+          chunk_src_it.step();
+        }
+        chunk_src_it.reset();
       }
-      src_it.reset();
     }
-  }
+  });
 }
 
 template <typename IdxT>
@@ -281,20 +294,29 @@ void gather_axis(
     size_post *= ind.shape(i);
   }
 
+  // The rows along the axis are split between the threads.
   size_t stride_pre = size_post * ind_ax_size;
-  for (size_t i = 0; i < size_pre; i++) {
-    for (size_t k = 0; k < size_post; k++) {
+  size_t grain =
+      cpu::min_parallel_size / std::max<size_t>(ind_ax_size, 1);
+  cpu::parallel_for(size_pre * size_post, grain, [&](size_t r, size_t end) {
+    auto chunk_ind_it = ind_it;
+    auto chunk_src_it = src_it;
+    chunk_ind_it.seek(r);
+    chunk_src_it.seek(r);
+    for (; r < end; r++) {
+      size_t i = r / size_post;
+      size_t k = r % size_post;
+      T* dst = dst_ptr + i * stride_pre + k;
       for (int j = 0; j < ind_ax_size; ++j) {
         auto ind_val = offset_neg_idx(
-            ind_ptr[ind_it.loc + j * ind_ax_stride], src_ax_size);
-        dst_ptr[k + j * dst_ax_stride] =
-            src_ptr[src_it.loc + ind_val * src_ax_stride];
+            ind_ptr[chunk_ind_it.loc + j * ind_ax_stride], src_ax_size);
+        dst[j * dst_ax_stride] =
+            src_ptr[chunk_src_it.loc + ind_val * src_ax_stride];
       }
-      ind_it.step();
-      src_it.step();
+      chunk_ind_it.step();
+      chunk_src_it.step();
     }
-    dst_ptr += stride_pre;
-  }
+  });
 }
 
 template <typename IdxT>
@@ -416,27 +438,67 @@ void scatter(
   ContiguousIterator update_it(updates);
   ContiguousIterator out_it(update_shape, out.strides(), out.ndim());
 
+  // The offsets of the last element of a slice from its first.
+  int64_t slice_extent = 0;
+  for (int i = 0; i < update_shape.size(); ++i) {
+    slice_extent += (update_shape[i] - 1) * out.strides()[i];
+  }
+  bool contiguous_slices = slice_extent + 1 == update_size &&
+      updates.flags().row_contiguous;
+
+  // The rows of the output are split between the threads, each applies the
+  // updates, in order, to the elements of its own rows so that the updates
+  // of the same element are neither racing nor reordered.
   auto out_ptr = out.data<InT>();
   auto upd_ptr = updates.data<InT>();
-  for (int i = 0; i < n_updates; ++i) {
-    size_t out_offset = 0;
-    for (int j = 0; j < inds.size(); ++j) {
-      auto ax = axes[j];
-      auto idx_loc = its[j].loc;
-      its[j].step();
-      auto idx_val =
-          offset_neg_idx(inds[j].data<IdxT>()[idx_loc], out.shape(ax));
-      out_offset += (idx_val * out.strides()[ax]);
-    }
-    update_it.seek(i * update_size);
-    for (int j = 0; j < update_size; ++j) {
-      OpT{}(upd_ptr[update_it.loc], out_ptr + out_offset + out_it.loc);
-      update_it.step();
-      out_it.step();
-    }
-    out_it.reset();
-    update_it.reset();
+  size_t num_rows = out.ndim() > 0 ? out.shape(0) : 1;
+  size_t row_stride = out.ndim() > 0 ? out.strides()[0] : 1;
+  size_t grain = num_rows;
+  if (n_updates * update_size >= cpu::min_parallel_size) {
+    int num_threads = cpu::thread_pool().size() + 1;
+    grain = (num_rows + num_threads - 1) / num_threads;
   }
+  cpu::parallel_for(num_rows, grain, [&](size_t row, size_t row_end) {
+    int64_t lo = row * row_stride;
+    int64_t hi = row_end * row_stride;
+    auto chunk_its = its;
+    auto chunk_update_it = update_it;
+    auto chunk_out_it = out_it;
+    for (size_t i = 0; i < n_updates; ++i) {
+      int64_t out_offset = 0;
+      for (int j = 0; j < inds.size(); ++j) {
+        auto ax = axes[j];
+        auto idx_loc = chunk_its[j].loc;
+        chunk_its[j].step();
+        auto idx_val =
+            offset_neg_idx(inds[j].data<IdxT>()[idx_loc], out.shape(ax));
+        out_offset += (idx_val * out.strides()[ax]);
+      }
+      if (out_offset + slice_extent < lo || out_offset >= hi) {
+        continue;
+      }
+      if (contiguous_slices) {
+        int64_t first = std::max(out_offset, lo);
+        int64_t last = std::min<int64_t>(out_offset + update_size, hi);
+        const InT* upd = upd_ptr + i * update_size;
+        for (int64_t o = first; o < last; ++o) {
+          OpT{}(upd[o - out_offset], out_ptr + o);
+        }
+        continue;
+      }
+      chunk_update_it.seek(i * update_size);
+      for (int j = 0; j < update_size; ++j) {
+        int64_t o = out_offset + chunk_out_it.loc;
+        if (o >= lo && o < hi) {
+          OpT{}(upd_ptr[chunk_update_it.loc], out_ptr + o);
+        }
+        chunk_update_it.step();
+        chunk_out_it.step();
+      }
+      chunk_out_it.reset();
+      chunk_update_it.reset();
+    }
+  });
 }
 
 template <typename InT, typename IdxT>
@@ -604,21 +666,31 @@ void scatter_axis(array& out, const array idx, const array& upd, int axis) {
   for (int i = axis + 1; i < idx.ndim(); ++i) {
     size_post *= idx.shape(i);
   }
+  // The rows along the axis are split between the threads, the updates of
+  // a row only touch the elements of the row.
   size_t stride_pre = size_post * dst_ax_size;
-  for (size_t i = 0; i < size_pre; i++) {
-    for (size_t k = 0; k < size_post; k++) {
+  size_t grain =
+      cpu::min_parallel_size / std::max<size_t>(idx_ax_size, 1);
+  cpu::parallel_for(size_pre * size_post, grain, [&](size_t r, size_t end) {
+    auto chunk_idx_it = idx_it;
+    auto chunk_upd_it = upd_it;
+    chunk_idx_it.seek(r);
+    chunk_upd_it.seek(r);
+    for (; r < end; r++) {
+      size_t i = r / size_post;
+      size_t k = r % size_post;
+      T* dst = dst_ptr + i * stride_pre + k;
       for (int j = 0; j < idx_ax_size; ++j) {
         auto ind_val = offset_neg_idx(
-            idx_ptr[idx_it.loc + j * idx_ax_stride], dst_ax_size);
+            idx_ptr[chunk_idx_it.loc + j * idx_ax_stride], dst_ax_size);
         OpT{}(
-            upd_ptr[upd_it.loc + j * upd_ax_stride],
-            dst_ptr + k + ind_val * dst_ax_stride);
+            upd_ptr[chunk_upd_it.loc + j * upd_ax_stride],
+            dst + ind_val * dst_ax_stride);
       }
-      idx_it.step();
-      upd_it.step();
+      chunk_idx_it.step();
+      chunk_upd_it.step();
     }
-    dst_ptr += stride_pre;
-  }
+  });
 }
 
 template <typename InT, typename IdxT>
@@ -4,30 +4,100 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/lapack.h"
+#include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
-template <typename T>
-void general_inv(T* inv, int N) {
-  int info;
-  auto ipiv = array::Data{allocator::malloc(sizeof(int) * N)};
-  // Compute LU factorization.
-  getrf<T>(
-      /* m = */ &N,
-      /* n = */ &N,
-      /* a = */ inv,
-      /* lda = */ &N,
-      /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
-      /* info = */ &info);
+// The matrices of at most small_inv_max_size rows are inverted without
+// lapack, see small_inv.
+constexpr int small_inv_max_size = 4;
 
-  if (info != 0) {
-    std::stringstream ss;
-    ss << "[Inverse::eval_cpu] LU factorization failed with error code "
-       << info;
-    throw std::runtime_error(ss.str());
+// Invert the |num_matrices| N x N matrices at |inv| in place with an
+// unrolled Gauss-Jordan elimination with partial pivoting. The matrices are
+// inverted simd::max_size<T> at a time with one matrix per lane, so they
+// stay in registers.
+template <typename T, int N>
+void small_inv(T* inv, size_t num_matrices) {
+  constexpr int S = simd::max_size<T>;
+  using V = simd::Simd<T, S>;
+  for (size_t m = 0; m < num_matrices; m += S) {
+    int lanes = std::min<size_t>(S, num_matrices - m);
+    T* mats = inv + m * N * N;
+
+    // Transpose the matrices into the lanes, the missing lanes are
+    // identities.
+    T buf[N * N][S];
+    for (int e = 0; e < N * N; ++e) {
+      for (int l = 0; l < S; ++l) {
+        buf[e][l] = l < lanes ? mats[l * N * N + e] : T(e / N == e % N);
+      }
+    }
+    V a[N][N];
+    V b[N][N];
+    for (int r = 0; r < N; ++r) {
+      for (int c = 0; c < N; ++c) {
+        a[r][c] = simd::load<T, S>(buf[r * N + c]);
+        b[r][c] = V(T(r == c));
+      }
+    }
+
+    for (int k = 0; k < N; ++k) {
+      // Bring the largest pivot of each lane to row k.
+      for (int r = k + 1; r < N; ++r) {
+        auto swap = simd::abs(a[r][k]) > simd::abs(a[k][k]);
+        for (int c = 0; c < N; ++c) {
+          V t = a[k][c];
+          a[k][c] = simd::select(swap, a[r][c], t);
+          a[r][c] = simd::select(swap, t, a[r][c]);
+          t = b[k][c];
+          b[k][c] = simd::select(swap, b[r][c], t);
+          b[r][c] = simd::select(swap, t, b[r][c]);
+        }
+      }
+      if (simd::any(a[k][k] == V(0))) {
+        std::stringstream ss;
+        ss << "[Inverse::eval_cpu] LU factorization failed with error code "
+           << k + 1;
+        throw std::runtime_error(ss.str());
+      }
+      V p = V(1) / a[k][k];
+      for (int c = 0; c < N; ++c) {
+        a[k][c] = a[k][c] * p;
+        b[k][c] = b[k][c] * p;
+      }
+      for (int r = 0; r < N; ++r) {
+        if (r == k) {
+          continue;
+        }
+        V f = a[r][k];
+        for (int c = 0; c < N; ++c) {
+          a[r][c] = a[r][c] - f * a[k][c];
+          b[r][c] = b[r][c] - f * b[k][c];
+        }
+      }
+    }
+
+    for (int r = 0; r < N; ++r) {
+      for (int c = 0; c < N; ++c) {
+        simd::store(buf[r * N + c], b[r][c]);
+      }
+    }
+    for (int e = 0; e < N * N; ++e) {
+      for (int l = 0; l < lanes; ++l) {
+        mats[l * N * N + e] = buf[e][l];
+      }
+    }
   }
+}
 
+// Invert the |num_matrices| N x N matrices at |inv| in place, sharing the
+// pivots and the workspace.
+template <typename T>
+void general_inv(T* inv, int N, size_t num_matrices) {
+  int info;
+  auto ipiv = array::Data{allocator::malloc(sizeof(int) * N)};
   static const int lwork_query = -1;
   T workspace_size = 0;
 
@@ -51,20 +121,38 @@ void general_inv(T* inv, int N) {
   const int lwork = workspace_size;
   auto scratch = array::Data{allocator::malloc(sizeof(T) * lwork)};
 
-  // Compute inverse.
-  getri<T>(
-      /* m = */ &N,
-      /* a = */ inv,
-      /* lda = */ &N,
-      /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
-      /* work = */ static_cast<T*>(scratch.buffer.raw_ptr()),
-      /* lwork = */ &lwork,
-      /* info = */ &info);
+  for (size_t i = 0; i < num_matrices; i++, inv += N * N) {
+    // Compute LU factorization.
+    getrf<T>(
+        /* m = */ &N,
+        /* n = */ &N,
+        /* a = */ inv,
+        /* lda = */ &N,
+        /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
+        /* info = */ &info);
 
-  if (info != 0) {
-    std::stringstream ss;
-    ss << "[Inverse::eval_cpu] inversion failed with error code " << info;
-    throw std::runtime_error(ss.str());
+    if (info != 0) {
+      std::stringstream ss;
+      ss << "[Inverse::eval_cpu] LU factorization failed with error code "
+         << info;
+      throw std::runtime_error(ss.str());
+    }
+
+    // Compute inverse.
+    getri<T>(
+        /* m = */ &N,
+        /* a = */ inv,
+        /* lda = */ &N,
+        /* ipiv = */ static_cast<int*>(ipiv.buffer.raw_ptr()),
+        /* work = */ static_cast<T*>(scratch.buffer.raw_ptr()),
+        /* lwork = */ &lwork,
+        /* info = */ &info);
+
+    if (info != 0) {
+      std::stringstream ss;
+      ss << "[Inverse::eval_cpu] inversion failed with error code " << info;
+      throw std::runtime_error(ss.str());
+    }
   }
 }
 
@@ -127,18 +215,46 @@ void inverse_impl(
   auto& encoder = cpu::get_command_encoder(stream);
   encoder.set_output_array(inv);
 
+  // The matrices are split between the threads in chunks of about
+  // min_parallel_size flops.
   auto inv_ptr = inv.data<T>();
+  size_t grain =
+      std::max<size_t>(cpu::min_parallel_size / (size_t(N) * N * N), 1);
   if (tri) {
-    encoder.dispatch([inv_ptr, N, num_matrices, upper]() {
-      for (int i = 0; i < num_matrices; i++) {
-        tri_inv<T>(inv_ptr + N * N * i, N, upper);
-      }
+    encoder.dispatch([inv_ptr, N, num_matrices, upper, grain]() {
+      cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+        for (; i < end; i++) {
+          tri_inv<T>(inv_ptr + size_t(N) * N * i, N, upper);
+        }
+      });
+    });
+  } else if (N <= small_inv_max_size) {
+    constexpr int S = simd::max_size<T>;
+    grain = (grain + S - 1) / S * S;
+    encoder.dispatch([inv_ptr, N, num_matrices, grain]() {
+      cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+        T* mats = inv_ptr + size_t(N) * N * i;
+        switch (N) {
+          case 1:
+            small_inv<T, 1>(mats, end - i);
+            break;
+          case 2:
+            small_inv<T, 2>(mats, end - i);
+            break;
+          case 3:
+            small_inv<T, 3>(mats, end - i);
+            break;
+          default:
+            small_inv<T, 4>(mats, end - i);
+            break;
+        }
+      });
     });
   } else {
-    encoder.dispatch([inv_ptr, N, num_matrices]() {
-      for (int i = 0; i < num_matrices; i++) {
-        general_inv<T>(inv_ptr + N * N * i, N);
-      }
+    encoder.dispatch([inv_ptr, N, num_matrices, grain]() {
+      cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+        general_inv<T>(inv_ptr + size_t(N) * N * i, N, end - i);
+      });
     });
   }
 }
@@ -2,11 +2,18 @@
 
 #include "mlx/backend/cpu/jit_compiler.h"
 
+#include <algorithm>
 #include <sstream>
 #include <vector>
 
+#if defined(__linux__) && defined(__aarch64__)
+#include <sys/auxv.h>
+#endif
+
 #include <fmt/format.h>
 
+#include "mlx/version.h"
+
 namespace mlx::core {
 
 #ifdef _MSC_VER
@@ -73,6 +80,91 @@ const VisualStudioInfo& GetVisualStudioInfo() {
 
 #endif // _MSC_VER
 
+namespace {
+
+// The flags tuning the kernels for the CPU of the host.
+const char* arch_flags() {
+#if defined(_MSC_VER)
+  return "";
+#elif defined(__x86_64__)
+  return "-march=native";
+#elif defined(__aarch64__)
+  return "-mcpu=native";
+#else
+  return "";
+#endif
+}
+
+// A name for the ISA the kernels are built for, the libraries built with
+// the flags above only running on CPUs with the same features.
+std::string host_isa() {
+#if defined(__x86_64__) && !defined(_MSC_VER)
+  __builtin_cpu_init();
+  int features[] = {
+      __builtin_cpu_supports("sse4.2"),
+      __builtin_cpu_supports("avx"),
+      __builtin_cpu_supports("f16c"),
+      __builtin_cpu_supports("fma"),
+      __builtin_cpu_supports("avx2"),
+      __builtin_cpu_supports("avx512f"),
+      __builtin_cpu_supports("avx512bw"),
+      __builtin_cpu_supports("avx512vl"),
+      __builtin_cpu_supports("avx512vnni"),
+      __builtin_cpu_supports("avx512bf16"),
+      __builtin_cpu_supports("avx512fp16"),
+  };
+  uint32_t mask = 0;
+  for (size_t i = 0; i < std::size(features); ++i) {
+    mask |= features[i] ? (1u << i) : 0u;
+  }
+  return fmt::format("x86_64_{:x}", mask);
+#elif defined(__linux__) && defined(__aarch64__)
+  return fmt::format(
+      "arm64_{:x}_{:x}", getauxval(AT_HWCAP), getauxval(AT_HWCAP2));
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  return "arm64";
+#else
+  return "generic";
+#endif
+}
+
+// The version of the compiler, the libraries of one not being reused with
+// another.
+std::string compiler_version() {
+#ifdef _MSC_VER
+  auto path = GetVisualStudioInfo().cl_exe;
+  return fmt::format("msvc_{:x}", std::hash<std::string>{}(path));
+#else
+  try {
+    return "gcc_" + JitCompiler::exec("g++ -dumpfullversion -dumpversion");
+  } catch (const std::exception&) {
+    return "gcc";
+  }
+#endif
+}
+
+} // namespace
+
+const std::filesystem::path& JitCompiler::cache_dir() {
+  static std::filesystem::path cache = []() -> std::filesystem::path {
+    std::filesystem::path cache;
+    if (auto c = std::getenv("MLX_CPU_JIT_CACHE_DIR"); c) {
+      cache = c;
+    } else {
+      cache =
+          std::filesystem::temp_directory_path() / "mlx" / version() / "cpu";
+    }
+    cache /= fmt::format("{}_{}", host_isa(), compiler_version());
+    std::error_code error;
+    std::filesystem::create_directories(cache, error);
+    if (error) {
+      return std::filesystem::path();
+    }
+    return cache;
+  }();
+  return cache;
+}
+
 std::string JitCompiler::build_command(
     const std::filesystem::path& dir,
     const std::string& source_file_name,
@@ -96,7 +188,9 @@ std::string JitCompiler::build_command(
       libpaths);
 #else
   return fmt::format(
-      "g++ -std=c++17 -O3 -Wall -fPIC -shared \"{0}\" -o \"{1}\" 2>&1",
+      "g++ -std=c++17 -O3 -fopenmp-simd {0} -Wall -fPIC -shared \"{1}\" "
+      "-o \"{2}\" 2>&1",
+      arch_flags(),
       (dir / source_file_name).string(),
       (dir / shared_lib_name).string());
 #endif
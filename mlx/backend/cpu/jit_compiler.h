@@ -15,6 +15,12 @@ class JitCompiler {
 
   // Run a command and get its output.
   static std::string exec(const std::string& cmd);
+
+  // The directory keeping the shared libraries across processes, named by
+  // the version of MLX, the compiler and the ISA of the host as the
+  // libraries are built for it. Set MLX_CPU_JIT_CACHE_DIR to move it. It is
+  // empty when the directory can not be created.
+  static const std::filesystem::path& cache_dir();
 };
 
 } // namespace mlx::core
@@ -6,6 +6,7 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/types/limits.h"
 
@@ -15,6 +16,48 @@ namespace {
 
 using namespace mlx::core::simd;
 
+// The logsumexp of the M contiguous values of |in|.
+template <typename T, typename AccT>
+AccT row_logsumexp(const T* in, int M) {
+  constexpr int N = std::min(max_size<AccT>, max_size<T>);
+
+  // Find the maximum
+  const T* current_in_ptr = in;
+  Simd<AccT, N> vmaximum(-numeric_limits<AccT>::infinity());
+  size_t s = M;
+  while (s >= N) {
+    Simd<AccT, N> vals = load<T, N>(current_in_ptr);
+    vmaximum = maximum(vals, vmaximum);
+    current_in_ptr += N;
+    s -= N;
+  }
+
+  AccT maximum = max(vmaximum);
+  while (s-- > 0) {
+    maximum = std::max(maximum, static_cast<AccT>(*current_in_ptr));
+    current_in_ptr++;
+  }
+
+  // Compute the normalizer and the exponentials
+  Simd<AccT, N> vnormalizer(0.0);
+  current_in_ptr = in;
+  s = M;
+  while (s >= N) {
+    Simd<AccT, N> vexp = load<T, N>(current_in_ptr);
+    vexp = exp(vexp - maximum);
+    vnormalizer = vnormalizer + vexp;
+    current_in_ptr += N;
+    s -= N;
+  }
+  AccT normalizer = sum(vnormalizer);
+  while (s-- > 0) {
+    AccT _exp = std::exp(*current_in_ptr - maximum);
+    normalizer += _exp;
+    current_in_ptr++;
+  }
+  return std::isinf(maximum) ? maximum : std::log(normalizer) + maximum;
+}
+
 template <typename T, typename AccT>
 void logsumexp(const array& in, array& out, Stream stream) {
   auto& encoder = cpu::get_command_encoder(stream);
@@ -28,53 +71,93 @@ void logsumexp(const array& in, array& out, Stream stream) {
   int L = in.data_size() / M;
 
   encoder.dispatch([in_ptr, out_ptr, M, L]() mutable {
-    constexpr int N = std::min(max_size<AccT>, max_size<T>);
+    for (int i = 0; i < L; i++, in_ptr += M, out_ptr += 1) {
+      *out_ptr = static_cast<T>(row_logsumexp<T, AccT>(in_ptr, M));
+    }
+  });
+}
 
-    const T* current_in_ptr;
+// The loss is logsumexp(x) - x[target] for each row of x, the logsumexp is
+// also kept for the vjp. The negative targets count from the end of the row
+// as in take_along_axis, the targets outside of the row give no score.
+template <typename T, typename AccT>
+void cross_entropy(
+    const array& logits,
+    const array& targets,
+    array& loss,
+    array& lse,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(logits);
+  encoder.set_input_array(targets);
+  encoder.set_output_array(loss);
+  encoder.set_output_array(lse);
 
-    for (int i = 0; i < L; i++, in_ptr += M, out_ptr += 1) {
-      // Find the maximum
-      current_in_ptr = in_ptr;
-      Simd<AccT, N> vmaximum(-numeric_limits<AccT>::infinity());
-      size_t s = M;
-      while (s >= N) {
-        Simd<AccT, N> vals = load<T, N>(current_in_ptr);
-        vmaximum = maximum(vals, vmaximum);
-        current_in_ptr += N;
-        s -= N;
-      }
-
-      AccT maximum = max(vmaximum);
-      while (s-- > 0) {
-        maximum = std::max(maximum, static_cast<AccT>(*current_in_ptr));
-        current_in_ptr++;
-      }
-
-      // Compute the normalizer and the exponentials
-      Simd<AccT, N> vnormalizer(0.0);
-      current_in_ptr = in_ptr;
-      s = M;
-      while (s >= N) {
-        Simd<AccT, N> vexp = load<T, N>(current_in_ptr);
-        vexp = exp(vexp - maximum);
-        vnormalizer = vnormalizer + vexp;
-        current_in_ptr += N;
-        s -= N;
-      }
-      AccT normalizer = sum(vnormalizer);
-      while (s-- > 0) {
-        AccT _exp = std::exp(*current_in_ptr - maximum);
-        normalizer += _exp;
-        current_in_ptr++;
-      }
-      // Normalize
-      *out_ptr = std::isinf(maximum)
-          ? static_cast<T>(maximum)
-          : static_cast<T>(std::log(normalizer) + maximum);
+  const T* in_ptr = logits.data<T>();
+  const int32_t* targets_ptr = targets.data<int32_t>();
+  T* loss_ptr = loss.data<T>();
+  AccT* lse_ptr = lse.data<AccT>();
+
+  int M = logits.shape().back();
+  int64_t L = M == 0 ? 0 : logits.size() / M;
+
+  encoder.dispatch([in_ptr, targets_ptr, loss_ptr, lse_ptr, M, L]() {
+    for (int64_t i = 0; i < L; i++) {
+      const T* row = in_ptr + i * M;
+      AccT l = row_logsumexp<T, AccT>(row, M);
+      int32_t t = targets_ptr[i];
+      t += t < 0 ? M : 0;
+      AccT score = (t >= 0 && t < M) ? static_cast<AccT>(row[t]) : AccT(0);
+      loss_ptr[i] = static_cast<T>(l - score);
+      lse_ptr[i] = l;
     }
   });
 }
 
+// The gradient of the logits, (softmax(x) - onehot(target)) * g.
+template <typename T, typename AccT>
+void cross_entropy_vjp(
+    const array& logits,
+    const array& targets,
+    const array& lse,
+    const array& g,
+    array& grad,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(logits);
+  encoder.set_input_array(targets);
+  encoder.set_input_array(lse);
+  encoder.set_input_array(g);
+  encoder.set_output_array(grad);
+
+  const T* in_ptr = logits.data<T>();
+  const int32_t* targets_ptr = targets.data<int32_t>();
+  const AccT* lse_ptr = lse.data<AccT>();
+  const T* g_ptr = g.data<T>();
+  T* grad_ptr = grad.data<T>();
+
+  int M = logits.shape().back();
+  int64_t L = M == 0 ? 0 : logits.size() / M;
+
+  encoder.dispatch(
+      [in_ptr, targets_ptr, lse_ptr, g_ptr, grad_ptr, M, L]() mutable {
+        for (int64_t i = 0; i < L; i++, in_ptr += M, grad_ptr += M) {
+          AccT l = lse_ptr[i];
+          AccT gi = static_cast<AccT>(g_ptr[i]);
+          for (int j = 0; j < M; j++) {
+            AccT p = std::exp(static_cast<AccT>(in_ptr[j]) - l);
+            grad_ptr[j] = static_cast<T>(p * gi);
+          }
+          int32_t t = targets_ptr[i];
+          t += t < 0 ? M : 0;
+          if (t >= 0 && t < M) {
+            AccT p = std::exp(static_cast<AccT>(in_ptr[t]) - l);
+            grad_ptr[t] = static_cast<T>((p - 1) * gi);
+          }
+        }
+      });
+}
+
 } // namespace
 
 void LogSumExp::eval_cpu(const std::vector<array>& inputs, array& out) {
@@ -137,4 +220,87 @@ void LogSumExp::eval_cpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+namespace fast {
+
+namespace {
+
+array ensure_row_contiguous(
+    const array& x,
+    cpu::CommandEncoder& encoder,
+    Stream s) {
+  if (x.flags().row_contiguous) {
+    return x;
+  }
+  array x_copy(x.shape(), x.dtype(), nullptr, {});
+  copy_cpu(x, x_copy, CopyType::General, s);
+  encoder.add_temporary(x_copy);
+  return x_copy;
+}
+
+} // namespace
+
+void CrossEntropy::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto logits = ensure_row_contiguous(inputs[0], encoder, s);
+  auto targets = ensure_row_contiguous(inputs[1], encoder, s);
+  auto& loss = outputs[0];
+  auto& lse = outputs[1];
+  loss.set_data(allocator::malloc(loss.nbytes()));
+  lse.set_data(allocator::malloc(lse.nbytes()));
+
+  switch (logits.dtype()) {
+    case float32:
+      cross_entropy<float, float>(logits, targets, loss, lse, s);
+      break;
+    case float16:
+      cross_entropy<float16_t, float>(logits, targets, loss, lse, s);
+      break;
+    case bfloat16:
+      cross_entropy<bfloat16_t, float>(logits, targets, loss, lse, s);
+      break;
+    case float64:
+      cross_entropy<double, double>(logits, targets, loss, lse, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[cross_entropy] only supports floating point types");
+  }
+}
+
+void CrossEntropyVJP::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto logits = ensure_row_contiguous(inputs[0], encoder, s);
+  auto targets = ensure_row_contiguous(inputs[1], encoder, s);
+  auto lse = ensure_row_contiguous(inputs[2], encoder, s);
+  auto g = ensure_row_contiguous(inputs[3], encoder, s);
+  auto& grad = outputs[0];
+  grad.set_data(allocator::malloc(grad.nbytes()));
+
+  switch (logits.dtype()) {
+    case float32:
+      cross_entropy_vjp<float, float>(logits, targets, lse, g, grad, s);
+      break;
+    case float16:
+      cross_entropy_vjp<float16_t, float>(logits, targets, lse, g, grad, s);
+      break;
+    case bfloat16:
+      cross_entropy_vjp<bfloat16_t, float>(logits, targets, lse, g, grad, s);
+      break;
+    case float64:
+      cross_entropy_vjp<double, double>(logits, targets, lse, g, grad, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[cross_entropy] only supports floating point types");
+  }
+}
+
+} // namespace fast
+
 } // namespace mlx::core
@@ -6,6 +6,7 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/lapack.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -55,48 +56,49 @@ void luf_impl(
   encoder.set_output_array(row_indices);
 
   encoder.dispatch(
-      [a_ptr, pivots_ptr, row_indices_ptr, num_matrices, M, N, K]() mutable {
-        int info;
-        for (size_t i = 0; i < num_matrices; ++i) {
-          // Compute LU factorization of A
-          getrf<T>(
-              /* m */ &M,
-              /* n */ &N,
-              /* a */ a_ptr,
-              /* lda */ &M,
-              /* ipiv */ reinterpret_cast<int*>(pivots_ptr),
-              /* info */ &info);
+      [a_ptr, pivots_ptr, row_indices_ptr, num_matrices, M, N, K]() {
+        size_t flops = std::max<size_t>(size_t(M) * N * K, 1);
+        size_t grain = std::max<size_t>(cpu::min_parallel_size / flops, 1);
+        cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+          int m = M;
+          int n = N;
+          int info;
+          for (; i < end; ++i) {
+            T* a = a_ptr + size_t(M) * N * i;
+            uint32_t* piv = pivots_ptr + size_t(K) * i;
+            uint32_t* rows = row_indices_ptr + size_t(M) * i;
 
-          if (info != 0) {
-            std::stringstream ss;
-            ss << "[LUF::eval_cpu] sgetrf_ failed with code " << info
-               << ((info > 0) ? " because matrix is singular"
-                              : " because argument had an illegal value");
-            throw std::runtime_error(ss.str());
-          }
+            // Compute LU factorization of A
+            getrf<T>(
+                /* m */ &m,
+                /* n */ &n,
+                /* a */ a,
+                /* lda */ &m,
+                /* ipiv */ reinterpret_cast<int*>(piv),
+                /* info */ &info);
 
-          // Subtract 1 to get 0-based index
-          int j = 0;
-          for (; j < K; ++j) {
-            pivots_ptr[j]--;
-            row_indices_ptr[j] = j;
-          }
-          for (; j < M; ++j) {
-            row_indices_ptr[j] = j;
-          }
-          for (int j = K - 1; j >= 0; --j) {
-            auto piv = pivots_ptr[j];
-            auto t1 = row_indices_ptr[piv];
-            auto t2 = row_indices_ptr[j];
-            row_indices_ptr[j] = t1;
-            row_indices_ptr[piv] = t2;
-          }
+            if (info != 0) {
+              std::stringstream ss;
+              ss << "[LUF::eval_cpu] sgetrf_ failed with code " << info
+                 << ((info > 0) ? " because matrix is singular"
+                                : " because argument had an illegal value");
+              throw std::runtime_error(ss.str());
+            }
 
-          // Advance pointers to the next matrix
-          a_ptr += M * N;
-          pivots_ptr += K;
-          row_indices_ptr += M;
-        }
+            // Subtract 1 to get 0-based index
+            int j = 0;
+            for (; j < K; ++j) {
+              piv[j]--;
+              rows[j] = j;
+            }
+            for (; j < M; ++j) {
+              rows[j] = j;
+            }
+            for (int j = K - 1; j >= 0; --j) {
+              std::swap(rows[j], rows[piv[j]]);
+            }
+          }
+        });
       });
 }
 
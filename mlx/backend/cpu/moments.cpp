@@ -0,0 +1,102 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// The running count, mean and sum of squared deviations of Welford's
+// algorithm.
+template <typename AccT>
+struct Welford {
+  int64_t n{0};
+  AccT mean{0};
+  AccT m2{0};
+
+  void push(AccT x) {
+    n++;
+    AccT delta = x - mean;
+    mean += delta / n;
+    m2 += delta * (x - mean);
+  }
+};
+
+// The mean and variance over the middle axis of |x| with shape [B, R, C].
+template <typename T, typename AccT>
+void moments(
+    const array& x,
+    array& mean,
+    array& var,
+    int ddof,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(x);
+  encoder.set_output_array(mean);
+  encoder.set_output_array(var);
+
+  const T* x_ptr = x.data<T>();
+  T* mean_ptr = mean.data<T>();
+  T* var_ptr = var.data<T>();
+  int64_t B = x.shape(0);
+  int64_t R = x.shape(1);
+  int64_t C = x.shape(2);
+
+  encoder.dispatch([x_ptr, mean_ptr, var_ptr, B, R, C, ddof]() mutable {
+    std::vector<Welford<AccT>> states(C);
+    for (int64_t b = 0; b < B; b++) {
+      std::fill(states.begin(), states.end(), Welford<AccT>{});
+      for (int64_t r = 0; r < R; r++, x_ptr += C) {
+        for (int64_t c = 0; c < C; c++) {
+          states[c].push(static_cast<AccT>(x_ptr[c]));
+        }
+      }
+      for (int64_t c = 0; c < C; c++) {
+        AccT n = std::max<int64_t>(states[c].n - ddof, 0);
+        *mean_ptr++ = static_cast<T>(states[c].mean);
+        *var_ptr++ = static_cast<T>(states[c].m2 / n);
+      }
+    }
+  });
+}
+
+} // namespace
+
+void Moments::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto x = inputs[0];
+  if (!x.flags().row_contiguous) {
+    x = array(x.shape(), x.dtype(), nullptr, {});
+    copy_cpu(inputs[0], x, CopyType::General, s);
+    encoder.add_temporary(x);
+  }
+  auto& mean = outputs[0];
+  auto& var = outputs[1];
+  mean.set_data(allocator::malloc(mean.nbytes()));
+  var.set_data(allocator::malloc(var.nbytes()));
+
+  switch (x.dtype()) {
+    case float32:
+      moments<float, float>(x, mean, var, ddof_, s);
+      break;
+    case float16:
+      moments<float16_t, float>(x, mean, var, ddof_, s);
+      break;
+    case bfloat16:
+      moments<bfloat16_t, float>(x, mean, var, ddof_, s);
+      break;
+    case float64:
+      moments<double, double>(x, mean, var, ddof_, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[moments] only supports floating point types");
+  }
+}
+
+} // namespace mlx::core::fast
@@ -0,0 +1,233 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <cmath>
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/stochastic_round.h"
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/backend/cpu/threefry.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// The pointers of a parameter, its gradient and its states, the outputs may
+// alias the inputs when they are donated. The key is set when the parameter
+// is rounded stochastically.
+template <typename T>
+struct Tensor {
+  const T* param;
+  const T* grad;
+  const T* state[2];
+  T* out_param;
+  T* out_state[2];
+  const uint32_t* key{nullptr};
+  uint32_t size;
+};
+
+// The new value of the element i of the parameter, rounded with the bits
+// random::bits gives for its key so it matches the fallback.
+template <typename T, typename AccT>
+T round_param(const Tensor<T>& t, size_t i, AccT p) {
+  if constexpr (std::is_same_v<T, bfloat16_t>) {
+    if (t.key) {
+      return stochastic_round_bf16(
+          p, random::bits_at({t.key[0], t.key[1]}, i, t.size));
+    }
+  }
+  return static_cast<T>(p);
+}
+
+template <typename T, typename AccT>
+void update(
+    OptimizerStep::Kind kind,
+    const OptimizerStep::Params& hp,
+    const AccT* scalars,
+    int num_states,
+    const Tensor<T>& t,
+    size_t begin,
+    size_t end) {
+  AccT lr = scalars[0];
+  AccT b1 = hp.beta1;
+  AccT b2 = hp.beta2;
+  AccT decay = 1 - lr * static_cast<AccT>(hp.weight_decay);
+  switch (kind) {
+    case OptimizerStep::SGD:
+      for (size_t i = begin; i < end; i++) {
+        AccT p = t.param[i];
+        AccT g = static_cast<AccT>(t.grad[i]) + hp.weight_decay * p;
+        if (num_states > 0) {
+          AccT v = b1 * static_cast<AccT>(t.state[0][i]) +
+              (1 - static_cast<AccT>(hp.dampening)) * g;
+          t.out_state[0][i] = static_cast<T>(v);
+          g = hp.nesterov ? g + b1 * v : v;
+        }
+        t.out_param[i] = round_param(t, i, p - lr * g);
+      }
+      break;
+    case OptimizerStep::AdamW:
+      for (size_t i = begin; i < end; i++) {
+        AccT g = t.grad[i];
+        AccT m = b1 * static_cast<AccT>(t.state[0][i]) + (1 - b1) * g;
+        AccT v = b2 * static_cast<AccT>(t.state[1][i]) + (1 - b2) * g * g;
+        AccT p = decay * static_cast<AccT>(t.param[i]);
+        p -= scalars[1] * m / (std::sqrt(v) * scalars[2] + hp.eps);
+        t.out_state[0][i] = static_cast<T>(m);
+        t.out_state[1][i] = static_cast<T>(v);
+        t.out_param[i] = round_param(t, i, p);
+      }
+      break;
+    case OptimizerStep::Lion:
+      for (size_t i = begin; i < end; i++) {
+        AccT g = t.grad[i];
+        AccT m = t.state[0][i];
+        AccT c = b1 * m + (1 - b1) * g;
+        AccT sign = (c > 0) - (c < 0);
+        t.out_state[0][i] = static_cast<T>(b2 * m + (1 - b2) * g);
+        AccT p = t.param[i];
+        t.out_param[i] = round_param(t, i, decay * p - lr * sign);
+      }
+      break;
+  }
+}
+
+// Walk the flat range of the elements of all the tensors in parallel, the
+// offsets are the first element of each tensor in the range.
+template <typename T, typename AccT>
+void optimizer_step(
+    OptimizerStep::Kind kind,
+    const OptimizerStep::Params& hp,
+    const array& scalars,
+    const std::optional<array>& keys,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    int num_params,
+    Stream s) {
+  auto& encoder = cpu::get_command_encoder(s);
+  int num_states = outputs.size() / num_params - 1;
+  std::vector<Tensor<T>> tensors(num_params);
+  std::vector<size_t> offsets{0};
+  for (int i = 0; i < num_params; i++) {
+    auto& t = tensors[i];
+    t.param = inputs[i].data<T>();
+    t.grad = inputs[num_params + i].data<T>();
+    t.out_param = outputs[i].data<T>();
+    for (int j = 0; j < num_states; j++) {
+      t.state[j] = inputs[(j + 2) * num_params + i].data<T>();
+      t.out_state[j] = outputs[(j + 1) * num_params + i].data<T>();
+    }
+    t.size = outputs[i].size();
+    if (keys) {
+      t.key = keys->data<uint32_t>() + 2 * i;
+    }
+    offsets.push_back(offsets.back() + outputs[i].size());
+  }
+  for (auto& in : inputs) {
+    encoder.set_input_array(in);
+  }
+  encoder.set_input_array(scalars);
+  if (keys) {
+    encoder.set_input_array(*keys);
+  }
+  for (auto& out : outputs) {
+    encoder.set_output_array(out);
+  }
+
+  const float* scalars_ptr = scalars.data<float>();
+  int num_scalars = scalars.size();
+  encoder.dispatch([kind,
+                    hp,
+                    scalars_ptr,
+                    num_scalars,
+                    num_states,
+                    tensors = std::move(tensors),
+                    offsets = std::move(offsets)]() {
+    AccT values[3] = {0, 0, 1};
+    std::copy_n(scalars_ptr, std::min(num_scalars, 3), values);
+    cpu::parallel_for(
+        offsets.back(), cpu::min_parallel_size, [&](size_t i, size_t end) {
+          int t = std::upper_bound(offsets.begin(), offsets.end(), i) -
+              offsets.begin() - 1;
+          for (; i < end; t++) {
+            size_t last = std::min(end, offsets[t + 1]);
+            update<T, AccT>(
+                kind,
+                hp,
+                values,
+                num_states,
+                tensors[t],
+                i - offsets[t],
+                last - offsets[t]);
+            i = last;
+          }
+        });
+  });
+}
+
+} // namespace
+
+void OptimizerStep::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+
+  // The parameters and the states are updated in place when donated
+  auto contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy(x.shape(), x.dtype(), nullptr, {});
+    copy_cpu(x, x_copy, CopyType::General, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  int n = num_params_;
+  // The keys of the parameters come last when they are rounded
+  int num_tensors = inputs.size() - params_.stochastic_rounding;
+  std::vector<array> tensors;
+  for (int i = 1; i < num_tensors; i++) {
+    tensors.push_back(contiguous(inputs[i]));
+  }
+  for (int i = 0; i < outputs.size(); i++) {
+    auto& in = i < n ? inputs[1 + i] : inputs[1 + n + i];
+    auto& out = outputs[i];
+    if (in.flags().row_contiguous && in.is_donatable()) {
+      out.copy_shared_buffer(in);
+    } else {
+      out.set_data(allocator::malloc(out.nbytes()));
+    }
+  }
+  auto scalars = contiguous(inputs[0]);
+  std::optional<array> keys;
+  if (params_.stochastic_rounding) {
+    keys = contiguous(inputs.back());
+  }
+
+  switch (outputs[0].dtype()) {
+    case float32:
+      optimizer_step<float, float>(
+          kind_, params_, scalars, keys, tensors, outputs, n, s);
+      break;
+    case float16:
+      optimizer_step<float16_t, float>(
+          kind_, params_, scalars, keys, tensors, outputs, n, s);
+      break;
+    case bfloat16:
+      optimizer_step<bfloat16_t, float>(
+          kind_, params_, scalars, keys, tensors, outputs, n, s);
+      break;
+    case float64:
+      optimizer_step<double, double>(
+          kind_, params_, scalars, keys, tensors, outputs, n, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[optimizer_step] only supports floating point types");
+  }
+}
+
+} // namespace mlx::core::fast
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <limits>
 #include <numeric>
 #include <sstream>
 
@@ -12,8 +13,10 @@
 #include "mlx/backend/cpu/arange.h"
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/backend/cpu/threefry.h"
 #include "mlx/primitives.h"
+#include "mlx/scheduler.h"
 #include "mlx/utils.h"
 
 namespace mlx::core {
@@ -238,6 +241,102 @@ void Full::eval_cpu(const std::vector<array>& inputs, array& out) {
   copy_cpu(in, out, ctype, stream());
 }
 
+namespace {
+
+// Fill |out| with NaNs, or with zeros when its type has no NaN.
+void fill_nan(array& out) {
+  constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+  switch (out.dtype()) {
+    case float16:
+      std::fill_n(out.data<float16_t>(), out.size(), float16_t(nan));
+      break;
+    case bfloat16:
+      std::fill_n(out.data<bfloat16_t>(), out.size(), bfloat16_t(nan));
+      break;
+    case float32:
+      std::fill_n(out.data<float>(), out.size(), nan);
+      break;
+    case float64:
+      std::fill_n(out.data<double>(), out.size(), double(nan));
+      break;
+    case complex64:
+      std::fill_n(out.data<complex64_t>(), out.size(), complex64_t(nan, nan));
+      break;
+    default:
+      std::fill_n(out.data<char>(), out.nbytes(), 0);
+  }
+}
+
+} // namespace
+
+void HostCallback::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& encoder = cpu::get_command_encoder(stream());
+  std::vector<array> outs;
+  for (auto& in : inputs) {
+    encoder.set_input_array(in);
+  }
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    encoder.set_output_array(out);
+    outs.push_back(array::unsafe_weak_copy(out));
+  }
+  // The function may keep the inputs so it gets copies owning their data.
+  // An exception can not leave the thread of the stream, so the errors of
+  // the function are thrown by the next wait for an evaluation and its
+  // outputs are NaNs, or zeros for the types without NaN.
+  encoder.dispatch([fn = fn_, inputs, outs = std::move(outs)]() mutable {
+    std::vector<array> results;
+    try {
+      results = fn(inputs);
+      if (results.size() != outs.size()) {
+        std::ostringstream msg;
+        msg << "[host_callback] Expected " << outs.size()
+            << " arrays from the function but got " << results.size() << ".";
+        throw std::runtime_error(msg.str());
+      }
+      for (size_t i = 0; i < outs.size(); ++i) {
+        auto& r = results[i];
+        auto& out = outs[i];
+        if (r.status() == array::Status::unscheduled ||
+            r.shape() != out.shape() || r.dtype() != out.dtype()) {
+          std::ostringstream msg;
+          msg << "[host_callback] Expected the output " << i
+              << " to be a computed array of shape " << out.shape()
+              << " and type " << out.dtype() << ".";
+          throw std::runtime_error(msg.str());
+        }
+      }
+    } catch (...) {
+      scheduler::set_error(std::current_exception());
+      for (auto& out : outs) {
+        fill_nan(out);
+      }
+      return;
+    }
+    for (size_t i = 0; i < outs.size(); ++i) {
+      auto& r = results[i];
+      auto& out = outs[i];
+      auto src = r.data<char>();
+      auto dst = out.data<char>();
+      if (r.flags().row_contiguous) {
+        std::copy(src, src + out.nbytes(), dst);
+        continue;
+      }
+      size_t itemsize = out.itemsize();
+      ContiguousIterator it(r);
+      for (size_t j = 0; j < out.size(); ++j) {
+        std::copy(
+            src + it.loc * itemsize,
+            src + (it.loc + 1) * itemsize,
+            dst + j * itemsize);
+        it.step();
+      }
+    }
+  });
+}
+
 void Pad::eval_cpu(const std::vector<array>& inputs, array& out) {
   // Inputs must be base input array and scalar val array
   assert(inputs.size() == 2);
@@ -290,40 +389,77 @@ void RandomBits::eval_cpu(const std::vector<array>& inputs, array& out) {
                     bytes_per_key,
                     num_keys,
                     kshape = keys.shape(),
-                    kstrides = keys.strides()]() mutable {
+                    kstrides = keys.strides()]() {
     size_t out_skip = (bytes_per_key + 4 - 1) / 4;
-    auto half_size = out_skip / 2;
+    if (out_skip == 0) {
+      return;
+    }
+    size_t half_size = out_skip / 2;
     bool even = out_skip % 2 == 0;
-    for (int i = 0; i < num_keys; ++i, cptr += bytes_per_key) {
-      auto ptr = reinterpret_cast<uint32_t*>(cptr);
-      // Get ith key
-      auto kidx = 2 * i;
-      auto k1_elem = elem_to_loc(kidx, kshape, kstrides);
-      auto k2_elem = elem_to_loc(kidx + 1, kshape, kstrides);
+    // The pairs of words of a key are the halves of its output, the last
+    // pair may be cut short and written with the middle word of an odd
+    // output.
+    size_t num_pairs = std::max<size_t>(half_size, 1);
+
+    // Hash the pairs [j, end) of the key i.
+    auto hash_pairs = [&](size_t i, size_t j, size_t end) {
+      constexpr int S = simd::max_size<uint32_t>;
+      auto ptr = reinterpret_cast<uint32_t*>(cptr + i * bytes_per_key);
+      auto k1_elem = elem_to_loc(2 * i, kshape, kstrides);
+      auto k2_elem = elem_to_loc(2 * i + 1, kshape, kstrides);
       auto key = std::make_pair(kptr[k1_elem], kptr[k2_elem]);
+      size_t second = half_size + !even;
 
-      std::pair<uintptr_t, uintptr_t> count{0, half_size + !even};
-      for (; count.first + 1 < half_size; count.first++, count.second++) {
-        std::tie(ptr[count.first], ptr[count.second]) =
-            random::threefry2x32_hash(key, count);
+      size_t full_end = std::min(end, half_size > 0 ? half_size - 1 : 0);
+      uint32_t lanes[S];
+      for (int l = 0; l < S; ++l) {
+        lanes[l] = l;
       }
-      if (count.first < half_size) {
+      auto iota = simd::load<uint32_t, S>(lanes);
+      for (; j + S <= full_end; j += S) {
+        auto [x0, x1] = random::threefry2x32_hash<S>(
+            key, {iota + uint32_t(j), iota + uint32_t(j + second)});
+        simd::store(ptr + j, x0);
+        simd::store(ptr + j + second, x1);
+      }
+      for (; j < full_end; ++j) {
+        std::tie(ptr[j], ptr[j + second]) =
+            random::threefry2x32_hash(key, {j, j + second});
+      }
+
+      if (end < num_pairs) {
+        return;
+      }
+      if (half_size > 0) {
+        auto count = std::make_pair(half_size - 1, out_skip - 1);
         auto rb = random::threefry2x32_hash(key, count);
-        ptr[count.first++] = rb.first;
+        ptr[count.first] = rb.first;
         if (bytes_per_key % 4 > 0) {
           std::copy(
               reinterpret_cast<char*>(&rb.second),
               reinterpret_cast<char*>(&rb.second) + bytes_per_key % 4,
-              cptr + 4 * count.second);
+              reinterpret_cast<char*>(ptr + count.second));
         } else {
           ptr[count.second] = rb.second;
         }
       }
       if (!even) {
-        count.second = 0;
-        ptr[half_size] = random::threefry2x32_hash(key, count).first;
+        ptr[half_size] = random::threefry2x32_hash(key, {half_size, 0}).first;
       }
-    }
+    };
+
+    // The hash costs tens of operations per pair of words.
+    size_t grain = cpu::min_parallel_size / 16;
+    cpu::parallel_for(
+        num_keys * num_pairs, grain, [&](size_t begin, size_t end) {
+          while (begin < end) {
+            size_t i = begin / num_pairs;
+            size_t j = begin % num_pairs;
+            size_t n = std::min(num_pairs - j, end - begin);
+            hash_pairs(i, j, j + n);
+            begin += n;
+          }
+        });
   });
 }
 
@@ -1,14 +1,25 @@
 // Copyright © 2023 Apple Inc.
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
 
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
 
+#if defined(__x86_64__) && !defined(_MSC_VER)
+#include <immintrin.h>
+#define MLX_X86_QMM_DOT
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define MLX_NEON_QMM_DOT
+#endif
+
 namespace mlx::core {
 
 namespace {
@@ -191,8 +202,10 @@ simd::Simd<uint32_t, S> extract_bits_simd(const uint32_t* w) {
     wi = wi >> shifts;
     wi = wi & bitmask;
   } else {
-    // Appease compiler.. but should never get here
-    throw std::runtime_error("Unsupported combination for simd qmm.");
+    constexpr int pack_factor = 32 / bits;
+    for (int i = 0; i < S; i++) {
+      wi[i] = (w[i / pack_factor] >> ((i % pack_factor) * bits)) & bitmask;
+    }
   }
   return wi;
 }
@@ -244,6 +257,215 @@ void _qmm_t_simd(
   }
 }
 
+// The dot product of |n| unsigned weights and signed activations, |n| a
+// multiple of 32.
+using DotU8S8 = int32_t (*)(const uint8_t*, const int8_t*, int);
+
+int32_t dot_u8s8(const uint8_t* w, const int8_t* x, int n) {
+  int32_t acc = 0;
+  for (int i = 0; i < n; i++) {
+    acc += static_cast<int32_t>(w[i]) * static_cast<int32_t>(x[i]);
+  }
+  return acc;
+}
+
+#ifdef MLX_X86_QMM_DOT
+
+__attribute__((target("avx2"))) inline int32_t hsum_epi32(__m256i x) {
+  __m128i s = _mm_add_epi32(
+      _mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1));
+  s = _mm_hadd_epi32(s, s);
+  s = _mm_hadd_epi32(s, s);
+  return _mm_cvtsi128_si32(s);
+}
+
+// vpmaddubsw adds the pairs of products in int16 with saturation, which
+// only holds for the weights of up to 7 bits.
+__attribute__((target("avx2"))) int32_t
+dot_u8s8_avx2(const uint8_t* w, const int8_t* x, int n) {
+  __m256i ones = _mm256_set1_epi16(1);
+  __m256i acc = _mm256_setzero_si256();
+  for (int i = 0; i < n; i += 32) {
+    __m256i wv = _mm256_loadu_si256((const __m256i*)(w + i));
+    __m256i xv = _mm256_loadu_si256((const __m256i*)(x + i));
+    __m256i p = _mm256_maddubs_epi16(wv, xv);
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(p, ones));
+  }
+  return hsum_epi32(acc);
+}
+
+// The weights of 8 bits are widened to int16 instead.
+__attribute__((target("avx2"))) int32_t
+dot_u8s8_avx2_wide(const uint8_t* w, const int8_t* x, int n) {
+  __m256i acc = _mm256_setzero_si256();
+  for (int i = 0; i < n; i += 16) {
+    __m256i wv =
+        _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(w + i)));
+    __m256i xv =
+        _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i*)(x + i)));
+    acc = _mm256_add_epi32(acc, _mm256_madd_epi16(wv, xv));
+  }
+  return hsum_epi32(acc);
+}
+
+__attribute__((target("avx2,avx512vl,avx512vnni"))) int32_t
+dot_u8s8_vnni(const uint8_t* w, const int8_t* x, int n) {
+  __m256i acc = _mm256_setzero_si256();
+  for (int i = 0; i < n; i += 32) {
+    __m256i wv = _mm256_loadu_si256((const __m256i*)(w + i));
+    __m256i xv = _mm256_loadu_si256((const __m256i*)(x + i));
+    acc = _mm256_dpbusd_epi32(acc, wv, xv);
+  }
+  return hsum_epi32(acc);
+}
+
+#endif
+
+#ifdef MLX_NEON_QMM_DOT
+
+int32_t dot_u8s8_neon(const uint8_t* w, const int8_t* x, int n) {
+  int32x4_t acc = vdupq_n_s32(0);
+  for (int i = 0; i < n; i += 16) {
+    uint8x16_t wv = vld1q_u8(w + i);
+    int8x16_t xv = vld1q_s8(x + i);
+    int16x8_t wl = vreinterpretq_s16_u16(vmovl_u8(vget_low_u8(wv)));
+    int16x8_t wh = vreinterpretq_s16_u16(vmovl_u8(vget_high_u8(wv)));
+    int16x8_t xl = vmovl_s8(vget_low_s8(xv));
+    int16x8_t xh = vmovl_s8(vget_high_s8(xv));
+    acc = vmlal_s16(acc, vget_low_s16(wl), vget_low_s16(xl));
+    acc = vmlal_s16(acc, vget_high_s16(wl), vget_high_s16(xl));
+    acc = vmlal_s16(acc, vget_low_s16(wh), vget_low_s16(xh));
+    acc = vmlal_s16(acc, vget_high_s16(wh), vget_high_s16(xh));
+  }
+  return vaddvq_s32(acc);
+}
+
+#endif
+
+// The fastest dot product the CPU supports for weights of |bits|.
+DotU8S8 select_dot_u8s8(int bits) {
+#if defined(MLX_X86_QMM_DOT)
+  static bool has_vnni = __builtin_cpu_supports("avx512vnni") &&
+      __builtin_cpu_supports("avx512vl");
+  static bool has_avx2 = __builtin_cpu_supports("avx2");
+  if (has_vnni) {
+    return dot_u8s8_vnni;
+  }
+  if (has_avx2) {
+    return bits < 8 ? dot_u8s8_avx2 : dot_u8s8_avx2_wide;
+  }
+#elif defined(MLX_NEON_QMM_DOT)
+  return dot_u8s8_neon;
+#endif
+  return dot_u8s8;
+}
+
+// Quantize a row of |K| activations to int8 with a scale per group, and keep
+// the sum of each group for the biases of the weights.
+template <typename T>
+void quantize_row_int8(
+    const T* x,
+    int K,
+    int group_size,
+    int8_t* xq,
+    float* x_scales,
+    float* x_sums) {
+  for (int k = 0; k < K; k += group_size) {
+    float amax = 0;
+    float sum = 0;
+    for (int i = 0; i < group_size; i++) {
+      float xi = static_cast<float>(x[k + i]);
+      amax = std::max(amax, std::abs(xi));
+      sum += xi;
+    }
+    float scale = amax / 127.0f;
+    float inv_scale = amax > 0 ? 127.0f / amax : 0.0f;
+    for (int i = 0; i < group_size; i++) {
+      xq[k + i] = static_cast<int8_t>(
+          std::nearbyint(static_cast<float>(x[k + i]) * inv_scale));
+    }
+    *x_scales++ = scale;
+    *x_sums++ = sum;
+  }
+}
+
+// Unpack a row of |K| quantized weights to a byte each.
+template <int bits>
+void unpack_row_u8(const uint8_t* w, uint8_t* out, int K) {
+  constexpr int bitmask = (1 << bits) - 1;
+  constexpr int pack_factor = get_pack_factor(bits, 8);
+  constexpr int bytes_per_pack = get_bytes_per_pack(bits);
+  for (int k = 0; k < K; k += pack_factor, w += bytes_per_pack) {
+    if constexpr (bits == 3 || bits == 5 || bits == 6) {
+      extract_bits<uint8_t, bits>(w, out + k);
+    } else {
+      uint8_t wi = *w;
+      for (int p = 0; p < pack_factor; p++) {
+        out[k + p] = wi & bitmask;
+        if (bits != 8) {
+          wi >>= bits;
+        }
+      }
+    }
+  }
+}
+
+// The transposed quantized matmul with the activations quantized to int8,
+// which accumulates scale_w * scale_x * dot(w, x) + bias_w * sum(x) per
+// group. Each row of weights is unpacked once for all the rows of |x|.
+template <typename T, int bits, int group_size>
+void _qmm_t_int8(
+    T* result,
+    const T* x,
+    const uint32_t* w,
+    const T* scales,
+    const T* biases,
+    int M,
+    int N,
+    int K) {
+  int groups = K / group_size;
+  size_t w_row = static_cast<size_t>(K) * bits / 32;
+
+  std::vector<int8_t> xq(static_cast<size_t>(M) * K);
+  std::vector<float> x_scales(static_cast<size_t>(M) * groups);
+  std::vector<float> x_sums(static_cast<size_t>(M) * groups);
+  for (int m = 0; m < M; m++) {
+    quantize_row_int8(
+        x + m * K,
+        K,
+        group_size,
+        xq.data() + m * K,
+        x_scales.data() + m * groups,
+        x_sums.data() + m * groups);
+  }
+
+  auto dot = select_dot_u8s8(bits);
+  size_t grain = std::max<size_t>(cpu::min_parallel_size / (M * K), 1);
+  cpu::parallel_for(N, grain, [&](size_t n, size_t end) {
+    std::vector<uint8_t> wq(K);
+    for (; n < end; n++) {
+      unpack_row_u8<bits>(
+          reinterpret_cast<const uint8_t*>(w + n * w_row), wq.data(), K);
+      const T* scales_local = scales + n * groups;
+      const T* biases_local = biases + n * groups;
+      for (int m = 0; m < M; m++) {
+        const int8_t* xq_local = xq.data() + m * K;
+        const float* xs_local = x_scales.data() + m * groups;
+        const float* xsum_local = x_sums.data() + m * groups;
+        float acc = 0;
+        for (int g = 0; g < groups; g++) {
+          int32_t d =
+              dot(wq.data() + g * group_size, xq_local + g * group_size,
+                  group_size);
+          acc += static_cast<float>(scales_local[g]) * xs_local[g] * d +
+              static_cast<float>(biases_local[g]) * xsum_local[g];
+        }
+        result[m * N + n] = static_cast<T>(acc);
+      }
+    }
+  });
+}
+
 template <typename T, int bits, int group_size>
 void _qmm_dispatch_transpose(
     T* result,
@@ -256,14 +478,55 @@ void _qmm_dispatch_transpose(
     int K,
     bool transposed_w) {
   if (transposed_w) {
-    // the simd size must be a multiple of the number of elements per word
-    if constexpr (32 % bits == 0 && simd::max_size<T> % (32 / bits) == 0) {
-      _qmm_t_simd<T, bits, group_size>(result, x, w, scales, biases, M, N, K);
-    } else {
-      _qmm_t<T, bits, group_size>(result, x, w, scales, biases, M, N, K);
+    if (env::cpu_qmm_int8()) {
+      _qmm_t_int8<T, bits, group_size>(result, x, w, scales, biases, M, N, K);
+      return;
     }
+    // Split the outputs of each row of x over the thread pool, the rows of
+    // the weights being independent.
+    size_t w_row = static_cast<size_t>(K) * bits / 32;
+    size_t groups = K / group_size;
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / K, 1);
+    cpu::parallel_for(
+        static_cast<size_t>(M) * N, grain, [&](size_t i, size_t end) {
+          while (i < end) {
+            size_t m = i / N;
+            size_t n = i % N;
+            int n_size = std::min<size_t>(N - n, end - i);
+            // the simd size must be a multiple of the number of elements per
+            // word
+            if constexpr (
+                32 % bits == 0 && simd::max_size<T> % (32 / bits) == 0) {
+              _qmm_t_simd<T, bits, group_size>(
+                  result + m * N + n,
+                  x + m * K,
+                  w + n * w_row,
+                  scales + n * groups,
+                  biases + n * groups,
+                  1,
+                  n_size,
+                  K);
+            } else {
+              _qmm_t<T, bits, group_size>(
+                  result + m * N + n,
+                  x + m * K,
+                  w + n * w_row,
+                  scales + n * groups,
+                  biases + n * groups,
+                  1,
+                  n_size,
+                  K);
+            }
+            i += n_size;
+          }
+        });
   } else {
-    _qmm<T, bits, group_size>(result, x, w, scales, biases, M, N, K);
+    // Split the rows of x, each reading all the weights.
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / (N * K), 1);
+    cpu::parallel_for(M, grain, [&](size_t m, size_t end) {
+      _qmm<T, bits, group_size>(
+          result + m * N, x + m * K, w, scales, biases, end - m, N, K);
+    });
   }
 }
 
@@ -624,6 +887,73 @@ void GatherQMM::eval_cpu(const std::vector<array>& inputs, array& out) {
   });
 }
 
+// Dequantize the rows |indices| of |w| into |out|, one row at a time.
+template <typename T, int bits>
+void dequantize_rows(
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    array& out,
+    int group_size) {
+  constexpr int pack_factor = get_pack_factor(bits, 8);
+  constexpr int bytes_per_pack = get_bytes_per_pack(bits);
+  int dims = out.shape(-1);
+  int groups = dims / group_size;
+  int64_t row_bytes = dims / pack_factor * bytes_per_pack;
+  int32_t num_rows = w.shape(0);
+  auto w_ptr = w.data<uint8_t>();
+  auto scales_ptr = scales.data<T>();
+  auto biases_ptr = biases.data<T>();
+  auto idx_ptr = indices.data<int32_t>();
+  auto out_ptr = out.data<T>();
+
+  std::vector<uint8_t> q(dims);
+  for (size_t i = 0; i < indices.size(); ++i) {
+    int64_t r = idx_ptr[elem_to_loc(i, indices)];
+    r = r < 0 ? r + num_rows : r;
+    unpack_row_u8<bits>(w_ptr + r * row_bytes, q.data(), dims);
+    const T* scale = scales_ptr + r * groups;
+    const T* bias = biases_ptr + r * groups;
+    for (int k = 0; k < dims; ++k) {
+      int g = k / group_size;
+      out_ptr[k] = static_cast<T>(q[k]) * scale[g] + bias[g];
+    }
+    out_ptr += dims;
+  }
+}
+
+template <typename T>
+void dispatch_dequantize_rows(
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    array& out,
+    int group_size,
+    int bits) {
+  switch (bits) {
+    case 2:
+      dequantize_rows<T, 2>(w, scales, biases, indices, out, group_size);
+      break;
+    case 3:
+      dequantize_rows<T, 3>(w, scales, biases, indices, out, group_size);
+      break;
+    case 4:
+      dequantize_rows<T, 4>(w, scales, biases, indices, out, group_size);
+      break;
+    case 5:
+      dequantize_rows<T, 5>(w, scales, biases, indices, out, group_size);
+      break;
+    case 6:
+      dequantize_rows<T, 6>(w, scales, biases, indices, out, group_size);
+      break;
+    case 8:
+      dequantize_rows<T, 8>(w, scales, biases, indices, out, group_size);
+      break;
+  }
+}
+
 template <typename T, typename U>
 void quantize(
     const T* w,
@@ -771,4 +1101,57 @@ void fast::AffineQuantize::eval_cpu(
   });
 }
 
+void fast::QuantizedEmbedding::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& encoder = cpu::get_command_encoder(stream());
+  auto ensure_row_contiguous = [&](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    }
+    array arr_copy(arr.shape(), arr.dtype(), nullptr, {});
+    copy_cpu(arr, arr_copy, CopyType::General, stream());
+    encoder.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  auto w = ensure_row_contiguous(inputs[0]);
+  auto scales = ensure_row_contiguous(inputs[1]);
+  auto biases = ensure_row_contiguous(inputs[2]);
+  auto& indices = inputs[3];
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  encoder.set_input_array(w);
+  encoder.set_input_array(scales);
+  encoder.set_input_array(biases);
+  encoder.set_input_array(indices);
+  encoder.set_output_array(out);
+  encoder.dispatch([w = array::unsafe_weak_copy(w),
+                    scales = array::unsafe_weak_copy(scales),
+                    biases = array::unsafe_weak_copy(biases),
+                    indices = array::unsafe_weak_copy(indices),
+                    out = array::unsafe_weak_copy(out),
+                    group_size = group_size_,
+                    bits = bits_]() mutable {
+    switch (out.dtype()) {
+      case float32:
+        dispatch_dequantize_rows<float>(
+            w, scales, biases, indices, out, group_size, bits);
+        break;
+      case float16:
+        dispatch_dequantize_rows<float16_t>(
+            w, scales, biases, indices, out, group_size, bits);
+        break;
+      case bfloat16:
+        dispatch_dequantize_rows<bfloat16_t>(
+            w, scales, biases, indices, out, group_size, bits);
+        break;
+      default:
+        throw std::runtime_error(
+            "[fast::QuantizedEmbedding::eval_cpu] Only supports floating "
+            "point scales.");
+    }
+  });
+}
+
 } // namespace mlx::core
@@ -3,10 +3,12 @@
 #include <cassert>
 #include <functional>
 #include <limits>
+#include <memory>
 
 #include "mlx/backend/common/reduce.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -135,6 +137,13 @@ void nd_loop(
   loop_inner(0, 0);
 }
 
+// The number of the |n| parts of |size| inputs per chunk, so each chunk
+// reads about cpu::min_parallel_size inputs.
+size_t parallel_grain(size_t size, size_t n) {
+  size_t per_part = std::max<size_t>(size / std::max<size_t>(n, 1), 1);
+  return (cpu::min_parallel_size + per_part - 1) / per_part;
+}
+
 template <typename T, typename U, typename Op>
 void reduction_op(
     const array& x,
@@ -146,17 +155,49 @@ void reduction_op(
   auto in_ptr = x.data<T>();
   auto out_ptr = out.data<U>();
   if (plan.type == ContiguousAllReduce) {
-    *out_ptr = init;
-    contiguous_reduce(in_ptr, out_ptr, x.size(), Op{}, init);
+    // Each thread reduces a part of the input, the parts are then combined.
+    size_t size = x.size();
+    size_t num_parts = std::min<size_t>(
+        size / cpu::min_parallel_size, cpu::thread_pool().size() + 1);
+    if (num_parts <= 1) {
+      *out_ptr = init;
+      contiguous_reduce(in_ptr, out_ptr, size, Op{}, init);
+      return;
+    }
+    // Not a std::vector as the partials of bool are written by pointer.
+    auto partials = std::make_unique<U[]>(num_parts);
+    std::fill_n(partials.get(), num_parts, init);
+    cpu::parallel_for(num_parts, 1, [&](size_t p, size_t end) {
+      for (; p < end; p++) {
+        size_t begin = p * size / num_parts;
+        size_t part_size = (p + 1) * size / num_parts - begin;
+        contiguous_reduce(in_ptr + begin, &partials[p], part_size, Op{}, init);
+      }
+    });
+    U val = init;
+    for (size_t p = 0; p < num_parts; p++) {
+      val = Op{}(val, partials[p]);
+    }
+    *out_ptr = val;
     return;
   }
 
   if (plan.type == ContiguousReduce && plan.shape.size() == 1) {
     int reduction_size = plan.shape[0];
-    for (int i = 0; i < out.size(); i++, out_ptr++, in_ptr += reduction_size) {
-      *out_ptr = init;
-      contiguous_reduce(in_ptr, out_ptr, reduction_size, Op{}, init);
-    }
+    cpu::parallel_for(
+        out.size(),
+        parallel_grain(x.size(), out.size()),
+        [&](size_t i, size_t end) {
+          for (; i < end; i++) {
+            out_ptr[i] = init;
+            contiguous_reduce(
+                in_ptr + i * reduction_size,
+                out_ptr + i,
+                reduction_size,
+                Op{},
+                init);
+          }
+        });
     return;
   }
 
@@ -166,30 +207,35 @@ void reduction_op(
     plan.strides.pop_back();
     // Unrolling the following loop (and implementing it in order for
     // ContiguousReduce) should hold extra performance boost.
-    auto [shape, strides] = shapes_without_reduction_axes(x, axes);
-    if (plan.shape.size() == 0) {
-      for (int i = 0; i < out.size(); i++, out_ptr++) {
-        int offset = elem_to_loc(i, shape, strides);
-        *out_ptr = init;
-        contiguous_reduce(in_ptr + offset, out_ptr, reduction_size, Op{}, init);
-      }
-    } else {
-      for (int i = 0; i < out.size(); i++, out_ptr++) {
-        int offset = elem_to_loc(i, shape, strides);
-        *out_ptr = init;
-        nd_loop(
-            [&](int extra_offset) {
+    // Not a structured binding, as it is captured by the chunks.
+    Shape shape;
+    Strides strides;
+    std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
+    cpu::parallel_for(
+        out.size(),
+        parallel_grain(x.size(), out.size()),
+        [&](size_t i, size_t end) {
+          for (; i < end; i++) {
+            int offset = elem_to_loc(i, shape, strides);
+            out_ptr[i] = init;
+            if (plan.shape.size() == 0) {
               contiguous_reduce(
-                  in_ptr + offset + extra_offset,
-                  out_ptr,
-                  reduction_size,
-                  Op{},
-                  init);
-            },
-            plan.shape,
-            plan.strides);
-      }
-    }
+                  in_ptr + offset, out_ptr + i, reduction_size, Op{}, init);
+              continue;
+            }
+            nd_loop(
+                [&](int extra_offset) {
+                  contiguous_reduce(
+                      in_ptr + offset + extra_offset,
+                      out_ptr + i,
+                      reduction_size,
+                      Op{},
+                      init);
+                },
+                plan.shape,
+                plan.strides);
+          }
+        });
     return;
   }
 
@@ -198,12 +244,22 @@ void reduction_op(
     size_t reduction_stride = plan.strides.back();
     plan.shape.pop_back();
     plan.strides.pop_back();
-    for (int i = 0; i < out.size(); i += reduction_stride) {
-      std::fill_n(out_ptr, reduction_stride, init);
-      strided_reduce(in_ptr, out_ptr, reduction_size, reduction_stride, Op{});
-      in_ptr += reduction_stride * reduction_size;
-      out_ptr += reduction_stride;
-    }
+    size_t num_blocks = out.size() / reduction_stride;
+    cpu::parallel_for(
+        num_blocks,
+        parallel_grain(x.size(), num_blocks),
+        [&](size_t b, size_t end) {
+          for (; b < end; b++) {
+            auto block_out = out_ptr + b * reduction_stride;
+            std::fill_n(block_out, reduction_stride, init);
+            strided_reduce(
+                in_ptr + b * reduction_stride * reduction_size,
+                block_out,
+                reduction_size,
+                reduction_stride,
+                Op{});
+          }
+        });
     return;
   }
 
@@ -213,51 +269,65 @@ void reduction_op(
     size_t reduction_stride = plan.strides.back();
     plan.shape.pop_back();
     plan.strides.pop_back();
-    auto [shape, strides] = shapes_without_reduction_axes(x, axes);
-
-    if (plan.shape.size() == 0) {
-      for (int i = 0; i < out.size(); i += reduction_stride) {
-        int offset = elem_to_loc(i, shape, strides);
-        std::fill_n(out_ptr, reduction_stride, init);
-        strided_reduce(
-            in_ptr + offset, out_ptr, reduction_size, reduction_stride, Op{});
-        out_ptr += reduction_stride;
-      }
-    } else {
-      for (int i = 0; i < out.size(); i += reduction_stride) {
-        int offset = elem_to_loc(i, shape, strides);
-        std::fill_n(out_ptr, reduction_stride, init);
-        nd_loop(
-            [&](int extra_offset) {
+    Shape shape;
+    Strides strides;
+    std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
+
+    size_t num_blocks = out.size() / reduction_stride;
+    cpu::parallel_for(
+        num_blocks,
+        parallel_grain(x.size(), num_blocks),
+        [&](size_t b, size_t end) {
+          for (; b < end; b++) {
+            int offset = elem_to_loc(b * reduction_stride, shape, strides);
+            auto block_out = out_ptr + b * reduction_stride;
+            std::fill_n(block_out, reduction_stride, init);
+            if (plan.shape.size() == 0) {
               strided_reduce(
-                  in_ptr + offset + extra_offset,
-                  out_ptr,
+                  in_ptr + offset,
+                  block_out,
                   reduction_size,
                   reduction_stride,
                   Op{});
-            },
-            plan.shape,
-            plan.strides);
-        out_ptr += reduction_stride;
-      }
-    }
+              continue;
+            }
+            nd_loop(
+                [&](int extra_offset) {
+                  strided_reduce(
+                      in_ptr + offset + extra_offset,
+                      block_out,
+                      reduction_size,
+                      reduction_stride,
+                      Op{});
+                },
+                plan.shape,
+                plan.strides);
+          }
+        });
     return;
   }
 
   if (plan.type == GeneralReduce) {
-    auto [shape, strides] = shapes_without_reduction_axes(x, axes);
-
-    for (int i = 0; i < out.size(); i++, out_ptr++) {
-      int offset = elem_to_loc(i, shape, strides);
-      U val = init;
-      nd_loop(
-          [&](int extra_offset) {
-            val = Op{}(val, *(in_ptr + offset + extra_offset));
-          },
-          plan.shape,
-          plan.strides);
-      *out_ptr = val;
-    }
+    Shape shape;
+    Strides strides;
+    std::tie(shape, strides) = shapes_without_reduction_axes(x, axes);
+
+    cpu::parallel_for(
+        out.size(),
+        parallel_grain(x.size(), out.size()),
+        [&](size_t i, size_t end) {
+          for (; i < end; i++) {
+            int offset = elem_to_loc(i, shape, strides);
+            U val = init;
+            nd_loop(
+                [&](int extra_offset) {
+                  val = Op{}(val, *(in_ptr + offset + extra_offset));
+                },
+                plan.shape,
+                plan.strides);
+            out_ptr[i] = val;
+          }
+        });
   }
 }
 
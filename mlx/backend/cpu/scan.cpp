@@ -1,18 +1,110 @@
 // Copyright © 2023 Apple Inc.
 
 #include <cassert>
+#include <memory>
 
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cpu/binary_ops.h"
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
 
 namespace {
 
+// The scan ops combine the scan so far |y| with the next input |x|, on
+// scalars and on simd vectors of the same type.
+struct ScanSum {
+  template <typename U, typename T>
+  U operator()(U y, T x) const {
+    return y + x;
+  }
+};
+
+struct ScanProd {
+  template <typename U, typename T>
+  U operator()(U y, T x) const {
+    if constexpr (std::is_same_v<U, bool>) {
+      return (y * x) != 0;
+    } else {
+      return y * x;
+    }
+  }
+};
+
+struct ScanMin {
+  template <typename U, typename T>
+  U operator()(U y, T x) const {
+    return x < y ? x : y;
+  }
+  template <typename T, int N>
+  simd::Simd<T, N> operator()(simd::Simd<T, N> y, simd::Simd<T, N> x) const {
+    return simd::select(x < y, x, y);
+  }
+};
+
+struct ScanMax {
+  template <typename U, typename T>
+  U operator()(U y, T x) const {
+    return x < y ? y : x;
+  }
+  template <typename T, int N>
+  simd::Simd<T, N> operator()(simd::Simd<T, N> y, simd::Simd<T, N> x) const {
+    return simd::select(x < y, y, x);
+  }
+};
+
+struct ScanLogAddExp {
+  template <typename U, typename T>
+  U operator()(U y, T x) const {
+    return detail::LogAddExp{}(y, static_cast<U>(x));
+  }
+  template <typename T, int N>
+  simd::Simd<T, N> operator()(simd::Simd<T, N> y, simd::Simd<T, N> x) const {
+    return detail::LogAddExp{}(y, x);
+  }
+};
+
+// Whether the scan of T into U runs on simd vectors.
+template <typename T, typename U>
+constexpr bool simd_scan = std::is_same_v<T, U> && simd::max_size<U> > 1;
+
+// Set out[k] = op(prev[k], in[k]) for the |n| elements of out.
+template <typename T, typename U, typename Op>
+void scan_step(U* out, const U* prev, const T* in, int n, const Op& op) {
+  int k = 0;
+  if constexpr (simd_scan<T, U>) {
+    constexpr int S = simd::max_size<U>;
+    for (; k + S <= n; k += S) {
+      simd::store(
+          out + k,
+          op(simd::load<U, S>(prev + k), simd::load<T, S>(in + k)));
+    }
+  }
+  for (; k < n; k++) {
+    out[k] = op(prev[k], in[k]);
+  }
+}
+
+// Set out[k] = op(carry, out[k]) for the |n| elements of out.
+template <typename U, typename Op>
+void scan_carry(U* out, U carry, size_t n, const Op& op) {
+  size_t k = 0;
+  if constexpr (simd_scan<U, U>) {
+    constexpr int S = simd::max_size<U>;
+    simd::Simd<U, S> c(carry);
+    for (; k + S <= n; k += S) {
+      simd::store(out + k, op(c, simd::load<U, S>(out + k)));
+    }
+  }
+  for (; k < n; k++) {
+    out[k] = op(carry, out[k]);
+  }
+}
+
 template <typename T, typename U, typename Op>
 void contiguous_scan(
     const T* input,
@@ -78,81 +170,82 @@ void contiguous_scan(
   }
 };
 
+// Scan |cols| adjacent columns of |size| rows of |stride| elements.
 template <typename T, typename U, typename Op>
 void strided_scan(
     const T* input,
     U* output,
-    int count,
+    int cols,
     int size,
     int stride,
     bool reverse,
     bool inclusive,
     const Op& op,
     U init) {
-  // TODO: Vectorize the following naive implementation
-  if (!reverse) {
-    if (inclusive) {
-      for (int i = 0; i < count; i++) {
-        std::copy(input, input + stride, output);
-        output += stride;
-        input += stride;
-        for (int j = 1; j < size; j++) {
-          for (int k = 0; k < stride; k++) {
-            *output = op(*(output - stride), *input);
-            output++;
-            input++;
-          }
-        }
-      }
-    } else {
-      for (int i = 0; i < count; i++) {
-        std::fill(output, output + stride, init);
-        output += stride;
-        input += stride;
-        for (int j = 1; j < size; j++) {
-          for (int k = 0; k < stride; k++) {
-            *output = op(*(output - stride), *(input - stride));
-            output++;
-            input++;
-          }
-        }
-      }
-    }
+  int first = reverse ? size - 1 : 0;
+  int step = reverse ? -stride : stride;
+  U* out = output + first * stride;
+  const T* in = input + first * stride;
+  if (inclusive) {
+    std::copy(in, in + cols, out);
   } else {
-    if (inclusive) {
-      for (int i = 0; i < count; i++) {
-        output += (size - 1) * stride;
-        input += (size - 1) * stride;
-        std::copy(input, input + stride, output);
-        for (int j = 1; j < size; j++) {
-          for (int k = 0; k < stride; k++) {
-            output--;
-            input--;
-            *output = op(*(output + stride), *input);
-          }
-        }
-        output += size * stride;
-        input += size * stride;
-      }
-    } else {
-      for (int i = 0; i < count; i++) {
-        output += (size - 1) * stride;
-        input += (size - 1) * stride;
-        std::fill(output, output + stride, init);
-        for (int j = 1; j < size; j++) {
-          for (int k = 0; k < stride; k++) {
-            output--;
-            input--;
-            *output = op(*(output + stride), *(input + stride));
-          }
-        }
-        output += size * stride;
-        input += size * stride;
-      }
-    }
+    std::fill(out, out + cols, init);
+  }
+  for (int j = 1; j < size; j++) {
+    out += step;
+    in += step;
+    scan_step(out, out - step, inclusive ? in : in - step, cols, op);
   }
 };
 
+// Scan a long contiguous row in chunks on several threads: the local scans
+// of the chunks, the scan of the totals of the chunks and then the totals
+// of the chunks before each chunk are added to it.
+template <typename T, typename U, typename Op>
+void blocked_scan(
+    const T* input,
+    U* output,
+    size_t size,
+    bool reverse,
+    bool inclusive,
+    const Op& op,
+    U init) {
+  size_t num_chunks = cpu::thread_pool().size() + 1;
+  size_t chunk = (size + num_chunks - 1) / num_chunks;
+  num_chunks = (size + chunk - 1) / chunk;
+  auto totals = std::make_unique<U[]>(num_chunks);
+  cpu::parallel_for(num_chunks, 1, [&](size_t c, size_t end) {
+    for (; c < end; c++) {
+      size_t start = c * chunk;
+      size_t n = std::min(chunk, size - start);
+      contiguous_scan(
+          input + start, output + start, 1, n, reverse, inclusive, op, init);
+      size_t last = reverse ? start : start + n - 1;
+      totals[c] = inclusive ? output[last] : op(output[last], input[last]);
+    }
+  });
+
+  // The carry of a chunk is the total of the chunks before it in the order
+  // of the scan.
+  auto carries = std::make_unique<U[]>(num_chunks);
+  for (size_t i = 1; i < num_chunks; i++) {
+    size_t c = reverse ? num_chunks - 1 - i : i;
+    size_t prev = reverse ? c + 1 : c - 1;
+    carries[c] = i == 1 ? totals[prev] : op(carries[prev], totals[prev]);
+  }
+
+  cpu::parallel_for(num_chunks, 1, [&](size_t c, size_t end) {
+    for (; c < end; c++) {
+      if (c == (reverse ? num_chunks - 1 : 0)) {
+        continue;
+      }
+      size_t start = c * chunk;
+      size_t n = std::min(chunk, size - start);
+      scan_carry(output + start, carries[c], n, op);
+    }
+  });
+}
+
 template <typename T, typename U, typename Op>
 void scan_op(
     const array& in,
@@ -162,31 +255,70 @@ void scan_op(
     bool inclusive,
     const Op& op,
     U init) {
-  if (in.flags().row_contiguous) {
-    if (in.strides()[axis] == 1) {
+  if (!in.flags().row_contiguous) {
+    throw std::runtime_error("Scan op supports only contiguous inputs");
+  }
+  const T* in_ptr = in.data<T>();
+  U* out_ptr = out.data<U>();
+  size_t size = in.shape(axis);
+  size_t stride = in.strides()[axis];
+  if (size == 0) {
+    return;
+  }
+
+  if (stride == 1) {
+    // The rows are split between the threads, or each row when there are
+    // too few of them.
+    size_t count = in.size() / size;
+    size_t num_threads = cpu::thread_pool().size() + 1;
+    if (count < num_threads && size >= 2 * cpu::min_parallel_size) {
+      for (size_t i = 0; i < count; i++) {
+        blocked_scan(
+            in_ptr + i * size,
+            out_ptr + i * size,
+            size,
+            reverse,
+            inclusive,
+            op,
+            init);
+      }
+      return;
+    }
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / size, 1);
+    cpu::parallel_for(count, grain, [&](size_t i, size_t end) {
       contiguous_scan(
-          in.data<T>(),
-          out.data<U>(),
-          in.size() / in.shape(axis),
-          in.shape(axis),
+          in_ptr + i * size,
+          out_ptr + i * size,
+          end - i,
+          size,
           reverse,
           inclusive,
           op,
           init);
-    } else {
-      strided_scan(
-          in.data<T>(),
-          out.data<U>(),
-          in.size() / in.shape(axis) / in.strides()[axis],
-          in.shape(axis),
-          in.strides()[axis],
-          reverse,
-          inclusive,
-          op,
-          init);
-    }
+    });
   } else {
-    throw std::runtime_error("Scan op supports only contiguous inputs");
+    // The columns of all the blocks of rows are split between the threads.
+    size_t count = in.size() / size / stride;
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / size, 1);
+    cpu::parallel_for(count * stride, grain, [&](size_t c, size_t end) {
+      while (c < end) {
+        size_t i = c / stride;
+        size_t k = c % stride;
+        size_t cols = std::min(stride - k, end - c);
+        size_t offset = i * size * stride + k;
+        strided_scan(
+            in_ptr + offset,
+            out_ptr + offset,
+            cols,
+            size,
+            stride,
+            reverse,
+            inclusive,
+            op,
+            init);
+        c += cols;
+      }
+    });
   }
 }
 
@@ -200,19 +332,19 @@ void scan_dispatch(
     bool inclusive) {
   switch (rtype) {
     case Scan::Sum: {
-      auto op = [](U y, T x) { return y + x; };
+      auto op = ScanSum{};
       auto init = static_cast<U>(0);
       scan_op<T, U>(in, out, axis, reverse, inclusive, op, init);
       break;
     }
     case Scan::Prod: {
-      auto op = [](U y, T x) { return y * x; };
+      auto op = ScanProd{};
       auto init = static_cast<U>(1);
       scan_op<T, U>(in, out, axis, reverse, inclusive, op, init);
       break;
     }
     case Scan::Min: {
-      auto op = [](U y, T x) { return x < y ? x : y; };
+      auto op = ScanMin{};
       auto init = (issubdtype(in.dtype(), floating))
           ? static_cast<U>(std::numeric_limits<float>::infinity())
           : std::numeric_limits<U>::max();
@@ -220,7 +352,7 @@ void scan_dispatch(
       break;
     }
     case Scan::Max: {
-      auto op = [](U y, T x) { return x < y ? y : x; };
+      auto op = ScanMax{};
       auto init = (issubdtype(in.dtype(), floating))
           ? static_cast<U>(-std::numeric_limits<float>::infinity())
           : std::numeric_limits<U>::min();
@@ -228,9 +360,7 @@ void scan_dispatch(
       break;
     }
     case Scan::LogAddExp: {
-      auto op = [](U a, T b) {
-        return detail::LogAddExp{}(a, static_cast<U>(b));
-      };
+      auto op = ScanLogAddExp{};
       auto init = (issubdtype(in.dtype(), floating))
           ? static_cast<U>(-std::numeric_limits<float>::infinity())
           : std::numeric_limits<U>::min();
@@ -0,0 +1,483 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <immintrin.h>
+
+#include <stdint.h>
+#include <cmath>
+#include <complex>
+#include <limits>
+
+#include "mlx/backend/cpu/simd/base_simd.h"
+
+namespace mlx::core::simd {
+
+// The size in bytes of the widest vector registers of the target, the
+// kernels use vectors of that size for the scalar types below.
+#ifdef __AVX512F__
+constexpr int vector_bytes = 64;
+#else
+constexpr int vector_bytes = 32;
+#endif
+
+// The vectors of bool hold int8_t, 0 or 1 as when they are loaded.
+template <typename T>
+struct ScalarT {
+  using v = T;
+};
+template <>
+struct ScalarT<bool> {
+  using v = int8_t;
+};
+
+// The integer of the size of the scalars of a mask.
+template <int Size>
+struct MaskT;
+template <>
+struct MaskT<1> {
+  using v = int8_t;
+};
+template <>
+struct MaskT<2> {
+  using v = int16_t;
+};
+template <>
+struct MaskT<4> {
+  using v = int32_t;
+};
+template <>
+struct MaskT<8> {
+  using v = int64_t;
+};
+
+// The vector of N scalars, only aligned as its scalars since the loads and
+// stores of the kernels are not aligned.
+template <typename T, int N>
+struct Vector {
+  typedef T type
+      __attribute__((vector_size(N * sizeof(T)), aligned(sizeof(T))));
+};
+
+template <typename T, int N>
+struct Simd {
+  static constexpr int size = N;
+  using scalar_t = typename ScalarT<T>::v;
+  using vector_t = typename Vector<scalar_t, N>::type;
+
+  Simd() {}
+
+  Simd(vector_t v) : value(v) {}
+
+  template <typename U>
+  Simd(Simd<U, N> other) {
+    if constexpr (std::is_same_v<T, bool>) {
+      value = __builtin_convertvector(other.value != 0, vector_t) & 1;
+    } else if constexpr (std::is_same_v<U, bool>) {
+      value = __builtin_convertvector(other.value & 1, vector_t);
+    } else {
+      value = __builtin_convertvector(other.value, vector_t);
+    }
+  }
+
+  template <
+      typename U,
+      typename = std::enable_if_t<std::is_convertible_v<U, scalar_t>>>
+  Simd(U v) : value(vector_t{} + static_cast<scalar_t>(v)) {}
+
+  Simd(Simd<T, N / 2> x, Simd<T, N / 2> y) {
+    for (int i = 0; i < N / 2; ++i) {
+      value[i] = x[i];
+      value[N / 2 + i] = y[i];
+    }
+  }
+
+  T operator[](int idx) const {
+    return value[idx];
+  }
+
+  scalar_t& operator[](int idx) {
+    return reinterpret_cast<scalar_t*>(&value)[idx];
+  }
+
+  vector_t value;
+};
+
+template <>
+inline constexpr int max_size<int8_t> = vector_bytes;
+template <>
+inline constexpr int max_size<int16_t> = vector_bytes / 2;
+template <>
+inline constexpr int max_size<int> = vector_bytes / 4;
+template <>
+inline constexpr int max_size<int64_t> = vector_bytes / 8;
+template <>
+inline constexpr int max_size<uint8_t> = vector_bytes;
+template <>
+inline constexpr int max_size<uint16_t> = vector_bytes / 2;
+template <>
+inline constexpr int max_size<uint32_t> = vector_bytes / 4;
+template <>
+inline constexpr int max_size<uint64_t> = vector_bytes / 8;
+template <>
+inline constexpr int max_size<float> = vector_bytes / 4;
+template <>
+inline constexpr int max_size<double> = vector_bytes / 8;
+
+// The masks of the comparisons as vectors of bool.
+template <int N, typename M>
+Simd<bool, N> to_bool(M mask) {
+  return __builtin_convertvector(mask, typename Simd<bool, N>::vector_t) & 1;
+}
+
+// Apply the scalar |f| to each element, the compiler vectorizes the loop
+// when it can.
+template <typename T, int N, typename F>
+Simd<T, N> map(Simd<T, N> x, F f) {
+  Simd<T, N> r;
+  for (int i = 0; i < N; ++i) {
+    r.value[i] = f(x.value[i]);
+  }
+  return r;
+}
+
+template <typename T, int N, typename F>
+Simd<T, N> map(Simd<T, N> x, Simd<T, N> y, F f) {
+  Simd<T, N> r;
+  for (int i = 0; i < N; ++i) {
+    r.value[i] = f(x.value[i], y.value[i]);
+  }
+  return r;
+}
+
+#define SIMD_DEFAULT_UNARY(name, op)                         \
+  template <typename T, int N>                               \
+  Simd<T, N> name(Simd<T, N> v) {                            \
+    return map(v, [](auto x) { return decltype(x)(op(x)); }); \
+  }
+
+SIMD_DEFAULT_UNARY(abs, std::abs)
+SIMD_DEFAULT_UNARY(floor, std::floor)
+SIMD_DEFAULT_UNARY(acos, std::acos)
+SIMD_DEFAULT_UNARY(acosh, std::acosh)
+SIMD_DEFAULT_UNARY(asin, std::asin)
+SIMD_DEFAULT_UNARY(asinh, std::asinh)
+SIMD_DEFAULT_UNARY(atan, std::atan)
+SIMD_DEFAULT_UNARY(atanh, std::atanh)
+SIMD_DEFAULT_UNARY(ceil, std::ceil)
+SIMD_DEFAULT_UNARY(cosh, std::cosh)
+SIMD_DEFAULT_UNARY(expm1, std::expm1)
+SIMD_DEFAULT_UNARY(log2, std::log2)
+SIMD_DEFAULT_UNARY(log10, std::log10)
+SIMD_DEFAULT_UNARY(log1p, std::log1p)
+SIMD_DEFAULT_UNARY(rint, std::rint)
+SIMD_DEFAULT_UNARY(sinh, std::sinh)
+SIMD_DEFAULT_UNARY(tan, std::tan)
+SIMD_DEFAULT_UNARY(tanh, std::tanh)
+
+template <typename T, int N>
+Simd<T, N> sqrt(Simd<T, N> v) {
+  using V = typename Simd<T, N>::vector_t;
+  if constexpr (std::is_same_v<T, float> && N == 8) {
+    return (V)_mm256_sqrt_ps((__m256)v.value);
+  } else if constexpr (std::is_same_v<T, double> && N == 4) {
+    return (V)_mm256_sqrt_pd((__m256d)v.value);
+#ifdef __AVX512F__
+  } else if constexpr (std::is_same_v<T, float> && N == 16) {
+    return (V)_mm512_sqrt_ps((__m512)v.value);
+  } else if constexpr (std::is_same_v<T, double> && N == 8) {
+    return (V)_mm512_sqrt_pd((__m512d)v.value);
+#endif
+  } else {
+    return map(v, [](auto x) { return decltype(x)(std::sqrt(x)); });
+  }
+}
+
+template <typename T, int N>
+Simd<T, N> recip(Simd<T, N> v) {
+  return T(1) / v;
+}
+
+template <typename T, int N>
+Simd<T, N> rsqrt(Simd<T, N> v) {
+  return T(1) / sqrt(v);
+}
+
+template <typename T, int N>
+Simd<T, N> operator-(Simd<T, N> v) {
+  return -v.value;
+}
+
+template <typename T, int N>
+Simd<T, N> operator~(Simd<T, N> v) {
+  return ~v.value;
+}
+
+template <typename T, int N>
+Simd<bool, N> isnan(Simd<T, N> v) {
+  return to_bool<N>(v.value != v.value);
+}
+
+template <typename T, int N>
+Simd<bool, N> operator!(Simd<T, N> v) {
+  return to_bool<N>(v.value == 0);
+}
+
+#define SIMD_DEFAULT_BINARY(OP)                                     \
+  template <typename T, typename U, int N>                          \
+  Simd<T, N> operator OP(Simd<T, N> x, U y) {                       \
+    return x.value OP Simd<T, N>(y).value;                          \
+  }                                                                 \
+  template <typename T1, typename T2, int N>                        \
+  Simd<T2, N> operator OP(T1 x, Simd<T2, N> y) {                    \
+    return Simd<T2, N>(x).value OP y.value;                         \
+  }                                                                 \
+  template <typename T1, typename T2, int N>                        \
+  Simd<T1, N> operator OP(Simd<T1, N> x, Simd<T2, N> y) {           \
+    return x.value OP Simd<T1, N>(y).value;                         \
+  }
+
+SIMD_DEFAULT_BINARY(+)
+SIMD_DEFAULT_BINARY(-)
+SIMD_DEFAULT_BINARY(/)
+SIMD_DEFAULT_BINARY(*)
+SIMD_DEFAULT_BINARY(<<)
+SIMD_DEFAULT_BINARY(>>)
+SIMD_DEFAULT_BINARY(|)
+SIMD_DEFAULT_BINARY(^)
+SIMD_DEFAULT_BINARY(&)
+
+#define SIMD_DEFAULT_LOGICAL(OP, BITOP)                                   \
+  template <typename T, typename U, int N>                                \
+  Simd<T, N> operator OP(Simd<T, N> x, U y) {                             \
+    return Simd<T, N>(                                                    \
+        to_bool<N>((x.value != 0) BITOP(Simd<T, N>(y).value != 0)));      \
+  }                                                                       \
+  template <typename T1, typename T2, int N>                              \
+  Simd<T2, N> operator OP(T1 x, Simd<T2, N> y) {                          \
+    return Simd<T2, N>(                                                   \
+        to_bool<N>((Simd<T2, N>(x).value != 0) BITOP(y.value != 0)));     \
+  }                                                                       \
+  template <typename T1, typename T2, int N>                              \
+  Simd<T1, N> operator OP(Simd<T1, N> x, Simd<T2, N> y) {                 \
+    return Simd<T1, N>(                                                   \
+        to_bool<N>((x.value != 0) BITOP(Simd<T1, N>(y).value != 0)));     \
+  }
+
+SIMD_DEFAULT_LOGICAL(&&, &)
+SIMD_DEFAULT_LOGICAL(||, |)
+
+#define SIMD_DEFAULT_COMPARISONS(OP)                        \
+  template <int N, typename T, typename U>                  \
+  Simd<bool, N> operator OP(Simd<T, N> a, U b) {            \
+    return to_bool<N>(a.value OP Simd<T, N>(b).value);      \
+  }                                                         \
+  template <int N, typename T, typename U>                  \
+  Simd<bool, N> operator OP(T a, Simd<U, N> b) {            \
+    return to_bool<N>(Simd<U, N>(a).value OP b.value);      \
+  }                                                         \
+  template <int N, typename T1, typename T2>                \
+  Simd<bool, N> operator OP(Simd<T1, N> a, Simd<T2, N> b) { \
+    return to_bool<N>(a.value OP Simd<T1, N>(b).value);     \
+  }
+
+SIMD_DEFAULT_COMPARISONS(>)
+SIMD_DEFAULT_COMPARISONS(<)
+SIMD_DEFAULT_COMPARISONS(>=)
+SIMD_DEFAULT_COMPARISONS(<=)
+SIMD_DEFAULT_COMPARISONS(==)
+SIMD_DEFAULT_COMPARISONS(!=)
+
+template <typename MaskT_, typename T1, typename T2, int N>
+Simd<T1, N> select(Simd<MaskT_, N> mask, Simd<T1, N> x, Simd<T2, N> y) {
+  using M = typename MaskT<sizeof(typename Simd<T1, N>::scalar_t)>::v;
+  using MV = typename Vector<M, N>::type;
+  auto m = __builtin_convertvector(mask.value != 0, MV);
+  auto r = ((MV)x.value & m) | ((MV)Simd<T1, N>(y).value & ~m);
+  return (typename Simd<T1, N>::vector_t)r;
+}
+
+template <typename T, int N>
+Simd<T, N> atan2(Simd<T, N> a, Simd<T, N> b) {
+  return map(a, b, [](auto x, auto y) { return decltype(x)(std::atan2(x, y)); });
+}
+
+template <typename T, int N>
+Simd<T, N> maximum(Simd<T, N> a, Simd<T, N> b) {
+  auto r = select(a > b, a, b);
+  if constexpr (!std::is_integral_v<T>) {
+    r = select(isnan(a), a, r);
+  }
+  return r;
+}
+
+template <typename T, int N>
+Simd<T, N> minimum(Simd<T, N> a, Simd<T, N> b) {
+  auto r = select(a < b, a, b);
+  if constexpr (!std::is_integral_v<T>) {
+    r = select(isnan(a), a, r);
+  }
+  return r;
+}
+
+template <typename T, int N>
+Simd<T, N> remainder(Simd<T, N> a, Simd<T, N> b) {
+  Simd<T, N> r;
+  if constexpr (!std::is_integral_v<T>) {
+    r = map(
+        a, b, [](auto x, auto y) { return decltype(x)(std::remainder(x, y)); });
+  } else {
+    r = a - b * (a / b);
+  }
+  if constexpr (std::is_signed_v<T>) {
+    auto mask = r != 0 && (r < 0 != b < 0);
+    r = select(mask, r + b, r);
+  }
+  return r;
+}
+
+template <typename T, int N>
+Simd<T, N> pow(Simd<T, N> base, Simd<T, N> exp) {
+  if constexpr (!std::is_integral_v<T>) {
+    return map(
+        base, exp, [](auto x, auto y) { return decltype(x)(std::pow(x, y)); });
+  } else {
+    Simd<T, N> res = 1;
+    while (any(exp)) {
+      res = select(exp & 1, res * base, res);
+      base = select(exp, base * base, base);
+      exp = exp >> 1;
+    }
+    return res;
+  }
+}
+
+template <typename T, int N>
+Simd<T, N> clamp(Simd<T, N> v, Simd<T, N> min, Simd<T, N> max) {
+  return select(v < min, min, select(max < v, max, v));
+}
+
+template <typename T, typename U, int N>
+Simd<T, N> fma(Simd<T, N> x, Simd<T, N> y, U z) {
+  using V = typename Simd<T, N>::vector_t;
+  auto zv = Simd<T, N>(z).value;
+#ifdef __FMA__
+  if constexpr (std::is_same_v<T, float> && N == 8) {
+    return (V)_mm256_fmadd_ps((__m256)x.value, (__m256)y.value, (__m256)zv);
+  } else if constexpr (std::is_same_v<T, double> && N == 4) {
+    return (V)_mm256_fmadd_pd((__m256d)x.value, (__m256d)y.value, (__m256d)zv);
+  }
+#endif
+#ifdef __AVX512F__
+  if constexpr (std::is_same_v<T, float> && N == 16) {
+    return (V)_mm512_fmadd_ps((__m512)x.value, (__m512)y.value, (__m512)zv);
+  } else if constexpr (std::is_same_v<T, double> && N == 8) {
+    return (V)_mm512_fmadd_pd((__m512d)x.value, (__m512d)y.value, (__m512d)zv);
+  }
+#endif
+  return x.value * y.value + zv;
+}
+
+/**
+ * The log of the floats, with the reduction to [sqrt(1/2), sqrt(2)) and the
+ * polynomial of the Cephes math library, and the logs of the other types
+ * element by element.
+ */
+template <typename T, int N>
+Simd<T, N> log(Simd<T, N> in) {
+  if constexpr (!std::is_same_v<T, float>) {
+    return map(in, [](auto x) { return decltype(x)(std::log(x)); });
+  } else {
+    // The denormals are scaled to normals by 2**23.
+    auto denormal = in < std::numeric_limits<float>::min();
+    auto x = select(denormal, in * 8388608.0f, in);
+    auto bits = *(Simd<int32_t, N>*)&x;
+    Simd<float, N> e = (bits >> 23) - 126;
+    e = select(denormal, e - 23.0f, e);
+    bits = (bits & ~0x7f800000) | 0x3f000000;
+    x = *(Simd<float, N>*)&bits;
+
+    // x in [0.5, 1), moved to [sqrt(1/2), sqrt(2)) with the exponent.
+    auto small = x < 0.707106781186547524f;
+    e = select(small, e - 1.0f, e);
+    x = select(small, x + x, x) - 1.0f;
+
+    auto z = x * x;
+    Simd<float, N> y = 7.0376836292e-2f;
+    y = fma(y, x, -1.1514610310e-1f);
+    y = fma(y, x, 1.1676998740e-1f);
+    y = fma(y, x, -1.2420140846e-1f);
+    y = fma(y, x, 1.4249322787e-1f);
+    y = fma(y, x, -1.6668057665e-1f);
+    y = fma(y, x, 2.0000714765e-1f);
+    y = fma(y, x, -2.4999993993e-1f);
+    y = fma(y, x, 3.3333331174e-1f);
+    y = y * x * z;
+    y = fma(e, Simd<float, N>(-2.12194440e-4f), y);
+    y = fma(z, Simd<float, N>(-0.5f), y);
+    auto result = x + y;
+    result = fma(e, Simd<float, N>(0.693359375f), result);
+
+    // Deal with 0, Inf, NaN and the negatives
+    constexpr float inf = std::numeric_limits<float>::infinity();
+    result = select(in == 0.0f, Simd<float, N>(-inf), result);
+    result = select(in == inf, in, result);
+    return select(
+        in < 0.0f || isnan(in),
+        Simd<float, N>(std::numeric_limits<float>::quiet_NaN()),
+        result);
+  }
+}
+
+// Reductions
+
+template <typename T, int N>
+bool all(Simd<T, N> x) {
+  bool r = true;
+  for (int i = 0; i < N; ++i) {
+    r &= x.value[i] != 0;
+  }
+  return r;
+}
+template <typename T, int N>
+bool any(Simd<T, N> x) {
+  bool r = false;
+  for (int i = 0; i < N; ++i) {
+    r |= x.value[i] != 0;
+  }
+  return r;
+}
+template <typename T, int N>
+T sum(Simd<T, N> x) {
+  auto r = x.value[0];
+  for (int i = 1; i < N; ++i) {
+    r += x.value[i];
+  }
+  return r;
+}
+template <typename T, int N>
+T max(Simd<T, N> x) {
+  auto r = x.value[0];
+  for (int i = 1; i < N; ++i) {
+    r = std::max(r, x.value[i]);
+  }
+  return r;
+}
+template <typename T, int N>
+T min(Simd<T, N> x) {
+  auto r = x.value[0];
+  for (int i = 1; i < N; ++i) {
+    r = std::min(r, x.value[i]);
+  }
+  return r;
+}
+template <typename T, int N>
+T prod(Simd<T, N> x) {
+  auto r = x.value[0];
+  for (int i = 1; i < N; ++i) {
+    r *= x.value[i];
+  }
+  return r;
+}
+
+} // namespace mlx::core::simd
@@ -1,13 +1,17 @@
 // Copyright © 2023 Apple Inc.
 
 #include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstring>
 #include <numeric>
+#include <type_traits>
 
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
 
 #include "mlx/primitives.h"
 
@@ -104,6 +108,203 @@ struct StridedIterator {
   T* ptr_;
 };
 
+// The size of the rows from which they are sorted and partitioned on the
+// radix of their keys rather than by comparisons.
+constexpr int radix_min_size = 1024;
+
+// The size of the rows from which the passes of the radix sort are split
+// over the thread pool.
+constexpr size_t radix_parallel_size = 4 * cpu::min_parallel_size;
+
+// The unsigned keys ordered as the values of |T|, for the types which have
+// them.
+template <typename T, typename = void>
+struct RadixKey {
+  static constexpr bool enabled = false;
+};
+
+template <>
+struct RadixKey<bool> {
+  static constexpr bool enabled = true;
+  using type = uint8_t;
+  static type key(bool x) {
+    return x;
+  }
+};
+
+template <typename T>
+struct RadixKey<
+    T,
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> {
+  static constexpr bool enabled = true;
+  using type = std::make_unsigned_t<T>;
+  static type key(T x) {
+    if constexpr (std::is_signed_v<T>) {
+      return static_cast<type>(x) ^ (type(1) << (8 * sizeof(type) - 1));
+    } else {
+      return x;
+    }
+  }
+};
+
+// Floats flip the sign bit of the positive values and all the bits of the
+// negative ones. The zeros have one key and the NaNs the largest so they
+// sort last.
+template <typename T, typename U>
+struct FloatRadixKey {
+  static constexpr bool enabled = true;
+  using type = U;
+  static U key(T x) {
+    constexpr U sign = U(1) << (8 * sizeof(U) - 1);
+    double v = static_cast<double>(x);
+    if (std::isnan(v)) {
+      return ~U(0);
+    }
+    if (v == 0) {
+      return sign;
+    }
+    U bits;
+    std::memcpy(&bits, &x, sizeof(U));
+    return (bits & sign) ? ~bits : (bits | sign);
+  }
+};
+
+template <>
+struct RadixKey<float> : FloatRadixKey<float, uint32_t> {};
+template <>
+struct RadixKey<double> : FloatRadixKey<double, uint64_t> {};
+template <>
+struct RadixKey<float16_t> : FloatRadixKey<float16_t, uint16_t> {};
+template <>
+struct RadixKey<bfloat16_t> : FloatRadixKey<bfloat16_t, uint16_t> {};
+
+// Sort |idx| by |keys| with a stable LSD radix sort of 8 bits per pass,
+// skipping the digits shared by all the keys. The passes over large rows
+// count and scatter blocks of the row in parallel.
+template <typename U, typename IdxT>
+void radix_argsort(std::vector<U>& keys, std::vector<IdxT>& idx) {
+  size_t n = keys.size();
+  std::vector<U> keys_tmp(n);
+  std::vector<IdxT> idx_tmp(n);
+
+  size_t n_blocks = 1;
+  if (n >= radix_parallel_size) {
+    n_blocks = std::min<size_t>(
+        n / cpu::min_parallel_size, cpu::thread_pool().size() + 1);
+  }
+  size_t block = (n + n_blocks - 1) / n_blocks;
+  std::vector<std::array<size_t, 256>> hist(n_blocks);
+
+  constexpr int key_bits = 8 * sizeof(U);
+  for (int shift = 0; shift < key_bits; shift += 8) {
+    cpu::parallel_for(n_blocks, 1, [&](size_t b, size_t end) {
+      for (; b < end; b++) {
+        hist[b].fill(0);
+        for (size_t i = b * block; i < std::min(n, (b + 1) * block); i++) {
+          hist[b][(keys[i] >> shift) & 0xff]++;
+        }
+      }
+    });
+
+    // The offset of each block in the bucket of each digit, the pass is
+    // skipped when all the keys have the same digit.
+    bool skip = false;
+    size_t offset = 0;
+    for (int d = 0; d < 256; d++) {
+      size_t start = offset;
+      for (auto& h : hist) {
+        size_t count = h[d];
+        h[d] = offset;
+        offset += count;
+      }
+      if (offset - start == n) {
+        skip = true;
+        break;
+      }
+    }
+    if (skip) {
+      continue;
+    }
+
+    cpu::parallel_for(n_blocks, 1, [&](size_t b, size_t end) {
+      for (; b < end; b++) {
+        for (size_t i = b * block; i < std::min(n, (b + 1) * block); i++) {
+          size_t pos = hist[b][(keys[i] >> shift) & 0xff]++;
+          keys_tmp[pos] = keys[i];
+          idx_tmp[pos] = idx[i];
+        }
+      }
+    });
+    std::swap(keys, keys_tmp);
+    std::swap(idx, idx_tmp);
+  }
+}
+
+// Write to |out| the indices of |idx| partitioned by |keys| such that the
+// |kth| is in place with the smaller keys before and the larger after. From
+// the most significant digit, each pass counts the digits of the remaining
+// keys, moves the indices of the digits below and above the one of the kth
+// to their sides and keeps the ones of its digit.
+template <typename U, typename IdxT>
+void radix_select(
+    std::vector<U>& keys,
+    std::vector<IdxT>& idx,
+    size_t kth,
+    IdxT* out) {
+  size_t lo = 0;
+  size_t hi = keys.size();
+  size_t m = keys.size();
+  constexpr int key_bits = 8 * sizeof(U);
+  for (int shift = key_bits - 8; m > 1 && shift >= 0; shift -= 8) {
+    size_t hist[256] = {};
+    for (size_t i = 0; i < m; i++) {
+      hist[(keys[i] >> shift) & 0xff]++;
+    }
+    size_t below = 0;
+    int digit = 0;
+    while (below + hist[digit] <= kth) {
+      below += hist[digit++];
+    }
+    size_t j = 0;
+    for (size_t i = 0; i < m; i++) {
+      int d = (keys[i] >> shift) & 0xff;
+      if (d < digit) {
+        out[lo++] = idx[i];
+      } else if (d > digit) {
+        out[--hi] = idx[i];
+      } else {
+        keys[j] = keys[i];
+        idx[j++] = idx[i];
+      }
+    }
+    m = j;
+    kth -= below;
+  }
+  std::copy(idx.begin(), idx.begin() + m, out + lo);
+}
+
+// The keys of a row of |axis_size| elements from |data| and their indices.
+template <typename T, typename U, typename IdxT>
+void radix_keys(
+    const T* data,
+    int64_t stride,
+    int axis_size,
+    std::vector<U>& keys,
+    std::vector<IdxT>& idx) {
+  keys.resize(axis_size);
+  idx.resize(axis_size);
+  for (int i = 0; i < axis_size; i++) {
+    keys[i] = RadixKey<T>::key(data[i * stride]);
+    idx[i] = i;
+  }
+}
+
+// The number of rows of |axis_size| elements processed by a task.
+size_t rows_grain(int axis_size) {
+  return std::max<size_t>(
+      cpu::min_parallel_size / std::max(axis_size, 1), 1);
+}
+
 template <typename T>
 void sort(array& out, int axis) {
   // Get axis, shape and stride info
@@ -121,18 +322,34 @@ void sort(array& out, int axis) {
   auto axis_size = out.shape(axis);
 
   // Perform sorting in place
-  ContiguousIterator src_it(
-      remaining_shape, remaining_strides, remaining_shape.size());
   auto out_ptr = out.data<T>();
-  for (int i = 0; i < n_rows; i++) {
-    T* data_ptr = out_ptr + src_it.loc;
-
-    StridedIterator st(data_ptr, axis_stride, 0);
-    StridedIterator ed(data_ptr, axis_stride, axis_size);
-
-    std::stable_sort(st, ed);
-    src_it.step();
-  }
+  cpu::parallel_for(n_rows, rows_grain(axis_size), [&](size_t r, size_t end) {
+    ContiguousIterator src_it(
+        remaining_shape, remaining_strides, remaining_shape.size());
+    src_it.seek(r);
+    for (; r < end; r++) {
+      T* data_ptr = out_ptr + src_it.loc;
+      src_it.step();
+
+      StridedIterator st(data_ptr, axis_stride, 0);
+      StridedIterator ed(data_ptr, axis_stride, axis_size);
+
+      if constexpr (RadixKey<T>::enabled) {
+        if (axis_size >= radix_min_size) {
+          std::vector<typename RadixKey<T>::type> keys;
+          std::vector<uint32_t> idx;
+          radix_keys(data_ptr, axis_stride, axis_size, keys, idx);
+          std::vector<T> vals(st, ed);
+          radix_argsort(keys, idx);
+          for (int i = 0; i < axis_size; i++) {
+            st[i] = vals[idx[i]];
+          }
+          continue;
+        }
+      }
+      std::stable_sort(st, ed);
+    }
+  });
 }
 
 template <typename T, typename IdxT = uint32_t>
@@ -158,35 +375,52 @@ void argsort(const array& in, array& out, int axis) {
   auto axis_size = in.shape(axis);
 
   // Perform sorting
-  ContiguousIterator in_it(
-      in_remaining_shape, in_remaining_strides, in_remaining_shape.size());
-  ContiguousIterator out_it(
-      out_remaining_shape, out_remaining_strides, out_remaining_shape.size());
   auto in_ptr = in.data<T>();
   auto out_ptr = out.data<IdxT>();
-  for (int i = 0; i < n_rows; i++) {
-    const T* data_ptr = in_ptr + in_it.loc;
-    IdxT* idx_ptr = out_ptr + out_it.loc;
-
-    in_it.step();
-    out_it.step();
-
-    StridedIterator st_(idx_ptr, out_stride, 0);
-    StridedIterator ed_(idx_ptr, out_stride, axis_size);
+  cpu::parallel_for(n_rows, rows_grain(axis_size), [&](size_t r, size_t end) {
+    ContiguousIterator in_it(
+        in_remaining_shape, in_remaining_strides, in_remaining_shape.size());
+    ContiguousIterator out_it(
+        out_remaining_shape,
+        out_remaining_strides,
+        out_remaining_shape.size());
+    in_it.seek(r);
+    out_it.seek(r);
+    for (; r < end; r++) {
+      const T* data_ptr = in_ptr + in_it.loc;
+      IdxT* idx_ptr = out_ptr + out_it.loc;
+
+      in_it.step();
+      out_it.step();
+
+      StridedIterator st_(idx_ptr, out_stride, 0);
+      StridedIterator ed_(idx_ptr, out_stride, axis_size);
+
+      if constexpr (RadixKey<T>::enabled) {
+        if (axis_size >= radix_min_size) {
+          std::vector<typename RadixKey<T>::type> keys;
+          std::vector<IdxT> idx;
+          radix_keys(data_ptr, in_stride, axis_size, keys, idx);
+          radix_argsort(keys, idx);
+          std::copy(idx.begin(), idx.end(), st_);
+          continue;
+        }
+      }
 
-    // Initialize with iota
-    std::iota(st_, ed_, IdxT(0));
+      // Initialize with iota
+      std::iota(st_, ed_, IdxT(0));
 
-    // Sort according to vals
-    StridedIterator st(idx_ptr, out_stride, 0);
-    StridedIterator ed(idx_ptr, out_stride, axis_size);
+      // Sort according to vals
+      StridedIterator st(idx_ptr, out_stride, 0);
+      StridedIterator ed(idx_ptr, out_stride, axis_size);
 
-    std::stable_sort(st, ed, [data_ptr, in_stride](IdxT a, IdxT b) {
-      auto v1 = data_ptr[a * in_stride];
-      auto v2 = data_ptr[b * in_stride];
-      return v1 < v2 || (v1 == v2 && a < b);
-    });
-  }
+      std::stable_sort(st, ed, [data_ptr, in_stride](IdxT a, IdxT b) {
+        auto v1 = data_ptr[a * in_stride];
+        auto v2 = data_ptr[b * in_stride];
+        return v1 < v2 || (v1 == v2 && a < b);
+      });
+    }
+  });
 }
 
 template <typename T>
@@ -208,19 +442,36 @@ void partition(array& out, int axis, int kth) {
   kth = kth < 0 ? kth + axis_size : kth;
 
   // Perform partition in place
-  ContiguousIterator src_it(
-      remaining_shape, remaining_strides, remaining_shape.size());
   auto out_ptr = out.data<T>();
-  for (int i = 0; i < n_rows; i++) {
-    T* data_ptr = out_ptr + src_it.loc;
-    src_it.step();
-
-    StridedIterator st(data_ptr, axis_stride, 0);
-    StridedIterator md(data_ptr, axis_stride, kth);
-    StridedIterator ed(data_ptr, axis_stride, axis_size);
-
-    std::nth_element(st, md, ed);
-  }
+  cpu::parallel_for(n_rows, rows_grain(axis_size), [&](size_t r, size_t end) {
+    ContiguousIterator src_it(
+        remaining_shape, remaining_strides, remaining_shape.size());
+    src_it.seek(r);
+    for (; r < end; r++) {
+      T* data_ptr = out_ptr + src_it.loc;
+      src_it.step();
+
+      StridedIterator st(data_ptr, axis_stride, 0);
+      StridedIterator md(data_ptr, axis_stride, kth);
+      StridedIterator ed(data_ptr, axis_stride, axis_size);
+
+      if constexpr (RadixKey<T>::enabled) {
+        if (axis_size >= radix_min_size) {
+          std::vector<typename RadixKey<T>::type> keys;
+          std::vector<uint32_t> idx;
+          radix_keys(data_ptr, axis_stride, axis_size, keys, idx);
+          std::vector<T> vals(st, ed);
+          std::vector<uint32_t> part(axis_size);
+          radix_select(keys, idx, kth, part.data());
+          for (int i = 0; i < axis_size; i++) {
+            st[i] = vals[part[i]];
+          }
+          continue;
+        }
+      }
+      std::nth_element(st, md, ed);
+    }
+  });
 }
 
 template <typename T, typename IdxT = uint32_t>
@@ -248,37 +499,53 @@ void argpartition(const array& in, array& out, int axis, int kth) {
   kth = kth < 0 ? kth + axis_size : kth;
 
   // Perform partition
-  ContiguousIterator in_it(
-      in_remaining_shape, in_remaining_strides, in_remaining_shape.size());
-  ContiguousIterator out_it(
-      out_remaining_shape, out_remaining_strides, out_remaining_shape.size());
-
   auto in_ptr = in.data<T>();
   auto out_ptr = out.data<IdxT>();
+  cpu::parallel_for(n_rows, rows_grain(axis_size), [&](size_t r, size_t end) {
+    ContiguousIterator in_it(
+        in_remaining_shape, in_remaining_strides, in_remaining_shape.size());
+    ContiguousIterator out_it(
+        out_remaining_shape,
+        out_remaining_strides,
+        out_remaining_shape.size());
+    in_it.seek(r);
+    out_it.seek(r);
+    for (; r < end; r++) {
+      const T* data_ptr = in_ptr + in_it.loc;
+      IdxT* idx_ptr = out_ptr + out_it.loc;
+      in_it.step();
+      out_it.step();
+
+      StridedIterator st_(idx_ptr, out_stride, 0);
+      StridedIterator ed_(idx_ptr, out_stride, axis_size);
+
+      if constexpr (RadixKey<T>::enabled) {
+        if (axis_size >= radix_min_size) {
+          std::vector<typename RadixKey<T>::type> keys;
+          std::vector<IdxT> idx;
+          radix_keys(data_ptr, in_stride, axis_size, keys, idx);
+          std::vector<IdxT> part(axis_size);
+          radix_select(keys, idx, kth, part.data());
+          std::copy(part.begin(), part.end(), st_);
+          continue;
+        }
+      }
 
-  for (int i = 0; i < n_rows; i++) {
-    const T* data_ptr = in_ptr + in_it.loc;
-    IdxT* idx_ptr = out_ptr + out_it.loc;
-    in_it.step();
-    out_it.step();
-
-    StridedIterator st_(idx_ptr, out_stride, 0);
-    StridedIterator ed_(idx_ptr, out_stride, axis_size);
-
-    // Initialize with iota
-    std::iota(st_, ed_, IdxT(0));
+      // Initialize with iota
+      std::iota(st_, ed_, IdxT(0));
 
-    // Sort according to vals
-    StridedIterator st(idx_ptr, out_stride, 0);
-    StridedIterator md(idx_ptr, out_stride, kth);
-    StridedIterator ed(idx_ptr, out_stride, axis_size);
+      // Sort according to vals
+      StridedIterator st(idx_ptr, out_stride, 0);
+      StridedIterator md(idx_ptr, out_stride, kth);
+      StridedIterator ed(idx_ptr, out_stride, axis_size);
 
-    std::nth_element(st, md, ed, [data_ptr, in_stride](IdxT a, IdxT b) {
-      auto v1 = data_ptr[a * in_stride];
-      auto v2 = data_ptr[b * in_stride];
-      return v1 < v2 || (v1 == v2 && a < b);
-    });
-  }
+      std::nth_element(st, md, ed, [data_ptr, in_stride](IdxT a, IdxT b) {
+        auto v1 = data_ptr[a * in_stride];
+        auto v2 = data_ptr[b * in_stride];
+        return v1 < v2 || (v1 == v2 && a < b);
+      });
+    }
+  });
 }
 
 } // namespace
@@ -0,0 +1,154 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// The sums of the half types are accumulated in float.
+template <typename T>
+using acc_t = std::conditional_t<std::is_same_v<T, double>, double, float>;
+
+// out = a @ b for the sparse a of M rows, the rows of out are split across
+// the threads.
+template <typename T>
+void sparse_matmul(
+    const int32_t* indptr,
+    const int32_t* indices,
+    const T* values,
+    const T* b,
+    T* out,
+    size_t M,
+    size_t N) {
+  using AccT = acc_t<T>;
+  size_t nnz = indptr[M];
+  size_t row_work = std::max<size_t>(nnz * N / std::max<size_t>(M, 1), 1);
+  cpu::parallel_for(
+      M, cpu::min_parallel_size / row_work, [&](size_t begin, size_t end) {
+        std::vector<AccT> acc(N);
+        for (size_t i = begin; i < end; ++i) {
+          std::fill(acc.begin(), acc.end(), AccT(0));
+          for (int32_t j = indptr[i]; j < indptr[i + 1]; ++j) {
+            AccT v = static_cast<AccT>(values[j]);
+            const T* b_row = b + static_cast<int64_t>(indices[j]) * N;
+            for (size_t n = 0; n < N; ++n) {
+              acc[n] += v * static_cast<AccT>(b_row[n]);
+            }
+          }
+          T* out_row = out + i * N;
+          for (size_t n = 0; n < N; ++n) {
+            out_row[n] = static_cast<T>(acc[n]);
+          }
+        }
+      });
+}
+
+// out = a^T @ b for the sparse a of M rows, the columns of out are split
+// across the threads so that they scatter to different elements.
+template <typename T>
+void sparse_matmul_t(
+    const int32_t* indptr,
+    const int32_t* indices,
+    const T* values,
+    const T* b,
+    T* out,
+    size_t M,
+    size_t K,
+    size_t N) {
+  using AccT = acc_t<T>;
+  size_t nnz = indptr[M];
+  size_t column_work = std::max<size_t>(nnz, 1);
+  cpu::parallel_for(
+      N, cpu::min_parallel_size / column_work, [&](size_t begin, size_t end) {
+        size_t width = end - begin;
+        std::vector<AccT> acc(K * width, AccT(0));
+        for (size_t i = 0; i < M; ++i) {
+          const T* b_row = b + i * N + begin;
+          for (int32_t j = indptr[i]; j < indptr[i + 1]; ++j) {
+            AccT v = static_cast<AccT>(values[j]);
+            AccT* acc_row =
+                acc.data() + static_cast<int64_t>(indices[j]) * width;
+            for (size_t n = 0; n < width; ++n) {
+              acc_row[n] += v * static_cast<AccT>(b_row[n]);
+            }
+          }
+        }
+        for (size_t k = 0; k < K; ++k) {
+          for (size_t n = 0; n < width; ++n) {
+            out[k * N + begin + n] = static_cast<T>(acc[k * width + n]);
+          }
+        }
+      });
+}
+
+} // namespace
+
+void SparseMatmul::eval_cpu(const std::vector<array>& inputs, array& out) {
+  auto& encoder = cpu::get_command_encoder(stream());
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy(x.shape(), x.dtype(), nullptr, {});
+    copy_cpu(x, x_copy, CopyType::General, stream());
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  auto indptr = ensure_row_contiguous(inputs[0]);
+  auto indices = ensure_row_contiguous(inputs[1]);
+  auto values = ensure_row_contiguous(inputs[2]);
+  auto b = ensure_row_contiguous(inputs[3]);
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  encoder.set_input_array(indptr);
+  encoder.set_input_array(indices);
+  encoder.set_input_array(values);
+  encoder.set_input_array(b);
+  encoder.set_output_array(out);
+  size_t M = indptr.size() - 1;
+  size_t K = out.shape(0);
+  size_t N = out.shape(1);
+  auto run = [&](auto type_tag) {
+    using T = decltype(type_tag);
+    encoder.dispatch([indptr = indptr.data<int32_t>(),
+                      indices = indices.data<int32_t>(),
+                      values = values.data<T>(),
+                      b = b.data<T>(),
+                      out = out.data<T>(),
+                      transpose = transpose_,
+                      M,
+                      K,
+                      N]() {
+      if (transpose) {
+        sparse_matmul_t(indptr, indices, values, b, out, M, K, N);
+      } else {
+        sparse_matmul(indptr, indices, values, b, out, M, N);
+      }
+    });
+  };
+  switch (out.dtype()) {
+    case float32:
+      return run(float{});
+    case float64:
+      return run(double{});
+    case float16:
+      return run(float16_t{});
+    case bfloat16:
+      return run(bfloat16_t{});
+    default:
+      throw std::invalid_argument("[SparseMatmul::eval_cpu] Unsupported type.");
+  }
+}
+
+} // namespace mlx::core
@@ -0,0 +1,89 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cpu/stochastic_round.h"
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/backend/cpu/threefry.h"
+#include "mlx/fast_primitives.h"
+
+namespace mlx::core::fast {
+
+namespace {
+
+// Hash the counters of the key like RandomBits does, the counter j gives
+// the bits of the elements j and j + second.
+template <typename T>
+void stochastic_round(
+    const array& x,
+    const array& key,
+    array& out,
+    Stream stream) {
+  auto& encoder = cpu::get_command_encoder(stream);
+  encoder.set_input_array(x);
+  encoder.set_input_array(key);
+  encoder.set_output_array(out);
+
+  const T* x_ptr = x.data<T>();
+  const uint32_t* key_ptr = key.data<uint32_t>();
+  int64_t key_stride = key.strides()[0];
+  bfloat16_t* out_ptr = out.data<bfloat16_t>();
+  uint32_t size = x.size();
+  encoder.dispatch([x_ptr, key_ptr, key_stride, out_ptr, size]() {
+    auto k = std::make_pair(key_ptr[0], key_ptr[key_stride]);
+    uint32_t second = size / 2 + size % 2;
+    bool odd = size % 2;
+    // The hash costs tens of operations per pair of elements.
+    cpu::parallel_for(
+        second, cpu::min_parallel_size / 16, [&](size_t begin, size_t end) {
+          for (uint32_t j = begin; j < end; j++) {
+            bool drop_last = odd && j == second - 1;
+            auto [b0, b1] =
+                random::threefry2x32_hash(k, {j, drop_last ? 0 : j + second});
+            out_ptr[j] =
+                stochastic_round_bf16(static_cast<float>(x_ptr[j]), b0);
+            if (!drop_last) {
+              out_ptr[j + second] = stochastic_round_bf16(
+                  static_cast<float>(x_ptr[j + second]), b1);
+            }
+          }
+        });
+  });
+}
+
+} // namespace
+
+void StochasticRound::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto s = stream();
+  auto& encoder = cpu::get_command_encoder(s);
+  auto x = inputs[0];
+  if (!x.flags().row_contiguous) {
+    x = array(x.shape(), x.dtype(), nullptr, {});
+    copy_cpu(inputs[0], x, CopyType::General, s);
+    encoder.add_temporary(x);
+  }
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  switch (x.dtype()) {
+    case float32:
+      stochastic_round<float>(x, inputs[1], out, s);
+      break;
+    case float16:
+      stochastic_round<float16_t>(x, inputs[1], out, s);
+      break;
+    case float64:
+      stochastic_round<double>(x, inputs[1], out, s);
+      break;
+    default:
+      throw std::runtime_error(
+          "[stochastic_round] only supports float32, float16 and float64");
+  }
+}
+
+} // namespace mlx::core::fast
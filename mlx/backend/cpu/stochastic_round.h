@@ -0,0 +1,28 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "mlx/types/half_types.h"
+
+namespace mlx::core {
+
+// Round |x| to one of the two closest bfloat16 with the low 16 of the random
+// |bits|, the magnitude is rounded up with the probability of the fraction
+// truncated by the bfloat16.
+inline bfloat16_t stochastic_round_bf16(float x, uint32_t bits) {
+  if (std::isnan(x)) {
+    return bfloat16_t(x);
+  }
+  uint32_t u;
+  std::memcpy(&u, &x, sizeof(u));
+  u += bits & 0xFFFF;
+  bfloat16_t out;
+  out.bits_ = u >> 16;
+  return out;
+}
+
+} // namespace mlx::core
@@ -4,6 +4,7 @@
 #include "mlx/backend/cpu/copy.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/lapack.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -132,49 +133,57 @@ void svd_impl(
     }
 
     const int lwork = workspace_dimension;
-    auto scratch = array::Data{allocator::malloc(sizeof(T) * lwork)};
-
-    // Loop over matrices.
-    for (int i = 0; i < num_matrices; i++) {
-      gesvdx<T>(
-          /* jobu = */ job_u,
-          /* jobvt = */ job_vt,
-          /* range = */ range,
-          // M and N are swapped since lapack expects column-major.
-          /* m = */ &N,
-          /* n = */ &M,
-          /* a = */ in_ptr + M * N * i,
-          /* lda = */ &lda,
-          /* vl = */ &ignored_float,
-          /* vu = */ &ignored_float,
-          /* il = */ &ignored_int,
-          /* iu = */ &ignored_int,
-          /* ns = */ &ns,
-          /* s = */ s_ptr + K * i,
-          // According to the identity above, lapack will write Vᵀᵀ as U.
-          /* u = */ vt_ptr ? vt_ptr + N * N * i : nullptr,
-          /* ldu = */ &ldu,
-          // According to the identity above, lapack will write Uᵀ as Vᵀ.
-          /* vt = */ u_ptr ? u_ptr + M * M * i : nullptr,
-          /* ldvt = */ &ldvt,
-          /* work = */ static_cast<T*>(scratch.buffer.raw_ptr()),
-          /* lwork = */ &lwork,
-          /* iwork = */ static_cast<int*>(iwork.buffer.raw_ptr()),
-          /* info = */ &info);
-
-      if (info != 0) {
-        std::stringstream ss;
-        ss << "svd_impl: sgesvdx_ failed with code " << info;
-        throw std::runtime_error(ss.str());
-      }
 
-      if (ns != K) {
-        std::stringstream ss;
-        ss << "svd_impl: expected " << K << " singular values, but " << ns
-           << " were computed.";
-        throw std::runtime_error(ss.str());
+    // The matrices are split between the threads, each chunk with its own
+    // workspace.
+    size_t flops = std::max<size_t>(size_t(M) * N * K, 1);
+    size_t grain = std::max<size_t>(cpu::min_parallel_size / flops, 1);
+    cpu::parallel_for(num_matrices, grain, [&](size_t i, size_t end) {
+      auto scratch = array::Data{allocator::malloc(sizeof(T) * lwork)};
+      auto iwork = array::Data{allocator::malloc(sizeof(int) * 12 * K)};
+      int ns = 0;
+      int info;
+      for (; i < end; i++) {
+        gesvdx<T>(
+            /* jobu = */ job_u,
+            /* jobvt = */ job_vt,
+            /* range = */ range,
+            // M and N are swapped since lapack expects column-major.
+            /* m = */ &N,
+            /* n = */ &M,
+            /* a = */ in_ptr + size_t(M) * N * i,
+            /* lda = */ &lda,
+            /* vl = */ &ignored_float,
+            /* vu = */ &ignored_float,
+            /* il = */ &ignored_int,
+            /* iu = */ &ignored_int,
+            /* ns = */ &ns,
+            /* s = */ s_ptr + size_t(K) * i,
+            // According to the identity above, lapack will write Vᵀᵀ as U.
+            /* u = */ vt_ptr ? vt_ptr + size_t(N) * N * i : nullptr,
+            /* ldu = */ &ldu,
+            // According to the identity above, lapack will write Uᵀ as Vᵀ.
+            /* vt = */ u_ptr ? u_ptr + size_t(M) * M * i : nullptr,
+            /* ldvt = */ &ldvt,
+            /* work = */ static_cast<T*>(scratch.buffer.raw_ptr()),
+            /* lwork = */ &lwork,
+            /* iwork = */ static_cast<int*>(iwork.buffer.raw_ptr()),
+            /* info = */ &info);
+
+        if (info != 0) {
+          std::stringstream ss;
+          ss << "svd_impl: sgesvdx_ failed with code " << info;
+          throw std::runtime_error(ss.str());
+        }
+
+        if (ns != K) {
+          std::stringstream ss;
+          ss << "svd_impl: expected " << K << " singular values, but " << ns
+             << " were computed.";
+          throw std::runtime_error(ss.str());
+        }
       }
-    }
+    });
   });
   encoder.add_temporary(in);
 }
@@ -0,0 +1,165 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/backend/common/numa.h"
+#include "mlx/utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+
+namespace mlx::core::cpu {
+
+namespace {
+
+// The index of the calling thread in the pool, or -1.
+thread_local int thread_index = -1;
+
+} // namespace
+
+ThreadPool::ThreadPool(int num_threads) {
+  for (int i = 0; i < num_threads; ++i) {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.emplace_back(&ThreadPool::thread_fn, this, i);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard lk(mtx_);
+    stop_ = true;
+  }
+  cond_.notify_all();
+  for (auto& t : threads_) {
+    t.join();
+  }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+  int index = thread_index;
+  if (index < 0) {
+    std::lock_guard lk(mtx_);
+    index = next_++ % queues_.size();
+  }
+  {
+    std::lock_guard lk(queues_[index]->mtx);
+    queues_[index]->tasks.push_back(std::move(task));
+  }
+  {
+    std::lock_guard lk(mtx_);
+    pending_++;
+  }
+  cond_.notify_one();
+}
+
+bool ThreadPool::pop(int index, std::function<void()>& task) {
+  int n = queues_.size();
+  for (int i = 0; i < n; ++i) {
+    auto& q = *queues_[(index + i) % n];
+    std::lock_guard lk(q.mtx);
+    if (q.tasks.empty()) {
+      continue;
+    }
+    // The own tasks are the most recent, the stolen ones the oldest.
+    if (i == 0) {
+      task = std::move(q.tasks.back());
+      q.tasks.pop_back();
+    } else {
+      task = std::move(q.tasks.front());
+      q.tasks.pop_front();
+    }
+    return true;
+  }
+  return false;
+}
+
+void ThreadPool::thread_fn(int index) {
+  thread_index = index;
+  // Spread the threads evenly over the NUMA nodes.
+  if (numa::num_nodes() > 1) {
+    numa::bind_thread(index * numa::num_nodes() / queues_.size());
+  }
+  while (true) {
+    std::function<void()> task;
+    if (pop(index, task)) {
+      {
+        std::lock_guard lk(mtx_);
+        pending_--;
+      }
+      task();
+      continue;
+    }
+    std::unique_lock lk(mtx_);
+    cond_.wait(lk, [this] { return pending_ > 0 || stop_; });
+    if (stop_ && pending_ == 0) {
+      return;
+    }
+  }
+}
+
+ThreadPool& thread_pool() {
+  static ThreadPool pool(env::cpu_threads(
+      std::max<int>(std::thread::hardware_concurrency(), 1) - 1));
+  return pool;
+}
+
+void parallel_for(
+    size_t n,
+    size_t grain,
+    const std::function<void(size_t, size_t)>& f) {
+  auto& pool = thread_pool();
+  grain = std::max<size_t>(grain, 1);
+  size_t num_grains = (n + grain - 1) / grain;
+  // A few chunks per thread balance the chunks which run slower.
+  size_t num_chunks =
+      std::min(num_grains, static_cast<size_t>(4 * (pool.size() + 1)));
+  if (num_chunks <= 1) {
+    f(0, n);
+    return;
+  }
+  size_t chunk = (num_grains + num_chunks - 1) / num_chunks * grain;
+  num_chunks = (n + chunk - 1) / chunk;
+
+  struct Job {
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> done{0};
+    std::mutex mtx;
+    std::condition_variable cond;
+    std::exception_ptr error;
+  };
+  auto job = std::make_shared<Job>();
+  // The helpers which start after the last chunk is taken return without
+  // calling |f|, which is only valid until the chunks are done.
+  auto run_chunks = [job, &f, n, chunk, num_chunks]() {
+    size_t c;
+    while ((c = job->next++) < num_chunks) {
+      try {
+        f(c * chunk, std::min(n, (c + 1) * chunk));
+      } catch (...) {
+        std::lock_guard lk(job->mtx);
+        if (!job->error) {
+          job->error = std::current_exception();
+        }
+      }
+      if (++job->done == num_chunks) {
+        std::lock_guard lk(job->mtx);
+        job->cond.notify_all();
+      }
+    }
+  };
+  size_t num_helpers =
+      std::min(num_chunks - 1, static_cast<size_t>(pool.size()));
+  for (size_t i = 0; i < num_helpers; ++i) {
+    pool.submit(run_chunks);
+  }
+  run_chunks();
+  std::unique_lock lk(job->mtx);
+  job->cond.wait(lk, [&] { return job->done == num_chunks; });
+  if (job->error) {
+    std::rethrow_exception(job->error);
+  }
+}
+
+} // namespace mlx::core::cpu
@@ -0,0 +1,72 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace mlx::core::cpu {
+
+// The number of items below which the elementwise kernels are not split.
+constexpr size_t min_parallel_size = 1 << 16;
+
+// The threads running the chunks of work forked by the CPU kernels, shared
+// by all the CPU streams. Each thread has a deque of tasks, it runs the
+// tasks of its own deque from the back and steals from the front of the
+// others when it is empty. The tasks of a stream are still run in order by
+// the thread of the stream, which runs the chunks it forks along with the
+// pool and waits for them.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  int size() const {
+    return threads_.size();
+  }
+
+  // Run |task| on a thread of the pool, it is pushed to the deque of the
+  // calling thread when it is one of them.
+  void submit(std::function<void()> task);
+
+ private:
+  struct Queue {
+    std::mutex mtx;
+    std::deque<std::function<void()>> tasks;
+  };
+
+  bool pop(int index, std::function<void()>& task);
+  void thread_fn(int index);
+
+  std::vector<std::unique_ptr<Queue>> queues_;
+  std::vector<std::thread> threads_;
+  std::mutex mtx_;
+  std::condition_variable cond_;
+  // The tasks submitted and not yet taken from a deque.
+  int pending_{0};
+  unsigned next_{0};
+  bool stop_{false};
+};
+
+// The pool, with MLX_CPU_THREADS threads or one less than the number of
+// cores as the thread of the stream also runs the chunks.
+ThreadPool& thread_pool();
+
+// Call |f(begin, end)| on chunks of [0, |n|) in parallel, with the chunks
+// multiples of |grain| items except for the last. It returns once all the
+// chunks are done and rethrows the first exception of a chunk.
+void parallel_for(
+    size_t n,
+    size_t grain,
+    const std::function<void(size_t, size_t)>& f);
+
+} // namespace mlx::core::cpu
@@ -5,6 +5,8 @@
 #include <cstdint>
 #include <utility>
 
+#include "mlx/backend/cpu/simd/simd.h"
+
 namespace mlx::core::random {
 
 /** Applies the Threefry 2x32 hash function.
@@ -18,4 +20,49 @@ std::pair<uint32_t, uint32_t> threefry2x32_hash(
     const std::pair<uint32_t, uint32_t>& key,
     std::pair<uint32_t, uint32_t> count);
 
+/** Applies the Threefry 2x32 hash function to N counters at once, each lane
+ * of the result is the hash of the counter in the same lane.
+ */
+template <int N>
+std::pair<simd::Simd<uint32_t, N>, simd::Simd<uint32_t, N>> threefry2x32_hash(
+    const std::pair<uint32_t, uint32_t>& key,
+    std::pair<simd::Simd<uint32_t, N>, simd::Simd<uint32_t, N>> count) {
+  constexpr int rotations[2][4] = {{13, 15, 26, 6}, {17, 29, 16, 24}};
+
+  uint32_t ks[3] = {key.first, key.second, key.first ^ key.second ^ 0x1BD11BDA};
+
+  auto& [x0, x1] = count;
+  x0 = x0 + ks[0];
+  x1 = x1 + ks[1];
+
+  for (int i = 0; i < 5; ++i) {
+    for (auto r : rotations[i % 2]) {
+      x0 = x0 + x1;
+      x1 = (x1 << r) | (x1 >> (32 - r));
+      x1 = x1 ^ x0;
+    }
+    x0 = x0 + ks[(i + 1) % 3];
+    x1 = x1 + (ks[(i + 2) % 3] + i + 1);
+  }
+
+  return count;
+}
+
+/** The 32 random bits of the element |index| of the |size| elements which
+ * random::bits generates for |key|, the hash of the counter j gives the
+ * elements j and j + ceil(size / 2).
+ */
+inline uint32_t bits_at(
+    const std::pair<uint32_t, uint32_t>& key,
+    uint32_t index,
+    uint32_t size) {
+  uint32_t second = size / 2 + size % 2;
+  if (index < second) {
+    bool drop_last = (size % 2) && index == second - 1;
+    return threefry2x32_hash(key, {index, drop_last ? 0 : index + second})
+        .first;
+  }
+  return threefry2x32_hash(key, {index - second, index}).second;
+}
+
 } // namespace mlx::core::random
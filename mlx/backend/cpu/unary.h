@@ -5,6 +5,7 @@
 #include "mlx/backend/common/unary.h"
 #include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
 #include "mlx/utils.h"
 
 namespace mlx::core {
@@ -23,20 +24,25 @@ void unary_op(const array& a, array& out, Op) {
   U* dst = out.data<U>();
   auto ndim = a.ndim();
   if (a.flags().contiguous) {
-    auto size = a.data_size();
-    constexpr int N = simd::max_size<T>;
-    while (size >= N) {
-      simd::store(dst, Op{}(simd::load<T, N>(src)));
-      size -= N;
-      src += N;
-      dst += N;
-    }
-    while (size > 0) {
-      *dst = Op{}(*src);
-      size--;
-      dst++;
-      src++;
-    }
+    cpu::parallel_for(
+        a.data_size(), cpu::min_parallel_size, [&](size_t i, size_t end) {
+          auto size = end - i;
+          auto src_i = src + i;
+          auto dst_i = dst + i;
+          constexpr int N = simd::max_size<T>;
+          while (size >= N) {
+            simd::store(dst_i, Op{}(simd::load<T, N>(src_i)));
+            size -= N;
+            src_i += N;
+            dst_i += N;
+          }
+          while (size > 0) {
+            *dst_i = Op{}(*src_i);
+            size--;
+            dst_i++;
+            src_i++;
+          }
+        });
   } else {
     size_t shape = ndim > 0 ? a.shape().back() : 1;
     size_t stride = ndim > 0 ? a.strides().back() : 1;
@@ -0,0 +1,103 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <type_traits>
+#include <vector>
+
+#include "mlx/backend/cpu/copy.h"
+#include "mlx/backend/cpu/encoder.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+namespace mlx::core {
+
+namespace {
+
+// Sort the positions of |x| by value, with the NaNs last so that the order
+// is strict weak, and write the first value of each run of equal values.
+// The rest of |values| repeats the last one with a count of 0.
+template <typename T>
+void unique(
+    const T* x,
+    T* values,
+    int32_t* num_unique,
+    int32_t* inverse,
+    int32_t* counts,
+    int32_t size) {
+  std::vector<int32_t> perm(size);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::stable_sort(perm.begin(), perm.end(), [x](int32_t a, int32_t b) {
+    if constexpr (std::is_floating_point_v<T>) {
+      return x[a] < x[b] || (!std::isnan(x[a]) && std::isnan(x[b]));
+    } else if constexpr (!std::is_integral_v<T>) {
+      float xa = static_cast<float>(x[a]);
+      float xb = static_cast<float>(x[b]);
+      return xa < xb || (!std::isnan(xa) && std::isnan(xb));
+    } else {
+      return x[a] < x[b];
+    }
+  });
+
+  int32_t k = -1;
+  for (int32_t i = 0; i < size; ++i) {
+    int32_t p = perm[i];
+    if (i == 0 || !(x[p] == x[perm[i - 1]])) {
+      values[++k] = x[p];
+      if (counts) {
+        counts[k] = 0;
+      }
+    }
+    if (counts) {
+      counts[k]++;
+    }
+    if (inverse) {
+      inverse[p] = k;
+    }
+  }
+  *num_unique = k + 1;
+  std::fill(values + k + 1, values + size, values[k]);
+  if (counts) {
+    std::fill(counts + k + 1, counts + size, 0);
+  }
+}
+
+} // namespace
+
+void Unique::eval_cpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  auto& encoder = cpu::get_command_encoder(stream());
+  auto in = inputs[0];
+  if (!in.flags().row_contiguous) {
+    array in_copy(in.shape(), in.dtype(), nullptr, {});
+    copy_cpu(in, in_copy, CopyType::General, stream());
+    encoder.add_temporary(in_copy);
+    in = in_copy;
+  }
+  encoder.set_input_array(in);
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    encoder.set_output_array(out);
+  }
+  int32_t* inverse = return_inverse_ ? outputs[2].data<int32_t>() : nullptr;
+  int32_t* counts = return_counts_ ? outputs.back().data<int32_t>() : nullptr;
+  dispatch_all_types(in.dtype(), [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    if constexpr (std::is_same_v<T, complex64_t>) {
+      throw std::invalid_argument("[Unique::eval_cpu] Unsupported type.");
+    } else {
+      encoder.dispatch([x = in.data<T>(),
+                        values = outputs[0].data<T>(),
+                        num_unique = outputs[1].data<int32_t>(),
+                        inverse,
+                        counts,
+                        size = static_cast<int32_t>(in.size())]() {
+        unique(x, values, num_unique, inverse, counts, size);
+      });
+    }
+  });
+}
+
+} // namespace mlx::core
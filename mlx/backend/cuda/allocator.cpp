@@ -1,14 +1,18 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/l2_persistence.h"
+#include "mlx/backend/cuda/memory_tracer.h"
 #include "mlx/backend/cuda/utils.h"
 #include "mlx/backend/cuda/worker.h"
+#include "mlx/memory.h"
 #include "mlx/utils.h"
 
 #include <cuda_runtime.h>
 #include <fmt/format.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace mlx::core {
@@ -17,71 +21,331 @@ namespace cu {
 
 constexpr int page_size = 16384;
 
-// Any allocations smaller than this will try to use the small pool
+// The smallest size of an allocation.
 constexpr int small_block_size = 8;
 
-// The small pool size in bytes. This should be a multiple of the host page
-// size and small_block_size.
-constexpr int small_pool_size = 4 * page_size;
+// The size of the slabs of the small pool. This should be a multiple of the
+// host page size.
+constexpr int slab_size = 64 * page_size;
 
-SmallSizePool::SmallSizePool() {
-  CHECK_CUDA_ERROR(cudaMallocManaged(&buffer_, small_pool_size));
-  end_ = reinterpret_cast<void*>(
-      reinterpret_cast<char*>(buffer_) + small_pool_size);
-  next_free_ = reinterpret_cast<Block*>(buffer_);
+namespace {
 
-  auto num_blocks = small_pool_size / small_block_size;
-  auto curr = next_free_;
-  for (size_t i = 0; i < num_blocks - 1; ++i) {
-    curr->next = reinterpret_cast<Block*>(
-        reinterpret_cast<char*>(buffer_) + (i + 1) * small_block_size);
-    curr = curr->next;
+// The size class of a power of 2 size of at most a page.
+int size_class(size_t size) {
+  int c = 0;
+  while ((small_block_size << c) < size) {
+    ++c;
   }
-  curr->next = nullptr;
+  return c;
 }
 
+} // namespace
+
 SmallSizePool::~SmallSizePool() {
-  CHECK_CUDA_ERROR(cudaFree(buffer_));
+  for (auto& [base, slab] : slabs_) {
+    CHECK_CUDA_ERROR(cudaFree(base));
+  }
 }
 
-void* SmallSizePool::malloc() {
-  if (next_free_ == nullptr) {
-    return nullptr;
+SmallSizePool::Slab& SmallSizePool::slab_of(void* p) {
+  auto it = slabs_.upper_bound(static_cast<char*>(p));
+  return std::prev(it)->second;
+}
+
+void* SmallSizePool::malloc(size_t size) {
+  std::lock_guard lock(mutex_);
+  int c = size_class(size);
+  if (Block* b = free_lists_[c]) {
+    free_lists_[c] = b->next;
+    slab_of(b).used++;
+    return b;
+  }
+
+  // Take the next block of the last slab, or of a new one when it is full.
+  char* base = current_[c];
+  if (!base || slabs_[base].top + size > slab_size) {
+    void* slab_ptr;
+    if (cudaMallocManaged(&slab_ptr, slab_size) != cudaSuccess) {
+      // Clear the error and let the caller allocate the buffer on its own.
+      cudaGetLastError();
+      return nullptr;
+    }
+    base = static_cast<char*>(slab_ptr);
+    current_[c] = base;
+    slabs_.emplace(base, Slab{size, 0, 0});
   }
-  Block* b = next_free_;
-  next_free_ = next_free_->next;
-  return static_cast<void*>(b);
+  auto& slab = slabs_[base];
+  void* p = base + slab.top;
+  slab.top += size;
+  slab.used++;
+  return p;
 }
 
 void SmallSizePool::free(void* p) {
+  std::lock_guard lock(mutex_);
+  auto& slab = slab_of(p);
+  slab.used--;
+  int c = size_class(slab.block_size);
   auto b = static_cast<Block*>(p);
-  b->next = next_free_;
-  next_free_ = b;
+  b->next = free_lists_[c];
+  free_lists_[c] = b;
 }
 
 bool SmallSizePool::in_pool(void* p) {
-  return (p >= buffer_) && (p < end_);
+  std::lock_guard lock(mutex_);
+  auto it = slabs_.upper_bound(static_cast<char*>(p));
+  if (it == slabs_.begin()) {
+    return false;
+  }
+  --it;
+  return p < it->first + slab_size;
+}
+
+void SmallSizePool::trim() {
+  std::lock_guard lock(mutex_);
+  // Unlink the blocks of the empty slabs from the free lists first.
+  for (auto& head : free_lists_) {
+    Block** link = &head;
+    while (*link) {
+      if (slab_of(*link).used == 0) {
+        *link = (*link)->next;
+      } else {
+        link = &(*link)->next;
+      }
+    }
+  }
+  for (auto it = slabs_.begin(); it != slabs_.end();) {
+    auto& [base, slab] = *it;
+    if (slab.used > 0) {
+      ++it;
+      continue;
+    }
+    int c = size_class(slab.block_size);
+    if (current_[c] == base) {
+      current_[c] = nullptr;
+    }
+    CHECK_CUDA_ERROR(cudaFree(base));
+    it = slabs_.erase(it);
+  }
+}
+
+namespace {
+
+void update_peak(std::atomic<size_t>& peak, size_t value) {
+  size_t current = peak.load();
+  while (current < value && !peak.compare_exchange_weak(current, value)) {
+  }
+}
+
+// The properties of the physical memory of |device| mapped in the virtual
+// ranges.
+CUmemAllocationProp device_allocation_prop(int device) {
+  CUmemAllocationProp prop = {};
+  prop.type = CU_MEM_ALLOCATION_TYPE_PINNED;
+  prop.location.type = CU_MEM_LOCATION_TYPE_DEVICE;
+  prop.location.id = device;
+  return prop;
+}
+
+// Releases the cache of a thread when the thread exits.
+struct ThreadCacheOwner {
+  ThreadCache* cache{nullptr};
+
+  ~ThreadCacheOwner() {
+    if (cache) {
+      allocator().release_thread_cache(cache);
+    }
+  }
+};
+
+// The trace or plan of the allocations of a thread recording a step, and
+// the stream of the kernels it encodes.
+struct StepAllocations {
+  std::vector<std::pair<CudaBuffer*, size_t>>* trace{nullptr};
+  MemoryPlan* plan{nullptr};
+  cudaStream_t stream{nullptr};
+};
+
+StepAllocations& step_allocations() {
+  thread_local StepAllocations step;
+  return step;
 }
 
-CudaAllocator::CudaAllocator()
-    : buffer_cache_(
+// The alignment of the slots of an arena.
+constexpr size_t slot_alignment = 256;
+
+} // namespace
+
+MemoryPlan::MemoryPlan(
+    std::vector<size_t> sizes,
+    std::vector<int> slot_of,
+    const std::vector<size_t>& slot_sizes)
+    : sizes_(std::move(sizes)), slot_of_(std::move(slot_of)) {
+  std::vector<size_t> offsets;
+  for (auto size : slot_sizes) {
+    offsets.push_back(arena_size_);
+    arena_size_ +=
+        (size + slot_alignment - 1) / slot_alignment * slot_alignment;
+  }
+  if (arena_size_ == 0) {
+    return;
+  }
+  arena_ = allocator().malloc(arena_size_);
+  auto* arena = static_cast<CudaBuffer*>(arena_.ptr());
+  for (size_t i = 0; i < slot_sizes.size(); ++i) {
+    slots_.emplace_back(new CudaBuffer{
+        static_cast<char*>(arena->data) + offsets[i],
+        slot_sizes[i],
+        arena->device});
+    slots_.back()->planned = true;
+  }
+}
+
+MemoryPlan::~MemoryPlan() {
+  allocator().free(arena_);
+}
+
+CudaBuffer* MemoryPlan::next(size_t size) {
+  if (diverged_ || next_ >= sizes_.size() || sizes_[next_] != size) {
+    diverged_ = true;
+    return nullptr;
+  }
+  int slot = slot_of_[next_++];
+  return slot < 0 ? nullptr : slots_[slot].get();
+}
+
+CudaBuffer* ThreadCache::pop(size_t size, int device) {
+  std::lock_guard lock(mutex_);
+  if (device >= devices_.size()) {
+    return nullptr;
+  }
+  auto& c = devices_[device][size_class(size)];
+  if (c.count == 0) {
+    return nullptr;
+  }
+  return c.buffers[--c.count];
+}
+
+int ThreadCache::push(
+    CudaBuffer* buf,
+    std::array<CudaBuffer*, capacity / 2>& overflow) {
+  std::lock_guard lock(mutex_);
+  if (buf->device >= devices_.size()) {
+    devices_.resize(buf->device + 1);
+  }
+  auto& c = devices_[buf->device][size_class(buf->size)];
+  int n = 0;
+  if (c.count == capacity) {
+    // Give back the least recently cached half.
+    n = capacity / 2;
+    std::copy(c.buffers.begin(), c.buffers.begin() + n, overflow.begin());
+    std::copy(c.buffers.begin() + n, c.buffers.end(), c.buffers.begin());
+    c.count -= n;
+  }
+  c.buffers[c.count++] = buf;
+  return n;
+}
+
+void ThreadCache::drain(int device, std::vector<CudaBuffer*>& buffers) {
+  std::lock_guard lock(mutex_);
+  for (int d = 0; d < devices_.size(); ++d) {
+    if (device != -1 && d != device) {
+      continue;
+    }
+    for (auto& c : devices_[d]) {
+      buffers.insert(
+          buffers.end(), c.buffers.begin(), c.buffers.begin() + c.count);
+      c.count = 0;
+    }
+  }
+}
+
+DeviceMemory::DeviceMemory(
+    int device,
+    std::function<void(CudaBuffer*)> free)
+    : buffer_cache(
           page_size,
           [](CudaBuffer* buf) { return buf->size; },
-          [this](CudaBuffer* buf) {
-            cuda_free(buf->data);
-            delete buf;
-          }) {
-  // TODO: Set memory limit for multi-device.
-  size_t free, total;
-  CHECK_CUDA_ERROR(cudaMemGetInfo(&free, &total));
-  memory_limit_ = total * 0.8;
-  max_pool_size_ = memory_limit_;
+          std::move(free),
+          env::max_cache_overallocation() / 100.0) {
+  int current;
+  CHECK_CUDA_ERROR(cudaGetDevice(&current));
+  CHECK_CUDA_ERROR(cudaSetDevice(device));
+  size_t free_memory, total;
+  CHECK_CUDA_ERROR(cudaMemGetInfo(&free_memory, &total));
+  memory_limit = total * 0.8;
+  max_pool_size = memory_limit;
+
+  if (env::get_var("MLX_CUDA_USE_MEMORY_POOL", 0)) {
+    cudaMemPoolProps props = {};
+    props.allocType = cudaMemAllocationTypePinned;
+    props.location.type = cudaMemLocationTypeDevice;
+    props.location.id = device;
+    CHECK_CUDA_ERROR(cudaMemPoolCreate(&memory_pool, &props));
+    // Keep the freed memory in the pool up to the memory limit instead of
+    // releasing it at each synchronization.
+    uint64_t threshold = memory_limit;
+    CHECK_CUDA_ERROR(cudaMemPoolSetAttribute(
+        memory_pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+    CHECK_CUDA_ERROR(
+        cudaStreamCreateWithFlags(&pool_stream, cudaStreamNonBlocking));
+
+    // Let the peers of the device access the memory of the pool.
+    int device_count;
+    CHECK_CUDA_ERROR(cudaGetDeviceCount(&device_count));
+    for (int peer = 0; peer < device_count; ++peer) {
+      int can_access = 0;
+      CHECK_CUDA_ERROR(cudaDeviceCanAccessPeer(&can_access, peer, device));
+      if (peer != device && can_access) {
+        cudaMemAccessDesc desc = {};
+        desc.location.type = cudaMemLocationTypeDevice;
+        desc.location.id = peer;
+        desc.flags = cudaMemAccessFlagsProtReadWrite;
+        CHECK_CUDA_ERROR(cudaMemPoolSetAccess(memory_pool, &desc, 1));
+      }
+    }
+  }
+  CHECK_CUDA_ERROR(cudaSetDevice(current));
+}
+
+CudaAllocator::CudaAllocator() {
+  int count;
+  CHECK_CUDA_ERROR(cudaGetDeviceCount(&count));
+  devices_.resize(count);
+}
+
+DeviceMemory& CudaAllocator::device_memory(int device) {
+  if (device < 0 || device >= devices_.size()) {
+    throw std::invalid_argument(
+        fmt::format("[CudaAllocator] Invalid device {}.", device));
+  }
+  // Created on first use so only the devices being used are initialized.
+  auto& memory = devices_[device];
+  if (!memory) {
+    memory = std::make_unique<DeviceMemory>(
+        device, [this](CudaBuffer* buf) { cuda_free(buf); });
+  }
+  return *memory;
 }
 
 Buffer CudaAllocator::malloc(size_t size) {
-  // Find available buffer from cache.
-  auto orig_size = size;
-  std::unique_lock lock(mutex_);
+  auto& step = step_allocations();
+  if (step.plan) {
+    if (auto* buf = step.plan->next(size)) {
+      return Buffer{buf};
+    }
+  }
+  auto buffer = allocate(size);
+  if (step.trace) {
+    step.trace->emplace_back(static_cast<CudaBuffer*>(buffer.ptr()), size);
+  }
+  return buffer;
+}
+
+Buffer CudaAllocator::allocate(size_t size) {
+  int device;
+  CHECK_CUDA_ERROR(cudaGetDevice(&device));
+
   if (size <= small_block_size) {
     size = 8;
   } else if (size < page_size) {
@@ -90,57 +354,161 @@ Buffer CudaAllocator::malloc(size_t size) {
     size = page_size * ((size + page_size - 1) / page_size);
   }
 
-  CudaBuffer* buf = buffer_cache_.reuse_from_cache(size);
-  if (!buf) {
+  // Find available buffer from the cache of the thread, which does not need
+  // the lock, and then from the cache of the device.
+  CudaBuffer* buf = nullptr;
+  if (size < page_size) {
+    buf = thread_cache().pop(size, device);
+  }
+  if (buf) {
+    buf->location = cudaInvalidDeviceId;
+    auto& memory = *devices_[device];
+    memory.thread_cache_size -= size;
+    memory.thread_cache_hits++;
+    memory.thread_cache_hit_bytes += size;
+    memory.active_memory += size;
+    update_peak(memory.peak_memory, memory.active_memory);
+    update_peak(peak_memory_, active_memory_ += size);
+    if (auto& tracer = memory_tracer(); tracer.enabled()) {
+      tracer.on_malloc(buf, size, device);
+    }
+    return Buffer{buf};
+  }
+
+  std::unique_lock lock(mutex_);
+  auto& memory = device_memory(device);
+  buf = memory.buffer_cache.reuse_from_cache(size);
+  if (buf) {
+    // The next writer may be the host.
+    buf->location = cudaInvalidDeviceId;
+  } else {
     // If we have a lot of memory pressure or are over the maximum cache size,
     // try to reclaim memory from the cache.
-    size_t mem_required = get_active_memory() + get_cache_memory() + size;
-    if (mem_required >= memory_limit_) {
-      buffer_cache_.release_cached_buffers(mem_required - memory_limit_);
+    size_t mem_required =
+        memory.active_memory + memory.buffer_cache.cache_size() + size;
+    if (mem_required >= memory.memory_limit) {
+      memory.buffer_cache.release_cached_buffers(
+          mem_required - memory.memory_limit);
     }
 
     lock.unlock();
-    buf = new CudaBuffer{nullptr, size};
-
-    // Try the scalar pool first
-    if (size <= small_block_size) {
-      buf->data = scalar_pool_.malloc();
+    buf = new CudaBuffer{nullptr, size, device};
+    auto try_allocate = [&]() {
+      // Try the small pool first
+      if (size <= page_size) {
+        buf->data = small_pool_.malloc(size);
+      }
+      if (!buf->data && memory.memory_pool) {
+        // The kernels using the buffer come after the allocation on their
+        // stream, so it is not waited for. Outside the evaluation of the
+        // primitives, or while the stream is captured, it is allocated on
+        // |pool_stream| which only has allocations and frees to wait for.
+        cudaStream_t stream = step_allocations().stream;
+        cudaStreamCaptureStatus status = cudaStreamCaptureStatusNone;
+        if (stream) {
+          CHECK_CUDA_ERROR(cudaStreamIsCapturing(stream, &status));
+        }
+        bool ordered = stream && status == cudaStreamCaptureStatusNone;
+        buf->stream = ordered ? stream : memory.pool_stream;
+        cudaError_t err = cudaMallocFromPoolAsync(
+            &buf->data, size, memory.memory_pool, buf->stream);
+        if (err == cudaSuccess && !ordered) {
+          err = cudaStreamSynchronize(memory.pool_stream);
+        }
+        if (err != cudaSuccess && err != cudaErrorMemoryAllocation) {
+          throw std::runtime_error(fmt::format(
+              "cudaMallocFromPoolAsync failed: {}.", cudaGetErrorString(err)));
+        }
+      } else if (!buf->data) {
+        cudaError_t err = cudaMallocManaged(&buf->data, size);
+        if (err != cudaSuccess && err != cudaErrorMemoryAllocation) {
+          throw std::runtime_error(fmt::format(
+              "cudaMallocManaged failed: {}.", cudaGetErrorString(err)));
+        }
+      }
+    };
+    try_allocate();
+    if (!buf->data) {
+      // Release all the cached buffers and try again before failing.
+      drain_thread_caches(device);
+      lock.lock();
+      memory.buffer_cache.release_cached_buffers(
+          memory.buffer_cache.cache_size());
+      lock.unlock();
+      small_pool_.trim();
+      try_allocate();
     }
     if (!buf->data) {
-      cudaError_t err = cudaMallocManaged(&buf->data, size);
-      if (err != cudaSuccess && err != cudaErrorMemoryAllocation) {
-        throw std::runtime_error(fmt::format(
-            "cudaMallocManaged failed: {}.", cudaGetErrorString(err)));
-      }
+      delete buf;
+      throw std::runtime_error(
+          fmt::format("[malloc] Unable to allocate {} bytes.", size));
     }
 
     lock.lock();
   }
-  active_memory_ += size;
-  peak_memory_ = std::max(active_memory_, peak_memory_);
+  memory.active_memory += size;
+  update_peak(memory.peak_memory, memory.active_memory);
+  update_peak(peak_memory_, active_memory_ += size);
 
   // Maintain the cache below the requested limit.
-  if (get_cache_memory() > max_pool_size_) {
-    buffer_cache_.release_cached_buffers(get_cache_memory() - max_pool_size_);
+  if (memory.buffer_cache.cache_size() > memory.max_pool_size) {
+    memory.buffer_cache.release_cached_buffers(
+        memory.buffer_cache.cache_size() - memory.max_pool_size);
   }
+  lock.unlock();
 
+  if (auto& tracer = memory_tracer(); tracer.enabled()) {
+    tracer.on_malloc(buf, size, device);
+  }
   return Buffer{buf};
 }
 
 void CudaAllocator::free(Buffer buffer) {
   auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
-  if (!buf) {
+  if (!buf || buf->planned || buf->foreign) {
+    return;
+  }
+  if (buf->l2_persisting || buf->l2_reads > 0) {
+    l2_persistence().on_free(buf);
+  }
+  if (buf->range) {
+    devices_[buf->device]->active_memory -= buf->size;
+    active_memory_ -= buf->size;
+    release_range(buf);
     return;
   }
+  if (auto& tracer = memory_tracer(); tracer.enabled()) {
+    tracer.on_free(buf);
+  }
 
-  std::unique_lock lock(mutex_);
+  if (buf->read_mostly) {
+    CHECK_CUDA_ERROR(mem_advise(
+        buf->data, buf->size, cudaMemAdviseUnsetReadMostly, cudaCpuDeviceId));
+    buf->read_mostly = false;
+  }
+
+  auto& memory = *devices_[buf->device];
+  memory.active_memory -= buf->size;
   active_memory_ -= buf->size;
-  if (get_cache_memory() < max_pool_size_) {
-    buffer_cache_.recycle_to_cache(buf);
+
+  // Keep the small buffers in the cache of the thread unless the caching is
+  // disabled, and only take the lock for the buffers which do not fit.
+  if (buf->size < page_size && memory.max_pool_size > 0) {
+    std::array<CudaBuffer*, ThreadCache::capacity / 2> overflow;
+    memory.thread_cache_size += buf->size;
+    int n = thread_cache().push(buf, overflow);
+    if (n > 0) {
+      recycle(overflow.data(), n);
+    }
+    return;
+  }
+
+  std::unique_lock lock(mutex_);
+  if (memory.buffer_cache.cache_size() < memory.max_pool_size) {
+    memory.buffer_cache.recycle_to_cache(buf);
   } else {
     lock.unlock();
-    cuda_free(buf->data);
-    delete buf;
+    cuda_free(buf);
   }
 }
 
@@ -152,33 +520,243 @@ size_t CudaAllocator::size(Buffer buffer) const {
   return buf->size;
 }
 
+ThreadCache& CudaAllocator::thread_cache() {
+  thread_local ThreadCacheOwner owner;
+  if (!owner.cache) {
+    owner.cache = new ThreadCache;
+    std::lock_guard lock(thread_caches_mutex_);
+    thread_caches_.insert(owner.cache);
+  }
+  return *owner.cache;
+}
+
+void CudaAllocator::release_thread_cache(ThreadCache* cache) {
+  {
+    std::lock_guard lock(thread_caches_mutex_);
+    thread_caches_.erase(cache);
+  }
+  std::vector<CudaBuffer*> buffers;
+  cache->drain(-1, buffers);
+  delete cache;
+  recycle(buffers.data(), buffers.size());
+}
+
+void CudaAllocator::drain_thread_caches(int device) {
+  std::vector<CudaBuffer*> buffers;
+  {
+    std::lock_guard lock(thread_caches_mutex_);
+    for (auto* cache : thread_caches_) {
+      cache->drain(device, buffers);
+    }
+  }
+  recycle(buffers.data(), buffers.size());
+}
+
+void CudaAllocator::recycle(CudaBuffer** buffers, size_t n) {
+  size_t n_free = 0;
+  {
+    std::lock_guard lock(mutex_);
+    for (size_t i = 0; i < n; ++i) {
+      auto& memory = *devices_[buffers[i]->device];
+      memory.thread_cache_size -= buffers[i]->size;
+      if (memory.buffer_cache.cache_size() < memory.max_pool_size) {
+        memory.buffer_cache.recycle_to_cache(buffers[i]);
+      } else {
+        buffers[n_free++] = buffers[i];
+      }
+    }
+  }
+  for (size_t i = 0; i < n_free; ++i) {
+    cuda_free(buffers[i]);
+  }
+}
+
+void CudaAllocator::set_trace(
+    std::vector<std::pair<CudaBuffer*, size_t>>* trace) {
+  step_allocations().trace = trace;
+}
+
+void CudaAllocator::set_plan(MemoryPlan* plan) {
+  step_allocations().plan = plan;
+}
+
+void CudaAllocator::set_stream(cudaStream_t stream) {
+  step_allocations().stream = stream;
+}
+
 void CudaAllocator::register_this_thread() {
   std::lock_guard lock(worker_mutex_);
   allowed_threads_.insert(std::this_thread::get_id());
 }
 
+void CudaAllocator::cuda_free(CudaBuffer* buf) {
+  // Freeing to the memory pool is ordered on the stream of the allocation
+  // and does not synchronize, so it can happen in any thread. The buffers
+  // are only freed once the kernels using them finished.
+  auto& memory = *devices_[buf->device];
+  if (memory.memory_pool && !small_pool_.in_pool(buf->data)) {
+    CHECK_CUDA_ERROR(cudaFreeAsync(buf->data, buf->stream));
+  } else {
+    cuda_free(buf->data);
+  }
+  delete buf;
+}
+
 void CudaAllocator::cuda_free(void* buf) {
   // If cuda_free() is called from a unregistered thread, reschedule the call to
   // worker.
-  {
-    std::lock_guard lock(worker_mutex_);
-    if (allowed_threads_.count(std::this_thread::get_id()) == 0) {
-      if (!worker_) {
-        worker_.reset(new Worker);
-      }
-      worker_->add_task([this, buf]() { this->cuda_free(buf); });
-      worker_->end_batch();
-      worker_->commit();
-      return;
-    }
+  if (defer_free([this, buf]() { this->cuda_free(buf); })) {
+    return;
   }
-  if (scalar_pool_.in_pool(buf)) {
-    scalar_pool_.free(buf);
+  if (small_pool_.in_pool(buf)) {
+    small_pool_.free(buf);
   } else {
     cudaFree(buf);
   }
 }
 
+bool CudaAllocator::defer_free(std::function<void()> task) {
+  std::lock_guard lock(worker_mutex_);
+  if (allowed_threads_.count(std::this_thread::get_id()) > 0) {
+    return false;
+  }
+  if (!worker_) {
+    worker_.reset(new Worker);
+  }
+  worker_->add_task(std::move(task));
+  worker_->end_batch();
+  worker_->commit();
+  return true;
+}
+
+Buffer CudaAllocator::reserve(size_t size) {
+  int device;
+  CHECK_CUDA_ERROR(cudaGetDevice(&device));
+  {
+    std::lock_guard lock(mutex_);
+    device_memory(device);
+  }
+  auto prop = device_allocation_prop(device);
+  size_t granularity;
+  CHECK_CUDA_ERROR(cuMemGetAllocationGranularity(
+      &granularity, &prop, CU_MEM_ALLOC_GRANULARITY_RECOMMENDED));
+  size = std::max<size_t>(
+      granularity * ((size + granularity - 1) / granularity), granularity);
+  CUdeviceptr ptr;
+  CHECK_CUDA_ERROR(cuMemAddressReserve(&ptr, size, 0, 0, 0));
+  auto* buf = new CudaBuffer{reinterpret_cast<void*>(ptr), 0, device, device};
+  buf->range = new VirtualRange{size, granularity, {}};
+  return Buffer{buf};
+}
+
+void CudaAllocator::grow(Buffer buffer, size_t size) {
+  auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+  auto& range = *buf->range;
+  if (size <= buf->size) {
+    return;
+  }
+  if (size > range.reserved) {
+    throw std::invalid_argument(fmt::format(
+        "[CudaAllocator::grow] Can not grow to {} bytes, only {} are "
+        "reserved.",
+        size,
+        range.reserved));
+  }
+  size_t mapped = range.granularity *
+      ((size + range.granularity - 1) / range.granularity);
+  size_t chunk = mapped - buf->size;
+
+  auto& memory = *devices_[buf->device];
+  {
+    std::lock_guard lock(mutex_);
+    size_t mem_required =
+        memory.active_memory + memory.buffer_cache.cache_size() + chunk;
+    if (mem_required >= memory.memory_limit) {
+      memory.buffer_cache.release_cached_buffers(
+          mem_required - memory.memory_limit);
+    }
+  }
+  auto prop = device_allocation_prop(buf->device);
+  CUmemGenericAllocationHandle handle;
+  CHECK_CUDA_ERROR(cuMemCreate(&handle, chunk, &prop, 0));
+  auto ptr = reinterpret_cast<CUdeviceptr>(buf->data) + buf->size;
+  CHECK_CUDA_ERROR(cuMemMap(ptr, chunk, 0, handle, 0));
+  range.handles.push_back(handle);
+  CUmemAccessDesc access = {};
+  access.location = prop.location;
+  access.flags = CU_MEM_ACCESS_FLAGS_PROT_READWRITE;
+  CHECK_CUDA_ERROR(cuMemSetAccess(ptr, chunk, &access, 1));
+
+  buf->size = mapped;
+  memory.active_memory += chunk;
+  update_peak(memory.peak_memory, memory.active_memory);
+  update_peak(peak_memory_, active_memory_ += chunk);
+}
+
+void CudaAllocator::release_range(CudaBuffer* buf) {
+  // Released in a safe thread like the memory of cudaFree.
+  if (defer_free([this, buf]() { release_range(buf); })) {
+    return;
+  }
+  auto ptr = reinterpret_cast<CUdeviceptr>(buf->data);
+  if (buf->size > 0) {
+    CHECK_CUDA_ERROR(cuMemUnmap(ptr, buf->size));
+  }
+  for (auto handle : buf->range->handles) {
+    CHECK_CUDA_ERROR(cuMemRelease(handle));
+  }
+  CHECK_CUDA_ERROR(cuMemAddressFree(ptr, buf->range->reserved));
+  delete buf->range;
+  delete buf;
+}
+
+int CudaAllocator::device_of(Buffer buffer) {
+  auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+  if (buf && buf->foreign && buf->location == cudaCpuDeviceId) {
+    // The host copies of readable_by_host.
+    return -1;
+  }
+  if (buf && (buf->foreign || buf->range)) {
+    return buf->device;
+  }
+  if (!buf || !devices_[buf->device]->memory_pool ||
+      small_pool_.in_pool(buf->data)) {
+    return -1;
+  }
+  return buf->device;
+}
+
+bool CudaAllocator::owns_pages(Buffer buffer) {
+  auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+  return buf && buf->size > page_size && !buf->foreign && !buf->range &&
+      !devices_[buf->device]->memory_pool;
+}
+
+void CudaAllocator::prefetch(Buffer buffer, int device, cudaStream_t stream) {
+  auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+  if (!owns_pages(buffer) || buf->location == device) {
+    return;
+  }
+  // The prefetches can not be captured in the graphs.
+  cudaStreamCaptureStatus status;
+  CHECK_CUDA_ERROR(cudaStreamIsCapturing(stream, &status));
+  if (status != cudaStreamCaptureStatusNone) {
+    return;
+  }
+  CHECK_CUDA_ERROR(mem_prefetch_async(buf->data, buf->size, device, stream));
+  buf->location = device;
+}
+
+void CudaAllocator::set_read_mostly(Buffer buffer) {
+  auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+  if (!owns_pages(buffer) || buf->read_mostly) {
+    return;
+  }
+  CHECK_CUDA_ERROR(mem_advise(
+      buf->data, buf->size, cudaMemAdviseSetReadMostly, cudaCpuDeviceId));
+  buf->read_mostly = true;
+}
+
 size_t CudaAllocator::get_active_memory() const {
   return active_memory_;
 }
@@ -190,31 +768,123 @@ size_t CudaAllocator::get_peak_memory() const {
 void CudaAllocator::reset_peak_memory() {
   std::lock_guard lock(mutex_);
   peak_memory_ = 0;
+  for (auto& memory : devices_) {
+    if (memory) {
+      memory->peak_memory = 0;
+    }
+  }
 }
 
-size_t CudaAllocator::get_memory_limit() {
-  return memory_limit_;
+size_t CudaAllocator::get_cache_memory() const {
+  size_t cache_memory = 0;
+  for (auto& memory : devices_) {
+    if (memory) {
+      cache_memory +=
+          memory->buffer_cache.cache_size() + memory->thread_cache_size;
+    }
+  }
+  return cache_memory;
 }
 
-size_t CudaAllocator::set_memory_limit(size_t limit) {
+BufferCacheStats CudaAllocator::get_cache_stats() {
   std::lock_guard lock(mutex_);
-  std::swap(limit, memory_limit_);
-  return limit;
+  BufferCacheStats stats;
+  for (auto& memory : devices_) {
+    if (memory) {
+      auto& s = memory->buffer_cache.stats();
+      stats.hits += s.hits + memory->thread_cache_hits;
+      stats.misses += s.misses;
+      stats.evictions += s.evictions;
+      stats.requested_bytes +=
+          s.requested_bytes + memory->thread_cache_hit_bytes;
+      stats.reused_bytes += s.reused_bytes + memory->thread_cache_hit_bytes;
+    }
+  }
+  return stats;
 }
 
-size_t CudaAllocator::get_cache_memory() const {
-  return buffer_cache_.cache_size();
+void CudaAllocator::reset_cache_stats() {
+  std::lock_guard lock(mutex_);
+  for (auto& memory : devices_) {
+    if (memory) {
+      memory->buffer_cache.reset_stats();
+      memory->thread_cache_hits = 0;
+      memory->thread_cache_hit_bytes = 0;
+    }
+  }
 }
 
-size_t CudaAllocator::set_cache_limit(size_t limit) {
+void CudaAllocator::clear_cache() {
+  drain_thread_caches(-1);
   std::lock_guard lk(mutex_);
-  std::swap(limit, max_pool_size_);
+  for (auto& memory : devices_) {
+    if (memory) {
+      clear_cache(*memory);
+    }
+  }
+}
+
+size_t CudaAllocator::get_active_memory(int device) {
+  std::lock_guard lock(mutex_);
+  return device_memory(device).active_memory;
+}
+
+size_t CudaAllocator::get_peak_memory(int device) {
+  std::lock_guard lock(mutex_);
+  return device_memory(device).peak_memory;
+}
+
+void CudaAllocator::reset_peak_memory(int device) {
+  std::lock_guard lock(mutex_);
+  device_memory(device).peak_memory = 0;
+}
+
+size_t CudaAllocator::get_memory_limit(int device) {
+  std::lock_guard lock(mutex_);
+  return device_memory(device).memory_limit;
+}
+
+size_t CudaAllocator::set_memory_limit(size_t limit, int device) {
+  std::lock_guard lock(mutex_);
+  auto& memory = device_memory(device);
+  std::swap(limit, memory.memory_limit);
+  if (memory.memory_pool) {
+    uint64_t threshold = memory.memory_limit;
+    CHECK_CUDA_ERROR(cudaMemPoolSetAttribute(
+        memory.memory_pool, cudaMemPoolAttrReleaseThreshold, &threshold));
+  }
   return limit;
 }
 
-void CudaAllocator::clear_cache() {
+size_t CudaAllocator::get_cache_memory(int device) {
+  std::lock_guard lock(mutex_);
+  auto& memory = device_memory(device);
+  return memory.buffer_cache.cache_size() + memory.thread_cache_size;
+}
+
+size_t CudaAllocator::set_cache_limit(size_t limit, int device) {
+  {
+    std::lock_guard lk(mutex_);
+    limit = device_memory(device).max_pool_size.exchange(limit);
+  }
+  // Apply the new limit to the buffers of the thread caches.
+  drain_thread_caches(device);
+  return limit;
+}
+
+void CudaAllocator::clear_cache(int device) {
+  drain_thread_caches(device);
   std::lock_guard lk(mutex_);
-  buffer_cache_.clear();
+  clear_cache(device_memory(device));
+}
+
+void CudaAllocator::clear_cache(DeviceMemory& memory) {
+  memory.buffer_cache.clear();
+  small_pool_.trim();
+  if (memory.memory_pool) {
+    CHECK_CUDA_ERROR(cudaStreamSynchronize(memory.pool_stream));
+    CHECK_CUDA_ERROR(cudaMemPoolTrimTo(memory.memory_pool, 0));
+  }
 }
 
 CudaAllocator& allocator() {
@@ -252,24 +922,96 @@ void reset_peak_memory() {
   return cu::allocator().reset_peak_memory();
 }
 size_t set_memory_limit(size_t limit) {
-  return cu::allocator().set_memory_limit(limit);
+  // Set the limit of every device and return the previous limit of the
+  // default one.
+  auto& allocator = cu::allocator();
+  size_t previous = allocator.set_memory_limit(limit, 0);
+  for (int i = 1; i < allocator.device_count(); ++i) {
+    allocator.set_memory_limit(limit, i);
+  }
+  return previous;
 }
 size_t get_memory_limit() {
-  return cu::allocator().get_memory_limit();
+  return cu::allocator().get_memory_limit(0);
 }
 size_t get_cache_memory() {
   return cu::allocator().get_cache_memory();
 }
 size_t set_cache_limit(size_t limit) {
-  return cu::allocator().set_cache_limit(limit);
+  auto& allocator = cu::allocator();
+  size_t previous = allocator.set_cache_limit(limit, 0);
+  for (int i = 1; i < allocator.device_count(); ++i) {
+    allocator.set_cache_limit(limit, i);
+  }
+  return previous;
 }
 void clear_cache() {
   cu::allocator().clear_cache();
 }
+std::unordered_map<std::string, size_t> get_cache_info() {
+  auto stats = cu::allocator().get_cache_stats();
+  return {
+      {"hits", stats.hits},
+      {"misses", stats.misses},
+      {"evictions", stats.evictions},
+      {"requested_bytes", stats.requested_bytes},
+      {"reused_bytes", stats.reused_bytes}};
+}
+void reset_cache_info() {
+  cu::allocator().reset_cache_stats();
+}
 
-// Not supported in CUDA.
-size_t set_wired_limit(size_t) {
-  return 0;
+// The arrays of the CPU are allocated on the current GPU, so the memory of
+// the CPU device is that of all the GPUs.
+size_t get_active_memory(Device device) {
+  if (device.type == Device::cpu) {
+    return get_active_memory();
+  }
+  return cu::allocator().get_active_memory(device.index);
+}
+size_t get_peak_memory(Device device) {
+  if (device.type == Device::cpu) {
+    return get_peak_memory();
+  }
+  return cu::allocator().get_peak_memory(device.index);
+}
+void reset_peak_memory(Device device) {
+  if (device.type == Device::cpu) {
+    reset_peak_memory();
+    return;
+  }
+  cu::allocator().reset_peak_memory(device.index);
+}
+size_t set_memory_limit(size_t limit, Device device) {
+  if (device.type == Device::cpu) {
+    return set_memory_limit(limit);
+  }
+  return cu::allocator().set_memory_limit(limit, device.index);
+}
+size_t get_memory_limit(Device device) {
+  if (device.type == Device::cpu) {
+    return get_memory_limit();
+  }
+  return cu::allocator().get_memory_limit(device.index);
+}
+size_t get_cache_memory(Device device) {
+  if (device.type == Device::cpu) {
+    return get_cache_memory();
+  }
+  return cu::allocator().get_cache_memory(device.index);
+}
+size_t set_cache_limit(size_t limit, Device device) {
+  if (device.type == Device::cpu) {
+    return set_cache_limit(limit);
+  }
+  return cu::allocator().set_cache_limit(limit, device.index);
+}
+void clear_cache(Device device) {
+  if (device.type == Device::cpu) {
+    clear_cache();
+    return;
+  }
+  cu::allocator().clear_cache(device.index);
 }
 
 } // namespace mlx::core
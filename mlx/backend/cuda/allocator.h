@@ -5,10 +5,18 @@
 #include "mlx/allocator.h"
 #include "mlx/backend/common/buffer_cache.h"
 
+#include <cuda.h>
+#include <cuda_runtime.h>
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <thread>
 #include <utility>
+#include <vector>
 
 namespace mlx::core::cu {
 
@@ -16,34 +24,179 @@ class Worker;
 
 using allocator::Buffer;
 
-// Stores cuda-managed unified memory.
+// A range of virtual addresses of device memory whose pages are mapped as
+// it grows.
+struct VirtualRange {
+  size_t reserved;
+  size_t granularity;
+  // The physical memory mapped after each other from the start.
+  std::vector<CUmemGenericAllocationHandle> handles;
+};
+
+// Stores cuda-managed unified memory, or device memory from a memory pool
+// when MLX_CUDA_USE_MEMORY_POOL is set, of |device|.
 struct CudaBuffer {
   void* data;
   size_t size;
+  int device;
+  // Where the managed memory was last prefetched to or written by the GPU,
+  // cudaInvalidDeviceId when unknown.
+  int location{cudaInvalidDeviceId};
+  bool read_mostly{false};
+  // Tagged to persist in the L2 cache, and the reads counted to tag it
+  // automatically with the last graph reading it, see l2_persistence.h.
+  bool l2_persisting{false};
+  uint32_t l2_reads{0};
+  uint64_t l2_commit{0};
+  // A slot of the arena of a MemoryPlan, its memory is freed with the plan.
+  bool planned{false};
+  // Memory of another library wrapped by from_device_memory, which is
+  // neither cached nor prefetched.
+  bool foreign{false};
+  // The addresses reserved by CudaAllocator::reserve, the size is the part
+  // mapped so far.
+  VirtualRange* range{nullptr};
+  // The stream the memory of the pool was allocated on, where it is freed.
+  cudaStream_t stream{nullptr};
+};
+
+// The allocations of a recorded step assigned to the slots of one arena.
+// The k-th allocation of the thread using the plan is served from the slot
+// |slot_of[k]|, or allocated as usual when it is -1, and the frees of the
+// slots are ignored.
+class MemoryPlan {
+ public:
+  MemoryPlan(
+      std::vector<size_t> sizes,
+      std::vector<int> slot_of,
+      const std::vector<size_t>& slot_sizes);
+  ~MemoryPlan();
+
+  MemoryPlan(const MemoryPlan&) = delete;
+  MemoryPlan& operator=(const MemoryPlan&) = delete;
+
+  // Return the slot of the next allocation, or nullptr when it is not
+  // planned. No slot is returned once an allocation differs from the plan.
+  CudaBuffer* next(size_t size);
+
+  size_t arena_size() const {
+    return arena_size_;
+  }
+
+ private:
+  Buffer arena_{nullptr};
+  size_t arena_size_{0};
+  std::vector<size_t> sizes_;
+  std::vector<int> slot_of_;
+  std::vector<std::unique_ptr<CudaBuffer>> slots_;
+  size_t next_{0};
+  bool diverged_{false};
 };
 
+// The buffers of up to a page are carved out of slabs of managed memory,
+// with a free list for each power of 2 size. The slabs are allocated on
+// demand and freed by trim() once all their blocks are free.
 class SmallSizePool {
  private:
   struct Block {
     Block* next;
   };
 
-  void* buffer_{nullptr};
-  Block* next_free_{nullptr};
-  void* end_{nullptr};
+  struct Slab {
+    size_t block_size;
+    // The blocks in use, and the offset of the blocks never used.
+    size_t used;
+    size_t top;
+  };
+
+  static constexpr int num_classes = 12;
+
+  Slab& slab_of(void* p);
+
+  // The scalars are allocated and freed outside the lock of the allocator.
+  std::mutex mutex_;
+  std::map<char*, Slab> slabs_;
+  std::array<Block*, num_classes> free_lists_{};
+  // The last slab of each size, the blocks are taken from its top.
+  std::array<char*, num_classes> current_{};
 
  public:
-  SmallSizePool();
+  SmallSizePool() = default;
   ~SmallSizePool();
 
   SmallSizePool(const SmallSizePool&) = delete;
   SmallSizePool& operator=(const SmallSizePool&) = delete;
 
-  void* malloc();
+  // Return a block of |size|, a power of 2 of at most a page, or nullptr
+  // when a slab can not be allocated.
+  void* malloc(size_t size);
   void free(void* p);
   bool in_pool(void* p);
+
+  // Free the slabs which have no block in use.
+  void trim();
 };
 
+// The limits, counters and cached buffers of the memory of a device.
+struct DeviceMemory {
+  DeviceMemory(int device, std::function<void(CudaBuffer*)> free);
+
+  DeviceMemory(const DeviceMemory&) = delete;
+  DeviceMemory& operator=(const DeviceMemory&) = delete;
+
+  size_t memory_limit;
+  std::atomic<size_t> max_pool_size;
+  BufferCache<CudaBuffer> buffer_cache;
+  std::atomic<size_t> active_memory{0};
+  std::atomic<size_t> peak_memory{0};
+
+  // The bytes of the buffers in the thread caches, and the allocations
+  // served from them.
+  std::atomic<size_t> thread_cache_size{0};
+  std::atomic<size_t> thread_cache_hits{0};
+  std::atomic<size_t> thread_cache_hit_bytes{0};
+
+  // The buffers are allocated from |memory_pool| instead of being managed
+  // memory when MLX_CUDA_USE_MEMORY_POOL is set. The allocations are ordered
+  // on the stream of the kernels using them, or on |pool_stream| outside the
+  // evaluation of the primitives.
+  cudaMemPool_t memory_pool{nullptr};
+  cudaStream_t pool_stream{nullptr};
+};
+
+// The buffers smaller than a page freed by a thread, kept for its next
+// allocations of the same size so that they do not take the lock of the
+// allocator. A size class holds at most |capacity| buffers of each device,
+// half of them are returned to the buffer cache of the device when it is
+// full.
+class ThreadCache {
+ public:
+  static constexpr int num_classes = 11;
+  static constexpr int capacity = 16;
+
+  // Return a cached buffer of |size| on |device|, or nullptr.
+  CudaBuffer* pop(size_t size, int device);
+
+  // Cache |buf|, and return the number of buffers which did not fit, moved
+  // to |overflow|.
+  int push(CudaBuffer* buf, std::array<CudaBuffer*, capacity / 2>& overflow);
+
+  // Remove the buffers of |device|, or of all the devices when it is -1.
+  void drain(int device, std::vector<CudaBuffer*>& buffers);
+
+ private:
+  struct SizeClass {
+    int count{0};
+    std::array<CudaBuffer*, capacity> buffers;
+  };
+
+  // Only contended when another thread drains the cache.
+  std::mutex mutex_;
+  std::vector<std::array<SizeClass, num_classes>> devices_;
+};
+
+// The buffers are allocated on the current device of the calling thread,
+// the buffers, limits and counters of each device are kept apart.
 class CudaAllocator : public allocator::Allocator {
  public:
   Buffer malloc(size_t size) override;
@@ -56,33 +209,111 @@ class CudaAllocator : public allocator::Allocator {
   // buffers there would result in dead lock.
   void register_this_thread();
 
+  // Return the memory of |buf| to where it was allocated from and delete it.
+  void cuda_free(CudaBuffer* buf);
+
   // Call cudaFree in the safe thread.
   void cuda_free(void* buf);
 
+  // The memory of all the devices.
   size_t get_active_memory() const;
   size_t get_peak_memory() const;
   void reset_peak_memory();
-  size_t get_memory_limit();
-  size_t set_memory_limit(size_t limit);
   size_t get_cache_memory() const;
-  size_t set_cache_limit(size_t limit);
+  BufferCacheStats get_cache_stats();
+  void reset_cache_stats();
   void clear_cache();
 
+  // The memory of a device.
+  size_t get_active_memory(int device);
+  size_t get_peak_memory(int device);
+  void reset_peak_memory(int device);
+  size_t get_memory_limit(int device);
+  size_t set_memory_limit(size_t limit, int device);
+  size_t get_cache_memory(int device);
+  size_t set_cache_limit(size_t limit, int device);
+  void clear_cache(int device);
+
+  int device_count() const {
+    return devices_.size();
+  }
+
+  // The device owning the memory of |buffer| when it is device memory from a
+  // memory pool or of another library, or -1 for the managed memory
+  // accessible from every device and the host copies of readable_by_host.
+  int device_of(Buffer buffer);
+
+  // Whether |buffer| is managed memory with pages of its own, which can be
+  // prefetched and advised. The buffers of the small pool share their pages.
+  bool owns_pages(Buffer buffer);
+
+  // Prefetch the managed memory of |buffer| on |stream| to |device|, or to
+  // the host when it is cudaCpuDeviceId, unless it is already there.
+  void prefetch(Buffer buffer, int device, cudaStream_t stream);
+
+  // Advise the driver that the managed memory of |buffer| is mostly read, so
+  // that the devices reading it keep a copy. The advice is removed when the
+  // buffer is freed.
+  void set_read_mostly(Buffer buffer);
+
+  // Reserve the addresses of |size| bytes of device memory on the current
+  // device, whose pages are mapped by grow(). The buffer keeps its address
+  // as it grows, and is neither cached nor prefetched.
+  Buffer reserve(size_t size);
+
+  // Map the pages of the first |size| bytes of a buffer from reserve().
+  void grow(Buffer buffer, size_t size);
+
+  // Return the buffers of a thread cache to the buffer caches and forget it,
+  // when its thread exits.
+  void release_thread_cache(ThreadCache* cache);
+
+  // Append the buffers allocated by the calling thread and their sizes to
+  // |trace|, or serve its allocations from |plan|, until they are reset to
+  // nullptr.
+  void set_trace(std::vector<std::pair<CudaBuffer*, size_t>>* trace);
+  void set_plan(MemoryPlan* plan);
+
+  // Order the allocations of the memory pool by the calling thread on
+  // |stream|, the stream of the kernels it encodes, until it is reset to
+  // nullptr.
+  void set_stream(cudaStream_t stream);
+
  private:
   CudaAllocator();
   friend CudaAllocator& allocator();
 
+  Buffer allocate(size_t size);
+
+  ThreadCache& thread_cache();
+
+  // Move the buffers of the thread caches of |device|, or of all the devices
+  // when it is -1, to the buffer caches.
+  void drain_thread_caches(int device);
+  void recycle(CudaBuffer** buffers, size_t n);
+
+  // Run |task| in the worker when the calling thread is not safe to free
+  // memory in, and return whether it did.
+  bool defer_free(std::function<void()> task);
+
+  // Unmap and release the memory of a buffer from reserve() and delete it.
+  void release_range(CudaBuffer* buf);
+
+  std::mutex thread_caches_mutex_;
+  std::set<ThreadCache*> thread_caches_;
+
   std::mutex worker_mutex_;
   std::unique_ptr<Worker> worker_;
   std::set<std::thread::id> allowed_threads_;
 
+  DeviceMemory& device_memory(int device);
+  void clear_cache(DeviceMemory& memory);
+
   std::mutex mutex_;
-  size_t memory_limit_;
-  size_t max_pool_size_;
-  BufferCache<CudaBuffer> buffer_cache_;
-  size_t active_memory_{0};
-  size_t peak_memory_{0};
-  SmallSizePool scalar_pool_;
+  std::vector<std::unique_ptr<DeviceMemory>> devices_;
+  std::atomic<size_t> active_memory_{0};
+  std::atomic<size_t> peak_memory_{0};
+  SmallSizePool small_pool_;
 };
 
 CudaAllocator& allocator();
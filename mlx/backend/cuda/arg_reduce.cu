@@ -1,10 +1,12 @@
 // Copyright © 2025 Apple Inc.
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/arg_reduce_ops.cuh"
 #include "mlx/backend/cuda/device/fp16_math.cuh"
 #include "mlx/backend/cuda/iterators/strided_iterator.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
 #include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 
 #include <cooperative_groups.h>
@@ -20,76 +22,11 @@ namespace cu {
 
 namespace cg = cooperative_groups;
 
-template <typename T>
-struct IndexValPair {
-  uint32_t index;
-  T val;
-};
-
-template <typename T>
-struct ArgMin {
-  constexpr __device__ T init() {
-    return Limits<T>::max();
-  }
-
-  __device__ IndexValPair<T> operator()(
-      const IndexValPair<T>& best,
-      const IndexValPair<T>& current) {
-    if (best.val > current.val ||
-        (best.val == current.val && best.index > current.index)) {
-      return current;
-    } else {
-      return best;
-    }
-  }
-
-  template <int N>
-  __device__ IndexValPair<T>
-  reduce_many(IndexValPair<T> best, T (&vals)[N], uint32_t offset) {
-    for (int i = 0; i < N; i++) {
-      if (vals[i] < best.val) {
-        best.val = vals[i];
-        best.index = offset + i;
-      }
-    }
-    return best;
-  }
-};
-
-template <typename T>
-struct ArgMax {
-  constexpr __device__ T init() {
-    return Limits<T>::min();
-  }
-
-  __device__ IndexValPair<T> operator()(
-      const IndexValPair<T>& best,
-      const IndexValPair<T>& current) {
-    if (best.val < current.val ||
-        (best.val == current.val && best.index > current.index)) {
-      return current;
-    } else {
-      return best;
-    }
-  }
-
-  template <int N>
-  __device__ IndexValPair<T>
-  reduce_many(IndexValPair<T> best, T (&vals)[N], uint32_t offset) {
-    for (int i = 0; i < N; i++) {
-      if (vals[i] > best.val) {
-        best.val = vals[i];
-        best.index = offset + i;
-      }
-    }
-    return best;
-  }
-};
-
 template <typename T, typename Op, int BLOCK_DIM, int N_READS = 4>
 __global__ void arg_reduce_general(
     const T* in,
     uint32_t* out,
+    T* out_val,
     size_t size,
     const __grid_constant__ Shape shape,
     const __grid_constant__ Strides in_strides,
@@ -126,57 +63,247 @@ __global__ void arg_reduce_general(
 
   if (block.thread_rank() == 0) {
     out[out_idx] = best.index;
+    if (out_val) {
+      out_val[out_idx] = best.val;
+    }
+  }
+}
+
+// The first pass of the reduction of the long rows, the block (c, r) reduces
+// the chunk c of the row r into partials[r * gridDim.x + c].
+template <typename T, typename Op, int BLOCK_DIM, int N_READS = 4>
+__global__ void arg_reduce_partial(
+    const T* in,
+    IndexValPair<T>* partials,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides in_strides,
+    int32_t ndim,
+    int64_t axis_stride,
+    int32_t axis_size,
+    int32_t chunk_size) {
+  auto block = cg::this_thread_block();
+
+  int64_t row = blockIdx.y;
+  int32_t start = blockIdx.x * chunk_size;
+  int32_t len = min(chunk_size, axis_size - start);
+  int64_t in_idx = elem_to_loc(row, shape.data(), in_strides.data(), ndim) +
+      start * axis_stride;
+
+  Op op;
+  T init = op.init();
+  IndexValPair<T> best{0, init};
+
+  for (int r = 0; r < cuda::ceil_div(len, BLOCK_DIM * N_READS); ++r) {
+    T vals[N_READS];
+    auto tid = r * BLOCK_DIM + block.thread_index().x;
+    cub::LoadDirectBlocked(
+        tid, strided_iterator(in + in_idx, axis_stride), vals, len, init);
+    best = op.reduce_many(best, vals, start + tid * N_READS);
+  }
+
+  typedef cub::BlockReduce<IndexValPair<T>, BLOCK_DIM> BlockReduceT;
+  __shared__ typename BlockReduceT::TempStorage temp;
+
+  best = BlockReduceT(temp).Reduce(best, op);
+
+  if (block.thread_rank() == 0) {
+    partials[row * gridDim.x + blockIdx.x] = best;
+  }
+}
+
+// The second pass, one block reduces the partial results of a row. The ties
+// are broken by the index so the result does not depend on the chunks.
+template <typename T, typename Op, int BLOCK_DIM>
+__global__ void arg_reduce_finalize(
+    const IndexValPair<T>* partials,
+    uint32_t* out,
+    T* out_val,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides out_strides,
+    int32_t ndim,
+    int32_t num_chunks) {
+  auto block = cg::this_thread_block();
+
+  int64_t row = blockIdx.x;
+  int64_t out_idx = elem_to_loc(row, shape.data(), out_strides.data(), ndim);
+
+  Op op;
+  IndexValPair<T> best{0, op.init()};
+  for (int i = block.thread_rank(); i < num_chunks; i += BLOCK_DIM) {
+    best = op(best, partials[row * num_chunks + i]);
+  }
+
+  typedef cub::BlockReduce<IndexValPair<T>, BLOCK_DIM> BlockReduceT;
+  __shared__ typename BlockReduceT::TempStorage temp;
+
+  best = BlockReduceT(temp).Reduce(best, op);
+
+  if (block.thread_rank() == 0) {
+    out[out_idx] = best.index;
+    if (out_val) {
+      out_val[out_idx] = best.val;
+    }
   }
 }
 
 } // namespace cu
 
-void ArgReduce::eval_gpu(const std::vector<array>& inputs, array& out) {
-  nvtx3::scoped_range r("ArgReduce::eval_gpu");
-  assert(inputs.size() == 1);
-  auto& in = inputs[0];
-  out.set_data(allocator::malloc(out.nbytes()));
-  auto& s = stream();
+namespace {
 
+// The fewest elements reduced by a block when a row is split across blocks.
+constexpr int32_t arg_reduce_min_chunk = 8192;
+
+// Write the index of the min or max of |in| along |axis| to |out|, and its
+// value to |out_val| when given. A single block reduces each row, unless
+// there are too few rows to fill the GPU and they are long, then the rows
+// are split across blocks and reduced in two passes.
+void arg_reduce_gpu(
+    const array& in,
+    array& out,
+    array* out_val,
+    ArgReduce::ReduceType reduce_type,
+    int axis,
+    const Stream& s) {
   // Prepare the shapes, strides and axis arguments.
-  Shape shape = remove_index(in.shape(), axis_);
-  Strides in_strides = remove_index(in.strides(), axis_);
+  Shape shape = remove_index(in.shape(), axis);
+  Strides in_strides = remove_index(in.strides(), axis);
   Strides out_strides = out.ndim() == in.ndim()
-      ? remove_index(out.strides(), axis_)
+      ? remove_index(out.strides(), axis)
       : out.strides();
-  int64_t axis_stride = in.strides()[axis_];
-  int32_t axis_size = in.shape()[axis_];
+  int64_t axis_stride = in.strides()[axis];
+  int32_t axis_size = in.shape()[axis];
   int32_t ndim = shape.size();
 
-  // ArgReduce.
   auto& encoder = cu::get_command_encoder(s);
   encoder.set_input_array(in);
   encoder.set_output_array(out);
+  if (out_val) {
+    encoder.set_output_array(*out_val);
+  }
+
+  int64_t rows = out.size();
+  int64_t target_blocks = 2 * encoder.device().multi_processor_count();
+  int32_t num_chunks = 1;
+  if (rows < target_blocks) {
+    num_chunks = std::min<int64_t>(
+        cuda::ceil_div(target_blocks, rows),
+        cuda::ceil_div(axis_size, arg_reduce_min_chunk));
+  }
+  int32_t chunk_size = cuda::ceil_div(axis_size, num_chunks);
+  num_chunks = cuda::ceil_div(axis_size, chunk_size);
+
   dispatch_real_types(in.dtype(), "ArgReduce", [&](auto type_tag) {
     using T = cuda_type_t<MLX_GET_TYPE(type_tag)>;
     constexpr uint32_t N_READS = 4;
-    dispatch_block_dim(cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
-      dim3 num_blocks = get_2d_grid_dims(out.shape(), out.strides());
-      auto kernel =
-          cu::arg_reduce_general<T, cu::ArgMax<T>, block_dim(), N_READS>;
-      if (reduce_type_ == ArgReduce::ArgMin) {
-        kernel = cu::arg_reduce_general<T, cu::ArgMin<T>, block_dim(), N_READS>;
+    T* out_val_ptr = out_val ? out_val->data<T>() : nullptr;
+    auto dispatch_op = [&](auto f) {
+      if (reduce_type == ArgReduce::ArgMin) {
+        f(type_identity<cu::ArgMin<T>>{});
+      } else {
+        f(type_identity<cu::ArgMax<T>>{});
+      }
+    };
+    dispatch_op([&](auto op_tag) {
+      using Op = typename decltype(op_tag)::type;
+      if (num_chunks == 1) {
+        dispatch_block_dim(
+            cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
+              dim3 num_blocks = get_2d_grid_dims(out.shape(), out.strides());
+              encoder.add_kernel_node(
+                  cu::arg_reduce_general<T, Op, block_dim(), N_READS>,
+                  num_blocks,
+                  block_dim(),
+                  in.data<T>(),
+                  out.data<uint32_t>(),
+                  out_val_ptr,
+                  out.size(),
+                  const_param(shape),
+                  const_param(in_strides),
+                  const_param(out_strides),
+                  ndim,
+                  axis_stride,
+                  axis_size);
+            });
+        return;
       }
-      encoder.add_kernel_node(
-          kernel,
-          num_blocks,
-          block_dim(),
-          in.data<T>(),
-          out.data<uint32_t>(),
-          out.size(),
-          const_param(shape),
-          const_param(in_strides),
-          const_param(out_strides),
-          ndim,
-          axis_stride,
-          axis_size);
+
+      array partials(
+          {static_cast<int>(
+              rows * num_chunks * sizeof(cu::IndexValPair<T>))},
+          uint8,
+          nullptr,
+          {});
+      partials.set_data(allocator::malloc(partials.nbytes()));
+      encoder.add_temporary(partials);
+      auto* partials_ptr =
+          reinterpret_cast<cu::IndexValPair<T>*>(partials.data<uint8_t>());
+
+      encoder.set_output_array(partials);
+      dispatch_block_dim(
+          cuda::ceil_div(chunk_size, N_READS), [&](auto block_dim) {
+            encoder.add_kernel_node(
+                cu::arg_reduce_partial<T, Op, block_dim(), N_READS>,
+                dim3(num_chunks, rows),
+                block_dim(),
+                in.data<T>(),
+                partials_ptr,
+                const_param(shape),
+                const_param(in_strides),
+                ndim,
+                axis_stride,
+                axis_size,
+                chunk_size);
+          });
+
+      encoder.set_input_array(partials);
+      encoder.set_output_array(out);
+      if (out_val) {
+        encoder.set_output_array(*out_val);
+      }
+      dispatch_block_dim(num_chunks, [&](auto block_dim) {
+        encoder.add_kernel_node(
+            cu::arg_reduce_finalize<T, Op, block_dim()>,
+            rows,
+            block_dim(),
+            partials_ptr,
+            out.data<uint32_t>(),
+            out_val_ptr,
+            const_param(shape),
+            const_param(out_strides),
+            ndim,
+            num_chunks);
+      });
     });
   });
 }
 
+} // namespace
+
+void ArgReduce::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("ArgReduce::eval_gpu");
+  assert(inputs.size() == 1);
+  out.set_data(allocator::malloc(out.nbytes()));
+  arg_reduce_gpu(inputs[0], out, nullptr, reduce_type_, axis_, stream());
+}
+
+namespace fast {
+
+bool ArgReduceWithValue::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void ArgReduceWithValue::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("ArgReduceWithValue::eval_gpu");
+  assert(inputs.size() == 1);
+  auto& values = outputs[0];
+  auto& indices = outputs[1];
+  values.set_data(allocator::malloc(values.nbytes()));
+  indices.set_data(allocator::malloc(indices.nbytes()));
+  arg_reduce_gpu(inputs[0], indices, &values, reduce_type_, axis_, stream());
+}
+
+} // namespace fast
+
 } // namespace mlx::core
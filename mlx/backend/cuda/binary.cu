@@ -248,8 +248,7 @@ void binary_op_gpu_inplace(
         } else {
           dispatch_bool(out.data_size() > UINT32_MAX, [&](auto large) {
             using IdxT = std::conditional_t<large(), int64_t, uint32_t>;
-            // TODO: Choose optimized value based on type size.
-            constexpr int N_READS = 4;
+            constexpr int N_READS = 16 / sizeof(InType);
             auto kernel = cu::binary_ss<Op, InType, OutType, IdxT, N_READS>;
             if (bopt == BinaryOpType::ScalarVector) {
               kernel = cu::binary_sv<Op, InType, OutType, IdxT, N_READS>;
@@ -258,13 +257,8 @@ void binary_op_gpu_inplace(
             } else if (bopt == BinaryOpType::VectorVector) {
               kernel = cu::binary_vv<Op, InType, OutType, IdxT, N_READS>;
             }
-            auto [num_blocks, block_dims] = get_launch_args(
-                kernel,
-                out.data_size(),
-                out.shape(),
-                out.strides(),
-                large(),
-                N_READS);
+            auto [num_blocks, block_dims] =
+                get_contiguous_launch_args(kernel, out, large(), N_READS);
             encoder.add_kernel_node(
                 kernel,
                 num_blocks,
@@ -291,11 +285,12 @@ void binary_op_gpu(
     const std::vector<array>& inputs,
     array& out,
     const char* op,
-    const Stream& s) {
+    const Stream& s,
+    bool inplace = false) {
   auto& a = inputs[0];
   auto& b = inputs[1];
   auto bopt = get_binary_op_type(a, b);
-  set_binary_op_output_data(a, b, out, bopt);
+  set_binary_op_output_data(a, b, out, bopt, inplace);
   binary_op_gpu_inplace<Op>(inputs, out, op, s);
 }
 
@@ -306,7 +301,6 @@ void binary_op_gpu(
     binary_op_gpu<cu::func>(inputs, out, name(), s);                  \
   }
 
-BINARY_GPU(Add)
 BINARY_GPU(ArcTan2)
 BINARY_GPU(Divide)
 BINARY_GPU(Remainder)
@@ -324,6 +318,15 @@ BINARY_GPU(NotEqual)
 BINARY_GPU(Power)
 BINARY_GPU(Subtract)
 
+void Add::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Add::eval_gpu");
+  auto& s = out.primitive().stream();
+  if (inplace_) {
+    check_inplace_binary_op(inputs[0], out, "add_inplace");
+  }
+  binary_op_gpu<cu::Add>(inputs, out, name(), s, inplace_);
+}
+
 void Equal::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("Equal::eval_gpu");
   auto& s = out.primitive().stream();
@@ -270,8 +270,7 @@ void binary_two_op_gpu_inplace(
         } else {
           dispatch_bool(out_a.data_size() > UINT32_MAX, [&](auto large) {
             using IdxT = std::conditional_t<large(), int64_t, uint32_t>;
-            // TODO: Choose optimized value based on type size.
-            constexpr int N_READS = 4;
+            constexpr int N_READS = 16 / sizeof(InType);
             auto kernel = cu::binary_two_ss<Op, InType, OutType, IdxT, N_READS>;
             if (bopt == BinaryOpType::ScalarVector) {
               kernel = cu::binary_two_sv<Op, InType, OutType, IdxT, N_READS>;
@@ -280,13 +279,8 @@ void binary_two_op_gpu_inplace(
             } else if (bopt == BinaryOpType::VectorVector) {
               kernel = cu::binary_two_vv<Op, InType, OutType, IdxT, N_READS>;
             }
-            auto [num_blocks, block_dims] = get_launch_args(
-                kernel,
-                out_a.data_size(),
-                out_a.shape(),
-                out_a.strides(),
-                large(),
-                N_READS);
+            auto [num_blocks, block_dims] =
+                get_contiguous_launch_args(kernel, out_a, large(), N_READS);
             encoder.add_kernel_node(
                 kernel,
                 num_blocks,
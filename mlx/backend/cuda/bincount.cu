@@ -0,0 +1,163 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/atomic_ops.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <nvtx3/nvtx3.hpp>
+
+#include <algorithm>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int bincount_block_dim = 256;
+
+// The blocks per SM, the elements are looped over by the blocks so that
+// there are few histograms to merge.
+constexpr int bincount_blocks_per_sm = 4;
+
+// Each block counts its elements in a histogram of |BINS| >= |length| bins
+// in shared memory, which is then added to |out| with one atomic per bin.
+// The adds to the few hot bins contend in the shared memory of a block
+// instead of in the global memory of the whole grid.
+template <typename IdxT, typename T, int BINS>
+__global__ void bincount_shared(
+    const IdxT* x,
+    const T* weights,
+    T* out,
+    int64_t size,
+    int length) {
+  __shared__ T hist[BINS];
+  auto block = cg::this_thread_block();
+  for (int j = block.thread_rank(); j < length; j += block.size()) {
+    hist[j] = T(0);
+  }
+  block.sync();
+
+  int64_t stride = int64_t(gridDim.x) * blockDim.x;
+  for (int64_t i = cg::this_grid().thread_rank(); i < size; i += stride) {
+    auto bin = static_cast<int64_t>(x[i]);
+    if (bin >= 0 && bin < length) {
+      cuda::atomic_ref<T, cuda::thread_scope_block> ref(hist[bin]);
+      ref += weights ? weights[i] : T(1);
+    }
+  }
+  block.sync();
+
+  for (int j = block.thread_rank(); j < length; j += block.size()) {
+    if (hist[j] != T(0)) {
+      atomic_add(&out[j], hist[j]);
+    }
+  }
+}
+
+// The histograms too large for the shared memory are added to in place.
+template <typename IdxT, typename T>
+__global__ void bincount_global(
+    const IdxT* x,
+    const T* weights,
+    T* out,
+    int64_t size,
+    int length) {
+  int64_t stride = int64_t(gridDim.x) * blockDim.x;
+  for (int64_t i = cg::this_grid().thread_rank(); i < size; i += stride) {
+    auto bin = static_cast<int64_t>(x[i]);
+    if (bin >= 0 && bin < length) {
+      atomic_add(&out[bin], weights ? weights[i] : T(1));
+    }
+  }
+}
+
+} // namespace cu
+
+void BinCount::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("BinCount::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  array zero(0, out.dtype());
+  encoder.add_temporary(zero);
+  fill_gpu(zero, out, s);
+  if (inputs[0].size() == 0) {
+    return;
+  }
+
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array x = ensure_row_contiguous(inputs[0]);
+  std::optional<array> weights;
+  if (inputs.size() > 1) {
+    weights = ensure_row_contiguous(inputs[1]);
+    encoder.set_input_array(*weights);
+  }
+  encoder.set_input_array(x);
+  encoder.set_output_array(out);
+
+  int64_t size = x.size();
+  int length = length_;
+  int max_blocks =
+      encoder.device().multi_processor_count() * cu::bincount_blocks_per_sm;
+  dispatch_int_types(x.dtype(), "[BinCount::eval_gpu]", [&](auto idx_tag) {
+    using IdxT = MLX_GET_TYPE(idx_tag);
+    auto run = [&](auto type_tag) {
+      using T = decltype(type_tag);
+      const T* w = weights ? weights->data<T>() : nullptr;
+      // A block takes at least as many elements as there are bins to add.
+      auto launch = [&](auto* kernel, int64_t work) {
+        int64_t num_blocks =
+            std::clamp<int64_t>(cuda::ceil_div(size, work), 1, max_blocks);
+        encoder.add_kernel_node(
+            kernel,
+            num_blocks,
+            cu::bincount_block_dim,
+            x.data<IdxT>(),
+            w,
+            out.data<T>(),
+            size,
+            length);
+      };
+      int64_t work = std::max(cu::bincount_block_dim, length);
+      if (length <= 256) {
+        launch(cu::bincount_shared<IdxT, T, 256>, work);
+      } else if (length <= 1024) {
+        launch(cu::bincount_shared<IdxT, T, 1024>, work);
+      } else if (length <= 4096) {
+        launch(cu::bincount_shared<IdxT, T, 4096>, work);
+      } else {
+        launch(cu::bincount_global<IdxT, T>, cu::bincount_block_dim);
+      }
+    };
+    switch (out.dtype()) {
+      case int32:
+        return run(int32_t{});
+      case int64:
+        return run(int64_t{});
+      case float32:
+        return run(float{});
+      case float64:
+        return run(double{});
+      default:
+        throw std::invalid_argument("[BinCount::eval_gpu] Unsupported type.");
+    }
+  });
+}
+
+} // namespace mlx::core
@@ -1,14 +1,17 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/common/compiled.h"
+#include "mlx/backend/common/utils.h"
 #include "mlx/backend/cuda/device.h"
 #include "mlx/backend/cuda/jit_module.h"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/megakernel.h"
 #include "mlx/graph_utils.h"
 #include "mlx/primitives.h"
 
 #include <fmt/format.h>
 #include <nvtx3/nvtx3.hpp>
+#include <string_view>
 
 namespace mlx::core {
 
@@ -26,21 +29,7 @@ struct FusedKernelBuilder {
     NodeNamer namer;
 
     // Function parameters.
-    std::vector<std::string> params;
-    for (size_t i = 0; i < inputs.size(); ++i) {
-      if (is_constant(i)) {
-        continue;
-      }
-      const auto& x = inputs[i];
-      const std::string& xname = namer.get_name(x);
-      params.push_back(
-          fmt::format("const {}* {}", dtype_to_cuda_type(x.dtype()), xname));
-      if (!is_scalar(x) && !contiguous) {
-        params.push_back(fmt::format(
-            "const __grid_constant__ cuda::std::array<int64_t, NDIM> {}_strides",
-            xname));
-      }
-    }
+    std::vector<std::string> params = input_params(namer, contiguous);
     for (const auto& x : outputs) {
       params.push_back(fmt::format(
           "{}* {}", dtype_to_cuda_type(x.dtype()), namer.get_name(x)));
@@ -58,7 +47,202 @@ struct FusedKernelBuilder {
       os +=
           "template <int NDIM, typename IdxT = uint32_t, int work_per_thread = 1>\n";
     }
-    os += fmt::format("__global__ void {}(\n", kernel_name + name);
+    write_signature(kernel_name + name, params);
+
+    if (contiguous) {
+      write_contiguous_body(namer);
+    } else {
+      write_strided_body(namer);
+    }
+    os += "}\n";
+  }
+
+  // Build a kernel reducing the trailing |row_size| elements computed by the
+  // tape into each element of the output, with one row per block in x and
+  // the blocks in y accumulating the same row atomically.
+  void build_reduce(const char* name, bool contiguous, const array& reduce) {
+    NodeNamer namer;
+    const auto& out = outputs[0];
+
+    // Function parameters.
+    std::vector<std::string> params = input_params(namer, contiguous);
+    std::string out_name = namer.get_name(out);
+    params.push_back(
+        fmt::format("{}* {}", dtype_to_cuda_type(out.dtype()), out_name));
+    if (!contiguous) {
+      params.push_back(
+          "const __grid_constant__ cuda::std::array<int32_t, NDIM> shape");
+    }
+    params.push_back("IdxT row_size");
+
+    // Build function signature.
+    if (contiguous) {
+      os += "template <typename IdxT = uint32_t>\n";
+    } else {
+      os += "template <int NDIM, typename IdxT = uint32_t>\n";
+    }
+    write_signature(kernel_name + name, params);
+
+    std::string out_type = dtype_to_cuda_type(out.dtype());
+    os += fmt::format(
+        "  using Op = {};\n"
+        "  using T = {};\n"
+        "  using AccT = typename ReduceResult<Op, T>::type;\n"
+        "  auto block = cg::this_thread_block();\n"
+        "  auto warp = cg::tiled_partition<WARP_SIZE>(block);\n"
+        "  __shared__ AccT smem[WARP_SIZE];\n"
+        "\n"
+        "  IdxT row = blockIdx.x;\n"
+        "  AccT acc[1] = {{ReduceInit<Op, T>::value()}};\n"
+        "  for (IdxT j = blockIdx.y * blockDim.x + threadIdx.x; j < row_size;\n"
+        "       j += gridDim.y * blockDim.x) {{\n"
+        "    IdxT index = row * row_size + j;\n",
+        reduce.primitive().name(),
+        dtype_to_cuda_type(reduce.inputs()[0].dtype()));
+    if (!contiguous) {
+      write_indices(namer, "    ");
+    }
+    write_values(
+        namer, contiguous ? Read::Contiguous : Read::Strided, "    ");
+    os += fmt::format(
+        "    acc[0] = Op{{}}(acc[0], cast_to<AccT>(tmp_{0}));\n"
+        "  }}\n"
+        "\n"
+        "  block_reduce(block, warp, acc, smem, Op{{}}, "
+        "ReduceInit<Op, T>::value());\n"
+        "  if (block.thread_rank() == 0) {{\n"
+        "    if (gridDim.y == 1) {{\n"
+        "      {1}[row] = cast_to<{2}>(acc[0]);\n"
+        "    }} else {{\n"
+        "      Op{{}}.atomic_update({1} + row, cast_to<{2}>(acc[0]));\n"
+        "    }}\n"
+        "  }}\n"
+        "}}\n",
+        namer.get_name(reduce.inputs()[0]),
+        out_name,
+        out_type);
+  }
+
+  // Build a kernel filling the output with the init value of the reduction,
+  // before the blocks accumulate into it.
+  void build_reduce_init(const char* name, const array& reduce) {
+    os += fmt::format(
+        "template <typename IdxT = uint32_t>\n"
+        "__global__ void {0}({1}* out, IdxT size) {{\n"
+        "  launch_dependent_grids();\n"
+        "  wait_prerequisite_grids();\n"
+        "  IdxT index = cg::this_grid().thread_rank();\n"
+        "  if (index < size) {{\n"
+        "    out[index] = cast_to<{1}>(ReduceInit<{2}, {3}>::value());\n"
+        "  }}\n"
+        "}}\n",
+        kernel_name + name,
+        dtype_to_cuda_type(outputs[0].dtype()),
+        reduce.primitive().name(),
+        dtype_to_cuda_type(reduce.inputs()[0].dtype()));
+  }
+
+  // Build a device function computing the tape for the contiguous elements,
+  // looping over the grid, to run as a stage of a megakernel.
+  MegakernelSource build_stage(const std::string& name) {
+    NodeNamer namer;
+    std::vector<std::string> params = input_params(namer, true);
+    for (const auto& x : outputs) {
+      params.push_back(fmt::format(
+          "{}* {}", dtype_to_cuda_type(x.dtype()), namer.get_name(x)));
+    }
+    params.push_back("uint32_t size");
+    write_signature(name, params, "__device__");
+    os +=
+        "  using IdxT = uint32_t;\n"
+        "  auto grid = cg::this_grid();\n"
+        "  for (IdxT index = grid.thread_rank(); index < size;\n"
+        "       index += grid.size()) {\n";
+    write_values(namer, Read::Contiguous, "    ");
+    for (const auto& x : outputs) {
+      os += fmt::format("    {0}[index] = tmp_{0};\n", namer.get_name(x));
+    }
+    os += "  }\n}\n";
+    return {name, std::move(os), param_types(params)};
+  }
+
+  // Build a device function reducing the contiguous rows computed by the
+  // tape with a block per row, looping over the rows, to run as a stage of
+  // a megakernel.
+  MegakernelSource build_reduce_stage(
+      const std::string& name,
+      const array& reduce) {
+    NodeNamer namer;
+    const auto& out = outputs[0];
+    std::vector<std::string> params = input_params(namer, true);
+    std::string out_name = namer.get_name(out);
+    std::string out_type = dtype_to_cuda_type(out.dtype());
+    params.push_back(fmt::format("{}* {}", out_type, out_name));
+    params.push_back("uint32_t row_size");
+    params.push_back("uint32_t rows");
+    write_signature(name, params, "__device__");
+    os += fmt::format(
+        "  using Op = {};\n"
+        "  using T = {};\n"
+        "  using AccT = typename ReduceResult<Op, T>::type;\n"
+        "  using IdxT = uint32_t;\n"
+        "  auto block = cg::this_thread_block();\n"
+        "  auto warp = cg::tiled_partition<WARP_SIZE>(block);\n"
+        "  __shared__ AccT smem[WARP_SIZE];\n"
+        "\n"
+        "  for (IdxT row = blockIdx.x; row < rows; row += gridDim.x) {{\n"
+        "    AccT acc[1] = {{ReduceInit<Op, T>::value()}};\n"
+        "    for (IdxT j = threadIdx.x; j < row_size; j += blockDim.x) {{\n"
+        "      IdxT index = row * row_size + j;\n",
+        reduce.primitive().name(),
+        dtype_to_cuda_type(reduce.inputs()[0].dtype()));
+    write_values(namer, Read::Contiguous, "      ");
+    os += fmt::format(
+        "      acc[0] = Op{{}}(acc[0], cast_to<AccT>(tmp_{0}));\n"
+        "    }}\n"
+        "    block_reduce(block, warp, acc, smem, Op{{}}, "
+        "ReduceInit<Op, T>::value());\n"
+        "    if (block.thread_rank() == 0) {{\n"
+        "      {1}[row] = cast_to<{2}>(acc[0]);\n"
+        "    }}\n"
+        "    // The next row reuses the shared memory.\n"
+        "    block.sync();\n"
+        "  }}\n"
+        "}}\n",
+        namer.get_name(reduce.inputs()[0]),
+        out_name,
+        out_type);
+    return {name, std::move(os), param_types(params)};
+  }
+
+ private:
+  // The constants are read like the scalar inputs instead of being written
+  // in the source, so the kernels do not depend on their values.
+  bool is_scalar_input(size_t i) {
+    return is_scalar(inputs[i]) || is_constant(i);
+  }
+
+  std::vector<std::string> input_params(NodeNamer& namer, bool contiguous) {
+    std::vector<std::string> params;
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      const std::string& xname = namer.get_name(x);
+      params.push_back(
+          fmt::format("const {}* {}", dtype_to_cuda_type(x.dtype()), xname));
+      if (!is_scalar_input(i) && !contiguous) {
+        params.push_back(fmt::format(
+            "const __grid_constant__ cuda::std::array<int64_t, NDIM> {}_strides",
+            xname));
+      }
+    }
+    return params;
+  }
+
+  void write_signature(
+      const std::string& name,
+      const std::vector<std::string>& params,
+      const char* qualifier = "__global__") {
+    os += fmt::format("{} void {}(\n", qualifier, name);
     for (size_t i = 0; i < params.size(); ++i) {
       os += "    ";
       os += params[i];
@@ -67,66 +251,157 @@ struct FusedKernelBuilder {
       }
     }
     os += ") {\n";
+    // The kernels are launched as dependent kernels.
+    if (std::string_view(qualifier) == "__global__") {
+      os +=
+          "  launch_dependent_grids();\n"
+          "  wait_prerequisite_grids();\n";
+    }
+  }
+
+  // The types of the parameters, without their names.
+  static std::vector<std::string> param_types(
+      const std::vector<std::string>& params) {
+    std::vector<std::string> types;
+    for (const auto& param : params) {
+      types.push_back(param.substr(0, param.rfind(' ')));
+    }
+    return types;
+  }
+
+  // Compute the location of |index| in each strided input.
+  void write_indices(NodeNamer& namer, const std::string& indent) {
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      const std::string& xname = namer.get_name(x);
+      if (is_scalar_input(i)) {
+        continue;
+      }
+      os += indent + "IdxT " + xname + "_idx = 0;\n";
+    }
+    os += indent + "{\n";
+    os += indent + "  IdxT loc = index;\n";
+    os += indent + "  #pragma unroll\n";
+    os += indent + "  for (int i = NDIM - 1; i >= 0; i--) {\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      const std::string& xname = namer.get_name(x);
+      if (is_scalar_input(i)) {
+        continue;
+      }
+      os += indent + "    " + xname + "_idx += (loc \% shape[i]) * IdxT(" +
+          xname + "_strides[i]);\n";
+    }
+    os += indent + "    loc /= shape[i];\n";
+    os += indent + "  }\n";
+    os += indent + "}\n";
+  }
+
+  // Each thread of a contiguous kernel loads and stores vectors of
+  // |work_per_thread| elements, except for the remainder at the end.
+  void write_contiguous_body(NodeNamer& namer) {
+    os +=
+        "  IdxT index = cg::this_grid().thread_rank();\n"
+        "  if ((index + 1) * work_per_thread > size) {\n"
+        "    for (index = index * work_per_thread; index < size; index++) {\n";
+    write_values(namer, Read::Contiguous, "      ");
+    for (const auto& x : outputs) {
+      os += fmt::format("      {0}[index] = tmp_{0};\n", namer.get_name(x));
+    }
+    os +=
+        "    }\n"
+        "    return;\n"
+        "  }\n"
+        "\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      if (is_scalar_input(i)) {
+        continue;
+      }
+      os += fmt::format(
+          "  auto vec_{0} = load_vector<work_per_thread>({0}, index);\n",
+          namer.get_name(x));
+    }
+    for (const auto& x : outputs) {
+      os += fmt::format(
+          "  AlignedVector<{}, work_per_thread> vec_{};\n",
+          dtype_to_cuda_type(x.dtype()),
+          namer.get_name(x));
+    }
+    os +=
+        "  #pragma unroll\n"
+        "  for (int i = 0; i < work_per_thread; i++) {\n";
+    write_values(namer, Read::Vector, "    ");
+    for (const auto& x : outputs) {
+      os += fmt::format("    vec_{0}.val[i] = tmp_{0};\n", namer.get_name(x));
+    }
+    os += "  }\n";
+    for (const auto& x : outputs) {
+      os += fmt::format(
+          "  store_vector<work_per_thread>({0}, index, vec_{0});\n",
+          namer.get_name(x));
+    }
+  }
 
-    // Index. For non contiguous kernels we create a separate index
-    // variable per variable otherwise everyone uses `index`.
+  // Each thread of a strided kernel computes |work_per_thread| consecutive
+  // elements of the last dimension. For non contiguous kernels we create a
+  // separate index variable per variable.
+  void write_strided_body(NodeNamer& namer) {
     os +=
         "  IdxT index = cg::this_grid().thread_rank() * work_per_thread;\n"
         "  if (index >= size) {\n"
         "    return;\n"
         "  }\n";
-    if (!contiguous) {
-      for (size_t i = 0; i < inputs.size(); ++i) {
-        const auto& x = inputs[i];
-        const std::string& xname = namer.get_name(x);
-        if (is_scalar(x) || is_constant(i)) {
-          continue;
-        }
-        os += "  IdxT " + xname + "_idx = 0;\n";
-      }
-      os += "  {\n";
-      os += "    IdxT loc = index;\n";
-      os +=
-          "    #pragma unroll\n"
-          "    for (int i = NDIM - 1; i >= 0; i--) {\n";
-      for (size_t i = 0; i < inputs.size(); ++i) {
-        const auto& x = inputs[i];
-        const std::string& xname = namer.get_name(x);
-        if (is_scalar(x) || is_constant(i)) {
-          continue;
-        }
-        os += "      " + xname + "_idx += (loc \% shape[i]) * IdxT(" + xname +
-            "_strides[i]);\n";
-      }
-      os +=
-          "      loc /= shape[i];\n"
-          "    }\n"
-          "  }\n";
-    }
+    write_indices(namer, "  ");
 
     // Work loop
     os +=
         "\n"
         "  for (int i = 0; i < work_per_thread && index < size; i++) {\n";
+    write_values(namer, Read::Strided, "    ");
+
+    // Write output.
+    for (const auto& x : outputs) {
+      os += fmt::format("    {0}[index] = tmp_{0};\n", namer.get_name(x));
+    }
+
+    // End of work loop
+    os +=
+        "\n"
+        "    index++;\n";
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      const auto& x = inputs[i];
+      const std::string& xname = namer.get_name(x);
+      if (is_scalar_input(i)) {
+        continue;
+      }
+      os += "    " + xname + "_idx += " + xname + "_strides[NDIM - 1];\n";
+    }
+    os += "  }\n";
+  }
+
+  // How the inputs are read: at |index|, at their own strided index, or from
+  // the vectors loaded by the thread.
+  enum class Read { Contiguous, Strided, Vector };
 
+  // Read the inputs and compute the values of the tape.
+  void write_values(NodeNamer& namer, Read read, const std::string& indent) {
     // Read inputs.
     for (size_t i = 0; i < inputs.size(); ++i) {
       const auto& x = inputs[i];
       const std::string& xname = namer.get_name(x);
       std::string type = dtype_to_cuda_type(x.dtype());
       std::string value;
-      if (is_constant(i)) {
-        std::ostringstream ss;
-        print_constant(ss, x);
-        value = fmt::format("static_cast<{}>({})", type, ss.str());
-      } else if (is_scalar(x)) {
+      if (is_scalar_input(i)) {
         value = fmt::format("{}[0]", xname);
-      } else if (contiguous) {
+      } else if (read == Read::Contiguous) {
         value = fmt::format("{}[index]", xname);
+      } else if (read == Read::Vector) {
+        value = fmt::format("vec_{}.val[i]", xname);
       } else {
         value = fmt::format("{}[{}_idx]", xname, xname);
       }
-      os += fmt::format("    {} tmp_{} = {};\n", type, xname, value);
+      os += fmt::format("{}{} tmp_{} = {};\n", indent, type, xname, value);
     }
 
     // Write tape.
@@ -145,31 +420,8 @@ struct FusedKernelBuilder {
         }
         value += fmt::format("tmp_{})", namer.get_name(x.inputs().back()));
       }
-      os += fmt::format("    {} tmp_{} = {};\n", type, xname, value);
-    }
-
-    // Write output.
-    for (const auto& x : outputs) {
-      os += fmt::format("    {0}[index] = tmp_{0};\n", namer.get_name(x));
-    }
-
-    // End of work loop
-    os +=
-        "\n"
-        "    index++;\n";
-    if (!contiguous) {
-      for (size_t i = 0; i < inputs.size(); ++i) {
-        const auto& x = inputs[i];
-        const std::string& xname = namer.get_name(x);
-        if (is_scalar(x) || is_constant(i)) {
-          continue;
-        }
-        os += "    " + xname + "_idx += " + xname + "_strides[NDIM - 1];\n";
-      }
+      os += fmt::format("{}{} tmp_{} = {};\n", indent, type, xname, value);
     }
-    os += "  }\n";
-
-    os += "}\n";
   }
 };
 
@@ -179,6 +431,7 @@ constexpr const char* g_jit_includes = R"(
 #include "mlx/backend/cuda/device/binary_ops.cuh"
 #include "mlx/backend/cuda/device/ternary_ops.cuh"
 #include "mlx/backend/cuda/device/unary_ops.cuh"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
 #include "mlx/backend/cuda/device/utils.cuh"
 
 #include <cooperative_groups.h>
@@ -186,16 +439,328 @@ constexpr const char* g_jit_includes = R"(
 #define inf cuda::std::numeric_limits<float>::infinity()
 )";
 
+namespace {
+
+// The number of elements computed by each thread, so that it loads and stores
+// 16 bytes of the widest of the inputs and outputs.
+int fused_work_per_thread(
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs,
+    const std::function<bool(size_t)>& is_constant) {
+  size_t itemsize = 1;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (!is_constant(i) && !is_scalar(inputs[i])) {
+      itemsize = std::max(itemsize, inputs[i].itemsize());
+    }
+  }
+  for (const auto& x : outputs) {
+    itemsize = std::max(itemsize, x.itemsize());
+  }
+  return std::max<int>(16 / itemsize, 1);
+}
+
+// The source and kernel names of a tape of elementwise ops followed by a
+// reduction of their trailing axes.
+std::pair<std::string, std::vector<std::string>> build_reduce_source(
+    const std::string& lib_name,
+    const std::vector<array>& inputs,
+    const std::vector<array>& outputs,
+    const std::vector<array>& tape,
+    const std::function<bool(size_t)>& is_constant) {
+  std::vector<array> elementwise(tape.begin(), tape.end() - 1);
+  const array& reduce = tape.back();
+  cu::FusedKernelBuilder builder{
+      g_jit_includes, lib_name, inputs, outputs, elementwise, is_constant};
+  builder.os +=
+      "namespace mlx::core::cu {\n\n"
+      "namespace cg = cooperative_groups;\n\n";
+  builder.build_reduce_init("_reduce_init", reduce);
+  builder.os += "\n";
+  builder.build_reduce("_reduce_contiguous", true, reduce);
+  builder.os += "\n";
+  builder.build_reduce("_reduce_strided", false, reduce);
+  builder.os += "\n} // namespace mlx::core::cu\n";
+  std::vector<std::string> kernel_names;
+  for (const char* index_type : {"uint32_t", "int64_t"}) {
+    kernel_names.push_back(fmt::format(
+        "mlx::core::cu::{}_reduce_init<{}>", lib_name, index_type));
+    kernel_names.push_back(fmt::format(
+        "mlx::core::cu::{}_reduce_contiguous<{}>", lib_name, index_type));
+    for (int i = 1; i <= MAX_NDIM; ++i) {
+      kernel_names.push_back(fmt::format(
+          "mlx::core::cu::{}_reduce_strided<{}, {}>",
+          lib_name,
+          i,
+          index_type));
+    }
+  }
+  return std::make_pair(std::move(builder.os), std::move(kernel_names));
+}
+
+// The name of the kernels of a tape. The kernels read the constants like the
+// scalar inputs, so the name has their dtypes instead of the hash of their
+// values that ends |lib_name|. The tapes only differing by their constants,
+// such as the scales of the means over different lengths, then share their
+// kernels and the PTX cached for them.
+std::string kernel_lib_name(
+    const std::string& lib_name,
+    const std::vector<array>& inputs,
+    const std::function<bool(size_t)>& is_constant) {
+  std::ostringstream os;
+  os << lib_name.substr(0, lib_name.rfind('_') + 1);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (is_constant(i)) {
+      os << kindof(inputs[i].dtype()) << inputs[i].itemsize();
+    }
+  }
+  return os.str();
+}
+
+// Get the kernel, or nullptr when it is being compiled in the background.
+CUfunction get_fused_kernel(cu::JitModule& mod, const std::string& name) {
+  if (cu::async_jit_enabled()) {
+    return mod.get_kernel_async(name);
+  }
+  return mod.get_kernel(name);
+}
+
+// Evaluate the primitives of the tape one by one with their own kernels,
+// while the fused kernel is compiled in the background.
+void eval_unfused(
+    const std::vector<array>& tape_inputs,
+    const std::vector<array>& tape_outputs,
+    const std::vector<array>& tape,
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs,
+    const Stream& s) {
+  auto& encoder = cu::get_command_encoder(s);
+  std::unordered_map<uintptr_t, array> values;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    values.emplace(tape_inputs[i].id(), inputs[i]);
+  }
+  for (const auto& a : tape) {
+    std::vector<array> ins;
+    for (const auto& in : a.inputs()) {
+      ins.push_back(values.at(in.id()));
+    }
+    std::vector<array> outs{array(
+        a.primitive().output_shapes(ins)[0],
+        a.dtype(),
+        a.primitive_ptr(),
+        ins)};
+    a.primitive().eval_gpu(ins, outs);
+    encoder.add_temporary(outs[0]);
+    values.emplace(a.id(), std::move(outs[0]));
+  }
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    outputs[i].copy_shared_buffer(values.at(tape_outputs[i].id()));
+  }
+}
+
+// Launch the fused reduction, returns false when its kernels are not
+// compiled yet.
+bool eval_reduce(
+    cu::JitModule& mod,
+    const std::string& lib_name,
+    const std::vector<array>& tape_inputs,
+    const std::vector<array>& tape_outputs,
+    const std::vector<array>& tape,
+    const std::vector<array>& inputs,
+    array& out,
+    const std::function<bool(size_t)>& is_constant,
+    const Stream& s) {
+  const array& reduce = tape.back();
+  auto axes = static_cast<Reduce&>(reduce.primitive()).state().second;
+
+  // The shape of the elementwise ops, which is the output shape with the
+  // reduced axes of the inputs.
+  Shape shape = out.shape();
+  for (auto ax : axes) {
+    shape[ax] = reduce.inputs()[0].shape(ax);
+    for (const auto& x : inputs) {
+      int d = ax - static_cast<int>(shape.size() - x.ndim());
+      if (d >= 0) {
+        shape[ax] = std::max(shape[ax], x.shape(d));
+      }
+    }
+  }
+  int64_t row_size = 1;
+  for (auto ax : axes) {
+    row_size *= shape[ax];
+  }
+  int64_t rows = out.size();
+
+  if (rows == 0) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    return true;
+  }
+  bool large = rows * row_size > UINT32_MAX;
+  const char* index_type = large ? "int64_t" : "uint32_t";
+
+  // Read the inputs at the output index when they all have its layout,
+  // otherwise broadcast them to the shape and collapse the dims.
+  bool contiguous = true;
+  std::vector<Strides> strides_vec{Strides(shape.size(), 1)};
+  for (int i = static_cast<int>(shape.size()) - 2; i >= 0; --i) {
+    strides_vec[0][i] = strides_vec[0][i + 1] * shape[i + 1];
+  }
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const auto& x = inputs[i];
+    if (is_constant(i) || is_scalar(x)) {
+      continue;
+    }
+    contiguous &= x.flags().row_contiguous && x.shape() == shape;
+    Strides xstrides(shape.size() - x.ndim(), 0);
+    for (int j = 0; j < x.ndim(); ++j) {
+      xstrides.push_back(x.shape(j) == 1 ? 0 : x.strides(j));
+    }
+    strides_vec.push_back(std::move(xstrides));
+  }
+  if (!contiguous) {
+    std::tie(shape, strides_vec) = collapse_contiguous_dims(shape, strides_vec);
+    contiguous = shape.empty();
+  }
+
+  // One block reduces a row, split the rows to more blocks and accumulate
+  // them atomically when there are too few rows to fill the GPU.
+  int block_dim = WARP_SIZE;
+  while (block_dim < row_size && block_dim < 1024) {
+    block_dim *= 2;
+  }
+  // The small reductions run in a megakernel with a block per row.
+  bool stage = contiguous && !large && cu::megakernel_enabled() &&
+      rows * row_size <= cu::megakernel_max_size();
+  int64_t blocks_per_row = 1;
+  if (rows < 1024 && !stage) {
+    blocks_per_row = std::min(
+        cuda::ceil_div(row_size, int64_t(block_dim) * 8),
+        cuda::ceil_div(int64_t(1024), rows));
+    blocks_per_row = std::clamp(blocks_per_row, int64_t(1), int64_t(65535));
+  }
+
+  // Get the kernels.
+  std::string kernel_name = fmt::format("mlx::core::cu::{}", lib_name);
+  if (contiguous) {
+    kernel_name += fmt::format("_reduce_contiguous<{}>", index_type);
+  } else {
+    kernel_name +=
+        fmt::format("_reduce_strided<{}, {}>", shape.size(), index_type);
+  }
+  CUfunction kernel = get_fused_kernel(mod, kernel_name);
+  CUfunction init_kernel = nullptr;
+  if (blocks_per_row > 1) {
+    init_kernel = get_fused_kernel(
+        mod,
+        fmt::format(
+            "mlx::core::cu::{}_reduce_init<{}>", lib_name, index_type));
+  }
+  if (!kernel || (blocks_per_row > 1 && !init_kernel)) {
+    return false;
+  }
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  cu::KernelArgs args;
+  // Put inputs.
+  int strides_index = 1;
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    const auto& x = inputs[i];
+    args.append(x);
+    if (!contiguous && !is_scalar(x) && !is_constant(i)) {
+      args.append_ptr(strides_vec[strides_index++].data());
+    }
+  }
+
+  // Put output, shape and size.
+  args.append(out);
+  if (!contiguous) {
+    args.append_ptr(shape.data());
+  }
+  if (large) {
+    args.append<int64_t>(row_size);
+  } else {
+    args.append<uint32_t>(row_size);
+  }
+
+  auto& encoder = cu::get_command_encoder(s);
+  if (stage) {
+    std::string stage_name = lib_name + "_reduce_stage";
+    auto& source = cu::megakernel_source(stage_name, [&]() {
+      std::vector<array> elementwise(tape.begin(), tape.end() - 1);
+      cu::FusedKernelBuilder builder{
+          "", lib_name, tape_inputs, tape_outputs, elementwise, is_constant};
+      return builder.build_reduce_stage(stage_name, reduce);
+    });
+    args.append<uint32_t>(rows);
+    encoder.add_megakernel_stage(cu::MegakernelStage{
+        &source,
+        kernel,
+        dim3(rows),
+        dim3(block_dim),
+        std::move(args),
+        static_cast<uint32_t>(rows),
+        inputs,
+        {out}});
+    return true;
+  }
+  if (init_kernel) {
+    encoder.set_output_array(out);
+    auto [num_blocks, block_dims] = get_launch_args(init_kernel, out, large);
+    cu::KernelArgs init_args;
+    init_args.append(out);
+    if (large) {
+      init_args.append<int64_t>(rows);
+    } else {
+      init_args.append<uint32_t>(rows);
+    }
+    encoder.add_dependent_kernel_node(
+        init_kernel, num_blocks, block_dims, init_args.args());
+  }
+
+  for (const auto& in : inputs) {
+    encoder.set_input_array(in);
+  }
+  encoder.set_output_array(out);
+  encoder.add_dependent_kernel_node(
+      kernel, dim3(rows, blocks_per_row), dim3(block_dim), args.args());
+  return true;
+}
+
+} // namespace
+
 void Compiled::eval_gpu(
     const std::vector<array>& inputs,
     std::vector<array>& outputs) {
   nvtx3::scoped_range r("Compiled::eval_gpu");
   auto& s = stream();
+  std::string kernel_lib = kernel_lib_name(lib_name(), inputs_, is_constant_);
 
-  cu::JitModule& mod = cu::get_jit_module(s.device, lib_name(), [&]() {
+  // Elementwise ops fused into a reduction.
+  if (typeid(tape_.back().primitive()) == typeid(Reduce)) {
+    cu::JitModule& mod = cu::get_jit_module(s.device, kernel_lib, [&]() {
+      return build_reduce_source(
+          kernel_lib, inputs_, outputs_, tape_, is_constant_);
+    });
+    if (!eval_reduce(
+            mod,
+            kernel_lib,
+            inputs_,
+            outputs_,
+            tape_,
+            inputs,
+            outputs[0],
+            is_constant_,
+            s)) {
+      eval_unfused(inputs_, outputs_, tape_, inputs, outputs, s);
+    }
+    return;
+  }
+
+  int max_work_per_thread =
+      fused_work_per_thread(inputs_, outputs_, is_constant_);
+  cu::JitModule& mod = cu::get_jit_module(s.device, kernel_lib, [&]() {
     // Build source code.
     cu::FusedKernelBuilder builder{
-        g_jit_includes, lib_name(), inputs_, outputs_, tape_, is_constant_};
+        g_jit_includes, kernel_lib, inputs_, outputs_, tape_, is_constant_};
     builder.os +=
         "namespace mlx::core::cu {\n\n"
         "namespace cg = cooperative_groups;\n\n";
@@ -205,24 +770,28 @@ void Compiled::eval_gpu(
     builder.os += "\n} // namespace mlx::core::cu\n";
     // Build kernel names.
     std::vector<std::string> kernel_names;
-    for (auto work_per_thread : std::array<int, 2>{1, 4}) {
+    std::vector<int> work_per_threads{1};
+    if (max_work_per_thread > 1) {
+      work_per_threads.push_back(max_work_per_thread);
+    }
+    for (auto work_per_thread : work_per_threads) {
       kernel_names.push_back(fmt::format(
           "mlx::core::cu::{}_contiguous<uint32_t, {}>",
-          lib_name(),
+          kernel_lib,
           work_per_thread));
       kernel_names.push_back(fmt::format(
           "mlx::core::cu::{}_contiguous<int64_t, {}>",
-          lib_name(),
+          kernel_lib,
           work_per_thread));
       for (int i = 1; i <= MAX_NDIM; ++i) {
         kernel_names.push_back(fmt::format(
             "mlx::core::cu::{}_strided<{}, uint32_t, {}>",
-            lib_name(),
+            kernel_lib,
             i,
             work_per_thread));
         kernel_names.push_back(fmt::format(
             "mlx::core::cu::{}_strided<{}, int64_t, {}>",
-            lib_name(),
+            kernel_lib,
             i,
             work_per_thread));
       }
@@ -238,16 +807,35 @@ void Compiled::eval_gpu(
   // Whether to use large index.
   bool large = compiled_use_large_index(inputs, outputs, contiguous);
 
+  // Choose work per thread
+  int work_per_thread = max_work_per_thread;
+  if (!contiguous && shape.back() % work_per_thread != 0) {
+    work_per_thread = 1;
+  }
+
+  // Get the kernel, or run the tape unfused until it is compiled.
+  const char* index_type = large ? "int64_t" : "uint32_t";
+  std::string kernel_name = fmt::format("mlx::core::cu::{}", kernel_lib);
+  if (contiguous) {
+    kernel_name +=
+        fmt::format("_contiguous<{}, {}>", index_type, work_per_thread);
+  } else {
+    kernel_name += fmt::format(
+        "_strided<{}, {}, {}>", shape.size(), index_type, work_per_thread);
+  }
+  auto kernel = get_fused_kernel(mod, kernel_name);
+  if (!kernel) {
+    eval_unfused(inputs_, outputs_, tape_, inputs, outputs, s);
+    return;
+  }
+
   cu::KernelArgs args;
   // Put inputs.
   int strides_index = 1;
   for (size_t i = 0; i < inputs.size(); ++i) {
-    if (is_constant_(i)) {
-      continue;
-    }
     const auto& x = inputs[i];
     args.append(x);
-    if (!contiguous && !is_scalar(x)) {
+    if (!contiguous && !is_scalar(x) && !is_constant_(i)) {
       args.append_ptr(strides_vec[strides_index++].data());
     }
   }
@@ -268,34 +856,41 @@ void Compiled::eval_gpu(
     args.append<uint32_t>(outputs[0].data_size());
   }
 
-  // Choose work per thread
-  int work_per_thread = 4;
-  if (!contiguous && shape.back() % work_per_thread != 0) {
-    work_per_thread = 1;
-  }
-
   // Launch kernel.
-  const char* index_type = large ? "int64_t" : "uint32_t";
-  std::string kernel_name = fmt::format("mlx::core::cu::{}", lib_name());
-  if (contiguous) {
-    kernel_name +=
-        fmt::format("_contiguous<{}, {}>", index_type, work_per_thread);
-  } else {
-    kernel_name += fmt::format(
-        "_strided<{}, {}, {}>", shape.size(), index_type, work_per_thread);
-  }
   auto& encoder = cu::get_command_encoder(s);
+  auto [num_blocks, block_dims] =
+      get_launch_args(kernel, outputs[0], large, work_per_thread);
+
+  // The small kernels run in a megakernel with the next ones.
+  int64_t size = outputs[0].data_size();
+  if (contiguous && !large && cu::megakernel_enabled() &&
+      size <= cu::megakernel_max_size()) {
+    std::string stage_name = kernel_lib + "_stage";
+    auto& source = cu::megakernel_source(stage_name, [&]() {
+      cu::FusedKernelBuilder builder{
+          "", kernel_lib, inputs_, outputs_, tape_, is_constant_};
+      return builder.build_stage(stage_name);
+    });
+    encoder.add_megakernel_stage(cu::MegakernelStage{
+        &source,
+        kernel,
+        num_blocks,
+        dim3(block_dims),
+        std::move(args),
+        static_cast<uint32_t>(
+            cuda::ceil_div(size, int64_t(cu::megakernel_block_dim))),
+        inputs,
+        outputs});
+    return;
+  }
   for (const auto& in : inputs) {
     encoder.set_input_array(in);
   }
   for (const auto& out : outputs) {
     encoder.set_output_array(out);
   }
-
-  auto kernel = mod.get_kernel(kernel_name);
-  auto [num_blocks, block_dims] =
-      get_launch_args(kernel, outputs[0], large, work_per_thread);
-  encoder.add_kernel_node(kernel, num_blocks, block_dims, args.args());
+  encoder.add_dependent_kernel_node(
+      kernel, num_blocks, block_dims, args.args());
 }
 
 } // namespace mlx::core
@@ -0,0 +1,603 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/mma.cuh"
+#include "mlx/backend/cuda/device/utils.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+// The input is [N, spatial..., C], the weight is [O, spatial..., C / groups]
+// and the output is [N, spatial..., O], all row contiguous.
+template <int NDIM>
+struct ConvParams {
+  int M; // N * prod(out_spatial)
+  int K; // prod(wt_spatial) * C / groups
+  int C;
+  int O;
+  int groups;
+  int in_spatial[NDIM];
+  int out_spatial[NDIM];
+  int wt_spatial[NDIM];
+  int strides[NDIM];
+  int padding[NDIM];
+  int kernel_dilation[NDIM];
+  int input_dilation[NDIM];
+  int64_t in_strides[NDIM + 1];
+  int64_t out_strides[NDIM + 1];
+  bool flip;
+};
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// The convolution as an implicit GEMM, for each group the output
+// [M, O / groups] is the product of the unfolded input [M, K] and the
+// weight [O / groups, K]. The tiles of the unfolded input are gathered from
+// the input when loaded to shared memory, the padding and the holes of the
+// input dilation are read as zeros.
+template <typename T, int NDIM, int BM = 64, int BN = 64, int BK = 32>
+__global__ void implicit_gemm_conv(
+    const T* in,
+    const T* wt,
+    T* out,
+    const __grid_constant__ ConvParams<NDIM> params) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  constexpr int NUM_THREADS = 128;
+
+  __shared__ __align__(32) T xs[BM * LDS];
+  __shared__ __align__(32) T ws[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  // The batch offset and the first input position of the rows of the tile,
+  // the position is in the coordinates of the dilated and padded input.
+  __shared__ int64_t row_offset[BM];
+  __shared__ int row_pos[BM][NDIM];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  // The rows are on the x dim of the grid which has no 65535 limit.
+  int m0 = blockIdx.x * BM;
+  int n0 = blockIdx.y * BN;
+  int g = blockIdx.z;
+  int M = params.M;
+  int K = params.K;
+  int C_per_group = params.C / params.groups;
+  int O_per_group = params.O / params.groups;
+
+  for (int r = tid; r < BM; r += NUM_THREADS) {
+    int m = min(m0 + r, M - 1);
+#pragma unroll
+    for (int i = NDIM - 1; i >= 0; --i) {
+      row_pos[r][i] =
+          (m % params.out_spatial[i]) * params.strides[i] - params.padding[i];
+      m /= params.out_spatial[i];
+    }
+    row_offset[r] = m * params.in_strides[0] + g * C_per_group;
+  }
+
+  wt += int64_t(g) * O_per_group * K;
+  out += g * O_per_group;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = 0; k0 < K; k0 += BK) {
+    block.sync();
+    for (int i = tid; i < BM * BK; i += NUM_THREADS) {
+      int r = i / BK;
+      int c = i % BK;
+      int k = k0 + c;
+      T val = static_cast<T>(0);
+      if (m0 + r < M && k < K) {
+        int kk = k / C_per_group;
+        int64_t loc = row_offset[r] + k % C_per_group;
+        bool valid = true;
+#pragma unroll
+        for (int j = NDIM - 1; j >= 0; --j) {
+          int w = kk % params.wt_spatial[j];
+          kk /= params.wt_spatial[j];
+          if (params.flip) {
+            w = params.wt_spatial[j] - 1 - w;
+          }
+          int pos = row_pos[r][j] + w * params.kernel_dilation[j];
+          int dil = params.input_dilation[j];
+          int p = pos / dil;
+          valid &= pos >= 0 && p * dil == pos && p < params.in_spatial[j];
+          loc += p * params.in_strides[j + 1];
+        }
+        if (valid) {
+          val = in[loc];
+        }
+      }
+      xs[r * LDS + c] = val;
+    }
+    load_tile<BN, BK, LDS, NUM_THREADS, false>(
+        ws, wt, K, n0, k0, O_per_group, K, tid);
+    block.sync();
+
+    mma.mma(xs, ws);
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, NUM_THREADS>(
+      cs, out, params.O, m0, n0, M, O_per_group, tid);
+}
+
+// The gradient of the input as an implicit GEMM, for each group the input
+// gradient [M, C / groups] is the product of the unfolded output gradient
+// [M, K] and the weight seen as [C / groups, K], with M = N *
+// prod(in_spatial) and K = prod(wt_spatial) * O / groups. An input position
+// gathers the output positions which read it in the forward through each
+// weight position, the others are read as zeros.
+template <typename T, int NDIM, int BM = 64, int BN = 64, int BK = 32>
+__global__ void implicit_gemm_conv_dgrad(
+    const T* cotan,
+    const T* wt,
+    T* grad,
+    const __grid_constant__ ConvParams<NDIM> params,
+    int M) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  constexpr int NUM_THREADS = 128;
+
+  __shared__ __align__(32) T xs[BM * LDS];
+  __shared__ __align__(32) T ws[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  // The batch offset and the position of the rows of the tile in the
+  // coordinates of the dilated and padded input.
+  __shared__ int64_t row_offset[BM];
+  __shared__ int row_pos[BM][NDIM];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.x * BM;
+  int n0 = blockIdx.y * BN;
+  int g = blockIdx.z;
+  int C_per_group = params.C / params.groups;
+  int O_per_group = params.O / params.groups;
+  int K = params.K / C_per_group * O_per_group;
+
+  for (int r = tid; r < BM; r += NUM_THREADS) {
+    int m = min(m0 + r, M - 1);
+#pragma unroll
+    for (int i = NDIM - 1; i >= 0; --i) {
+      row_pos[r][i] = (m % params.in_spatial[i]) * params.input_dilation[i] +
+          params.padding[i];
+      m /= params.in_spatial[i];
+    }
+    row_offset[r] = m * params.out_strides[0] + g * O_per_group;
+  }
+
+  wt += int64_t(g) * O_per_group * params.K;
+  grad += g * C_per_group;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = 0; k0 < K; k0 += BK) {
+    block.sync();
+    for (int i = tid; i < BM * BK; i += NUM_THREADS) {
+      int r = i / BK;
+      int c = i % BK;
+      int k = k0 + c;
+      T val = static_cast<T>(0);
+      if (m0 + r < M && k < K) {
+        int kk = k / O_per_group;
+        int64_t loc = row_offset[r] + k % O_per_group;
+        bool valid = true;
+#pragma unroll
+        for (int j = NDIM - 1; j >= 0; --j) {
+          int w = kk % params.wt_spatial[j];
+          kk /= params.wt_spatial[j];
+          if (params.flip) {
+            w = params.wt_spatial[j] - 1 - w;
+          }
+          int pos = row_pos[r][j] - w * params.kernel_dilation[j];
+          int stride = params.strides[j];
+          int y = pos / stride;
+          valid &= pos >= 0 && y * stride == pos && y < params.out_spatial[j];
+          loc += y * params.out_strides[j + 1];
+        }
+        if (valid) {
+          val = cotan[loc];
+        }
+      }
+      xs[r * LDS + c] = val;
+    }
+    // The element (c, (w, o)) of the weight is wt[o, w, c], consecutive
+    // threads walk the channels.
+    for (int i = tid; i < BN * BK; i += NUM_THREADS) {
+      int r = i % BN;
+      int c = i / BN;
+      int n = n0 + r;
+      int k = k0 + c;
+      T val = static_cast<T>(0);
+      if (n < C_per_group && k < K) {
+        int w = k / O_per_group;
+        int o = k % O_per_group;
+        val = wt[int64_t(o) * params.K + w * C_per_group + n];
+      }
+      ws[r * LDS + c] = val;
+    }
+    block.sync();
+
+    mma.mma(xs, ws);
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, NUM_THREADS>(
+      cs, grad, params.C, m0, n0, M, C_per_group, tid);
+}
+
+// The gradient of the weight as an implicit GEMM, for each group the
+// weight gradient [O / groups, prod(wt_spatial) * C / groups] is the
+// product of the transposed output gradient [O / groups, M] and the
+// unfolded input [M, prod(wt_spatial) * C / groups]. The long reduction
+// over M is split across gridDim.z / groups blocks which add their partial
+// products to the float |grad|.
+template <typename T, int NDIM, int BM = 64, int BN = 64, int BK = 32>
+__global__ void implicit_gemm_conv_wgrad(
+    const T* cotan,
+    const T* in,
+    float* grad,
+    const __grid_constant__ ConvParams<NDIM> params,
+    int chunk) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  constexpr int NUM_THREADS = 128;
+
+  __shared__ __align__(32) T xs[BM * LDS];
+  __shared__ __align__(32) T ws[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  // The batch offset and the first input position of the output positions
+  // of the tile, in the coordinates of the dilated and padded input.
+  __shared__ int64_t col_offset[BK];
+  __shared__ int col_pos[BK][NDIM];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int n0 = blockIdx.x * BN;
+  int m0 = blockIdx.y * BM;
+  int splits = gridDim.z / params.groups;
+  int g = blockIdx.z / splits;
+  int k_begin = (blockIdx.z % splits) * chunk;
+  int k_end = min(k_begin + chunk, params.M);
+  int C_per_group = params.C / params.groups;
+  int O_per_group = params.O / params.groups;
+  int N = params.K;
+
+  cotan += g * O_per_group;
+  grad += int64_t(g) * O_per_group * N;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = k_begin; k0 < k_end; k0 += BK) {
+    block.sync();
+    for (int c = tid; c < BK; c += NUM_THREADS) {
+      int k = min(k0 + c, params.M - 1);
+#pragma unroll
+      for (int i = NDIM - 1; i >= 0; --i) {
+        col_pos[c][i] =
+            (k % params.out_spatial[i]) * params.strides[i] - params.padding[i];
+        k /= params.out_spatial[i];
+      }
+      col_offset[c] = k * params.in_strides[0] + g * C_per_group;
+    }
+    load_tile<BM, BK, LDS, NUM_THREADS, true>(
+        xs, cotan, params.O, m0, k0, O_per_group, k_end, tid);
+    block.sync();
+    // The element ((w, c), k) of the unfolded input, consecutive threads
+    // walk the channels.
+    for (int i = tid; i < BN * BK; i += NUM_THREADS) {
+      int r = i % BN;
+      int c = i / BN;
+      int n = n0 + r;
+      T val = static_cast<T>(0);
+      if (n < N && k0 + c < k_end) {
+        int kk = n / C_per_group;
+        int64_t loc = col_offset[c] + n % C_per_group;
+        bool valid = true;
+#pragma unroll
+        for (int j = NDIM - 1; j >= 0; --j) {
+          int w = kk % params.wt_spatial[j];
+          kk /= params.wt_spatial[j];
+          if (params.flip) {
+            w = params.wt_spatial[j] - 1 - w;
+          }
+          int pos = col_pos[c][j] + w * params.kernel_dilation[j];
+          int dil = params.input_dilation[j];
+          int p = pos / dil;
+          valid &= pos >= 0 && p * dil == pos && p < params.in_spatial[j];
+          loc += p * params.in_strides[j + 1];
+        }
+        if (valid) {
+          val = in[loc];
+        }
+      }
+      ws[r * LDS + c] = val;
+    }
+    block.sync();
+
+    mma.mma(xs, ws);
+  }
+
+  mma.store(cs);
+  block.sync();
+  for (int i = tid; i < BM * BN; i += NUM_THREADS) {
+    int r = i / BN;
+    int c = i % BN;
+    if (m0 + r < O_per_group && n0 + c < N) {
+      atomicAdd(&grad[int64_t(m0 + r) * N + n0 + c], cs[r * LDC + c]);
+    }
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_conv_ndim(int ndim, F&& f) {
+  switch (ndim) {
+    case 1:
+      f(std::integral_constant<int, 1>{});
+      break;
+    case 2:
+      f(std::integral_constant<int, 2>{});
+      break;
+    case 3:
+      f(std::integral_constant<int, 3>{});
+      break;
+    default:
+      throw std::invalid_argument(
+          fmt::format("[conv] Unsupported spatial dims {}.", ndim));
+  }
+}
+
+template <int NDIM>
+ConvParams<NDIM> make_conv_params(
+    const array& in,
+    const array& wt,
+    const array& out,
+    const std::vector<int>& strides,
+    const std::vector<int>& padding,
+    const std::vector<int>& kernel_dilation,
+    const std::vector<int>& input_dilation,
+    int groups,
+    bool flip) {
+  ConvParams<NDIM> params;
+  params.C = in.shape(-1);
+  params.O = wt.shape(0);
+  params.groups = groups;
+  params.M = out.size() / params.O;
+  params.K = wt.size() / params.O;
+  for (int i = 0; i < NDIM; ++i) {
+    params.in_spatial[i] = in.shape(i + 1);
+    params.out_spatial[i] = out.shape(i + 1);
+    params.wt_spatial[i] = wt.shape(i + 1);
+    params.strides[i] = strides[i];
+    params.padding[i] = padding[i];
+    params.kernel_dilation[i] = kernel_dilation[i];
+    params.input_dilation[i] = input_dilation[i];
+  }
+  for (int i = 0; i <= NDIM; ++i) {
+    params.in_strides[i] = in.strides(i);
+    params.out_strides[i] = out.strides(i);
+  }
+  params.flip = flip;
+  return params;
+}
+
+} // namespace
+
+void Convolution::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Convolution::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  if (out.dtype() == float64) {
+    throw std::runtime_error(
+        "[Convolution] float64 is not supported on the GPU.");
+  }
+
+  auto ensure_row_contiguous = [&](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  array in = ensure_row_contiguous(inputs[0]);
+  array wt = ensure_row_contiguous(inputs[1]);
+
+  enc.set_input_array(in);
+  enc.set_input_array(wt);
+  enc.set_output_array(out);
+
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  dispatch_conv_ndim(out.ndim() - 2, [&](auto ndim) {
+    auto params = make_conv_params<ndim.value>(
+        in,
+        wt,
+        out,
+        kernel_strides_,
+        padding_lo_,
+        kernel_dilation_,
+        input_dilation_,
+        groups_,
+        flip_);
+    dim3 num_blocks(
+        cuda::ceil_div(params.M, BM),
+        cuda::ceil_div(params.O / groups_, BN),
+        groups_);
+    dispatch_float_types(out.dtype(), "conv", [&](auto type_tag) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      auto kernel = cu::implicit_gemm_conv<DataType, ndim.value, BM, BN>;
+      enc.add_kernel_node(
+          kernel,
+          num_blocks,
+          128,
+          in.data<DataType>(),
+          wt.data<DataType>(),
+          out.data<DataType>(),
+          params);
+    });
+  });
+}
+
+namespace fast {
+
+bool ConvolutionVJP::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void ConvolutionVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("ConvolutionVJP::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto& out = outputs[0];
+
+  if (out.size() == 0) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    return;
+  }
+  if (out.dtype() == float64) {
+    throw std::runtime_error(
+        "[ConvolutionVJP] float64 is not supported on the GPU.");
+  }
+
+  auto ensure_row_contiguous = [&](const array& arr) {
+    if (arr.flags().row_contiguous) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  array cotan = ensure_row_contiguous(inputs[0]);
+  array other = ensure_row_contiguous(inputs[1]);
+
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  constexpr int BK = 32;
+  if (!weight_grad_) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    enc.set_input_array(cotan);
+    enc.set_input_array(other);
+    enc.set_output_array(out);
+    dispatch_conv_ndim(out.ndim() - 2, [&](auto ndim) {
+      auto params = make_conv_params<ndim.value>(
+          out,
+          other,
+          cotan,
+          kernel_strides_,
+          padding_lo_,
+          kernel_dilation_,
+          input_dilation_,
+          groups_,
+          flip_);
+      int M = out.size() / params.C;
+      dim3 num_blocks(
+          cuda::ceil_div(M, BM),
+          cuda::ceil_div(params.C / groups_, BN),
+          groups_);
+      dispatch_float_types(out.dtype(), "conv_vjp", [&](auto type_tag) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel =
+            cu::implicit_gemm_conv_dgrad<DataType, ndim.value, BM, BN, BK>;
+        enc.add_kernel_node(
+            kernel,
+            num_blocks,
+            128,
+            cotan.data<DataType>(),
+            other.data<DataType>(),
+            out.data<DataType>(),
+            params,
+            M);
+      });
+    });
+    return;
+  }
+
+  // The partial products of the splits of the reduction are added up in
+  // float32, in place when the gradient is float32.
+  array acc = out;
+  if (out.dtype() != float32) {
+    acc = array(out.shape(), float32, nullptr, {});
+    enc.add_temporary(acc);
+  }
+  array zero(0.0f, float32);
+  enc.add_temporary(zero);
+  fill_gpu(zero, acc, s);
+
+  if (cotan.size() > 0) {
+    enc.set_input_array(cotan);
+    enc.set_input_array(other);
+    enc.set_output_array(acc);
+    dispatch_conv_ndim(out.ndim() - 2, [&](auto ndim) {
+      auto params = make_conv_params<ndim.value>(
+          other,
+          out,
+          cotan,
+          kernel_strides_,
+          padding_lo_,
+          kernel_dilation_,
+          input_dilation_,
+          groups_,
+          flip_);
+      // Split the reduction over the batch and the output positions until
+      // the tiles of the weight gradient fill the GPU.
+      int tiles = cuda::ceil_div(params.K, BN) *
+          cuda::ceil_div(params.O / groups_, BM) * groups_;
+      int target = 4 * enc.device().multi_processor_count();
+      int max_splits = std::clamp(
+          cuda::ceil_div(params.M, 8 * BK), 1, std::max(65535 / groups_, 1));
+      int splits = std::clamp(cuda::ceil_div(target, tiles), 1, max_splits);
+      int chunk = cuda::ceil_div(cuda::ceil_div(params.M, splits), BK) * BK;
+      splits = cuda::ceil_div(params.M, chunk);
+      dim3 num_blocks(
+          cuda::ceil_div(params.K, BN),
+          cuda::ceil_div(params.O / groups_, BM),
+          groups_ * splits);
+      dispatch_float_types(out.dtype(), "conv_vjp", [&](auto type_tag) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel =
+            cu::implicit_gemm_conv_wgrad<DataType, ndim.value, BM, BN, BK>;
+        enc.add_kernel_node(
+            kernel,
+            num_blocks,
+            128,
+            cotan.data<DataType>(),
+            other.data<DataType>(),
+            acc.data<float>(),
+            params,
+            chunk);
+      });
+    });
+  }
+
+  if (out.dtype() != float32) {
+    copy_gpu(acc, out, CopyType::Vector, s);
+  }
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -32,7 +32,20 @@ void copy_gpu_inplace(
   if (ctype == CopyType::General || ctype == CopyType::GeneralGeneral) {
     auto [shape_collapsed, strides_vec] = collapse_contiguous_dims(
         shape, std::vector{strides_in, strides_out}, INT32_MAX);
-    if (ctype == CopyType::General) {
+    bool dynamic = dynamic_offset_in || dynamic_offset_out;
+    if (!dynamic &&
+        use_copy_transpose(shape_collapsed, strides_vec[0], strides_vec[1])) {
+      copy_transpose(
+          encoder,
+          ctype,
+          in,
+          out,
+          offset_in,
+          offset_out,
+          shape_collapsed,
+          strides_vec[0],
+          strides_vec[1]);
+    } else if (ctype == CopyType::General) {
       copy_general_input(
           encoder,
           ctype,
@@ -43,7 +56,7 @@ void copy_gpu_inplace(
           shape_collapsed,
           strides_vec[0]);
     } else {
-      if (dynamic_offset_in || dynamic_offset_out) {
+      if (dynamic) {
         copy_general_dynamic(
             encoder,
             ctype,
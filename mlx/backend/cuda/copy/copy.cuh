@@ -52,4 +52,22 @@ void copy_general_input(
     const Shape& shape,
     const Strides& strides_in);
 
+// Whether the copy is a (batched) 2-D transpose which copy_transpose handles
+// with coalesced reads and writes.
+bool use_copy_transpose(
+    const Shape& shape,
+    const Strides& strides_in,
+    const Strides& strides_out);
+
+void copy_transpose(
+    cu::CommandEncoder& encoder,
+    CopyType ctype,
+    const array& in,
+    array& out,
+    int64_t offset_in,
+    int64_t offset_out,
+    const Shape& shape,
+    const Strides& strides_in,
+    const Strides& strides_out);
+
 } // namespace mlx::core
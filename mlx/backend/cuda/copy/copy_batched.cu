@@ -0,0 +1,137 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/common/utils.h"
+#include "mlx/backend/cuda/copy/copy.cuh"
+#include "mlx/backend/cuda/copy/copy_batched.h"
+
+#include <algorithm>
+
+namespace mlx::core {
+
+namespace cu {
+
+// The copies of a launch are passed by value so the launch reads no memory
+// written by the host, which keeps it valid in a CUDA graph.
+constexpr int MAX_BATCHED_COPIES = 16;
+
+struct CopyBatch {
+  const void* in[MAX_BATCHED_COPIES];
+  void* out;
+  int64_t offset_out[MAX_BATCHED_COPIES];
+  int64_t size[MAX_BATCHED_COPIES];
+  int ndim[MAX_BATCHED_COPIES];
+  Shape shape[MAX_BATCHED_COPIES];
+  Strides strides_in[MAX_BATCHED_COPIES];
+  Strides strides_out[MAX_BATCHED_COPIES];
+};
+
+// The kernel parameters are limited to 4KB.
+static_assert(sizeof(CopyBatch) <= 4096);
+
+// The copy blockIdx.y is done by the blocks along x, the blocks past its
+// end return right away.
+template <typename T, typename IdxT>
+__global__ void copy_batched(const __grid_constant__ CopyBatch batch) {
+  int i = blockIdx.y;
+  IdxT index = IdxT(blockIdx.x) * blockDim.x + threadIdx.x;
+  if (index < batch.size[i]) {
+    auto [idx_in, idx_out] = elem_to_loc_4d(
+        index,
+        batch.shape[i].data(),
+        batch.strides_in[i].data(),
+        batch.strides_out[i].data(),
+        batch.ndim[i]);
+    const T* in = static_cast<const T*>(batch.in[i]);
+    T* out = static_cast<T*>(batch.out) + batch.offset_out[i];
+    out[idx_out] = in[idx_in];
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+// The copies only move elements, so they are dispatched on the size of the
+// dtype instead of on the dtype.
+template <typename F>
+void dispatch_element_size(int size, F&& f) {
+  switch (size) {
+    case 1:
+      f(type_identity<uint8_t>{});
+      break;
+    case 2:
+      f(type_identity<uint16_t>{});
+      break;
+    case 4:
+      f(type_identity<uint32_t>{});
+      break;
+    case 8:
+      f(type_identity<uint64_t>{});
+      break;
+    default:
+      throw std::runtime_error(
+          fmt::format("[copy_batched] Unsupported element size {}.", size));
+  }
+}
+
+} // namespace
+
+void copy_batched(
+    cu::CommandEncoder& encoder,
+    const std::vector<BatchedCopy>& copies,
+    array& out) {
+  encoder.set_output_array(out);
+  bool large = out.data_size() > INT32_MAX;
+  for (auto& c : copies) {
+    encoder.set_input_array(c.in);
+    large |= c.in.data_size() > INT32_MAX;
+  }
+
+  dispatch_element_size(out.itemsize(), [&](auto type_tag) {
+    dispatch_bool(large, [&](auto large) {
+      using T = MLX_GET_TYPE(type_tag);
+      using IdxT = std::conditional_t<large(), int64_t, int32_t>;
+      auto kernel = cu::copy_batched<T, IdxT>;
+      uint block_dim = max_occupancy_block_dim(kernel);
+
+      cu::CopyBatch batch;
+      batch.out = out.data<T>();
+      int count = 0;
+      size_t max_size = 0;
+      auto launch = [&]() {
+        uint num_blocks = cuda::ceil_div(max_size, block_dim);
+        encoder.add_kernel_node(
+            kernel, dim3(num_blocks, count), block_dim, batch);
+        count = 0;
+        max_size = 0;
+      };
+      for (auto& c : copies) {
+        size_t size = 1;
+        for (auto s : c.shape) {
+          size *= s;
+        }
+        if (size == 0) {
+          continue;
+        }
+        auto [shape, strides] = collapse_contiguous_dims(
+            c.shape, std::vector{c.strides_in, out.strides()}, INT32_MAX);
+        batch.in[count] = c.in.data<T>() + c.offset_in;
+        batch.offset_out[count] = c.offset_out;
+        batch.size[count] = size;
+        batch.ndim[count] = shape.size();
+        batch.shape[count] = const_param(shape);
+        batch.strides_in[count] = const_param(strides[0]);
+        batch.strides_out[count] = const_param(strides[1]);
+        max_size = std::max(max_size, size);
+        if (++count == cu::MAX_BATCHED_COPIES) {
+          launch();
+        }
+      }
+      if (count > 0) {
+        launch();
+      }
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,33 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// One of the copies of copy_batched: the |shape| box of |in| read from
+// |offset_in| with |strides_in| is written to the output from |offset_out|
+// with the strides of the output. The input and the output have the same
+// dtype.
+struct BatchedCopy {
+  array in;
+  int64_t offset_in;
+  int64_t offset_out;
+  Shape shape;
+  Strides strides_in;
+};
+
+// Do the |copies| into |out| in a single kernel launch instead of one per
+// copy, the boxes written by the copies must not overlap. Very long lists
+// of copies are split into a few launches.
+void copy_batched(
+    cu::CommandEncoder& encoder,
+    const std::vector<BatchedCopy>& copies,
+    array& out);
+
+} // namespace mlx::core
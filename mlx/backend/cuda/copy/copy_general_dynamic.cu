@@ -72,19 +72,22 @@ void copy_general_dynamic(
             const InType* in_ptr = in.data<InType>() + offset_in;
             OutType* out_ptr = out.data<OutType>() + offset_out;
             int ndim = shape.size();
+            size_t data_size = 1;
+            for (auto& s : shape)
+              data_size *= s;
             if (ndim <= 3) {
               dispatch_1_2_3(ndim, [&](auto dims_constant) {
                 auto kernel = cu::
                     copy_gg_dynamic_nd<InType, OutType, IdxT, dims_constant()>;
-                auto [num_blocks, block_dims] =
-                    get_launch_args(kernel, out, large());
+                auto [num_blocks, block_dims] = get_launch_args(
+                    kernel, data_size, shape, out.strides(), large());
                 encoder.add_kernel_node(
                     kernel,
                     num_blocks,
                     block_dims,
                     in_ptr,
                     out_ptr,
-                    out.size(),
+                    data_size,
                     const_param<dims_constant()>(shape),
                     const_param<dims_constant()>(strides_in),
                     const_param<dims_constant()>(strides_out),
@@ -93,15 +96,15 @@ void copy_general_dynamic(
               });
             } else { // ndim >= 4
               auto kernel = cu::copy_gg_dynamic<InType, OutType, IdxT>;
-              auto [num_blocks, block_dims] =
-                  get_launch_args(kernel, out, large());
+              auto [num_blocks, block_dims] = get_launch_args(
+                  kernel, data_size, shape, out.strides(), large());
               encoder.add_kernel_node(
                   kernel,
                   num_blocks,
                   block_dims,
                   in_ptr,
                   out_ptr,
-                  out.size(),
+                  data_size,
                   const_param(shape),
                   const_param(strides_in),
                   const_param(strides_out),
@@ -0,0 +1,145 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/copy/copy.cuh"
+
+#include <cooperative_groups.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int transpose_tile_dim = 32;
+constexpr int transpose_block_rows = 8;
+
+// Copy the (batch, rows, cols) view whose rows are contiguous in the input
+// and whose cols are contiguous in the output. Each block goes through a
+// square tile of shared memory, so both the reads and the writes coalesce.
+// The tile is padded by one column to avoid bank conflicts, and small types
+// move N_READS elements per thread.
+template <typename In, typename Out, int N_READS>
+__global__ void copy_transpose(
+    const In* in,
+    Out* out,
+    int rows,
+    int cols,
+    int64_t batch_stride_in,
+    int64_t col_stride_in,
+    int64_t batch_stride_out,
+    int64_t row_stride_out) {
+  constexpr int TILE = transpose_tile_dim * N_READS;
+  __shared__ In tile[TILE][TILE + 1];
+
+  auto block = cg::this_thread_block();
+  auto tid = block.thread_index();
+  auto bid = block.group_index();
+  int row0 = bid.x * TILE;
+  int col0 = bid.y * TILE;
+  in += bid.z * batch_stride_in;
+  out += bid.z * batch_stride_out;
+
+  // Read along the rows, which are contiguous in the input.
+  int row = row0 + tid.x * N_READS;
+  for (int j = tid.y; j < TILE; j += transpose_block_rows) {
+    int col = col0 + j;
+    if (row < rows && col < cols) {
+      auto vec = load_vector<N_READS>(in + col * col_stride_in + row, 0);
+#pragma unroll
+      for (int i = 0; i < N_READS; ++i) {
+        tile[j][tid.x * N_READS + i] = vec.val[i];
+      }
+    }
+  }
+  block.sync();
+
+  // Write along the cols, which are contiguous in the output.
+  int col = col0 + tid.x * N_READS;
+  for (int j = tid.y; j < TILE; j += transpose_block_rows) {
+    int row = row0 + j;
+    if (row < rows && col < cols) {
+      AlignedVector<Out, N_READS> vec;
+#pragma unroll
+      for (int i = 0; i < N_READS; ++i) {
+        vec.val[i] = CastOp<In, Out>{}(tile[tid.x * N_READS + i][j]);
+      }
+      store_vector<N_READS>(out + row * row_stride_out + col, 0, vec);
+    }
+  }
+}
+
+} // namespace cu
+
+bool use_copy_transpose(
+    const Shape& shape,
+    const Strides& strides_in,
+    const Strides& strides_out) {
+  int ndim = shape.size();
+  if (ndim != 2 && ndim != 3) {
+    return false;
+  }
+  int rows = shape[ndim - 2];
+  int cols = shape[ndim - 1];
+  int batch = ndim == 3 ? shape[0] : 1;
+  // Below a tile the per element copy is as good.
+  if (rows < cu::transpose_tile_dim || cols < cu::transpose_tile_dim) {
+    return false;
+  }
+  // The tiles of the cols and the batches go in the y and z of the grid.
+  if (cuda::ceil_div(cols, cu::transpose_tile_dim) > 65535 || batch > 65535) {
+    return false;
+  }
+  return strides_in[ndim - 2] == 1 && strides_out[ndim - 1] == 1;
+}
+
+void copy_transpose(
+    cu::CommandEncoder& encoder,
+    CopyType ctype,
+    const array& in,
+    array& out,
+    int64_t offset_in,
+    int64_t offset_out,
+    const Shape& shape,
+    const Strides& strides_in,
+    const Strides& strides_out) {
+  int ndim = shape.size();
+  int rows = shape[ndim - 2];
+  int cols = shape[ndim - 1];
+  int batch = ndim == 3 ? shape[0] : 1;
+  int64_t batch_stride_in = ndim == 3 ? strides_in[0] : 0;
+  // The output of a general copy is written in row order.
+  bool general = ctype == CopyType::General;
+  int64_t batch_stride_out =
+      ndim != 3 ? 0 : (general ? int64_t(rows) * cols : strides_out[0]);
+  int64_t row_stride_out = general ? cols : strides_out[ndim - 2];
+  dispatch_all_types(in.dtype(), [&](auto in_type_tag) {
+    dispatch_all_types(out.dtype(), [&](auto out_type_tag) {
+      using InType = cuda_type_t<MLX_GET_TYPE(in_type_tag)>;
+      using OutType = cuda_type_t<MLX_GET_TYPE(out_type_tag)>;
+      // Pack the 8 and 16 bits types into 32 bits loads and stores.
+      constexpr int N_READS = sizeof(InType) < 4 ? 4 / sizeof(InType) : 1;
+      bool vectorize = rows % N_READS == 0 && cols % N_READS == 0;
+      dispatch_bool(vectorize, [&](auto vectorized) {
+        constexpr int N = vectorized() ? N_READS : 1;
+        constexpr int tile = cu::transpose_tile_dim * N;
+        dim3 num_blocks(
+            cuda::ceil_div(rows, tile), cuda::ceil_div(cols, tile), batch);
+        dim3 block_dims(cu::transpose_tile_dim, cu::transpose_block_rows);
+        encoder.add_kernel_node(
+            cu::copy_transpose<InType, OutType, N>,
+            num_blocks,
+            block_dims,
+            in.data<InType>() + offset_in,
+            out.data<OutType>() + offset_out,
+            rows,
+            cols,
+            batch_stride_in,
+            strides_in[ndim - 1],
+            batch_stride_out,
+            row_stride_out);
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -1,6 +1,26 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/cuda/cuda.h"
+#include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/event.h"
+#include "mlx/backend/cuda/jit_module.h"
+#include "mlx/backend/cuda/l2_persistence.h"
+#include "mlx/backend/cuda/memory_tracer.h"
+#include "mlx/backend/cuda/offload.h"
+#include "mlx/backend/cuda/pinned_staging.h"
+#include "mlx/backend/cuda/profiler.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/io/load.h"
+#include "mlx/ops.h"
+#include "mlx/primitives.h"
+#include "mlx/transforms.h"
+#include "mlx/utils.h"
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <cstring>
 
 namespace mlx::core::cu {
 
@@ -8,4 +28,511 @@ bool is_available() {
   return true;
 }
 
+std::unordered_map<std::string, size_t> graph_cache_info() {
+  auto& stats = graph_cache_stats();
+  return {
+      {"hits", stats.hits.load()},
+      {"misses", stats.misses.load()},
+      {"instantiations", stats.instantiations.load()},
+      {"evictions", stats.evictions.load()},
+      {"capacity", static_cast<size_t>(cuda_graph_cache_size())},
+  };
+}
+
+void reset_graph_cache_info() {
+  auto& stats = graph_cache_stats();
+  stats.hits = 0;
+  stats.misses = 0;
+  stats.instantiations = 0;
+  stats.evictions = 0;
+}
+
+std::unordered_map<std::string, double> dispatch_info() {
+  auto& stats = dispatch_stats();
+  return {
+      {"evals", static_cast<double>(stats.evals.load())},
+      {"nodes", static_cast<double>(stats.nodes.load())},
+      {"graphs", static_cast<double>(stats.graphs.load())},
+      {"dispatch_us", stats.dispatch_ns.load() / 1e3},
+      {"update_us", stats.update_ns.load() / 1e3},
+      {"instantiate_us", stats.instantiate_ns.load() / 1e3},
+      {"launch_us", stats.launch_ns.load() / 1e3},
+      {"gpu_us", stats.gpu_ns.load() / 1e3},
+      {"gpu_nodes", static_cast<double>(stats.gpu_nodes.load())},
+      {"retire_us", stats.retire_ns.load() / 1e3},
+  };
+}
+
+void reset_dispatch_info() {
+  auto& stats = dispatch_stats();
+  stats.evals = 0;
+  stats.nodes = 0;
+  stats.dispatch_ns = 0;
+  stats.update_ns = 0;
+  stats.instantiate_ns = 0;
+  stats.launch_ns = 0;
+  stats.graphs = 0;
+  stats.gpu_ns = 0;
+  stats.gpu_nodes = 0;
+  stats.retire_ns = 0;
+}
+
+int precompile_kernels() {
+  return precompile_jit_modules(mlx::core::Device::gpu);
+}
+
+std::vector<std::pair<std::string, std::string>> kernel_cache_files() {
+  return jit_cache_files(mlx::core::Device::gpu);
+}
+
+void add_kernel_cache_files(
+    const std::vector<std::pair<std::string, std::string>>& files) {
+  add_jit_cache_files(files);
+}
+
+void prefetch(const std::vector<array>& arrays, bool to_host) {
+  eval(arrays);
+  auto s = default_stream(mlx::core::Device::gpu);
+  auto& encoder = get_command_encoder(s);
+  int location = to_host ? cudaCpuDeviceId : device(s.device).cuda_device();
+  for (auto& a : arrays) {
+    allocator().prefetch(a.buffer(), location, encoder.stream());
+  }
+}
+
+void set_read_mostly(const std::vector<array>& arrays) {
+  eval(arrays);
+  for (auto& a : arrays) {
+    allocator().set_read_mostly(a.buffer());
+  }
+}
+
+void set_l2_persisting(const std::vector<array>& arrays, bool persisting) {
+  eval(arrays);
+  auto& d = device(default_stream(mlx::core::Device::gpu).device);
+  for (auto& a : arrays) {
+    if (auto* buf = static_cast<CudaBuffer*>(a.buffer().ptr()); buf) {
+      l2_persistence().set_persisting(d, buf, persisting);
+    }
+  }
+}
+
+void offload(const std::vector<std::vector<array>>& layers, int ahead) {
+  std::vector<array> arrays;
+  for (auto& layer : layers) {
+    arrays.insert(arrays.end(), layer.begin(), layer.end());
+  }
+  eval(arrays);
+  device(mlx::core::Device::gpu).make_current();
+  offloader().offload(layers, ahead);
+}
+
+void start_profiling() {
+  profiler().start();
+}
+
+void stop_profiling() {
+  profiler().stop();
+}
+
+std::unordered_map<std::string, std::unordered_map<std::string, double>>
+profiling_info() {
+  std::unordered_map<std::string, std::unordered_map<std::string, double>>
+      info;
+  for (auto& [name, stats] : profiler().stats()) {
+    double gbps = stats.time_ms > 0 ? stats.bytes / (stats.time_ms * 1e6) : 0;
+    info[name] = {
+        {"count", static_cast<double>(stats.count)},
+        {"time_ms", stats.time_ms},
+        {"bytes", static_cast<double>(stats.bytes)},
+        {"bandwidth_gbps", gbps},
+    };
+  }
+  return info;
+}
+
+void save_profiling_trace(const std::string& path) {
+  profiler().save_trace(path);
+}
+
+array from_device_memory(
+    void* data,
+    Shape shape,
+    Dtype dtype,
+    int device,
+    std::function<void()> release) {
+  size_t size = dtype.size();
+  for (auto dim : shape) {
+    size *= dim;
+  }
+  if (device < 0) {
+    cudaPointerAttributes attributes;
+    CHECK_CUDA_ERROR(cudaPointerGetAttributes(&attributes, data));
+    device = attributes.device;
+  }
+  auto* buf = new CudaBuffer{data, size, device, device};
+  buf->foreign = true;
+  // The buffer is not returned to the allocator but to its owner.
+  return array(
+      allocator::Buffer{buf},
+      std::move(shape),
+      dtype,
+      [release = std::move(release)](allocator::Buffer buffer) {
+        delete static_cast<CudaBuffer*>(buffer.ptr());
+        release();
+      });
+}
+
+array from_host(const void* data, Shape shape, Dtype dtype) {
+  array out(std::move(shape), dtype, nullptr, {});
+  auto buffer = allocator::malloc(out.nbytes());
+  out.set_data(buffer);
+  if (out.nbytes() > 0) {
+    auto& d = device(default_stream(mlx::core::Device::gpu).device);
+    pinned_staging(d).copy(data, buffer, out.nbytes());
+  }
+  return out;
+}
+
+array readable_by_host(const array& a) {
+  eval({a});
+  int device = allocator().device_of(a.buffer());
+  if (device < 0) {
+    return a;
+  }
+  // The copy is in pageable memory, which is freed without synchronizing.
+  size_t nbytes = a.data_size() * a.itemsize();
+  void* data = std::malloc(nbytes);
+  if (!data) {
+    throw std::runtime_error(fmt::format(
+        "[readable_by_host] Unable to allocate {} bytes.", nbytes));
+  }
+  CHECK_CUDA_ERROR(
+      cudaMemcpy(data, a.data<void>(), nbytes, cudaMemcpyDeviceToHost));
+  auto* buf = new CudaBuffer{data, nbytes, device, cudaCpuDeviceId};
+  buf->foreign = true;
+  array out(a.shape(), a.dtype(), nullptr, {});
+  out.set_data(
+      allocator::Buffer{buf},
+      a.data_size(),
+      a.strides(),
+      a.flags(),
+      [](allocator::Buffer buffer) {
+        auto* buf = static_cast<CudaBuffer*>(buffer.ptr());
+        std::free(buf->data);
+        delete buf;
+      });
+  return out;
+}
+
+namespace {
+
+// The start of the handle of an array shared through CUDA IPC, followed by
+// its shape.
+struct IpcHeader {
+  cudaIpcMemHandle_t mem;
+  // Recorded after the memory is written.
+  cudaIpcEventHandle_t event;
+  Dtype::Val dtype;
+  uint8_t dtype_size;
+  int32_t ndim;
+};
+
+} // namespace
+
+std::pair<array, std::string> ipc_export(const array& a) {
+  auto src = contiguous(a);
+  eval({src});
+  auto s = default_stream(mlx::core::Device::gpu);
+  auto& encoder = get_command_encoder(s);
+  auto& d = encoder.device();
+  d.make_current();
+
+  // The managed memory of the allocator can not be shared, so the array is
+  // copied to device memory.
+  void* data = nullptr;
+  CHECK_CUDA_ERROR(cudaMalloc(&data, std::max<size_t>(src.nbytes(), 1)));
+  cudaEvent_t event;
+  CHECK_CUDA_ERROR(cudaEventCreateWithFlags(
+      &event, cudaEventDisableTiming | cudaEventInterprocess));
+  CHECK_CUDA_ERROR(cudaMemcpyAsync(
+      data,
+      src.data<char>(),
+      src.nbytes(),
+      cudaMemcpyDefault,
+      encoder.stream()));
+  CHECK_CUDA_ERROR(cudaEventRecord(event, encoder.stream()));
+  encoder.add_completed_handler([src]() {});
+  encoder.commit();
+
+  IpcHeader header;
+  CHECK_CUDA_ERROR(cudaIpcGetMemHandle(&header.mem, data));
+  CHECK_CUDA_ERROR(cudaIpcGetEventHandle(&header.event, event));
+  header.dtype = src.dtype().val();
+  header.dtype_size = src.dtype().size();
+  header.ndim = src.ndim();
+  std::string handle(reinterpret_cast<const char*>(&header), sizeof(header));
+  handle.append(
+      reinterpret_cast<const char*>(src.shape().data()),
+      src.ndim() * sizeof(ShapeElem));
+
+  auto shared = from_device_memory(
+      data, src.shape(), src.dtype(), d.cuda_device(), [data, event]() {
+        cudaEventDestroy(event);
+        allocator().cuda_free(data);
+      });
+  return {std::move(shared), std::move(handle)};
+}
+
+array ipc_import(const std::string& handle, StreamOrDevice s) {
+  IpcHeader header;
+  if (handle.size() < sizeof(header)) {
+    throw std::invalid_argument("[ipc_import] Invalid handle.");
+  }
+  std::memcpy(&header, handle.data(), sizeof(header));
+  if (header.ndim < 0 ||
+      handle.size() != sizeof(header) + header.ndim * sizeof(ShapeElem)) {
+    throw std::invalid_argument("[ipc_import] Invalid handle.");
+  }
+  Shape shape(header.ndim);
+  std::memcpy(
+      shape.data(),
+      handle.data() + sizeof(header),
+      header.ndim * sizeof(ShapeElem));
+
+  auto stream = to_stream(s, mlx::core::Device::gpu);
+  if (stream.device != mlx::core::Device::gpu) {
+    throw std::invalid_argument("[ipc_import] The stream is not a GPU one.");
+  }
+  auto& encoder = get_command_encoder(stream);
+  auto& d = encoder.device();
+  d.make_current();
+  void* data = nullptr;
+  CHECK_CUDA_ERROR(cudaIpcOpenMemHandle(
+      &data, header.mem, cudaIpcMemLazyEnablePeerAccess));
+  // The kernels launched on the stream from now on wait for the copy of the
+  // exporting process.
+  cudaEvent_t event;
+  CHECK_CUDA_ERROR(cudaIpcOpenEventHandle(&event, header.event));
+  CHECK_CUDA_ERROR(cudaStreamWaitEvent(encoder.stream(), event, 0));
+  CHECK_CUDA_ERROR(cudaEventDestroy(event));
+
+  return from_device_memory(
+      data,
+      std::move(shape),
+      Dtype(header.dtype, header.dtype_size),
+      d.cuda_device(),
+      [data]() { cudaIpcCloseMemHandle(data); });
+}
+
+std::uintptr_t cuda_stream(Stream s) {
+  if (s.device != mlx::core::Device::gpu) {
+    throw std::invalid_argument("[cuda_stream] The stream is not a GPU one.");
+  }
+  return reinterpret_cast<std::uintptr_t>(
+      static_cast<cudaStream_t>(get_command_encoder(s).stream()));
+}
+
+void wait_for_stream(std::uintptr_t stream, Stream s) {
+  CudaEvent event;
+  event.record(reinterpret_cast<cudaStream_t>(stream));
+  event.wait(s);
+}
+
+std::uintptr_t evaluation_stream(array a) {
+  async_eval({a});
+  if (a.is_available()) {
+    return 0;
+  }
+  auto s = a.event().stream();
+  if (s.device == mlx::core::Device::cpu) {
+    a.wait();
+    return 0;
+  }
+  // The graph computing the array has to be launched before the other
+  // library waits on the stream.
+  auto& encoder = get_command_encoder(s);
+  encoder.commit();
+  return reinterpret_cast<std::uintptr_t>(
+      static_cast<cudaStream_t>(encoder.stream()));
+}
+
+namespace {
+
+// Reads the memory of a row contiguous array, for a Load to copy it.
+class ArrayReader : public io::Reader {
+ public:
+  explicit ArrayReader(array a) : a_(std::move(a)) {}
+
+  bool is_open() const override {
+    return true;
+  }
+  bool good() const override {
+    return true;
+  }
+  size_t tell() override {
+    return pos_;
+  }
+  void seek(int64_t off, std::ios_base::seekdir way = std::ios_base::beg)
+      override {
+    if (way == std::ios_base::cur) {
+      off += pos_;
+    } else if (way == std::ios_base::end) {
+      off += a_.nbytes();
+    }
+    pos_ = off;
+  }
+  void read(char* data, size_t n) override {
+    read(data, n, pos_);
+    pos_ += n;
+  }
+  void read(char* data, size_t n, size_t offset) override {
+    std::memcpy(data, a_.data<char>() + offset, n);
+  }
+  std::string label() const override {
+    return "array";
+  }
+
+ private:
+  array a_;
+  size_t pos_{0};
+};
+
+} // namespace
+
+BatchPrefetcher::BatchPrefetcher(
+    std::function<std::optional<Batch>()> batches,
+    int ahead)
+    : batches_(std::move(batches)),
+      ahead_(std::max(ahead, 1)),
+      stream_(new_stream(mlx::core::Device::gpu)) {}
+
+std::optional<BatchPrefetcher::Batch> BatchPrefetcher::next() {
+  while (!done_ && pending_.size() <= static_cast<size_t>(ahead_)) {
+    auto batch = batches_();
+    if (!batch) {
+      done_ = true;
+      break;
+    }
+    pending_.push_back(copy_to_device(std::move(*batch)));
+  }
+  if (pending_.empty()) {
+    return std::nullopt;
+  }
+  auto batch = std::move(pending_.front());
+  pending_.pop_front();
+  return batch;
+}
+
+BatchPrefetcher::Batch BatchPrefetcher::copy_to_device(Batch batch) {
+  for (auto& a : batch) {
+    if (!a.flags().row_contiguous) {
+      a = contiguous(a, false, mlx::core::Device::cpu);
+    }
+  }
+  eval(batch);
+  // The copies are read by the io threads, and the streams using them wait
+  // on their events.
+  for (auto& a : batch) {
+    a = array(
+        a.shape(),
+        a.dtype(),
+        std::make_shared<Load>(*stream_, std::make_shared<ArrayReader>(a), 0),
+        {});
+  }
+  async_eval(batch);
+  return batch;
+}
+
+namespace {
+
+// The rows of a GrowableArray in a reserved range of addresses.
+array reserve_rows(Shape shape, Dtype dtype, int max_length) {
+  if (max_length < 0) {
+    throw std::invalid_argument(
+        "[GrowableArray] The maximum length must be non-negative.");
+  }
+  shape.insert(shape.begin(), max_length);
+  size_t size = dtype.size();
+  for (auto dim : shape) {
+    size *= dim;
+  }
+  device(mlx::core::Device::gpu).make_current();
+  return array(allocator().reserve(size), std::move(shape), dtype);
+}
+
+} // namespace
+
+GrowableArray::GrowableArray(Shape shape, Dtype dtype, int max_length)
+    : storage_(reserve_rows(std::move(shape), dtype, max_length)),
+      max_length_(max_length) {}
+
+void GrowableArray::append(const array& x) {
+  if (x.ndim() != storage_.ndim() || x.dtype() != storage_.dtype() ||
+      !std::equal(
+          x.shape().begin() + 1,
+          x.shape().end(),
+          storage_.shape().begin() + 1)) {
+    throw std::invalid_argument(
+        "[GrowableArray::append] The rows must have the shape and type of "
+        "the array.");
+  }
+  int n = x.shape(0);
+  if (length_ + n > max_length_) {
+    throw std::invalid_argument(fmt::format(
+        "[GrowableArray::append] Can not append {} rows to {} rows, the "
+        "maximum length is {}.",
+        n,
+        length_,
+        max_length_));
+  }
+  if (x.size() == 0) {
+    length_ += n;
+    return;
+  }
+  eval({x});
+
+  int64_t offset = length_ * storage_.strides(0);
+  allocator().grow(
+      storage_.buffer(), (offset + x.size()) * storage_.itemsize());
+  auto s = default_stream(mlx::core::Device::gpu);
+  auto& encoder = get_command_encoder(s);
+  copy_gpu_inplace(
+      x,
+      storage_,
+      x.shape(),
+      x.strides(),
+      storage_.strides(),
+      0,
+      offset,
+      CopyType::GeneralGeneral,
+      s);
+  // The arrays are kept until the rows are written.
+  encoder.add_temporary(x);
+  encoder.add_temporary(storage_);
+  length_ += n;
+}
+
+array GrowableArray::data() const {
+  auto stop = storage_.shape();
+  stop[0] = length_;
+  return slice(storage_, Shape(storage_.ndim(), 0), std::move(stop));
+}
+
+void start_memory_tracing() {
+  memory_tracer().start();
+}
+
+void stop_memory_tracing() {
+  memory_tracer().stop();
+}
+
+std::vector<std::pair<std::string, size_t>> memory_trace_peak(int top_n) {
+  return memory_tracer().peak(top_n);
+}
+
+void save_memory_trace(const std::string& path, int top_n) {
+  memory_tracer().save(path, top_n);
+}
+
 } // namespace mlx::core::cu
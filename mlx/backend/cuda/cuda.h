@@ -2,9 +2,342 @@
 
 #pragma once
 
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/utils.h"
+
 namespace mlx::core::cu {
 
 /* Check if the CUDA backend is available. */
 bool is_available();
 
+/* Get the counters of the cache of CUDA graph executables.
+ *
+ * The graphs of the commands are cached by topology with at most
+ * MLX_CUDA_GRAPH_CACHE_SIZE executables per stream, and the least recently
+ * used one is evicted when full. The counters are summed over the streams:
+ *   - "hits": the graphs found in the cache.
+ *   - "misses": the graphs not found in the cache.
+ *   - "instantiations": the executables created, for the misses and for the
+ *     cached executables that could not be updated to a new graph.
+ *   - "evictions": the executables evicted from a full cache.
+ *   - "capacity": the maximum number of executables cached per stream.
+ *
+ * The map is empty when the CUDA backend is not available.
+ * */
+std::unordered_map<std::string, size_t> graph_cache_info();
+
+/* Reset the counters of graph_cache_info to zero. */
+void reset_graph_cache_info();
+
+/* Get the counters splitting the time of the ops evaluated on the GPU.
+ *
+ * The counters are summed over the streams, the times are in microseconds:
+ *   - "evals": the primitives evaluated.
+ *   - "nodes": the graph nodes launched.
+ *   - "graphs": the graphs launched.
+ *   - "dispatch_us": the host time of evaluating the primitives and adding
+ *     their nodes to the graphs.
+ *   - "update_us": the host time of updating the cached graph executables.
+ *   - "instantiate_us": the host time of instantiating graph executables.
+ *   - "launch_us": the rest of the host time of committing the graphs,
+ *     including their launch.
+ *   - "gpu_us": the GPU time of the timed graphs.
+ *   - "gpu_nodes": the nodes of the timed graphs.
+ *   - "retire_us": the time of running the completion handlers, which
+ *     release the buffers of the finished graphs.
+ *
+ * The map is empty when the CUDA backend is not available.
+ * */
+std::unordered_map<std::string, double> dispatch_info();
+
+/* Reset the counters of dispatch_info to zero. */
+void reset_dispatch_info();
+
+/* Load the kernels JIT compiled by previous runs.
+ *
+ * The sources of the kernels are cached in MLX_PTX_CACHE_DIR along with
+ * their binaries for each GPU architecture and NVRTC version. This loads all
+ * of them for the GPU, compiling the ones without a binary for it, so that
+ * a pre-populated cache can be warmed up before the first evaluation.
+ *
+ * Returns the number of kernel modules loaded.
+ * */
+int precompile_kernels();
+
+/* Get the files of the kernels JIT compiled by this process.
+ *
+ * The files are the sources and kernel names of the modules loaded for the
+ * GPU and their binaries for its architecture, by their path relative to
+ * MLX_PTX_CACHE_DIR. They are embedded in exported functions.
+ * */
+std::vector<std::pair<std::string, std::string>> kernel_cache_files();
+
+/* Add the |files| of kernel_cache_files to MLX_PTX_CACHE_DIR, keeping the
+ * ones already there, so their kernels are not compiled again. */
+void add_kernel_cache_files(
+    const std::vector<std::pair<std::string, std::string>>& files);
+
+/* Prefetch the memory of |arrays| to the GPU, or to the host when
+ * |to_host| is true.
+ *
+ * The arrays are evaluated first. The managed memory is otherwise moved on
+ * demand by page faults, at the first access of a kernel or of the host.
+ * The memory written by the host is also prefetched when a kernel first
+ * reads it.
+ * */
+void prefetch(const std::vector<array>& arrays, bool to_host = false);
+
+/* Advise that the memory of |arrays|, such as weights, is mostly read.
+ *
+ * The GPU and the host then keep a copy of the memory they read instead of
+ * moving it back and forth, and a write invalidates the copies. The arrays
+ * are evaluated first, and the advice lasts until their memory is freed.
+ * */
+void set_read_mostly(const std::vector<array>& arrays);
+
+/* Keep the memory of |arrays| in the L2 cache of the GPU, or stop keeping
+ * it when |persisting| is false.
+ *
+ * The arrays, such as the norms and small weights of a model or the recent
+ * pages of a KV cache read at every step of a decode, are read by the
+ * kernels through an access policy window of the persisting part of the L2
+ * so the streaming reads of the large weights do not evict them. The
+ * persisting L2 is reserved on the first use, at most
+ * MLX_CUDA_L2_PERSISTING_MB, and shared between the persisting arrays. With
+ * MLX_CUDA_L2_AUTO_PERSIST=1 the small arrays read by the kernels of several
+ * graphs are also kept. The GPUs before sm_80 have no persisting L2.
+ *
+ * The arrays are evaluated first, and they are kept until their memory is
+ * freed.
+ * */
+void set_l2_persisting(
+    const std::vector<array>& arrays,
+    bool persisting = true);
+
+/* Offload the arrays of |layers| to the host.
+ *
+ * The memory of the arrays, such as the weights of the layers of a model
+ * larger than the GPU memory, is kept on the host where the GPU reads it
+ * through its mapping. When a kernel reads a layer, the next |ahead| layers
+ * are prefetched to the GPU on a stream of their own while the layer is
+ * computed, and the other layers are moved back to the host. The layers are
+ * in the order they are read, the first following the last.
+ *
+ * The arrays are evaluated first. The previously offloaded layers are
+ * restored, and an empty |layers| only restores them.
+ * */
+void offload(const std::vector<std::vector<array>>& layers, int ahead = 1);
+
+/* Start timing the primitives evaluated on the GPU.
+ *
+ * The kernels of each primitive are enclosed by a pair of CUDA events, and
+ * committed in a graph of their own so the primitives of a stream run one
+ * at a time while profiling. The records of a previous run are discarded.
+ * */
+void start_profiling();
+
+/* Stop timing the primitives, the records are kept until the next start. */
+void stop_profiling();
+
+/* Get the GPU time of the primitives timed since start_profiling by name:
+ *   - "count": the number of evaluations.
+ *   - "time_ms": the total GPU time in milliseconds.
+ *   - "bytes": the total size of the inputs and outputs.
+ *   - "bandwidth_gbps": the bytes over the time in GB/s.
+ *
+ * Waits for the GPU to finish the timed primitives.
+ * */
+std::unordered_map<std::string, std::unordered_map<std::string, double>>
+profiling_info();
+
+/* Save the primitives timed since start_profiling to |path| in the Chrome
+ * trace event format, which can be opened in Perfetto. */
+void save_profiling_trace(const std::string& path);
+
+/* Return a function evaluating |fun|, usually a compiled function, on the
+ * GPU by launching a single CUDA graph.
+ *
+ * The first call with given input shapes and dtypes evaluates |fun| and
+ * records its kernels in a graph. The next calls copy the inputs to the
+ * buffers the graph was recorded with, launch it and copy its outputs, so
+ * the primitives are not evaluated again. The inputs that are the same
+ * arrays as when recorded, such as the weights of a model, are read in
+ * place and the others are copied. An input first seen with other values
+ * is recorded again to be copied from then on.
+ *
+ * The first call records the graph twice, once to find the nodes using each
+ * buffer it allocates and once with the buffers assigned to the slots of one
+ * arena, the buffers used by disjoint ranges of nodes sharing a slot. The
+ * arenas and the buffers of the recorded graphs are kept until the function
+ * is destroyed. The function must only run on the default GPU stream and not
+ * depend on values read by the host, such as the arrays of other streams
+ * or the shapes of data dependent outputs. It calls |fun| when the default
+ * device is not the GPU.
+ * */
+std::function<std::vector<array>(const std::vector<array>&)> graph_function(
+    std::function<std::vector<array>(const std::vector<array>&)> fun);
+
+/* Wrap |data|, memory of the CUDA |device| allocated by another library,
+ * in an array of |shape| and |dtype| without copying it. The device is the
+ * one owning |data| when |device| is -1.
+ *
+ * The memory must be row contiguous and stay valid until |release| is
+ * called, once the array and the arrays sharing its memory are freed. It is
+ * not counted in the memory of the allocator and, unless it is managed
+ * memory, it is only readable by the GPU.
+ * */
+array from_device_memory(
+    void* data,
+    Shape shape,
+    Dtype dtype,
+    int device,
+    std::function<void()> release);
+
+/* Copy |data|, host memory of an array of |shape| and |dtype| in row
+ * contiguous order, to a new array whose memory is on the current GPU.
+ *
+ * The copy goes through pinned staging buffers on a CUDA stream of its own,
+ * next to the work of the compute streams, and the pages are written on the
+ * GPU instead of migrating there at the first kernel. Returns once the copy
+ * is done, so |data| can then be reused.
+ * */
+array from_host(const void* data, Shape shape, Dtype dtype);
+
+/* Get |a| in memory the host can read.
+ *
+ * The device memory of the pool of MLX_CUDA_USE_MEMORY_POOL and of
+ * from_device_memory is only readable by the GPU, the data of |a| is then
+ * copied to host memory, otherwise |a| is returned. It is evaluated first.
+ * */
+array readable_by_host(const array& a);
+
+/* Share a copy of |a| with the other processes of the host through CUDA
+ * IPC.
+ *
+ * The array is evaluated and copied to device memory, since the managed
+ * memory of the allocator can not be shared. Returns the copy and the
+ * handle for ipc_import, which also holds an event recorded after the
+ * copy. The memory is freed with the copy, so the copy must outlive the
+ * arrays imported from it.
+ * */
+std::pair<array, std::string> ipc_export(const array& a);
+
+/* Map the memory of an array exported by ipc_export in another process of
+ * the host, without copying it.
+ *
+ * The GPU stream |s| waits on the GPU for the copy of the exporting process
+ * before its next kernels, so the array should be read on |s|. The memory is
+ * unmapped once the array and the arrays sharing its memory are freed.
+ * */
+array ipc_import(const std::string& handle, StreamOrDevice s = {});
+
+/* Get the CUDA stream which runs the GPU stream |s| as an integer, for
+ * instance for another library to order its work before the work of |s|. */
+std::uintptr_t cuda_stream(Stream s);
+
+/* Make the GPU stream |s| wait for the work submitted so far to |stream|,
+ * a CUDA stream of another library, without waiting on the host. */
+void wait_for_stream(std::uintptr_t stream, Stream s);
+
+/* Schedule the evaluation of |a| and return the CUDA stream computing it,
+ * for another library to wait on before reading its memory, or 0 when the
+ * array is ready. The host only waits for the arrays computed on the CPU.
+ * */
+std::uintptr_t evaluation_stream(array a);
+
+/* Copy the batches of host arrays of a data loader to the GPU ahead of the
+ * steps using them.
+ *
+ * Each call of next() keeps the copies of the following |ahead| batches of
+ * |batches| in flight and returns the oldest one. The arrays are copied
+ * through pinned memory on a GPU stream of their own, while the GPU runs
+ * the current step, and the steps using them wait for the copies in the GPU
+ * rather than on the host. |batches| returns nullopt after the last batch,
+ * and the arrays are returned as is without the CUDA backend.
+ * */
+class BatchPrefetcher {
+ public:
+  using Batch = std::vector<array>;
+
+  BatchPrefetcher(std::function<std::optional<Batch>()> batches, int ahead);
+
+  /* Get the next batch, or nullopt after the last one. */
+  std::optional<Batch> next();
+
+ private:
+  Batch copy_to_device(Batch batch);
+
+  std::function<std::optional<Batch>()> batches_;
+  int ahead_;
+  bool done_{false};
+  std::deque<Batch> pending_;
+  std::optional<Stream> stream_;
+};
+
+/* An array grown along its first axis in place, such as a KV cache
+ * appended to at each step.
+ *
+ * The rows are stored in a range of addresses reserved for |max_length|
+ * rows on the current GPU, and the pages of memory are mapped as rows are
+ * appended. Appending copies only the new rows, the address of the array
+ * never changes, which also suits the graphs of graph_function, and no
+ * memory is taken for the rows not appended yet. The rows are written on
+ * the default GPU stream, where the arrays returned by data() should be
+ * read. Without the CUDA backend the rows are concatenated.
+ * */
+class GrowableArray {
+ public:
+  /* An empty array of rows of |shape| and |dtype|. */
+  GrowableArray(Shape shape, Dtype dtype, int max_length);
+
+  /* Append the rows of |x|, of shape (n, *shape), after the rows appended
+   * so far. It is evaluated first. */
+  void append(const array& x);
+
+  /* Get the array of the rows appended so far, which shares their memory.
+   * */
+  array data() const;
+
+  int length() const {
+    return length_;
+  }
+
+  int max_length() const {
+    return max_length_;
+  }
+
+ private:
+  array storage_;
+  int length_{0};
+  int max_length_;
+};
+
+/* Start tracing the GPU buffers allocated and freed.
+ *
+ * Each buffer is tagged with the primitive being evaluated when it was
+ * allocated, and marked as a temporary when the primitive only used it
+ * while running. The records of a previous trace are discarded.
+ * */
+void start_memory_tracing();
+
+/* Stop tracing the buffers, the records are kept until the next start. */
+void stop_memory_tracing();
+
+/* Get the |top_n| tags holding the most memory when the traced memory was
+ * the highest, in decreasing order of bytes. */
+std::vector<std::pair<std::string, size_t>> memory_trace_peak(int top_n = 10);
+
+/* Save the traced buffers with their tag, size and allocation and free
+ * times, and the |top_n| tags at the peak, as JSON to |path|. */
+void save_memory_trace(const std::string& path, int top_n = 10);
+
 } // namespace mlx::core::cu
@@ -0,0 +1,328 @@
+// Copyright © 2025 Apple Inc.
+
+#include <iostream>
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/jit_module.h"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/fast.h"
+#include "mlx/fast_primitives.h"
+
+#include <fmt/format.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core::fast {
+
+namespace {
+
+constexpr const char* g_kernel_includes = R"(
+#include "mlx/backend/cuda/device/atomic_ops.cuh"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/device/config.h"
+#include "mlx/backend/cuda/device/utils.cuh"
+
+#include <cooperative_groups.h>
+)";
+
+std::string template_arg_string(const TemplateArg& arg) {
+  if (std::holds_alternative<int>(arg)) {
+    return std::to_string(std::get<int>(arg));
+  } else if (std::holds_alternative<bool>(arg)) {
+    return std::get<bool>(arg) ? "true" : "false";
+  } else {
+    return dtype_to_cuda_type(std::get<Dtype>(arg));
+  }
+}
+
+std::string write_signature(
+    const std::string& func_name,
+    const std::string& header,
+    const std::string& source,
+    const std::vector<std::string>& input_names,
+    const std::vector<array>& inputs,
+    const std::vector<std::string>& output_names,
+    const std::vector<Dtype>& output_dtypes,
+    const std::vector<std::pair<std::string, TemplateArg>>& template_args,
+    const std::vector<CustomKernelShapeInfo>& shape_infos) {
+  std::string kernel_source;
+  kernel_source.reserve(header.size() + source.size() + 16384);
+  kernel_source += g_kernel_includes;
+  kernel_source += header;
+  kernel_source +=
+      "\nnamespace mlx::core::cu {\n\n"
+      "namespace cg = cooperative_groups;\n\n";
+  // Auto-generate a function signature based on `template_args`
+  // and the dtype/shape of the arrays passed as `inputs`.
+  if (!template_args.empty()) {
+    kernel_source += "template <";
+    for (int i = 0; i < template_args.size(); ++i) {
+      const auto& [name, arg] = template_args[i];
+      if (i > 0) {
+        kernel_source += ", ";
+      }
+      if (std::holds_alternative<int>(arg)) {
+        kernel_source += "int ";
+      } else if (std::holds_alternative<bool>(arg)) {
+        kernel_source += "bool ";
+      } else {
+        kernel_source += "typename ";
+      }
+      kernel_source += name;
+    }
+    kernel_source += ">\n";
+  }
+  kernel_source += "__global__ void ";
+  kernel_source += func_name;
+  kernel_source += "(\n";
+
+  std::vector<std::string> params;
+  // Add inputs, the scalars are passed by pointer as well
+  for (int i = 0; i < inputs.size(); ++i) {
+    const auto& name = input_names[i];
+    const auto& arr = inputs[i];
+    params.push_back(fmt::format(
+        "    const {}* {}", dtype_to_cuda_type(arr.dtype()), name));
+    // Add input shape, strides and ndim if present in the source
+    if (arr.ndim() > 0) {
+      if (shape_infos[i].shape) {
+        params.push_back(
+            fmt::format("    const __grid_constant__ Shape {}_shape", name));
+      }
+      if (shape_infos[i].strides) {
+        params.push_back(fmt::format(
+            "    const __grid_constant__ Strides {}_strides", name));
+      }
+      if (shape_infos[i].ndim) {
+        params.push_back(fmt::format("    const int {}_ndim", name));
+      }
+    }
+  }
+  // Add outputs
+  for (int i = 0; i < output_names.size(); ++i) {
+    params.push_back(fmt::format(
+        "    {}* {}", dtype_to_cuda_type(output_dtypes[i]), output_names[i]));
+  }
+  for (int i = 0; i < params.size(); ++i) {
+    kernel_source += params[i];
+    kernel_source += i < params.size() - 1 ? ",\n" : ") {\n";
+  }
+  kernel_source += source;
+  kernel_source += "\n}\n\n} // namespace mlx::core::cu\n";
+  return kernel_source;
+}
+
+} // namespace
+
+CustomKernelFunction cuda_kernel(
+    const std::string& name,
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::string& source,
+    const std::string& header /* = "" */,
+    bool ensure_row_contiguous /* = true */,
+    int shared_memory /* = 0 */) {
+  if (output_names.empty()) {
+    throw std::invalid_argument(
+        "[cuda_kernel] Must specify at least one output.");
+  }
+  std::vector<CustomKernelShapeInfo> shape_infos;
+  for (auto& n : input_names) {
+    CustomKernelShapeInfo shape_info;
+    shape_info.shape = source.find(n + "_shape") != std::string::npos;
+    shape_info.strides = source.find(n + "_strides") != std::string::npos;
+    shape_info.ndim = source.find(n + "_ndim") != std::string::npos;
+    shape_infos.push_back(shape_info);
+  }
+
+  return [=, shape_infos = std::move(shape_infos)](
+             const std::vector<array>& inputs,
+             const std::vector<Shape>& output_shapes,
+             const std::vector<Dtype>& output_dtypes,
+             std::tuple<int, int, int> grid,
+             std::tuple<int, int, int> threadgroup,
+             const std::vector<std::pair<std::string, TemplateArg>>&
+                 template_args = {},
+             std::optional<float> init_value = std::nullopt,
+             bool verbose = false,
+             StreamOrDevice s_ = {}) {
+    if (inputs.size() != input_names.size()) {
+      std::ostringstream msg;
+      msg << "[cuda_kernel] Expected `inputs` to have size "
+          << input_names.size() << " but got size " << inputs.size() << "."
+          << std::endl;
+      throw std::invalid_argument(msg.str());
+    }
+    if (output_shapes.size() != output_names.size()) {
+      std::ostringstream msg;
+      msg << "[cuda_kernel] Expected `output_shapes` to have size "
+          << output_names.size() << " but got size " << output_shapes.size()
+          << "." << std::endl;
+      throw std::invalid_argument(msg.str());
+    }
+    if (output_dtypes.size() != output_names.size()) {
+      std::ostringstream msg;
+      msg << "[cuda_kernel] Expected `output_dtypes` to have size "
+          << output_names.size() << " but got size " << output_dtypes.size()
+          << "." << std::endl;
+      throw std::invalid_argument(msg.str());
+    }
+
+    auto s = to_stream(s_);
+    if (s.device != Device::gpu) {
+      throw std::invalid_argument("[cuda_kernel] Only supports the GPU.");
+    }
+
+    std::string func_name = "custom_kernel_" + name;
+    std::string kernel_source = write_signature(
+        func_name,
+        header,
+        source,
+        input_names,
+        inputs,
+        output_names,
+        output_dtypes,
+        template_args,
+        shape_infos);
+
+    // The kernel is named by the expression which instantiates it.
+    std::string kernel_name = "mlx::core::cu::" + func_name;
+    if (!template_args.empty()) {
+      kernel_name += "<";
+      for (int i = 0; i < template_args.size(); ++i) {
+        if (i > 0) {
+          kernel_name += ", ";
+        }
+        kernel_name += template_arg_string(template_args[i].second);
+      }
+      kernel_name += ">";
+    }
+
+    if (verbose) {
+      std::cout << "Generated source code for `" << name << "`:" << std::endl
+                << "```" << std::endl
+                << kernel_source << std::endl
+                << "```" << std::endl;
+    }
+
+    return array::make_arrays(
+        std::move(output_shapes),
+        std::move(output_dtypes),
+        std::make_shared<CustomKernel>(
+            s,
+            std::move(kernel_name),
+            std::move(kernel_source),
+            grid,
+            threadgroup,
+            shape_infos,
+            ensure_row_contiguous,
+            init_value,
+            shared_memory),
+        std::move(inputs));
+  };
+}
+
+void CustomKernel::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("CustomKernel::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  std::vector<array> copies;
+
+  for (auto& out : outputs) {
+    if (init_value_) {
+      copies.emplace_back(init_value_.value(), out.dtype());
+      fill_gpu(copies.back(), out, s);
+    } else {
+      out.set_data(allocator::malloc(out.nbytes()));
+    }
+  }
+
+  auto check_input = [&copies, &s, this](const array& x) -> const array {
+    bool no_copy = x.flags().row_contiguous;
+    if (!ensure_row_contiguous_ || no_copy) {
+      return x;
+    } else {
+      copies.push_back(array(x.shape(), x.dtype(), nullptr, {}));
+      copy_gpu(x, copies.back(), CopyType::General, s);
+      return copies.back();
+    }
+  };
+  std::vector<array> checked_inputs;
+  for (const array& in : inputs) {
+    checked_inputs.push_back(check_input(in));
+  }
+
+  // The source and the instantiation are hashed in the module name so a
+  // kernel redefined with the same name does not reuse the previous binary.
+  std::string module_name = fmt::format(
+      "custom_kernel_{:016x}", std::hash<std::string>{}(name_ + source_));
+  cu::JitModule& mod = cu::get_jit_module(s.device, module_name, [&]() {
+    return std::make_pair(source_, std::vector<std::string>{name_});
+  });
+  auto kernel = mod.get_kernel(name_);
+
+  cu::KernelArgs args;
+  for (int i = 0; i < checked_inputs.size(); i++) {
+    const array& in = checked_inputs[i];
+    auto& shape_info = shape_infos_[i];
+    args.append(in);
+    if (in.ndim() > 0) {
+      if (shape_info.shape) {
+        args.append_ndim(in.shape());
+      }
+      if (shape_info.strides) {
+        args.append_ndim(in.strides());
+      }
+      if (shape_info.ndim) {
+        args.append<int32_t>(in.ndim());
+      }
+    }
+  }
+  for (auto& out : outputs) {
+    args.append(out);
+  }
+
+  const auto [tx, ty, tz] = threadgroup_;
+  int max_block_size;
+  CHECK_CUDA_ERROR(cuFuncGetAttribute(
+      &max_block_size, CU_FUNC_ATTRIBUTE_MAX_THREADS_PER_BLOCK, kernel));
+  if (tx * ty * tz > max_block_size) {
+    std::ostringstream msg;
+    msg << "Thread group size (" << tx * ty * tz << ") is greater than "
+        << " the maximum allowed threads per block (" << max_block_size
+        << ").";
+    throw std::invalid_argument(msg.str());
+  }
+  if (shared_memory_ > 0) {
+    CHECK_CUDA_ERROR(cuFuncSetAttribute(
+        kernel,
+        CU_FUNC_ATTRIBUTE_MAX_DYNAMIC_SHARED_SIZE_BYTES,
+        shared_memory_));
+  }
+
+  // Like the Metal kernels the grid is in threads, the blocks past the end
+  // of the grid are launched whole so the kernel checks its bounds.
+  const auto [gx, gy, gz] = grid_;
+  dim3 block_dims(std::min(tx, gx), std::min(ty, gy), std::min(tz, gz));
+  dim3 grid_dims(
+      (gx + block_dims.x - 1) / block_dims.x,
+      (gy + block_dims.y - 1) / block_dims.y,
+      (gz + block_dims.z - 1) / block_dims.z);
+
+  for (const auto& in : checked_inputs) {
+    encoder.set_input_array(in);
+  }
+  for (const auto& out : outputs) {
+    encoder.set_output_array(out);
+  }
+  encoder.add_kernel_node(
+      kernel, grid_dims, block_dims, args.args(), shared_memory_);
+  for (auto& copy : copies) {
+    encoder.add_temporary(copy);
+  }
+}
+
+} // namespace mlx::core::fast
@@ -1,19 +1,44 @@
 // Copyright © 2025 Apple Inc.
 
+#include "mlx/backend/cuda/allocator.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/l2_persistence.h"
+#include "mlx/backend/cuda/megakernel.h"
+#include "mlx/backend/cuda/offload.h"
 #include "mlx/backend/cuda/worker.h"
+#include "mlx/scheduler.h"
 #include "mlx/utils.h"
 
 #include <fmt/format.h>
 #include <nvtx3/nvtx3.hpp>
+#include <algorithm>
+#include <cmath>
 #include <future>
-#include <unordered_set>
 
 namespace mlx::core {
 
-// Can be tuned with MLX_MAX_OPS_PER_BUFFER
-// This should be less than 255
+// The number of nodes of a graph before the kernel time is measured, the
+// commits are then sized to run for about |target_graph_ms| on the GPU
+// unless MLX_MAX_OPS_PER_BUFFER sets a fixed number of nodes.
 constexpr int default_max_nodes_per_graph = 20;
+constexpr int max_adaptive_nodes_per_graph = 512;
+constexpr float target_graph_ms = 1.0f;
+
+// Can be tuned with MLX_MAX_MB_PER_BUFFER
+constexpr int default_max_mb_per_graph = 256;
+
+// The number of graphs timed at once.
+constexpr int num_graph_timings = 8;
+
+namespace cu {
+
+namespace {
+
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+} // namespace
 
 int cuda_graph_cache_size() {
   static int cache_size = []() {
@@ -22,13 +47,17 @@ int cuda_graph_cache_size() {
   return cache_size;
 }
 
-namespace cu {
-
 Device::Device(int device) : device_(device) {
   CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
       &compute_capability_major_, cudaDevAttrComputeCapabilityMajor, device_));
   CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
       &compute_capability_minor_, cudaDevAttrComputeCapabilityMinor, device_));
+  CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
+      &multi_processor_count_, cudaDevAttrMultiProcessorCount, device_));
+#if CUDART_VERSION >= 12030
+  dependent_launch_ = compute_capability_major_ >= 9 &&
+      env::get_var("MLX_CUDA_DEPENDENT_LAUNCH", 0);
+#endif
   // Validate the requirements of device.
   int attr = 0;
   CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
@@ -41,26 +70,127 @@ Device::Device(int device) : device_(device) {
   // The cublasLt handle is used by matmul.
   make_current();
   cublasLtCreate(&lt_);
+  // Access the memory of the peers directly, which also makes the copies
+  // between the devices direct.
+  int device_count;
+  CHECK_CUDA_ERROR(cudaGetDeviceCount(&device_count));
+  for (int peer = 0; peer < device_count; ++peer) {
+    int can_access = 0;
+    CHECK_CUDA_ERROR(cudaDeviceCanAccessPeer(&can_access, device_, peer));
+    if (peer == device_ || !can_access) {
+      continue;
+    }
+    cudaError_t err = cudaDeviceEnablePeerAccess(peer, 0);
+    if (err == cudaErrorPeerAccessAlreadyEnabled) {
+      cudaGetLastError(); // reset error
+    } else {
+      CHECK_CUDA_ERROR(err);
+    }
+  }
 }
 
 Device::~Device() {
   cublasLtDestroy(lt_);
+  if (blas_) {
+    cublasDestroy(blas_);
+  }
+  if (solver_) {
+    cusolverDnDestroy(solver_);
+  }
+  if (sparse_) {
+    cusparseDestroy(sparse_);
+  }
+#if CUDA_VERSION >= 12040
+  for (auto ctx : green_ctxs_) {
+    cuGreenCtxDestroy(ctx);
+  }
+#endif
+}
+
+#if CUDA_VERSION >= 12040
+CUgreenCtx Device::sm_partition(float fraction) {
+  CUdevice dev;
+  CHECK_CUDA_ERROR(cuDeviceGet(&dev, device_));
+  if (!free_sms_) {
+    CUdevResource sms;
+    CHECK_CUDA_ERROR(
+        cuDeviceGetDevResource(dev, &sms, CU_DEV_RESOURCE_TYPE_SM));
+    free_sms_ = sms;
+  }
+  auto count = static_cast<unsigned int>(
+      std::ceil(fraction * multi_processor_count_));
+  CUdevResource partition;
+  CUdevResource rest;
+  unsigned int num_groups = 1;
+  CHECK_CUDA_ERROR(cuDevSmResourceSplitByCount(
+      &partition, &num_groups, &*free_sms_, &rest, 0, count));
+  if (num_groups == 0) {
+    throw std::runtime_error(fmt::format(
+        "[new_stream] Cannot partition {} SMs of device {}, {} SMs are not "
+        "in a partition.",
+        count,
+        device_,
+        free_sms_->sm.smCount));
+  }
+  free_sms_ = rest;
+  CUdevResourceDesc desc;
+  CHECK_CUDA_ERROR(cuDevResourceGenerateDesc(&desc, &partition, 1));
+  CUgreenCtx ctx;
+  CHECK_CUDA_ERROR(
+      cuGreenCtxCreate(&ctx, desc, dev, CU_GREEN_CTX_DEFAULT_STREAM));
+  green_ctxs_.push_back(ctx);
+  return ctx;
 }
+#endif
 
 void Device::make_current() {
   // We need to set/get current CUDA device very frequently, cache it to reduce
-  // actual calls of CUDA APIs. This function assumes single-thread in host.
-  static int current = 0;
+  // actual calls of CUDA APIs. The current device is per host thread.
+  static thread_local int current = -1;
   if (current != device_) {
     CHECK_CUDA_ERROR(cudaSetDevice(device_));
     current = device_;
   }
 }
 
+cublasHandle_t Device::blas_handle() {
+  std::call_once(blas_once_, [this]() {
+    make_current();
+    CHECK_CUBLAS_ERROR(cublasCreate(&blas_));
+  });
+  return blas_;
+}
+
+cusolverDnHandle_t Device::solver_handle() {
+  std::call_once(solver_once_, [this]() {
+    make_current();
+    cusolverStatus_t err = cusolverDnCreate(&solver_);
+    if (err != CUSOLVER_STATUS_SUCCESS) {
+      throw std::runtime_error(fmt::format(
+          "cusolverDnCreate failed with code: {}.", static_cast<int>(err)));
+    }
+  });
+  return solver_;
+}
+
+cusparseHandle_t Device::sparse_handle() {
+  std::call_once(sparse_once_, [this]() {
+    make_current();
+    cusparseStatus_t err = cusparseCreate(&sparse_);
+    if (err != CUSPARSE_STATUS_SUCCESS) {
+      throw std::runtime_error(fmt::format(
+          "cusparseCreate failed with code: {} ({}).",
+          static_cast<int>(err),
+          cusparseGetErrorString(err)));
+    }
+  });
+  return sparse_;
+}
+
 CommandEncoder& Device::get_command_encoder(Stream s) {
   auto it = encoders_.find(s.index);
   if (it == encoders_.end()) {
-    it = encoders_.try_emplace(s.index, *this).first;
+    it = encoders_.try_emplace(s.index, *this, s).first;
   }
   return it->second;
 }
@@ -74,9 +204,14 @@ CommandEncoder::CaptureContext::~CaptureContext() {
   CHECK_CUDA_ERROR(cudaStreamEndCapture(enc.stream(), &graph));
   size_t num_nodes;
   CHECK_CUDA_ERROR(cudaGraphGetNodes(graph, NULL, &num_nodes));
+  cudaGraphNode_t captured_node;
+  cudaGraphNodeType node_type = cudaGraphNodeTypeEmpty;
   if (num_nodes == 1) {
-    cudaGraphNode_t captured_node;
     CHECK_CUDA_ERROR(cudaGraphGetNodes(graph, &captured_node, &num_nodes));
+    CHECK_CUDA_ERROR(cudaGraphNodeGetType(captured_node, &node_type));
+  }
+  // A single kernel is added as is, other captures as a subgraph.
+  if (node_type == cudaGraphNodeTypeKernel) {
     CUDA_KERNEL_NODE_PARAMS params;
     CHECK_CUDA_ERROR(cuGraphKernelNodeGetParams(captured_node, &params));
     cudaGraphNode_t node;
@@ -93,6 +228,7 @@ CommandEncoder::CaptureContext::~CaptureContext() {
 
 CommandEncoder::ConcurrentContext::ConcurrentContext(CommandEncoder& enc)
     : enc(enc) {
+  enc.flush_megakernel();
   enc.in_concurrent_ = true;
 }
 
@@ -100,24 +236,22 @@ CommandEncoder::ConcurrentContext::~ConcurrentContext() {
   enc.in_concurrent_ = false;
 
   // Use an empty graph node for synchronization
-  CommandEncoder::GraphNode empty{NULL, 'E', std::to_string(enc.node_count_++)};
+  CommandEncoder::GraphNode empty{
+      NULL, 'E', static_cast<uint32_t>(enc.node_count_++)};
   enc.empty_node_count_++;
   CHECK_CUDA_ERROR(cudaGraphAddEmptyNode(&empty.node, enc.graph_, NULL, 0));
 
   // Insert the concurrent -> empty node dependencies
   for (auto& from : enc.concurrent_nodes_) {
-    enc.from_nodes_.push_back(from.node);
-    enc.to_nodes_.push_back(empty.node);
-    enc.graph_key_ += from.id;
-    enc.graph_key_ += from.node_type;
-    enc.graph_key_ += empty.id;
-    enc.graph_key_ += empty.node_type;
+    enc.add_graph_edge(from, empty);
   }
 
-  // Insert the input -> concurrent node dependencies without updating output
-  // nodes
-  auto outputs = std::move(enc.active_outputs_);
-  enc.insert_graph_dependencies(std::move(enc.concurrent_nodes_));
+  // Insert the input -> concurrent node dependencies, the output nodes are
+  // then replaced by the empty node
+  auto outputs = enc.active_outputs_;
+  enc.insert_graph_dependencies(
+      enc.concurrent_nodes_.data(), enc.concurrent_nodes_.size());
+  enc.concurrent_nodes_.clear();
 
   // Update output node to be the empty node
   for (auto o : outputs) {
@@ -126,88 +260,258 @@ CommandEncoder::ConcurrentContext::~ConcurrentContext() {
 }
 
 void CommandEncoder::insert_graph_dependencies(GraphNode node) {
+  flush_megakernel();
   if (node.node_type == 'G') {
     graph_node_count_++;
   }
-  node.id = std::to_string(node_count_++);
+  node.id = node_count_++;
+  if ((node.node_type == 'K' || node.node_type == 'D') &&
+      l2_persistence().enabled() &&
+      l2_persistence().set_window(device_, node.node, active_inputs_)) {
+    // The windows are in the topology so the graphs with and without them
+    // do not share an executable.
+    uint64_t window = (static_cast<uint64_t>(node.id) << 8) | 'L';
+    graph_topology_.push_back(window);
+    graph_hash_ = hash_combine(graph_hash_, window);
+  }
   if (in_concurrent_) {
-    concurrent_nodes_.push_back(std::move(node));
+    concurrent_nodes_.push_back(node);
   } else {
-    std::vector<GraphNode> nodes;
-    nodes.push_back(std::move(node));
-    insert_graph_dependencies(std::move(nodes));
+    insert_graph_dependencies(&node, 1);
   }
 }
 
-void CommandEncoder::insert_graph_dependencies(std::vector<GraphNode> nodes) {
-  std::vector<GraphNode> deps;
-  {
-    // Dependencies must be added in the same order to produce a consistent
-    // topology
-    std::unordered_set<cudaGraphNode_t> set_deps;
-    for (auto d : active_deps_) {
-      if (auto it = node_map_.find(d); it != node_map_.end()) {
-        auto [_, inserted] = set_deps.insert(it->second.node);
-        if (inserted) {
-          deps.push_back(it->second);
-        }
+void CommandEncoder::insert_graph_dependencies(
+    const GraphNode* nodes,
+    size_t num_nodes) {
+  // Dependencies must be added in the same order to produce a consistent
+  // topology. A node has few dependencies so a linear search is cheaper than
+  // a set.
+  deps_.clear();
+  auto add_dep = [this](const GraphNode& dep) {
+    auto same_node = [&](const GraphNode& n) { return n.node == dep.node; };
+    if (std::none_of(deps_.begin(), deps_.end(), same_node)) {
+      deps_.push_back(dep);
+    }
+  };
+  // The nodes depend on the last writers of the buffers they read or write.
+  for (auto d : active_deps_) {
+    if (auto it = node_map_.find(d); it != node_map_.end()) {
+      add_dep(it->second);
+    }
+  }
+  // The nodes writing a buffer also wait for the nodes still reading it.
+  for (auto o : active_outputs_) {
+    if (auto it = readers_.find(o); it != readers_.end()) {
+      for (auto& reader : it->second) {
+        add_dep(reader);
       }
+      it->second.clear();
+    }
+  }
+  if (record_graph_ && num_nodes > 0) {
+    // The nodes added together may run concurrently, so the buffers are used
+    // by all of them.
+    int first = record_nodes_ + nodes[0].id;
+    int last = record_nodes_ + nodes[num_nodes - 1].id;
+    for (auto d : active_deps_) {
+      record_uses_.try_emplace(d, first, last).first->second.second = last;
     }
   }
   active_deps_.clear();
 
   for (auto o : active_outputs_) {
-    for (auto& node : nodes) {
-      node_map_.emplace(o, node).first->second = node;
+    for (size_t i = 0; i < num_nodes; ++i) {
+      node_map_.insert_or_assign(o, nodes[i]);
     }
   }
+  for (auto in : active_inputs_) {
+    if (std::find(active_outputs_.begin(), active_outputs_.end(), in) ==
+        active_outputs_.end()) {
+      auto& readers = readers_[in];
+      readers.insert(readers.end(), nodes, nodes + num_nodes);
+    }
+  }
+  active_inputs_.clear();
   active_outputs_.clear();
 
-  for (auto& from : deps) {
-    for (auto& to : nodes) {
-      from_nodes_.push_back(from.node);
-      to_nodes_.push_back(to.node);
-      graph_key_ += from.id;
-      graph_key_ += from.node_type;
-      graph_key_ += to.id;
-      graph_key_ += to.node_type;
+  for (auto& from : deps_) {
+    for (size_t i = 0; i < num_nodes; ++i) {
+      add_graph_edge(from, nodes[i]);
     }
   }
 }
 
-CommandEncoder::CommandEncoder(Device& d) : device_(d), stream_(d) {
-  CHECK_CUDA_ERROR(cudaGraphCreate(&graph_, 0));
+void CommandEncoder::add_graph_edge(
+    const GraphNode& from,
+    const GraphNode& to) {
+  from_nodes_.push_back(from.node);
+  to_nodes_.push_back(to.node);
+#if CUDART_VERSION >= 12030
+  if (device_.dependent_launch()) {
+    // The kernel waits for the kernels before it, which trigger it once all
+    // their blocks started.
+    cudaGraphEdgeData data = {};
+    if (to.node_type == 'D' &&
+        (from.node_type == 'K' || from.node_type == 'D')) {
+      data.from_port = cudaGraphKernelNodePortProgrammatic;
+      data.type = cudaGraphDependencyTypeProgrammatic;
+    }
+    edge_data_.push_back(data);
+  }
+#endif
+  uint64_t edge = (static_cast<uint64_t>(from.id) << 40) |
+      (static_cast<uint64_t>(from.node_type) << 32) |
+      (static_cast<uint64_t>(to.id) << 8) | static_cast<uint64_t>(to.node_type);
+  graph_topology_.push_back(edge);
+  graph_hash_ = hash_combine(graph_hash_, edge);
+}
+
+GraphCacheStats& graph_cache_stats() {
+  static GraphCacheStats stats;
+  return stats;
 }
 
-void clear_graphs(std::unordered_map<std::string, cudaGraphExec_t>& graphs) {
-  for (auto& [_, graph_exec] : graphs) {
-    CHECK_CUDA_ERROR(cudaGraphExecDestroy(graph_exec));
+DispatchStats& dispatch_stats() {
+  static DispatchStats stats;
+  return stats;
+}
+
+CommandEncoder::CommandEncoder(Device& d, Stream s)
+    : device_(d),
+      mlx_stream_(s),
+      stream_(d, s.priority, s.sm_fraction),
+      worker_(s.priority),
+      graph_cache_(cuda_graph_cache_size()) {
+  CHECK_CUDA_ERROR(cudaGraphCreate(&graph_, 0));
+  int max_nodes = env::get_var("MLX_MAX_OPS_PER_BUFFER", 0);
+  adaptive_ = max_nodes <= 0;
+  max_nodes_per_graph_ = adaptive_ ? default_max_nodes_per_graph : max_nodes;
+  max_mb_per_graph_ = env::max_mb_per_buffer(default_max_mb_per_graph);
+  graph_timings_.resize(num_graph_timings);
+  for (auto& timing : graph_timings_) {
+    CHECK_CUDA_ERROR(cudaEventCreate(&timing.start));
+    CHECK_CUDA_ERROR(cudaEventCreate(&timing.end));
   }
-  graphs.clear();
 }
 
 CommandEncoder::~CommandEncoder() {
-  clear_graphs(graph_cache_);
+  for (auto& timing : pending_timings_) {
+    graph_timings_.push_back(timing);
+  }
+  for (auto& timing : graph_timings_) {
+    cudaEventDestroy(timing.start);
+    cudaEventDestroy(timing.end);
+  }
 }
 
 void CommandEncoder::add_completed_handler(std::function<void()> task) {
   worker_.add_task(std::move(task));
 }
 
+void CommandEncoder::add_megakernel_stage(MegakernelStage stage) {
+  if (!megakernel_) {
+    megakernel_ = std::make_unique<Megakernel>(*this);
+  }
+  megakernel_->add(std::move(stage));
+}
+
+void CommandEncoder::flush_megakernel() {
+  if (!megakernel_ || megakernel_->empty()) {
+    return;
+  }
+  // The buffers set for the node being added are set again after the
+  // deferred kernels, which come before it.
+  auto deps = std::move(active_deps_);
+  auto inputs = std::move(active_inputs_);
+  auto outputs = std::move(active_outputs_);
+  active_deps_.clear();
+  active_inputs_.clear();
+  active_outputs_.clear();
+  megakernel_->flush();
+  active_deps_ = std::move(deps);
+  active_inputs_ = std::move(inputs);
+  active_outputs_ = std::move(outputs);
+}
+
 void CommandEncoder::set_input_array(const array& arr) {
   auto id = reinterpret_cast<std::uintptr_t>(arr.buffer().ptr());
+  // Empty arrays have no buffer and do not order the nodes.
+  if (id == 0) {
+    return;
+  }
+  graph_bytes_ += arr.data_size() * arr.itemsize();
   active_deps_.push_back(id);
+  active_inputs_.push_back(id);
+  if (record_graph_) {
+    record_data_.push_back(arr.data_shared_ptr());
+  }
+  if (auto& o = offloader(); o.enabled()) {
+    o.on_input(arr.buffer().ptr(), device_.cuda_device(), stream_);
+  }
+  if (auto& l2 = l2_persistence(); l2.enabled()) {
+    l2.on_input(device_, reinterpret_cast<CudaBuffer*>(id), commits_);
+  }
+  // Move the memory written by the host to the device before the kernels
+  // reading it fault on it.
+  allocator().prefetch(arr.buffer(), device_.cuda_device(), stream_);
 }
 
 void CommandEncoder::set_output_array(const array& arr) {
   auto id = reinterpret_cast<std::uintptr_t>(arr.buffer().ptr());
+  if (id == 0) {
+    return;
+  }
+  graph_bytes_ += arr.data_size() * arr.itemsize();
   active_deps_.push_back(id);
   active_outputs_.push_back(id);
+  reinterpret_cast<CudaBuffer*>(id)->location = device_.cuda_device();
+  if (record_graph_) {
+    record_data_.push_back(arr.data_shared_ptr());
+  }
 }
 
 void CommandEncoder::maybe_commit() {
-  if (node_count_ >= env::max_ops_per_buffer(default_max_nodes_per_graph)) {
+  if (node_count_ >= max_nodes_per_graph_ ||
+      (graph_bytes_ >> 20) >= max_mb_per_graph_) {
     commit();
+    return;
+  }
+  // Commit early when the GPU has finished the previous graphs so it does not
+  // idle while the graph is built, once there is enough work to amortize the
+  // launch.
+  if (node_count_ >= std::max(max_nodes_per_graph_ / 4, 1)) {
+    update_graph_timings();
+    if (graph_timings_.size() == num_graph_timings) {
+      commit();
+    }
+  }
+}
+
+void CommandEncoder::update_graph_timings() {
+  // The timings are retired in order, |graph_timings_| holds the free ones
+  // and |pending_timings_| those of the graphs still running.
+  while (!pending_timings_.empty()) {
+    auto& timing = pending_timings_.front();
+    if (cudaEventQuery(timing.end) != cudaSuccess) {
+      break;
+    }
+    float ms;
+    CHECK_CUDA_ERROR(cudaEventElapsedTime(&ms, timing.start, timing.end));
+    auto& stats = dispatch_stats();
+    stats.gpu_ns += static_cast<uint64_t>(ms * 1e6);
+    stats.gpu_nodes += timing.num_nodes;
+    float node_ms = ms / timing.num_nodes;
+    node_ms_ = node_ms_ > 0 ? 0.75f * node_ms_ + 0.25f * node_ms : node_ms;
+    graph_timings_.push_back(timing);
+    pending_timings_.pop_front();
+  }
+  if (adaptive_ && node_ms_ > 0) {
+    float nodes = std::clamp(
+        target_graph_ms / node_ms_,
+        1.0f,
+        static_cast<float>(max_adaptive_nodes_per_graph));
+    max_nodes_per_graph_ = static_cast<int>(nodes);
   }
 }
 
@@ -227,11 +531,12 @@ void CommandEncoder::add_kernel_node(
   insert_graph_dependencies(GraphNode{node, 'K'});
 }
 
-void CommandEncoder::add_kernel_node(
+CUgraphNode CommandEncoder::create_kernel_node(
     CUfunction func,
     dim3 grid_dim,
     dim3 block_dim,
-    void** params) {
+    void** params,
+    uint32_t shared_memory) {
   CUDA_KERNEL_NODE_PARAMS kernel_params = {0};
   kernel_params.func = func;
   kernel_params.gridDimX = grid_dim.x;
@@ -240,74 +545,209 @@ void CommandEncoder::add_kernel_node(
   kernel_params.blockDimX = block_dim.x;
   kernel_params.blockDimY = block_dim.y;
   kernel_params.blockDimZ = block_dim.z;
+  kernel_params.sharedMemBytes = shared_memory;
   kernel_params.kernelParams = params;
   CUgraphNode node;
   CHECK_CUDA_ERROR(
       cuGraphAddKernelNode(&node, graph_, NULL, 0, &kernel_params));
+  return node;
+}
+
+void CommandEncoder::add_kernel_node(
+    CUfunction func,
+    dim3 grid_dim,
+    dim3 block_dim,
+    void** params,
+    uint32_t shared_memory,
+    bool cooperative) {
+  CUgraphNode node =
+      create_kernel_node(func, grid_dim, block_dim, params, shared_memory);
+  if (cooperative) {
+    CUkernelNodeAttrValue value = {};
+    value.cooperative = 1;
+    CHECK_CUDA_ERROR(cuGraphKernelNodeSetAttribute(
+        node, CU_KERNEL_NODE_ATTRIBUTE_COOPERATIVE, &value));
+  }
   insert_graph_dependencies(GraphNode{node, 'K'});
 }
 
+void CommandEncoder::add_dependent_kernel_node(
+    CUfunction func,
+    dim3 grid_dim,
+    dim3 block_dim,
+    void** params) {
+  CUgraphNode node = create_kernel_node(func, grid_dim, block_dim, params, 0);
+  char node_type = device_.dependent_launch() ? 'D' : 'K';
+  insert_graph_dependencies(GraphNode{node, node_type});
+}
+
 void CommandEncoder::commit() {
+  flush_megakernel();
   if (!temporaries_.empty()) {
+    // Reserve for the next commit so adding temporaries does not reallocate.
+    size_t num_temporaries = temporaries_.size();
     add_completed_handler([temporaries = std::move(temporaries_)]() {});
+    temporaries_.clear();
+    temporaries_.reserve(num_temporaries);
   }
+  auto start = std::chrono::steady_clock::now();
+  uint64_t exec_ns = 0;
   if (node_count_ > 0) {
     if (!from_nodes_.empty()) {
+#if CUDART_VERSION >= 12030
+      if (device_.dependent_launch()) {
+        CHECK_CUDA_ERROR(cudaGraphAddDependencies_v2(
+            graph_,
+            from_nodes_.data(),
+            to_nodes_.data(),
+            edge_data_.data(),
+            from_nodes_.size()));
+      } else {
+        CHECK_CUDA_ERROR(cudaGraphAddDependencies(
+            graph_, from_nodes_.data(), to_nodes_.data(), from_nodes_.size()));
+      }
+#else
       CHECK_CUDA_ERROR(cudaGraphAddDependencies(
           graph_, from_nodes_.data(), to_nodes_.data(), from_nodes_.size()));
+#endif
     }
 
-    graph_key_ += ".";
-    graph_key_ += std::to_string(node_count_);
-    graph_key_ += ".";
-    graph_key_ += std::to_string(graph_node_count_);
-    graph_key_ += ".";
-    graph_key_ += std::to_string(empty_node_count_);
-
-    cudaGraphExec_t& graph_exec = graph_cache_[graph_key_];
-
-    if (graph_exec != nullptr) {
-      cudaGraphExecUpdateResult update_result;
-#if CUDART_VERSION >= 12000
-      cudaGraphExecUpdateResultInfo info;
-      cudaGraphExecUpdate(graph_exec, graph_, &info);
-      update_result = info.result;
-#else
-      cudaGraphNode_t error_node;
-      cudaGraphExecUpdate(graph_exec, graph_, &error_node, &update_result);
-#endif // CUDART_VERSION >= 12000
-      if (update_result != cudaGraphExecUpdateSuccess) {
-        cudaGetLastError(); // reset error
-        CHECK_CUDA_ERROR(cudaGraphExecDestroy(graph_exec));
-        graph_exec = nullptr;
-      }
+    // The node counts are part of the topology as the nodes without edges
+    // are not in the edges.
+    uint64_t counts = (static_cast<uint64_t>(node_count_) << 32) |
+        (static_cast<uint64_t>(graph_node_count_) << 16) |
+        static_cast<uint64_t>(empty_node_count_);
+    graph_topology_.push_back(counts);
+    graph_hash_ = hash_combine(graph_hash_, counts);
+
+    if (record_graph_) {
+      cudaGraphNode_t node;
+      CHECK_CUDA_ERROR(cudaGraphAddChildGraphNode(
+          &node, record_graph_, &record_tail_, record_tail_ ? 1 : 0, graph_));
+      record_tail_ = node;
+      record_nodes_ += node_count_;
     }
-    if (graph_exec == nullptr) {
-      CHECK_CUDA_ERROR(
-          cudaGraphInstantiate(&graph_exec, graph_, NULL, NULL, 0));
+
+    auto& stats = graph_cache_stats();
+    auto& dispatch = dispatch_stats();
+    auto instantiate = [&]() {
+      auto exec_start = std::chrono::steady_clock::now();
+      stats.instantiations++;
+      auto exec = CudaGraphExec(graph_);
+      uint64_t ns = elapsed_ns(exec_start);
+      dispatch.instantiate_ns += ns;
+      exec_ns += ns;
+      return exec;
+    };
+    CachedGraph* cached = graph_cache_.find(graph_hash_);
+    if (cached && cached->topology == graph_topology_) {
+      stats.hits++;
+      auto exec_start = std::chrono::steady_clock::now();
+      bool updated = cached->exec.update(graph_);
+      uint64_t ns = elapsed_ns(exec_start);
+      dispatch.update_ns += ns;
+      exec_ns += ns;
+      if (!updated) {
+        cached->exec = instantiate();
+      }
+    } else if (cached) {
+      // A different graph with the same hash, it replaces the cached one.
+      stats.misses++;
+      cached->exec = instantiate();
+      cached->topology = graph_topology_;
+    } else {
+      stats.misses++;
+      size_t cache_size = graph_cache_.size();
+      cached = &graph_cache_.insert(
+          graph_hash_, CachedGraph{instantiate(), graph_topology_});
+      if (graph_cache_.size() == cache_size) {
+        stats.evictions++;
+      }
     }
     device_.make_current();
-    CHECK_CUDA_ERROR(cudaGraphLaunch(graph_exec, stream_));
-
-    // TODO smarter cache policy
-    if (graph_cache_.size() > cuda_graph_cache_size()) {
-      clear_graphs(graph_cache_);
+    // Time the graph when a timing is free, the previous ones are retired
+    // first.
+    update_graph_timings();
+    bool timed = !graph_timings_.empty();
+    if (timed) {
+      CHECK_CUDA_ERROR(cudaEventRecord(graph_timings_.back().start, stream_));
+    }
+    CHECK_CUDA_ERROR(cudaGraphLaunch(cached->exec, stream_));
+    dispatch.graphs++;
+    dispatch.nodes += node_count_;
+    commits_++;
+    if (timed) {
+      auto timing = graph_timings_.back();
+      graph_timings_.pop_back();
+      timing.num_nodes = node_count_;
+      CHECK_CUDA_ERROR(cudaEventRecord(timing.end, stream_));
+      pending_timings_.push_back(timing);
     }
 
     // Reset state
     node_count_ = 0;
     graph_node_count_ = 0;
+    empty_node_count_ = 0;
+    graph_bytes_ = 0;
     from_nodes_.clear();
     to_nodes_.clear();
-    graph_key_.clear();
+#if CUDART_VERSION >= 12030
+    edge_data_.clear();
+#endif
+    graph_topology_.clear();
+    graph_hash_ = 0;
     node_map_.clear();
+    readers_.clear();
     CHECK_CUDA_ERROR(cudaGraphDestroy(graph_));
     CHECK_CUDA_ERROR(cudaGraphCreate(&graph_, 0));
+
+    // The graph is a task of the scheduler until its buffers are released,
+    // so the evaluation can wait for them under memory pressure.
+    scheduler::notify_new_task(mlx_stream_);
+    add_completed_handler(
+        [s = mlx_stream_]() { scheduler::notify_task_completion(s); });
   }
 
   // Put completion handlers in a batch.
   worker_.end_batch();
   worker_.commit(stream_);
+  dispatch_stats().launch_ns += elapsed_ns(start) - exec_ns;
+}
+
+void CommandEncoder::begin_recording() {
+  commit();
+  CHECK_CUDA_ERROR(cudaGraphCreate(&record_graph_, 0));
+  record_tail_ = nullptr;
+  record_nodes_ = 0;
+}
+
+CommandEncoder::Recording CommandEncoder::end_recording() {
+  commit();
+  Recording recording{
+      CudaGraphExec(record_graph_),
+      record_nodes_,
+      std::move(record_data_),
+      std::move(record_uses_)};
+  CHECK_CUDA_ERROR(cudaGraphDestroy(record_graph_));
+  record_graph_ = nullptr;
+  record_data_.clear();
+  record_uses_.clear();
+  auto& data = recording.data;
+  std::sort(data.begin(), data.end());
+  data.erase(std::unique(data.begin(), data.end()), data.end());
+  return recording;
+}
+
+void CommandEncoder::launch(const Recording& recording) {
+  commit();
+  if (recording.num_nodes == 0) {
+    return;
+  }
+  device_.make_current();
+  CHECK_CUDA_ERROR(cudaGraphLaunch(recording.exec, stream_));
+  auto& dispatch = dispatch_stats();
+  dispatch.graphs++;
+  dispatch.nodes += recording.num_nodes;
 }
 
 void CommandEncoder::synchronize() {
@@ -333,6 +773,18 @@ CommandEncoder& get_command_encoder(Stream s) {
   return device(s.device).get_command_encoder(s);
 }
 
+char* ThrustAllocator::allocate(size_t size) {
+  // The temporary storage is usually allocated while capturing the kernels
+  // of thrust and cub, relax the capture mode so the allocator can call the
+  // cuda APIs that are not permitted in a global capture.
+  cudaStreamCaptureMode mode = cudaStreamCaptureModeRelaxed;
+  CHECK_CUDA_ERROR(cudaThreadExchangeStreamCaptureMode(&mode));
+  array temp(allocator::malloc(size), {static_cast<int>(size)}, uint8);
+  CHECK_CUDA_ERROR(cudaThreadExchangeStreamCaptureMode(&mode));
+  encoder_->add_temporary(temp);
+  return temp.data<char>();
+}
+
 } // namespace cu
 
 } // namespace mlx::core
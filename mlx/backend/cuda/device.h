@@ -3,17 +3,82 @@
 #pragma once
 
 #include "mlx/array.h"
+#include "mlx/backend/cuda/lru_cache.h"
+#include "mlx/backend/cuda/memory_tracer.h"
 #include "mlx/backend/cuda/worker.h"
 #include "mlx/stream.h"
 
 #include <cublasLt.h>
+#include <cublas_v2.h>
 #include <cuda.h>
+#include <cusolverDn.h>
+#include <cusparse.h>
 #include <thrust/execution_policy.h>
 
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <unordered_map>
+#include <vector>
 
 namespace mlx::core::cu {
 
+class Megakernel;
+struct MegakernelStage;
+
+// The counters of the graph caches of all the command encoders.
+struct GraphCacheStats {
+  // The graphs found in the cache.
+  std::atomic<size_t> hits{0};
+  // The graphs not found in the cache.
+  std::atomic<size_t> misses{0};
+  // The executables created, for the misses and for the cached executables
+  // that could not be updated.
+  std::atomic<size_t> instantiations{0};
+  // The least recently used executables removed from a full cache.
+  std::atomic<size_t> evictions{0};
+};
+
+GraphCacheStats& graph_cache_stats();
+
+// The counters splitting the time of the ops evaluated by all the command
+// encoders into their parts, the times are in nanoseconds.
+struct DispatchStats {
+  // The primitives evaluated and the graph nodes launched.
+  std::atomic<size_t> evals{0};
+  std::atomic<size_t> nodes{0};
+  // The host time of gpu::eval, without the commits.
+  std::atomic<uint64_t> dispatch_ns{0};
+  // The host time of updating the cached executables and of instantiating
+  // new ones.
+  std::atomic<uint64_t> update_ns{0};
+  std::atomic<uint64_t> instantiate_ns{0};
+  // The rest of the host time of the commits, including the launches.
+  std::atomic<uint64_t> launch_ns{0};
+  std::atomic<size_t> graphs{0};
+  // The GPU time of the timed graphs and their nodes.
+  std::atomic<uint64_t> gpu_ns{0};
+  std::atomic<size_t> gpu_nodes{0};
+  // The time of the workers running the completion handlers.
+  std::atomic<uint64_t> retire_ns{0};
+};
+
+DispatchStats& dispatch_stats();
+
+// The nanoseconds elapsed since |start|.
+inline uint64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// The maximum number of graph executables cached by each command encoder,
+// can be tuned with MLX_CUDA_GRAPH_CACHE_SIZE.
+int cuda_graph_cache_size();
+
 class CommandEncoder {
  public:
   struct CaptureContext {
@@ -27,8 +92,19 @@ class CommandEncoder {
     ~ConcurrentContext();
     CommandEncoder& enc;
   };
+  // The graphs committed while recording merged in one executable, with the
+  // buffers they use which are kept so it can be launched again, and the
+  // first and last nodes using each buffer.
+  struct Recording {
+    CudaGraphExec exec;
+    int num_nodes;
+    std::vector<std::shared_ptr<array::Data>> data;
+    std::unordered_map<std::uintptr_t, std::pair<int, int>> uses;
+  };
 
-  explicit CommandEncoder(Device& d);
+  // The graphs of |s| are launched in a CUDA stream of its priority, their
+  // kernels run with it, and on the partition of the SMs of its SM fraction.
+  CommandEncoder(Device& d, Stream s);
   ~CommandEncoder();
 
   CommandEncoder(const CommandEncoder&) = delete;
@@ -41,6 +117,8 @@ class CommandEncoder {
     return ConcurrentContext{*this};
   }
 
+  // Set the arrays read and written by the next node, which must be called
+  // for every buffer it uses as the nodes are only ordered by them.
   void set_input_array(const array& arr);
   void set_output_array(const array& arr);
 
@@ -56,27 +134,67 @@ class CommandEncoder {
     add_kernel_node((void*)func, grid_dim, block_dim, ptrs);
   }
 
+  // A |cooperative| kernel can synchronize its grid, all its blocks must be
+  // resident at once.
   void add_kernel_node(
       CUfunction func,
       dim3 grid_dim,
       dim3 block_dim,
-      void** params);
+      void** params,
+      uint32_t shared_memory = 0,
+      bool cooperative = false);
 
   void
   add_kernel_node(void* func, dim3 grid_dim, dim3 block_dim, void** params);
 
+  // Add a kernel which calls wait_prerequisite_grids before reading or
+  // writing memory. On devices supporting programmatic dependent launch it
+  // depends on the previous kernels with programmatic edges, and so is
+  // launched while they finish instead of after them.
+  void add_dependent_kernel_node(
+      CUfunction func,
+      dim3 grid_dim,
+      dim3 block_dim,
+      void** params);
+
   void add_temporary(const array& arr) {
+    if (auto& tracer = memory_tracer(); tracer.enabled()) {
+      tracer.on_temporary(arr.buffer().ptr());
+    }
+    if (record_graph_) {
+      record_data_.push_back(arr.data_shared_ptr());
+    }
     temporaries_.push_back(arr.data_shared_ptr());
   }
 
   void add_completed_handler(std::function<void()> task);
+
+  // Defer the small fused kernel |stage| to run with the next ones in a
+  // megakernel, see megakernel.h.
+  void add_megakernel_stage(MegakernelStage stage);
+
+  // Commit when the graph has enough nodes or bytes, or when the GPU has
+  // finished the committed graphs. The number of nodes adapts to the measured
+  // GPU time of the recent graphs.
   void maybe_commit();
   void commit();
 
+  // Record the graphs committed until end_recording, the graphs are still
+  // launched as they are committed.
+  void begin_recording();
+  Recording end_recording();
+
+  // Commit and launch |recording| after the committed graphs.
+  void launch(const Recording& recording);
+
   CudaStream& stream() {
     return stream_;
   }
 
+  Device& device() {
+    return device_;
+  }
+
   // Wait until kernels and completion handlers are finished
   void synchronize();
 
@@ -84,32 +202,87 @@ class CommandEncoder {
   struct GraphNode {
     cudaGraphNode_t node;
     // K = kernel
+    // D = kernel launched early by its dependencies
     // E = empty
     // G = subgraph
     char node_type;
-    std::string id;
+    uint32_t id;
+  };
+
+  // The cached executable of a graph, with the topology it was created from
+  // to tell apart the graphs with the same hash.
+  struct CachedGraph {
+    CudaGraphExec exec;
+    std::vector<uint64_t> topology;
   };
 
   void insert_graph_dependencies(GraphNode node);
-  void insert_graph_dependencies(std::vector<GraphNode> nodes);
+  void insert_graph_dependencies(const GraphNode* nodes, size_t num_nodes);
+  void add_graph_edge(const GraphNode& from, const GraphNode& to);
+  void update_graph_timings();
+  void flush_megakernel();
+  CUgraphNode create_kernel_node(
+      CUfunction func,
+      dim3 grid_dim,
+      dim3 block_dim,
+      void** params,
+      uint32_t shared_memory);
+
+  struct GraphTiming {
+    cudaEvent_t start;
+    cudaEvent_t end;
+    int num_nodes;
+  };
 
   Device& device_;
+  Stream mlx_stream_;
   CudaStream stream_;
   cudaGraph_t graph_;
   Worker worker_;
-  char node_count_{0};
-  char graph_node_count_{0};
-  char empty_node_count_{0};
+  int node_count_{0};
+  // The number of the graph being built, from 1.
+  uint64_t commits_{1};
+  int graph_node_count_{0};
+  int empty_node_count_{0};
+  size_t graph_bytes_{0};
+  bool adaptive_;
+  int max_nodes_per_graph_;
+  int max_mb_per_graph_;
+  // The average GPU time of a node in the recent graphs.
+  float node_ms_{0};
+  std::vector<GraphTiming> graph_timings_;
+  std::deque<GraphTiming> pending_timings_;
   bool in_concurrent_{false};
   std::vector<cudaGraphNode_t> from_nodes_;
   std::vector<cudaGraphNode_t> to_nodes_;
-  std::string graph_key_;
+#if CUDART_VERSION >= 12030
+  // The types of the edges, when the kernels may be launched early.
+  std::vector<cudaGraphEdgeData> edge_data_;
+#endif
+  // The edges of |graph_| and their hash, which is the key of the cache.
+  std::vector<uint64_t> graph_topology_;
+  uint64_t graph_hash_{0};
   std::vector<GraphNode> concurrent_nodes_;
+  std::vector<GraphNode> deps_;
   std::vector<std::shared_ptr<array::Data>> temporaries_;
-  std::unordered_map<std::string, cudaGraphExec_t> graph_cache_;
+  LRUCache<uint64_t, CachedGraph> graph_cache_;
+  // The graph with a child graph for each graph committed while recording,
+  // and the last of them.
+  cudaGraph_t record_graph_{nullptr};
+  cudaGraphNode_t record_tail_{nullptr};
+  int record_nodes_{0};
+  std::vector<std::shared_ptr<array::Data>> record_data_;
+  std::unordered_map<std::uintptr_t, std::pair<int, int>> record_uses_;
+  // The nodes are only ordered by the buffers they use, so independent
+  // branches of work run concurrently in the graph. |node_map_| has the last
+  // writer of each buffer and |readers_| the nodes reading it since.
   std::vector<std::uintptr_t> active_deps_;
+  std::vector<std::uintptr_t> active_inputs_;
   std::vector<std::uintptr_t> active_outputs_;
   std::unordered_map<std::uintptr_t, GraphNode> node_map_;
+  std::unordered_map<std::uintptr_t, std::vector<GraphNode>> readers_;
+  // The fused kernels deferred until the next node is added.
+  std::unique_ptr<Megakernel> megakernel_;
 };
 
 class Device {
@@ -134,26 +307,77 @@ class Device {
   int compute_capability_minor() const {
     return compute_capability_minor_;
   }
+  int multi_processor_count() const {
+    return multi_processor_count_;
+  }
+  // Whether the kernels can be launched while the kernels they depend on
+  // finish, on sm_90 and later with MLX_CUDA_DEPENDENT_LAUNCH set.
+  bool dependent_launch() const {
+    return dependent_launch_;
+  }
   cublasLtHandle_t lt_handle() const {
     return lt_;
   }
+  // The cuBLAS handle of the pointer array batched gemm, created on first
+  // use.
+  cublasHandle_t blas_handle();
+  // The cuSOLVER handle of the factorizations, created on first use.
+  cusolverDnHandle_t solver_handle();
+  // The cuSPARSE handle of the sparse matmuls, created on first use.
+  cusparseHandle_t sparse_handle();
+
+#if CUDA_VERSION >= 12040
+  // Create a green context on |fraction| of the SMs, rounded up to the
+  // granularity of the device, which are not in the previous partitions.
+  CUgreenCtx sm_partition(float fraction);
+#endif
 
  private:
   int device_;
   int compute_capability_major_;
   int compute_capability_minor_;
+  int multi_processor_count_;
+  bool dependent_launch_{false};
   cublasLtHandle_t lt_;
+  std::once_flag blas_once_;
+  cublasHandle_t blas_{nullptr};
+  std::once_flag solver_once_;
+  cusolverDnHandle_t solver_{nullptr};
+  std::once_flag sparse_once_;
+  cusparseHandle_t sparse_{nullptr};
+#if CUDA_VERSION >= 12040
+  // The SMs not in a partition yet, and the green contexts of the
+  // partitions.
+  std::optional<CUdevResource> free_sms_;
+  std::vector<CUgreenCtx> green_ctxs_;
+#endif
   std::unordered_map<int, CommandEncoder> encoders_;
 };
 
 Device& device(mlx::core::Device device);
 CommandEncoder& get_command_encoder(Stream s);
 
-// Return an execution policy that does not sync for result.
+// A thrust and cub allocator of temporary storage from mlx's allocator, the
+// buffers are kept alive by |encoder| until its kernels finish.
+class ThrustAllocator {
+ public:
+  using value_type = char;
+
+  explicit ThrustAllocator(CommandEncoder& encoder) : encoder_(&encoder) {}
+
+  char* allocate(size_t size);
+  void deallocate(char* ptr, size_t size) {}
+
+ private:
+  CommandEncoder* encoder_;
+};
+
+// Return an execution policy that does not sync for result and allocates
+// its temporary storage with ThrustAllocator.
 // Note that not all thrust APIs support async policy, confirm before using.
-inline auto thrust_policy(cudaStream_t stream) {
-  // TODO: Connect thrust's custom allocator with mlx's allocator.
-  return thrust::cuda::par_nosync.on(stream);
+inline auto thrust_policy(CommandEncoder& encoder) {
+  return thrust::cuda::par_nosync(ThrustAllocator(encoder))
+      .on(encoder.stream());
 }
 
 } // namespace mlx::core::cu
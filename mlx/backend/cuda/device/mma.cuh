@@ -0,0 +1,207 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/cuda/device/config.h"
+
+#include <cuda_bf16.h>
+#include <cuda_fp16.h>
+#include <cuda/std/type_traits>
+#include <mma.h>
+
+namespace mlx::core::cu {
+
+// Block level MMA used by the tiled matmul kernels. The tiles are in shared
+// memory, the A tile is [BM, BK] and the B tile is stored transposed as
+// [BN, BK], both with the leading dimension LDS. The results are stored as a
+// [BM, BN] float tile with the leading dimension LDC. Both implementations
+// require a block of 128 threads.
+
+// Whether the tensor cores can be used for T on the current architecture.
+template <typename T>
+inline constexpr __host__ __device__ bool mma_use_wmma() {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 800
+  return cuda::std::is_same_v<T, __half> ||
+      cuda::std::is_same_v<T, __nv_bfloat16>;
+#elif defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 700
+  return cuda::std::is_same_v<T, __half>;
+#else
+  return false;
+#endif
+}
+
+// Tensor cores implementation, each warp computes a [32, 32] block of the
+// output tile.
+template <typename T, int BM, int BN, int BK, int LDS, int LDC>
+struct BlockMmaWmma {
+  static_assert(BM == 64 && BN == 64, "The warps are laid out as 2x2.");
+
+  nvcuda::wmma::fragment<nvcuda::wmma::accumulator, 16, 16, 16, float>
+      frags[2][2];
+  int wm;
+  int wn;
+
+  __device__ BlockMmaWmma(int thread_rank) {
+    int warp_id = thread_rank / WARP_SIZE;
+    wm = warp_id / 2;
+    wn = warp_id % 2;
+#pragma unroll
+    for (int i = 0; i < 2; ++i) {
+#pragma unroll
+      for (int j = 0; j < 2; ++j) {
+        nvcuda::wmma::fill_fragment(frags[i][j], 0.0f);
+      }
+    }
+  }
+
+  __device__ void mma(const T* as, const T* bs) {
+    using namespace nvcuda;
+#pragma unroll
+    for (int kk = 0; kk < BK; kk += 16) {
+      wmma::fragment<wmma::matrix_a, 16, 16, 16, T, wmma::row_major> a[2];
+      wmma::fragment<wmma::matrix_b, 16, 16, 16, T, wmma::col_major> b[2];
+#pragma unroll
+      for (int i = 0; i < 2; ++i) {
+        wmma::load_matrix_sync(a[i], as + (wm * 32 + i * 16) * LDS + kk, LDS);
+        wmma::load_matrix_sync(b[i], bs + (wn * 32 + i * 16) * LDS + kk, LDS);
+      }
+#pragma unroll
+      for (int i = 0; i < 2; ++i) {
+#pragma unroll
+        for (int j = 0; j < 2; ++j) {
+          wmma::mma_sync(frags[i][j], a[i], b[j], frags[i][j]);
+        }
+      }
+    }
+  }
+
+  __device__ void store(float* cs) {
+#pragma unroll
+    for (int i = 0; i < 2; ++i) {
+#pragma unroll
+      for (int j = 0; j < 2; ++j) {
+        nvcuda::wmma::store_matrix_sync(
+            cs + (wm * 32 + i * 16) * LDC + wn * 32 + j * 16,
+            frags[i][j],
+            LDC,
+            nvcuda::wmma::mem_row_major);
+      }
+    }
+  }
+};
+
+// Fallback with plain FMAs, each thread computes a [8, 4] block of the output
+// tile.
+template <typename T, int BM, int BN, int BK, int LDS, int LDC>
+struct BlockMmaSimt {
+  static constexpr int TM = 8;
+  static constexpr int TN = 4;
+  static_assert((BM / TM) * (BN / TN) == 128, "Expect 128 threads.");
+
+  float acc[TM][TN] = {};
+  int tm;
+  int tn;
+
+  __device__ BlockMmaSimt(int thread_rank) {
+    tm = thread_rank / (BN / TN);
+    tn = thread_rank % (BN / TN);
+  }
+
+  __device__ void mma(const T* as, const T* bs) {
+#pragma unroll 4
+    for (int kk = 0; kk < BK; ++kk) {
+      float a[TM];
+      float b[TN];
+#pragma unroll
+      for (int i = 0; i < TM; ++i) {
+        a[i] = static_cast<float>(as[(tm * TM + i) * LDS + kk]);
+      }
+#pragma unroll
+      for (int j = 0; j < TN; ++j) {
+        b[j] = static_cast<float>(bs[(tn * TN + j) * LDS + kk]);
+      }
+#pragma unroll
+      for (int i = 0; i < TM; ++i) {
+#pragma unroll
+        for (int j = 0; j < TN; ++j) {
+          acc[i][j] += a[i] * b[j];
+        }
+      }
+    }
+  }
+
+  __device__ void store(float* cs) {
+#pragma unroll
+    for (int i = 0; i < TM; ++i) {
+#pragma unroll
+      for (int j = 0; j < TN; ++j) {
+        cs[(tm * TM + i) * LDC + tn * TN + j] = acc[i][j];
+      }
+    }
+  }
+};
+
+template <typename T, int BM, int BN, int BK, int LDS, int LDC>
+using BlockMma = cuda::std::conditional_t<
+    mma_use_wmma<T>(),
+    BlockMmaWmma<T, BM, BN, BK, LDS, LDC>,
+    BlockMmaSimt<T, BM, BN, BK, LDS, LDC>>;
+
+// Load the [ROWS, BK] tile at (r0, k0) of the matrix |src| into |tile|, the
+// element (r, k) is src[r * ld + k], or src[k * ld + r] when |transposed|.
+// Elements out of [0, rows) x [0, k_end) are zeroed.
+template <
+    int ROWS,
+    int BK,
+    int LDS,
+    int NUM_THREADS,
+    bool transposed,
+    typename T>
+inline __device__ void load_tile(
+    T* tile,
+    const T* src,
+    int64_t ld,
+    int r0,
+    int k0,
+    int rows,
+    int k_end,
+    int thread_rank) {
+  for (int i = thread_rank; i < ROWS * BK; i += NUM_THREADS) {
+    // Walk the contiguous dim of |src| with consecutive threads.
+    int r = transposed ? i % ROWS : i / BK;
+    int c = transposed ? i / ROWS : i % BK;
+    int row = r0 + r;
+    int k = k0 + c;
+    T val = static_cast<T>(0);
+    if (row < rows && k < k_end) {
+      val = transposed ? src[int64_t(k) * ld + row]
+                       : src[int64_t(row) * ld + k];
+    }
+    tile[r * LDS + c] = val;
+  }
+}
+
+// Write the [BM, BN] float tile in shared memory to |out| at (m0, n0), the
+// stores are coalesced and bounds checked.
+template <int BM, int BN, int LDC, int NUM_THREADS, typename T>
+inline __device__ void store_tile(
+    const float* cs,
+    T* out,
+    int ldo,
+    int m0,
+    int n0,
+    int M,
+    int N,
+    int thread_rank) {
+  for (int i = thread_rank; i < BM * BN; i += NUM_THREADS) {
+    int r = i / BN;
+    int c = i % BN;
+    int m = m0 + r;
+    int n = n0 + c;
+    if (m < M && n < N) {
+      out[int64_t(m) * ldo + n] = static_cast<T>(cs[r * LDC + c]);
+    }
+  }
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,70 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/cuda/device/binary_ops.cuh"
+
+namespace mlx::core::cu {
+
+__constant__ constexpr uint32_t rotations[2][4] = {
+    {13, 15, 26, 6},
+    {17, 29, 16, 24}};
+
+union rbits {
+  uint2 val;
+  uint8_t bytes[2][4];
+};
+
+inline __device__ rbits threefry2x32_hash(uint2 key, uint2 count) {
+  uint32_t ks[] = {key.x, key.y, key.x ^ key.y ^ 0x1BD11BDA};
+
+  rbits v;
+  v.val.x = count.x + ks[0];
+  v.val.y = count.y + ks[1];
+
+  for (int i = 0; i < 5; ++i) {
+    for (auto r : rotations[i % 2]) {
+      v.val.x += v.val.y;
+      v.val.y = (v.val.y << r) | (v.val.y >> (32 - r));
+      v.val.y ^= v.val.x;
+    }
+    v.val.x += ks[(i + 1) % 3];
+    v.val.y += ks[(i + 2) % 3] + i + 1;
+  }
+
+  return v;
+}
+
+// The float in [0, upper] of 32 random bits as computed by random::uniform.
+inline __device__ float bits_to_unit(uint32_t bits, float upper) {
+  // The float32 of UINT32_MAX rounds to 2^32.
+  float u = Divide{}(static_cast<float>(bits), 4294967296.0f);
+  return Minimum{}(u, upper);
+}
+
+// The 32 random bits of the element |index| of the |size| elements that
+// random::bits generates for |key|, the hash of the counter |i| gives the
+// elements |i| and |i + grid_y|.
+inline __device__ uint32_t
+random_bits_at(uint2 key, uint32_t index, uint32_t size) {
+  uint32_t grid_y = size / 2 + size % 2;
+  if (index < grid_y) {
+    bool drop_last = (size % 2) && (index == grid_y - 1);
+    return threefry2x32_hash(key, uint2{index, drop_last ? 0 : index + grid_y})
+        .val.x;
+  }
+  return threefry2x32_hash(key, uint2{index - grid_y, index}).val.y;
+}
+
+// Round |x| to one of the two closest bfloat16 with the low 16 of the random
+// |bits|, the magnitude is rounded up with the probability of the fraction
+// truncated by the bfloat16.
+inline __device__ __nv_bfloat16 stochastic_round_bf16(float x, uint32_t bits) {
+  if (isnan(x)) {
+    return __float2bfloat16(x);
+  }
+  uint32_t u = __float_as_uint(x) + (bits & 0xFFFF);
+  return __ushort_as_bfloat16(static_cast<uint16_t>(u >> 16));
+}
+
+} // namespace mlx::core::cu
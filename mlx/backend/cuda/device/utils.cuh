@@ -35,18 +35,41 @@ struct alignas(sizeof(T) * N) AlignedVector {
 };
 
 template <int N, typename T>
+inline __device__ bool is_aligned(T* x) {
+  return (reinterpret_cast<size_t>(x) % (N * sizeof(T))) == 0;
+}
+
+// Load the |offset|-th vector of |N| elements, element by element when |ptr|
+// is not aligned to the vector, e.g. for the data of a sliced array.
+template <int N, typename T, typename SizeT>
 inline __device__ AlignedVector<T, N> load_vector(
     const T* ptr,
-    uint32_t offset) {
-  auto* from = reinterpret_cast<const AlignedVector<T, N>*>(ptr);
-  return from[offset];
+    SizeT offset) {
+  if (is_aligned<N>(ptr)) {
+    auto* from = reinterpret_cast<const AlignedVector<T, N>*>(ptr);
+    return from[offset];
+  } else {
+    AlignedVector<T, N> v;
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+      v.val[i] = ptr[offset * N + i];
+    }
+    return v;
+  }
 }
 
-template <int N, typename T>
+template <int N, typename T, typename SizeT>
 inline __device__ void
-store_vector(T* ptr, uint32_t offset, const AlignedVector<T, N>& vec) {
-  auto* to = reinterpret_cast<AlignedVector<T, N>*>(ptr);
-  to[offset] = vec;
+store_vector(T* ptr, SizeT offset, const AlignedVector<T, N>& vec) {
+  if (is_aligned<N>(ptr)) {
+    auto* to = reinterpret_cast<AlignedVector<T, N>*>(ptr);
+    to[offset] = vec;
+  } else {
+#pragma unroll
+    for (int i = 0; i < N; ++i) {
+      ptr[offset * N + i] = vec.val[i];
+    }
+  }
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -359,4 +382,24 @@ struct LoopedElemToLoc<1, false, OffsetT> {
   }
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// Programmatic dependent launch
+///////////////////////////////////////////////////////////////////////////////
+
+// Let the kernels depending on this one launch once all its blocks started,
+// see CommandEncoder::add_dependent_kernel_node.
+inline __device__ void launch_dependent_grids() {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 900
+  asm volatile("griddepcontrol.launch_dependents;");
+#endif
+}
+
+// Wait until the kernels this one depends on are done and their writes are
+// visible, a no-op when it was not launched before they finished.
+inline __device__ void wait_prerequisite_grids() {
+#if defined(__CUDA_ARCH__) && __CUDA_ARCH__ >= 900
+  asm volatile("griddepcontrol.wait;" ::: "memory");
+#endif
+}
+
 } // namespace mlx::core::cu
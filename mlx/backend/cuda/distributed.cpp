@@ -0,0 +1,122 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/distributed/primitives.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+#include <cassert>
+
+namespace mlx::core::distributed {
+
+namespace {
+
+array ensure_row_contiguous(const array& arr, const Stream& s) {
+  if (arr.flags().row_contiguous) {
+    return arr;
+  }
+  array arr_copy = contiguous_copy_gpu(arr, s);
+  cu::get_command_encoder(s).add_temporary(arr_copy);
+  return arr_copy;
+}
+
+} // namespace
+
+void AllReduce::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("AllReduce::eval_gpu");
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  // The reduction can be done in place.
+  auto in = ensure_row_contiguous(inputs[0], stream());
+  if (in.is_donatable()) {
+    outputs[0].copy_shared_buffer(in);
+  } else {
+    outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  }
+  switch (reduce_type_) {
+    case Sum:
+      if (compression_) {
+        distributed::detail::compressed_all_sum(
+            group(), in, outputs[0], *compression_, stream());
+      } else {
+        distributed::detail::all_sum(group(), in, outputs[0], stream());
+      }
+      break;
+    case Max:
+      distributed::detail::all_max(group(), in, outputs[0], stream());
+      break;
+    case Min:
+      distributed::detail::all_min(group(), in, outputs[0], stream());
+      break;
+    default:
+      throw std::runtime_error(
+          "Only all reduce sum, min and max are supported for now");
+  }
+}
+
+void AllGather::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("AllGather::eval_gpu");
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto in = ensure_row_contiguous(inputs[0], stream());
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::all_gather(group(), in, outputs[0], stream());
+}
+
+void ReduceScatter::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("ReduceScatter::eval_gpu");
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto in = ensure_row_contiguous(inputs[0], stream());
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::reduce_scatter(group(), in, outputs[0], stream());
+}
+
+void AllToAll::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("AllToAll::eval_gpu");
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto in = ensure_row_contiguous(inputs[0], stream());
+  auto [send_counts, recv_counts] = counts(in);
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::all_to_all(
+      group(), in, outputs[0], send_counts, recv_counts, stream());
+}
+
+void Send::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("Send::eval_gpu");
+  assert(inputs.size() == 1);
+  assert(outputs.size() == 1);
+
+  auto in = ensure_row_contiguous(inputs[0], stream());
+  distributed::detail::send(group(), in, dst_, stream());
+  outputs[0].copy_shared_buffer(inputs[0]);
+}
+
+void Recv::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("Recv::eval_gpu");
+  assert(inputs.size() == 0);
+  assert(outputs.size() == 1);
+
+  outputs[0].set_data(allocator::malloc(outputs[0].nbytes()));
+  distributed::detail::recv(group(), outputs[0], src_, stream());
+}
+
+} // namespace mlx::core::distributed
@@ -3,6 +3,8 @@
 #include "mlx/backend/gpu/eval.h"
 #include "mlx/backend/cuda/allocator.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/profiler.h"
+#include "mlx/backend/cuda/utils.h"
 #include "mlx/backend/gpu/available.h"
 #include "mlx/primitives.h"
 
@@ -23,36 +25,138 @@ void new_stream(Stream s) {
   cu::allocator().register_this_thread();
 }
 
+namespace {
+
+// Copy |in| from the device memory of another device, the copy is direct
+// when the devices have peer access.
+array copy_from_peer(
+    const array& in,
+    int src_device,
+    cu::Device& device,
+    cu::CommandEncoder& encoder) {
+  array out(in.shape(), in.dtype(), nullptr, {});
+  size_t nbytes = in.data_size() * in.itemsize();
+  out.set_data(
+      allocator::malloc(nbytes), in.data_size(), in.strides(), in.flags());
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  {
+    auto capture = encoder.capture_context();
+    CHECK_CUDA_ERROR(cudaMemcpyPeerAsync(
+        out.data<void>(),
+        device.cuda_device(),
+        in.data<void>(),
+        src_device,
+        nbytes,
+        encoder.stream()));
+  }
+  encoder.add_temporary(out);
+  return out;
+}
+
+} // namespace
+
 void eval(array& arr) {
   nvtx3::scoped_range r("gpu::eval");
+  auto start = std::chrono::steady_clock::now();
+  auto stream = arr.primitive().stream();
+  auto& device = cu::device(stream.device);
+  auto& encoder = device.get_command_encoder(stream);
+  // The outputs are allocated on the current device.
+  device.make_current();
+
+  // The primitive is committed in a graph of its own to be timed alone.
+  auto& profiler = cu::profiler();
+  bool profile = profiler.enabled();
+  cu::Profiler::Range range{};
+  if (profile) {
+    encoder.commit();
+    range = profiler.begin(device.cuda_device(), encoder.stream());
+  }
+
   auto outputs = arr.outputs();
   {
+    // The buffers allocated by the primitive are attributed to it.
+    std::optional<cu::MemoryTracer::Scope> memory_scope;
+    if (cu::memory_tracer().enabled()) {
+      memory_scope.emplace(arr.primitive().name());
+    }
     // If the array is a tracer hold a reference
     // to its inputs so they don't get donated
     std::vector<array> inputs;
     if (arr.is_tracer()) {
       inputs = arr.inputs();
     }
-    arr.primitive().eval_gpu(arr.inputs(), outputs);
+    // The inputs in the device memory of other devices are copied first.
+    std::vector<array> peer_inputs;
+    for (size_t i = 0; i < arr.inputs().size(); ++i) {
+      auto& in = arr.inputs()[i];
+      int src_device = cu::allocator().device_of(in.buffer());
+      if (src_device >= 0 && src_device != device.cuda_device()) {
+        if (peer_inputs.empty()) {
+          peer_inputs = arr.inputs();
+        }
+        peer_inputs[i] = copy_from_peer(in, src_device, device, encoder);
+      }
+    }
+    // The memory pool allocates on the stream of the kernels.
+    auto& alloc = cu::allocator();
+    alloc.set_stream(encoder.stream());
+    try {
+      arr.primitive().eval_gpu(
+          peer_inputs.empty() ? arr.inputs() : peer_inputs, outputs);
+    } catch (...) {
+      alloc.set_stream(nullptr);
+      throw;
+    }
+    alloc.set_stream(nullptr);
   }
 
-  auto& encoder = cu::get_command_encoder(arr.primitive().stream());
-  // Keep used buffers alive until kernel finishes running.
-  std::unordered_set<std::shared_ptr<array::Data>> buffers;
+  if (profile) {
+    encoder.commit();
+    size_t bytes = 0;
+    for (auto& a : arr.inputs()) {
+      bytes += a.data_size() * a.itemsize();
+    }
+    for (auto& a : outputs) {
+      bytes += a.data_size() * a.itemsize();
+    }
+    profiler.end(
+        range,
+        device.cuda_device(),
+        stream.index,
+        encoder.stream(),
+        arr.primitive().name(),
+        bytes);
+  }
+
+  // Keep used buffers alive until kernel finishes running, they are released
+  // together with the temporaries of the commit. The output is not kept if
+  // it was donated to by an input.
+  auto& out_data = arr.data_shared_ptr();
   for (auto& in : arr.inputs()) {
-    buffers.insert(in.data_shared_ptr());
+    if (in.data_shared_ptr() != out_data) {
+      encoder.add_temporary(in);
+    }
   }
   for (auto& s : arr.siblings()) {
-    buffers.insert(s.data_shared_ptr());
-  }
-  // Remove the output if it was donated to by an input.
-  if (auto it = buffers.find(arr.data_shared_ptr()); it != buffers.end()) {
-    buffers.erase(it);
+    if (s.data_shared_ptr() != out_data) {
+      encoder.add_temporary(s);
+    }
   }
-  encoder.add_completed_handler([buffers = std::move(buffers)]() {});
+  auto& dispatch = cu::dispatch_stats();
+  dispatch.evals++;
+  dispatch.dispatch_ns += cu::elapsed_ns(start);
   encoder.maybe_commit();
 }
 
+void prefetch_to_host(const array& arr) {
+  // The kernels writing |arr| are launched first.
+  auto& encoder = cu::get_command_encoder(arr.primitive().stream());
+  encoder.commit();
+  cu::allocator().prefetch(arr.buffer(), cudaCpuDeviceId, encoder.stream());
+}
+
 void finalize(Stream s) {
   nvtx3::scoped_range r("gpu::finalize");
   cu::get_command_encoder(s).commit();
@@ -63,4 +167,10 @@ void synchronize(Stream s) {
   cu::get_command_encoder(s).synchronize();
 }
 
+void add_completed_handler(Stream s, std::function<void()> handler) {
+  auto& encoder = cu::get_command_encoder(s);
+  encoder.add_completed_handler(std::move(handler));
+  encoder.commit();
+}
+
 } // namespace mlx::core::gpu
@@ -7,7 +7,16 @@
 #include "mlx/event.h"
 #include "mlx/scheduler.h"
 
+#include <linux/futex.h>
 #include <nvtx3/nvtx3.hpp>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <climits>
+#include <ctime>
+#include <mutex>
+#include <vector>
 
 namespace mlx::core {
 
@@ -90,44 +99,128 @@ bool CudaEvent::completed() const {
 // SharedEvent implementations
 ///////////////////////////////////////////////////////////////////////////////
 
-__host__ __device__ void event_wait(SharedEvent::Atomic* ac, uint64_t value) {
-  uint64_t current;
-  while ((current = ac->load()) < value) {
-    ac->wait(current);
-  }
+namespace {
+
+// Whether the streams can wait on and write the value of the events with
+// the 64-bit stream memory operations, which take no SM time.
+bool stream_mem_ops_supported() {
+  static bool supported = []() {
+    int device;
+    CHECK_CUDA_ERROR(cudaGetDevice(&device));
+    int value = 0;
+    CHECK_CUDA_ERROR(cuDeviceGetAttribute(
+        &value, CU_DEVICE_ATTRIBUTE_CAN_USE_64_BIT_STREAM_MEM_OPS, device));
+    return value != 0;
+  }();
+  return supported;
 }
 
-__host__ __device__ void event_signal(SharedEvent::Atomic* ac, uint64_t value) {
-  ac->store(value);
-  ac->notify_all();
+// The futex of the low word of the value.
+int* futex_word(SharedEvent::Atomic* ac) {
+  return reinterpret_cast<int*>(ac);
 }
 
+// The values of the events are carved out of pages of pinned memory which
+// are kept, since allocating and freeing pinned memory is slow and
+// synchronizes the device. Each value has a cache line of its own.
+class EventValuePool {
+ public:
+  void* get() {
+    std::lock_guard lock(mutex_);
+    if (free_.empty()) {
+      char* page;
+      CHECK_CUDA_ERROR(cudaHostAlloc(
+          &page, page_size, cudaHostAllocMapped | cudaHostAllocPortable));
+      for (size_t i = 0; i < page_size; i += slot_size) {
+        free_.push_back(page + i);
+      }
+    }
+    void* slot = free_.back();
+    free_.pop_back();
+    return slot;
+  }
+
+  void put(void* slot) {
+    std::lock_guard lock(mutex_);
+    free_.push_back(slot);
+  }
+
+ private:
+  static constexpr size_t page_size = 4096;
+  static constexpr size_t slot_size = 64;
+  std::mutex mutex_;
+  std::vector<void*> free_;
+};
+
+EventValuePool& event_value_pool() {
+  // Leaked so that the events destroyed at exit can still return their
+  // values.
+  static auto* pool = new EventValuePool;
+  return *pool;
+}
+
+} // namespace
+
+// The kernels spinning on the value when the stream memory operations are
+// not supported.
 __global__ void event_wait_kernel(SharedEvent::Atomic* ac, uint64_t value) {
-  event_wait(ac, value);
+  while (ac->load() < value) {
+  }
 }
 
 __global__ void event_signal_kernel(SharedEvent::Atomic* ac, uint64_t value) {
-  event_signal(ac, value);
+  ac->store(value);
 }
 
 SharedEvent::SharedEvent() {
-  // Allocate cuda::atomic on managed memory.
-  Atomic* ac;
-  CHECK_CUDA_ERROR(cudaMallocManaged(&ac, sizeof(Atomic)));
-  new (ac) Atomic(0);
+  // The value is in pinned host memory, which the host reads and writes
+  // directly and the GPU through its mapping.
+  auto* ac = new (event_value_pool().get()) Atomic(0);
   ac_ = std::shared_ptr<Atomic>(ac, [](Atomic* ptr) {
     ptr->~Atomic();
-    allocator().cuda_free(ptr);
+    event_value_pool().put(ptr);
   });
 }
 
 void SharedEvent::wait(uint64_t value) {
   nvtx3::scoped_range r("cu::SharedEvent::wait");
-  event_wait(ac_.get(), value);
+  // The values written by the GPU wake no waiter, so after spinning for a
+  // while the thread sleeps on the futex of the value with a timeout which
+  // grows up to a limit, and the signals of the host wake it up early.
+  constexpr int spins = 64;
+  constexpr long max_timeout_ns = 128000;
+  long timeout_ns = 1000;
+  for (int i = 0; ac_->load() < value; ++i) {
+    if (i < spins) {
+      continue;
+    }
+    uint64_t current = ac_->load();
+    if (current >= value) {
+      break;
+    }
+    timespec timeout{0, timeout_ns};
+    syscall(
+        SYS_futex,
+        futex_word(ac_.get()),
+        FUTEX_WAIT_PRIVATE,
+        static_cast<int>(current),
+        &timeout,
+        nullptr,
+        0);
+    timeout_ns = std::min(2 * timeout_ns, max_timeout_ns);
+  }
 }
 
 void SharedEvent::wait(cudaStream_t stream, uint64_t value) {
-  event_wait_kernel<<<1, 1, 0, stream>>>(ac_.get(), value);
+  if (stream_mem_ops_supported()) {
+    CHECK_CUDA_ERROR(cuStreamWaitValue64(
+        stream,
+        reinterpret_cast<CUdeviceptr>(ac_.get()),
+        value,
+        CU_STREAM_WAIT_VALUE_GEQ));
+  } else {
+    event_wait_kernel<<<1, 1, 0, stream>>>(ac_.get(), value);
+  }
 }
 
 void SharedEvent::wait(Stream s, uint64_t value) {
@@ -144,20 +237,34 @@ void SharedEvent::wait(Stream s, uint64_t value) {
 
 void SharedEvent::signal(uint64_t value) {
   nvtx3::scoped_range r("cu::SharedEvent::signal");
-  event_signal(ac_.get(), value);
+  ac_->store(value);
+  syscall(
+      SYS_futex,
+      futex_word(ac_.get()),
+      FUTEX_WAKE_PRIVATE,
+      INT_MAX,
+      nullptr,
+      nullptr,
+      0);
 }
 
 void SharedEvent::signal(cudaStream_t stream, uint64_t value) {
-  event_signal_kernel<<<1, 1, 0, stream>>>(ac_.get(), value);
+  if (stream_mem_ops_supported()) {
+    CHECK_CUDA_ERROR(cuStreamWriteValue64(
+        stream,
+        reinterpret_cast<CUdeviceptr>(ac_.get()),
+        value,
+        CU_STREAM_WRITE_VALUE_DEFAULT));
+  } else {
+    event_signal_kernel<<<1, 1, 0, stream>>>(ac_.get(), value);
+  }
 }
 
 void SharedEvent::signal(Stream s, uint64_t value) {
   nvtx3::scoped_range r("cu::SharedEvent::signal(s)");
   if (s.device == mlx::core::Device::cpu) {
-    // Signal through a GPU stream so the atomic is updated in GPU - updating
-    // the atomic in CPU sometimes does not get GPU notified.
-    static CudaStream stream(device(mlx::core::Device::gpu));
-    scheduler::enqueue(s, [*this, value]() mutable { signal(stream, value); });
+    // The host writes the pinned memory which the GPU streams wait on.
+    scheduler::enqueue(s, [*this, value]() mutable { signal(value); });
   } else {
     auto& encoder = get_command_encoder(s);
     encoder.commit();
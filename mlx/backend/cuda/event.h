@@ -38,8 +38,10 @@ class CudaEvent {
   std::shared_ptr<CudaEventHandle> event_;
 };
 
-// Event that can synchronize between CPU and GPU. It is much slower than
-// CudaEvent so the latter should always be preferred when possible.
+// Event that can synchronize between CPU and GPU. Its value is in pinned host
+// memory, which the GPU streams wait on and write with stream memory
+// operations. It is slower than CudaEvent so the latter should always be
+// preferred when possible.
 class SharedEvent {
  public:
   using Atomic = cuda::atomic<uint64_t>;
@@ -16,8 +16,10 @@ Fence::Fence(Stream s) {
 }
 
 void Fence::wait(Stream s, const array&) {
+  // A GPU stream waits on the device without blocking the dispatch, only a
+  // CPU stream blocks its thread.
   auto* fence = static_cast<FenceImpl*>(fence_.get());
-  fence->event.wait(fence->count);
+  fence->event.wait(s, fence->count);
 }
 
 void Fence::update(Stream s, const array&) {
@@ -0,0 +1,285 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/common/utils.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/lru_cache.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/primitives.h"
+#include "mlx/utils.h"
+
+#include <cooperative_groups.h>
+#include <cufft.h>
+#include <fmt/format.h>
+#include <nvtx3/nvtx3.hpp>
+
+#include <numeric>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+__global__ void fft_scale(float* x, float scale, int64_t size) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index < size) {
+    x[index] *= scale;
+  }
+}
+
+#define CHECK_CUFFT_ERROR(cmd) check_cufft_error(#cmd, (cmd))
+
+void check_cufft_error(const char* name, cufftResult err) {
+  if (err != CUFFT_SUCCESS) {
+    throw std::runtime_error(
+        fmt::format("{} failed with code: {}.", name, static_cast<int>(err)));
+  }
+}
+
+// A cuFFT plan without its own work area, the work area is allocated from
+// MLX for each execution.
+class FFTPlan {
+ public:
+  FFTPlan(const std::vector<long long>& n, long long batch, cufftType type) {
+    CHECK_CUFFT_ERROR(cufftCreate(&plan_));
+    CHECK_CUFFT_ERROR(cufftSetAutoAllocation(plan_, 0));
+    CHECK_CUFFT_ERROR(cufftMakePlanMany64(
+        plan_,
+        n.size(),
+        const_cast<long long*>(n.data()),
+        nullptr,
+        1,
+        0,
+        nullptr,
+        1,
+        0,
+        type,
+        batch,
+        &workspace_size_));
+  }
+
+  ~FFTPlan() {
+    cufftDestroy(plan_);
+  }
+
+  FFTPlan(const FFTPlan&) = delete;
+  FFTPlan& operator=(const FFTPlan&) = delete;
+
+  cufftHandle handle() const {
+    return plan_;
+  }
+  size_t workspace_size() const {
+    return workspace_size_;
+  }
+
+ private:
+  cufftHandle plan_;
+  size_t workspace_size_{0};
+};
+
+int fft_plan_cache_size() {
+  static int cache_size = []() {
+    return env::get_var("MLX_CUDA_FFT_PLAN_CACHE_SIZE", 64);
+  }();
+  return cache_size;
+}
+
+// The plans only depend on the sizes of the transform, the batch size and
+// the types, the direction is passed at execution.
+std::shared_ptr<FFTPlan> get_fft_plan(
+    Device& device,
+    const std::vector<long long>& n,
+    long long batch,
+    cufftType type) {
+  static LRUCache<std::string, std::shared_ptr<FFTPlan>> cache(
+      fft_plan_cache_size());
+  std::string key = std::to_string(device.cuda_device());
+  for (auto size : n) {
+    key += "." + std::to_string(size);
+  }
+  key += "." + std::to_string(batch) + "." + std::to_string(type);
+  return cache.get_or_create(key, [&]() {
+    device.make_current();
+    return std::make_shared<FFTPlan>(n, batch, type);
+  });
+}
+
+} // namespace cu
+
+namespace {
+
+// The strides of the layout used by cuFFT, the transformed axes are the
+// innermost and in order, the other axes are the batch.
+Strides fft_strides(const Shape& shape, const std::vector<size_t>& axes) {
+  Strides strides(shape.size());
+  std::vector<bool> is_fft_axis(shape.size(), false);
+  int64_t stride = 1;
+  for (auto it = axes.rbegin(); it != axes.rend(); ++it) {
+    is_fft_axis[*it] = true;
+    strides[*it] = stride;
+    stride *= shape[*it];
+  }
+  for (int i = shape.size() - 1; i >= 0; --i) {
+    if (!is_fft_axis[i]) {
+      strides[i] = stride;
+      stride *= shape[i];
+    }
+  }
+  return strides;
+}
+
+bool has_fft_layout(const array& x, const Strides& strides) {
+  if (x.data_size() != x.size()) {
+    return false;
+  }
+  for (int i = 0; i < x.ndim(); ++i) {
+    if (x.shape(i) > 1 && x.strides(i) != strides[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void set_fft_layout(array& x, const Strides& strides) {
+  auto [data_size, is_row_contiguous, is_col_contiguous] =
+      check_contiguity(x.shape(), strides);
+  array::Flags flags;
+  flags.contiguous = data_size == x.size();
+  flags.row_contiguous = is_row_contiguous;
+  flags.col_contiguous = is_col_contiguous;
+  x.set_data(allocator::malloc(x.nbytes()), data_size, strides, flags);
+}
+
+// A transform of at most 3 axes with a single cuFFT plan.
+void fft_op(
+    const array& in,
+    array& out,
+    const std::vector<size_t>& axes,
+    bool inverse,
+    bool real,
+    const Stream& s) {
+  auto& enc = cu::get_command_encoder(s);
+
+  // The complex to real transforms overwrite their input, so the input is
+  // always copied for them.
+  bool c2r = real && inverse;
+  Strides in_strides = fft_strides(in.shape(), axes);
+  array x = in;
+  if (c2r || !has_fft_layout(in, in_strides)) {
+    x = array(in.shape(), in.dtype(), nullptr, {});
+    set_fft_layout(x, in_strides);
+    copy_gpu_inplace(in, x, CopyType::GeneralGeneral, s);
+    enc.add_temporary(x);
+  }
+  set_fft_layout(out, fft_strides(out.shape(), axes));
+
+  // The transform sizes are the sizes of the real side.
+  const Shape& real_shape = out.dtype() == float32 ? out.shape() : in.shape();
+  std::vector<long long> n;
+  for (auto ax : axes) {
+    n.push_back(real_shape[ax]);
+  }
+  long long fft_size =
+      std::accumulate(n.begin(), n.end(), 1LL, std::multiplies<long long>());
+  long long batch = 1;
+  for (int i = 0; i < out.ndim(); ++i) {
+    if (std::find(axes.begin(), axes.end(), static_cast<size_t>(i)) == axes.end()) {
+      batch *= out.shape(i);
+    }
+  }
+  cufftType type = !real ? CUFFT_C2C : (inverse ? CUFFT_C2R : CUFFT_R2C);
+  auto plan = cu::get_fft_plan(cu::device(s.device), n, batch, type);
+
+  enc.set_input_array(x);
+  enc.set_output_array(out);
+
+  void* workspace_ptr = nullptr;
+  if (plan->workspace_size() > 0) {
+    array workspace(
+        allocator::malloc(plan->workspace_size()),
+        {static_cast<int>(plan->workspace_size())},
+        int8);
+    enc.add_temporary(workspace);
+    workspace_ptr = workspace.data<void>();
+  }
+  // Keep the plan alive until the kernels finish in case it is evicted.
+  enc.add_completed_handler([plan]() {});
+
+  {
+    auto capture = enc.capture_context();
+    cufftHandle handle = plan->handle();
+    CHECK_CUFFT_ERROR(cufftSetStream(handle, enc.stream()));
+    CHECK_CUFFT_ERROR(cufftSetWorkArea(handle, workspace_ptr));
+    auto in_ptr = const_cast<void*>(x.data<void>());
+    if (type == CUFFT_C2C) {
+      CHECK_CUFFT_ERROR(cufftExecC2C(
+          handle,
+          static_cast<cufftComplex*>(in_ptr),
+          out.data<cufftComplex>(),
+          inverse ? CUFFT_INVERSE : CUFFT_FORWARD));
+    } else if (type == CUFFT_R2C) {
+      CHECK_CUFFT_ERROR(cufftExecR2C(
+          handle, static_cast<cufftReal*>(in_ptr), out.data<cufftComplex>()));
+    } else {
+      CHECK_CUFFT_ERROR(cufftExecC2R(
+          handle, static_cast<cufftComplex*>(in_ptr), out.data<cufftReal>()));
+    }
+  }
+
+  // cuFFT does not normalize the inverse transforms.
+  if (inverse && fft_size > 1) {
+    int64_t size = out.dtype() == float32 ? out.size() : 2 * out.size();
+    auto [num_blocks, block_dims] = get_launch_args(
+        cu::fft_scale, size, out.shape(), out.strides(), false);
+    enc.set_output_array(out);
+    enc.add_kernel_node(
+        cu::fft_scale,
+        num_blocks,
+        block_dims,
+        out.data<float>(),
+        1.0f / fft_size,
+        size);
+  }
+}
+
+// cuFFT transforms at most 3 axes at once, the others are transformed
+// separately. As with np.fft.rfftn the real transform is on the last axis.
+void nd_fft_op(
+    const array& in,
+    array& out,
+    const std::vector<size_t>& axes,
+    bool inverse,
+    bool real,
+    const Stream& s) {
+  if (axes.size() <= 3) {
+    fft_op(in, out, axes, inverse, real, s);
+    return;
+  }
+  std::vector<size_t> head(axes.begin(), axes.end() - 3);
+  std::vector<size_t> tail(axes.end() - 3, axes.end());
+  array temp(inverse ? in.shape() : out.shape(), complex64, nullptr, {});
+  if (inverse) {
+    nd_fft_op(in, temp, head, inverse, false, s);
+    fft_op(temp, out, tail, inverse, real, s);
+  } else {
+    fft_op(in, temp, tail, inverse, real, s);
+    nd_fft_op(temp, out, head, inverse, false, s);
+  }
+  cu::get_command_encoder(s).add_temporary(temp);
+}
+
+} // namespace
+
+void FFT::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("FFT::eval_gpu");
+  auto& s = stream();
+  auto& in = inputs[0];
+  if (out.size() == 0) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    return;
+  }
+  nd_fft_op(in, out, axes_, inverse_, real_, s);
+}
+
+} // namespace mlx::core
@@ -0,0 +1,150 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
+#include "mlx/backend/cuda/fp8.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <cuda_fp8.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int fp8_block_dim = 256;
+// The number of blocks computing the partial maximums of abs(x).
+constexpr int fp8_amax_blocks = 128;
+// The largest finite value of float8 e4m3.
+constexpr float fp8_e4m3_max = 448.0f;
+
+// Write the maximum of abs(x) over the elements visited by each block to
+// |partials|.
+template <typename T>
+__global__ void fp8_amax(const T* x, float* partials, size_t size) {
+  __shared__ float smem[fp8_block_dim / WARP_SIZE];
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+
+  float amax[1] = {0};
+  for (size_t i = block.group_index().x * fp8_block_dim + block.thread_rank();
+       i < size;
+       i += size_t(fp8_amax_blocks) * fp8_block_dim) {
+    amax[0] = fmaxf(amax[0], fabsf(static_cast<float>(x[i])));
+  }
+  block_reduce(block, warp, amax, smem, cg::greater<float>{}, 0.0f);
+  if (block.thread_rank() == 0) {
+    partials[block.group_index().x] = amax[0];
+  }
+}
+
+// Reduce the partial maximums to the scale and quantize x with it, the first
+// block also writes the scale for the matmul.
+template <typename T>
+__global__ void fp8_quantize(
+    const T* x,
+    const float* partials,
+    __nv_fp8_e4m3* x_q,
+    float* x_scale,
+    size_t size) {
+  __shared__ float smem[fp8_block_dim / WARP_SIZE];
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+
+  float amax[1] = {0};
+  for (int i = block.thread_rank(); i < fp8_amax_blocks; i += fp8_block_dim) {
+    amax[0] = fmaxf(amax[0], partials[i]);
+  }
+  // Every warp ends with the reduced value.
+  block_reduce(block, warp, amax, smem, cg::greater<float>{}, 0.0f);
+  float scale = fmaxf(amax[0], 1e-12f) / fp8_e4m3_max;
+  if (block.group_index().x == 0 && block.thread_rank() == 0) {
+    *x_scale = scale;
+  }
+
+  size_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    // The conversion rounds to nearest and saturates to the finite range.
+    x_q[i] = __nv_fp8_e4m3(static_cast<float>(x[i]) / scale);
+  }
+}
+
+template <typename T>
+__global__ void
+fp8_scale_columns(T* out, const float* scales, size_t size, int cols) {
+  size_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    out[i] = static_cast<T>(static_cast<float>(out[i]) * scales[i % cols]);
+  }
+}
+
+} // namespace cu
+
+void fp8_quantize(
+    const array& x,
+    array& x_q,
+    array& x_scale,
+    cu::CommandEncoder& encoder) {
+  array partials({cu::fp8_amax_blocks}, float32, nullptr, {});
+  partials.set_data(allocator::malloc(partials.nbytes()));
+  encoder.add_temporary(partials);
+
+  size_t size = x.size();
+  encoder.set_input_array(x);
+  encoder.set_output_array(partials);
+  dispatch_float_types(x.dtype(), "fp8_quantize", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::fp8_amax<DataType>,
+        cu::fp8_amax_blocks,
+        cu::fp8_block_dim,
+        x.data<DataType>(),
+        partials.data<float>(),
+        size);
+  });
+
+  encoder.set_input_array(x);
+  encoder.set_input_array(partials);
+  encoder.set_output_array(x_q);
+  encoder.set_output_array(x_scale);
+  dispatch_float_types(x.dtype(), "fp8_quantize", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::fp8_quantize<DataType>,
+        cuda::ceil_div(size, cu::fp8_block_dim),
+        cu::fp8_block_dim,
+        x.data<DataType>(),
+        partials.data<float>(),
+        x_q.data<__nv_fp8_e4m3>(),
+        x_scale.data<float>(),
+        size);
+  });
+}
+
+void fp8_scale_columns(
+    array& out,
+    const array& scales,
+    cu::CommandEncoder& encoder) {
+  size_t size = out.size();
+  int cols = out.shape(-1);
+  encoder.set_input_array(out);
+  encoder.set_input_array(scales);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "fp8_scale_columns", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::fp8_scale_columns<DataType>,
+        cuda::ceil_div(size, cu::fp8_block_dim),
+        cu::fp8_block_dim,
+        out.data<DataType>(),
+        scales.data<float>(),
+        size,
+        cols);
+  });
+}
+
+} // namespace mlx::core
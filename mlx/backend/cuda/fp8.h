@@ -0,0 +1,28 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// Quantize the row contiguous |x| to the float8 e4m3 values |x_q| with the
+// per-tensor scale |x_scale| = max(abs(x)) / 448, so that x ~ x_q * x_scale.
+void fp8_quantize(
+    const array& x,
+    array& x_q,
+    array& x_scale,
+    cu::CommandEncoder& encoder);
+
+// Multiply in place the columns of the row contiguous |out| by the
+// per-channel |scales|, which has one element per column.
+void fp8_scale_columns(
+    array& out,
+    const array& scales,
+    cu::CommandEncoder& encoder);
+
+} // namespace mlx::core
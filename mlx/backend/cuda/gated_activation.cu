@@ -0,0 +1,187 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <cooperative_groups.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+using GatedActivation = fast::GatedActivation;
+
+constexpr int gated_block_dim = 256;
+
+// The activation of the gate a and, for the vjp, its derivative.
+template <GatedActivation::Kind KIND, typename AccT>
+__device__ AccT gated_act(AccT a, AccT* dact = nullptr) {
+  if constexpr (KIND == GatedActivation::SiLU) {
+    AccT sig = 1 / (1 + exp(-a));
+    if (dact) {
+      *dact = sig * (1 + a * (1 - sig));
+    }
+    return a * sig;
+  } else {
+    AccT cdf = AccT(0.5) * (1 + erf(a * AccT(M_SQRT1_2)));
+    if (dact) {
+      *dact = cdf +
+          a * AccT(0.5 * M_2_SQRTPI * M_SQRT1_2) * exp(AccT(-0.5) * a * a);
+    }
+    return a * cdf;
+  }
+}
+
+// Each row of x holds the H gates followed by the H up projections, and
+// each thread computes one element of out.
+template <typename T, typename AccT, GatedActivation::Kind KIND>
+__global__ void
+gated_activation(const T* x, T* out, int64_t size, int64_t H) {
+  int64_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    int64_t row = i / H;
+    int64_t j = i % H;
+    const T* x_row = x + row * 2 * H;
+    AccT act = gated_act<KIND>(static_cast<AccT>(x_row[j]));
+    out[i] = static_cast<T>(act * static_cast<AccT>(x_row[H + j]));
+  }
+}
+
+// The gradients of both halves are written by the thread reading them, so
+// grad may share the buffer of x.
+template <typename T, typename AccT, GatedActivation::Kind KIND>
+__global__ void gated_activation_vjp(
+    const T* x,
+    const T* g,
+    T* grad,
+    int64_t size,
+    int64_t H) {
+  int64_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    int64_t offset = (i / H) * 2 * H + i % H;
+    AccT a = x[offset];
+    AccT b = x[offset + H];
+    AccT gi = g[i];
+    AccT dact;
+    AccT act = gated_act<KIND>(a, &dact);
+    grad[offset] = static_cast<T>(gi * b * dact);
+    grad[offset + H] = static_cast<T>(gi * act);
+  }
+}
+
+} // namespace cu
+
+namespace fast {
+
+bool GatedActivation::use_fallback(Stream s) {
+  return false;
+}
+
+void GatedActivation::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("GatedActivation::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  array x = inputs[0];
+  if (!x.flags().row_contiguous) {
+    x = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x);
+  }
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  int64_t size = out.size();
+  int64_t H = out.shape().back();
+  encoder.set_input_array(x);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "gated_activation", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using AccT =
+        std::conditional_t<std::is_same_v<DataType, double>, double, float>;
+    auto launch = [&](auto kernel) {
+      encoder.add_kernel_node(
+          kernel,
+          cuda::ceil_div(size, cu::gated_block_dim),
+          cu::gated_block_dim,
+          x.data<DataType>(),
+          out.data<DataType>(),
+          size,
+          H);
+    };
+    if (kind_ == SiLU) {
+      launch(cu::gated_activation<DataType, AccT, SiLU>);
+    } else {
+      launch(cu::gated_activation<DataType, AccT, GELU>);
+    }
+  });
+}
+
+void GatedActivationVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("GatedActivationVJP::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  auto ensure_row_contiguous = [&s, &encoder](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  auto x = ensure_row_contiguous(inputs[0]);
+  auto g = ensure_row_contiguous(inputs[1]);
+  auto& grad = outputs[0];
+  if (inputs[0].is_donatable() && inputs[0].flags().row_contiguous) {
+    grad.copy_shared_buffer(x);
+  } else {
+    grad.set_data(allocator::malloc(grad.nbytes()));
+  }
+  if (g.size() == 0) {
+    return;
+  }
+
+  int64_t size = g.size();
+  int64_t H = g.shape().back();
+  encoder.set_input_array(x);
+  encoder.set_input_array(g);
+  encoder.set_output_array(grad);
+  dispatch_float_types(grad.dtype(), "gated_activation_vjp", [&](auto tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(tag)>;
+    using AccT =
+        std::conditional_t<std::is_same_v<DataType, double>, double, float>;
+    auto launch = [&](auto kernel) {
+      encoder.add_kernel_node(
+          kernel,
+          cuda::ceil_div(size, cu::gated_block_dim),
+          cu::gated_block_dim,
+          x.data<DataType>(),
+          g.data<DataType>(),
+          grad.data<DataType>(),
+          size,
+          H);
+    };
+    if (kind_ == GatedActivation::SiLU) {
+      launch(cu::gated_activation_vjp<DataType, AccT, GatedActivation::SiLU>);
+    } else {
+      launch(cu::gated_activation_vjp<DataType, AccT, GatedActivation::GELU>);
+    }
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -0,0 +1,793 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/mma.cuh"
+#include "mlx/backend/cuda/device/utils.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+// The batch layout of GatherMM, the batch element i of the output is computed
+// from a[lhs_indices[i]] and b[rhs_indices[i]]. A launch computes the batch
+// elements from |batch_offset| on, in the z dimension of the grid.
+struct GatherMMBatch {
+  int64_t batch_offset;
+  int idx_ndims;
+  cu::Shape idx_shape;
+  cu::Strides lhs_strides;
+  cu::Strides rhs_strides;
+  const uint32_t* lhs_indices;
+  const uint32_t* rhs_indices;
+  int a_batch_ndims;
+  cu::Shape a_shape;
+  cu::Strides a_strides;
+  int b_batch_ndims;
+  cu::Shape b_shape;
+  cu::Strides b_strides;
+};
+
+// The batch layout of BlockMaskedMM, the strides include the two last dims.
+struct BlockMaskedMMBatch {
+  int ndim;
+  cu::Shape shape;
+  cu::Strides a_strides;
+  cu::Strides b_strides;
+  cu::Strides out_mask_strides;
+  cu::Strides lhs_mask_strides;
+  cu::Strides rhs_mask_strides;
+};
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int gemm_threads = 128;
+
+// Computes out[i] = a[lhs_indices[i]] @ b[rhs_indices[i]] with one block per
+// [BM, BN] tile of the output and all the batch elements in one launch.
+template <
+    typename T,
+    bool transpose_a,
+    bool transpose_b,
+    int BM = 64,
+    int BN = 64,
+    int BK = 32>
+__global__ void gather_mm(
+    const T* a,
+    const T* b,
+    T* out,
+    int M,
+    int N,
+    int K,
+    int64_t lda,
+    int64_t ldb,
+    const __grid_constant__ GatherMMBatch batch) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+
+  __shared__ __align__(32) T as[BM * LDS];
+  __shared__ __align__(32) T bs[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+
+  int64_t z = batch.batch_offset + blockIdx.z;
+  auto [lhs_loc, rhs_loc] = elem_to_loc_4d(
+      z,
+      batch.idx_shape.data(),
+      batch.lhs_strides.data(),
+      batch.rhs_strides.data(),
+      batch.idx_ndims);
+  a += elem_to_loc(
+      int64_t(batch.lhs_indices[lhs_loc]),
+      batch.a_shape.data(),
+      batch.a_strides.data(),
+      batch.a_batch_ndims);
+  b += elem_to_loc(
+      int64_t(batch.rhs_indices[rhs_loc]),
+      batch.b_shape.data(),
+      batch.b_strides.data(),
+      batch.b_batch_ndims);
+  out += z * M * N;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = 0; k0 < K; k0 += BK) {
+    // The b tile is stored as [n][k], which is the transposed layout of b.
+    load_tile<BM, BK, LDS, gemm_threads, transpose_a>(
+        as, a, lda, m0, k0, M, K, tid);
+    load_tile<BN, BK, LDS, gemm_threads, !transpose_b>(
+        bs, b, ldb, n0, k0, N, K, tid);
+    block.sync();
+
+    mma.mma(as, bs);
+    block.sync();
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, gemm_threads>(cs, out, N, m0, n0, M, N, tid);
+}
+
+// Computes out[i] = a[lhs_indices[i]] @ b[rhs_indices[i]] for the B rows of a
+// (M == 1), the rows are expected to be sorted by rhs_indices.
+//
+// Each block walks the runs of rows sharing a rhs index in its tile, so the
+// tile of b is read once per run instead of once per row.
+template <typename T, bool transpose_b, int BM = 64, int BN = 64, int BK = 32>
+__global__ void gather_mm_rhs(
+    const T* a,
+    const T* b,
+    T* out,
+    int B,
+    int N,
+    int K,
+    int64_t ldb,
+    const __grid_constant__ GatherMMBatch batch) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+
+  __shared__ __align__(32) T as[BM * LDS];
+  __shared__ __align__(32) T bs[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  __shared__ const T* a_rows[BM];
+  __shared__ uint32_t rhs[BM];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+  int rows = min(BM, B - m0);
+
+  for (int r = tid; r < rows; r += gemm_threads) {
+    auto [lhs_loc, rhs_loc] = elem_to_loc_4d(
+        int64_t(m0 + r),
+        batch.idx_shape.data(),
+        batch.lhs_strides.data(),
+        batch.rhs_strides.data(),
+        batch.idx_ndims);
+    int64_t a_loc = elem_to_loc(
+        int64_t(batch.lhs_indices[lhs_loc]),
+        batch.a_shape.data(),
+        batch.a_strides.data(),
+        batch.a_batch_ndims);
+    a_rows[r] = a + a_loc;
+    rhs[r] = batch.rhs_indices[rhs_loc];
+  }
+  block.sync();
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  int run_start = 0;
+  while (run_start < rows) {
+    uint32_t idx = rhs[run_start];
+    int run_end = run_start + 1;
+    while (run_end < rows && rhs[run_end] == idx) {
+      run_end++;
+    }
+
+    int64_t b_loc = elem_to_loc(
+        int64_t(idx),
+        batch.b_shape.data(),
+        batch.b_strides.data(),
+        batch.b_batch_ndims);
+    const T* b_run = b + b_loc;
+
+    for (int k0 = 0; k0 < K; k0 += BK) {
+      // Only the rows of the run are loaded, the others are zeroed.
+      for (int i = tid; i < BM * BK; i += gemm_threads) {
+        int r = i / BK;
+        int c = i % BK;
+        int k = k0 + c;
+        as[r * LDS + c] = (r >= run_start && r < run_end && k < K)
+            ? a_rows[r][k]
+            : static_cast<T>(0);
+      }
+      load_tile<BN, BK, LDS, gemm_threads, !transpose_b>(
+          bs, b_run, ldb, n0, k0, N, K, tid);
+      block.sync();
+
+      mma.mma(as, bs);
+      block.sync();
+    }
+
+    run_start = run_end;
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, gemm_threads>(cs, out, N, m0, n0, B, N, tid);
+}
+
+// Computes out[i] = a[:, k_start:k_end] @ b[k_start:k_end, :] where
+// (k_start, k_end) is the i-th segment.
+template <
+    typename T,
+    bool transpose_a,
+    bool transpose_b,
+    int BM = 64,
+    int BN = 64,
+    int BK = 32>
+__global__ void segmented_mm(
+    const T* a,
+    const T* b,
+    const uint32_t* segments,
+    T* out,
+    int M,
+    int N,
+    int64_t lda,
+    int64_t ldb,
+    int segment_offset) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+
+  __shared__ __align__(32) T as[BM * LDS];
+  __shared__ __align__(32) T bs[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+
+  int64_t z = segment_offset + blockIdx.z;
+  int k_start = segments[2 * z];
+  int k_end = segments[2 * z + 1];
+  out += z * M * N;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = k_start; k0 < k_end; k0 += BK) {
+    load_tile<BM, BK, LDS, gemm_threads, transpose_a>(
+        as, a, lda, m0, k0, M, k_end, tid);
+    load_tile<BN, BK, LDS, gemm_threads, !transpose_b>(
+        bs, b, ldb, n0, k0, N, k_end, tid);
+    block.sync();
+
+    mma.mma(as, bs);
+    block.sync();
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, gemm_threads>(cs, out, N, m0, n0, M, N, tid);
+}
+
+template <typename MaskT>
+inline __device__ float mask_value(const MaskT* mask, int64_t loc) {
+  if constexpr (cuda::std::is_same_v<MaskT, bool>) {
+    return mask[loc] ? 1.0f : 0.0f;
+  } else {
+    return static_cast<float>(mask[loc]);
+  }
+}
+
+// Computes out = (a * lhs_mask) @ (b * rhs_mask) * out_mask where the masks
+// have one value per [block_size, block_size] block, and a null mask is all
+// ones. The tiles whose out mask blocks are all zero and the steps of K whose
+// operand mask blocks are all zero are skipped.
+template <
+    typename T,
+    typename OutMaskT,
+    typename OpMaskT,
+    bool transpose_a,
+    bool transpose_b,
+    int BM = 64,
+    int BN = 64,
+    int BK = 32>
+__global__ void block_masked_mm(
+    const T* a,
+    const T* b,
+    const OutMaskT* out_mask,
+    const OpMaskT* lhs_mask,
+    const OpMaskT* rhs_mask,
+    T* out,
+    int M,
+    int N,
+    int K,
+    int64_t lda,
+    int64_t ldb,
+    int block_size,
+    const __grid_constant__ BlockMaskedMMBatch batch) {
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  // The smallest block size is 32.
+  constexpr int MB = BM / 32;
+  constexpr int NB = BN / 32;
+  static_assert(BM == BN, "The a and b tiles are scaled in one loop.");
+
+  __shared__ __align__(32) T as[BM * LDS];
+  __shared__ __align__(32) T bs[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  __shared__ float lhs_scale[MB];
+  __shared__ float rhs_scale[NB];
+  __shared__ float out_scale[MB][NB];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+  int64_t z = blockIdx.z;
+  int nd = batch.ndim;
+
+  a += elem_to_loc(z, batch.shape.data(), batch.a_strides.data(), nd);
+  b += elem_to_loc(z, batch.shape.data(), batch.b_strides.data(), nd);
+  out += z * M * N;
+
+  // The mask blocks covered by the tile.
+  int bm0 = m0 / block_size;
+  int bn0 = n0 / block_size;
+  int num_bm = (min(m0 + BM, M) - 1) / block_size - bm0 + 1;
+  int num_bn = (min(n0 + BN, N) - 1) / block_size - bn0 + 1;
+
+  if (out_mask) {
+    const auto* strides = batch.out_mask_strides.data();
+    int64_t loc = elem_to_loc(z, batch.shape.data(), strides, nd);
+    if (tid < MB * NB) {
+      int i = tid / NB;
+      int j = tid % NB;
+      out_scale[i][j] = (i < num_bm && j < num_bn)
+          ? mask_value(
+                out_mask,
+                loc + (bm0 + i) * strides[nd] + (bn0 + j) * strides[nd + 1])
+          : 0.0f;
+    }
+    block.sync();
+    bool skip = true;
+#pragma unroll
+    for (int i = 0; i < MB; ++i) {
+#pragma unroll
+      for (int j = 0; j < NB; ++j) {
+        skip &= out_scale[i][j] == 0.0f;
+      }
+    }
+    if (skip) {
+      for (int i = tid; i < BM * BN; i += gemm_threads) {
+        int m = m0 + i / BN;
+        int n = n0 + i % BN;
+        if (m < M && n < N) {
+          out[int64_t(m) * N + n] = static_cast<T>(0);
+        }
+      }
+      return;
+    }
+  }
+
+  int64_t lhs_loc = 0;
+  int64_t rhs_loc = 0;
+  if (lhs_mask) {
+    lhs_loc = elem_to_loc(
+        z, batch.shape.data(), batch.lhs_mask_strides.data(), nd);
+    rhs_loc = elem_to_loc(
+        z, batch.shape.data(), batch.rhs_mask_strides.data(), nd);
+  }
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = 0; k0 < K; k0 += BK) {
+    // A step of K is within one block as the block size is a multiple of BK.
+    bool scale_lhs = false;
+    bool scale_rhs = false;
+    if (lhs_mask) {
+      int kb = k0 / block_size;
+      const auto* lhs_strides = batch.lhs_mask_strides.data();
+      const auto* rhs_strides = batch.rhs_mask_strides.data();
+      if (tid < MB) {
+        lhs_scale[tid] = tid < num_bm
+            ? mask_value(
+                  lhs_mask,
+                  lhs_loc + (bm0 + tid) * lhs_strides[nd] +
+                      kb * lhs_strides[nd + 1])
+            : 0.0f;
+      } else if (tid >= WARP_SIZE && tid < WARP_SIZE + NB) {
+        int j = tid - WARP_SIZE;
+        rhs_scale[j] = j < num_bn
+            ? mask_value(
+                  rhs_mask,
+                  rhs_loc + kb * rhs_strides[nd] +
+                      (bn0 + j) * rhs_strides[nd + 1])
+            : 0.0f;
+      }
+      block.sync();
+      bool lhs_zero = true;
+      bool rhs_zero = true;
+#pragma unroll
+      for (int i = 0; i < MB; ++i) {
+        lhs_zero &= lhs_scale[i] == 0.0f;
+        scale_lhs |= i < num_bm && lhs_scale[i] != 1.0f;
+      }
+#pragma unroll
+      for (int j = 0; j < NB; ++j) {
+        rhs_zero &= rhs_scale[j] == 0.0f;
+        scale_rhs |= j < num_bn && rhs_scale[j] != 1.0f;
+      }
+      if (lhs_zero || rhs_zero) {
+        // Wait for the scales to be read before the next step writes them.
+        block.sync();
+        continue;
+      }
+    }
+
+    // The b tile is stored as [n][k], which is the transposed layout of b.
+    load_tile<BM, BK, LDS, gemm_threads, transpose_a>(
+        as, a, lda, m0, k0, M, K, tid);
+    load_tile<BN, BK, LDS, gemm_threads, !transpose_b>(
+        bs, b, ldb, n0, k0, N, K, tid);
+    block.sync();
+
+    if (scale_lhs || scale_rhs) {
+      for (int i = tid; i < BM * BK; i += gemm_threads) {
+        int r = i / BK;
+        int c = i % BK;
+        if (scale_lhs) {
+          float scale = lhs_scale[(m0 + r) / block_size - bm0];
+          as[r * LDS + c] =
+              static_cast<T>(static_cast<float>(as[r * LDS + c]) * scale);
+        }
+        if (scale_rhs) {
+          float scale = rhs_scale[(n0 + r) / block_size - bn0];
+          bs[r * LDS + c] =
+              static_cast<T>(static_cast<float>(bs[r * LDS + c]) * scale);
+        }
+      }
+      block.sync();
+    }
+
+    mma.mma(as, bs);
+    block.sync();
+  }
+
+  mma.store(cs);
+  block.sync();
+  for (int i = tid; i < BM * BN; i += gemm_threads) {
+    int r = i / BN;
+    int c = i % BN;
+    int m = m0 + r;
+    int n = n0 + c;
+    if (m < M && n < N) {
+      float val = cs[r * LDC + c];
+      if (out_mask) {
+        val *= out_scale[m / block_size - bm0][n / block_size - bn0];
+      }
+      out[int64_t(m) * N + n] = static_cast<T>(val);
+    }
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+std::tuple<bool, int64_t, array>
+check_transpose(cu::CommandEncoder& enc, const Stream& s, const array& arr) {
+  auto stx = arr.strides()[arr.ndim() - 2];
+  auto sty = arr.strides()[arr.ndim() - 1];
+  if (sty == 1 && stx == arr.shape(-1)) {
+    return std::make_tuple(false, stx, arr);
+  } else if (stx == 1 && sty == arr.shape(-2)) {
+    return std::make_tuple(true, sty, arr);
+  } else {
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return std::make_tuple(false, arr.shape(-1), arr_copy);
+  }
+}
+
+template <typename F>
+void dispatch_gemm_types(Dtype dtype, const char* tag, F&& f) {
+  if (dtype == float64) {
+    throw std::runtime_error(
+        fmt::format("{} float64 is not supported on the GPU.", tag));
+  }
+  dispatch_float_types(dtype, tag, std::forward<F>(f));
+}
+
+} // namespace
+
+void GatherMM::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("GatherMM::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  // Return 0s if either input is empty.
+  if (inputs[0].size() == 0 || inputs[1].size() == 0) {
+    array zero(0, out.dtype());
+    enc.add_temporary(zero);
+    fill_gpu(zero, out, s);
+    return;
+  }
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  // Not using structured bindings as they can not be captured by lambdas.
+  auto a_layout = check_transpose(enc, s, inputs[0]);
+  bool transpose_a = std::get<0>(a_layout);
+  int64_t lda = std::get<1>(a_layout);
+  const array& a = std::get<2>(a_layout);
+  auto b_layout = check_transpose(enc, s, inputs[1]);
+  bool transpose_b = std::get<0>(b_layout);
+  int64_t ldb = std::get<1>(b_layout);
+  const array& b = std::get<2>(b_layout);
+  const array& lhs_indices = inputs[2];
+  const array& rhs_indices = inputs[3];
+
+  int M = a.shape(-2);
+  int N = b.shape(-1);
+  int K = a.shape(-1);
+  int B = lhs_indices.size();
+
+  GatherMMBatch batch;
+  batch.idx_ndims = lhs_indices.ndim();
+  batch.idx_shape = const_param(lhs_indices.shape());
+  batch.lhs_strides = const_param(lhs_indices.strides());
+  batch.rhs_strides = const_param(rhs_indices.strides());
+  batch.lhs_indices = lhs_indices.data<uint32_t>();
+  batch.rhs_indices = rhs_indices.data<uint32_t>();
+  batch.a_batch_ndims = a.ndim() - 2;
+  batch.a_shape = const_param(a.shape());
+  batch.a_strides = const_param(a.strides());
+  batch.b_batch_ndims = b.ndim() - 2;
+  batch.b_shape = const_param(b.shape());
+  batch.b_strides = const_param(b.strides());
+
+  enc.set_input_array(a);
+  enc.set_input_array(b);
+  enc.set_input_array(lhs_indices);
+  enc.set_input_array(rhs_indices);
+  enc.set_output_array(out);
+
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+
+  // The rows are sorted by rhs index so the ones sharing a matrix of b can be
+  // multiplied together.
+  if (M == 1 && right_sorted_ && !transpose_a && B >= 16 &&
+      cuda::ceil_div(B, BM) <= max_grid_yz) {
+    dispatch_gemm_types(out.dtype(), "[GatherMM]", [&](auto type_tag) {
+      dispatch_bool(transpose_b, [&](auto transpose_b) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel = cu::gather_mm_rhs<DataType, transpose_b.value, BM, BN>;
+        enc.add_kernel_node(
+            kernel,
+            dim3(cuda::ceil_div(N, BN), cuda::ceil_div(B, BM)),
+            cu::gemm_threads,
+            a.data<DataType>(),
+            b.data<DataType>(),
+            out.data<DataType>(),
+            B,
+            N,
+            K,
+            ldb,
+            batch);
+      });
+    });
+    return;
+  }
+
+  dispatch_gemm_types(out.dtype(), "[GatherMM]", [&](auto type_tag) {
+    dispatch_bool(transpose_a, [&](auto transpose_a) {
+      dispatch_bool(transpose_b, [&](auto transpose_b) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel = cu::gather_mm<
+            DataType,
+            transpose_a.value,
+            transpose_b.value,
+            BM,
+            BN>;
+        for (int z0 = 0; z0 < B; z0 += max_grid_yz) {
+          batch.batch_offset = z0;
+          enc.add_kernel_node(
+              kernel,
+              dim3(
+                  cuda::ceil_div(N, BN),
+                  cuda::ceil_div(M, BM),
+                  std::min(B - z0, max_grid_yz)),
+              cu::gemm_threads,
+              a.data<DataType>(),
+              b.data<DataType>(),
+              out.data<DataType>(),
+              M,
+              N,
+              K,
+              lda,
+              ldb,
+              batch);
+        }
+      });
+    });
+  });
+}
+
+void SegmentedMM::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("SegmentedMM::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  // Not using structured bindings as they can not be captured by lambdas.
+  auto a_layout = check_transpose(enc, s, inputs[0]);
+  bool transpose_a = std::get<0>(a_layout);
+  int64_t lda = std::get<1>(a_layout);
+  const array& a = std::get<2>(a_layout);
+  auto b_layout = check_transpose(enc, s, inputs[1]);
+  bool transpose_b = std::get<0>(b_layout);
+  int64_t ldb = std::get<1>(b_layout);
+  const array& b = std::get<2>(b_layout);
+  array segments = inputs[2];
+  if (!segments.flags().row_contiguous) {
+    segments = contiguous_copy_gpu(segments, s);
+    enc.add_temporary(segments);
+  }
+
+  int M = a.shape(-2);
+  int N = b.shape(-1);
+  int num_segments = segments.size() / 2;
+
+  enc.set_input_array(a);
+  enc.set_input_array(b);
+  enc.set_input_array(segments);
+  enc.set_output_array(out);
+
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  dispatch_gemm_types(out.dtype(), "[SegmentedMM]", [&](auto type_tag) {
+    dispatch_bool(transpose_a, [&](auto transpose_a) {
+      dispatch_bool(transpose_b, [&](auto transpose_b) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel = cu::segmented_mm<
+            DataType,
+            transpose_a.value,
+            transpose_b.value,
+            BM,
+            BN>;
+        for (int z0 = 0; z0 < num_segments; z0 += max_grid_yz) {
+          enc.add_kernel_node(
+              kernel,
+              dim3(
+                  cuda::ceil_div(N, BN),
+                  cuda::ceil_div(M, BM),
+                  std::min(num_segments - z0, max_grid_yz)),
+              cu::gemm_threads,
+              a.data<DataType>(),
+              b.data<DataType>(),
+              segments.data<uint32_t>(),
+              out.data<DataType>(),
+              M,
+              N,
+              lda,
+              ldb,
+              z0);
+        }
+      });
+    });
+  });
+}
+
+void BlockMaskedMM::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("BlockMaskedMM::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  int K = inputs[0].shape(-1);
+  if (K == 0) {
+    array zero(0, out.dtype());
+    enc.add_temporary(zero);
+    fill_gpu(zero, out, s);
+    return;
+  }
+
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  // Not using structured bindings as they can not be captured by lambdas.
+  auto a_layout = check_transpose(enc, s, inputs[0]);
+  bool transpose_a = std::get<0>(a_layout);
+  int64_t lda = std::get<1>(a_layout);
+  const array& a = std::get<2>(a_layout);
+  auto b_layout = check_transpose(enc, s, inputs[1]);
+  bool transpose_b = std::get<0>(b_layout);
+  int64_t ldb = std::get<1>(b_layout);
+  const array& b = std::get<2>(b_layout);
+
+  int M = a.shape(-2);
+  int N = b.shape(-1);
+  int num_matrices = out.size() / (int64_t(M) * N);
+
+  bool has_op_mask = inputs.size() > 3;
+  bool has_out_mask = inputs.size() == 3 || inputs.size() == 5;
+
+  BlockMaskedMMBatch batch;
+  batch.ndim = out.ndim() - 2;
+  batch.shape = const_param(out.shape());
+  batch.a_strides = const_param(a.strides());
+  batch.b_strides = const_param(b.strides());
+
+  enc.set_input_array(a);
+  enc.set_input_array(b);
+  const array* out_mask = nullptr;
+  const array* lhs_mask = nullptr;
+  const array* rhs_mask = nullptr;
+  if (has_out_mask) {
+    out_mask = &inputs[2];
+    batch.out_mask_strides = const_param(out_mask->strides());
+    enc.set_input_array(*out_mask);
+  }
+  if (has_op_mask) {
+    lhs_mask = &inputs[inputs.size() - 2];
+    rhs_mask = &inputs[inputs.size() - 1];
+    batch.lhs_mask_strides = const_param(lhs_mask->strides());
+    batch.rhs_mask_strides = const_param(rhs_mask->strides());
+    enc.set_input_array(*lhs_mask);
+    enc.set_input_array(*rhs_mask);
+  }
+  enc.set_output_array(out);
+
+  bool out_mask_bool = !out_mask || out_mask->dtype() == bool_;
+  bool op_mask_bool = !lhs_mask || lhs_mask->dtype() == bool_;
+
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  dispatch_gemm_types(out.dtype(), "[BlockMaskedMM]", [&](auto type_tag) {
+    dispatch_bool(out_mask_bool, [&](auto out_mask_bool) {
+      dispatch_bool(op_mask_bool, [&](auto op_mask_bool) {
+        dispatch_bool(transpose_a, [&](auto transpose_a) {
+          dispatch_bool(transpose_b, [&](auto transpose_b) {
+            using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+            using OutMaskT =
+                std::conditional_t<out_mask_bool.value, bool, DataType>;
+            using OpMaskT =
+                std::conditional_t<op_mask_bool.value, bool, DataType>;
+            auto kernel = cu::block_masked_mm<
+                DataType,
+                OutMaskT,
+                OpMaskT,
+                transpose_a.value,
+                transpose_b.value,
+                BM,
+                BN>;
+            enc.add_kernel_node(
+                kernel,
+                dim3(
+                    cuda::ceil_div(N, BN),
+                    cuda::ceil_div(M, BM),
+                    num_matrices),
+                cu::gemm_threads,
+                a.data<DataType>(),
+                b.data<DataType>(),
+                out_mask ? out_mask->data<OutMaskT>() : nullptr,
+                lhs_mask ? lhs_mask->data<OpMaskT>() : nullptr,
+                rhs_mask ? rhs_mask->data<OpMaskT>() : nullptr,
+                out.data<DataType>(),
+                M,
+                N,
+                K,
+                lda,
+                ldb,
+                block_size_,
+                batch);
+          });
+        });
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,137 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/indexing.cuh"
+#include "mlx/backend/cuda/gather_rows.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Each thread copies a vector of the row |idx[i]| of |src| to the row i of
+// |out|, the rows and their stride are counted in vectors.
+template <typename VecT, typename IdxT>
+__global__ void gather_rows(
+    const VecT* src,
+    VecT* out,
+    const IdxT* idx,
+    int64_t size,
+    int64_t row_size,
+    int64_t row_stride,
+    int32_t axis_size,
+    const __grid_constant__ Shape idx_shape,
+    const __grid_constant__ Strides idx_strides,
+    int32_t idx_ndim,
+    bool idx_contiguous) {
+  int64_t i = cg::this_grid().thread_rank();
+  if (i >= size) {
+    return;
+  }
+  int64_t row = i / row_size;
+  int64_t col = i - row * row_size;
+  int64_t idx_loc = idx_contiguous
+      ? row
+      : elem_to_loc(row, idx_shape.data(), idx_strides.data(), idx_ndim);
+  int64_t src_row = absolute_index(idx[idx_loc], axis_size);
+  out[i] = src[src_row * row_stride + col];
+}
+
+} // namespace cu
+
+bool use_gather_rows(
+    const array& src,
+    const std::vector<int>& axes,
+    const Shape& slice_sizes) {
+  if (axes.size() != 1 || axes[0] != 0 || slice_sizes[0] != 1) {
+    return false;
+  }
+  int64_t stride = 1;
+  for (int i = src.ndim() - 1; i > 0; --i) {
+    if (slice_sizes[i] != src.shape(i)) {
+      return false;
+    }
+    if (src.shape(i) > 1 && src.strides(i) != stride) {
+      return false;
+    }
+    stride *= src.shape(i);
+  }
+  return true;
+}
+
+void gather_rows(
+    const array& src,
+    const array& idx,
+    array& out,
+    cu::CommandEncoder& encoder) {
+  size_t itemsize = out.itemsize();
+  int64_t row_bytes = (out.size() / idx.size()) * itemsize;
+  int64_t stride_bytes = src.strides(0) * itemsize;
+
+  // The widest vector which divides the rows and their stride, and to which
+  // both buffers are aligned.
+  auto alignment = reinterpret_cast<uintptr_t>(src.data<char>()) |
+      reinterpret_cast<uintptr_t>(out.data<char>()) | row_bytes |
+      (src.shape(0) > 1 ? stride_bytes : 0);
+  int vec_bytes = 16;
+  while (vec_bytes > 1 && (alignment % vec_bytes) != 0) {
+    vec_bytes /= 2;
+  }
+  auto dispatch_vec = [&](auto f) {
+    switch (vec_bytes) {
+      case 16:
+        f(type_identity<uint4>{});
+        break;
+      case 8:
+        f(type_identity<uint2>{});
+        break;
+      case 4:
+        f(type_identity<uint32_t>{});
+        break;
+      case 2:
+        f(type_identity<uint16_t>{});
+        break;
+      default:
+        f(type_identity<uint8_t>{});
+        break;
+    }
+  };
+
+  int64_t row_size = row_bytes / vec_bytes;
+  int64_t row_stride = stride_bytes / vec_bytes;
+  int64_t size = idx.size() * row_size;
+  bool idx_contiguous = idx.flags().row_contiguous;
+
+  encoder.set_input_array(src);
+  encoder.set_input_array(idx);
+  encoder.set_output_array(out);
+  dispatch_int_types(idx.dtype(), "gather_rows", [&](auto idx_tag) {
+    using IdxT = MLX_GET_TYPE(idx_tag);
+    dispatch_vec([&](auto vec_tag) {
+      using VecT = typename decltype(vec_tag)::type;
+      constexpr int block_dim = 256;
+      encoder.add_kernel_node(
+          cu::gather_rows<VecT, IdxT>,
+          cuda::ceil_div(size, block_dim),
+          block_dim,
+          reinterpret_cast<const VecT*>(src.data<char>()),
+          reinterpret_cast<VecT*>(out.data<char>()),
+          idx.data<IdxT>(),
+          size,
+          row_size,
+          row_stride,
+          static_cast<int32_t>(src.shape(0)),
+          const_param(idx.shape()),
+          const_param(idx.strides()),
+          static_cast<int32_t>(idx.ndim()),
+          idx_contiguous);
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,29 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// Whether the gather of the slices |slice_sizes| of |src| at |axes| copies
+// whole rows, i.e. a single index array selects along the first axis and
+// the slices cover the contiguous trailing dimensions, like the lookup of
+// an embedding table or of the pages of a KV cache.
+bool use_gather_rows(
+    const array& src,
+    const std::vector<int>& axes,
+    const Shape& slice_sizes);
+
+// out[i, ...] = src[idx[i], ...] with vectorized copies of the rows.
+void gather_rows(
+    const array& src,
+    const array& idx,
+    array& out,
+    cu::CommandEncoder& encoder);
+
+} // namespace mlx::core
@@ -0,0 +1,153 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/gemm_batched.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/utils.h"
+
+#include <cooperative_groups.h>
+#include <cublas_v2.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Write the pointers of the matrices of each batch, the pointers of a, then
+// of b, then of out.
+__global__ void gemm_batched_pointers(
+    const char* a,
+    const char* b,
+    char* out,
+    int64_t itemsize,
+    int64_t out_batch_size,
+    int batch_count,
+    const __grid_constant__ Shape batch_shape,
+    const __grid_constant__ Strides a_batch_strides,
+    const __grid_constant__ Strides b_batch_strides,
+    int batch_ndim,
+    const void** pointers) {
+  int64_t i = cg::this_grid().thread_rank();
+  if (i >= batch_count) {
+    return;
+  }
+  auto [a_loc, b_loc] = elem_to_loc_4d(
+      i,
+      batch_shape.data(),
+      a_batch_strides.data(),
+      b_batch_strides.data(),
+      batch_ndim);
+  pointers[i] = a + a_loc * itemsize;
+  pointers[batch_count + i] = b + b_loc * itemsize;
+  pointers[2 * batch_count + i] = out + i * out_batch_size * itemsize;
+}
+
+} // namespace cu
+
+bool can_use_gemm_batched(Dtype dtype) {
+  return dtype == float32 || dtype == float16 || dtype == bfloat16;
+}
+
+void gemm_batched(
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    bool a_transposed,
+    int64_t lda,
+    bool b_transposed,
+    int64_t ldb,
+    const Shape& batch_shape,
+    const Strides& a_batch_strides,
+    const Strides& b_batch_strides,
+    MatmulPrecision precision,
+    cu::CommandEncoder& encoder,
+    const Stream& s) {
+  auto& device = cu::device(s.device);
+  int batch_count = out.size() / (int64_t(M) * N);
+
+  array pointers({3 * batch_count}, uint64, nullptr, {});
+  pointers.set_data(allocator::malloc(pointers.nbytes()));
+  encoder.add_temporary(pointers);
+  encoder.set_input_array(a);
+  encoder.set_input_array(b);
+  encoder.set_output_array(pointers);
+  constexpr int block_dim = 256;
+  encoder.add_kernel_node(
+      cu::gemm_batched_pointers,
+      cuda::ceil_div(batch_count, block_dim),
+      block_dim,
+      a.data<char>(),
+      b.data<char>(),
+      out.data<char>(),
+      int64_t(out.itemsize()),
+      int64_t(M) * N,
+      batch_count,
+      const_param(batch_shape),
+      const_param(a_batch_strides),
+      const_param(b_batch_strides),
+      int(batch_shape.size()),
+      pointers.data<const void*>());
+
+  // The workspace size recommended for cublas, see the preference of
+  // cublasLt in matmul.cpp.
+  uint64_t MiB = 1024 * 1024;
+  uint64_t workspace_size =
+      device.compute_capability_major() >= 9 ? 32 * MiB : 4 * MiB;
+  array workspace(
+      allocator::malloc(workspace_size),
+      {static_cast<int>(workspace_size)},
+      int8);
+  encoder.add_temporary(workspace);
+
+  // The matrices of mlx are row-major, so like cu::MatMul this computes
+  // out^T = b^T @ a^T in column order.
+  cudaDataType_t type = out.dtype() == float32 ? CUDA_R_32F
+      : out.dtype() == float16                 ? CUDA_R_16F
+                                               : CUDA_R_16BF;
+  auto compute_type = cublas_compute_type(out.dtype(), precision);
+  // The half accumulation also takes half alpha and beta.
+  float alpha = 1;
+  float beta = 0;
+  __half alpha_h = __float2half(1.0f);
+  __half beta_h = __float2half(0.0f);
+  bool half_scales = compute_type == CUBLAS_COMPUTE_16F;
+  const void** ptrs = pointers.data<const void*>();
+
+  encoder.set_input_array(a);
+  encoder.set_input_array(b);
+  encoder.set_input_array(pointers);
+  encoder.set_output_array(out);
+  auto handle = device.blas_handle();
+  auto capture = encoder.capture_context();
+  CHECK_CUBLAS_ERROR(cublasSetStream(handle, encoder.stream()));
+  CHECK_CUBLAS_ERROR(cublasSetWorkspace(
+      handle, workspace.data<void>(), workspace_size));
+  CHECK_CUBLAS_ERROR(cublasGemmBatchedEx(
+      handle,
+      b_transposed ? CUBLAS_OP_T : CUBLAS_OP_N,
+      a_transposed ? CUBLAS_OP_T : CUBLAS_OP_N,
+      N,
+      M,
+      K,
+      half_scales ? static_cast<const void*>(&alpha_h) : &alpha,
+      ptrs + batch_count,
+      type,
+      ldb,
+      ptrs,
+      type,
+      lda,
+      half_scales ? static_cast<const void*>(&beta_h) : &beta,
+      const_cast<void**>(ptrs + 2 * batch_count),
+      type,
+      N,
+      batch_count,
+      compute_type,
+      CUBLAS_GEMM_DEFAULT));
+}
+
+} // namespace mlx::core
@@ -0,0 +1,38 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+#include "mlx/utils.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// Whether gemm_batched can compute the matmuls of |dtype|.
+bool can_use_gemm_batched(Dtype dtype);
+
+// Compute all the batches of out = a @ b in a single launch of a pointer
+// array batched gemm, for the batch shapes and strides that can not be
+// collapsed into one strided batch, e.g. the broadcasted heads of GQA.
+void gemm_batched(
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    bool a_transposed,
+    int64_t lda,
+    bool b_transposed,
+    int64_t ldb,
+    const Shape& batch_shape,
+    const Strides& a_batch_strides,
+    const Strides& b_batch_strides,
+    MatmulPrecision precision,
+    cu::CommandEncoder& encoder,
+    const Stream& s);
+
+} // namespace mlx::core
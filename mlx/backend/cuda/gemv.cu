@@ -0,0 +1,331 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/gemv.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int gemv_warps_per_block = 8;
+
+// The batch dims of the vectors and of the matrix.
+struct GemvBatch {
+  int ndim;
+  Shape shape;
+  Strides vec_strides;
+  Strides mat_strides;
+};
+
+// Move the pointers to the batch element |batch_idx|.
+template <typename T>
+inline __device__ void gemv_batch_offsets(
+    const GemvBatch& b,
+    int64_t batch_idx,
+    int64_t out_size,
+    const T*& vec,
+    const T*& mat,
+    T*& out) {
+  vec += elem_to_loc(batch_idx, b.shape.data(), b.vec_strides.data(), b.ndim);
+  mat += elem_to_loc(batch_idx, b.shape.data(), b.mat_strides.data(), b.ndim);
+  out += batch_idx * out_size;
+}
+
+template <typename T>
+inline __device__ void
+gemv_write(T* out, const T* bias, bool relu, int cols, int r, int c, float v) {
+  if (bias) {
+    v += static_cast<float>(bias[c]);
+  }
+  if (relu) {
+    v = fmaxf(v, 0.0f);
+  }
+  out[int64_t(r) * cols + c] = static_cast<T>(v);
+}
+
+// Computes out = vec @ mat.T for up to gemv_max_rows vectors, where mat is
+// [cols, K] and its rows are contiguous.
+//
+// SPLIT_K warps compute each output column over consecutive chunks of K, the
+// lanes load N_READS consecutive values at a time and the partial dot
+// products are reduced across the warp, then across the SPLIT_K warps in
+// shared memory.
+template <typename T, int N_READS, int SPLIT_K>
+__global__ void gemv(
+    const T* vec,
+    const T* mat,
+    const T* bias,
+    T* out,
+    int rows,
+    int cols,
+    int K,
+    int64_t ld_vec,
+    int64_t ld_mat,
+    bool relu,
+    const __grid_constant__ GemvBatch batch) {
+  constexpr int cols_per_block = gemv_warps_per_block / SPLIT_K;
+  __shared__ float partials[gemv_warps_per_block][gemv_max_rows];
+
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  int warp_idx = warp.meta_group_rank();
+  int c = blockIdx.x * cols_per_block + warp_idx / SPLIT_K;
+  int split = warp_idx % SPLIT_K;
+
+  gemv_batch_offsets(batch, blockIdx.y, int64_t(rows) * cols, vec, mat, out);
+
+  float acc[gemv_max_rows] = {0};
+  if (c < cols) {
+    const T* mat_c = mat + c * ld_mat;
+    int k_per_split = cuda::ceil_div(K, SPLIT_K * N_READS) * N_READS;
+    int k_end = min(K, (split + 1) * k_per_split);
+    for (int k = split * k_per_split + warp.thread_rank() * N_READS; k < k_end;
+         k += WARP_SIZE * N_READS) {
+      if (k + N_READS <= k_end) {
+        auto w = load_vector<N_READS>(mat_c, k / N_READS);
+#pragma unroll
+        for (int r = 0; r < gemv_max_rows; ++r) {
+          if (r < rows) {
+            auto x = load_vector<N_READS>(vec + r * ld_vec, k / N_READS);
+#pragma unroll
+            for (int i = 0; i < N_READS; ++i) {
+              acc[r] += static_cast<float>(x.val[i]) *
+                  static_cast<float>(w.val[i]);
+            }
+          }
+        }
+      } else {
+        for (int kk = k; kk < k_end; ++kk) {
+          float w = static_cast<float>(mat_c[kk]);
+#pragma unroll
+          for (int r = 0; r < gemv_max_rows; ++r) {
+            if (r < rows) {
+              acc[r] += static_cast<float>(vec[r * ld_vec + kk]) * w;
+            }
+          }
+        }
+      }
+    }
+  }
+
+#pragma unroll
+  for (int r = 0; r < gemv_max_rows; ++r) {
+    acc[r] = cg::reduce(warp, acc[r], cg::plus<float>{});
+  }
+  if constexpr (SPLIT_K > 1) {
+    if (warp.thread_rank() == 0) {
+#pragma unroll
+      for (int r = 0; r < gemv_max_rows; ++r) {
+        partials[warp_idx][r] = acc[r];
+      }
+    }
+    block.sync();
+    if (split == 0 && warp.thread_rank() == 0) {
+#pragma unroll
+      for (int r = 0; r < gemv_max_rows; ++r) {
+        for (int j = 1; j < SPLIT_K; ++j) {
+          acc[r] += partials[warp_idx + j][r];
+        }
+      }
+    }
+  }
+  if (split != 0 || warp.thread_rank() != 0 || c >= cols) {
+    return;
+  }
+#pragma unroll
+  for (int r = 0; r < gemv_max_rows; ++r) {
+    if (r < rows) {
+      gemv_write(out, bias, relu, cols, r, c, acc[r]);
+    }
+  }
+}
+
+// Computes out = vec @ mat for up to gemv_max_rows vectors, where mat is
+// [K, cols] and its rows are contiguous.
+//
+// The threads in x dimension handle N_READS consecutive output columns each,
+// and the SPLIT_K threads in y dimension split K, the partial sums are then
+// reduced in shared memory.
+template <typename T, int N_READS, int SPLIT_K>
+__global__ void gemv_t(
+    const T* vec,
+    const T* mat,
+    const T* bias,
+    T* out,
+    int rows,
+    int cols,
+    int K,
+    int64_t ld_vec,
+    int64_t ld_mat,
+    bool relu,
+    const __grid_constant__ GemvBatch batch) {
+  constexpr int BN = WARP_SIZE * N_READS;
+  __shared__ float partials[SPLIT_K][BN];
+
+  auto block = cg::this_thread_block();
+  int tx = block.thread_index().x;
+  int ty = block.thread_index().y;
+
+  gemv_batch_offsets(batch, blockIdx.y, int64_t(rows) * cols, vec, mat, out);
+
+  int c0 = blockIdx.x * BN;
+  int c = c0 + tx * N_READS;
+  float acc[gemv_max_rows][N_READS] = {};
+  if (c < cols) {
+    bool full = c + N_READS <= cols;
+    for (int k = ty; k < K; k += SPLIT_K) {
+      const T* mat_k = mat + k * ld_mat;
+      AlignedVector<T, N_READS> w;
+      if (full) {
+        w = load_vector<N_READS>(mat_k, c / N_READS);
+      } else {
+#pragma unroll
+        for (int i = 0; i < N_READS; ++i) {
+          w.val[i] = c + i < cols ? mat_k[c + i] : static_cast<T>(0);
+        }
+      }
+#pragma unroll
+      for (int r = 0; r < gemv_max_rows; ++r) {
+        if (r < rows) {
+          float x = static_cast<float>(vec[r * ld_vec + k]);
+#pragma unroll
+          for (int i = 0; i < N_READS; ++i) {
+            acc[r][i] += x * static_cast<float>(w.val[i]);
+          }
+        }
+      }
+    }
+  }
+
+  // Reduce the SPLIT_K partial sums of each column.
+#pragma unroll
+  for (int r = 0; r < gemv_max_rows; ++r) {
+    if (r < rows) {
+#pragma unroll
+      for (int i = 0; i < N_READS; ++i) {
+        partials[ty][tx * N_READS + i] = acc[r][i];
+      }
+      block.sync();
+      for (int j = block.thread_rank(); j < BN; j += WARP_SIZE * SPLIT_K) {
+        float val = 0;
+#pragma unroll
+        for (int s = 0; s < SPLIT_K; ++s) {
+          val += partials[s][j];
+        }
+        if (c0 + j < cols) {
+          gemv_write(out, bias, relu, cols, r, c0 + j, val);
+        }
+      }
+      block.sync();
+    }
+  }
+}
+
+} // namespace cu
+
+bool can_use_gemv(int M, int N, bool a_transposed, Dtype dtype, bool has_bias) {
+  if (dtype != float32 && dtype != float16 && dtype != bfloat16) {
+    return false;
+  }
+  return (M <= gemv_max_rows && !a_transposed) || (N == 1 && !has_bias);
+}
+
+void gemv(
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    bool a_transposed,
+    int64_t lda,
+    bool b_transposed,
+    int64_t ldb,
+    const Shape& batch_shape,
+    const Strides& a_batch_strides,
+    const Strides& b_batch_strides,
+    const array* bias,
+    bool relu,
+    cu::CommandEncoder& encoder) {
+  // The rows of a are the vectors when there are few of them, otherwise b is
+  // the single vector and out^T = b^T @ a^T. The K values of the single
+  // column of b are always contiguous.
+  bool vec_is_a = M <= gemv_max_rows && !a_transposed;
+  const array& vec = vec_is_a ? a : b;
+  const array& mat = vec_is_a ? b : a;
+  int rows = vec_is_a ? M : 1;
+  int cols = vec_is_a ? N : M;
+  int64_t ld_vec = vec_is_a ? lda : 0;
+  int64_t ld_mat = vec_is_a ? ldb : lda;
+  // Whether the rows of the [cols, K] matrix are contiguous.
+  bool mat_rows = vec_is_a ? b_transposed : !a_transposed;
+
+  cu::GemvBatch batch;
+  int batch_count = out.size() / (int64_t(M) * N);
+  batch.ndim = batch_count > 1 ? batch_shape.size() : 0;
+  batch.shape = const_param(batch_shape);
+  batch.vec_strides = const_param(vec_is_a ? a_batch_strides : b_batch_strides);
+  batch.mat_strides = const_param(vec_is_a ? b_batch_strides : a_batch_strides);
+
+  encoder.set_input_array(a);
+  encoder.set_input_array(b);
+  if (bias) {
+    encoder.set_input_array(*bias);
+  }
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "gemv", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    constexpr int N_READS = 16 / sizeof(DataType);
+    const DataType* bias_ptr = bias ? bias->data<DataType>() : nullptr;
+    if (mat_rows) {
+      // Split K across the warps of a block when there are too few columns
+      // to fill the GPU with one warp each.
+      bool split = int64_t(cols) * batch_count < 2048 && K >= 1024;
+      dispatch_bool(split, [&](auto split_k) {
+        constexpr int SPLIT_K = split_k.value ? 4 : 1;
+        constexpr int cols_per_block = cu::gemv_warps_per_block / SPLIT_K;
+        encoder.add_kernel_node(
+            cu::gemv<DataType, N_READS, SPLIT_K>,
+            dim3(cuda::ceil_div(cols, cols_per_block), batch_count),
+            cu::gemv_warps_per_block * WARP_SIZE,
+            vec.data<DataType>(),
+            mat.data<DataType>(),
+            bias_ptr,
+            out.data<DataType>(),
+            rows,
+            cols,
+            K,
+            ld_vec,
+            ld_mat,
+            relu,
+            batch);
+      });
+    } else {
+      constexpr int SPLIT_K = 8;
+      encoder.add_kernel_node(
+          cu::gemv_t<DataType, N_READS, SPLIT_K>,
+          dim3(cuda::ceil_div(cols, WARP_SIZE * N_READS), batch_count),
+          dim3(WARP_SIZE, SPLIT_K),
+          vec.data<DataType>(),
+          mat.data<DataType>(),
+          bias_ptr,
+          out.data<DataType>(),
+          rows,
+          cols,
+          K,
+          ld_vec,
+          ld_mat,
+          relu,
+          batch);
+    }
+  });
+}
+
+} // namespace mlx::core
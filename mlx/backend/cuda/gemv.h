@@ -0,0 +1,43 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// The largest number of rows of a, i.e. M, computed by the gemv kernels.
+constexpr int gemv_max_rows = 8;
+
+// Whether the gemv kernels can compute a @ b, which is the case for the
+// floating types when a has up to gemv_max_rows contiguous rows, or when b
+// is a single column. The bias of the epilogue is only supported in the
+// former case.
+bool can_use_gemv(int M, int N, bool a_transposed, Dtype dtype, bool has_bias);
+
+// Compute out = a @ b, plus the optional |bias| of the columns of out and
+// a relu, for the problems accepted by can_use_gemv. The batch dims of a
+// and b are described by the collapsed |batch_shape| and batch strides.
+void gemv(
+    const array& a,
+    const array& b,
+    array& out,
+    int M,
+    int N,
+    int K,
+    bool a_transposed,
+    int64_t lda,
+    bool b_transposed,
+    int64_t ldb,
+    const Shape& batch_shape,
+    const Strides& a_batch_strides,
+    const Strides& b_batch_strides,
+    const array* bias,
+    bool relu,
+    cu::CommandEncoder& encoder);
+
+} // namespace mlx::core
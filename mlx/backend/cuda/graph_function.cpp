@@ -0,0 +1,290 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/cuda.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/primitives.h"
+#include "mlx/transforms.h"
+
+#include <algorithm>
+#include <climits>
+#include <map>
+#include <optional>
+#include <tuple>
+#include <unordered_set>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// The graph recorded for the inputs of a shape, with the arrays it reads
+// and writes.
+struct GraphRecord {
+  // Destroyed last as the arrays of the record may be in its arena.
+  std::unique_ptr<MemoryPlan> plan;
+  Stream stream;
+  std::vector<array> inputs;
+  // The inputs copied to the buffers of |inputs| at each call, the others
+  // are read in place.
+  std::vector<bool> copied;
+  std::vector<array> outputs;
+  std::optional<CommandEncoder::Recording> recording;
+};
+
+CopyType copy_type(const array& in) {
+  return in.flags().row_contiguous ? CopyType::Vector : CopyType::General;
+}
+
+// Launches the recorded graph and copies its outputs to the outputs of the
+// primitive, or only copies them when |launch| is false.
+class GraphReplay : public Primitive {
+ public:
+  GraphReplay(Stream stream, std::shared_ptr<GraphRecord> record, bool launch)
+      : Primitive(stream), record_(std::move(record)), launch_(launch) {}
+
+  void eval_cpu(const std::vector<array>&, std::vector<array>&) override {
+    throw std::runtime_error("[GraphReplay] Not supported on the CPU.");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    auto& s = stream();
+    auto& encoder = get_command_encoder(s);
+    auto& record = *record_;
+    if (launch_) {
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        if (record.copied[i]) {
+          copy_gpu_inplace(
+              inputs[i], record.inputs[i], copy_type(inputs[i]), s);
+        }
+      }
+      encoder.launch(*record.recording);
+    }
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      auto& in = record.outputs[i];
+      copy_gpu(
+          in,
+          outputs[i],
+          in.flags().contiguous ? CopyType::Vector : CopyType::General,
+          s);
+    }
+    // The buffers of the graph are kept until it finishes.
+    encoder.add_completed_handler([record = record_]() {});
+  }
+
+  DEFINE_NAME(GraphReplay)
+
+ private:
+  std::shared_ptr<GraphRecord> record_;
+  bool launch_;
+};
+
+bool same_array(const array& a, const array& b) {
+  return a.data_shared_ptr() && a.data_shared_ptr() == b.data_shared_ptr() &&
+      a.data<void>() == b.data<void>() && a.strides() == b.strides();
+}
+
+std::vector<array> replay(
+    const std::shared_ptr<GraphRecord>& record,
+    const std::vector<array>& inputs,
+    bool launch) {
+  std::vector<Shape> shapes;
+  std::vector<Dtype> dtypes;
+  for (auto& out : record->outputs) {
+    shapes.push_back(out.shape());
+    dtypes.push_back(out.dtype());
+  }
+  return array::make_arrays(
+      std::move(shapes),
+      dtypes,
+      std::make_shared<GraphReplay>(record->stream, record, launch),
+      inputs);
+}
+
+using AllocationTrace = std::vector<std::pair<CudaBuffer*, size_t>>;
+
+// Assign the buffers allocated while recording to the slots of an arena, so
+// the buffers used by disjoint ranges of nodes share a slot. The nodes
+// writing a slot then wait for the nodes which used it before, as they use
+// the same buffer. The outputs live until the end, and the buffers not used
+// by the nodes are allocated as usual.
+std::unique_ptr<MemoryPlan> plan_memory(
+    const AllocationTrace& trace,
+    const CommandEncoder::Recording& recording,
+    const std::vector<array>& outputs) {
+  struct Interval {
+    int first;
+    int last;
+    size_t index;
+  };
+  std::unordered_set<std::uintptr_t> output_ids;
+  for (auto& out : outputs) {
+    output_ids.insert(reinterpret_cast<std::uintptr_t>(out.buffer().ptr()));
+  }
+  std::vector<Interval> intervals;
+  std::unordered_set<CudaBuffer*> seen;
+  for (size_t k = trace.size(); k-- > 0;) {
+    // A buffer allocated again was not used by the nodes before.
+    if (!seen.insert(trace[k].first).second) {
+      continue;
+    }
+    auto id = reinterpret_cast<std::uintptr_t>(trace[k].first);
+    auto it = recording.uses.find(id);
+    if (it == recording.uses.end()) {
+      continue;
+    }
+    int last = output_ids.count(id) ? INT_MAX : it->second.second;
+    intervals.push_back({it->second.first, last, k});
+  }
+  std::sort(intervals.begin(), intervals.end(), [](auto& a, auto& b) {
+    return std::tie(a.first, a.index) < std::tie(b.first, b.index);
+  });
+
+  // Each buffer takes the smallest free slot it fits in, or grows the
+  // largest free slot, or takes a new slot.
+  std::vector<size_t> sizes(trace.size());
+  std::vector<int> slot_of(trace.size(), -1);
+  std::vector<size_t> slot_sizes;
+  std::vector<int> slot_last;
+  for (auto& interval : intervals) {
+    size_t size = trace[interval.index].second;
+    int best = -1;
+    for (int i = 0; i < static_cast<int>(slot_sizes.size()); ++i) {
+      if (slot_last[i] >= interval.first) {
+        continue;
+      }
+      if (best < 0) {
+        best = i;
+      } else if (slot_sizes[i] >= size) {
+        if (slot_sizes[best] < size || slot_sizes[i] < slot_sizes[best]) {
+          best = i;
+        }
+      } else if (slot_sizes[best] < size && slot_sizes[i] > slot_sizes[best]) {
+        best = i;
+      }
+    }
+    if (best < 0) {
+      best = slot_sizes.size();
+      slot_sizes.push_back(0);
+      slot_last.push_back(0);
+    }
+    slot_sizes[best] = std::max(slot_sizes[best], size);
+    slot_last[best] = interval.last;
+    slot_of[interval.index] = best;
+  }
+  for (size_t k = 0; k < trace.size(); ++k) {
+    sizes[k] = trace[k].second;
+  }
+  return std::make_unique<MemoryPlan>(
+      std::move(sizes), std::move(slot_of), slot_sizes);
+}
+
+std::shared_ptr<GraphRecord> record_graph(
+    const std::function<std::vector<array>(const std::vector<array>&)>& fun,
+    Stream s,
+    const std::vector<array>& inputs,
+    std::vector<bool> copied) {
+  eval(inputs);
+  auto& d = device(s.device);
+  d.make_current();
+  auto& encoder = d.get_command_encoder(s);
+  auto record = std::make_shared<GraphRecord>(GraphRecord{nullptr, s, inputs});
+  record->copied = std::move(copied);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    if (record->copied[i]) {
+      auto& in = inputs[i];
+      array buf(allocator::malloc(in.nbytes()), in.shape(), in.dtype());
+      copy_gpu_inplace(in, buf, copy_type(in), s);
+      encoder.add_temporary(in);
+      record->inputs[i] = std::move(buf);
+    }
+  }
+
+  // The inputs are held by the record so they are not donated to the
+  // outputs, which would change them at each call. The buffers used by the
+  // graph are held too, so nothing is donated while recording and the
+  // buffers are reused by planning them instead.
+  auto& alloc = allocator();
+  auto run = [&](AllocationTrace* trace, MemoryPlan* plan) {
+    auto outputs = fun(record->inputs);
+    encoder.begin_recording();
+    alloc.set_trace(trace);
+    alloc.set_plan(plan);
+    try {
+      eval(outputs);
+    } catch (...) {
+      alloc.set_trace(nullptr);
+      alloc.set_plan(nullptr);
+      encoder.end_recording();
+      throw;
+    }
+    alloc.set_trace(nullptr);
+    alloc.set_plan(nullptr);
+    record->recording = encoder.end_recording();
+    record->outputs = std::move(outputs);
+  };
+
+  // The first recording traces the allocations and the nodes using them,
+  // the second serves the allocations from the planned arena.
+  AllocationTrace trace;
+  run(&trace, nullptr);
+  auto plan = plan_memory(trace, *record->recording, record->outputs);
+  if (plan->arena_size() > 0) {
+    record->recording.reset();
+    record->outputs.clear();
+    run(nullptr, plan.get());
+    record->plan = std::move(plan);
+  }
+  return record;
+}
+
+} // namespace
+
+std::function<std::vector<array>(const std::vector<array>&)> graph_function(
+    std::function<std::vector<array>(const std::vector<array>&)> fun) {
+  using Records = std::map<std::vector<int64_t>, std::shared_ptr<GraphRecord>>;
+  return [fun = std::move(fun), records = std::make_shared<Records>()](
+             const std::vector<array>& inputs) {
+    auto s = default_stream(default_device());
+    if (s.device != mlx::core::Device::gpu ||
+        std::any_of(inputs.begin(), inputs.end(), [](auto& in) {
+          return in.is_tracer();
+        })) {
+      return fun(inputs);
+    }
+
+    std::vector<int64_t> key = {s.index};
+    for (auto& in : inputs) {
+      key.push_back(static_cast<int64_t>(in.dtype().val()));
+      key.push_back(in.ndim());
+      key.insert(key.end(), in.shape().begin(), in.shape().end());
+    }
+    auto& record = (*records)[key];
+    std::vector<bool> copied(inputs.size());
+    if (record) {
+      bool recorded = true;
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        copied[i] = record->copied[i] ||
+            !same_array(inputs[i], record->inputs[i]);
+        recorded &= copied[i] == record->copied[i];
+      }
+      if (recorded) {
+        return replay(record, inputs, true);
+      }
+    } else {
+      // The inputs not computed yet are usually new at each call.
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        copied[i] = inputs[i].status() == array::Status::unscheduled;
+      }
+    }
+    record = record_graph(fun, s, inputs, std::move(copied));
+    // The outputs of the record are copied now, as the next calls overwrite
+    // them.
+    auto outputs = replay(record, inputs, false);
+    eval(outputs);
+    return outputs;
+  };
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,327 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/common/hadamard.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int hadamard_max_radix = 16;
+constexpr int hadamard_max_n = 8192;
+
+// The rows of a block, so that it has at least 256 threads.
+__host__ __device__ constexpr int hadamard_rows_per_block(int threads) {
+  return threads < 256 ? 256 / threads : 1;
+}
+
+// The signs of a Hadamard matrix of size M, the bit c of the row r is set
+// when the entry (r, c) is negative.
+struct HadamardSigns {
+  uint32_t rows[28];
+};
+
+// In register Hadamard transform of the R values of a thread.
+template <int R>
+__device__ __forceinline__ void radix_func(float* x) {
+#pragma unroll
+  for (int h = 1; h < R; h <<= 1) {
+#pragma unroll
+    for (int i = 0; i < R / 2; i++) {
+      int k = i & (h - 1);
+      int j = ((i - k) << 1) + k;
+      float a = x[j];
+      float b = x[j + h];
+      x[j] = a + b;
+      x[j + h] = a - b;
+    }
+  }
+}
+
+// Hadamard transform of the rows of N = 2^k elements spaced by |stride|.
+//
+// Each row is handled by T = N / R threads and the thread t holds the
+// elements r * T + t. As the butterflies of the bits of the index commute,
+// the bits of r are transformed in registers, the bits of t which are in
+// the lane with warp shuffles, and the bits of t which are in the warp by
+// going once through shared memory.
+template <typename T, int N, int R>
+__global__ void
+hadamard_n(const T* in, T* out, float scale, int64_t num_rows, int64_t stride) {
+  constexpr int THREADS = N / R;
+  constexpr int LANES = THREADS < WARP_SIZE ? THREADS : WARP_SIZE;
+  constexpr int WARPS = THREADS / LANES;
+  constexpr int ROWS = hadamard_rows_per_block(THREADS);
+  static_assert(WARPS <= R, "The warps of a row do not fit in registers.");
+
+  auto block = cg::this_thread_block();
+  int t = block.thread_index().x;
+  int64_t row = int64_t(block.group_index().x) * ROWS + block.thread_index().y;
+  // The rows past the end still take part in the shuffles.
+  bool valid = row < num_rows;
+  int64_t offset = (row / stride) * N * stride + row % stride;
+
+  float x[R];
+#pragma unroll
+  for (int r = 0; r < R; r++) {
+    x[r] = valid ? static_cast<float>(in[offset + (r * THREADS + t) * stride])
+                 : 0.0f;
+  }
+
+  radix_func<R>(x);
+
+#pragma unroll
+  for (int h = 1; h < LANES; h <<= 1) {
+    bool upper = t & h;
+#pragma unroll
+    for (int r = 0; r < R; r++) {
+      float y = __shfl_xor_sync(0xffffffff, x[r], h);
+      x[r] = upper ? y - x[r] : x[r] + y;
+    }
+  }
+
+  if constexpr (WARPS > 1) {
+    __shared__ float buf[ROWS][N];
+    float* row_buf = buf[block.thread_index().y];
+#pragma unroll
+    for (int r = 0; r < R; r++) {
+      row_buf[r * THREADS + t] = x[r];
+    }
+    block.sync();
+
+    // A thread takes the WARPS elements which only differ in the warp.
+    int lane = t % WARP_SIZE;
+    int warp = t / WARP_SIZE;
+#pragma unroll
+    for (int q = 0; q < R / WARPS; q++) {
+      float* w_buf = row_buf + (q * WARPS + warp) * THREADS + lane;
+      float y[WARPS];
+#pragma unroll
+      for (int w = 0; w < WARPS; w++) {
+        y[w] = w_buf[w * WARP_SIZE];
+      }
+      radix_func<WARPS>(y);
+#pragma unroll
+      for (int w = 0; w < WARPS; w++) {
+        w_buf[w * WARP_SIZE] = y[w];
+      }
+    }
+    block.sync();
+
+#pragma unroll
+    for (int r = 0; r < R; r++) {
+      x[r] = row_buf[r * THREADS + t];
+    }
+  }
+
+  if (valid) {
+#pragma unroll
+    for (int r = 0; r < R; r++) {
+      out[offset + (r * THREADS + t) * stride] = static_cast<T>(x[r] * scale);
+    }
+  }
+}
+
+// Hadamard transform of size M of the elements spaced by N, with a naive
+// O(M^2) product. This is the last stage of a transform of size M * N.
+template <typename T, int M>
+__global__ void hadamard_m(
+    const T* in,
+    T* out,
+    float scale,
+    int64_t size,
+    int64_t n,
+    const __grid_constant__ HadamardSigns signs) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index >= size) {
+    return;
+  }
+  int64_t offset = (index / n) * M * n + index % n;
+
+  float x[M];
+#pragma unroll
+  for (int c = 0; c < M; c++) {
+    x[c] = static_cast<float>(in[offset + c * n]);
+  }
+#pragma unroll
+  for (int r = 0; r < M; r++) {
+    float y = 0;
+#pragma unroll
+    for (int c = 0; c < M; c++) {
+      y += ((signs.rows[r] >> c) & 1) ? -x[c] : x[c];
+    }
+    out[offset + r * n] = static_cast<T>(y * scale);
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+template <int N = 2, typename F>
+void dispatch_hadamard_n(int n, F&& f) {
+  if constexpr (N <= cu::hadamard_max_n) {
+    if (n == N) {
+      f(std::integral_constant<int, N>{});
+    } else {
+      dispatch_hadamard_n<N * 2>(n, std::forward<F>(f));
+    }
+  }
+}
+
+template <typename F>
+void dispatch_hadamard_m(int m, F&& f) {
+  switch (m) {
+    case 12:
+      f(std::integral_constant<int, 12>{});
+      break;
+    case 20:
+      f(std::integral_constant<int, 20>{});
+      break;
+    case 28:
+      f(std::integral_constant<int, 28>{});
+      break;
+  }
+}
+
+cu::HadamardSigns hadamard_signs(int m) {
+  auto h_matrices = hadamard_matrices();
+  auto& matrix = h_matrices[m];
+  cu::HadamardSigns signs = {};
+  auto start = 1;
+  auto end = matrix.find('\n', start);
+  for (int r = 0; end != std::string_view::npos; r++) {
+    for (int c = 0; c < end - start; c++) {
+      if (matrix[start + c] == '-') {
+        signs.rows[r] |= 1u << c;
+      }
+    }
+    start = end + 1;
+    end = matrix.find('\n', start);
+  }
+  return signs;
+}
+
+void hadamard_n(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    int n,
+    int64_t stride,
+    float scale) {
+  int64_t num_rows = in.size() / n;
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "hadamard", [&](auto type_tag) {
+    dispatch_hadamard_n(n, [&](auto n_constant) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      constexpr int N = n_constant();
+      constexpr int R = std::min(N, cu::hadamard_max_radix);
+      constexpr int rows = cu::hadamard_rows_per_block(N / R);
+      encoder.add_kernel_node(
+          cu::hadamard_n<DataType, N, R>,
+          cuda::ceil_div(num_rows, rows),
+          dim3(N / R, rows),
+          in.data<DataType>(),
+          out.data<DataType>(),
+          scale,
+          num_rows,
+          stride);
+    });
+  });
+}
+
+void hadamard_m(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    int m,
+    int64_t n,
+    float scale) {
+  int64_t size = in.size() / m;
+  auto signs = hadamard_signs(m);
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "hadamard", [&](auto type_tag) {
+    dispatch_hadamard_m(m, [&](auto m_constant) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      constexpr int block_dim = 256;
+      encoder.add_kernel_node(
+          cu::hadamard_m<DataType, m_constant()>,
+          cuda::ceil_div(size, block_dim),
+          block_dim,
+          in.data<DataType>(),
+          out.data<DataType>(),
+          scale,
+          size,
+          n,
+          signs);
+    });
+  });
+}
+
+void hadamard_mn_contiguous(
+    cu::CommandEncoder& encoder,
+    const array& x,
+    array& y,
+    int m,
+    int n1,
+    int n2,
+    float scale) {
+  // n1 is a strided power of 2 transform with stride n2, n2 is a row
+  // contiguous power of 2 transform and m is a strided transform with stride
+  // n = n1 * n2.
+  if (n1 > 1) {
+    hadamard_n(encoder, x, y, n1, n2, 1.0f);
+  }
+  hadamard_n(encoder, n1 > 1 ? y : x, y, n2, 1, m == 1 ? scale : 1.0f);
+  if (m > 1) {
+    hadamard_m(encoder, y, y, m, n1 * n2, scale);
+  }
+}
+
+} // namespace
+
+void Hadamard::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Hadamard::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+  auto& in = inputs[0];
+
+  // Split the hadamard transform so that all of them work on vectors of at
+  // most 8192 elements:
+  //
+  // n = m * n1 * n2 = m * 2^k1 * 2^k2
+  //
+  // where m is in (1, 12, 20, 28) and n1 and n2 <= 8192
+  auto [n, m] = decompose_hadamard(in.shape().back());
+  int n1 = 1, n2 = n;
+  if (n > cu::hadamard_max_n) {
+    for (n2 = 2; n2 * n2 < n; n2 *= 2) {
+    }
+    n1 = n / n2;
+  }
+
+  if (in.flags().row_contiguous) {
+    if (in.is_donatable()) {
+      out.copy_shared_buffer(in);
+    } else {
+      out.set_data(allocator::malloc(out.nbytes()));
+    }
+    hadamard_mn_contiguous(encoder, in, out, m, n1, n2, scale_);
+  } else {
+    copy_gpu(in, out, CopyType::General, s);
+    hadamard_mn_contiguous(encoder, out, out, m, n1, n2, scale_);
+  }
+}
+
+} // namespace mlx::core
@@ -2,8 +2,10 @@
 
 #include "mlx/backend/common/compiled.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/gather_rows.h"
 #include "mlx/backend/cuda/jit_module.h"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/sorted_scatter.h"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/primitives.h"
@@ -64,6 +66,14 @@ void Gather::eval_gpu(const std::vector<array>& inputs, array& out) {
     return;
   }
 
+  auto& s = stream();
+
+  // Copy whole rows without computing the location of each element.
+  if (use_gather_rows(src, axes_, slice_sizes_)) {
+    gather_rows(src, inputs[1], out, cu::get_command_encoder(s));
+    return;
+  }
+
   int nidx = inputs.size() - 1;
   Dtype idx_dtype = nidx > 0 ? inputs[1].dtype() : int32;
   int32_t idx_ndim = nidx > 0 ? inputs[1].ndim() : 0;
@@ -80,7 +90,6 @@ void Gather::eval_gpu(const std::vector<array>& inputs, array& out) {
       dtype_to_string(idx_dtype),
       nidx);
 
-  auto& s = stream();
   cu::JitModule& mod = cu::get_jit_module(s.device, module_name, [&]() {
     std::vector<std::string> kernel_names;
     for (int ndim = 0; ndim <= MAX_NDIM; ++ndim) {
@@ -157,6 +166,16 @@ void Scatter::eval_gpu(const std::vector<array>& inputs, array& out) {
   Dtype idx_dtype = nidx > 0 ? inputs[1].dtype() : int32;
   int32_t idx_ndim = nidx > 0 ? inputs[1].ndim() : 0;
 
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  // Sum the updates of the repeated indices before writing them.
+  if (reduce_type_ == Scatter::Sum && nidx == 1 &&
+      use_sorted_scatter_sum(upd, out, inputs[1].size())) {
+    sorted_scatter_sum(upd, inputs[1], out, axes_[0], encoder);
+    return;
+  }
+
   bool large = (nidx > 0 && inputs[1].size() > INT32_MAX) ||
       (upd.size() > INT32_MAX) || (out.size() > INT32_MAX);
 
@@ -174,7 +193,6 @@ void Scatter::eval_gpu(const std::vector<array>& inputs, array& out) {
       op,
       nidx);
 
-  auto& s = stream();
   cu::JitModule& mod = cu::get_jit_module(s.device, module_name, [&]() {
     std::vector<std::string> kernel_names;
     for (int ndim = 0; ndim <= MAX_NDIM; ++ndim) {
@@ -223,7 +241,6 @@ void Scatter::eval_gpu(const std::vector<array>& inputs, array& out) {
       idx_ndim,
       large ? "int64_t" : "int32_t");
 
-  auto& encoder = cu::get_command_encoder(s);
   for (const auto& in : inputs) {
     encoder.set_input_array(in);
   }
@@ -344,6 +361,16 @@ void ScatterAxis::eval_gpu(const std::vector<array>& inputs, array& out) {
     return;
   }
 
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  // Sum the updates of the repeated locations before writing them.
+  if (reduce_type_ == ScatterAxis::Sum &&
+      use_sorted_scatter_sum(upd, out, idx.size())) {
+    sorted_scatter_axis_sum(upd, idx, out, axis_, encoder);
+    return;
+  }
+
   bool large = idx.size() > INT32_MAX || src.size() > INT32_MAX;
 
   const char* op = reduce_type_ == ScatterAxis::Sum ? "Sum" : "Assign";
@@ -353,7 +380,6 @@ void ScatterAxis::eval_gpu(const std::vector<array>& inputs, array& out) {
       dtype_to_string(idx.dtype()),
       op);
 
-  auto& s = stream();
   cu::JitModule& mod = cu::get_jit_module(s.device, module_name, [&]() {
     std::vector<std::string> kernel_names;
     for (int ndim = 0; ndim <= MAX_NDIM; ++ndim) {
@@ -415,7 +441,6 @@ void ScatterAxis::eval_gpu(const std::vector<array>& inputs, array& out) {
       idx.flags().row_contiguous,
       large ? "int64_t" : "int32_t");
 
-  auto& encoder = cu::get_command_encoder(s);
   for (const auto& in : inputs) {
     encoder.set_input_array(in);
   }
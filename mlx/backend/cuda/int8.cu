@@ -0,0 +1,117 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
+#include "mlx/backend/cuda/int8.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int int8_block_dim = 256;
+
+// Each block quantizes a row of x with the maximum of its abs(x).
+template <typename T>
+__global__ void
+int8_quantize_rows(const T* x, int8_t* x_q, float* x_scales, int cols) {
+  __shared__ float smem[int8_block_dim / WARP_SIZE];
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+
+  size_t row = block.group_index().x;
+  x += row * cols;
+  x_q += row * cols;
+
+  float amax[1] = {0};
+  for (int i = block.thread_rank(); i < cols; i += int8_block_dim) {
+    amax[0] = fmaxf(amax[0], fabsf(static_cast<float>(x[i])));
+  }
+  // Every warp ends with the reduced value.
+  block_reduce(block, warp, amax, smem, cg::greater<float>{}, 0.0f);
+  float scale = fmaxf(amax[0], 1e-12f) / 127.0f;
+  if (block.thread_rank() == 0) {
+    x_scales[row] = scale;
+  }
+  for (int i = block.thread_rank(); i < cols; i += int8_block_dim) {
+    float q = rintf(static_cast<float>(x[i]) / scale);
+    x_q[i] = static_cast<int8_t>(fminf(fmaxf(q, -127.0f), 127.0f));
+  }
+}
+
+template <typename T>
+__global__ void int8_dequantize(
+    const int32_t* acc,
+    const float* x_scales,
+    const float* w_scales,
+    T* out,
+    size_t size,
+    int cols,
+    bool per_tensor) {
+  size_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    float scale = x_scales[i / cols] * w_scales[per_tensor ? 0 : i % cols];
+    out[i] = static_cast<T>(static_cast<float>(acc[i]) * scale);
+  }
+}
+
+} // namespace cu
+
+void int8_quantize_rows(
+    const array& x,
+    array& x_q,
+    array& x_scales,
+    cu::CommandEncoder& encoder) {
+  int cols = x.shape(-1);
+  int rows = x.size() / cols;
+  encoder.set_input_array(x);
+  encoder.set_output_array(x_q);
+  encoder.set_output_array(x_scales);
+  dispatch_float_types(x.dtype(), "int8_quantize_rows", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::int8_quantize_rows<DataType>,
+        rows,
+        cu::int8_block_dim,
+        x.data<DataType>(),
+        x_q.data<int8_t>(),
+        x_scales.data<float>(),
+        cols);
+  });
+}
+
+void int8_dequantize(
+    const array& acc,
+    const array& x_scales,
+    const array& w_scales,
+    array& out,
+    cu::CommandEncoder& encoder) {
+  size_t size = out.size();
+  int cols = out.shape(-1);
+  encoder.set_input_array(acc);
+  encoder.set_input_array(x_scales);
+  encoder.set_input_array(w_scales);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "int8_dequantize", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::int8_dequantize<DataType>,
+        cuda::ceil_div(size, cu::int8_block_dim),
+        cu::int8_block_dim,
+        acc.data<int32_t>(),
+        x_scales.data<float>(),
+        w_scales.data<float>(),
+        out.data<DataType>(),
+        size,
+        cols,
+        w_scales.size() == 1);
+  });
+}
+
+} // namespace mlx::core
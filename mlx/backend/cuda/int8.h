@@ -0,0 +1,32 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// Quantize the rows of the row contiguous |x| to the int8 values |x_q| with
+// the per-row scales |x_scales| = max(abs(row)) / 127, so that
+// x ~ x_q * x_scales.
+void int8_quantize_rows(
+    const array& x,
+    array& x_q,
+    array& x_scales,
+    cu::CommandEncoder& encoder);
+
+// Write to |out| the int32 products |acc| of the int8 matmul multiplied by
+// the scales of its rows |x_scales| and of its columns |w_scales|, which has
+// one element per column or one for all of them.
+void int8_dequantize(
+    const array& acc,
+    const array& x_scales,
+    const array& w_scales,
+    array& out,
+    cu::CommandEncoder& encoder);
+
+} // namespace mlx::core
@@ -2,6 +2,8 @@
 
 #include "mlx/backend/cuda/jit_module.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/threadpool.h"
+#include "mlx/utils.h"
 #include "mlx/version.h"
 
 #include "cuda_jit_sources.h"
@@ -9,6 +11,8 @@
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iostream>
+#include <map>
 #include <unordered_map>
 
 #include <fmt/format.h>
@@ -17,6 +21,27 @@
 
 namespace mlx::core::cu {
 
+// Get the cache directory for storing compiled results.
+const std::filesystem::path& ptx_cache_dir() {
+  static std::filesystem::path cache = []() -> std::filesystem::path {
+    std::filesystem::path cache;
+    if (auto c = std::getenv("MLX_PTX_CACHE_DIR"); c) {
+      cache = c;
+    } else {
+      cache =
+          std::filesystem::temp_directory_path() / "mlx" / version() / "ptx";
+    }
+    if (!std::filesystem::exists(cache)) {
+      std::error_code error;
+      if (!std::filesystem::create_directories(cache, error)) {
+        return std::filesystem::path();
+      }
+    }
+    return cache;
+  }();
+  return cache;
+}
+
 namespace {
 
 #define CHECK_NVRTC_ERROR(cmd) check_nvrtc_error(#cmd, (cmd))
@@ -77,83 +102,161 @@ const std::string& cccl_dir() {
   return dir;
 }
 
-// Get the cache directory for storing compiled results.
-const std::filesystem::path& ptx_cache_dir() {
-  static std::filesystem::path cache = []() -> std::filesystem::path {
-    std::filesystem::path cache;
-    if (auto c = std::getenv("MLX_PTX_CACHE_DIR"); c) {
-      cache = c;
-    } else {
-      cache =
-          std::filesystem::temp_directory_path() / "mlx" / version() / "ptx";
+// Read the names of the kernels compiled in previous runs and their mangled
+// names in the module.
+void read_kernel_names(
+    const std::filesystem::path& cache_dir,
+    const std::string& module_name,
+    std::unordered_map<std::string, std::string>* mangled_names) {
+  if (cache_dir.empty()) {
+    return;
+  }
+  std::ifstream txt_file(cache_dir / (module_name + ".txt"), std::ios::binary);
+  std::string line;
+  while (std::getline(txt_file, line)) {
+    auto tab = line.find('\t');
+    if (tab != std::string::npos) {
+      mangled_names->emplace(line.substr(0, tab), line.substr(tab + 1));
     }
-    if (!std::filesystem::exists(cache)) {
-      std::error_code error;
-      if (!std::filesystem::create_directories(cache, error)) {
-        return std::filesystem::path();
-      }
+  }
+}
+
+// Get the cache directory of the binaries compiled for |device|, named by
+// the architecture and the NVRTC version as the binaries of one can not be
+// used with another.
+std::filesystem::path binary_cache_dir(Device& device) {
+  if (ptx_cache_dir().empty()) {
+    return std::filesystem::path();
+  }
+  int nvrtc_major, nvrtc_minor;
+  CHECK_NVRTC_ERROR(nvrtcVersion(&nvrtc_major, &nvrtc_minor));
+  std::string arch = fmt::format(
+      "sm_{}{}_nvrtc_{}.{}",
+      device.compute_capability_major(),
+      device.compute_capability_minor(),
+      nvrtc_major,
+      nvrtc_minor);
+  auto cache = ptx_cache_dir() / arch;
+  if (!std::filesystem::exists(cache)) {
+    std::error_code error;
+    if (!std::filesystem::create_directories(cache, error)) {
+      return std::filesystem::path();
     }
-    return cache;
-  }();
+  }
   return cache;
 }
 
-// Try to read the cached |ptx| and |ptx_kernels| from |cache_dir|.
+// The file name of the binary of a kernel, as the kernel names are not valid
+// file names.
+std::string binary_file_name(
+    const std::string& module_name,
+    const std::string& kernel_name) {
+  return fmt::format(
+      "{}.{:016x}.cubin", module_name, std::hash<std::string>{}(kernel_name));
+}
+
+// Try to read the cached |cubin| of |kernel_name| from |binary_dir|.
 bool read_cached_ptx(
-    const std::filesystem::path& cache_dir,
+    const std::filesystem::path& binary_dir,
     const std::string& module_name,
-    std::vector<char>* ptx,
-    std::vector<std::pair<std::string, std::string>>* ptx_kernels) {
-  if (cache_dir.empty()) {
+    const std::string& kernel_name,
+    std::vector<char>* cubin) {
+  if (binary_dir.empty()) {
     return false;
   }
 
-  auto ptx_path = cache_dir / (module_name + ".ptx");
+  auto cubin_path = binary_dir / binary_file_name(module_name, kernel_name);
   std::error_code error;
-  auto ptx_size = std::filesystem::file_size(ptx_path, error);
+  auto cubin_size = std::filesystem::file_size(cubin_path, error);
   if (error) {
     return false;
   }
-  std::ifstream ptx_file(ptx_path, std::ios::binary);
-  if (!ptx_file.good()) {
+  std::ifstream cubin_file(cubin_path, std::ios::binary);
+  if (!cubin_file.good()) {
     return false;
   }
-  ptx->resize(ptx_size);
-  ptx_file.read(ptx->data(), ptx_size);
-
-  std::ifstream txt_file(cache_dir / (module_name + ".txt"), std::ios::binary);
-  std::string line;
-  while (std::getline(txt_file, line)) {
-    auto tab = line.find('\t');
-    if (tab != std::string::npos) {
-      ptx_kernels->emplace_back(line.substr(0, tab), line.substr(tab + 1));
-    }
-  }
+  cubin->resize(cubin_size);
+  cubin_file.read(cubin->data(), cubin_size);
   return true;
 }
 
-// Write the |ptx| and |ptx_kernels| to |cache_dir| with |name|.
+// Write the |cubin| of |kernel_name| to |binary_dir|, and add its |mangled|
+// name and the |source_code| to |cache_dir| unless already written for
+// another architecture.
 void write_cached_ptx(
     const std::filesystem::path& cache_dir,
+    const std::filesystem::path& binary_dir,
     const std::string& module_name,
-    const std::vector<char>& ptx,
-    const std::vector<std::pair<std::string, std::string>>& ptx_kernels,
+    const std::string& kernel_name,
+    const std::string& mangled,
+    bool known_kernel,
+    const std::vector<char>& cubin,
     const std::string& source_code) {
-  if (cache_dir.empty()) {
+  if (cache_dir.empty() || binary_dir.empty()) {
     return;
   }
 
-  std::ofstream ptx_file(cache_dir / (module_name + ".ptx"), std::ios::binary);
-  if (!ptx.empty()) {
-    ptx_file.write(&ptx.front(), ptx.size());
+  // Write to a temporary file first so other processes sharing the cache
+  // never read a partial binary.
+  auto cubin_path = binary_dir / binary_file_name(module_name, kernel_name);
+  auto tmp_path = cubin_path;
+  tmp_path += fmt::format(".{}", getpid());
+  {
+    std::ofstream cubin_file(tmp_path, std::ios::binary);
+    if (!cubin.empty()) {
+      cubin_file.write(&cubin.front(), cubin.size());
+    }
   }
-  std::ofstream txt_file(cache_dir / (module_name + ".txt"), std::ios::binary);
-  for (const auto& [name, mangled] : ptx_kernels) {
-    txt_file << name << "\t" << mangled << std::endl;
+  std::error_code error;
+  std::filesystem::rename(tmp_path, cubin_path, error);
+
+  auto source_path = cache_dir / (module_name + ".cu");
+  if (!std::filesystem::exists(source_path)) {
+    std::ofstream source_file(source_path);
+    source_file << source_code;
+  }
+  if (!known_kernel) {
+    std::ofstream txt_file(
+        cache_dir / (module_name + ".txt"), std::ios::binary | std::ios::app);
+    txt_file << kernel_name << "\t" << mangled << std::endl;
   }
+}
 
-  std::ofstream source_file(cache_dir / (module_name + ".cu"));
-  source_file << source_code;
+// Link the |ptx| into the binary of the current device, which otherwise the
+// driver would do each time the module is loaded.
+std::vector<char> link_ptx(
+    const std::string& module_name,
+    std::vector<char> ptx) {
+  CUlinkState state;
+  CHECK_CUDA_ERROR(cuLinkCreate(0, nullptr, nullptr, &state));
+  std::unique_ptr<CUlinkState_st, CUresult (*)(CUlinkState)> state_freer(
+      state, cuLinkDestroy);
+  CHECK_CUDA_ERROR(cuLinkAddData(
+      state,
+      CU_JIT_INPUT_PTX,
+      ptx.data(),
+      ptx.size(),
+      module_name.c_str(),
+      0,
+      nullptr,
+      nullptr));
+  void* cubin;
+  size_t cubin_size;
+  CHECK_CUDA_ERROR(cuLinkComplete(state, &cubin, &cubin_size));
+  auto data = static_cast<char*>(cubin);
+  return std::vector<char>(data, data + cubin_size);
+}
+
+int async_jit_threads() {
+  static int threads = env::get_var("MLX_CUDA_ASYNC_JIT", 0);
+  return threads;
+}
+
+// The threads compiling kernels in the background, which is never destroyed
+// as the tasks may still be running at exit.
+ThreadPool& jit_thread_pool() {
+  static ThreadPool* pool = new ThreadPool(async_jit_threads());
+  return *pool;
 }
 
 // Return if |device|'s version is not newer than |major|.|minor| version.
@@ -196,6 +299,7 @@ constexpr const char* g_include_names[] = {
     INCLUDE_PREFIX "complex.cuh",
     INCLUDE_PREFIX "fp16_math.cuh",
     INCLUDE_PREFIX "indexing.cuh",
+    INCLUDE_PREFIX "reduce_ops.cuh",
     INCLUDE_PREFIX "scatter_ops.cuh",
     INCLUDE_PREFIX "unary_ops.cuh",
     INCLUDE_PREFIX "ternary_ops.cuh",
@@ -212,6 +316,7 @@ constexpr const char* g_headers[] = {
     jit_source_complex,
     jit_source_fp16_math,
     jit_source_indexing,
+    jit_source_reduce_ops,
     jit_source_scatter_ops,
     jit_source_unary_ops,
     jit_source_ternary_ops,
@@ -223,36 +328,122 @@ constexpr const char* g_headers[] = {
 JitModule::JitModule(
     Device& device,
     const std::string& module_name,
-    const KernelBuilder& builder) {
+    const KernelBuilder& builder,
+    bool partial)
+    : device_(device), module_name_(module_name), partial_(partial) {
+  auto [source_code, kernel_names] = builder();
+  source_code_ = std::move(source_code);
+  kernel_names_.insert(kernel_names.begin(), kernel_names.end());
+  read_kernel_names(ptx_cache_dir(), module_name_, &mangled_names_);
+}
+
+JitModule::~JitModule() {
+  for (auto module : modules_) {
+    CHECK_CUDA_ERROR(cuModuleUnload(module));
+  }
+}
+
+void JitModule::complete(const KernelBuilder& builder) {
+  auto [source_code, kernel_names] = builder();
+  std::lock_guard compile_lock(compile_mutex_);
+  std::lock_guard lock(mutex_);
+  source_code_ = std::move(source_code);
+  kernel_names_.insert(kernel_names.begin(), kernel_names.end());
+  partial_ = false;
+}
+
+CUfunction JitModule::get_kernel(const std::string& kernel_name) {
+  if (!check_kernel_name(kernel_name)) {
+    std::lock_guard lock(mutex_);
+    return kernels_.at(kernel_name);
+  }
+  std::lock_guard compile_lock(compile_mutex_);
+  // It could have been compiled in the background meanwhile.
+  {
+    std::lock_guard lock(mutex_);
+    if (auto it = kernels_.find(kernel_name); it != kernels_.end()) {
+      return it->second;
+    }
+  }
+  CUfunction kernel = load_kernel(kernel_name);
+  std::lock_guard lock(mutex_);
+  kernels_.emplace(kernel_name, kernel);
+  pending_kernels_.erase(kernel_name);
+  return kernel;
+}
+
+CUfunction JitModule::get_kernel_async(const std::string& kernel_name) {
+  if (!check_kernel_name(kernel_name)) {
+    std::lock_guard lock(mutex_);
+    return kernels_.at(kernel_name);
+  }
+  {
+    std::lock_guard lock(mutex_);
+    if (!pending_kernels_.insert(kernel_name).second) {
+      return nullptr;
+    }
+  }
+  jit_thread_pool().enqueue([this, kernel_name]() {
+    try {
+      get_kernel(kernel_name);
+    } catch (const std::exception& e) {
+      // Leave it pending, the kernel keeps running unfused.
+      std::cerr << "[cuda] Failed to compile kernel " << kernel_name << ": "
+                << e.what() << std::endl;
+    }
+  });
+  return nullptr;
+}
+
+// Return whether the kernel still needs to be loaded, and throw if the
+// module has no such kernel.
+bool JitModule::check_kernel_name(const std::string& kernel_name) {
+  std::lock_guard lock(mutex_);
+  if (kernels_.find(kernel_name) != kernels_.end()) {
+    return false;
+  }
+  if (kernel_names_.find(kernel_name) == kernel_names_.end()) {
+    throw std::runtime_error(
+        fmt::format("There is no kernel named {}.", kernel_name));
+  }
+  return true;
+}
+
+CUfunction JitModule::load_kernel(const std::string& kernel_name) {
+  device_.make_current();
+
   // Check cache.
+  auto binary_dir = binary_cache_dir(device_);
   std::vector<char> ptx;
-  std::vector<std::pair<std::string, std::string>> ptx_kernels;
-  if (!read_cached_ptx(ptx_cache_dir(), module_name, &ptx, &ptx_kernels)) {
-    // Create program.
-    auto [source_code, kernel_names] = builder();
+  auto mangled_it = mangled_names_.find(kernel_name);
+  bool known_kernel = mangled_it != mangled_names_.end();
+  std::string mangled;
+  if (known_kernel &&
+      read_cached_ptx(binary_dir, module_name_, kernel_name, &ptx)) {
+    mangled = mangled_it->second;
+  } else {
+    // Create program, which only instantiates the requested kernel.
     nvrtcProgram prog;
     CHECK_NVRTC_ERROR(nvrtcCreateProgram(
         &prog,
-        source_code.c_str(),
-        (module_name + ".cu").c_str(),
+        source_code_.c_str(),
+        (module_name_ + ".cu").c_str(),
         std::size(g_headers),
         g_headers,
         g_include_names));
     std::unique_ptr<nvrtcProgram, void (*)(nvrtcProgram*)> prog_freer(
         &prog,
         [](nvrtcProgram* p) { CHECK_NVRTC_ERROR(nvrtcDestroyProgram(p)); });
-    for (const auto& name : kernel_names) {
-      CHECK_NVRTC_ERROR(nvrtcAddNameExpression(prog, name.c_str()));
-    }
+    CHECK_NVRTC_ERROR(nvrtcAddNameExpression(prog, kernel_name.c_str()));
 
     // Compile program.
     std::vector<const char*> args;
-    bool use_sass = compiler_supports_device_sass(device);
+    bool use_sass = compiler_supports_device_sass(device_);
     std::string compute = fmt::format(
         "--gpu-architecture={}_{}{}",
         use_sass ? "sm" : "compute",
-        device.compute_capability_major(),
-        device.compute_capability_minor());
+        device_.compute_capability_major(),
+        device_.compute_capability_minor());
     args.push_back(compute.c_str());
     std::string cccl_include = cccl_dir();
     if (!cccl_include.empty()) {
@@ -273,12 +464,11 @@ JitModule::JitModule(
           fmt::format("Failed to compile kernel: {}.", log.data()));
     }
 
-    // Get mangled names of kernel names.
-    for (const auto& name : kernel_names) {
-      const char* mangled;
-      CHECK_NVRTC_ERROR(nvrtcGetLoweredName(prog, name.c_str(), &mangled));
-      ptx_kernels.emplace_back(name, mangled);
-    }
+    // Get mangled name of the kernel.
+    const char* lowered_name;
+    CHECK_NVRTC_ERROR(
+        nvrtcGetLoweredName(prog, kernel_name.c_str(), &lowered_name));
+    mangled = lowered_name;
 
     // Get ptx data.
     size_t ptx_size;
@@ -292,9 +482,18 @@ JitModule::JitModule(
       CHECK_NVRTC_ERROR(nvrtcGetCUBIN(prog, ptx.data()));
     } else {
       CHECK_NVRTC_ERROR(nvrtcGetPTX(prog, ptx.data()));
+      ptx = link_ptx(module_name_, std::move(ptx));
     }
     write_cached_ptx(
-        ptx_cache_dir(), module_name, ptx, ptx_kernels, source_code);
+        ptx_cache_dir(),
+        binary_dir,
+        module_name_,
+        kernel_name,
+        mangled,
+        known_kernel,
+        ptx,
+        source_code_);
+    mangled_names_.emplace(kernel_name, mangled);
   }
 
   // Load module.
@@ -302,44 +501,196 @@ JitModule::JitModule(
   CUjit_option options[] = {
       CU_JIT_ERROR_LOG_BUFFER, CU_JIT_ERROR_LOG_BUFFER_SIZE_BYTES};
   void* values[] = {jit_log, reinterpret_cast<void*>(std::size(jit_log) - 1)};
+  CUmodule module;
   CUresult jit_result = cuModuleLoadDataEx(
-      &module_, ptx.data(), std::size(options), options, values);
+      &module, ptx.data(), std::size(options), options, values);
   if (jit_result != CUDA_SUCCESS) {
     throw std::runtime_error(fmt::format(
-        "Failed to load compiled {} kernel: {}.", module_name, jit_log));
+        "Failed to load compiled {} kernel: {}.", module_name_, jit_log));
   }
+  modules_.push_back(module);
 
-  // Load kernels.
-  for (const auto& [name, mangled] : ptx_kernels) {
-    CUfunction kernel;
-    CHECK_CUDA_ERROR(cuModuleGetFunction(&kernel, module_, mangled.c_str()));
-    kernels_[name] = kernel;
+  // Load kernel.
+  CUfunction kernel;
+  CHECK_CUDA_ERROR(cuModuleGetFunction(&kernel, module, mangled.c_str()));
+  return kernel;
+}
+
+std::vector<std::string> JitModule::cached_kernel_names() {
+  std::lock_guard lock(compile_mutex_);
+  std::vector<std::string> names;
+  for (const auto& [name, mangled] : mangled_names_) {
+    names.push_back(name);
   }
+  return names;
 }
 
-JitModule::~JitModule() {
-  CHECK_CUDA_ERROR(cuModuleUnload(module_));
+namespace {
+
+// The modules loaded by the process, by device index and name as they are
+// compiled for the architecture of each device.
+struct JitModules {
+  std::map<std::pair<int, std::string>, JitModule> map;
+  std::mutex mutex;
+};
+
+JitModules& jit_modules() {
+  static JitModules modules;
+  return modules;
 }
 
-CUfunction JitModule::get_kernel(const std::string& kernel_name) {
-  auto it = kernels_.find(kernel_name);
-  if (it == kernels_.end()) {
-    throw std::runtime_error(
-        fmt::format("There is no kernel named {}.", kernel_name));
+// The module of |name|, created from |builder| or completed with it when it
+// was created partial.
+JitModule& get_jit_module(
+    const mlx::core::Device& device,
+    const std::string& name,
+    const KernelBuilder& builder,
+    bool partial) {
+  auto& modules = jit_modules();
+  std::lock_guard lock(modules.mutex);
+  auto key = std::make_pair(device.index, name);
+  auto it = modules.map.find(key);
+  if (it == modules.map.end()) {
+    it = modules.map
+             .try_emplace(key, cu::device(device), name, builder, partial)
+             .first;
+  } else if (it->second.partial() && !partial) {
+    it->second.complete(builder);
   }
   return it->second;
 }
 
+} // namespace
+
 JitModule& get_jit_module(
     const mlx::core::Device& device,
     const std::string& name,
     const KernelBuilder& builder) {
-  static std::unordered_map<std::string, JitModule> map;
-  auto it = map.find(name);
-  if (it == map.end()) {
-    it = map.try_emplace(name, cu::device(device), name, builder).first;
+  return get_jit_module(device, name, builder, false);
+}
+
+std::vector<std::pair<std::string, std::string>> jit_cache_files(
+    const mlx::core::Device& device) {
+  std::vector<std::pair<std::string, std::string>> files;
+  const auto& cache_dir = ptx_cache_dir();
+  auto binary_dir = binary_cache_dir(cu::device(device));
+  if (cache_dir.empty() || binary_dir.empty()) {
+    return files;
   }
-  return it->second;
+  auto read_file = [&](const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.good()) {
+      return;
+    }
+    files.emplace_back(
+        std::filesystem::relative(path, cache_dir).generic_string(),
+        std::string(
+            (std::istreambuf_iterator<char>(file)),
+            std::istreambuf_iterator<char>()));
+  };
+  std::vector<std::string> names;
+  {
+    auto& modules = jit_modules();
+    std::lock_guard lock(modules.mutex);
+    for (const auto& [key, mod] : modules.map) {
+      if (key.first == device.index) {
+        names.push_back(key.second);
+      }
+    }
+  }
+  std::error_code error;
+  for (const auto& name : names) {
+    read_file(cache_dir / (name + ".cu"));
+    read_file(cache_dir / (name + ".txt"));
+    for (const auto& entry :
+         std::filesystem::directory_iterator(binary_dir, error)) {
+      auto file_name = entry.path().filename().string();
+      if (file_name.size() > name.size() + 1 &&
+          file_name.compare(0, name.size() + 1, name + ".") == 0 &&
+          entry.path().extension() == ".cubin") {
+        read_file(entry.path());
+      }
+    }
+  }
+  return files;
+}
+
+void add_jit_cache_files(
+    const std::vector<std::pair<std::string, std::string>>& files) {
+  const auto& cache_dir = ptx_cache_dir();
+  if (cache_dir.empty()) {
+    return;
+  }
+  for (const auto& [name, data] : files) {
+    // Only the files of the cache layout, a module file or a binary in the
+    // directory of an architecture, are written.
+    std::filesystem::path path(name);
+    bool valid = !path.empty() && path.is_relative() &&
+        std::distance(path.begin(), path.end()) <= 2;
+    for (const auto& part : path) {
+      valid &= part != ".." && part != ".";
+    }
+    if (!valid) {
+      throw std::invalid_argument(
+          fmt::format("[add_jit_cache_files] Invalid file name {}.", name));
+    }
+    auto file_path = cache_dir / path;
+    std::error_code error;
+    if (std::filesystem::exists(file_path, error)) {
+      continue;
+    }
+    std::filesystem::create_directories(file_path.parent_path(), error);
+    // Write to a temporary file first as in write_cached_ptx.
+    auto tmp_path = file_path;
+    tmp_path += fmt::format(".{}", getpid());
+    {
+      std::ofstream file(tmp_path, std::ios::binary);
+      file.write(data.data(), data.size());
+    }
+    std::filesystem::rename(tmp_path, file_path, error);
+  }
+}
+
+bool async_jit_enabled() {
+  return async_jit_threads() > 0;
+}
+
+int precompile_jit_modules(const mlx::core::Device& device) {
+  const auto& cache_dir = ptx_cache_dir();
+  if (cache_dir.empty()) {
+    return 0;
+  }
+  int count = 0;
+  std::error_code error;
+  for (const auto& entry :
+       std::filesystem::directory_iterator(cache_dir, error)) {
+    const auto& path = entry.path();
+    if (path.extension() != ".cu") {
+      continue;
+    }
+    std::unordered_map<std::string, std::string> mangled_names;
+    read_kernel_names(cache_dir, path.stem().string(), &mangled_names);
+    // The module only knows the kernels of the previous runs until the
+    // first use of the module completes it with all its kernels.
+    auto builder = [&]() {
+      std::ifstream source_file(path);
+      std::string source_code(
+          (std::istreambuf_iterator<char>(source_file)),
+          std::istreambuf_iterator<char>());
+      std::vector<std::string> kernel_names;
+      for (const auto& [name, mangled] : mangled_names) {
+        kernel_names.push_back(name);
+      }
+      return std::make_pair(std::move(source_code), std::move(kernel_names));
+    };
+    auto& mod = get_jit_module(device, path.stem().string(), builder, true);
+    // Load the kernels used by the previous runs.
+    for (const auto& name : mod.cached_kernel_names()) {
+      mod.get_kernel(name);
+    }
+    count++;
+  }
+  return count;
 }
 
 } // namespace mlx::core::cu
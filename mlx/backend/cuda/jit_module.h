@@ -8,7 +8,10 @@
 #include "mlx/backend/cuda/device/config.h"
 
 #include <deque>
+#include <filesystem>
+#include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <variant>
 
@@ -84,19 +87,54 @@ struct KernelArgs {
 
 class JitModule {
  public:
+  // A |partial| module only knows some of its kernels, such as the ones of
+  // the previous runs, until it is completed.
   JitModule(
       Device& device,
       const std::string& module_name,
-      const KernelBuilder& builder);
+      const KernelBuilder& builder,
+      bool partial = false);
   ~JitModule();
 
   JitModule(const JitModule&) = delete;
   JitModule& operator=(const JitModule&) = delete;
+
+  // Get the kernel, which is compiled on first use as only a few of the
+  // kernels of a module are usually used.
   CUfunction get_kernel(const std::string& kernel_name);
 
+  // Get the kernel if it is ready, otherwise compile it in the background
+  // and return nullptr.
+  CUfunction get_kernel_async(const std::string& kernel_name);
+
+  // The kernels compiled for the module in this and previous runs.
+  std::vector<std::string> cached_kernel_names();
+
+  bool partial() const {
+    return partial_;
+  }
+
+  // Add all the kernels of |builder| to a partial module.
+  void complete(const KernelBuilder& builder);
+
  private:
-  CUmodule module_{nullptr};
+  CUfunction load_kernel(const std::string& kernel_name);
+  bool check_kernel_name(const std::string& kernel_name);
+
+  Device& device_;
+  std::string module_name_;
+  std::string source_code_;
+  std::unordered_set<std::string> kernel_names_;
+  std::unordered_map<std::string, std::string> mangled_names_;
+  std::vector<CUmodule> modules_;
+  bool partial_;
+  // Guards the state used for compiling kernels.
+  std::mutex compile_mutex_;
+
   std::unordered_map<std::string, CUfunction> kernels_;
+  std::unordered_set<std::string> pending_kernels_;
+  // Guards the loaded and pending kernels.
+  std::mutex mutex_;
 };
 
 JitModule& get_jit_module(
@@ -104,4 +142,26 @@ JitModule& get_jit_module(
     const std::string& name,
     const KernelBuilder& builder);
 
+// The directory caching the compiled modules, given by MLX_PTX_CACHE_DIR, or
+// empty when it can not be created.
+const std::filesystem::path& ptx_cache_dir();
+
+// Whether the fused kernels are compiled in the background while their
+// primitives run unfused, enabled by setting MLX_CUDA_ASYNC_JIT to the number
+// of compiling threads.
+bool async_jit_enabled();
+
+// The files in the cache dir of the modules loaded for |device|, their
+// sources, kernel names and binaries for the device, by relative path.
+std::vector<std::pair<std::string, std::string>> jit_cache_files(
+    const mlx::core::Device& device);
+
+// Write the |files| of jit_cache_files to the cache dir unless there.
+void add_jit_cache_files(
+    const std::vector<std::pair<std::string, std::string>>& files);
+
+// Load the modules whose sources are in the cache dir, compiling those not
+// yet cached for the architecture of |device|. Returns the number of modules.
+int precompile_jit_modules(const mlx::core::Device& device);
+
 } // namespace mlx::core::cu
@@ -6,10 +6,13 @@
 
 #pragma once
 
+#include <tuple>
 #include <type_traits>
+#include <utility>
 
 #include "mlx/array.h"
 #include "mlx/backend/cuda/device/utils.cuh"
+#include "mlx/backend/cuda/launch_tuner.h"
 
 #include <cuda.h>
 #include <cuda_bf16.h>
@@ -19,6 +22,10 @@
 
 namespace mlx::core {
 
+// The largest y and z dimensions of a grid, the batches beyond it are run in
+// several launches.
+constexpr int max_grid_yz = 65535;
+
 template <typename F>
 void dispatch_1_2_3(int n, F&& f) {
   switch (n) {
@@ -134,6 +141,92 @@ inline uint max_occupancy_block_dim(T kernel) {
   return block_dim;
 }
 
+// Whether the kernel is called as kernel(ptrs..., size), as the kernels of
+// the contiguous elementwise ops.
+template <typename... Args>
+constexpr bool is_contiguous_kernel() {
+  if constexpr (sizeof...(Args) < 2) {
+    return false;
+  } else {
+    using Size =
+        std::tuple_element_t<sizeof...(Args) - 1, std::tuple<Args...>>;
+    return std::is_integral_v<Size> &&
+        (std::is_pointer_v<Args> + ...) == sizeof...(Args) - 1;
+  }
+}
+
+// Launch the contiguous |kernel| for |size| elements on the |scratch|
+// buffers, one per argument.
+template <typename... Args, size_t... I>
+inline void launch_on_scratch(
+    void (*kernel)(Args...),
+    size_t size,
+    uint num_blocks,
+    uint block_dim,
+    cudaStream_t stream,
+    void** scratch,
+    std::index_sequence<I...>) {
+  auto arg = [&](auto* tag, void* ptr) {
+    using Arg = std::remove_pointer_t<decltype(tag)>;
+    if constexpr (std::is_pointer_v<Arg>) {
+      return static_cast<Arg>(ptr);
+    } else {
+      return static_cast<Arg>(size);
+    }
+  };
+  std::tuple<Args...> args{arg(static_cast<Args*>(nullptr), scratch[I])...};
+  void* ptrs[] = {&std::get<I>(args)...};
+  cudaLaunchKernel(
+      reinterpret_cast<const void*>(kernel),
+      num_blocks,
+      block_dim,
+      ptrs,
+      0,
+      stream);
+}
+
+// Return the block size of the contiguous |kernel| picked by the launch
+// tuner for |size| elements, or |block_dim| when the tuner is disabled.
+template <typename... Args>
+inline uint tuned_block_dim(
+    void (*kernel)(Args...),
+    size_t size,
+    int work_per_thread,
+    uint block_dim) {
+  auto& tuner = cu::launch_tuner();
+  if (!tuner.enabled()) {
+    return block_dim;
+  }
+  cudaFuncAttributes attrs;
+  CHECK_CUDA_ERROR(
+      cudaFuncGetAttributes(&attrs, reinterpret_cast<const void*>(kernel)));
+  auto bytes = [&](auto* tag) -> size_t {
+    using Arg = std::remove_pointer_t<decltype(tag)>;
+    if constexpr (std::is_pointer_v<Arg>) {
+      return size * sizeof(std::remove_pointer_t<Arg>);
+    } else {
+      return 0;
+    }
+  };
+  size_t nthreads = cuda::ceil_div(size, work_per_thread);
+  return tuner.block_dim(
+      reinterpret_cast<void*>(kernel),
+      nthreads,
+      block_dim,
+      attrs.maxThreadsPerBlock,
+      {bytes(static_cast<Args*>(nullptr))...},
+      [&](uint32_t b, cudaStream_t stream, void** scratch) {
+        launch_on_scratch(
+            kernel,
+            size,
+            cuda::ceil_div(nthreads, b),
+            b,
+            stream,
+            scratch,
+            std::index_sequence_for<Args...>{});
+      });
+}
+
 // Get the num_blocks and block_dims that maximize occupancy for |kernel|,
 // assuming each thread handles |work_per_thread| elements of |arr|.
 template <typename T>
@@ -169,4 +262,27 @@ inline std::tuple<dim3, uint> get_launch_args(
       kernel, arr.size(), arr.shape(), arr.strides(), large, work_per_thread);
 }
 
+// Get the launch args of the kernel of a contiguous elementwise op writing
+// |out|, called as kernel(ptrs..., size) with the data size of |out|. With
+// MLX_CUDA_LAUNCH_AUTOTUNE=1 the block size is the fastest one timed by the
+// launch tuner rather than the one maximizing occupancy.
+template <typename... Args>
+inline std::tuple<dim3, uint> get_contiguous_launch_args(
+    void (*kernel)(Args...),
+    const array& out,
+    bool large,
+    int work_per_thread) {
+  static_assert(is_contiguous_kernel<Args...>());
+  size_t size = out.data_size();
+  auto [num_blocks, block_dim] = get_launch_args(
+      kernel, size, out.shape(), out.strides(), large, work_per_thread);
+  // The large kernels have a 2D grid, which is not tuned.
+  if (!large) {
+    block_dim = tuned_block_dim(kernel, size, work_per_thread, block_dim);
+    num_blocks.x =
+        cuda::ceil_div(cuda::ceil_div(size, work_per_thread), block_dim);
+  }
+  return std::make_tuple(num_blocks, block_dim);
+}
+
 } // namespace mlx::core
@@ -0,0 +1,168 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/l2_persistence.h"
+#include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/utils.h"
+
+#include <algorithm>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// A buffer is tagged automatically once read by the kernels of this many
+// graphs, when it is at most this fraction of the persisting L2.
+constexpr uint32_t auto_persist_reads = 4;
+constexpr size_t auto_persist_fraction = 16;
+
+} // namespace
+
+L2Persistence::L2Persistence()
+    : auto_persist_(env::get_var("MLX_CUDA_L2_AUTO_PERSIST", 0)) {
+  update_enabled();
+}
+
+L2Persistence::DeviceL2& L2Persistence::device_l2(Device& device) {
+  auto it = devices_.find(device.cuda_device());
+  if (it != devices_.end()) {
+    return it->second;
+  }
+  // Reserve the persisting L2 when the device is first used, as much as it
+  // allows unless MLX_CUDA_L2_PERSISTING_MB asks for less. The devices
+  // before sm_80 have none.
+  int max_persisting = 0;
+  int max_window = 0;
+  CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
+      &max_persisting,
+      cudaDevAttrMaxPersistingL2CacheSize,
+      device.cuda_device()));
+  CHECK_CUDA_ERROR(cudaDeviceGetAttribute(
+      &max_window, cudaDevAttrMaxAccessPolicyWindowSize, device.cuda_device()));
+  size_t size = max_persisting;
+  if (int mb = env::get_var("MLX_CUDA_L2_PERSISTING_MB", -1); mb >= 0) {
+    size = std::min(size, static_cast<size_t>(mb) << 20);
+  }
+  if (max_window <= 0) {
+    size = 0;
+  }
+  if (size > 0) {
+    device.make_current();
+    CHECK_CUDA_ERROR(cudaDeviceSetLimit(cudaLimitPersistingL2CacheSize, size));
+  }
+  DeviceL2 l2{size, static_cast<size_t>(std::max(max_window, 0))};
+  return devices_.emplace(device.cuda_device(), l2).first->second;
+}
+
+void L2Persistence::tag(CudaBuffer* buf) {
+  if (!buf->l2_persisting) {
+    buf->l2_persisting = true;
+    persisting_bytes_ += buf->size;
+  }
+}
+
+void L2Persistence::untag(CudaBuffer* buf) {
+  if (buf->l2_persisting) {
+    buf->l2_persisting = false;
+    persisting_bytes_ -= buf->size;
+  }
+}
+
+void L2Persistence::update_enabled() {
+  enabled_ = auto_persist_ || persisting_bytes_ > 0;
+}
+
+void L2Persistence::set_persisting(
+    Device& device,
+    CudaBuffer* buf,
+    bool persisting) {
+  std::lock_guard lock(mutex_);
+  auto& l2 = device_l2(device);
+  if (persisting) {
+    tag(buf);
+  } else {
+    untag(buf);
+    // The lines of the untagged buffers would otherwise keep the persisting
+    // L2 until they are replaced.
+    if (persisting_bytes_ == 0 && l2.persisting_size > 0) {
+      device.make_current();
+      CHECK_CUDA_ERROR(cudaCtxResetPersistingL2Cache());
+    }
+  }
+  update_enabled();
+}
+
+void L2Persistence::on_free(CudaBuffer* buf) {
+  std::lock_guard lock(mutex_);
+  untag(buf);
+  buf->l2_reads = 0;
+  buf->l2_commit = 0;
+  update_enabled();
+}
+
+void L2Persistence::on_input(Device& device, CudaBuffer* buf, uint64_t commit) {
+  if (!auto_persist_ || buf->l2_persisting || buf->l2_commit == commit) {
+    return;
+  }
+  buf->l2_commit = commit;
+  if (++buf->l2_reads < auto_persist_reads) {
+    return;
+  }
+  std::lock_guard lock(mutex_);
+  auto& l2 = device_l2(device);
+  if (buf->size <= l2.persisting_size / auto_persist_fraction &&
+      persisting_bytes_ + buf->size <= l2.persisting_size) {
+    tag(buf);
+  }
+}
+
+bool L2Persistence::set_window(
+    Device& device,
+    cudaGraphNode_t node,
+    const std::vector<std::uintptr_t>& inputs) {
+  // Only one window can be set on a kernel, it covers the largest tagged
+  // buffer which benefits the most.
+  CudaBuffer* window_buf = nullptr;
+  for (auto id : inputs) {
+    auto* buf = reinterpret_cast<CudaBuffer*>(id);
+    if (buf->l2_persisting && (!window_buf || buf->size > window_buf->size)) {
+      window_buf = buf;
+    }
+  }
+  if (!window_buf) {
+    return false;
+  }
+  size_t persisting_size;
+  size_t max_window_size;
+  {
+    std::lock_guard lock(mutex_);
+    auto& l2 = device_l2(device);
+    persisting_size = l2.persisting_size;
+    max_window_size = l2.max_window_size;
+  }
+  if (persisting_size == 0) {
+    return false;
+  }
+  // The tagged buffers share the persisting L2, the part of the window
+  // beyond its share is read as streaming so it does not thrash it.
+  size_t bytes = std::max(persisting_bytes_.load(), size_t(1));
+  cudaKernelNodeAttrValue value = {};
+  auto& window = value.accessPolicyWindow;
+  window.base_ptr = window_buf->data;
+  window.num_bytes = std::min(window_buf->size, max_window_size);
+  window.hitRatio = std::min(1.0f, static_cast<float>(persisting_size) / bytes);
+  window.hitProp = cudaAccessPropertyPersisting;
+  window.missProp = cudaAccessPropertyStreaming;
+  CHECK_CUDA_ERROR(cudaGraphKernelNodeSetAttribute(
+      node, cudaKernelNodeAttributeAccessPolicyWindow, &value));
+  return true;
+}
+
+L2Persistence& l2_persistence() {
+  // Leaked on exit like the allocator, which frees the tagged buffers.
+  static L2Persistence* l2_persistence_ = new L2Persistence;
+  return *l2_persistence_;
+}
+
+} // namespace mlx::core::cu
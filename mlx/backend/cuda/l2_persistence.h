@@ -0,0 +1,80 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mlx::core::cu {
+
+class Device;
+struct CudaBuffer;
+
+// Keeps the tagged buffers, such as the small weights and the recent pages
+// of a KV cache read at every step of a decode, in the persisting part of
+// the L2 cache so the streaming reads of the large weights do not evict
+// them. The kernel nodes reading a tagged buffer get an access policy
+// window over it, whose hit ratio shares the persisting L2 between the
+// tagged bytes.
+//
+// With MLX_CUDA_L2_AUTO_PERSIST=1 the small buffers read by the kernels of
+// several graphs are also tagged, while they fit in the persisting L2.
+class L2Persistence {
+ public:
+  L2Persistence();
+
+  L2Persistence(const L2Persistence&) = delete;
+  L2Persistence& operator=(const L2Persistence&) = delete;
+
+  // Whether a buffer is tagged or may be tagged automatically.
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Tag or untag |buf|. Untagging the last buffer resets the persisting
+  // lines of the L2 of |device|.
+  void set_persisting(Device& device, CudaBuffer* buf, bool persisting);
+
+  // Called when |buf| is freed.
+  void on_free(CudaBuffer* buf);
+
+  // Called when a kernel of the |commit|-th graph of an encoder of |device|
+  // reads |buf|.
+  void on_input(Device& device, CudaBuffer* buf, uint64_t commit);
+
+  // Set the access policy window of the kernel |node| of |device| to the
+  // largest tagged buffer of |inputs|, and return whether there was one.
+  bool set_window(
+      Device& device,
+      cudaGraphNode_t node,
+      const std::vector<std::uintptr_t>& inputs);
+
+ private:
+  // The persisting L2 reserved on a device, 0 when it has none, and the
+  // largest window.
+  struct DeviceL2 {
+    size_t persisting_size;
+    size_t max_window_size;
+  };
+
+  DeviceL2& device_l2(Device& device);
+  void tag(CudaBuffer* buf);
+  void untag(CudaBuffer* buf);
+  void update_enabled();
+
+  bool auto_persist_;
+  std::atomic<bool> enabled_{false};
+  std::mutex mutex_;
+  std::unordered_map<int, DeviceL2> devices_;
+  // The bytes of the tagged buffers.
+  std::atomic<size_t> persisting_bytes_{0};
+};
+
+L2Persistence& l2_persistence();
+
+} // namespace mlx::core::cu
@@ -0,0 +1,172 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/launch_tuner.h"
+#include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/jit_module.h"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/utils.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// The kernels launched with fewer threads are too short for the block size
+// to matter, they keep the default one.
+constexpr size_t min_tuned_threads = 1 << 16;
+
+constexpr uint32_t candidate_block_dims[] = {128, 256, 512, 1024};
+
+} // namespace
+
+LaunchTuner::LaunchTuner()
+    : enabled_(env::get_var("MLX_CUDA_LAUNCH_AUTOTUNE", 0)) {}
+
+std::filesystem::path LaunchTuner::tuned_file(int device) {
+  auto& dir = ptx_cache_dir();
+  if (dir.empty()) {
+    return std::filesystem::path();
+  }
+  auto& d = cu::device(mlx::core::Device(mlx::core::Device::gpu, device));
+  return dir /
+      fmt::format("sm_{}{}_launch.txt",
+                  d.compute_capability_major(),
+                  d.compute_capability_minor());
+}
+
+LaunchTuner::Tuned& LaunchTuner::tuned(int device) {
+  auto [it, inserted] = devices_.try_emplace(device);
+  if (inserted) {
+    // Each line has the kernel name, the size bucket and the block size.
+    std::ifstream f(tuned_file(device));
+    std::string name;
+    int bucket;
+    uint32_t block_dim;
+    while (f >> name >> bucket >> block_dim) {
+      it->second[fmt::format("{} {}", name, bucket)] = block_dim;
+    }
+  }
+  return it->second;
+}
+
+const std::string& LaunchTuner::kernel_name(void* kernel) {
+  auto [it, inserted] = names_.try_emplace(kernel);
+  if (inserted) {
+#if CUDART_VERSION >= 12030
+    const char* name;
+    if (cudaFuncGetName(&name, kernel) == cudaSuccess) {
+      it->second = name;
+    }
+#endif
+  }
+  return it->second;
+}
+
+uint32_t LaunchTuner::block_dim(
+    void* kernel,
+    size_t nthreads,
+    uint32_t default_block_dim,
+    uint32_t max_block_dim,
+    const std::vector<size_t>& scratch_bytes,
+    const Launch& launch) {
+  if (!enabled_ || nthreads < min_tuned_threads) {
+    return default_block_dim;
+  }
+  std::vector<uint32_t> candidates;
+  for (auto b : candidate_block_dims) {
+    if (b <= max_block_dim && b != default_block_dim) {
+      candidates.push_back(b);
+    }
+  }
+  candidates.push_back(default_block_dim);
+  if (candidates.size() == 1) {
+    return default_block_dim;
+  }
+
+  int device;
+  CHECK_CUDA_ERROR(cudaGetDevice(&device));
+  std::lock_guard lock(mutex_);
+  // The sizes are bucketed by powers of 2. Without the name of the kernel,
+  // before CUDA 12.3, the block sizes are only kept for the process.
+  int bucket = 0;
+  while ((size_t(1) << bucket) < nthreads) {
+    ++bucket;
+  }
+  auto& name = kernel_name(kernel);
+  auto key = name.empty() ? fmt::format("{} {}", fmt::ptr(kernel), bucket)
+                          : fmt::format("{} {}", name, bucket);
+  auto& tuned_dims = tuned(device);
+  if (auto it = tuned_dims.find(key); it != tuned_dims.end()) {
+    return std::min(it->second, max_block_dim);
+  }
+  auto block_dim = benchmark(device, candidates, scratch_bytes, launch);
+  tuned_dims[key] = block_dim;
+  if (auto path = tuned_file(device); !path.empty() && !name.empty()) {
+    std::ofstream(path, std::ios::app) << key << " " << block_dim << "\n";
+  }
+  return block_dim;
+}
+
+uint32_t LaunchTuner::benchmark(
+    int device,
+    const std::vector<uint32_t>& candidates,
+    const std::vector<size_t>& scratch_bytes,
+    const Launch& launch) {
+  constexpr int iterations = 5;
+  std::vector<allocator::Buffer> buffers;
+  std::vector<void*> scratch;
+  for (auto nbytes : scratch_bytes) {
+    buffers.push_back(allocator::malloc(std::max<size_t>(nbytes, 1)));
+    scratch.push_back(buffers.back().raw_ptr());
+  }
+
+  auto& d = cu::device(mlx::core::Device(mlx::core::Device::gpu, device));
+  CudaStream stream(d);
+  cudaEvent_t start, end;
+  CHECK_CUDA_ERROR(cudaEventCreate(&start));
+  CHECK_CUDA_ERROR(cudaEventCreate(&end));
+  for (size_t i = 0; i < scratch.size(); ++i) {
+    CHECK_CUDA_ERROR(cudaMemsetAsync(scratch[i], 0, scratch_bytes[i], stream));
+  }
+  uint32_t best = candidates.back();
+  float best_ms = std::numeric_limits<float>::infinity();
+  for (auto block_dim : candidates) {
+    // Warm up, and skip the block sizes failing to launch.
+    launch(block_dim, stream, scratch.data());
+    if (cudaGetLastError() != cudaSuccess) {
+      continue;
+    }
+    CHECK_CUDA_ERROR(cudaEventRecord(start, stream));
+    for (int j = 0; j < iterations; ++j) {
+      launch(block_dim, stream, scratch.data());
+    }
+    CHECK_CUDA_ERROR(cudaEventRecord(end, stream));
+    CHECK_CUDA_ERROR(cudaEventSynchronize(end));
+    float ms;
+    CHECK_CUDA_ERROR(cudaEventElapsedTime(&ms, start, end));
+    if (ms < best_ms) {
+      best_ms = ms;
+      best = block_dim;
+    }
+  }
+  CHECK_CUDA_ERROR(cudaStreamSynchronize(stream));
+  CHECK_CUDA_ERROR(cudaEventDestroy(start));
+  CHECK_CUDA_ERROR(cudaEventDestroy(end));
+  for (auto& buffer : buffers) {
+    allocator::free(buffer);
+  }
+  return best;
+}
+
+LaunchTuner& launch_tuner() {
+  static LaunchTuner launch_tuner_;
+  return launch_tuner_;
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,71 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mlx::core::cu {
+
+// Picks the block size of the elementwise kernels by timing the candidates
+// on the first launch of a kernel in a bucket of sizes, as the block size
+// maximizing the occupancy is not always the fastest for the memory bound
+// kernels. Enabled with MLX_CUDA_LAUNCH_AUTOTUNE=1, the picked sizes are
+// kept next to the PTX cache for the next runs.
+class LaunchTuner {
+ public:
+  // Launch the kernel being tuned on |stream| with |block_dim| threads per
+  // block, on the |scratch| buffers.
+  using Launch = std::function<
+      void(uint32_t block_dim, cudaStream_t stream, void** scratch)>;
+
+  LaunchTuner();
+
+  LaunchTuner(const LaunchTuner&) = delete;
+  LaunchTuner& operator=(const LaunchTuner&) = delete;
+
+  bool enabled() const {
+    return enabled_;
+  }
+
+  // Return the fastest block size of |kernel| for |nthreads| threads, up to
+  // |max_block_dim|, or |default_block_dim| when there is nothing to tune.
+  // The candidates are timed by |launch| on scratch buffers of
+  // |scratch_bytes| as the inputs may not have been computed yet.
+  uint32_t block_dim(
+      void* kernel,
+      size_t nthreads,
+      uint32_t default_block_dim,
+      uint32_t max_block_dim,
+      const std::vector<size_t>& scratch_bytes,
+      const Launch& launch);
+
+ private:
+  // The tuned block sizes of a device by kernel name and size bucket.
+  using Tuned = std::unordered_map<std::string, uint32_t>;
+
+  Tuned& tuned(int device);
+  std::filesystem::path tuned_file(int device);
+  const std::string& kernel_name(void* kernel);
+  uint32_t benchmark(
+      int device,
+      const std::vector<uint32_t>& candidates,
+      const std::vector<size_t>& scratch_bytes,
+      const Launch& launch);
+
+  bool enabled_;
+  std::mutex mutex_;
+  std::unordered_map<int, Tuned> devices_;
+  std::unordered_map<void*, std::string> names_;
+};
+
+LaunchTuner& launch_tuner();
+
+} // namespace mlx::core::cu
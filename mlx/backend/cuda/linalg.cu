@@ -0,0 +1,729 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/common/utils.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <cusolverDn.h>
+#include <fmt/format.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Zero the lower (upper == true) or the upper triangle of the row contiguous
+// matrices in |x|.
+template <typename T>
+__global__ void
+zero_triangle(T* x, int rows, int cols, bool upper, int64_t size) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index < size) {
+    int r = (index / cols) % rows;
+    int c = index % cols;
+    if (upper ? c < r : c > r) {
+      x[index] = T(0);
+    }
+  }
+}
+
+template <typename T>
+__global__ void set_identity(T* x, int n, int64_t size) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index < size) {
+    int r = (index / n) % n;
+    int c = index % n;
+    x[index] = r == c ? T(1) : T(0);
+  }
+}
+
+template <typename T>
+__global__ void
+set_matrix_pointers(T** ptrs, T* base, int64_t stride, int batch) {
+  int index = cg::this_grid().thread_rank();
+  if (index < batch) {
+    ptrs[index] = base + index * stride;
+  }
+}
+
+// Convert the 1-based pivots of getrf to 0-based pivots and compute the row
+// permutation, a thread handles a matrix.
+__global__ void lu_pivots(
+    const int* ipiv,
+    uint32_t* pivots,
+    uint32_t* row_indices,
+    int M,
+    int K,
+    int batch) {
+  int index = cg::this_grid().thread_rank();
+  if (index >= batch) {
+    return;
+  }
+  ipiv += int64_t(index) * K;
+  pivots += int64_t(index) * K;
+  row_indices += int64_t(index) * M;
+  for (int j = 0; j < K; ++j) {
+    pivots[j] = ipiv[j] - 1;
+  }
+  for (int j = 0; j < M; ++j) {
+    row_indices[j] = j;
+  }
+  for (int j = K - 1; j >= 0; --j) {
+    auto piv = pivots[j];
+    auto t = row_indices[piv];
+    row_indices[piv] = row_indices[j];
+    row_indices[j] = t;
+  }
+}
+
+#define CHECK_CUSOLVER_ERROR(cmd) check_cusolver_error(#cmd, (cmd))
+
+void check_cusolver_error(const char* name, cusolverStatus_t err) {
+  if (err != CUSOLVER_STATUS_SUCCESS) {
+    throw std::runtime_error(
+        fmt::format("{} failed with code: {}.", name, static_cast<int>(err)));
+  }
+}
+
+// Call the float or double version of a cuSOLVER function.
+#define DEFINE_SOLVER_FUNC(name, func)                   \
+  template <typename T, typename... Args>                \
+  void name(Args... args) {                              \
+    if constexpr (std::is_same_v<T, float>) {            \
+      CHECK_CUSOLVER_ERROR(cusolverDnS##func(args...));  \
+    } else {                                             \
+      CHECK_CUSOLVER_ERROR(cusolverDnD##func(args...));  \
+    }                                                    \
+  }
+
+DEFINE_SOLVER_FUNC(getrf_buffer_size, getrf_bufferSize)
+DEFINE_SOLVER_FUNC(getrf, getrf)
+DEFINE_SOLVER_FUNC(getrs, getrs)
+DEFINE_SOLVER_FUNC(geqrf_buffer_size, geqrf_bufferSize)
+DEFINE_SOLVER_FUNC(geqrf, geqrf)
+DEFINE_SOLVER_FUNC(orgqr_buffer_size, orgqr_bufferSize)
+DEFINE_SOLVER_FUNC(orgqr, orgqr)
+DEFINE_SOLVER_FUNC(potrf_batched, potrfBatched)
+DEFINE_SOLVER_FUNC(gesvdj_buffer_size, gesvdj_bufferSize)
+DEFINE_SOLVER_FUNC(gesvdj, gesvdj)
+DEFINE_SOLVER_FUNC(gesvdj_batched_buffer_size, gesvdjBatched_bufferSize)
+DEFINE_SOLVER_FUNC(gesvdj_batched, gesvdjBatched)
+DEFINE_SOLVER_FUNC(syevj_buffer_size, syevj_bufferSize)
+DEFINE_SOLVER_FUNC(syevj, syevj)
+DEFINE_SOLVER_FUNC(syevj_batched_buffer_size, syevjBatched_bufferSize)
+DEFINE_SOLVER_FUNC(syevj_batched, syevjBatched)
+
+#undef DEFINE_SOLVER_FUNC
+
+// The Jacobi methods of cuSOLVER support batching for matrices of at most
+// 32 x 32.
+constexpr int max_jacobi_batched_size = 32;
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_solver_types(Dtype dtype, const char* tag, F&& f) {
+  switch (dtype) {
+    case float32:
+      f(type_identity<float>{});
+      break;
+    case float64:
+      f(type_identity<double>{});
+      break;
+    default:
+      throw std::runtime_error(
+          fmt::format("{} only supports float32 or float64.", tag));
+  }
+}
+
+array make_temporary(cu::CommandEncoder& enc, Shape shape, Dtype dtype) {
+  array arr(std::move(shape), dtype, nullptr, {});
+  arr.set_data(allocator::malloc(arr.nbytes()));
+  enc.add_temporary(arr);
+  return arr;
+}
+
+// Launch a kernel with one thread per element.
+template <typename F, typename... Args>
+void launch_elementwise(
+    cu::CommandEncoder& enc,
+    F* kernel,
+    int64_t size,
+    Args&&... args) {
+  constexpr int block_dim = 256;
+  enc.add_kernel_node(
+      kernel,
+      cuda::ceil_div(size, block_dim),
+      block_dim,
+      std::forward<Args>(args)...);
+}
+
+// Copy |a| into |out| with the matrices stored in column major, as expected
+// by cuSOLVER.
+void copy_col_major(const array& a, array& out, const Stream& s) {
+  auto ndim = a.ndim();
+  auto strides = out.strides();
+  strides[ndim - 1] = a.shape(-2);
+  strides[ndim - 2] = 1;
+  auto flags = out.flags();
+  flags.contiguous = true;
+  flags.row_contiguous = false;
+  flags.col_contiguous = a.size() == a.shape(-1) * a.shape(-2);
+  out.set_data(allocator::malloc(out.nbytes()), out.size(), strides, flags);
+  copy_gpu_inplace(a, out, CopyType::GeneralGeneral, s);
+}
+
+// Use the strides of the transpose, with the eigen/singular vectors in the
+// columns the outputs keep the layout written by cuSOLVER.
+void set_transposed_layout(array& out) {
+  auto ndim = out.ndim();
+  auto strides = out.strides();
+  std::swap(strides[ndim - 1], strides[ndim - 2]);
+  auto flags = out.flags();
+  flags.contiguous = true;
+  flags.row_contiguous = out.size() <= 1;
+  flags.col_contiguous = out.size() <= 1 || ndim == 2;
+  out.set_data(allocator::malloc(out.nbytes()), out.size(), strides, flags);
+}
+
+void zero_triangle(
+    cu::CommandEncoder& enc,
+    array& x,
+    bool upper,
+    Dtype dtype) {
+  int rows = x.shape(-2);
+  int cols = x.shape(-1);
+  int64_t size = x.size();
+  dispatch_solver_types(dtype, "[zero_triangle]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    enc.set_output_array(x);
+    launch_elementwise(
+        enc, cu::zero_triangle<T>, size, x.data<T>(), rows, cols, upper, size);
+  });
+}
+
+// Compute the inverses of the row contiguous matrices |a| into |out|, the
+// row major matrices are column major transposes and the inverse of the
+// transpose is the transpose of the inverse.
+template <typename T>
+void general_inv(
+    cu::CommandEncoder& enc,
+    cusolverDnHandle_t handle,
+    array& lu,
+    array& out) {
+  int N = lu.shape(-1);
+  int batch = lu.size() / (N * N);
+  int64_t size = out.size();
+
+  enc.set_output_array(out);
+  launch_elementwise(enc, cu::set_identity<T>, size, out.data<T>(), N, size);
+
+  int lwork;
+  cu::getrf_buffer_size<T>(handle, N, N, lu.data<T>(), N, &lwork);
+  auto work = make_temporary(enc, {std::max(lwork, 1)}, lu.dtype());
+  auto ipiv = make_temporary(enc, {batch * N}, int32);
+  auto info = make_temporary(enc, {batch}, int32);
+
+  enc.set_input_array(lu);
+  enc.set_output_array(lu);
+  enc.set_output_array(out);
+  enc.set_output_array(work);
+  enc.set_output_array(ipiv);
+  enc.set_output_array(info);
+  auto capture = enc.capture_context();
+  CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+  for (int i = 0; i < batch; ++i) {
+    T* a = lu.data<T>() + int64_t(i) * N * N;
+    int* p = ipiv.data<int>() + int64_t(i) * N;
+    cu::getrf<T>(handle, N, N, a, N, work.data<T>(), p, info.data<int>() + i);
+    cu::getrs<T>(
+        handle,
+        CUBLAS_OP_N,
+        N,
+        N,
+        a,
+        N,
+        p,
+        out.data<T>() + int64_t(i) * N * N,
+        N,
+        info.data<int>() + i);
+  }
+}
+
+} // namespace
+
+void LUF::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("LUF::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  const array& a = inputs[0];
+  array& lu = outputs[0];
+  array& pivots = outputs[1];
+  array& row_indices = outputs[2];
+  int M = a.shape(-2);
+  int N = a.shape(-1);
+  int K = std::min(M, N);
+  int batch = a.size() / (M * N);
+
+  // The factorization is done in place in the column major output.
+  copy_col_major(a, lu, s);
+  pivots.set_data(allocator::malloc(pivots.nbytes()));
+  row_indices.set_data(allocator::malloc(row_indices.nbytes()));
+
+  dispatch_solver_types(a.dtype(), "[LUF::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    int lwork;
+    cu::getrf_buffer_size<T>(handle, M, N, lu.data<T>(), M, &lwork);
+    auto work = make_temporary(enc, {std::max(lwork, 1)}, a.dtype());
+    auto ipiv = make_temporary(enc, {batch * K}, int32);
+    auto info = make_temporary(enc, {batch}, int32);
+
+    enc.set_output_array(lu);
+    enc.set_output_array(work);
+    enc.set_output_array(ipiv);
+    enc.set_output_array(info);
+    {
+      auto capture = enc.capture_context();
+      CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+      for (int i = 0; i < batch; ++i) {
+        cu::getrf<T>(
+            handle,
+            M,
+            N,
+            lu.data<T>() + int64_t(i) * M * N,
+            M,
+            work.data<T>(),
+            ipiv.data<int>() + int64_t(i) * K,
+            info.data<int>() + i);
+      }
+    }
+
+    enc.set_input_array(ipiv);
+    enc.set_output_array(pivots);
+    enc.set_output_array(row_indices);
+    launch_elementwise(
+        enc,
+        cu::lu_pivots,
+        batch,
+        ipiv.data<int>(),
+        pivots.data<uint32_t>(),
+        row_indices.data<uint32_t>(),
+        M,
+        K,
+        batch);
+  });
+}
+
+void QRF::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("QRF::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  const array& a = inputs[0];
+  array& q = outputs[0];
+  array& r_out = outputs[1];
+  int M = a.shape(-2);
+  int N = a.shape(-1);
+  int K = std::min(M, N);
+  int batch = a.size() / (M * N);
+
+  array in(a.shape(), a.dtype(), nullptr, {});
+  copy_col_major(a, in, s);
+  enc.add_temporary(in);
+  q.set_data(allocator::malloc(q.nbytes()));
+  r_out.set_data(allocator::malloc(r_out.nbytes()));
+
+  dispatch_solver_types(a.dtype(), "[QRF::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    int lwork_geqrf;
+    int lwork_orgqr;
+    cu::geqrf_buffer_size<T>(handle, M, N, in.data<T>(), M, &lwork_geqrf);
+    auto tau = make_temporary(enc, {batch * K}, a.dtype());
+    cu::orgqr_buffer_size<T>(
+        handle, M, K, K, in.data<T>(), M, tau.data<T>(), &lwork_orgqr);
+    int lwork = std::max({lwork_geqrf, lwork_orgqr, 1});
+    auto work = make_temporary(enc, {lwork}, a.dtype());
+    auto info = make_temporary(enc, {batch}, int32);
+
+    auto solve = [&](auto&& f) {
+      enc.set_output_array(in);
+      enc.set_output_array(tau);
+      enc.set_output_array(work);
+      enc.set_output_array(info);
+      auto capture = enc.capture_context();
+      CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+      for (int i = 0; i < batch; ++i) {
+        f(in.data<T>() + int64_t(i) * M * N,
+          tau.data<T>() + int64_t(i) * K,
+          info.data<int>() + i);
+      }
+    };
+
+    solve([&](T* x, T* t, int* i) {
+      cu::geqrf<T>(handle, M, N, x, M, t, work.data<T>(), lwork, i);
+    });
+
+    // R is the upper triangle of the first K rows.
+    copy_gpu_inplace(
+        in,
+        r_out,
+        r_out.shape(),
+        in.strides(),
+        r_out.strides(),
+        0,
+        0,
+        CopyType::General,
+        s);
+    zero_triangle(enc, r_out, true, a.dtype());
+
+    // Q is in the first K columns after orgqr.
+    solve([&](T* x, T* t, int* i) {
+      cu::orgqr<T>(handle, M, K, K, x, M, t, work.data<T>(), lwork, i);
+    });
+    copy_gpu_inplace(
+        in,
+        q,
+        q.shape(),
+        in.strides(),
+        q.strides(),
+        0,
+        0,
+        CopyType::General,
+        s);
+  });
+}
+
+void SVD::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("SVD::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  // As on the CPU the row major A is seen as the column major Aᵀ = V Σ Uᵀ,
+  // so cuSOLVER writes Vᵀ in row major as its U and U in column major as its
+  // V.
+  const array& a = inputs[0];
+  int M = a.shape(-2);
+  int N = a.shape(-1);
+  int K = std::min(M, N);
+  int batch = a.size() / (M * N);
+
+  // cuSOLVER overwrites the input.
+  array in = contiguous_copy_gpu(a, s);
+  enc.add_temporary(in);
+
+  array& sv = compute_uv_ ? outputs[1] : outputs[0];
+  sv.set_data(allocator::malloc(sv.nbytes()));
+  array* u = nullptr;
+  array* vt = nullptr;
+  if (compute_uv_) {
+    u = &outputs[0];
+    vt = &outputs[2];
+    set_transposed_layout(*u);
+    vt->set_data(allocator::malloc(vt->nbytes()));
+  }
+
+  dispatch_solver_types(a.dtype(), "[SVD::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    auto jobz =
+        compute_uv_ ? CUSOLVER_EIG_MODE_VECTOR : CUSOLVER_EIG_MODE_NOVECTOR;
+    T* u_ptr = compute_uv_ ? vt->data<T>() : nullptr;
+    T* v_ptr = compute_uv_ ? u->data<T>() : nullptr;
+    gesvdjInfo_t params;
+    CHECK_CUSOLVER_ERROR(cusolverDnCreateGesvdjInfo(&params));
+    // The parameters are read when the calls are captured.
+    enc.add_completed_handler(
+        [params]() { cusolverDnDestroyGesvdjInfo(params); });
+
+    bool batched =
+        M <= cu::max_jacobi_batched_size && N <= cu::max_jacobi_batched_size;
+    int lwork;
+    if (batched) {
+      cu::gesvdj_batched_buffer_size<T>(
+          handle,
+          jobz,
+          N,
+          M,
+          in.data<T>(),
+          N,
+          sv.data<T>(),
+          u_ptr,
+          N,
+          v_ptr,
+          M,
+          &lwork,
+          params,
+          batch);
+    } else {
+      cu::gesvdj_buffer_size<T>(
+          handle,
+          jobz,
+          0,
+          N,
+          M,
+          in.data<T>(),
+          N,
+          sv.data<T>(),
+          u_ptr,
+          N,
+          v_ptr,
+          M,
+          &lwork,
+          params);
+    }
+    auto work = make_temporary(enc, {std::max(lwork, 1)}, a.dtype());
+    auto info = make_temporary(enc, {batch}, int32);
+
+    enc.set_output_array(in);
+    enc.set_output_array(sv);
+    if (compute_uv_) {
+      enc.set_output_array(*u);
+      enc.set_output_array(*vt);
+    }
+    enc.set_output_array(work);
+    enc.set_output_array(info);
+    auto capture = enc.capture_context();
+    CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+    if (batched) {
+      cu::gesvdj_batched<T>(
+          handle,
+          jobz,
+          N,
+          M,
+          in.data<T>(),
+          N,
+          sv.data<T>(),
+          u_ptr,
+          N,
+          v_ptr,
+          M,
+          work.data<T>(),
+          lwork,
+          info.data<int>(),
+          params,
+          batch);
+      return;
+    }
+    for (int i = 0; i < batch; ++i) {
+      cu::gesvdj<T>(
+          handle,
+          jobz,
+          0,
+          N,
+          M,
+          in.data<T>() + int64_t(i) * M * N,
+          N,
+          sv.data<T>() + int64_t(i) * K,
+          u_ptr ? u_ptr + int64_t(i) * N * N : nullptr,
+          N,
+          v_ptr ? v_ptr + int64_t(i) * M * M : nullptr,
+          M,
+          work.data<T>(),
+          lwork,
+          info.data<int>() + i,
+          params);
+    }
+  });
+}
+
+void Inverse::eval_gpu(const std::vector<array>& inputs, array& output) {
+  nvtx3::scoped_range r("Inverse::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  const array& a = inputs[0];
+  output.set_data(allocator::malloc(output.nbytes()));
+
+  // The factorization overwrites its input.
+  array lu = contiguous_copy_gpu(a, s);
+  enc.add_temporary(lu);
+
+  // Only the triangle of |a| is read for triangular matrices.
+  if (tri_) {
+    zero_triangle(enc, lu, upper_, a.dtype());
+  }
+  dispatch_solver_types(a.dtype(), "[Inverse::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    general_inv<T>(enc, handle, lu, output);
+  });
+  if (tri_) {
+    zero_triangle(enc, output, upper_, a.dtype());
+  }
+}
+
+void Cholesky::eval_gpu(const std::vector<array>& inputs, array& output) {
+  nvtx3::scoped_range r("Cholesky::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  // The matrices are symmetric so the row major upper triangle is the column
+  // major lower triangle, the factorization is done in place in the output.
+  const array& a = inputs[0];
+  copy_gpu(
+      a,
+      output,
+      a.flags().row_contiguous ? CopyType::Vector : CopyType::General,
+      s);
+  int N = a.shape(-1);
+  int batch = a.size() / (N * N);
+  auto uplo = upper_ ? CUBLAS_FILL_MODE_LOWER : CUBLAS_FILL_MODE_UPPER;
+
+  dispatch_solver_types(a.dtype(), "[Cholesky::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    auto ptrs = make_temporary(enc, {batch}, uint64);
+    auto info = make_temporary(enc, {batch}, int32);
+    enc.set_output_array(ptrs);
+    launch_elementwise(
+        enc,
+        cu::set_matrix_pointers<T>,
+        batch,
+        reinterpret_cast<T**>(ptrs.data<uint64_t>()),
+        output.data<T>(),
+        int64_t(N) * N,
+        batch);
+
+    enc.set_input_array(ptrs);
+    enc.set_output_array(output);
+    enc.set_output_array(info);
+    {
+      auto capture = enc.capture_context();
+      CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+      cu::potrf_batched<T>(
+          handle,
+          uplo,
+          N,
+          reinterpret_cast<T**>(ptrs.data<uint64_t>()),
+          N,
+          info.data<int>(),
+          batch);
+    }
+  });
+  zero_triangle(enc, output, upper_, a.dtype());
+}
+
+void Eigh::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("Eigh::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+  auto handle = cu::device(s.device).solver_handle();
+
+  const array& a = inputs[0];
+  array& values = outputs[0];
+  values.set_data(allocator::malloc(values.nbytes()));
+
+  // The eigenvectors are computed in place in the columns of the column
+  // major matrices, which are the transposes of the row major outputs.
+  array vectors = compute_eigenvectors_
+      ? outputs[1]
+      : array(a.shape(), a.dtype(), nullptr, {});
+  set_transposed_layout(vectors);
+  if (!compute_eigenvectors_) {
+    enc.add_temporary(vectors);
+  }
+  copy_gpu_inplace(a, vectors, CopyType::GeneralGeneral, s);
+
+  int N = a.shape(-1);
+  int batch = a.size() / (N * N);
+  // The input is symmetric so the row major lower triangle is the column
+  // major upper triangle.
+  auto uplo = uplo_ == "L" ? CUBLAS_FILL_MODE_UPPER : CUBLAS_FILL_MODE_LOWER;
+  auto jobz = compute_eigenvectors_ ? CUSOLVER_EIG_MODE_VECTOR
+                                    : CUSOLVER_EIG_MODE_NOVECTOR;
+
+  dispatch_solver_types(a.dtype(), "[Eigh::eval_gpu]", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    syevjInfo_t params;
+    CHECK_CUSOLVER_ERROR(cusolverDnCreateSyevjInfo(&params));
+    enc.add_completed_handler(
+        [params]() { cusolverDnDestroySyevjInfo(params); });
+
+    bool batched = N <= cu::max_jacobi_batched_size;
+    int lwork;
+    if (batched) {
+      cu::syevj_batched_buffer_size<T>(
+          handle,
+          jobz,
+          uplo,
+          N,
+          vectors.data<T>(),
+          N,
+          values.data<T>(),
+          &lwork,
+          params,
+          batch);
+    } else {
+      cu::syevj_buffer_size<T>(
+          handle,
+          jobz,
+          uplo,
+          N,
+          vectors.data<T>(),
+          N,
+          values.data<T>(),
+          &lwork,
+          params);
+    }
+    auto work = make_temporary(enc, {std::max(lwork, 1)}, a.dtype());
+    auto info = make_temporary(enc, {batch}, int32);
+
+    enc.set_output_array(vectors);
+    enc.set_output_array(values);
+    enc.set_output_array(work);
+    enc.set_output_array(info);
+    auto capture = enc.capture_context();
+    CHECK_CUSOLVER_ERROR(cusolverDnSetStream(handle, enc.stream()));
+    if (batched) {
+      cu::syevj_batched<T>(
+          handle,
+          jobz,
+          uplo,
+          N,
+          vectors.data<T>(),
+          N,
+          values.data<T>(),
+          work.data<T>(),
+          lwork,
+          info.data<int>(),
+          params,
+          batch);
+      return;
+    }
+    for (int i = 0; i < batch; ++i) {
+      cu::syevj<T>(
+          handle,
+          jobz,
+          uplo,
+          N,
+          vectors.data<T>() + int64_t(i) * N * N,
+          N,
+          values.data<T>() + int64_t(i) * N,
+          work.data<T>(),
+          lwork,
+          info.data<int>() + i,
+          params);
+    }
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,51 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/pinned_staging.h"
+#include "mlx/primitives.h"
+#include "mlx/utils.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+void Load::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Load::eval_gpu");
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.nbytes() == 0) {
+    return;
+  }
+
+  // The file is read and copied in the io threads while the stream runs the
+  // work already encoded, the next kernels wait on |done| in the stream.
+  auto& staging = cu::pinned_staging(cu::device(stream().device));
+  cu::SharedEvent done;
+  // The task holds the buffer of |out| until it has been written.
+  auto read_task = [&staging,
+                    data = out.data_shared_ptr(),
+                    dst = out.buffer(),
+                    nbytes = out.nbytes(),
+                    itemsize = out.itemsize(),
+                    offset = offset_,
+                    reader = reader_,
+                    swap = swap_endianness_,
+                    done]() mutable {
+    try {
+      auto mapped = std::dynamic_pointer_cast<io::MmapFileReader>(reader);
+      if (mapped && !swap &&
+          staging.load_mapped(
+              mapped->data(offset, nbytes), dst, nbytes, done)) {
+        return;
+      }
+      staging.load(*reader, dst, nbytes, offset, itemsize, swap, done);
+    } catch (const std::exception& error) {
+      // The exception would be dropped by the io thread and the stream would
+      // go on with the data not written, and no one waits on the host for
+      // the read to raise it.
+      abort_with_exception(error);
+    }
+  };
+  io::thread_pool().enqueue(std::move(read_task));
+  done.wait(stream(), 1);
+}
+
+} // namespace mlx::core
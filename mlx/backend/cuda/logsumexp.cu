@@ -3,8 +3,10 @@
 #include "mlx/backend/cuda/device.h"
 #include "mlx/backend/cuda/device/cast_op.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/online_softmax.cuh"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 
 #include <cooperative_groups.h>
@@ -27,14 +29,13 @@ inline __device__ T softmax_exp(T x) {
   return __expf(x);
 }
 
+// The logsumexp of the row |in| computed by a block, the result is
+// broadcasted to every thread.
 template <typename T, typename AccT, int BLOCK_DIM, int N_READS = 4>
-__global__ void logsumexp(const T* in, T* out, int axis_size) {
-  auto grid = cg::this_grid();
-  auto block = cg::this_thread_block();
+__device__ AccT
+block_logsumexp(cg::thread_block& block, const T* in, int axis_size) {
   auto warp = cg::tiled_partition<WARP_SIZE>(block);
 
-  in += grid.block_rank() * axis_size;
-
   cg::greater<AccT> max_op;
   cg::plus<AccT> plus_op;
 
@@ -88,10 +89,87 @@ __global__ void logsumexp(const T* in, T* out, int axis_size) {
       ? local_normalizer[warp.thread_rank()]
       : AccT{};
   normalizer = cg::reduce(warp, normalizer, plus_op);
+  return isinf(maxval) ? maxval : log(normalizer) + maxval;
+}
+
+template <typename T, typename AccT, int BLOCK_DIM, int N_READS = 4>
+__global__ void logsumexp(const T* in, T* out, int axis_size) {
+  auto grid = cg::this_grid();
+  auto block = cg::this_thread_block();
+  in += grid.block_rank() * axis_size;
+  AccT l = block_logsumexp<T, AccT, BLOCK_DIM, N_READS>(block, in, axis_size);
+  if (block.thread_rank() == 0) {
+    out[grid.block_rank()] = l;
+  }
+}
+
+// The loss is logsumexp(x) - x[target] for each row of x, the logsumexp is
+// also kept for the vjp. The negative targets count from the end of the row
+// as in take_along_axis, the targets outside of the row give no score.
+template <typename T, typename AccT, int BLOCK_DIM, int N_READS = 4>
+__global__ void cross_entropy(
+    const T* logits,
+    const int32_t* targets,
+    T* loss,
+    AccT* lse,
+    int axis_size) {
+  auto grid = cg::this_grid();
+  auto block = cg::this_thread_block();
+  int64_t row = grid.block_rank();
+  logits += row * axis_size;
+  AccT l =
+      block_logsumexp<T, AccT, BLOCK_DIM, N_READS>(block, logits, axis_size);
+  if (block.thread_rank() == 0) {
+    int32_t t = targets[row];
+    t += t < 0 ? axis_size : 0;
+    AccT score = (t >= 0 && t < axis_size) ? AccT(logits[t]) : AccT(0);
+    loss[row] = l - score;
+    lse[row] = l;
+  }
+}
+
+// The gradient of the logits, (softmax(x) - onehot(target)) * g, one row per
+// block in x and chunks of the row in y.
+template <typename T, typename AccT, int BLOCK_DIM, int N_READS = 4>
+__global__ void cross_entropy_vjp(
+    const T* logits,
+    const int32_t* targets,
+    const AccT* lse,
+    const T* g,
+    T* grad,
+    int axis_size) {
+  auto block = cg::this_thread_block();
+  int64_t row = block.group_index().x;
+  int offset = block.group_index().y * BLOCK_DIM * N_READS;
+  AccT l = lse[row];
+  AccT gi = g[row];
+  int32_t t = targets[row];
+  t += (t < 0 ? axis_size : 0) - offset;
+  int size = min(BLOCK_DIM * N_READS, axis_size - offset);
+  logits += row * axis_size + offset;
+  grad += row * axis_size + offset;
 
-  // Write output.
+  T vals[N_READS];
+  cub::LoadDirectBlocked(block.thread_rank(), logits, vals, size);
+  for (int i = 0; i < N_READS; i++) {
+    int j = block.thread_rank() * N_READS + i;
+    AccT p = exp(AccT(vals[i]) - l);
+    vals[i] = (p - AccT(j == t)) * gi;
+  }
+  cub::StoreDirectBlocked(block.thread_rank(), grad, vals, size);
+}
+
+// Merge the partials of the rows split by online_softmax_partials, one block
+// per row.
+template <typename T, int BLOCK_DIM>
+__global__ void
+logsumexp_chunks(const float2* partials, T* out, int n_chunks) {
+  auto block = cg::this_thread_block();
+  int row = block.group_index().x;
+  float2 val =
+      merge_online_softmax_partials<BLOCK_DIM>(block, partials, row, n_chunks);
   if (block.thread_rank() == 0) {
-    out[grid.block_rank()] = isinf(maxval) ? maxval : log(normalizer) + maxval;
+    out[row] = isinf(val.x) ? val.x : log(val.y) + val.x;
   }
 }
 
@@ -140,6 +218,44 @@ void LogSumExp::eval_gpu(const std::vector<array>& inputs, array& out) {
   int axis_size = in.shape().back();
   int n_rows = in.data_size() / axis_size;
 
+  // Split the rows across blocks when there are too few of them, each block
+  // reduces a chunk to a (max, sum) pair and the pairs are merged per row.
+  int n_chunks = online_softmax_chunks(cu::device(s.device), n_rows, axis_size);
+  if (n_chunks > 1) {
+    int chunk_size = cuda::ceil_div(axis_size, n_chunks);
+    n_chunks = cuda::ceil_div(axis_size, chunk_size);
+    array partials({n_rows, n_chunks, 2}, float32, nullptr, {});
+    partials.set_data(allocator::malloc(partials.nbytes()));
+    encoder.add_temporary(partials);
+
+    dispatch_float_types(out.dtype(), "logsumexp", [&](auto type_tag) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      constexpr int N_READS = 4;
+      constexpr int BLOCK_DIM = 1024;
+      encoder.set_input_array(in);
+      encoder.set_output_array(partials);
+      encoder.add_kernel_node(
+          cu::online_softmax_partials<DataType, BLOCK_DIM, N_READS>,
+          dim3(n_chunks, n_rows),
+          BLOCK_DIM,
+          in.data<DataType>(),
+          partials.data<float2>(),
+          axis_size,
+          chunk_size);
+      constexpr int MERGE_BLOCK_DIM = 256;
+      encoder.set_input_array(partials);
+      encoder.set_output_array(out);
+      encoder.add_kernel_node(
+          cu::logsumexp_chunks<DataType, MERGE_BLOCK_DIM>,
+          n_rows,
+          MERGE_BLOCK_DIM,
+          partials.data<float2>(),
+          out.data<DataType>(),
+          n_chunks);
+    });
+    return;
+  }
+
   encoder.set_input_array(in);
   encoder.set_output_array(out);
   dispatch_float_types(out.dtype(), "logsumexp", [&](auto type_tag) {
@@ -158,4 +274,113 @@ void LogSumExp::eval_gpu(const std::vector<array>& inputs, array& out) {
   });
 }
 
+namespace fast {
+
+bool CrossEntropy::use_fallback(Stream s) {
+  return false;
+}
+
+void CrossEntropy::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("CrossEntropy::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  auto ensure_row_contiguous = [&s, &encoder](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  auto logits = ensure_row_contiguous(inputs[0]);
+  auto targets = ensure_row_contiguous(inputs[1]);
+  auto& loss = outputs[0];
+  auto& lse = outputs[1];
+  loss.set_data(allocator::malloc(loss.nbytes()));
+  lse.set_data(allocator::malloc(lse.nbytes()));
+
+  int axis_size = logits.shape().back();
+  int n_rows = loss.size();
+
+  encoder.set_input_array(logits);
+  encoder.set_input_array(targets);
+  encoder.set_output_array(loss);
+  encoder.set_output_array(lse);
+  dispatch_float_types(loss.dtype(), "cross_entropy", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using AccT =
+        std::conditional_t<std::is_same_v<DataType, double>, double, float>;
+    constexpr int N_READS = 4;
+    dispatch_block_dim(cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
+      encoder.add_kernel_node(
+          cu::cross_entropy<DataType, AccT, block_dim(), N_READS>,
+          n_rows,
+          block_dim(),
+          logits.data<DataType>(),
+          targets.data<int32_t>(),
+          loss.data<DataType>(),
+          lse.data<AccT>(),
+          axis_size);
+    });
+  });
+}
+
+void CrossEntropyVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("CrossEntropyVJP::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  auto ensure_row_contiguous = [&s, &encoder](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  auto logits = ensure_row_contiguous(inputs[0]);
+  auto targets = ensure_row_contiguous(inputs[1]);
+  auto lse = ensure_row_contiguous(inputs[2]);
+  auto g = ensure_row_contiguous(inputs[3]);
+  auto& grad = outputs[0];
+  if (inputs[0].is_donatable() && inputs[0].flags().row_contiguous) {
+    grad.copy_shared_buffer(logits);
+  } else {
+    grad.set_data(allocator::malloc(grad.nbytes()));
+  }
+
+  int axis_size = logits.shape().back();
+  int n_rows = lse.size();
+
+  encoder.set_input_array(logits);
+  encoder.set_input_array(targets);
+  encoder.set_input_array(lse);
+  encoder.set_input_array(g);
+  encoder.set_output_array(grad);
+  dispatch_float_types(grad.dtype(), "cross_entropy_vjp", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using AccT =
+        std::conditional_t<std::is_same_v<DataType, double>, double, float>;
+    constexpr int N_READS = 4;
+    constexpr int BLOCK_DIM = 256;
+    encoder.add_kernel_node(
+        cu::cross_entropy_vjp<DataType, AccT, BLOCK_DIM, N_READS>,
+        dim3(n_rows, cuda::ceil_div(axis_size, BLOCK_DIM * N_READS)),
+        BLOCK_DIM,
+        logits.data<DataType>(),
+        targets.data<int32_t>(),
+        lse.data<AccT>(),
+        g.data<DataType>(),
+        grad.data<DataType>(),
+        axis_size);
+  });
+}
+
+} // namespace fast
+
 } // namespace mlx::core
@@ -0,0 +1,73 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <algorithm>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace mlx::core {
+
+// A cache with a fixed capacity that evicts the least recently used entry.
+template <typename K, typename V>
+class LRUCache {
+ public:
+  explicit LRUCache(size_t capacity) : capacity_(capacity) {}
+
+  LRUCache(const LRUCache&) = delete;
+  LRUCache& operator=(const LRUCache&) = delete;
+
+  // Return the value of |key|, it is created with |make()| when missing.
+  template <typename F>
+  V& get_or_create(const K& key, F&& make) {
+    if (V* value = find(key)) {
+      return *value;
+    }
+    return insert(key, make());
+  }
+
+  // Return the value of |key| and mark it as the most recently used, or
+  // nullptr when missing.
+  V* find(const K& key) {
+    auto it = map_.find(key);
+    if (it == map_.end()) {
+      return nullptr;
+    }
+    items_.splice(items_.begin(), items_, it->second);
+    return &it->second->second;
+  }
+
+  // Insert |value| for the missing |key|, the least recently used entry is
+  // evicted when the cache is full.
+  V& insert(const K& key, V value) {
+    items_.emplace_front(key, std::move(value));
+    map_.emplace(key, items_.begin());
+    // The new entry is always kept.
+    if (items_.size() > std::max<size_t>(capacity_, 1)) {
+      map_.erase(items_.back().first);
+      items_.pop_back();
+    }
+    return items_.front().second;
+  }
+
+  size_t size() const {
+    return items_.size();
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  void clear() {
+    map_.clear();
+    items_.clear();
+  }
+
+ private:
+  size_t capacity_;
+  std::list<std::pair<K, V>> items_;
+  std::unordered_map<K, typename std::list<std::pair<K, V>>::iterator> map_;
+};
+
+} // namespace mlx::core
@@ -2,40 +2,45 @@
 
 #include "mlx/backend/common/matmul.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/fp8.h"
+#include "mlx/backend/cuda/gemm_batched.h"
+#include "mlx/backend/cuda/gemv.h"
+#include "mlx/backend/cuda/int8.h"
+#include "mlx/backend/cuda/lru_cache.h"
+#include "mlx/backend/cuda/utils.h"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
+#include "mlx/version.h"
 
 #include <cublasLt.h>
+#include <cuda_fp16.h>
 #include <fmt/format.h>
 #include <nvtx3/nvtx3.hpp>
 
+#include <filesystem>
+#include <fstream>
+#include <limits>
 #include <numeric>
+#include <optional>
 
 namespace mlx::core {
 
 namespace cu {
 
-#define CHECK_CUBLAS_ERROR(cmd) check_cublas_error(#cmd, (cmd))
-
-void check_cublas_error(const char* name, cublasStatus_t err) {
-  if (err != CUBLAS_STATUS_SUCCESS) {
-    // TODO: Use cublasGetStatusString when it is widely available.
-    throw std::runtime_error(
-        fmt::format("{} failed with code: {}.", name, static_cast<int>(err)));
-  }
+uint64_t cublas_workspace_size(Device& device) {
+  // The recommended cublas workspace size is 4 MiB for pre-Hopper and 32 MiB
+  // for Hopper+:
+  // https://docs.nvidia.com/cuda/cublas/#cublassetworkspace
+  uint64_t MiB = 1024 * 1024;
+  return device.compute_capability_major() >= 9 ? 32 * MiB : 4 * MiB;
 }
 
 struct CublasPreference {
   CublasPreference(Device& device) {
-    // The recommended cublas workspace size is 4 MiB for pre-Hopper and 32 MiB
-    // for Hopper+:
-    // https://docs.nvidia.com/cuda/cublas/#cublassetworkspace
-    uint64_t MiB = 1024 * 1024;
-    uint64_t workspace_size =
-        device.compute_capability_major() >= 9 ? 32 * MiB : 4 * MiB;
-
+    uint64_t workspace_size = cublas_workspace_size(device);
     CHECK_CUBLAS_ERROR(cublasLtMatmulPreferenceCreate(&pref_));
     CHECK_CUBLAS_ERROR(cublasLtMatmulPreferenceSetAttribute(
         pref_,
@@ -56,11 +61,116 @@ cublasLtMatmulPreference_t cublas_preference(Device& device) {
   return pref.pref_;
 }
 
+// The number of the best algorithms of the heuristic which are timed on the
+// first use of a matmul to pick the fastest, 0 disables the autotuning.
+int matmul_autotune_candidates() {
+  static int candidates = env::get_var("MLX_CUDA_MATMUL_AUTOTUNE", 0);
+  return candidates;
+}
+
+// Whether the matmuls whose output tiles can not fill the GPU split K across
+// more blocks, see MatMul::split_k.
+bool matmul_split_k() {
+  static bool split_k = env::get_var("MLX_CUDA_MATMUL_SPLIT_K", 1);
+  return split_k;
+}
+
+int matmul_cache_size() {
+  static int cache_size = env::get_var("MLX_CUDA_MATMUL_CACHE_SIZE", 128);
+  return cache_size;
+}
+
+// The file keeping the autotuned algorithms of a device, which are only
+// valid for its architecture and the version of cublasLt.
+std::filesystem::path autotune_file(Device& device) {
+  std::filesystem::path dir;
+  if (auto d = std::getenv("MLX_CUDA_MATMUL_AUTOTUNE_DIR"); d) {
+    dir = d;
+  } else {
+    dir = std::filesystem::temp_directory_path() / "mlx" / version() /
+        "matmul";
+  }
+  std::error_code error;
+  std::filesystem::create_directories(dir, error);
+  if (error) {
+    return std::filesystem::path();
+  }
+  return dir /
+      fmt::format("sm_{}{}_cublasLt_{}.txt",
+                  device.compute_capability_major(),
+                  device.compute_capability_minor(),
+                  cublasLtGetVersion());
+}
+
+// The autotuned algorithm of each matmul key, loaded from the file of the
+// device on first use.
+std::unordered_map<std::string, cublasLtMatmulAlgo_t>& tuned_algorithms(
+    Device& device) {
+  static std::unordered_map<
+      int,
+      std::unordered_map<std::string, cublasLtMatmulAlgo_t>>
+      algorithms;
+  auto [it, inserted] = algorithms.try_emplace(device.cuda_device());
+  if (inserted) {
+    // Each line has the key and the hex words of the algorithm.
+    std::ifstream f(autotune_file(device));
+    std::string key, hex;
+    constexpr size_t num_words =
+        sizeof(cublasLtMatmulAlgo_t::data) / sizeof(uint64_t);
+    while (f >> key >> hex) {
+      if (hex.size() != num_words * 16) {
+        continue;
+      }
+      cublasLtMatmulAlgo_t algo;
+      for (size_t i = 0; i < num_words; ++i) {
+        algo.data[i] = std::stoull(hex.substr(i * 16, 16), nullptr, 16);
+      }
+      it->second[key] = algo;
+    }
+  }
+  return it->second;
+}
+
+void save_tuned_algorithm(
+    Device& device,
+    const std::string& key,
+    const cublasLtMatmulAlgo_t& algo) {
+  tuned_algorithms(device)[key] = algo;
+  auto path = autotune_file(device);
+  if (path.empty()) {
+    return;
+  }
+  std::string hex;
+  for (auto word : algo.data) {
+    hex += fmt::format("{:016x}", word);
+  }
+  std::ofstream(path, std::ios::app) << key << " " << hex << "\n";
+}
+
+// The number of elements spanned by a column-major matrix.
+int64_t matrix_size(
+    uint64_t rows,
+    uint64_t cols,
+    int64_t ld,
+    int32_t batch_count,
+    int64_t batch_stride) {
+  if (rows == 0 || cols == 0) {
+    return 0;
+  }
+  return (batch_count - 1) * batch_stride + (cols - 1) * ld + rows;
+}
+
+// The matrices of mlx are row-major while cublasLt expects column-major ones,
+// and a row-major matrix is the same memory as its column-major transpose.
+// So instead of out = a @ b, MatMul computes out^T = b^T @ a^T in column
+// order, which also makes the bias of the epilogues a vector along the
+// columns of out.
 class MatMul {
  public:
   MatMul(
       Device& device,
       Dtype dtype,
+      cublasComputeType_t compute_type,
       bool a_transposed,
       uint64_t a_rows,
       uint64_t a_cols,
@@ -72,45 +182,66 @@ class MatMul {
       int32_t batch_count,
       int64_t a_batch_stride,
       int64_t b_batch_stride)
-      : handle_(device.lt_handle()), pref_(cublas_preference(device)) {
+      : device_(device),
+        handle_(device.lt_handle()),
+        pref_(cublas_preference(device)),
+        k_(a_cols),
+        itemsize_(size_of(dtype)),
+        in_itemsize_(size_of(dtype)),
+        out_rows_(b_cols),
+        out_size_(a_rows * b_cols * batch_count) {
     heuristic_.state = CUBLAS_STATUS_NOT_INITIALIZED;
 
-    auto scale_type = dtype_to_cuda_type(dtype);
-    if (dtype == bfloat16 || dtype == float16) {
-      scale_type = CUDA_R_32F;
+    // The half accumulation also takes half alpha and beta.
+    scale_type_ = dtype_to_cuda_type(dtype);
+    if (compute_type == CUBLAS_COMPUTE_16F) {
+      scale_type_ = CUDA_R_16F;
+    } else if (dtype == bfloat16 || dtype == float16) {
+      scale_type_ = CUDA_R_32F;
     }
-    CHECK_CUBLAS_ERROR(cublasLtMatmulDescCreate(
-        &matmul_desc_, dtype_to_compute_type(dtype), scale_type));
+    CHECK_CUBLAS_ERROR(
+        cublasLtMatmulDescCreate(&matmul_desc_, compute_type, scale_type_));
     int32_t pointer_mode = CUBLASLT_POINTER_MODE_HOST;
     CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
         matmul_desc_,
         CUBLASLT_MATMUL_DESC_POINTER_MODE,
         &pointer_mode,
         sizeof(int32_t)));
-    cublasOperation_t op = CUBLAS_OP_N;
+    // The first operand of cublasLt is b and the second is a.
+    cublasOperation_t b_op = b_transposed ? CUBLAS_OP_T : CUBLAS_OP_N;
     CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
         matmul_desc_,
         CUBLASLT_MATMUL_DESC_TRANSA,
-        &op,
+        &b_op,
         sizeof(cublasOperation_t)));
+    cublasOperation_t a_op = a_transposed ? CUBLAS_OP_T : CUBLAS_OP_N;
     CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
         matmul_desc_,
         CUBLASLT_MATMUL_DESC_TRANSB,
-        &op,
+        &a_op,
         sizeof(cublasOperation_t)));
 
     auto type = dtype_to_cuda_type(dtype);
+    uint64_t a_layout_rows = a_transposed ? a_rows : a_cols;
+    uint64_t a_layout_cols = a_transposed ? a_cols : a_rows;
     a_desc_ = create_matrix_layout(
-        type, a_rows, a_cols, a_transposed, lda, batch_count, a_batch_stride);
+        type, a_layout_rows, a_layout_cols, lda, batch_count, a_batch_stride);
+    a_size_ = matrix_size(
+        a_layout_rows, a_layout_cols, lda, batch_count, a_batch_stride);
+    uint64_t b_layout_rows = b_transposed ? b_rows : b_cols;
+    uint64_t b_layout_cols = b_transposed ? b_cols : b_rows;
     b_desc_ = create_matrix_layout(
-        type, b_rows, b_cols, b_transposed, ldb, batch_count, b_batch_stride);
+        type, b_layout_rows, b_layout_cols, ldb, batch_count, b_batch_stride);
+    b_size_ = matrix_size(
+        b_layout_rows, b_layout_cols, ldb, batch_count, b_batch_stride);
     out_desc_ = create_matrix_layout(
-        type, a_rows, b_cols, false, b_cols, batch_count, a_rows * b_cols);
+        type, b_cols, a_rows, b_cols, batch_count, a_rows * b_cols);
   }
 
   MatMul(
       Device& device,
       Dtype dtype,
+      cublasComputeType_t compute_type,
       bool a_transposed,
       uint64_t a_rows,
       uint64_t a_cols,
@@ -127,6 +258,7 @@ class MatMul {
       : MatMul(
             device,
             dtype,
+            compute_type,
             a_transposed,
             a_rows,
             a_cols,
@@ -140,7 +272,7 @@ class MatMul {
             b_batch_stride) {
     auto type = dtype_to_cuda_type(dtype);
     c_desc_ = create_matrix_layout(
-        type, a_rows, b_cols, false, ldc, batch_count, c_batch_stride);
+        type, b_cols, a_rows, ldc, batch_count, c_batch_stride);
   }
 
   ~MatMul() {
@@ -151,6 +283,83 @@ class MatMul {
     CHECK_CUBLAS_ERROR(cublasLtMatmulDescDestroy(matmul_desc_));
   }
 
+  // Apply the |epilogue| of cublasLt to the result:
+  // - the BIAS epilogues add the vector |bias|, which has one element per
+  //   column of out and is shared by the batches,
+  // - the AUX epilogues store the input of the activation in |aux|, with
+  //   the leading dimension |aux_ld|, for the backward pass,
+  // - BGRADB writes the sum over the rows of a to |bias|, the gradient of
+  //   the bias of a linear layer whose input gradient is out.
+  void set_epilogue(
+      cublasLtEpilogue_t epilogue,
+      const void* bias = nullptr,
+      void* aux = nullptr,
+      int64_t aux_ld = 0) {
+    if (epilogue != epilogue_) {
+      CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+          matmul_desc_,
+          CUBLASLT_MATMUL_DESC_EPILOGUE,
+          &epilogue,
+          sizeof(cublasLtEpilogue_t)));
+      epilogue_ = epilogue;
+      // The algorithm depends on the epilogue.
+      heuristic_.state = CUBLAS_STATUS_NOT_INITIALIZED;
+    }
+    if (bias) {
+      set_bias(bias);
+    }
+    if (aux) {
+      CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+          matmul_desc_,
+          CUBLASLT_MATMUL_DESC_EPILOGUE_AUX_POINTER,
+          &aux,
+          sizeof(void*)));
+      CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+          matmul_desc_,
+          CUBLASLT_MATMUL_DESC_EPILOGUE_AUX_LD,
+          &aux_ld,
+          sizeof(int64_t)));
+      aux_ = aux;
+    }
+  }
+
+  // Read a and b as |type| instead of the type of out, which is how the
+  // float8 inputs of the Ada and Hopper tensor cores and the int8 inputs of
+  // the int32 matmuls are multiplied.
+  void set_input_type(cudaDataType_t type, size_t itemsize) {
+    uint32_t layout_type = type;
+    for (auto desc : {a_desc_, b_desc_}) {
+      CHECK_CUBLAS_ERROR(cublasLtMatrixLayoutSetAttribute(
+          desc,
+          CUBLASLT_MATRIX_LAYOUT_TYPE,
+          &layout_type,
+          sizeof(uint32_t)));
+    }
+    in_itemsize_ = itemsize;
+    heuristic_.state = CUBLAS_STATUS_NOT_INITIALIZED;
+  }
+
+  // Set the device pointers of the float scales of a and b, which multiply
+  // the product of float8 inputs, a null pointer is a scale of 1.
+  void set_scales(const void* a_scale, const void* b_scale) {
+    CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+        matmul_desc_,
+        CUBLASLT_MATMUL_DESC_A_SCALE_POINTER,
+        &b_scale,
+        sizeof(const void*)));
+    CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+        matmul_desc_,
+        CUBLASLT_MATMUL_DESC_B_SCALE_POINTER,
+        &a_scale,
+        sizeof(const void*)));
+  }
+
+  // Time the best algorithms of the heuristic on the first run and keep the
+  // fastest under |key|, see MLX_CUDA_MATMUL_AUTOTUNE.
+  void set_autotune_key(std::string key) {
+    autotune_key_ = std::move(key);
+  }
+
   void run(
       cu::CommandEncoder& encoder,
       void* out,
@@ -160,21 +369,7 @@ class MatMul {
       float alpha = 1,
       float beta = 0) {
     if (heuristic_.state != CUBLAS_STATUS_SUCCESS) {
-      int ret = 0;
-      CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoGetHeuristic(
-          handle_,
-          matmul_desc_,
-          a_desc_,
-          b_desc_,
-          out_desc_,
-          out_desc_,
-          pref_,
-          1,
-          &heuristic_,
-          &ret));
-      if (ret == 0) {
-        throw std::runtime_error("Can not find algorithm for matmul.");
-      }
+      find_algorithm();
     }
 
     void* workspace_ptr = nullptr;
@@ -187,16 +382,17 @@ class MatMul {
       workspace_ptr = workspace.data<void>();
     }
 
+    ScaleValues scales(alpha, beta);
     auto capture = encoder.capture_context();
     CHECK_CUBLAS_ERROR(cublasLtMatmul(
         handle_,
         matmul_desc_,
-        &alpha,
-        a,
-        a_desc_,
+        scales.alpha(scale_type_),
         b,
         b_desc_,
-        &beta,
+        a,
+        a_desc_,
+        scales.beta(scale_type_),
         c ? c : out,
         c ? c_desc_ : out_desc_,
         out,
@@ -208,24 +404,287 @@ class MatMul {
   }
 
  private:
-  cublasComputeType_t dtype_to_compute_type(Dtype dtype) {
-    switch (dtype) {
-      case float16:
-        return CUBLAS_COMPUTE_32F;
-      case bfloat16:
-        return CUBLAS_COMPUTE_32F;
-      case float32:
-        return mlx::core::env::enable_tf32() ? CUBLAS_COMPUTE_32F_FAST_TF32
-                                             : CUBLAS_COMPUTE_32F;
-      case float64:
-      case complex64:
-        return CUBLAS_COMPUTE_64F;
-      default:
-        throw std::runtime_error(fmt::format(
-            "Unsupported dtype in MatMul: {}.", dtype_to_string(dtype)));
+  // The alpha and beta of cublasLt have the scale type of the matmul, which
+  // is an integer for the int32 matmuls and a half for the half accumulation.
+  struct ScaleValues {
+    ScaleValues(float alpha, float beta)
+        : f{alpha, beta},
+          i{static_cast<int32_t>(alpha), static_cast<int32_t>(beta)},
+          h{__float2half(alpha), __float2half(beta)} {}
+    const void* alpha(cudaDataType_t type) const {
+      return get(type, 0);
+    }
+    const void* beta(cudaDataType_t type) const {
+      return get(type, 1);
+    }
+    const void* get(cudaDataType_t type, int index) const {
+      switch (type) {
+        case CUDA_R_32I:
+          return &i[index];
+        case CUDA_R_16F:
+          return &h[index];
+        default:
+          return &f[index];
+      }
+    }
+    float f[2];
+    int32_t i[2];
+    __half h[2];
+  };
+
+  void find_algorithm() {
+    int candidates = matmul_autotune_candidates();
+    if (candidates > 1 && !autotune_key_.empty() && !aux_) {
+      autotune(candidates);
+      return;
+    }
+    int ret = 0;
+    CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoGetHeuristic(
+        handle_,
+        matmul_desc_,
+        b_desc_,
+        a_desc_,
+        out_desc_,
+        out_desc_,
+        pref_,
+        1,
+        &heuristic_,
+        &ret));
+    if (ret == 0) {
+      throw std::runtime_error("Can not find algorithm for matmul.");
+    }
+    if (auto split = split_k(heuristic_)) {
+      heuristic_ = *split;
     }
   }
 
+  void autotune(int candidates) {
+    auto& tuned = tuned_algorithms(device_);
+    if (auto it = tuned.find(autotune_key_); it != tuned.end()) {
+      cublasLtMatmulHeuristicResult_t result;
+      if (cublasLtMatmulAlgoCheck(
+              handle_,
+              matmul_desc_,
+              b_desc_,
+              a_desc_,
+              out_desc_,
+              out_desc_,
+              &it->second,
+              &result) == CUBLAS_STATUS_SUCCESS) {
+        heuristic_ = result;
+        heuristic_.algo = it->second;
+        return;
+      }
+    }
+
+    std::vector<cublasLtMatmulHeuristicResult_t> results(candidates);
+    int ret = 0;
+    CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoGetHeuristic(
+        handle_,
+        matmul_desc_,
+        b_desc_,
+        a_desc_,
+        out_desc_,
+        out_desc_,
+        pref_,
+        candidates,
+        results.data(),
+        &ret));
+    if (ret == 0) {
+      throw std::runtime_error("Can not find algorithm for matmul.");
+    }
+    // Also time the best algorithm with K split.
+    if (auto split = split_k(results[0])) {
+      results.resize(ret);
+      results.push_back(*split);
+      ret = results.size();
+    }
+    int best = 0;
+    if (ret > 1) {
+      best = benchmark(results.data(), ret);
+    }
+    heuristic_ = results[best];
+    save_tuned_algorithm(device_, autotune_key_, heuristic_.algo);
+  }
+
+  // Return the index of the fastest of the |n| algorithms, timed with
+  // scratch buffers on a separate stream as the inputs of the matmul may
+  // not have been computed yet.
+  int benchmark(const cublasLtMatmulHeuristicResult_t* results, int n) {
+    constexpr int iterations = 5;
+    device_.make_current();
+    size_t workspace_size = 0;
+    for (int i = 0; i < n; ++i) {
+      workspace_size = std::max(workspace_size, results[i].workspaceSize);
+    }
+    std::vector<allocator::Buffer> buffers;
+    auto scratch = [&](size_t nbytes) {
+      buffers.push_back(allocator::malloc(std::max<size_t>(nbytes, 1)));
+      return buffers.back().raw_ptr();
+    };
+    void* a = scratch(a_size_ * in_itemsize_);
+    void* b = scratch(b_size_ * in_itemsize_);
+    void* out = scratch(out_size_ * itemsize_);
+    void* workspace = scratch(workspace_size);
+    if (bias_) {
+      const void* bias = scratch(out_rows_ * itemsize_);
+      CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+          matmul_desc_,
+          CUBLASLT_MATMUL_DESC_BIAS_POINTER,
+          &bias,
+          sizeof(const void*)));
+    }
+
+    CudaStream stream(device_);
+    cudaEvent_t start, end;
+    CHECK_CUDA_ERROR(cudaEventCreate(&start));
+    CHECK_CUDA_ERROR(cudaEventCreate(&end));
+    CHECK_CUDA_ERROR(cudaMemsetAsync(a, 0, a_size_ * in_itemsize_, stream));
+    CHECK_CUDA_ERROR(cudaMemsetAsync(b, 0, b_size_ * in_itemsize_, stream));
+    ScaleValues scales(1, 0);
+    auto matmul = [&](const cublasLtMatmulAlgo_t& algo) {
+      return cublasLtMatmul(
+          handle_,
+          matmul_desc_,
+          scales.alpha(scale_type_),
+          b,
+          b_desc_,
+          a,
+          a_desc_,
+          scales.beta(scale_type_),
+          out,
+          out_desc_,
+          out,
+          out_desc_,
+          &algo,
+          workspace,
+          workspace_size,
+          stream);
+    };
+    int best = 0;
+    float best_ms = std::numeric_limits<float>::infinity();
+    for (int i = 0; i < n; ++i) {
+      // Warm up, and skip the algorithms failing to launch.
+      if (matmul(results[i].algo) != CUBLAS_STATUS_SUCCESS) {
+        continue;
+      }
+      CHECK_CUDA_ERROR(cudaEventRecord(start, stream));
+      for (int j = 0; j < iterations; ++j) {
+        matmul(results[i].algo);
+      }
+      CHECK_CUDA_ERROR(cudaEventRecord(end, stream));
+      CHECK_CUDA_ERROR(cudaEventSynchronize(end));
+      float ms;
+      CHECK_CUDA_ERROR(cudaEventElapsedTime(&ms, start, end));
+      if (ms < best_ms) {
+        best_ms = ms;
+        best = i;
+      }
+    }
+    CHECK_CUDA_ERROR(cudaStreamSynchronize(stream));
+    CHECK_CUDA_ERROR(cudaEventDestroy(start));
+    CHECK_CUDA_ERROR(cudaEventDestroy(end));
+    for (auto& buffer : buffers) {
+      allocator::free(buffer);
+    }
+    if (bias_) {
+      set_bias(bias_);
+    }
+    return best;
+  }
+
+  // Return the algorithm of |result| with K split across more blocks when
+  // its output tiles fill less than half of the GPU, which is the case of
+  // the skinny matmuls with a long K such as the gradients of the weights.
+  // The partial products are reduced in a second pass over the workspace.
+  std::optional<cublasLtMatmulHeuristicResult_t> split_k(
+      const cublasLtMatmulHeuristicResult_t& result) {
+    // The fewest elements of K computed by each split.
+    constexpr int64_t min_split_size = 256;
+    constexpr int64_t max_splits = 16;
+    if (!matmul_split_k() || result.wavesCount <= 0 ||
+        result.wavesCount > 0.5f) {
+      return std::nullopt;
+    }
+    int64_t splits = std::min(
+        {static_cast<int64_t>(1 / result.wavesCount),
+         k_ / min_split_size,
+         max_splits});
+    if (splits < 2) {
+      return std::nullopt;
+    }
+
+    size_t written;
+    int32_t supported = 0;
+    CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoCapGetAttribute(
+        &result.algo,
+        CUBLASLT_ALGO_CAP_SPLITK_SUPPORT,
+        &supported,
+        sizeof(int32_t),
+        &written));
+    uint32_t current_splits = 1;
+    CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoConfigGetAttribute(
+        &result.algo,
+        CUBLASLT_ALGO_CONFIG_SPLITK_NUM,
+        &current_splits,
+        sizeof(uint32_t),
+        &written));
+    if (!supported || current_splits > 1) {
+      return std::nullopt;
+    }
+    uint32_t schemes = 0;
+    CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoCapGetAttribute(
+        &result.algo,
+        CUBLASLT_ALGO_CAP_REDUCTION_SCHEME_MASK,
+        &schemes,
+        sizeof(uint32_t),
+        &written));
+
+    // Prefer reducing in the compute type, then in the type of out, then in
+    // place with atomics on out.
+    for (uint32_t scheme :
+         {CUBLASLT_REDUCTION_SCHEME_COMPUTE_TYPE,
+          CUBLASLT_REDUCTION_SCHEME_OUTPUT_TYPE,
+          CUBLASLT_REDUCTION_SCHEME_INPLACE}) {
+      if (!(schemes & scheme)) {
+        continue;
+      }
+      cublasLtMatmulAlgo_t algo = result.algo;
+      uint32_t num = splits;
+      CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoConfigSetAttribute(
+          &algo, CUBLASLT_ALGO_CONFIG_SPLITK_NUM, &num, sizeof(uint32_t)));
+      CHECK_CUBLAS_ERROR(cublasLtMatmulAlgoConfigSetAttribute(
+          &algo,
+          CUBLASLT_ALGO_CONFIG_REDUCTION_SCHEME,
+          &scheme,
+          sizeof(uint32_t)));
+      cublasLtMatmulHeuristicResult_t split;
+      if (cublasLtMatmulAlgoCheck(
+              handle_,
+              matmul_desc_,
+              b_desc_,
+              a_desc_,
+              out_desc_,
+              out_desc_,
+              &algo,
+              &split) == CUBLAS_STATUS_SUCCESS &&
+          split.workspaceSize <= cublas_workspace_size(device_)) {
+        split.algo = algo;
+        return split;
+      }
+    }
+    return std::nullopt;
+  }
+
+  void set_bias(const void* bias) {
+    CHECK_CUBLAS_ERROR(cublasLtMatmulDescSetAttribute(
+        matmul_desc_,
+        CUBLASLT_MATMUL_DESC_BIAS_POINTER,
+        &bias,
+        sizeof(const void*)));
+    bias_ = bias;
+  }
+
   cudaDataType_t dtype_to_cuda_type(Dtype dtype) {
     switch (dtype) {
       case float16:
@@ -238,26 +697,24 @@ class MatMul {
         return CUDA_R_64F;
       case complex64:
         return CUDA_C_32F;
+      case int32:
+        return CUDA_R_32I;
       default:
         throw std::runtime_error(fmt::format(
             "Unsupported dtype in MatMul: {}.", dtype_to_string(dtype)));
     }
   }
 
+  // Create the layout of a column-major matrix.
   cublasLtMatrixLayout_t create_matrix_layout(
       cudaDataType_t type,
       uint64_t rows,
       uint64_t cols,
-      bool transposed,
       int64_t ld,
       int32_t batch_count,
       int64_t batch_stride) {
     cublasLtMatrixLayout_t desc;
     CHECK_CUBLAS_ERROR(cublasLtMatrixLayoutCreate(&desc, type, rows, cols, ld));
-    cublasLtOrder_t order =
-        transposed ? CUBLASLT_ORDER_COL : CUBLASLT_ORDER_ROW;
-    CHECK_CUBLAS_ERROR(cublasLtMatrixLayoutSetAttribute(
-        desc, CUBLASLT_MATRIX_LAYOUT_ORDER, &order, sizeof(cublasLtOrder_t)));
     if (batch_count > 1) {
       CHECK_CUBLAS_ERROR(cublasLtMatrixLayoutSetAttribute(
           desc,
@@ -273,16 +730,120 @@ class MatMul {
     return desc;
   }
 
-  cublasLtMatmulPreference_t pref_{nullptr};
+  Device& device_;
   cublasLtHandle_t handle_{nullptr};
+  cublasLtMatmulPreference_t pref_{nullptr};
   cublasLtMatmulDesc_t matmul_desc_{nullptr};
   cublasLtMatrixLayout_t a_desc_{nullptr};
   cublasLtMatrixLayout_t b_desc_{nullptr};
   cublasLtMatrixLayout_t c_desc_{nullptr};
   cublasLtMatrixLayout_t out_desc_{nullptr};
   cublasLtMatmulHeuristicResult_t heuristic_;
+  cudaDataType_t scale_type_;
+  cublasLtEpilogue_t epilogue_{CUBLASLT_EPILOGUE_DEFAULT};
+  const void* bias_{nullptr};
+  void* aux_{nullptr};
+  std::string autotune_key_;
+  int64_t k_;
+  // The sizes of the scratch buffers of autotuning.
+  size_t itemsize_;
+  size_t in_itemsize_;
+  int64_t a_size_;
+  int64_t b_size_;
+  int64_t out_rows_;
+  int64_t out_size_;
 };
 
+// The matmuls are cached by their problem, so the descriptors are created
+// and the algorithm is chosen once per shape and compute type.
+template <typename... Args>
+std::shared_ptr<MatMul> get_matmul(
+    Device& device,
+    Dtype dtype,
+    MatmulPrecision precision,
+    cublasLtEpilogue_t epilogue,
+    Args... args) {
+  static LRUCache<std::string, std::shared_ptr<MatMul>> cache(
+      matmul_cache_size());
+  auto compute_type = cublas_compute_type(dtype, precision);
+  std::string key = fmt::format(
+      "{}.{}.{}",
+      dtype_to_string(dtype),
+      static_cast<int>(epilogue),
+      static_cast<int>(compute_type));
+  ((key += "." + std::to_string(args)), ...);
+  return cache.get_or_create(
+      std::to_string(device.cuda_device()) + ":" + key, [&]() {
+        auto matmul =
+            std::make_shared<MatMul>(device, dtype, compute_type, args...);
+        matmul->set_epilogue(epilogue);
+        matmul->set_autotune_key(key);
+        return matmul;
+      });
+}
+
+// The matmuls out = a @ b^T of the float8 e4m3 a [M, K] and b [N, K], with
+// out of type |dtype|. The transposed b is the TN layout required by the
+// float8 kernels of cublasLt.
+std::shared_ptr<MatMul>
+get_fp8_matmul(Device& device, Dtype dtype, int M, int N, int K) {
+  static LRUCache<std::string, std::shared_ptr<MatMul>> cache(
+      matmul_cache_size());
+  std::string key =
+      fmt::format("fp8.{}.{}.{}.{}", dtype_to_string(dtype), M, N, K);
+  return cache.get_or_create(
+      std::to_string(device.cuda_device()) + ":" + key, [&]() {
+        auto matmul = std::make_shared<MatMul>(
+            device,
+            dtype,
+            CUBLAS_COMPUTE_32F,
+            false,
+            M,
+            K,
+            K,
+            true,
+            K,
+            N,
+            K,
+            1,
+            0,
+            0);
+        matmul->set_input_type(CUDA_R_8F_E4M3, 1);
+        matmul->set_autotune_key(key);
+        return matmul;
+      });
+}
+
+// The matmuls acc = a @ b^T of the int8 a [M, K] and b [N, K] accumulated
+// in int32, which run on the integer tensor cores. They also need the TN
+// layout.
+std::shared_ptr<MatMul> get_int8_matmul(Device& device, int M, int N, int K) {
+  static LRUCache<std::string, std::shared_ptr<MatMul>> cache(
+      matmul_cache_size());
+  std::string key = fmt::format("int8.{}.{}.{}", M, N, K);
+  return cache.get_or_create(
+      std::to_string(device.cuda_device()) + ":" + key, [&]() {
+        auto matmul = std::make_shared<MatMul>(
+            device,
+            int32,
+            CUBLAS_COMPUTE_32I,
+            false,
+            M,
+            K,
+            K,
+            true,
+            K,
+            N,
+            K,
+            1,
+            0,
+            0);
+        matmul->set_input_type(CUDA_R_8I, 1);
+        matmul->set_autotune_key(key);
+        return matmul;
+      });
+}
+
 } // namespace cu
 
 namespace {
@@ -291,10 +852,21 @@ std::tuple<bool, int64_t, array>
 check_transpose(cu::CommandEncoder& enc, const Stream& s, const array& arr) {
   auto stx = arr.strides()[arr.ndim() - 2];
   auto sty = arr.strides()[arr.ndim() - 1];
+  // The slices of a matrix only have larger leading dimensions, which are
+  // used as is when the rows and the data keep the 16 bytes alignment of the
+  // tensor cores.
+  auto aligned = [&arr](int64_t ld) {
+    auto ptr = reinterpret_cast<uintptr_t>(arr.data<void>());
+    return (ld * arr.itemsize()) % 16 == 0 && ptr % 16 == 0;
+  };
   if (sty == 1 && stx == arr.shape(-1)) {
     return std::make_tuple(false, stx, arr);
   } else if (stx == 1 && sty == arr.shape(-2)) {
     return std::make_tuple(true, sty, arr);
+  } else if (sty == 1 && stx > arr.shape(-1) && aligned(stx)) {
+    return std::make_tuple(false, stx, arr);
+  } else if (stx == 1 && sty > arr.shape(-2) && aligned(sty)) {
+    return std::make_tuple(true, sty, arr);
   } else {
     array arr_copy = contiguous_copy_gpu(arr, s);
     enc.add_temporary(arr_copy);
@@ -302,24 +874,17 @@ check_transpose(cu::CommandEncoder& enc, const Stream& s, const array& arr) {
   }
 }
 
-} // namespace
-
-void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
-  nvtx3::scoped_range r("Matmul::eval_gpu");
-  auto& s = stream();
+// Compute out = a @ b with |precision| followed by the |epilogue| of
+// cublasLt, with the vector |bias| of the BIAS epilogues.
+void matmul_gpu(
+    const Stream& s,
+    const array& a_pre,
+    const array& b_pre,
+    array& out,
+    MatmulPrecision precision,
+    cublasLtEpilogue_t epilogue = CUBLASLT_EPILOGUE_DEFAULT,
+    const array* bias = nullptr) {
   auto& encoder = cu::get_command_encoder(s);
-
-  assert(inputs.size() == 2);
-  auto& a_pre = inputs[0];
-  auto& b_pre = inputs[1];
-  // Return 0s if either input is empty.
-  if (a_pre.size() == 0 || b_pre.size() == 0) {
-    array zero(0, a_pre.dtype());
-    encoder.add_temporary(zero);
-    fill_gpu(zero, out, s);
-    return;
-  }
-
   out.set_data(allocator::malloc(out.nbytes()));
 
   /////////////////////////////////////////////////////////////////////////////
@@ -353,12 +918,68 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
     batch_shape = {1};
   }
 
+  /////////////////////////////////////////////////////////////////////////////
+  // Dispatch the decode sized problems to the gemv kernels
+
+  bool relu = epilogue == CUBLASLT_EPILOGUE_RELU ||
+      epilogue == CUBLASLT_EPILOGUE_RELU_BIAS;
+  bool gemv_epilogue = relu || epilogue == CUBLASLT_EPILOGUE_DEFAULT ||
+      epilogue == CUBLASLT_EPILOGUE_BIAS;
+  if (gemv_epilogue && batch_count <= 65535 &&
+      can_use_gemv(M, N, a_transposed, out.dtype(), bias != nullptr)) {
+    gemv(
+        a,
+        b,
+        out,
+        M,
+        N,
+        K,
+        a_transposed,
+        lda,
+        b_transposed,
+        ldb,
+        batch_shape,
+        a_batch_strides,
+        b_batch_strides,
+        bias,
+        relu,
+        encoder);
+    return;
+  }
+
+  // The batches which can not be collapsed into one strided batch run in a
+  // single launch with pointer arrays, instead of a matmul per outer batch.
+  if (batch_count > batch_shape.back() &&
+      epilogue == CUBLASLT_EPILOGUE_DEFAULT &&
+      can_use_gemm_batched(out.dtype())) {
+    gemm_batched(
+        a,
+        b,
+        out,
+        M,
+        N,
+        K,
+        a_transposed,
+        lda,
+        b_transposed,
+        ldb,
+        batch_shape,
+        a_batch_strides,
+        b_batch_strides,
+        precision,
+        encoder,
+        s);
+    return;
+  }
+
   /////////////////////////////////////////////////////////////////////////////
   // Invoke cublasLt
 
-  cu::MatMul matmul(
+  auto matmul = cu::get_matmul(
       cu::device(s.device),
       a.dtype(),
+      precision,
+      epilogue,
       a_transposed,
       M,
       K,
@@ -370,13 +991,20 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
       batch_shape.back(),
       a_batch_strides.back(),
       b_batch_strides.back());
+  if (bias) {
+    matmul->set_epilogue(epilogue, bias->data<void>());
+  }
 
   encoder.set_input_array(a);
   encoder.set_input_array(b);
+  if (bias) {
+    encoder.set_input_array(*bias);
+  }
   encoder.set_output_array(out);
   auto nbatch = batch_count / batch_shape.back();
   if (nbatch == 1) {
-    matmul.run(encoder, out.data<int8_t>(), a.data<int8_t>(), b.data<int8_t>());
+    matmul->run(
+        encoder, out.data<int8_t>(), a.data<int8_t>(), b.data<int8_t>());
     return;
   }
 
@@ -384,7 +1012,7 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
   ContiguousIterator b_it(batch_shape, b_batch_strides, batch_shape.size() - 1);
   auto concurrent = encoder.concurrent_context();
   for (size_t i = 0; i < nbatch; ++i) {
-    matmul.run(
+    matmul->run(
         encoder,
         out.data<int8_t>() + out.itemsize() * i * batch_shape.back() * M * N,
         a.data<int8_t>() + a.itemsize() * a_it.loc,
@@ -394,6 +1022,182 @@ void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+} // namespace
+
+void Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Matmul::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  assert(inputs.size() == 2);
+  auto& a_pre = inputs[0];
+  auto& b_pre = inputs[1];
+  // Return 0s if either input is empty.
+  if (a_pre.size() == 0 || b_pre.size() == 0) {
+    array zero(0, a_pre.dtype());
+    encoder.add_temporary(zero);
+    fill_gpu(zero, out, s);
+    return;
+  }
+
+  matmul_gpu(s, a_pre, b_pre, out, precision_);
+}
+
+void fast::FusedMatmul::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  nvtx3::scoped_range r("FusedMatmul::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  assert(inputs.size() == 2 || inputs.size() == 3);
+  const array* bias = nullptr;
+  std::optional<array> bias_copy;
+  if (inputs.size() == 3) {
+    bias = &inputs[2];
+    if (!bias->flags().row_contiguous) {
+      bias_copy = contiguous_copy_gpu(*bias, s);
+      encoder.add_temporary(*bias_copy);
+      bias = &*bias_copy;
+    }
+  }
+
+  cublasLtEpilogue_t epilogue;
+  if (activation_ == ReLU) {
+    epilogue = bias ? CUBLASLT_EPILOGUE_RELU_BIAS : CUBLASLT_EPILOGUE_RELU;
+  } else {
+    epilogue = bias ? CUBLASLT_EPILOGUE_BIAS : CUBLASLT_EPILOGUE_DEFAULT;
+  }
+  matmul_gpu(s, inputs[0], inputs[1], out, precision_, epilogue, bias);
+}
+
+bool fast::Fp8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  if (s.device == Device::cpu) {
+    return true;
+  }
+  // The float8 tensor cores need sm_89 or newer, and the leading dimensions
+  // of the float8 operands need to be multiples of 16 bytes.
+  auto& d = cu::device(s.device);
+  int arch = d.compute_capability_major() * 10 + d.compute_capability_minor();
+  bool supported_type = x.dtype() == float16 || x.dtype() == bfloat16;
+  return arch < 89 || !supported_type || x.shape(-1) % 16 != 0 ||
+      w.shape(0) % 16 != 0;
+}
+
+void fast::Fp8Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Fp8Matmul::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  assert(inputs.size() == 3);
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array x = ensure_row_contiguous(inputs[0]);
+  array w = ensure_row_contiguous(inputs[1]);
+  array scales = ensure_row_contiguous(inputs[2]);
+  int K = x.shape(-1);
+  int N = w.shape(0);
+  int M = x.size() / K;
+
+  // Quantize x with a per-tensor scale, as the kernels of cublasLt only take
+  // scalar scales.
+  array x_q(x.shape(), uint8, nullptr, {});
+  x_q.set_data(allocator::malloc(x_q.nbytes()));
+  encoder.add_temporary(x_q);
+  array x_scale({1}, float32, nullptr, {});
+  x_scale.set_data(allocator::malloc(x_scale.nbytes()));
+  encoder.add_temporary(x_scale);
+  fp8_quantize(x, x_q, x_scale, encoder);
+
+  bool per_tensor = scales.size() == 1;
+  auto matmul =
+      cu::get_fp8_matmul(cu::device(s.device), out.dtype(), M, N, K);
+  matmul->set_scales(
+      x_scale.data<void>(), per_tensor ? scales.data<void>() : nullptr);
+  encoder.set_input_array(x_q);
+  encoder.set_input_array(w);
+  encoder.set_input_array(x_scale);
+  encoder.set_input_array(scales);
+  encoder.set_output_array(out);
+  matmul->run(
+      encoder, out.data<int8_t>(), x_q.data<int8_t>(), w.data<int8_t>());
+
+  // The per-channel scales multiply the columns of the result.
+  if (!per_tensor) {
+    fp8_scale_columns(out, scales, encoder);
+  }
+}
+
+bool fast::Int8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  if (s.device == Device::cpu) {
+    return true;
+  }
+  // The integer tensor cores need sm_75 or newer, and the leading dimensions
+  // of the int8 operands need to be multiples of 16 bytes.
+  auto& d = cu::device(s.device);
+  int arch = d.compute_capability_major() * 10 + d.compute_capability_minor();
+  return arch < 75 || x.shape(-1) % 16 != 0 || w.shape(0) % 16 != 0;
+}
+
+void fast::Int8Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("Int8Matmul::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  assert(inputs.size() == 3);
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array x = ensure_row_contiguous(inputs[0]);
+  array w = ensure_row_contiguous(inputs[1]);
+  array scales = ensure_row_contiguous(inputs[2]);
+  int K = x.shape(-1);
+  int N = w.shape(0);
+  int M = x.size() / K;
+
+  // Quantize each row of x, the tokens, with its own scale.
+  array x_q(x.shape(), int8, nullptr, {});
+  x_q.set_data(allocator::malloc(x_q.nbytes()));
+  encoder.add_temporary(x_q);
+  array x_scales({M}, float32, nullptr, {});
+  x_scales.set_data(allocator::malloc(x_scales.nbytes()));
+  encoder.add_temporary(x_scales);
+  int8_quantize_rows(x, x_q, x_scales, encoder);
+
+  array acc({M, N}, int32, nullptr, {});
+  acc.set_data(allocator::malloc(acc.nbytes()));
+  encoder.add_temporary(acc);
+  auto matmul = cu::get_int8_matmul(cu::device(s.device), M, N, K);
+  encoder.set_input_array(x_q);
+  encoder.set_input_array(w);
+  encoder.set_output_array(acc);
+  matmul->run(
+      encoder, acc.data<int8_t>(), x_q.data<int8_t>(), w.data<int8_t>());
+
+  // The scales of the rows and the columns are applied when converting the
+  // int32 products to the type of out.
+  int8_dequantize(acc, x_scales, scales, out, encoder);
+}
+
 void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("AddMM::eval_gpu");
   auto& s = stream();
@@ -459,9 +1263,11 @@ void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   /////////////////////////////////////////////////////////////////////////////
   // Invoke cublasLt
 
-  cu::MatMul matmul(
+  auto matmul = cu::get_matmul(
       cu::device(s.device),
       a.dtype(),
+      precision_,
+      CUBLASLT_EPILOGUE_DEFAULT,
       a_transposed,
       M,
       K,
@@ -483,7 +1289,7 @@ void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
 
   auto nbatch = batch_count / batch_shape.back();
   if (nbatch == 1) {
-    matmul.run(
+    matmul->run(
         encoder,
         out.data<int8_t>(),
         a.data<int8_t>(),
@@ -499,7 +1305,7 @@ void AddMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   ContiguousIterator c_it(batch_shape, c_batch_strides, batch_shape.size() - 1);
   auto concurrent = encoder.concurrent_context();
   for (size_t i = 0; i < nbatch; ++i) {
-    matmul.run(
+    matmul->run(
         encoder,
         out.data<int8_t>() + out.itemsize() * i * batch_shape.back() * M * N,
         a.data<int8_t>() + a.itemsize() * a_it.loc,
@@ -0,0 +1,205 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/megakernel.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/utils.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// The kernel parameters are limited to 4KB and the number of megakernels
+// compiled grows with the number of stages in them.
+constexpr size_t max_megakernel_params = 256;
+constexpr size_t max_megakernel_stages = 32;
+
+constexpr const char* megakernel_includes = R"(
+#include "mlx/backend/cuda/device/binary_ops.cuh"
+#include "mlx/backend/cuda/device/ternary_ops.cuh"
+#include "mlx/backend/cuda/device/unary_ops.cuh"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
+#include "mlx/backend/cuda/device/utils.cuh"
+
+#include <cooperative_groups.h>
+
+#define inf cuda::std::numeric_limits<float>::infinity()
+)";
+
+// The source of a megakernel calling the device functions of |stages| one
+// after the other with a grid barrier between them.
+KernelBuilderResult build_megakernel(
+    const std::vector<MegakernelStage>& stages) {
+  std::string os = megakernel_includes;
+  os +=
+      "namespace mlx::core::cu {\n\n"
+      "namespace cg = cooperative_groups;\n\n";
+  std::vector<const MegakernelSource*> sources;
+  for (const auto& stage : stages) {
+    if (std::find(sources.begin(), sources.end(), stage.source) ==
+        sources.end()) {
+      sources.push_back(stage.source);
+      os += stage.source->source;
+      os += "\n";
+    }
+  }
+  std::vector<std::string> params;
+  std::string body;
+  for (size_t i = 0; i < stages.size(); ++i) {
+    if (i > 0) {
+      body += "  grid.sync();\n";
+    }
+    body += fmt::format("  {}(", stages[i].source->name);
+    const auto& types = stages[i].source->param_types;
+    for (size_t j = 0; j < types.size(); ++j) {
+      std::string name = fmt::format("s{}_{}", i, j);
+      params.push_back(fmt::format("{} {}", types[j], name));
+      body += j > 0 ? ", " + name : name;
+    }
+    body += ");\n";
+  }
+  os += "__global__ void megakernel(\n";
+  for (size_t i = 0; i < params.size(); ++i) {
+    os += "    " + params[i];
+    os += i + 1 < params.size() ? ",\n" : ") {\n";
+  }
+  os += "  auto grid = cg::this_grid();\n";
+  os += body;
+  os += "}\n\n} // namespace mlx::core::cu\n";
+  return std::make_pair(
+      std::move(os), std::vector<std::string>{"mlx::core::cu::megakernel"});
+}
+
+// The name of the module of the megakernel running |stages|.
+std::string megakernel_module_name(
+    const std::vector<MegakernelStage>& stages) {
+  std::string names;
+  for (const auto& stage : stages) {
+    names += stage.source->name;
+    names += ';';
+  }
+  return fmt::format(
+      "megakernel_{}_{:016x}", stages.size(), std::hash<std::string>{}(names));
+}
+
+bool cooperative_launch_supported() {
+  static bool supported = []() {
+    int device;
+    CHECK_CUDA_ERROR(cudaGetDevice(&device));
+    int value = 0;
+    CHECK_CUDA_ERROR(
+        cudaDeviceGetAttribute(&value, cudaDevAttrCooperativeLaunch, device));
+    return value != 0;
+  }();
+  return supported;
+}
+
+} // namespace
+
+const MegakernelSource& megakernel_source(
+    const std::string& name,
+    const std::function<MegakernelSource()>& builder) {
+  static std::unordered_map<std::string, MegakernelSource> sources;
+  static std::mutex mtx;
+  std::lock_guard lock(mtx);
+  auto it = sources.find(name);
+  if (it == sources.end()) {
+    it = sources.emplace(name, builder()).first;
+  }
+  return it->second;
+}
+
+void Megakernel::add(MegakernelStage stage) {
+  size_t num_params = stage.source->param_types.size();
+  if (stages_.size() == max_megakernel_stages ||
+      num_params_ + num_params > max_megakernel_params) {
+    flush();
+  }
+  num_params_ += num_params;
+  stages_.push_back(std::move(stage));
+}
+
+void Megakernel::flush() {
+  // Adding the nodes flushes the stages again, so they are taken first.
+  auto stages = std::move(stages_);
+  stages_.clear();
+  num_params_ = 0;
+  if (stages.empty()) {
+    return;
+  }
+
+  auto& device = encoder_.device();
+  CUfunction kernel = nullptr;
+  if (stages.size() > 1 && cooperative_launch_supported()) {
+    auto& mod = get_jit_module(
+        mlx::core::Device(mlx::core::Device::gpu, device.cuda_device()),
+        megakernel_module_name(stages),
+        [&]() { return build_megakernel(stages); });
+    kernel = async_jit_enabled()
+        ? mod.get_kernel_async("mlx::core::cu::megakernel")
+        : mod.get_kernel("mlx::core::cu::megakernel");
+  }
+  if (!kernel) {
+    for (auto& stage : stages) {
+      for (const auto& in : stage.inputs) {
+        encoder_.set_input_array(in);
+      }
+      for (const auto& out : stage.outputs) {
+        encoder_.set_output_array(out);
+      }
+      encoder_.add_dependent_kernel_node(
+          stage.kernel,
+          stage.num_blocks,
+          stage.block_dims,
+          stage.args.args());
+    }
+    return;
+  }
+
+  // All the blocks must be resident for the grid barriers.
+  int blocks_per_sm = 0;
+  CHECK_CUDA_ERROR(cuOccupancyMaxActiveBlocksPerMultiprocessor(
+      &blocks_per_sm, kernel, megakernel_block_dim, 0));
+  uint32_t work_blocks = 1;
+  std::vector<void*> params;
+  for (auto& stage : stages) {
+    work_blocks = std::max(work_blocks, stage.work_blocks);
+    void** args = stage.args.args();
+    params.insert(
+        params.end(), args, args + stage.source->param_types.size());
+    for (const auto& in : stage.inputs) {
+      encoder_.set_input_array(in);
+    }
+    for (const auto& out : stage.outputs) {
+      encoder_.set_output_array(out);
+    }
+  }
+  uint32_t resident_blocks =
+      std::max(blocks_per_sm, 1) * device.multi_processor_count();
+  encoder_.add_kernel_node(
+      kernel,
+      std::min(work_blocks, resident_blocks),
+      megakernel_block_dim,
+      params.data(),
+      0,
+      /* cooperative */ true);
+}
+
+bool megakernel_enabled() {
+  static bool enabled = env::get_var("MLX_CUDA_MEGAKERNEL", 0);
+  return enabled;
+}
+
+int64_t megakernel_max_size() {
+  static int64_t max_size =
+      env::get_var("MLX_CUDA_MEGAKERNEL_MAX_SIZE", 1 << 16);
+  return max_size;
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,81 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+#include "mlx/backend/cuda/jit_module.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include <cuda.h>
+
+namespace mlx::core::cu {
+
+class CommandEncoder;
+
+// The threads of the blocks of a megakernel.
+constexpr int megakernel_block_dim = 256;
+
+// The device function running a fused kernel as a stage of a megakernel,
+// with the types of its parameters which are the parameters of the kernel.
+struct MegakernelSource {
+  std::string name;
+  std::string source;
+  std::vector<std::string> param_types;
+};
+
+// Get the source of the stage |name|, built once.
+const MegakernelSource& megakernel_source(
+    const std::string& name,
+    const std::function<MegakernelSource()>& builder);
+
+// A small fused kernel deferred to run in a megakernel, or alone with its
+// own kernel.
+struct MegakernelStage {
+  const MegakernelSource* source;
+  CUfunction kernel;
+  dim3 num_blocks;
+  dim3 block_dims;
+  // The arguments of the kernel, which start with those of the stage.
+  KernelArgs args;
+  // The blocks of megakernel_block_dim threads the stage has work for.
+  uint32_t work_blocks;
+  std::vector<array> inputs;
+  std::vector<array> outputs;
+};
+
+// The consecutive small fused kernels of a command encoder, which run in a
+// single persistent kernel with grid wide barriers between them instead of
+// one kernel each, when the launches would cost more than their work.
+class Megakernel {
+ public:
+  explicit Megakernel(CommandEncoder& encoder) : encoder_(encoder) {}
+
+  // Defer |stage| until the next node of the encoder is added.
+  void add(MegakernelStage stage);
+
+  // Add the deferred stages to the graph of the encoder, in one kernel once
+  // it is compiled and with their own kernels until then.
+  void flush();
+
+  bool empty() const {
+    return stages_.empty();
+  }
+
+ private:
+  CommandEncoder& encoder_;
+  std::vector<MegakernelStage> stages_;
+  size_t num_params_{0};
+};
+
+// Whether the small fused kernels run in megakernels, enabled by setting
+// MLX_CUDA_MEGAKERNEL=1.
+bool megakernel_enabled();
+
+// The most elements computed by a fused kernel run in a megakernel, can be
+// tuned with MLX_CUDA_MEGAKERNEL_MAX_SIZE.
+int64_t megakernel_max_size();
+
+} // namespace mlx::core::cu
@@ -0,0 +1,163 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/memory_tracer.h"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// The primitive being evaluated by the thread, if any.
+thread_local const char* current_tag = nullptr;
+
+constexpr const char* unattributed_tag = "<unattributed>";
+
+} // namespace
+
+MemoryTracer::Scope::Scope(const char* name) : previous_(current_tag) {
+  current_tag = name;
+}
+
+MemoryTracer::Scope::~Scope() {
+  current_tag = previous_;
+}
+
+double MemoryTracer::now_us() const {
+  return std::chrono::duration<double, std::micro>(
+             std::chrono::steady_clock::now() - start_)
+      .count();
+}
+
+void MemoryTracer::start() {
+  std::lock_guard lock(mutex_);
+  start_ = std::chrono::steady_clock::now();
+  records_.clear();
+  live_.clear();
+  num_events_ = 0;
+  active_memory_ = 0;
+  peak_memory_ = 0;
+  peak_event_ = -1;
+  enabled_ = true;
+}
+
+void MemoryTracer::stop() {
+  enabled_ = false;
+}
+
+void MemoryTracer::on_malloc(const void* buffer, size_t size, int device) {
+  std::lock_guard lock(mutex_);
+  int64_t event = num_events_++;
+  live_[buffer] = records_.size();
+  records_.push_back(Record{
+      current_tag ? current_tag : unattributed_tag,
+      size,
+      device,
+      false,
+      event,
+      -1,
+      now_us(),
+      -1});
+  active_memory_ += size;
+  if (active_memory_ > peak_memory_) {
+    peak_memory_ = active_memory_;
+    peak_event_ = event;
+  }
+}
+
+void MemoryTracer::on_free(const void* buffer) {
+  std::lock_guard lock(mutex_);
+  // The buffers allocated before the trace started are not recorded.
+  auto it = live_.find(buffer);
+  if (it == live_.end()) {
+    return;
+  }
+  auto& record = records_[it->second];
+  record.free_event = num_events_++;
+  record.free_us = now_us();
+  active_memory_ -= record.size;
+  live_.erase(it);
+}
+
+void MemoryTracer::on_temporary(const void* buffer) {
+  std::lock_guard lock(mutex_);
+  if (auto it = live_.find(buffer); it != live_.end()) {
+    records_[it->second].temporary = true;
+  }
+}
+
+std::vector<std::pair<std::string, size_t>> MemoryTracer::peak_locked(
+    int top_n) const {
+  std::map<std::string, size_t> tags;
+  for (auto& r : records_) {
+    bool live = r.alloc_event <= peak_event_ &&
+        (r.free_event < 0 || r.free_event > peak_event_);
+    if (live) {
+      tags[r.temporary ? r.tag + " (temporary)" : r.tag] += r.size;
+    }
+  }
+  std::vector<std::pair<std::string, size_t>> peak(tags.begin(), tags.end());
+  std::sort(peak.begin(), peak.end(), [](const auto& a, const auto& b) {
+    return a.second > b.second;
+  });
+  if (top_n >= 0 && peak.size() > top_n) {
+    peak.resize(top_n);
+  }
+  return peak;
+}
+
+std::vector<std::pair<std::string, size_t>> MemoryTracer::peak(int top_n) {
+  std::lock_guard lock(mutex_);
+  return peak_locked(top_n);
+}
+
+size_t MemoryTracer::peak_memory() {
+  std::lock_guard lock(mutex_);
+  return peak_memory_;
+}
+
+void MemoryTracer::save(const std::string& path, int top_n) {
+  std::lock_guard lock(mutex_);
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error(
+        fmt::format("[cuda::save_memory_trace] Cannot open {}.", path));
+  }
+  file << fmt::format("{{\"peak_memory\": {}, \"peak\": [", peak_memory_);
+  auto peak = peak_locked(top_n);
+  for (size_t i = 0; i < peak.size(); ++i) {
+    file << (i > 0 ? ", " : "")
+         << fmt::format(
+                "{{\"tag\": \"{}\", \"bytes\": {}}}",
+                peak[i].first,
+                peak[i].second);
+  }
+  file << "],\n\"allocations\": [";
+  for (size_t i = 0; i < records_.size(); ++i) {
+    auto& r = records_[i];
+    file << (i > 0 ? ",\n" : "\n")
+         << fmt::format(
+                "{{\"tag\": \"{}\", \"size\": {}, \"device\": {}, "
+                "\"temporary\": {}, \"alloc_us\": {:.3f}, \"free_us\": {}}}",
+                r.tag,
+                r.size,
+                r.device,
+                r.temporary,
+                r.alloc_us,
+                r.free_us < 0 ? "null" : fmt::format("{:.3f}", r.free_us));
+  }
+  file << "\n]}\n";
+}
+
+MemoryTracer& memory_tracer() {
+  // Leaked on purpose, the buffers can be freed at exit after the static
+  // objects are destroyed.
+  static auto* tracer = new MemoryTracer;
+  return *tracer;
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,89 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mlx::core::cu {
+
+// Records the lifetime of the buffers allocated while tracing, each tagged
+// with the primitive being evaluated by the thread which allocated it.
+class MemoryTracer {
+ public:
+  // Tag the buffers allocated by the thread with |name| in its scope.
+  class Scope {
+   public:
+    explicit Scope(const char* name);
+    ~Scope();
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+   private:
+    const char* previous_;
+  };
+
+  MemoryTracer() = default;
+
+  MemoryTracer(const MemoryTracer&) = delete;
+  MemoryTracer& operator=(const MemoryTracer&) = delete;
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Start tracing, the records of a previous trace are discarded.
+  void start();
+  void stop();
+
+  void on_malloc(const void* buffer, size_t size, int device);
+  void on_free(const void* buffer);
+  // Mark |buffer| as a temporary of the primitive which allocated it.
+  void on_temporary(const void* buffer);
+
+  // The |top_n| tags holding the most memory when the traced memory was the
+  // highest, with their bytes.
+  std::vector<std::pair<std::string, size_t>> peak(int top_n);
+  size_t peak_memory();
+
+  // Write the allocations and the peak as JSON to |path|.
+  void save(const std::string& path, int top_n);
+
+ private:
+  struct Record {
+    std::string tag;
+    size_t size;
+    int device;
+    bool temporary;
+    // The ordinal of the events and their time in microseconds since the
+    // start, the free is -1 while the buffer is alive.
+    int64_t alloc_event;
+    int64_t free_event;
+    double alloc_us;
+    double free_us;
+  };
+
+  double now_us() const;
+  std::vector<std::pair<std::string, size_t>> peak_locked(int top_n) const;
+
+  std::atomic<bool> enabled_{false};
+  std::mutex mutex_;
+  std::chrono::steady_clock::time_point start_;
+  std::vector<Record> records_;
+  // The records of the live buffers.
+  std::unordered_map<const void*, size_t> live_;
+  int64_t num_events_{0};
+  size_t active_memory_{0};
+  size_t peak_memory_{0};
+  int64_t peak_event_{-1};
+};
+
+MemoryTracer& memory_tracer();
+
+} // namespace mlx::core::cu
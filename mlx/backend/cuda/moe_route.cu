@@ -0,0 +1,268 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int moe_max_experts = 1024;
+constexpr int moe_max_k = WARP_SIZE;
+constexpr int moe_tokens_per_block = 16;
+constexpr int moe_block_dim = moe_tokens_per_block * WARP_SIZE;
+
+// One warp routes one token: the softmax statistics of its logits, then k
+// rounds of a warp argmax over the experts which come after the last pick
+// in the order of decreasing logit and increasing index. The experts picked
+// by the tokens of the block are counted in block_counts.
+template <typename T, typename AccT>
+__global__ void moe_topk(
+    const T* logits,
+    uint32_t* indices,
+    T* weights,
+    uint32_t* block_counts,
+    int64_t num_tokens,
+    int num_experts,
+    int k,
+    bool normalize) {
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  __shared__ uint32_t hist[moe_max_experts];
+  for (int e = block.thread_rank(); e < num_experts; e += block.size()) {
+    hist[e] = 0;
+  }
+  block.sync();
+
+  int64_t token =
+      int64_t(blockIdx.x) * moe_tokens_per_block + warp.meta_group_rank();
+  if (token < num_tokens) {
+    const T* row = logits + token * num_experts;
+    int lane = warp.thread_rank();
+    AccT maxval = Limits<AccT>::min();
+    for (int e = lane; e < num_experts; e += WARP_SIZE) {
+      maxval = max(maxval, static_cast<AccT>(row[e]));
+    }
+    maxval = cg::reduce(warp, maxval, cg::greater<AccT>{});
+    AccT normalizer = 0;
+    for (int e = lane; e < num_experts; e += WARP_SIZE) {
+      normalizer += exp(static_cast<AccT>(row[e]) - maxval);
+    }
+    normalizer = cg::reduce(warp, normalizer, cg::plus<AccT>{});
+
+    AccT last_val = Limits<AccT>::max();
+    int last_idx = -1;
+    AccT top_sum = 0;
+    AccT my_weight = 0;
+    int my_idx = 0;
+    for (int j = 0; j < k; j++) {
+      AccT best_val = Limits<AccT>::min();
+      int best_idx = num_experts;
+      for (int e = lane; e < num_experts; e += WARP_SIZE) {
+        AccT v = row[e];
+        bool after = v < last_val || (v == last_val && e > last_idx);
+        bool better = v > best_val || (v == best_val && e < best_idx);
+        if (after && better) {
+          best_val = v;
+          best_idx = e;
+        }
+      }
+      for (int offset = WARP_SIZE / 2; offset > 0; offset /= 2) {
+        AccT v = warp.shfl_down(best_val, offset);
+        int e = warp.shfl_down(best_idx, offset);
+        if (v > best_val || (v == best_val && e < best_idx)) {
+          best_val = v;
+          best_idx = e;
+        }
+      }
+      last_val = warp.shfl(best_val, 0);
+      last_idx = warp.shfl(best_idx, 0);
+      AccT w = exp(last_val - maxval) / normalizer;
+      top_sum += w;
+      if (lane == j) {
+        my_weight = w;
+        my_idx = last_idx;
+      }
+    }
+
+    if (lane < k) {
+      if (normalize) {
+        my_weight /= top_sum;
+      }
+      indices[token * k + lane] = my_idx;
+      weights[token * k + lane] = static_cast<T>(my_weight);
+      atomicAdd(&hist[my_idx], 1u);
+    }
+  }
+  block.sync();
+  for (int e = block.thread_rank(); e < num_experts; e += block.size()) {
+    block_counts[int64_t(blockIdx.x) * num_experts + e] = hist[e];
+  }
+}
+
+// Turn the counts of the experts in each block into the position of the
+// first pair of the block in the permutation, and add them up into the
+// counts of the experts.
+__global__ void moe_offsets(
+    uint32_t* block_counts,
+    uint32_t* counts,
+    int num_blocks,
+    int num_experts) {
+  auto block = cg::this_thread_block();
+  __shared__ uint32_t starts[moe_max_experts];
+  for (int e = block.thread_rank(); e < num_experts; e += block.size()) {
+    uint32_t total = 0;
+    for (int b = 0; b < num_blocks; b++) {
+      uint32_t c = block_counts[int64_t(b) * num_experts + e];
+      block_counts[int64_t(b) * num_experts + e] = total;
+      total += c;
+    }
+    counts[e] = total;
+    starts[e] = total;
+  }
+  block.sync();
+  if (block.thread_rank() == 0) {
+    uint32_t total = 0;
+    for (int e = 0; e < num_experts; e++) {
+      uint32_t c = starts[e];
+      starts[e] = total;
+      total += c;
+    }
+  }
+  block.sync();
+  for (int e = block.thread_rank(); e < num_experts; e += block.size()) {
+    for (int b = 0; b < num_blocks; b++) {
+      block_counts[int64_t(b) * num_experts + e] += starts[e];
+    }
+  }
+}
+
+// Scatter the pairs of the block to their position in the permutation, the
+// rank of a pair among the pairs of its expert in the block keeps the sort
+// stable.
+__global__ void moe_permute(
+    const uint32_t* indices,
+    const uint32_t* block_offsets,
+    uint32_t* perm,
+    int64_t num_pairs,
+    int num_experts,
+    int k) {
+  auto block = cg::this_thread_block();
+  __shared__ uint32_t experts[moe_tokens_per_block * moe_max_k];
+  int64_t first = int64_t(blockIdx.x) * moe_tokens_per_block * k;
+  int n = min(int64_t(moe_tokens_per_block) * k, num_pairs - first);
+  for (int i = block.thread_rank(); i < n; i += block.size()) {
+    experts[i] = indices[first + i];
+  }
+  block.sync();
+  const uint32_t* offsets = block_offsets + int64_t(blockIdx.x) * num_experts;
+  for (int i = block.thread_rank(); i < n; i += block.size()) {
+    uint32_t e = experts[i];
+    uint32_t rank = 0;
+    for (int j = 0; j < i; j++) {
+      rank += experts[j] == e;
+    }
+    perm[offsets[e] + rank] = first + i;
+  }
+}
+
+} // namespace cu
+
+namespace fast {
+
+bool MoERoute::use_fallback(int num_experts, int k, Stream s) {
+  return s.device == Device::cpu || num_experts > cu::moe_max_experts ||
+      k > cu::moe_max_k;
+}
+
+void MoERoute::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("MoERoute::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  array logits = inputs[0];
+  if (!logits.flags().row_contiguous) {
+    logits = contiguous_copy_gpu(logits, s);
+    encoder.add_temporary(logits);
+  }
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc(out.nbytes()));
+  }
+  auto& indices = outputs[0];
+  auto& weights = outputs[1];
+  auto& counts = outputs[2];
+  auto& perm = outputs[3];
+
+  int num_experts = logits.shape(-1);
+  int64_t num_tokens = logits.size() / num_experts;
+  int num_blocks = cuda::ceil_div(num_tokens, cu::moe_tokens_per_block);
+  if (num_tokens == 0) {
+    num_blocks = 1;
+  }
+  array block_counts({num_blocks, num_experts}, uint32, nullptr, {});
+  block_counts.set_data(allocator::malloc(block_counts.nbytes()));
+  encoder.add_temporary(block_counts);
+
+  encoder.set_input_array(logits);
+  encoder.set_output_array(indices);
+  encoder.set_output_array(weights);
+  encoder.set_output_array(block_counts);
+  dispatch_float_types(logits.dtype(), "moe_route", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using AccT =
+        std::conditional_t<std::is_same_v<DataType, double>, double, float>;
+    encoder.add_kernel_node(
+        cu::moe_topk<DataType, AccT>,
+        num_blocks,
+        cu::moe_block_dim,
+        logits.data<DataType>(),
+        indices.data<uint32_t>(),
+        weights.data<DataType>(),
+        block_counts.data<uint32_t>(),
+        num_tokens,
+        num_experts,
+        k_,
+        normalize_);
+  });
+
+  encoder.set_input_array(block_counts);
+  encoder.set_output_array(block_counts);
+  encoder.set_output_array(counts);
+  encoder.add_kernel_node(
+      cu::moe_offsets,
+      1,
+      1024,
+      block_counts.data<uint32_t>(),
+      counts.data<uint32_t>(),
+      num_blocks,
+      num_experts);
+
+  encoder.set_input_array(indices);
+  encoder.set_input_array(block_counts);
+  encoder.set_output_array(perm);
+  encoder.add_kernel_node(
+      cu::moe_permute,
+      num_blocks,
+      cu::moe_block_dim,
+      indices.data<uint32_t>(),
+      block_counts.data<uint32_t>(),
+      perm.data<uint32_t>(),
+      static_cast<int64_t>(perm.size()),
+      num_experts,
+      k_);
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -1,11 +1,158 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/cuda/cuda.h"
+#include "mlx/fast.h"
+#include "mlx/ops.h"
 
-namespace mlx::core::cu {
+namespace mlx::core {
+
+namespace cu {
 
 bool is_available() {
   return false;
 }
 
-} // namespace mlx::core::cu
+std::unordered_map<std::string, size_t> graph_cache_info() {
+  return {};
+}
+
+void reset_graph_cache_info() {}
+
+std::unordered_map<std::string, double> dispatch_info() {
+  return {};
+}
+
+void reset_dispatch_info() {}
+
+int precompile_kernels() {
+  return 0;
+}
+
+std::vector<std::pair<std::string, std::string>> kernel_cache_files() {
+  return {};
+}
+
+void add_kernel_cache_files(
+    const std::vector<std::pair<std::string, std::string>>&) {}
+
+void prefetch(const std::vector<array>&, bool) {}
+
+void set_read_mostly(const std::vector<array>&) {}
+
+void set_l2_persisting(const std::vector<array>&, bool) {}
+
+void offload(const std::vector<std::vector<array>>&, int) {}
+
+std::function<std::vector<array>(const std::vector<array>&)> graph_function(
+    std::function<std::vector<array>(const std::vector<array>&)> fun) {
+  return fun;
+}
+
+void start_profiling() {}
+
+void stop_profiling() {}
+
+std::unordered_map<std::string, std::unordered_map<std::string, double>>
+profiling_info() {
+  return {};
+}
+
+void save_profiling_trace(const std::string&) {
+  throw std::runtime_error("[save_profiling_trace] No CUDA back-end.");
+}
+
+void start_memory_tracing() {}
+
+void stop_memory_tracing() {}
+
+std::vector<std::pair<std::string, size_t>> memory_trace_peak(int) {
+  return {};
+}
+
+void save_memory_trace(const std::string&, int) {
+  throw std::runtime_error("[save_memory_trace] No CUDA back-end.");
+}
+
+array from_device_memory(
+    void*,
+    Shape,
+    Dtype,
+    int,
+    std::function<void()>) {
+  throw std::runtime_error("[from_device_memory] No CUDA back-end.");
+}
+
+array from_host(const void*, Shape, Dtype) {
+  throw std::runtime_error("[from_host] No CUDA back-end.");
+}
+
+array readable_by_host(const array& a) {
+  return a;
+}
+
+std::pair<array, std::string> ipc_export(const array&) {
+  throw std::runtime_error("[ipc_export] No CUDA back-end.");
+}
+
+array ipc_import(const std::string&, StreamOrDevice) {
+  throw std::runtime_error("[ipc_import] No CUDA back-end.");
+}
+
+BatchPrefetcher::BatchPrefetcher(
+    std::function<std::optional<Batch>()> batches,
+    int ahead)
+    : batches_(std::move(batches)), ahead_(ahead) {}
+
+std::optional<BatchPrefetcher::Batch> BatchPrefetcher::next() {
+  return batches_();
+}
+
+GrowableArray::GrowableArray(Shape shape, Dtype dtype, int max_length)
+    : storage_(zeros({0}, dtype)), max_length_(max_length) {
+  shape.insert(shape.begin(), 0);
+  storage_ = zeros(std::move(shape), dtype);
+}
+
+void GrowableArray::append(const array& x) {
+  if (length_ + x.shape(0) > max_length_) {
+    throw std::invalid_argument(
+        "[GrowableArray::append] The maximum length is exceeded.");
+  }
+  storage_ = concatenate({storage_, x});
+  length_ += x.shape(0);
+}
+
+array GrowableArray::data() const {
+  return storage_;
+}
+
+std::uintptr_t cuda_stream(Stream) {
+  throw std::runtime_error("[cuda_stream] No CUDA back-end.");
+}
+
+void wait_for_stream(std::uintptr_t, Stream) {
+  throw std::runtime_error("[wait_for_stream] No CUDA back-end.");
+}
+
+std::uintptr_t evaluation_stream(array) {
+  throw std::runtime_error("[evaluation_stream] No CUDA back-end.");
+}
+
+} // namespace cu
+
+namespace fast {
+
+CustomKernelFunction cuda_kernel(
+    const std::string&,
+    const std::vector<std::string>&,
+    const std::vector<std::string>&,
+    const std::string&,
+    const std::string&,
+    bool,
+    int) {
+  throw std::runtime_error("[cuda_kernel] No CUDA back-end.");
+}
+
+} // namespace fast
+
+} // namespace mlx::core
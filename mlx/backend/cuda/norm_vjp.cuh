@@ -0,0 +1,92 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/dtype_utils.h"
+#include "mlx/utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+
+#include <algorithm>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Sum the |n_rows| rows of |partial|, the sums of the gradients of the
+// weights by the blocks of a norm VJP, into |out|. A block of 32 x 32
+// threads sums 32 columns.
+template <typename T>
+__global__ void __launch_bounds__(WARP_SIZE * WARP_SIZE) sum_partial_rows(
+    const float* partial,
+    T* out,
+    int32_t n_rows,
+    int32_t axis_size) {
+  __shared__ float sums[WARP_SIZE][WARP_SIZE + 1];
+  int col = blockIdx.x * WARP_SIZE + threadIdx.x;
+  float sum = 0;
+  if (col < axis_size) {
+    for (int row = threadIdx.y; row < n_rows; row += WARP_SIZE) {
+      sum += partial[static_cast<int64_t>(row) * axis_size + col];
+    }
+  }
+  sums[threadIdx.y][threadIdx.x] = sum;
+  __syncthreads();
+
+  // The warp y sums the column y.
+  auto warp = cg::tiled_partition<WARP_SIZE>(cg::this_thread_block());
+  sum = cg::reduce(warp, sums[threadIdx.x][threadIdx.y], cg::plus<float>{});
+  col = blockIdx.x * WARP_SIZE + threadIdx.y;
+  if (threadIdx.x == 0 && col < axis_size) {
+    out[col] = static_cast<T>(sum);
+  }
+}
+
+} // namespace cu
+
+// The block size of the norm kernels reading rows of |axis_size| with
+// |n_reads| elements per thread, the one of dispatch_block_dim.
+inline int norm_block_dim(int axis_size, int n_reads) {
+  return std::clamp(
+      next_power_of_2(cuda::ceil_div(axis_size, n_reads)),
+      WARP_SIZE,
+      WARP_SIZE * WARP_SIZE);
+}
+
+// The number of blocks of the norm VJPs, which loop over the rows and sum
+// the gradients of the weights of their rows. As many as can be resident on
+// the GPU so the partial sums stay small.
+inline int norm_vjp_blocks(cu::Device& device, int n_rows, int block_dim) {
+  int blocks_per_sm = std::clamp(2048 / block_dim, 1, 16);
+  return std::clamp(n_rows, 1, device.multi_processor_count() * blocks_per_sm);
+}
+
+// Sum the |n_blocks| rows of sums of the blocks of a norm VJP in |partial|
+// into |out|.
+inline void sum_partial_rows(
+    cu::CommandEncoder& encoder,
+    const array& partial,
+    array& out,
+    int n_blocks,
+    int32_t axis_size) {
+  encoder.set_input_array(partial);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "sum_partial_rows", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::sum_partial_rows<DataType>,
+        dim3(cuda::ceil_div(axis_size, WARP_SIZE)),
+        dim3(WARP_SIZE, WARP_SIZE),
+        partial.data<float>(),
+        out.data<DataType>(),
+        n_blocks,
+        axis_size);
+  });
+}
+
+} // namespace mlx::core
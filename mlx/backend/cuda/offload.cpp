@@ -0,0 +1,142 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/offload.h"
+#include "mlx/backend/cuda/allocator.h"
+#include "mlx/backend/cuda/utils.h"
+
+#include <algorithm>
+
+namespace mlx::core::cu {
+
+void Offloader::offload(
+    const std::vector<std::vector<array>>& layers,
+    int ahead) {
+  std::lock_guard lock(mutex_);
+  restore();
+  ahead_ = std::max(ahead, 0);
+  current_ = -1;
+
+  int device;
+  CHECK_CUDA_ERROR(cudaGetDevice(&device));
+  int device_count;
+  CHECK_CUDA_ERROR(cudaGetDeviceCount(&device_count));
+  for (auto& arrays : layers) {
+    Layer layer{{}, cudaCpuDeviceId};
+    for (auto& a : arrays) {
+      auto* buf = static_cast<CudaBuffer*>(a.buffer().ptr());
+      // The buffers shared by several layers belong to the first one.
+      if (!allocator().owns_pages(a.buffer()) || layer_of_.count(buf)) {
+        continue;
+      }
+      layer_of_.emplace(buf, layers_.size());
+      layer.data.push_back(a.data_shared_ptr());
+      // Keep the pages on the host and map them for the GPUs so they are
+      // read in place instead of moved on a fault.
+      CHECK_CUDA_ERROR(mem_advise(
+          buf->data,
+          buf->size,
+          cudaMemAdviseSetPreferredLocation,
+          cudaCpuDeviceId));
+      for (int d = 0; d < device_count; ++d) {
+        CHECK_CUDA_ERROR(
+            mem_advise(buf->data, buf->size, cudaMemAdviseSetAccessedBy, d));
+      }
+    }
+    layers_.push_back(std::move(layer));
+  }
+
+  auto& ds = device_stream(device);
+  for (auto& layer : layers_) {
+    move(layer, cudaCpuDeviceId, ds.stream);
+  }
+  enabled_ = !layers_.empty();
+}
+
+void Offloader::on_input(const void* buffer, int device, cudaStream_t stream) {
+  std::lock_guard lock(mutex_);
+  auto it = layer_of_.find(buffer);
+  if (it == layer_of_.end() || it->second == current_) {
+    return;
+  }
+  // The prefetches can not be captured in the graphs.
+  cudaStreamCaptureStatus status;
+  CHECK_CUDA_ERROR(cudaStreamIsCapturing(stream, &status));
+  if (status != cudaStreamCaptureStatusNone) {
+    return;
+  }
+  current_ = it->second;
+
+  // The layers moved back to the host may be read by the kernels enqueued on
+  // |stream|, the prefetches then overlap with the kernels of this layer.
+  auto& ds = device_stream(device);
+  CHECK_CUDA_ERROR(cudaEventRecord(ds.event, stream));
+  CHECK_CUDA_ERROR(cudaStreamWaitEvent(ds.stream, ds.event, 0));
+  int n = layers_.size();
+  for (int i = 0; i < n; ++i) {
+    int distance = (i - current_ + n) % n;
+    if (distance > ahead_ && layers_[i].location != cudaCpuDeviceId) {
+      move(layers_[i], cudaCpuDeviceId, ds.stream);
+    }
+  }
+  for (int i = 0; i <= std::min(ahead_, n - 1); ++i) {
+    auto& layer = layers_[(current_ + i) % n];
+    if (layer.location != device) {
+      move(layer, device, ds.stream);
+    }
+  }
+}
+
+void Offloader::restore() {
+  int device_count;
+  CHECK_CUDA_ERROR(cudaGetDeviceCount(&device_count));
+  for (auto& layer : layers_) {
+    for (auto& data : layer.data) {
+      auto* buf = static_cast<CudaBuffer*>(data->buffer.ptr());
+      CHECK_CUDA_ERROR(mem_advise(
+          buf->data,
+          buf->size,
+          cudaMemAdviseUnsetPreferredLocation,
+          cudaCpuDeviceId));
+      for (int d = 0; d < device_count; ++d) {
+        CHECK_CUDA_ERROR(
+            mem_advise(buf->data, buf->size, cudaMemAdviseUnsetAccessedBy, d));
+      }
+      buf->location = cudaInvalidDeviceId;
+    }
+  }
+  layers_.clear();
+  layer_of_.clear();
+  enabled_ = false;
+}
+
+void Offloader::move(Layer& layer, int location, cudaStream_t stream) {
+  for (auto& data : layer.data) {
+    auto* buf = static_cast<CudaBuffer*>(data->buffer.ptr());
+    CHECK_CUDA_ERROR(
+        mem_prefetch_async(buf->data, buf->size, location, stream));
+    buf->location = location;
+  }
+  layer.location = location;
+}
+
+Offloader::DeviceStream& Offloader::device_stream(int device) {
+  auto it = streams_.find(device);
+  if (it == streams_.end()) {
+    // Created on the current device, which is |device|.
+    DeviceStream ds;
+    CHECK_CUDA_ERROR(
+        cudaStreamCreateWithFlags(&ds.stream, cudaStreamNonBlocking));
+    CHECK_CUDA_ERROR(
+        cudaEventCreateWithFlags(&ds.event, cudaEventDisableTiming));
+    it = streams_.emplace(device, ds).first;
+  }
+  return it->second;
+}
+
+Offloader& offloader() {
+  // Leaked on exit like the allocator, which owns the offloaded buffers.
+  static Offloader* offloader_ = new Offloader;
+  return *offloader_;
+}
+
+} // namespace mlx::core::cu
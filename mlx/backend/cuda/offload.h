@@ -0,0 +1,70 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+#include <cuda_runtime.h>
+
+#include <atomic>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace mlx::core::cu {
+
+// Keeps the memory of the offloaded layers, such as the weights of a model
+// larger than the GPU memory, on the host where the GPU reads it through
+// its mapping. When a kernel reads a layer, the next |ahead| layers are
+// prefetched to the GPU on a stream of their own and the other layers are
+// moved back to the host, so at most |ahead| + 1 layers are on the GPU. The
+// layers are in the order they are read, the first following the last.
+class Offloader {
+ public:
+  Offloader() = default;
+
+  Offloader(const Offloader&) = delete;
+  Offloader& operator=(const Offloader&) = delete;
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Offload the evaluated arrays of |layers|, the previously offloaded
+  // layers are restored first.
+  void offload(const std::vector<std::vector<array>>& layers, int ahead);
+
+  // Called when a kernel on |stream| of |device| reads |buffer|.
+  void on_input(const void* buffer, int device, cudaStream_t stream);
+
+ private:
+  struct Layer {
+    std::vector<std::shared_ptr<array::Data>> data;
+    // The device the layer is prefetched to, or cudaCpuDeviceId.
+    int location;
+  };
+
+  // The stream of the prefetches to |device| and an event to order them
+  // after the kernels.
+  struct DeviceStream {
+    cudaStream_t stream;
+    cudaEvent_t event;
+  };
+
+  void restore();
+  void move(Layer& layer, int location, cudaStream_t stream);
+  DeviceStream& device_stream(int device);
+
+  std::atomic<bool> enabled_{false};
+  std::mutex mutex_;
+  std::vector<Layer> layers_;
+  // The layer of each buffer.
+  std::unordered_map<const void*, int> layer_of_;
+  int ahead_{1};
+  int current_{-1};
+  std::unordered_map<int, DeviceStream> streams_;
+};
+
+Offloader& offloader();
+
+} // namespace mlx::core::cu
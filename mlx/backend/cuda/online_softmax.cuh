@@ -0,0 +1,118 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <cub/block/block_load.cuh>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Merge two (max, sum of exp(x - max)) pairs of the online softmax, stored in
+// the x and y of a float2.
+struct OnlineSoftmaxMerge {
+  __device__ float2 operator()(const float2& a, const float2& b) const {
+    float m = fmaxf(a.x, b.x);
+    return {m, a.y * __expf(a.x - m) + b.y * __expf(b.x - m)};
+  }
+};
+
+// Reduce the (max, sum) pairs of the threads of a block, the result is
+// broadcasted to every thread.
+template <int BLOCK_DIM>
+__device__ float2 block_online_softmax(cg::thread_block& block, float2 val) {
+  static_assert(BLOCK_DIM % WARP_SIZE == 0);
+  __shared__ float2 smem[BLOCK_DIM / WARP_SIZE];
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  OnlineSoftmaxMerge op;
+  val = cg::reduce(warp, val, op);
+  if (warp.thread_rank() == 0) {
+    smem[warp.meta_group_rank()] = val;
+  }
+  block.sync();
+  val = warp.thread_rank() < warp.meta_group_size()
+      ? smem[warp.thread_rank()]
+      : float2{Limits<float>::finite_min(), 0};
+  return cg::reduce(warp, val, op);
+}
+
+// Compute the (max, sum) pair of each of the |gridDim.x| chunks of
+// |chunk_size| elements of each row, one block per chunk, into
+// partials[row * gridDim.x + chunk].
+template <typename T, int BLOCK_DIM, int N_READS = 4>
+__global__ void online_softmax_partials(
+    const T* in,
+    float2* partials,
+    int axis_size,
+    int chunk_size) {
+  auto block = cg::this_thread_block();
+  int chunk = block.group_index().x;
+  int row = block.group_index().y;
+  int size = min(chunk_size, axis_size - chunk * chunk_size);
+  in += int64_t(row) * axis_size + int64_t(chunk) * chunk_size;
+
+  cg::greater<float> max_op;
+  float maxval = Limits<float>::finite_min();
+  float normalizer = 0;
+  for (int r = 0; r < cuda::ceil_div(size, BLOCK_DIM * N_READS); r++) {
+    float vals[N_READS];
+    cub::LoadDirectBlocked(
+        r * BLOCK_DIM + block.thread_rank(),
+        make_cast_iterator<float>(in),
+        vals,
+        size,
+        Limits<float>::min());
+    float prevmax = maxval;
+    maxval = max_op(maxval, cub::ThreadReduce(vals, max_op));
+    normalizer = normalizer * __expf(prevmax - maxval);
+    for (int i = 0; i < N_READS; i++) {
+      normalizer = normalizer + __expf(vals[i] - maxval);
+    }
+  }
+
+  float2 val = block_online_softmax<BLOCK_DIM>(block, {maxval, normalizer});
+  if (block.thread_rank() == 0) {
+    partials[int64_t(row) * gridDim.x + chunk] = val;
+  }
+}
+
+// Merge the |n_chunks| partials of |row| in a block.
+template <int BLOCK_DIM>
+__device__ float2 merge_online_softmax_partials(
+    cg::thread_block& block,
+    const float2* partials,
+    int row,
+    int n_chunks) {
+  partials += int64_t(row) * n_chunks;
+  float2 val = {Limits<float>::finite_min(), 0};
+  for (int i = block.thread_rank(); i < n_chunks; i += BLOCK_DIM) {
+    val = OnlineSoftmaxMerge{}(val, partials[i]);
+  }
+  return block_online_softmax<BLOCK_DIM>(block, val);
+}
+
+} // namespace cu
+
+// The number of chunks each row of a softmax or logsumexp is split into, the
+// rows are split when there are too few of them to give every SM a block and
+// they are long enough that each chunk keeps a block busy.
+inline int
+online_softmax_chunks(cu::Device& device, int n_rows, int axis_size) {
+  constexpr int min_chunk_size = 8192;
+  int sms = device.multi_processor_count();
+  if (n_rows >= sms || axis_size < 2 * min_chunk_size) {
+    return 1;
+  }
+  int chunks = cuda::ceil_div(2 * sms, n_rows);
+  return std::min({chunks, axis_size / min_chunk_size, 1024});
+}
+
+} // namespace mlx::core
@@ -0,0 +1,242 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/random.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+using OptimizerStep = fast::OptimizerStep;
+
+// The tensors of a launch are passed by value like the copies of
+// copy_batched so that the launch can be replayed in a CUDA graph.
+constexpr int MAX_OPTIMIZER_TENSORS = 48;
+
+template <typename T>
+struct OptimizerTensor {
+  const T* param;
+  const T* grad;
+  const T* state[2];
+  T* out_param;
+  T* out_state[2];
+  // Set when the parameter is rounded stochastically.
+  const uint32_t* key;
+};
+
+template <typename T>
+struct OptimizerBatch {
+  OptimizerTensor<T> tensors[MAX_OPTIMIZER_TENSORS];
+  // The first element of each tensor in the flat range of the elements of
+  // all of them.
+  int64_t offsets[MAX_OPTIMIZER_TENSORS + 1];
+  int count;
+};
+
+// The kernel parameters are limited to 4KB.
+static_assert(sizeof(OptimizerBatch<double>) <= 4000);
+
+template <typename T, typename AccT, OptimizerStep::Kind KIND>
+__device__ void optimizer_update(
+    const OptimizerTensor<T>& t,
+    int64_t i,
+    int64_t size,
+    const OptimizerStep::Params& hp,
+    const float* scalars,
+    bool has_state) {
+  AccT lr = scalars[0];
+  AccT b1 = hp.beta1;
+  AccT b2 = hp.beta2;
+  AccT decay = 1 - lr * static_cast<AccT>(hp.weight_decay);
+  // The new parameter rounded with the bits random::bits gives the element
+  // for its key, so it matches the fallback.
+  auto round_param = [&](AccT x) {
+    if constexpr (cuda::std::is_same_v<T, __nv_bfloat16>) {
+      if (t.key) {
+        return stochastic_round_bf16(
+            x, random_bits_at(uint2{t.key[0], t.key[1]}, i, size));
+      }
+    }
+    return static_cast<T>(x);
+  };
+  AccT p = t.param[i];
+  AccT g = t.grad[i];
+  if constexpr (KIND == OptimizerStep::SGD) {
+    g += static_cast<AccT>(hp.weight_decay) * p;
+    if (has_state) {
+      AccT v = b1 * static_cast<AccT>(t.state[0][i]) +
+          (1 - static_cast<AccT>(hp.dampening)) * g;
+      t.out_state[0][i] = static_cast<T>(v);
+      g = hp.nesterov ? g + b1 * v : v;
+    }
+    t.out_param[i] = round_param(p - lr * g);
+  } else if constexpr (KIND == OptimizerStep::AdamW) {
+    AccT m = b1 * static_cast<AccT>(t.state[0][i]) + (1 - b1) * g;
+    AccT v = b2 * static_cast<AccT>(t.state[1][i]) + (1 - b2) * g * g;
+    AccT c1 = scalars[1];
+    AccT c2 = scalars[2];
+    p = decay * p - c1 * m / (sqrt(v) * c2 + static_cast<AccT>(hp.eps));
+    t.out_state[0][i] = static_cast<T>(m);
+    t.out_state[1][i] = static_cast<T>(v);
+    t.out_param[i] = round_param(p);
+  } else {
+    AccT m = t.state[0][i];
+    AccT c = b1 * m + (1 - b1) * g;
+    AccT sign = (c > 0) - (c < 0);
+    t.out_state[0][i] = static_cast<T>(b2 * m + (1 - b2) * g);
+    t.out_param[i] = round_param(decay * p - lr * sign);
+  }
+}
+
+// Each block updates a chunk of the flat range of the elements of all the
+// tensors, which may span several small tensors.
+template <typename T, typename AccT, OptimizerStep::Kind KIND>
+__global__ void optimizer_step(
+    const __grid_constant__ OptimizerBatch<T> batch,
+    const __grid_constant__ OptimizerStep::Params hp,
+    const float* scalars,
+    bool has_state,
+    int64_t chunk) {
+  int64_t start = blockIdx.x * chunk;
+  int64_t end = min(start + chunk, batch.offsets[batch.count]);
+  int t = 0;
+  while (batch.offsets[t + 1] <= start) {
+    t++;
+  }
+  for (; t < batch.count && batch.offsets[t] < end; t++) {
+    int64_t first = max(start, batch.offsets[t]);
+    int64_t last = min(end, batch.offsets[t + 1]);
+    int64_t size = batch.offsets[t + 1] - batch.offsets[t];
+    for (int64_t i = first + threadIdx.x; i < last; i += blockDim.x) {
+      optimizer_update<T, AccT, KIND>(
+          batch.tensors[t],
+          i - batch.offsets[t],
+          size,
+          hp,
+          scalars,
+          has_state);
+    }
+  }
+}
+
+} // namespace cu
+
+namespace fast {
+
+bool OptimizerStep::use_fallback(Stream s) {
+  return false;
+}
+
+void OptimizerStep::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("OptimizerStep::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  // The parameters and the states are updated in place when donated
+  auto ensure_row_contiguous = [&s, &encoder](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  int n = num_params_;
+  int num_states = outputs.size() / n - 1;
+  // The keys of the parameters come last when they are rounded
+  int num_tensors = inputs.size() - params_.stochastic_rounding;
+  std::vector<array> tensors;
+  for (int i = 1; i < num_tensors; i++) {
+    tensors.push_back(ensure_row_contiguous(inputs[i]));
+    encoder.set_input_array(tensors.back());
+  }
+  for (int i = 0; i < outputs.size(); i++) {
+    auto& in = i < n ? inputs[1 + i] : inputs[1 + n + i];
+    auto& out = outputs[i];
+    if (in.flags().row_contiguous && in.is_donatable()) {
+      out.copy_shared_buffer(in);
+    } else {
+      out.set_data(allocator::malloc(out.nbytes()));
+    }
+    encoder.set_output_array(out);
+  }
+  auto scalars = ensure_row_contiguous(inputs[0]);
+  encoder.set_input_array(scalars);
+  const uint32_t* keys = nullptr;
+  if (params_.stochastic_rounding) {
+    auto keys_arr = ensure_row_contiguous(inputs.back());
+    encoder.set_input_array(keys_arr);
+    keys = keys_arr.data<uint32_t>();
+  }
+
+  dispatch_float_types(outputs[0].dtype(), "optimizer_step", [&](auto tag) {
+    using T = cuda_type_t<MLX_GET_TYPE(tag)>;
+    using AccT = std::conditional_t<std::is_same_v<T, double>, double, float>;
+    auto launch_kind = [&](auto kernel) {
+      uint block_dim = max_occupancy_block_dim(kernel);
+      int64_t chunk = 8 * block_dim;
+      cu::OptimizerBatch<T> batch;
+      batch.count = 0;
+      batch.offsets[0] = 0;
+      auto launch = [&]() {
+        uint num_blocks =
+            cuda::ceil_div(batch.offsets[batch.count], chunk);
+        encoder.add_kernel_node(
+            kernel,
+            num_blocks,
+            block_dim,
+            batch,
+            params_,
+            scalars.data<float>(),
+            num_states > 0,
+            chunk);
+        batch.count = 0;
+      };
+      for (int i = 0; i < n; i++) {
+        if (outputs[i].size() == 0) {
+          continue;
+        }
+        auto& t = batch.tensors[batch.count];
+        t.param = tensors[i].data<T>();
+        t.grad = tensors[n + i].data<T>();
+        t.out_param = outputs[i].data<T>();
+        t.key = keys ? keys + 2 * i : nullptr;
+        for (int j = 0; j < num_states; j++) {
+          t.state[j] = tensors[(j + 2) * n + i].data<T>();
+          t.out_state[j] = outputs[(j + 1) * n + i].data<T>();
+        }
+        batch.offsets[batch.count + 1] =
+            batch.offsets[batch.count] + outputs[i].size();
+        if (++batch.count == cu::MAX_OPTIMIZER_TENSORS) {
+          launch();
+        }
+      }
+      if (batch.count > 0) {
+        launch();
+      }
+    };
+    switch (kind_) {
+      case SGD:
+        launch_kind(cu::optimizer_step<T, AccT, SGD>);
+        break;
+      case AdamW:
+        launch_kind(cu::optimizer_step<T, AccT, AdamW>);
+        break;
+      case Lion:
+        launch_kind(cu::optimizer_step<T, AccT, Lion>);
+        break;
+    }
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -0,0 +1,372 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/utils.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/transforms_impl.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+struct PagedAttnParams {
+  int qL;
+  int gqa_factor;
+  int page_size;
+  int max_pages;
+  float scale;
+  int64_t Q_strides[3];
+  int64_t K_strides[3];
+  int64_t V_strides[3];
+  int64_t O_strides[3];
+};
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Write the element |index| of the keys and values of shape
+// [B, n_kv_heads, L, D] to the slot of its position in the page pools.
+template <typename T>
+__global__ void paged_kv_write(
+    const T* keys,
+    const T* values,
+    T* k_pages,
+    T* v_pages,
+    const int32_t* block_table,
+    const int32_t* context_lens,
+    int n_kv_heads,
+    int seq_len,
+    int head_dim,
+    int page_size,
+    int max_pages,
+    const __grid_constant__ cuda::std::array<int64_t, 3> page_strides,
+    int64_t size) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index >= size) {
+    return;
+  }
+  int d = index % head_dim;
+  int64_t rest = index / head_dim;
+  int l = rest % seq_len;
+  rest /= seq_len;
+  int h = rest % n_kv_heads;
+  int b = rest / n_kv_heads;
+
+  int pos = context_lens[b] + l;
+  int64_t page = block_table[b * max_pages + pos / page_size];
+  int64_t out_idx = page * page_strides[0] + h * page_strides[1] +
+      (pos % page_size) * page_strides[2] + d;
+  k_pages[out_idx] = keys[index];
+  v_pages[out_idx] = values[index];
+}
+
+// The attention of one query of one head in a block like sdpa_vector, the
+// warps walk the keys of the sequence and find their page in the block
+// table.
+template <typename T, int D, int NUM_WARPS = 32>
+__global__ void paged_attention(
+    const T* Q,
+    const T* K,
+    const T* V,
+    const int32_t* block_table,
+    const int32_t* context_lens,
+    T* O,
+    const __grid_constant__ PagedAttnParams params) {
+  __shared__ float maxs[NUM_WARPS];
+  __shared__ float sums[NUM_WARPS];
+  __shared__ float outs[NUM_WARPS * D];
+
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  int warp_id = warp.meta_group_rank();
+  int lane = warp.thread_rank();
+
+  int h = blockIdx.x;
+  int q_idx = blockIdx.y;
+  int b = blockIdx.z;
+  int kv_h = h / params.gqa_factor;
+
+  Q += b * params.Q_strides[0] + h * params.Q_strides[1] +
+      q_idx * params.Q_strides[2];
+  K += kv_h * params.K_strides[1];
+  V += kv_h * params.V_strides[1];
+  const int32_t* pages = block_table + b * params.max_pages;
+
+  constexpr int EPT = D / WARP_SIZE;
+  static_assert(D % WARP_SIZE == 0);
+  constexpr float log2e = 1.44269504089f;
+  float scale_log2 = params.scale * log2e;
+  float q[EPT];
+  float o[EPT] = {};
+#pragma unroll
+  for (int i = 0; i < EPT; ++i) {
+    q[i] = static_cast<float>(Q[i * WARP_SIZE + lane]) * scale_log2;
+  }
+
+  // The query is at the position context_len - qL + q_idx of its sequence.
+  int key_end = context_lens[b] - params.qL + q_idx + 1;
+
+  // Online softmax in base 2.
+  float m = Limits<float>::min();
+  float l = 0;
+  for (int j = warp_id; j < key_end; j += NUM_WARPS) {
+    int64_t page = pages[j / params.page_size];
+    int slot = j % params.page_size;
+    const T* k = K + page * params.K_strides[0] + slot * params.K_strides[2];
+    const T* v = V + page * params.V_strides[0] + slot * params.V_strides[2];
+    float score = 0;
+#pragma unroll
+    for (int i = 0; i < EPT; ++i) {
+      score += q[i] * static_cast<float>(k[i * WARP_SIZE + lane]);
+    }
+    score = cg::reduce(warp, score, cg::plus<float>{});
+    float m_new = max(m, score);
+    float factor = exp2f(m - m_new);
+    float p = exp2f(score - m_new);
+    l = l * factor + p;
+    m = m_new;
+#pragma unroll
+    for (int i = 0; i < EPT; ++i) {
+      o[i] = o[i] * factor + p * static_cast<float>(v[i * WARP_SIZE + lane]);
+    }
+  }
+
+  // Merge the warps.
+  if (lane == 0) {
+    maxs[warp_id] = m;
+    sums[warp_id] = l;
+  }
+  block.sync();
+  float max_score = Limits<float>::min();
+#pragma unroll
+  for (int w = 0; w < NUM_WARPS; ++w) {
+    max_score = max(max_score, maxs[w]);
+  }
+  // Warps without any key keep a -inf max and a zero sum.
+  bool empty = max_score == Limits<float>::min();
+  float sum_exp = 0;
+#pragma unroll
+  for (int w = 0; w < NUM_WARPS; ++w) {
+    sum_exp += empty ? 0.0f : sums[w] * exp2f(maxs[w] - max_score);
+  }
+  float factor = empty ? 0.0f : exp2f(m - max_score);
+#pragma unroll
+  for (int i = 0; i < EPT; ++i) {
+    outs[warp_id * D + i * WARP_SIZE + lane] = o[i] * factor;
+  }
+  block.sync();
+
+  int d = block.thread_rank();
+  if (d < D) {
+    float acc = 0;
+#pragma unroll
+    for (int w = 0; w < NUM_WARPS; ++w) {
+      acc += outs[w * D + d];
+    }
+    O += b * params.O_strides[0] + h * params.O_strides[1] +
+        q_idx * params.O_strides[2];
+    O[d] = static_cast<T>(sum_exp > 0 ? acc / sum_exp : 0.0f);
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_paged_head_dim(int head_dim, F&& f) {
+  switch (head_dim) {
+    case 64:
+      f(std::integral_constant<int, 64>{});
+      break;
+    case 96:
+      f(std::integral_constant<int, 96>{});
+      break;
+    case 128:
+      f(std::integral_constant<int, 128>{});
+      break;
+    case 256:
+      f(std::integral_constant<int, 256>{});
+      break;
+  }
+}
+
+} // namespace
+
+namespace fast {
+
+bool PagedKVWrite::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void PagedKVWrite::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("PagedKVWrite::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  auto ensure_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array keys = ensure_contiguous(inputs[2]);
+  array values = ensure_contiguous(inputs[3]);
+  array block_table = ensure_contiguous(inputs[4]);
+  array context_lens = ensure_contiguous(inputs[5]);
+
+  // The new tokens are written in place in the pools when donated.
+  auto update_pool = [&](const array& in, array& out) {
+    if (in.flags().row_contiguous && in.is_donatable()) {
+      out.copy_shared_buffer(in);
+    } else {
+      copy_gpu(in, out, CopyType::General, s);
+    }
+  };
+  auto& k_pages = outputs[0];
+  auto& v_pages = outputs[1];
+  update_pool(inputs[0], k_pages);
+  update_pool(inputs[1], v_pages);
+  if (keys.size() == 0) {
+    return;
+  }
+
+  cuda::std::array<int64_t, 3> page_strides = {
+      k_pages.strides(0), k_pages.strides(1), k_pages.strides(2)};
+
+  encoder.set_input_array(keys);
+  encoder.set_input_array(values);
+  encoder.set_input_array(block_table);
+  encoder.set_input_array(context_lens);
+  encoder.set_output_array(k_pages);
+  encoder.set_output_array(v_pages);
+  dispatch_float_types(k_pages.dtype(), "paged_kv_write", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    constexpr int block_dim = 256;
+    encoder.add_kernel_node(
+        cu::paged_kv_write<DataType>,
+        cuda::ceil_div(keys.size(), block_dim),
+        block_dim,
+        keys.data<DataType>(),
+        values.data<DataType>(),
+        k_pages.data<DataType>(),
+        v_pages.data<DataType>(),
+        block_table.data<int32_t>(),
+        context_lens.data<int32_t>(),
+        static_cast<int>(keys.shape(1)),
+        static_cast<int>(keys.shape(2)),
+        static_cast<int>(keys.shape(3)),
+        static_cast<int>(k_pages.shape(2)),
+        static_cast<int>(block_table.shape(1)),
+        page_strides,
+        static_cast<int64_t>(keys.size()));
+  });
+}
+
+bool PagedAttention::use_fallback(
+    const array& q,
+    const array& k_pages,
+    Stream s) {
+  if (detail::in_grad_tracing()) {
+    return true;
+  }
+  if (s.device == Device::cpu) {
+    return true;
+  }
+  // The prompts gather their pages for the full attention.
+  const int head_dim = q.shape(-1);
+  const bool supported_dtype = k_pages.dtype() == float32 ||
+      k_pages.dtype() == float16 || k_pages.dtype() == bfloat16;
+  const bool supported_head_dim =
+      head_dim == 64 || head_dim == 96 || head_dim == 128 || head_dim == 256;
+  return !(q.shape(2) <= 8 && supported_dtype && supported_head_dim);
+}
+
+void PagedAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("PagedAttention::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  // The head dim must be contiguous, the other dims can have any strides.
+  auto copy_unless_matrix_contiguous = [&](const array& arr) {
+    if (arr.strides(-1) == 1) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    encoder.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  auto ensure_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array q = copy_unless_matrix_contiguous(inputs[0]);
+  array k_pages = copy_unless_matrix_contiguous(inputs[1]);
+  array v_pages = copy_unless_matrix_contiguous(inputs[2]);
+  array block_table = ensure_contiguous(inputs[3]);
+  array context_lens = ensure_contiguous(inputs[4]);
+
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  int B = q.shape(0);
+  int H = q.shape(1);
+  int qL = q.shape(2);
+  PagedAttnParams params;
+  params.qL = qL;
+  params.gqa_factor = H / k_pages.shape(1);
+  params.page_size = k_pages.shape(2);
+  params.max_pages = block_table.shape(1);
+  params.scale = scale_;
+  for (int i = 0; i < 3; ++i) {
+    params.Q_strides[i] = q.strides(i);
+    params.K_strides[i] = k_pages.strides(i);
+    params.V_strides[i] = v_pages.strides(i);
+    params.O_strides[i] = out.strides(i);
+  }
+
+  encoder.set_input_array(q);
+  encoder.set_input_array(k_pages);
+  encoder.set_input_array(v_pages);
+  encoder.set_input_array(block_table);
+  encoder.set_input_array(context_lens);
+  encoder.set_output_array(out);
+
+  constexpr int NUM_WARPS = 32;
+  dispatch_float_types(out.dtype(), "paged_attention", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    dispatch_paged_head_dim(q.shape(3), [&](auto head_dim) {
+      encoder.add_kernel_node(
+          cu::paged_attention<DataType, head_dim.value, NUM_WARPS>,
+          dim3(H, qL, B),
+          NUM_WARPS * WARP_SIZE,
+          q.data<DataType>(),
+          k_pages.data<DataType>(),
+          v_pages.data<DataType>(),
+          block_table.data<int32_t>(),
+          context_lens.data<int32_t>(),
+          out.data<DataType>(),
+          params);
+    });
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -0,0 +1,114 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/pinned_staging.h"
+#include "mlx/backend/common/load.h"
+#include "mlx/backend/cuda/allocator.h"
+
+#include <unistd.h>
+
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+
+namespace mlx::core::cu {
+
+PinnedStaging::PinnedStaging(Device& device)
+    : device_(device), stream_(device) {
+  device_.make_current();
+  for (auto& chunk : chunks_) {
+    CHECK_CUDA_ERROR(
+        cudaHostAlloc(&chunk.data, chunk_size, cudaHostAllocDefault));
+  }
+}
+
+void PinnedStaging::stage(
+    allocator::Buffer dst,
+    size_t size,
+    const std::function<void(char*, size_t, size_t)>& fill) {
+  device_.make_current();
+  allocator().prefetch(dst, device_.cuda_device(), stream_);
+  auto* out = static_cast<char*>(dst.raw_ptr());
+  for (size_t pos = 0, i = 0; pos < size; pos += chunk_size, ++i) {
+    auto& chunk = chunks_[i % num_chunks];
+    if (chunk.copied.recorded()) {
+      chunk.copied.wait();
+    }
+    size_t n = std::min(chunk_size, size - pos);
+    fill(chunk.data, pos, n);
+    CHECK_CUDA_ERROR(cudaMemcpyAsync(
+        out + pos, chunk.data, n, cudaMemcpyDefault, stream_));
+    chunk.copied.record(stream_);
+  }
+}
+
+void PinnedStaging::load(
+    io::Reader& reader,
+    allocator::Buffer dst,
+    size_t size,
+    size_t offset,
+    int itemsize,
+    bool swap,
+    SharedEvent& done) {
+  std::lock_guard lock(mutex_);
+  stage(dst, size, [&](char* chunk, size_t pos, size_t n) {
+    reader.read(chunk, n, offset + pos);
+    if (swap) {
+      auto bytes = reinterpret_cast<uint8_t*>(chunk);
+      swap_endianness(bytes, n / itemsize, itemsize);
+    }
+  });
+  done.signal(stream_, 1);
+  // The caller holds |dst| until the copies are done.
+  CHECK_CUDA_ERROR(cudaStreamSynchronize(stream_));
+}
+
+bool PinnedStaging::load_mapped(
+    const char* src,
+    allocator::Buffer dst,
+    size_t size,
+    SharedEvent& done) {
+  std::lock_guard lock(mutex_);
+  device_.make_current();
+  static size_t page = sysconf(_SC_PAGESIZE);
+  auto begin = reinterpret_cast<uintptr_t>(src) / page * page;
+  auto last = reinterpret_cast<uintptr_t>(src) + size;
+  auto end = (last + page - 1) / page * page;
+  auto pages = reinterpret_cast<void*>(begin);
+  if (cudaHostRegister(pages, end - begin, cudaHostRegisterReadOnly) !=
+      cudaSuccess) {
+    // Clear the error, the file is staged instead.
+    cudaGetLastError();
+    return false;
+  }
+  allocator().prefetch(dst, device_.cuda_device(), stream_);
+  CHECK_CUDA_ERROR(cudaMemcpyAsync(
+      dst.raw_ptr(), src, size, cudaMemcpyDefault, stream_));
+  done.signal(stream_, 1);
+  CHECK_CUDA_ERROR(cudaStreamSynchronize(stream_));
+  CHECK_CUDA_ERROR(cudaHostUnregister(pages));
+  return true;
+}
+
+void PinnedStaging::copy(const void* src, allocator::Buffer dst, size_t size) {
+  std::lock_guard lock(mutex_);
+  auto* in = static_cast<const char*>(src);
+  stage(dst, size, [in](char* chunk, size_t pos, size_t n) {
+    std::memcpy(chunk, in + pos, n);
+  });
+  CHECK_CUDA_ERROR(cudaStreamSynchronize(stream_));
+}
+
+PinnedStaging& pinned_staging(Device& device) {
+  static std::mutex mutex;
+  // Leaked on purpose, the pinned memory is freed with the CUDA context.
+  static auto* stagings =
+      new std::unordered_map<int, std::unique_ptr<PinnedStaging>>;
+  std::lock_guard lock(mutex);
+  auto& staging = (*stagings)[device.cuda_device()];
+  if (!staging) {
+    staging = std::make_unique<PinnedStaging>(device);
+  }
+  return *staging;
+}
+
+} // namespace mlx::core::cu
@@ -0,0 +1,83 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/allocator.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/event.h"
+#include "mlx/backend/cuda/utils.h"
+#include "mlx/io/load.h"
+
+#include <array>
+#include <functional>
+#include <mutex>
+
+namespace mlx::core::cu {
+
+// A ring of pinned host buffers the host data is copied through: a chunk is
+// copied to the device in |stream_| while the next chunks are filled, and a
+// buffer is only filled again once its previous copy has finished. The
+// copies run in a stream of their own, next to the work of the compute
+// streams.
+//
+// The managed memory of the destination is prefetched to the device first,
+// so the copies write it in place rather than it migrating by page faults.
+class PinnedStaging {
+ public:
+  // The chunks are large enough for ParallelFileReader to split each read
+  // across its threads.
+  static constexpr size_t chunk_size = 1 << 26;
+  static constexpr int num_chunks = 3;
+
+  explicit PinnedStaging(Device& device);
+
+  PinnedStaging(const PinnedStaging&) = delete;
+  PinnedStaging& operator=(const PinnedStaging&) = delete;
+
+  // Read |size| bytes at |offset| of |reader| to |dst| and signal |done| in
+  // the copy stream after the last copy.
+  void load(
+      io::Reader& reader,
+      allocator::Buffer dst,
+      size_t size,
+      size_t offset,
+      int itemsize,
+      bool swap,
+      SharedEvent& done);
+
+  // Copy |size| bytes of a mapped file at |src| to |dst| straight from its
+  // pages, registered with the device for the DMA, and signal |done| after
+  // the copy. Returns false when the pages cannot be registered.
+  bool load_mapped(
+      const char* src,
+      allocator::Buffer dst,
+      size_t size,
+      SharedEvent& done);
+
+  // Copy |size| bytes of host memory at |src| to |dst|, and return once the
+  // copy is done.
+  void copy(const void* src, allocator::Buffer dst, size_t size);
+
+ private:
+  // Fill the chunks with |fill(chunk, pos, n)| and copy them to |dst|, the
+  // caller holds the lock.
+  void stage(
+      allocator::Buffer dst,
+      size_t size,
+      const std::function<void(char*, size_t, size_t)>& fill);
+
+  struct Chunk {
+    char* data{nullptr};
+    CudaEvent copied;
+  };
+
+  Device& device_;
+  CudaStream stream_;
+  std::array<Chunk, num_chunks> chunks_;
+  std::mutex mutex_;
+};
+
+// The staging of |device|, made on first use.
+PinnedStaging& pinned_staging(Device& device);
+
+} // namespace mlx::core::cu
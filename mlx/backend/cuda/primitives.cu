@@ -4,6 +4,8 @@
 #include "mlx/backend/cuda/device/arange.cuh"
 #include "mlx/backend/cuda/device/fp16_math.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/backend/gpu/eval.h"
 #include "mlx/distributed/primitives.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/fast_primitives.h"
@@ -14,9 +16,68 @@
 #include <thrust/transform.h>
 
 #include <cassert>
+#include <unordered_set>
 
 namespace mlx::core {
 
+namespace cu {
+
+template <typename T>
+__global__ void compute_dynamic_offset(
+    const T* indices,
+    int64_t* offset,
+    const __grid_constant__ Strides strides,
+    const __grid_constant__ cuda::std::array<int32_t, MAX_NDIM> axes,
+    int n_axes) {
+  int64_t acc = 0;
+  for (int i = 0; i < n_axes; ++i) {
+    acc += indices[i] * strides[axes[i]];
+  }
+  *offset = acc;
+}
+
+} // namespace cu
+
+namespace {
+
+// The offset of the start indices is computed on the device, so the copy
+// kernels keep the same parameters whatever the indices, and the cached
+// graphs of a decode loop are updated instead of instantiated again.
+array compute_dynamic_offset(
+    const array& indices,
+    const Strides& strides,
+    const std::vector<int>& axes,
+    const Stream& s) {
+  auto& encoder = cu::get_command_encoder(s);
+  array offset({1}, int64, nullptr, {});
+  bool donate = indices.is_donatable() &&
+      (indices.data_size() * indices.itemsize()) >= offset.itemsize();
+  if (donate) {
+    offset.copy_shared_buffer(indices);
+  } else {
+    offset.set_data(allocator::malloc(offset.itemsize()));
+  }
+  encoder.add_temporary(offset);
+
+  encoder.set_input_array(indices);
+  encoder.set_output_array(offset);
+  dispatch_int_types(indices.dtype(), "DynamicSlice", [&](auto type_tag) {
+    using T = MLX_GET_TYPE(type_tag);
+    encoder.add_kernel_node(
+        cu::compute_dynamic_offset<T>,
+        1,
+        1,
+        indices.data<T>(),
+        offset.data<int64_t>(),
+        const_param(strides),
+        const_param(axes),
+        static_cast<int>(axes.size()));
+  });
+  return offset;
+}
+
+} // namespace
+
 void Arange::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("Arange::eval_gpu");
   assert(inputs.size() == 0);
@@ -33,7 +94,7 @@ void Arange::eval_gpu(const std::vector<array>& inputs, array& out) {
     CTYPE step =
         static_cast<CTYPE>(start_ + step_) - static_cast<CTYPE>(start_);
     thrust::transform(
-        cu::thrust_policy(encoder.stream()),
+        cu::thrust_policy(encoder),
         thrust::counting_iterator<uint32_t>(0),
         thrust::counting_iterator<uint32_t>(out.data_size()),
         thrust::device_pointer_cast(out.data<OutType>()),
@@ -42,22 +103,95 @@ void Arange::eval_gpu(const std::vector<array>& inputs, array& out) {
   });
 }
 
-bool fast::ScaledDotProductAttention::use_fallback(
-    const array& q,
-    const array& k,
-    const array& v,
-    bool has_mask,
-    bool has_arr_mask,
-    bool do_causal,
-    Stream s) {
-  return true;
+void DynamicSlice::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("DynamicSlice::eval_gpu");
+  if (out.size() == 0) {
+    out.set_data(nullptr);
+    return;
+  }
+
+  auto& in = inputs[0];
+  auto& start = inputs[1];
+  out.set_data(allocator::malloc(out.nbytes()));
+  auto s = stream();
+  auto in_offset = compute_dynamic_offset(start, in.strides(), axes_, s);
+  copy_gpu_inplace(
+      /* const array& src = */ in,
+      /* array& dst = */ out,
+      /* const Shape& data_shape = */ out.shape(),
+      /* const Strides& i_strides = */ in.strides(),
+      /* const Strides& o_strides = */ out.strides(),
+      /* int64_t i_offset = */ 0,
+      /* int64_t o_offset = */ 0,
+      /* CopyType ctype = */ CopyType::GeneralGeneral,
+      /* const Stream& s = */ s,
+      /* const std::optional<array>& dynamic_i_offset = */ in_offset,
+      /* const std::optional<array>& dynamic_o_offset = */ std::nullopt);
+}
+
+void DynamicSliceUpdate::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  nvtx3::scoped_range r("DynamicSliceUpdate::eval_gpu");
+  if (out.size() == 0) {
+    out.set_data(nullptr);
+    return;
+  }
+
+  auto& in = inputs[0];
+  auto& upd = inputs[1];
+  auto& start_indices = inputs[2];
+
+  if (upd.size() == 0) {
+    out.copy_shared_buffer(in);
+    return;
+  }
+
+  // Copy or donate input to output
+  auto s = stream();
+  auto ctype = in.flags().contiguous && in.size() == in.data_size()
+      ? CopyType::Vector
+      : CopyType::General;
+  copy_gpu(in, out, in.data_size() == 1 ? CopyType::Scalar : ctype, s);
+
+  auto out_offset =
+      compute_dynamic_offset(start_indices, out.strides(), axes_, s);
+  copy_gpu_inplace(
+      /* const array& src = */ upd,
+      /* array& dst = */ out,
+      /* const Shape& data_shape = */ upd.shape(),
+      /* const Strides& i_strides = */ upd.strides(),
+      /* const Strides& o_strides = */ out.strides(),
+      /* int64_t i_offset = */ 0,
+      /* int64_t o_offset = */ 0,
+      /* CopyType ctype = */ CopyType::GeneralGeneral,
+      /* const Stream& s = */ s,
+      /* const std::optional<array>& dynamic_i_offset = */ std::nullopt,
+      /* const std::optional<array>& dynamic_o_offset = */ out_offset);
+}
+
+namespace {
+
+// The names of the primitives without a CUDA implementation.
+std::unordered_set<std::string>& unsupported_primitives() {
+  static std::unordered_set<std::string> names;
+  return names;
+}
+
+} // namespace
+
+bool gpu::is_supported(Primitive& p) {
+  auto& names = unsupported_primitives();
+  return names.find(p.name()) == names.end();
 }
 
 #define NO_GPU_MULTI(func)                                             \
   void func::eval_gpu(                                                 \
       const std::vector<array>& inputs, std::vector<array>& outputs) { \
     throw std::runtime_error(#func " has no CUDA implementation.");    \
-  }
+  }                                                                    \
+  static bool func##_unsupported =                                     \
+      unsupported_primitives().insert(#func).second;
 
 #define NO_GPU_USE_FALLBACK(func)     \
   bool func::use_fallback(Stream s) { \
@@ -68,37 +202,10 @@ bool fast::ScaledDotProductAttention::use_fallback(
 #define NO_GPU(func)                                                  \
   void func::eval_gpu(const std::vector<array>& inputs, array& out) { \
     throw std::runtime_error(#func " has no CUDA implementation.");   \
-  }
+  }                                                                   \
+  static bool func##_unsupported =                                    \
+      unsupported_primitives().insert(#func).second;
 
-NO_GPU(BlockMaskedMM)
-NO_GPU(Convolution)
-NO_GPU(DynamicSlice)
-NO_GPU(DynamicSliceUpdate)
-NO_GPU(FFT)
-NO_GPU(GatherMM)
-NO_GPU(GatherQMM)
-NO_GPU(Hadamard)
-NO_GPU(Load)
-NO_GPU_MULTI(LUF)
-NO_GPU_MULTI(QRF)
-NO_GPU(QuantizedMatmul)
-NO_GPU(SegmentedMM)
-NO_GPU_MULTI(SVD)
-NO_GPU(Inverse)
-NO_GPU(Cholesky)
 NO_GPU_MULTI(Eig)
-NO_GPU_MULTI(Eigh)
-
-namespace fast {
-NO_GPU(ScaledDotProductAttention)
-NO_GPU_MULTI(CustomKernel)
-} // namespace fast
-
-namespace distributed {
-NO_GPU_MULTI(AllReduce)
-NO_GPU_MULTI(AllGather)
-NO_GPU_MULTI(Send)
-NO_GPU_MULTI(Recv)
-} // namespace distributed
 
 } // namespace mlx::core
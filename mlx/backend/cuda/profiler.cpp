@@ -0,0 +1,150 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/profiler.h"
+#include "mlx/backend/cuda/utils.h"
+
+#include <fmt/format.h>
+
+#include <fstream>
+
+namespace mlx::core::cu {
+
+namespace {
+
+// The trace keeps the first primitives recorded, the stats keep counting.
+constexpr size_t max_trace_events = 1 << 20;
+
+} // namespace
+
+void Profiler::start() {
+  std::lock_guard lock(mutex_);
+  retire(/* wait= */ true);
+  clear();
+  enabled_ = true;
+}
+
+void Profiler::stop() {
+  enabled_ = false;
+}
+
+cudaEvent_t Profiler::new_event(int device) {
+  auto& events = free_events_[device];
+  if (events.empty()) {
+    cudaEvent_t event;
+    CHECK_CUDA_ERROR(cudaEventCreate(&event));
+    return event;
+  }
+  auto event = events.back();
+  events.pop_back();
+  return event;
+}
+
+Profiler::Range Profiler::begin(int device, cudaStream_t stream) {
+  std::lock_guard lock(mutex_);
+  retire(/* wait= */ false);
+  auto [it, inserted] = origins_.try_emplace(device, nullptr);
+  if (inserted) {
+    it->second = new_event(device);
+    CHECK_CUDA_ERROR(cudaEventRecord(it->second, stream));
+  }
+  Range range{new_event(device), new_event(device)};
+  CHECK_CUDA_ERROR(cudaEventRecord(range.start, stream));
+  return range;
+}
+
+void Profiler::end(
+    Range range,
+    int device,
+    int stream_index,
+    cudaStream_t stream,
+    const char* name,
+    size_t bytes) {
+  std::lock_guard lock(mutex_);
+  CHECK_CUDA_ERROR(cudaEventRecord(range.end, stream));
+  pending_.push_back(Record{range, device, stream_index, name, bytes});
+}
+
+void Profiler::retire(bool wait) {
+  while (!pending_.empty()) {
+    auto& record = pending_.front();
+    if (wait) {
+      CHECK_CUDA_ERROR(cudaEventSynchronize(record.range.end));
+    } else if (cudaEventQuery(record.range.end) != cudaSuccess) {
+      break;
+    }
+    float ms;
+    float start_ms;
+    CHECK_CUDA_ERROR(
+        cudaEventElapsedTime(&ms, record.range.start, record.range.end));
+    CHECK_CUDA_ERROR(cudaEventElapsedTime(
+        &start_ms, origins_.at(record.device), record.range.start));
+    auto& stats = stats_[record.name];
+    stats.count++;
+    stats.time_ms += ms;
+    stats.bytes += record.bytes;
+    if (trace_.size() < max_trace_events) {
+      trace_.push_back(TraceEvent{
+          record.name,
+          record.device,
+          record.stream_index,
+          start_ms * 1e3,
+          ms * 1e3,
+          record.bytes});
+    }
+    auto& events = free_events_[record.device];
+    events.push_back(record.range.start);
+    events.push_back(record.range.end);
+    pending_.pop_front();
+  }
+}
+
+void Profiler::clear() {
+  for (auto& [device, event] : origins_) {
+    free_events_[device].push_back(event);
+  }
+  origins_.clear();
+  stats_.clear();
+  trace_.clear();
+}
+
+std::map<std::string, Profiler::Stats> Profiler::stats() {
+  std::lock_guard lock(mutex_);
+  retire(/* wait= */ true);
+  return stats_;
+}
+
+void Profiler::save_trace(const std::string& path) {
+  std::lock_guard lock(mutex_);
+  retire(/* wait= */ true);
+  std::ofstream file(path);
+  if (!file) {
+    throw std::runtime_error(
+        fmt::format("[cuda::save_profiling_trace] Cannot open {}.", path));
+  }
+  file << "{\"traceEvents\": [";
+  for (size_t i = 0; i < trace_.size(); ++i) {
+    auto& e = trace_[i];
+    double gbps = e.duration_us > 0 ? e.bytes / (e.duration_us * 1e3) : 0;
+    file << (i > 0 ? ",\n" : "\n")
+         << fmt::format(
+                "{{\"name\": \"{}\", \"ph\": \"X\", \"pid\": {}, \"tid\": {}, "
+                "\"ts\": {:.3f}, \"dur\": {:.3f}, \"args\": {{\"bytes\": {}, "
+                "\"bandwidth_gbps\": {:.3f}}}}}",
+                e.name,
+                e.device,
+                e.stream_index,
+                e.start_us,
+                e.duration_us,
+                e.bytes,
+                gbps);
+  }
+  file << "\n], \"displayTimeUnit\": \"ms\"}\n";
+}
+
+Profiler& profiler() {
+  // Leaked on purpose, the events are freed with the CUDA context.
+  static auto* profiler = new Profiler;
+  return *profiler;
+}
+
+} // namespace mlx::core::cu
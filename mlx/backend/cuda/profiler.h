@@ -0,0 +1,103 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cuda_runtime.h>
+
+#include <atomic>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mlx::core::cu {
+
+// Times the kernels of each primitive on the GPU with a pair of CUDA events.
+//
+// While profiling, the graph of a stream is committed before and after each
+// primitive so the events only enclose its kernels. This serializes the
+// primitives of a stream, the times are those of the primitives run alone.
+class Profiler {
+ public:
+  struct Range {
+    cudaEvent_t start;
+    cudaEvent_t end;
+  };
+
+  // The totals of a primitive over all its evaluations.
+  struct Stats {
+    size_t count{0};
+    double time_ms{0};
+    size_t bytes{0};
+  };
+
+  Profiler() = default;
+
+  Profiler(const Profiler&) = delete;
+  Profiler& operator=(const Profiler&) = delete;
+
+  bool enabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  // Start recording, the records of a previous run are discarded.
+  void start();
+  void stop();
+
+  // Record the start of a primitive in |stream| of |device|.
+  Range begin(int device, cudaStream_t stream);
+
+  // Record the end of the primitive |name| which read and wrote |bytes|.
+  void end(
+      Range range,
+      int device,
+      int stream_index,
+      cudaStream_t stream,
+      const char* name,
+      size_t bytes);
+
+  std::map<std::string, Stats> stats();
+
+  // Write the recorded primitives in the Chrome trace event format, which
+  // can be opened in Perfetto or chrome://tracing.
+  void save_trace(const std::string& path);
+
+ private:
+  struct Record {
+    Range range;
+    int device;
+    int stream_index;
+    std::string name;
+    size_t bytes;
+  };
+
+  struct TraceEvent {
+    std::string name;
+    int device;
+    int stream_index;
+    double start_us;
+    double duration_us;
+    size_t bytes;
+  };
+
+  cudaEvent_t new_event(int device);
+  // Move the records whose kernels have finished to the stats and the
+  // trace, when |wait| also wait for the unfinished ones.
+  void retire(bool wait);
+  void clear();
+
+  std::atomic<bool> enabled_{false};
+  std::mutex mutex_;
+  std::unordered_map<int, std::vector<cudaEvent_t>> free_events_;
+  std::deque<Record> pending_;
+  // The event all the times of a device are measured from.
+  std::unordered_map<int, cudaEvent_t> origins_;
+  std::map<std::string, Stats> stats_;
+  std::vector<TraceEvent> trace_;
+};
+
+Profiler& profiler();
+
+} // namespace mlx::core::cu
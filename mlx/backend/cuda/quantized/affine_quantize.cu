@@ -0,0 +1,343 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device/indexing.cuh"
+#include "mlx/backend/cuda/quantized/quantized.cuh"
+#include "mlx/backend/cuda/quantized/quantized_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+
+namespace mlx::core {
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+template <typename T, int group_size, int bits>
+__global__ void
+affine_quantize(const T* w, uint8_t* out, T* scales, T* biases, size_t size) {
+  auto block_size = cg::this_thread_block().dim_threads();
+  auto block_idx = cg::this_thread_block().group_index();
+  auto idx_in_block = cg::this_thread_block().thread_index();
+
+  auto tidx = block_idx.x * block_size.x + idx_in_block.x;
+  auto tidy = block_idx.y * block_size.y + idx_in_block.y;
+
+  auto grid_dim_x =
+      cg::this_grid().dim_blocks().x * cg::this_grid().block_index().x;
+  constexpr float eps = 1e-7;
+  constexpr int simd_size = WARP_SIZE;
+  constexpr float n_bins = (1 << bits) - 1;
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int values_per_reduce = group_size / simd_size;
+  constexpr int writes_per_reduce = pack_factor / values_per_reduce;
+  constexpr int writes_per_pack =
+      writes_per_reduce > 1 ? 1 : values_per_reduce / pack_factor;
+  constexpr int power_of_2_bits = (bits & (bits - 1)) == 0;
+
+  size_t offset = tidx + grid_dim_x * size_t(tidy);
+  size_t in_index = offset * values_per_reduce;
+  if (in_index >= size) {
+    return;
+  }
+  size_t out_index = power_of_2_bits
+      ? offset * writes_per_pack
+      : offset * bytes_per_pack / writes_per_reduce;
+
+  float w_thread[values_per_reduce];
+  float w_min = Limits<float>::max();
+  float w_max = 0;
+
+#pragma clang loop unroll(full)
+  for (int i = 0; i < values_per_reduce; i++) {
+    float val = w[in_index + i];
+    w_thread[i] = val;
+    w_min = min(w_min, val);
+    w_max = max(w_max, val);
+  }
+
+  cg::greater<float> max_op;
+  cg::less<float> min_op;
+  auto warp = cg::tiled_partition<WARP_SIZE>(cg::this_thread_block());
+
+  w_min = cg::reduce(warp, w_min, min_op);
+  w_max = cg::reduce(warp, w_max, max_op);
+
+  float scale = max((w_max - w_min) / n_bins, eps);
+  bool side = abs(w_min) > abs(w_max);
+  scale = side ? scale : -scale;
+  float edge = side ? w_min : w_max;
+  float q0 = round(edge / scale);
+  bool at_zero = q0 == 0.0f;
+  scale = at_zero ? scale : edge / q0;
+  float bias = at_zero ? 0 : edge;
+
+  // Write out the scales and biases
+  size_t gindex = in_index / group_size;
+  if (in_index % group_size == 0) {
+    scales[gindex] = static_cast<T>(scale);
+    biases[gindex] = static_cast<T>(bias);
+  }
+
+  using OutType = std::conditional_t<bits == 5, uint64_t, uint32_t>;
+  OutType output = 0;
+
+#pragma clang loop unroll(full)
+  for (int i = 0; i < values_per_reduce; i++) {
+    uint8_t val = min(round((w_thread[i] - bias) / scale), n_bins);
+    if (bits == 8) {
+      output = val;
+    } else {
+      output |= val << (bits * (i % pack_factor));
+    }
+
+    if (pack_factor < values_per_reduce && i % pack_factor == pack_factor - 1) {
+      out[out_index + i / pack_factor] = output;
+      output = 0;
+    } else {
+#pragma clang loop unroll(full)
+      for (int j = 1; j < writes_per_reduce; j++) {
+        uint8_t sval = warp.shfl_down(val, j);
+        output |= static_cast<OutType>(sval)
+            << (bits * (j * values_per_reduce + i));
+      }
+    }
+  }
+  if constexpr (bits == 3 || bits == 6) {
+    if (in_index % pack_factor == 0 && out_index % bytes_per_pack == 0) {
+      out[out_index] = output & 0xff;
+      out[out_index + 1] = (output & 0xff00) >> 8;
+      out[out_index + 2] = (output & 0xff0000) >> 16;
+    }
+  } else if constexpr (bits == 5) {
+    if (in_index % pack_factor == 0 && out_index % bytes_per_pack == 0) {
+      out[out_index] = output & 0xff;
+      out[out_index + 1] = (output & 0xff00) >> 8;
+      out[out_index + 2] = (output & 0xff0000) >> 16;
+      out[out_index + 3] = (output & 0xff000000) >> 24;
+      out[out_index + 4] = (output & 0xff00000000) >> 32;
+    }
+  } else {
+    if constexpr (writes_per_reduce > 0) {
+      if (out_index % writes_per_reduce == 0) {
+        out[out_index / writes_per_reduce] = output;
+      }
+    }
+  }
+}
+
+template <typename T, int group_size, int bits>
+__global__ void affine_dequantize(
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    size_t size) {
+  auto block_size = cg::this_thread_block().dim_threads();
+  auto block_idx = cg::this_thread_block().group_index();
+  auto idx_in_block = cg::this_thread_block().thread_index();
+
+  auto tidx = block_idx.x * block_size.x + idx_in_block.x;
+  auto tidy = block_idx.y * block_size.y + idx_in_block.y;
+
+  auto grid_dim_x =
+      cg::this_grid().dim_blocks().x * cg::this_grid().block_index().x;
+
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+
+  size_t offset = tidx + grid_dim_x * size_t(tidy);
+  size_t oindex = offset * pack_factor;
+
+  if (oindex >= size) {
+    return;
+  }
+
+  size_t gindex = oindex / group_size;
+  T scale = scales[gindex];
+  T bias = biases[gindex];
+  dequantize<bits>(w + offset * bytes_per_pack, scale, bias, out + oindex);
+}
+
+// Dequantize the rows |indices| of |w|, a thread writes a pack of the row i
+// of |out| from the row indices[i] of |w| and its scale and bias.
+template <typename T, int group_size, int bits>
+__global__ void affine_dequantize_rows(
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    const int32_t* indices,
+    T* out,
+    int64_t size,
+    int64_t row_size,
+    int32_t num_rows,
+    const __grid_constant__ Shape idx_shape,
+    const __grid_constant__ Strides idx_strides,
+    int32_t idx_ndim,
+    bool idx_contiguous) {
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+
+  int64_t offset = cg::this_grid().thread_rank();
+  if (offset >= size) {
+    return;
+  }
+  int64_t oindex = offset * pack_factor;
+  int64_t row = oindex / row_size;
+  int64_t col = oindex - row * row_size;
+  int64_t idx_loc = idx_contiguous
+      ? row
+      : elem_to_loc(row, idx_shape.data(), idx_strides.data(), idx_ndim);
+  int64_t w_row = absolute_index(indices[idx_loc], num_rows);
+
+  int64_t gindex = (w_row * row_size + col) / group_size;
+  T scale = scales[gindex];
+  T bias = biases[gindex];
+  int64_t windex = (w_row * row_size + col) / pack_factor * bytes_per_pack;
+  dequantize<bits>(w + windex, scale, bias, out + oindex);
+}
+
+} // namespace cu
+
+void affine_quantize(
+    const array& w,
+    array& wq,
+    array& scales,
+    array& biases,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s) {
+  // Each thread reduces group_size / WARP_SIZE values.
+  int per_thread = group_size / WARP_SIZE;
+  size_t size = w.size() / per_thread;
+
+  bool large = size > UINT_MAX;
+  auto grid_shape = w.shape();
+  grid_shape.back() /= per_thread;
+
+  enc.set_input_array(w);
+  enc.set_output_array(wq);
+  enc.set_output_array(scales);
+  enc.set_output_array(biases);
+  dispatch_float_types(w.dtype(), "affine_quantize", [&](auto type_tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel =
+            cu::affine_quantize<DataType, group_size.value, bits.value>;
+        auto [num_blocks, block_dims] =
+            get_launch_args(kernel, size, grid_shape, w.strides(), large);
+        enc.add_kernel_node(
+            kernel,
+            num_blocks,
+            block_dims,
+            w.data<DataType>(),
+            wq.data<uint8_t>(),
+            scales.data<DataType>(),
+            biases.data<DataType>(),
+            w.size());
+      });
+    });
+  });
+}
+
+void affine_dequantize(
+    const array& wq,
+    const array& scales,
+    const array& biases,
+    array& w,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s) {
+  // Treat uint32 as uint8 in kernel.
+  constexpr int uint8_per_uint32 = 4;
+  int packs_per_int = (bits == 3 || bits == 5) ? 8
+      : bits == 6                              ? 4
+                                               : 8 / bits;
+  size_t size = w.size() / packs_per_int;
+
+  bool large = size > UINT_MAX;
+  auto grid_shape = wq.shape();
+  grid_shape.back() *= uint8_per_uint32;
+
+  enc.set_input_array(wq);
+  enc.set_input_array(scales);
+  enc.set_input_array(biases);
+  enc.set_output_array(w);
+  dispatch_float_types(w.dtype(), "affine_dequantize", [&](auto type_tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel =
+            cu::affine_dequantize<DataType, group_size.value, bits.value>;
+        auto [num_blocks, block_dims] =
+            get_launch_args(kernel, size, grid_shape, wq.strides(), large);
+        enc.add_kernel_node(
+            kernel,
+            num_blocks,
+            block_dims,
+            wq.data<uint8_t>(),
+            scales.data<DataType>(),
+            biases.data<DataType>(),
+            w.data<DataType>(),
+            w.size());
+      });
+    });
+  });
+}
+
+void affine_dequantize_rows(
+    const array& wq,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    array& out,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s) {
+  int packs_per_int = (bits == 3 || bits == 5) ? 8
+      : bits == 6                              ? 4
+                                               : 8 / bits;
+  int64_t row_size = out.shape(-1);
+  int64_t size = out.size() / packs_per_int;
+  bool idx_contiguous = indices.flags().row_contiguous;
+
+  enc.set_input_array(wq);
+  enc.set_input_array(scales);
+  enc.set_input_array(biases);
+  enc.set_input_array(indices);
+  enc.set_output_array(out);
+  dispatch_float_types(out.dtype(), "affine_dequantize_rows", [&](auto tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(tag)>;
+        constexpr int block_dim = 256;
+        enc.add_kernel_node(
+            cu::affine_dequantize_rows<
+                DataType,
+                group_size.value,
+                bits.value>,
+            cuda::ceil_div(size, block_dim),
+            block_dim,
+            wq.data<uint8_t>(),
+            scales.data<DataType>(),
+            biases.data<DataType>(),
+            indices.data<int32_t>(),
+            out.data<DataType>(),
+            size,
+            row_size,
+            static_cast<int32_t>(wq.shape(0)),
+            const_param(indices.shape()),
+            const_param(indices.strides()),
+            static_cast<int32_t>(indices.ndim()),
+            idx_contiguous);
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
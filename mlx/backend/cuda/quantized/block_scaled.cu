@@ -0,0 +1,211 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/quantized/quantized.cuh"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <cooperative_groups.h>
+#include <cuda_fp8.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+using Mode = fast::BlockScaledQuantize::Mode;
+
+template <int mode>
+struct BlockScaledFormat {
+  static constexpr int group_size = mode == Mode::NVFP4 ? 16 : 32;
+  static constexpr int bits = mode == Mode::MXFP8 ? 8 : 4;
+  // The exponent of the largest value of the element format.
+  static constexpr float emax = mode == Mode::MXFP8 ? 8.0f : 2.0f;
+};
+
+// Rounds to the nearest e2m1 value with the ties to even and saturates.
+__device__ __forceinline__ uint8_t to_fp4(float x) {
+  float a = fabsf(x);
+  uint8_t code = (a > 0.25f) + (a >= 0.75f) + (a > 1.25f) + (a >= 1.75f) +
+      (a > 2.5f) + (a >= 3.5f) + (a > 5.0f);
+  return x < 0.0f ? code | 8 : code;
+}
+
+__device__ __forceinline__ float from_fp4(uint8_t x) {
+  constexpr float values[8] = {0.0f, 0.5f, 1.0f, 1.5f, 2.0f, 3.0f, 4.0f, 6.0f};
+  float v = values[x & 7];
+  return (x & 8) ? -v : v;
+}
+
+template <int mode>
+__device__ __forceinline__ float decode_scale(uint8_t x) {
+  if constexpr (mode == Mode::NVFP4) {
+    __nv_fp8_e4m3 scale;
+    scale.__x = x;
+    return static_cast<float>(scale);
+  } else {
+    return exp2f(static_cast<float>(x) - 127.0f);
+  }
+}
+
+// Each thread quantizes one group and writes its packed bytes and its scale.
+template <typename T, int mode>
+__global__ void block_scaled_quantize(
+    const T* w,
+    uint8_t* out,
+    uint8_t* scales,
+    size_t num_groups) {
+  using Format = BlockScaledFormat<mode>;
+  constexpr int group_size = Format::group_size;
+  size_t g = cg::this_grid().thread_rank();
+  if (g >= num_groups) {
+    return;
+  }
+
+  float vals[group_size];
+  float amax = 0.0f;
+#pragma unroll
+  for (int i = 0; i < group_size; i++) {
+    vals[i] = static_cast<float>(w[g * group_size + i]);
+    amax = fmaxf(amax, fabsf(vals[i]));
+  }
+
+  float scale;
+  uint8_t scale_byte;
+  if constexpr (mode == Mode::NVFP4) {
+    __nv_fp8_e4m3 scale_fp8(amax / 6.0f);
+    scale_byte = scale_fp8.__x;
+    scale = static_cast<float>(scale_fp8);
+  } else {
+    float e = amax > 0.0f ? floorf(log2f(amax)) - Format::emax : -127.0f;
+    e = fminf(fmaxf(e, -127.0f), 127.0f);
+    scale_byte = static_cast<uint8_t>(e + 127.0f);
+    scale = exp2f(e);
+  }
+  scales[g] = scale_byte;
+
+  if constexpr (Format::bits == 8) {
+    uint8_t* out_g = out + g * group_size;
+#pragma unroll
+    for (int i = 0; i < group_size; i++) {
+      float y = scale == 0.0f ? 0.0f : vals[i] / scale;
+      out_g[i] = __nv_fp8_e4m3(y).__x;
+    }
+  } else {
+    uint8_t* out_g = out + g * group_size / 2;
+#pragma unroll
+    for (int i = 0; i < group_size; i += 2) {
+      float y0 = scale == 0.0f ? 0.0f : vals[i] / scale;
+      float y1 = scale == 0.0f ? 0.0f : vals[i + 1] / scale;
+      out_g[i / 2] = to_fp4(y0) | (to_fp4(y1) << 4);
+    }
+  }
+}
+
+// Each thread dequantizes one element.
+template <typename T, int mode>
+__global__ void block_scaled_dequantize(
+    const uint8_t* w,
+    const uint8_t* scales,
+    T* out,
+    size_t size) {
+  using Format = BlockScaledFormat<mode>;
+  size_t index = cg::this_grid().thread_rank();
+  if (index >= size) {
+    return;
+  }
+  float val;
+  if constexpr (Format::bits == 8) {
+    __nv_fp8_e4m3 x;
+    x.__x = w[index];
+    val = static_cast<float>(x);
+  } else {
+    val = from_fp4((w[index / 2] >> ((index % 2) * 4)) & 0xf);
+  }
+  float scale = decode_scale<mode>(scales[index / Format::group_size]);
+  out[index] = static_cast<T>(val * scale);
+}
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_block_scaled_mode(cu::Mode mode, F&& f) {
+  switch (mode) {
+    case cu::Mode::MXFP4:
+      f(std::integral_constant<int, cu::Mode::MXFP4>{});
+      break;
+    case cu::Mode::NVFP4:
+      f(std::integral_constant<int, cu::Mode::NVFP4>{});
+      break;
+    case cu::Mode::MXFP8:
+      f(std::integral_constant<int, cu::Mode::MXFP8>{});
+      break;
+  }
+}
+
+} // namespace
+
+bool fast::BlockScaledQuantize::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void fast::BlockScaledQuantize::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("BlockScaledQuantize::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  auto w = ensure_row_contiguous(inputs[0], enc, s);
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  constexpr int block_dim = 256;
+
+  if (dequantize_) {
+    auto scales = ensure_row_contiguous(inputs[1], enc, s);
+    enc.set_input_array(w);
+    enc.set_input_array(scales);
+    enc.set_output_array(out);
+    dispatch_float_types(out.dtype(), "block_scaled_dequantize", [&](auto t) {
+      dispatch_block_scaled_mode(mode_, [&](auto mode) {
+        using T = cuda_type_t<MLX_GET_TYPE(t)>;
+        enc.add_kernel_node(
+            cu::block_scaled_dequantize<T, mode.value>,
+            cuda::ceil_div(out.size(), block_dim),
+            block_dim,
+            w.data<uint8_t>(),
+            scales.data<uint8_t>(),
+            out.data<T>(),
+            out.size());
+      });
+    });
+  } else {
+    auto& scales = outputs[1];
+    scales.set_data(allocator::malloc(scales.nbytes()));
+    enc.set_input_array(w);
+    enc.set_output_array(out);
+    enc.set_output_array(scales);
+    dispatch_float_types(w.dtype(), "block_scaled_quantize", [&](auto t) {
+      dispatch_block_scaled_mode(mode_, [&](auto mode) {
+        using T = cuda_type_t<MLX_GET_TYPE(t)>;
+        enc.add_kernel_node(
+            cu::block_scaled_quantize<T, mode.value>,
+            cuda::ceil_div(scales.size(), block_dim),
+            block_dim,
+            w.data<T>(),
+            out.data<uint8_t>(),
+            scales.data<uint8_t>(),
+            scales.size());
+      });
+    });
+  }
+}
+
+} // namespace mlx::core
@@ -0,0 +1,381 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device/mma.cuh"
+#include "mlx/backend/cuda/quantized/quantized.cuh"
+#include "mlx/backend/cuda/quantized/quantized_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Dequantize the [BN, BK] tile of w at (n0, k0) into |ws|, which is always
+// stored as [n][k] so the same MMA is used for both layouts.
+template <
+    typename T,
+    int group_size,
+    int bits,
+    bool transpose,
+    int BN,
+    int BK,
+    int LDS,
+    int NUM_THREADS>
+inline __device__ void load_w_tile(
+    T* ws,
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    int n0,
+    int k0,
+    int N,
+    int K,
+    int tid) {
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  int64_t row_bytes = int64_t(transpose ? K : N) * bits / 8;
+  int groups_per_row = (transpose ? K : N) / group_size;
+
+  if constexpr (transpose) {
+    constexpr int packs_per_row = BK / pack_factor;
+    for (int i = tid; i < BN * packs_per_row; i += NUM_THREADS) {
+      int r = i / packs_per_row;
+      int p = i % packs_per_row;
+      int n = n0 + r;
+      int k = k0 + p * pack_factor;
+      T vals[pack_factor];
+      if (n < N) {
+        int64_t g = int64_t(n) * groups_per_row + k / group_size;
+        dequantize<bits>(
+            w + n * row_bytes + k / pack_factor * bytes_per_pack,
+            scales[g],
+            biases[g],
+            vals);
+      } else {
+#pragma unroll
+        for (int j = 0; j < pack_factor; ++j) {
+          vals[j] = static_cast<T>(0);
+        }
+      }
+#pragma unroll
+      for (int j = 0; j < pack_factor; ++j) {
+        ws[r * LDS + p * pack_factor + j] = vals[j];
+      }
+    }
+  } else {
+    constexpr int packs_per_row = BN / pack_factor;
+    for (int i = tid; i < BK * packs_per_row; i += NUM_THREADS) {
+      int r = i / packs_per_row;
+      int p = i % packs_per_row;
+      int k = k0 + r;
+      int n = n0 + p * pack_factor;
+      T vals[pack_factor];
+      if (k < K && n < N) {
+        int64_t g = int64_t(k) * groups_per_row + n / group_size;
+        dequantize<bits>(
+            w + k * row_bytes + n / pack_factor * bytes_per_pack,
+            scales[g],
+            biases[g],
+            vals);
+      } else {
+#pragma unroll
+        for (int j = 0; j < pack_factor; ++j) {
+          vals[j] = static_cast<T>(0);
+        }
+      }
+#pragma unroll
+      for (int j = 0; j < pack_factor; ++j) {
+        ws[(p * pack_factor + j) * LDS + r] = vals[j];
+      }
+    }
+  }
+}
+
+// Computes out = x @ w.T (transpose) or out = x @ w where the quantized w is
+// dequantized into shared memory one [BN, BK] tile at a time.
+template <
+    typename T,
+    int group_size,
+    int bits,
+    bool transpose,
+    int BM = 64,
+    int BN = 64,
+    int BK = 32>
+__global__ void qmm(
+    const T* x,
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    int M,
+    int N,
+    int K,
+    const __grid_constant__ QuantizedBatch batch) {
+  static_assert(group_size % BK == 0, "A tile must not cross groups.");
+  // Pad the tiles to avoid bank conflicts while keeping the 32 bytes alignment
+  // required by wmma.
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  constexpr int NUM_THREADS = 128;
+
+  __shared__ __align__(32) T xs[BM * LDS];
+  __shared__ __align__(32) T ws[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+
+  int64_t batch_idx = batch.batch_offset + blockIdx.z;
+  batch_offsets(batch, batch_idx, x, w, scales, biases);
+  out += batch_idx * M * N;
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  for (int k0 = 0; k0 < K; k0 += BK) {
+    // Load the x tile.
+    for (int i = tid; i < BM * BK; i += NUM_THREADS) {
+      int r = i / BK;
+      int c = i % BK;
+      int m = m0 + r;
+      int k = k0 + c;
+      xs[r * LDS + c] =
+          (m < M && k < K) ? x[int64_t(m) * K + k] : static_cast<T>(0);
+    }
+    load_w_tile<T, group_size, bits, transpose, BN, BK, LDS, NUM_THREADS>(
+        ws, w, scales, biases, n0, k0, N, K, tid);
+    block.sync();
+
+    mma.mma(xs, ws);
+    block.sync();
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, NUM_THREADS>(cs, out, N, m0, n0, M, N, tid);
+}
+
+// Computes out[i] = x[lhs_indices[i]] @ w[rhs_indices[i]] for the B rows of
+// x (M == 1), the rows are expected to be sorted by rhs_indices.
+//
+// Each block walks the runs of rows sharing an expert in its tile, a run is
+// multiplied with the dequantized w of its expert while the other rows of the
+// tile are zeroed, so the accumulators hold the result for all the rows at
+// the end.
+template <
+    typename T,
+    int group_size,
+    int bits,
+    bool transpose,
+    int BM = 64,
+    int BN = 64,
+    int BK = 32>
+__global__ void gather_qmm_rhs(
+    const T* x,
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    int B,
+    int N,
+    int K,
+    const __grid_constant__ QuantizedBatch batch) {
+  static_assert(group_size % BK == 0, "A tile must not cross groups.");
+  constexpr int LDS = BK + 16;
+  constexpr int LDC = BN + 8;
+  constexpr int NUM_THREADS = 128;
+
+  __shared__ __align__(32) T xs[BM * LDS];
+  __shared__ __align__(32) T ws[BN * LDS];
+  __shared__ __align__(32) float cs[BM * LDC];
+  __shared__ const T* x_rows[BM];
+  __shared__ uint32_t experts[BM];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int m0 = blockIdx.y * BM;
+  int n0 = blockIdx.x * BN;
+  int rows = min(BM, B - m0);
+
+  for (int r = tid; r < rows; r += NUM_THREADS) {
+    auto [lhs_loc, rhs_loc] = elem_to_loc_4d(
+        int64_t(m0 + r),
+        batch.idx_shape.data(),
+        batch.lhs_strides.data(),
+        batch.rhs_strides.data(),
+        batch.idx_ndims);
+    int64_t x_loc = elem_to_loc(
+        int64_t(batch.lhs_indices[lhs_loc]),
+        batch.x_shape.data(),
+        batch.x_strides.data(),
+        batch.x_batch_ndims);
+    x_rows[r] = x + x_loc;
+    experts[r] = batch.rhs_indices[rhs_loc];
+  }
+  block.sync();
+
+  BlockMma<T, BM, BN, BK, LDS, LDC> mma(tid);
+
+  int run_start = 0;
+  while (run_start < rows) {
+    uint32_t expert = experts[run_start];
+    int run_end = run_start + 1;
+    while (run_end < rows && experts[run_end] == expert) {
+      run_end++;
+    }
+
+    auto [w_loc, s_loc, b_loc] = elem_to_loc_4d(
+        int64_t(expert),
+        batch.w_shape.data(),
+        batch.w_strides.data(),
+        batch.scales_strides.data(),
+        batch.biases_strides.data(),
+        batch.w_batch_ndims);
+    const uint8_t* we = w + w_loc * sizeof(uint32_t);
+    const T* se = scales + s_loc;
+    const T* be = biases + b_loc;
+
+    for (int k0 = 0; k0 < K; k0 += BK) {
+      for (int i = tid; i < BM * BK; i += NUM_THREADS) {
+        int r = i / BK;
+        int c = i % BK;
+        int k = k0 + c;
+        xs[r * LDS + c] = (r >= run_start && r < run_end && k < K)
+            ? x_rows[r][k]
+            : static_cast<T>(0);
+      }
+      load_w_tile<T, group_size, bits, transpose, BN, BK, LDS, NUM_THREADS>(
+          ws, we, se, be, n0, k0, N, K, tid);
+      block.sync();
+
+      mma.mma(xs, ws);
+      block.sync();
+    }
+
+    run_start = run_end;
+  }
+
+  mma.store(cs);
+  block.sync();
+  store_tile<BM, BN, LDC, NUM_THREADS>(cs, out, N, m0, n0, B, N, tid);
+}
+
+} // namespace cu
+
+void qmm(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int M,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc) {
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  enc.set_input_array(x);
+  enc.set_input_array(w);
+  enc.set_input_array(scales);
+  enc.set_input_array(biases);
+  enc.set_output_array(out);
+  dispatch_float_types(out.dtype(), "qmm", [&](auto type_tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        dispatch_bool(transpose, [&](auto transpose) {
+          using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+          auto kernel = cu::qmm<
+              DataType,
+              group_size.value,
+              bits.value,
+              transpose.value,
+              BM,
+              BN>;
+          for (int b0 = 0; b0 < batch.batch_count; b0 += max_grid_yz) {
+            batch.batch_offset = b0;
+            dim3 num_blocks(
+                cuda::ceil_div(N, BN),
+                cuda::ceil_div(M, BM),
+                std::min(batch.batch_count - b0, max_grid_yz));
+            enc.add_kernel_node(
+                kernel,
+                num_blocks,
+                128,
+                x.data<DataType>(),
+                w.data<uint8_t>(),
+                scales.data<DataType>(),
+                biases.data<DataType>(),
+                out.data<DataType>(),
+                M,
+                N,
+                K,
+                batch);
+          }
+        });
+      });
+    });
+  });
+}
+
+void gather_qmm_rhs(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int B,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc) {
+  constexpr int BM = 64;
+  constexpr int BN = 64;
+  enc.set_input_array(x);
+  enc.set_input_array(w);
+  enc.set_input_array(scales);
+  enc.set_input_array(biases);
+  enc.set_output_array(out);
+  dispatch_float_types(out.dtype(), "gather_qmm_rhs", [&](auto type_tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        dispatch_bool(transpose, [&](auto transpose) {
+          using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+          auto kernel = cu::gather_qmm_rhs<
+              DataType,
+              group_size.value,
+              bits.value,
+              transpose.value,
+              BM,
+              BN>;
+          dim3 num_blocks(cuda::ceil_div(N, BN), cuda::ceil_div(B, BM));
+          enc.add_kernel_node(
+              kernel,
+              num_blocks,
+              128,
+              x.data<DataType>(),
+              w.data<uint8_t>(),
+              scales.data<DataType>(),
+              biases.data<DataType>(),
+              out.data<DataType>(),
+              B,
+              N,
+              K,
+              batch);
+        });
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,260 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/quantized/quantized.cuh"
+#include "mlx/backend/cuda/quantized/quantized_utils.cuh"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Each thread dequantizes 8 consecutive values at a time, which is a multiple
+// of the pack factor of every supported bits and always falls in one group.
+constexpr int qmv_values_per_thread = 8;
+
+// Computes out = x @ w.T where w is [N, K] quantized along K.
+//
+// Each warp computes one output column for all the M rows, the lanes stride
+// over K and the partial dot products are reduced across the warp.
+template <typename T, int group_size, int bits, int WARPS_PER_BLOCK>
+__global__ void qmv(
+    const T* x,
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    int M,
+    int N,
+    int K,
+    const __grid_constant__ QuantizedBatch batch) {
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int packs_per_thread = qmv_values_per_thread / pack_factor;
+
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+
+  int n = blockIdx.x * WARPS_PER_BLOCK + warp.meta_group_rank();
+  if (n >= N) {
+    return;
+  }
+
+  int64_t batch_idx = batch.batch_offset + blockIdx.y;
+  batch_offsets(batch, batch_idx, x, w, scales, biases);
+  out += batch_idx * M * N;
+
+  int64_t row_bytes = int64_t(K) * bits / 8;
+  int groups_per_row = K / group_size;
+  w += n * row_bytes;
+  scales += int64_t(n) * groups_per_row;
+  biases += int64_t(n) * groups_per_row;
+
+  float acc[qmv_max_rows] = {0};
+  for (int k = warp.thread_rank() * qmv_values_per_thread; k < K;
+       k += WARP_SIZE * qmv_values_per_thread) {
+    // Unpack the raw quantized values, the scale and bias of the group are
+    // applied to the dot product instead.
+    float q[qmv_values_per_thread];
+    const uint8_t* wk = w + k / pack_factor * bytes_per_pack;
+#pragma unroll
+    for (int p = 0; p < packs_per_thread; ++p) {
+      dequantize<bits>(
+          wk + p * bytes_per_pack, 1.0f, 0.0f, q + p * pack_factor);
+    }
+    float scale = scales[k / group_size];
+    float bias = biases[k / group_size];
+
+#pragma unroll
+    for (int m = 0; m < qmv_max_rows; ++m) {
+      if (m < M) {
+        const T* xm = x + int64_t(m) * K + k;
+        float dot = 0;
+        float sum = 0;
+#pragma unroll
+        for (int i = 0; i < qmv_values_per_thread; ++i) {
+          float xi = static_cast<float>(xm[i]);
+          dot += xi * q[i];
+          sum += xi;
+        }
+        acc[m] += scale * dot + bias * sum;
+      }
+    }
+  }
+
+#pragma unroll
+  for (int m = 0; m < qmv_max_rows; ++m) {
+    if (m < M) {
+      float val = cg::reduce(warp, acc[m], cg::plus<float>{});
+      if (warp.thread_rank() == 0) {
+        out[int64_t(m) * N + n] = static_cast<T>(val);
+      }
+    }
+  }
+}
+
+// Computes out = x @ w where w is [K, N] quantized along N.
+//
+// The threads in x dimension handle 8 consecutive output columns each, and
+// the threads in y dimension split K, the partial sums are then reduced in
+// shared memory.
+template <typename T, int group_size, int bits, int COLS, int SPLIT_K>
+__global__ void qvm(
+    const T* x,
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    T* out,
+    int M,
+    int N,
+    int K,
+    const __grid_constant__ QuantizedBatch batch) {
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  constexpr int bytes_per_pack = get_bytes_per_pack<bits>();
+  constexpr int packs_per_thread = qmv_values_per_thread / pack_factor;
+  constexpr int BN = COLS * qmv_values_per_thread;
+
+  __shared__ float partials[SPLIT_K][BN];
+
+  auto block = cg::this_thread_block();
+  int tx = block.thread_index().x;
+  int ty = block.thread_index().y;
+
+  int64_t batch_idx = batch.batch_offset + blockIdx.y;
+  batch_offsets(batch, batch_idx, x, w, scales, biases);
+  out += batch_idx * M * N;
+
+  int n0 = blockIdx.x * BN;
+  int n = n0 + tx * qmv_values_per_thread;
+  int64_t row_bytes = int64_t(N) * bits / 8;
+  int groups_per_row = N / group_size;
+
+  float acc[qmv_max_rows][qmv_values_per_thread] = {};
+  if (n < N) {
+    for (int k = ty; k < K; k += SPLIT_K) {
+      float scale = scales[int64_t(k) * groups_per_row + n / group_size];
+      float bias = biases[int64_t(k) * groups_per_row + n / group_size];
+      float wk[qmv_values_per_thread];
+      const uint8_t* wp = w + k * row_bytes + n / pack_factor * bytes_per_pack;
+#pragma unroll
+      for (int p = 0; p < packs_per_thread; ++p) {
+        dequantize<bits>(
+            wp + p * bytes_per_pack, scale, bias, wk + p * pack_factor);
+      }
+#pragma unroll
+      for (int m = 0; m < qmv_max_rows; ++m) {
+        if (m < M) {
+          float xk = static_cast<float>(x[int64_t(m) * K + k]);
+#pragma unroll
+          for (int i = 0; i < qmv_values_per_thread; ++i) {
+            acc[m][i] += xk * wk[i];
+          }
+        }
+      }
+    }
+  }
+
+  // Reduce the SPLIT_K partial sums of each column.
+  for (int m = 0; m < M; ++m) {
+#pragma unroll
+    for (int i = 0; i < qmv_values_per_thread; ++i) {
+      partials[ty][tx * qmv_values_per_thread + i] = acc[m][i];
+    }
+    block.sync();
+    for (int c = block.thread_rank(); c < BN; c += COLS * SPLIT_K) {
+      float val = 0;
+#pragma unroll
+      for (int j = 0; j < SPLIT_K; ++j) {
+        val += partials[j][c];
+      }
+      if (n0 + c < N) {
+        out[int64_t(m) * N + n0 + c] = static_cast<T>(val);
+      }
+    }
+    block.sync();
+  }
+}
+
+} // namespace cu
+
+void qmv(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int M,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc) {
+  enc.set_input_array(x);
+  enc.set_input_array(w);
+  enc.set_input_array(scales);
+  enc.set_input_array(biases);
+  enc.set_output_array(out);
+  dispatch_float_types(out.dtype(), "qmv", [&](auto type_tag) {
+    dispatch_groups(group_size, [&](auto group_size) {
+      dispatch_bits(bits, [&](auto bits) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        if (transpose) {
+          constexpr int warps_per_block = 8;
+          auto kernel = cu::
+              qmv<DataType, group_size.value, bits.value, warps_per_block>;
+          for (int b0 = 0; b0 < batch.batch_count; b0 += max_grid_yz) {
+            batch.batch_offset = b0;
+            dim3 num_blocks(
+                cuda::ceil_div(N, warps_per_block),
+                std::min(batch.batch_count - b0, max_grid_yz));
+            enc.add_kernel_node(
+                kernel,
+                num_blocks,
+                warps_per_block * WARP_SIZE,
+                x.data<DataType>(),
+                w.data<uint8_t>(),
+                scales.data<DataType>(),
+                biases.data<DataType>(),
+                out.data<DataType>(),
+                M,
+                N,
+                K,
+                batch);
+          }
+        } else {
+          constexpr int cols = 8;
+          constexpr int split_k = 32;
+          auto kernel = cu::
+              qvm<DataType, group_size.value, bits.value, cols, split_k>;
+          for (int b0 = 0; b0 < batch.batch_count; b0 += max_grid_yz) {
+            batch.batch_offset = b0;
+            dim3 num_blocks(
+                cuda::ceil_div(N, cols * cu::qmv_values_per_thread),
+                std::min(batch.batch_count - b0, max_grid_yz));
+            enc.add_kernel_node(
+                kernel,
+                num_blocks,
+                dim3(cols, split_k),
+                x.data<DataType>(),
+                w.data<uint8_t>(),
+                scales.data<DataType>(),
+                biases.data<DataType>(),
+                out.data<DataType>(),
+                M,
+                N,
+                K,
+                batch);
+          }
+        }
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,250 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+
+namespace mlx::core {
+
+template <typename F>
+void dispatch_groups(int group_size, F&& f) {
+  switch (group_size) {
+    case 32:
+      f(std::integral_constant<int, 32>{});
+      break;
+    case 64:
+      f(std::integral_constant<int, 64>{});
+      break;
+    case 128:
+      f(std::integral_constant<int, 128>{});
+      break;
+  }
+}
+
+template <typename F>
+void dispatch_bits(int bits, F&& f) {
+  switch (bits) {
+    case 2:
+      f(std::integral_constant<int, 2>{});
+      break;
+    case 3:
+      f(std::integral_constant<int, 3>{});
+      break;
+    case 4:
+      f(std::integral_constant<int, 4>{});
+      break;
+    case 5:
+      f(std::integral_constant<int, 5>{});
+      break;
+    case 6:
+      f(std::integral_constant<int, 6>{});
+      break;
+    case 8:
+      f(std::integral_constant<int, 8>{});
+      break;
+  }
+}
+
+inline array ensure_row_contiguous(
+    const array& x,
+    cu::CommandEncoder& enc,
+    const Stream& s) {
+  if (!x.flags().row_contiguous) {
+    array x_copy = contiguous_copy_gpu(x, s);
+    enc.add_temporary(x_copy);
+    return x_copy;
+  } else {
+    return x;
+  }
+}
+
+// Only make sure the last two dims are row contiguous, the batch dims can have
+// arbitrary strides.
+inline array ensure_row_contiguous_matrix(
+    const array& x,
+    cu::CommandEncoder& enc,
+    const Stream& s) {
+  auto stride_0 = x.strides()[x.ndim() - 2];
+  auto stride_1 = x.strides()[x.ndim() - 1];
+  if (stride_0 == x.shape(-1) && stride_1 == 1) {
+    return x;
+  } else {
+    array x_copy = contiguous_copy_gpu(x, s);
+    enc.add_temporary(x_copy);
+    return x_copy;
+  }
+}
+
+void affine_quantize(
+    const array& w,
+    array& wq,
+    array& scales,
+    array& biases,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s);
+
+void affine_dequantize(
+    const array& wq,
+    const array& scales,
+    const array& biases,
+    array& w,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s);
+
+// Dequantize the rows |indices| of |wq| into |out|, the rows of |wq|,
+// |scales| and |biases| must be contiguous and |indices| are int32.
+void affine_dequantize_rows(
+    const array& wq,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    array& out,
+    int group_size,
+    int bits,
+    cu::CommandEncoder& enc,
+    const Stream& s);
+
+// The batch layout shared by the quantized matmul kernels. |x| must have its
+// last two dims row contiguous, and |w|, |scales| and |biases| share the same
+// batch shape.
+//
+// When |lhs_indices| and |rhs_indices| are set, the batch element i of the
+// output is computed from x[lhs_indices[i]] and w[rhs_indices[i]] (GatherQMM),
+// otherwise x and w are broadcasted to the batch shape of the output. A launch
+// computes the batch elements from |batch_offset| on, in the grid.
+struct QuantizedBatch {
+  int batch_count;
+  int batch_offset;
+  int idx_ndims;
+  cu::Shape idx_shape;
+  cu::Strides lhs_strides;
+  cu::Strides rhs_strides;
+  const uint32_t* lhs_indices;
+  const uint32_t* rhs_indices;
+  int x_batch_ndims;
+  cu::Shape x_shape;
+  cu::Strides x_strides;
+  int w_batch_ndims;
+  cu::Shape w_shape;
+  cu::Strides w_strides;
+  cu::Strides scales_strides;
+  cu::Strides biases_strides;
+};
+
+// Move the pointers to the batch element |batch_idx|.
+template <typename T>
+inline __device__ void batch_offsets(
+    const QuantizedBatch& b,
+    int64_t batch_idx,
+    const T*& x,
+    const uint8_t*& w,
+    const T*& scales,
+    const T*& biases) {
+  int64_t x_idx = batch_idx;
+  int64_t w_idx = batch_idx;
+  if (b.lhs_indices) {
+    auto [lhs_loc, rhs_loc] = cu::elem_to_loc_4d(
+        batch_idx,
+        b.idx_shape.data(),
+        b.lhs_strides.data(),
+        b.rhs_strides.data(),
+        b.idx_ndims);
+    x_idx = b.lhs_indices[lhs_loc];
+    w_idx = b.rhs_indices[rhs_loc];
+  }
+  x += cu::elem_to_loc(
+      x_idx, b.x_shape.data(), b.x_strides.data(), b.x_batch_ndims);
+  if (b.w_batch_ndims > 0) {
+    auto [w_loc, s_loc, b_loc] = cu::elem_to_loc_4d(
+        w_idx,
+        b.w_shape.data(),
+        b.w_strides.data(),
+        b.scales_strides.data(),
+        b.biases_strides.data(),
+        b.w_batch_ndims);
+    // The strides of w are in number of uint32.
+    w += w_loc * sizeof(uint32_t);
+    scales += s_loc;
+    biases += b_loc;
+  }
+}
+
+QuantizedBatch quantized_batch(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& out,
+    int M,
+    int N);
+
+QuantizedBatch gather_quantized_batch(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& lhs_indices,
+    const array& rhs_indices);
+
+// The largest M handled by qmv.
+constexpr int qmv_max_rows = 8;
+
+// Matrix-vector products used when M is small (decode). The weights are read
+// once and the dot products for all the M rows are kept in registers.
+void qmv(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int M,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc);
+
+// Tiled matrix-matrix products, the weights are dequantized into shared memory
+// tile by tile and fed to the tensor cores.
+void qmm(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int M,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc);
+
+// Quantized matmul of rows of x sorted by their rhs index (experts), the rows
+// of a tile sharing an expert are multiplied together so each tile of w is
+// dequantized once per expert instead of once per row.
+void gather_qmm_rhs(
+    const array& x,
+    const array& w,
+    const array& scales,
+    const array& biases,
+    array& out,
+    bool transpose,
+    int group_size,
+    int bits,
+    int B,
+    int N,
+    int K,
+    QuantizedBatch batch,
+    cu::CommandEncoder& enc);
+
+} // namespace mlx::core
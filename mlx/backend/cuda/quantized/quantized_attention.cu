@@ -0,0 +1,471 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/quantized/quantized.cuh"
+#include "mlx/backend/cuda/quantized/quantized_utils.cuh"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/transforms_impl.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+// The strides of the packed keys and values are in bytes.
+struct QuantizedAttnParams {
+  int qL;
+  int kL;
+  int gqa_factor;
+  float scale;
+  int64_t Q_strides[3];
+  int64_t K_strides[3];
+  int64_t K_scales_strides[3];
+  int64_t K_biases_strides[3];
+  int64_t V_strides[3];
+  int64_t V_scales_strides[3];
+  int64_t V_biases_strides[3];
+  int64_t O_strides[3];
+};
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Dequantize the N consecutive values of a row starting at the element |e|.
+template <typename T, int N, int bits, int group_size>
+__device__ __forceinline__ void dequantize_row(
+    const uint8_t* w,
+    const T* scales,
+    const T* biases,
+    int e,
+    float* out) {
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  static_assert(N % pack_factor == 0 && group_size % N == 0);
+  float scale = static_cast<float>(scales[e / group_size]);
+  float bias = static_cast<float>(biases[e / group_size]);
+  w += e * bits / 8;
+#pragma unroll
+  for (int i = 0; i < N / pack_factor; ++i) {
+    dequantize<bits>(w + i, scale, bias, out + i * pack_factor);
+  }
+}
+
+// The attention of one query of one head in a block like sdpa_vector, with
+// the keys and values dequantized in registers as they are read. Lane l owns
+// the EPT consecutive elements l * EPT, ... of the head dim so it reads whole
+// packs of one group.
+template <
+    typename T,
+    int D,
+    int bits,
+    int group_size,
+    bool do_causal,
+    int NUM_WARPS = 32>
+__global__ void quantized_sdpa_vector(
+    const T* Q,
+    const uint8_t* K,
+    const T* K_scales,
+    const T* K_biases,
+    const uint8_t* V,
+    const T* V_scales,
+    const T* V_biases,
+    T* O,
+    const __grid_constant__ QuantizedAttnParams params) {
+  __shared__ float maxs[NUM_WARPS];
+  __shared__ float sums[NUM_WARPS];
+  __shared__ float outs[NUM_WARPS * D];
+
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  int warp_id = warp.meta_group_rank();
+  int lane = warp.thread_rank();
+
+  int h = blockIdx.x;
+  int q_idx = blockIdx.y;
+  int b = blockIdx.z;
+  int kv_h = h / params.gqa_factor;
+  int kL = params.kL;
+
+  auto head_offset = [&](const int64_t* strides) {
+    return b * strides[0] + kv_h * strides[1];
+  };
+  Q += b * params.Q_strides[0] + h * params.Q_strides[1] +
+      q_idx * params.Q_strides[2];
+  K += head_offset(params.K_strides);
+  K_scales += head_offset(params.K_scales_strides);
+  K_biases += head_offset(params.K_biases_strides);
+  V += head_offset(params.V_strides);
+  V_scales += head_offset(params.V_scales_strides);
+  V_biases += head_offset(params.V_biases_strides);
+
+  constexpr int EPT = D / WARP_SIZE;
+  static_assert(D % WARP_SIZE == 0);
+  constexpr float log2e = 1.44269504089f;
+  int e = lane * EPT;
+  float scale_log2 = params.scale * log2e;
+  float q[EPT];
+  float o[EPT] = {};
+#pragma unroll
+  for (int i = 0; i < EPT; ++i) {
+    q[i] = static_cast<float>(Q[e + i]) * scale_log2;
+  }
+
+  int key_end = kL;
+  if constexpr (do_causal) {
+    key_end = min(kL, kL - params.qL + q_idx + 1);
+  }
+
+  // Online softmax in base 2.
+  float m = Limits<float>::min();
+  float l = 0;
+  for (int j = warp_id; j < key_end; j += NUM_WARPS) {
+    float k[EPT];
+    dequantize_row<T, EPT, bits, group_size>(
+        K + j * params.K_strides[2],
+        K_scales + j * params.K_scales_strides[2],
+        K_biases + j * params.K_biases_strides[2],
+        e,
+        k);
+    float score = 0;
+#pragma unroll
+    for (int i = 0; i < EPT; ++i) {
+      score += q[i] * k[i];
+    }
+    score = cg::reduce(warp, score, cg::plus<float>{});
+    float m_new = max(m, score);
+    float factor = exp2f(m - m_new);
+    float p = exp2f(score - m_new);
+    l = l * factor + p;
+    m = m_new;
+    float v[EPT];
+    dequantize_row<T, EPT, bits, group_size>(
+        V + j * params.V_strides[2],
+        V_scales + j * params.V_scales_strides[2],
+        V_biases + j * params.V_biases_strides[2],
+        e,
+        v);
+#pragma unroll
+    for (int i = 0; i < EPT; ++i) {
+      o[i] = o[i] * factor + p * v[i];
+    }
+  }
+
+  // Merge the warps.
+  if (lane == 0) {
+    maxs[warp_id] = m;
+    sums[warp_id] = l;
+  }
+  block.sync();
+  float max_score = Limits<float>::min();
+#pragma unroll
+  for (int w = 0; w < NUM_WARPS; ++w) {
+    max_score = max(max_score, maxs[w]);
+  }
+  // Warps without any key keep a -inf max and a zero sum.
+  bool empty = max_score == Limits<float>::min();
+  float sum_exp = 0;
+#pragma unroll
+  for (int w = 0; w < NUM_WARPS; ++w) {
+    sum_exp += empty ? 0.0f : sums[w] * exp2f(maxs[w] - max_score);
+  }
+  float factor = empty ? 0.0f : exp2f(m - max_score);
+#pragma unroll
+  for (int i = 0; i < EPT; ++i) {
+    outs[warp_id * D + e + i] = o[i] * factor;
+  }
+  block.sync();
+
+  int d = block.thread_rank();
+  if (d < D) {
+    float acc = 0;
+#pragma unroll
+    for (int w = 0; w < NUM_WARPS; ++w) {
+      acc += outs[w * D + d];
+    }
+    O += b * params.O_strides[0] + h * params.O_strides[1] +
+        q_idx * params.O_strides[2];
+    O[d] = static_cast<T>(sum_exp > 0 ? acc / sum_exp : 0.0f);
+  }
+}
+
+// Quantize a group of the input of shape [B, n_kv_heads, L, D] like
+// affine_quantize and write it at its position in the cache. A thread
+// handles a whole group.
+template <typename T, int group_size, int bits>
+__global__ void quantized_kv_write(
+    const T* x,
+    uint8_t* w,
+    T* scales,
+    T* biases,
+    int n_kv_heads,
+    int seq_len,
+    int head_dim,
+    int offset,
+    const __grid_constant__ cuda::std::array<int64_t, 3> w_strides,
+    const __grid_constant__ cuda::std::array<int64_t, 3> s_strides,
+    int64_t num_groups) {
+  int64_t index = cg::this_grid().thread_rank();
+  if (index >= num_groups) {
+    return;
+  }
+  int groups_per_row = head_dim / group_size;
+  int g = index % groups_per_row;
+  int64_t row = index / groups_per_row;
+  int l = row % seq_len;
+  int h = (row / seq_len) % n_kv_heads;
+  int b = row / seq_len / n_kv_heads;
+  x += row * head_dim + g * group_size;
+
+  constexpr float eps = 1e-7;
+  constexpr float n_bins = (1 << bits) - 1;
+  float w_min = Limits<float>::max();
+  float w_max = 0;
+  for (int i = 0; i < group_size; ++i) {
+    float val = static_cast<float>(x[i]);
+    w_min = min(w_min, val);
+    w_max = max(w_max, val);
+  }
+  float scale = max((w_max - w_min) / n_bins, eps);
+  bool side = abs(w_min) > abs(w_max);
+  scale = side ? scale : -scale;
+  float edge = side ? w_min : w_max;
+  float q0 = round(edge / scale);
+  bool at_zero = q0 == 0.0f;
+  scale = at_zero ? scale : edge / q0;
+  float bias = at_zero ? 0 : edge;
+
+  int pos = offset + l;
+  int64_t s_idx = b * s_strides[0] + h * s_strides[1] + pos * s_strides[2] + g;
+  scales[s_idx] = static_cast<T>(scale);
+  biases[s_idx] = static_cast<T>(bias);
+
+  constexpr int pack_factor = get_pack_factor<bits, 8>();
+  w += b * w_strides[0] + h * w_strides[1] + pos * w_strides[2] +
+      g * group_size * bits / 8;
+  for (int i = 0; i < group_size; i += pack_factor) {
+    uint8_t pack = 0;
+#pragma unroll
+    for (int j = 0; j < pack_factor; ++j) {
+      float val = static_cast<float>(x[i + j]);
+      uint8_t q = min(round((val - bias) / scale), n_bins);
+      pack |= q << (bits * j);
+    }
+    w[i / pack_factor] = pack;
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_quantized_head_dim(int head_dim, F&& f) {
+  switch (head_dim) {
+    case 64:
+      f(std::integral_constant<int, 64>{});
+      break;
+    case 128:
+      f(std::integral_constant<int, 128>{});
+      break;
+  }
+}
+
+// The cache kernels handle the bits whose packs are whole bytes.
+template <typename F>
+void dispatch_cache_bits(int bits, F&& f) {
+  switch (bits) {
+    case 4:
+      f(std::integral_constant<int, 4>{});
+      break;
+    case 8:
+      f(std::integral_constant<int, 8>{});
+      break;
+  }
+}
+
+bool supported_cache_quantization(int group_size, int bits) {
+  return (bits == 4 || bits == 8) &&
+      (group_size == 32 || group_size == 64 || group_size == 128);
+}
+
+} // namespace
+
+namespace fast {
+
+bool QuantizedScaledDotProductAttention::use_fallback(
+    const array& q,
+    const array& k,
+    bool has_arr_mask,
+    bool do_causal,
+    int group_size,
+    int bits,
+    Stream s) {
+  if (detail::in_grad_tracing()) {
+    return true;
+  }
+  if (s.device == Device::cpu) {
+    return true;
+  }
+  // The prompts and the array masks dequantize the cache for the regular
+  // attention.
+  const int head_dim = q.shape(-1);
+  const bool supported_dtype =
+      q.dtype() == float32 || q.dtype() == float16 || q.dtype() == bfloat16;
+  const bool supported_head_dim =
+      (head_dim == 64 || head_dim == 128) && head_dim % group_size == 0;
+  return has_arr_mask || q.shape(2) > 8 || q.shape(2) > k.shape(2) ||
+      !supported_dtype || !supported_head_dim ||
+      !supported_cache_quantization(group_size, bits);
+}
+
+void QuantizedScaledDotProductAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("QuantizedScaledDotProductAttention::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  // The last dim must be contiguous, the other dims can have any strides.
+  auto copy_unless_matrix_contiguous = [&](const array& arr) {
+    if (arr.strides(-1) == 1) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  std::vector<array> in;
+  for (auto& x : inputs) {
+    in.push_back(copy_unless_matrix_contiguous(x));
+  }
+  auto& q = in[0];
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  QuantizedAttnParams params;
+  params.qL = q.shape(2);
+  params.kL = in[1].shape(2);
+  params.gqa_factor = q.shape(1) / in[1].shape(1);
+  params.scale = scale_;
+  for (int i = 0; i < 3; ++i) {
+    params.Q_strides[i] = q.strides(i);
+    params.K_strides[i] = in[1].strides(i) * in[1].itemsize();
+    params.K_scales_strides[i] = in[2].strides(i);
+    params.K_biases_strides[i] = in[3].strides(i);
+    params.V_strides[i] = in[4].strides(i) * in[4].itemsize();
+    params.V_scales_strides[i] = in[5].strides(i);
+    params.V_biases_strides[i] = in[6].strides(i);
+    params.O_strides[i] = out.strides(i);
+  }
+
+  for (auto& x : in) {
+    enc.set_input_array(x);
+  }
+  enc.set_output_array(out);
+
+  constexpr int NUM_WARPS = 32;
+  int B = q.shape(0);
+  int H = q.shape(1);
+  dispatch_float_types(out.dtype(), "quantized_sdpa", [&](auto type_tag) {
+    dispatch_quantized_head_dim(q.shape(3), [&](auto head_dim) {
+      dispatch_groups(group_size_, [&](auto group_size) {
+        dispatch_cache_bits(bits_, [&](auto bits) {
+          dispatch_bool(do_causal_, [&](auto do_causal) {
+            using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+            if constexpr (head_dim.value % group_size.value == 0) {
+              auto kernel = cu::quantized_sdpa_vector<
+                  DataType,
+                  head_dim.value,
+                  bits.value,
+                  group_size.value,
+                  do_causal.value,
+                  NUM_WARPS>;
+              enc.add_kernel_node(
+                  kernel,
+                  dim3(H, params.qL, B),
+                  NUM_WARPS * WARP_SIZE,
+                  q.data<DataType>(),
+                  in[1].data<uint8_t>(),
+                  in[2].data<DataType>(),
+                  in[3].data<DataType>(),
+                  in[4].data<uint8_t>(),
+                  in[5].data<DataType>(),
+                  in[6].data<DataType>(),
+                  out.data<DataType>(),
+                  params);
+            }
+          });
+        });
+      });
+    });
+  });
+}
+
+bool QuantizedKVWrite::use_fallback(int group_size, int bits, Stream s) {
+  return s.device == Device::cpu ||
+      !supported_cache_quantization(group_size, bits);
+}
+
+void QuantizedKVWrite::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("QuantizedKVWrite::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  // The new positions are written in place in the cache when donated.
+  for (int i = 0; i < 3; ++i) {
+    auto& in = inputs[i];
+    if (in.flags().row_contiguous && in.is_donatable()) {
+      outputs[i].copy_shared_buffer(in);
+    } else {
+      copy_gpu(in, outputs[i], CopyType::General, s);
+    }
+  }
+  array x = ensure_row_contiguous(inputs[3], enc, s);
+  auto& w = outputs[0];
+  auto& scales = outputs[1];
+  auto& biases = outputs[2];
+  if (x.size() == 0) {
+    return;
+  }
+
+  int64_t num_groups = x.size() / group_size_;
+  cuda::std::array<int64_t, 3> w_strides = {
+      w.strides(0) * 4, w.strides(1) * 4, w.strides(2) * 4};
+  cuda::std::array<int64_t, 3> s_strides = {
+      scales.strides(0), scales.strides(1), scales.strides(2)};
+
+  enc.set_input_array(x);
+  enc.set_output_array(w);
+  enc.set_output_array(scales);
+  enc.set_output_array(biases);
+  dispatch_float_types(x.dtype(), "quantized_kv_write", [&](auto type_tag) {
+    dispatch_groups(group_size_, [&](auto group_size) {
+      dispatch_cache_bits(bits_, [&](auto bits) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        constexpr int block_dim = 128;
+        enc.add_kernel_node(
+            cu::quantized_kv_write<DataType, group_size.value, bits.value>,
+            cuda::ceil_div(num_groups, block_dim),
+            block_dim,
+            x.data<DataType>(),
+            w.data<uint8_t>(),
+            scales.data<DataType>(),
+            biases.data<DataType>(),
+            static_cast<int>(x.shape(1)),
+            static_cast<int>(x.shape(2)),
+            static_cast<int>(x.shape(3)),
+            offset_,
+            w_strides,
+            s_strides,
+            num_groups);
+      });
+    });
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
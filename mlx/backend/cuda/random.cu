@@ -1,7 +1,13 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/device/random.cuh"
+#include "mlx/backend/cuda/device/unary_ops.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 
 #include <cooperative_groups.h>
@@ -15,35 +21,6 @@ namespace cu {
 
 namespace cg = cooperative_groups;
 
-__constant__ constexpr uint32_t rotations[2][4] = {
-    {13, 15, 26, 6},
-    {17, 29, 16, 24}};
-
-union rbits {
-  uint2 val;
-  uint8_t bytes[2][4];
-};
-
-__device__ rbits threefry2x32_hash(uint2 key, uint2 count) {
-  uint32_t ks[] = {key.x, key.y, key.x ^ key.y ^ 0x1BD11BDA};
-
-  rbits v;
-  v.val.x = count.x + ks[0];
-  v.val.y = count.y + ks[1];
-
-  for (int i = 0; i < 5; ++i) {
-    for (auto r : rotations[i % 2]) {
-      v.val.x += v.val.y;
-      v.val.y = (v.val.y << r) | (v.val.y >> (32 - r));
-      v.val.y ^= v.val.x;
-    }
-    v.val.x += ks[(i + 1) % 3];
-    v.val.y += ks[(i + 2) % 3] + i + 1;
-  }
-
-  return v;
-}
-
 __global__ void rbitsc(
     const uint32_t* keys,
     uint8_t* out,
@@ -130,6 +107,102 @@ __global__ void rbits(
   }
 }
 
+// The products and sums of the fused distributions are rounded like the ones
+// of the separate elementwise kernels, without being contracted to fma.
+template <typename T>
+__device__ T mul_rn(T x, T y) {
+  if constexpr (cuda::std::is_same_v<T, float>) {
+    return __fmul_rn(x, y);
+  } else {
+    return __hmul_rn(x, y);
+  }
+}
+
+template <typename T>
+__device__ T add_rn(T x, T y) {
+  if constexpr (cuda::std::is_same_v<T, float>) {
+    return __fadd_rn(x, y);
+  } else {
+    return __hadd_rn(x, y);
+  }
+}
+
+template <fast::RandomDistribution::Kind KIND, typename T>
+__device__ auto
+random_transform(uint32_t bits, const T* a, const T* b, float upper) {
+  using Kind = fast::RandomDistribution::Kind;
+  if constexpr (KIND == Kind::Bernoulli) {
+    // |a| is p scaled to [0, nexthigher(UINT32_MAX)].
+    return static_cast<float>(bits) < *a;
+  } else if constexpr (KIND == Kind::Normal) {
+    // Uniform over (-1, 1) in float32, |a| is the scale and |b| the loc.
+    float lo = nextafterf(-1.0f, 0.0f);
+    float u = __fadd_rn(__fmul_rn(1.0f - lo, bits_to_unit(bits, upper)), lo);
+    T x = mul_rn(*a, cast_to<T>(ErfInv{}(u)));
+    return b ? add_rn(*b, x) : x;
+  } else {
+    T u = cast_to<T>(bits_to_unit(bits, upper));
+    if constexpr (KIND == Kind::Uniform) {
+      // |a| is low and |b| is high.
+      return add_rn(mul_rn(*b - *a, u), *a);
+    } else {
+      // The uniform over [0, 1) of gumbel leaves u unchanged.
+      return Negative{}(Log{}(Negative{}(Log{}(u))));
+    }
+  }
+}
+
+// Each thread hashes one counter of the key like rbits does, and transforms
+// both 32 bits halves to the samples |index| and |index + grid_y|.
+template <fast::RandomDistribution::Kind KIND, typename T, typename OutT>
+__global__ void random_distribution(
+    const uint32_t* key,
+    int64_t key_stride,
+    const T* a,
+    const T* b,
+    OutT* out,
+    uint32_t grid_y,
+    bool odd,
+    float upper) {
+  uint32_t index = cg::this_grid().thread_rank();
+  if (index >= grid_y) {
+    return;
+  }
+  bool drop_last = odd && (index == grid_y - 1);
+  auto bits = threefry2x32_hash(
+      uint2{key[0], key[key_stride]},
+      uint2{index, drop_last ? 0 : index + grid_y});
+  out[index] = random_transform<KIND>(bits.val.x, a, b, upper);
+  if (!drop_last) {
+    out[index + grid_y] = random_transform<KIND>(bits.val.y, a, b, upper);
+  }
+}
+
+// Round the elements |index| and |index + grid_y| with the bits random::bits
+// gives them for the key.
+template <typename T>
+__global__ void stochastic_round(
+    const uint32_t* key,
+    int64_t key_stride,
+    const T* x,
+    __nv_bfloat16* out,
+    uint32_t grid_y,
+    bool odd) {
+  uint32_t index = cg::this_grid().thread_rank();
+  if (index >= grid_y) {
+    return;
+  }
+  bool drop_last = odd && (index == grid_y - 1);
+  auto bits = threefry2x32_hash(
+      uint2{key[0], key[key_stride]},
+      uint2{index, drop_last ? 0 : index + grid_y});
+  out[index] = stochastic_round_bf16(static_cast<float>(x[index]), bits.val.x);
+  if (!drop_last) {
+    out[index + grid_y] = stochastic_round_bf16(
+        static_cast<float>(x[index + grid_y]), bits.val.y);
+  }
+}
+
 } // namespace cu
 
 void RandomBits::eval_gpu(const std::vector<array>& inputs, array& out) {
@@ -191,4 +264,132 @@ void RandomBits::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+namespace fast {
+
+bool RandomDistribution::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void RandomDistribution::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("RandomDistribution::eval_gpu");
+  auto& key = inputs[0];
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  uint32_t half_size = out.size() / 2;
+  bool odd = out.size() % 2;
+  uint32_t grid_y = half_size + odd;
+
+  auto& encoder = cu::get_command_encoder(stream());
+  for (auto& in : inputs) {
+    encoder.set_input_array(in);
+  }
+  encoder.set_output_array(out);
+
+  auto launch = [&](auto kind_tag, auto type_tag, auto out_type_tag) {
+    constexpr Kind KIND = decltype(kind_tag)::value;
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using OutType = cuda_type_t<MLX_GET_TYPE(out_type_tag)>;
+    auto kernel = cu::random_distribution<KIND, DataType, OutType>;
+    auto [num_blocks, block_dims] =
+        get_launch_args(kernel, grid_y, out.shape(), out.strides(), false);
+    encoder.add_kernel_node(
+        kernel,
+        num_blocks,
+        block_dims,
+        key.data<uint32_t>(),
+        key.strides()[0],
+        inputs.size() > 1 ? inputs[1].data<DataType>() : nullptr,
+        inputs.size() > 2 ? inputs[2].data<DataType>() : nullptr,
+        out.data<OutType>(),
+        grid_y,
+        odd,
+        upper_);
+  };
+
+  if (kind_ == Bernoulli) {
+    launch(
+        std::integral_constant<Kind, Bernoulli>{},
+        type_identity<float>{},
+        type_identity<bool>{});
+    return;
+  }
+  dispatch_float_types(out.dtype(), "RandomDistribution", [&](auto type_tag) {
+    using CTYPE = MLX_GET_TYPE(type_tag);
+    if constexpr (!std::is_same_v<CTYPE, double>) {
+      switch (kind_) {
+        case Uniform:
+          launch(std::integral_constant<Kind, Uniform>{}, type_tag, type_tag);
+          break;
+        case Normal:
+          launch(std::integral_constant<Kind, Normal>{}, type_tag, type_tag);
+          break;
+        default:
+          launch(std::integral_constant<Kind, Gumbel>{}, type_tag, type_tag);
+          break;
+      }
+    } else {
+      throw std::runtime_error(
+          "[RandomDistribution::eval_gpu] float64 is not supported.");
+    }
+  });
+}
+
+bool StochasticRound::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void StochasticRound::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("StochasticRound::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+  auto x = inputs[0];
+  if (!x.flags().row_contiguous) {
+    x = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x);
+  }
+  auto& key = inputs[1];
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  uint32_t grid_y = out.size() / 2 + out.size() % 2;
+  encoder.set_input_array(x);
+  encoder.set_input_array(key);
+  encoder.set_output_array(out);
+  dispatch_float_types(x.dtype(), "StochasticRound", [&](auto type_tag) {
+    using CTYPE = MLX_GET_TYPE(type_tag);
+    if constexpr (!std::is_same_v<CTYPE, double>) {
+      using DataType = cuda_type_t<CTYPE>;
+      auto kernel = cu::stochastic_round<DataType>;
+      auto [num_blocks, block_dims] =
+          get_launch_args(kernel, grid_y, out.shape(), out.strides(), false);
+      encoder.add_kernel_node(
+          kernel,
+          num_blocks,
+          block_dims,
+          key.data<uint32_t>(),
+          key.strides()[0],
+          x.data<DataType>(),
+          out.data<__nv_bfloat16>(),
+          grid_y,
+          out.size() % 2);
+    } else {
+      throw std::runtime_error(
+          "[StochasticRound::eval_gpu] float64 is not supported.");
+    }
+  });
+}
+
+} // namespace fast
+
 } // namespace mlx::core
@@ -4,6 +4,7 @@
 #include "mlx/backend/cuda/reduce/reduce.cuh"
 #include "mlx/backend/gpu/copy.h"
 
+#include <cooperative_groups.h>
 #include <nvtx3/nvtx3.hpp>
 #include <thrust/device_ptr.h>
 #include <thrust/fill.h>
@@ -12,6 +13,82 @@
 
 namespace mlx::core {
 
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Multiply the sums by the number of times the broadcasted reduction axes
+// repeat each input.
+template <typename T>
+__global__ void scale_sum(T* out, size_t size, uint64_t repeats) {
+  size_t index = cg::this_grid().thread_rank();
+  if (index < size) {
+    if constexpr (cuda::std::is_integral_v<T>) {
+      out[index] = out[index] * static_cast<T>(repeats);
+    } else if constexpr (is_complex_v<T>) {
+      out[index] = out[index] * T{static_cast<float>(repeats), 0};
+    } else if constexpr (cuda::std::is_same_v<T, double>) {
+      out[index] = out[index] * static_cast<double>(repeats);
+    } else {
+      out[index] =
+          cast_to<T>(cast_to<float>(out[index]) * static_cast<float>(repeats));
+    }
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+// Remove the broadcasted reduction axes of |in|, they only repeat the same
+// values. Returns the view of |in| with these axes of size 1 and the number
+// of times each value was repeated.
+std::pair<array, uint64_t> remove_broadcasted_axes(
+    const array& in,
+    const std::vector<int>& axes) {
+  auto shape = in.shape();
+  uint64_t repeats = 1;
+  for (auto ax : axes) {
+    if (in.strides(ax) == 0 && shape[ax] > 1) {
+      repeats *= shape[ax];
+      shape[ax] = 1;
+    }
+  }
+  if (repeats == 1) {
+    return {in, 1};
+  }
+  auto [data_size, row_contiguous, col_contiguous] =
+      check_contiguity(shape, in.strides());
+  array view(shape, in.dtype(), nullptr, {});
+  auto flags = in.flags();
+  flags.row_contiguous = row_contiguous;
+  flags.col_contiguous = col_contiguous;
+  flags.contiguous =
+      (row_contiguous || col_contiguous) && data_size == view.size();
+  view.copy_shared_buffer(in, in.strides(), flags, data_size);
+  return {view, repeats};
+}
+
+// Whether the vectorized loads of the row and col reductions stay aligned for
+// a non contiguous input, namely its start and strides are multiples of the
+// widest load.
+bool has_aligned_loads(const array& in) {
+  constexpr int n_reads = 8;
+  if (reinterpret_cast<uintptr_t>(in.data<char>()) %
+          (n_reads * in.itemsize()) !=
+      0) {
+    return false;
+  }
+  for (int i = 0; i < in.ndim(); i++) {
+    if (in.shape(i) > 1 && in.strides(i) != 1 && in.strides(i) % n_reads) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
 void Reduce::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("Reduce::eval_gpu");
   assert(inputs.size() == 1);
@@ -29,43 +106,83 @@ void Reduce::eval_gpu(const std::vector<array>& inputs, array& out) {
     return;
   }
 
+  // Broadcasted reduction axes are ignored by all the reductions but prod,
+  // which would need a power, and scale the sums.
+  uint64_t repeats = 1;
+  if (reduce_type_ != Reduce::Prod) {
+    std::tie(in, repeats) = remove_broadcasted_axes(in, axes_);
+  }
+  auto finalize = [&]() {
+    if (repeats > 1 && reduce_type_ == Reduce::Sum) {
+      encoder.set_input_array(out);
+      encoder.set_output_array(out);
+      dispatch_all_types(out.dtype(), [&](auto type_tag) {
+        using T = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        constexpr int block_dim = 256;
+        encoder.add_kernel_node(
+            cu::scale_sum<T>,
+            cuda::ceil_div(out.data_size(), block_dim),
+            block_dim,
+            out.data<T>(),
+            out.data_size(),
+            repeats);
+      });
+    }
+  };
+
+  // Only broadcasted axes were reduced.
+  if (in.size() == out.size()) {
+    copy_gpu(in, out, CopyType::General, s);
+    finalize();
+    return;
+  }
+
   // Reduce.
   ReductionPlan plan = get_reduction_plan(in, axes_);
 
-  // If it is a general reduce then copy the input to a contiguous array and
-  // recompute the plan.
-  //
-  // TODO: Instead of copying we can use elem-to-loc to deal with broadcasting
-  //       like we do in Metal. When it comes to broadcasted reduction axes
-  //       some can be ignored eg for min/max.
+  // The general reduce reads the input with elem-to-loc, the row and col
+  // reductions handle any stride of the input as long as their vectorized
+  // loads are aligned. The col reduction also expects the kept axes of the
+  // input to be free of broadcasts.
   bool broadcasted = false;
   for (int i = 0, j = 0; i < in.ndim() && !broadcasted; i++) {
     if (j < axes_.size() && axes_[j] == i) {
       j++;
     } else {
-      broadcasted = in.strides(i) == 0;
+      broadcasted = in.strides(i) == 0 && in.shape(i) > 1;
     }
   }
-  if (plan.type == GeneralReduce || broadcasted || !in.flags().contiguous) {
+  bool strided = plan.type == ContiguousStridedReduce ||
+      plan.type == GeneralStridedReduce;
+  if (plan.type != GeneralReduce && !in.flags().contiguous &&
+      (!has_aligned_loads(in) || (strided && broadcasted))) {
     array in_copy = contiguous_copy_gpu(in, s);
     encoder.add_temporary(in_copy);
     in = in_copy;
     plan = get_reduction_plan(in, axes_);
   }
 
+  if (plan.type == GeneralReduce) {
+    general_reduce(encoder, in, out, reduce_type_, axes_, plan);
+    finalize();
+    return;
+  }
+
   if (plan.type == ContiguousAllReduce) {
     all_reduce(encoder, in, out, reduce_type_);
+    finalize();
     return;
   }
 
   if (plan.type == ContiguousReduce || plan.type == GeneralContiguousReduce) {
     row_reduce(encoder, in, out, reduce_type_, axes_, plan);
+    finalize();
     return;
   }
 
-  if (plan.type == ContiguousStridedReduce ||
-      plan.type == GeneralStridedReduce) {
+  if (strided) {
     col_reduce(encoder, in, out, reduce_type_, axes_, plan);
+    finalize();
     return;
   }
 
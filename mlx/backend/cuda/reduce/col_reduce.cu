@@ -56,7 +56,7 @@ struct ColReduceArgs {
     }
     std::vector<int> indices(shape_vec.size());
     std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), [&](int left, int right) {
+    std::stable_sort(indices.begin(), indices.end(), [&](int left, int right) {
       return strides_vec[left] > strides_vec[right];
     });
     ShapeVector sorted_shape;
@@ -0,0 +1,92 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/reduce/reduce.cuh"
+
+#include <cooperative_groups.h>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// Each thread computes one output, the input is read with elem_to_loc over
+// the kept axes and looped over the reduction axes in the order of the plan,
+// so the input can have any strides.
+template <typename T, typename U, typename Op, int NDIM>
+__global__ void general_reduce(
+    const T* in,
+    U* out,
+    size_t out_size,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides strides,
+    int ndim,
+    const __grid_constant__ Shape reduce_shape,
+    const __grid_constant__ Strides reduce_strides,
+    int reduce_ndim,
+    size_t reduction_size) {
+  size_t index = cg::this_grid().thread_rank();
+  if (index >= out_size) {
+    return;
+  }
+
+  in += elem_to_loc(index, shape.data(), strides.data(), ndim);
+
+  Op op;
+  U total = ReduceInit<Op, T>::value();
+  LoopedElemToLoc<NDIM, (NDIM > 2)> loop(reduce_ndim);
+  for (size_t r = 0; r < reduction_size; r++) {
+    total = op(total, cast_to<U>(in[loop.location()]));
+    loop.next(reduce_shape.data(), reduce_strides.data());
+  }
+  out[index] = total;
+}
+
+} // namespace cu
+
+void general_reduce(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    Reduce::ReduceType reduce_type,
+    const std::vector<int>& axes,
+    const ReductionPlan& plan) {
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  auto [shape, strides] = shapes_without_reduction_axes(in, axes);
+  std::tie(shape, strides) = collapse_contiguous_dims(shape, strides);
+  size_t reduction_size = 1;
+  for (auto n : plan.shape) {
+    reduction_size *= n;
+  }
+
+  constexpr int block_dim = 256;
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  dispatch_all_types(in.dtype(), [&](auto type_tag) {
+    dispatch_reduce_ops(reduce_type, [&](auto reduce_type_tag) {
+      dispatch_reduce_ndim(plan.shape.size(), [&](auto reduce_ndim) {
+        using OP = MLX_GET_TYPE(reduce_type_tag);
+        using T = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        using U = typename cu::ReduceResult<OP, T>::type;
+        encoder.add_kernel_node(
+            cu::general_reduce<T, U, OP, reduce_ndim()>,
+            cuda::ceil_div(out.size(), block_dim),
+            block_dim,
+            in.data<T>(),
+            out.data<U>(),
+            out.size(),
+            const_param(shape),
+            const_param(strides),
+            int(shape.size()),
+            const_param(plan.shape),
+            const_param(plan.strides),
+            int(plan.shape.size()),
+            reduction_size);
+      });
+    });
+  });
+}
+
+} // namespace mlx::core
@@ -0,0 +1,301 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <cooperative_groups.h>
+#include <cub/block/block_reduce.cuh>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// The rows of a column block of moments_col.
+constexpr int moments_col_rows = 8;
+
+// The running count, mean and sum of squared deviations of Welford's
+// algorithm.
+template <typename AccT>
+struct Welford {
+  int64_t n;
+  AccT mean;
+  AccT m2;
+
+  __device__ void push(AccT x) {
+    n++;
+    AccT delta = x - mean;
+    mean += delta / static_cast<AccT>(n);
+    m2 += delta * (x - mean);
+  }
+};
+
+struct WelfordMerge {
+  template <typename AccT>
+  __device__ Welford<AccT> operator()(
+      const Welford<AccT>& a,
+      const Welford<AccT>& b) const {
+    int64_t n = a.n + b.n;
+    if (n == 0) {
+      return a;
+    }
+    AccT delta = b.mean - a.mean;
+    AccT wb = static_cast<AccT>(b.n) / static_cast<AccT>(n);
+    return Welford<AccT>{
+        n,
+        a.mean + delta * wb,
+        a.m2 + b.m2 + delta * delta * static_cast<AccT>(a.n) * wb};
+  }
+};
+
+// Write the moments of the output |o|, or the partial state of the split.
+template <typename T, typename AccT>
+__device__ void write_moments(
+    const Welford<AccT>& w,
+    Welford<AccT>* partials,
+    T* mean,
+    T* var,
+    int64_t o,
+    int64_t partial_idx,
+    int ddof) {
+  if (partials) {
+    partials[partial_idx] = w;
+  } else {
+    AccT n = max(w.n - ddof, int64_t(0));
+    mean[o] = cast_to<T>(w.mean);
+    var[o] = cast_to<T>(w.m2 / n);
+  }
+}
+
+// The moments of the rows of [B, R] with C = 1, the block (b, s) reduces
+// the split s of the row b.
+template <typename T, typename AccT, int BLOCK_DIM, int N_READS = 4>
+__global__ void moments_row(
+    const T* in,
+    Welford<AccT>* partials,
+    T* mean,
+    T* var,
+    int64_t row_size,
+    int64_t chunk,
+    int ddof) {
+  auto block = cg::this_thread_block();
+  int64_t b = blockIdx.x;
+  int64_t start = blockIdx.y * chunk;
+  int64_t end = min(start + chunk, row_size);
+  in += b * row_size;
+
+  Welford<AccT> w{0, 0, 0};
+  for (int64_t i = start + block.thread_rank() * N_READS; i < end;
+       i += BLOCK_DIM * N_READS) {
+#pragma unroll
+    for (int j = 0; j < N_READS; j++) {
+      if (i + j < end) {
+        w.push(cast_to<AccT>(in[i + j]));
+      }
+    }
+  }
+
+  typedef cub::BlockReduce<Welford<AccT>, BLOCK_DIM> BlockReduceT;
+  __shared__ typename BlockReduceT::TempStorage temp;
+  w = BlockReduceT(temp).Reduce(w, WelfordMerge{});
+
+  if (block.thread_rank() == 0) {
+    write_moments(
+        w, partials, mean, var, b, blockIdx.y * gridDim.x + b, ddof);
+  }
+}
+
+// The moments of the columns of [B, R, C], a block reduces the split
+// blockIdx.y of WARP_SIZE columns with moments_col_rows threads each.
+template <typename T, typename AccT>
+__global__ void moments_col(
+    const T* in,
+    Welford<AccT>* partials,
+    T* mean,
+    T* var,
+    int64_t R,
+    int64_t C,
+    int64_t col_blocks,
+    int64_t chunk,
+    int ddof) {
+  auto block = cg::this_thread_block();
+  int64_t b = blockIdx.x / col_blocks;
+  int64_t c = (blockIdx.x % col_blocks) * WARP_SIZE + threadIdx.x;
+  int64_t start = blockIdx.y * chunk;
+  int64_t end = min(start + chunk, R);
+
+  Welford<AccT> w{0, 0, 0};
+  if (c < C) {
+    in += b * R * C + c;
+    for (int64_t r = start + threadIdx.y; r < end; r += moments_col_rows) {
+      w.push(cast_to<AccT>(in[r * C]));
+    }
+  }
+
+  __shared__ Welford<AccT> states[moments_col_rows][WARP_SIZE];
+  states[threadIdx.y][threadIdx.x] = w;
+  block.sync();
+  if (threadIdx.y == 0 && c < C) {
+    WelfordMerge merge;
+    for (int i = 1; i < moments_col_rows; i++) {
+      w = merge(w, states[i][threadIdx.x]);
+    }
+    int64_t num_outputs = (gridDim.x / col_blocks) * C;
+    int64_t o = b * C + c;
+    write_moments(
+        w, partials, mean, var, o, blockIdx.y * num_outputs + o, ddof);
+  }
+}
+
+// Merge the partial states of the splits of each output.
+template <typename T, typename AccT>
+__global__ void moments_finalize(
+    const Welford<AccT>* partials,
+    T* mean,
+    T* var,
+    int64_t num_outputs,
+    int splits,
+    int ddof) {
+  int64_t o = cg::this_grid().thread_rank();
+  if (o >= num_outputs) {
+    return;
+  }
+  WelfordMerge merge;
+  Welford<AccT> w = partials[o];
+  for (int i = 1; i < splits; i++) {
+    w = merge(w, partials[i * num_outputs + o]);
+  }
+  write_moments<T, AccT>(w, nullptr, mean, var, o, 0, ddof);
+}
+
+} // namespace cu
+
+namespace fast {
+
+bool Moments::use_fallback(Stream s) {
+  return false;
+}
+
+void Moments::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("Moments::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  array in = inputs[0];
+  if (!in.flags().row_contiguous) {
+    in = contiguous_copy_gpu(in, s);
+    encoder.add_temporary(in);
+  }
+  auto& mean = outputs[0];
+  auto& var = outputs[1];
+  mean.set_data(allocator::malloc(mean.nbytes()));
+  var.set_data(allocator::malloc(var.nbytes()));
+
+  int64_t B = in.shape(0);
+  int64_t R = in.shape(1);
+  int64_t C = in.shape(2);
+  int64_t num_outputs = B * C;
+  if (num_outputs == 0) {
+    return;
+  }
+
+  // Split the reduction across blocks until they fill the GPU, without
+  // leaving less than a few thousand elements to each of them.
+  int64_t col_blocks = cuda::ceil_div(C, WARP_SIZE);
+  int64_t blocks = C == 1 ? B : B * col_blocks;
+  int64_t min_chunk = C == 1 ? 4096 : 256;
+  int64_t target_blocks = 4 * encoder.device().multi_processor_count();
+  int64_t max_splits =
+      std::clamp<int64_t>(cuda::ceil_div(R, min_chunk), 1, 65535);
+  int64_t splits = std::clamp<int64_t>(
+      cuda::ceil_div(target_blocks, blocks), 1, max_splits);
+  int64_t chunk = std::max<int64_t>(cuda::ceil_div(R, splits), 1);
+  splits = std::max<int64_t>(cuda::ceil_div(R, chunk), 1);
+
+  encoder.set_input_array(in);
+  dispatch_float_types(in.dtype(), "moments", [&](auto type_tag) {
+    using T = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    using AccT = std::conditional_t<std::is_same_v<T, double>, double, float>;
+    using State = cu::Welford<AccT>;
+
+    // The partial states of the splits, merged by moments_finalize.
+    int64_t partials_bytes =
+        splits > 1 ? splits * num_outputs * sizeof(State) : 0;
+    array partials_arr(
+        {static_cast<int>(partials_bytes)},
+        uint8,
+        nullptr,
+        {});
+    State* partials = nullptr;
+    if (splits > 1) {
+      partials_arr.set_data(allocator::malloc(partials_arr.nbytes()));
+      encoder.add_temporary(partials_arr);
+      encoder.set_output_array(partials_arr);
+      partials = reinterpret_cast<State*>(partials_arr.data<uint8_t>());
+    } else {
+      encoder.set_output_array(mean);
+      encoder.set_output_array(var);
+    }
+
+    int ddof = ddof_;
+    if (C == 1) {
+      constexpr int N_READS = 4;
+      dispatch_block_dim(cuda::ceil_div(chunk, N_READS), [&](auto block_dim) {
+        encoder.add_kernel_node(
+            cu::moments_row<T, AccT, block_dim(), N_READS>,
+            dim3(B, splits),
+            block_dim(),
+            in.data<T>(),
+            partials,
+            mean.data<T>(),
+            var.data<T>(),
+            R,
+            chunk,
+            ddof);
+      });
+    } else {
+      encoder.add_kernel_node(
+          cu::moments_col<T, AccT>,
+          dim3(B * col_blocks, splits),
+          dim3(WARP_SIZE, cu::moments_col_rows),
+          in.data<T>(),
+          partials,
+          mean.data<T>(),
+          var.data<T>(),
+          R,
+          C,
+          col_blocks,
+          chunk,
+          ddof);
+    }
+
+    if (splits > 1) {
+      encoder.set_input_array(partials_arr);
+      encoder.set_output_array(mean);
+      encoder.set_output_array(var);
+      constexpr int block_dim = 256;
+      encoder.add_kernel_node(
+          cu::moments_finalize<T, AccT>,
+          cuda::ceil_div(num_outputs, block_dim),
+          block_dim,
+          partials,
+          mean.data<T>(),
+          var.data<T>(),
+          num_outputs,
+          static_cast<int>(splits),
+          ddof);
+    }
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
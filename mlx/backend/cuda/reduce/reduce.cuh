@@ -3,8 +3,9 @@
 #include <type_traits>
 
 #include "mlx/backend/common/reduce.h"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
-#include "mlx/backend/cuda/reduce/reduce_ops.cuh"
+#include "mlx/backend/cuda/reduce/reduce_utils.cuh"
 #include "mlx/dtype_utils.h"
 #include "mlx/primitives.h"
 
@@ -62,6 +63,14 @@ void col_reduce(
     const std::vector<int>& axes,
     const ReductionPlan& plan);
 
+void general_reduce(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    Reduce::ReduceType reduce_type,
+    const std::vector<int>& axes,
+    const ReductionPlan& plan);
+
 void init_reduce(
     cu::CommandEncoder& encoder,
     const array& in,
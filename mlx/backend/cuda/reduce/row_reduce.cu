@@ -65,7 +65,7 @@ struct RowReduceArgs {
         shapes_without_reduction_axes(shape_vec, strides_vec, axes);
     std::vector<int> indices(shape_vec.size());
     std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), [&](int left, int right) {
+    std::stable_sort(indices.begin(), indices.end(), [&](int left, int right) {
       return strides_vec[left] > strides_vec[right];
     });
     decltype(shape_vec) sorted_shape;
@@ -352,8 +352,8 @@ void row_reduce(
   //        transpositions as they are (contrary to our Metal backend).
 
   // Simple row reduce means that we have 1 axis that we are reducing over and
-  // it has stride 1.
-  if (plan.shape.size() == 1) {
+  // it has stride 1, and that the rows are packed one after the other.
+  if (plan.shape.size() == 1 && in.flags().contiguous) {
     row_reduce_simple(encoder, in, out, reduce_type, axes, plan);
     return;
   }
@@ -3,7 +3,7 @@
 #include "mlx/backend/cuda/device.h"
 #include "mlx/backend/cuda/iterators/strided_iterator.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
-#include "mlx/backend/cuda/reduce/reduce.cuh"
+#include "mlx/backend/cuda/norm_vjp.cuh"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/fast_primitives.h"
@@ -52,10 +52,15 @@ struct BlockBroadcastReduce {
   }
 };
 
-template <typename T, int BLOCK_DIM, int N_READS = 4>
+// When HAS_RESIDUAL is true the normalized input is h = x + residual, which
+// is also written to |h|. Every thread reads back only the elements of h it
+// wrote itself so the later passes need no synchronization.
+template <typename T, bool HAS_RESIDUAL, int BLOCK_DIM, int N_READS = 4>
 __global__ void rms_norm(
     const T* x,
+    const T* residual,
     const T* w,
+    T* h,
     T* out,
     float eps,
     int32_t axis_size,
@@ -68,6 +73,10 @@ __global__ void rms_norm(
 
   x += grid.block_rank() * axis_size;
   out += grid.block_rank() * axis_size;
+  if constexpr (HAS_RESIDUAL) {
+    residual += grid.block_rank() * axis_size;
+    h += grid.block_rank() * axis_size;
+  }
 
   // Normalizer.
   float normalizer = 0;
@@ -75,11 +84,23 @@ __global__ void rms_norm(
     auto index = r * BLOCK_DIM + block.thread_rank();
     T xn[N_READS];
     cub::LoadDirectBlocked(index, x, xn, axis_size, cast_to<T>(0));
+    if constexpr (HAS_RESIDUAL) {
+      T rn[N_READS];
+      cub::LoadDirectBlocked(index, residual, rn, axis_size, cast_to<T>(0));
+      for (int i = 0; i < N_READS; ++i) {
+        xn[i] = static_cast<T>(
+            static_cast<float>(xn[i]) + static_cast<float>(rn[i]));
+      }
+      cub::StoreDirectBlocked(index, h, xn, axis_size);
+    }
     for (int i = 0; i < N_READS; ++i) {
       float t = static_cast<float>(xn[i]);
       normalizer += t * t;
     }
   }
+  if constexpr (HAS_RESIDUAL) {
+    x = h;
+  }
   normalizer = BlockReduceT{block, temp}.Sum(normalizer);
   normalizer = rsqrt(normalizer / axis_size + eps);
 
@@ -98,15 +119,24 @@ __global__ void rms_norm(
   }
 }
 
-template <typename T, bool HAS_W, int BLOCK_DIM, int N_READS = 4>
-__global__ void rms_norm_vjp(
+// Each block computes the gradients of the rows |block_rank|, |block_rank| +
+// |num_blocks|, ... and sums the gradients of w of its rows into its row of
+// |gw| in float32, see layer_norm_vjp.
+template <
+    typename T,
+    bool HAS_W,
+    int BLOCK_DIM,
+    int N_READS = 4,
+    int N_CHUNKS = (BLOCK_DIM < WARP_SIZE * WARP_SIZE) ? 1 : 2>
+__global__ void __launch_bounds__(BLOCK_DIM) rms_norm_vjp(
     const T* x,
     const T* w,
     const T* g,
     T* gx,
-    T* gw,
+    float* gw,
     float eps,
     int32_t axis_size,
+    int32_t n_rows,
     int64_t w_stride) {
   auto grid = cg::this_grid();
   auto block = cg::this_thread_block();
@@ -118,55 +148,92 @@ __global__ void rms_norm_vjp(
     typename BlockReduceF2::TempStorage f2;
   } temp;
 
-  x += grid.block_rank() * axis_size;
-  g += grid.block_rank() * axis_size;
-  gx += grid.block_rank() * axis_size;
-  gw += grid.block_rank() * axis_size;
-
-  // Normalizer.
-  float2 factors = {};
-  for (int r = 0; r < cuda::ceil_div(axis_size, BLOCK_DIM * N_READS); ++r) {
-    T xn[N_READS];
-    T wn[N_READS] = {};
-    T gn[N_READS] = {};
-    auto index = r * BLOCK_DIM + block.thread_rank();
-    cub::LoadDirectBlocked(index, x, xn, axis_size, cast_to<T>(0));
-    cub::LoadDirectBlocked(index, g, gn, axis_size);
-    cub::LoadDirectBlocked(index, strided_iterator(w, w_stride), wn, axis_size);
-    for (int i = 0; i < N_READS; i++) {
-      float t = static_cast<float>(xn[i]);
-      float wi = wn[i];
-      float gi = gn[i];
-      float wg = wi * gi;
-      factors = plus_f2(factors, {wg * t, t * t});
-    }
+  if constexpr (HAS_W) {
+    gw += grid.block_rank() * axis_size;
   }
-  factors = BlockReduceF2{block, temp.f2}.Reduce(factors, plus_f2, {});
-  float meangwx = factors.x / axis_size;
-  float normalizer = rsqrt(factors.y / axis_size + eps);
-  float normalizer3 = normalizer * normalizer * normalizer;
-
-  // Outputs.
-  for (int r = 0; r < cuda::ceil_div(axis_size, BLOCK_DIM * N_READS); ++r) {
-    auto index = r * BLOCK_DIM + block.thread_rank();
-    T xn[N_READS];
-    T wn[N_READS];
-    T gn[N_READS];
-    cub::LoadDirectBlocked(index, x, xn, axis_size);
-    cub::LoadDirectBlocked(index, g, gn, axis_size);
-    cub::LoadDirectBlocked(index, strided_iterator(w, w_stride), wn, axis_size);
-    for (int i = 0; i < N_READS; i++) {
-      float xi = xn[i];
-      float wi = wn[i];
-      float gi = gn[i];
-      xn[i] = static_cast<T>(normalizer * wi * gi - xi * meangwx * normalizer3);
+  int n_chunks = cuda::ceil_div(axis_size, BLOCK_DIM * N_READS);
+  float gw_sums[N_CHUNKS][N_READS] = {};
+
+  for (int64_t row = grid.block_rank(); row < n_rows;
+       row += grid.num_blocks()) {
+    const T* x_row = x + row * axis_size;
+    const T* g_row = g + row * axis_size;
+    T* gx_row = gx + row * axis_size;
+
+    // Normalizer.
+    float2 factors = {};
+    for (int r = 0; r < n_chunks; ++r) {
+      T xn[N_READS];
+      T wn[N_READS] = {};
+      T gn[N_READS] = {};
+      auto index = r * BLOCK_DIM + block.thread_rank();
+      cub::LoadDirectBlocked(index, x_row, xn, axis_size, cast_to<T>(0));
+      cub::LoadDirectBlocked(index, g_row, gn, axis_size);
+      cub::LoadDirectBlocked(
+          index, strided_iterator(w, w_stride), wn, axis_size);
+      for (int i = 0; i < N_READS; i++) {
+        float t = static_cast<float>(xn[i]);
+        float wi = wn[i];
+        float gi = gn[i];
+        float wg = wi * gi;
+        factors = plus_f2(factors, {wg * t, t * t});
+      }
+    }
+    factors = BlockReduceF2{block, temp.f2}.Reduce(factors, plus_f2, {});
+    float meangwx = factors.x / axis_size;
+    float normalizer = rsqrt(factors.y / axis_size + eps);
+    float normalizer3 = normalizer * normalizer * normalizer;
+
+    // Outputs.
+    auto outputs = [&](int r, float* gw_sum) {
+      auto index = r * BLOCK_DIM + block.thread_rank();
+      T xn[N_READS];
+      T wn[N_READS];
+      T gn[N_READS];
+      cub::LoadDirectBlocked(index, x_row, xn, axis_size);
+      cub::LoadDirectBlocked(index, g_row, gn, axis_size);
+      cub::LoadDirectBlocked(
+          index, strided_iterator(w, w_stride), wn, axis_size);
+      for (int i = 0; i < N_READS; i++) {
+        float xi = xn[i];
+        float wi = wn[i];
+        float gi = gn[i];
+        xn[i] =
+            static_cast<T>(normalizer * wi * gi - xi * meangwx * normalizer3);
+        if constexpr (HAS_W) {
+          gw_sum[i] += gi * xi * normalizer;
+        }
+      }
+      cub::StoreDirectBlocked(index, gx_row, xn, axis_size);
+    };
+#pragma unroll
+    for (int r = 0; r < N_CHUNKS; ++r) {
+      if (r < n_chunks) {
+        outputs(r, gw_sums[r]);
+      }
+    }
+    for (int r = N_CHUNKS; r < n_chunks; ++r) {
+      auto index = r * BLOCK_DIM + block.thread_rank();
+      float gw_sum[N_READS] = {};
       if constexpr (HAS_W) {
-        wn[i] = static_cast<T>(gi * xi * normalizer);
+        if (row != grid.block_rank()) {
+          cub::LoadDirectBlocked(index, gw, gw_sum, axis_size);
+        }
+      }
+      outputs(r, gw_sum);
+      if constexpr (HAS_W) {
+        cub::StoreDirectBlocked(index, gw, gw_sum, axis_size);
       }
     }
-    cub::StoreDirectBlocked(index, gx, xn, axis_size);
-    if constexpr (HAS_W) {
-      cub::StoreDirectBlocked(index, gw, wn, axis_size);
+  }
+
+  if constexpr (HAS_W) {
+#pragma unroll
+    for (int r = 0; r < N_CHUNKS; ++r) {
+      auto index = r * BLOCK_DIM + block.thread_rank();
+      if (r < n_chunks) {
+        cub::StoreDirectBlocked(index, gw, gw_sums[r], axis_size);
+      }
     }
   }
 }
@@ -227,13 +294,78 @@ void RMSNorm::eval_gpu(
     constexpr uint32_t N_READS = 4;
     dispatch_block_dim(cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
       using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
-      auto kernel = cu::rms_norm<DataType, block_dim(), N_READS>;
+      auto kernel = cu::rms_norm<DataType, false, block_dim(), N_READS>;
       encoder.add_kernel_node(
           kernel,
           n_rows,
           block_dim(),
           x.data<DataType>(),
+          static_cast<const DataType*>(nullptr),
           w.data<DataType>(),
+          static_cast<DataType*>(nullptr),
+          out.data<DataType>(),
+          eps_,
+          axis_size,
+          w_stride);
+    });
+  });
+}
+
+bool AddRMSNorm::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void AddRMSNorm::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("AddRMSNorm::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+  auto& h = outputs[0];
+  auto& out = outputs[1];
+
+  // The kernel reads and writes full rows so make both inputs row contiguous.
+  auto check_input = [&s, &encoder](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  const array x = check_input(inputs[0]);
+  const array residual = check_input(inputs[1]);
+  const array& w = inputs[2];
+
+  if (inputs[0].is_donatable() && inputs[0].flags().row_contiguous) {
+    h.copy_shared_buffer(x);
+  } else {
+    h.set_data(allocator::malloc(h.nbytes()));
+  }
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  int32_t axis_size = x.shape().back();
+  int32_t n_rows = x.size() / axis_size;
+  int64_t w_stride = (w.ndim() == 1) ? w.strides()[0] : 0;
+
+  encoder.set_input_array(x);
+  encoder.set_input_array(residual);
+  encoder.set_input_array(w);
+  encoder.set_output_array(h);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "add_rms_norm", [&](auto type_tag) {
+    constexpr uint32_t N_READS = 4;
+    dispatch_block_dim(cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      auto kernel = cu::rms_norm<DataType, true, block_dim(), N_READS>;
+      encoder.add_kernel_node(
+          kernel,
+          n_rows,
+          block_dim(),
+          x.data<DataType>(),
+          residual.data<DataType>(),
+          w.data<DataType>(),
+          h.data<DataType>(),
           out.data<DataType>(),
           eps_,
           axis_size,
@@ -293,31 +425,27 @@ void RMSNormVJP::eval_gpu(
   int32_t n_rows = x.data_size() / axis_size;
   int64_t w_stride = (w.ndim() == 1) ? w.strides()[0] : 0;
 
-  // Allocate a temporary to store the gradients for w and allocate the output
-  // gradient accumulators.
-  array gw_temp =
-      (has_w) ? array({n_rows, x.shape().back()}, gw.dtype(), nullptr, {}) : w;
-  if (has_w) {
-    if (!g_in_gx && donate_g) {
-      gw_temp.copy_shared_buffer(g);
-    } else {
-      gw_temp.set_data(allocator::malloc(gw_temp.nbytes()));
-      encoder.add_temporary(gw_temp);
-    }
-  }
+  // The blocks sum the gradients for w of their rows in float32, which are
+  // then summed over the blocks.
+  constexpr int N_READS = 4;
+  int threads = norm_block_dim(axis_size, N_READS);
+  int n_blocks = norm_vjp_blocks(encoder.device(), n_rows, threads);
+  array gw_partial({n_blocks, axis_size}, float32, nullptr, {});
 
   encoder.set_input_array(x);
   encoder.set_input_array(w);
   encoder.set_input_array(g);
   encoder.set_output_array(gx);
-  encoder.set_output_array(gw_temp);
+  if (has_w) {
+    gw_partial.set_data(allocator::malloc(gw_partial.nbytes()));
+    encoder.add_temporary(gw_partial);
+    encoder.set_output_array(gw_partial);
+  }
   dispatch_float_types(gx.dtype(), "rms_norm_vjp", [&](auto type_tag) {
     dispatch_bool(has_w, [&](auto has_w_constant) {
-      constexpr int N_READS = 4;
       dispatch_block_dim(
           cuda::ceil_div(axis_size, N_READS), [&](auto block_dim) {
             using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
-            constexpr int N_READS = 4;
             auto kernel = cu::rms_norm_vjp<
                 DataType,
                 has_w_constant.value,
@@ -325,24 +453,24 @@ void RMSNormVJP::eval_gpu(
                 N_READS>;
             encoder.add_kernel_node(
                 kernel,
-                n_rows,
+                n_blocks,
                 block_dim(),
                 x.data<DataType>(),
                 w.data<DataType>(),
                 g.data<DataType>(),
                 gx.data<DataType>(),
-                gw_temp.data<DataType>(),
+                has_w ? gw_partial.data<float>() : nullptr,
                 eps_,
                 axis_size,
+                n_rows,
                 w_stride);
           });
     });
   });
 
   if (has_w) {
-    ReductionPlan plan(
-        ReductionOpType::ContiguousStridedReduce, {n_rows}, {axis_size});
-    col_reduce(encoder, gw_temp, gw, Reduce::ReduceType::Sum, {0}, plan);
+    gw.set_data(allocator::malloc(gw.nbytes()));
+    sum_partial_rows(encoder, gw_partial, gw, n_blocks, axis_size);
   }
 }
 
@@ -163,6 +163,7 @@ __global__ void rope(
     const T* in,
     T* out,
     const int32_t* offset,
+    int64_t offset_stride,
     float scale,
     float base,
     const __grid_constant__ cuda::std::array<int64_t, 3> strides,
@@ -182,7 +183,7 @@ __global__ void rope(
   rope_impl<T, traditional, forward>(
       in,
       out,
-      *offset,
+      offset[pos.y * offset_stride],
       inv_freq,
       scale,
       strides,
@@ -197,6 +198,7 @@ __global__ void rope_freqs(
     const T* in,
     T* out,
     const int32_t* offset,
+    int64_t offset_stride,
     const float* freqs,
     float scale,
     float base,
@@ -217,7 +219,7 @@ __global__ void rope_freqs(
   rope_impl<T, traditional, forward>(
       in,
       out,
-      *offset,
+      offset[pos.y * offset_stride],
       inv_freq,
       scale,
       strides,
@@ -227,11 +229,98 @@ __global__ void rope_freqs(
       dims);
 }
 
+// Split the fused projection of a token into its heads, rotate the queries
+// and the keys, and write the keys and values to the caches at their
+// position. A thread handles a pair of elements of a head, the pairs past
+// the rotated dims are only copied.
+template <typename T, bool traditional, bool with_freqs>
+__global__ void rope_qkv(
+    const T* qkv,
+    T* q,
+    T* k_cache,
+    T* v_cache,
+    const float* freqs,
+    float scale,
+    float base,
+    int offset,
+    int n_heads,
+    int n_kv_heads,
+    int seq_len,
+    int head_dim,
+    int half_dims,
+    const __grid_constant__ cuda::std::array<int64_t, 3> cache_strides,
+    int64_t freq_stride,
+    uint3 dims) {
+  uint3 pos = make_uint3(
+      blockIdx.x * blockDim.x + threadIdx.x,
+      blockIdx.y * blockDim.y + threadIdx.y,
+      blockIdx.z * blockDim.z + threadIdx.z);
+  if (pos.x >= dims.x || pos.y >= dims.y || pos.z >= dims.z) {
+    return;
+  }
+
+  int head = pos.y;
+  int b = pos.z / seq_len;
+  int l = pos.z % seq_len;
+  const T* in = qkv + (int64_t(pos.z) * dims.y + head) * head_dim;
+
+  // The destination of the head.
+  T* out;
+  bool rotate = head < n_heads + n_kv_heads;
+  if (head < n_heads) {
+    out = q + ((int64_t(b) * n_heads + head) * seq_len + l) * head_dim;
+  } else {
+    int kv_head = head - n_heads;
+    T* cache = k_cache;
+    if (kv_head >= n_kv_heads) {
+      kv_head -= n_kv_heads;
+      cache = v_cache;
+    }
+    out = cache + b * cache_strides[0] + kv_head * cache_strides[1] +
+        (offset + l) * cache_strides[2];
+  }
+
+  // The indices of the pair.
+  int index_1, index_2;
+  if (pos.x >= half_dims) {
+    rotate = false;
+    index_1 = 2 * pos.x;
+    index_2 = index_1 + 1;
+  } else if (traditional) {
+    index_1 = 2 * pos.x;
+    index_2 = index_1 + 1;
+  } else {
+    index_1 = pos.x;
+    index_2 = index_1 + half_dims;
+  }
+
+  float x1 = static_cast<float>(in[index_1]);
+  float x2 = static_cast<float>(in[index_2]);
+  if (rotate) {
+    float inv_freq;
+    if constexpr (with_freqs) {
+      inv_freq = 1.0 / freqs[freq_stride * pos.x];
+    } else {
+      float d = static_cast<float>(pos.x) / static_cast<float>(half_dims);
+      inv_freq = exp2(-d * base);
+    }
+    float theta = scale * static_cast<float>(offset + l) * inv_freq;
+    float costheta = cos(theta);
+    float sintheta = sin(theta);
+    float rx1 = x1 * costheta - x2 * sintheta;
+    float rx2 = x1 * sintheta + x2 * costheta;
+    x1 = rx1;
+    x2 = rx2;
+  }
+  out[index_1] = static_cast<T>(x1);
+  out[index_2] = static_cast<T>(x2);
+}
+
 } // namespace cu
 
 namespace fast {
 
-bool RoPE::use_fallback(Stream s) {
+bool RoPE::use_fallback(Stream s, bool per_position) {
   return s.device == Device::cpu;
 }
 
@@ -304,6 +393,8 @@ void RoPE::eval_gpu(
   // Some flags to help us dispatch below
   bool single = in.flags().row_contiguous && (mat_size == in.shape(-1));
   bool with_freqs = inputs.size() == 3;
+  // The offset is a scalar or one entry per position.
+  int64_t offset_stride = offset.size() > 1 ? offset.strides(0) : 0;
 
   auto& encoder = cu::get_command_encoder(s);
   encoder.set_input_array(donated ? out : in);
@@ -363,6 +454,7 @@ void RoPE::eval_gpu(
               (donated ? out : in).data<DataType>(),
               out.data<DataType>(),
               offset.data<int32_t>(),
+              offset_stride,
               inputs[2].data<float>(),
               scale_,
               std::log2(base_),
@@ -384,6 +476,7 @@ void RoPE::eval_gpu(
               (donated ? out : in).data<DataType>(),
               out.data<DataType>(),
               offset.data<int32_t>(),
+              offset_stride,
               scale_,
               std::log2(base_),
               strides,
@@ -396,6 +489,88 @@ void RoPE::eval_gpu(
   });
 }
 
+bool RoPEQKV::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void RoPEQKV::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("RoPEQKV::eval_gpu");
+
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+  auto& q = outputs[0];
+  auto& k_cache = outputs[1];
+  auto& v_cache = outputs[2];
+  bool with_freqs = inputs.size() == 4;
+
+  // The heads of a token are read from a row contiguous projection.
+  array qkv = inputs[0];
+  if (!qkv.flags().row_contiguous) {
+    qkv = contiguous_copy_gpu(qkv, s);
+    encoder.add_temporary(qkv);
+  }
+
+  // The new positions are written in place in the caches when donated.
+  auto update_cache = [&](const array& in, array& out) {
+    if (in.flags().row_contiguous && in.is_donatable()) {
+      out.copy_shared_buffer(in);
+    } else {
+      copy_gpu(in, out, CopyType::General, s);
+    }
+  };
+  update_cache(inputs[1], k_cache);
+  update_cache(inputs[2], v_cache);
+  q.set_data(allocator::malloc(q.nbytes()));
+
+  int head_dim = q.shape(3);
+  cuda::std::array<int64_t, 3> cache_strides = {
+      k_cache.strides(0), k_cache.strides(1), k_cache.strides(2)};
+
+  encoder.set_input_array(qkv);
+  if (with_freqs) {
+    encoder.set_input_array(inputs[3]);
+  }
+  encoder.set_output_array(q);
+  encoder.set_output_array(k_cache);
+  encoder.set_output_array(v_cache);
+  dispatch_float_types(q.dtype(), "rope_qkv", [&](auto type_tag) {
+    dispatch_bool(traditional_, [&](auto traditional) {
+      dispatch_bool(with_freqs, [&](auto with_freqs) {
+        using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+        auto kernel =
+            cu::rope_qkv<DataType, traditional.value, with_freqs.value>;
+        uint3 dims = make_uint3(
+            head_dim / 2,
+            n_heads_ + 2 * n_kv_heads_,
+            qkv.shape(0) * qkv.shape(1));
+        auto [grid, block] = get_grid_and_block(dims.x, dims.y, dims.z);
+        encoder.add_kernel_node(
+            kernel,
+            grid,
+            block,
+            qkv.data<DataType>(),
+            q.data<DataType>(),
+            k_cache.data<DataType>(),
+            v_cache.data<DataType>(),
+            with_freqs ? inputs[3].data<float>() : nullptr,
+            scale_,
+            std::log2(base_),
+            offset_,
+            n_heads_,
+            n_kv_heads_,
+            static_cast<int>(q.shape(2)),
+            head_dim,
+            dims_ / 2,
+            cache_strides,
+            with_freqs ? inputs[3].strides(0) : 0,
+            dims);
+      });
+    });
+  });
+}
+
 } // namespace fast
 
 } // namespace mlx::core
@@ -0,0 +1,207 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/arg_reduce_ops.cuh"
+#include "mlx/backend/cuda/device/random.cuh"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <nvtx3/nvtx3.hpp>
+#include <cub/block/block_reduce.cuh>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int sample_block_dim = 1024;
+
+// The uint32 of |x| which has the order of the floats.
+inline __device__ uint32_t float_to_ordered(float x) {
+  uint32_t u = __float_as_uint(x);
+  return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// The largest key K such that the weights of the elements of the row with a
+// key of at least K add up to |target|, selected one 8 bits digit of the key
+// per pass over the row. |weight(i, key)| returns the weight of the element i
+// and writes its key.
+template <typename W, typename F>
+__device__ uint32_t
+radix_select(cg::thread_block& block, int size, W target, F weight) {
+  __shared__ W hist[256];
+  __shared__ uint32_t digit;
+  __shared__ W remaining;
+
+  uint32_t prefix = 0;
+  uint32_t mask = 0;
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    for (int i = block.thread_rank(); i < 256; i += block.size()) {
+      hist[i] = 0;
+    }
+    block.sync();
+    for (int i = block.thread_rank(); i < size; i += block.size()) {
+      uint32_t key;
+      W w = weight(i, key);
+      if (w > 0 && (key & mask) == prefix) {
+        atomicAdd(&hist[(key >> shift) & 255], w);
+      }
+    }
+    block.sync();
+    // Pick the digit from the largest one, the weight of the larger digits is
+    // taken out of the target of the next digits.
+    if (block.thread_rank() == 0) {
+      W above = 0;
+      int d = 255;
+      for (; d > 0 && above + hist[d] < target; d--) {
+        above += hist[d];
+      }
+      digit = d;
+      remaining = target - above;
+    }
+    block.sync();
+    prefix |= digit << shift;
+    mask |= 255u << shift;
+    target = remaining;
+  }
+  return prefix;
+}
+
+// Sample one index of each row of logits / temperature with the Gumbel-max
+// trick, among the logits kept by the top-k and then the top-p cutoffs. The
+// Gumbel noise is the one random::gumbel draws for the whole logits.
+template <typename T, int BLOCK_DIM>
+__global__ void sample_top_k_top_p(
+    const T* logits,
+    const uint32_t* key,
+    int64_t key_stride,
+    uint32_t* out,
+    int axis_size,
+    uint32_t size,
+    float temperature,
+    int top_k,
+    float top_p) {
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  int64_t row = block.group_index().x;
+  logits += row * axis_size;
+  auto load = [&](int i) {
+    return static_cast<float>(logits[i]) / temperature;
+  };
+
+  // The kept logits have a key of at least |lower|.
+  uint32_t lower = 0;
+  if (top_k > 0 && top_k < axis_size) {
+    lower = radix_select(block, axis_size, top_k, [&](int i, uint32_t& k) {
+      k = float_to_ordered(load(i));
+      return 1;
+    });
+  }
+  if (top_p < 1) {
+    __shared__ float smem[BLOCK_DIM / WARP_SIZE];
+    float vals[1] = {Limits<float>::min()};
+    for (int i = block.thread_rank(); i < axis_size; i += BLOCK_DIM) {
+      vals[0] = fmaxf(vals[0], load(i));
+    }
+    block_reduce(
+        block, warp, vals, smem, cg::greater<float>{}, Limits<float>::min());
+    float maxval = vals[0];
+    block.sync();
+
+    vals[0] = 0;
+    for (int i = block.thread_rank(); i < axis_size; i += BLOCK_DIM) {
+      float x = load(i);
+      if (float_to_ordered(x) >= lower) {
+        vals[0] += expf(x - maxval);
+      }
+    }
+    block_reduce(block, warp, vals, smem, cg::plus<float>{}, 0.0f);
+    float target = top_p * vals[0];
+    lower = radix_select(
+        block, axis_size, target, [&, lower](int i, uint32_t& k) {
+          float x = load(i);
+          k = float_to_ordered(x);
+          return k >= lower ? expf(x - maxval) : 0.0f;
+        });
+  }
+
+  // The argmax of x + gumbel of the kept logits.
+  uint2 rkey = {key[0], key[key_stride]};
+  float upper = nextafterf(1.0f, 0.0f);
+  ArgMax<float> op;
+  IndexValPair<float> best{0, op.init()};
+  for (int i = block.thread_rank(); i < axis_size; i += BLOCK_DIM) {
+    float x = load(i);
+    if (float_to_ordered(x) >= lower) {
+      uint32_t index = row * axis_size + i;
+      uint32_t bits = random_bits_at(rkey, index, size);
+      float g = -logf(-logf(bits_to_unit(bits, upper)));
+      best = op(best, {uint32_t(i), x + g});
+    }
+  }
+  typedef cub::BlockReduce<IndexValPair<float>, BLOCK_DIM> BlockReduceT;
+  __shared__ typename BlockReduceT::TempStorage temp;
+  best = BlockReduceT(temp).Reduce(best, op);
+  if (block.thread_rank() == 0) {
+    out[row] = best.index;
+  }
+}
+
+} // namespace cu
+
+namespace fast {
+
+bool SampleTopKTopP::use_fallback(Stream s) {
+  return s.device == Device::cpu;
+}
+
+void SampleTopKTopP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("SampleTopKTopP::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  auto logits = inputs[0];
+  if (!logits.flags().row_contiguous) {
+    logits = contiguous_copy_gpu(logits, s);
+    encoder.add_temporary(logits);
+  }
+  auto& key = inputs[1];
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  int axis_size = logits.shape().back();
+  encoder.set_input_array(logits);
+  encoder.set_input_array(key);
+  encoder.set_output_array(out);
+  dispatch_float_types(logits.dtype(), "SampleTopKTopP", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    encoder.add_kernel_node(
+        cu::sample_top_k_top_p<DataType, cu::sample_block_dim>,
+        out.size(),
+        cu::sample_block_dim,
+        logits.data<DataType>(),
+        key.data<uint32_t>(),
+        key.strides()[0],
+        out.data<uint32_t>(),
+        axis_size,
+        static_cast<uint32_t>(logits.size()),
+        temperature_,
+        top_k_,
+        top_p_);
+  });
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -0,0 +1,1204 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/mma.cuh"
+#include "mlx/backend/cuda/device/utils.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/fast_primitives.h"
+#include "mlx/transforms_impl.h"
+
+#include <cooperative_groups.h>
+#include <cooperative_groups/reduce.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+// The window of the causal attention, a query at position p sees the keys
+// (p - size, p], or with chunked the keys of its chunk of size positions up
+// to p, and the num_sinks first keys. A size of 0 is no window.
+struct AttnWindow {
+  int size;
+  int num_sinks;
+  bool chunked;
+};
+
+struct AttnParams {
+  int qL;
+  int kL;
+  int gqa_factor;
+  float scale;
+  int64_t Q_strides[3];
+  int64_t K_strides[3];
+  int64_t V_strides[3];
+  int64_t O_strides[3];
+  int64_t M_strides[4];
+  // The mask covers the keys from mask_start on, the keys before are seen
+  // by all the queries, like the cache by the tree of the draft tokens
+  // which follow it.
+  int mask_start;
+  // The offsets of the sequences packed along the l dim of the varlen
+  // attention.
+  const int32_t* cu_seqlens_q;
+  const int32_t* cu_seqlens_k;
+  int num_seqs;
+  AttnWindow window;
+};
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// The first key of the window of the query at position p, the sinks before
+// it are still seen.
+__device__ __forceinline__ int window_start(const AttnWindow& window, int p) {
+  if (window.size == 0) {
+    return 0;
+  }
+  return window.chunked ? p / window.size * window.size
+                        : max(0, p - window.size + 1);
+}
+
+// The full attention, a block computes BQ = 64 queries of one head with
+// 4 warps of 16 queries each. The keys and values are walked in tiles of
+// BKV = 32 with the online softmax, so the scores are never materialized.
+//
+// The matmuls use the tensor cores. The rows of the softmax and of the output
+// are owned by pairs of lanes: lane l handles the row l / 2 and the half l % 2
+// of the columns.
+//
+// With varlen the sequences are packed along the l dim and the blocks along
+// x walk the query tiles of one sequence after the other.
+template <
+    typename T,
+    int D,
+    bool do_causal,
+    bool has_mask,
+    typename MaskT,
+    int BQ = 64,
+    int BKV = 32,
+    bool varlen = false>
+__global__ void sdpa_full(
+    const T* Q,
+    const T* K,
+    const T* V,
+    const MaskT* mask,
+    T* O,
+    const __grid_constant__ AttnParams params) {
+  if constexpr (mma_use_wmma<T>()) {
+    using namespace nvcuda;
+    constexpr int NUM_WARPS = BQ / 16;
+    constexpr int NUM_THREADS = NUM_WARPS * WARP_SIZE;
+    constexpr int DF = D / 16;
+    constexpr int KF = BKV / 16;
+    // Paddings keep the 32 bytes alignment of the fragments.
+    constexpr int LDK = D + 8;
+    constexpr int LDS = BKV + 4;
+    constexpr int LDP = BKV + 8;
+    constexpr int COLS = BKV / 2;
+    static_assert(BQ == 2 * BKV, "The q tile is staged in the kv tiles.");
+    static_assert(D % 16 == 0 && BKV % 16 == 0);
+
+    __shared__ __align__(32) T kv_smem[2 * BKV * LDK];
+    __shared__ __align__(32) float s_smem[NUM_WARPS * 16 * LDS];
+    __shared__ __align__(32) T p_smem[NUM_WARPS * 16 * LDP];
+
+    auto block = cg::this_thread_block();
+    auto warp = cg::tiled_partition<WARP_SIZE>(block);
+    int tid = block.thread_rank();
+    int warp_id = warp.meta_group_rank();
+    int lane = warp.thread_rank();
+
+    int q0 = blockIdx.x * BQ;
+    int h = blockIdx.y;
+    int b = blockIdx.z;
+    int kv_h = h / params.gqa_factor;
+    int qL = params.qL;
+    int kL = params.kL;
+    if constexpr (varlen) {
+      int tile = blockIdx.x;
+      for (b = 0; b < params.num_seqs; ++b) {
+        qL = params.cu_seqlens_q[b + 1] - params.cu_seqlens_q[b];
+        int num_tiles = (qL + BQ - 1) / BQ;
+        if (tile < num_tiles) {
+          break;
+        }
+        tile -= num_tiles;
+      }
+      // The grid covers the most tiles the sequences can have.
+      if (b == params.num_seqs) {
+        return;
+      }
+      q0 = tile * BQ;
+      kL = params.cu_seqlens_k[b + 1] - params.cu_seqlens_k[b];
+      Q += params.cu_seqlens_q[b] * params.Q_strides[2];
+      K += params.cu_seqlens_k[b] * params.K_strides[2];
+      V += params.cu_seqlens_k[b] * params.V_strides[2];
+      O += params.cu_seqlens_q[b] * params.O_strides[2];
+    }
+    int qL_off = kL - qL;
+
+    Q += b * params.Q_strides[0] + h * params.Q_strides[1];
+    K += b * params.K_strides[0] + kv_h * params.K_strides[1];
+    V += b * params.V_strides[0] + kv_h * params.V_strides[1];
+    O += b * params.O_strides[0] + h * params.O_strides[1];
+    if constexpr (has_mask) {
+      mask += b * params.M_strides[0] + h * params.M_strides[1];
+    }
+
+    T* ks = kv_smem;
+    T* vs = kv_smem + BKV * LDK;
+    float* sw = s_smem + warp_id * 16 * LDS;
+    T* pw = p_smem + warp_id * 16 * LDP;
+
+    // Load the queries of the warp into registers, staged in the kv tiles.
+    for (int i = tid; i < BQ * D; i += NUM_THREADS) {
+      int r = i / D;
+      int c = i % D;
+      int q = q0 + r;
+      kv_smem[r * LDK + c] =
+          q < qL ? Q[q * params.Q_strides[2] + c] : static_cast<T>(0);
+    }
+    block.sync();
+    wmma::fragment<wmma::matrix_a, 16, 16, 16, T, wmma::row_major> qa[DF];
+#pragma unroll
+    for (int df = 0; df < DF; ++df) {
+      wmma::load_matrix_sync(
+          qa[df], kv_smem + warp_id * 16 * LDK + df * 16, LDK);
+    }
+    block.sync();
+
+    int row = lane / 2;
+    int half = lane % 2;
+    int q_idx = q0 + warp_id * 16 + row;
+    constexpr float log2e = 1.44269504089f;
+    float scale_log2 = params.scale * log2e;
+
+    float o[DF][8] = {};
+    float m_i = Limits<float>::min();
+    float l_i = 0;
+
+    // With the causal mask the keys after the last query of the tile are
+    // skipped, and with a window the tiles between the sinks and the window
+    // of the first query of the tile too.
+    int kv_end = kL;
+    int kv_begin = 0;
+    if constexpr (do_causal) {
+      kv_end = min(kL, q0 + BQ + qL_off);
+      kv_begin = window_start(params.window, q0 + qL_off) / BKV * BKV;
+    }
+
+    for (int kv0 = 0; kv0 < kv_end; kv0 += BKV) {
+      if (kv0 >= params.window.num_sinks && kv0 < kv_begin) {
+        kv0 = kv_begin;
+        if (kv0 >= kv_end) {
+          break;
+        }
+      }
+      for (int i = tid; i < BKV * D; i += NUM_THREADS) {
+        int r = i / D;
+        int c = i % D;
+        int j = kv0 + r;
+        bool in_bounds = j < kL;
+        ks[r * LDK + c] =
+            in_bounds ? K[j * params.K_strides[2] + c] : static_cast<T>(0);
+        vs[r * LDK + c] =
+            in_bounds ? V[j * params.V_strides[2] + c] : static_cast<T>(0);
+      }
+      block.sync();
+
+      // S = Q @ K.T
+#pragma unroll
+      for (int kf = 0; kf < KF; ++kf) {
+        wmma::fragment<wmma::accumulator, 16, 16, 16, float> acc;
+        wmma::fill_fragment(acc, 0.0f);
+#pragma unroll
+        for (int df = 0; df < DF; ++df) {
+          wmma::fragment<wmma::matrix_b, 16, 16, 16, T, wmma::col_major> kb;
+          wmma::load_matrix_sync(kb, ks + kf * 16 * LDK + df * 16, LDK);
+          wmma::mma_sync(acc, qa[df], kb, acc);
+        }
+        wmma::store_matrix_sync(sw + kf * 16, acc, LDS, wmma::mem_row_major);
+      }
+      warp.sync();
+
+      // Online softmax in base 2.
+      float s[COLS];
+      float m_blk = Limits<float>::min();
+#pragma unroll
+      for (int i = 0; i < COLS; ++i) {
+        int c = half * COLS + i;
+        int j = kv0 + c;
+        float x = sw[row * LDS + c] * scale_log2;
+        if (j >= kL || q_idx >= qL) {
+          x = Limits<float>::min();
+        } else {
+          if constexpr (do_causal) {
+            int p = q_idx + qL_off;
+            if (j > p ||
+                (j >= params.window.num_sinks &&
+                 j < window_start(params.window, p))) {
+              x = Limits<float>::min();
+            }
+          }
+          if constexpr (has_mask) {
+            if (j >= params.mask_start) {
+              auto m = mask
+                  [q_idx * params.M_strides[2] +
+                   (j - params.mask_start) * params.M_strides[3]];
+              if constexpr (cuda::std::is_same_v<MaskT, bool>) {
+                x = m ? x : Limits<float>::min();
+              } else {
+                x += static_cast<float>(m) * log2e;
+              }
+            }
+          }
+        }
+        s[i] = x;
+        m_blk = max(m_blk, x);
+      }
+      m_blk = max(m_blk, warp.shfl_xor(m_blk, 1));
+      float m_new = max(m_i, m_blk);
+      // Rows with all the scores masked so far keep a -inf max.
+      bool all_masked = m_new == Limits<float>::min();
+      float alpha = all_masked ? 1.0f : exp2f(m_i - m_new);
+      float l_blk = 0;
+#pragma unroll
+      for (int i = 0; i < COLS; ++i) {
+        float p = all_masked ? 0.0f : exp2f(s[i] - m_new);
+        l_blk += p;
+        pw[row * LDP + half * COLS + i] = static_cast<T>(p);
+      }
+      l_i = l_i * alpha + l_blk;
+      m_i = m_new;
+#pragma unroll
+      for (int df = 0; df < DF; ++df) {
+#pragma unroll
+        for (int i = 0; i < 8; ++i) {
+          o[df][i] *= alpha;
+        }
+      }
+      warp.sync();
+
+      // O += P @ V
+      wmma::fragment<wmma::matrix_a, 16, 16, 16, T, wmma::row_major> pa[KF];
+#pragma unroll
+      for (int kf = 0; kf < KF; ++kf) {
+        wmma::load_matrix_sync(pa[kf], pw + kf * 16, LDP);
+      }
+#pragma unroll
+      for (int df = 0; df < DF; ++df) {
+        wmma::fragment<wmma::accumulator, 16, 16, 16, float> acc;
+        wmma::fill_fragment(acc, 0.0f);
+#pragma unroll
+        for (int kf = 0; kf < KF; ++kf) {
+          wmma::fragment<wmma::matrix_b, 16, 16, 16, T, wmma::row_major> vb;
+          wmma::load_matrix_sync(vb, vs + kf * 16 * LDK + df * 16, LDK);
+          wmma::mma_sync(acc, pa[kf], vb, acc);
+        }
+        wmma::store_matrix_sync(sw, acc, LDS, wmma::mem_row_major);
+        warp.sync();
+#pragma unroll
+        for (int i = 0; i < 8; ++i) {
+          o[df][i] += sw[row * LDS + half * 8 + i];
+        }
+        warp.sync();
+      }
+      block.sync();
+    }
+
+    float l = l_i + warp.shfl_xor(l_i, 1);
+    float inv_l = l > 0 ? 1.0f / l : 0.0f;
+    if (q_idx < qL) {
+      T* out = O + q_idx * params.O_strides[2];
+#pragma unroll
+      for (int df = 0; df < DF; ++df) {
+#pragma unroll
+        for (int i = 0; i < 8; ++i) {
+          out[df * 16 + half * 8 + i] = static_cast<T>(o[df][i] * inv_l);
+        }
+      }
+    }
+  } else {
+    // Excluded by use_fallback.
+    __trap();
+  }
+}
+
+// The attention of NQ consecutive queries of one head in a block, used for
+// the few queries of decoding and of the verification of draft tokens. The
+// keys and values are read once for all the queries. The warps start at the
+// key key_start + warp_id and walk the keys with key_stride, lane l owns the
+// elements l, l + 32, ... of the head dim.
+//
+// The results of the warps are merged in shared memory, the first D threads
+// return the unnormalized outputs of the queries in |acc| along with their
+// max scores and sums of the exponentials.
+template <
+    typename T,
+    int D,
+    bool do_causal,
+    bool has_mask,
+    typename MaskT,
+    int NUM_WARPS,
+    int NQ>
+inline __device__ void sdpa_vector_block(
+    const T* Q,
+    const T* K,
+    const T* V,
+    const MaskT* mask,
+    const AttnParams& params,
+    dim3 idx,
+    int key_start,
+    int key_stride,
+    float* maxs,
+    float* sums,
+    float* outs,
+    float (&acc)[NQ],
+    float (&max_score)[NQ],
+    float (&sum_exp)[NQ]) {
+  auto block = cg::this_thread_block();
+  auto warp = cg::tiled_partition<WARP_SIZE>(block);
+  int warp_id = warp.meta_group_rank();
+  int lane = warp.thread_rank();
+
+  int h = idx.x;
+  int q0 = idx.y * NQ;
+  int b = idx.z;
+  int kv_h = h / params.gqa_factor;
+  int kL = params.kL;
+  int nq = min(NQ, params.qL - q0);
+
+  Q += b * params.Q_strides[0] + h * params.Q_strides[1] +
+      q0 * params.Q_strides[2];
+  K += b * params.K_strides[0] + kv_h * params.K_strides[1];
+  V += b * params.V_strides[0] + kv_h * params.V_strides[1];
+  if constexpr (has_mask) {
+    mask += b * params.M_strides[0] + h * params.M_strides[1] +
+        q0 * params.M_strides[2];
+  }
+
+  constexpr int EPT = D / WARP_SIZE;
+  static_assert(D % WARP_SIZE == 0);
+  static_assert(NQ <= 32, "The visible queries are kept in a bitmask.");
+  constexpr float log2e = 1.44269504089f;
+  float scale_log2 = params.scale * log2e;
+  float q[NQ][EPT];
+  float o[NQ][EPT] = {};
+#pragma unroll
+  for (int i = 0; i < NQ; ++i) {
+#pragma unroll
+    for (int e = 0; e < EPT; ++e) {
+      q[i][e] = 0;
+      if (i < nq) {
+        q[i][e] = static_cast<float>(
+                      Q[i * params.Q_strides[2] + e * WARP_SIZE + lane]) *
+            scale_log2;
+      }
+    }
+  }
+
+  // The queries are at the positions p0 + i.
+  int p0 = kL - params.qL + q0;
+  int key_end = kL;
+  int key_begin = 0;
+  if constexpr (do_causal) {
+    key_end = min(kL, p0 + nq);
+    key_begin = window_start(params.window, p0);
+  }
+
+  // Online softmax in base 2.
+  float m[NQ];
+  float l[NQ] = {};
+#pragma unroll
+  for (int i = 0; i < NQ; ++i) {
+    m[i] = Limits<float>::min();
+  }
+  for (int j = key_start + warp_id; j < key_end; j += key_stride) {
+    // Jump from the sinks to the first key of the window of the warp.
+    if (j >= params.window.num_sinks && j < key_begin) {
+      j += (key_begin - j + key_stride - 1) / key_stride * key_stride;
+      if (j >= key_end) {
+        break;
+      }
+    }
+    // The queries which see the key, and the additive masks.
+    uint32_t visible = 0;
+    float bias[NQ];
+#pragma unroll
+    for (int i = 0; i < NQ; ++i) {
+      bool seen = i < nq;
+      bias[i] = 0;
+      if constexpr (do_causal) {
+        int p = p0 + i;
+        seen = seen && j <= p &&
+            (j < params.window.num_sinks ||
+             j >= window_start(params.window, p));
+      }
+      if constexpr (has_mask) {
+        // The keys before mask_start are not covered by the mask.
+        if (seen && j >= params.mask_start) {
+          auto mv = mask
+              [i * params.M_strides[2] +
+               (j - params.mask_start) * params.M_strides[3]];
+          if constexpr (cuda::std::is_same_v<MaskT, bool>) {
+            seen = mv;
+          } else {
+            bias[i] = max(
+                Limits<float>::finite_min(), static_cast<float>(mv) * log2e);
+          }
+        }
+      }
+      visible |= uint32_t(seen) << i;
+    }
+    if (!visible) {
+      continue;
+    }
+
+    const T* k = K + j * params.K_strides[2];
+    const T* v = V + j * params.V_strides[2];
+    float kj[EPT];
+    float vj[EPT];
+#pragma unroll
+    for (int e = 0; e < EPT; ++e) {
+      kj[e] = static_cast<float>(k[e * WARP_SIZE + lane]);
+      vj[e] = static_cast<float>(v[e * WARP_SIZE + lane]);
+    }
+#pragma unroll
+    for (int i = 0; i < NQ; ++i) {
+      if (!(visible & (1u << i))) {
+        continue;
+      }
+      float score = 0;
+#pragma unroll
+      for (int e = 0; e < EPT; ++e) {
+        score += q[i][e] * kj[e];
+      }
+      score = cg::reduce(warp, score, cg::plus<float>{}) + bias[i];
+      float m_new = max(m[i], score);
+      float factor = exp2f(m[i] - m_new);
+      float p = exp2f(score - m_new);
+      l[i] = l[i] * factor + p;
+      m[i] = m_new;
+#pragma unroll
+      for (int e = 0; e < EPT; ++e) {
+        o[i][e] = o[i][e] * factor + p * vj[e];
+      }
+    }
+  }
+
+  // Merge the warps.
+  if (lane == 0) {
+#pragma unroll
+    for (int i = 0; i < NQ; ++i) {
+      maxs[i * NUM_WARPS + warp_id] = m[i];
+      sums[i * NUM_WARPS + warp_id] = l[i];
+    }
+  }
+  block.sync();
+#pragma unroll
+  for (int i = 0; i < NQ; ++i) {
+    max_score[i] = Limits<float>::min();
+#pragma unroll
+    for (int w = 0; w < NUM_WARPS; ++w) {
+      max_score[i] = max(max_score[i], maxs[i * NUM_WARPS + w]);
+    }
+    // Warps without any key keep a -inf max and a zero sum.
+    bool empty = max_score[i] == Limits<float>::min();
+    sum_exp[i] = 0;
+#pragma unroll
+    for (int w = 0; w < NUM_WARPS; ++w) {
+      sum_exp[i] += empty
+          ? 0.0f
+          : sums[i * NUM_WARPS + w] *
+              exp2f(maxs[i * NUM_WARPS + w] - max_score[i]);
+    }
+    float factor = empty ? 0.0f : exp2f(m[i] - max_score[i]);
+    if (i > 0) {
+      block.sync();
+    }
+#pragma unroll
+    for (int e = 0; e < EPT; ++e) {
+      outs[warp_id * D + e * WARP_SIZE + lane] = o[i][e] * factor;
+    }
+    block.sync();
+    acc[i] = 0;
+    if (block.thread_rank() < D) {
+#pragma unroll
+      for (int w = 0; w < NUM_WARPS; ++w) {
+        acc[i] += outs[w * D + block.thread_rank()];
+      }
+    }
+  }
+}
+
+// The warps of a block of the single pass vector attention, fewer with
+// several queries as each lane keeps their queries and outputs in registers.
+template <int NQ>
+constexpr int sdpa_vector_warps = NQ == 1 ? 32 : 8;
+
+template <
+    typename T,
+    int D,
+    bool do_causal,
+    bool has_mask,
+    typename MaskT,
+    int NQ = 1,
+    int NUM_WARPS = sdpa_vector_warps<NQ>>
+__global__ void sdpa_vector(
+    const T* Q,
+    const T* K,
+    const T* V,
+    const MaskT* mask,
+    T* O,
+    const __grid_constant__ AttnParams params) {
+  __shared__ float maxs[NQ * NUM_WARPS];
+  __shared__ float sums[NQ * NUM_WARPS];
+  __shared__ float outs[NUM_WARPS * D];
+
+  float acc[NQ], max_score[NQ], sum_exp[NQ];
+  sdpa_vector_block<T, D, do_causal, has_mask, MaskT, NUM_WARPS, NQ>(
+      Q,
+      K,
+      V,
+      mask,
+      params,
+      blockIdx,
+      0,
+      NUM_WARPS,
+      maxs,
+      sums,
+      outs,
+      acc,
+      max_score,
+      sum_exp);
+
+  int d = threadIdx.x;
+  int q0 = blockIdx.y * NQ;
+  if (d < D) {
+    O += blockIdx.z * params.O_strides[0] + blockIdx.x * params.O_strides[1] +
+        q0 * params.O_strides[2];
+#pragma unroll
+    for (int i = 0; i < NQ; ++i) {
+      if (q0 + i < params.qL) {
+        O[i * params.O_strides[2] + d] =
+            static_cast<T>(sum_exp[i] > 0 ? acc[i] / sum_exp[i] : 0.0f);
+      }
+    }
+  }
+}
+
+// The first pass of the split-k variant for long caches, the keys are split
+// between |blocks| blocks which write their partial outputs, max scores and
+// sums of exponentials in float, indexed by [B, H, qL, blocks].
+template <
+    typename T,
+    int D,
+    bool do_causal,
+    bool has_mask,
+    typename MaskT,
+    int NQ = 1,
+    int NUM_WARPS = 8>
+__global__ void sdpa_vector_2pass_1(
+    const T* Q,
+    const T* K,
+    const T* V,
+    const MaskT* mask,
+    float* partials,
+    float* sums,
+    float* maxs,
+    int blocks,
+    const __grid_constant__ AttnParams params) {
+  __shared__ float maxs_smem[NQ * NUM_WARPS];
+  __shared__ float sums_smem[NQ * NUM_WARPS];
+  __shared__ float outs[NUM_WARPS * D];
+
+  // The split is the fastest moving index of the batch dim of the grid.
+  int split = blockIdx.z % blocks;
+  dim3 idx(blockIdx.x, blockIdx.y, blockIdx.z / blocks);
+  float acc[NQ], max_score[NQ], sum_exp[NQ];
+  sdpa_vector_block<T, D, do_causal, has_mask, MaskT, NUM_WARPS, NQ>(
+      Q,
+      K,
+      V,
+      mask,
+      params,
+      idx,
+      split * NUM_WARPS,
+      blocks * NUM_WARPS,
+      maxs_smem,
+      sums_smem,
+      outs,
+      acc,
+      max_score,
+      sum_exp);
+
+  int d = threadIdx.x;
+  int q0 = idx.y * NQ;
+#pragma unroll
+  for (int i = 0; i < NQ; ++i) {
+    if (q0 + i >= params.qL) {
+      break;
+    }
+    int64_t row = (int64_t(idx.z) * gridDim.x + idx.x) * params.qL + q0 + i;
+    int64_t out_idx = row * blocks + split;
+    if (d < D) {
+      partials[out_idx * D + d] = acc[i];
+    }
+    if (d == 0) {
+      sums[out_idx] = sum_exp[i];
+      maxs[out_idx] = max_score[i];
+    }
+  }
+}
+
+// Merge the partial outputs of the first pass, a block of D threads computes
+// one query of one head.
+template <typename T, int D>
+__global__ void sdpa_vector_2pass_2(
+    const float* partials,
+    const float* sums,
+    const float* maxs,
+    T* O,
+    int blocks,
+    const __grid_constant__ AttnParams params) {
+  int h = blockIdx.x;
+  int q_idx = blockIdx.y;
+  int b = blockIdx.z;
+  int d = threadIdx.x;
+
+  int64_t row = (int64_t(b) * gridDim.x + h) * params.qL + q_idx;
+  partials += row * blocks * D;
+  sums += row * blocks;
+  maxs += row * blocks;
+
+  float max_score = Limits<float>::min();
+  for (int i = 0; i < blocks; ++i) {
+    max_score = max(max_score, maxs[i]);
+  }
+  bool empty = max_score == Limits<float>::min();
+  float sum_exp = 0;
+  float acc = 0;
+  for (int i = 0; i < blocks; ++i) {
+    float factor = empty ? 0.0f : exp2f(maxs[i] - max_score);
+    sum_exp += sums[i] * factor;
+    acc += partials[i * D + d] * factor;
+  }
+
+  O += b * params.O_strides[0] + h * params.O_strides[1] +
+      q_idx * params.O_strides[2];
+  O[d] = static_cast<T>(sum_exp > 0 ? acc / sum_exp : 0.0f);
+}
+
+} // namespace cu
+
+namespace {
+
+template <typename F>
+void dispatch_head_dim(int head_dim, F&& f) {
+  switch (head_dim) {
+    case 64:
+      f(std::integral_constant<int, 64>{});
+      break;
+    case 80:
+      f(std::integral_constant<int, 80>{});
+      break;
+    case 128:
+      f(std::integral_constant<int, 128>{});
+      break;
+  }
+}
+
+// Calls f(has_mask, mask_tag) with the type of the mask as the tag.
+template <typename DataType, typename F>
+void dispatch_mask(const std::optional<array>& mask, F&& f) {
+  if (!mask) {
+    f(std::false_type{}, DataType{});
+  } else if (mask->dtype() == bool_) {
+    f(std::true_type{}, bool{});
+  } else {
+    f(std::true_type{}, DataType{});
+  }
+}
+
+AttnParams make_attn_params(
+    const array& q,
+    const array& k,
+    const array& v,
+    float scale,
+    const array& o,
+    const std::optional<array>& mask,
+    int mask_start,
+    const AttnWindow& window) {
+  AttnParams params;
+  params.qL = q.shape(2);
+  params.kL = k.shape(2);
+  params.gqa_factor = q.shape(1) / k.shape(1);
+  params.scale = scale;
+  for (int i = 0; i < 3; ++i) {
+    params.Q_strides[i] = q.strides(i);
+    params.K_strides[i] = k.strides(i);
+    params.V_strides[i] = v.strides(i);
+    params.O_strides[i] = o.strides(i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    params.M_strides[i] = mask ? mask->strides(i) : 0;
+  }
+  params.mask_start = mask_start;
+  params.cu_seqlens_q = nullptr;
+  params.cu_seqlens_k = nullptr;
+  params.num_seqs = 0;
+  params.window = window;
+  return params;
+}
+
+void set_attn_arrays(
+    cu::CommandEncoder& enc,
+    const array& q,
+    const array& k,
+    const array& v,
+    array& o,
+    const std::optional<array>& mask) {
+  enc.set_input_array(q);
+  enc.set_input_array(k);
+  enc.set_input_array(v);
+  if (mask) {
+    enc.set_input_array(*mask);
+  }
+  enc.set_output_array(o);
+}
+
+void sdpa_full_self_attention(
+    const Stream& s,
+    cu::CommandEncoder& enc,
+    const array& q,
+    const array& k,
+    const array& v,
+    float scale,
+    array& o,
+    bool do_causal,
+    const std::optional<array>& mask,
+    int mask_start,
+    const AttnWindow& window) {
+  constexpr int BQ = 64;
+  int B = q.shape(0);
+  int H = q.shape(1);
+  int D = q.shape(3);
+
+  AttnParams params =
+      make_attn_params(q, k, v, scale, o, mask, mask_start, window);
+  set_attn_arrays(enc, q, k, v, o, mask);
+
+  dim3 num_blocks(cuda::ceil_div(params.qL, BQ), H, B);
+  dispatch_float_types(o.dtype(), "sdpa_full", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    if constexpr (
+        std::is_same_v<DataType, __half> ||
+        std::is_same_v<DataType, __nv_bfloat16>) {
+      dispatch_head_dim(D, [&](auto head_dim) {
+        dispatch_bool(do_causal, [&](auto do_causal) {
+          dispatch_mask<DataType>(mask, [&](auto has_mask, auto mask_tag) {
+            using MaskT = decltype(mask_tag);
+            auto kernel = cu::sdpa_full<
+                DataType,
+                head_dim.value,
+                do_causal.value,
+                has_mask.value,
+                MaskT,
+                BQ>;
+            enc.add_kernel_node(
+                kernel,
+                num_blocks,
+                BQ / 16 * WARP_SIZE,
+                q.data<DataType>(),
+                k.data<DataType>(),
+                v.data<DataType>(),
+                mask ? mask->data<MaskT>() : nullptr,
+                o.data<DataType>(),
+                params);
+          });
+        });
+      });
+    } else {
+      throw std::invalid_argument(
+          "[sdpa_full] Only float16 and bfloat16 are supported.");
+    }
+  });
+}
+
+
+// The queries, keys and values are packed as (total_tokens, n_heads,
+// head_dim) and are read as a batch of one with the tokens of all the
+// sequences along the l dim.
+void sdpa_varlen(
+    cu::CommandEncoder& enc,
+    const array& q,
+    const array& k,
+    const array& v,
+    const array& cu_seqlens_q,
+    const array& cu_seqlens_k,
+    float scale,
+    array& o,
+    bool do_causal) {
+  constexpr int BQ = 64;
+  int H = q.shape(1);
+  int D = q.shape(2);
+
+  AttnParams params;
+  params.qL = q.shape(0);
+  params.kL = k.shape(0);
+  params.gqa_factor = q.shape(1) / k.shape(1);
+  params.scale = scale;
+  auto set_strides = [](const array& x, int64_t* strides) {
+    strides[0] = 0;
+    strides[1] = x.strides(1);
+    strides[2] = x.strides(0);
+  };
+  set_strides(q, params.Q_strides);
+  set_strides(k, params.K_strides);
+  set_strides(v, params.V_strides);
+  set_strides(o, params.O_strides);
+  for (int i = 0; i < 4; ++i) {
+    params.M_strides[i] = 0;
+  }
+  params.mask_start = 0;
+  params.cu_seqlens_q = cu_seqlens_q.data<int32_t>();
+  params.cu_seqlens_k = cu_seqlens_k.data<int32_t>();
+  params.num_seqs = cu_seqlens_q.size() - 1;
+  params.window = AttnWindow{0, 0, false};
+  set_attn_arrays(enc, q, k, v, o, std::nullopt);
+  enc.set_input_array(cu_seqlens_q);
+  enc.set_input_array(cu_seqlens_k);
+
+  // Each sequence has at most one partial tile.
+  dim3 num_blocks(cuda::ceil_div(params.qL, BQ) + params.num_seqs, H, 1);
+  dispatch_float_types(o.dtype(), "sdpa_varlen", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    if constexpr (
+        std::is_same_v<DataType, __half> ||
+        std::is_same_v<DataType, __nv_bfloat16>) {
+      dispatch_head_dim(D, [&](auto head_dim) {
+        dispatch_bool(do_causal, [&](auto do_causal) {
+          auto kernel = cu::sdpa_full<
+              DataType,
+              head_dim.value,
+              do_causal.value,
+              false,
+              DataType,
+              BQ,
+              BQ / 2,
+              true>;
+          enc.add_kernel_node(
+              kernel,
+              num_blocks,
+              BQ / 16 * WARP_SIZE,
+              q.data<DataType>(),
+              k.data<DataType>(),
+              v.data<DataType>(),
+              static_cast<const DataType*>(nullptr),
+              o.data<DataType>(),
+              params);
+        });
+      });
+    } else {
+      throw std::invalid_argument(
+          "[sdpa_varlen] Only float16 and bfloat16 are supported.");
+    }
+  });
+}
+
+template <typename F>
+void dispatch_vector_head_dim(int head_dim, F&& f) {
+  switch (head_dim) {
+    case 64:
+      f(std::integral_constant<int, 64>{});
+      break;
+    case 96:
+      f(std::integral_constant<int, 96>{});
+      break;
+    case 128:
+      f(std::integral_constant<int, 128>{});
+      break;
+    case 256:
+      f(std::integral_constant<int, 256>{});
+      break;
+  }
+}
+
+void sdpa_vector(
+    const Stream& s,
+    cu::CommandEncoder& enc,
+    const array& q,
+    const array& k,
+    const array& v,
+    float scale,
+    array& o,
+    bool do_causal,
+    const std::optional<array>& mask,
+    int mask_start,
+    const AttnWindow& window) {
+  int B = q.shape(0);
+  int H = q.shape(1);
+  int qL = q.shape(2);
+  int kL = k.shape(2);
+  int D = q.shape(3);
+
+  AttnParams params =
+      make_attn_params(q, k, v, scale, o, mask, mask_start, window);
+  set_attn_arrays(enc, q, k, v, o, mask);
+
+  // With a long cache and too few queries to fill the GPU the keys are split
+  // between blocks, and the partial results are merged by a second kernel.
+  // A query only reads the keys of its window.
+  constexpr int blocks = 32;
+  int keys_read = kL;
+  if (window.size > 0) {
+    keys_read = std::min(kL, window.size + window.num_sinks);
+  }
+  //
+  // The several queries of the verification of draft tokens are computed by
+  // the same blocks, which read the keys and values once for all of them.
+  constexpr int max_block_queries = 8;
+  bool multi_query = qL > 1;
+  int q_blocks = multi_query ? cuda::ceil_div(qL, max_block_queries) : qL;
+  bool two_pass = keys_read >= 1024 && B * H * q_blocks <= 256;
+
+  if (!two_pass) {
+    dim3 num_blocks(H, q_blocks, B);
+    dispatch_float_types(o.dtype(), "sdpa_vector", [&](auto type_tag) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      dispatch_vector_head_dim(D, [&](auto head_dim) {
+        dispatch_bool(do_causal, [&](auto do_causal) {
+          dispatch_mask<DataType>(mask, [&](auto has_mask, auto mask_tag) {
+            dispatch_bool(multi_query, [&](auto multi_query) {
+              using MaskT = decltype(mask_tag);
+              constexpr int NQ = multi_query.value ? max_block_queries : 1;
+              auto kernel = cu::sdpa_vector<
+                  DataType,
+                  head_dim.value,
+                  do_causal.value,
+                  has_mask.value,
+                  MaskT,
+                  NQ>;
+              enc.add_kernel_node(
+                  kernel,
+                  num_blocks,
+                  cu::sdpa_vector_warps<NQ> * WARP_SIZE,
+                  q.data<DataType>(),
+                  k.data<DataType>(),
+                  v.data<DataType>(),
+                  mask ? mask->data<MaskT>() : nullptr,
+                  o.data<DataType>(),
+                  params);
+            });
+          });
+        });
+      });
+    });
+    return;
+  }
+
+  array partials({B, H, qL, blocks, D}, float32, nullptr, {});
+  array sums({B, H, qL, blocks}, float32, nullptr, {});
+  array maxs({B, H, qL, blocks}, float32, nullptr, {});
+  for (auto* arr : {&partials, &sums, &maxs}) {
+    arr->set_data(allocator::malloc(arr->nbytes()));
+    enc.add_temporary(*arr);
+  }
+
+  enc.set_output_array(partials);
+  enc.set_output_array(sums);
+  enc.set_output_array(maxs);
+
+  constexpr int NUM_WARPS = 8;
+  dispatch_float_types(o.dtype(), "sdpa_vector_2pass", [&](auto type_tag) {
+    using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    dispatch_vector_head_dim(D, [&](auto head_dim) {
+      dispatch_bool(do_causal, [&](auto do_causal) {
+        dispatch_mask<DataType>(mask, [&](auto has_mask, auto mask_tag) {
+          dispatch_bool(multi_query, [&](auto multi_query) {
+            using MaskT = decltype(mask_tag);
+            constexpr int NQ = multi_query.value ? max_block_queries : 1;
+            auto kernel = cu::sdpa_vector_2pass_1<
+                DataType,
+                head_dim.value,
+                do_causal.value,
+                has_mask.value,
+                MaskT,
+                NQ,
+                NUM_WARPS>;
+            enc.add_kernel_node(
+                kernel,
+                dim3(H, q_blocks, B * blocks),
+                NUM_WARPS * WARP_SIZE,
+                q.data<DataType>(),
+                k.data<DataType>(),
+                v.data<DataType>(),
+                mask ? mask->data<MaskT>() : nullptr,
+                partials.data<float>(),
+                sums.data<float>(),
+                maxs.data<float>(),
+                blocks,
+                params);
+          });
+        });
+      });
+
+      enc.set_input_array(partials);
+      enc.set_input_array(sums);
+      enc.set_input_array(maxs);
+      enc.set_output_array(o);
+      enc.add_kernel_node(
+          cu::sdpa_vector_2pass_2<DataType, head_dim.value>,
+          dim3(H, qL, B),
+          head_dim.value,
+          partials.data<float>(),
+          sums.data<float>(),
+          maxs.data<float>(),
+          o.data<DataType>(),
+          blocks,
+          params);
+    });
+  });
+}
+
+} // namespace
+
+namespace fast {
+
+bool ScaledDotProductAttention::use_fallback(
+    const array& q,
+    const array& k,
+    const array& v,
+    bool has_mask,
+    bool has_arr_mask,
+    bool do_causal,
+    bool has_window,
+    bool has_tree,
+    Stream s) {
+  if (detail::in_grad_tracing()) {
+    return true;
+  }
+  if (s.device == Device::cpu) {
+    return true;
+  }
+
+  const int value_head_dim = v.shape(-1);
+  const int query_head_dim = q.shape(-1);
+  const int query_sequence_length = q.shape(2);
+  const int key_sequence_length = k.shape(2);
+
+  // The tensor cores support bfloat16 from sm_80.
+  auto& d = cu::device(s.device);
+  const bool sdpa_full_supported_dtype = q.dtype() == float16 ||
+      (q.dtype() == bfloat16 && d.compute_capability_major() >= 8);
+  const bool sdpa_full_supported_head_dim = query_head_dim == value_head_dim &&
+      (query_head_dim == 64 || query_head_dim == 80 || query_head_dim == 128);
+  const bool sdpa_vector_supported_dtype = q.dtype() == float32 ||
+      q.dtype() == float16 || q.dtype() == bfloat16;
+  const bool sdpa_vector_supported_head_dim =
+      query_head_dim == value_head_dim &&
+      (query_head_dim == 64 || query_head_dim == 96 || query_head_dim == 128 ||
+       query_head_dim == 256);
+
+  const bool sdpa_full_supported_mask = !has_mask || has_arr_mask ||
+      (query_sequence_length <= key_sequence_length && do_causal);
+
+  const bool supports_sdpa_full = query_sequence_length > 8 &&
+      sdpa_full_supported_mask && sdpa_full_supported_head_dim &&
+      sdpa_full_supported_dtype;
+
+  const bool supports_sdpa_vector = (query_sequence_length <= 8) &&
+      (query_sequence_length <= key_sequence_length) &&
+      sdpa_vector_supported_head_dim && sdpa_vector_supported_dtype;
+
+  return !(supports_sdpa_full || supports_sdpa_vector);
+}
+
+void ScaledDotProductAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  nvtx3::scoped_range r("ScaledDotProductAttention::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  // The head dim must be contiguous, the other dims can have any strides.
+  auto copy_unless_matrix_contiguous = [&](const array& arr) {
+    if (arr.strides(-1) == 1) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return arr_copy;
+  };
+
+  array q = copy_unless_matrix_contiguous(inputs[0]);
+  array k = copy_unless_matrix_contiguous(inputs[1]);
+  array v = copy_unless_matrix_contiguous(inputs[2]);
+  // The mask is broadcasted to [B, H, qL, kL] and read with its strides.
+  std::optional<array> mask;
+  if (inputs.size() > 3) {
+    mask = inputs[3];
+  }
+
+  out.set_data(allocator::malloc(out.nbytes()));
+
+  AttnWindow window{window_size_, num_sinks_, chunked_};
+  // The tree mask covers the last keys, those of the queries.
+  int mask_start = tree_ ? k.shape(2) - q.shape(2) : 0;
+  if (q.shape(2) <= 8) {
+    sdpa_vector(
+        s, enc, q, k, v, scale_, out, do_causal_, mask, mask_start, window);
+  } else {
+    sdpa_full_self_attention(
+        s, enc, q, k, v, scale_, out, do_causal_, mask, mask_start, window);
+  }
+}
+
+bool VarlenAttention::use_fallback(const array& q, const array& v, Stream s) {
+  if (detail::in_grad_tracing() || s.device == Device::cpu) {
+    return true;
+  }
+  auto& d = cu::device(s.device);
+  const bool supported_dtype = q.dtype() == float16 ||
+      (q.dtype() == bfloat16 && d.compute_capability_major() >= 8);
+  const int head_dim = q.shape(-1);
+  const bool supported_head_dim = head_dim == v.shape(-1) &&
+      (head_dim == 64 || head_dim == 80 || head_dim == 128);
+  return !(supported_dtype && supported_head_dim);
+}
+
+void VarlenAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("VarlenAttention::eval_gpu");
+  auto& s = stream();
+  auto& enc = cu::get_command_encoder(s);
+
+  // The head dim must be contiguous and the offsets are read in order.
+  auto copy_unless = [&](const array& arr, bool contiguous) {
+    if (contiguous) {
+      return arr;
+    }
+    array arr_copy = contiguous_copy_gpu(arr, s);
+    enc.add_temporary(arr_copy);
+    return arr_copy;
+  };
+  array q = copy_unless(inputs[0], inputs[0].strides(-1) == 1);
+  array k = copy_unless(inputs[1], inputs[1].strides(-1) == 1);
+  array v = copy_unless(inputs[2], inputs[2].strides(-1) == 1);
+  array cu_seqlens_q =
+      copy_unless(inputs[3], inputs[3].flags().row_contiguous);
+  array cu_seqlens_k =
+      copy_unless(inputs[4], inputs[4].flags().row_contiguous);
+
+  auto& out = outputs[0];
+  out.set_data(allocator::malloc(out.nbytes()));
+  sdpa_varlen(
+      enc, q, k, v, cu_seqlens_q, cu_seqlens_k, scale_, out, do_causal_);
+}
+
+} // namespace fast
+
+} // namespace mlx::core
@@ -2,8 +2,10 @@
 
 #include "mlx/backend/cuda/device.h"
 #include "mlx/backend/cuda/device/binary_ops.cuh"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/device/reduce_ops.cuh"
+#include "mlx/backend/cuda/iterators/strided_iterator.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
-#include "mlx/backend/cuda/reduce/reduce_ops.cuh"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/primitives.h"
@@ -11,6 +13,8 @@
 #include <cooperative_groups.h>
 #include <cooperative_groups/scan.h>
 #include <nvtx3/nvtx3.hpp>
+#include <thrust/iterator/reverse_iterator.h>
+#include <cub/device/device_scan.cuh>
 
 #include <cassert>
 
@@ -317,8 +321,75 @@ __global__ void strided_scan(
   }
 }
 
+// The ops of reduce_ops.cuh have a non const call operator, cub calls its scan
+// op through a const reference.
+template <typename Op>
+struct DeviceScanOp {
+  template <typename U>
+  __device__ U operator()(const U& a, const U& b) const {
+    return Op{}(a, b);
+  }
+};
+
 } // namespace cu
 
+// The scan of a single row of at least this size runs on all the SMs instead
+// of in one block.
+constexpr int device_scan_min_size = 32768;
+
+// Scan the |axis_size| elements of |in|, which are |stride| apart, into the
+// contiguous |out| with the single pass decoupled look-back scan of cub. The
+// strided and reversed accesses go through iterators so |in| is not copied.
+template <typename T, typename U, typename Op, bool inclusive, bool reverse>
+void device_scan(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    int32_t axis_size,
+    int64_t stride) {
+  auto in_it = cu::make_cast_iterator<U>(
+      cu::strided_iterator(in.data<T>(), stride));
+  U* out_ptr = out.data<U>();
+  U init = cu::ReduceInit<Op, T>::value();
+  auto scan = [&](void* temp, size_t& size, auto first, auto result) {
+    if constexpr (inclusive) {
+      return cub::DeviceScan::InclusiveScan(
+          temp,
+          size,
+          first,
+          result,
+          cu::DeviceScanOp<Op>{},
+          axis_size,
+          encoder.stream());
+    } else {
+      return cub::DeviceScan::ExclusiveScan(
+          temp,
+          size,
+          first,
+          result,
+          cu::DeviceScanOp<Op>{},
+          init,
+          axis_size,
+          encoder.stream());
+    }
+  };
+  auto run = [&](auto first, auto result) {
+    size_t size;
+    CHECK_CUDA_ERROR(scan(nullptr, size, first, result));
+    void* temp = cu::ThrustAllocator(encoder).allocate(size);
+
+    // Start capturing after allocations
+    auto capture = encoder.capture_context();
+    CHECK_CUDA_ERROR(scan(temp, size, first, result));
+  };
+  if constexpr (reverse) {
+    run(thrust::make_reverse_iterator(in_it + axis_size),
+        thrust::make_reverse_iterator(out_ptr + axis_size));
+  } else {
+    run(in_it, out_ptr);
+  }
+}
+
 template <typename F>
 void dispatch_scan_ops(Scan::ReduceType scan_op, F&& f) {
   if (scan_op == Scan::ReduceType::Max) {
@@ -368,7 +439,14 @@ void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
   auto in = inputs[0];
   auto& s = stream();
 
-  if (in.flags().contiguous && in.strides()[axis_] != 0) {
+  // A single long row, possibly strided, is scanned by the whole device.
+  int32_t axis_size = in.shape(axis_);
+  bool device_wide = in.size() == static_cast<size_t>(axis_size) &&
+      axis_size >= device_scan_min_size;
+
+  if (device_wide) {
+    out.set_data(allocator::malloc(out.nbytes()));
+  } else if (in.flags().contiguous && in.strides()[axis_] != 0) {
     if (in.is_donatable() && in.itemsize() == out.itemsize()) {
       out.copy_shared_buffer(in);
     } else {
@@ -384,7 +462,6 @@ void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 
   constexpr int N_READS = 4;
-  int32_t axis_size = in.shape(axis_);
   bool contiguous = in.strides()[axis_] == 1;
 
   auto& encoder = cu::get_command_encoder(s);
@@ -399,7 +476,10 @@ void Scan::eval_gpu(const std::vector<array>& inputs, array& out) {
         using U = typename cu::ScanResult<Op, T>::type;
         dispatch_bool(inclusive_, [&](auto inclusive) {
           dispatch_bool(reverse_, [&](auto reverse) {
-            if (contiguous) {
+            if (device_wide) {
+              device_scan<T, U, Op, inclusive.value, reverse.value>(
+                  encoder, in, out, axis_size, in.strides()[axis_]);
+            } else if (contiguous) {
               auto kernel = cu::contiguous_scan<
                   T,
                   U,
@@ -1,6 +1,8 @@
 // Copyright © 2025 Apple Inc.
 
 #include "mlx/backend/common/slicing.h"
+#include "mlx/backend/cuda/copy/copy_batched.h"
+#include "mlx/backend/cuda/device.h"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/backend/gpu/slicing.h"
 
@@ -21,21 +23,74 @@ void concatenate_gpu(
   std::partial_sum(sizes.cbegin(), sizes.cend(), sizes.begin());
 
   out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
 
-  auto strides = out.strides();
-  auto flags = out.flags();
-  flags.row_contiguous = false;
-  flags.col_contiguous = false;
-  flags.contiguous = false;
-  // TODO: Handle concurrent outputs:
-  // https://github.com/ml-explore/mlx/pull/2145#discussion_r2070753816
+  // All the inputs are copied by one kernel.
+  std::vector<BatchedCopy> copies;
+  copies.reserve(inputs.size());
   for (int i = 0; i < inputs.size(); i++) {
-    array out_slice(inputs[i].shape(), out.dtype(), nullptr, {});
-    size_t data_offset = strides[axis] * sizes[i];
-    out_slice.copy_shared_buffer(
-        out, strides, flags, out_slice.size(), data_offset);
-    copy_gpu_inplace(inputs[i], out_slice, CopyType::GeneralGeneral, s);
+    copies.push_back(
+        {inputs[i],
+         0,
+         out.strides()[axis] * sizes[i],
+         inputs[i].shape(),
+         inputs[i].strides()});
+  }
+  copy_batched(cu::get_command_encoder(s), copies, out);
+}
+
+void pad_gpu(
+    const array& in,
+    const array& val,
+    array& out,
+    const std::vector<int>& axes,
+    const Shape& low_pad_size,
+    const Stream& s) {
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+
+  // The input is copied into the box [low, low + in.shape) of the output and
+  // the padding is split in disjoint boxes filled with |val|, all of them by
+  // one kernel: for the k-th padded axis the boxes before and after the
+  // input along it, spanning the input along the previous padded axes and
+  // the whole output along the others.
+  int ndim = out.ndim();
+  Shape low(ndim, 0);
+  for (int i = 0; i < axes.size(); i++) {
+    low[axes[i] < 0 ? ndim + axes[i] : axes[i]] = low_pad_size[i];
+  }
+  auto offset_of = [&](const Shape& start) {
+    int64_t offset = 0;
+    for (int i = 0; i < ndim; i++) {
+      offset += out.strides()[i] * start[i];
+    }
+    return offset;
+  };
+
+  std::vector<BatchedCopy> copies;
+  copies.push_back({in, 0, offset_of(low), in.shape(), in.strides()});
+  Shape start(ndim, 0);
+  Shape shape = out.shape();
+  Strides zeros(ndim, 0);
+  for (int ax : axes) {
+    ax = ax < 0 ? ndim + ax : ax;
+    // Before the input along ax.
+    shape[ax] = low[ax];
+    start[ax] = 0;
+    copies.push_back({val, 0, offset_of(start), shape, zeros});
+    // After the input along ax.
+    shape[ax] = out.shape(ax) - low[ax] - in.shape(ax);
+    start[ax] = low[ax] + in.shape(ax);
+    copies.push_back({val, 0, offset_of(start), shape, zeros});
+    // Along the next padded axes the boxes span the input along ax.
+    shape[ax] = in.shape(ax);
+    start[ax] = low[ax];
   }
+  copy_batched(cu::get_command_encoder(s), copies, out);
 }
 
 } // namespace mlx::core
@@ -4,6 +4,7 @@
 #include "mlx/backend/cuda/device/cast_op.cuh"
 #include "mlx/backend/cuda/device/fp16_math.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/online_softmax.cuh"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/primitives.h"
@@ -104,6 +105,38 @@ __global__ void softmax(const T* in, T* out, int axis_size) {
   }
 }
 
+// Write the softmax of a chunk of a row split by online_softmax_partials,
+// one block per chunk.
+template <typename T, int BLOCK_DIM, int N_READS = 4>
+__global__ void softmax_chunks(
+    const T* in,
+    const float2* partials,
+    T* out,
+    int axis_size,
+    int chunk_size) {
+  auto block = cg::this_thread_block();
+  int chunk = block.group_index().x;
+  int row = block.group_index().y;
+  float2 val =
+      merge_online_softmax_partials<BLOCK_DIM>(block, partials, row, gridDim.x);
+  float maxval = val.x;
+  float normalizer = 1 / val.y;
+
+  int size = min(chunk_size, axis_size - chunk * chunk_size);
+  int64_t offset = int64_t(row) * axis_size + int64_t(chunk) * chunk_size;
+  in += offset;
+  out += offset;
+  for (int r = 0; r < cuda::ceil_div(size, BLOCK_DIM * N_READS); r++) {
+    auto index = r * BLOCK_DIM + block.thread_rank();
+    T vals[N_READS];
+    cub::LoadDirectBlocked(index, in, vals, size);
+    for (int i = 0; i < N_READS; i++) {
+      vals[i] = softmax_exp(static_cast<float>(vals[i]) - maxval) * normalizer;
+    }
+    cub::StoreDirectBlocked(index, out, vals, size);
+  }
+}
+
 } // namespace cu
 
 void Softmax::eval_gpu(const std::vector<array>& inputs, array& out) {
@@ -138,6 +171,49 @@ void Softmax::eval_gpu(const std::vector<array>& inputs, array& out) {
   int n_rows = in.data_size() / axis_size;
 
   auto& encoder = cu::get_command_encoder(s);
+
+  // Split the rows across blocks when there are too few of them, each block
+  // reduces a chunk to a (max, sum) pair and the pairs are merged before
+  // writing the output.
+  int n_chunks = online_softmax_chunks(cu::device(s.device), n_rows, axis_size);
+  if (n_chunks > 1) {
+    int chunk_size = cuda::ceil_div(axis_size, n_chunks);
+    n_chunks = cuda::ceil_div(axis_size, chunk_size);
+    array partials({n_rows, n_chunks, 2}, float32, nullptr, {});
+    partials.set_data(allocator::malloc(partials.nbytes()));
+    encoder.add_temporary(partials);
+
+    dispatch_float_types(out.dtype(), "softmax", [&](auto type_tag) {
+      using DataType = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+      constexpr int N_READS = 4;
+      constexpr int BLOCK_DIM = 1024;
+      dim3 grid(n_chunks, n_rows);
+      encoder.set_input_array(in);
+      encoder.set_output_array(partials);
+      encoder.add_kernel_node(
+          cu::online_softmax_partials<DataType, BLOCK_DIM, N_READS>,
+          grid,
+          BLOCK_DIM,
+          in.data<DataType>(),
+          partials.data<float2>(),
+          axis_size,
+          chunk_size);
+      encoder.set_input_array(in);
+      encoder.set_input_array(partials);
+      encoder.set_output_array(out);
+      encoder.add_kernel_node(
+          cu::softmax_chunks<DataType, BLOCK_DIM, N_READS>,
+          grid,
+          BLOCK_DIM,
+          in.data<DataType>(),
+          partials.data<float2>(),
+          out.data<DataType>(),
+          axis_size,
+          chunk_size);
+    });
+    return;
+  }
+
   encoder.set_input_array(in);
   encoder.set_output_array(out);
   dispatch_float_types(out.dtype(), "softmax", [&](auto type_tag) {
@@ -2,14 +2,18 @@
 
 #include "mlx/backend/common/utils.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/utils.cuh"
 #include "mlx/backend/cuda/kernel_utils.cuh"
 #include "mlx/backend/gpu/copy.h"
 #include "mlx/dtype_utils.h"
 #include "mlx/primitives.h"
 
+#include <cooperative_groups.h>
 #include <nvtx3/nvtx3.hpp>
 #include <thrust/device_ptr.h>
 #include <thrust/transform.h>
+#include <cub/block/block_radix_sort.cuh>
+#include <cub/device/device_radix_sort.cuh>
 #include <cub/device/device_segmented_sort.cuh>
 
 #include <cassert>
@@ -17,6 +21,212 @@
 
 namespace mlx::core {
 
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+template <typename U>
+__device__ __forceinline__ U float_radix_key(U bits) {
+  constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+  return (bits & sign) ? U(~bits) : U(bits | sign);
+}
+
+// Map the values to unsigned integers with the same order, the floats are
+// ordered as in cub's radix sort.
+template <typename T>
+__device__ __forceinline__ auto radix_key(T x) {
+  if constexpr (std::is_same_v<T, bool>) {
+    return uint8_t(x);
+  } else if constexpr (std::is_same_v<T, __half>) {
+    return float_radix_key(__half_as_ushort(x));
+  } else if constexpr (std::is_same_v<T, __nv_bfloat16>) {
+    return float_radix_key(__bfloat16_as_ushort(x));
+  } else if constexpr (std::is_same_v<T, float>) {
+    return float_radix_key(__float_as_uint(x));
+  } else if constexpr (std::is_same_v<T, double>) {
+    return float_radix_key(static_cast<uint64_t>(__double_as_longlong(x)));
+  } else if constexpr (std::is_unsigned_v<T>) {
+    return x;
+  } else {
+    using U = std::make_unsigned_t<T>;
+    return U(U(x) ^ (U(1) << (sizeof(T) * 8 - 1)));
+  }
+}
+
+// Partition a row with a block. The key of the kth element is found with a
+// radix select, 8 bits at a time, and then the elements (or their indices)
+// less than, equal to and greater than it are written to their part of the
+// output. Each pass reads the row once, so the work is linear in the size of
+// the row.
+template <typename T, typename OutT, bool ARG_PARTITION, int BLOCK_DIM>
+__global__ void radix_partition(
+    const T* in,
+    OutT* out,
+    int axis_size,
+    int kth,
+    int64_t in_stride,
+    int64_t out_stride,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides in_strides,
+    const __grid_constant__ Strides out_strides,
+    int ndim) {
+  using Bits = decltype(radix_key(std::declval<T>()));
+  constexpr int RADIX_BITS = 8;
+  constexpr int RADIX = 1 << RADIX_BITS;
+
+  __shared__ int hist[RADIX];
+  __shared__ Bits prefix_shared;
+  __shared__ int k_shared;
+  __shared__ int counts[3];
+
+  auto block = cg::this_thread_block();
+  int tid = block.thread_rank();
+  int64_t row = cg::this_grid().block_rank();
+  in += elem_to_loc(row, shape.data(), in_strides.data(), ndim);
+  out += elem_to_loc(row, shape.data(), out_strides.data(), ndim);
+
+  // Find the key of the kth element from the most significant digit, after
+  // each pass |k| is the rank of the kth element among the elements with the
+  // digits found so far.
+  Bits prefix = 0;
+  Bits mask = 0;
+  int k = kth;
+  for (int shift = sizeof(Bits) * 8 - RADIX_BITS; shift >= 0;
+       shift -= RADIX_BITS) {
+    for (int i = tid; i < RADIX; i += BLOCK_DIM) {
+      hist[i] = 0;
+    }
+    block.sync();
+    for (int i = tid; i < axis_size; i += BLOCK_DIM) {
+      Bits key = radix_key(in[i * in_stride]);
+      if ((key & mask) == prefix) {
+        atomicAdd(&hist[(key >> shift) & (RADIX - 1)], 1);
+      }
+    }
+    block.sync();
+    if (tid == 0) {
+      int digit = 0;
+      while (k >= hist[digit]) {
+        k -= hist[digit++];
+      }
+      prefix_shared = prefix | (Bits(digit) << shift);
+      k_shared = k;
+    }
+    block.sync();
+    prefix = prefix_shared;
+    k = k_shared;
+    mask = mask | (Bits(RADIX - 1) << shift);
+  }
+
+  // The elements less than the kth one fill [0, kth - k), the equal ones
+  // follow them and the greater ones are written from the end.
+  int num_less = kth - k;
+  if (tid < 3) {
+    counts[tid] = 0;
+  }
+  block.sync();
+  int lane = tid % WARP_SIZE;
+  unsigned lane_mask_lt = (1u << lane) - 1;
+  for (int base = 0; base < axis_size; base += BLOCK_DIM) {
+    int i = base + tid;
+    T val;
+    int part = -1;
+    if (i < axis_size) {
+      val = in[i * in_stride];
+      Bits key = radix_key(val);
+      part = key < prefix ? 0 : (key == prefix ? 1 : 2);
+    }
+    // Reserve the output positions once per warp.
+    int pos = 0;
+#pragma unroll
+    for (int p = 0; p < 3; ++p) {
+      unsigned ballot = __ballot_sync(0xffffffff, part == p);
+      int start = 0;
+      if (lane == 0 && ballot) {
+        start = atomicAdd(&counts[p], __popc(ballot));
+      }
+      start = __shfl_sync(0xffffffff, start, 0);
+      if (part == p) {
+        pos = start + __popc(ballot & lane_mask_lt);
+      }
+    }
+    if (part == 1) {
+      pos += num_less;
+    } else if (part == 2) {
+      pos = axis_size - 1 - pos;
+    }
+    if (part >= 0) {
+      if constexpr (ARG_PARTITION) {
+        out[pos * out_stride] = i;
+      } else {
+        out[pos * out_stride] = val;
+      }
+    }
+  }
+}
+
+// Sort a row with a block, the row is read and written with its strides so
+// sorting along any axis needs no transposed copy. The radix keys of the
+// elements are sorted with their values, or their indices for an argsort.
+// The padding has the largest key, and the sort is stable, so it stays past
+// the end of the row.
+template <
+    typename T,
+    typename OutT,
+    bool ARG_SORT,
+    int BLOCK_DIM,
+    int N_PER_THREAD>
+__global__ void block_sort(
+    const T* in,
+    OutT* out,
+    int axis_size,
+    int64_t in_stride,
+    int64_t out_stride,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides in_strides,
+    const __grid_constant__ Strides out_strides,
+    int ndim) {
+  using Bits = decltype(radix_key(std::declval<T>()));
+  using BlockSortT = cub::BlockRadixSort<Bits, BLOCK_DIM, N_PER_THREAD, OutT>;
+  __shared__ typename BlockSortT::TempStorage temp;
+
+  auto block = cg::this_thread_block();
+  int64_t row = cg::this_grid().block_rank();
+  in += elem_to_loc(row, shape.data(), in_strides.data(), ndim);
+  out += elem_to_loc(row, shape.data(), out_strides.data(), ndim);
+
+  Bits keys[N_PER_THREAD];
+  OutT vals[N_PER_THREAD];
+#pragma unroll
+  for (int i = 0; i < N_PER_THREAD; ++i) {
+    int idx = block.thread_rank() * N_PER_THREAD + i;
+    if (idx < axis_size) {
+      T x = in[idx * in_stride];
+      keys[i] = radix_key(x);
+      if constexpr (ARG_SORT) {
+        vals[i] = idx;
+      } else {
+        vals[i] = x;
+      }
+    } else {
+      keys[i] = ~Bits(0);
+      vals[i] = OutT{};
+    }
+  }
+
+  BlockSortT(temp).SortBlockedToStriped(keys, vals);
+
+#pragma unroll
+  for (int i = 0; i < N_PER_THREAD; ++i) {
+    int idx = i * BLOCK_DIM + block.thread_rank();
+    if (idx < axis_size) {
+      out[idx * out_stride] = vals[i];
+    }
+  }
+}
+
+} // namespace cu
+
 namespace {
 
 template <typename T>
@@ -58,6 +268,61 @@ struct OffsetTransform {
   }
 };
 
+// The largest row a block sorts.
+constexpr int block_sort_max_size = 4096;
+
+void block_sort(
+    cu::CommandEncoder& encoder,
+    const array& in,
+    array& out,
+    int axis,
+    bool argsort) {
+  int axis_size = in.shape(axis);
+  Shape shape = remove_index(in.shape(), axis);
+  Strides in_strides = remove_index(in.strides(), axis);
+  Strides out_strides = remove_index(out.strides(), axis);
+  int64_t in_stride = in.strides(axis);
+  int64_t out_stride = out.strides(axis);
+  int ndim = shape.size();
+
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  dispatch_all_types(in.dtype(), [&](auto type_tag) {
+    using CTYPE = MLX_GET_TYPE(type_tag);
+    if constexpr (!std::is_same_v<CTYPE, complex64_t>) {
+      using T = cuda_type_t<CTYPE>;
+      dispatch_bool(argsort, [&](auto arg) {
+        using OutT = std::conditional_t<arg(), uint32_t, T>;
+        auto launch = [&](auto kernel, int block_dim) {
+          encoder.add_kernel_node(
+              kernel,
+              get_2d_grid_dims(shape, out_strides),
+              block_dim,
+              in.data<T>(),
+              out.data<OutT>(),
+              axis_size,
+              in_stride,
+              out_stride,
+              const_param(shape),
+              const_param(in_strides),
+              const_param(out_strides),
+              ndim);
+        };
+        if (axis_size <= 512) {
+          launch(cu::block_sort<T, OutT, arg(), 128, 4>, 128);
+        } else if (axis_size <= 2048) {
+          launch(cu::block_sort<T, OutT, arg(), 256, 8>, 256);
+        } else {
+          launch(cu::block_sort<T, OutT, arg(), 512, 8>, 512);
+        }
+      });
+    } else {
+      throw std::runtime_error(
+          "CUDA backend does not support sorting complex numbers");
+    }
+  });
+}
+
 void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
   array out = out_;
   auto& encoder = cu::get_command_encoder(s);
@@ -68,8 +333,16 @@ void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
   int last_dim = in.ndim() - 1;
 
   // If we are not sorting the innermost dimension of a contiguous array,
-  // transpose and make a copy.
+  // sort the rows which fit a block along their strides, otherwise transpose
+  // and make a copy.
   bool is_segmented_sort = in.flags().contiguous && in.strides()[axis] == 1;
+  if (!is_segmented_sort && nsort <= block_sort_max_size) {
+    out.set_data(allocator::malloc(out.nbytes()));
+    if (out.size() > 0) {
+      block_sort(encoder, in, out, axis, argsort);
+    }
+    return;
+  }
   if (!is_segmented_sort) {
     array trans = swapaxes_in_eval(in, axis, last_dim);
     in = contiguous_copy_gpu(trans, s);
@@ -84,6 +357,10 @@ void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
         in.flags());
   }
 
+  // The segmented sort runs poorly with a single huge segment, a single row
+  // goes through the device wide radix sort instead.
+  bool is_single_row = in.data_size() == nsort;
+
   encoder.set_input_array(in);
   encoder.set_output_array(out);
   dispatch_all_types(in.dtype(), [&](auto type_tag) {
@@ -91,6 +368,7 @@ void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
     auto& stream = encoder.stream();
     if constexpr (!std::is_same_v<CTYPE, complex64_t>) {
       using Type = cuda_type_t<CTYPE>;
+      bool radix_sort = is_single_row && !std::is_same_v<Type, bool>;
       auto offsets = thrust::make_transform_iterator(
           thrust::make_counting_iterator(0), OffsetTransform{nsort});
       if (argsort) {
@@ -103,72 +381,84 @@ void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
         array discard(allocator::malloc(in.nbytes()), in.shape(), in.dtype());
         encoder.add_temporary(discard);
 
+        auto sort_pairs = [&](void* temp, size_t& size) {
+          if (radix_sort) {
+            CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(
+                temp,
+                size,
+                in.data<Type>(),
+                discard.data<Type>(),
+                indices.data<uint32_t>(),
+                out.data<uint32_t>(),
+                in.data_size(),
+                0,
+                sizeof(Type) * 8,
+                stream));
+          } else {
+            CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortPairs(
+                temp,
+                size,
+                in.data<Type>(),
+                discard.data<Type>(),
+                indices.data<uint32_t>(),
+                out.data<uint32_t>(),
+                in.data_size(),
+                in.data_size() / nsort,
+                offsets,
+                offsets + 1,
+                stream));
+          }
+        };
+
         size_t size;
-        CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortPairs(
-            nullptr,
-            size,
-            in.data<Type>(),
-            discard.data<Type>(),
-            indices.data<uint32_t>(),
-            out.data<uint32_t>(),
-            in.data_size(),
-            in.data_size() / nsort,
-            offsets,
-            offsets + 1,
-            stream));
-
-        array temp(allocator::malloc(size), {static_cast<int>(size)}, uint8);
-        encoder.add_temporary(temp);
+        sort_pairs(nullptr, size);
+
+        void* temp = cu::ThrustAllocator(encoder).allocate(size);
 
         // Start capturing after allocations
         auto capture = encoder.capture_context();
         thrust::transform(
-            cu::thrust_policy(stream),
+            cu::thrust_policy(encoder),
             thrust::counting_iterator<uint32_t>(0),
             thrust::counting_iterator<uint32_t>(indices.data_size()),
             thrust::device_pointer_cast(indices.data<uint32_t>()),
             ModOp<uint32_t>{static_cast<uint32_t>(nsort)});
 
-        CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortPairs(
-            temp.data<void>(),
-            size,
-            in.data<Type>(),
-            discard.data<Type>(),
-            indices.data<uint32_t>(),
-            out.data<uint32_t>(),
-            in.data_size(),
-            in.data_size() / nsort,
-            offsets,
-            offsets + 1,
-            stream));
+        sort_pairs(temp, size);
       } else {
+        auto sort_keys = [&](void* temp, size_t& size) {
+          if (radix_sort) {
+            CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortKeys(
+                temp,
+                size,
+                in.data<Type>(),
+                out.data<Type>(),
+                in.data_size(),
+                0,
+                sizeof(Type) * 8,
+                stream));
+          } else {
+            CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortKeys(
+                temp,
+                size,
+                in.data<Type>(),
+                out.data<Type>(),
+                in.data_size(),
+                in.data_size() / nsort,
+                offsets,
+                offsets + 1,
+                stream));
+          }
+        };
+
         size_t size;
-        CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortKeys(
-            nullptr,
-            size,
-            in.data<Type>(),
-            out.data<Type>(),
-            in.data_size(),
-            in.data_size() / nsort,
-            offsets,
-            offsets + 1,
-            stream));
-
-        array temp(allocator::malloc(size), {static_cast<int>(size)}, uint8);
-        encoder.add_temporary(temp);
+        sort_keys(nullptr, size);
+
+        void* temp = cu::ThrustAllocator(encoder).allocate(size);
 
         // Start capturing after allocations
         auto capture = encoder.capture_context();
-        CHECK_CUDA_ERROR(cub::DeviceSegmentedSort::StableSortKeys(
-            temp.data<void>(),
-            size,
-            in.data<Type>(),
-            out.data<Type>(),
-            in.data_size(),
-            in.data_size() / nsort,
-            offsets,
-            offsets + 1,
-            stream));
+        sort_keys(temp, size);
       }
     } else {
       throw std::runtime_error(
@@ -183,6 +473,66 @@ void gpu_sort(const Stream& s, array in, array& out_, int axis, bool argsort) {
   }
 }
 
+void gpu_partition(
+    const Stream& s,
+    const array& in,
+    array& out,
+    int axis,
+    int kth,
+    bool arg_partition) {
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  if (axis < 0) {
+    axis += in.ndim();
+  }
+  int axis_size = in.shape(axis);
+  kth = kth < 0 ? kth + axis_size : kth;
+
+  // A block partitions a row and reads it with its strides, so there is no
+  // need for a contiguous copy.
+  Shape shape = remove_index(in.shape(), axis);
+  Strides in_strides = remove_index(in.strides(), axis);
+  Strides out_strides = remove_index(out.strides(), axis);
+  int64_t in_stride = in.strides(axis);
+  int64_t out_stride = out.strides(axis);
+  int ndim = shape.size();
+
+  auto& encoder = cu::get_command_encoder(s);
+  encoder.set_input_array(in);
+  encoder.set_output_array(out);
+  dispatch_all_types(in.dtype(), [&](auto type_tag) {
+    using CTYPE = MLX_GET_TYPE(type_tag);
+    if constexpr (!std::is_same_v<CTYPE, complex64_t>) {
+      using T = cuda_type_t<CTYPE>;
+      dispatch_bool(arg_partition, [&](auto arg) {
+        using OutT = std::conditional_t<arg(), uint32_t, T>;
+        dispatch_block_dim(std::min(axis_size, 256), [&](auto block_dim) {
+          auto kernel = cu::radix_partition<T, OutT, arg(), block_dim()>;
+          encoder.add_kernel_node(
+              kernel,
+              get_2d_grid_dims(shape, out_strides),
+              block_dim(),
+              in.data<T>(),
+              out.data<OutT>(),
+              axis_size,
+              kth,
+              in_stride,
+              out_stride,
+              const_param(shape),
+              const_param(in_strides),
+              const_param(out_strides),
+              ndim);
+        });
+      });
+    } else {
+      throw std::runtime_error(
+          "CUDA backend does not support partitioning complex numbers");
+    }
+  });
+}
+
 } // namespace
 
 void ArgSort::eval_gpu(const std::vector<array>& inputs, array& out) {
@@ -199,12 +549,14 @@ void Sort::eval_gpu(const std::vector<array>& inputs, array& out) {
 
 void ArgPartition::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("ArgPartition::eval_gpu");
-  gpu_sort(stream(), inputs[0], out, axis_, true);
+  assert(inputs.size() == 1);
+  gpu_partition(stream(), inputs[0], out, axis_, kth_, true);
 }
 
 void Partition::eval_gpu(const std::vector<array>& inputs, array& out) {
   nvtx3::scoped_range r("Partition::eval_gpu");
-  gpu_sort(stream(), inputs[0], out, axis_, false);
+  assert(inputs.size() == 1);
+  gpu_partition(stream(), inputs[0], out, axis_, kth_, false);
 }
 
 } // namespace mlx::core
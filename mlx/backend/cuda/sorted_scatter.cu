@@ -0,0 +1,296 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/common/utils.h"
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/device/cast_op.cuh"
+#include "mlx/backend/cuda/device/indexing.cuh"
+#include "mlx/backend/cuda/device/scatter_ops.cuh"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/cuda/sorted_scatter.h"
+#include "mlx/dtype_utils.h"
+
+#include <cooperative_groups.h>
+#include <cub/device/device_radix_sort.cuh>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+// The longest run of sorted keys a thread sums, the runs of the hot indices
+// are split in chunks which are added with atomics.
+constexpr uint32_t sorted_scatter_chunk = 256;
+
+// Write the key of each index, its location in the output, and its position.
+template <typename IdxT>
+__global__ void sorted_scatter_keys(
+    const IdxT* idx,
+    uint32_t* keys,
+    uint32_t* vals,
+    uint32_t size,
+    const __grid_constant__ Shape shape,
+    const __grid_constant__ Strides idx_strides,
+    const __grid_constant__ Strides key_strides,
+    int ndim,
+    int32_t axis_size,
+    int64_t axis_key_stride) {
+  uint32_t i = cg::this_grid().thread_rank();
+  if (i >= size) {
+    return;
+  }
+  auto [idx_loc, key_loc] = elem_to_loc_4d(
+      int64_t(i), shape.data(), idx_strides.data(), key_strides.data(), ndim);
+  int64_t index = absolute_index(idx[idx_loc], axis_size);
+  keys[i] = key_loc + index * axis_key_stride;
+  vals[i] = i;
+}
+
+// Sum the updates of the runs of equal sorted keys, a thread sums the slice
+// element x of the run which starts at y. The runs are written without
+// atomics unless they were split in chunks.
+template <typename T>
+__global__ void sorted_scatter_sum(
+    const T* upd,
+    T* out,
+    const uint32_t* keys,
+    const uint32_t* vals,
+    uint32_t num_keys,
+    int64_t key_stride,
+    int32_t slice_size,
+    const __grid_constant__ Shape slice_shape,
+    const __grid_constant__ Strides slice_strides,
+    int slice_ndim,
+    const __grid_constant__ Shape upd_shape,
+    const __grid_constant__ Strides upd_strides,
+    int upd_ndim) {
+  using AccT = cuda::std::conditional_t<(sizeof(T) < 4), float, T>;
+  auto block = cg::this_thread_block();
+  int64_t e = int64_t(block.group_index().y) * block.dim_threads().x +
+      block.thread_index().x;
+  uint32_t i =
+      block.group_index().x * block.dim_threads().y + block.thread_index().y;
+  if (i >= num_keys || e >= slice_size) {
+    return;
+  }
+  uint32_t key = keys[i];
+  bool first = i == 0 || keys[i - 1] != key;
+  if (!first && i % sorted_scatter_chunk != 0) {
+    return;
+  }
+
+  AccT acc = 0;
+  uint32_t j = i;
+  do {
+    int64_t upd_loc = elem_to_loc(
+        int64_t(vals[j]) * slice_size + e,
+        upd_shape.data(),
+        upd_strides.data(),
+        upd_ndim);
+    acc += cast_to<AccT>(upd[upd_loc]);
+    j++;
+  } while (j < num_keys && keys[j] == key && j % sorted_scatter_chunk != 0);
+
+  out += key * key_stride +
+      elem_to_loc(e, slice_shape.data(), slice_strides.data(), slice_ndim);
+  if (first && (j == num_keys || keys[j] != key)) {
+    *out = cast_to<T>(cast_to<AccT>(*out) + acc);
+  } else {
+    ScatterSum{}(out, cast_to<T>(acc));
+  }
+}
+
+} // namespace cu
+
+namespace {
+
+void sorted_scatter_sum_impl(
+    const array& upd,
+    const array& idx,
+    array& out,
+    const Strides& key_strides,
+    int32_t axis_size,
+    int64_t axis_key_stride,
+    uint32_t max_key,
+    int64_t key_stride,
+    const Shape& slice_shape,
+    const Strides& slice_strides,
+    cu::CommandEncoder& encoder) {
+  uint32_t num_keys = idx.size();
+  int32_t slice_size = 1;
+  for (auto n : slice_shape) {
+    slice_size *= n;
+  }
+  auto& stream = encoder.stream();
+  auto make_keys_array = [&]() {
+    array a(
+        allocator::malloc(num_keys * sizeof(uint32_t)),
+        {static_cast<int>(num_keys)},
+        uint32);
+    encoder.add_temporary(a);
+    return a;
+  };
+  array keys = make_keys_array();
+  array vals = make_keys_array();
+  array sorted_keys = make_keys_array();
+  array sorted_vals = make_keys_array();
+
+  encoder.set_input_array(idx);
+  encoder.set_output_array(keys);
+  encoder.set_output_array(vals);
+  dispatch_int_types(idx.dtype(), "sorted_scatter", [&](auto type_tag) {
+    using IdxT = MLX_GET_TYPE(type_tag);
+    constexpr int block_dim = 256;
+    encoder.add_kernel_node(
+        cu::sorted_scatter_keys<IdxT>,
+        cuda::ceil_div(num_keys, block_dim),
+        block_dim,
+        idx.data<IdxT>(),
+        keys.data<uint32_t>(),
+        vals.data<uint32_t>(),
+        num_keys,
+        const_param(idx.shape()),
+        const_param(idx.strides()),
+        const_param(key_strides),
+        int(idx.ndim()),
+        axis_size,
+        axis_key_stride);
+  });
+
+  // Only sort the bits the keys use.
+  int end_bit = 1;
+  while (end_bit < 32 && (max_key >> end_bit) != 0) {
+    end_bit++;
+  }
+  encoder.set_input_array(keys);
+  encoder.set_input_array(vals);
+  encoder.set_output_array(sorted_keys);
+  encoder.set_output_array(sorted_vals);
+  size_t size;
+  CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(
+      nullptr,
+      size,
+      keys.data<uint32_t>(),
+      sorted_keys.data<uint32_t>(),
+      vals.data<uint32_t>(),
+      sorted_vals.data<uint32_t>(),
+      num_keys,
+      0,
+      end_bit,
+      stream));
+  void* temp = cu::ThrustAllocator(encoder).allocate(size);
+  {
+    // Start capturing after allocations
+    auto capture = encoder.capture_context();
+    CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(
+        temp,
+        size,
+        keys.data<uint32_t>(),
+        sorted_keys.data<uint32_t>(),
+        vals.data<uint32_t>(),
+        sorted_vals.data<uint32_t>(),
+        num_keys,
+        0,
+        end_bit,
+        stream));
+  }
+
+  encoder.set_input_array(upd);
+  encoder.set_input_array(sorted_keys);
+  encoder.set_input_array(sorted_vals);
+  encoder.set_output_array(out);
+  dispatch_float_types(out.dtype(), "sorted_scatter", [&](auto type_tag) {
+    using T = cuda_type_t<MLX_GET_TYPE(type_tag)>;
+    // The threads of a warp sum contiguous slice elements when there are
+    // enough of them, the rest of the block goes through the runs.
+    int block_x = std::min(slice_size, 32);
+    int block_y = 256 / block_x;
+    dim3 num_blocks(
+        cuda::ceil_div(num_keys, block_y), cuda::ceil_div(slice_size, block_x));
+    encoder.add_kernel_node(
+        cu::sorted_scatter_sum<T>,
+        num_blocks,
+        dim3(block_x, block_y),
+        upd.data<T>(),
+        out.data<T>(),
+        sorted_keys.data<uint32_t>(),
+        sorted_vals.data<uint32_t>(),
+        num_keys,
+        key_stride,
+        slice_size,
+        const_param(slice_shape),
+        const_param(slice_strides),
+        int(slice_shape.size()),
+        const_param(upd.shape()),
+        const_param(upd.strides()),
+        int(upd.ndim()));
+  });
+}
+
+} // namespace
+
+bool use_sorted_scatter_sum(
+    const array& upd,
+    const array& out,
+    size_t num_keys) {
+  // Fewer indices rarely collide enough for the sort to pay off.
+  constexpr size_t min_num_keys = 4096;
+  if (out.dtype() != float32 && out.dtype() != float16 &&
+      out.dtype() != bfloat16) {
+    return false;
+  }
+  if (num_keys < min_num_keys || num_keys > INT32_MAX ||
+      out.size() > INT32_MAX) {
+    return false;
+  }
+  // The slice elements go in the y of the grid, 32 per block.
+  return upd.size() / num_keys <= 32 * 65535;
+}
+
+void sorted_scatter_sum(
+    const array& upd,
+    const array& idx,
+    array& out,
+    int axis,
+    cu::CommandEncoder& encoder) {
+  // The key is the index along the axis, and each key updates a slice.
+  int idx_ndim = idx.ndim();
+  Shape slice_shape(upd.shape().begin() + idx_ndim, upd.shape().end());
+  sorted_scatter_sum_impl(
+      upd,
+      idx,
+      out,
+      Strides(idx_ndim, 0),
+      out.shape(axis),
+      1,
+      out.shape(axis) - 1,
+      out.strides(axis),
+      slice_shape,
+      out.strides(),
+      encoder);
+}
+
+void sorted_scatter_axis_sum(
+    const array& upd,
+    const array& idx,
+    array& out,
+    int axis,
+    cu::CommandEncoder& encoder) {
+  // The key is the location in the output, and each key updates an element.
+  Strides key_strides = out.strides();
+  key_strides[axis] = 0;
+  sorted_scatter_sum_impl(
+      upd,
+      idx,
+      out,
+      key_strides,
+      out.shape(axis),
+      out.strides(axis),
+      out.size() - 1,
+      1,
+      {},
+      {},
+      encoder);
+}
+
+} // namespace mlx::core
@@ -0,0 +1,40 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include "mlx/array.h"
+
+namespace mlx::core {
+
+namespace cu {
+class CommandEncoder;
+}
+
+// Whether the scatter sum of |upd| at |num_keys| indices into |out| should
+// sort the indices instead of adding the updates with atomics, which
+// serialize on the repeated indices, e.g. the rows of the gradient of an
+// embedding.
+bool use_sorted_scatter_sum(
+    const array& upd,
+    const array& out,
+    size_t num_keys);
+
+// out[idx[i], ...] += upd[i, ...] along |axis| for a single index array, the
+// updates of each index are summed in sorted order and then written once.
+void sorted_scatter_sum(
+    const array& upd,
+    const array& idx,
+    array& out,
+    int axis,
+    cu::CommandEncoder& encoder);
+
+// The sorted version of the scatter sum of ScatterAxis, the updates of each
+// element of |out| are summed in sorted order and then written once.
+void sorted_scatter_axis_sum(
+    const array& upd,
+    const array& idx,
+    array& out,
+    int axis,
+    cu::CommandEncoder& encoder);
+
+} // namespace mlx::core
@@ -0,0 +1,173 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cusparse.h>
+#include <fmt/format.h>
+#include <nvtx3/nvtx3.hpp>
+
+namespace mlx::core {
+
+namespace cu {
+
+#define CHECK_CUSPARSE_ERROR(cmd) check_cusparse_error(#cmd, (cmd))
+
+void check_cusparse_error(const char* name, cusparseStatus_t err) {
+  if (err != CUSPARSE_STATUS_SUCCESS) {
+    throw std::runtime_error(fmt::format(
+        "{} failed with code: {} ({}).",
+        name,
+        static_cast<int>(err),
+        cusparseGetErrorString(err)));
+  }
+}
+
+cudaDataType_t sparse_data_type(Dtype dtype) {
+  switch (dtype) {
+    case float32:
+      return CUDA_R_32F;
+    case float64:
+      return CUDA_R_64F;
+    case float16:
+      return CUDA_R_16F;
+    case bfloat16:
+      return CUDA_R_16BF;
+    default:
+      throw std::invalid_argument(fmt::format(
+          "[SparseMatmul::eval_gpu] Unsupported type {}.",
+          dtype_to_string(dtype)));
+  }
+}
+
+} // namespace cu
+
+void SparseMatmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  nvtx3::scoped_range r("SparseMatmul::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+
+  assert(inputs.size() == 4);
+  out.set_data(allocator::malloc(out.nbytes()));
+  if (out.size() == 0) {
+    return;
+  }
+  auto ensure_row_contiguous = [&](const array& x) {
+    if (x.flags().row_contiguous) {
+      return x;
+    }
+    array x_copy = contiguous_copy_gpu(x, s);
+    encoder.add_temporary(x_copy);
+    return x_copy;
+  };
+  array indptr = ensure_row_contiguous(inputs[0]);
+  array indices = ensure_row_contiguous(inputs[1]);
+  array values = ensure_row_contiguous(inputs[2]);
+  array b = ensure_row_contiguous(inputs[3]);
+  if (values.size() == 0) {
+    array zero(0, out.dtype());
+    encoder.add_temporary(zero);
+    fill_gpu(zero, out, s);
+    return;
+  }
+
+  // The sparse matrix has M rows and K columns, it multiplies b from the
+  // left when not transposed and the rows of b otherwise.
+  int64_t M = indptr.size() - 1;
+  int64_t K = transpose_ ? out.shape(0) : b.shape(0);
+  int64_t N = out.shape(1);
+  auto type = cu::sparse_data_type(out.dtype());
+  // The half types are accumulated in float.
+  bool is_double = out.dtype() == float64;
+  auto compute_type = is_double ? CUDA_R_64F : CUDA_R_32F;
+  float alpha_f = 1, beta_f = 0;
+  double alpha_d = 1, beta_d = 0;
+  const void* alpha = is_double ? static_cast<const void*>(&alpha_d)
+                                : static_cast<const void*>(&alpha_f);
+  const void* beta = is_double ? static_cast<const void*>(&beta_d)
+                               : static_cast<const void*>(&beta_f);
+  auto op = transpose_ ? CUSPARSE_OPERATION_TRANSPOSE
+                       : CUSPARSE_OPERATION_NON_TRANSPOSE;
+
+  cusparseSpMatDescr_t mat_a;
+  cusparseDnMatDescr_t mat_b, mat_out;
+  CHECK_CUSPARSE_ERROR(cusparseCreateCsr(
+      &mat_a,
+      M,
+      K,
+      values.size(),
+      indptr.data<int32_t>(),
+      indices.data<int32_t>(),
+      values.data<void>(),
+      CUSPARSE_INDEX_32I,
+      CUSPARSE_INDEX_32I,
+      CUSPARSE_INDEX_BASE_ZERO,
+      type));
+  CHECK_CUSPARSE_ERROR(cusparseCreateDnMat(
+      &mat_b,
+      b.shape(0),
+      N,
+      N,
+      b.data<void>(),
+      type,
+      CUSPARSE_ORDER_ROW));
+  CHECK_CUSPARSE_ERROR(cusparseCreateDnMat(
+      &mat_out,
+      out.shape(0),
+      N,
+      N,
+      out.data<void>(),
+      type,
+      CUSPARSE_ORDER_ROW));
+
+  auto handle = cu::device(s.device).sparse_handle();
+  size_t workspace_size = 0;
+  CHECK_CUSPARSE_ERROR(cusparseSpMM_bufferSize(
+      handle,
+      op,
+      CUSPARSE_OPERATION_NON_TRANSPOSE,
+      alpha,
+      mat_a,
+      mat_b,
+      beta,
+      mat_out,
+      compute_type,
+      CUSPARSE_SPMM_ALG_DEFAULT,
+      &workspace_size));
+  array workspace(
+      {static_cast<int>(std::max<size_t>(workspace_size, 1))},
+      uint8,
+      nullptr,
+      {});
+  workspace.set_data(allocator::malloc(workspace.nbytes()));
+  encoder.add_temporary(workspace);
+
+  encoder.set_input_array(indptr);
+  encoder.set_input_array(indices);
+  encoder.set_input_array(values);
+  encoder.set_input_array(b);
+  encoder.set_output_array(out);
+  {
+    auto capture = encoder.capture_context();
+    CHECK_CUSPARSE_ERROR(cusparseSetStream(handle, encoder.stream()));
+    CHECK_CUSPARSE_ERROR(cusparseSpMM(
+        handle,
+        op,
+        CUSPARSE_OPERATION_NON_TRANSPOSE,
+        alpha,
+        mat_a,
+        mat_b,
+        beta,
+        mat_out,
+        compute_type,
+        CUSPARSE_SPMM_ALG_DEFAULT,
+        workspace.data<void>()));
+  }
+  CHECK_CUSPARSE_ERROR(cusparseDestroySpMat(mat_a));
+  CHECK_CUSPARSE_ERROR(cusparseDestroyDnMat(mat_b));
+  CHECK_CUSPARSE_ERROR(cusparseDestroyDnMat(mat_out));
+}
+
+} // namespace mlx::core
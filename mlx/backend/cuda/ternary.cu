@@ -166,16 +166,10 @@ void ternary_op_gpu_inplace(
     } else {
       dispatch_bool(out.data_size() > UINT32_MAX, [&](auto large) {
         using IdxT = std::conditional_t<large(), int64_t, uint32_t>;
-        // TODO: Choose optimized value based on type size.
-        constexpr int N_READS = 4;
+        constexpr int N_READS = 16 / sizeof(DType);
         auto kernel = cu::ternary_v<Op, DType, IdxT, N_READS>;
-        auto [num_blocks, block_dims] = get_launch_args(
-            kernel,
-            out.data_size(),
-            out.shape(),
-            out.strides(),
-            large(),
-            N_READS);
+        auto [num_blocks, block_dims] =
+            get_contiguous_launch_args(kernel, out, large(), N_READS);
         encoder.add_kernel_node(
             kernel,
             num_blocks,
@@ -128,16 +128,10 @@ void unary_op_gpu_inplace(
           using OutType = cuda_type_t<CTYPE_OUT>;
           if (contig) {
             using IdxT = std::conditional_t<large(), int64_t, uint32_t>;
-            // TODO: Choose optimized value based on type size.
-            constexpr int N_READS = 4;
+            constexpr int N_READS = 16 / sizeof(InType);
             auto kernel = cu::unary_v<Op, InType, OutType, IdxT, N_READS>;
-            auto [num_blocks, block_dims] = get_launch_args(
-                kernel,
-                out.data_size(),
-                out.shape(),
-                out.strides(),
-                large,
-                N_READS);
+            auto [num_blocks, block_dims] =
+                get_contiguous_launch_args(kernel, out, large, N_READS);
             encoder.add_kernel_node(
                 kernel,
                 num_blocks,
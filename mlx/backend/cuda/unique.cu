@@ -0,0 +1,270 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/backend/cuda/kernel_utils.cuh"
+#include "mlx/backend/gpu/copy.h"
+#include "mlx/dtype_utils.h"
+#include "mlx/primitives.h"
+
+#include <cooperative_groups.h>
+#include <cub/device/device_radix_sort.cuh>
+#include <cub/device/device_scan.cuh>
+#include <nvtx3/nvtx3.hpp>
+
+#include <optional>
+
+namespace mlx::core {
+
+namespace cu {
+
+namespace cg = cooperative_groups;
+
+constexpr int unique_block_dim = 256;
+
+__global__ void unique_iota(uint32_t* perm, int32_t size) {
+  int32_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    perm[i] = i;
+  }
+}
+
+// Flag the first value of each run of equal sorted values.
+template <typename T>
+__global__ void unique_flags(const T* sorted, int32_t* flags, int32_t size) {
+  int32_t i = cg::this_grid().thread_rank();
+  if (i < size) {
+    flags[i] = i == 0 || !(sorted[i] == sorted[i - 1]);
+  }
+}
+
+// The |runs| are the inclusive sums of the flags, so the run of the sorted
+// value i is runs[i] - 1. The first value of a run writes it and its start,
+// and the values past the last run repeat the largest value. The sorted
+// value i came from perm[i] which gets its run as inverse.
+template <typename T>
+__global__ void unique_scatter(
+    const T* sorted,
+    const uint32_t* perm,
+    const int32_t* runs,
+    T* values,
+    int32_t* num_unique,
+    int32_t* inverse,
+    int32_t* starts,
+    int32_t size) {
+  int32_t i = cg::this_grid().thread_rank();
+  if (i >= size) {
+    return;
+  }
+  int32_t run = runs[i] - 1;
+  int32_t num_runs = runs[size - 1];
+  if (i == 0 || runs[i - 1] != runs[i]) {
+    values[run] = sorted[i];
+    if (starts) {
+      starts[run] = i;
+    }
+  }
+  if (i >= num_runs) {
+    values[i] = sorted[size - 1];
+  }
+  if (inverse) {
+    inverse[perm[i]] = run;
+  }
+  if (i == size - 1) {
+    *num_unique = num_runs;
+  }
+}
+
+// The count of a run is the distance from its start to the next one.
+__global__ void unique_counts(
+    const int32_t* starts,
+    const int32_t* runs,
+    int32_t* counts,
+    int32_t size) {
+  int32_t i = cg::this_grid().thread_rank();
+  if (i >= size) {
+    return;
+  }
+  int32_t num_runs = runs[size - 1];
+  if (i < num_runs) {
+    int32_t end = i + 1 < num_runs ? starts[i + 1] : size;
+    counts[i] = end - starts[i];
+  } else {
+    counts[i] = 0;
+  }
+}
+
+} // namespace cu
+
+void Unique::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  nvtx3::scoped_range r("Unique::eval_gpu");
+  auto& s = stream();
+  auto& encoder = cu::get_command_encoder(s);
+  auto& stream = encoder.stream();
+
+  for (auto& out : outputs) {
+    out.set_data(allocator::malloc(out.nbytes()));
+  }
+  array in = inputs[0];
+  if (!in.flags().row_contiguous) {
+    in = contiguous_copy_gpu(in, s);
+    encoder.add_temporary(in);
+  }
+
+  // The values are sorted with their positions for the inverse, the flags
+  // of the first values of the runs are then summed into the runs and
+  // reused for the starts of the runs.
+  int32_t size = in.size();
+  auto make_temporary = [&](Dtype dtype) {
+    array a(allocator::malloc(size * size_of(dtype)), {size}, dtype);
+    encoder.add_temporary(a);
+    return a;
+  };
+  array sorted = make_temporary(in.dtype());
+  array flags = make_temporary(int32);
+  array runs = make_temporary(int32);
+  std::optional<array> perm;
+  std::optional<array> sorted_perm;
+  if (return_inverse_) {
+    perm = make_temporary(uint32);
+    sorted_perm = make_temporary(uint32);
+  }
+  array& values = outputs[0];
+  array& num_unique = outputs[1];
+  int32_t* inverse = return_inverse_ ? outputs[2].data<int32_t>() : nullptr;
+  int32_t* counts = return_counts_ ? outputs.back().data<int32_t>() : nullptr;
+  int num_blocks = cuda::ceil_div(size, cu::unique_block_dim);
+
+  dispatch_all_types(in.dtype(), [&](auto type_tag) {
+    using CTYPE = MLX_GET_TYPE(type_tag);
+    if constexpr (std::is_same_v<CTYPE, complex64_t>) {
+      throw std::invalid_argument("[Unique::eval_gpu] Unsupported type.");
+    } else {
+      // The radix sort takes the bools as bytes.
+      using T = cuda_type_t<CTYPE>;
+      using Key = std::conditional_t<std::is_same_v<T, bool>, uint8_t, T>;
+      const Key* keys = reinterpret_cast<const Key*>(in.data<T>());
+      Key* sorted_keys = reinterpret_cast<Key*>(sorted.data<T>());
+
+      if (return_inverse_) {
+        encoder.set_output_array(*perm);
+        encoder.add_kernel_node(
+            cu::unique_iota,
+            num_blocks,
+            cu::unique_block_dim,
+            perm->data<uint32_t>(),
+            size);
+        encoder.set_input_array(*perm);
+        encoder.set_output_array(*sorted_perm);
+      }
+      encoder.set_input_array(in);
+      encoder.set_output_array(sorted);
+      auto sort = [&](void* temp, size_t& temp_size) {
+        if (return_inverse_) {
+          CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortPairs(
+              temp,
+              temp_size,
+              keys,
+              sorted_keys,
+              perm->data<uint32_t>(),
+              sorted_perm->data<uint32_t>(),
+              size,
+              0,
+              sizeof(Key) * 8,
+              stream));
+        } else {
+          CHECK_CUDA_ERROR(cub::DeviceRadixSort::SortKeys(
+              temp,
+              temp_size,
+              keys,
+              sorted_keys,
+              size,
+              0,
+              sizeof(Key) * 8,
+              stream));
+        }
+      };
+      size_t sort_size;
+      sort(nullptr, sort_size);
+      void* sort_temp = cu::ThrustAllocator(encoder).allocate(sort_size);
+      {
+        // Start capturing after allocations
+        auto capture = encoder.capture_context();
+        sort(sort_temp, sort_size);
+      }
+
+      encoder.set_input_array(sorted);
+      encoder.set_output_array(flags);
+      encoder.add_kernel_node(
+          cu::unique_flags<Key>,
+          num_blocks,
+          cu::unique_block_dim,
+          sorted_keys,
+          flags.data<int32_t>(),
+          size);
+
+      encoder.set_input_array(flags);
+      encoder.set_output_array(runs);
+      size_t scan_size;
+      CHECK_CUDA_ERROR(cub::DeviceScan::InclusiveSum(
+          nullptr,
+          scan_size,
+          flags.data<int32_t>(),
+          runs.data<int32_t>(),
+          size,
+          stream));
+      void* scan_temp = cu::ThrustAllocator(encoder).allocate(scan_size);
+      {
+        auto capture = encoder.capture_context();
+        CHECK_CUDA_ERROR(cub::DeviceScan::InclusiveSum(
+            scan_temp,
+            scan_size,
+            flags.data<int32_t>(),
+            runs.data<int32_t>(),
+            size,
+            stream));
+      }
+
+      encoder.set_input_array(sorted);
+      encoder.set_input_array(runs);
+      if (return_inverse_) {
+        encoder.set_input_array(*sorted_perm);
+      }
+      for (auto& out : outputs) {
+        encoder.set_output_array(out);
+      }
+      if (counts) {
+        encoder.set_output_array(flags);
+      }
+      encoder.add_kernel_node(
+          cu::unique_scatter<Key>,
+          num_blocks,
+          cu::unique_block_dim,
+          sorted_keys,
+          return_inverse_ ? sorted_perm->data<uint32_t>() : nullptr,
+          runs.data<int32_t>(),
+          reinterpret_cast<Key*>(values.data<T>()),
+          num_unique.data<int32_t>(),
+          inverse,
+          counts ? flags.data<int32_t>() : nullptr,
+          size);
+      if (counts) {
+        // The starts of the runs were written in |flags| by the scatter.
+        encoder.set_input_array(flags);
+        encoder.set_input_array(runs);
+        encoder.set_output_array(outputs.back());
+        encoder.add_kernel_node(
+            cu::unique_counts,
+            num_blocks,
+            cu::unique_block_dim,
+            flags.data<int32_t>(),
+            runs.data<int32_t>(),
+            counts,
+            size);
+      }
+    }
+  });
+}
+
+} // namespace mlx::core
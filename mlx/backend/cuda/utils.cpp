@@ -3,20 +3,115 @@
 #include "mlx/backend/cuda/utils.h"
 #include "mlx/backend/cuda/device.h"
 #include "mlx/dtype_utils.h"
+#include "mlx/utils.h"
 
 #include <fmt/format.h>
 
+#include <algorithm>
+
 namespace mlx::core {
 
-CudaStream::CudaStream(cu::Device& device) {
+CudaStream::CudaStream(
+    cu::Device& device,
+    int priority /* = 0 */,
+    float sm_fraction /* = 1.0f */) {
   device.make_current();
-  CHECK_CUDA_ERROR(cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking));
+  if (priority == 0 && sm_fraction >= 1) {
+    CHECK_CUDA_ERROR(
+        cudaStreamCreateWithFlags(&stream_, cudaStreamNonBlocking));
+    return;
+  }
+  // CUDA runs the lower numbers first, from |greatest| to |least| which is
+  // the default of 0.
+  int least, greatest;
+  CHECK_CUDA_ERROR(cudaDeviceGetStreamPriorityRange(&least, &greatest));
+  int cuda_priority = std::clamp(-priority, greatest, least);
+#if CUDA_VERSION >= 12040
+  if (sm_fraction < 1) {
+    // The kernels and graphs launched in a stream of a green context only
+    // run on its SMs.
+    CUgreenCtx green_ctx = device.sm_partition(sm_fraction);
+    CUstream stream;
+    CHECK_CUDA_ERROR(cuGreenCtxStreamCreate(
+        &stream, green_ctx, CU_STREAM_NON_BLOCKING, cuda_priority));
+    stream_ = stream;
+    return;
+  }
+#endif
+  CHECK_CUDA_ERROR(cudaStreamCreateWithPriority(
+      &stream_, cudaStreamNonBlocking, cuda_priority));
 }
 
 CudaStream::~CudaStream() {
   CHECK_CUDA_ERROR(cudaStreamDestroy(stream_));
 }
 
+CudaGraphExec::CudaGraphExec(cudaGraph_t graph) {
+  CHECK_CUDA_ERROR(cudaGraphInstantiate(&exec_, graph, NULL, NULL, 0));
+}
+
+CudaGraphExec::~CudaGraphExec() {
+  // An executable still running is freed once it completes.
+  if (exec_) {
+    CHECK_CUDA_ERROR(cudaGraphExecDestroy(exec_));
+  }
+}
+
+bool CudaGraphExec::update(cudaGraph_t graph) {
+  cudaGraphExecUpdateResult update_result;
+#if CUDART_VERSION >= 12000
+  cudaGraphExecUpdateResultInfo info;
+  cudaGraphExecUpdate(exec_, graph, &info);
+  update_result = info.result;
+#else
+  cudaGraphNode_t error_node;
+  cudaGraphExecUpdate(exec_, graph, &error_node, &update_result);
+#endif // CUDART_VERSION >= 12000
+  if (update_result != cudaGraphExecUpdateSuccess) {
+    cudaGetLastError(); // reset error
+    return false;
+  }
+  return true;
+}
+
+#if CUDART_VERSION >= 13000
+namespace {
+
+cudaMemLocation mem_location(int device) {
+  cudaMemLocation location = {};
+  if (device == cudaCpuDeviceId) {
+    location.type = cudaMemLocationTypeHost;
+  } else {
+    location.type = cudaMemLocationTypeDevice;
+    location.id = device;
+  }
+  return location;
+}
+
+} // namespace
+#endif // CUDART_VERSION >= 13000
+
+cudaError_t mem_prefetch_async(
+    void* data,
+    size_t size,
+    int device,
+    cudaStream_t stream) {
+#if CUDART_VERSION >= 13000
+  return cudaMemPrefetchAsync(data, size, mem_location(device), 0, stream);
+#else
+  return cudaMemPrefetchAsync(data, size, device, stream);
+#endif // CUDART_VERSION >= 13000
+}
+
+cudaError_t
+mem_advise(void* data, size_t size, cudaMemoryAdvise advice, int device) {
+#if CUDART_VERSION >= 13000
+  return cudaMemAdvise(data, size, advice, mem_location(device));
+#else
+  return cudaMemAdvise(data, size, advice, device);
+#endif // CUDART_VERSION >= 13000
+}
+
 void check_cuda_error(const char* name, cudaError_t err) {
   if (err != cudaSuccess) {
     throw std::runtime_error(
@@ -32,6 +127,14 @@ void check_cuda_error(const char* name, CUresult err) {
   }
 }
 
+void check_cublas_error(const char* name, cublasStatus_t err) {
+  if (err != CUBLAS_STATUS_SUCCESS) {
+    // TODO: Use cublasGetStatusString when it is widely available.
+    throw std::runtime_error(
+        fmt::format("{} failed with code: {}.", name, static_cast<int>(err)));
+  }
+}
+
 const char* dtype_to_cuda_type(const Dtype& dtype) {
   switch (dtype) {
     case bool_:
@@ -67,4 +170,39 @@ const char* dtype_to_cuda_type(const Dtype& dtype) {
   }
 }
 
+cublasComputeType_t cublas_compute_type(
+    const Dtype& dtype,
+    MatmulPrecision precision) {
+  switch (dtype) {
+    case float16:
+      return precision == MatmulPrecision::Float16 ? CUBLAS_COMPUTE_16F
+                                                   : CUBLAS_COMPUTE_32F;
+    case bfloat16:
+      return CUBLAS_COMPUTE_32F;
+    case float32:
+      switch (precision) {
+        case MatmulPrecision::Default:
+          return env::enable_tf32() ? CUBLAS_COMPUTE_32F_FAST_TF32
+                                    : CUBLAS_COMPUTE_32F;
+        case MatmulPrecision::Float32:
+          return CUBLAS_COMPUTE_32F;
+        case MatmulPrecision::TF32:
+          return CUBLAS_COMPUTE_32F_FAST_TF32;
+        case MatmulPrecision::BFloat16:
+          return CUBLAS_COMPUTE_32F_FAST_16BF;
+        case MatmulPrecision::Float16:
+          return CUBLAS_COMPUTE_32F_FAST_16F;
+      }
+      return CUBLAS_COMPUTE_32F;
+    case float64:
+    case complex64:
+      return CUBLAS_COMPUTE_64F;
+    case int32:
+      return CUBLAS_COMPUTE_32I;
+    default:
+      throw std::runtime_error(fmt::format(
+          "Unsupported dtype in MatMul: {}.", dtype_to_string(dtype)));
+  }
+}
+
 } // namespace mlx::core
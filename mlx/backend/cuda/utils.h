@@ -4,9 +4,12 @@
 
 #pragma once
 
+#include <cublasLt.h>
 #include <cuda.h>
 #include <cuda_runtime.h>
 
+#include <utility>
+
 namespace mlx::core {
 
 namespace cu {
@@ -14,11 +17,17 @@ class Device;
 }
 
 struct Dtype;
+enum class MatmulPrecision;
 
-// Cuda stream managed with RAII.
+// Cuda stream managed with RAII. The |priority| is the one of an MLX stream,
+// the higher the more urgent, clamped to the range of the device. With an
+// |sm_fraction| below 1 the stream runs on a partition of the SMs.
 class CudaStream {
  public:
-  explicit CudaStream(cu::Device& device);
+  explicit CudaStream(
+      cu::Device& device,
+      int priority = 0,
+      float sm_fraction = 1.0f);
   ~CudaStream();
 
   CudaStream(const CudaStream&) = delete;
@@ -32,6 +41,48 @@ class CudaStream {
   cudaStream_t stream_;
 };
 
+// Cuda graph executable managed with RAII.
+class CudaGraphExec {
+ public:
+  // Instantiate an executable of |graph|.
+  explicit CudaGraphExec(cudaGraph_t graph);
+  ~CudaGraphExec();
+
+  CudaGraphExec(CudaGraphExec&& other) : exec_(other.exec_) {
+    other.exec_ = nullptr;
+  }
+  CudaGraphExec& operator=(CudaGraphExec&& other) {
+    std::swap(exec_, other.exec_);
+    return *this;
+  }
+  CudaGraphExec(const CudaGraphExec&) = delete;
+  CudaGraphExec& operator=(const CudaGraphExec&) = delete;
+
+  // Update the executable in place to run |graph|, returns false when the
+  // topology of |graph| is different and the executable is unchanged.
+  bool update(cudaGraph_t graph);
+
+  operator cudaGraphExec_t() const {
+    return exec_;
+  }
+
+ private:
+  cudaGraphExec_t exec_;
+};
+
+// Prefetch the managed memory to |device|, or to the host when it is
+// cudaCpuDeviceId, with the signature of the CUDA version.
+cudaError_t mem_prefetch_async(
+    void* data,
+    size_t size,
+    int device,
+    cudaStream_t stream);
+
+// Advise the driver about the managed memory for |device|, or for the host
+// when it is cudaCpuDeviceId.
+cudaError_t
+mem_advise(void* data, size_t size, cudaMemoryAdvise advice, int device);
+
 // Throw exception if the cuda API does not succeed.
 void check_cuda_error(const char* name, cudaError_t err);
 void check_cuda_error(const char* name, CUresult err);
@@ -39,7 +90,17 @@ void check_cuda_error(const char* name, CUresult err);
 // The macro version that prints the command that failed.
 #define CHECK_CUDA_ERROR(cmd) check_cuda_error(#cmd, (cmd))
 
+// Throw exception if the cublas API does not succeed.
+void check_cublas_error(const char* name, cublasStatus_t err);
+
+#define CHECK_CUBLAS_ERROR(cmd) check_cublas_error(#cmd, (cmd))
+
 // Convert Dtype to CUDA C++ types.
 const char* dtype_to_cuda_type(const Dtype& dtype);
 
+// The compute type of the cublas matmuls of |dtype| with |precision|.
+cublasComputeType_t cublas_compute_type(
+    const Dtype& dtype,
+    MatmulPrecision precision);
+
 } // namespace mlx::core
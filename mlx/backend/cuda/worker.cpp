@@ -3,11 +3,13 @@
 #include "mlx/backend/cuda/worker.h"
 #include "mlx/backend/cuda/allocator.h"
 #include "mlx/backend/cuda/device.h"
+#include "mlx/utils.h"
 
 namespace mlx::core::cu {
 
-Worker::Worker()
-    : signal_stream_(device(mlx::core::Device::gpu)),
+Worker::Worker(int priority /* = 0 */)
+    : use_host_func_(env::get_var("MLX_CUDA_HOST_FUNC_COMPLETION", 0)),
+      signal_stream_(device(mlx::core::Device::gpu), priority),
       worker_(&Worker::thread_fn, this) {}
 
 Worker::~Worker() {
@@ -52,6 +54,13 @@ void Worker::commit(cudaStream_t stream) {
     return;
   }
   uncommited_batches_ = 0;
+  if (use_host_func_) {
+    // The host functions of |stream| run in order, so the worker is woken up
+    // with the batches signaled so far, which are run together.
+    auto* data = new std::pair<Worker*, uint64_t>(this, batch_);
+    CHECK_CUDA_ERROR(cudaLaunchHostFunc(stream, &signal_from_host, data));
+    return;
+  }
   // Signal the |worker_event_| in |signal_stream_| after the kernels in
   // |stream_| finish running.
   signal_event_.record(stream);
@@ -59,6 +68,14 @@ void Worker::commit(cudaStream_t stream) {
   worker_event_.signal(signal_stream_, batch_);
 }
 
+void Worker::signal_from_host(void* data) {
+  // No CUDA API can be called in a host function, the tasks that free memory
+  // are run in the worker thread.
+  auto* signal = static_cast<std::pair<Worker*, uint64_t>*>(data);
+  signal->first->worker_event_.signal(signal->second);
+  delete signal;
+}
+
 void Worker::thread_fn() {
   // The worker thread is safe to free buffers.
   allocator().register_this_thread();
@@ -81,10 +98,14 @@ void Worker::thread_fn() {
       worker_tasks_.erase(worker_tasks_.begin(), end);
     }
     // Make sure tasks are cleared before the next wait
+    auto start = std::chrono::steady_clock::now();
     for (int i = 0; i < tasks.size(); ++i) {
       auto task = std::move(tasks[i]);
       task();
     }
+    if (!tasks.empty()) {
+      dispatch_stats().retire_ns += elapsed_ns(start);
+    }
     worker_event_.wait(batch + 1);
   }
 }
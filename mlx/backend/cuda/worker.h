@@ -15,7 +15,9 @@ namespace mlx::core::cu {
 // Run tasks in worker thread, synchronized with cuda stream.
 class Worker {
  public:
-  Worker();
+  // The worker is signaled from a CUDA stream of |priority|, the one of the
+  // stream it runs the tasks of.
+  explicit Worker(int priority = 0);
   ~Worker();
 
   Worker(const Worker&) = delete;
@@ -35,6 +37,11 @@ class Worker {
 
   // Inform worker thread to run current batches after kernels in |stream|
   // finish running.
+  //
+  // By default the worker is signaled from |signal_stream_| after an event
+  // recorded in |stream|. With MLX_CUDA_HOST_FUNC_COMPLETION set it is
+  // signaled by a host function launched in |stream| instead, which saves the
+  // event and the cross-stream wait of each commit.
   void commit(cudaStream_t stream);
 
   // Return how many batches have been added but not committed yet.
@@ -44,10 +51,13 @@ class Worker {
 
  private:
   void thread_fn();
+  static void signal_from_host(void* data);
 
   uint64_t batch_{0};
   size_t uncommited_batches_{0};
 
+  bool use_host_func_;
+
   // Cuda stream and event for signaling kernel completion.
   CudaStream signal_stream_;
   CudaEvent signal_event_;
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <functional>
 #include <future>
 #include <memory>
 
@@ -12,7 +13,19 @@ namespace mlx::core::gpu {
 
 void new_stream(Stream stream);
 void eval(array& arr);
+
+// Whether the GPU backend implements |p|.
+bool is_supported(Primitive& p);
+
+// Move the memory of |arr|, computed on the GPU, to the host for the CPU
+// primitives using it.
+void prefetch_to_host(const array& arr);
+
 void finalize(Stream s);
 void synchronize(Stream s);
 
+// Call |handler| once the work enqueued in |s| so far is done, from the
+// thread which completes the GPU work. The work of |s| is committed.
+void add_completed_handler(Stream s, std::function<void()> handler);
+
 } // namespace mlx::core::gpu
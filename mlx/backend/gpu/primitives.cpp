@@ -127,6 +127,13 @@ void Flatten::eval_gpu(const std::vector<array>& inputs, array& out) {
   reshape(inputs[0], out, stream());
 }
 
+void HostCallback::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[HostCallback::eval_gpu] Host callbacks run on a CPU stream.");
+}
+
 void NumberOfElements::eval_gpu(const std::vector<array>& inputs, array& out) {
   MLX_PROFILER_RANGE("NumberOfElements::eval_gpu");
   eval(inputs, out);
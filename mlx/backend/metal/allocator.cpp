@@ -3,6 +3,7 @@
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/resident.h"
 #include "mlx/memory.h"
+#include "mlx/utils.h"
 
 #include <mach/vm_page_size.h>
 #include <unistd.h>
@@ -41,7 +42,8 @@ MetalAllocator::MetalAllocator()
               residency_set_.erase(buf);
             }
             buf->release();
-          }) {
+          },
+          env::max_cache_overallocation() / 100.0) {
   auto pool = metal::new_scoped_memory_pool();
   auto memsize = std::get<size_t>(device_info().at("memory_size"));
   auto max_rec_size =
@@ -63,6 +65,7 @@ MetalAllocator::MetalAllocator()
   heap_ = device_->newHeap(heap_desc);
   heap_desc->release();
   residency_set_.insert(heap_);
+  max_heap_memory_ = block_limit_ / 8;
 }
 
 MetalAllocator::~MetalAllocator() {
@@ -71,6 +74,60 @@ MetalAllocator::~MetalAllocator() {
     heap_->release();
   }
   buffer_cache_.clear();
+  for (auto& tier : heap_tiers_) {
+    for (auto heap : tier.heaps) {
+      heap->release();
+    }
+  }
+}
+
+MTL::Buffer* MetalAllocator::heap_malloc_(size_t size) {
+  for (auto& tier : heap_tiers_) {
+    if (size > tier.max_size) {
+      continue;
+    }
+    for (auto heap : tier.heaps) {
+      if (heap->maxAvailableSize(vm_page_size) >= size) {
+        if (auto buf = heap->newBuffer(size, resource_options); buf) {
+          return buf;
+        }
+      }
+    }
+
+    // All the heaps of the tier are full so add one
+    if (heap_memory_ + tier.heap_size > max_heap_memory_) {
+      return nullptr;
+    }
+    auto heap_desc = MTL::HeapDescriptor::alloc()->init();
+    heap_desc->setResourceOptions(resource_options);
+    heap_desc->setSize(tier.heap_size);
+    auto heap = device_->newHeap(heap_desc);
+    heap_desc->release();
+    if (!heap) {
+      return nullptr;
+    }
+    tier.heaps.push_back(heap);
+    heap_memory_ += tier.heap_size;
+    residency_set_.insert(heap);
+    return heap->newBuffer(size, resource_options);
+  }
+  return nullptr;
+}
+
+void MetalAllocator::release_empty_heaps_() {
+  for (auto& tier : heap_tiers_) {
+    auto it = tier.heaps.begin();
+    while (it != tier.heaps.end()) {
+      if ((*it)->usedSize() == 0) {
+        residency_set_.erase(*it);
+        (*it)->release();
+        heap_memory_ -= tier.heap_size;
+        it = tier.heaps.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
 }
 
 size_t MetalAllocator::set_cache_limit(size_t limit) {
@@ -142,6 +199,9 @@ Buffer MetalAllocator::malloc(size_t size) {
           << ") exceeded.";
       throw std::runtime_error(msg.str());
     }
+    if (size >= small_size_ && size <= medium_size_ && heap_) {
+      buf = heap_malloc_(size);
+    }
     lk.unlock();
     if (size < small_size_ && heap_) {
       buf = heap_->newBuffer(size, resource_options);
@@ -176,6 +236,7 @@ void MetalAllocator::clear_cache() {
   std::unique_lock lk(mutex_);
   auto pool = metal::new_scoped_memory_pool();
   num_resources_ -= buffer_cache_.clear();
+  release_empty_heaps_();
 }
 
 void MetalAllocator::free(Buffer buffer) {
@@ -245,5 +306,43 @@ size_t get_cache_memory() {
 void clear_cache() {
   return metal::allocator().clear_cache();
 }
+std::unordered_map<std::string, size_t> get_cache_info() {
+  auto stats = metal::allocator().get_cache_stats();
+  return {
+      {"hits", stats.hits},
+      {"misses", stats.misses},
+      {"evictions", stats.evictions},
+      {"requested_bytes", stats.requested_bytes},
+      {"reused_bytes", stats.reused_bytes}};
+}
+void reset_cache_info() {
+  metal::allocator().reset_cache_stats();
+}
+
+// A single device of each type.
+size_t get_active_memory(Device) {
+  return get_active_memory();
+}
+size_t get_peak_memory(Device) {
+  return get_peak_memory();
+}
+void reset_peak_memory(Device) {
+  reset_peak_memory();
+}
+size_t get_cache_memory(Device) {
+  return get_cache_memory();
+}
+size_t set_memory_limit(size_t limit, Device) {
+  return set_memory_limit(limit);
+}
+size_t get_memory_limit(Device) {
+  return get_memory_limit();
+}
+size_t set_cache_limit(size_t limit, Device) {
+  return set_cache_limit(limit);
+}
+void clear_cache(Device) {
+  clear_cache();
+}
 
 } // namespace mlx::core
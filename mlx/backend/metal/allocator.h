@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <mutex>
 #include <vector>
@@ -34,6 +35,14 @@ class MetalAllocator : public allocator::Allocator {
   size_t get_cache_memory() {
     return buffer_cache_.cache_size();
   };
+  BufferCacheStats get_cache_stats() {
+    std::unique_lock lk(mutex_);
+    return buffer_cache_.stats();
+  };
+  void reset_cache_stats() {
+    std::unique_lock lk(mutex_);
+    buffer_cache_.reset_stats();
+  };
   size_t set_cache_limit(size_t limit);
   size_t set_memory_limit(size_t limit);
   size_t get_memory_limit();
@@ -48,7 +57,25 @@ class MetalAllocator : public allocator::Allocator {
   // the heap, a heap can have at most heap.size() / 256 buffers.
   static constexpr int small_size_ = 256;
   static constexpr int heap_size_ = 1 << 20;
-  MTL::Heap* heap_;
+  MTL::Heap* heap_{nullptr};
+
+  // Medium allocations go on heaps of their size class, which are added as
+  // needed up to max_heap_memory_. The heaps are made resident once rather
+  // than each of their buffers and new buffers are sub-allocated from them.
+  struct HeapTier {
+    size_t max_size;
+    size_t heap_size;
+    std::vector<MTL::Heap*> heaps;
+  };
+  static constexpr size_t medium_size_ = 1 << 22;
+  std::array<HeapTier, 2> heap_tiers_{
+      HeapTier{1 << 18, 1 << 23, {}},
+      HeapTier{medium_size_, 1 << 26, {}}};
+  size_t heap_memory_{0};
+  size_t max_heap_memory_{0};
+  MTL::Buffer* heap_malloc_(size_t size);
+  void release_empty_heaps_();
+
   MetalAllocator();
   ~MetalAllocator();
   friend MetalAllocator& allocator();
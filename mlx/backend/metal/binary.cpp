@@ -214,7 +214,19 @@ void binary_op_gpu(
   binary_op_gpu(inputs, out, op, s);
 }
 
-BINARY_GPU(Add)
+void Add::eval_gpu(const std::vector<array>& inputs, array& out) {
+  if (!inplace_) {
+    binary_op_gpu(inputs, out, name());
+    return;
+  }
+  auto& a = inputs[0];
+  auto& b = inputs[1];
+  check_inplace_binary_op(a, out, "add_inplace");
+  auto bopt = get_binary_op_type(a, b);
+  set_binary_op_output_data(a, b, out, bopt, /* inplace = */ true);
+  binary_op_gpu_inplace(inputs, out, name(), out.primitive().stream());
+}
+
 BINARY_GPU(ArcTan2)
 BINARY_GPU(Divide)
 BINARY_GPU_MULTI(DivMod)
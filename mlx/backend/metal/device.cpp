@@ -1,5 +1,8 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <sys/sysctl.h>
+#include <unistd.h>
+
 #include <cstdlib>
 #include <sstream>
 
@@ -12,6 +15,7 @@
 #include "mlx/backend/metal/metal.h"
 #include "mlx/backend/metal/utils.h"
 #include "mlx/utils.h"
+#include "mlx/version.h"
 
 namespace mlx::core::metal {
 
@@ -107,6 +111,36 @@ std::pair<MTL::Library*, NS::Error*> load_swiftpm_library(
   return {nullptr, nullptr};
 }
 
+// The directory of the binary archives, with one archive per GPU and OS
+// build since the compiled pipelines are specific to both.
+const std::filesystem::path& binary_archive_dir() {
+  static std::filesystem::path cache = []() -> std::filesystem::path {
+    std::filesystem::path cache;
+    if (auto c = std::getenv("MLX_METAL_CACHE_DIR"); c) {
+      cache = c;
+    } else {
+      cache =
+          std::filesystem::temp_directory_path() / "mlx" / version() / "metal";
+    }
+    std::error_code error;
+    std::filesystem::create_directories(cache, error);
+    if (error) {
+      return std::filesystem::path();
+    }
+    return cache;
+  }();
+  return cache;
+}
+
+std::string os_build() {
+  char build[64] = {0};
+  size_t length = sizeof(build) - 1;
+  if (sysctlbyname("kern.osversion", build, &length, NULL, 0) != 0) {
+    return "unknown";
+  }
+  return build;
+}
+
 MTL::Library* load_default_library(MTL::Device* device) {
   NS::Error* error[4];
   MTL::Library* lib;
@@ -318,10 +352,15 @@ Device::Device() {
   }
   max_ops_per_buffer_ = env::max_ops_per_buffer(max_ops_per_buffer_);
   max_mb_per_buffer_ = env::max_mb_per_buffer(max_mb_per_buffer_);
+  load_binary_archive_();
 }
 
 Device::~Device() {
   auto pool = new_scoped_memory_pool();
+  save_binary_archive();
+  if (binary_archive_) {
+    binary_archive_->release();
+  }
   for (auto& [l, kernel_map] : library_kernels_) {
     l->release();
     for (auto& [_, k] : kernel_map) {
@@ -490,6 +529,51 @@ MTL::Library* Device::get_library(
   return new_lib;
 }
 
+void Device::load_binary_archive_() {
+  if (!env::metal_binary_archive() || binary_archive_dir().empty()) {
+    return;
+  }
+  binary_archive_path_ =
+      binary_archive_dir() / (arch_ + "_" + os_build() + ".metallib");
+
+  // Start from an empty archive if there is none or it can not be read, for
+  // instance after a driver update.
+  auto desc = MTL::BinaryArchiveDescriptor::alloc()->init();
+  NS::Error* error = nullptr;
+  if (std::filesystem::exists(binary_archive_path_)) {
+    auto path = NS::String::string(
+        binary_archive_path_.c_str(), NS::UTF8StringEncoding);
+    desc->setUrl(NS::URL::fileURLWithPath(path));
+    binary_archive_ = device_->newBinaryArchive(desc, &error);
+    desc->setUrl(nullptr);
+  }
+  if (!binary_archive_) {
+    binary_archive_ = device_->newBinaryArchive(desc, &error);
+  }
+  desc->release();
+}
+
+void Device::save_binary_archive() {
+  std::unique_lock wlock(kernel_mtx_);
+  if (!binary_archive_ || !binary_archive_dirty_) {
+    return;
+  }
+  auto pool = new_scoped_memory_pool();
+
+  // Write to a temporary file and rename it so that concurrent processes
+  // never read a partial archive.
+  auto tmp_path = binary_archive_path_;
+  tmp_path += "." + std::to_string(getpid()) + ".tmp";
+  auto path = NS::String::string(tmp_path.c_str(), NS::UTF8StringEncoding);
+  NS::Error* error = nullptr;
+  if (binary_archive_->serializeToURL(
+          NS::URL::fileURLWithPath(path), &error)) {
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, binary_archive_path_, ec);
+    binary_archive_dirty_ = false;
+  }
+}
+
 MTL::Library* Device::build_library_(const std::string& source_string) {
   auto pool = new_scoped_memory_pool();
 
@@ -597,7 +681,7 @@ MTL::ComputePipelineState* Device::get_kernel_(
     const MTL::Function* mtl_function,
     const MTL::LinkedFunctions* linked_functions) {
   // Check inputs
-  if (!linked_functions) {
+  if (!linked_functions && !binary_archive_) {
     return get_kernel_(name, mtl_function);
   }
 
@@ -610,12 +694,32 @@ MTL::ComputePipelineState* Device::get_kernel_(
   // Prepare compute pipeline state descriptor
   auto desc = MTL::ComputePipelineDescriptor::alloc()->init();
   desc->setComputeFunction(mtl_function);
-  desc->setLinkedFunctions(linked_functions);
+  if (linked_functions) {
+    desc->setLinkedFunctions(linked_functions);
+  }
 
   // Compile kernel to compute pipeline
   NS::Error* error = nullptr;
-  auto kernel = device_->newComputePipelineState(
-      desc, MTL::PipelineOptionNone, nullptr, &error);
+  MTL::ComputePipelineState* kernel = nullptr;
+  if (binary_archive_) {
+    // Load the pipeline from the archive, or on a miss compile it into the
+    // archive first so that it is only compiled once.
+    desc->setBinaryArchives(NS::Array::array(binary_archive_));
+    kernel = device_->newComputePipelineState(
+        desc, MTL::PipelineOptionFailOnBinaryArchiveMiss, nullptr, &error);
+    if (!kernel) {
+      error = nullptr;
+      if (binary_archive_->addComputePipelineFunctions(desc, &error)) {
+        binary_archive_dirty_ = true;
+      }
+    }
+  }
+  if (!kernel) {
+    error = nullptr;
+    kernel = device_->newComputePipelineState(
+        desc, MTL::PipelineOptionNone, nullptr, &error);
+  }
+  desc->release();
 
   // Throw error if unable to compile metal function
   if (!kernel) {
@@ -3,6 +3,7 @@
 #pragma once
 
 #include <Metal/Metal.hpp>
+#include <filesystem>
 #include <functional>
 #include <mutex>
 #include <shared_mutex>
@@ -207,6 +208,9 @@ class Device {
 
   void set_residency_set(const MTL::ResidencySet* residency_set);
 
+  // Write the pipelines compiled since the binary archive was loaded.
+  void save_binary_archive();
+
  private:
   DeviceStream& get_stream_(int index) {
     return stream_map_.find(index)->second;
@@ -236,6 +240,8 @@ class Device {
       const MTL::Function* mtl_function,
       const MTL::LinkedFunctions* linked_functions);
 
+  void load_binary_archive_();
+
   MTL::ComputePipelineState* get_kernel_(
       const std::string& base_name,
       MTL::Library* mtl_lib,
@@ -255,6 +261,10 @@ class Device {
       std::unordered_map<std::string, MTL::ComputePipelineState*>>
       library_kernels_;
   const MTL::ResidencySet* residency_set_{nullptr};
+  // The compiled pipelines cached on disk across processes.
+  MTL::BinaryArchive* binary_archive_{nullptr};
+  std::filesystem::path binary_archive_path_;
+  bool binary_archive_dirty_{false};
   std::string arch_;
   int arch_gen_;
   int max_ops_per_buffer_;
@@ -99,4 +99,25 @@ void synchronize(Stream s) {
   cb->release();
 }
 
+bool is_supported(Primitive&) {
+  return true;
+}
+
+// The memory is shared with the host.
+void prefetch_to_host(const array&) {}
+
+void add_completed_handler(Stream s, std::function<void()> handler) {
+  auto pool = metal::new_scoped_memory_pool();
+  auto& d = metal::device(s.device);
+  auto cb = d.get_command_buffer(s.index);
+  d.end_encoding(s.index);
+  cb->addCompletedHandler(
+      [handler = std::move(handler)](MTL::CommandBuffer* cbuf) {
+        check_error(cbuf);
+        handler();
+      });
+  d.commit_command_buffer(s.index);
+  d.get_command_buffer(s.index);
+}
+
 } // namespace mlx::core::gpu
@@ -595,4 +595,8 @@ void ScatterAxis::eval_gpu(const std::vector<array>& inputs, array& out) {
   compute_encoder.dispatch_threads(grid_dims, group_dims);
 }
 
+void BinCount::eval_gpu(const std::vector<array>& inputs, array& out) {
+  throw std::runtime_error("[BinCount::eval_gpu] Metal bincount NYI.");
+}
+
 } // namespace mlx::core
@@ -64,6 +64,16 @@ struct DivOp {
   }
 };
 
+// The first key of the causal window of the query at position p, the sinks
+// before it are still seen.
+METAL_FUNC int window_start(const constant AttnParams* params, int p) {
+  if (params->window_size == 0) {
+    return 0;
+  }
+  int w = params->window_size;
+  return params->chunked ? p / w * w : max(0, p - w + 1);
+}
+
 // clang-format off
 template <
     typename T,
@@ -233,15 +243,29 @@ template <
   }
 
   int kb_lim = params->NK;
+  // The first block of the window of the first query of the block, the
+  // blocks between the sinks and it are skipped.
+  int kb_win = 0;
 
   if (do_causal) {
     int q_max = (tid.x + 1) * BQ + params->qL_off;
     kb_lim = (q_max + BK - 1) / BK;
     kb_lim = min(params->NK, kb_lim);
+    if (params->window_size > 0) {
+      int q_min = tid.x * BQ + params->qL_off;
+      kb_win = window_start(params, q_min) / BK;
+    }
   }
 
   // Loop over KV seq length
   for (int kb = 0; kb < kb_lim; kb++) {
+    if (kb * BK >= params->num_sinks && kb < kb_win) {
+      for (; kb < kb_win; kb++) {
+        loader_k.next();
+        loader_v.next();
+      }
+    }
+
     // Load K block and apply scale
     threadgroup_barrier(mem_flags::mem_threadgroup);
     if (!align_K && kb == (params->NK_aligned)) {
@@ -291,7 +315,9 @@ template <
     }
 
     // Mask out if causal
-    if (do_causal && kb >= (kb_lim - ((BQ + BK - 1) / BK) - int(!align_K))) {
+    if (do_causal &&
+        (params->window_size > 0 ||
+         kb >= (kb_lim - ((BQ + BK - 1) / BK) - int(!align_K)))) {
       using stile_t = decltype(Stile);
       using selem_t = typename stile_t::elem_type;
       constexpr auto neg_inf = Limits<selem_t>::finite_min;
@@ -305,7 +331,10 @@ template <
           const int col_pos = kb * BK + sn + (j * stile_t::kFragCols);
           STEEL_PRAGMA_UNROLL
           for (short jj = 0; jj < stile_t::MMAFrag_t::kElemCols; jj++) {
-            if (row_pos < (col_pos + jj)) {
+            const int col = col_pos + jj;
+            if (row_pos < col ||
+                (col >= params->num_sinks &&
+                 col < window_start(params, row_pos))) {
               Stile.frag_at(i, j)[jj] = neg_inf;
             }
           }
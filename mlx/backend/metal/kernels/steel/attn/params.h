@@ -34,6 +34,10 @@ struct AttnParams {
   int64_t K_strides[3]; ///< Key    strides (B, H, L, D = 1)
   int64_t V_strides[3]; ///< Value  strides (B, H, L, D = 1)
   int64_t O_strides[3]; ///< Output strides (B, H, L, D = 1)
+
+  int window_size; ///< Causal window size, 0 for no window
+  int num_sinks; ///< Keys seen besides the window
+  int chunked; ///< Whether the window is a chunk
 };
 
 struct AttnMaskParams {
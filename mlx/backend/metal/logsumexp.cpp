@@ -5,6 +5,7 @@
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 
 namespace mlx::core {
@@ -92,4 +93,21 @@ void LogSumExp::eval_gpu(const std::vector<array>& inputs, array& out) {
   }
 }
 
+bool fast::CrossEntropy::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::CrossEntropy::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[CrossEntropy::eval_gpu] Metal cross entropy NYI.");
+}
+
+void fast::CrossEntropyVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[CrossEntropyVJP::eval_gpu] Metal cross entropy NYI.");
+}
+
 } // namespace mlx::core
@@ -14,6 +14,7 @@
 #include "mlx/backend/metal/kernels/steel/gemm/params.h"
 #include "mlx/backend/metal/matmul.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
 
@@ -2022,4 +2023,30 @@ void SegmentedMM::eval_gpu(const std::vector<array>& inputs, array& out) {
   segmented_mm(a, b, segments, out, M, N, K, d, s);
 }
 
+void SparseMatmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  throw std::runtime_error("[SparseMatmul::eval_gpu] Metal sparse matmul NYI.");
+}
+
+void fast::FusedMatmul::eval_gpu(
+    const std::vector<array>& inputs,
+    array& out) {
+  throw std::runtime_error("[FusedMatmul::eval_gpu] Metal fused matmul NYI.");
+}
+
+bool fast::Fp8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  return true;
+}
+
+void fast::Fp8Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  throw std::runtime_error("[Fp8Matmul::eval_gpu] Metal fp8 matmul NYI.");
+}
+
+bool fast::Int8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  return true;
+}
+
+void fast::Int8Matmul::eval_gpu(const std::vector<array>& inputs, array& out) {
+  throw std::runtime_error("[Int8Matmul::eval_gpu] Metal int8 matmul NYI.");
+}
+
 } // namespace mlx::core
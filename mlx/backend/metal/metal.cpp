@@ -49,6 +49,10 @@ void stop_capture() {
   manager->stopCapture();
 }
 
+void save_binary_archive() {
+  device(mlx::core::Device::gpu).save_binary_archive();
+}
+
 const std::unordered_map<std::string, std::variant<std::string, size_t>>&
 device_info() {
   auto init_device_info = []()
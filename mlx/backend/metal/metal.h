@@ -15,6 +15,14 @@ bool is_available();
 void start_capture(std::string path = "");
 void stop_capture();
 
+/**
+ * Write the pipelines compiled so far to the binary archive on disk, which
+ * is loaded at startup so that later processes skip their compilation. The
+ * archive is also written at exit. It lives in MLX_METAL_CACHE_DIR and is
+ * disabled with MLX_METAL_BINARY_ARCHIVE=0.
+ */
+void save_binary_archive();
+
 /** Get information about the GPU and system settings. */
 const std::unordered_map<std::string, std::variant<std::string, size_t>>&
 device_info();
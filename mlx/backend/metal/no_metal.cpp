@@ -15,6 +15,7 @@ bool is_available() {
 
 void start_capture(std::string) {}
 void stop_capture() {}
+void save_binary_archive() {}
 
 const std::unordered_map<std::string, std::variant<std::string, size_t>>&
 device_info() {
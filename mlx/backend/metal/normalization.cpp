@@ -435,4 +435,25 @@ void LayerNormVJP::eval_gpu(
   }
 }
 
+bool AddRMSNorm::use_fallback(Stream s) {
+  return true;
+}
+
+void AddRMSNorm::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[AddRMSNorm::eval_gpu] Metal add rms norm NYI.");
+}
+
+bool AddLayerNorm::use_fallback(Stream s) {
+  return true;
+}
+
+void AddLayerNorm::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[AddLayerNorm::eval_gpu] Metal add layer norm NYI.");
+}
+
 } // namespace mlx::core::fast
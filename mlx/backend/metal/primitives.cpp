@@ -12,6 +12,7 @@
 #include "mlx/backend/metal/device.h"
 #include "mlx/backend/metal/kernels.h"
 #include "mlx/backend/metal/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
 #include "mlx/scheduler.h"
 #include "mlx/utils.h"
@@ -256,6 +257,113 @@ void RandomBits::eval_gpu(const std::vector<array>& inputs, array& out) {
   compute_encoder.dispatch_threads(grid_dims, group_dims);
 }
 
+bool fast::RandomDistribution::use_fallback(Stream s) {
+  return true;
+}
+
+void fast::RandomDistribution::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[RandomDistribution::eval_gpu] Metal random distributions NYI.");
+}
+
+bool fast::SampleTopKTopP::use_fallback(Stream s) {
+  return true;
+}
+
+void fast::SampleTopKTopP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[SampleTopKTopP::eval_gpu] Metal sampling NYI.");
+}
+
+bool fast::StochasticRound::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::StochasticRound::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[StochasticRound::eval_gpu] Metal NYI.");
+}
+
+bool fast::OptimizerStep::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::OptimizerStep::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[OptimizerStep::eval_gpu] Metal NYI.");
+}
+
+bool fast::GatedActivation::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::GatedActivation::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[GatedActivation::eval_gpu] Metal NYI.");
+}
+
+void fast::GatedActivationVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[GatedActivationVJP::eval_gpu] Metal NYI.");
+}
+
+bool fast::MoERoute::use_fallback(int num_experts, int k, Stream s) {
+  return true;
+}
+
+void fast::MoERoute::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[MoERoute::eval_gpu] Metal NYI.");
+}
+
+bool fast::ArgReduceWithValue::use_fallback(Stream s) {
+  return true;
+}
+
+void fast::ArgReduceWithValue::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[ArgReduceWithValue::eval_gpu] Metal NYI.");
+}
+
+bool fast::QuantizedEmbedding::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::QuantizedEmbedding::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[QuantizedEmbedding::eval_gpu] Metal NYI.");
+}
+
+bool fast::Moments::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+void fast::Moments::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[Moments::eval_gpu] Metal NYI.");
+}
+
+bool fast::ConvolutionVJP::use_fallback(Stream s) {
+  return true;
+}
+
+void fast::ConvolutionVJP::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[ConvolutionVJP::eval_gpu] Metal NYI.");
+}
+
 void DynamicSlice::eval_gpu(const std::vector<array>& inputs, array& out) {
   if (out.size() == 0) {
     out.set_data(nullptr);
@@ -998,4 +998,15 @@ void fast::AffineQuantize::eval_gpu(
   compute_encoder.dispatch_threads(grid_dims, group_dims);
 }
 
+bool fast::BlockScaledQuantize::use_fallback(Stream s) {
+  return true;
+}
+
+void fast::BlockScaledQuantize::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[BlockScaledQuantize::eval_gpu] Metal block scaled quantization NYI.");
+}
+
 } // namespace mlx::core
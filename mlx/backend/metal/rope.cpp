@@ -7,8 +7,8 @@ namespace mlx::core::fast {
 
 constexpr int n_per_thread = 4;
 
-bool RoPE::use_fallback(Stream s) {
-  return s.device == Device::cpu;
+bool RoPE::use_fallback(Stream s, bool per_position) {
+  return s.device == Device::cpu || per_position;
 }
 
 void RoPE::eval_gpu(
@@ -119,4 +119,14 @@ void RoPE::eval_gpu(
   compute_encoder.dispatch_threads(grid_dims, group_dims);
 }
 
+bool RoPEQKV::use_fallback(Stream s) {
+  return true;
+}
+
+void RoPEQKV::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[RoPEQKV::eval_gpu] Metal RoPEQKV NYI.");
+}
+
 } // namespace mlx::core::fast
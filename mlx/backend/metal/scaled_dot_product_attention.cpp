@@ -22,7 +22,10 @@ void sdpa_full_self_attention_metal(
     const float scale,
     array& o,
     bool do_causal_ = false,
-    const std::optional<array>& mask = std::nullopt) {
+    const std::optional<array>& mask = std::nullopt,
+    int window_size = 0,
+    int num_sinks = 0,
+    bool chunked = false) {
   using namespace mlx::steel;
 
   int wm = 4;
@@ -106,7 +109,11 @@ void sdpa_full_self_attention_metal(
       /* int64_t Q_strides[3] = */ {q.strides(0), q.strides(1), q.strides(2)},
       /* int64_t K_strides[3] = */ {k.strides(0), k.strides(1), k.strides(2)},
       /* int64_t V_strides[3] = */ {v.strides(0), v.strides(1), v.strides(2)},
-      /* int64_t O_strides[3] = */ {o.strides(0), o.strides(1), o.strides(2)}};
+      /* int64_t O_strides[3] = */ {o.strides(0), o.strides(1), o.strides(2)},
+
+      /* int window_size = */ window_size,
+      /* int num_sinks = */ num_sinks,
+      /* int chunked = */ chunked};
 
   compute_encoder.set_input_array(q, 0);
   compute_encoder.set_input_array(k, 1);
@@ -346,8 +353,10 @@ bool ScaledDotProductAttention::use_fallback(
     bool has_mask,
     bool has_arr_mask,
     bool do_causal,
+    bool has_window,
+    bool has_tree,
     Stream s) {
-  if (detail::in_grad_tracing()) {
+  if (detail::in_grad_tracing() || has_tree) {
     return true;
   }
   if (s.device == Device::cpu) {
@@ -372,9 +381,10 @@ bool ScaledDotProductAttention::use_fallback(
   const bool supports_sdpa_full = query_sequence_length > 8 &&
       sdpa_full_supported_mask && sdpa_full_supported_head_dim;
 
+  // The windows are only skipped by the full attention.
   const bool supports_sdpa_vector = (query_sequence_length <= 8) &&
       (query_sequence_length <= key_sequence_length) &&
-      sdpa_vector_supported_head_dim;
+      sdpa_vector_supported_head_dim && !has_window;
 
   return !(supports_sdpa_full || supports_sdpa_vector);
 }
@@ -507,10 +517,87 @@ void ScaledDotProductAttention::eval_gpu(
         ? std::optional<array>{copy_unless(is_matrix_contiguous, inputs[3])}
         : std::nullopt;
 
-    sdpa_full_self_attention_metal(s, d, q, k, v, scale_, o, do_causal_, mask);
+    sdpa_full_self_attention_metal(
+        s,
+        d,
+        q,
+        k,
+        v,
+        scale_,
+        o,
+        do_causal_,
+        mask,
+        window_size_,
+        num_sinks_,
+        chunked_);
   }
 
   d.add_temporaries(std::move(copies), s.index);
 }
 
+bool QuantizedScaledDotProductAttention::use_fallback(
+    const array& q,
+    const array& k,
+    bool has_arr_mask,
+    bool do_causal,
+    int group_size,
+    int bits,
+    Stream s) {
+  return true;
+}
+
+void QuantizedScaledDotProductAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[QuantizedScaledDotProductAttention::eval_gpu] Metal "
+      "QuantizedScaledDotProductAttention NYI.");
+}
+
+bool QuantizedKVWrite::use_fallback(int group_size, int bits, Stream s) {
+  return true;
+}
+
+void QuantizedKVWrite::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[QuantizedKVWrite::eval_gpu] Metal QuantizedKVWrite NYI.");
+}
+
+bool PagedKVWrite::use_fallback(Stream s) {
+  return true;
+}
+
+void PagedKVWrite::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[PagedKVWrite::eval_gpu] Metal PagedKVWrite NYI.");
+}
+
+bool PagedAttention::use_fallback(
+    const array& q,
+    const array& k_pages,
+    Stream s) {
+  return true;
+}
+
+void PagedAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[PagedAttention::eval_gpu] Metal PagedAttention NYI.");
+}
+
+bool VarlenAttention::use_fallback(const array& q, const array& v, Stream s) {
+  return true;
+}
+
+void VarlenAttention::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error(
+      "[VarlenAttention::eval_gpu] Metal VarlenAttention NYI.");
+}
+
 } // namespace mlx::core::fast
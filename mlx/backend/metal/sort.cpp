@@ -365,4 +365,10 @@ void Partition::eval_gpu(const std::vector<array>& inputs, array& out) {
   gpu_merge_sort(s, d, in, out, axis_, false);
 }
 
+void Unique::eval_gpu(
+    const std::vector<array>& inputs,
+    std::vector<array>& outputs) {
+  throw std::runtime_error("[Unique::eval_gpu] Metal unique NYI.");
+}
+
 } // namespace mlx::core
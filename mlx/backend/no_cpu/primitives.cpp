@@ -33,6 +33,7 @@ NO_CPU(ArgReduce)
 NO_CPU(ArgSort)
 NO_CPU(AsType)
 NO_CPU(AsStrided)
+NO_CPU(BinCount)
 NO_CPU(BitwiseBinary)
 NO_CPU(BitwiseInvert)
 NO_CPU(BlockMaskedMM)
@@ -74,6 +75,7 @@ NO_CPU(GatherQMM)
 NO_CPU(Greater)
 NO_CPU(GreaterEqual)
 NO_CPU(Hadamard)
+NO_CPU_MULTI(HostCallback)
 NO_CPU(Imag)
 NO_CPU(Less)
 NO_CPU(LessEqual)
@@ -114,6 +116,7 @@ NO_CPU(Slice)
 NO_CPU(SliceUpdate)
 NO_CPU(Softmax)
 NO_CPU(Sort)
+NO_CPU(SparseMatmul)
 NO_CPU_MULTI(Split)
 NO_CPU(Square)
 NO_CPU(Squeeze)
@@ -125,16 +128,21 @@ NO_CPU(Tan)
 NO_CPU(Tanh)
 NO_CPU(Transpose)
 NO_CPU(Unflatten)
+NO_CPU_MULTI(Unique)
 NO_CPU(Inverse)
 NO_CPU(View)
 
 namespace fast {
 NO_CPU_MULTI(AffineQuantize)
+NO_CPU_MULTI(QuantizedEmbedding)
+NO_CPU_MULTI(Moments)
 } // namespace fast
 
 namespace distributed {
 NO_CPU_MULTI(AllReduce)
 NO_CPU_MULTI(AllGather)
+NO_CPU_MULTI(ReduceScatter)
+NO_CPU_MULTI(AllToAll)
 NO_CPU_MULTI(Send)
 NO_CPU_MULTI(Recv)
 } // namespace distributed
@@ -1,9 +1,20 @@
 // Copyright © 2023 Apple Inc.
 
 #include <algorithm>
+#include <cstdint>
 #include <mutex>
 
 #include "mlx/allocator.h"
+#include "mlx/backend/common/buffer_cache.h"
+#include "mlx/backend/common/numa.h"
+#include "mlx/memory.h"
+#include "mlx/utils.h"
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <unistd.h>
+#define MLX_CPU_MMAP
+#endif
 
 #ifdef __APPLE__
 #include "mlx/backend/no_gpu/apple_memory.h"
@@ -19,12 +30,128 @@ namespace mlx::core {
 
 namespace allocator {
 
+namespace {
+
+// The header in front of the data of each buffer.
+struct alignas(16) Block {
+  // The bytes requested for the buffer, and the bytes it can hold.
+  size_t size;
+  size_t capacity;
+  // The length of the mapping of the block, 0 for a block from malloc.
+  size_t mapped;
+  // Right after the header, or the memory of the owner of an external
+  // block which is allocated on its own.
+  void* data;
+  bool external;
+};
+
+constexpr size_t huge_page_size = 2 << 20;
+
+// The buffers from which the blocks are mapped, the smaller ones come from
+// malloc.
+constexpr size_t min_map_size = 1 << 18;
+
+size_t page_size() {
+#ifdef MLX_CPU_MMAP
+  static size_t page = sysconf(_SC_PAGESIZE);
+  return page;
+#else
+  return 4096;
+#endif
+}
+
+#ifdef MLX_CPU_MMAP
+// Map |length| bytes from explicit huge pages, or with the mappings larger
+// than a huge page aligned to one for the transparent huge pages to back
+// them.
+void* map_block(size_t& length) {
+  constexpr int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_HUGETLB
+  if (env::cpu_hugetlb()) {
+    size_t huge_length =
+        (length + huge_page_size - 1) / huge_page_size * huge_page_size;
+    void* ptr = mmap(
+        nullptr,
+        huge_length,
+        PROT_READ | PROT_WRITE,
+        flags | MAP_HUGETLB,
+        -1,
+        0);
+    if (ptr != MAP_FAILED) {
+      length = huge_length;
+      return ptr;
+    }
+  }
+#endif
+  if (length < huge_page_size) {
+    void* ptr = mmap(nullptr, length, PROT_READ | PROT_WRITE, flags, -1, 0);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  }
+  void* ptr = mmap(
+      nullptr, length + huge_page_size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (ptr == MAP_FAILED) {
+    return nullptr;
+  }
+  auto begin = reinterpret_cast<uintptr_t>(ptr);
+  auto aligned = (begin + huge_page_size - 1) / huge_page_size * huge_page_size;
+  if (aligned > begin) {
+    munmap(ptr, aligned - begin);
+  }
+  size_t tail = begin + huge_page_size - aligned;
+  if (tail > 0) {
+    munmap(reinterpret_cast<void*>(aligned + length), tail);
+  }
+  ptr = reinterpret_cast<void*>(aligned);
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, length, MADV_HUGEPAGE);
+#endif
+  return ptr;
+}
+#endif
+
+Block* new_block(size_t size) {
+  size_t length = sizeof(Block) + size;
+  void* ptr = nullptr;
+  size_t mapped = 0;
+#ifdef MLX_CPU_MMAP
+  if (size >= min_map_size) {
+    length = (length + page_size() - 1) / page_size() * page_size();
+    ptr = map_block(length);
+    mapped = length;
+  }
+#endif
+  if (mapped == 0) {
+    ptr = std::malloc(length);
+  }
+  if (ptr == nullptr) {
+    return nullptr;
+  }
+  // The pages are placed before the header touches the first one.
+  numa::place(ptr, length);
+  auto block = static_cast<Block*>(ptr);
+  *block = Block{size, length - sizeof(Block), mapped, block + 1, false};
+  return block;
+}
+
+void free_block(Block* block) {
+#ifdef MLX_CPU_MMAP
+  if (block->mapped) {
+    munmap(block, block->mapped);
+    return;
+  }
+#endif
+  std::free(block);
+}
+
+} // namespace
+
 class CommonAllocator : public Allocator {
-  /** A general CPU allocator. */
+  /** A general CPU allocator caching the freed buffers. */
  public:
   virtual Buffer malloc(size_t size) override;
   virtual void free(Buffer buffer) override;
   virtual size_t size(Buffer buffer) const override;
+  virtual Buffer make_buffer(void* ptr, size_t size) override;
   size_t get_active_memory() const {
     return active_memory_;
   };
@@ -43,16 +170,46 @@ class CommonAllocator : public Allocator {
     std::swap(memory_limit_, limit);
     return limit;
   }
+  size_t get_cache_memory() {
+    std::unique_lock lk(mutex_);
+    return buffer_cache_.cache_size();
+  }
+  size_t set_cache_limit(size_t limit) {
+    std::unique_lock lk(mutex_);
+    std::swap(max_pool_size_, limit);
+    return limit;
+  }
+  void clear_cache() {
+    std::unique_lock lk(mutex_);
+    buffer_cache_.clear();
+  }
+  BufferCacheStats get_cache_stats() {
+    std::unique_lock lk(mutex_);
+    return buffer_cache_.stats();
+  }
+  void reset_cache_stats() {
+    std::unique_lock lk(mutex_);
+    buffer_cache_.reset_stats();
+  }
 
  private:
   size_t memory_limit_;
+  size_t max_pool_size_;
   size_t active_memory_{0};
   size_t peak_memory_{0};
   std::mutex mutex_;
-  CommonAllocator() : memory_limit_(0.8 * get_memory_size()) {
+  BufferCache<Block> buffer_cache_;
+  CommonAllocator()
+      : memory_limit_(0.8 * get_memory_size()),
+        buffer_cache_(
+            page_size(),
+            [](Block* block) { return block->capacity; },
+            free_block,
+            env::max_cache_overallocation() / 100.0) {
     if (memory_limit_ == 0) {
       memory_limit_ = 1UL << 33;
     }
+    max_pool_size_ = memory_limit_;
   };
 
   friend CommonAllocator& common_allocator();
@@ -71,32 +228,60 @@ void* Buffer::raw_ptr() {
   if (!ptr_) {
     return nullptr;
   }
-  return static_cast<size_t*>(ptr_) + 1;
+  return static_cast<Block*>(ptr_)->data;
 }
 
 Buffer CommonAllocator::malloc(size_t size) {
-  void* ptr = std::malloc(size + sizeof(size_t));
-  if (ptr != nullptr) {
-    *static_cast<size_t*>(ptr) = size;
-  }
   std::unique_lock lk(mutex_);
-  active_memory_ += size;
+  Block* block = buffer_cache_.reuse_from_cache(size);
+  if (!block) {
+    // Make room in the cache for the new buffer under memory pressure.
+    size_t mem_required = active_memory_ + buffer_cache_.cache_size() + size;
+    if (mem_required >= memory_limit_) {
+      buffer_cache_.release_cached_buffers(mem_required - memory_limit_);
+    }
+    lk.unlock();
+    block = new_block(size);
+    if (!block) {
+      return Buffer{nullptr};
+    }
+    lk.lock();
+  }
+  block->size = size;
+  active_memory_ += block->capacity;
   peak_memory_ = std::max(active_memory_, peak_memory_);
-  return Buffer{ptr};
+  return Buffer{block};
+}
+
+Buffer CommonAllocator::make_buffer(void* ptr, size_t size) {
+  return Buffer{new Block{size, 0, 0, ptr, true}};
 }
 
 void CommonAllocator::free(Buffer buffer) {
-  auto sz = size(buffer);
-  std::free(buffer.ptr());
+  auto block = static_cast<Block*>(buffer.ptr());
+  if (block == nullptr) {
+    return;
+  }
+  // The external memory is not counted as active.
+  if (block->external) {
+    delete block;
+    return;
+  }
   std::unique_lock lk(mutex_);
-  active_memory_ -= sz;
+  active_memory_ -= block->capacity;
+  if (buffer_cache_.cache_size() + block->capacity <= max_pool_size_) {
+    buffer_cache_.recycle_to_cache(block);
+  } else {
+    lk.unlock();
+    free_block(block);
+  }
 }
 
 size_t CommonAllocator::size(Buffer buffer) const {
   if (buffer.ptr() == nullptr) {
     return 0;
   }
-  return *static_cast<size_t*>(buffer.ptr());
+  return static_cast<const Block*>(buffer.ptr())->size;
 }
 
 } // namespace allocator
@@ -117,16 +302,55 @@ size_t get_memory_limit() {
   return allocator::common_allocator().get_memory_limit();
 }
 
-// No-ops for common allocator
 size_t get_cache_memory() {
-  return 0;
+  return allocator::common_allocator().get_cache_memory();
 }
-size_t set_cache_limit(size_t) {
-  return 0;
+size_t set_cache_limit(size_t limit) {
+  return allocator::common_allocator().set_cache_limit(limit);
 }
 size_t set_wired_limit(size_t) {
   return 0;
 }
-void clear_cache() {}
+void clear_cache() {
+  allocator::common_allocator().clear_cache();
+}
+std::unordered_map<std::string, size_t> get_cache_info() {
+  auto stats = allocator::common_allocator().get_cache_stats();
+  return {
+      {"hits", stats.hits},
+      {"misses", stats.misses},
+      {"evictions", stats.evictions},
+      {"requested_bytes", stats.requested_bytes},
+      {"reused_bytes", stats.reused_bytes}};
+}
+void reset_cache_info() {
+  allocator::common_allocator().reset_cache_stats();
+}
+
+// A single device of each type.
+size_t get_active_memory(Device) {
+  return get_active_memory();
+}
+size_t get_peak_memory(Device) {
+  return get_peak_memory();
+}
+void reset_peak_memory(Device) {
+  reset_peak_memory();
+}
+size_t get_cache_memory(Device) {
+  return get_cache_memory();
+}
+size_t set_memory_limit(size_t limit, Device) {
+  return set_memory_limit(limit);
+}
+size_t get_memory_limit(Device) {
+  return get_memory_limit();
+}
+size_t set_cache_limit(size_t limit, Device) {
+  return set_cache_limit(limit);
+}
+void clear_cache(Device) {
+  clear_cache();
+}
 
 } // namespace mlx::core
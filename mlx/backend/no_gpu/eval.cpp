@@ -17,6 +17,12 @@ void eval(array&) {
   throw std::runtime_error("[gpu::eval] GPU backend is not available");
 }
 
+bool is_supported(Primitive&) {
+  return false;
+}
+
+void prefetch_to_host(const array&) {}
+
 void finalize(Stream) {
   throw std::runtime_error("[gpu::finalize] GPU backend is not available");
 }
@@ -25,4 +31,9 @@ void synchronize(Stream) {
   throw std::runtime_error("[gpu::synchronize]  GPU backend is not available");
 }
 
+void add_completed_handler(Stream, std::function<void()>) {
+  throw std::runtime_error(
+      "[gpu::add_completed_handler] GPU backend is not available");
+}
+
 } // namespace mlx::core::gpu
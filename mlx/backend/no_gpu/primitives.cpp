@@ -30,6 +30,38 @@ bool fast::ScaledDotProductAttention::use_fallback(
     bool has_mask,
     bool has_arr_mask,
     bool do_causal,
+    bool has_window,
+    bool has_tree,
+    Stream s) {
+  return true;
+}
+
+bool fast::Fp8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  return true;
+}
+
+bool fast::Int8Matmul::use_fallback(const array& x, const array& w, Stream s) {
+  return true;
+}
+
+bool fast::QuantizedScaledDotProductAttention::use_fallback(
+    const array& q,
+    const array& k,
+    bool has_arr_mask,
+    bool do_causal,
+    int group_size,
+    int bits,
+    Stream s) {
+  return true;
+}
+
+bool fast::QuantizedKVWrite::use_fallback(int group_size, int bits, Stream s) {
+  return true;
+}
+
+bool fast::PagedAttention::use_fallback(
+    const array& q,
+    const array& k_pages,
     Stream s) {
   return true;
 }
@@ -50,6 +82,7 @@ NO_GPU(ArgReduce)
 NO_GPU(ArgSort)
 NO_GPU(AsType)
 NO_GPU(AsStrided)
+NO_GPU(BinCount)
 NO_GPU(BitwiseBinary)
 NO_GPU(BitwiseInvert)
 NO_GPU(BlockMaskedMM)
@@ -89,6 +122,7 @@ NO_GPU(GatherQMM)
 NO_GPU(Greater)
 NO_GPU(GreaterEqual)
 NO_GPU(Hadamard)
+NO_GPU_MULTI(HostCallback)
 NO_GPU(Imag)
 NO_GPU(Less)
 NO_GPU(LessEqual)
@@ -130,6 +164,7 @@ NO_GPU(Slice)
 NO_GPU(SliceUpdate)
 NO_GPU(Softmax)
 NO_GPU(Sort)
+NO_GPU(SparseMatmul)
 NO_GPU_MULTI(Split)
 NO_GPU(Square)
 NO_GPU(Squeeze)
@@ -141,6 +176,7 @@ NO_GPU(Tan)
 NO_GPU(Tanh)
 NO_GPU(Transpose)
 NO_GPU(Unflatten)
+NO_GPU_MULTI(Unique)
 NO_GPU(Inverse)
 NO_GPU(Cholesky)
 NO_GPU_MULTI(Eigh)
@@ -148,19 +184,86 @@ NO_GPU_MULTI(Eig)
 NO_GPU(View)
 
 namespace fast {
+bool CrossEntropy::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool StochasticRound::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool OptimizerStep::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool GatedActivation::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool MoERoute::use_fallback(int num_experts, int k, Stream s) {
+  return true;
+}
+
+bool ArgReduceWithValue::use_fallback(Stream s) {
+  return true;
+}
+
+bool QuantizedEmbedding::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool Moments::use_fallback(Stream s) {
+  return s.device == Device::gpu;
+}
+
+bool RoPE::use_fallback(Stream s, bool per_position) {
+  return true;
+}
+
+bool VarlenAttention::use_fallback(const array& q, const array& v, Stream s) {
+  return true;
+}
+
+NO_GPU_USE_FALLBACK(AddLayerNorm)
+NO_GPU_USE_FALLBACK(AddRMSNorm)
 NO_GPU_USE_FALLBACK(LayerNorm)
 NO_GPU_MULTI(LayerNormVJP)
 NO_GPU_USE_FALLBACK(RMSNorm)
 NO_GPU_MULTI(RMSNormVJP)
-NO_GPU_USE_FALLBACK(RoPE)
+NO_GPU_USE_FALLBACK(PagedKVWrite)
+NO_GPU_MULTI(PagedAttention)
+NO_GPU_MULTI(QuantizedKVWrite)
+NO_GPU_MULTI(QuantizedScaledDotProductAttention)
+NO_GPU_MULTI(RoPE)
+NO_GPU_USE_FALLBACK(RoPEQKV)
+NO_GPU_USE_FALLBACK(SampleTopKTopP)
 NO_GPU(ScaledDotProductAttention)
+NO_GPU_MULTI(VarlenAttention)
+NO_GPU(FusedMatmul)
+NO_GPU(Fp8Matmul)
+NO_GPU(Int8Matmul)
+NO_GPU_MULTI(CrossEntropy)
+NO_GPU_MULTI(CrossEntropyVJP)
+NO_GPU_MULTI(OptimizerStep)
+NO_GPU_MULTI(GatedActivation)
+NO_GPU_MULTI(GatedActivationVJP)
+NO_GPU_MULTI(MoERoute)
+NO_GPU_MULTI(ArgReduceWithValue)
+NO_GPU_MULTI(QuantizedEmbedding)
+NO_GPU_MULTI(Moments)
+NO_GPU_USE_FALLBACK(ConvolutionVJP)
+NO_GPU_USE_FALLBACK(RandomDistribution)
+NO_GPU_MULTI(StochasticRound)
 NO_GPU_MULTI(AffineQuantize)
+NO_GPU_USE_FALLBACK(BlockScaledQuantize)
 NO_GPU_MULTI(CustomKernel)
 } // namespace fast
 
 namespace distributed {
 NO_GPU_MULTI(AllReduce)
 NO_GPU_MULTI(AllGather)
+NO_GPU_MULTI(ReduceScatter)
+NO_GPU_MULTI(AllToAll)
 NO_GPU_MULTI(Send)
 NO_GPU_MULTI(Recv)
 } // namespace distributed
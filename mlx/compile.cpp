@@ -1,5 +1,6 @@
 // Copyright © 2023-2024 Apple Inc.
 #include <cstdlib>
+#include <list>
 #include <map>
 #include <sstream>
 #include <unordered_map>
@@ -7,10 +8,12 @@
 
 #include "mlx/allocator.h"
 #include "mlx/backend/common/compiled.h"
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/compile.h"
 #include "mlx/compile_impl.h"
 #include "mlx/fast_primitives.h"
 #include "mlx/graph_utils.h"
+#include "mlx/ops.h"
 #include "mlx/primitives.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
@@ -73,9 +76,36 @@ bool is_reduction(const Primitive& p) {
 }
 
 bool is_fusable(const Primitive& p) {
+  // The fused kernels don't guarantee the in-place outputs
+  if (auto add = dynamic_cast<const Add*>(&p); add && add->inplace()) {
+    return false;
+  }
   return is_unary(p) || is_binary(p) || is_ternary(p) || is_broadcast(p);
 }
 
+// Whether the elementwise ops computing the input of the reduction can be
+// fused into the reduction kernel, which is only supported by the CUDA
+// backend for the reductions of the trailing axes.
+bool is_fusable_reduction(const array& a) {
+  if (!a.has_primitive() || typeid(a.primitive()) != typeid(Reduce) ||
+      a.primitive().stream().device != Device::gpu || !cu::is_available()) {
+    return false;
+  }
+  auto axes = static_cast<Reduce&>(a.primitive()).state().second;
+  int ndim = a.inputs()[0].ndim();
+  int n = axes.size();
+  if (n == 0 || n > ndim) {
+    return false;
+  }
+  std::sort(axes.begin(), axes.end());
+  for (int i = 0; i < n; ++i) {
+    if (axes[i] != ndim - n + i) {
+      return false;
+    }
+  }
+  return true;
+}
+
 Compiled::Compiled(
     Stream stream,
     std::vector<array> inputs,
@@ -194,6 +224,13 @@ std::vector<Shape> Compiled::output_shapes(const std::vector<array>& inputs) {
       out_shape[i] = std::max(out_shape[i], in.shape()[i - dd]);
     }
   }
+  // A fused reduction keeps the reduced axes
+  if (auto& p = tape_.back().primitive(); typeid(p) == typeid(Reduce)) {
+    auto axes = static_cast<Reduce&>(p).state().second;
+    for (auto ax : axes) {
+      out_shape[ax] = 1;
+    }
+  }
   // All outputs have the same shape
   return std::vector<Shape>(outputs_.size(), out_shape);
 }
@@ -298,15 +335,19 @@ class CompilerCache {
     std::vector<uint64_t> constants;
   };
 
-  // Returns a reference to a CacheEntry which can be updated
-  // by the caller to avoid copying large tapes / inputs / outputs
-  CacheEntry& find(
+  // Returns the CacheEntry matching the inputs, or a new empty one which is
+  // filled by the caller. The entries are found by a hash of the stream, the
+  // shapes and dtypes of the inputs and the constants, and only compared in
+  // full when the hashes match. The entries are shared so the caller can
+  // fill one while others are evicted.
+  std::shared_ptr<CacheEntry> find(
       std::uintptr_t fun_id,
       const std::vector<array>& inputs,
       bool shapeless,
       const std::vector<uint64_t>& constants) {
-    // Find the cache entries for |fun_id|.
-    std::vector<CacheEntry>& entries = cache_[fun_id];
+    auto stream = default_stream(default_device());
+    uint64_t key = signature(stream, inputs, shapeless, constants);
+    auto& entries = cache_[fun_id];
 
     // Compare if 2 arrays have same shape and dtype.
     auto has_same_shape_and_dtype = [shapeless](
@@ -328,36 +369,56 @@ class CompilerCache {
       }
       return true;
     };
-    // Loop over entries and check:
+    // Check the entries with the same hash:
     // - Default stream and device match the entry's default stream
     // - Inputs match i.e. shapes and types must be equal.
-    auto stream = default_stream(default_device());
-    for (CacheEntry& entry : entries) {
-      // Check that the default stream and device match
-      if (entry.stream != stream) {
-        continue;
-      }
-      if (entry.shapeless != shapeless) {
-        continue;
-      }
-
-      // Check the inputs match and return if so
-      if (has_same_shape_and_dtype(inputs, entry.inputs) &&
+    auto [first, last] = entries.equal_range(key);
+    for (auto it = first; it != last; ++it) {
+      auto& entry = *it->second->entry;
+      if (entry.stream == stream && entry.shapeless == shapeless &&
+          has_same_shape_and_dtype(inputs, entry.inputs) &&
           constants == entry.constants) {
-        return entry;
+        stats_.hits++;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->entry;
       }
     }
-    // Otherwise append a new cache entry
-    entries.push_back(CacheEntry{stream, shapeless});
-    return entries.back();
+    // Otherwise add a new cache entry
+    stats_.misses++;
+    auto entry = std::make_shared<CacheEntry>(stream, shapeless);
+    lru_.push_front(LruEntry{fun_id, key, entry});
+    entries.emplace(key, lru_.begin());
+    evict(env::compile_cache_size());
+    return entry;
   }
 
   void erase(std::uintptr_t fun_id) {
-    cache_.erase(fun_id);
+    auto it = cache_.find(fun_id);
+    if (it == cache_.end()) {
+      return;
+    }
+    for (auto& [key, lru_it] : it->second) {
+      lru_.erase(lru_it);
+    }
+    cache_.erase(it);
   }
 
   void clear() {
     cache_.clear();
+    lru_.clear();
+  }
+
+  std::unordered_map<std::string, size_t> info() const {
+    return {
+        {"entries", lru_.size()},
+        {"hits", stats_.hits},
+        {"misses", stats_.misses},
+        {"evictions", stats_.evictions},
+        {"capacity", static_cast<size_t>(env::compile_cache_size())}};
+  }
+
+  void reset_info() {
+    stats_ = Stats{};
   }
 
  private:
@@ -367,8 +428,77 @@ class CompilerCache {
     allocator::allocator();
   }
 
+  static uint64_t signature(
+      const Stream& stream,
+      const std::vector<array>& inputs,
+      bool shapeless,
+      const std::vector<uint64_t>& constants) {
+    uint64_t h = 0;
+    auto combine = [&h](uint64_t v) {
+      h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+    };
+    combine(stream.index);
+    combine(static_cast<uint64_t>(stream.device.type));
+    combine(shapeless);
+    combine(inputs.size());
+    for (auto& in : inputs) {
+      combine(static_cast<uint64_t>(in.dtype().val()));
+      combine(in.ndim());
+      if (!shapeless) {
+        for (auto d : in.shape()) {
+          combine(d);
+        }
+      }
+    }
+    combine(constants.size());
+    for (auto c : constants) {
+      combine(c);
+    }
+    return h;
+  }
+
+  // Evict the least recently used entries beyond |capacity|, or none when it
+  // is not positive.
+  void evict(int capacity) {
+    while (capacity > 0 && lru_.size() > static_cast<size_t>(capacity)) {
+      auto last = std::prev(lru_.end());
+      auto it = cache_.find(last->fun_id);
+      auto [first, end] = it->second.equal_range(last->key);
+      for (auto e = first; e != end; ++e) {
+        if (e->second == last) {
+          it->second.erase(e);
+          break;
+        }
+      }
+      if (it->second.empty()) {
+        cache_.erase(it);
+      }
+      lru_.pop_back();
+      stats_.evictions++;
+    }
+  }
+
+  struct LruEntry {
+    std::uintptr_t fun_id;
+    uint64_t key;
+    std::shared_ptr<CacheEntry> entry;
+  };
+
+  struct Stats {
+    size_t hits{0};
+    size_t misses{0};
+    size_t evictions{0};
+  };
+
   friend CompilerCache& compiler_cache();
-  std::unordered_map<std::uintptr_t, std::vector<CacheEntry>> cache_;
+  // The entries from the most to the least recently used, and the entries of
+  // each function by the hash of their signature.
+  std::list<LruEntry> lru_;
+  std::unordered_map<
+      std::uintptr_t,
+      std::unordered_multimap<uint64_t, std::list<LruEntry>::iterator>>
+      cache_;
+  Stats stats_;
 };
 
 CompilerCache& compiler_cache() {
@@ -617,6 +747,339 @@ void compile_simplify(
   }
 }
 
+// Replace the matmuls followed by the addition of a bias vector along the
+// last axis and/or a relu with FusedMatmul primitives, which the CUDA backend
+// computes with the epilogues of cublasLt.
+void compile_fuse_matmul(
+    std::vector<array>& tape,
+    ParentsMap& parents_map,
+    std::vector<array>& outputs) {
+  if (!cu::is_available()) {
+    return;
+  }
+
+  std::unordered_map<uintptr_t, array> output_map;
+  for (auto& o : outputs) {
+    output_map.insert({o.id(), o});
+  }
+
+  // The only parent of an array which is not an output, if any.
+  auto single_parent = [&](const array& a) -> const std::pair<array, int>* {
+    if (output_map.find(a.id()) != output_map.end()) {
+      return nullptr;
+    }
+    auto it = parents_map.find(a.id());
+    if (it == parents_map.end() || it->second.size() != 1) {
+      return nullptr;
+    }
+    return &it->second[0];
+  };
+  // The elementwise op of the same stream, dtype and shape applied to |a|.
+  auto elementwise_parent = [&](const array& a, const std::type_info& type)
+      -> const std::pair<array, int>* {
+    auto p = single_parent(a);
+    if (!p || typeid(p->first.primitive()) != type ||
+        p->first.primitive().stream() != a.primitive().stream() ||
+        p->first.dtype() != a.dtype() || p->first.shape() != a.shape()) {
+      return nullptr;
+    }
+    return p;
+  };
+  // The array broadcasted to |a| by the ops of the graph.
+  auto unbroadcast = [](const array& a) {
+    if (a.has_primitive() && is_broadcast(a.primitive())) {
+      return a.inputs()[0];
+    }
+    return a;
+  };
+  auto is_zero = [](const array& a) {
+    if (a.ndim() != 0 || !a.is_available()) {
+      return false;
+    }
+    switch (a.dtype()) {
+      case float16:
+        return a.item<float16_t>() == 0;
+      case bfloat16:
+        return a.item<bfloat16_t>() == 0;
+      case float32:
+        return a.item<float>() == 0;
+      default:
+        return false;
+    }
+  };
+
+  std::unordered_set<uintptr_t> removed;
+  std::unordered_map<uintptr_t, array> replaced;
+  for (auto& mm : tape) {
+    if (!mm.has_primitive() || typeid(mm.primitive()) != typeid(Matmul) ||
+        removed.find(mm.id()) != removed.end()) {
+      continue;
+    }
+    auto& s = mm.primitive().stream();
+    if (s.device != Device::gpu ||
+        (mm.dtype() != float32 && mm.dtype() != float16 &&
+         mm.dtype() != bfloat16) ||
+        mm.inputs()[0].size() == 0 || mm.inputs()[1].size() == 0) {
+      continue;
+    }
+
+    std::vector<array> fused_inputs = mm.inputs();
+    std::vector<array> fused = {mm};
+    // Drop the broadcast of an operand of an op being fused when nothing
+    // else uses it.
+    auto fuse_operand = [&](const std::pair<array, int>& parent) {
+      auto& operand = parent.first.inputs()[1 - parent.second];
+      if (operand.has_primitive() && is_broadcast(operand.primitive()) &&
+          single_parent(operand)) {
+        fused.push_back(operand);
+      }
+    };
+
+    int N = mm.shape(-1);
+    if (auto p = elementwise_parent(fused.back(), typeid(Add))) {
+      auto bias = unbroadcast(p->first.inputs()[1 - p->second]);
+      if (bias.ndim() > 0 && bias.shape(-1) == N && bias.size() == N &&
+          bias.dtype() == mm.dtype()) {
+        fused_inputs.push_back(bias);
+        fuse_operand(*p);
+        fused.push_back(p->first);
+      }
+    }
+    auto activation = fast::FusedMatmul::None;
+    if (auto p = elementwise_parent(fused.back(), typeid(Maximum))) {
+      if (is_zero(unbroadcast(p->first.inputs()[1 - p->second]))) {
+        activation = fast::FusedMatmul::ReLU;
+        fuse_operand(*p);
+        fused.push_back(p->first);
+      }
+    }
+    if (fused.size() == 1) {
+      continue;
+    }
+
+    auto precision = static_cast<Matmul&>(mm.primitive()).precision();
+    auto fallback = [s, activation, precision](
+                        const std::vector<array>& inputs) {
+      MatmulPrecisionContext ctx(precision);
+      auto out = matmul(inputs[0], inputs[1], s);
+      if (inputs.size() == 3) {
+        out = add(out, inputs[2], s);
+      }
+      if (activation == fast::FusedMatmul::ReLU) {
+        out = maximum(out, array(0, out.dtype()), s);
+      }
+      return std::vector<array>{out};
+    };
+    auto top = fused.back();
+    array out(
+        top.shape(),
+        top.dtype(),
+        std::make_shared<fast::FusedMatmul>(
+            s, fallback, activation, precision),
+        fused_inputs);
+
+    for (auto& a : fused) {
+      removed.insert(a.id());
+    }
+    auto is_removed = [&](const std::pair<array, int>& parent) {
+      return removed.find(parent.first.id()) != removed.end();
+    };
+    std::unordered_set<uintptr_t> visited;
+    for (auto& a : fused) {
+      for (auto& in : a.inputs()) {
+        if (!visited.insert(in.id()).second) {
+          continue;
+        }
+        auto& pairs = parents_map[in.id()];
+        pairs.erase(
+            std::remove_if(pairs.begin(), pairs.end(), is_removed),
+            pairs.end());
+      }
+    }
+    for (int i = 0; i < fused_inputs.size(); ++i) {
+      parents_map[fused_inputs[i].id()].push_back({out, i});
+    }
+    for (auto& a : fused) {
+      if (a.id() != top.id()) {
+        parents_map.erase(a.id());
+      }
+    }
+    merge_one(out, top, parents_map);
+    if (auto it = output_map.find(top.id()); it != output_map.end()) {
+      it->second = out;
+    }
+    replaced.insert({top.id(), out});
+  }
+
+  if (replaced.empty()) {
+    return;
+  }
+  std::vector<array> new_tape;
+  for (auto& arr : tape) {
+    if (auto it = replaced.find(arr.id()); it != replaced.end()) {
+      new_tape.push_back(it->second);
+    } else if (removed.find(arr.id()) == removed.end()) {
+      new_tape.push_back(std::move(arr));
+    }
+  }
+  tape = std::move(new_tape);
+  for (auto& o : outputs) {
+    o = output_map.at(o.id());
+  }
+}
+
+bool is_view(const Primitive& p) {
+  return typeid(p) == typeid(Transpose) || typeid(p) == typeid(Slice) ||
+      typeid(p) == typeid(Reshape);
+}
+
+// The view |view| applied to |x| which has the shape of its input.
+array apply_view(const array& view, const array& x) {
+  auto& p = view.primitive();
+  auto& s = p.stream();
+  std::shared_ptr<Primitive> prim;
+  if (typeid(p) == typeid(Transpose)) {
+    prim = std::make_shared<Transpose>(
+        s, static_cast<const Transpose&>(p).state());
+  } else if (typeid(p) == typeid(Slice)) {
+    auto [start, stop, strides] = static_cast<const Slice&>(p).state();
+    prim = std::make_shared<Slice>(s, start, stop, strides);
+  } else {
+    prim = std::make_shared<Reshape>(s, view.shape());
+  }
+  return array(view.shape(), x.dtype(), std::move(prim), {x});
+}
+
+// Move the transposes, slices and reshapes of the outputs of elementwise
+// ops to the operands of the ops. The elementwise ops commute with the
+// views, and once moved the ops on both sides of a view are fused into one
+// kernel which reads the views of its inputs with their strides, instead
+// of the op before the view being computed by its own kernel.
+void compile_sink_views(
+    std::vector<array>& tape,
+    ParentsMap& parents_map,
+    std::vector<array>& outputs) {
+  if (!cu::is_available()) {
+    return;
+  }
+
+  std::unordered_map<uintptr_t, array> output_map;
+  for (auto& o : outputs) {
+    output_map.insert({o.id(), o});
+  }
+  auto remove_parent = [&](const array& a, const array& parent) {
+    auto& pairs = parents_map[a.id()];
+    pairs.erase(
+        std::remove_if(
+            pairs.begin(),
+            pairs.end(),
+            [&](auto& p) { return p.first.id() == parent.id(); }),
+        pairs.end());
+  };
+
+  std::vector<array> views;
+  for (auto& a : tape) {
+    if (a.has_primitive() && is_view(a.primitive())) {
+      views.push_back(a);
+    }
+  }
+  bool changed = false;
+  for (size_t i = 0; i < views.size(); ++i) {
+    auto view = views[i];
+    auto& s = view.primitive().stream();
+    auto op = view.inputs()[0];
+    if (s.device != Device::gpu || !op.has_primitive() ||
+        !is_fusable(op.primitive()) || is_broadcast(op.primitive()) ||
+        op.primitive().stream() != s ||
+        output_map.find(op.id()) != output_map.end()) {
+      continue;
+    }
+    auto parents = parents_map.find(op.id());
+    if (parents == parents_map.end() || parents->second.size() != 1) {
+      continue;
+    }
+
+    // The broadcasts of scalars are broadcasted to the shape of the view.
+    // The other operands have the shape of the op, a reshape of them may
+    // copy when they are broadcasts so the op is left alone.
+    bool reshape = typeid(view.primitive()) == typeid(Reshape);
+    auto scalar_broadcast = [&](const array& x) {
+      return x.has_primitive() && is_broadcast(x.primitive()) &&
+          x.inputs()[0].size() == 1 && x.inputs()[0].ndim() <= view.ndim();
+    };
+    bool sinkable = true;
+    for (auto& x : op.inputs()) {
+      sinkable &= x.shape() == op.shape() &&
+          (scalar_broadcast(x) || !reshape || !x.has_primitive() ||
+           !is_broadcast(x.primitive()));
+    }
+    if (!sinkable) {
+      continue;
+    }
+
+    std::vector<array> operands;
+    for (auto& x : op.inputs()) {
+      array y = scalar_broadcast(x)
+          ? array(
+                view.shape(),
+                x.dtype(),
+                std::make_shared<Broadcast>(s, view.shape()),
+                {x.inputs()[0]})
+          : apply_view(view, x);
+      auto& y_in = y.inputs()[0];
+      remove_parent(x, op);
+      parents_map[y_in.id()].push_back({y, 0});
+      // Drop the broadcasts which are not used anymore.
+      if (y_in.id() != x.id() && parents_map[x.id()].empty() &&
+          output_map.find(x.id()) == output_map.end()) {
+        remove_parent(y_in, x);
+        parents_map.erase(x.id());
+      }
+      if (is_view(y.primitive())) {
+        views.push_back(y);
+      }
+      operands.push_back(std::move(y));
+    }
+    array sunk(view.shape(), op.dtype(), op.primitive_ptr(), operands);
+    for (int j = 0; j < operands.size(); ++j) {
+      parents_map[operands[j].id()].push_back({sunk, j});
+    }
+    parents_map.erase(op.id());
+    merge_one(sunk, view, parents_map);
+    if (auto it = output_map.find(view.id()); it != output_map.end()) {
+      it->second = sunk;
+    }
+    changed = true;
+  }
+  if (!changed) {
+    return;
+  }
+
+  for (auto& o : outputs) {
+    o = output_map.at(o.id());
+  }
+  // Rebuild the tape in the order of the graph.
+  std::vector<array> old_tape = std::move(tape);
+  tape.clear();
+  std::unordered_set<uintptr_t> cache;
+  std::function<void(const array&)> recurse = [&](const array& a) {
+    if (cache.find(a.id()) != cache.end()) {
+      return;
+    }
+    for (auto& in : a.inputs()) {
+      recurse(in);
+    }
+    cache.insert(a.id());
+    for (auto& s : a.siblings()) {
+      cache.insert(s.id());
+    }
+    tape.push_back(a);
+  };
+  for (auto& o : outputs) {
+    recurse(o);
+  }
+}
+
 // Extract sub-graphs of the graph that can be compiled
 // and replace them with a Compiled Primitive.
 void compile_fuse(
@@ -661,6 +1124,9 @@ void compile_fuse(
     std::function<void(const array&, int, const Stream&, const Shape&)> recurse;
     std::unordered_set<uintptr_t> cache;
     std::unordered_set<uintptr_t> input_set;
+    // The fused ops of a reduction have a different shape from its output so
+    // none of them can be an output.
+    bool reduction = is_fusable_reduction(arr);
     recurse = [&](const array& a,
                   int depth,
                   const Stream& s,
@@ -674,10 +1140,11 @@ void compile_fuse(
       // - Constant input
       // - Stream mismatch
       // - Non fusable primitive
-      // - Is global output but has a different shape
+      // - Is global output but has a different shape or feeds a reduction
       if (depth >= max_compile_depth || !a.has_primitive() ||
           a.primitive().stream() != s || !is_fusable(a.primitive()) ||
-          (output_map.find(a.id()) != output_map.end() && a.shape() != shape)) {
+          (output_map.find(a.id()) != output_map.end() &&
+           (a.shape() != shape || reduction))) {
         // Possible input
         input_set.insert(a.id());
         return;
@@ -727,7 +1194,12 @@ void compile_fuse(
       }
     };
 
-    if (arr.has_primitive()) {
+    if (reduction) {
+      // Fuse the ops computing the input of the reduction with its shape.
+      cache.insert(arr.id());
+      auto& in = arr.inputs()[0];
+      recurse(in, 1, arr.primitive().stream(), in.shape());
+    } else if (arr.has_primitive()) {
       Stream s = arr.primitive().stream();
       recurse(arr, 0, s, arr.shape());
     }
@@ -953,42 +1425,46 @@ std::function<std::vector<array>(const std::vector<array>&)> compile(
     }
 
     // Find a cache entry with the correct inputs
-    auto& entry = compiler_cache().find(fun_id, inputs, shapeless, constants);
+    auto entry = compiler_cache().find(fun_id, inputs, shapeless, constants);
 
     // No matching cache entry existed, so compile
-    if (entry.empty) {
+    if (entry->empty) {
       // Mark the entry as not empty since we are about to fill it
-      entry.empty = false;
+      entry->empty = false;
       // Set the constants
-      entry.constants = std::move(constants);
+      entry->constants = std::move(constants);
       // Trace to build the graph
-      std::tie(entry.inputs, entry.outputs) =
+      std::tie(entry->inputs, entry->outputs) =
           compile_trace(fun, inputs, shapeless);
 
       // DFS the graph and get a tape, and a map of array id to (parent,
       // position in parent inputs)
       std::unordered_map<uintptr_t, std::vector<std::pair<array, int>>>
           parents_map;
-      std::tie(entry.tape, parents_map) =
-          compile_dfs(entry.inputs, entry.outputs, inputs);
+      std::tie(entry->tape, parents_map) =
+          compile_dfs(entry->inputs, entry->outputs, inputs);
 
       // Simplify the tape
       if (compile_mode() != CompileMode::no_simplify) {
         compile_simplify(
-            entry.tape, parents_map, entry.outputs, /* passes */ 3);
+            entry->tape, parents_map, entry->outputs, /* passes */ 3);
       }
 
       // Kernel fusion to generate Compiled primitives. The tape and
       // new outputs must be updated accordingly
       if (compile_mode() != CompileMode::no_fuse) {
-        compile_fuse(entry.tape, parents_map, entry.inputs, entry.outputs);
+        if (!shapeless) {
+          compile_fuse_matmul(entry->tape, parents_map, entry->outputs);
+          compile_sink_views(entry->tape, parents_map, entry->outputs);
+        }
+        compile_fuse(entry->tape, parents_map, entry->inputs, entry->outputs);
       }
     }
 
     // At this point we must have a tape, now replace the placeholders
     // with real arrays that can be evaluated
     return compile_replace(
-        entry.tape, entry.inputs, entry.outputs, inputs, shapeless);
+        entry->tape, entry->inputs, entry->outputs, inputs, shapeless);
   };
 }
 
@@ -1052,4 +1528,12 @@ void set_compile_mode(CompileMode mode) {
   detail::compile_mode() = mode;
 }
 
+std::unordered_map<std::string, size_t> compile_cache_info() {
+  return detail::compiler_cache().info();
+}
+
+void reset_compile_cache_info() {
+  detail::compiler_cache().reset_info();
+}
+
 } // namespace mlx::core
@@ -2,6 +2,9 @@
 
 #pragma once
 
+#include <string>
+#include <unordered_map>
+
 #include "mlx/array.h"
 
 namespace mlx::core {
@@ -41,4 +44,20 @@ void enable_compile();
 
 /** Set the compiler mode to the given value. */
 void set_compile_mode(CompileMode mode);
+
+/** Get the counters of the cache of compiled functions.
+ *
+ * The cache has an entry for each function and signature of its inputs, with
+ * at most ``MLX_COMPILE_CACHE_SIZE`` entries, and the least recently used one
+ * is evicted when it is full:
+ *   - "entries": the entries in the cache.
+ *   - "hits": the calls which found their entry.
+ *   - "misses": the calls which traced the function for a new entry.
+ *   - "evictions": the entries evicted from a full cache.
+ *   - "capacity": the maximum number of entries, 0 when not bounded.
+ */
+std::unordered_map<std::string, size_t> compile_cache_info();
+
+/** Reset the counters of compile_cache_info to zero. */
+void reset_compile_cache_info();
 } // namespace mlx::core
@@ -0,0 +1,146 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include "mlx/distributed/compression.h"
+#include "mlx/types/half_types.h"
+
+namespace mlx::core::distributed::detail {
+
+namespace {
+
+constexpr float fp8_max = 448.0f;
+
+// Float8 e4m3 rounded to nearest even and saturated to 448 as in to_fp8.
+uint8_t to_fp8(float x) {
+  uint32_t bits;
+  std::memcpy(&bits, &x, sizeof(bits));
+  uint8_t sign = (bits >> 24) & 0x80;
+  bits &= 0x7FFFFFFF;
+  float a = std::abs(x);
+  if (std::isnan(x)) {
+    return sign | 0x7F;
+  }
+  if (a >= fp8_max) {
+    return sign | 0x7E;
+  }
+  // The denormals are multiples of 2^-9.
+  if (a < 0.015625f) {
+    return sign | static_cast<uint8_t>(std::nearbyint(a * 512.0f));
+  }
+  uint32_t mant_odd = (bits >> 20) & 1;
+  bits += (static_cast<uint32_t>(7 - 127) << 23) + 0x7FFFF + mant_odd;
+  return sign | static_cast<uint8_t>(bits >> 20);
+}
+
+const std::array<float, 256>& fp8_table() {
+  static std::array<float, 256> table = []() {
+    std::array<float, 256> t;
+    for (int i = 0; i < 256; i++) {
+      int exp = (i >> 3) & 0xF;
+      int mant = i & 0x7;
+      float v;
+      if (exp == 0) {
+        v = std::ldexp(static_cast<float>(mant), -9);
+      } else if (exp == 0xF && mant == 0x7) {
+        v = NAN;
+      } else {
+        v = std::ldexp(1.0f + mant / 8.0f, exp - 7);
+      }
+      t[i] = (i & 0x80) ? -v : v;
+    }
+    return t;
+  }();
+  return table;
+}
+
+size_t num_blocks(size_t n) {
+  return (n + fp8_block_size - 1) / fp8_block_size;
+}
+
+// Decode the float8 blocks of |in| and combine them with |out| by |op|.
+template <typename Op>
+void decode_fp8(const char* in, size_t n, float* out, Op op) {
+  auto& table = fp8_table();
+  auto values = reinterpret_cast<const uint8_t*>(in) + 4 * num_blocks(n);
+  for (size_t b = 0; b < num_blocks(n); b++) {
+    float scale;
+    std::memcpy(&scale, in + 4 * b, sizeof(scale));
+    size_t end = std::min(n, (b + 1) * fp8_block_size);
+    for (size_t i = b * fp8_block_size; i < end; i++) {
+      op(out[i], table[values[i]] * scale);
+    }
+  }
+}
+
+template <typename Op>
+void decode_bf16(const char* in, size_t n, float* out, Op op) {
+  auto values = reinterpret_cast<const bfloat16_t*>(in);
+  for (size_t i = 0; i < n; i++) {
+    op(out[i], static_cast<float>(values[i]));
+  }
+}
+
+} // namespace
+
+size_t compressed_size(Compression compression, size_t n) {
+  switch (compression) {
+    case Compression::BFloat16:
+      return n * sizeof(bfloat16_t);
+    case Compression::Float8:
+      return n + sizeof(float) * num_blocks(n);
+  }
+  return 0;
+}
+
+void compress(Compression compression, const float* in, size_t n, char* out) {
+  if (compression == Compression::BFloat16) {
+    auto values = reinterpret_cast<bfloat16_t*>(out);
+    for (size_t i = 0; i < n; i++) {
+      values[i] = static_cast<bfloat16_t>(in[i]);
+    }
+    return;
+  }
+
+  // A scale per block maps its largest magnitude to the largest float8.
+  auto values = reinterpret_cast<uint8_t*>(out) + 4 * num_blocks(n);
+  for (size_t b = 0; b < num_blocks(n); b++) {
+    size_t end = std::min(n, (b + 1) * fp8_block_size);
+    float amax = 0.0f;
+    for (size_t i = b * fp8_block_size; i < end; i++) {
+      amax = std::max(amax, std::abs(in[i]));
+    }
+    float scale = (amax > 0.0f && std::isfinite(amax)) ? amax / fp8_max : 1.0f;
+    std::memcpy(out + 4 * b, &scale, sizeof(scale));
+    for (size_t i = b * fp8_block_size; i < end; i++) {
+      values[i] = to_fp8(in[i] / scale);
+    }
+  }
+}
+
+void decompress_add(
+    Compression compression,
+    const char* in,
+    size_t n,
+    float* out) {
+  auto add = [](float& o, float v) { o += v; };
+  if (compression == Compression::BFloat16) {
+    decode_bf16(in, n, out, add);
+  } else {
+    decode_fp8(in, n, out, add);
+  }
+}
+
+void decompress(Compression compression, const char* in, size_t n, float* out) {
+  auto assign = [](float& o, float v) { o = v; };
+  if (compression == Compression::BFloat16) {
+    decode_bf16(in, n, out, assign);
+  } else {
+    decode_fp8(in, n, out, assign);
+  }
+}
+
+} // namespace mlx::core::distributed::detail
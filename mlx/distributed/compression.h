@@ -0,0 +1,31 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cstddef>
+
+#include "mlx/distributed/distributed.h"
+
+namespace mlx::core::distributed::detail {
+
+// The float8 values sharing a scale, counted from the start of the encoded
+// span.
+constexpr size_t fp8_block_size = 256;
+
+// The bytes of |n| floats encoded with |compression|.
+size_t compressed_size(Compression compression, size_t n);
+
+// Encode the |n| floats of |in| into |out|.
+void compress(Compression compression, const float* in, size_t n, char* out);
+
+// Decode |n| floats from |in| and add them to |out|.
+void decompress_add(
+    Compression compression,
+    const char* in,
+    size_t n,
+    float* out);
+
+// Decode |n| floats from |in| into |out|.
+void decompress(Compression compression, const char* in, size_t n, float* out);
+
+} // namespace mlx::core::distributed::detail
@@ -5,6 +5,7 @@
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/distributed_impl.h"
 #include "mlx/distributed/mpi/mpi.h"
+#include "mlx/distributed/nccl/nccl.h"
 #include "mlx/distributed/ring/ring.h"
 
 namespace mlx::core::distributed {
@@ -27,6 +28,34 @@ void all_gather(Group group, const array& input, array& output, Stream stream) {
   group.raw_group()->all_gather(input, output, stream);
 }
 
+void compressed_all_sum(
+    Group group,
+    const array& input,
+    array& output,
+    Compression compression,
+    Stream stream) {
+  group.raw_group()->compressed_all_sum(input, output, compression, stream);
+}
+
+void reduce_scatter(
+    Group group,
+    const array& input,
+    array& output,
+    Stream stream) {
+  group.raw_group()->reduce_scatter(input, output, stream);
+}
+
+void all_to_all(
+    Group group,
+    const array& input,
+    array& output,
+    const std::vector<size_t>& send_counts,
+    const std::vector<size_t>& recv_counts,
+    Stream stream) {
+  group.raw_group()->all_to_all(
+      input, output, send_counts, recv_counts, stream);
+}
+
 void send(Group group, const array& input, int dst, Stream stream) {
   group.raw_group()->send(input, dst, stream);
 }
@@ -75,12 +104,28 @@ class EmptyGroup : public GroupImpl {
     throw std::runtime_error(
         "Communication not implemented in an empty distributed group.");
   }
+
+  void reduce_scatter(const array&, array&, Stream) override {
+    throw std::runtime_error(
+        "Communication not implemented in an empty distributed group.");
+  }
+
+  void all_to_all(
+      const array&,
+      array&,
+      const std::vector<size_t>&,
+      const std::vector<size_t>&,
+      Stream) override {
+    throw std::runtime_error(
+        "Communication not implemented in an empty distributed group.");
+  }
 };
 
 } // namespace detail
 
 bool is_available() {
-  return mpi::is_available() || ring::is_available();
+  return mpi::is_available() || ring::is_available() ||
+      nccl::is_available();
 }
 
 int Group::rank() const {
@@ -95,6 +140,11 @@ Group Group::split(int color, int key /* = -1 */) const {
   return Group(group_->split(color, key));
 }
 
+Group hierarchical_group(Group local, Group cross) {
+  return Group(std::make_shared<detail::HierarchicalGroup>(
+      std::move(local), std::move(cross)));
+}
+
 Group init(bool strict /* = false */, const std::string& bk /* = "any" */) {
   static std::unordered_map<std::string, std::shared_ptr<detail::GroupImpl>>
       backends;
@@ -111,6 +161,8 @@ Group init(bool strict /* = false */, const std::string& bk /* = "any" */) {
     group = mpi::init(strict);
   } else if (bk == "ring") {
     group = ring::init(strict);
+  } else if (bk == "nccl") {
+    group = nccl::init(strict);
   } else if (bk == "any") {
     group = ring::init(false);
     bk_ = "ring";
@@ -118,13 +170,17 @@ Group init(bool strict /* = false */, const std::string& bk /* = "any" */) {
       group = mpi::init(false);
       bk_ = "mpi";
     }
+    if (group == nullptr) {
+      group = nccl::init(false);
+      bk_ = "nccl";
+    }
     if (group == nullptr && strict) {
       throw std::runtime_error("[distributed] Couldn't initialize any backend");
     }
   } else {
     std::ostringstream msg;
-    msg << "[distributed] The only valid values for backend are 'any', 'mpi' "
-        << "and 'ring' but '" << bk << "' was provided.";
+    msg << "[distributed] The only valid values for backend are 'any', 'mpi', "
+        << "'ring' and 'nccl' but '" << bk << "' was provided.";
     throw std::invalid_argument(msg.str());
   }
 
@@ -13,6 +13,9 @@ namespace detail {
 class GroupImpl;
 };
 
+/* The formats of the floats sent by a compressed all reduce */
+enum class Compression { BFloat16, Float8 };
+
 /* Check if a communication backend is available */
 bool is_available();
 
@@ -55,4 +58,17 @@ struct Group {
  */
 Group init(bool strict = false, const std::string& bk = "any");
 
+/**
+ * Combine the group of the processes of a node with the group of the
+ * processes with the same rank on the other nodes. The rank of a process in
+ * the returned group is its rank in ``local`` plus its rank in ``cross``
+ * times the size of ``local``.
+ *
+ * The all reduces of the returned group reduce scatter in the node, all
+ * reduce the shards across the nodes and all gather them in the node, so
+ * that only a shard of the data crosses the slower links. The all gathers
+ * gather in the node and then across the nodes.
+ */
+Group hierarchical_group(Group local, Group cross);
+
 } // namespace mlx::core::distributed
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "mlx/distributed/distributed.h"
+#include "mlx/utils.h"
 
 namespace mlx::core::distributed::detail {
 
@@ -17,12 +18,121 @@ class GroupImpl {
   virtual int size() = 0;
   virtual std::shared_ptr<GroupImpl> split(int color, int key = -1) = 0;
 
+  // The stream to run the communication on, by default the communication
+  // happens on the CPU.
+  virtual Stream communication_stream(StreamOrDevice s = {}) {
+    return to_stream(s, Device::cpu);
+  }
+
   virtual void all_sum(const array& input, array& output, Stream stream) = 0;
   virtual void all_gather(const array& input, array& output, Stream stream) = 0;
   virtual void send(const array& input, int dst, Stream stream) = 0;
   virtual void recv(array& out, int src, Stream stream) = 0;
   virtual void all_max(const array& input, array& output, Stream stream) = 0;
   virtual void all_min(const array& input, array& output, Stream stream) = 0;
+
+  // Sum the float32 |input| over the group sending the values in the
+  // |compression| format and accumulating them in float32.
+  virtual void compressed_all_sum(
+      const array& input,
+      array& output,
+      Compression compression,
+      Stream stream) {
+    throw std::invalid_argument(
+        "[distributed] Compressed all reduces are only supported by the "
+        "ring and MPI backends.");
+  }
+
+  // Sum |input| over the group and keep the |rank|-th of |size| equal
+  // chunks of the result in |output|.
+  virtual void
+  reduce_scatter(const array& input, array& output, Stream stream) = 0;
+
+  // Send |send_counts[i]| elements of |input| to rank i and receive
+  // |recv_counts[i]| elements of |output| from it, both in rank order.
+  virtual void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<size_t>& send_counts,
+      const std::vector<size_t>& recv_counts,
+      Stream stream) = 0;
+};
+
+/**
+ * A group made of a group of the processes of a node and a group across the
+ * nodes. Its collectives are built by the ops from the ones of the two
+ * groups.
+ */
+class HierarchicalGroup : public GroupImpl {
+ public:
+  HierarchicalGroup(Group local, Group cross)
+      : local_(std::move(local)), cross_(std::move(cross)) {}
+
+  int rank() override {
+    return cross_.rank() * local_.size() + local_.rank();
+  }
+
+  int size() override {
+    return cross_.size() * local_.size();
+  }
+
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    throw std::runtime_error(
+        "[distributed] Split the node and cross node groups instead of the "
+        "hierarchical group.");
+  }
+
+  Stream communication_stream(StreamOrDevice s = {}) override {
+    return local_.raw_group()->communication_stream(s);
+  }
+
+  const Group& local() const {
+    return local_;
+  }
+
+  const Group& cross() const {
+    return cross_;
+  }
+
+  void all_sum(const array&, array&, Stream) override {
+    unsupported();
+  }
+  void all_gather(const array&, array&, Stream) override {
+    unsupported();
+  }
+  void send(const array&, int, Stream) override {
+    unsupported();
+  }
+  void recv(array&, int, Stream) override {
+    unsupported();
+  }
+  void all_max(const array&, array&, Stream) override {
+    unsupported();
+  }
+  void all_min(const array&, array&, Stream) override {
+    unsupported();
+  }
+  void reduce_scatter(const array&, array&, Stream) override {
+    unsupported();
+  }
+  void all_to_all(
+      const array&,
+      array&,
+      const std::vector<size_t>&,
+      const std::vector<size_t>&,
+      Stream) override {
+    unsupported();
+  }
+
+ private:
+  [[noreturn]] void unsupported() {
+    throw std::runtime_error(
+        "[distributed] Only all_sum, all_max, all_min and all_gather are "
+        "supported by hierarchical groups.");
+  }
+
+  Group local_;
+  Group cross_;
 };
 
 /* Perform an all reduce sum operation */
@@ -43,4 +153,28 @@ void all_max(Group group, const array& input, array& output, Stream stream);
 /** Min reduction */
 void all_min(Group group, const array& input, array& output, Stream stream);
 
+/** Sum reduction with compressed communication */
+void compressed_all_sum(
+    Group group,
+    const array& input,
+    array& output,
+    Compression compression,
+    Stream stream);
+
+/** Sum reduction keeping a chunk per rank */
+void reduce_scatter(
+    Group group,
+    const array& input,
+    array& output,
+    Stream stream);
+
+/** Exchange a chunk of the input with every rank */
+void all_to_all(
+    Group group,
+    const array& input,
+    array& output,
+    const std::vector<size_t>& send_counts,
+    const std::vector<size_t>& recv_counts,
+    Stream stream);
+
 } // namespace mlx::core::distributed::detail
@@ -2,8 +2,10 @@
 
 #include <dlfcn.h>
 #include <iostream>
+#include <limits>
 
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/distributed/compression.h"
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/distributed_impl.h"
 #include "mlx/distributed/mpi/mpi.h"
@@ -122,6 +124,8 @@ struct MPIWrapper {
     LOAD_SYMBOL(MPI_Comm_free, comm_free);
     LOAD_SYMBOL(MPI_Allreduce, all_reduce);
     LOAD_SYMBOL(MPI_Allgather, all_gather);
+    LOAD_SYMBOL(MPI_Reduce_scatter_block, reduce_scatter_block);
+    LOAD_SYMBOL(MPI_Alltoallv, all_to_all_v);
     LOAD_SYMBOL(MPI_Send, send);
     LOAD_SYMBOL(MPI_Recv, recv);
     LOAD_SYMBOL(MPI_Type_contiguous, mpi_type_contiguous);
@@ -283,6 +287,23 @@ struct MPIWrapper {
       int,
       MPI_Datatype,
       MPI_Comm);
+  int (*reduce_scatter_block)(
+      const void*,
+      void*,
+      int,
+      MPI_Datatype,
+      MPI_Op,
+      MPI_Comm);
+  int (*all_to_all_v)(
+      const void*,
+      const int*,
+      const int*,
+      MPI_Datatype,
+      void*,
+      const int*,
+      const int*,
+      MPI_Datatype,
+      MPI_Comm);
   int (*comm_split)(MPI_Comm, int, int, MPI_Comm*);
   int (*comm_free)(MPI_Comm*);
   int (*send)(const void*, int, MPI_Datatype, int, int, MPI_Comm);
@@ -390,6 +411,83 @@ class MPIGroup : public GroupImpl {
         comm_);
   }
 
+  void compressed_all_sum(
+      const array& input,
+      array& output,
+      Compression compression,
+      Stream stream) override {
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch([in_ptr = input.data<float>(),
+                      out_ptr = output.data<float>(),
+                      size = input.size(),
+                      compression,
+                      group_size = this->size(),
+                      group_rank = rank(),
+                      comm = comm_]() {
+      // Every rank sums a segment of the encoded inputs with an all to all
+      // and the encoded sums are then gathered, so each value is encoded
+      // once per phase.
+      size_t segment_size = (size + group_size - 1) / group_size;
+      size_t slot = detail::compressed_size(compression, segment_size);
+      if (slot * group_size > std::numeric_limits<int>::max()) {
+        throw std::runtime_error(
+            "[mpi] compressed_all_sum supports at most 2^31 - 1 bytes.");
+      }
+      auto count = [&](int i) {
+        return std::min(size, (i + 1) * segment_size) -
+            std::min(size, i * segment_size);
+      };
+      std::vector<char> send_buffer(slot * group_size);
+      std::vector<char> recv_buffer(slot * group_size);
+      for (int i = 0; i < group_size; i++) {
+        detail::compress(
+            compression,
+            in_ptr + std::min(size, i * segment_size),
+            count(i),
+            send_buffer.data() + i * slot);
+      }
+      std::vector<int> counts(group_size, slot);
+      std::vector<int> displs(group_size);
+      for (int i = 0; i < group_size; i++) {
+        displs[i] = i * slot;
+      }
+      mpi().all_to_all_v(
+          send_buffer.data(),
+          counts.data(),
+          displs.data(),
+          mpi().mpi_uint8_,
+          recv_buffer.data(),
+          counts.data(),
+          displs.data(),
+          mpi().mpi_uint8_,
+          comm);
+
+      std::vector<float> sum(count(group_rank), 0.0f);
+      for (int i = 0; i < group_size; i++) {
+        detail::decompress_add(
+            compression, recv_buffer.data() + i * slot, sum.size(), sum.data());
+      }
+      detail::compress(compression, sum.data(), sum.size(), send_buffer.data());
+      mpi().all_gather(
+          send_buffer.data(),
+          slot,
+          mpi().mpi_uint8_,
+          recv_buffer.data(),
+          slot,
+          mpi().mpi_uint8_,
+          comm);
+      for (int i = 0; i < group_size; i++) {
+        detail::decompress(
+            compression,
+            recv_buffer.data() + i * slot,
+            count(i),
+            out_ptr + std::min(size, i * segment_size));
+      }
+    });
+  }
+
   void all_max(const array& input, array& output, Stream stream) override {
     auto& encoder = cpu::get_command_encoder(stream);
     encoder.set_input_array(input);
@@ -435,6 +533,69 @@ class MPIGroup : public GroupImpl {
         comm_);
   }
 
+  void reduce_scatter(const array& input, array& output, Stream stream)
+      override {
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch(
+        mpi().reduce_scatter_block,
+        input.data<void>(),
+        output.data<void>(),
+        output.size(),
+        mpi().datatype(input),
+        mpi().op_sum(input),
+        comm_);
+  }
+
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<size_t>& send_counts,
+      const std::vector<size_t>& recv_counts,
+      Stream stream) override {
+    // MPI counts and displacements are ints.
+    auto to_ints = [](const std::vector<size_t>& counts) {
+      std::vector<int> ints(counts.size());
+      std::vector<int> displs(counts.size());
+      size_t offset = 0;
+      for (int i = 0; i < counts.size(); i++) {
+        ints[i] = counts[i];
+        displs[i] = offset;
+        offset += counts[i];
+      }
+      if (offset > std::numeric_limits<int>::max()) {
+        throw std::runtime_error(
+            "[mpi] all_to_all supports at most 2^31 - 1 elements.");
+      }
+      return std::make_pair(std::move(ints), std::move(displs));
+    };
+    auto [scounts, sdispls] = to_ints(send_counts);
+    auto [rcounts, rdispls] = to_ints(recv_counts);
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch([in_ptr = input.data<void>(),
+                      out_ptr = output.data<void>(),
+                      type = mpi().datatype(input),
+                      scounts = std::move(scounts),
+                      sdispls = std::move(sdispls),
+                      rcounts = std::move(rcounts),
+                      rdispls = std::move(rdispls),
+                      comm = comm_]() {
+      mpi().all_to_all_v(
+          in_ptr,
+          scounts.data(),
+          sdispls.data(),
+          type,
+          out_ptr,
+          rcounts.data(),
+          rdispls.data(),
+          type,
+          comm);
+    });
+  }
+
   void send(const array& input, int dst, Stream stream) override {
     auto& encoder = cpu::get_command_encoder(stream);
     encoder.set_input_array(input);
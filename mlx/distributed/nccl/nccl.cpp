@@ -0,0 +1,488 @@
+// Copyright © 2025 Apple Inc.
+
+#include <arpa/inet.h>
+#include <dlfcn.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+#include "mlx/backend/cuda/device.h"
+#include "mlx/distributed/distributed.h"
+#include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/nccl/nccl.h"
+#include "mlx/distributed/nccl/nccl_declarations.h"
+
+#define LOAD_SYMBOL(symbol, variable)                                \
+  {                                                                  \
+    variable = (decltype(variable))dlsym(libnccl_handle_, #symbol);  \
+    char* error = dlerror();                                         \
+    if (error != nullptr) {                                          \
+      libnccl_handle_ = nullptr;                                     \
+      return;                                                        \
+    }                                                                \
+  }
+
+#define CHECK_NCCL_ERROR(cmd) check_nccl_error(#cmd, (cmd))
+
+static constexpr const char* libnccl_name = "libnccl.so.2";
+
+constexpr int CONN_ATTEMPTS = 10;
+constexpr int CONN_WAIT = 100;
+
+namespace mlx::core::distributed::nccl {
+
+using GroupImpl = mlx::core::distributed::detail::GroupImpl;
+
+namespace {
+
+struct NCCLWrapper {
+  NCCLWrapper() : libnccl_handle_(nullptr) {
+    libnccl_handle_ = dlopen(libnccl_name, RTLD_NOW | RTLD_GLOBAL);
+    if (libnccl_handle_ == nullptr) {
+      return;
+    }
+
+    LOAD_SYMBOL(ncclGetErrorString, get_error_string);
+    LOAD_SYMBOL(ncclGetUniqueId, get_unique_id);
+    LOAD_SYMBOL(ncclCommInitRank, comm_init_rank);
+    LOAD_SYMBOL(ncclCommSplit, comm_split);
+    LOAD_SYMBOL(ncclCommDestroy, comm_destroy);
+    LOAD_SYMBOL(ncclCommCount, comm_count);
+    LOAD_SYMBOL(ncclCommUserRank, comm_user_rank);
+    LOAD_SYMBOL(ncclAllReduce, all_reduce);
+    LOAD_SYMBOL(ncclAllGather, all_gather);
+    LOAD_SYMBOL(ncclReduceScatter, reduce_scatter);
+    LOAD_SYMBOL(ncclGroupStart, group_start);
+    LOAD_SYMBOL(ncclGroupEnd, group_end);
+    LOAD_SYMBOL(ncclSend, send);
+    LOAD_SYMBOL(ncclRecv, recv);
+  }
+
+  bool is_available() {
+    return libnccl_handle_ != nullptr;
+  }
+
+  void* libnccl_handle_;
+
+  // API
+  const char* (*get_error_string)(ncclResult_t);
+  ncclResult_t (*get_unique_id)(ncclUniqueId*);
+  ncclResult_t (*comm_init_rank)(ncclComm_t*, int, ncclUniqueId, int);
+  ncclResult_t (*comm_split)(ncclComm_t, int, int, ncclComm_t*, void*);
+  ncclResult_t (*comm_destroy)(ncclComm_t);
+  ncclResult_t (*comm_count)(ncclComm_t, int*);
+  ncclResult_t (*comm_user_rank)(ncclComm_t, int*);
+  ncclResult_t (*all_reduce)(
+      const void*,
+      void*,
+      size_t,
+      ncclDataType_t,
+      ncclRedOp_t,
+      ncclComm_t,
+      cudaStream_t);
+  ncclResult_t (*all_gather)(
+      const void*,
+      void*,
+      size_t,
+      ncclDataType_t,
+      ncclComm_t,
+      cudaStream_t);
+  ncclResult_t (*reduce_scatter)(
+      const void*,
+      void*,
+      size_t,
+      ncclDataType_t,
+      ncclRedOp_t,
+      ncclComm_t,
+      cudaStream_t);
+  ncclResult_t (*group_start)();
+  ncclResult_t (*group_end)();
+  ncclResult_t (*send)(
+      const void*,
+      size_t,
+      ncclDataType_t,
+      int,
+      ncclComm_t,
+      cudaStream_t);
+  ncclResult_t (
+      *recv)(void*, size_t, ncclDataType_t, int, ncclComm_t, cudaStream_t);
+};
+
+NCCLWrapper& nccl() {
+  static NCCLWrapper wrapper;
+  return wrapper;
+}
+
+void check_nccl_error(const char* name, ncclResult_t err) {
+  if (err != ncclSuccess) {
+    std::ostringstream msg;
+    msg << "[nccl] " << name << " failed: " << nccl().get_error_string(err);
+    throw std::runtime_error(msg.str());
+  }
+}
+
+// The NCCL datatype and the number of its elements in |arr|.
+std::pair<ncclDataType_t, size_t> datatype(const array& arr) {
+  switch (arr.dtype()) {
+    case bool_:
+    case uint8:
+      return {ncclUint8, arr.size()};
+    case int8:
+      return {ncclInt8, arr.size()};
+    case int32:
+      return {ncclInt32, arr.size()};
+    case uint32:
+      return {ncclUint32, arr.size()};
+    case int64:
+      return {ncclInt64, arr.size()};
+    case uint64:
+      return {ncclUint64, arr.size()};
+    case float16:
+      return {ncclFloat16, arr.size()};
+    case bfloat16:
+      return {ncclBfloat16, arr.size()};
+    case float32:
+      return {ncclFloat32, arr.size()};
+    case float64:
+      return {ncclFloat64, arr.size()};
+    case complex64:
+      return {ncclFloat32, 2 * arr.size()};
+    default: {
+      std::ostringstream msg;
+      msg << "[nccl] Unsupported type " << arr.dtype() << ".";
+      throw std::runtime_error(msg.str());
+    }
+  }
+}
+
+/**
+ * Share the unique id created by rank 0 with all the other ranks. Rank 0
+ * accepts a connection from each of them on the provided address.
+ */
+ncclUniqueId share_unique_id(const std::string& host, int rank, int size) {
+  auto colon = host.rfind(":");
+  if (colon == std::string::npos) {
+    std::ostringstream msg;
+    msg << "[nccl] Can't parse address " << host;
+    throw std::runtime_error(msg.str());
+  }
+  std::string ip(host.begin(), host.begin() + colon);
+  std::string port(host.begin() + colon + 1, host.end());
+
+  struct addrinfo hints, *res;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  if (getaddrinfo(ip.c_str(), port.c_str(), &hints, &res) != 0) {
+    std::ostringstream msg;
+    msg << "[nccl] Can't parse address " << host;
+    throw std::runtime_error(msg.str());
+  }
+  sockaddr_storage addr;
+  socklen_t addr_len = res->ai_addrlen;
+  memcpy(&addr, res->ai_addr, res->ai_addrlen);
+  freeaddrinfo(res);
+
+  auto fail = [](const char* what, int sock) {
+    if (sock >= 0) {
+      close(sock);
+    }
+    std::ostringstream msg;
+    msg << "[nccl] " << what << " (error: " << errno << ")";
+    throw std::runtime_error(msg.str());
+  };
+
+  ncclUniqueId id;
+  if (rank == 0) {
+    CHECK_NCCL_ERROR(nccl().get_unique_id(&id));
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+      fail("Couldn't create socket", sock);
+    }
+    int enable = 1;
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(int)) < 0) {
+      fail("Couldn't enable reuseaddr", sock);
+    }
+    if (bind(sock, (struct sockaddr*)&addr, addr_len) < 0) {
+      fail("Couldn't bind socket", sock);
+    }
+    if (listen(sock, size) < 0) {
+      fail("Couldn't listen", sock);
+    }
+    for (int i = 1; i < size; i++) {
+      int peer = accept(sock, nullptr, nullptr);
+      if (peer < 0) {
+        fail("Accept failed", sock);
+      }
+      bool sent = ::send(peer, &id, sizeof(id), 0) == ssize_t(sizeof(id));
+      close(peer);
+      if (!sent) {
+        fail("Couldn't send the unique id", sock);
+      }
+    }
+    close(sock);
+    return id;
+  }
+
+  // Connect to rank 0 with exponential backoff as it may not be listening
+  // yet.
+  int sock = -1;
+  for (int attempt = 0; attempt < CONN_ATTEMPTS; attempt++) {
+    if (attempt > 0) {
+      close(sock);
+      int wait = (1 << (attempt - 1)) * CONN_WAIT;
+      std::this_thread::sleep_for(std::chrono::milliseconds(wait));
+    }
+    sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) {
+      fail("Couldn't create socket", sock);
+    }
+    if (connect(sock, (struct sockaddr*)&addr, addr_len) == 0) {
+      break;
+    }
+    if (attempt == CONN_ATTEMPTS - 1) {
+      fail("Couldn't connect", sock);
+    }
+  }
+  size_t received = 0;
+  while (received < sizeof(id)) {
+    auto r = ::recv(sock, id.internal + received, sizeof(id) - received, 0);
+    if (r <= 0) {
+      fail("Couldn't receive the unique id", sock);
+    }
+    received += r;
+  }
+  close(sock);
+  return id;
+}
+
+} // namespace
+
+class NCCLGroup : public GroupImpl {
+ public:
+  NCCLGroup(ncclComm_t comm) : comm_(comm), rank_(-1), size_(-1) {}
+
+  virtual ~NCCLGroup() {
+    nccl().comm_destroy(comm_);
+  }
+
+  // The communication is enqueued on the GPU streams.
+  Stream communication_stream(StreamOrDevice s = {}) override {
+    return to_stream(s, Device::gpu);
+  }
+
+  int rank() override {
+    if (rank_ < 0) {
+      CHECK_NCCL_ERROR(nccl().comm_user_rank(comm_, &rank_));
+    }
+    return rank_;
+  }
+
+  int size() override {
+    if (size_ < 0) {
+      CHECK_NCCL_ERROR(nccl().comm_count(comm_, &size_));
+    }
+    return size_;
+  }
+
+  std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
+    key = (key < 0) ? rank() : key;
+    ncclComm_t new_comm;
+    CHECK_NCCL_ERROR(nccl().comm_split(comm_, color, key, &new_comm, nullptr));
+    return std::make_shared<NCCLGroup>(new_comm);
+  }
+
+  void all_sum(const array& input, array& output, Stream stream) override {
+    // The sum of booleans is their logical or.
+    auto op = input.dtype() == bool_ ? ncclMax : ncclSum;
+    all_reduce(input, output, stream, op);
+  }
+
+  void all_max(const array& input, array& output, Stream stream) override {
+    all_reduce(input, output, stream, ncclMax);
+  }
+
+  void all_min(const array& input, array& output, Stream stream) override {
+    all_reduce(input, output, stream, ncclMin);
+  }
+
+  void all_gather(const array& input, array& output, Stream stream) override {
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(input);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    auto capture = encoder.capture_context();
+    CHECK_NCCL_ERROR(nccl().all_gather(
+        input.data<void>(),
+        output.data<void>(),
+        count,
+        type,
+        comm_,
+        encoder.stream()));
+  }
+
+  void reduce_scatter(const array& input, array& output, Stream stream)
+      override {
+    // The sum of booleans is their logical or.
+    auto op = input.dtype() == bool_ ? ncclMax : ncclSum;
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(output);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    auto capture = encoder.capture_context();
+    CHECK_NCCL_ERROR(nccl().reduce_scatter(
+        input.data<void>(),
+        output.data<void>(),
+        count,
+        type,
+        op,
+        comm_,
+        encoder.stream()));
+  }
+
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<size_t>& send_counts,
+      const std::vector<size_t>& recv_counts,
+      Stream stream) override {
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(input);
+    // The NCCL elements per element of the array, 2 for complex64.
+    size_t scale = input.size() > 0 ? count / input.size() : 1;
+    size_t itemsize = input.itemsize() / scale;
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    auto capture = encoder.capture_context();
+    // The sends and receives of a group run concurrently.
+    auto in_ptr = input.data<char>();
+    auto out_ptr = output.data<char>();
+    size_t send_offset = 0;
+    size_t recv_offset = 0;
+    CHECK_NCCL_ERROR(nccl().group_start());
+    for (int i = 0; i < send_counts.size(); i++) {
+      size_t send_count = send_counts[i] * scale;
+      size_t recv_count = recv_counts[i] * scale;
+      CHECK_NCCL_ERROR(nccl().send(
+          in_ptr + send_offset * itemsize,
+          send_count,
+          type,
+          i,
+          comm_,
+          encoder.stream()));
+      CHECK_NCCL_ERROR(nccl().recv(
+          out_ptr + recv_offset * itemsize,
+          recv_count,
+          type,
+          i,
+          comm_,
+          encoder.stream()));
+      send_offset += send_count;
+      recv_offset += recv_count;
+    }
+    CHECK_NCCL_ERROR(nccl().group_end());
+  }
+
+  void send(const array& input, int dst, Stream stream) override {
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(input);
+    encoder.set_input_array(input);
+    auto capture = encoder.capture_context();
+    CHECK_NCCL_ERROR(nccl().send(
+        input.data<void>(), count, type, dst, comm_, encoder.stream()));
+  }
+
+  void recv(array& out, int src, Stream stream) override {
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(out);
+    encoder.set_output_array(out);
+    auto capture = encoder.capture_context();
+    CHECK_NCCL_ERROR(nccl().recv(
+        out.data<void>(), count, type, src, comm_, encoder.stream()));
+  }
+
+ private:
+  cu::CommandEncoder& get_command_encoder(Stream stream) {
+    if (stream.device != Device::gpu) {
+      throw std::invalid_argument(
+          "[nccl] The communication must happen on a GPU stream.");
+    }
+    return cu::get_command_encoder(stream);
+  }
+
+  void all_reduce(
+      const array& input,
+      array& output,
+      Stream stream,
+      ncclRedOp_t op) {
+    if (input.dtype() == complex64 && op != ncclSum) {
+      throw std::invalid_argument(
+          "[nccl] Only the sum of complex arrays is supported.");
+    }
+    auto& encoder = get_command_encoder(stream);
+    auto [type, count] = datatype(input);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    auto capture = encoder.capture_context();
+    CHECK_NCCL_ERROR(nccl().all_reduce(
+        input.data<void>(),
+        output.data<void>(),
+        count,
+        type,
+        op,
+        comm_,
+        encoder.stream()));
+  }
+
+  ncclComm_t comm_;
+  int rank_;
+  int size_;
+};
+
+bool is_available() {
+  return nccl().is_available();
+}
+
+std::shared_ptr<GroupImpl> init(bool strict /* = false */) {
+  const char* host = std::getenv("MLX_NCCL_HOST");
+  const char* rank_str = std::getenv("MLX_RANK");
+  const char* size_str = std::getenv("MLX_WORLD_SIZE");
+
+  if (!host || !rank_str || !size_str) {
+    if (strict) {
+      std::ostringstream msg;
+      msg << "[nccl] You need to provide via environment variables a rank "
+          << "(MLX_RANK), the number of processes (MLX_WORLD_SIZE) and the "
+          << "address of rank 0 (MLX_NCCL_HOST) but provided MLX_RANK=\""
+          << ((rank_str) ? rank_str : "") << "\", MLX_WORLD_SIZE=\""
+          << ((size_str) ? size_str : "") << "\" and MLX_NCCL_HOST=\""
+          << ((host) ? host : "") << "\"";
+      throw std::runtime_error(msg.str());
+    }
+    return nullptr;
+  }
+
+  if (!is_available()) {
+    if (strict) {
+      throw std::runtime_error("[nccl] Couldn't load libnccl.");
+    }
+    return nullptr;
+  }
+
+  int rank = std::atoi(rank_str);
+  int size = std::atoi(size_str);
+  auto id = share_unique_id(host, rank, size);
+
+  // The communicator uses the current device.
+  cu::device(Device::gpu).make_current();
+  ncclComm_t comm;
+  CHECK_NCCL_ERROR(nccl().comm_init_rank(&comm, size, id, rank));
+  return std::make_shared<NCCLGroup>(comm);
+}
+
+} // namespace mlx::core::distributed::nccl
@@ -4,6 +4,7 @@
 
 #include "mlx/distributed/ops.h"
 #include "mlx/distributed/primitives.h"
+#include "mlx/ops.h"
 
 namespace mlx::core::distributed {
 
@@ -17,6 +18,36 @@ Group to_group(std::optional<Group> group) {
   }
 }
 
+const detail::HierarchicalGroup* as_hierarchical(const Group& group) {
+  return dynamic_cast<const detail::HierarchicalGroup*>(
+      group.raw_group().get());
+}
+
+// Reduce scatter |x| in the node, reduce the shards across the nodes with
+// |cross_reduce| and gather them back in the node. The streams apply to the
+// node group, the cross node group communicates on its default stream.
+template <typename F>
+array hierarchical_all_sum(
+    const array& x,
+    const detail::HierarchicalGroup& group,
+    StreamOrDevice s,
+    F cross_reduce) {
+  int n = group.local().size();
+  int size = x.size();
+  int padded_size = (size + n - 1) / n * n;
+  auto y = flatten(x, s);
+  if (padded_size != size) {
+    y = pad(y, {0, padded_size - size}, array(0, x.dtype()), "constant", s);
+  }
+  y = reduce_scatter(y, group.local(), s);
+  y = cross_reduce(y, group.cross());
+  y = all_gather(y, group.local(), s);
+  if (padded_size != size) {
+    y = slice(y, {0}, {size}, s);
+  }
+  return reshape(y, x.shape(), s);
+}
+
 } // namespace
 
 array all_sum(
@@ -28,11 +59,47 @@ array all_sum(
   if (group.size() == 1) {
     return x;
   }
+  if (auto h = as_hierarchical(group)) {
+    return hierarchical_all_sum(
+        x, *h, s, [](const array& y, Group g) { return all_sum(y, g); });
+  }
   return array(
       x.shape(),
       x.dtype(),
       std::make_shared<AllReduce>(
-          to_stream(s, Device::cpu), group, AllReduce::Sum),
+          group.raw_group()->communication_stream(s), group, AllReduce::Sum),
+      {x});
+}
+
+array compressed_all_sum(
+    const array& x,
+    Compression compression,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (x.dtype() != float32) {
+    std::ostringstream msg;
+    msg << "[compressed_all_sum] Only float32 inputs are supported but got "
+        << x.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (group.size() == 1) {
+    return x;
+  }
+  if (auto h = as_hierarchical(group)) {
+    return hierarchical_all_sum(x, *h, s, [&](const array& y, Group g) {
+      return compressed_all_sum(y, compression, g);
+    });
+  }
+  return array(
+      x.shape(),
+      x.dtype(),
+      std::make_shared<AllReduce>(
+          group.raw_group()->communication_stream(s),
+          group,
+          AllReduce::Sum,
+          compression),
       {x});
 }
 
@@ -45,11 +112,14 @@ array all_max(
   if (group.size() == 1) {
     return x;
   }
+  if (auto h = as_hierarchical(group)) {
+    return all_max(all_max(x, h->local(), s), h->cross());
+  }
   return array(
       x.shape(),
       x.dtype(),
       std::make_shared<AllReduce>(
-          to_stream(s, Device::cpu), group, AllReduce::Max),
+          group.raw_group()->communication_stream(s), group, AllReduce::Max),
       {x});
 }
 
@@ -62,11 +132,14 @@ array all_min(
   if (group.size() == 1) {
     return x;
   }
+  if (auto h = as_hierarchical(group)) {
+    return all_min(all_min(x, h->local(), s), h->cross());
+  }
   return array(
       x.shape(),
       x.dtype(),
       std::make_shared<AllReduce>(
-          to_stream(s, Device::cpu), group, AllReduce::Min),
+          group.raw_group()->communication_stream(s), group, AllReduce::Min),
       {x});
 }
 
@@ -79,6 +152,9 @@ array all_gather(
   if (group.size() == 1) {
     return x;
   }
+  if (auto h = as_hierarchical(group)) {
+    return all_gather(all_gather(x, h->local(), s), h->cross());
+  }
 
   auto result_shape = x.shape();
   if (result_shape.size() == 0) {
@@ -89,7 +165,115 @@ array all_gather(
   return array(
       std::move(result_shape),
       x.dtype(),
-      std::make_shared<AllGather>(to_stream(s, Device::cpu), group),
+      std::make_shared<AllGather>(
+          group.raw_group()->communication_stream(s), group),
+      {x});
+}
+
+array reduce_scatter(
+    const array& x,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return x;
+  }
+
+  if (x.ndim() == 0 || x.shape(0) % group.size() != 0) {
+    std::ostringstream msg;
+    msg << "[reduce_scatter] The first dimension of the input must be "
+        << "divisible by the group size " << group.size()
+        << " but the input has shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto result_shape = x.shape();
+  result_shape[0] /= group.size();
+  return array(
+      std::move(result_shape),
+      x.dtype(),
+      std::make_shared<ReduceScatter>(
+          group.raw_group()->communication_stream(s), group),
+      {x});
+}
+
+array all_to_all(
+    const array& x,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (group.size() == 1) {
+    return x;
+  }
+
+  if (x.ndim() == 0 || x.shape(0) % group.size() != 0) {
+    std::ostringstream msg;
+    msg << "[all_to_all] The first dimension of the input must be divisible "
+        << "by the group size " << group.size()
+        << " but the input has shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  std::vector<int> sizes(group.size(), x.shape(0) / group.size());
+  return all_to_all(x, sizes, sizes, group, s);
+}
+
+array all_to_all(
+    const array& x,
+    std::vector<int> send_sizes,
+    std::vector<int> recv_sizes,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+
+  if (x.ndim() == 0) {
+    throw std::invalid_argument(
+        "[all_to_all] The input must have at least one dimension.");
+  }
+  if (send_sizes.size() != group.size() || recv_sizes.size() != group.size()) {
+    std::ostringstream msg;
+    msg << "[all_to_all] Expected a send and a receive size per process "
+        << "of the group of size " << group.size() << " but got "
+        << send_sizes.size() << " and " << recv_sizes.size() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int64_t send_total = 0;
+  int64_t recv_total = 0;
+  for (int i = 0; i < group.size(); i++) {
+    if (send_sizes[i] < 0 || recv_sizes[i] < 0) {
+      throw std::invalid_argument(
+          "[all_to_all] The send and receive sizes must be non-negative.");
+    }
+    send_total += send_sizes[i];
+    recv_total += recv_sizes[i];
+  }
+  if (send_total != x.shape(0)) {
+    std::ostringstream msg;
+    msg << "[all_to_all] The send sizes add up to " << send_total
+        << " rows but the input has shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if (group.size() == 1) {
+    if (recv_sizes != send_sizes) {
+      throw std::invalid_argument(
+          "[all_to_all] A singleton group receives what it sends.");
+    }
+    return x;
+  }
+
+  auto result_shape = x.shape();
+  result_shape[0] = recv_total;
+  return array(
+      std::move(result_shape),
+      x.dtype(),
+      std::make_shared<AllToAll>(
+          group.raw_group()->communication_stream(s),
+          group,
+          std::move(send_sizes),
+          std::move(recv_sizes)),
       {x});
 }
 
@@ -114,7 +298,8 @@ array send(
   return array(
       x.shape(),
       x.dtype(),
-      std::make_shared<Send>(to_stream(s, Device::cpu), group, dst),
+      std::make_shared<Send>(
+          group.raw_group()->communication_stream(s), group, dst),
       {x});
 }
 
@@ -139,7 +324,8 @@ array recv(
   return array(
       std::move(shape),
       std::move(dtype),
-      std::make_shared<Recv>(to_stream(s, Device::cpu), group, src),
+      std::make_shared<Recv>(
+          group.raw_group()->communication_stream(s), group, src),
       std::vector<array>{});
 }
 
@@ -151,4 +337,98 @@ array recv_like(
   return recv(x.shape(), x.dtype(), src, group_, s);
 }
 
+namespace {
+
+// Check the inputs of the sharded matmuls and flatten the rows of |x|.
+array flatten_rows(
+    const char* name,
+    const array& x,
+    const array& w,
+    int chunks,
+    StreamOrDevice s) {
+  if (chunks < 1) {
+    std::ostringstream msg;
+    msg << "[" << name << "] The number of chunks must be positive but got "
+        << chunks << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (x.ndim() < 1 || w.ndim() != 2 || x.shape(-1) != w.shape(0)) {
+    std::ostringstream msg;
+    msg << "[" << name << "] Expected inputs of shape (..., K) and (K, N) "
+        << "but got " << x.shape() << " and " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return reshape(x, {-1, x.shape(-1)}, s);
+}
+
+} // namespace
+
+array matmul_all_sum(
+    const array& x,
+    const array& w,
+    int chunks /* = 1 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  auto rows = flatten_rows("matmul_all_sum", x, w, chunks, s);
+  auto out_shape = x.shape();
+  out_shape.back() = w.shape(1);
+  if (x.ndim() == 1) {
+    out_shape = {w.shape(1)};
+  }
+
+  int m = rows.shape(0);
+  chunks = std::max(std::min(chunks, m), 1);
+  int chunk_size = (m + chunks - 1) / chunks;
+  std::vector<array> outs;
+  for (int start = 0; start < m || outs.empty(); start += chunk_size) {
+    int end = std::min(start + chunk_size, m);
+    auto y = matmul(
+        slice(rows, {start, 0}, {end, rows.shape(1)}, s), w, s);
+    outs.push_back(all_sum(y, group, s));
+  }
+  auto y = outs.size() == 1 ? outs[0] : concatenate(outs, 0, s);
+  return reshape(y, std::move(out_shape), s);
+}
+
+array all_gather_matmul(
+    const array& x,
+    const array& w,
+    int chunks /* = 1 */,
+    std::optional<Group> group_ /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto group = to_group(group_);
+  auto rows = flatten_rows("all_gather_matmul", x, w, chunks, s);
+  int n = group.size();
+  auto out_shape = x.shape();
+  out_shape.back() = w.shape(1);
+  if (x.ndim() == 1) {
+    out_shape = {n, w.shape(1)};
+  } else {
+    out_shape[0] *= n;
+  }
+
+  // The gathered chunks interleave the rows of the processes, so the chunks
+  // have the same size to put the rows back in rank order.
+  int m = rows.shape(0);
+  chunks = std::max(std::min(chunks, m), 1);
+  while (m % chunks != 0) {
+    chunks--;
+  }
+  int chunk_size = m / chunks;
+  std::vector<array> outs;
+  for (int start = 0; start < m || outs.empty(); start += chunk_size) {
+    auto chunk =
+        slice(rows, {start, 0}, {start + chunk_size, rows.shape(1)}, s);
+    outs.push_back(matmul(all_gather(chunk, group, s), w, s));
+  }
+  if (outs.size() == 1) {
+    return reshape(outs[0], std::move(out_shape), s);
+  }
+  auto y = reshape(
+      concatenate(outs, 0, s), {chunks, n, chunk_size, w.shape(1)}, s);
+  y = transpose(y, {1, 0, 2, 3}, s);
+  return reshape(y, std::move(out_shape), s);
+}
+
 } // namespace mlx::core::distributed
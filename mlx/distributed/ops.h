@@ -14,6 +14,17 @@ array all_sum(
     std::optional<Group> group = std::nullopt,
     StreamOrDevice s = {});
 
+/**
+ * Sum the float32 ``x`` over the group sending the values as bfloat16 or as
+ * float8 with a scale per block. The partial sums are accumulated in
+ * float32 and every process ends with the same result.
+ */
+array compressed_all_sum(
+    const array& x,
+    Compression compression,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
 array all_gather(
     const array& x,
     std::optional<Group> group = std::nullopt,
@@ -48,4 +59,61 @@ array all_min(
     std::optional<Group> group = std::nullopt,
     StreamOrDevice s = {});
 
+/**
+ * Sum ``x`` over the group and return the chunk of the sum along the first
+ * axis which corresponds to the rank of this process.
+ */
+array reduce_scatter(
+    const array& x,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Split ``x`` along the first axis in as many equal chunks as processes,
+ * send the i-th chunk to rank i and concatenate the received chunks in rank
+ * order.
+ */
+array all_to_all(
+    const array& x,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Send ``send_sizes[i]`` rows of ``x`` to rank i and concatenate the
+ * ``recv_sizes[i]`` rows received from each rank i in rank order. The sizes
+ * sent by a rank must match the ones its peers expect to receive.
+ */
+array all_to_all(
+    const array& x,
+    std::vector<int> send_sizes,
+    std::vector<int> recv_sizes,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Multiply ``x`` by ``w`` and sum the products over the group, the
+ * row-parallel linear layer with ``x`` and ``w`` sharded along the inner
+ * axis. The rows of ``x`` are split in ``chunks`` so the sum of a chunk on
+ * the communication stream overlaps the product of the next one.
+ */
+array matmul_all_sum(
+    const array& x,
+    const array& w,
+    int chunks = 1,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Gather ``x`` along the first axis from the group and multiply it by
+ * ``w``, the column-parallel linear layer with the rows of ``x`` sharded.
+ * The rows of ``x`` are split in ``chunks`` so the product of a gathered
+ * chunk overlaps the gather of the next one on the communication stream.
+ */
+array all_gather_matmul(
+    const array& x,
+    const array& w,
+    int chunks = 1,
+    std::optional<Group> group = std::nullopt,
+    StreamOrDevice s = {});
+
 } // namespace mlx::core::distributed
@@ -14,6 +14,11 @@ std::pair<std::vector<array>, std::vector<int>> AllReduce::vmap(
     const std::vector<int>& axes) {
   switch (reduce_type_) {
     case Sum:
+      if (compression_) {
+        return {
+            {compressed_all_sum(inputs[0], *compression_, group(), stream())},
+            axes};
+      }
       return {{all_sum(inputs[0], group(), stream())}, axes};
     case Max:
       return {{all_max(inputs[0], group(), stream())}, axes};
@@ -32,6 +37,10 @@ std::vector<array> AllReduce::jvp(
     const std::vector<int>& argnums) {
   switch (reduce_type_) {
     case Sum:
+      if (compression_) {
+        return {
+            compressed_all_sum(tangents[0], *compression_, group(), stream())};
+      }
       return {all_sum(tangents[0], group(), stream())};
     case Max:
       return {all_max(tangents[0], group(), stream())};
@@ -77,6 +86,53 @@ std::vector<array> AllGather::vjp(
   return {slice(cotangents[0], starts, stops)};
 }
 
+std::vector<array> ReduceScatter::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  return {reduce_scatter(tangents[0], group(), stream())};
+}
+
+std::vector<array> ReduceScatter::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  return {all_gather(cotangents[0], group(), stream())};
+}
+
+std::pair<std::vector<size_t>, std::vector<size_t>> AllToAll::counts(
+    const array& in) const {
+  size_t row_size = 1;
+  for (int i = 1; i < in.ndim(); i++) {
+    row_size *= in.shape(i);
+  }
+  std::vector<size_t> send_counts;
+  std::vector<size_t> recv_counts;
+  for (int i = 0; i < send_sizes_.size(); i++) {
+    send_counts.push_back(send_sizes_[i] * row_size);
+    recv_counts.push_back(recv_sizes_[i] * row_size);
+  }
+  return {std::move(send_counts), std::move(recv_counts)};
+}
+
+std::vector<array> AllToAll::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  return {all_to_all(tangents[0], send_sizes_, recv_sizes_, group(), stream())};
+}
+
+std::vector<array> AllToAll::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // The cotangent of each received chunk goes back to the rank it came from.
+  return {
+      all_to_all(cotangents[0], recv_sizes_, send_sizes_, group(), stream())};
+}
+
 std::pair<std::vector<array>, std::vector<int>> Send::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <optional>
+
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/distributed_impl.h"
 #include "mlx/primitives.h"
@@ -25,8 +27,14 @@ class AllReduce : public DistPrimitive {
  public:
   enum ReduceType { And, Or, Sum, Prod, Min, Max };
 
-  AllReduce(Stream stream, Group group, ReduceType reduce_type)
-      : DistPrimitive(stream, group), reduce_type_(reduce_type) {}
+  AllReduce(
+      Stream stream,
+      Group group,
+      ReduceType reduce_type,
+      std::optional<Compression> compression = std::nullopt)
+      : DistPrimitive(stream, group),
+        reduce_type_(reduce_type),
+        compression_(compression) {}
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override;
@@ -65,6 +73,7 @@ class AllReduce : public DistPrimitive {
 
  private:
   ReduceType reduce_type_;
+  std::optional<Compression> compression_;
 };
 
 class AllGather : public DistPrimitive {
@@ -92,6 +101,65 @@ class AllGather : public DistPrimitive {
   DEFINE_NAME(AllGather);
 };
 
+class ReduceScatter : public DistPrimitive {
+ public:
+  ReduceScatter(Stream stream, Group group) : DistPrimitive(stream, group) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_NAME(ReduceScatter);
+};
+
+class AllToAll : public DistPrimitive {
+ public:
+  AllToAll(
+      Stream stream,
+      Group group,
+      std::vector<int> send_sizes,
+      std::vector<int> recv_sizes)
+      : DistPrimitive(stream, group),
+        send_sizes_(std::move(send_sizes)),
+        recv_sizes_(std::move(recv_sizes)) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> jvp(
+      const std::vector<array>& primals,
+      const std::vector<array>& tangents,
+      const std::vector<int>& argnums) override;
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_NAME(AllToAll);
+
+  // The number of elements sent to and received from each rank.
+  std::pair<std::vector<size_t>, std::vector<size_t>> counts(
+      const array& in) const;
+
+ private:
+  std::vector<int> send_sizes_;
+  std::vector<int> recv_sizes_;
+};
+
 class Send : public DistPrimitive {
  public:
   Send(Stream stream, Group group, int dst)
@@ -0,0 +1,521 @@
+// Copyright © 2025 Apple Inc.
+
+#include <arpa/inet.h>
+#include <infiniband/verbs.h>
+#include <unistd.h>
+
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#include "mlx/distributed/ring/ibverbs.h"
+#include "mlx/utils.h"
+
+namespace mlx::core::distributed::ring::ibverbs {
+
+namespace {
+
+// The receive slots of each side. The sender writes a packet per slot and
+// waits for the receiver to hand the slot back with a credit.
+constexpr int num_slots = 16;
+constexpr size_t slot_size = 1 << 20;
+
+// The immediate data of the writes is the size of the packet or, with the
+// highest bit, a credit returning a slot.
+constexpr uint32_t credit_flag = 1u << 31;
+
+// The work requests of the completions.
+constexpr uint64_t wr_data = 0;
+constexpr uint64_t wr_credit = 1;
+constexpr uint64_t wr_recv = 2;
+
+struct PeerInfo {
+  uint32_t qp_num;
+  uint16_t lid;
+  uint8_t mtu;
+  uint8_t use_grh;
+  uint8_t gid[16];
+  uint64_t addr;
+  uint32_t rkey;
+};
+
+void log_message(const std::string& msg) {
+  std::cerr << "[ring] " << msg << std::endl;
+}
+
+bool write_all(int socket, const void* data, size_t size) {
+  auto ptr = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t r = ::write(socket, ptr, size);
+    if (r <= 0) {
+      return false;
+    }
+    ptr += r;
+    size -= r;
+  }
+  return true;
+}
+
+bool read_all(int socket, void* data, size_t size) {
+  auto ptr = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t r = ::read(socket, ptr, size);
+    if (r <= 0) {
+      return false;
+    }
+    ptr += r;
+    size -= r;
+  }
+  return true;
+}
+
+// Exchange a value with the peer. The writes are small enough to not block
+// so both sides can write first.
+template <typename T>
+void exchange(int socket, const T& mine, T& theirs) {
+  if (!write_all(socket, &mine, sizeof(T)) ||
+      !read_all(socket, &theirs, sizeof(T))) {
+    throw std::runtime_error("[ring] Failed to exchange the ibverbs info.");
+  }
+}
+
+class IBVerbsChannel : public Channel {
+ public:
+  IBVerbsChannel(ibv_context* context, int port)
+      : context_(context), port_(port) {}
+
+  ~IBVerbsChannel() override {
+    if (worker_.joinable()) {
+      {
+        std::lock_guard lock(mutex_);
+        stop_ = true;
+      }
+      condition_.notify_all();
+      worker_.join();
+    }
+    if (qp_) {
+      ibv_destroy_qp(qp_);
+    }
+    if (cq_) {
+      ibv_destroy_cq(cq_);
+    }
+    if (send_mr_) {
+      ibv_dereg_mr(send_mr_);
+    }
+    if (recv_mr_) {
+      ibv_dereg_mr(recv_mr_);
+    }
+    if (pd_) {
+      ibv_dealloc_pd(pd_);
+    }
+    ibv_close_device(context_);
+  }
+
+  void connect(int socket, bool verbose) {
+    ibv_port_attr port_attr;
+    if (ibv_query_port(context_, port_, &port_attr)) {
+      throw std::runtime_error("[ring] Failed to query the ibverbs port.");
+    }
+
+    // The staging buffers of the sends and the slots the peer writes into
+    // are registered once for the lifetime of the channel.
+    send_buffer_.reset(new char[num_slots * slot_size]);
+    recv_buffer_.reset(new char[num_slots * slot_size]);
+    pd_ = ibv_alloc_pd(context_);
+    if (pd_) {
+      send_mr_ = ibv_reg_mr(
+          pd_,
+          send_buffer_.get(),
+          num_slots * slot_size,
+          IBV_ACCESS_LOCAL_WRITE);
+      recv_mr_ = ibv_reg_mr(
+          pd_,
+          recv_buffer_.get(),
+          num_slots * slot_size,
+          IBV_ACCESS_LOCAL_WRITE | IBV_ACCESS_REMOTE_WRITE);
+    }
+    // Every slot may hold a packet and a credit in flight in each direction.
+    if (send_mr_ && recv_mr_) {
+      cq_ = ibv_create_cq(context_, 8 * num_slots, nullptr, nullptr, 0);
+    }
+    if (cq_) {
+      ibv_qp_init_attr init_attr = {};
+      init_attr.send_cq = cq_;
+      init_attr.recv_cq = cq_;
+      init_attr.qp_type = IBV_QPT_RC;
+      init_attr.cap.max_send_wr = 2 * num_slots;
+      init_attr.cap.max_recv_wr = 2 * num_slots;
+      init_attr.cap.max_send_sge = 1;
+      init_attr.cap.max_recv_sge = 1;
+      qp_ = ibv_create_qp(pd_, &init_attr);
+    }
+    if (!qp_) {
+      throw std::runtime_error("[ring] Failed to create the ibverbs queues.");
+    }
+
+    ibv_qp_attr attr = {};
+    attr.qp_state = IBV_QPS_INIT;
+    attr.pkey_index = 0;
+    attr.port_num = port_;
+    attr.qp_access_flags = IBV_ACCESS_REMOTE_WRITE;
+    if (ibv_modify_qp(
+            qp_,
+            &attr,
+            IBV_QP_STATE | IBV_QP_PKEY_INDEX | IBV_QP_PORT |
+                IBV_QP_ACCESS_FLAGS)) {
+      throw std::runtime_error("[ring] Failed to initialize the ibverbs QP.");
+    }
+    for (int i = 0; i < 2 * num_slots; i++) {
+      post_recv();
+    }
+
+    int gid_index = env::get_var("MLX_RING_RDMA_GID_INDEX", 0);
+    PeerInfo mine = {};
+    mine.qp_num = qp_->qp_num;
+    mine.lid = port_attr.lid;
+    mine.mtu = port_attr.active_mtu;
+    mine.use_grh = port_attr.link_layer == IBV_LINK_LAYER_ETHERNET ||
+        std::getenv("MLX_RING_RDMA_GID_INDEX") != nullptr;
+    if (mine.use_grh) {
+      ibv_gid gid;
+      if (ibv_query_gid(context_, port_, gid_index, &gid)) {
+        throw std::runtime_error("[ring] Failed to query the ibverbs GID.");
+      }
+      std::memcpy(mine.gid, gid.raw, sizeof(mine.gid));
+    }
+    mine.addr = reinterpret_cast<uint64_t>(recv_buffer_.get());
+    mine.rkey = recv_mr_->rkey;
+    exchange(socket, mine, peer_);
+
+    attr = {};
+    attr.qp_state = IBV_QPS_RTR;
+    attr.path_mtu = static_cast<ibv_mtu>(std::min(mine.mtu, peer_.mtu));
+    attr.dest_qp_num = peer_.qp_num;
+    attr.rq_psn = 0;
+    attr.max_dest_rd_atomic = 1;
+    attr.min_rnr_timer = 12;
+    attr.ah_attr.dlid = peer_.lid;
+    attr.ah_attr.port_num = port_;
+    if (mine.use_grh || peer_.use_grh) {
+      attr.ah_attr.is_global = 1;
+      attr.ah_attr.grh.hop_limit = 1;
+      attr.ah_attr.grh.sgid_index = gid_index;
+      std::memcpy(attr.ah_attr.grh.dgid.raw, peer_.gid, sizeof(peer_.gid));
+    }
+    if (ibv_modify_qp(
+            qp_,
+            &attr,
+            IBV_QP_STATE | IBV_QP_AV | IBV_QP_PATH_MTU | IBV_QP_DEST_QPN |
+                IBV_QP_RQ_PSN | IBV_QP_MAX_DEST_RD_ATOMIC |
+                IBV_QP_MIN_RNR_TIMER)) {
+      throw std::runtime_error("[ring] Failed to connect the ibverbs QP.");
+    }
+
+    attr = {};
+    attr.qp_state = IBV_QPS_RTS;
+    attr.timeout = 14;
+    attr.retry_cnt = 7;
+    attr.rnr_retry = 7;
+    attr.sq_psn = 0;
+    attr.max_rd_atomic = 1;
+    if (ibv_modify_qp(
+            qp_,
+            &attr,
+            IBV_QP_STATE | IBV_QP_TIMEOUT | IBV_QP_RETRY_CNT |
+                IBV_QP_RNR_RETRY | IBV_QP_SQ_PSN | IBV_QP_MAX_QP_RD_ATOMIC)) {
+      throw std::runtime_error("[ring] Failed to connect the ibverbs QP.");
+    }
+
+    // Wait for the peer to be ready to receive before the first write.
+    char ready = 1;
+    exchange(socket, ready, ready);
+
+    if (verbose) {
+      std::ostringstream msg;
+      msg << "Connected " << ibv_get_device_name(context_->device)
+          << " to the QP " << peer_.qp_num;
+      log_message(msg.str());
+    }
+    worker_ = std::thread(&IBVerbsChannel::worker, this);
+  }
+
+  std::future<void> send(const char* buffer, size_t size) override {
+    return enqueue(sends_, const_cast<char*>(buffer), size);
+  }
+
+  std::future<void> recv(char* buffer, size_t size) override {
+    return enqueue(recvs_, buffer, size);
+  }
+
+ private:
+  struct Task {
+    char* buffer;
+    size_t size;
+    std::promise<void> promise;
+  };
+
+  struct Packet {
+    int slot;
+    size_t offset;
+    size_t size;
+  };
+
+  std::future<void> enqueue(std::list<Task>& tasks, char* buffer, size_t size) {
+    std::promise<void> promise;
+    auto future = promise.get_future();
+    if (size == 0) {
+      promise.set_value();
+      return future;
+    }
+    {
+      std::lock_guard lock(mutex_);
+      tasks.push_back(Task{buffer, size, std::move(promise)});
+    }
+    condition_.notify_one();
+    return future;
+  }
+
+  void post_recv() {
+    ibv_recv_wr wr = {};
+    ibv_recv_wr* bad_wr;
+    wr.wr_id = wr_recv;
+    if (ibv_post_recv(qp_, &wr, &bad_wr)) {
+      throw std::runtime_error("[ring] Failed to post an ibverbs receive.");
+    }
+  }
+
+  bool post_write(int slot, size_t size, uint32_t imm, uint64_t wr_id) {
+    ibv_sge sge = {};
+    sge.addr =
+        reinterpret_cast<uint64_t>(send_buffer_.get() + slot * slot_size);
+    sge.length = size;
+    sge.lkey = send_mr_->lkey;
+    ibv_send_wr wr = {};
+    ibv_send_wr* bad_wr;
+    wr.wr_id = wr_id;
+    wr.sg_list = size > 0 ? &sge : nullptr;
+    wr.num_sge = size > 0 ? 1 : 0;
+    wr.opcode = IBV_WR_RDMA_WRITE_WITH_IMM;
+    wr.send_flags = IBV_SEND_SIGNALED;
+    wr.imm_data = htonl(imm);
+    wr.wr.rdma.remote_addr = peer_.addr + slot * slot_size;
+    wr.wr.rdma.rkey = peer_.rkey;
+    return ibv_post_send(qp_, &wr, &bad_wr) == 0;
+  }
+
+  // Copy the sends into the staging slots and write them to the peer while
+  // it has free slots.
+  bool progress_sends(std::list<Task>& sends) {
+    while (!sends.empty() && credits_ > 0 && in_flight_ < num_slots) {
+      auto& task = sends.front();
+      int slot = sent_ % num_slots;
+      size_t n = std::min(task.size, slot_size);
+      std::memcpy(send_buffer_.get() + slot * slot_size, task.buffer, n);
+      if (!post_write(slot, n, n, wr_data)) {
+        log_message("Posting an ibverbs write failed.");
+        return false;
+      }
+      sent_++;
+      credits_--;
+      in_flight_++;
+      task.buffer += n;
+      task.size -= n;
+      if (task.size == 0) {
+        task.promise.set_value();
+        sends.pop_front();
+      }
+    }
+    return true;
+  }
+
+  // Copy the received packets into the receives and hand the emptied slots
+  // back to the peer.
+  bool progress_recvs(std::list<Task>& recvs) {
+    while (!recvs.empty() && !packets_.empty()) {
+      auto& task = recvs.front();
+      auto& packet = packets_.front();
+      size_t n = std::min(task.size, packet.size);
+      std::memcpy(
+          task.buffer,
+          recv_buffer_.get() + packet.slot * slot_size + packet.offset,
+          n);
+      task.buffer += n;
+      task.size -= n;
+      packet.offset += n;
+      packet.size -= n;
+      if (packet.size == 0) {
+        packets_.pop_front();
+        free_slots_++;
+      }
+      if (task.size == 0) {
+        task.promise.set_value();
+        recvs.pop_front();
+      }
+    }
+    // The emptied slots are returned together, with at most one credit per
+    // slot in flight so that the send queue never overflows.
+    if (free_slots_ > 0 && credits_in_flight_ < num_slots) {
+      if (!post_write(0, 0, credit_flag | free_slots_, wr_credit)) {
+        log_message("Posting an ibverbs credit failed.");
+        return false;
+      }
+      free_slots_ = 0;
+      credits_in_flight_++;
+    }
+    return true;
+  }
+
+  bool poll() {
+    ibv_wc wc[16];
+    int n = ibv_poll_cq(cq_, 16, wc);
+    if (n < 0) {
+      log_message("Polling the ibverbs completion queue failed.");
+      return false;
+    }
+    for (int i = 0; i < n; i++) {
+      if (wc[i].status != IBV_WC_SUCCESS) {
+        std::ostringstream msg;
+        msg << "An ibverbs operation failed with "
+            << ibv_wc_status_str(wc[i].status);
+        log_message(msg.str());
+        return false;
+      }
+      if (wc[i].wr_id == wr_data) {
+        in_flight_--;
+      } else if (wc[i].wr_id == wr_credit) {
+        credits_in_flight_--;
+      } else if (wc[i].wr_id == wr_recv) {
+        uint32_t imm = ntohl(wc[i].imm_data);
+        if (imm & credit_flag) {
+          credits_ += imm & ~credit_flag;
+        } else {
+          packets_.push_back(Packet{int(received_ % num_slots), 0, imm});
+          received_++;
+        }
+        post_recv();
+      }
+    }
+    return true;
+  }
+
+  void worker() {
+    // The tasks are moved out of the shared queues so that the copies run
+    // without the lock.
+    std::list<Task> sends;
+    std::list<Task> recvs;
+    while (true) {
+      {
+        std::unique_lock lock(mutex_);
+        if (sends.empty() && recvs.empty()) {
+          condition_.wait(lock, [this] {
+            return stop_ || !sends_.empty() || !recvs_.empty();
+          });
+        }
+        if (stop_) {
+          return;
+        }
+        sends.splice(sends.end(), sends_);
+        recvs.splice(recvs.end(), recvs_);
+      }
+      try {
+        if (!poll() || !progress_sends(sends) || !progress_recvs(recvs)) {
+          log_message("Too many ibverbs errors. Aborting...");
+          return;
+        }
+      } catch (const std::exception& e) {
+        log_message(e.what());
+        return;
+      }
+    }
+  }
+
+  ibv_context* context_;
+  int port_;
+  ibv_pd* pd_{nullptr};
+  ibv_mr* send_mr_{nullptr};
+  ibv_mr* recv_mr_{nullptr};
+  ibv_cq* cq_{nullptr};
+  ibv_qp* qp_{nullptr};
+  PeerInfo peer_;
+  std::unique_ptr<char[]> send_buffer_;
+  std::unique_ptr<char[]> recv_buffer_;
+
+  // Only touched by the worker once connected.
+  int credits_{num_slots};
+  int in_flight_{0};
+  int free_slots_{0};
+  int credits_in_flight_{0};
+  uint64_t sent_{0};
+  uint64_t received_{0};
+  std::deque<Packet> packets_;
+
+  bool stop_{false};
+  std::thread worker_;
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::list<Task> sends_;
+  std::list<Task> recvs_;
+};
+
+// Open the requested device, or the first one with an active port.
+std::unique_ptr<IBVerbsChannel> open_channel() {
+  const char* name = std::getenv("MLX_RING_RDMA_DEVICE");
+  int num_devices = 0;
+  ibv_device** devices = ibv_get_device_list(&num_devices);
+  if (devices == nullptr) {
+    return nullptr;
+  }
+  std::unique_ptr<IBVerbsChannel> channel;
+  for (int i = 0; i < num_devices && !channel; i++) {
+    if (name && std::strcmp(ibv_get_device_name(devices[i]), name) != 0) {
+      continue;
+    }
+    ibv_context* context = ibv_open_device(devices[i]);
+    if (context == nullptr) {
+      continue;
+    }
+    ibv_device_attr device_attr;
+    int port = 0;
+    if (ibv_query_device(context, &device_attr) == 0) {
+      for (int p = 1; p <= device_attr.phys_port_cnt && port == 0; p++) {
+        ibv_port_attr port_attr;
+        if (ibv_query_port(context, p, &port_attr) == 0 &&
+            port_attr.state == IBV_PORT_ACTIVE) {
+          port = p;
+        }
+      }
+    }
+    if (port == 0) {
+      ibv_close_device(context);
+      continue;
+    }
+    channel = std::make_unique<IBVerbsChannel>(context, port);
+  }
+  ibv_free_device_list(devices);
+  return channel;
+}
+
+} // namespace
+
+std::unique_ptr<Channel> connect(int socket, bool verbose) {
+  auto channel = open_channel();
+  char mine = channel != nullptr;
+  char theirs = 0;
+  exchange(socket, mine, theirs);
+  if (!mine || !theirs) {
+    if (verbose) {
+      log_message("No RDMA device on one of the sides, falling back to TCP.");
+    }
+    return nullptr;
+  }
+  channel->connect(socket, verbose);
+  return channel;
+}
+
+} // namespace mlx::core::distributed::ring::ibverbs
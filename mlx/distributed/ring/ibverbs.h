@@ -0,0 +1,38 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <future>
+#include <memory>
+
+namespace mlx::core::distributed::ring {
+
+/**
+ * A byte stream to and from a neighbor of the ring. The sends and the
+ * receives complete in the order they are made and a receive may be made
+ * before or after the matching send.
+ */
+class Channel {
+ public:
+  virtual ~Channel() {}
+
+  virtual std::future<void> send(const char* buffer, size_t size) = 0;
+  virtual std::future<void> recv(char* buffer, size_t size) = 0;
+};
+
+namespace ibverbs {
+
+/**
+ * Agree with the peer at the other end of the connected |socket| on an
+ * ibverbs channel and connect it. It returns nullptr, and the socket is used
+ * instead, when either of them has no usable RDMA device.
+ *
+ * The device is the first one with an active port unless
+ * MLX_RING_RDMA_DEVICE names one, and MLX_RING_RDMA_GID_INDEX selects the
+ * GID, for instance the RoCE v2 one.
+ */
+std::unique_ptr<Channel> connect(int socket, bool verbose);
+
+} // namespace ibverbs
+
+} // namespace mlx::core::distributed::ring
@@ -0,0 +1,25 @@
+// Copyright © 2025 Apple Inc.
+
+#include <unistd.h>
+
+#include <iostream>
+
+#include "mlx/distributed/ring/ibverbs.h"
+
+namespace mlx::core::distributed::ring::ibverbs {
+
+std::unique_ptr<Channel> connect(int socket, bool verbose) {
+  // Tell the peer, which may have an RDMA device, to use the socket.
+  char mine = 0;
+  char theirs = 0;
+  if (::write(socket, &mine, 1) != 1 || ::read(socket, &theirs, 1) != 1) {
+    throw std::runtime_error("[ring] Failed to exchange the ibverbs info.");
+  }
+  if (verbose) {
+    std::cerr << "[ring] Built without ibverbs, falling back to TCP."
+              << std::endl;
+  }
+  return nullptr;
+}
+
+} // namespace mlx::core::distributed::ring::ibverbs
@@ -20,9 +20,16 @@
 #include <json.hpp>
 
 #include "mlx/backend/cpu/encoder.h"
+#include "mlx/backend/cpu/simd/simd.h"
+#include "mlx/backend/cpu/threading.h"
+#include "mlx/distributed/compression.h"
 #include "mlx/distributed/distributed.h"
 #include "mlx/distributed/distributed_impl.h"
+#include "mlx/distributed/ops.h"
+#include "mlx/distributed/ring/ibverbs.h"
 #include "mlx/threadpool.h"
+#include "mlx/transforms.h"
+#include "mlx/utils.h"
 
 #ifndef SOL_TCP
 #define SOL_TCP IPPROTO_TCP
@@ -90,8 +97,6 @@
 
 namespace mlx::core::distributed::ring {
 
-constexpr const size_t ALL_SUM_SIZE = 8 * 1024 * 1024;
-constexpr const size_t ALL_SUM_BUFFERS = 2;
 constexpr const int CONN_ATTEMPTS = 5;
 constexpr const int CONN_WAIT = 1000;
 
@@ -125,14 +130,14 @@ decltype(T() * U()) ceildiv(T a, U b) {
   return (a + b - 1) / b;
 }
 
-class SocketThread {
+class SocketThread : public Channel {
  public:
   SocketThread(int fd) : fd_(fd), stop_(false) {
     worker_ = std::thread(&SocketThread::worker, this);
     int flags = fcntl(fd, F_GETFL, 0);
     fcntl(fd, F_SETFL, flags | O_NONBLOCK);
   }
-  ~SocketThread() {
+  ~SocketThread() override {
     stop_ = true;
     condition_.notify_all();
     worker_.join();
@@ -140,28 +145,7 @@ class SocketThread {
     fcntl(fd_, F_SETFL, flags & ~O_NONBLOCK);
   }
 
-  template <typename T>
-  std::future<void> send(const T* buffer, size_t size) {
-    return send_impl(reinterpret_cast<const char*>(buffer), size * sizeof(T));
-  }
-
-  template <typename T>
-  std::future<void> recv(T* buffer, size_t size) {
-    return recv_impl(reinterpret_cast<char*>(buffer), size * sizeof(T));
-  }
-
- private:
-  struct SocketTask {
-    SocketTask(void* b, size_t s, std::promise<void>&& p)
-        : buffer(b), size(s), promise(std::move(p)) {}
-    SocketTask(SocketTask&& t)
-        : buffer(t.buffer), size(t.size), promise(std::move(t.promise)) {}
-    void* buffer;
-    size_t size;
-    std::promise<void> promise;
-  };
-
-  std::future<void> send_impl(const char* buffer, size_t size) {
+  std::future<void> send(const char* buffer, size_t size) override {
     std::promise<void> send_completed_promise;
     auto send_completed_future = send_completed_promise.get_future();
     if (size == 0) {
@@ -178,7 +162,7 @@ class SocketThread {
     return send_completed_future;
   }
 
-  std::future<void> recv_impl(char* buffer, size_t size) {
+  std::future<void> recv(char* buffer, size_t size) override {
     std::promise<void> recv_completed_promise;
     auto recv_completed_future = recv_completed_promise.get_future();
     if (size == 0) {
@@ -195,6 +179,18 @@ class SocketThread {
     return recv_completed_future;
   }
 
+
+ private:
+  struct SocketTask {
+    SocketTask(void* b, size_t s, std::promise<void>&& p)
+        : buffer(b), size(s), promise(std::move(p)) {}
+    SocketTask(SocketTask&& t)
+        : buffer(t.buffer), size(t.size), promise(std::move(t.promise)) {}
+    void* buffer;
+    size_t size;
+    std::promise<void> promise;
+  };
+
   bool have_tasks() {
     return !(sends_.empty() && recvs_.empty());
   }
@@ -276,24 +272,36 @@ class SocketThread {
 
 class CommunicationThreads {
  public:
-  void add(const std::vector<int>& sockets) {
+  // Communicate over ibverbs when |rdma| and both ends have an RDMA device
+  // or else over the sockets, which are connected to the same peers in the
+  // same order on both ends.
+  void add(const std::vector<int>& sockets, bool rdma, bool verbose) {
     for (int sock : sockets) {
-      threads_.emplace(sock, sock);
+      std::unique_ptr<Channel> channel;
+      if (rdma) {
+        channel = ibverbs::connect(sock, verbose);
+      }
+      if (!channel) {
+        channel = std::make_unique<SocketThread>(sock);
+      }
+      threads_.emplace(sock, std::move(channel));
     }
   }
 
   template <typename T>
   std::future<void> send(int socket, T* buffer, size_t size) {
-    return threads_.at(socket).send<T>(buffer, size);
+    return threads_.at(socket)->send(
+        reinterpret_cast<const char*>(buffer), size * sizeof(T));
   }
 
   template <typename T>
   std::future<void> recv(int socket, T* buffer, size_t size) {
-    return threads_.at(socket).recv<T>(buffer, size);
+    return threads_.at(socket)->recv(
+        reinterpret_cast<char*>(buffer), size * sizeof(T));
   }
 
  private:
-  std::unordered_map<int, SocketThread> threads_;
+  std::unordered_map<int, std::unique_ptr<Channel>> threads_;
 };
 
 struct address_t {
@@ -374,10 +382,12 @@ std::vector<std::vector<address_t>> load_nodes(const char* hostfile) {
 }
 
 /**
- * Create a socket and accept one connection for each of the provided
- * addresses.
+ * Create a socket and accept |connections| connections for each of the
+ * provided addresses.
  */
-std::vector<int> accept_connections(const std::vector<address_t>& addresses) {
+std::vector<int> accept_connections(
+    const std::vector<address_t>& addresses,
+    int connections) {
   std::vector<int> sockets;
   int success;
 
@@ -421,7 +431,7 @@ std::vector<int> accept_connections(const std::vector<address_t>& addresses) {
     }
 
     // Wait for connections
-    success = listen(sock, 0);
+    success = listen(sock, connections);
     if (success < 0) {
       shutdown(sock, 2);
       close(sock);
@@ -430,36 +440,41 @@ std::vector<int> accept_connections(const std::vector<address_t>& addresses) {
       throw std::runtime_error(msg.str());
     }
 
-    int peer_socket = accept(sock, nullptr, nullptr);
-    if (peer_socket < 0) {
-      shutdown(sock, 2);
-      close(sock);
-      std::ostringstream msg;
-      msg << "[ring] Accept failed (error: " << errno << ")";
-      throw std::runtime_error(msg.str());
+    // The peer connects one at a time so the connections are accepted in
+    // the order they are made.
+    for (int i = 0; i < connections; i++) {
+      int peer_socket = accept(sock, nullptr, nullptr);
+      if (peer_socket < 0) {
+        shutdown(sock, 2);
+        close(sock);
+        std::ostringstream msg;
+        msg << "[ring] Accept failed (error: " << errno << ")";
+        throw std::runtime_error(msg.str());
+      }
+      sockets.push_back(peer_socket);
     }
 
     // Close the listening socket
     shutdown(sock, 2);
     close(sock);
-
-    sockets.push_back(peer_socket);
   }
 
   return sockets;
 }
 
 /**
- * The counterpoint of `accept_connections`. Basically connect to each of the
- * provided addresses.
+ * The counterpoint of `accept_connections`. Basically connect |connections|
+ * times to each of the provided addresses.
  */
 std::vector<int> make_connections(
     const std::vector<address_t>& addresses,
+    int connections,
     bool verbose) {
   std::vector<int> sockets;
   int success;
 
-  for (auto& address : addresses) {
+  for (int i = 0; i < addresses.size() * connections; i++) {
+    auto& address = addresses[i / connections];
     int sock;
 
     // Attempt to connect to the peer CONN_ATTEMPTS times with exponential
@@ -503,65 +518,107 @@ std::vector<int> make_connections(
 
   return sockets;
 }
+// Reduce |input| into |output| with |op|, in SIMD vectors for the types
+// which have them and split over the CPU threads when large.
+template <typename T, typename Op>
+void reduce_inplace(const T* input, T* output, size_t N, Op op) {
+  auto reduce_chunk = [input, output, op](size_t i, size_t end) {
+    constexpr int n = simd::max_size<T>;
+    if constexpr (n > 1) {
+      for (; i + n <= end; i += n) {
+        simd::store<T, n>(
+            output + i,
+            op(simd::load<T, n>(output + i), simd::load<T, n>(input + i)));
+      }
+    }
+    for (; i < end; i++) {
+      output[i] = op(output[i], input[i]);
+    }
+  };
+  if (N < cpu::min_parallel_size) {
+    reduce_chunk(0, N);
+  } else {
+    cpu::parallel_for(N, cpu::min_parallel_size, reduce_chunk);
+  }
+}
+
 template <typename T>
 struct SumOp {
   void operator()(const T* input, T* output, size_t N) {
-    while (N-- > 0) {
-      *output += *input;
-      input++;
-      output++;
-    }
+    reduce_inplace(input, output, N, [](auto a, auto b) { return a + b; });
   }
 };
 
 template <typename T>
 struct MaxOp {
   void operator()(const T* input, T* output, size_t N) {
-    while (N-- > 0) {
-      *output = std::max(*output, *input);
-      input++;
-      output++;
-    }
+    reduce_inplace(input, output, N, [](auto a, auto b) {
+      if constexpr (std::is_same_v<decltype(a), T>) {
+        return std::max(a, b);
+      } else {
+        return simd::maximum(a, b);
+      }
+    });
   }
 };
 
 template <typename T>
 struct MinOp {
   void operator()(const T* input, T* output, size_t N) {
-    while (N-- > 0) {
-      *output = std::min(*output, *input);
-      input++;
-      output++;
-    }
+    reduce_inplace(input, output, N, [](auto a, auto b) {
+      if constexpr (std::is_same_v<decltype(a), T>) {
+        return std::min(a, b);
+      } else {
+        return simd::minimum(a, b);
+      }
+    });
   }
 };
 
 } // namespace
 
-class RingGroup : public GroupImpl {
+class RingGroup : public GroupImpl,
+                  public std::enable_shared_from_this<RingGroup> {
  public:
   RingGroup(int rank, std::vector<std::vector<address_t>> nodes, bool verbose)
-      : rank_(rank), verbose_(verbose), pool_(0) {
+      : rank_(rank),
+        nodes_(nodes),
+        verbose_(verbose),
+        packet_size_(env::get_var("MLX_RING_PACKET_SIZE", 8 * 1024 * 1024)),
+        num_buffers_(std::max(env::get_var("MLX_RING_BUFFERS", 2), 1)),
+        min_send_size_(env::get_var("MLX_RING_MIN_SEND_SIZE", 262144)),
+        pool_(0) {
+    // Enough for the smallest packets of all_reduce_impl.
+    packet_size_ = std::max(packet_size_, size_t(32768) * 8);
+    int connections = std::max(env::get_var("MLX_RING_CONNECTIONS", 1), 1);
     if (rank_ > 0 && rank_ >= nodes.size()) {
       throw std::runtime_error(
           "[ring] Rank cannot be larger than the size of the group");
     }
 
     size_ = nodes.size();
+    // A singleton group doesn't communicate.
+    if (size_ == 1) {
+      return;
+    }
     int connect_to = (rank_ + 1) % size_;
 
     // We define the connection order by having the rank_ == size_ - 1 connect
     // first and accept after.
     if (rank_ < connect_to) {
       log_info(verbose_, "Rank", rank_, "accepting");
-      sockets_left_ = std::move(accept_connections(nodes[rank_]));
+      sockets_left_ =
+          std::move(accept_connections(nodes[rank_], connections));
       log_info(verbose_, "Rank", rank_, "connecting to", connect_to);
-      sockets_right_ = std::move(make_connections(nodes[connect_to], verbose));
+      sockets_right_ = std::move(
+          make_connections(nodes[connect_to], connections, verbose));
     } else {
       log_info(verbose_, "Rank", rank_, "connecting to", connect_to);
-      sockets_right_ = std::move(make_connections(nodes[connect_to], verbose));
+      sockets_right_ = std::move(
+          make_connections(nodes[connect_to], connections, verbose));
       log_info(verbose_, "Rank", rank_, "accepting");
-      sockets_left_ = std::move(accept_connections(nodes[rank_]));
+      sockets_left_ =
+          std::move(accept_connections(nodes[rank_], connections));
     }
 
     // Failure if we couldn't make right or left sockets
@@ -598,14 +655,21 @@ class RingGroup : public GroupImpl {
     pool_.resize(sockets_right_.size() + sockets_left_.size());
 
     // Create a communication thread per socket. This also converts them to
-    // non-blocking.
-    comm_.add(sockets_right_);
-    comm_.add(sockets_left_);
+    // non-blocking. The ibverbs handshakes follow the order of the
+    // connections so that each waits on a peer which is doing the same.
+    bool rdma = env::get_var("MLX_RING_RDMA", 0);
+    if (rank_ < connect_to) {
+      comm_.add(sockets_left_, rdma, verbose_);
+      comm_.add(sockets_right_, rdma, verbose_);
+    } else {
+      comm_.add(sockets_right_, rdma, verbose_);
+      comm_.add(sockets_left_, rdma, verbose_);
+    }
 
     // Allocate buffers for the all sum
     buffers_.resize(
-        (sockets_right_.size() + sockets_left_.size()) * ALL_SUM_BUFFERS *
-        ALL_SUM_SIZE);
+        (sockets_right_.size() + sockets_left_.size()) * num_buffers_ *
+        packet_size_);
   }
 
   ~RingGroup() {
@@ -632,6 +696,52 @@ class RingGroup : public GroupImpl {
         output, all_reduce<T, SumOp<T>>(input, output, stream, SumOp<T>()));
   }
 
+  void compressed_all_sum(
+      const array& input,
+      array& output,
+      Compression compression,
+      Stream stream) override {
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch([in_ptr = input.data<float>(),
+                      out_ptr = output.data<float>(),
+                      size = input.size(),
+                      compression,
+                      this]() {
+      if (in_ptr != out_ptr) {
+        std::memcpy(out_ptr, in_ptr, size * sizeof(float));
+      }
+
+      // Split the reduces as the uncompressed ones but by the bytes sent.
+      size_t nbytes = detail::compressed_size(compression, size);
+      size_t n_reduces = std::max(
+          std::min(
+              sockets_right_.size() + sockets_left_.size(),
+              nbytes / (size_ * min_send_size_)),
+          size_t(1));
+      size_t step = ceildiv(size, n_reduces);
+      std::vector<std::future<void>> all_sums;
+      for (int i = 0; i < n_reduces; i++) {
+        if (i * step >= size) {
+          break;
+        }
+        all_sums.emplace_back(pool_.enqueue(std::bind(
+            &RingGroup::compressed_all_reduce_impl,
+            this,
+            out_ptr + i * step,
+            std::min(size, (i + 1) * step) - i * step,
+            sockets_right_[i / 2],
+            sockets_left_[i / 2],
+            (i % 2) ? -1 : 1,
+            compression)));
+      }
+      for (auto& f : all_sums) {
+        f.wait();
+      }
+    });
+  }
+
   void all_max(const array& input, array& output, Stream stream) override {
     SWITCH_TYPE(
         output, all_reduce<T, MaxOp<T>>(input, output, stream, MaxOp<T>()));
@@ -643,7 +753,100 @@ class RingGroup : public GroupImpl {
   }
 
   std::shared_ptr<GroupImpl> split(int color, int key = -1) override {
-    throw std::runtime_error("[ring] Group split not supported.");
+    key = (key < 0) ? rank() : key;
+
+    // Share the colors and keys with an all gather through the stream so
+    // that it is ordered with the rest of the communication.
+    auto info = distributed::all_gather(
+        array({color, key}), Group(shared_from_this()), Device::cpu);
+    eval(info);
+    auto colors_keys = info.data<int>();
+
+    // The members of the new group ordered by key and then by rank connect
+    // to each other with the addresses of the hostfile.
+    std::vector<std::pair<int, int>> members;
+    for (int i = 0; i < size_; i++) {
+      if (colors_keys[2 * i] == color) {
+        members.emplace_back(colors_keys[2 * i + 1], i);
+      }
+    }
+    std::sort(members.begin(), members.end());
+    int new_rank = 0;
+    std::vector<std::vector<address_t>> new_nodes;
+    for (int i = 0; i < members.size(); i++) {
+      if (members[i].second == rank_) {
+        new_rank = i;
+      }
+      new_nodes.push_back(nodes_[members[i].second]);
+    }
+    log_info(verbose_, "Rank", rank_, "split to rank", new_rank, "of", color);
+    return std::make_shared<RingGroup>(new_rank, new_nodes, verbose_);
+  }
+
+  void reduce_scatter(const array& input, array& output, Stream stream)
+      override {
+    SWITCH_TYPE(output, reduce_scatter_sum<T>(input, output, stream));
+  }
+
+  void all_to_all(
+      const array& input,
+      array& output,
+      const std::vector<size_t>& send_counts,
+      const std::vector<size_t>& recv_counts,
+      Stream stream) override {
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch([input_ptr = input.data<char>(),
+                      output_ptr = output.data<char>(),
+                      itemsize = input.itemsize(),
+                      send_counts,
+                      recv_counts,
+                      this]() {
+      std::vector<size_t> send_offsets(size_, 0);
+      std::vector<size_t> recv_offsets(size_, 0);
+      for (int i = 1; i < size_; i++) {
+        send_offsets[i] = send_offsets[i - 1] + send_counts[i - 1] * itemsize;
+        recv_offsets[i] = recv_offsets[i - 1] + recv_counts[i - 1] * itemsize;
+      }
+      std::memcpy(
+          output_ptr + recv_offsets[rank_],
+          input_ptr + send_offsets[rank_],
+          recv_counts[rank_] * itemsize);
+
+      // The chunk for rank + k travels k hops to the right, the ranks in
+      // between forward it and learn its size from a header sent first.
+      for (int k = 1; k < size_; k++) {
+        int dst = (rank_ + k) % size_;
+        int src = (rank_ + size_ - k) % size_;
+        const char* data = input_ptr + send_offsets[dst];
+        uint64_t data_size = send_counts[dst] * itemsize;
+        std::vector<char> received;
+        for (int hop = 0; hop < k; hop++) {
+          uint64_t recv_size;
+          auto sent = comm_.send(sockets_right_[0], &data_size, 1);
+          auto recvd = comm_.recv(sockets_left_[0], &recv_size, 1);
+          sent.wait();
+          recvd.wait();
+          std::vector<char> next(recv_size);
+          sent = comm_.send(sockets_right_[0], data, data_size);
+          recvd = comm_.recv(sockets_left_[0], next.data(), recv_size);
+          sent.wait();
+          recvd.wait();
+          received = std::move(next);
+          data = received.data();
+          data_size = recv_size;
+        }
+        if (data_size != recv_counts[src] * itemsize) {
+          std::ostringstream msg;
+          msg << "[ring] Rank " << rank_ << " expected "
+              << recv_counts[src] * itemsize << " bytes from rank " << src
+              << " but received " << data_size << ".";
+          throw std::runtime_error(msg.str());
+        }
+        std::memcpy(output_ptr + recv_offsets[src], data, data_size);
+      }
+    });
   }
 
   void all_gather(const array& input, array& output, Stream stream) override {
@@ -654,11 +857,10 @@ class RingGroup : public GroupImpl {
                       nbytes = input.nbytes(),
                       output_ptr = output.data<char>(),
                       this]() {
-      constexpr size_t min_send_size = 262144;
       size_t n_gathers = std::max(
           std::min(
               sockets_right_.size() + sockets_left_.size(),
-              nbytes / min_send_size),
+              nbytes / min_send_size_),
           size_t(1));
       size_t bytes_per_gather = ceildiv(nbytes, n_gathers);
       std::vector<std::future<void>> all_gathers;
@@ -774,11 +976,10 @@ class RingGroup : public GroupImpl {
 
       // Split the all reduces so that each member has at least 1 buffer to
       // send/recv per segment.
-      constexpr size_t min_send_size = 262144;
       size_t n_reduces = std::max(
           std::min(
               sockets_right_.size() + sockets_left_.size(),
-              nbytes / (size_ * min_send_size)),
+              nbytes / (size_ * min_send_size_)),
           size_t(1));
       size_t step = ceildiv(size, n_reduces);
       std::vector<std::future<void>> all_sums;
@@ -788,7 +989,7 @@ class RingGroup : public GroupImpl {
             &RingGroup::all_reduce_impl<T, ReduceOp>,
             this,
             reinterpret_cast<T*>(
-                buffers_.data() + i * ALL_SUM_SIZE * ALL_SUM_BUFFERS),
+                buffers_.data() + i * packet_size_ * num_buffers_),
             reinterpret_cast<T*>(out_ptr) + i * step,
             std::min(size, (i + 1) * step) - i * step,
             sockets_right_[i / 2],
@@ -816,10 +1017,13 @@ class RingGroup : public GroupImpl {
     int socket_recv = (direction < 0) ? socket_left : socket_right;
 
     // We split the data into `size_` segments of size `segment_size` and each
-    // of these in smaller segments of ALL_SUM_SIZE which we 'll call packets.
+    // of these in smaller segments of at most `packet_size_` bytes which
+    // we 'll call packets. The packets are small enough for a segment to
+    // fill the pipeline of `num_buffers_` packets in flight.
     size_t segment_size = ceildiv(data_size, size_);
-    size_t BUFFER_SIZE = std::max(
-        size_t(32768), std::min(ALL_SUM_SIZE / sizeof(T), segment_size / 2));
+    size_t BUFFER_SIZE = std::min(
+        packet_size_ / sizeof(T),
+        std::max(size_t(32768), segment_size / std::max<size_t>(num_buffers_, 2)));
     size_t n_packets = ceildiv(segment_size, BUFFER_SIZE);
 
     // Initial segments
@@ -857,47 +1061,188 @@ class RingGroup : public GroupImpl {
       }
     }
 
-    // Running the plan is fairly simple, we keep a send and a recv in flight
-    // while doing the summation.
-    T* recv_buffers[ALL_SUM_BUFFERS];
-    for (int i = 0; i < ALL_SUM_BUFFERS; i++) {
-      recv_buffers[i] = buffer + i * BUFFER_SIZE;
-    }
-    std::future<void> sends[2], recvs[2];
-    int a = 0;
-    int b = (n_packets > 1) ? 1 : 0;
-    for (int i = 0, j = -b; i < send_plan.size(); j++, i++) {
-      sends[a] = comm_.send(
-          socket_send,
-          data + send_plan[i].first,
-          send_plan[i].second - send_plan[i].first);
-      if (2 * i < send_plan.size()) {
-        recvs[a] = comm_.recv(
-            socket_recv,
-            recv_buffers[i % ALL_SUM_BUFFERS],
-            recv_plan[i].second - recv_plan[i].first);
-      } else {
-        recvs[a] = comm_.recv(
-            socket_recv,
-            data + recv_plan[i].first,
-            recv_plan[i].second - recv_plan[i].first);
+    // Running the plan is fairly simple, we keep up to `depth` sends and
+    // recvs in flight while doing the summation of the oldest. A packet is
+    // sent a segment after it is received so at most `n_packets` can be in
+    // flight.
+    size_t depth = std::min<size_t>(num_buffers_, n_packets);
+    std::vector<std::future<void>> sends(depth), recvs(depth);
+    for (size_t i = 0; i < send_plan.size() + depth - 1; i++) {
+      if (i < send_plan.size()) {
+        sends[i % depth] = comm_.send(
+            socket_send,
+            data + send_plan[i].first,
+            send_plan[i].second - send_plan[i].first);
+        if (2 * i < send_plan.size()) {
+          recvs[i % depth] = comm_.recv(
+              socket_recv,
+              buffer + (i % depth) * BUFFER_SIZE,
+              recv_plan[i].second - recv_plan[i].first);
+        } else {
+          recvs[i % depth] = comm_.recv(
+              socket_recv,
+              data + recv_plan[i].first,
+              recv_plan[i].second - recv_plan[i].first);
+        }
       }
 
-      if (j >= 0) {
-        sends[b].wait();
-        recvs[b].wait();
+      if (i + 1 >= depth) {
+        size_t j = i + 1 - depth;
+        sends[j % depth].wait();
+        recvs[j % depth].wait();
         if (2 * j < send_plan.size()) {
           reduce_op(
-              recv_buffers[j % ALL_SUM_BUFFERS],
+              buffer + (j % depth) * BUFFER_SIZE,
               data + recv_plan[j].first,
               recv_plan[j].second - recv_plan[j].first);
         }
       }
+    }
+  }
+
+  void compressed_all_reduce_impl(
+      float* data,
+      size_t data_size,
+      int socket_right,
+      int socket_left,
+      int direction,
+      Compression compression) {
+    // Choose which socket we send to and recv from
+    int socket_send = (direction < 0) ? socket_right : socket_left;
+    int socket_recv = (direction < 0) ? socket_left : socket_right;
+
+    // The same segments as all_reduce_impl, sent a segment at a time.
+    size_t segment_size = ceildiv(data_size, size_);
+    auto segment = [&](int i) {
+      size_t start = std::min(i * segment_size, data_size);
+      size_t stop = std::min((i + 1) * segment_size, data_size);
+      return std::make_pair(data + start, stop - start);
+    };
+    size_t max_bytes = detail::compressed_size(compression, segment_size);
+    std::vector<char> send_buffer(max_bytes);
+    std::vector<char> recv_buffer(max_bytes);
+
+    int send_segment = rank_;
+    int recv_segment = (rank_ + direction + size_) % size_;
+
+    // Scatter reduce, the partial sums are encoded before every hop and
+    // accumulated in float32.
+    for (int i = 0; i < size_ - 1; i++) {
+      auto [send_ptr, send_count] = segment(send_segment);
+      auto [recv_ptr, recv_count] = segment(recv_segment);
+      detail::compress(compression, send_ptr, send_count, send_buffer.data());
+      auto sent = comm_.send(
+          socket_send,
+          send_buffer.data(),
+          detail::compressed_size(compression, send_count));
+      auto recvd = comm_.recv(
+          socket_recv,
+          recv_buffer.data(),
+          detail::compressed_size(compression, recv_count));
+      sent.wait();
+      recvd.wait();
+      detail::decompress_add(
+          compression, recv_buffer.data(), recv_count, recv_ptr);
+      send_segment = (send_segment + size_ + direction) % size_;
+      recv_segment = (recv_segment + size_ + direction) % size_;
+    }
+
+    // Round the reduced segment to the wire format so that every rank ends
+    // with the same values, and forward the encoded segments unchanged.
+    auto [own_ptr, own_count] = segment(send_segment);
+    detail::compress(compression, own_ptr, own_count, send_buffer.data());
+    detail::decompress(compression, send_buffer.data(), own_count, own_ptr);
+    for (int i = 0; i < size_ - 1; i++) {
+      size_t send_count = segment(send_segment).second;
+      auto [recv_ptr, recv_count] = segment(recv_segment);
+      auto sent = comm_.send(
+          socket_send,
+          send_buffer.data(),
+          detail::compressed_size(compression, send_count));
+      auto recvd = comm_.recv(
+          socket_recv,
+          recv_buffer.data(),
+          detail::compressed_size(compression, recv_count));
+      sent.wait();
+      recvd.wait();
+      detail::decompress(compression, recv_buffer.data(), recv_count, recv_ptr);
+      std::swap(send_buffer, recv_buffer);
+      send_segment = (send_segment + size_ + direction) % size_;
+      recv_segment = (recv_segment + size_ + direction) % size_;
+    }
+  }
+
+  template <typename T>
+  void reduce_scatter_sum(const array& input, array& output, Stream stream) {
+    auto& encoder = cpu::get_command_encoder(stream);
+    encoder.set_input_array(input);
+    encoder.set_output_array(output);
+    encoder.dispatch([input_ptr = input.data<T>(),
+                      output_ptr = output.data<T>(),
+                      chunk_size = output.size(),
+                      this]() {
+      // Split the chunks in parts reduced concurrently over the connections
+      // and in both directions.
+      size_t n_parts = std::max(
+          std::min(
+              sockets_right_.size() + sockets_left_.size(),
+              chunk_size * sizeof(T) / min_send_size_),
+          size_t(1));
+      size_t step = ceildiv(chunk_size, n_parts);
+      std::vector<std::future<void>> reduces;
+      for (int i = 0; i < n_parts; i++) {
+        if (i * step >= chunk_size) {
+          break;
+        }
+        reduces.emplace_back(pool_.enqueue(std::bind(
+            &RingGroup::reduce_scatter_impl<T>,
+            this,
+            input_ptr + i * step,
+            output_ptr + i * step,
+            chunk_size,
+            std::min(chunk_size, (i + 1) * step) - i * step,
+            sockets_right_[i / 2],
+            sockets_left_[i / 2],
+            (i % 2) ? -1 : 1)));
+      }
+      for (auto& f : reduces) {
+        f.wait();
+      }
+    });
+  }
 
-      std::swap(a, b);
+  template <typename T>
+  void reduce_scatter_impl(
+      const T* input,
+      T* output,
+      size_t chunk_size,
+      size_t data_size,
+      int socket_right,
+      int socket_left,
+      int direction) {
+    // Choose which socket we send to and recv from
+    int socket_send = (direction < 0) ? socket_right : socket_left;
+    int socket_recv = (direction < 0) ? socket_left : socket_right;
+
+    // The first half of the ring all reduce, shifted by a segment so that
+    // every rank ends with the sum of its own segment. The partial sums
+    // alternate between two buffers as one is sent while the other is
+    // received.
+    int send_segment = (rank_ + direction + size_) % size_;
+    int recv_segment = (rank_ + 2 * direction + 2 * size_) % size_;
+    auto buffers = std::make_unique<T[]>(2 * data_size);
+    const T* send_ptr = input + send_segment * chunk_size;
+    for (int i = 0; i < size_ - 1; i++) {
+      T* recv_ptr = buffers.get() + (i % 2) * data_size;
+      auto sent = comm_.send(socket_send, send_ptr, data_size);
+      auto recvd = comm_.recv(socket_recv, recv_ptr, data_size);
+      sent.wait();
+      recvd.wait();
+      SumOp<T>()(input + recv_segment * chunk_size, recv_ptr, data_size);
+      send_ptr = recv_ptr;
+      recv_segment = (recv_segment + size_ + direction) % size_;
     }
-    sends[b].wait();
-    recvs[b].wait();
+    std::memcpy(output, send_ptr, data_size * sizeof(T));
   }
 
   void all_gather_impl(
@@ -976,8 +1321,17 @@ class RingGroup : public GroupImpl {
   int rank_;
   int size_;
 
+  // The addresses of the members in rank order to connect the subgroups.
+  std::vector<std::vector<address_t>> nodes_;
   bool verbose_;
 
+  // The maximum size of the packets of the all reduce, the packets in flight
+  // per connection and the minimum size sent per connection, set by
+  // MLX_RING_PACKET_SIZE, MLX_RING_BUFFERS and MLX_RING_MIN_SEND_SIZE.
+  size_t packet_size_;
+  size_t num_buffers_;
+  size_t min_send_size_;
+
   ThreadPool pool_;
   CommunicationThreads comm_;
 
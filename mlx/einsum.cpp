@@ -1,4 +1,5 @@
 // Copyright © 2024 Apple Inc.
+#include <functional>
 #include <numeric>
 #include <sstream>
 #include <unordered_map>
@@ -18,6 +19,11 @@ namespace {
 
 using CharSet = std::unordered_set<char>;
 
+// The largest number of inputs for which the optimal path is searched.
+constexpr int max_optimal_inputs = 8;
+
+constexpr int max_cached_paths = 1024;
+
 // A helper struct to hold the string and set
 // representation of a subscript to avoid needing
 // to recompute the set
@@ -158,6 +164,75 @@ std::pair<size_t, int> compute_cost_and_scaling(
   return {cost, contractions.size()};
 }
 
+// The subscripts of the result of contracting |x| and |y| in the order of
+// the output of batch_tensordot, the batch subscripts and then the free ones
+// of |x| and of |y|, so the result is not transposed.
+Subscript
+contraction_output(const Subscript& x, const Subscript& y, CharSet kept) {
+  std::string batch;
+  std::string x_free;
+  std::string y_free;
+  for (auto c : x.str) {
+    if (kept.find(c) != kept.end()) {
+      (y.set.find(c) != y.set.end() ? batch : x_free) += c;
+    }
+  }
+  for (auto c : y.str) {
+    if (kept.find(c) != kept.end() && x.set.find(c) == x.set.end()) {
+      y_free += c;
+    }
+  }
+  return Subscript(batch + x_free + y_free, std::move(kept));
+}
+
+// The size of the inputs which batch_tensordot copies to contract |x| and
+// |y| keeping |kept|. An input is not copied when its batch subscripts come
+// first, followed by its free and its contracted subscripts in either order.
+size_t transpose_cost(
+    const Subscript& x,
+    const Subscript& y,
+    const CharSet& kept,
+    std::unordered_map<char, ShapeElem>& dim_map) {
+  std::string batch;
+  std::string x_free;
+  std::string contracted;
+  std::string y_free;
+  for (auto c : x.str) {
+    bool in_y = y.set.find(c) != y.set.end();
+    if (kept.find(c) != kept.end()) {
+      (in_y ? batch : x_free) += c;
+    } else if (in_y) {
+      contracted += c;
+    }
+  }
+  for (auto c : y.str) {
+    if (kept.find(c) != kept.end() && x.set.find(c) == x.set.end()) {
+      y_free += c;
+    }
+  }
+  // The subscripts summed before the contraction are ignored
+  auto in_order = [&](const Subscript& in,
+                      const std::string& first,
+                      const std::string& second) {
+    std::string str;
+    for (auto c : in.str) {
+      if (kept.find(c) != kept.end() ||
+          contracted.find(c) != std::string::npos) {
+        str += c;
+      }
+    }
+    return str == batch + first + second || str == batch + second + first;
+  };
+  size_t cost = 0;
+  if (!in_order(x, x_free, contracted)) {
+    cost += term_size(x.set, dim_map);
+  }
+  if (!in_order(y, contracted, y_free)) {
+    cost += term_size(y.set, dim_map);
+  }
+  return cost;
+}
+
 std::tuple<std::vector<PathNode>, size_t, int> greedy_path(
     std::vector<Subscript> inputs,
     const Subscript& output,
@@ -279,12 +354,8 @@ std::tuple<std::vector<PathNode>, size_t, int> greedy_path(
     path_scaling = std::max(best.dims, path_scaling);
 
     // Construct the output subscripts
-    std::string out_str(best.output.begin(), best.output.end());
-    // TODO, sorting by dimension size seems suboptimal?
-    std::sort(out_str.begin(), out_str.end(), [&dim_map](auto x, auto y) {
-      return dim_map[x] < dim_map[y];
-    });
-    Subscript new_output(std::move(out_str), std::move(best.output));
+    auto new_output =
+        contraction_output(inputs[best.x], inputs[best.y], best.output);
 
     // Add the chosen contraction to the path
     {
@@ -331,6 +402,165 @@ std::tuple<std::vector<PathNode>, size_t, int> greedy_path(
   return {path, path_cost, path_scaling};
 }
 
+// The path of least cost found by a depth first search over the pairwise
+// contractions, which is only tractable for a few inputs. The cost of a
+// contraction is its FLOP count and the size of its inputs which are copied
+// to transpose them, so the contractions done by a single batched matmul are
+// preferred. Branches are pruned when they cost more than the best path found
+// so far, or than another branch which reached the same intermediates.
+std::tuple<std::vector<PathNode>, size_t, int> optimal_path(
+    std::vector<Subscript> inputs,
+    const Subscript& output,
+    std::unordered_map<char, ShapeElem> dim_map,
+    size_t cost_limit,
+    size_t memory_limit) {
+  // The subscripts kept by contracting inputs[x] and inputs[y] and the ones
+  // of the contraction.
+  auto contract = [&](const std::vector<Subscript>& terms, int x, int y) {
+    CharSet contractions(terms[x].set.begin(), terms[x].set.end());
+    contractions.insert(terms[y].set.begin(), terms[y].set.end());
+    CharSet kept;
+    for (int i = 0; i < terms.size(); i++) {
+      if (i == x || i == y) {
+        continue;
+      }
+      for (auto c : terms[i].set) {
+        if (contractions.find(c) != contractions.end()) {
+          kept.insert(c);
+        }
+      }
+    }
+    for (auto c : output.set) {
+      if (contractions.find(c) != contractions.end()) {
+        kept.insert(c);
+      }
+    }
+    return std::make_pair(std::move(kept), std::move(contractions));
+  };
+
+  // A step (-1, -1) contracts the remaining inputs naively.
+  using Steps = std::vector<std::pair<int, int>>;
+  Steps steps;
+  Steps best_steps;
+  size_t best_cost = cost_limit;
+  std::unordered_map<uint64_t, size_t> visited;
+
+  // The bits of masks[i] are the inputs contracted into terms[i].
+  using Masks = std::vector<uint8_t>;
+  std::function<void(const std::vector<Subscript>&, Masks, size_t)> search =
+      [&](const std::vector<Subscript>& terms, Masks masks, size_t cost) {
+        if (terms.size() == 1) {
+          if (cost < best_cost) {
+            best_cost = cost;
+            best_steps = steps;
+          }
+          return;
+        }
+        uint64_t key = 0;
+        {
+          auto sorted = masks;
+          std::sort(sorted.begin(), sorted.end());
+          for (auto m : sorted) {
+            key = (key << 8) | m;
+          }
+        }
+        auto [it, inserted] = visited.emplace(key, cost);
+        if (!inserted) {
+          if (it->second <= cost) {
+            return;
+          }
+          it->second = cost;
+        }
+
+        // Outer products are only tried when nothing else can be contracted
+        bool found = false;
+        for (bool outer : {false, true}) {
+          for (int x = 0; x < terms.size(); ++x) {
+            for (int y = x + 1; y < terms.size(); ++y) {
+              if (!outer && disjoint(terms[x].set, terms[y].set)) {
+                continue;
+              }
+              auto [kept, contractions] = contract(terms, x, y);
+              if (term_size(kept, dim_map) > memory_limit) {
+                continue;
+              }
+              found = true;
+              bool inner = contractions.size() > kept.size();
+              size_t step_cost = flop_count(contractions, inner, 2, dim_map) +
+                  transpose_cost(terms[x], terms[y], kept, dim_map);
+              if (cost + step_cost >= best_cost) {
+                continue;
+              }
+              std::vector<Subscript> next_terms;
+              Masks next_masks;
+              for (int i = 0; i < terms.size(); ++i) {
+                if (i != x && i != y) {
+                  next_terms.push_back(terms[i]);
+                  next_masks.push_back(masks[i]);
+                }
+              }
+              next_terms.push_back(
+                  contraction_output(terms[x], terms[y], std::move(kept)));
+              next_masks.push_back(masks[x] | masks[y]);
+              steps.emplace_back(x, y);
+              search(next_terms, std::move(next_masks), cost + step_cost);
+              steps.pop_back();
+            }
+          }
+          if (found) {
+            break;
+          }
+        }
+        if (!found) {
+          auto [naive_cost, _] =
+              compute_cost_and_scaling(terms, output, dim_map);
+          if (cost + naive_cost < best_cost) {
+            best_cost = cost + naive_cost;
+            best_steps = steps;
+            best_steps.emplace_back(-1, -1);
+          }
+        }
+      };
+  Masks masks;
+  for (int i = 0; i < inputs.size(); ++i) {
+    masks.push_back(1 << i);
+  }
+  search(inputs, std::move(masks), 0);
+
+  // Replay the best steps, none were found cheaper than the naive einsum
+  // when it is empty.
+  if (best_steps.empty()) {
+    best_steps.emplace_back(-1, -1);
+  }
+  std::vector<PathNode> path;
+  size_t path_cost = 0;
+  int path_scaling = 0;
+  for (auto [x, y] : best_steps) {
+    if (x < 0) {
+      std::vector<int> positions(inputs.size());
+      std::iota(positions.begin(), positions.end(), 0);
+      auto [cost, scale] = compute_cost_and_scaling(inputs, output, dim_map);
+      path.emplace_back(std::move(inputs), output, std::move(positions));
+      path_cost += cost;
+      path_scaling = std::max(scale, path_scaling);
+      break;
+    }
+    auto [kept, contractions] = contract(inputs, x, y);
+    bool inner = contractions.size() > kept.size();
+    path_cost += flop_count(contractions, inner, 2, dim_map);
+    path_scaling = std::max<int>(contractions.size(), path_scaling);
+    auto new_output = contraction_output(inputs[x], inputs[y], std::move(kept));
+    std::vector<Subscript> in_terms;
+    in_terms.push_back(std::move(inputs[x]));
+    in_terms.push_back(std::move(inputs[y]));
+    path.emplace_back(std::move(in_terms), new_output, std::vector<int>{x, y});
+    inputs.erase(inputs.begin() + y);
+    inputs.erase(inputs.begin() + x);
+    inputs.push_back(std::move(new_output));
+  }
+  return {path, path_cost, path_scaling};
+}
+
 // Assumes inputs have already have had repeats and single axis sums collapsed
 bool can_dot(const std::vector<Subscript>& inputs, const Subscript& output) {
   if (inputs.size() != 2) {
@@ -627,10 +857,11 @@ array einsum_naive(
   return transpose(out, reorder, s);
 }
 
-std::pair<std::vector<PathNode>, PathInfo> einsum_path_helper(
+std::pair<std::vector<PathNode>, PathInfo> compute_einsum_path(
     const std::string& subscripts,
     const std::vector<array>& operands,
-    const std::string& fn_name) {
+    const std::string& fn_name,
+    bool optimal) {
   if (operands.size() == 0) {
     std::ostringstream msg;
     msg << "[" << fn_name << "] At least one operand is required.";
@@ -802,21 +1033,68 @@ std::pair<std::vector<PathNode>, PathInfo> einsum_path_helper(
     path.emplace_back(
         std::move(inputs), std::move(output), std::move(positions));
   } else {
+    auto find_path =
+        (optimal && inputs.size() <= max_optimal_inputs) ? optimal_path
+                                                         : greedy_path;
     std::tie(path, path_info.optimized_cost, path_info.optimized_scaling) =
-        greedy_path(inputs, output, dim_map, path_info.naive_cost, max_size);
+        find_path(inputs, output, dim_map, path_info.naive_cost, max_size);
     // Set the final output subscript to the actual output
     path.back().output = std::move(output);
   }
   return {path, path_info};
 }
 
+// The paths of the recently used subscripts and shapes, a layer usually
+// calls einsum with the same ones at each step.
+std::unordered_map<std::string, std::pair<std::vector<PathNode>, PathInfo>>&
+path_cache() {
+  thread_local std::unordered_map<
+      std::string,
+      std::pair<std::vector<PathNode>, PathInfo>>
+      cache;
+  return cache;
+}
+
+std::pair<std::vector<PathNode>, PathInfo> einsum_path_helper(
+    const std::string& subscripts,
+    const std::vector<array>& operands,
+    const std::string& fn_name,
+    bool optimal) {
+  std::ostringstream key;
+  key << optimal << subscripts;
+  for (auto& op : operands) {
+    key << ";";
+    for (auto dim : op.shape()) {
+      key << dim << ",";
+    }
+  }
+  auto& cache = path_cache();
+  if (auto it = cache.find(key.str()); it != cache.end()) {
+    return it->second;
+  }
+  auto path = compute_einsum_path(subscripts, operands, fn_name, optimal);
+  // Drop the old paths when full, the ones in use are cached again.
+  if (cache.size() >= max_cached_paths) {
+    cache.clear();
+  }
+  cache.emplace(key.str(), path);
+  return path;
+}
+
 } // namespace
 
 std::pair<std::vector<std::vector<int>>, std::string> einsum_path(
     const std::string& subscripts,
-    const std::vector<array>& operands) {
-  auto [path, path_info] =
-      einsum_path_helper(subscripts, operands, "einsum_path");
+    const std::vector<array>& operands,
+    const std::string& optimize /* = "greedy" */) {
+  if (optimize != "greedy" && optimize != "optimal") {
+    std::ostringstream msg;
+    msg << "[einsum_path] Invalid optimize '" << optimize
+        << "', expected 'greedy' or 'optimal'.";
+    throw std::invalid_argument(msg.str());
+  }
+  auto [path, path_info] = einsum_path_helper(
+      subscripts, operands, "einsum_path", optimize == "optimal");
 
   std::vector<std::vector<int>> pos_path;
   for (auto& p : path) {
@@ -838,7 +1116,8 @@ array einsum(
     const std::string& subscripts,
     const std::vector<array>& operands,
     StreamOrDevice s /* = {} */) {
-  auto [path, path_info] = einsum_path_helper(subscripts, operands, "einsum");
+  auto [path, path_info] =
+      einsum_path_helper(subscripts, operands, "einsum", true);
   auto inputs = operands;
   for (auto& node : path) {
     preprocess_einsum_inputs(
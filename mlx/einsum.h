@@ -10,9 +10,16 @@
 
 namespace mlx::core {
 
+/**
+ * The order in which einsum contracts the operands. With |optimize|
+ * "greedy" the path is found greedily, as by NumPy, and with "optimal" the
+ * cheapest path is searched when there are up to 8 operands, which is the
+ * path used by einsum.
+ */
 std::pair<std::vector<std::vector<int>>, std::string> einsum_path(
     const std::string& subscripts,
-    const std::vector<array>& operands);
+    const std::vector<array>& operands,
+    const std::string& optimize = "greedy");
 
 array einsum(
     const std::string& subscripts,
@@ -1,6 +1,7 @@
 // Copyright © 2024 Apple Inc.
 #include "mlx/export.h"
 #include <map>
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/compile_impl.h"
 #include "mlx/fast_primitives.h"
 #include "mlx/primitives.h"
@@ -30,6 +31,9 @@ using namespace mlx::core::fast;
 using Reader = io::ParallelFileReader;
 using Writer = io::FileWriter;
 
+// The alignment of the data of the constants in the file.
+constexpr uint64_t constant_alignment = 4096;
+
 struct PrimitiveSerializer {
   using Serializer = std::function<void(Writer&, const Primitive&)>;
   using Deserializer =
@@ -233,6 +237,7 @@ struct PrimitiveFactory {
       SERIALIZE_PRIMITIVE(ArgSort),
       SERIALIZE_PRIMITIVE(AsType),
       SERIALIZE_PRIMITIVE(AsStrided),
+      SERIALIZE_PRIMITIVE(BinCount),
       SERIALIZE_PRIMITIVE(
           BitwiseBinary,
           "BitwiseAnd",
@@ -318,6 +323,7 @@ struct PrimitiveFactory {
       SERIALIZE_PRIMITIVE(SliceUpdate),
       SERIALIZE_PRIMITIVE(Softmax),
       SERIALIZE_PRIMITIVE(Sort),
+      SERIALIZE_PRIMITIVE(SparseMatmul),
       SERIALIZE_PRIMITIVE(Split),
       SERIALIZE_PRIMITIVE(Square),
       SERIALIZE_PRIMITIVE(Squeeze),
@@ -329,6 +335,7 @@ struct PrimitiveFactory {
       SERIALIZE_PRIMITIVE(View),
       SERIALIZE_PRIMITIVE(Transpose),
       SERIALIZE_PRIMITIVE(Unflatten),
+      SERIALIZE_PRIMITIVE(Unique),
       SERIALIZE_PRIMITIVE(QRF),
       SERIALIZE_PRIMITIVE(SVD),
       SERIALIZE_PRIMITIVE(Inverse),
@@ -341,7 +348,9 @@ struct PrimitiveFactory {
       SERIALIZE_PRIMITIVE(LayerNorm),
       SERIALIZE_PRIMITIVE(LayerNormVJP),
       SERIALIZE_PRIMITIVE(RoPE),
-      SERIALIZE_PRIMITIVE(ScaledDotProductAttention)};
+      SERIALIZE_PRIMITIVE(ScaledDotProductAttention),
+      SERIALIZE_PRIMITIVE(PagedKVWrite),
+      SERIALIZE_PRIMITIVE(PagedAttention)};
   std::unordered_map<std::string, std::string> name_remap;
 
   PrimitiveFactory() {
@@ -657,6 +666,12 @@ void FunctionExporter::export_function(const Args& args, const Kwargs& kwargs) {
         if (constants.insert(arr.id()).second) {
           serialize(os, arr.shape());
           serialize(os, arr.dtype());
+          // Align the data to the pages for the import to map it.
+          uint64_t pos = os.tell() + sizeof(uint64_t);
+          uint64_t pad = (constant_alignment - pos % constant_alignment) %
+              constant_alignment;
+          serialize(os, pad);
+          os.write(std::string(pad, '\0').data(), pad);
           os.write(arr.data<char>(), arr.nbytes());
         }
       } else {
@@ -664,6 +679,22 @@ void FunctionExporter::export_function(const Args& args, const Kwargs& kwargs) {
       }
     }
   }
+
+  // The kernels compiled so far, which the import adds to its cache.
+  std::vector<std::pair<std::string, std::string>> kernel_files;
+  if (env::export_kernels()) {
+    for (auto& file : cu::kernel_cache_files()) {
+      if (kernels.insert(file.first).second) {
+        kernel_files.push_back(std::move(file));
+      }
+    }
+  }
+  serialize(os, static_cast<uint64_t>(kernel_files.size()));
+  for (auto& [name, data] : kernel_files) {
+    serialize(os, name);
+    serialize(os, static_cast<uint64_t>(data.size()));
+    os.write(data.data(), data.size());
+  }
 }
 
 void FunctionExporter::operator()(const Args& args) {
@@ -779,6 +810,15 @@ ImportedFunction::ImportedFunction(const std::string& file)
     throw std::runtime_error("[import_function] Failed to open " + file);
   }
 
+  // The constants are read from the pages of the file where possible.
+  std::shared_ptr<io::Reader> constants_reader = is_ptr;
+#ifndef _WIN32
+  if (auto mapped = std::make_shared<io::MmapFileReader>(file);
+      mapped->is_open()) {
+    constants_reader = std::move(mapped);
+  }
+#endif
+
   // Parse header
   auto mlx_version = deserialize<std::string>(is);
   auto function_count = deserialize<int>(is);
@@ -843,12 +883,13 @@ ImportedFunction::ImportedFunction(const std::string& file)
           } else {
             auto shape = deserialize<std::vector<int>>(is);
             auto type = deserialize<Dtype>(is);
-            size_t offset = is.tell();
+            auto pad = deserialize<uint64_t>(is);
+            size_t offset = is.tell() + pad;
             tape.push_back(array(
                 std::move(shape),
                 type,
                 std::make_shared<Load>(
-                    default_stream(Device::cpu), is_ptr, offset),
+                    default_stream(Device::cpu), constants_reader, offset),
                 {}));
             is.seek(offset + tape.back().nbytes());
             constants.insert({id, tape.back()});
@@ -871,6 +912,16 @@ ImportedFunction::ImportedFunction(const std::string& file)
         std::move(trace_inputs),
         std::move(trace_outputs),
         std::move(tape));
+
+    auto num_kernel_files = deserialize<uint64_t>(is);
+    std::vector<std::pair<std::string, std::string>> kernel_files;
+    for (uint64_t i = 0; i < num_kernel_files; ++i) {
+      auto name = deserialize<std::string>(is);
+      std::string data(deserialize<uint64_t>(is), '\0');
+      is.read(data.data(), data.size());
+      kernel_files.emplace_back(std::move(name), std::move(data));
+    }
+    cu::add_kernel_cache_files(kernel_files);
   };
 
   for (int i = 0; i < function_count; ++i) {
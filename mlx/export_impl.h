@@ -46,6 +46,7 @@ struct FunctionExporter {
   std::function<std::vector<array>(const Args&, const Kwargs& kwargs)> fun;
   void export_function(const Args& args, const Kwargs& kwargs);
   std::set<std::uintptr_t> constants;
+  std::set<std::string> kernels;
   int count{0};
   bool closed{false};
   std::shared_ptr<FunctionTable> ftable;
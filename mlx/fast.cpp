@@ -5,6 +5,7 @@
 #include "mlx/fast.h"
 #include "mlx/fast_primitives.h"
 #include "mlx/ops.h"
+#include "mlx/random.h"
 #include "mlx/transforms.h"
 
 namespace mlx::core::fast {
@@ -366,10 +367,13 @@ array rope(
     msg << "[rope] Input must be a floating type but got " << x.dtype() << ".";
     throw std::invalid_argument(msg.str());
   }
-  if (offset.size() != 1) {
+  // Besides a scalar, the offset can hold one entry per position to rotate
+  // the rows of each sequence by different amounts.
+  bool per_position = offset.size() != 1;
+  if (per_position && offset.shape() != Shape{x.shape(-2)}) {
     std::ostringstream msg;
-    msg << "[rope] offset must be a scalar but has shape " << offset.shape()
-        << ".";
+    msg << "[rope] offset must be a scalar or have one entry per position "
+        << "but has shape " << offset.shape() << ".";
     throw std::invalid_argument(msg.str());
   }
   if (!issubdtype(offset.dtype(), integer)) {
@@ -465,7 +469,7 @@ array rope(
     }
   };
   auto stream = to_stream(s);
-  if (!RoPE::use_fallback(stream)) {
+  if (!RoPE::use_fallback(stream, per_position)) {
     return array(
         x.shape(),
         x.dtype(),
@@ -505,6 +509,133 @@ array rope(
       s);
 }
 
+// Check the arguments of the fused residual add and norm and return the type
+// of its outputs.
+Dtype add_norm_out_type(
+    const char* tag,
+    const array& x,
+    const array& residual,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias) {
+  if (x.ndim() == 0) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Input must have at least 1 dimension but got "
+        << "input with 0 dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (x.shape() != residual.shape()) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The residual must have the same shape as the "
+        << "input but got " << residual.shape() << " and " << x.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  std::vector<array> arrays = {x, residual};
+  auto check_param = [&](const std::optional<array>& a, const char* name) {
+    if (!a.has_value()) {
+      return;
+    }
+    if (a->ndim() != 1 || a->size() != x.shape(-1)) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] The " << name << " must have 1 dimension with "
+          << "the size of the last dimension of the input but has shape "
+          << a->shape() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    arrays.push_back(*a);
+  };
+  check_param(weight, "weight");
+  check_param(bias, "bias");
+  auto out_type = result_type(arrays);
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return out_type;
+}
+
+std::pair<array, array> add_rms_norm(
+    const array& x,
+    const array& residual,
+    const std::optional<array>& weight,
+    float eps,
+    StreamOrDevice s_ /* = {} */) {
+  bool has_weight = weight.has_value();
+  auto out_type =
+      add_norm_out_type("add_rms_norm", x, residual, weight, std::nullopt);
+
+  auto s = to_stream(s_);
+  auto fallback = [has_weight, eps, s](const std::vector<array>& inputs) {
+    auto h = add(inputs[0], inputs[1], s);
+    auto w = has_weight ? std::optional<array>(inputs[2]) : std::nullopt;
+    return std::vector<array>{h, rms_norm(h, w, eps, s)};
+  };
+
+  std::vector<array> inputs = {
+      astype(x, out_type, s),
+      astype(residual, out_type, s),
+      has_weight ? astype(*weight, out_type, s) : array(1, out_type)};
+  if (!AddRMSNorm::use_fallback(s)) {
+    auto outputs = array::make_arrays(
+        {x.shape(), x.shape()},
+        {out_type, out_type},
+        std::make_shared<AddRMSNorm>(s, fallback, eps),
+        inputs);
+    return {outputs[0], outputs[1]};
+  }
+  auto outputs = fallback(inputs);
+  return {outputs[0], outputs[1]};
+}
+
+std::pair<array, array> add_layer_norm(
+    const array& x,
+    const array& residual,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s_ /* = {} */) {
+  bool has_weight = weight.has_value();
+  bool has_bias = bias.has_value();
+  auto out_type =
+      add_norm_out_type("add_layer_norm", x, residual, weight, bias);
+
+  auto s = to_stream(s_);
+  auto fallback =
+      [has_weight, has_bias, eps, s](const std::vector<array>& inputs) {
+        auto h = add(inputs[0], inputs[1], s);
+        auto w = has_weight ? std::optional<array>(inputs[2]) : std::nullopt;
+        auto b = has_bias ? std::optional<array>(inputs[3]) : std::nullopt;
+        return std::vector<array>{h, layer_norm(h, w, b, eps, s)};
+      };
+
+  std::vector<array> inputs = {
+      astype(x, out_type, s),
+      astype(residual, out_type, s),
+      has_weight ? astype(*weight, out_type, s) : array(1, out_type),
+      has_bias ? astype(*bias, out_type, s) : array(0, out_type)};
+  if (!AddLayerNorm::use_fallback(s)) {
+    auto outputs = array::make_arrays(
+        {x.shape(), x.shape()},
+        {out_type, out_type},
+        std::make_shared<AddLayerNorm>(s, fallback, eps),
+        inputs);
+    return {outputs[0], outputs[1]};
+  }
+  auto outputs = fallback(inputs);
+  return {outputs[0], outputs[1]};
+}
+
+bool AddRMSNorm::is_equivalent(const Primitive& other) const {
+  const AddRMSNorm& a_other = static_cast<const AddRMSNorm&>(other);
+  return eps_ == a_other.eps_;
+}
+
+bool AddLayerNorm::is_equivalent(const Primitive& other) const {
+  const AddLayerNorm& a_other = static_cast<const AddLayerNorm&>(other);
+  return eps_ == a_other.eps_;
+}
+
 array rope(
     const array& x,
     int dims,
@@ -518,6 +649,64 @@ array rope(
       x, dims, traditional, base, scale, array(offset, int32), freqs, s);
 }
 
+namespace {
+
+// Check the offsets of the packed sequences of a varlen op.
+void check_cu_seqlens(const char* tag, const array& cu_seqlens) {
+  if (cu_seqlens.ndim() != 1 || cu_seqlens.size() < 2 ||
+      !issubdtype(cu_seqlens.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Expected integer sequence offsets of shape "
+        << "(num_seqs + 1,) but got shape " << cu_seqlens.shape()
+        << " and type " << cu_seqlens.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+// The sequence of each of the n packed tokens, the number of sequences
+// ending at or before it.
+array varlen_segments(const array& cu_seqlens, int n, const Stream& s) {
+  auto ends = slice(cu_seqlens, {1}, {cu_seqlens.shape(0)}, s);
+  auto after = greater_equal(
+      expand_dims(arange(n, int32, s), 1, s), expand_dims(ends, 0, s), s);
+  return astype(sum(after, 1, false, s), int32, s);
+}
+
+} // namespace
+
+array rope_varlen(
+    const array& x,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    const array& cu_seqlens,
+    const std::optional<array>& freqs /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  if (x.ndim() != 3) {
+    std::ostringstream msg;
+    msg << "[rope_varlen] Expected input of shape (total_tokens, n_heads, "
+        << "head_dim) but got " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  check_cu_seqlens("rope_varlen", cu_seqlens);
+  auto s = to_stream(s_);
+  // The position of a token is its index minus the start of its sequence,
+  // and the tokens are moved to the rotated axis with a transposed view.
+  auto starts = astype(cu_seqlens, int32, s);
+  starts = take(starts, varlen_segments(starts, x.shape(0), s), s);
+  auto out = rope(
+      swapaxes(x, 0, 1, s),
+      dims,
+      traditional,
+      base,
+      scale,
+      negative(starts, s),
+      freqs,
+      s);
+  return swapaxes(out, 0, 1, s);
+}
+
 std::vector<array> RoPE::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
@@ -541,6 +730,9 @@ std::vector<array> RoPE::vjp(
   if (primals.size() == 3) {
     inputs.push_back(primals[2]);
   }
+  if (use_fallback(s, primals[1].size() != 1)) {
+    return fallback(std::move(inputs));
+  }
   return {array(
       cotangents[0].shape(),
       cotangents[0].dtype(),
@@ -557,6 +749,155 @@ bool RoPE::is_equivalent(const Primitive& other) const {
       forward_ == a_other.forward_);
 }
 
+std::tuple<array, array, array> rope_qkv(
+    const array& qkv,
+    const array& k_cache,
+    const array& v_cache,
+    int n_heads,
+    int n_kv_heads,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    int offset,
+    const std::optional<array>& freqs /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  if (qkv.ndim() != 3 || k_cache.ndim() != 4 || v_cache.ndim() != 4) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] Expected qkv with 3 dimensions and caches with 4 "
+        << "dimensions but got shapes " << qkv.shape() << ", "
+        << k_cache.shape() << " and " << v_cache.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (k_cache.shape() != v_cache.shape()) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] The key and value caches must have the same shape but "
+        << "got " << k_cache.shape() << " and " << v_cache.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int B = qkv.shape(0);
+  int L = qkv.shape(1);
+  int head_dim = k_cache.shape(3);
+  if (n_heads <= 0 || n_kv_heads <= 0 ||
+      qkv.shape(2) != (n_heads + 2 * n_kv_heads) * head_dim ||
+      k_cache.shape(0) != B || k_cache.shape(1) != n_kv_heads) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] The qkv of shape " << qkv.shape() << " does not hold "
+        << n_heads << " query heads and " << n_kv_heads << " key and value "
+        << "heads for the caches of shape " << k_cache.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (offset < 0 || offset + L > k_cache.shape(2)) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] The " << L << " positions at offset " << offset
+        << " do not fit in the caches of shape " << k_cache.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (dims <= 0 || dims > head_dim || dims % 2 != 0 || head_dim % 2 != 0) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] The rotated dims " << dims << " must be even and at "
+        << "most the even head dim " << head_dim << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(qkv.dtype(), floating) || k_cache.dtype() != qkv.dtype() ||
+      v_cache.dtype() != qkv.dtype()) {
+    std::ostringstream msg;
+    msg << "[rope_qkv] Expected the qkv and the caches to have the same "
+        << "floating type but got " << qkv.dtype() << ", " << k_cache.dtype()
+        << " and " << v_cache.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (freqs) {
+    if (base) {
+      throw std::invalid_argument(
+          "[rope_qkv] Only one of base or freqs can have a value.");
+    }
+    if (freqs->ndim() != 1 || freqs->shape(0) != dims / 2) {
+      std::ostringstream msg;
+      msg << "[rope_qkv] freqs must be one dimensional with size " << dims / 2
+          << " but got shape " << freqs->shape() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+  } else if (!base) {
+    throw std::invalid_argument(
+        "[rope_qkv] Neither base nor freqs has a value.");
+  }
+
+  auto s = to_stream(s_);
+  float base_value = base.has_value() ? *base : 1.0;
+  auto fallback = [n_heads,
+                   n_kv_heads,
+                   dims,
+                   traditional,
+                   base_value,
+                   scale,
+                   offset,
+                   s](std::vector<array> inputs) {
+    auto& qkv = inputs[0];
+    int B = qkv.shape(0);
+    int L = qkv.shape(1);
+    int head_dim = inputs[1].shape(3);
+    auto x = reshape(qkv, {B, L, n_heads + 2 * n_kv_heads, head_dim}, s);
+    auto heads = split(x, Shape{n_heads, n_heads + n_kv_heads}, 2, s);
+    auto apply_rope = [&](const array& x) {
+      std::vector<array> rope_inputs = {x, array(offset, int32)};
+      if (inputs.size() == 4) {
+        rope_inputs.push_back(inputs[3]);
+      }
+      return rope(
+          std::move(rope_inputs),
+          dims,
+          traditional,
+          base_value,
+          scale,
+          true,
+          s);
+    };
+    auto q = apply_rope(transpose(heads[0], {0, 2, 1, 3}, s));
+    auto k = apply_rope(transpose(heads[1], {0, 2, 1, 3}, s));
+    auto v = transpose(heads[2], {0, 2, 1, 3}, s);
+    Shape start = {0, 0, offset, 0};
+    Shape stop = {B, n_kv_heads, offset + L, head_dim};
+    return std::vector<array>{
+        q,
+        slice_update(inputs[1], k, start, stop, s),
+        slice_update(inputs[2], v, start, stop, s)};
+  };
+
+  std::vector<array> inputs = {qkv, k_cache, v_cache};
+  if (freqs) {
+    inputs.push_back(astype(*freqs, float32, s));
+  }
+  if (!RoPEQKV::use_fallback(s)) {
+    auto outputs = array::make_arrays(
+        {{B, n_heads, L, head_dim}, k_cache.shape(), v_cache.shape()},
+        {qkv.dtype(), qkv.dtype(), qkv.dtype()},
+        std::make_shared<RoPEQKV>(
+            s,
+            fallback,
+            n_heads,
+            n_kv_heads,
+            dims,
+            traditional,
+            base_value,
+            scale,
+            offset),
+        std::move(inputs));
+    return {outputs[0], outputs[1], outputs[2]};
+  }
+  auto outputs = fallback(std::move(inputs));
+  return {outputs[0], outputs[1], outputs[2]};
+}
+
+bool RoPEQKV::is_equivalent(const Primitive& other) const {
+  const RoPEQKV& a_other = static_cast<const RoPEQKV&>(other);
+  return (
+      n_heads_ == a_other.n_heads_ && n_kv_heads_ == a_other.n_kv_heads_ &&
+      dims_ == a_other.dims_ && traditional_ == a_other.traditional_ &&
+      base_ == a_other.base_ && scale_ == a_other.scale_ &&
+      offset_ == a_other.offset_);
+}
+
 /** Computes: O = softmax(Q @ K.T) @ V **/
 array scaled_dot_product_attention(
     const array& queries,
@@ -565,6 +906,8 @@ array scaled_dot_product_attention(
     const float scale,
     const std::string& mask_mode /* = "" */,
     const std::vector<array>& mask_arrs /* = {} */,
+    int window_size /* = 0 */,
+    int num_sinks /* = 0 */,
     StreamOrDevice s /* = {}*/) {
   for (const auto& tensor : {queries, keys, values}) {
     if (tensor.ndim() != 4) {
@@ -575,10 +918,24 @@ array scaled_dot_product_attention(
     }
   }
   // Check valid mask
-  if (mask_mode != "" && mask_mode != "causal" && mask_mode != "array") {
+  if (mask_mode != "" && mask_mode != "causal" && mask_mode != "chunked" &&
+      mask_mode != "array" && mask_mode != "tree") {
     std::ostringstream msg;
     msg << "[scaled_dot_product_attention] Invalid mask_mode " << mask_mode
-        << ". mask_mode must be 'causal', 'array' or ''.";
+        << ". mask_mode must be 'causal', 'chunked', 'array', 'tree' or ''.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  bool chunked = mask_mode == "chunked";
+  bool tree = mask_mode == "tree";
+  if (window_size < 0 || num_sinks < 0 || (chunked && window_size == 0) ||
+      (window_size > 0 && mask_mode != "causal" && !chunked) ||
+      (num_sinks > 0 && window_size == 0)) {
+    std::ostringstream msg;
+    msg << "[scaled_dot_product_attention] Invalid window_size "
+        << window_size << " and num_sinks " << num_sinks
+        << " for mask_mode '" << mask_mode << "'. A window needs mask_mode "
+        << "'causal' or 'chunked' and the sinks need a window.";
     throw std::invalid_argument(msg.str());
   }
 
@@ -587,7 +944,7 @@ array scaled_dot_product_attention(
   bool has_arr_mask = false;
   bool has_bool_mask = false;
 
-  if (mask_mode == "causal") {
+  if (mask_mode == "causal" || chunked) {
     has_mask = true;
     do_causal = true;
 
@@ -599,7 +956,16 @@ array scaled_dot_product_attention(
     }
   }
 
-  if (mask_mode == "array" || (mask_mode == "" && !mask_arrs.empty())) {
+  if (tree && queries.shape(2) > keys.shape(2)) {
+    std::ostringstream msg;
+    msg << "[scaled_dot_product_attention] The queries of mask_mode 'tree' "
+        << "are the last keys but got " << queries.shape(2) << " queries for "
+        << keys.shape(2) << " keys.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if (mask_mode == "array" || tree ||
+      (mask_mode == "" && !mask_arrs.empty())) {
     if (mask_arrs.size() != 1) {
       std::ostringstream msg;
       msg << "[scaled_dot_product_attention] Invalid mask_arrs for mask_mode "
@@ -670,8 +1036,16 @@ array scaled_dot_product_attention(
   auto k = astype(keys, final_type, s);
   auto v = astype(values, final_type, s);
 
-  auto fallback = [scale, final_type, n_q_heads, n_kv_heads, do_causal, s](
-                      const std::vector<array>& inputs) {
+  auto fallback = [scale,
+                   final_type,
+                   n_q_heads,
+                   n_kv_heads,
+                   do_causal,
+                   window_size,
+                   num_sinks,
+                   chunked,
+                   tree,
+                   s](const std::vector<array>& inputs) {
     auto q = multiply(array(scale, inputs[0].dtype()), inputs[0], s);
     int n_repeats = n_q_heads / n_kv_heads;
     int B = q.shape(0);
@@ -687,6 +1061,15 @@ array scaled_dot_product_attention(
     if (inputs.size() > 3 || do_causal) {
       // Mask must be broadcast-compatible with [B, n_q_heads, L_q, L_kv]
       auto mask = inputs.back();
+      if (tree) {
+        // The queries see all the keys before them.
+        auto prefix_shape = mask.shape();
+        prefix_shape.back() = k.shape(-2) - L;
+        auto prefix = mask.dtype() == bool_
+            ? full(prefix_shape, array(true), s)
+            : zeros(prefix_shape, mask.dtype(), s);
+        mask = concatenate({prefix, mask}, -1, s);
+      }
 
       if (do_causal) {
         int kL = k.shape(-2);
@@ -697,6 +1080,17 @@ array scaled_dot_product_attention(
         q_idx = expand_dims(q_idx, 1, s);
         k_idx = expand_dims(k_idx, 0, s);
         mask = greater_equal(q_idx, k_idx, s);
+        if (window_size > 0) {
+          auto w = array(window_size, q_idx.dtype());
+          auto first = chunked
+              ? multiply(floor_divide(q_idx, w, s), w, s)
+              : add(subtract(q_idx, w, s), array(1, q_idx.dtype()), s);
+          auto visible = logical_or(
+              greater_equal(k_idx, first, s),
+              less(k_idx, array(num_sinks, k_idx.dtype()), s),
+              s);
+          mask = logical_and(mask, visible, s);
+        }
       }
 
       if (n_repeats > 1 && mask.ndim() >= 3) {
@@ -735,19 +1129,34 @@ array scaled_dot_product_attention(
     } else if (!has_bool_mask) {
       mask_arr = astype(mask_arr, final_type, stream);
     }
-    // Broadcast mask
+    // Broadcast mask, the tree mask only covers the keys of the queries.
     auto mask_shape = queries.shape();
-    mask_shape.back() = keys.shape(-2);
+    mask_shape.back() = tree ? queries.shape(-2) : keys.shape(-2);
     inputs.push_back(broadcast_to(mask_arr, mask_shape, stream));
   }
   if (!ScaledDotProductAttention::use_fallback(
-          q, k, v, has_mask, has_arr_mask, do_causal, stream)) {
+          q,
+          k,
+          v,
+          has_mask,
+          has_arr_mask,
+          do_causal,
+          window_size > 0,
+          tree,
+          stream)) {
     auto out_shape = Shape{q.shape(0), q.shape(1), q.shape(2), v.shape(-1)};
     return array(
         std::move(out_shape),
         final_type,
         std::make_shared<ScaledDotProductAttention>(
-            stream, fallback, scale, do_causal),
+            stream,
+            fallback,
+            scale,
+            do_causal,
+            window_size,
+            num_sinks,
+            chunked,
+            tree),
         std::move(inputs));
   }
   return fallback(std::move(inputs))[0];
@@ -756,88 +1165,684 @@ array scaled_dot_product_attention(
 bool ScaledDotProductAttention::is_equivalent(const Primitive& other) const {
   const ScaledDotProductAttention& a_other =
       static_cast<const ScaledDotProductAttention&>(other);
-  return scale_ == a_other.scale_ && do_causal_ == a_other.do_causal_;
+  return state() == a_other.state();
 }
 
-array pack_and_quantize(
-    array& packed_w,
-    const array& scales,
-    const array& biases,
-    int bits,
-    const Stream& s) {
-  int el_per_int = 32 / bits;
-  array zero(0, packed_w.dtype());
-  array n_bins((1 << bits) - 1, packed_w.dtype()); // 2**bits - 1
-  packed_w = astype(
-      clip(
-          round(divide(subtract(packed_w, biases, s), scales, s), s),
-          zero,
-          n_bins,
-          s),
-      uint32,
-      s);
-  if (is_power_of_2(bits)) {
-    array shifts = power(array(2, uint32), arange(0, 32, bits, uint32, s), s);
-    packed_w = reshape(packed_w, {packed_w.shape(0), -1, el_per_int}, s);
-    packed_w = sum(
-        multiply(packed_w, shifts, s), /* axis= */ 2, /* keepdims= */ false, s);
-  } else {
-    // This is slow but we have fast GPU/CPU versions of this function so we
-    // shouldn't be here often.
-    packed_w = expand_dims(packed_w, /* axis= */ -1, s);
-    packed_w = bitwise_and(
-        right_shift(packed_w, arange(bits, uint32, s), s),
-        array({1}, uint32),
-        s);
-    auto new_shape = packed_w.shape();
-    new_shape[new_shape.size() - 2] = -1;
-    new_shape.back() = 32;
-    packed_w = reshape(packed_w, new_shape, s);
-    array shifts = arange(32, uint32, s);
-    packed_w =
-        sum(left_shift(packed_w, shifts, s),
-            /* axis= */ -1,
-            /* keepdims= */ false,
-            s);
+array varlen_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const array& cu_seqlens_q,
+    const array& cu_seqlens_k,
+    const float scale,
+    bool causal /* = false */,
+    StreamOrDevice s_ /* = {} */) {
+  for (const auto& tensor : {queries, keys, values}) {
+    if (tensor.ndim() != 3) {
+      std::ostringstream msg;
+      msg << "[varlen_attention] Expected inputs of shape (total_tokens, "
+          << "n_heads, head_dim) but got " << tensor.shape() << ".";
+      throw std::invalid_argument(msg.str());
+    }
   }
-  return packed_w;
-}
-
-std::tuple<array, array, array>
-affine_quantize(const array& w, int group_size, int bits, StreamOrDevice s_) {
-  auto s = to_stream(s_);
-
-  if (group_size != 32 && group_size != 64 && group_size != 128) {
+  if (queries.shape(2) != keys.shape(2) || keys.shape(1) != values.shape(1) ||
+      keys.shape(0) != values.shape(0) ||
+      queries.shape(1) % keys.shape(1) != 0) {
     std::ostringstream msg;
-    msg << "[quantize] The requested group size " << group_size
-        << " is not supported. The supported group sizes are 32, 64, and 128.";
+    msg << "[varlen_attention] Expected keys and values with the same tokens "
+        << "and heads, a number of heads dividing the query heads and the "
+        << "head dim of the queries but got queries " << queries.shape()
+        << ", keys " << keys.shape() << " and values " << values.shape()
+        << ".";
     throw std::invalid_argument(msg.str());
   }
-
-  if (bits < 2 || bits > 8 || bits == 7) {
+  check_cu_seqlens("varlen_attention", cu_seqlens_q);
+  check_cu_seqlens("varlen_attention", cu_seqlens_k);
+  if (cu_seqlens_q.size() != cu_seqlens_k.size()) {
     std::ostringstream msg;
-    msg << "[quantize] The requested number of bits " << bits
-        << " is not supported. The supported bits are 2, 3, 4, 5, 6 and 8.";
+    msg << "[varlen_attention] The query and key offsets must have the same "
+        << "number of sequences but got shapes " << cu_seqlens_q.shape()
+        << " and " << cu_seqlens_k.shape() << ".";
     throw std::invalid_argument(msg.str());
   }
-
-  if (w.ndim() < 2) {
+  auto final_type = result_type(queries, keys, values);
+  if (!issubdtype(final_type, floating)) {
     std::ostringstream msg;
-    msg << "[quantize] The matrix to be quantized must have at least 2 dimension "
-        << "but it has only " << w.ndim() << ".";
+    msg << "[varlen_attention] Received unsupported type " << final_type
+        << ".";
     throw std::invalid_argument(msg.str());
   }
 
-  if ((w.shape(-1) % group_size) != 0) {
+  // The sequences are attended to at once as one batch with a block
+  // diagonal mask.
+  auto s = to_stream(s_);
+  auto fallback = [scale, causal, s](std::vector<array> inputs) {
+    auto& cu_q = inputs[3];
+    auto& cu_k = inputs[4];
+    int qL = inputs[0].shape(0);
+    int kL = inputs[1].shape(0);
+    auto seg_q = varlen_segments(cu_q, qL, s);
+    auto seg_k = varlen_segments(cu_k, kL, s);
+    auto mask =
+        equal(expand_dims(seg_q, 1, s), expand_dims(seg_k, 0, s), s);
+    if (causal) {
+      // The last query of a sequence sees all of its keys.
+      auto next = add(seg_q, array(1, int32), s);
+      auto last =
+          add(arange(qL, int32, s),
+              subtract(take(cu_k, next, s), take(cu_q, next, s), s),
+              s);
+      mask = logical_and(
+          mask,
+          less_equal(
+              expand_dims(arange(kL, int32, s), 0, s),
+              expand_dims(last, 1, s),
+              s),
+          s);
+    }
+    auto batch = [&](const array& x) {
+      return expand_dims(swapaxes(x, 0, 1, s), 0, s);
+    };
+    auto out = scaled_dot_product_attention(
+        batch(inputs[0]),
+        batch(inputs[1]),
+        batch(inputs[2]),
+        scale,
+        "",
+        {mask},
+        0,
+        0,
+        s);
+    return std::vector<array>{swapaxes(squeeze(out, 0, s), 0, 1, s)};
+  };
+
+  std::vector<array> inputs = {
+      astype(queries, final_type, s),
+      astype(keys, final_type, s),
+      astype(values, final_type, s),
+      astype(cu_seqlens_q, int32, s),
+      astype(cu_seqlens_k, int32, s)};
+  if (!VarlenAttention::use_fallback(inputs[0], inputs[2], s)) {
+    auto out_shape = Shape{queries.shape(0), queries.shape(1), values.shape(2)};
+    return array(
+        std::move(out_shape),
+        final_type,
+        std::make_shared<VarlenAttention>(s, fallback, scale, causal),
+        std::move(inputs));
+  }
+  return fallback(std::move(inputs))[0];
+}
+
+array quantized_scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& k_scales,
+    const array& k_biases,
+    const array& values,
+    const array& v_scales,
+    const array& v_biases,
+    const float scale,
+    const std::string& mask_mode /* = "" */,
+    const std::vector<array>& mask_arrs /* = {} */,
+    int group_size /* = 64 */,
+    int bits /* = 8 */,
+    StreamOrDevice s_ /* = {} */) {
+  for (const auto& tensor : {queries, keys, values}) {
+    if (tensor.ndim() != 4) {
+      std::ostringstream msg;
+      msg << "[quantized_scaled_dot_product_attention] input with shape "
+          << tensor.shape() << " expected to be rank 4";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+  if (!issubdtype(queries.dtype(), floating)) {
     std::ostringstream msg;
-    msg << "[quantize] The last dimension of the matrix needs to be divisible by "
-        << "the quantization group size " << group_size
-        << ". However the provided " << " matrix has shape " << w.shape();
+    msg << "[quantized_scaled_dot_product_attention] Received unsupported "
+        << "type " << queries.dtype() << ".";
     throw std::invalid_argument(msg.str());
   }
-
-  auto fallback = [group_size, bits, s](
-                      const std::vector<array>& inputs) -> std::vector<array> {
+  // The dequantization checks the quantized shapes.
+  auto s = to_stream(s_);
+  auto fallback = [scale, mask_mode, group_size, bits, s](
+                      const std::vector<array>& inputs) {
+    auto dtype = inputs[0].dtype();
+    auto dequantize = [&](int i) {
+      return astype(
+          affine_dequantize(
+              inputs[i], inputs[i + 1], inputs[i + 2], group_size, bits, s),
+          dtype,
+          s);
+    };
+    std::vector<array> mask_arrs(inputs.begin() + 7, inputs.end());
+    return std::vector<array>{scaled_dot_product_attention(
+        inputs[0],
+        dequantize(1),
+        dequantize(4),
+        scale,
+        mask_mode,
+        mask_arrs,
+        0,
+        0,
+        s)};
+  };
+
+  std::vector<array> inputs = {
+      queries, keys, k_scales, k_biases, values, v_scales, v_biases};
+  bool do_causal = mask_mode == "causal";
+  bool has_arr_mask = !mask_arrs.empty();
+  if (!QuantizedScaledDotProductAttention::use_fallback(
+          queries, keys, has_arr_mask, do_causal, group_size, bits, s)) {
+    int head_dim = queries.shape(3);
+    if ((mask_mode != "" && !do_causal) ||
+        keys.shape() != values.shape() || keys.dtype() != uint32 ||
+        values.dtype() != uint32 || keys.shape(3) * 32 / bits != head_dim ||
+        keys.shape(0) != queries.shape(0) ||
+        queries.shape(1) % keys.shape(1) != 0) {
+      // Let the composition report the error.
+      return fallback(std::move(inputs))[0];
+    }
+    auto sshape = keys.shape();
+    sshape.back() = head_dim / group_size;
+    for (int i : {2, 3, 5, 6}) {
+      if (inputs[i].shape() != sshape) {
+        return fallback(std::move(inputs))[0];
+      }
+      inputs[i] = astype(inputs[i], queries.dtype(), s);
+    }
+    return array(
+        queries.shape(),
+        queries.dtype(),
+        std::make_shared<QuantizedScaledDotProductAttention>(
+            s, fallback, scale, do_causal, group_size, bits),
+        std::move(inputs));
+  }
+  inputs.insert(inputs.end(), mask_arrs.begin(), mask_arrs.end());
+  return fallback(std::move(inputs))[0];
+}
+
+bool QuantizedScaledDotProductAttention::is_equivalent(
+    const Primitive& other) const {
+  const QuantizedScaledDotProductAttention& a_other =
+      static_cast<const QuantizedScaledDotProductAttention&>(other);
+  return scale_ == a_other.scale_ && do_causal_ == a_other.do_causal_ &&
+      group_size_ == a_other.group_size_ && bits_ == a_other.bits_;
+}
+
+std::tuple<array, array, array> quantized_kv_write(
+    const array& cache,
+    const array& scales,
+    const array& biases,
+    const array& x,
+    int offset,
+    int group_size /* = 64 */,
+    int bits /* = 8 */,
+    StreamOrDevice s_ /* = {} */) {
+  if (cache.ndim() != 4 || x.ndim() != 4 || cache.dtype() != uint32) {
+    std::ostringstream msg;
+    msg << "[quantized_kv_write] Expected a uint32 cache and an input with "
+        << "4 dimensions but got shapes " << cache.shape() << " and "
+        << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int head_dim = x.shape(3);
+  auto sshape = cache.shape();
+  sshape.back() = head_dim / group_size;
+  if (head_dim % group_size != 0 ||
+      cache.shape(3) * 32 != head_dim * bits || x.shape(0) != cache.shape(0) ||
+      x.shape(1) != cache.shape(1) || scales.shape() != sshape ||
+      biases.shape() != sshape) {
+    std::ostringstream msg;
+    msg << "[quantized_kv_write] The input of shape " << x.shape()
+        << " does not match the cache of shape " << cache.shape()
+        << " and the scales and biases of shapes " << scales.shape()
+        << " and " << biases.shape() << " with group_size=" << group_size
+        << " and bits=" << bits << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int L = x.shape(2);
+  if (offset < 0 || offset + L > cache.shape(2)) {
+    std::ostringstream msg;
+    msg << "[quantized_kv_write] The " << L << " positions at offset "
+        << offset << " do not fit in the cache of shape " << cache.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto fallback = [offset, group_size, bits, s](
+                      const std::vector<array>& inputs) {
+    auto [wq, x_scales, x_biases] =
+        affine_quantize(inputs[3], group_size, bits, s);
+    auto update = [&](const array& a, const array& upd) {
+      Shape start = {0, 0, offset, 0};
+      Shape stop = a.shape();
+      stop[2] = offset + upd.shape(2);
+      return slice_update(a, upd, start, stop, s);
+    };
+    return std::vector<array>{
+        update(inputs[0], wq),
+        update(inputs[1], x_scales),
+        update(inputs[2], x_biases)};
+  };
+
+  auto dtype = scales.dtype();
+  std::vector<array> inputs = {cache, scales, astype(biases, dtype, s), x};
+  if (!QuantizedKVWrite::use_fallback(group_size, bits, s)) {
+    inputs[3] = astype(x, dtype, s);
+    auto outputs = array::make_arrays(
+        {cache.shape(), scales.shape(), biases.shape()},
+        {uint32, dtype, dtype},
+        std::make_shared<QuantizedKVWrite>(
+            s, fallback, offset, group_size, bits),
+        std::move(inputs));
+    return {outputs[0], outputs[1], outputs[2]};
+  }
+  auto outputs = fallback(std::move(inputs));
+  return {outputs[0], outputs[1], outputs[2]};
+}
+
+bool QuantizedKVWrite::is_equivalent(const Primitive& other) const {
+  const QuantizedKVWrite& a_other = static_cast<const QuantizedKVWrite&>(other);
+  return offset_ == a_other.offset_ && group_size_ == a_other.group_size_ &&
+      bits_ == a_other.bits_;
+}
+
+namespace {
+
+void check_page_table(
+    const char* tag,
+    int batch_size,
+    const array& block_table,
+    const array& context_lens) {
+  if (block_table.ndim() != 2 || block_table.shape(0) != batch_size ||
+      context_lens.ndim() != 1 || context_lens.shape(0) != batch_size) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Expected a block table of shape (" << batch_size
+        << ", max_pages) and context lengths of shape (" << batch_size
+        << ",) but got " << block_table.shape() << " and "
+        << context_lens.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(block_table.dtype(), integer) ||
+      !issubdtype(context_lens.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The block table and the context lengths must be "
+        << "integers but got " << block_table.dtype() << " and "
+        << context_lens.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+void check_pages(const char* tag, const array& k_pages, const array& v_pages) {
+  if (k_pages.ndim() != 4 || k_pages.shape() != v_pages.shape()) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Expected key and value pages of the same shape "
+        << "(num_pages, n_kv_heads, page_size, head_dim) but got "
+        << k_pages.shape() << " and " << v_pages.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(k_pages.dtype(), floating) ||
+      k_pages.dtype() != v_pages.dtype()) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Expected key and value pages of the same floating "
+        << "type but got " << k_pages.dtype() << " and " << v_pages.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+} // namespace
+
+std::pair<array, array> paged_kv_write(
+    const array& k_pages,
+    const array& v_pages,
+    const array& keys,
+    const array& values,
+    const array& block_table,
+    const array& context_lens,
+    StreamOrDevice s_ /* = {} */) {
+  check_pages("paged_kv_write", k_pages, v_pages);
+  if (keys.ndim() != 4 || keys.shape() != values.shape() ||
+      keys.shape(1) != k_pages.shape(1) || keys.shape(3) != k_pages.shape(3)) {
+    std::ostringstream msg;
+    msg << "[paged_kv_write] Expected keys and values of the same shape "
+        << "(B, " << k_pages.shape(1) << ", L, " << k_pages.shape(3)
+        << ") but got " << keys.shape() << " and " << values.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  check_page_table("paged_kv_write", keys.shape(0), block_table, context_lens);
+
+  auto s = to_stream(s_);
+  int page_size = k_pages.shape(2);
+  auto fallback = [page_size, s](std::vector<array> inputs) {
+    auto& keys = inputs[2];
+    int B = keys.shape(0);
+    int n_kv_heads = keys.shape(1);
+    int L = keys.shape(2);
+    int D = keys.shape(3);
+    auto positions = add(
+        expand_dims(inputs[5], 1, s), arange(L, inputs[5].dtype(), s), s);
+    auto page_size_arr = array(page_size, positions.dtype());
+    auto pages = take_along_axis(
+        inputs[4], floor_divide(positions, page_size_arr, s), 1, s);
+    auto slots = remainder(positions, page_size_arr, s);
+    auto update = [&](const array& pool, const array& x) {
+      auto x_t = reshape(
+          transpose(x, {0, 2, 1, 3}, s), {B, L, 1, n_kv_heads, 1, D}, s);
+      return scatter(pool, {pages, slots}, x_t, {0, 2}, s);
+    };
+    return std::vector<array>{
+        update(inputs[0], inputs[2]), update(inputs[1], inputs[3])};
+  };
+
+  auto dtype = k_pages.dtype();
+  std::vector<array> inputs = {
+      k_pages,
+      v_pages,
+      astype(keys, dtype, s),
+      astype(values, dtype, s),
+      astype(block_table, int32, s),
+      astype(context_lens, int32, s)};
+  if (!PagedKVWrite::use_fallback(s)) {
+    auto outputs = array::make_arrays(
+        {k_pages.shape(), v_pages.shape()},
+        {dtype, dtype},
+        std::make_shared<PagedKVWrite>(s, fallback),
+        std::move(inputs));
+    return {outputs[0], outputs[1]};
+  }
+  auto outputs = fallback(std::move(inputs));
+  return {outputs[0], outputs[1]};
+}
+
+array paged_attention(
+    const array& queries,
+    const array& k_pages,
+    const array& v_pages,
+    const array& block_table,
+    const array& context_lens,
+    const float scale,
+    StreamOrDevice s_ /* = {} */) {
+  check_pages("paged_attention", k_pages, v_pages);
+  if (queries.ndim() != 4 || queries.shape(3) != k_pages.shape(3) ||
+      queries.shape(1) % k_pages.shape(1) != 0) {
+    std::ostringstream msg;
+    msg << "[paged_attention] Expected queries of shape (B, n_heads, L, "
+        << k_pages.shape(3) << ") with n_heads a multiple of "
+        << k_pages.shape(1) << " but got " << queries.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  check_page_table(
+      "paged_attention", queries.shape(0), block_table, context_lens);
+
+  auto s = to_stream(s_);
+  auto fallback = [scale, s](std::vector<array> inputs) {
+    auto& q = inputs[0];
+    int B = q.shape(0);
+    int L = q.shape(2);
+    // Gather the pages of each sequence into contiguous keys and values.
+    auto gather = [&](const array& pool) {
+      auto x = take(pool, inputs[3], 0, s);
+      x = transpose(x, {0, 2, 1, 3, 4}, s);
+      return flatten(x, 2, 3, s);
+    };
+    auto k = gather(inputs[1]);
+    auto v = gather(inputs[2]);
+    int kL = k.shape(2);
+    auto& lens = inputs[4];
+    auto q_pos = add(
+        expand_dims(subtract(lens, array(L, lens.dtype()), s), 1, s),
+        arange(L, lens.dtype(), s),
+        s);
+    auto mask = less_equal(
+        reshape(arange(kL, lens.dtype(), s), {1, 1, kL}, s),
+        expand_dims(q_pos, 2, s),
+        s);
+    mask = reshape(mask, {B, 1, L, kL}, s);
+    return std::vector<array>{
+        scaled_dot_product_attention(q, k, v, scale, "", {mask}, 0, 0, s)};
+  };
+
+  auto dtype = k_pages.dtype();
+  std::vector<array> inputs = {
+      astype(queries, dtype, s),
+      k_pages,
+      v_pages,
+      astype(block_table, int32, s),
+      astype(context_lens, int32, s)};
+  if (!PagedAttention::use_fallback(queries, k_pages, s)) {
+    return array(
+        queries.shape(),
+        dtype,
+        std::make_shared<PagedAttention>(s, fallback, scale),
+        std::move(inputs));
+  }
+  return fallback(std::move(inputs))[0];
+}
+
+bool PagedAttention::is_equivalent(const Primitive& other) const {
+  const PagedAttention& a_other = static_cast<const PagedAttention&>(other);
+  return scale_ == a_other.scale_;
+}
+
+std::vector<Shape> PagedKVWrite::output_shapes(
+    const std::vector<array>& inputs) {
+  return {inputs[0].shape(), inputs[1].shape()};
+}
+
+std::vector<Shape> PagedAttention::output_shapes(
+    const std::vector<array>& inputs) {
+  return {inputs[0].shape()};
+}
+
+PagedKVCache::PagedKVCache(
+    int num_pages,
+    int page_size,
+    int n_kv_heads,
+    int head_dim,
+    Dtype dtype /* = float16 */,
+    StreamOrDevice s /* = {} */)
+    : page_size_(page_size),
+      stream_(to_stream(s)),
+      k_pages_(zeros({num_pages, n_kv_heads, page_size, head_dim}, dtype, s)),
+      v_pages_(zeros({num_pages, n_kv_heads, page_size, head_dim}, dtype, s)) {
+  if (num_pages <= 0 || page_size <= 0) {
+    std::ostringstream msg;
+    msg << "[PagedKVCache] Expected a positive number of pages and page size "
+        << "but got " << num_pages << " and " << page_size << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  // The pages are taken from the back.
+  free_pages_.resize(num_pages);
+  std::iota(free_pages_.rbegin(), free_pages_.rend(), 0);
+}
+
+PagedKVCache::Sequence& PagedKVCache::sequence(int seq) {
+  auto it = sequences_.find(seq);
+  if (it == sequences_.end()) {
+    std::ostringstream msg;
+    msg << "[PagedKVCache] Unknown sequence " << seq << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return it->second;
+}
+
+const PagedKVCache::Sequence& PagedKVCache::sequence(int seq) const {
+  return const_cast<PagedKVCache*>(this)->sequence(seq);
+}
+
+int PagedKVCache::add_sequence() {
+  int seq = next_seq_++;
+  sequences_.emplace(seq, Sequence{});
+  return seq;
+}
+
+void PagedKVCache::free_sequence(int seq) {
+  auto& pages = sequence(seq).pages;
+  free_pages_.insert(free_pages_.end(), pages.rbegin(), pages.rend());
+  sequences_.erase(seq);
+}
+
+int PagedKVCache::length(int seq) const {
+  return sequence(seq).length;
+}
+
+void PagedKVCache::append(
+    const std::vector<int>& seqs,
+    const array& keys,
+    const array& values) {
+  if (keys.ndim() != 4 || keys.shape(0) != seqs.size()) {
+    std::ostringstream msg;
+    msg << "[PagedKVCache::append] Expected keys of shape (" << seqs.size()
+        << ", n_kv_heads, L, head_dim) but got " << keys.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int L = keys.shape(2);
+
+  // Check that the pool has enough pages before taking any of them.
+  size_t needed = 0;
+  for (int seq : seqs) {
+    auto& sq = sequence(seq);
+    int num_pages = (sq.length + L + page_size_ - 1) / page_size_;
+    needed += std::max<int>(num_pages - sq.pages.size(), 0);
+  }
+  if (needed > free_pages_.size()) {
+    std::ostringstream msg;
+    msg << "[PagedKVCache::append] Needs " << needed << " pages but only "
+        << free_pages_.size() << " are free.";
+    throw std::runtime_error(msg.str());
+  }
+  for (int seq : seqs) {
+    auto& sq = sequence(seq);
+    while (sq.pages.size() * page_size_ < sq.length + L) {
+      sq.pages.push_back(free_pages_.back());
+      free_pages_.pop_back();
+    }
+  }
+
+  auto [table, lens] = block_table(seqs);
+  std::tie(k_pages_, v_pages_) = paged_kv_write(
+      k_pages_, v_pages_, keys, values, table, lens, stream_);
+  for (int seq : seqs) {
+    sequence(seq).length += L;
+  }
+}
+
+array PagedKVCache::attention(
+    const std::vector<int>& seqs,
+    const array& queries,
+    const float scale) {
+  auto [table, lens] = block_table(seqs);
+  return paged_attention(
+      queries, k_pages_, v_pages_, table, lens, scale, stream_);
+}
+
+std::pair<array, array> PagedKVCache::block_table(
+    const std::vector<int>& seqs) const {
+  size_t max_pages = 1;
+  for (int seq : seqs) {
+    max_pages = std::max(max_pages, sequence(seq).pages.size());
+  }
+  // The entries past the pages of a sequence are never read.
+  std::vector<int32_t> table(seqs.size() * max_pages, 0);
+  std::vector<int32_t> lens;
+  for (int i = 0; i < seqs.size(); ++i) {
+    auto& sq = sequence(seqs[i]);
+    std::copy(
+        sq.pages.begin(), sq.pages.end(), table.begin() + i * max_pages);
+    lens.push_back(sq.length);
+  }
+  int B = seqs.size();
+  return {
+      array(table.begin(), {B, static_cast<int>(max_pages)}, int32),
+      array(lens.begin(), {B}, int32)};
+}
+
+bool FusedMatmul::is_equivalent(const Primitive& other) const {
+  const FusedMatmul& f_other = static_cast<const FusedMatmul&>(other);
+  return activation_ == f_other.activation_ &&
+      precision_ == f_other.precision_;
+}
+
+array pack_and_quantize(
+    array& packed_w,
+    const array& scales,
+    const array& biases,
+    int bits,
+    const Stream& s) {
+  int el_per_int = 32 / bits;
+  array zero(0, packed_w.dtype());
+  array n_bins((1 << bits) - 1, packed_w.dtype()); // 2**bits - 1
+  packed_w = astype(
+      clip(
+          round(divide(subtract(packed_w, biases, s), scales, s), s),
+          zero,
+          n_bins,
+          s),
+      uint32,
+      s);
+  if (is_power_of_2(bits)) {
+    array shifts = power(array(2, uint32), arange(0, 32, bits, uint32, s), s);
+    packed_w = reshape(packed_w, {packed_w.shape(0), -1, el_per_int}, s);
+    packed_w = sum(
+        multiply(packed_w, shifts, s), /* axis= */ 2, /* keepdims= */ false, s);
+  } else {
+    // This is slow but we have fast GPU/CPU versions of this function so we
+    // shouldn't be here often.
+    packed_w = expand_dims(packed_w, /* axis= */ -1, s);
+    packed_w = bitwise_and(
+        right_shift(packed_w, arange(bits, uint32, s), s),
+        array({1}, uint32),
+        s);
+    auto new_shape = packed_w.shape();
+    new_shape[new_shape.size() - 2] = -1;
+    new_shape.back() = 32;
+    packed_w = reshape(packed_w, new_shape, s);
+    array shifts = arange(32, uint32, s);
+    packed_w =
+        sum(left_shift(packed_w, shifts, s),
+            /* axis= */ -1,
+            /* keepdims= */ false,
+            s);
+  }
+  return packed_w;
+}
+
+std::tuple<array, array, array>
+affine_quantize(const array& w, int group_size, int bits, StreamOrDevice s_) {
+  auto s = to_stream(s_);
+
+  if (group_size != 32 && group_size != 64 && group_size != 128) {
+    std::ostringstream msg;
+    msg << "[quantize] The requested group size " << group_size
+        << " is not supported. The supported group sizes are 32, 64, and 128.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if (bits < 2 || bits > 8 || bits == 7) {
+    std::ostringstream msg;
+    msg << "[quantize] The requested number of bits " << bits
+        << " is not supported. The supported bits are 2, 3, 4, 5, 6 and 8.";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if (w.ndim() < 2) {
+    std::ostringstream msg;
+    msg << "[quantize] The matrix to be quantized must have at least 2 dimension "
+        << "but it has only " << w.ndim() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  if ((w.shape(-1) % group_size) != 0) {
+    std::ostringstream msg;
+    msg << "[quantize] The last dimension of the matrix needs to be divisible by "
+        << "the quantization group size " << group_size
+        << ". However the provided " << " matrix has shape " << w.shape();
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto fallback = [group_size, bits, s](
+                      const std::vector<array>& inputs) -> std::vector<array> {
     auto& w = inputs[0];
     auto wshape = w.shape();
     wshape.back() = -1;
@@ -999,11 +2004,1411 @@ array affine_dequantize(
   return fallback({w, scales, biases})[0];
 }
 
-bool AffineQuantize::is_equivalent(const Primitive& other) const {
-  const AffineQuantize& p_other = static_cast<const AffineQuantize&>(other);
-  return (
-      p_other.group_size_ == group_size_ && p_other.bits_ == bits_ &&
-      p_other.dequantize_ == dequantize_);
+array quantized_embedding(
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    int group_size /* = 64 */,
+    int bits /* = 4 */,
+    StreamOrDevice s_ /* = {} */) {
+  if (w.ndim() != 2 || w.dtype() != uint32) {
+    std::ostringstream msg;
+    msg << "[quantized_embedding] Expected a 2D uint32 matrix but got "
+        << w.dtype() << " with shape " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (group_size != 32 && group_size != 64 && group_size != 128) {
+    std::ostringstream msg;
+    msg << "[quantized_embedding] The group size " << group_size
+        << " is not supported. The supported group sizes are 32, 64, and 128.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (bits < 2 || bits > 8 || bits == 7) {
+    std::ostringstream msg;
+    msg << "[quantized_embedding] The number of bits " << bits
+        << " is not supported. The supported bits are 2, 3, 4, 5, 6 and 8.";
+    throw std::invalid_argument(msg.str());
+  }
+  int dims = w.shape(1) * 32 / bits;
+  Shape sshape = {w.shape(0), dims / group_size};
+  if (dims % group_size != 0 || scales.shape() != sshape ||
+      biases.shape() != sshape) {
+    std::ostringstream msg;
+    msg << "[quantized_embedding] Shape of scales and biases does not match "
+        << "the matrix given the quantization parameters. Provided matrix of "
+        << "shape " << w.shape() << " and scales/biases of shape "
+        << scales.shape() << " with group_size=" << group_size
+        << " and bits=" << bits << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(scales.dtype(), floating) ||
+      scales.dtype() != biases.dtype()) {
+    throw std::invalid_argument(
+        "[quantized_embedding] The scales and biases must have the same "
+        "floating point type.");
+  }
+  if (!issubdtype(indices.dtype(), integer)) {
+    throw std::invalid_argument(
+        "[quantized_embedding] The indices must be integers.");
+  }
+
+  auto s = to_stream(s_);
+  auto out_shape = indices.shape();
+  out_shape.push_back(dims);
+  auto fallback = [group_size, bits, out_shape, s](
+                      const std::vector<array>& inputs) {
+    auto idx = flatten(inputs[3], s);
+    auto out = affine_dequantize(
+        take(inputs[0], idx, 0, s),
+        take(inputs[1], idx, 0, s),
+        take(inputs[2], idx, 0, s),
+        group_size,
+        bits,
+        s);
+    return std::vector<array>{reshape(out, out_shape, s)};
+  };
+
+  // The row indices fit in 32 bits, which keeps the kernels to one index
+  // type.
+  std::vector<array> inputs = {w, scales, biases, astype(indices, int32, s)};
+  if (QuantizedEmbedding::use_fallback(s)) {
+    return fallback(inputs)[0];
+  }
+  return array(
+      std::move(out_shape),
+      scales.dtype(),
+      std::make_shared<QuantizedEmbedding>(s, fallback, group_size, bits),
+      std::move(inputs));
+}
+
+namespace {
+
+BlockScaledQuantize::Mode block_scaled_mode(
+    const std::string& mode,
+    const char* tag) {
+  if (mode == "mxfp4") {
+    return BlockScaledQuantize::MXFP4;
+  } else if (mode == "nvfp4") {
+    return BlockScaledQuantize::NVFP4;
+  } else if (mode == "mxfp8") {
+    return BlockScaledQuantize::MXFP8;
+  }
+  std::ostringstream msg;
+  msg << "[" << tag << "] Invalid quantization mode '" << mode
+      << "', expected 'mxfp4', 'nvfp4' or 'mxfp8'.";
+  throw std::invalid_argument(msg.str());
+}
+
+int block_scaled_group_size(BlockScaledQuantize::Mode mode) {
+  return mode == BlockScaledQuantize::NVFP4 ? 16 : 32;
+}
+
+int block_scaled_bits(BlockScaledQuantize::Mode mode) {
+  return mode == BlockScaledQuantize::MXFP8 ? 8 : 4;
+}
+
+// Rounds to the nearest e2m1 value {0, 0.5, 1, 1.5, 2, 3, 4, 6}, the ties
+// to even, and saturates to 6. The sign is the bit 3.
+array to_fp4(const array& x, const Stream& s) {
+  auto a = abs(x, s);
+  auto code = astype(greater(a, array(0.25f), s), uint32, s);
+  auto step = [&](float t, bool even) {
+    auto m = even ? greater_equal(a, array(t), s) : greater(a, array(t), s);
+    code = add(code, astype(m, uint32, s), s);
+  };
+  step(0.75f, true);
+  step(1.25f, false);
+  step(1.75f, true);
+  step(2.5f, false);
+  step(3.5f, true);
+  step(5.0f, false);
+  auto sign = where(less(x, array(0.0f), s), array(8u), array(0u), s);
+  return bitwise_or(code, sign, s);
+}
+
+array from_fp4(const array& x, const Stream& s) {
+  array lut(
+      {0.0f,
+       0.5f,
+       1.0f,
+       1.5f,
+       2.0f,
+       3.0f,
+       4.0f,
+       6.0f,
+       -0.0f,
+       -0.5f,
+       -1.0f,
+       -1.5f,
+       -2.0f,
+       -3.0f,
+       -4.0f,
+       -6.0f});
+  return take(lut, x, s);
+}
+
+} // namespace
+
+std::pair<array, array> block_scaled_quantize(
+    const array& w,
+    const std::string& mode_str,
+    StreamOrDevice s_) {
+  auto mode = block_scaled_mode(mode_str, "quantize");
+  int group_size = block_scaled_group_size(mode);
+  int bits = block_scaled_bits(mode);
+  if (!issubdtype(w.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[quantize] Expected a floating point matrix but got " << w.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (w.ndim() < 2) {
+    std::ostringstream msg;
+    msg << "[quantize] The matrix to be quantized must have at least 2 dimension "
+        << "but it has only " << w.ndim() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if ((w.shape(-1) % group_size) != 0) {
+    std::ostringstream msg;
+    msg << "[quantize] The last dimension of the matrix needs to be divisible by "
+        << "the quantization group size " << group_size << " of " << mode_str
+        << ". However the provided matrix has shape " << w.shape();
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto wq_shape = w.shape();
+  wq_shape.back() = w.shape(-1) * bits / 32;
+  auto sshape = w.shape();
+  sshape.back() = w.shape(-1) / group_size;
+
+  auto fallback = [mode, group_size, bits, wq_shape, sshape, s](
+                      const std::vector<array>& inputs) -> std::vector<array> {
+    auto& w = inputs[0];
+    auto g = reshape(
+        astype(w, float32, s), {-1, w.shape(-1) / group_size, group_size}, s);
+    auto amax = max(abs(g, s), /* axis= */ -1, /* keepdims= */ true, s);
+
+    // The e8m0 scale is the power of 2 which takes the largest element of
+    // the group to the binade of the largest value of the element format.
+    array scale_bytes = array(0);
+    array scales = array(0.0f);
+    if (mode == BlockScaledQuantize::NVFP4) {
+      scale_bytes = to_fp8(divide(amax, array(6.0f), s), "e4m3", s);
+      scales = from_fp8(scale_bytes, float32, "e4m3", s);
+    } else {
+      float emax = mode == BlockScaledQuantize::MXFP4 ? 2.0f : 8.0f;
+      auto e = subtract(floor(log2(amax, s), s), array(emax), s);
+      e = clip(e, array(-127.0f), array(127.0f), s);
+      scale_bytes = astype(add(e, array(127.0f), s), uint8, s);
+      scales = power(array(2.0f), e, s);
+    }
+    auto y = divide(g, scales, s);
+    y = where(equal(scales, array(0.0f), s), array(0.0f), y, s);
+
+    auto codes = mode == BlockScaledQuantize::MXFP8
+        ? astype(to_fp8(y, "e4m3", s), uint32, s)
+        : to_fp4(y, s);
+    codes = reshape(codes, {codes.shape(0), -1, 32 / bits}, s);
+    auto shifts = arange(0, 32, bits, uint32, s);
+    auto packed = sum(
+        left_shift(codes, shifts, s), /* axis= */ -1, /* keepdims= */ false, s);
+    return {reshape(packed, wq_shape, s), reshape(scale_bytes, sshape, s)};
+  };
+
+  if (!BlockScaledQuantize::use_fallback(s)) {
+    auto outputs = array::make_arrays(
+        {wq_shape, sshape},
+        {uint32, uint8},
+        std::make_shared<BlockScaledQuantize>(s, fallback, mode, false),
+        {w});
+    return {outputs[0], outputs[1]};
+  }
+  auto outputs = fallback({w});
+  return {outputs[0], outputs[1]};
+}
+
+array block_scaled_dequantize(
+    const array& w,
+    const array& scales,
+    const std::string& mode_str,
+    Dtype dtype /* = bfloat16 */,
+    StreamOrDevice s_) {
+  auto mode = block_scaled_mode(mode_str, "dequantize");
+  int group_size = block_scaled_group_size(mode);
+  int bits = block_scaled_bits(mode);
+  if (w.dtype() != uint32) {
+    throw std::invalid_argument(
+        "[dequantize] The matrix should be given as a uint32");
+  }
+  if (scales.dtype() != uint8) {
+    std::ostringstream msg;
+    msg << "[dequantize] The scales of " << mode_str
+        << " should be given as a uint8 but got " << scales.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(dtype, floating)) {
+    std::ostringstream msg;
+    msg << "[dequantize] Expected a floating point output type but got "
+        << dtype << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (w.ndim() < 2 || scales.ndim() != w.ndim()) {
+    std::ostringstream msg;
+    msg << "[dequantize] Expected a matrix and scales with the same number "
+        << "of dimensions, at least 2, but got shapes " << w.shape() << " and "
+        << scales.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int out_size = w.shape(-1) * 32 / bits;
+  auto wshape = w.shape();
+  auto sshape = scales.shape();
+  wshape.back() = -1;
+  sshape.back() = -1;
+  if (wshape != sshape || out_size != scales.shape(-1) * group_size) {
+    std::ostringstream msg;
+    msg << "[dequantize] Shape of scales does not match the matrix given the "
+        << "quantization mode. Provided matrix of shape " << w.shape()
+        << " and scales of shape " << scales.shape() << " with mode "
+        << mode_str << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto out_shape = w.shape();
+  out_shape.back() = out_size;
+
+  auto fallback = [mode, group_size, bits, dtype, out_shape, s](
+                      const std::vector<array>& inputs) -> std::vector<array> {
+    auto& w = inputs[0];
+    auto& scale_bytes = inputs[1];
+    auto codes = bitwise_and(
+        right_shift(
+            expand_dims(w, -1, s), arange(0, 32, bits, uint32, s), s),
+        array((1u << bits) - 1, uint32),
+        s);
+    auto values = mode == BlockScaledQuantize::MXFP8
+        ? from_fp8(astype(codes, uint8, s), float32, "e4m3", s)
+        : from_fp4(codes, s);
+    auto gshape = scale_bytes.shape();
+    gshape.push_back(group_size);
+    values = reshape(values, std::move(gshape), s);
+
+    auto scales = mode == BlockScaledQuantize::NVFP4
+        ? from_fp8(scale_bytes, float32, "e4m3", s)
+        : power(
+              array(2.0f),
+              subtract(astype(scale_bytes, float32, s), array(127.0f), s),
+              s);
+    values = multiply(values, expand_dims(scales, -1, s), s);
+    return {astype(reshape(values, out_shape, s), dtype, s)};
+  };
+
+  if (!BlockScaledQuantize::use_fallback(s)) {
+    return array(
+        std::move(out_shape),
+        dtype,
+        std::make_shared<BlockScaledQuantize>(s, fallback, mode, true),
+        {w, scales});
+  }
+  return fallback({w, scales})[0];
+}
+
+array fp8_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    StreamOrDevice s_) {
+  if (x.ndim() < 2 || w.ndim() != 2) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] Expected x with at least 2 dimensions and a 2D w "
+        << "but got x with shape " << x.shape() << " and w with shape "
+        << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (w.dtype() != uint8) {
+    throw std::invalid_argument(
+        "[fp8_matmul] The float8 matrix should be given as a uint8");
+  }
+  auto out_type = x.dtype();
+  if (out_type != float32 && out_type != float16 && out_type != bfloat16) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int N = w.shape(0);
+  if (x.shape(-1) != w.shape(1)) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] The last dimension of x must match the second "
+        << "dimension of w but got x with shape " << x.shape()
+        << " and w with shape " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (scales.size() != 1 && (scales.ndim() != 1 || scales.size() != N)) {
+    std::ostringstream msg;
+    msg << "[fp8_matmul] The scales must have 1 or " << N
+        << " elements but have shape " << scales.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto fallback = [out_type, s](const std::vector<array>& inputs) {
+    auto w = from_fp8(inputs[1], out_type, "e4m3", s);
+    auto scales = astype(reshape(inputs[2], {-1, 1}, s), out_type, s);
+    w = multiply(w, scales, s);
+    return std::vector<array>{matmul(inputs[0], transpose(w, s), s)};
+  };
+
+  auto passed_scales = flatten(astype(scales, float32, s), s);
+  if (!Fp8Matmul::use_fallback(x, w, s)) {
+    auto out_shape = x.shape();
+    out_shape.back() = N;
+    return array(
+        std::move(out_shape),
+        out_type,
+        std::make_shared<Fp8Matmul>(s, fallback),
+        {x, w, passed_scales});
+  }
+  return fallback({x, w, passed_scales})[0];
+}
+
+array int8_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    StreamOrDevice s_) {
+  if (x.ndim() < 2 || w.ndim() != 2) {
+    std::ostringstream msg;
+    msg << "[int8_matmul] Expected x with at least 2 dimensions and a 2D w "
+        << "but got x with shape " << x.shape() << " and w with shape "
+        << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (w.dtype() != int8) {
+    std::ostringstream msg;
+    msg << "[int8_matmul] Expected the weights as int8 but got " << w.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_type = x.dtype();
+  if (out_type != float32 && out_type != float16 && out_type != bfloat16) {
+    std::ostringstream msg;
+    msg << "[int8_matmul] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int N = w.shape(0);
+  if (x.shape(-1) != w.shape(1)) {
+    std::ostringstream msg;
+    msg << "[int8_matmul] The last dimension of x must match the second "
+        << "dimension of w but got x with shape " << x.shape()
+        << " and w with shape " << w.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (scales.size() != 1 && scales.size() != N) {
+    std::ostringstream msg;
+    msg << "[int8_matmul] The scales must have 1 or " << N
+        << " elements but have shape " << scales.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  // Quantize the rows of x like the fast path and multiply the integer
+  // values in float32, which is exact as long as the sums fit in 24 bits.
+  auto fallback = [out_type, s](const std::vector<array>& inputs) {
+    auto x = astype(inputs[0], float32, s);
+    auto amax = maximum(max(abs(x, s), -1, true, s), array(1e-12f), s);
+    auto x_scales = divide(amax, array(127.0f), s);
+    auto x_q = clip(
+        round(divide(x, x_scales, s), s), array(-127.0f), array(127.0f), s);
+    auto w = astype(inputs[1], float32, s);
+    auto out = matmul(x_q, transpose(w, s), s);
+    out = multiply(multiply(out, x_scales, s), inputs[2], s);
+    return std::vector<array>{astype(out, out_type, s)};
+  };
+
+  auto passed_scales = flatten(astype(scales, float32, s), s);
+  if (!Int8Matmul::use_fallback(x, w, s)) {
+    auto out_shape = x.shape();
+    out_shape.back() = N;
+    return array(
+        std::move(out_shape),
+        out_type,
+        std::make_shared<Int8Matmul>(s, fallback),
+        {x, w, passed_scales});
+  }
+  return fallback({x, w, passed_scales})[0];
+}
+
+namespace {
+
+array gated_activation(
+    const char* tag,
+    GatedActivation::Kind kind,
+    const array& x,
+    StreamOrDevice s_) {
+  if (x.ndim() == 0 || x.shape(-1) % 2 != 0) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The last axis of the input must have an even "
+        << "size but the input has shape " << x.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_type = x.dtype();
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto acc_type = out_type == float64 ? float64 : float32;
+  auto fallback = [kind, out_type, acc_type, s](
+                      const std::vector<array>& inputs) {
+    auto halves = split(astype(inputs[0], acc_type, s), 2, -1, s);
+    auto& a = halves[0];
+    array act = a;
+    if (kind == GatedActivation::SiLU) {
+      act = multiply(a, sigmoid(a, s), s);
+    } else {
+      auto cdf = multiply(
+          array(0.5, acc_type),
+          add(array(1.0, acc_type),
+              erf(multiply(a, array(M_SQRT1_2, acc_type), s), s),
+              s),
+          s);
+      act = multiply(a, cdf, s);
+    }
+    auto out = multiply(act, halves[1], s);
+    return std::vector<array>{astype(out, out_type, s)};
+  };
+
+  if (!GatedActivation::use_fallback(s)) {
+    auto out_shape = x.shape();
+    out_shape.back() /= 2;
+    return array(
+        std::move(out_shape),
+        out_type,
+        std::make_shared<GatedActivation>(s, fallback, kind),
+        {x});
+  }
+  return fallback({x})[0];
+}
+
+} // namespace
+
+array swiglu(const array& x, StreamOrDevice s /* = {} */) {
+  return gated_activation("swiglu", GatedActivation::SiLU, x, s);
+}
+
+array geglu(const array& x, StreamOrDevice s /* = {} */) {
+  return gated_activation("geglu", GatedActivation::GELU, x, s);
+}
+
+std::vector<array> GatedActivation::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  // The gradients of the halves a and b of x are g * b * act'(a) and
+  // g * act(a), they are written in one pass by GatedActivationVJP.
+  auto s = stream();
+  auto kind = kind_;
+  auto fallback = [kind, s](const std::vector<array>& inputs) {
+    auto& x = inputs[0];
+    auto acc_type = x.dtype() == float64 ? float64 : float32;
+    auto halves = split(astype(x, acc_type, s), 2, -1, s);
+    auto& a = halves[0];
+    auto& b = halves[1];
+    auto g = astype(inputs[1], acc_type, s);
+    auto one = array(1.0, acc_type);
+    array act = a;
+    array dact = a;
+    if (kind == GatedActivation::SiLU) {
+      auto sig = sigmoid(a, s);
+      act = multiply(a, sig, s);
+      dact = multiply(
+          sig, add(one, multiply(a, subtract(one, sig, s), s), s), s);
+    } else {
+      auto cdf = multiply(
+          array(0.5, acc_type),
+          add(one, erf(multiply(a, array(M_SQRT1_2, acc_type), s), s), s),
+          s);
+      auto pdf = multiply(
+          array(0.5 * M_2_SQRTPI * M_SQRT1_2, acc_type),
+          exp(multiply(array(-0.5, acc_type), square(a, s), s), s),
+          s);
+      act = multiply(a, cdf, s);
+      dact = add(cdf, multiply(a, pdf, s), s);
+    }
+    auto da = multiply(multiply(g, b, s), dact, s);
+    auto db = multiply(g, act, s);
+    return std::vector<array>{
+        astype(concatenate({da, db}, -1, s), x.dtype(), s)};
+  };
+
+  auto& x = primals[0];
+  return {array(
+      x.shape(),
+      x.dtype(),
+      std::make_shared<GatedActivationVJP>(s, fallback, kind_),
+      {x, cotangents[0]})};
+}
+
+array cross_entropy(
+    const array& logits,
+    const array& targets,
+    StreamOrDevice s_ /* = {} */) {
+  if (logits.ndim() == 0) {
+    throw std::invalid_argument(
+        "[cross_entropy] The logits must have at least 1 dimension.");
+  }
+  auto out_shape = logits.shape();
+  out_shape.pop_back();
+  if (targets.shape() != out_shape) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] Targets shape " << targets.shape()
+        << " does not match logits shape " << logits.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(targets.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] The targets must be class indices but have type "
+        << targets.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_type = logits.dtype();
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[cross_entropy] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // The outputs are the loss and the logsumexp of the logits, which the
+  // vjp reuses to compute the softmax.
+  auto s = to_stream(s_);
+  auto acc_type = out_type == float64 ? float64 : float32;
+  auto fallback = [out_type, acc_type, s](const std::vector<array>& inputs) {
+    auto logits = astype(inputs[0], acc_type, s);
+    auto lse = logsumexp(logits, -1, /* keepdims= */ false, s);
+    auto score = take_along_axis(logits, expand_dims(inputs[1], -1, s), -1, s);
+    auto loss = subtract(lse, squeeze(score, -1, s), s);
+    return std::vector<array>{astype(loss, out_type, s), lse};
+  };
+
+  auto passed_targets = astype(targets, int32, s);
+  if (!CrossEntropy::use_fallback(s)) {
+    return array::make_arrays(
+        {out_shape, out_shape},
+        {out_type, acc_type},
+        std::make_shared<CrossEntropy>(s, fallback),
+        {logits, passed_targets})[0];
+  }
+  return fallback({logits, passed_targets})[0];
+}
+
+std::vector<array> CrossEntropy::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>& outputs) {
+  assert(primals.size() == 2);
+  assert(outputs.size() == 2);
+
+  // The gradient of the logits is (softmax(logits) - onehot(targets)) * g,
+  // the logsumexp output only exists for the vjp and has no cotangent.
+  auto s = stream();
+  auto fallback = [s](const std::vector<array>& inputs) {
+    auto& logits = inputs[0];
+    auto& targets = inputs[1];
+    auto& lse = inputs[2];
+    auto& g = inputs[3];
+    auto acc_type = lse.dtype();
+    auto p = exp(
+        subtract(astype(logits, acc_type, s), expand_dims(lse, -1, s), s), s);
+    // The negative targets count from the last class.
+    int num_classes = logits.shape(-1);
+    auto classes = arange(num_classes, int32, s);
+    auto t = where(
+        less(targets, array(0), s),
+        add(targets, array(num_classes), s),
+        targets,
+        s);
+    auto onehot = equal(expand_dims(t, -1, s), classes, s);
+    auto grad = multiply(
+        subtract(p, astype(onehot, acc_type, s), s),
+        expand_dims(astype(g, acc_type, s), -1, s),
+        s);
+    return std::vector<array>{astype(grad, logits.dtype(), s)};
+  };
+
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg == 0) {
+      vjps.push_back(array(
+          primals[0].shape(),
+          primals[0].dtype(),
+          std::make_shared<CrossEntropyVJP>(s, fallback),
+          {primals[0], primals[1], outputs[1], cotangents[0]}));
+    } else {
+      vjps.push_back(zeros_like(primals[1], s));
+    }
+  }
+  return vjps;
+}
+
+array sample_top_k_top_p(
+    const array& logits,
+    float temperature,
+    int top_k,
+    float top_p,
+    const std::optional<array>& key_ /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  if (logits.ndim() == 0) {
+    throw std::invalid_argument(
+        "[sample_top_k_top_p] The logits must have at least 1 dimension.");
+  }
+  if (!issubdtype(logits.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[sample_top_k_top_p] Received unsupported type "
+        << logits.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (temperature < 0 || top_k < 0 || !(top_p > 0 && top_p <= 1)) {
+    std::ostringstream msg;
+    msg << "[sample_top_k_top_p] Invalid temperature " << temperature
+        << ", top_k " << top_k << " or top_p " << top_p << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // A zero temperature picks the largest logit.
+  auto s = to_stream(s_);
+  if (temperature == 0) {
+    return argmax(logits, -1, /* keepdims= */ false, s);
+  }
+
+  auto key = key_ ? *key_ : random::KeySequence::default_().next();
+  if (key.dtype() != uint32 || key.shape() != Shape{2}) {
+    std::ostringstream msg;
+    msg << "[sample_top_k_top_p] Expected a uint32 key of shape (2) but "
+        << "received " << key.dtype() << " " << key.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto fallback = [temperature, top_k, top_p, s](
+                      const std::vector<array>& inputs) {
+    auto x = divide(astype(inputs[0], float32, s), array(temperature), s);
+    auto neg_inf = array(-std::numeric_limits<float>::infinity());
+    int axis_size = x.shape(-1);
+    if (top_k > 0 && top_k < axis_size) {
+      auto kth = take(sort(x, -1, s), axis_size - top_k, -1, s);
+      x = where(less(x, expand_dims(kth, -1, s), s), neg_inf, x, s);
+    }
+    if (top_p < 1) {
+      // Keep the probabilities for which the mass of the larger ones is
+      // below top_p.
+      auto probs = softmax(x, -1, /* precise= */ true, s);
+      auto sorted = sort(probs, -1, s);
+      auto larger = cumsum(
+          sorted, -1, /* reverse= */ true, /* inclusive= */ false, s);
+      auto kept = where(
+          less(larger, array(top_p), s),
+          sorted,
+          array(std::numeric_limits<float>::infinity()),
+          s);
+      auto threshold = min(kept, -1, /* keepdims= */ true, s);
+      x = where(less(probs, threshold, s), neg_inf, x, s);
+    }
+    auto g = random::gumbel(x.shape(), float32, inputs[1], s);
+    return std::vector<array>{argmax(add(x, g, s), -1, false, s)};
+  };
+
+  if (SampleTopKTopP::use_fallback(s)) {
+    return fallback({logits, key})[0];
+  }
+  auto out_shape = logits.shape();
+  out_shape.pop_back();
+  return array(
+      std::move(out_shape),
+      uint32,
+      std::make_shared<SampleTopKTopP>(
+          s, fallback, temperature, top_k, top_p),
+      {logits, key});
+}
+
+std::tuple<array, array, array, array> moe_route(
+    const array& logits,
+    int k,
+    bool normalize /* = true */,
+    StreamOrDevice s_ /* = {} */) {
+  if (logits.ndim() == 0) {
+    throw std::invalid_argument(
+        "[moe_route] The logits must have at least 1 dimension.");
+  }
+  auto out_type = logits.dtype();
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[moe_route] Received unsupported type " << out_type << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int num_experts = logits.shape(-1);
+  if (k <= 0 || k > num_experts) {
+    std::ostringstream msg;
+    msg << "[moe_route] Expected k between 1 and the number of experts "
+        << num_experts << " but got " << k << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto s = to_stream(s_);
+  auto fallback = [k, normalize, out_type, s](
+                      const std::vector<array>& inputs) {
+    auto probs = softmax(
+        astype(inputs[0], float32, s), -1, /* precise= */ true, s);
+    int num_experts = probs.shape(-1);
+    auto neg_probs = negative(probs, s);
+    auto top = argpartition(neg_probs, k - 1, -1, s);
+    auto stop = top.shape();
+    stop.back() = k;
+    top = slice(top, Shape(top.ndim(), 0), stop, s);
+    // Order the k experts from the most likely one.
+    auto order = argsort(take_along_axis(neg_probs, top, -1, s), -1, s);
+    auto indices = take_along_axis(top, order, -1, s);
+    auto weights = take_along_axis(probs, indices, -1, s);
+    if (normalize) {
+      weights = divide(weights, sum(weights, -1, true, s), s);
+    }
+    // The sorts are stable so the pairs of each expert keep their order.
+    auto flat = flatten(indices, s);
+    auto counts = scatter_add_axis(
+        zeros({num_experts}, uint32, s), flat, ones_like(flat, s), 0, s);
+    return std::vector<array>{
+        indices, astype(weights, out_type, s), counts, argsort(flat, s)};
+  };
+
+  std::vector<array> outputs;
+  if (MoERoute::use_fallback(num_experts, k, s)) {
+    outputs = fallback({logits});
+  } else {
+    auto top_shape = logits.shape();
+    top_shape.back() = k;
+    int num_pairs = (logits.size() / num_experts) * k;
+    outputs = array::make_arrays(
+        {top_shape, top_shape, {num_experts}, {num_pairs}},
+        {uint32, out_type, uint32, uint32},
+        std::make_shared<MoERoute>(s, fallback, k, normalize),
+        {logits});
+  }
+  return {outputs[0], outputs[1], outputs[2], outputs[3]};
+}
+
+std::pair<array, array> moments(
+    const array& x,
+    const std::vector<int>& axes_,
+    bool keepdims /* = false */,
+    int ddof /* = 0 */,
+    StreamOrDevice s_ /* = {} */) {
+  int ndim = x.ndim();
+  std::vector<int> axes;
+  for (int ax : axes_) {
+    int a = ax < 0 ? ax + ndim : ax;
+    if (a < 0 || a >= ndim) {
+      std::ostringstream msg;
+      msg << "[moments] Invalid axis " << ax << " for array with " << ndim
+          << " dimensions.";
+      throw std::invalid_argument(msg.str());
+    }
+    axes.push_back(a);
+  }
+  std::sort(axes.begin(), axes.end());
+  if (std::adjacent_find(axes.begin(), axes.end()) != axes.end()) {
+    throw std::invalid_argument("[moments] Received duplicate axes.");
+  }
+
+  auto s = to_stream(s_);
+  auto in = x;
+  if (!issubdtype(in.dtype(), floating)) {
+    in = astype(in, float32, s);
+  }
+
+  // The shape of the outputs with the reduced axes kept.
+  auto out_shape = in.shape();
+  for (int a : axes) {
+    out_shape[a] = 1;
+  }
+  auto finalize = [&](array mean, array var) {
+    mean = reshape(mean, out_shape, s);
+    var = reshape(var, out_shape, s);
+    if (keepdims) {
+      return std::make_pair(mean, var);
+    }
+    return std::make_pair(squeeze(mean, axes, s), squeeze(var, axes, s));
+  };
+  if (axes.empty() || in.size() == 0) {
+    return finalize(mean(in, axes, true, s), var(in, axes, true, ddof, s));
+  }
+
+  // Bring the reduced axes together in the middle of [B, R, C], in place
+  // when they are already contiguous and at the end otherwise.
+  int first = axes.front();
+  int last = axes.back();
+  if (last - first + 1 != static_cast<int>(axes.size())) {
+    std::vector<int> perm;
+    for (int i = 0; i < ndim; i++) {
+      if (!std::binary_search(axes.begin(), axes.end(), i)) {
+        perm.push_back(i);
+      }
+    }
+    first = perm.size();
+    last = ndim - 1;
+    perm.insert(perm.end(), axes.begin(), axes.end());
+    in = transpose(in, perm, s);
+  }
+  int B = 1;
+  int R = 1;
+  int C = 1;
+  for (int i = 0; i < ndim; i++) {
+    if (i < first) {
+      B *= in.shape(i);
+    } else if (i <= last) {
+      R *= in.shape(i);
+    } else {
+      C *= in.shape(i);
+    }
+  }
+  in = reshape(in, {B, R, C}, s);
+
+  auto fallback = [ddof, s](const std::vector<array>& inputs) {
+    return std::vector<array>{
+        mean(inputs[0], 1, false, s), var(inputs[0], 1, false, ddof, s)};
+  };
+  std::vector<array> outputs;
+  if (Moments::use_fallback(s)) {
+    outputs = fallback({in});
+  } else {
+    outputs = array::make_arrays(
+        {{B, C}, {B, C}},
+        {in.dtype(), in.dtype()},
+        std::make_shared<Moments>(s, fallback, ddof),
+        {in});
+  }
+  return finalize(outputs[0], outputs[1]);
+}
+
+std::pair<array, array> moments(
+    const array& x,
+    bool keepdims /* = false */,
+    int ddof /* = 0 */,
+    StreamOrDevice s /* = {} */) {
+  std::vector<int> axes(x.ndim());
+  std::iota(axes.begin(), axes.end(), 0);
+  return moments(x, axes, keepdims, ddof, s);
+}
+
+namespace {
+
+std::pair<array, array> arg_reduce_with_value(
+    const array& a,
+    int axis,
+    bool keepdims,
+    ArgReduce::ReduceType reduce_type,
+    const char* tag,
+    StreamOrDevice s_) {
+  if (a.size() == 0) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Cannot reduce zero size array.";
+    throw std::invalid_argument(msg.str());
+  }
+  int ndim = a.ndim();
+  if (axis < -ndim || axis >= ndim) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Invalid axis " << axis << " for array with "
+        << ndim << " dimensions.";
+    throw std::invalid_argument(msg.str());
+  }
+  axis = axis < 0 ? axis + ndim : axis;
+
+  auto s = to_stream(s_);
+  // The outputs keep the reduced axis so they match the outputs of the
+  // primitive for the transformations.
+  auto fallback = [axis, reduce_type, s](const std::vector<array>& inputs) {
+    auto& x = inputs[0];
+    if (reduce_type == ArgReduce::ArgMin) {
+      return std::vector<array>{
+          min(x, axis, true, s), argmin(x, axis, true, s)};
+    }
+    return std::vector<array>{max(x, axis, true, s), argmax(x, axis, true, s)};
+  };
+
+  std::vector<array> outputs;
+  if (ArgReduceWithValue::use_fallback(s) ||
+      issubdtype(a.dtype(), complexfloating)) {
+    outputs = fallback({a});
+  } else {
+    auto out_shape = a.shape();
+    out_shape[axis] = 1;
+    outputs = array::make_arrays(
+        {out_shape, out_shape},
+        {a.dtype(), uint32},
+        std::make_shared<ArgReduceWithValue>(s, fallback, reduce_type, axis),
+        {a});
+  }
+  if (!keepdims) {
+    outputs[0] = squeeze(outputs[0], axis, s);
+    outputs[1] = squeeze(outputs[1], axis, s);
+  }
+  return {outputs[0], outputs[1]};
+}
+
+} // namespace
+
+std::pair<array, array> max_with_index(
+    const array& a,
+    int axis /* = -1 */,
+    bool keepdims /* = false */,
+    StreamOrDevice s /* = {} */) {
+  return arg_reduce_with_value(
+      a, axis, keepdims, ArgReduce::ArgMax, "max_with_index", s);
+}
+
+std::pair<array, array> min_with_index(
+    const array& a,
+    int axis /* = -1 */,
+    bool keepdims /* = false */,
+    StreamOrDevice s /* = {} */) {
+  return arg_reduce_with_value(
+      a, axis, keepdims, ArgReduce::ArgMin, "min_with_index", s);
+}
+
+array lora_matmul(
+    const array& x,
+    const array& w,
+    const array& a,
+    const array& b,
+    const array& indices,
+    float scale /* = 1.0f */,
+    bool sorted_indices /* = false */,
+    StreamOrDevice s_ /* = {} */) {
+  if (x.ndim() == 0 || w.ndim() != 2 || a.ndim() != 3 || b.ndim() != 3) {
+    std::ostringstream msg;
+    msg << "[lora_matmul] Expected x with at least 1 dimension, a 2D w and "
+        << "3D a and b but got x with shape " << x.shape() << ", w with "
+        << "shape " << w.shape() << ", a with shape " << a.shape()
+        << " and b with shape " << b.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  int K = x.shape(-1);
+  int N = w.shape(1);
+  if (w.shape(0) != K || a.shape(1) != K || b.shape(2) != N ||
+      a.shape(0) != b.shape(0) || a.shape(2) != b.shape(1)) {
+    std::ostringstream msg;
+    msg << "[lora_matmul] Incompatible shapes x " << x.shape() << ", w "
+        << w.shape() << ", a " << a.shape() << " and b " << b.shape()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto out_shape = x.shape();
+  out_shape.back() = N;
+  Shape batch_shape(x.shape().begin(), x.shape().end() - 1);
+  if (indices.shape() != batch_shape) {
+    std::ostringstream msg;
+    msg << "[lora_matmul] Expected indices with shape " << batch_shape
+        << " but got " << indices.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  // Each row is a 1 x K matrix multiplied by the matrices of its adapter.
+  auto s = to_stream(s_);
+  int T = x.size() / K;
+  auto rows = reshape(x, {T, 1, K}, s);
+  auto idx = flatten(indices, s);
+  auto update = gather_mm(rows, a, std::nullopt, idx, sorted_indices, s);
+  update = gather_mm(update, b, std::nullopt, idx, sorted_indices, s);
+  auto out = addmm(
+      reshape(update, {T, N}, s), reshape(rows, {T, K}, s), w, 1.0f, scale, s);
+  return reshape(out, std::move(out_shape), s);
+}
+
+array stochastic_round(
+    const array& x,
+    const std::optional<array>& key_ /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[stochastic_round] Received unsupported type " << x.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto key = key_ ? *key_ : random::KeySequence::default_().next();
+  if (key.dtype() != uint32 || key.shape() != Shape{2}) {
+    std::ostringstream msg;
+    msg << "[stochastic_round] Expected a uint32 key of shape (2) but "
+        << "received " << key.dtype() << " " << key.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto s = to_stream(s_);
+  if (x.dtype() == bfloat16) {
+    return x;
+  }
+
+  // Adding 16 random bits below the bits of the bfloat16 and truncating
+  // rounds the magnitude up with the probability of the truncated fraction.
+  auto fallback = [s](const std::vector<array>& inputs) {
+    auto x = astype(inputs[0], float32, s);
+    auto bits = random::bits(x.shape(), 4, inputs[1], s);
+    auto rounded = add(
+        view(x, uint32, s),
+        bitwise_and(bits, array(0xFFFF, uint32), s),
+        s);
+    rounded = astype(right_shift(rounded, array(16, uint32), s), uint16, s);
+    return std::vector<array>{where(
+        isnan(x, s), astype(x, bfloat16, s), view(rounded, bfloat16, s), s)};
+  };
+  if (StochasticRound::use_fallback(s)) {
+    return fallback({x, key})[0];
+  }
+  return array(
+      x.shape(),
+      bfloat16,
+      std::make_shared<StochasticRound>(s, fallback),
+      {x, key});
+}
+
+namespace {
+
+// The update of one parameter, its gradient and states by the Python
+// optimizers, with the scalars cast to the type of the parameter.
+std::vector<array> optimizer_update(
+    OptimizerStep::Kind kind,
+    const OptimizerStep::Params& hp,
+    const array& scalars,
+    const array& param,
+    const array& grad,
+    const std::vector<array>& states,
+    Stream s) {
+  auto dtype = param.dtype();
+  auto lr = astype(take(scalars, 0, s), dtype, s);
+  auto scale = [&](float x, const array& a) {
+    return multiply(array(x, dtype), a, s);
+  };
+  auto decay = [&](const array& p) {
+    if (hp.weight_decay == 0) {
+      return p;
+    }
+    auto factor = subtract(array(1, dtype), scale(hp.weight_decay, lr), s);
+    return multiply(factor, p, s);
+  };
+  switch (kind) {
+    case OptimizerStep::SGD: {
+      auto g = hp.weight_decay != 0
+          ? add(grad, scale(hp.weight_decay, param), s)
+          : grad;
+      if (states.empty()) {
+        return {subtract(param, multiply(lr, g, s), s)};
+      }
+      auto v = add(scale(hp.beta1, states[0]), scale(1 - hp.dampening, g), s);
+      auto update = hp.nesterov ? add(g, scale(hp.beta1, v), s) : v;
+      return {subtract(param, multiply(lr, update, s), s), v};
+    }
+    case OptimizerStep::AdamW: {
+      auto c1 = astype(take(scalars, 1, s), dtype, s);
+      auto c2 = astype(take(scalars, 2, s), dtype, s);
+      auto m = add(scale(hp.beta1, states[0]), scale(1 - hp.beta1, grad), s);
+      auto v = add(
+          scale(hp.beta2, states[1]),
+          scale(1 - hp.beta2, square(grad, s)),
+          s);
+      auto denominator =
+          add(multiply(sqrt(v, s), c2, s), array(hp.eps, dtype), s);
+      auto p = subtract(
+          decay(param), divide(multiply(c1, m, s), denominator, s), s);
+      return {p, m, v};
+    }
+    case OptimizerStep::Lion: {
+      auto c = add(scale(hp.beta1, states[0]), scale(1 - hp.beta1, grad), s);
+      auto m = add(scale(hp.beta2, states[0]), scale(1 - hp.beta2, grad), s);
+      auto p = subtract(decay(param), multiply(lr, sign(c, s), s), s);
+      return {p, m};
+    }
+  }
+  return {};
+}
+
+// Update the parameters with one primitive for each type of them. The
+// states are the lists of the states of each parameter.
+std::vector<std::vector<array>> optimizer_step(
+    const char* tag,
+    OptimizerStep::Kind kind,
+    const OptimizerStep::Params& hp,
+    const array& scalars,
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<std::vector<array>>& states,
+    const std::optional<array>& key,
+    Stream s) {
+  int n = params.size();
+  int k = states.size();
+  if (key && (key->dtype() != uint32 || key->shape() != Shape{2})) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Expected a uint32 key of shape (2) but "
+        << "received " << key->dtype() << " " << key->shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (grads.size() != n) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Received " << n << " parameters but "
+        << grads.size() << " gradients.";
+    throw std::invalid_argument(msg.str());
+  }
+  for (auto& state : states) {
+    if (state.size() != n) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] Received " << n << " parameters but "
+          << state.size() << " states.";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+  for (int i = 0; i < n; i++) {
+    if (!issubdtype(params[i].dtype(), floating)) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] Received unsupported parameter type "
+          << params[i].dtype() << ".";
+      throw std::invalid_argument(msg.str());
+    }
+    bool same_shape = grads[i].shape() == params[i].shape();
+    for (auto& state : states) {
+      same_shape &= state[i].shape() == params[i].shape();
+    }
+    if (!same_shape) {
+      std::ostringstream msg;
+      msg << "[" << tag << "] The gradient and the states of the parameter "
+          << "of shape " << params[i].shape() << " have different shapes.";
+      throw std::invalid_argument(msg.str());
+    }
+  }
+
+  // Group the parameters by type, the inputs of each group are the scalars,
+  // the parameters, the gradients and the states.
+  std::vector<std::vector<array>> outputs(k + 1);
+  for (auto& out : outputs) {
+    out.reserve(n);
+  }
+  std::vector<std::pair<Dtype, std::vector<int>>> groups;
+  for (int i = 0; i < n; i++) {
+    auto dtype = params[i].dtype();
+    auto it = std::find_if(groups.begin(), groups.end(), [dtype](auto& g) {
+      return g.first == dtype;
+    });
+    if (it == groups.end()) {
+      groups.push_back({dtype, {}});
+      it = groups.end() - 1;
+    }
+    it->second.push_back(i);
+  }
+
+  std::vector<std::optional<array>> results(n * (k + 1));
+  for (auto& [dtype, indices] : groups) {
+    int m = indices.size();
+    auto group_hp = hp;
+    group_hp.stochastic_rounding = key && dtype == bfloat16;
+    std::vector<array> inputs{scalars};
+    for (int i : indices) {
+      inputs.push_back(params[i]);
+    }
+    for (int i : indices) {
+      inputs.push_back(astype(grads[i], dtype, s));
+    }
+    for (auto& state : states) {
+      for (int i : indices) {
+        inputs.push_back(astype(state[i], dtype, s));
+      }
+    }
+
+    if (group_hp.stochastic_rounding) {
+      inputs.push_back(random::split(*key, m, s));
+    }
+
+    auto fallback = [kind, hp = group_hp, m, k, s](
+                        const std::vector<array>& inputs) {
+      // The stochastic rounding updates in float32 and then rounds.
+      auto cast = [&](const array& x) {
+        return hp.stochastic_rounding ? astype(x, float32, s) : x;
+      };
+      std::vector<std::vector<array>> updated;
+      for (int i = 0; i < m; i++) {
+        std::vector<array> states;
+        for (int j = 0; j < k; j++) {
+          states.push_back(cast(inputs[1 + (j + 2) * m + i]));
+        }
+        updated.push_back(optimizer_update(
+            kind,
+            hp,
+            inputs[0],
+            cast(inputs[1 + i]),
+            cast(inputs[1 + m + i]),
+            states,
+            s));
+        if (hp.stochastic_rounding) {
+          auto& u = updated.back();
+          u[0] = stochastic_round(u[0], take(inputs.back(), i, 0, s), s);
+          for (int j = 1; j <= k; j++) {
+            u[j] = astype(u[j], bfloat16, s);
+          }
+        }
+      }
+      std::vector<array> outputs;
+      for (int j = 0; j <= k; j++) {
+        for (int i = 0; i < m; i++) {
+          outputs.push_back(std::move(updated[i][j]));
+        }
+      }
+      return outputs;
+    };
+
+    std::vector<array> group_outputs;
+    if (OptimizerStep::use_fallback(s)) {
+      group_outputs = fallback(inputs);
+    } else {
+      std::vector<Shape> shapes;
+      for (int j = 0; j <= k; j++) {
+        for (int i : indices) {
+          shapes.push_back(params[i].shape());
+        }
+      }
+      std::vector<Dtype> dtypes(shapes.size(), dtype);
+      group_outputs = array::make_arrays(
+          std::move(shapes),
+          std::move(dtypes),
+          std::make_shared<OptimizerStep>(s, fallback, kind, group_hp, m),
+          std::move(inputs));
+    }
+    for (int j = 0; j <= k; j++) {
+      for (int i = 0; i < m; i++) {
+        results[j * n + indices[i]] = group_outputs[j * m + i];
+      }
+    }
+  }
+  for (int j = 0; j <= k; j++) {
+    for (int i = 0; i < n; i++) {
+      outputs[j].push_back(std::move(*results[j * n + i]));
+    }
+  }
+  return outputs;
+}
+
+} // namespace
+
+std::vector<std::vector<array>> sgd_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& momenta,
+    const array& learning_rate,
+    float momentum /* = 0.0f */,
+    float weight_decay /* = 0.0f */,
+    float dampening /* = 0.0f */,
+    bool nesterov /* = false */,
+    const std::optional<array>& key /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  auto s = to_stream(s_);
+  auto scalars = reshape(astype(learning_rate, float32, s), {1}, s);
+  std::vector<std::vector<array>> states;
+  if (momentum > 0) {
+    states.push_back(momenta);
+  }
+  return optimizer_step(
+      "sgd_step",
+      OptimizerStep::SGD,
+      {momentum, 0.0f, 0.0f, weight_decay, dampening, nesterov, false},
+      scalars,
+      params,
+      grads,
+      states,
+      key,
+      s);
+}
+
+std::vector<std::vector<array>> adamw_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& m,
+    const std::vector<array>& v,
+    const array& learning_rate,
+    float beta1 /* = 0.9f */,
+    float beta2 /* = 0.999f */,
+    float eps /* = 1e-8f */,
+    float weight_decay /* = 0.01f */,
+    const std::optional<array>& step /* = std::nullopt */,
+    const std::optional<array>& key /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  // Without the bias correction the scalars are lr, lr and 1
+  auto s = to_stream(s_);
+  auto lr = astype(learning_rate, float32, s);
+  auto c1 = lr;
+  auto c2 = array(1.0f);
+  if (step) {
+    auto t = astype(*step, float32, s);
+    auto one = array(1.0f);
+    c1 = divide(lr, subtract(one, power(array(beta1), t, s), s), s);
+    c2 = rsqrt(subtract(one, power(array(beta2), t, s), s), s);
+  }
+  auto scalars = stack({reshape(lr, {}, s), reshape(c1, {}, s), c2}, s);
+  return optimizer_step(
+      "adamw_step",
+      OptimizerStep::AdamW,
+      {beta1, beta2, eps, weight_decay, 0.0f, false, false},
+      scalars,
+      params,
+      grads,
+      {m, v},
+      key,
+      s);
+}
+
+std::vector<std::vector<array>> lion_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& m,
+    const array& learning_rate,
+    float beta1 /* = 0.9f */,
+    float beta2 /* = 0.99f */,
+    float weight_decay /* = 0.0f */,
+    const std::optional<array>& key /* = std::nullopt */,
+    StreamOrDevice s_ /* = {} */) {
+  auto s = to_stream(s_);
+  auto scalars = reshape(astype(learning_rate, float32, s), {1}, s);
+  return optimizer_step(
+      "lion_step",
+      OptimizerStep::Lion,
+      {beta1, beta2, 0.0f, weight_decay, 0.0f, false, false},
+      scalars,
+      params,
+      grads,
+      {m},
+      key,
+      s);
+}
+
+std::vector<Shape> OptimizerStep::output_shapes(
+    const std::vector<array>& inputs) {
+  // The states have the shapes of the parameters
+  int num_outputs =
+      inputs.size() - 1 - num_params_ - params_.stochastic_rounding;
+  std::vector<Shape> shapes;
+  for (int i = 0; i < num_outputs; i++) {
+    shapes.push_back(inputs[1 + i % num_params_].shape());
+  }
+  return shapes;
+}
+
+bool AffineQuantize::is_equivalent(const Primitive& other) const {
+  const AffineQuantize& p_other = static_cast<const AffineQuantize&>(other);
+  return (
+      p_other.group_size_ == group_size_ && p_other.bits_ == bits_ &&
+      p_other.dequantize_ == dequantize_);
+}
+
+bool BlockScaledQuantize::is_equivalent(const Primitive& other) const {
+  const BlockScaledQuantize& p_other =
+      static_cast<const BlockScaledQuantize&>(other);
+  return p_other.mode_ == mode_ && p_other.dequantize_ == dequantize_;
 }
 
 std::vector<Shape> AffineQuantize::output_shapes(
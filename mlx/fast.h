@@ -3,6 +3,7 @@
 #pragma once
 
 #include <optional>
+#include <unordered_map>
 #include <variant>
 
 #include "mlx/utils.h"
@@ -22,6 +23,23 @@ array layer_norm(
     float eps,
     StreamOrDevice s = {});
 
+/** Computes: h = x + residual and returns (h, rms_norm(h)) **/
+std::pair<array, array> add_rms_norm(
+    const array& x,
+    const array& residual,
+    const std::optional<array>& weight,
+    float eps,
+    StreamOrDevice s = {});
+
+/** Computes: h = x + residual and returns (h, layer_norm(h)) **/
+std::pair<array, array> add_layer_norm(
+    const array& x,
+    const array& residual,
+    const std::optional<array>& weight,
+    const std::optional<array>& bias,
+    float eps,
+    StreamOrDevice s = {});
+
 array rope(
     const array& x,
     int dims,
@@ -42,7 +60,53 @@ array rope(
     const std::optional<array>& freqs = std::nullopt,
     StreamOrDevice s = {});
 
-/** Computes: O = softmax(Q @ K.T) @ V **/
+/** Applies rope to the tokens of shape (total_tokens, n_heads, head_dim) of
+ * sequences packed one after the other, the sequence b holding the tokens
+ * [cu_seqlens[b], cu_seqlens[b + 1]). A token is rotated by its position in
+ * its sequence. **/
+array rope_varlen(
+    const array& x,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    const array& cu_seqlens,
+    const std::optional<array>& freqs = std::nullopt,
+    StreamOrDevice s = {});
+
+/** Splits the fused projection |qkv| of shape
+ * (B, L, (n_heads + 2 * n_kv_heads) * head_dim) into the queries, keys and
+ * values, applies rope to the queries and the keys at the positions
+ * offset + [0, L), and writes the keys and values to the caches of shape
+ * (B, n_kv_heads, S, head_dim) at the position offset.
+ *
+ * Returns the queries of shape (B, n_heads, L, head_dim) and the updated
+ * key and value caches. **/
+std::tuple<array, array, array> rope_qkv(
+    const array& qkv,
+    const array& k_cache,
+    const array& v_cache,
+    int n_heads,
+    int n_kv_heads,
+    int dims,
+    bool traditional,
+    std::optional<float> base,
+    float scale,
+    int offset,
+    const std::optional<array>& freqs = std::nullopt,
+    StreamOrDevice s = {});
+
+/** Computes: O = softmax(Q @ K.T) @ V
+ *
+ * With a |window_size| the query at position p only attends to the keys
+ * (p - window_size, p] with mask_mode "causal", or to the keys of its chunk
+ * of window_size positions up to p with mask_mode "chunked", and always to
+ * the first |num_sinks| keys.
+ *
+ * With mask_mode "tree" the queries are the last keys, like the draft tokens
+ * verified by speculative decoding, and the mask of mask_arrs broadcasts to
+ * [B, n_heads, L_q, L_q]: the queries see all the keys before them and the
+ * queries the mask allows, like their ancestors in the tree of drafts. **/
 array scaled_dot_product_attention(
     const array& queries,
     const array& keys,
@@ -50,8 +114,158 @@ array scaled_dot_product_attention(
     const float scale,
     const std::string& mask_mode = "",
     const std::vector<array>& mask_arrs = {},
+    int window_size = 0,
+    int num_sinks = 0,
+    StreamOrDevice s = {});
+
+/** Computes: O = softmax(Q @ K.T) @ V for sequences of different lengths
+ * packed one after the other in queries of shape
+ * (total_q, n_heads, head_dim) and keys and values of shape
+ * (total_k, n_kv_heads, head_dim). The queries [cu_seqlens_q[b],
+ * cu_seqlens_q[b + 1]) of the sequence b attend to its keys
+ * [cu_seqlens_k[b], cu_seqlens_k[b + 1]). With causal the queries are the
+ * last positions of their sequence. **/
+array varlen_attention(
+    const array& queries,
+    const array& keys,
+    const array& values,
+    const array& cu_seqlens_q,
+    const array& cu_seqlens_k,
+    const float scale,
+    bool causal = false,
     StreamOrDevice s = {});
 
+/** Computes: O = softmax(Q @ K.T) @ V where the keys and values are given
+ * quantized by affine_quantize with |group_size| and |bits|, and are only
+ * dequantized as they are read by the attention. **/
+array quantized_scaled_dot_product_attention(
+    const array& queries,
+    const array& keys,
+    const array& k_scales,
+    const array& k_biases,
+    const array& values,
+    const array& v_scales,
+    const array& v_biases,
+    const float scale,
+    const std::string& mask_mode = "",
+    const std::vector<array>& mask_arrs = {},
+    int group_size = 64,
+    int bits = 8,
+    StreamOrDevice s = {});
+
+/** Quantizes |x| of shape (B, n_kv_heads, L, head_dim) like affine_quantize
+ * and writes it to the quantized cache of shape
+ * (B, n_kv_heads, S, head_dim * bits / 32) and its scales and biases at the
+ * position offset.
+ *
+ * Returns the updated cache, scales and biases. **/
+std::tuple<array, array, array> quantized_kv_write(
+    const array& cache,
+    const array& scales,
+    const array& biases,
+    const array& x,
+    int offset,
+    int group_size = 64,
+    int bits = 8,
+    StreamOrDevice s = {});
+
+/** Writes the keys and values of shape (B, n_kv_heads, L, head_dim) to the
+ * page pools of shape (num_pages, n_kv_heads, page_size, head_dim) at the
+ * positions context_lens[b] + [0, L) of each sequence, where the position p
+ * of the sequence b is the slot p % page_size of the page
+ * block_table[b, p / page_size].
+ *
+ * Returns the updated key and value page pools. **/
+std::pair<array, array> paged_kv_write(
+    const array& k_pages,
+    const array& v_pages,
+    const array& keys,
+    const array& values,
+    const array& block_table,
+    const array& context_lens,
+    StreamOrDevice s = {});
+
+/** Computes the causal attention of the queries of shape
+ * (B, n_heads, L, head_dim) to the first context_lens[b] keys and values of
+ * each sequence, read from the page pools through the block table. The
+ * queries are the last L positions of their sequence. **/
+array paged_attention(
+    const array& queries,
+    const array& k_pages,
+    const array& v_pages,
+    const array& block_table,
+    const array& context_lens,
+    const float scale,
+    StreamOrDevice s = {});
+
+/** A key and value cache of fixed size pages shared by the sequences, a
+ * sequence only holds the pages its tokens use and returns them to the pool
+ * when freed. **/
+class PagedKVCache {
+ public:
+  PagedKVCache(
+      int num_pages,
+      int page_size,
+      int n_kv_heads,
+      int head_dim,
+      Dtype dtype = float16,
+      StreamOrDevice s = {});
+
+  /** Adds an empty sequence and returns its id. **/
+  int add_sequence();
+
+  /** Returns the pages of the sequence to the pool. **/
+  void free_sequence(int seq);
+
+  /** Appends the keys and values of shape (B, n_kv_heads, L, head_dim) to
+   * the B sequences |seqs|, taking new pages from the pool as needed. **/
+  void append(
+      const std::vector<int>& seqs,
+      const array& keys,
+      const array& values);
+
+  /** The attention of the queries of shape (B, n_heads, L, head_dim) to the
+   * sequences |seqs|, the queries being their last L positions. **/
+  array attention(
+      const std::vector<int>& seqs,
+      const array& queries,
+      const float scale);
+
+  /** The block table of shape (B, max_pages) and the lengths of shape (B,)
+   * of the sequences. **/
+  std::pair<array, array> block_table(const std::vector<int>& seqs) const;
+
+  const array& k_pages() const {
+    return k_pages_;
+  }
+  const array& v_pages() const {
+    return v_pages_;
+  }
+  int page_size() const {
+    return page_size_;
+  }
+  int num_free_pages() const {
+    return free_pages_.size();
+  }
+  int length(int seq) const;
+
+ private:
+  struct Sequence {
+    std::vector<int> pages;
+    int length{0};
+  };
+  Sequence& sequence(int seq);
+  const Sequence& sequence(int seq) const;
+
+  int page_size_;
+  Stream stream_;
+  array k_pages_;
+  array v_pages_;
+  std::vector<int> free_pages_;
+  std::unordered_map<int, Sequence> sequences_;
+  int next_seq_{0};
+};
+
 std::tuple<array, array, array> affine_quantize(
     const array& w,
     int group_size = 64,
@@ -66,6 +280,225 @@ array affine_dequantize(
     int bits = 4,
     StreamOrDevice s = {});
 
+/**
+ * Computes dequantize(w[indices], scales[indices], biases[indices]) for the
+ * rows |indices| of the affine quantized matrix w [V, D * bits / 32], like a
+ * quantized embedding lookup, without gathering the packed rows first.
+ * Returns an array of shape indices.shape + [D] with the dtype of scales.
+ **/
+array quantized_embedding(
+    const array& w,
+    const array& scales,
+    const array& biases,
+    const array& indices,
+    int group_size = 64,
+    int bits = 4,
+    StreamOrDevice s = {});
+
+/**
+ * Quantizes the groups of the last axis of w to the block scaled floating
+ * point format |mode|:
+ *
+ * - "mxfp4": e2m1 values in groups of 32 with an e8m0 scale.
+ * - "nvfp4": e2m1 values in groups of 16 with an e4m3 scale.
+ * - "mxfp8": e4m3 values in groups of 32 with an e8m0 scale.
+ *
+ * Returns the values packed in uint32 like affine_quantize and the scales
+ * as uint8.
+ **/
+std::pair<array, array> block_scaled_quantize(
+    const array& w,
+    const std::string& mode,
+    StreamOrDevice s = {});
+
+array block_scaled_dequantize(
+    const array& w,
+    const array& scales,
+    const std::string& mode,
+    Dtype dtype = bfloat16,
+    StreamOrDevice s = {});
+
+/**
+ * Computes x @ (w * scales).T where w holds float8 e4m3 values as uint8 with
+ * shape [N, K], and scales has 1 element (per-tensor) or N (per-channel).
+ **/
+array fp8_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    StreamOrDevice s = {});
+
+/**
+ * Computes x @ (w * scales).T where w holds int8 values with shape [N, K],
+ * and scales has 1 element (per-tensor) or N (per-channel). Each row of x is
+ * quantized to int8 with its own scale, so that the product runs on the
+ * integer tensor cores.
+ **/
+array int8_matmul(
+    const array& x,
+    const array& w,
+    const array& scales,
+    StreamOrDevice s = {});
+
+/**
+ * Computes silu(x1) * x2 where x1 and x2 are the two halves of the last axis
+ * of x, such as the concatenated gate and up projections of a LLaMA MLP.
+ **/
+array swiglu(const array& x, StreamOrDevice s = {});
+
+/** Computes gelu(x1) * x2 for the two halves x1 and x2 of the last axis of
+ * x, see swiglu. **/
+array geglu(const array& x, StreamOrDevice s = {});
+
+/** Computes: logsumexp(logits, -1) - take_along_axis(logits, targets, -1)
+ * without storing the intermediate softmax. The negative targets count from
+ * the last class, the targets must be in [-C, C) for C classes. **/
+array cross_entropy(
+    const array& logits,
+    const array& targets,
+    StreamOrDevice s = {});
+
+/** Samples an index from each row of softmax(logits / temperature) among the
+ * top_k largest logits (all of them if top_k is 0), further restricted to the
+ * smallest set of them with a probability of at least top_p. **/
+array sample_top_k_top_p(
+    const array& logits,
+    float temperature,
+    int top_k,
+    float top_p,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Routes the tokens of a mixture of experts with the router |logits| of
+ * shape [..., E]. Returns:
+ *
+ * - the uint32 indices [..., k] of the top k experts of each token, from
+ *   the most to the least likely,
+ * - their softmax probabilities [..., k], renormalized to add up to 1 when
+ *   |normalize| is true,
+ * - the uint32 number of (token, slot) pairs [E] routed to each expert,
+ * - the uint32 permutation [N * k], with N tokens, which stably sorts the
+ *   flattened indices by expert, so that the tokens perm / k are grouped by
+ *   expert for gather_mm with sorted indices.
+ **/
+std::tuple<array, array, array, array> moe_route(
+    const array& logits,
+    int k,
+    bool normalize = true,
+    StreamOrDevice s = {});
+
+/**
+ * Computes mean(x, axes) and var(x, axes, ddof) in a single pass over x with
+ * Welford's algorithm, such as for the statistics of a batch or group norm.
+ **/
+std::pair<array, array> moments(
+    const array& x,
+    const std::vector<int>& axes,
+    bool keepdims = false,
+    int ddof = 0,
+    StreamOrDevice s = {});
+
+/** Computes the moments over all the axes of x, see moments. **/
+std::pair<array, array> moments(
+    const array& x,
+    bool keepdims = false,
+    int ddof = 0,
+    StreamOrDevice s = {});
+
+/**
+ * Computes the maximum of |a| along |axis| and its index in a single pass,
+ * returns the values and the uint32 indices. The index of the first maximum
+ * is returned as in argmax.
+ **/
+std::pair<array, array> max_with_index(
+    const array& a,
+    int axis = -1,
+    bool keepdims = false,
+    StreamOrDevice s = {});
+
+/** Computes the minimum of |a| along |axis| and its index, see
+ * max_with_index. **/
+std::pair<array, array> min_with_index(
+    const array& a,
+    int axis = -1,
+    bool keepdims = false,
+    StreamOrDevice s = {});
+
+/**
+ * Computes x @ w + scale * (x @ a[i]) @ b[i] with the adapter i of each row
+ * of x given by |indices| of shape x.shape[:-1], for serving many LoRA
+ * adapters in one batch. The adapters a [L, K, r] and b [L, r, N] are
+ * applied with gather_mm and the low rank update is added by the epilogue
+ * of the base matmul. Pass |sorted_indices| when the rows are grouped by
+ * adapter.
+ **/
+array lora_matmul(
+    const array& x,
+    const array& w,
+    const array& a,
+    const array& b,
+    const array& indices,
+    float scale = 1.0f,
+    bool sorted_indices = false,
+    StreamOrDevice s = {});
+
+/** Casts x to bfloat16 rounding each value up or down at random, with the
+ * probability of its distance to the other one, so the rounding is unbiased.
+ * The random bits are the ones of random::bits(x.shape(), 4, key). **/
+array stochastic_round(
+    const array& x,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
+/** Applies the SGD update of the parameters in one pass for each type of
+ * them. Returns the new parameters and, with a momentum, the new momenta.
+ * With a key, the new bfloat16 parameters are rounded with
+ * stochastic_round. **/
+std::vector<std::vector<array>> sgd_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& momenta,
+    const array& learning_rate,
+    float momentum = 0.0f,
+    float weight_decay = 0.0f,
+    float dampening = 0.0f,
+    bool nesterov = false,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
+/** Applies the AdamW update of the parameters in one pass for each type of
+ * them, with the bias correction of the given step if any. Returns the new
+ * parameters, first moments and second moments. With a key, the new
+ * bfloat16 parameters are rounded with stochastic_round. **/
+std::vector<std::vector<array>> adamw_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& m,
+    const std::vector<array>& v,
+    const array& learning_rate,
+    float beta1 = 0.9f,
+    float beta2 = 0.999f,
+    float eps = 1e-8f,
+    float weight_decay = 0.01f,
+    const std::optional<array>& step = std::nullopt,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
+/** Applies the Lion update of the parameters in one pass for each type of
+ * them. Returns the new parameters and momenta. With a key, the new bfloat16
+ * parameters are rounded with stochastic_round. **/
+std::vector<std::vector<array>> lion_step(
+    const std::vector<array>& params,
+    const std::vector<array>& grads,
+    const std::vector<array>& m,
+    const array& learning_rate,
+    float beta1 = 0.9f,
+    float beta2 = 0.99f,
+    float weight_decay = 0.0f,
+    const std::optional<array>& key = std::nullopt,
+    StreamOrDevice s = {});
+
 typedef std::variant<int, bool, Dtype> TemplateArg;
 
 typedef std::function<std::vector<array>(
@@ -78,7 +511,9 @@ typedef std::function<std::vector<array>(
     std::optional<float>,
     bool,
     StreamOrDevice)>
-    MetalKernelFunction;
+    CustomKernelFunction;
+
+typedef CustomKernelFunction MetalKernelFunction;
 
 MetalKernelFunction metal_kernel(
     const std::string& name,
@@ -89,4 +524,17 @@ MetalKernelFunction metal_kernel(
     bool ensure_row_contiguous = true,
     bool atomic_outputs = false);
 
+/** A jit-compiled custom CUDA kernel, the source is the body of a
+ * __global__ function whose signature is generated from the inputs, outputs
+ * and template arguments. Each block has |shared_memory| bytes of dynamic
+ * shared memory. **/
+CustomKernelFunction cuda_kernel(
+    const std::string& name,
+    const std::vector<std::string>& input_names,
+    const std::vector<std::string>& output_names,
+    const std::string& source,
+    const std::string& header = "",
+    bool ensure_row_contiguous = true,
+    int shared_memory = 0);
+
 } // namespace mlx::core::fast
@@ -154,6 +154,60 @@ class LayerNormVJP : public Custom {
   float eps_;
 };
 
+class AddRMSNorm : public Custom {
+ public:
+  AddRMSNorm(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float eps)
+      : Custom(stream, fallback), eps_(eps) {}
+
+  static bool use_fallback(Stream stream);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(AddRMSNorm)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_pair(nullptr, eps_);
+  }
+
+ private:
+  float eps_;
+};
+
+class AddLayerNorm : public Custom {
+ public:
+  AddLayerNorm(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float eps)
+      : Custom(stream, fallback), eps_(eps) {}
+
+  static bool use_fallback(Stream stream);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(AddLayerNorm)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_pair(nullptr, eps_);
+  }
+
+ private:
+  float eps_;
+};
+
 class RoPE : public Custom {
  public:
   RoPE(
@@ -171,7 +225,8 @@ class RoPE : public Custom {
         scale_(scale),
         forward_(forward) {}
 
-  static bool use_fallback(Stream s);
+  // The offset is one scalar or one per position with |per_position|.
+  static bool use_fallback(Stream s, bool per_position = false);
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override {
@@ -202,14 +257,245 @@ class RoPE : public Custom {
   bool forward_;
 };
 
+class RoPEQKV : public Custom {
+ public:
+  RoPEQKV(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int n_heads,
+      int n_kv_heads,
+      int dims,
+      bool traditional,
+      float base,
+      float scale,
+      int offset)
+      : Custom(stream, fallback),
+        n_heads_(n_heads),
+        n_kv_heads_(n_kv_heads),
+        dims_(dims),
+        traditional_(traditional),
+        base_(base),
+        scale_(scale),
+        offset_(offset) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(RoPEQKV)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_tuple(
+        nullptr,
+        n_heads_,
+        n_kv_heads_,
+        dims_,
+        traditional_,
+        base_,
+        scale_,
+        offset_);
+  }
+
+ private:
+  int n_heads_;
+  int n_kv_heads_;
+  int dims_;
+  bool traditional_;
+  float base_;
+  float scale_;
+  int offset_;
+};
+
+class QuantizedScaledDotProductAttention : public Custom {
+ public:
+  QuantizedScaledDotProductAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float scale,
+      bool do_causal,
+      int group_size,
+      int bits)
+      : Custom(stream, fallback),
+        scale_(scale),
+        do_causal_(do_causal),
+        group_size_(group_size),
+        bits_(bits) {}
+
+  static bool use_fallback(
+      const array& q,
+      const array& k,
+      bool has_arr_mask,
+      bool do_causal,
+      int group_size,
+      int bits,
+      Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(QuantizedScaledDotProductAttention)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_tuple(nullptr, scale_, do_causal_, group_size_, bits_);
+  }
+
+ private:
+  float scale_;
+  bool do_causal_;
+  int group_size_;
+  int bits_;
+};
+
+class QuantizedKVWrite : public Custom {
+ public:
+  QuantizedKVWrite(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int offset,
+      int group_size,
+      int bits)
+      : Custom(stream, fallback),
+        offset_(offset),
+        group_size_(group_size),
+        bits_(bits) {}
+
+  static bool use_fallback(int group_size, int bits, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(QuantizedKVWrite)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_tuple(nullptr, offset_, group_size_, bits_);
+  }
+
+ private:
+  int offset_;
+  int group_size_;
+  int bits_;
+};
+
+class PagedKVWrite : public Custom {
+ public:
+  PagedKVWrite(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(PagedKVWrite)
+  std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+  auto state() const {
+    return nullptr;
+  }
+};
+
+class PagedAttention : public Custom {
+ public:
+  PagedAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float scale)
+      : Custom(stream, fallback), scale_(scale) {}
+
+  static bool use_fallback(const array& q, const array& k_pages, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(PagedAttention)
+  std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_tuple(nullptr, scale_);
+  }
+
+ private:
+  float scale_;
+};
+
+class VarlenAttention : public Custom {
+ public:
+  VarlenAttention(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float scale,
+      bool do_causal)
+      : Custom(stream, fallback), scale_(scale), do_causal_(do_causal) {}
+
+  static bool use_fallback(const array& q, const array& v, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(VarlenAttention)
+  auto state() const {
+    return std::make_tuple(nullptr, scale_, do_causal_);
+  }
+  bool is_equivalent(const Primitive& other) const override {
+    return state() == static_cast<const VarlenAttention&>(other).state();
+  }
+
+ private:
+  float scale_;
+  bool do_causal_;
+};
+
 class ScaledDotProductAttention : public Custom {
  public:
+  // A |window_size| limits the causal attention to a sliding window, or to
+  // the chunks of window_size positions with |chunked|, besides the first
+  // |num_sinks| keys. With |tree| the mask is the one of the queries between
+  // them, which are the last keys, and they all see the keys before.
   explicit ScaledDotProductAttention(
       Stream stream,
       std::function<std::vector<array>(std::vector<array>)> fallback,
       const float scale,
-      const bool do_causal)
-      : Custom(stream, fallback), scale_(scale), do_causal_(do_causal) {}
+      const bool do_causal,
+      int window_size = 0,
+      int num_sinks = 0,
+      bool chunked = false,
+      bool tree = false)
+      : Custom(stream, fallback),
+        scale_(scale),
+        do_causal_(do_causal),
+        window_size_(window_size),
+        num_sinks_(num_sinks),
+        chunked_(chunked),
+        tree_(tree) {}
 
   static bool use_fallback(
       const array& q,
@@ -218,6 +504,8 @@ class ScaledDotProductAttention : public Custom {
       bool has_mask,
       bool has_arr_mask,
       bool do_causal,
+      bool has_window,
+      bool has_tree,
       Stream s);
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
@@ -236,44 +524,665 @@ class ScaledDotProductAttention : public Custom {
   DEFINE_NAME(ScaledDotProductAttention);
   DEFINE_INPUT_OUTPUT_SHAPE()
   auto state() const {
-    return std::make_tuple(nullptr, scale_, do_causal_);
+    return std::make_tuple(
+        nullptr,
+        scale_,
+        do_causal_,
+        window_size_,
+        num_sinks_,
+        chunked_,
+        tree_);
   }
 
  private:
   float scale_;
   bool do_causal_;
+  int window_size_;
+  int num_sinks_;
+  bool chunked_;
+  bool tree_;
 };
 
-class AffineQuantize : public Custom {
+// The matmul of a and b followed by the optional addition of a bias vector
+// along the last axis and an activation, which mx.compile forms from the
+// matching graphs on the backends that can fuse them.
+class FusedMatmul : public Custom {
  public:
-  explicit AffineQuantize(
+  enum Activation { None, ReLU };
+
+  explicit FusedMatmul(
       Stream stream,
       std::function<std::vector<array>(std::vector<array>)> fallback,
-      int group_size,
-      int bits,
-      bool dequantize)
+      Activation activation,
+      MatmulPrecision precision = MatmulPrecision::Default)
       : Custom(stream, fallback),
-        group_size_(group_size),
-        bits_(bits),
-        dequantize_(dequantize) {}
+        activation_(activation),
+        precision_(precision) {}
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
-      override;
+      override {
+    throw std::runtime_error("NYI");
+  }
 
   void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
-      override;
-
-  DEFINE_NAME(AffineQuantize);
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
 
+  void eval_gpu(const std::vector<array>& inputs, array& out);
   bool is_equivalent(const Primitive& other) const override;
-  std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+
+  DEFINE_NAME(FusedMatmul);
   auto state() const {
-    return std::make_tuple(nullptr, group_size_, bits_, dequantize_);
+    return std::make_tuple(nullptr, activation_, precision_);
   }
 
  private:
-  int group_size_;
-  int bits_;
+  Activation activation_;
+  MatmulPrecision precision_;
+};
+
+class Fp8Matmul : public Custom {
+ public:
+  explicit Fp8Matmul(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  static bool use_fallback(const array& x, const array& w, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+
+  DEFINE_NAME(Fp8Matmul);
+  auto state() const {
+    return nullptr;
+  }
+};
+
+class Int8Matmul : public Custom {
+ public:
+  explicit Int8Matmul(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  static bool use_fallback(const array& x, const array& w, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    eval_gpu(inputs, outputs[0]);
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, array& out);
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+
+  DEFINE_NAME(Int8Matmul);
+  auto state() const {
+    return nullptr;
+  }
+};
+
+class CrossEntropy : public Custom {
+ public:
+  explicit CrossEntropy(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_NAME(CrossEntropy);
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+  auto state() const {
+    return nullptr;
+  }
+};
+
+class CrossEntropyVJP : public Custom {
+ public:
+  explicit CrossEntropyVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(CrossEntropyVJP);
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+  auto state() const {
+    return nullptr;
+  }
+};
+
+// Generate the random bits of a key and transform them to samples of a
+// distribution in one pass, the samples are the same as the ones of the
+// composite of random::bits and elementwise ops in the fallback.
+class RandomDistribution : public Custom {
+ public:
+  enum Kind { Uniform, Normal, Gumbel, Bernoulli };
+
+  explicit RandomDistribution(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      Kind kind,
+      float upper)
+      : Custom(stream, fallback), kind_(kind), upper_(upper) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(RandomDistribution);
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const RandomDistribution&>(other);
+    return kind_ == o.kind_ && upper_ == o.upper_;
+  }
+  auto state() const {
+    return std::make_tuple(nullptr, kind_, upper_);
+  }
+
+ private:
+  Kind kind_;
+  float upper_;
+};
+
+class SampleTopKTopP : public Custom {
+ public:
+  SampleTopKTopP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      float temperature,
+      int top_k,
+      float top_p)
+      : Custom(stream, fallback),
+        temperature_(temperature),
+        top_k_(top_k),
+        top_p_(top_p) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(SampleTopKTopP);
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const SampleTopKTopP&>(other);
+    return temperature_ == o.temperature_ && top_k_ == o.top_k_ &&
+        top_p_ == o.top_p_;
+  }
+  auto state() const {
+    return std::make_tuple(nullptr, temperature_, top_k_, top_p_);
+  }
+
+ private:
+  float temperature_;
+  int top_k_;
+  float top_p_;
+};
+
+// The mean and the variance over the middle axis of an array of shape
+// [B, R, C] computed in one pass with Welford's algorithm.
+class Moments : public Custom {
+ public:
+  Moments(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int ddof)
+      : Custom(stream, fallback), ddof_(ddof) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(Moments);
+  bool is_equivalent(const Primitive& other) const override {
+    return ddof_ == static_cast<const Moments&>(other).ddof_;
+  }
+  auto state() const {
+    return std::make_pair(nullptr, ddof_);
+  }
+
+ private:
+  int ddof_;
+};
+
+// The gradient of a convolution with respect to its input or its weight,
+// the inputs are the gradient of the output and the weight or the input.
+class ConvolutionVJP : public Custom {
+ public:
+  ConvolutionVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      bool weight_grad,
+      const std::vector<int>& kernel_strides,
+      const std::vector<int>& padding_lo,
+      const std::vector<int>& padding_hi,
+      const std::vector<int>& kernel_dilation,
+      const std::vector<int>& input_dilation,
+      int groups,
+      bool flip)
+      : Custom(stream, fallback),
+        weight_grad_(weight_grad),
+        kernel_strides_(kernel_strides),
+        padding_lo_(padding_lo),
+        padding_hi_(padding_hi),
+        kernel_dilation_(kernel_dilation),
+        input_dilation_(input_dilation),
+        groups_(groups),
+        flip_(flip) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(ConvolutionVJP);
+  auto state() const {
+    return std::make_tuple(
+        nullptr,
+        weight_grad_,
+        kernel_strides_,
+        padding_lo_,
+        padding_hi_,
+        kernel_dilation_,
+        input_dilation_,
+        groups_,
+        flip_);
+  }
+  bool is_equivalent(const Primitive& other) const override {
+    return state() == static_cast<const ConvolutionVJP&>(other).state();
+  }
+
+ private:
+  bool weight_grad_;
+  std::vector<int> kernel_strides_;
+  std::vector<int> padding_lo_;
+  std::vector<int> padding_hi_;
+  std::vector<int> kernel_dilation_;
+  std::vector<int> input_dilation_;
+  int groups_;
+  bool flip_;
+};
+
+// Route the tokens of a mixture of experts: the top k experts of the softmax
+// of the router logits, their weights, the number of tokens of each expert
+// and the permutation which sorts the (token, slot) pairs by expert.
+class MoERoute : public Custom {
+ public:
+  MoERoute(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int k,
+      bool normalize)
+      : Custom(stream, fallback), k_(k), normalize_(normalize) {}
+
+  static bool use_fallback(int num_experts, int k, Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(MoERoute);
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const MoERoute&>(other);
+    return k_ == o.k_ && normalize_ == o.normalize_;
+  }
+  auto state() const {
+    return std::make_tuple(nullptr, k_, normalize_);
+  }
+
+ private:
+  int k_;
+  bool normalize_;
+};
+
+// The min or the max of an array along an axis with its index, computed in
+// the same pass.
+class ArgReduceWithValue : public Custom {
+ public:
+  ArgReduceWithValue(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      ArgReduce::ReduceType reduce_type,
+      int axis)
+      : Custom(stream, fallback), reduce_type_(reduce_type), axis_(axis) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(ArgReduceWithValue);
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const ArgReduceWithValue&>(other);
+    return reduce_type_ == o.reduce_type_ && axis_ == o.axis_;
+  }
+  auto state() const {
+    return std::make_tuple(nullptr, reduce_type_, axis_);
+  }
+
+ private:
+  ArgReduce::ReduceType reduce_type_;
+  int axis_;
+};
+
+// Cast the input to bfloat16 with stochastic rounding, the inputs are the
+// values and the key of the random bits.
+class StochasticRound : public Custom {
+ public:
+  StochasticRound(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback)
+      : Custom(stream, fallback) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(StochasticRound);
+  bool is_equivalent(const Primitive& other) const override {
+    return true;
+  }
+  auto state() const {
+    return nullptr;
+  }
+};
+
+// Apply the update of an optimizer to many parameters in one pass. The
+// inputs are the scalars (the learning rate and the bias corrections), the
+// parameters, the gradients and the states, one list after the other, and the
+// outputs are the new parameters followed by the new states. The parameters
+// and their states share one floating point type. With stochastic rounding
+// the last input holds a key for each parameter and the new bfloat16
+// parameters are rounded like StochasticRound does.
+class OptimizerStep : public Custom {
+ public:
+  enum Kind { SGD, AdamW, Lion };
+
+  // The hyperparameters, the momentum of SGD is beta1.
+  struct Params {
+    float beta1;
+    float beta2;
+    float eps;
+    float weight_decay;
+    float dampening;
+    bool nesterov;
+    bool stochastic_rounding;
+  };
+
+  OptimizerStep(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      Kind kind,
+      Params params,
+      int num_params)
+      : Custom(stream, fallback),
+        kind_(kind),
+        params_(params),
+        num_params_(num_params) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(OptimizerStep);
+  std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const OptimizerStep&>(other);
+    return kind_ == o.kind_ && params_.beta1 == o.params_.beta1 &&
+        params_.beta2 == o.params_.beta2 && params_.eps == o.params_.eps &&
+        params_.weight_decay == o.params_.weight_decay &&
+        params_.dampening == o.params_.dampening &&
+        params_.nesterov == o.params_.nesterov &&
+        params_.stochastic_rounding == o.params_.stochastic_rounding &&
+        num_params_ == o.num_params_;
+  }
+  auto state() const {
+    return std::make_tuple(
+        nullptr,
+        kind_,
+        params_.beta1,
+        params_.beta2,
+        params_.eps,
+        params_.weight_decay,
+        params_.dampening,
+        params_.nesterov,
+        params_.stochastic_rounding,
+        num_params_);
+  }
+
+ private:
+  Kind kind_;
+  Params params_;
+  int num_params_;
+};
+
+// The gated activation act(x1) * x2 of the two halves x1 and x2 of the last
+// axis of x, the concatenated gate and up projections of a gated MLP.
+class GatedActivation : public Custom {
+ public:
+  enum Kind { SiLU, GELU };
+
+  GatedActivation(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      Kind kind)
+      : Custom(stream, fallback), kind_(kind) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  std::vector<array> vjp(
+      const std::vector<array>& primals,
+      const std::vector<array>& cotangents,
+      const std::vector<int>& argnums,
+      const std::vector<array>& outputs) override;
+
+  DEFINE_NAME(GatedActivation);
+  bool is_equivalent(const Primitive& other) const override {
+    return kind_ == static_cast<const GatedActivation&>(other).kind_;
+  }
+  auto state() const {
+    return std::make_pair(nullptr, kind_);
+  }
+
+ private:
+  Kind kind_;
+};
+
+// The gradient of the input of GatedActivation given the gradient of its
+// output, with the gradients of both halves written in one pass.
+class GatedActivationVJP : public Custom {
+ public:
+  GatedActivationVJP(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      GatedActivation::Kind kind)
+      : Custom(stream, fallback), kind_(kind) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(GatedActivationVJP);
+  bool is_equivalent(const Primitive& other) const override {
+    return kind_ == static_cast<const GatedActivationVJP&>(other).kind_;
+  }
+  auto state() const {
+    return std::make_pair(nullptr, kind_);
+  }
+
+ private:
+  GatedActivation::Kind kind_;
+};
+
+class AffineQuantize : public Custom {
+ public:
+  explicit AffineQuantize(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int group_size,
+      int bits,
+      bool dequantize)
+      : Custom(stream, fallback),
+        group_size_(group_size),
+        bits_(bits),
+        dequantize_(dequantize) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(AffineQuantize);
+
+  bool is_equivalent(const Primitive& other) const override;
+  std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+  auto state() const {
+    return std::make_tuple(nullptr, group_size_, bits_, dequantize_);
+  }
+
+ private:
+  int group_size_;
+  int bits_;
+  bool dequantize_;
+};
+
+// The rows |indices| of an affine quantized matrix dequantized, reading only
+// the selected rows of the packed weights, scales and biases.
+class QuantizedEmbedding : public Custom {
+ public:
+  QuantizedEmbedding(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      int group_size,
+      int bits)
+      : Custom(stream, fallback), group_size_(group_size), bits_(bits) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(QuantizedEmbedding);
+  bool is_equivalent(const Primitive& other) const override {
+    auto& o = static_cast<const QuantizedEmbedding&>(other);
+    return group_size_ == o.group_size_ && bits_ == o.bits_;
+  }
+  auto state() const {
+    return std::make_tuple(nullptr, group_size_, bits_);
+  }
+
+ private:
+  int group_size_;
+  int bits_;
+};
+
+class BlockScaledQuantize : public Custom {
+ public:
+  enum Mode { MXFP4, NVFP4, MXFP8 };
+
+  explicit BlockScaledQuantize(
+      Stream stream,
+      std::function<std::vector<array>(std::vector<array>)> fallback,
+      Mode mode,
+      bool dequantize)
+      : Custom(stream, fallback), mode_(mode), dequantize_(dequantize) {}
+
+  static bool use_fallback(Stream s);
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override {
+    throw std::runtime_error("NYI");
+  }
+
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(BlockScaledQuantize);
+
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_tuple(nullptr, mode_, dequantize_);
+  }
+
+ private:
+  Mode mode_;
   bool dequantize_;
 };
 
@@ -293,7 +1202,8 @@ class CustomKernel : public Primitive {
       std::tuple<int, int, int> threadgroup,
       std::vector<CustomKernelShapeInfo> shape_infos,
       bool ensure_row_contiguous,
-      std::optional<float> init_value)
+      std::optional<float> init_value,
+      int shared_memory = 0)
       : Primitive(stream),
         source_(std::move(source)),
         name_(std::move(name)),
@@ -301,11 +1211,12 @@ class CustomKernel : public Primitive {
         threadgroup_(threadgroup),
         shape_infos_(std::move(shape_infos)),
         ensure_row_contiguous_(ensure_row_contiguous),
-        init_value_(init_value) {}
+        init_value_(init_value),
+        shared_memory_(shared_memory) {}
 
   void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
       override {
-    throw std::runtime_error("Custom Metal kernels only run on GPU.");
+    throw std::runtime_error("Custom kernels only run on GPU.");
   }
 
   void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
@@ -321,6 +1232,7 @@ class CustomKernel : public Primitive {
   std::vector<CustomKernelShapeInfo> shape_infos_;
   bool ensure_row_contiguous_;
   std::optional<float> init_value_;
+  int shared_memory_;
 };
 
 } // namespace mlx::core::fast
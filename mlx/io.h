@@ -2,6 +2,8 @@
 
 #pragma once
 
+#include <future>
+#include <optional>
 #include <unordered_map>
 #include <variant>
 
@@ -36,9 +38,30 @@ array load(std::string file, StreamOrDevice s = {});
 SafetensorsLoad load_safetensors(
     std::shared_ptr<io::Reader> in_stream,
     StreamOrDevice s = {});
+
+/**
+ * Load array map from .safetensors file format. With |mmap| the file is
+ * mapped in memory and the arrays loaded on the CPU wrap its pages without
+ * copying them when aligned.
+ */
 SafetensorsLoad load_safetensors(
     const std::string& file,
-    StreamOrDevice s = {});
+    StreamOrDevice s = {},
+    bool mmap = false);
+
+/**
+ * Load the arrays of the shards of a checkpoint in .safetensors format.
+ * The headers are parsed in parallel, and the arrays are read from the
+ * shards in turn and evaluated in groups of at most |max_bytes_in_flight|
+ * bytes of the files. The floating point arrays are cast to |dtype| when
+ * given, the float8 ones included, in the stream of the loads.
+ */
+SafetensorsLoad load_sharded(
+    const std::vector<std::string>& files,
+    std::optional<Dtype> dtype = std::nullopt,
+    size_t max_bytes_in_flight = 1 << 30,
+    StreamOrDevice s = {},
+    bool mmap = false);
 
 void save_safetensors(
     std::shared_ptr<io::Writer> in_stream,
@@ -49,6 +72,16 @@ void save_safetensors(
     std::unordered_map<std::string, array>,
     std::unordered_map<std::string, std::string> metadata = {});
 
+/**
+ * Save the arrays to a file in .safetensors format in the background. It
+ * returns once the arrays are scheduled, they are held until written with
+ * parallel pwrites, and the future is ready once the file is complete.
+ */
+std::shared_future<void> save_safetensors_async(
+    std::string file,
+    std::unordered_map<std::string, array>,
+    std::unordered_map<std::string, std::string> metadata = {});
+
 /** Load array map and metadata from .gguf file format */
 
 GGUFLoad load_gguf(const std::string& file, StreamOrDevice s = {});
@@ -2,10 +2,14 @@
 
 #include <cstdint>
 #include <cstring>
+#include <exception>
 #include <fstream>
+#include <future>
 #include <numeric>
 
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/io/gguf.h"
+#include "mlx/io/load.h"
 #include "mlx/ops.h"
 
 namespace mlx::core {
@@ -204,9 +208,17 @@ std::unordered_map<std::string, GGUFMetaData> load_metadata(gguf_ctx* ctx) {
   return metadata;
 }
 
-std::unordered_map<std::string, array> load_arrays(gguf_ctx* ctx) {
+bool is_quantized(const gguf_tensor& tensor) {
+  return tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1 ||
+      tensor.type == GGUF_TYPE_Q8_0 || tensor.type == GGUF_TYPE_Q4_K ||
+      tensor.type == GGUF_TYPE_Q5_K;
+}
+
+std::unordered_map<std::string, array> load_arrays(
+    gguf_ctx* ctx,
+    const std::string& file,
+    StreamOrDevice s) {
   std::unordered_map<std::string, array> array_map;
-  gguf_tensor tensor;
 
   auto check_insert = [](const auto& inserted) {
     if (!inserted.second) {
@@ -217,16 +229,64 @@ std::unordered_map<std::string, array> load_arrays(gguf_ctx* ctx) {
     }
   };
 
-  while (gguf_get_tensor(ctx, &tensor)) {
-    if (tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1 ||
-        tensor.type == GGUF_TYPE_Q8_0) {
-      gguf_load_quantized(array_map, tensor);
-    } else {
+  // The tensors with an equivalent type are read lazily from the file, the
+  // others are converted from the mapped file in parallel.
+  auto stream = to_stream(s, cu::is_available() ? Device::gpu : Device::cpu);
+  if (stream.device != Device::cpu && !cu::is_available()) {
+    throw std::runtime_error("[load_gguf] Must run on a CPU stream.");
+  }
+  auto reader = std::make_shared<io::ParallelFileReader>(file);
+  using ArrayMap = std::unordered_map<std::string, array>;
+  std::vector<std::future<ArrayMap>> futures;
+  // The conversions read the mapped file, so they are all waited for before
+  // throwing the first error and closing the file.
+  std::exception_ptr error;
+  gguf_tensor tensor;
+  try {
+    while (gguf_get_tensor(ctx, &tensor)) {
       std::string name(tensor.name, tensor.namelen);
-      const auto& [data, dtype] = extract_tensor_data(&tensor);
-      array loaded_array = array(data, get_shape(tensor), dtype);
-      check_insert(array_map.insert({name, loaded_array}));
+      if (is_quantized(tensor)) {
+        futures.push_back(io::thread_pool().enqueue([tensor]() {
+          ArrayMap arrays;
+          gguf_load_quantized(arrays, tensor);
+          return arrays;
+        }));
+      } else if (auto dtype = gguf_type_to_dtype(tensor.type)) {
+        size_t offset =
+            static_cast<uint8_t*>(tensor.weights_data) - ctx->data;
+        array loaded_array = array(
+            get_shape(tensor),
+            *dtype,
+            std::make_shared<Load>(stream, reader, offset, false),
+            std::vector<array>{});
+        check_insert(array_map.insert({name, loaded_array}));
+      } else {
+        futures.push_back(
+            io::thread_pool().enqueue([tensor, name]() mutable {
+              const auto& [data, dtype] = extract_tensor_data(&tensor);
+              return ArrayMap{{name, array(data, get_shape(tensor), dtype)}};
+            }));
+      }
     }
+  } catch (...) {
+    error = std::current_exception();
+  }
+  for (auto& f : futures) {
+    try {
+      auto arrays = f.get();
+      if (!error) {
+        for (auto& [name, arr] : arrays) {
+          check_insert(array_map.insert({name, std::move(arr)}));
+        }
+      }
+    } catch (...) {
+      if (!error) {
+        error = std::current_exception();
+      }
+    }
+  }
+  if (error) {
+    std::rethrow_exception(error);
   }
   return array_map;
 }
@@ -247,7 +307,7 @@ GGUFLoad load_gguf(const std::string& file, StreamOrDevice s) {
     throw std::runtime_error("[load_gguf] gguf_init failed");
   }
   auto metadata = load_metadata(ctx.get());
-  auto arrays = load_arrays(ctx.get());
+  auto arrays = load_arrays(ctx.get(), file, s);
   return {arrays, metadata};
 }
 
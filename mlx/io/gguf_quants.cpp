@@ -97,21 +97,103 @@ void extract_q8_0_data(
   }
 }
 
+// Pack |n| values of |bits| into |dst| in the order of the bits of MLX, from
+// the lowest bits of the first byte.
+void pack_bits(const uint8_t* q, int n, int bits, uint8_t* dst) {
+  uint32_t acc = 0;
+  int filled = 0;
+  for (int i = 0; i < n; ++i) {
+    acc |= static_cast<uint32_t>(q[i]) << filled;
+    filled += bits;
+    while (filled >= 8) {
+      *dst++ = acc & 0xFF;
+      acc >>= 8;
+      filled -= 8;
+    }
+  }
+}
+
+// The 6 bit scale and min of the sub-block |j| of a K-quant super-block.
+void get_scale_min_k4(int j, const uint8_t* q, uint8_t& d, uint8_t& m) {
+  if (j < 4) {
+    d = q[j] & 63;
+    m = q[j + 4] & 63;
+  } else {
+    d = (q[j + 4] & 0xF) | ((q[j - 4] >> 6) << 4);
+    m = (q[j + 4] >> 4) | ((q[j] >> 6) << 4);
+  }
+}
+
+// Extracts (weight, scales, biases) from Q4_K and Q5_K tensors, which are
+// super-blocks of 8 x 32 weights with a 6 bit scale and min per block of 32
+// scaled by the 16 bit scale and min of the super-block. Data layout is:
+// |16 bit scale|16 bit min|12 bytes of scales|(Q5_K) 32 bytes of 5th bits|
+// |256 x 4bit weights|.
+void extract_q_k_data(
+    const gguf_tensor& tensor,
+    int bits,
+    array& weights_arr,
+    array& scales_arr,
+    array& biases_arr) {
+  const int64_t high_bytes = bits == 5 ? 32 : 0;
+  const int64_t bytes_per_block = 16 + high_bytes + 128;
+  auto data = static_cast<uint8_t*>(tensor.weights_data);
+  auto weights = weights_arr.data<uint8_t>();
+  auto scales = scales_arr.data<float16_t>();
+  auto biases = biases_arr.data<float16_t>();
+  int64_t num_blocks = scales_arr.size() / 8;
+  uint8_t q[32];
+  for (int64_t i = 0; i < num_blocks; i++) {
+    float d = *((float16_t*)data);
+    float dmin = *((float16_t*)data + 1);
+    const uint8_t* sc = data + 4;
+    const uint8_t* qh = data + 16;
+    const uint8_t* ql = data + 16 + high_bytes;
+    // Each 32 bytes of |ql| hold the blocks 2j in the low bits and 2j + 1
+    // in the high bits, with their 5th bits at 2j and 2j + 1 of |qh|.
+    for (int j = 0; j < 8; j++) {
+      uint8_t sc_j, m_j;
+      get_scale_min_k4(j, sc, sc_j, m_j);
+      *scales++ = d * sc_j;
+      *biases++ = -dmin * m_j;
+      int shift = (j % 2) * 4;
+      for (int l = 0; l < 32; l++) {
+        q[l] = (ql[l] >> shift) & 0xF;
+        if (high_bytes) {
+          q[l] |= ((qh[l] >> j) & 1) << 4;
+        }
+      }
+      pack_bits(q, 32, bits, weights);
+      weights += 32 * bits / 8;
+      if (j % 2 == 1) {
+        ql += 32;
+      }
+    }
+    data += bytes_per_block;
+  }
+}
+
 void gguf_load_quantized(
     std::unordered_map<std::string, array>& a,
     const gguf_tensor& tensor) {
-  uint64_t weights_per_byte;
-  if (tensor.type == GGUF_TYPE_Q4_0 || tensor.type == GGUF_TYPE_Q4_1) {
-    weights_per_byte = 2;
-  } else { // tensor.type == GGUF_TYPE_Q8_0
-    weights_per_byte = 1;
+  int bits;
+  if (tensor.type == GGUF_TYPE_Q8_0) {
+    bits = 8;
+  } else if (tensor.type == GGUF_TYPE_Q5_K) {
+    bits = 5;
+  } else { // Q4_0, Q4_1 and Q4_K
+    bits = 4;
   }
+  bool k_quant =
+      tensor.type == GGUF_TYPE_Q4_K || tensor.type == GGUF_TYPE_Q5_K;
 
   std::string name(tensor.name, tensor.namelen);
 
   auto shape = get_shape(tensor);
+  // The K-quants are in super-blocks of 256 weights, with a scale and a
+  // bias per 32 weights as for the others.
   const uint64_t weights_per_block = 32;
-  if (shape[shape.size() - 1] % weights_per_block != 0) {
+  if (shape[shape.size() - 1] % (k_quant ? 256 : weights_per_block) != 0) {
     std::ostringstream msg;
     msg << "[load_gguf] tensor " << name
         << "has incompatible last dim shape: " << shape[shape.size() - 1];
@@ -119,7 +201,7 @@ void gguf_load_quantized(
   }
 
   auto weights_shape = shape;
-  weights_shape.back() /= (weights_per_byte * 4);
+  weights_shape.back() = weights_shape.back() * bits / 32;
   auto w_nbytes = uint32.size() *
       std::accumulate(weights_shape.begin(),
                       weights_shape.end(),
@@ -141,6 +223,8 @@ void gguf_load_quantized(
     extract_q4_1_data(tensor, weights, scales, biases);
   } else if (tensor.type == GGUF_TYPE_Q8_0) {
     extract_q8_0_data(tensor, weights, scales, biases);
+  } else if (k_quant) {
+    extract_q_k_data(tensor, bits, weights, scales, biases);
   }
 
   a.emplace(name, std::move(weights));
@@ -13,7 +13,12 @@
 #include <windows.h>
 #endif // _WIN32
 
+#ifndef _WIN32
+#include <sys/mman.h>
+#endif
+
 #include "mlx/io/load.h"
+#include "mlx/io/uring.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
@@ -129,6 +134,25 @@ int64_t pread(int fd, void* buf, uint64_t size, uint64_t offset) {
 
   return bytes_read;
 }
+
+// Nor pwrite, emulate it with WriteFile.
+int64_t pwrite(int fd, const void* buf, uint64_t size, uint64_t offset) {
+  HANDLE file = reinterpret_cast<HANDLE>(_get_osfhandle(fd));
+  if (file == INVALID_HANDLE_VALUE) {
+    return -1;
+  }
+
+  OVERLAPPED overlapped = {0};
+  overlapped.Offset = offset & 0xFFFFFFFF;
+  overlapped.OffsetHigh = (offset >> 32) & 0xFFFFFFFF;
+
+  DWORD bytes_written;
+  if (!WriteFile(file, buf, size, &bytes_written, &overlapped)) {
+    return -1;
+  }
+
+  return bytes_written;
+}
 #endif
 
 } // namespace
@@ -353,7 +377,25 @@ void ParallelFileReader::read(char* data, size_t n) {
   }
 }
 
+ParallelFileReader::ParallelFileReader(std::string file_path)
+    : fd_(open(file_path.c_str(), O_RDONLY | O_BINARY)),
+      label_(std::move(file_path)) {
+#ifdef O_DIRECT
+  if (env::io_direct() && Uring::get()) {
+    direct_fd_ = open(label_.c_str(), O_RDONLY | O_DIRECT);
+  }
+#endif
+}
+
 void ParallelFileReader::read(char* data, size_t n, size_t offset) {
+  if (auto ring = Uring::get()) {
+    bool direct = direct_fd_ >= 0;
+    if (ring->read(direct ? direct_fd_ : fd_, data, n, offset, direct)) {
+      return;
+    }
+    // The file system may not support O_DIRECT or io_uring reads, the
+    // preads below report the errors.
+  }
   auto readfn = [fd = fd_](size_t offset, size_t size, char* buffer) -> bool {
     while (size != 0) {
       auto m = pread(fd, buffer, size, offset);
@@ -388,6 +430,87 @@ void ParallelFileReader::read(char* data, size_t n, size_t offset) {
   }
 }
 
+void FileWriter::write(const char* data, size_t n, size_t offset) {
+  auto writefn = [fd = fd_](
+                     size_t offset, size_t size, const char* buffer) -> bool {
+    while (size != 0) {
+      auto m = pwrite(fd, buffer, size, offset);
+      if (m <= 0) {
+        return false;
+      }
+      buffer += m;
+      size -= m;
+      offset += m;
+    }
+    return true;
+  };
+  std::vector<std::future<bool>> futs;
+  while (n > batch_size_) {
+    futs.emplace_back(
+        thread_pool().enqueue(writefn, offset, batch_size_, data));
+    data += batch_size_;
+    n -= batch_size_;
+    offset += batch_size_;
+  }
+  bool good = writefn(offset, n, data);
+  for (auto& f : futs) {
+    good &= f.get();
+  }
+  if (!good) {
+    throw std::runtime_error("[write] Unable to write to " + label());
+  }
+}
+
+#ifndef _WIN32
+MmapFileReader::MmapFileReader(std::string file_path)
+    : label_(std::move(file_path)) {
+  int fd = open(label_.c_str(), O_RDONLY | O_BINARY);
+  if (fd < 0) {
+    return;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* ptr = mmap(
+        nullptr, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (ptr != MAP_FAILED) {
+      data_ = static_cast<char*>(ptr);
+      size_ = st.st_size;
+    }
+  }
+  // The mapping holds the file.
+  close(fd);
+}
+
+MmapFileReader::~MmapFileReader() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+char* MmapFileReader::data(size_t offset, size_t n) {
+  if (offset > size_ || n > size_ - offset) {
+    std::ostringstream msg;
+    msg << "[read] Unable to read " << n << " bytes at offset " << offset
+        << " from " << label() << ".";
+    throw std::runtime_error(msg.str());
+  }
+  // Start reading the pages in ahead of the first access.
+  static size_t page = sysconf(_SC_PAGESIZE);
+  size_t begin = offset / page * page;
+  madvise(data_ + begin, offset + n - begin, MADV_WILLNEED);
+  return data_ + offset;
+}
+
+void MmapFileReader::read(char* data, size_t n) {
+  read(data, n, pos_);
+  pos_ += n;
+}
+
+void MmapFileReader::read(char* data, size_t n, size_t offset) {
+  std::memcpy(data, this->data(offset, n), n);
+}
+#endif
+
 } // namespace io
 
 } // namespace mlx::core
@@ -56,14 +56,19 @@ class Writer {
   virtual ~Writer() = default;
 };
 
+// A reader of a file splitting the reads at an offset. They are issued
+// from an io_uring of the calling thread when available, through the
+// page cache or with O_DIRECT when MLX_IO_DIRECT is set, and otherwise split
+// over a pool of threads of blocking preads.
 class ParallelFileReader : public Reader {
  public:
-  explicit ParallelFileReader(std::string file_path)
-      : fd_(open(file_path.c_str(), O_RDONLY | O_BINARY)),
-        label_(std::move(file_path)) {}
+  explicit ParallelFileReader(std::string file_path);
 
   ~ParallelFileReader() override {
     close(fd_);
+    if (direct_fd_ >= 0) {
+      close(direct_fd_);
+    }
   }
 
   bool is_open() const override {
@@ -103,9 +108,59 @@ class ParallelFileReader : public Reader {
   static constexpr size_t batch_size_ = 1 << 25;
   static ThreadPool& thread_pool();
   int fd_;
+  // The file opened with O_DIRECT, or -1.
+  int direct_fd_{-1};
   std::string label_;
 };
 
+#ifndef _WIN32
+// A reader of a file mapped in memory. The mapping is private and writable
+// so the arrays wrapping its pages can be written to, e.g. when donated,
+// without changing the file: the pages are only copied once written.
+class MmapFileReader : public Reader {
+ public:
+  explicit MmapFileReader(std::string file_path);
+  ~MmapFileReader() override;
+
+  MmapFileReader(const MmapFileReader&) = delete;
+  MmapFileReader& operator=(const MmapFileReader&) = delete;
+
+  bool is_open() const override {
+    return data_ != nullptr;
+  }
+
+  bool good() const override {
+    return is_open();
+  }
+
+  size_t tell() override {
+    return pos_;
+  }
+
+  void seek(int64_t off, std::ios_base::seekdir way = std::ios_base::beg)
+      override {
+    pos_ = (way == std::ios_base::beg) ? off : pos_ + off;
+  }
+
+  void read(char* data, size_t n) override;
+
+  void read(char* data, size_t n, size_t offset) override;
+
+  std::string label() const override {
+    return "file " + label_;
+  }
+
+  // The |n| mapped bytes at |offset|, which are about to be read.
+  char* data(size_t offset, size_t n);
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+  size_t pos_{0};
+  std::string label_;
+};
+#endif
+
 class FileWriter : public Writer {
  public:
   explicit FileWriter(std::string file_path)
@@ -161,11 +216,16 @@ class FileWriter : public Writer {
     }
   }
 
+  // Write |n| bytes at |offset| with parallel pwrites, which does not move
+  // the position of the file.
+  void write(const char* data, size_t n, size_t offset);
+
   std::string label() const override {
     return "file " + label_;
   }
 
  private:
+  static constexpr size_t batch_size_ = 1 << 25;
   int fd_{0};
   std::string label_;
 };
@@ -10,12 +10,23 @@ SafetensorsLoad load_safetensors(std::shared_ptr<io::Reader>, StreamOrDevice) {
       "to enable safetensors support.");
 }
 
-SafetensorsLoad load_safetensors(const std::string&, StreamOrDevice) {
+SafetensorsLoad load_safetensors(const std::string&, StreamOrDevice, bool) {
   throw std::runtime_error(
       "[load_safetensors] Compile with MLX_BUILD_SAFETENSORS=ON "
       "to enable safetensors support.");
 }
 
+SafetensorsLoad load_sharded(
+    const std::vector<std::string>&,
+    std::optional<Dtype>,
+    size_t,
+    StreamOrDevice,
+    bool) {
+  throw std::runtime_error(
+      "[load_sharded] Compile with MLX_BUILD_SAFETENSORS=ON "
+      "to enable safetensors support.");
+}
+
 void save_safetensors(
     std::shared_ptr<io::Writer>,
     std::unordered_map<std::string, array>,
@@ -34,4 +45,13 @@ void save_safetensors(
       "to enable safetensors support.");
 }
 
+std::shared_future<void> save_safetensors_async(
+    std::string,
+    std::unordered_map<std::string, array>,
+    std::unordered_map<std::string, std::string>) {
+  throw std::runtime_error(
+      "[save_safetensors] Compile with MLX_BUILD_SAFETENSORS=ON "
+      "to enable safetensors support.");
+}
+
 } // namespace mlx::core
@@ -1,10 +1,11 @@
 // Copyright © 2023 Apple Inc.
 //
 #include <json.hpp>
+#include <future>
 #include <memory>
 #include <stack>
 
-#include "mlx/fast.h"
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/io.h"
 #include "mlx/io/load.h"
 #include "mlx/ops.h"
@@ -27,6 +28,7 @@ using json = nlohmann::json;
 #define ST_U32 "U32"
 #define ST_U64 "U64"
 #define ST_F8_E4M3 "F8_E4M3"
+#define ST_F8_E5M2 "F8_E5M2"
 
 // Note: Complex numbers aren't in the spec yet so this could change -
 // https://github.com/huggingface/safetensors/issues/389
@@ -94,7 +96,7 @@ Dtype dtype_from_safetensor_str(std::string_view str) {
     return bool_;
   } else if (str == ST_C64) {
     return complex64;
-  } else if (str == ST_F8_E4M3) {
+  } else if (str == ST_F8_E4M3 || str == ST_F8_E5M2) {
     // We convert this manually later
     return uint8;
   } else {
@@ -103,171 +105,209 @@ Dtype dtype_from_safetensor_str(std::string_view str) {
   }
 }
 
-array f8_e4m3_to_float(array x, Dtype dtype, StreamOrDevice s) {
-  if (to_stream(s).device == Device::gpu) {
-    // From PyTorch:
-    // https://github.com/pytorch/pytorch/blob/e3643e1e0e923f0fc063dfab6f45c956d568919d/c10/util/Float8_e4m3fn.h#L46
-    std::string source = R"(
-      uint elem = thread_position_in_grid.x;
-      uint8_t val = x[elem];
-
-      const uint32_t w = (uint32_t)val << 24;
-      const uint32_t sign = w & 0x80000000;
-      const uint32_t nonsign = w & 0x7FFFFFFF;
-
-      uint32_t renorm_shift = metal::clz(nonsign);
-      renorm_shift = renorm_shift > 4 ? renorm_shift - 4 : 0;
-
-      const int32_t inf_nan_mask =
-          ((int32_t)(nonsign + 0x01000000) >> 8) & 0x7F800000;
-      const int32_t zero_mask = (int32_t)(nonsign - 1) >> 31;
-      uint32_t result = sign |
-          ((((nonsign << renorm_shift >> 4) + ((0x78 - renorm_shift) << 23)) |
-              inf_nan_mask) &
-              ~zero_mask);
-
-      float out = *(reinterpret_cast<thread float*>(&result));
-      y[elem] = static_cast<T>(out);
-    )";
-    auto kernel = fast::metal_kernel("f8_e4m3", {"x"}, {"y"}, source);
-    auto outputs = kernel(
-        {x},
-        {x.shape()},
-        {dtype},
-        {x.size(), 1, 1},
-        {256, 1, 1},
-        {{"T", dtype}},
-        std::nullopt,
-        false,
-        s);
-    return outputs[0];
-  } else {
-    auto w = left_shift(astype(x, uint32, s), array({24}, uint32), s);
-    auto sign = bitwise_and(w, array({0x80000000}, uint32), s);
-    auto nonsign = bitwise_and(w, array({0x7FFFFFFF}, uint32), s);
-
-    // Emulate a clz op with a lookup table
-    auto clz_table =
-        array({28, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0}, uint32);
-    auto renorm_shift = take(clz_table, bitwise_and(x, array({0xf}), s), s);
-    renorm_shift = where(
-        greater(
-            bitwise_and(x, array({0x70}, uint32), s), array({0}, uint32), s),
-        array({0}, uint32),
-        renorm_shift,
-        s);
-    auto inf_nan_mask = bitwise_and(
-        right_shift(
-            astype(add(nonsign, array(0x01000000, int32), s), int32, s),
-            array({8}, int32),
-            s),
-        array({0x7F800000}, int32),
-        s);
-    auto zero_mask = right_shift(
-        astype(subtract(nonsign, array({1}, uint32), s), int32, s),
-        array({31}, int32),
-        s);
-    zero_mask = astype(zero_mask, uint32, s);
-    inf_nan_mask = astype(inf_nan_mask, uint32, s);
-    auto result =
-        add(right_shift(
-                left_shift(nonsign, renorm_shift, s), array({4}, uint32), s),
-            left_shift(
-                subtract(array({0x78}, uint32), renorm_shift, s),
-                array({23}, uint32),
-                s),
-            s);
-    result = bitwise_or(
-        sign,
-        bitwise_and(
-            bitwise_or(result, inf_nan_mask, s),
-            bitwise_invert(zero_mask, s),
-            s),
-        s);
-    result = astype(view(result, float32, s), dtype, s);
-    return result;
-  }
-}
+namespace {
 
-/** Load array from reader in safetensor format */
-SafetensorsLoad load_safetensors(
-    std::shared_ptr<io::Reader> in_stream,
-    StreamOrDevice s) {
-  ////////////////////////////////////////////////////////
-  // Open and check file
-  if (!in_stream->good() || !in_stream->is_open()) {
-    throw std::runtime_error(
-        "[load_safetensors] Failed to open " + in_stream->label());
-  }
+// An array of a safetensors file.
+struct SafetensorsEntry {
+  std::string name;
+  std::string dtype;
+  Shape shape;
+  // The offset of the data in the file and its size.
+  size_t offset;
+  size_t nbytes;
+};
 
-  auto stream = to_stream(s, Device::cpu);
-  if (stream.device != Device::cpu) {
-    throw std::runtime_error("[load_safetensors] Must run on a CPU stream.");
+struct SafetensorsHeader {
+  std::vector<SafetensorsEntry> entries;
+  std::unordered_map<std::string, std::string> metadata;
+};
+
+SafetensorsHeader read_safetensors_header(io::Reader& in_stream) {
+  if (!in_stream.good() || !in_stream.is_open()) {
+    throw std::runtime_error(
+        "[load_safetensors] Failed to open " + in_stream.label());
   }
 
   uint64_t jsonHeaderLength = 0;
   // This is the same limit as in the original Rust Safetensors code.
   constexpr uint64_t kMaxJsonHeaderLength = 100000000;
-  in_stream->read(reinterpret_cast<char*>(&jsonHeaderLength), 8);
+  in_stream.read(reinterpret_cast<char*>(&jsonHeaderLength), 8);
   if (jsonHeaderLength <= 0 || jsonHeaderLength >= kMaxJsonHeaderLength) {
     throw std::runtime_error(
-        "[load_safetensors] Invalid json header length " + in_stream->label());
+        "[load_safetensors] Invalid json header length " + in_stream.label());
   }
   // Load the json metadata
   auto rawJson = std::make_unique<char[]>(jsonHeaderLength);
-  in_stream->read(rawJson.get(), jsonHeaderLength);
+  in_stream.read(rawJson.get(), jsonHeaderLength);
   auto metadata = json::parse(rawJson.get(), rawJson.get() + jsonHeaderLength);
   // Should always be an object on the top-level
   if (!metadata.is_object()) {
     throw std::runtime_error(
-        "[load_safetensors] Invalid json metadata " + in_stream->label());
+        "[load_safetensors] Invalid json metadata " + in_stream.label());
   }
   size_t offset = jsonHeaderLength + 8;
-  // Load the arrays using metadata
-  std::unordered_map<std::string, array> res;
-  std::unordered_map<std::string, std::string> metadata_map;
+  SafetensorsHeader header;
   for (const auto& item : metadata.items()) {
     if (item.key() == "__metadata__") {
       for (const auto& meta_item : item.value().items()) {
-        metadata_map.insert({meta_item.key(), meta_item.value()});
+        header.metadata.insert({meta_item.key(), meta_item.value()});
       }
       continue;
     }
-    const std::string& dtype = item.value().at("dtype");
-    const Shape& shape = item.value().at("shape");
     const std::vector<size_t>& data_offsets = item.value().at("data_offsets");
-    Dtype type = dtype_from_safetensor_str(dtype);
-    auto loaded_array = array(
-        shape,
-        type,
-        std::make_shared<Load>(
-            stream, in_stream, offset + data_offsets.at(0), false),
-        std::vector<array>{});
-    if (dtype == ST_F8_E4M3) {
-      loaded_array = f8_e4m3_to_float(loaded_array, bfloat16, s);
-    }
-    res.insert({item.key(), loaded_array});
+    header.entries.push_back(
+        {item.key(),
+         item.value().at("dtype"),
+         item.value().at("shape"),
+         offset + data_offsets.at(0),
+         data_offsets.at(1) - data_offsets.at(0)});
   }
-  return {res, metadata_map};
+  return header;
 }
 
-SafetensorsLoad load_safetensors(const std::string& file, StreamOrDevice s) {
-  return load_safetensors(std::make_shared<io::ParallelFileReader>(file), s);
+// The stream of the Load primitives, the CUDA back-end reads the arrays to
+// the device through pinned buffers.
+Stream load_stream(StreamOrDevice s) {
+  auto stream = to_stream(s, cu::is_available() ? Device::gpu : Device::cpu);
+  if (stream.device != Device::cpu && !cu::is_available()) {
+    throw std::runtime_error("[load_safetensors] Must run on a CPU stream.");
+  }
+  return stream;
 }
 
-void save_safetensors(
-    std::shared_ptr<io::Writer> out_stream,
-    std::unordered_map<std::string, array> a,
-    std::unordered_map<std::string, std::string> metadata /* = {} */) {
-  ////////////////////////////////////////////////////////
-  // Check file
-  if (!out_stream->good() || !out_stream->is_open()) {
-    throw std::runtime_error(
-        "[save_safetensors] Failed to open " + out_stream->label());
+// The array of |entry| read from |in_stream|, the float8 arrays converted
+// to |fp8_dtype|.
+array load_entry(
+    const SafetensorsEntry& entry,
+    const std::shared_ptr<io::Reader>& in_stream,
+    Stream stream,
+    Dtype fp8_dtype,
+    StreamOrDevice s) {
+  auto loaded_array = array(
+      entry.shape,
+      dtype_from_safetensor_str(entry.dtype),
+      std::make_shared<Load>(stream, in_stream, entry.offset, false),
+      std::vector<array>{});
+  if (entry.dtype == ST_F8_E4M3) {
+    loaded_array = from_fp8(loaded_array, fp8_dtype, "e4m3", s);
+  } else if (entry.dtype == ST_F8_E5M2) {
+    loaded_array = from_fp8(loaded_array, fp8_dtype, "e5m2", s);
   }
+  return loaded_array;
+}
 
-  ////////////////////////////////////////////////////////
-  // Check array map
+std::shared_ptr<io::Reader> open_safetensors(
+    const std::string& file,
+    bool mmap) {
+#ifndef _WIN32
+  if (mmap) {
+    return std::make_shared<io::MmapFileReader>(file);
+  }
+#endif
+  return std::make_shared<io::ParallelFileReader>(file);
+}
+
+} // namespace
+
+/** Load array from reader in safetensor format */
+SafetensorsLoad load_safetensors(
+    std::shared_ptr<io::Reader> in_stream,
+    StreamOrDevice s) {
+  auto header = read_safetensors_header(*in_stream);
+  auto stream = load_stream(s);
+  std::unordered_map<std::string, array> res;
+  for (auto& entry : header.entries) {
+    res.insert(
+        {entry.name, load_entry(entry, in_stream, stream, bfloat16, s)});
+  }
+  return {res, std::move(header.metadata)};
+}
+
+SafetensorsLoad
+load_safetensors(const std::string& file, StreamOrDevice s, bool mmap) {
+  return load_safetensors(open_safetensors(file, mmap), s);
+}
+
+SafetensorsLoad load_sharded(
+    const std::vector<std::string>& files,
+    std::optional<Dtype> dtype /* = std::nullopt */,
+    size_t max_bytes_in_flight /* = 1 << 30 */,
+    StreamOrDevice s /* = {} */,
+    bool mmap /* = false */) {
+  // Parse the headers of the shards in parallel.
+  std::vector<std::shared_ptr<io::Reader>> readers(files.size());
+  std::vector<std::future<SafetensorsHeader>> futures;
+  for (size_t i = 0; i < files.size(); ++i) {
+    readers[i] = open_safetensors(files[i], mmap);
+    futures.push_back(io::thread_pool().enqueue(
+        [reader = readers[i]]() { return read_safetensors_header(*reader); }));
+  }
+  std::vector<SafetensorsHeader> headers;
+  for (auto& f : futures) {
+    headers.push_back(f.get());
+  }
+
+  // The floating point arrays are cast to |dtype| with the float8 ones
+  // converted to it directly, in the stream of the loads.
+  auto stream = load_stream(s);
+  Dtype fp8_dtype = bfloat16;
+  if (dtype && issubdtype(*dtype, floating)) {
+    fp8_dtype = *dtype;
+  }
+  auto convert = [&](array a) {
+    if (dtype && issubdtype(a.dtype(), floating) && a.dtype() != *dtype) {
+      return astype(std::move(a), *dtype, stream);
+    }
+    return a;
+  };
+
+  // Take the arrays from the shards in turn so the files are read together,
+  // and evaluate them in groups of at most |max_bytes_in_flight| bytes of
+  // the files. The buffers read are freed once converted.
+  SafetensorsLoad res;
+  std::vector<array> group;
+  size_t group_bytes = 0;
+  auto flush = [&]() {
+    eval(group);
+    group.clear();
+    group_bytes = 0;
+  };
+  for (size_t k = 0, remaining = 1; remaining > 0; ++k) {
+    remaining = 0;
+    for (size_t i = 0; i < headers.size(); ++i) {
+      auto& entries = headers[i].entries;
+      if (k >= entries.size()) {
+        continue;
+      }
+      remaining++;
+      auto& entry = entries[k];
+      if (res.first.count(entry.name)) {
+        throw std::invalid_argument(
+            "[load_sharded] The array " + entry.name +
+            " is in several shards.");
+      }
+      if (!group.empty() && group_bytes + entry.nbytes > max_bytes_in_flight) {
+        flush();
+      }
+      auto a = convert(load_entry(entry, readers[i], stream, fp8_dtype, s));
+      group.push_back(a);
+      group_bytes += entry.nbytes;
+      res.first.insert({entry.name, std::move(a)});
+    }
+  }
+  flush();
+  for (auto& header : headers) {
+    res.second.insert(header.metadata.begin(), header.metadata.end());
+  }
+  return res;
+}
+
+namespace {
+
+// The header of the arrays, made contiguous, and of the metadata.
+std::string make_safetensors_header(
+    std::unordered_map<std::string, array>& a,
+    const std::unordered_map<std::string, std::string>& metadata) {
   json parent;
   json _metadata;
   for (auto& [key, value] : metadata) {
@@ -275,18 +315,9 @@ void save_safetensors(
   }
   parent["__metadata__"] = _metadata;
 
-  {
-    std::vector<array> to_eval;
-    to_eval.reserve(a.size());
-    for (auto& p : a) {
-      p.second = contiguous(p.second);
-      to_eval.push_back(p.second);
-    }
-    eval(std::move(to_eval));
-  }
-
   size_t offset = 0;
   for (auto& [key, arr] : a) {
+    arr = contiguous(arr);
     if (arr.nbytes() == 0) {
       throw std::invalid_argument(
           "[save_safetensors] cannot serialize an empty array key: " + key);
@@ -300,27 +331,111 @@ void save_safetensors(
     offset += arr.nbytes();
   }
 
+  // Pad the header with spaces for the data to be aligned in the file, as
+  // the arrays may wrap the pages of the file when it is mapped.
   auto header = parent.dump();
+  header.resize((header.length() + 7) / 8 * 8, ' ');
   uint64_t header_len = header.length();
-  out_stream->write(reinterpret_cast<char*>(&header_len), 8);
-  out_stream->write(header.c_str(), header_len);
+  return std::string(reinterpret_cast<char*>(&header_len), 8) + header;
+}
+
+std::string safetensors_file_name(std::string file) {
+  // Add .safetensors to file name if it is not there
+  if (file.length() < 12 ||
+      file.substr(file.length() - 12, 12) != ".safetensors")
+    file += ".safetensors";
+  return file;
+}
+
+} // namespace
+
+void save_safetensors(
+    std::shared_ptr<io::Writer> out_stream,
+    std::unordered_map<std::string, array> a,
+    std::unordered_map<std::string, std::string> metadata /* = {} */) {
+  ////////////////////////////////////////////////////////
+  // Check file
+  if (!out_stream->good() || !out_stream->is_open()) {
+    throw std::runtime_error(
+        "[save_safetensors] Failed to open " + out_stream->label());
+  }
+
+  auto header = make_safetensors_header(a, metadata);
+  {
+    std::vector<array> to_eval;
+    to_eval.reserve(a.size());
+    for (auto& p : a) {
+      to_eval.push_back(p.second);
+    }
+    eval(std::move(to_eval));
+  }
+
+  out_stream->write(header.c_str(), header.length());
   for (auto& [key, arr] : a) {
-    out_stream->write(arr.data<char>(), arr.nbytes());
+    auto host = cu::readable_by_host(arr);
+    out_stream->write(host.data<char>(), host.nbytes());
   }
 }
 
-void save_safetensors(
+std::shared_future<void> save_safetensors_async(
     std::string file,
     std::unordered_map<std::string, array> a,
     std::unordered_map<std::string, std::string> metadata /* = {} */) {
-  // Add .safetensors to file name if it is not there
-  if (file.length() < 12 ||
-      file.substr(file.length() - 12, 12) != ".safetensors")
-    file += ".safetensors";
+  auto header = make_safetensors_header(a, metadata);
+
+  // Hold the arrays until they are written, which keeps their buffers from
+  // being donated, and wait on their events off the calling thread.
+  std::vector<array> arrays;
+  arrays.reserve(a.size());
+  for (auto& p : a) {
+    arrays.push_back(std::move(p.second));
+  }
+  async_eval(arrays);
+  std::vector<Event> events;
+  for (auto& arr : arrays) {
+    if (!arr.is_available() && arr.event().valid()) {
+      events.push_back(arr.event());
+    }
+  }
+
+  // The saves are written one at a time and in order, the arrays of the
+  // next ones are held meanwhile.
+  static ThreadPool save_pool{1};
+  auto writer = std::make_shared<io::FileWriter>(
+      safetensors_file_name(std::move(file)));
+  if (!writer->good() || !writer->is_open()) {
+    throw std::runtime_error(
+        "[save_safetensors] Failed to open " + writer->label());
+  }
+  return save_pool
+      .enqueue([writer = std::move(writer),
+                header = std::move(header),
+                arrays = std::move(arrays),
+                events = std::move(events)]() mutable {
+        for (auto& e : events) {
+          e.wait();
+        }
+        writer->write(header.data(), header.length(), 0);
+        size_t offset = header.length();
+        for (auto& arr : arrays) {
+          auto host = cu::readable_by_host(arr);
+          writer->write(host.data<char>(), host.nbytes(), offset);
+          offset += host.nbytes();
+        }
+      })
+      .share();
+}
 
+void save_safetensors(
+    std::string file,
+    std::unordered_map<std::string, array> a,
+    std::unordered_map<std::string, std::string> metadata /* = {} */) {
   // Serialize array
   save_safetensors(
-      std::make_shared<io::FileWriter>(std::move(file)), a, metadata);
+      std::make_shared<io::FileWriter>(
+          safetensors_file_name(std::move(file))),
+      a,
+      metadata);
 }
 
 } // namespace mlx::core
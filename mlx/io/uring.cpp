@@ -0,0 +1,269 @@
+// Copyright © 2025 Apple Inc.
+
+#include "mlx/io/uring.h"
+#include "mlx/utils.h"
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#define MLX_IO_URING
+#endif
+
+namespace mlx::core::io {
+
+#ifdef MLX_IO_URING
+
+// A read in flight of up to |Uring::chunk_size| bytes of the file at
+// |offset|, of which |done| bytes are read.
+struct Uring::Op {
+  size_t offset;
+  size_t size;
+  size_t done;
+  // The destination of a buffered read, or the registered buffer of a
+  // direct one.
+  char* dst;
+  int buffer;
+};
+
+Uring* Uring::get() {
+  static bool enabled = env::use_io_uring();
+  if (!enabled) {
+    return nullptr;
+  }
+  thread_local std::unique_ptr<Uring> ring;
+  thread_local bool initialized = false;
+  if (!initialized) {
+    initialized = true;
+    std::unique_ptr<Uring> r(new Uring);
+    if (r->init()) {
+      ring = std::move(r);
+    }
+  }
+  return ring.get();
+}
+
+bool Uring::init() {
+  io_uring_params p;
+  std::memset(&p, 0, sizeof(p));
+  ring_fd_ = syscall(__NR_io_uring_setup, queue_depth, &p);
+  if (ring_fd_ < 0) {
+    return false;
+  }
+  sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+  cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+  bool single_mmap = p.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap) {
+    sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+  }
+  constexpr int prot = PROT_READ | PROT_WRITE;
+  constexpr int flags = MAP_SHARED | MAP_POPULATE;
+  sq_ptr_ = mmap(nullptr, sq_size_, prot, flags, ring_fd_, IORING_OFF_SQ_RING);
+  if (sq_ptr_ == MAP_FAILED) {
+    sq_ptr_ = nullptr;
+    return false;
+  }
+  if (single_mmap) {
+    cq_ptr_ = sq_ptr_;
+  } else {
+    cq_ptr_ =
+        mmap(nullptr, cq_size_, prot, flags, ring_fd_, IORING_OFF_CQ_RING);
+    if (cq_ptr_ == MAP_FAILED) {
+      cq_ptr_ = nullptr;
+      return false;
+    }
+  }
+  sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+  sqes_ = mmap(nullptr, sqes_size_, prot, flags, ring_fd_, IORING_OFF_SQES);
+  if (sqes_ == MAP_FAILED) {
+    sqes_ = nullptr;
+    return false;
+  }
+  auto sq = static_cast<char*>(sq_ptr_);
+  sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+  sq_mask_ = reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+  sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+  auto cq = static_cast<char*>(cq_ptr_);
+  cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+  cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+  cq_mask_ = reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+  cqes_ = cq + p.cq_off.cqes;
+  return true;
+}
+
+Uring::~Uring() {
+  if (sqes_) {
+    munmap(sqes_, sqes_size_);
+  }
+  if (cq_ptr_ && cq_ptr_ != sq_ptr_) {
+    munmap(cq_ptr_, cq_size_);
+  }
+  if (sq_ptr_) {
+    munmap(sq_ptr_, sq_size_);
+  }
+  if (ring_fd_ >= 0) {
+    close(ring_fd_);
+  }
+  std::free(buffers_);
+}
+
+void Uring::submit(Op& op, int fd, bool direct) {
+  // The submission queue has a single producer, this thread.
+  unsigned tail = *sq_tail_;
+  unsigned index = tail & *sq_mask_;
+  auto sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+  std::memset(sqe, 0, sizeof(*sqe));
+  char* dst = direct ? buffers_ + op.buffer * chunk_size : op.dst;
+  sqe->opcode = (direct && registered_) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->off = op.offset + op.done;
+  sqe->addr = reinterpret_cast<uint64_t>(dst + op.done);
+  sqe->len = op.size - op.done;
+  if (direct && registered_) {
+    sqe->buf_index = op.buffer;
+  }
+  sqe->user_data = reinterpret_cast<uint64_t>(&op);
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+  pending_++;
+}
+
+void Uring::wait(int min_complete) {
+  while (true) {
+    // Submit the queued reads and wait for |min_complete| of them.
+    int ret = syscall(
+        __NR_io_uring_enter,
+        ring_fd_,
+        pending_,
+        min_complete,
+        IORING_ENTER_GETEVENTS,
+        nullptr,
+        0);
+    if (ret >= 0) {
+      pending_ -= ret;
+      return;
+    }
+    // The reads in flight still write to their buffers, so the ring can
+    // not be given up on.
+    if (errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+      throw std::runtime_error(
+          "[Uring::read] io_uring_enter failed: " +
+          std::string(std::strerror(errno)));
+    }
+  }
+}
+
+bool Uring::read(int fd, char* data, size_t n, size_t offset, bool direct) {
+  if (direct && !buffers_) {
+    buffers_ = static_cast<char*>(
+        std::aligned_alloc(direct_alignment, queue_depth * chunk_size));
+    if (!buffers_) {
+      return false;
+    }
+    std::vector<iovec> iovs(queue_depth);
+    for (int i = 0; i < queue_depth; ++i) {
+      iovs[i] = {buffers_ + i * chunk_size, chunk_size};
+    }
+    registered_ = syscall(
+                      __NR_io_uring_register,
+                      ring_fd_,
+                      IORING_REGISTER_BUFFERS,
+                      iovs.data(),
+                      queue_depth) == 0;
+  }
+
+  // The direct reads cover the aligned blocks around the requested bytes.
+  size_t end = offset + n;
+  size_t next = direct ? offset / direct_alignment * direct_alignment : offset;
+  size_t last = direct
+      ? (end + direct_alignment - 1) / direct_alignment * direct_alignment
+      : end;
+
+  Op ops[queue_depth];
+  std::vector<Op*> free_ops;
+  for (int i = 0; i < queue_depth; ++i) {
+    ops[i].buffer = i;
+    free_ops.push_back(&ops[i]);
+  }
+  int in_flight = 0;
+  bool ok = true;
+  while (in_flight > 0 || (ok && next < last)) {
+    while (ok && next < last && !free_ops.empty()) {
+      Op& op = *free_ops.back();
+      free_ops.pop_back();
+      op.offset = next;
+      op.size = std::min(chunk_size, last - next);
+      op.done = 0;
+      op.dst = data + (next - offset);
+      submit(op, fd, direct);
+      next += op.size;
+      in_flight++;
+    }
+    wait(1);
+    unsigned head = *cq_head_;
+    unsigned tail = __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE);
+    for (; head != tail; ++head) {
+      auto& cqe = static_cast<io_uring_cqe*>(cqes_)[head & *cq_mask_];
+      Op& op = *reinterpret_cast<Op*>(cqe.user_data);
+      int res = cqe.res;
+      if (res == -EINTR || res == -EAGAIN) {
+        submit(op, fd, direct);
+        continue;
+      }
+      if (res > 0 && direct) {
+        // Copy the requested bytes of the aligned block.
+        size_t begin = std::max(op.offset + op.done, offset);
+        size_t stop = std::min(op.offset + op.done + res, end);
+        if (begin < stop) {
+          std::memcpy(
+              data + (begin - offset),
+              buffers_ + op.buffer * chunk_size + (begin - op.offset),
+              stop - begin);
+        }
+      }
+      if (res > 0) {
+        op.done += res;
+      }
+      // The end of the file is within the last aligned block of the direct
+      // reads, the others must read all of their bytes.
+      bool complete = op.done == op.size ||
+          (direct && res >= 0 && op.offset + op.done >= end);
+      bool resubmit = !complete && res > 0 &&
+          (!direct || op.done % direct_alignment == 0);
+      if (resubmit) {
+        submit(op, fd, direct);
+        continue;
+      }
+      ok &= complete;
+      in_flight--;
+      free_ops.push_back(&op);
+    }
+    __atomic_store_n(cq_head_, head, __ATOMIC_RELEASE);
+  }
+  return ok;
+}
+
+#else
+
+Uring* Uring::get() {
+  return nullptr;
+}
+
+Uring::~Uring() = default;
+
+bool Uring::read(int, char*, size_t, size_t, bool) {
+  return false;
+}
+
+#endif
+
+} // namespace mlx::core::io
@@ -0,0 +1,69 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace mlx::core::io {
+
+// An io_uring of the calling thread reading files with many reads in
+// flight, without the threads of blocking preads. The rings are set up
+// with the syscalls directly, there is no dependency on liburing.
+class Uring {
+ public:
+  // The size of the reads, the reads in flight, and the alignment of the
+  // reads of the files opened with O_DIRECT.
+  static constexpr size_t chunk_size = 1 << 20;
+  static constexpr int queue_depth = 32;
+  static constexpr size_t direct_alignment = 4096;
+
+  // The ring of the calling thread, null when io_uring is not supported or
+  // disabled with MLX_IO_URING=0.
+  static Uring* get();
+
+  ~Uring();
+
+  Uring(const Uring&) = delete;
+  Uring& operator=(const Uring&) = delete;
+
+  // Read |n| bytes at |offset| of |fd| to |data|. The reads of a file opened
+  // with O_DIRECT go through aligned buffers registered with the ring.
+  // Returns false when a read fails, for the caller to fall back to pread.
+  bool read(int fd, char* data, size_t n, size_t offset, bool direct);
+
+ private:
+  Uring() = default;
+  bool init();
+
+  struct Op;
+  void submit(Op& op, int fd, bool direct);
+  void wait(int min_complete);
+
+  int ring_fd_{-1};
+  // The reads queued and not yet submitted to the kernel.
+  unsigned pending_{0};
+  void* sq_ptr_{nullptr};
+  size_t sq_size_{0};
+  void* cq_ptr_{nullptr};
+  size_t cq_size_{0};
+  void* sqes_{nullptr};
+  size_t sqes_size_{0};
+
+  unsigned* sq_tail_{nullptr};
+  unsigned* sq_mask_{nullptr};
+  unsigned* sq_array_{nullptr};
+  unsigned* cq_head_{nullptr};
+  unsigned* cq_tail_{nullptr};
+  unsigned* cq_mask_{nullptr};
+  void* cqes_{nullptr};
+
+  // The aligned buffers of the O_DIRECT reads, registered with the ring
+  // when the kernel allows it.
+  char* buffers_{nullptr};
+  bool registered_{false};
+  std::vector<int> free_buffers_;
+};
+
+} // namespace mlx::core::io
@@ -4,6 +4,7 @@
 #include <ostream>
 #include <vector>
 
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/linalg.h"
 #include "mlx/primitives.h"
 #include "mlx/utils.h"
@@ -18,6 +19,12 @@ void check_cpu_stream(const StreamOrDevice& s, const std::string& prefix) {
         "Explicitly pass a CPU stream to run it.");
   }
 }
+// The factorizations are implemented on the GPU by the CUDA backend only.
+void check_solver_stream(const StreamOrDevice& s, const std::string& prefix) {
+  if (!cu::is_available()) {
+    check_cpu_stream(s, prefix);
+  }
+}
 void check_float(Dtype dtype, const std::string& prefix) {
   if (dtype != float32 && dtype != float64) {
     std::ostringstream msg;
@@ -224,7 +231,7 @@ array norm(
 }
 
 std::pair<array, array> qr(const array& a, StreamOrDevice s /* = {} */) {
-  check_cpu_stream(s, "[linalg::qr]");
+  check_solver_stream(s, "[linalg::qr]");
   check_float(a.dtype(), "[linalg::qr]");
 
   if (a.ndim() < 2) {
@@ -249,7 +256,7 @@ std::pair<array, array> qr(const array& a, StreamOrDevice s /* = {} */) {
 
 std::vector<array>
 svd(const array& a, bool compute_uv, StreamOrDevice s /* = {} */) {
-  check_cpu_stream(s, "[linalg::svd]");
+  check_solver_stream(s, "[linalg::svd]");
   check_float(a.dtype(), "[linalg::svd]");
 
   if (a.ndim() < 2) {
@@ -292,7 +299,7 @@ svd(const array& a, bool compute_uv, StreamOrDevice s /* = {} */) {
 }
 
 array inv_impl(const array& a, bool tri, bool upper, StreamOrDevice s) {
-  check_cpu_stream(s, "[linalg::inv]");
+  check_solver_stream(s, "[linalg::inv]");
   check_float(a.dtype(), "[linalg::inv]");
 
   if (a.ndim() < 2) {
@@ -329,7 +336,7 @@ array cholesky(
     const array& a,
     bool upper /* = false */,
     StreamOrDevice s /* = {} */) {
-  check_cpu_stream(s, "[linalg::cholesky]");
+  check_solver_stream(s, "[linalg::cholesky]");
   check_float(a.dtype(), "[linalg::cholesky]");
   if (a.ndim() < 2) {
     std::ostringstream msg;
@@ -352,7 +359,7 @@ array cholesky(
 }
 
 array pinv(const array& a, StreamOrDevice s /* = {} */) {
-  check_cpu_stream(s, "[linalg::pinv]");
+  check_solver_stream(s, "[linalg::pinv]");
   check_float(a.dtype(), "[linalg::pinv]");
 
   if (a.ndim() < 2) {
@@ -400,7 +407,7 @@ array cholesky_inv(
     const array& L,
     bool upper /* = false */,
     StreamOrDevice s /* = {} */) {
-  check_cpu_stream(s, "[linalg::cholesky_inv]");
+  check_solver_stream(s, "[linalg::cholesky_inv]");
   check_float(L.dtype(), "[linalg::cholesky_inv]");
 
   if (L.ndim() < 2) {
@@ -500,8 +507,13 @@ array cross(
 void validate_eig(
     const array& a,
     const StreamOrDevice& stream,
-    const std::string& fname) {
-  check_cpu_stream(stream, fname);
+    const std::string& fname,
+    bool gpu_supported = true) {
+  if (gpu_supported) {
+    check_solver_stream(stream, fname);
+  } else {
+    check_cpu_stream(stream, fname);
+  }
   check_float_or_complex(a.dtype(), fname);
 
   if (a.ndim() < 2) {
@@ -520,7 +532,12 @@ array eigvalsh(
     const array& a,
     std::string UPLO /* = "L" */,
     StreamOrDevice s /* = {} */) {
-  validate_eig(a, s, "[linalg::eigvalsh]");
+  // The complex matrices are only supported on the CPU.
+  validate_eig(
+      a,
+      s,
+      "[linalg::eigvalsh]",
+      /* gpu_supported = */ a.dtype() != complex64);
   Shape out_shape(a.shape().begin(), a.shape().end() - 1);
   Dtype eigval_type = a.dtype() == complex64 ? float32 : a.dtype();
   return array(
@@ -534,7 +551,12 @@ std::pair<array, array> eigh(
     const array& a,
     std::string UPLO /* = "L" */,
     StreamOrDevice s /* = {} */) {
-  validate_eig(a, s, "[linalg::eigh]");
+  // The complex matrices are only supported on the CPU.
+  validate_eig(
+      a,
+      s,
+      "[linalg::eigh]",
+      /* gpu_supported = */ a.dtype() != complex64);
   Dtype eigval_type = a.dtype() == complex64 ? float32 : a.dtype();
   auto out = array::make_arrays(
       {Shape(a.shape().begin(), a.shape().end() - 1), a.shape()},
@@ -545,7 +567,7 @@ std::pair<array, array> eigh(
 }
 
 array eigvals(const array& a, StreamOrDevice s /* = {} */) {
-  validate_eig(a, s, "[linalg::eigvals]");
+  validate_eig(a, s, "[linalg::eigvals]", /* gpu_supported = */ false);
   Shape out_shape(a.shape().begin(), a.shape().end() - 1);
   return array(
       std::move(out_shape),
@@ -555,7 +577,7 @@ array eigvals(const array& a, StreamOrDevice s /* = {} */) {
 }
 
 std::pair<array, array> eig(const array& a, StreamOrDevice s /* = {} */) {
-  validate_eig(a, s, "[linalg::eig]");
+  validate_eig(a, s, "[linalg::eig]", /* gpu_supported = */ false);
   auto out = array::make_arrays(
       {Shape(a.shape().begin(), a.shape().end() - 1), a.shape()},
       {complex64, complex64},
@@ -568,7 +590,7 @@ void validate_lu(
     const array& a,
     const StreamOrDevice& stream,
     const std::string& fname) {
-  check_cpu_stream(stream, fname);
+  check_solver_stream(stream, fname);
   check_float(a.dtype(), fname);
 
   if (a.ndim() < 2) {
@@ -635,7 +657,7 @@ void validate_solve(
     const array& b,
     const StreamOrDevice& stream,
     const std::string& fname) {
-  check_cpu_stream(stream, fname);
+  check_solver_stream(stream, fname);
   if (a.ndim() < 2) {
     std::ostringstream msg;
     msg << fname << " First input must have >= 2 dimensions. "
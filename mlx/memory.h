@@ -3,6 +3,10 @@
 #pragma once
 
 #include <cstdlib>
+#include <string>
+#include <unordered_map>
+
+#include "mlx/device.h"
 
 namespace mlx::core {
 
@@ -61,6 +65,24 @@ size_t set_cache_limit(size_t limit);
 /* Clear the memory cache. */
 void clear_cache();
 
+/* Get the counters of the memory cache.
+ *
+ * The counters are summed over the devices:
+ *   - "hits": the allocations served from the cache.
+ *   - "misses": the allocations not served from the cache.
+ *   - "evictions": the cached buffers freed to make room or by clearing the
+ *     cache.
+ *   - "requested_bytes": the bytes requested by the hits.
+ *   - "reused_bytes": the bytes of the buffers reused for the hits, their
+ *     difference with "requested_bytes" is the internal fragmentation.
+ *
+ * The map is empty when there is no memory cache.
+ * */
+std::unordered_map<std::string, size_t> get_cache_info();
+
+/* Reset the counters of get_cache_info to zero. */
+void reset_cache_info();
+
 /* Set the wired size limit.
  *
  * Note, this function is only useful when using the Metal backend with
@@ -75,4 +97,21 @@ void clear_cache();
  * */
 size_t set_wired_limit(size_t limit);
 
+/* The memory of a single device.
+ *
+ * The functions above count the memory of all the devices, and setting a
+ * limit with them sets it for each device. With the versions below the
+ * counters and limits are those of the given device, which is useful when
+ * there are several GPUs. On backends with a single device they are the same
+ * as the functions above.
+ * */
+size_t get_active_memory(Device device);
+size_t get_peak_memory(Device device);
+void reset_peak_memory(Device device);
+size_t get_cache_memory(Device device);
+size_t set_memory_limit(size_t limit, Device device);
+size_t get_memory_limit(Device device);
+size_t set_cache_limit(size_t limit, Device device);
+void clear_cache(Device device);
+
 } // namespace mlx::core
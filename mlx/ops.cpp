@@ -10,6 +10,7 @@
 #include <set>
 #include <sstream>
 
+#include "mlx/backend/metal/metal.h"
 #include "mlx/fast.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
@@ -2363,6 +2364,95 @@ array topk(const array& a, int k, int axis, StreamOrDevice s /* = {}*/) {
   return slice(a_partitioned, slice_starts, slice_ends, s);
 }
 
+namespace {
+
+// Find the runs of equal sorted values with ops for the backends without a
+// Unique kernel. The values of a run are all put to its index so whichever
+// put wins is right.
+std::vector<array> unique_scatter(
+    const array& flat,
+    bool return_inverse,
+    bool return_counts,
+    StreamOrDevice s) {
+  int n = flat.size();
+  auto perm = argsort(flat, 0, s);
+  auto sorted = take_along_axis(flat, perm, 0, s);
+  auto is_new = not_equal(
+      slice(sorted, {1}, {n}, s), slice(sorted, {0}, {n - 1}, s), s);
+  auto is_first = concatenate({array({true}), is_new}, 0, s);
+  auto runs = subtract(
+      cumsum(astype(is_first, int32, s), 0, false, true, s),
+      array(1, int32),
+      s);
+  auto last = slice(sorted, {n - 1}, {n}, s);
+  std::vector<array> outputs = {
+      put_along_axis(broadcast_to(last, {n}, s), runs, sorted, 0, s),
+      add(reshape(slice(runs, {n - 1}, {n}, s), {}, s), array(1, int32), s)};
+  if (return_inverse) {
+    outputs.push_back(put_along_axis(zeros({n}, int32, s), perm, runs, 0, s));
+  }
+  if (return_counts) {
+    auto counts = zeros({n}, int32, s);
+    outputs.push_back(
+        scatter_add_axis(counts, runs, ones({n}, int32, s), 0, s));
+  }
+  return outputs;
+}
+
+} // namespace
+
+std::vector<array> unique(
+    const array& a,
+    bool return_inverse /* = false */,
+    bool return_counts /* = false */,
+    StreamOrDevice s /* = {} */) {
+  if (issubdtype(a.dtype(), complexfloating)) {
+    throw std::invalid_argument(
+        "[unique] Complex arrays are not supported as they are not ordered.");
+  }
+  if (a.size() > std::numeric_limits<int32_t>::max()) {
+    std::ostringstream msg;
+    msg << "[unique] The array of size " << a.size() << " has more than "
+        << std::numeric_limits<int32_t>::max() << " elements.";
+    throw std::invalid_argument(msg.str());
+  }
+  int n = a.size();
+  auto flat = flatten(a, s);
+  auto stream = to_stream(s);
+  std::vector<array> outputs;
+  if (n == 0) {
+    outputs = {flat, array(0, int32)};
+    if (return_inverse) {
+      outputs.push_back(zeros({0}, int32, s));
+    }
+    if (return_counts) {
+      outputs.push_back(zeros({0}, int32, s));
+    }
+  } else if (stream.device == Device::gpu && metal::is_available()) {
+    outputs = unique_scatter(flat, return_inverse, return_counts, s);
+  } else {
+    std::vector<Shape> shapes = {{n}, {}};
+    std::vector<Dtype> dtypes = {a.dtype(), int32};
+    if (return_inverse) {
+      shapes.push_back({n});
+      dtypes.push_back(int32);
+    }
+    if (return_counts) {
+      shapes.push_back({n});
+      dtypes.push_back(int32);
+    }
+    outputs = array::make_arrays(
+        std::move(shapes),
+        dtypes,
+        std::make_shared<Unique>(stream, return_inverse, return_counts),
+        {flat});
+  }
+  if (return_inverse) {
+    outputs[2] = reshape(outputs[2], a.shape(), s);
+  }
+  return outputs;
+}
+
 array logsumexp(const array& a, bool keepdims, StreamOrDevice s /* = {}*/) {
   std::vector<int> axes(a.ndim());
   std::iota(axes.begin(), axes.end(), 0);
@@ -2493,6 +2583,25 @@ array operator+(const array& a, const array& b) {
   return add(a, b);
 }
 
+array add_inplace(
+    const array& a,
+    const array& b,
+    StreamOrDevice s /* = {} */) {
+  if (broadcast_shapes(a.shape(), b.shape()) != a.shape()) {
+    std::ostringstream msg;
+    msg << "[add_inplace] Cannot broadcast the second input with shape "
+        << b.shape() << " to the shape " << a.shape() << " of the first.";
+    throw std::invalid_argument(msg.str());
+  }
+  std::vector<array> inputs = {
+      a, broadcast_to(astype(b, a.dtype(), s), a.shape(), s)};
+  return array(
+      a.shape(),
+      a.dtype(),
+      std::make_shared<Add>(to_stream(s), true),
+      std::move(inputs));
+}
+
 array subtract(const array& a, const array& b, StreamOrDevice s /* = {} */) {
   auto out_type = promote_types(a.dtype(), b.dtype());
   auto inputs =
@@ -2914,7 +3023,7 @@ array matmul(
   auto out = array(
       std::move(out_shape),
       out_type,
-      std::make_shared<Matmul>(to_stream(s)),
+      std::make_shared<Matmul>(to_stream(s), default_matmul_precision()),
       {a, b});
   if (in_a.ndim() > 2 && in_b.ndim() <= 2) {
     auto orig_shape = in_a.shape();
@@ -3373,6 +3482,88 @@ array scatter_min(
   return scatter(a, indices, updates, axes, Scatter::Min, s);
 }
 
+namespace {
+
+// Add the weights, or ones, of the values in range to their bins with a
+// scatter for the backends without a BinCount kernel.
+array bincount_scatter(
+    const std::vector<array>& inputs,
+    int length,
+    Dtype acc_type,
+    StreamOrDevice s) {
+  auto& x = inputs[0];
+  auto out = zeros({length}, acc_type, s);
+  if (length == 0 || x.size() == 0) {
+    return out;
+  }
+  auto valid = logical_and(
+      greater_equal(x, array(0, x.dtype()), s),
+      less(x, array(length, x.dtype()), s),
+      s);
+  auto updates = inputs.size() > 1 ? inputs[1] : ones(x.shape(), acc_type, s);
+  updates = where(valid, updates, array(0, acc_type), s);
+  auto bins = where(valid, x, array(0, x.dtype()), s);
+  return scatter_add_axis(out, bins, updates, 0, s);
+}
+
+} // namespace
+
+array bincount(
+    const array& x,
+    int length,
+    const std::optional<array>& weights /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  if (!issubdtype(x.dtype(), integer)) {
+    std::ostringstream msg;
+    msg << "[bincount] The input must be an integer array but got type "
+        << x.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (length < 0) {
+    std::ostringstream msg;
+    msg << "[bincount] The length must be non-negative but got " << length
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (weights && weights->shape() != x.shape()) {
+    std::ostringstream msg;
+    msg << "[bincount] The weights must have the shape of the input "
+        << x.shape() << " but got " << weights->shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  // The weights are summed in the types of 32 or 64 bits the backends
+  // can add atomically.
+  auto dtype = weights ? weights->dtype() : int32;
+  Dtype acc_type = int32;
+  if (dtype == complex64) {
+    throw std::invalid_argument(
+        "[bincount] Complex weights are not supported.");
+  } else if (dtype == float64) {
+    acc_type = float64;
+  } else if (issubdtype(dtype, floating)) {
+    acc_type = float32;
+  } else if (size_of(dtype) == 8 || dtype == uint32) {
+    acc_type = int64;
+  }
+
+  auto stream = to_stream(s);
+  std::vector<array> inputs = {flatten(x, s)};
+  if (weights) {
+    inputs.push_back(astype(flatten(*weights, s), acc_type, s));
+  }
+  array out = (stream.device == Device::gpu && metal::is_available())
+      ? bincount_scatter(inputs, length, acc_type, s)
+      : array(
+            {length},
+            acc_type,
+            std::make_shared<BinCount>(stream, length),
+            std::move(inputs));
+  if (issubdtype(dtype, floating)) {
+    out = astype(out, dtype, s);
+  }
+  return out;
+}
+
 array sqrt(const array& a, StreamOrDevice s /* = {} */) {
   auto dtype = at_least_float(a.dtype());
   return array(
@@ -4057,6 +4248,371 @@ array dequantize(
   return fast::affine_dequantize(w, scales, biases, group_size, bits, s);
 }
 
+namespace {
+
+void check_quantization_mode(
+    const char* tag,
+    const std::string& mode,
+    int group_size,
+    int bits) {
+  int expected_group_size;
+  int expected_bits;
+  if (mode == "mxfp4") {
+    expected_group_size = 32;
+    expected_bits = 4;
+  } else if (mode == "nvfp4") {
+    expected_group_size = 16;
+    expected_bits = 4;
+  } else if (mode == "mxfp8") {
+    expected_group_size = 32;
+    expected_bits = 8;
+  } else if (mode == "int8") {
+    // A single scale per row so the group size is not used.
+    expected_group_size = group_size;
+    expected_bits = 8;
+  } else {
+    std::ostringstream msg;
+    msg << "[" << tag << "] Invalid quantization mode '" << mode
+        << "', expected 'affine', 'mxfp4', 'nvfp4', 'mxfp8' or 'int8'.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (group_size != expected_group_size || bits != expected_bits) {
+    std::ostringstream msg;
+    msg << "[" << tag << "] The mode " << mode << " requires group_size="
+        << expected_group_size << " and bits=" << expected_bits
+        << " but got group_size=" << group_size << " and bits=" << bits
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+// The symmetric quantization of the rows of w to int8 with the scales
+// max(abs(row)) / 127.
+std::vector<array> int8_quantize(const array& w, StreamOrDevice s) {
+  auto w_f = astype(w, float32, s);
+  auto amax = maximum(max(abs(w_f, s), -1, true, s), array(1e-12f), s);
+  auto scales = divide(amax, array(127.0f), s);
+  auto w_q = clip(
+      round(divide(w_f, scales, s), s), array(-127.0f), array(127.0f), s);
+  return {astype(w_q, int8, s), scales};
+}
+
+} // namespace
+
+array quantized_matmul(
+    array x,
+    array w,
+    array scales,
+    std::optional<array> biases,
+    bool transpose,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    StreamOrDevice s /* = {} */) {
+  if (mode == "affine") {
+    if (!biases) {
+      throw std::invalid_argument(
+          "[quantized_matmul] The biases are required for the affine mode.");
+    }
+    return quantized_matmul(
+        std::move(x),
+        std::move(w),
+        std::move(scales),
+        std::move(*biases),
+        transpose,
+        group_size,
+        bits,
+        s);
+  }
+  check_quantization_mode("quantized_matmul", mode, group_size, bits);
+  if (biases) {
+    std::ostringstream msg;
+    msg << "[quantized_matmul] The mode " << mode << " does not use biases.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[quantized_matmul] Only real floating types are supported but "
+        << "the passed type was x.dtype() == " << x.dtype();
+    throw std::invalid_argument(msg.str());
+  }
+  if (mode == "int8") {
+    // The scales are per row of w, which are the output channels only when
+    // it is transposed.
+    if (!transpose) {
+      throw std::invalid_argument(
+          "[quantized_matmul] The int8 mode only supports transpose=true.");
+    }
+    return fast::int8_matmul(x, w, scales, s);
+  }
+  // The block scaled formats are expanded to the type of x right before the
+  // matmul, so the weights stay in their 4 or 8 bit form in memory.
+  auto w_full = fast::block_scaled_dequantize(w, scales, mode, x.dtype(), s);
+  if (transpose) {
+    w_full = swapaxes(w_full, -1, -2, s);
+  }
+  return matmul(x, w_full, s);
+}
+
+std::vector<array> quantize(
+    const array& w,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    StreamOrDevice s /* = {} */) {
+  if (mode == "affine") {
+    auto [wq, scales, biases] = fast::affine_quantize(w, group_size, bits, s);
+    return {wq, scales, biases};
+  }
+  check_quantization_mode("quantize", mode, group_size, bits);
+  if (mode == "int8") {
+    return int8_quantize(w, s);
+  }
+  auto [wq, scales] = fast::block_scaled_quantize(w, mode, s);
+  return {wq, scales};
+}
+
+array dequantize(
+    const array& w,
+    const array& scales,
+    const std::optional<array>& biases,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    std::optional<Dtype> dtype /* = std::nullopt */,
+    StreamOrDevice s /* = {} */) {
+  if (mode == "affine") {
+    if (!biases) {
+      throw std::invalid_argument(
+          "[dequantize] The biases are required for the affine mode.");
+    }
+    auto out = fast::affine_dequantize(w, scales, *biases, group_size, bits, s);
+    return dtype ? astype(out, *dtype, s) : out;
+  }
+  check_quantization_mode("dequantize", mode, group_size, bits);
+  if (biases) {
+    std::ostringstream msg;
+    msg << "[dequantize] The mode " << mode << " does not use biases.";
+    throw std::invalid_argument(msg.str());
+  }
+  if (mode == "int8") {
+    auto out_type = dtype.value_or(scales.dtype());
+    return multiply(astype(w, out_type, s), astype(scales, out_type, s), s);
+  }
+  return fast::block_scaled_dequantize(
+      w, scales, mode, dtype.value_or(bfloat16), s);
+}
+
+namespace {
+
+void check_fp8_format(const std::string& format, const std::string& tag) {
+  if (format != "e4m3" && format != "e5m2") {
+    std::ostringstream msg;
+    msg << tag << " Invalid float8 format '" << format
+        << "', expected 'e4m3' or 'e5m2'.";
+    throw std::invalid_argument(msg.str());
+  }
+}
+
+} // namespace
+
+array from_fp8(
+    array x,
+    Dtype dtype,
+    const std::string& format /* = "e4m3" */,
+    StreamOrDevice s /* = {} */) {
+  check_fp8_format(format, "[from_fp8]");
+  if (x.dtype() != uint8) {
+    std::ostringstream msg;
+    msg << "[from_fp8] Expected the float8 " << format
+        << " values as uint8 but got " << x.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (!issubdtype(dtype, floating)) {
+    std::ostringstream msg;
+    msg << "[from_fp8] Expected a floating point output type but got "
+        << dtype << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (format == "e5m2") {
+    // The e5m2 values are the high byte of the float16 values.
+    auto bits = left_shift(astype(x, uint16, s), array(8, uint16), s);
+    return astype(view(bits, float16, s), dtype, s);
+  }
+  if (to_stream(s).device == Device::gpu && metal::is_available()) {
+    // From PyTorch:
+    // https://github.com/pytorch/pytorch/blob/e3643e1e0e923f0fc063dfab6f45c956d568919d/c10/util/Float8_e4m3fn.h#L46
+    std::string source = R"(
+      uint elem = thread_position_in_grid.x;
+      uint8_t val = x[elem];
+
+      const uint32_t w = (uint32_t)val << 24;
+      const uint32_t sign = w & 0x80000000;
+      const uint32_t nonsign = w & 0x7FFFFFFF;
+
+      uint32_t renorm_shift = metal::clz(nonsign);
+      renorm_shift = renorm_shift > 4 ? renorm_shift - 4 : 0;
+
+      const int32_t inf_nan_mask =
+          ((int32_t)(nonsign + 0x01000000) >> 8) & 0x7F800000;
+      const int32_t zero_mask = (int32_t)(nonsign - 1) >> 31;
+      uint32_t result = sign |
+          ((((nonsign << renorm_shift >> 4) + ((0x78 - renorm_shift) << 23)) |
+              inf_nan_mask) &
+              ~zero_mask);
+
+      float out = *(reinterpret_cast<thread float*>(&result));
+      y[elem] = static_cast<T>(out);
+    )";
+    auto kernel = fast::metal_kernel("f8_e4m3", {"x"}, {"y"}, source);
+    auto outputs = kernel(
+        {x},
+        {x.shape()},
+        {dtype},
+        {x.size(), 1, 1},
+        {256, 1, 1},
+        {{"T", dtype}},
+        std::nullopt,
+        false,
+        s);
+    return outputs[0];
+  } else {
+    auto w = left_shift(astype(x, uint32, s), array({24}, uint32), s);
+    auto sign = bitwise_and(w, array({0x80000000}, uint32), s);
+    auto nonsign = bitwise_and(w, array({0x7FFFFFFF}, uint32), s);
+
+    // Emulate a clz op with a lookup table
+    auto clz_table =
+        array({28, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0}, uint32);
+    auto renorm_shift = take(clz_table, bitwise_and(x, array({0xf}), s), s);
+    renorm_shift = where(
+        greater(
+            bitwise_and(x, array({0x70}, uint32), s), array({0}, uint32), s),
+        array({0}, uint32),
+        renorm_shift,
+        s);
+    auto inf_nan_mask = bitwise_and(
+        right_shift(
+            astype(add(nonsign, array(0x01000000, int32), s), int32, s),
+            array({8}, int32),
+            s),
+        array({0x7F800000}, int32),
+        s);
+    auto zero_mask = right_shift(
+        astype(subtract(nonsign, array({1}, uint32), s), int32, s),
+        array({31}, int32),
+        s);
+    zero_mask = astype(zero_mask, uint32, s);
+    inf_nan_mask = astype(inf_nan_mask, uint32, s);
+    auto result =
+        add(right_shift(
+                left_shift(nonsign, renorm_shift, s), array({4}, uint32), s),
+            left_shift(
+                subtract(array({0x78}, uint32), renorm_shift, s),
+                array({23}, uint32),
+                s),
+            s);
+    result = bitwise_or(
+        sign,
+        bitwise_and(
+            bitwise_or(result, inf_nan_mask, s),
+            bitwise_invert(zero_mask, s),
+            s),
+        s);
+    result = astype(view(result, float32, s), dtype, s);
+    return result;
+  }
+}
+
+array to_fp8(
+    array x,
+    const std::string& format /* = "e4m3" */,
+    StreamOrDevice s /* = {} */) {
+  check_fp8_format(format, "[to_fp8]");
+  if (!issubdtype(x.dtype(), floating)) {
+    std::ostringstream msg;
+    msg << "[to_fp8] Expected a floating point input but got " << x.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (format == "e5m2") {
+    // From PyTorch, rounding to nearest even and overflowing to infinity:
+    // https://github.com/pytorch/pytorch/blob/e3643e1e0e923f0fc063dfab6f45c956d568919d/c10/util/Float8_e5m2.h
+    auto f_bits = view(astype(x, float32, s), uint32, s);
+    auto sign = bitwise_and(f_bits, array(0x80000000, uint32), s);
+    f_bits = bitwise_xor(f_bits, sign, s);
+
+    // The denormals are rounded by the float addition of 2^7.
+    auto denorm_mask = array(134 << 23, uint32);
+    auto denorm = subtract(
+        view(
+            add(view(f_bits, float32, s), view(denorm_mask, float32, s), s),
+            uint32,
+            s),
+        denorm_mask,
+        s);
+
+    auto mant_odd = bitwise_and(
+        right_shift(f_bits, array(21, uint32), s), array(1, uint32), s);
+    // Adds ((15 - 127) << 23) + 0xFFFFF, wrapping around.
+    auto normal = right_shift(
+        add(add(f_bits, array(0xC80FFFFF, uint32), s), mant_odd, s),
+        array(21, uint32),
+        s);
+
+    auto result = where(
+        less(f_bits, array(113 << 23, uint32), s), denorm, normal, s);
+    // The values of at least 2^16 are infinite, or NaN.
+    result = where(
+        greater_equal(f_bits, array(143 << 23, uint32), s),
+        where(
+            greater(f_bits, array(255 << 23, uint32), s),
+            array(0x7F, uint32),
+            array(0x7C, uint32),
+            s),
+        result,
+        s);
+    result = bitwise_or(result, right_shift(sign, array(24, uint32), s), s);
+    return astype(result, uint8, s);
+  }
+  // From PyTorch, rounding to nearest even and saturating to the largest
+  // finite value 448:
+  // https://github.com/pytorch/pytorch/blob/e3643e1e0e923f0fc063dfab6f45c956d568919d/c10/util/Float8_e4m3fn.h#L117
+  x = clip(astype(x, float32, s), array(-448.0f), array(448.0f), s);
+  auto f_bits = view(x, uint32, s);
+  auto sign = bitwise_and(f_bits, array(0x80000000, uint32), s);
+  f_bits = bitwise_xor(f_bits, sign, s);
+
+  // The denormals are rounded by the float addition of 2^14.
+  auto denorm_mask = array(141 << 23, uint32);
+  auto denorm = subtract(
+      view(
+          add(view(f_bits, float32, s), view(denorm_mask, float32, s), s),
+          uint32,
+          s),
+      denorm_mask,
+      s);
+
+  auto mant_odd = bitwise_and(
+      right_shift(f_bits, array(20, uint32), s), array(1, uint32), s);
+  // Adds ((7 - 127) << 23) + 0x7FFFF, wrapping around.
+  auto normal = right_shift(
+      add(add(f_bits, array(0xC407FFFF, uint32), s), mant_odd, s),
+      array(20, uint32),
+      s);
+
+  auto result = where(
+      less(f_bits, array(121 << 23, uint32), s), denorm, normal, s);
+  // Only NaN is left above the largest finite value after clipping.
+  result = where(
+      greater_equal(f_bits, array(1087 << 20, uint32), s),
+      array(0x7F, uint32),
+      result,
+      s);
+  result = bitwise_or(result, right_shift(sign, array(24, uint32), s), s);
+  return astype(result, uint8, s);
+}
+
 array gather_qmm(
     const array& x,
     const array& w,
@@ -4296,7 +4852,8 @@ array addmm(
     auto out = array(
         {a.shape(0), b.shape(1)},
         out_type,
-        std::make_shared<AddMM>(to_stream(s), alpha, beta),
+        std::make_shared<AddMM>(
+            to_stream(s), alpha, beta, default_matmul_precision()),
         {a, b, c});
     return reshape(out, out_shape, s);
   }
@@ -4352,7 +4909,8 @@ array addmm(
   auto out = array(
       std::move(out_shape),
       out_type,
-      std::make_shared<AddMM>(to_stream(s), alpha, beta),
+      std::make_shared<AddMM>(
+          to_stream(s), alpha, beta, default_matmul_precision()),
       {a, b, c});
 
   // Remove the possibly inserted singleton dimensions
@@ -4697,6 +5255,59 @@ array segmented_mm(
       {std::move(a), std::move(b), std::move(segments)});
 }
 
+array sparse_matmul(
+    const array& indptr,
+    const array& indices,
+    array values,
+    array b,
+    StreamOrDevice s /* = {} */) {
+  if (indptr.ndim() != 1 || indptr.size() == 0 || indptr.dtype() != int32) {
+    std::ostringstream msg;
+    msg << "[sparse_matmul] The row offsets must be a non empty 1D int32 "
+        << "array but got shape " << indptr.shape() << " and type "
+        << indptr.dtype() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (indices.ndim() != 1 || indices.dtype() != int32) {
+    std::ostringstream msg;
+    msg << "[sparse_matmul] The column indices must be a 1D int32 array but "
+        << "got shape " << indices.shape() << " and type " << indices.dtype()
+        << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (values.shape() != indices.shape()) {
+    std::ostringstream msg;
+    msg << "[sparse_matmul] The values must have the shape of the indices "
+        << indices.shape() << " but got " << values.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  if (b.ndim() != 2) {
+    std::ostringstream msg;
+    msg << "[sparse_matmul] The dense matrix must be 2D but got shape "
+        << b.shape() << ".";
+    throw std::invalid_argument(msg.str());
+  }
+
+  auto out_type = result_type(values, b);
+  if (!issubdtype(out_type, floating)) {
+    std::ostringstream msg;
+    msg << "[sparse_matmul] Only real floating point types are supported but "
+        << values.dtype() << " and " << b.dtype()
+        << " were provided which results in " << out_type
+        << ", which is not a real floating point type.";
+    throw std::invalid_argument(msg.str());
+  }
+  values = astype(values, out_type, s);
+  b = astype(b, out_type, s);
+
+  Shape out_shape = {indptr.shape(0) - 1, b.shape(1)};
+  return array(
+      std::move(out_shape),
+      out_type,
+      std::make_shared<SparseMatmul>(to_stream(s)),
+      {indptr, indices, std::move(values), std::move(b)});
+}
+
 array diagonal(
     const array& a,
     int offset /* = 0 */,
@@ -4854,6 +5465,30 @@ std::vector<array> depends(
       all_inputs);
 }
 
+std::vector<array> host_callback(
+    std::function<std::vector<array>(const std::vector<array>&)> fn,
+    const std::vector<array>& inputs,
+    std::vector<Shape> output_shapes,
+    const std::vector<Dtype>& output_dtypes,
+    StreamOrDevice s /* = {} */) {
+  if (output_shapes.empty() || output_shapes.size() != output_dtypes.size()) {
+    std::ostringstream msg;
+    msg << "[host_callback] Expected as many output shapes as output types "
+        << "and at least one but got " << output_shapes.size()
+        << " shapes and " << output_dtypes.size() << " types.";
+    throw std::invalid_argument(msg.str());
+  }
+  auto stream = to_stream(s, Device::cpu);
+  if (stream.device != Device::cpu) {
+    throw std::invalid_argument("[host_callback] Must run on a CPU stream.");
+  }
+  return array::make_arrays(
+      std::move(output_shapes),
+      output_dtypes,
+      std::make_shared<HostCallback>(stream, std::move(fn)),
+      inputs);
+}
+
 array atleast_1d(const array& a, StreamOrDevice s /* = {} */) {
   if (a.ndim() == 0) {
     return reshape(a, {1}, s);
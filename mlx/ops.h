@@ -715,6 +715,22 @@ array topk(const array& a, int k, StreamOrDevice s = {});
 /** Returns topk elements of the array along a given axis. */
 array topk(const array& a, int k, int axis, StreamOrDevice s = {});
 
+/**
+ * The sorted unique values of the flattened array with the number of unique
+ * values, followed by the indices of the values of ``a`` in them if
+ * ``return_inverse`` and by their counts if ``return_counts``. The number
+ * of unique values depends on the data, so the values and counts have the
+ * size of ``a``: the first ``num_unique`` are the unique ones and the rest
+ * repeat the largest value with a count of 0. The number of unique values
+ * and the inverse, of the shape of ``a``, and counts are int32. NaNs are
+ * all unique.
+ */
+std::vector<array> unique(
+    const array& a,
+    bool return_inverse = false,
+    bool return_counts = false,
+    StreamOrDevice s = {});
+
 /** Cumulative logsumexp of an array. */
 array logcumsumexp(
     const array& a,
@@ -779,6 +795,14 @@ array operator+(const array& a, T b) {
   return add(a, array(b));
 }
 
+/**
+ * Add two arrays writing the result over the buffer of the first one. The
+ * second array is broadcast and cast to the first. The evaluation throws
+ * when the buffer of the first array can't be donated, for instance if it
+ * is still referenced by other arrays.
+ **/
+array add_inplace(const array& a, const array& b, StreamOrDevice s = {});
+
 /** Subtract two arrays. */
 array subtract(const array& a, const array& b, StreamOrDevice s = {});
 array operator-(const array& a, const array& b);
@@ -1160,6 +1184,19 @@ inline array scatter_min(
   return scatter_min(a, {indices}, updates, std::vector<int>{axis}, s);
 }
 
+/**
+ * Count the occurrences of the values of the integer array ``x`` in the
+ * ``length`` bins [0, length), or sum the ``weights`` of the same shape in
+ * them. The values out of the range are ignored. The counts are int32, the
+ * floating point weights are summed in float32 (float64 for float64) and
+ * the integer weights in int32 (int64 when they may not fit).
+ */
+array bincount(
+    const array& x,
+    int length,
+    const std::optional<array>& weights = std::nullopt,
+    StreamOrDevice s = {});
+
 /** Square root the elements of an array. */
 array sqrt(const array& a, StreamOrDevice s = {});
 
@@ -1344,6 +1381,64 @@ array dequantize(
     int bits = 4,
     StreamOrDevice s = {});
 
+/**
+ * Quantized matmul with the quantization |mode|, one of "affine", "mxfp4",
+ * "nvfp4", "mxfp8" or "int8". The biases are only given for "affine". The
+ * "int8" mode also quantizes the rows of x, see fast::int8_matmul.
+ */
+array quantized_matmul(
+    array x,
+    array w,
+    array scales,
+    std::optional<array> biases,
+    bool transpose,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    StreamOrDevice s = {});
+
+/**
+ * Quantize a matrix along its last axis with the quantization |mode|. Returns
+ * the packed matrix and the scales, followed by the biases for "affine".
+ */
+std::vector<array> quantize(
+    const array& w,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    StreamOrDevice s = {});
+
+/** Dequantize a matrix produced by quantize() with the quantization |mode| */
+array dequantize(
+    const array& w,
+    const array& scales,
+    const std::optional<array>& biases,
+    int group_size,
+    int bits,
+    const std::string& mode,
+    std::optional<Dtype> dtype = std::nullopt,
+    StreamOrDevice s = {});
+
+/**
+ * Convert float8 values, stored as uint8, to the floating point type
+ * `dtype`. The `format` is "e4m3" or "e5m2".
+ */
+array from_fp8(
+    array x,
+    Dtype dtype,
+    const std::string& format = "e4m3",
+    StreamOrDevice s = {});
+
+/**
+ * Convert a floating point array to float8 values stored as uint8. The
+ * "e4m3" values saturate at the largest finite value 448, and the "e5m2"
+ * values overflow to infinity past 57344.
+ */
+array to_fp8(
+    array x,
+    const std::string& format = "e4m3",
+    StreamOrDevice s = {});
+
 /** Compute matrix products with matrix-level gather. */
 array gather_qmm(
     const array& x,
@@ -1412,6 +1507,19 @@ array gather_mm(
  */
 array segmented_mm(array a, array b, array segments, StreamOrDevice s = {});
 
+/**
+ * Multiply the sparse matrix given in the compressed sparse row format by the
+ * dense matrix b. The columns of the nonzero elements of the row i are
+ * ``indices[indptr[i]:indptr[i + 1]]`` and their values are at the same
+ * positions in ``values``.
+ */
+array sparse_matmul(
+    const array& indptr,
+    const array& indices,
+    array values,
+    array b,
+    StreamOrDevice s = {});
+
 /** Extract a diagonal or construct a diagonal array */
 array diagonal(
     const array& a,
@@ -1448,6 +1556,23 @@ std::vector<array> depends(
     const std::vector<array>& inputs,
     const std::vector<array>& dependencies);
 
+/**
+ * Call the host function ``fn`` with the computed ``inputs`` on a CPU
+ * stream and return its arrays as lazy outputs of the given shapes and
+ * types. The streams of the other devices only wait for the callback when
+ * they use its outputs. The function runs on the thread of the stream, it
+ * must return available arrays, such as arrays made from host data, and
+ * must not evaluate arrays. When it throws or returns arrays of other
+ * shapes or types, the error is thrown by the next wait for an evaluation
+ * and the outputs are NaNs, or zeros for the types without NaN.
+ */
+std::vector<array> host_callback(
+    std::function<std::vector<array>(const std::vector<array>&)> fn,
+    const std::vector<array>& inputs,
+    std::vector<Shape> output_shapes,
+    const std::vector<Dtype>& output_dtypes,
+    StreamOrDevice s = {});
+
 /** convert an array to an atleast ndim array */
 array atleast_1d(const array& a, StreamOrDevice s = {});
 std::vector<array> atleast_1d(
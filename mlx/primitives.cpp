@@ -11,6 +11,7 @@
 #include <stdexcept>
 
 #include "mlx/backend/common/utils.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/fft.h"
 #include "mlx/linalg.h"
 #include "mlx/ops.h"
@@ -269,11 +270,17 @@ std::pair<std::vector<array>, std::vector<int>> Add::vmap(
   return {{add(a, b, stream())}, {to_ax}};
 }
 
+bool Add::is_equivalent(const Primitive& other) const {
+  return inplace_ == static_cast<const Add&>(other).inplace_;
+}
+
 std::vector<array> AddMM::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
     const std::vector<int>& argnums,
     const std::vector<array>&) {
+  // The matmuls of the gradients keep the precision
+  MatmulPrecisionContext ctx(precision_);
   std::vector<array> vjps;
   auto& cotan = cotangents[0];
   std::vector<int> reorder(cotan.ndim());
@@ -314,6 +321,7 @@ std::vector<array> AddMM::jvp(
     const std::vector<array>& primals,
     const std::vector<array>& tangents,
     const std::vector<int>& argnums) {
+  MatmulPrecisionContext ctx(precision_);
   std::vector<array> jvp;
   for (int i = 0; i < argnums.size(); ++i) {
     auto arg = argnums[i];
@@ -342,7 +350,9 @@ std::vector<array> AddMM::jvp(
 
 bool AddMM::is_equivalent(const Primitive& other) const {
   const AddMM& a_other = static_cast<const AddMM&>(other);
-  return (alpha_ == a_other.alpha_ && beta_ == a_other.beta_);
+  return (
+      alpha_ == a_other.alpha_ && beta_ == a_other.beta_ &&
+      precision_ == a_other.precision_);
 }
 
 std::pair<std::vector<array>, std::vector<int>> AddMM::vmap(
@@ -354,6 +364,7 @@ std::pair<std::vector<array>, std::vector<int>> AddMM::vmap(
   auto a = maybe_move_ax(inputs[0], axes[0]);
   auto b = maybe_move_ax(inputs[1], axes[1]);
   auto c = maybe_move_ax(inputs[2], axes[2]);
+  MatmulPrecisionContext ctx(precision_);
   return {{addmm(c, a, b, alpha_, beta_, stream())}, {0}};
 }
 
@@ -738,6 +749,60 @@ bool AsStrided::is_equivalent(const Primitive& other) const {
       offset_ == a_other.offset_;
 }
 
+std::vector<array> BinCount::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  if (argnums.size() != 1 || argnums[0] != 1) {
+    throw std::invalid_argument(
+        "[BinCount] Cannot calculate JVP with respect to the input.");
+  }
+  auto& tangent = tangents[0];
+  return {array(
+      {length_},
+      tangent.dtype(),
+      std::make_shared<BinCount>(stream(), length_),
+      {primals[0], tangent})};
+}
+
+std::vector<array> BinCount::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  auto& x = primals[0];
+  auto& cotan = cotangents[0];
+  std::vector<array> vjps;
+  for (auto arg : argnums) {
+    if (arg != 1) {
+      throw std::invalid_argument(
+          "[BinCount] Cannot calculate VJP with respect to the input.");
+    }
+    // Each weight gets the cotangent of its bin, zero when out of range.
+    auto& weights = primals[1];
+    if (length_ == 0) {
+      vjps.push_back(zeros_like(weights, stream()));
+      continue;
+    }
+    auto valid = logical_and(
+        greater_equal(x, array(0, x.dtype()), stream()),
+        less(x, array(length_, x.dtype()), stream()),
+        stream());
+    auto bins = where(valid, x, array(0, x.dtype()), stream());
+    vjps.push_back(where(
+        valid,
+        take(cotan, bins, stream()),
+        array(0, cotan.dtype()),
+        stream()));
+  }
+  return vjps;
+}
+
+bool BinCount::is_equivalent(const Primitive& other) const {
+  const BinCount& b_other = static_cast<const BinCount&>(other);
+  return length_ == b_other.length_;
+}
+
 bool BitwiseBinary::is_equivalent(const Primitive& other) const {
   const BitwiseBinary& a_other = static_cast<const BitwiseBinary&>(other);
   return op_ == a_other.op_;
@@ -1149,7 +1214,7 @@ bool Contiguous::is_equivalent(const Primitive& other) const {
 
 array conv_weight_backward_patches(
     const array& in,
-    const array& wt,
+    const Shape& wt_shape,
     const array& cotan,
     const std::vector<int>& kernel_strides,
     const std::vector<int>& padding_lo,
@@ -1191,7 +1256,7 @@ array conv_weight_backward_patches(
   // (batch_dim, out_spatial_dims, weight_spatial_dims, in_channels)
   Shape patches_shape{cotan.shape().begin(), cotan.shape().end() - 1};
   patches_shape.insert(
-      patches_shape.end(), wt.shape().begin() + 1, wt.shape().end());
+      patches_shape.end(), wt_shape.begin() + 1, wt_shape.end());
 
   // Resolve patch strides
   int n_spatial_dim = in.ndim() - 2;
@@ -1208,170 +1273,240 @@ array conv_weight_backward_patches(
   auto in_patches = as_strided(in_padded, patches_shape, patches_strides, 0, s);
 
   // Prepare for matmul
-  int O = wt.shape(0);
+  int O = wt_shape[0];
   auto cotan_mat = reshape(cotan, {-1, O}, s);
   in_patches = reshape(in_patches, {cotan_mat.shape(0), -1}, s);
 
   auto grad = matmul(transpose(cotan_mat, {1, 0}, s), in_patches, s);
-  grad = reshape(grad, wt.shape(), s);
+  grad = reshape(grad, wt_shape, s);
   return grad;
 }
 
-std::vector<array> Convolution::vjp(
-    const std::vector<array>& primals,
-    const std::vector<array>& cotangents,
-    const std::vector<int>& argnums,
-    const std::vector<array>&) {
-  assert(primals.size() == 2);
-  std::vector<array> grads;
-
-  // Collect info
-  auto& in = primals[0];
-  auto& wt = primals[1];
-  auto& cotan = cotangents[0];
-
-  auto group_transpose =
-      [this](const array& x, int group_dim, int ax_a, int ax_b) {
-        if (groups_ > 1) {
-          auto shape = x.shape();
-          if (group_dim < 0) {
-            group_dim += shape.size();
-          }
-          shape.insert(shape.begin() + group_dim, groups_);
-          shape[group_dim + 1] = shape[group_dim + 1] / groups_;
-          auto x_trans = swapaxes(
-              reshape(x, std::move(shape), stream()), ax_a, ax_b, stream());
-          return flatten(x_trans, group_dim, group_dim + 1, stream());
-        } else {
-          return swapaxes(x, 0, -1, stream());
-        }
-      };
+namespace {
 
-  for (int a : argnums) {
-    // Grads for input
-    if (a == 0) {
-      std::vector<int> padding_lo = padding_lo_;
-      std::vector<int> padding_hi = padding_hi_;
-
-      for (int i = 0; i < padding_lo.size(); ++i) {
-        int wt_size = 1 + kernel_dilation_[i] * (wt.shape(1 + i) - 1);
-        padding_lo[i] = wt_size - padding_lo_[i] - 1;
-
-        int in_size = 1 + input_dilation_[i] * (in.shape(1 + i) - 1);
-        int out_size = 1 + kernel_strides_[i] * (cotan.shape(1 + i) - 1);
-        padding_hi[i] = in_size - out_size + padding_hi_[i];
-      }
+array conv_group_transpose(
+    const array& x,
+    int groups,
+    int group_dim,
+    int ax_a,
+    int ax_b,
+    StreamOrDevice s) {
+  if (groups > 1) {
+    auto shape = x.shape();
+    if (group_dim < 0) {
+      group_dim += shape.size();
+    }
+    shape.insert(shape.begin() + group_dim, groups);
+    shape[group_dim + 1] = shape[group_dim + 1] / groups;
+    auto x_trans = swapaxes(reshape(x, std::move(shape), s), ax_a, ax_b, s);
+    return flatten(x_trans, group_dim, group_dim + 1, s);
+  } else {
+    return swapaxes(x, 0, -1, s);
+  }
+}
 
-      // Check for negative padding
-      bool has_neg_padding = false;
-      for (auto& pd : padding_lo) {
-        has_neg_padding |= (pd < 0);
-      }
-      for (auto& pd : padding_hi) {
-        has_neg_padding |= (pd < 0);
+// The gradient of the input of a convolution as a convolution of the
+// gradient of its output with the transposed weight.
+array conv_input_grad(
+    const array& cotan,
+    const array& wt,
+    const Shape& in_shape,
+    const std::vector<int>& kernel_strides,
+    const std::vector<int>& padding_lo_,
+    const std::vector<int>& padding_hi_,
+    const std::vector<int>& kernel_dilation,
+    const std::vector<int>& input_dilation,
+    int groups,
+    bool flip,
+    StreamOrDevice s) {
+  std::vector<int> padding_lo = padding_lo_;
+  std::vector<int> padding_hi = padding_hi_;
+
+  for (int i = 0; i < padding_lo.size(); ++i) {
+    int wt_size = 1 + kernel_dilation[i] * (wt.shape(1 + i) - 1);
+    padding_lo[i] = wt_size - padding_lo_[i] - 1;
+
+    int in_size = 1 + input_dilation[i] * (in_shape[1 + i] - 1);
+    int out_size = 1 + kernel_strides[i] * (cotan.shape(1 + i) - 1);
+    padding_hi[i] = in_size - out_size + padding_hi_[i];
+  }
+
+  // Check for negative padding
+  bool has_neg_padding = false;
+  for (auto& pd : padding_lo) {
+    has_neg_padding |= (pd < 0);
+  }
+  for (auto& pd : padding_hi) {
+    has_neg_padding |= (pd < 0);
+  }
+
+  auto wt_trans = conv_group_transpose(wt, groups, 0, 1, -1, s);
+  auto grad = conv_general(
+      /* const array& input = */ cotan,
+      /* const array& weight = */ wt_trans,
+      /* std::vector<int> stride = */ input_dilation,
+      /* std::vector<int> padding_lo = */ padding_lo,
+      /* std::vector<int> padding_hi = */ padding_hi,
+      /* std::vector<int> kernel_dilation = */ kernel_dilation,
+      /* std::vector<int> input_dilation = */ kernel_strides,
+      /* int groups = */ groups,
+      /* bool flip = */ !flip,
+      s);
+
+  // Handle negative padding
+  if (has_neg_padding) {
+    Shape starts(grad.ndim(), 0);
+    auto stops = grad.shape();
+
+    for (int i = 0; i < grad.ndim() - 2; i++) {
+      if (padding_lo[i] < 0) {
+        starts[i + 1] -= padding_lo[i];
+        padding_lo[i] = 0;
       }
 
-      auto padding_lo_ = std::vector<int>(padding_lo);
-      auto padding_hi_ = std::vector<int>(padding_hi);
-
-      // Use negative padding on the gradient output
-      if (has_neg_padding) {
-        for (auto& p : padding_lo_) {
-          p = std::max(0, p);
-        }
-        for (auto& p : padding_hi_) {
-          p = std::max(0, p);
-        }
+      if (padding_hi[i] < 0) {
+        stops[i + 1] += padding_hi[i];
+        padding_hi[i] = 0;
       }
+    }
 
-      auto wt_trans = group_transpose(wt, 0, 1, -1);
-      auto grad = conv_general(
-          /* const array& input = */ cotan,
-          /* const array& weight = */ wt_trans,
-          /* std::vector<int> stride = */ input_dilation_,
-          /* std::vector<int> padding_lo = */ padding_lo,
-          /* std::vector<int> padding_hi = */ padding_hi,
-          /* std::vector<int> kernel_dilation = */ kernel_dilation_,
-          /* std::vector<int> input_dilation = */ kernel_strides_,
-          /* int groups = */ groups_,
-          /* bool flip = */ !flip_,
-          stream());
-
-      // Handle negative padding
-      if (has_neg_padding) {
-        Shape starts(grad.ndim(), 0);
-        auto stops = grad.shape();
-
-        for (int i = 0; i < grad.ndim() - 2; i++) {
-          if (padding_lo[i] < 0) {
-            starts[i + 1] -= padding_lo[i];
-            padding_lo[i] = 0;
-          }
+    grad = slice(grad, std::move(starts), std::move(stops), s);
+  }
 
-          if (padding_hi[i] < 0) {
-            stops[i + 1] += padding_hi[i];
-            padding_hi[i] = 0;
-          }
-        }
+  return grad;
+}
 
-        grad = slice(grad, std::move(starts), std::move(stops), stream());
+// The gradient of the weight of a convolution, with the patches of the
+// input when possible and as a convolution of the transposed input with
+// the transposed gradient of the output otherwise.
+array conv_weight_grad(
+    const array& cotan,
+    const array& in,
+    const Shape& wt_shape,
+    const std::vector<int>& kernel_strides,
+    const std::vector<int>& padding_lo,
+    const std::vector<int>& padding_hi_,
+    const std::vector<int>& kernel_dilation,
+    const std::vector<int>& input_dilation,
+    int groups,
+    bool flip,
+    StreamOrDevice s) {
+  bool no_dilation = true;
+
+  for (int i = 0; i < input_dilation.size(); i++) {
+    no_dilation &= (input_dilation[i] == 1) && (kernel_dilation[i] == 1);
+  }
+
+  if (no_dilation && !flip && groups == 1) {
+    return conv_weight_backward_patches(
+        in, wt_shape, cotan, kernel_strides, padding_lo, padding_hi_, s);
+  }
+
+  auto padding_hi = padding_lo;
+
+  for (int i = 0; i < padding_hi.size(); ++i) {
+    int in_size = 1 + input_dilation[i] * (in.shape(1 + i) - 1);
+    int out_size = 1 + kernel_strides[i] * (cotan.shape(1 + i) - 1);
+    int wt_size = 1 + kernel_dilation[i] * (wt_shape[1 + i] - 1);
+    padding_hi[i] = out_size - in_size + wt_size - padding_hi[i] - 1;
+  }
+
+  auto cotan_trans = swapaxes(cotan, 0, -1, s);
+  auto in_trans = conv_group_transpose(in, groups, -1, 0, -1, s);
+
+  auto grad_trans = conv_general(
+      /* const array& input = */ in_trans,
+      /* const array& weight = */ cotan_trans,
+      /* std::vector<int> stride = */ kernel_dilation,
+      /* std::vector<int> padding_lo = */ padding_lo,
+      /* std::vector<int> padding_hi = */ padding_hi,
+      /* std::vector<int> kernel_dilation = */ kernel_strides,
+      /* std::vector<int> input_dilation = */ input_dilation,
+      /* int groups = */ groups,
+      /* bool flip = */ false,
+      s);
+  if (flip) {
+    auto start = Shape(grad_trans.ndim(), 0);
+    auto stop = Shape(grad_trans.ndim(), 0);
+    auto strides = Shape(grad_trans.ndim(), 1);
+    for (int i = 0; i < stop.size(); ++i) {
+      if (i >= 1 && i < stop.size() - 1) {
+        start[i] = grad_trans.shape(i);
+        stop[i] = -start[i] - 1;
+        strides[i] = -1;
+      } else {
+        stop[i] = grad_trans.shape(i);
       }
-
-      grads.push_back(grad);
     }
-    // Grads for weight
-    else if (a == 1) {
-      bool no_dilation = true;
+    grad_trans = slice(grad_trans, start, stop, strides, s);
+  }
+  return swapaxes(grad_trans, 0, -1, s);
+}
 
-      for (int i = 0; i < input_dilation_.size(); i++) {
-        no_dilation &= (input_dilation_[i] == 1) && (kernel_dilation_[i] == 1);
-      }
+} // namespace
 
-      if (no_dilation && !flip_ && groups_ == 1) {
-        auto grad = conv_weight_backward_patches(
-            in, wt, cotan, kernel_strides_, padding_lo_, padding_hi_, stream());
-        grads.push_back(grad);
-      } else {
-        auto padding_hi = padding_lo_;
+std::vector<array> Convolution::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  assert(primals.size() == 2);
+  std::vector<array> grads;
 
-        for (int i = 0; i < padding_hi.size(); ++i) {
-          int in_size = 1 + input_dilation_[i] * (in.shape(1 + i) - 1);
-          int out_size = 1 + kernel_strides_[i] * (cotan.shape(1 + i) - 1);
-          int wt_size = 1 + kernel_dilation_[i] * (wt.shape(1 + i) - 1);
-          padding_hi[i] = out_size - in_size + wt_size - padding_hi[i] - 1;
-        }
+  // Collect info
+  auto& in = primals[0];
+  auto& wt = primals[1];
+  auto s = stream();
+  auto cotan = astype(cotangents[0], in.dtype(), s);
 
-        auto cotan_trans = swapaxes(cotan, 0, -1, stream());
-        auto in_trans = group_transpose(in, -1, 0, -1);
-
-        auto grad_trans = conv_general(
-            /* const array& input = */ in_trans,
-            /* const array& weight = */ cotan_trans,
-            /* std::vector<int> stride = */ kernel_dilation_,
-            /* std::vector<int> padding_lo = */ padding_lo_,
-            /* std::vector<int> padding_hi = */ padding_hi,
-            /* std::vector<int> kernel_dilation = */ kernel_strides_,
-            /* std::vector<int> input_dilation = */ input_dilation_,
-            /* int groups = */ groups_,
-            /* bool flip = */ false,
-            stream());
-        if (flip_) {
-          auto start = Shape(grad_trans.ndim(), 0);
-          auto stop = Shape(grad_trans.ndim(), 0);
-          auto strides = Shape(grad_trans.ndim(), 1);
-          for (int i = 0; i < stop.size(); ++i) {
-            if (i >= 1 && i < stop.size() - 1) {
-              start[i] = grad_trans.shape(i);
-              stop[i] = -start[i] - 1;
-              strides[i] = -1;
-            } else {
-              stop[i] = grad_trans.shape(i);
-            }
-          }
-          grad_trans = slice(grad_trans, start, stop, strides, stream());
-        }
-        grads.push_back(swapaxes(grad_trans, 0, -1, stream()));
-      }
+  // The gradients are computed by a backend kernel when there is one, the
+  // fallback copies the parameters so it does not refer to this primitive.
+  for (int a : argnums) {
+    bool weight_grad = a == 1;
+    auto& other = weight_grad ? in : wt;
+    auto& shape = weight_grad ? wt.shape() : in.shape();
+    auto fallback = [weight_grad,
+                     shape,
+                     kernel_strides = kernel_strides_,
+                     padding_lo = padding_lo_,
+                     padding_hi = padding_hi_,
+                     kernel_dilation = kernel_dilation_,
+                     input_dilation = input_dilation_,
+                     groups = groups_,
+                     flip = flip_,
+                     s](const std::vector<array>& inputs) {
+      auto grad_fn = weight_grad ? conv_weight_grad : conv_input_grad;
+      return std::vector<array>{grad_fn(
+          inputs[0],
+          inputs[1],
+          shape,
+          kernel_strides,
+          padding_lo,
+          padding_hi,
+          kernel_dilation,
+          input_dilation,
+          groups,
+          flip,
+          s)};
+    };
+    if (fast::ConvolutionVJP::use_fallback(s)) {
+      grads.push_back(fallback({cotan, other})[0]);
+    } else {
+      grads.push_back(array(
+          shape,
+          in.dtype(),
+          std::make_shared<fast::ConvolutionVJP>(
+              s,
+              fallback,
+              weight_grad,
+              kernel_strides_,
+              padding_lo_,
+              padding_hi_,
+              kernel_dilation_,
+              input_dilation_,
+              groups_,
+              flip_),
+          {cotan, other}));
     }
   }
 
@@ -2017,6 +2152,12 @@ std::vector<Shape> Unflatten::output_shapes(const std::vector<array>& inputs) {
   return {Unflatten::output_shape(inputs[0], axis_, shape_)};
 }
 
+bool Unique::is_equivalent(const Primitive& other) const {
+  const auto& u_other = static_cast<const Unique&>(other);
+  return return_inverse_ == u_other.return_inverse_ &&
+      return_counts_ == u_other.return_counts_;
+}
+
 std::pair<std::vector<array>, std::vector<int>> FFT::vmap(
     const std::vector<array>& inputs,
     const std::vector<int>& axes) {
@@ -2763,6 +2904,8 @@ std::vector<array> Matmul::vjp(
     const std::vector<array>& cotangents,
     const std::vector<int>& argnums,
     const std::vector<array>&) {
+  // The matmuls of the gradients keep the precision
+  MatmulPrecisionContext ctx(precision_);
   std::vector<array> vjps;
   auto& cotan = cotangents[0];
   std::vector<int> reorder(cotan.ndim());
@@ -2790,6 +2933,7 @@ std::vector<array> Matmul::jvp(
     const std::vector<array>& primals,
     const std::vector<array>& tangents,
     const std::vector<int>& argnums) {
+  MatmulPrecisionContext ctx(precision_);
   std::vector<array> jvp;
   for (int i = 0; i < argnums.size(); ++i) {
     auto arg = argnums[i];
@@ -2814,9 +2958,14 @@ std::pair<std::vector<array>, std::vector<int>> Matmul::vmap(
   };
   auto a = maybe_move_ax(inputs[0], axes[0]);
   auto b = maybe_move_ax(inputs[1], axes[1]);
+  MatmulPrecisionContext ctx(precision_);
   return {{matmul(a, b, stream())}, {0}};
 }
 
+bool Matmul::is_equivalent(const Primitive& other) const {
+  return precision_ == static_cast<const Matmul&>(other).precision_;
+}
+
 std::vector<Shape> Matmul::output_shapes(const std::vector<array>& inputs) {
   auto out_shape = inputs[0].shape();
   out_shape.back() = inputs[1].shape(-1);
@@ -5245,6 +5394,93 @@ bool BlockMaskedMM::is_equivalent(const Primitive& other) const {
   return (block_size_ == a_other.block_size_);
 }
 
+namespace {
+
+// The row of each of the |nnz| nonzero elements of the sparse matrix whose
+// rows start at |indptr|, which counts the rows starting at or before it.
+array sparse_rows(const array& indptr, int nnz, Stream s) {
+  int M = indptr.size() - 1;
+  if (M <= 1) {
+    return zeros({nnz}, int32, s);
+  }
+  auto starts = slice(indptr, {1}, {M}, s);
+  auto marks = scatter_add_axis(
+      zeros({nnz + 1}, int32, s), starts, ones({M - 1}, int32, s), 0, s);
+  return slice(cumsum(marks, 0, false, true, s), {0}, {nnz}, s);
+}
+
+} // namespace
+
+std::vector<array> SparseMatmul::jvp(
+    const std::vector<array>& primals,
+    const std::vector<array>& tangents,
+    const std::vector<int>& argnums) {
+  if (transpose_) {
+    throw std::invalid_argument(
+        "[SparseMatmul] Cannot calculate the JVP of the transposed product.");
+  }
+  auto& indptr = primals[0];
+  auto& indices = primals[1];
+  std::optional<array> jvp;
+  for (int i = 0; i < argnums.size(); ++i) {
+    auto arg = argnums[i];
+    if (arg < 2) {
+      throw std::invalid_argument(
+          "[SparseMatmul] Cannot calculate JVP with respect to indices.");
+    }
+    auto t = arg == 2
+        ? sparse_matmul(indptr, indices, tangents[i], primals[3], stream())
+        : sparse_matmul(indptr, indices, primals[2], tangents[i], stream());
+    jvp = jvp ? add(*jvp, t, stream()) : t;
+  }
+  return {*jvp};
+}
+
+std::vector<array> SparseMatmul::vjp(
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<int>& argnums,
+    const std::vector<array>&) {
+  std::vector<array> vjps;
+  auto& cotan = cotangents[0];
+  auto& indptr = primals[0];
+  auto& indices = primals[1];
+  auto& values = primals[2];
+  auto& b = primals[3];
+  for (auto arg : argnums) {
+    if (arg == 2) {
+      // The gradient of a value is the dot product of the row of the
+      // cotangent and the row of b it multiplied.
+      auto rows = sparse_rows(indptr, indices.size(), stream());
+      auto& cotan_rows = transpose_ ? indices : rows;
+      auto& b_rows = transpose_ ? rows : indices;
+      vjps.push_back(sum(
+          multiply(
+              take(cotan, cotan_rows, 0, stream()),
+              take(b, b_rows, 0, stream()),
+              stream()),
+          -1,
+          false,
+          stream()));
+    } else if (arg == 3) {
+      vjps.push_back(array(
+          b.shape(),
+          b.dtype(),
+          std::make_shared<SparseMatmul>(stream(), !transpose_),
+          {indptr, indices, values, cotan}));
+    } else {
+      throw std::invalid_argument(
+          "[SparseMatmul] Cannot calculate VJP with respect to indices.");
+    }
+  }
+  return vjps;
+}
+
+bool SparseMatmul::is_equivalent(const Primitive& other) const {
+  const SparseMatmul& s_other = static_cast<const SparseMatmul&>(other);
+  return transpose_ == s_other.transpose_;
+}
+
 std::vector<array> Transpose::vjp(
     const std::vector<array>& primals,
     const std::vector<array>& cotangents,
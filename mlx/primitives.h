@@ -8,6 +8,7 @@
 #include "mlx/device.h"
 #include "mlx/io/load.h"
 #include "mlx/stream.h"
+#include "mlx/utils.h"
 
 #define DEFINE_VMAP()                                                 \
   virtual std::pair<std::vector<array>, std::vector<int>> vmap(       \
@@ -59,6 +60,14 @@ class Primitive {
     return stream_;
   }
 
+  /**
+   * Move the primitive to another stream before it is scheduled. All the
+   * arrays which share the primitive then run on that stream.
+   */
+  void set_stream(Stream stream) {
+    stream_ = stream;
+  }
+
   /**
    * A primitive must know how to evaluate itself on
    * the CPU/GPU for the given inputs and populate the output arrays.
@@ -167,7 +176,8 @@ class Abs : public UnaryPrimitive {
 
 class Add : public UnaryPrimitive {
  public:
-  explicit Add(Stream stream) : UnaryPrimitive(stream) {}
+  explicit Add(Stream stream, bool inplace = false)
+      : UnaryPrimitive(stream), inplace_(inplace) {}
 
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
@@ -175,14 +185,30 @@ class Add : public UnaryPrimitive {
   DEFINE_VMAP()
   DEFINE_GRADS()
   DEFINE_NAME(Add)
-  DEFINE_DEFAULT_IS_EQUIVALENT()
   DEFINE_INPUT_OUTPUT_SHAPE()
+
+  bool is_equivalent(const Primitive& other) const override;
+
+  /** The output must be written over the buffer of the first input. */
+  bool inplace() const {
+    return inplace_;
+  }
+
+ private:
+  bool inplace_;
 };
 
 class AddMM : public UnaryPrimitive {
  public:
-  explicit AddMM(Stream stream, float alpha, float beta)
-      : UnaryPrimitive(stream), alpha_(alpha), beta_(beta) {}
+  explicit AddMM(
+      Stream stream,
+      float alpha,
+      float beta,
+      MatmulPrecision precision = MatmulPrecision::Default)
+      : UnaryPrimitive(stream),
+        alpha_(alpha),
+        beta_(beta),
+        precision_(precision) {}
 
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
@@ -192,13 +218,18 @@ class AddMM : public UnaryPrimitive {
   DEFINE_NAME(AddMM)
 
   bool is_equivalent(const Primitive& other) const override;
-  std::pair<float, float> state() const {
-    return {alpha_, beta_};
+  std::tuple<float, float, MatmulPrecision> state() const {
+    return {alpha_, beta_, precision_};
   };
 
+  MatmulPrecision precision() const {
+    return precision_;
+  }
+
  private:
   const float alpha_;
   const float beta_;
+  MatmulPrecision precision_;
 };
 
 class Arange : public UnaryPrimitive {
@@ -437,6 +468,30 @@ class AsStrided : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+/**
+ * Count the occurrences of each value of the flattened integer input in
+ * [0, length), or sum the weights given as the second input. The values out
+ * of the range are ignored.
+ */
+class BinCount : public UnaryPrimitive {
+ public:
+  explicit BinCount(Stream stream, int length)
+      : UnaryPrimitive(stream), length_(length) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_GRADS()
+  DEFINE_NAME(BinCount)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return length_;
+  }
+
+ private:
+  int length_;
+};
+
 class BitwiseBinary : public UnaryPrimitive {
  public:
   enum Op { And, Or, Xor, LeftShift, RightShift };
@@ -553,6 +608,31 @@ class SegmentedMM : public UnaryPrimitive {
   DEFINE_NAME(SegmentedMM)
 };
 
+/**
+ * The product of a sparse matrix in the compressed sparse row format, given
+ * by its row offsets, column indices and values, with a dense matrix. With
+ * |transpose| it is the product of the transpose of the sparse matrix, whose
+ * number of rows is the one of the output.
+ */
+class SparseMatmul : public UnaryPrimitive {
+ public:
+  explicit SparseMatmul(Stream stream, bool transpose = false)
+      : UnaryPrimitive(stream), transpose_(transpose) {}
+
+  void eval_cpu(const std::vector<array>& inputs, array& out) override;
+  void eval_gpu(const std::vector<array>& inputs, array& out) override;
+
+  DEFINE_GRADS()
+  DEFINE_NAME(SparseMatmul)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return transpose_;
+  }
+
+ private:
+  bool transpose_;
+};
+
 class BroadcastAxes : public UnaryPrimitive {
  public:
   explicit BroadcastAxes(Stream stream, std::vector<int> ignore_axes = {})
@@ -1226,6 +1306,27 @@ class Hadamard : public UnaryPrimitive {
   float scale_;
 };
 
+// Runs host code on the thread of a CPU stream once the inputs are computed
+// and copies the arrays it returns to the outputs.
+class HostCallback : public Primitive {
+ public:
+  using Function =
+      std::function<std::vector<array>(const std::vector<array>&)>;
+
+  explicit HostCallback(Stream stream, Function fn)
+      : Primitive(stream), fn_(std::move(fn)) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(HostCallback)
+
+ private:
+  Function fn_;
+};
+
 class Imag : public UnaryPrimitive {
  public:
   explicit Imag(Stream stream) : UnaryPrimitive(stream) {}
@@ -1411,7 +1512,10 @@ class LogSumExp : public UnaryPrimitive {
 
 class Matmul : public UnaryPrimitive {
  public:
-  explicit Matmul(Stream stream) : UnaryPrimitive(stream) {}
+  explicit Matmul(
+      Stream stream,
+      MatmulPrecision precision = MatmulPrecision::Default)
+      : UnaryPrimitive(stream), precision_(precision) {}
 
   void eval_cpu(const std::vector<array>& inputs, array& out) override;
   void eval_gpu(const std::vector<array>& inputs, array& out) override;
@@ -1419,8 +1523,18 @@ class Matmul : public UnaryPrimitive {
   DEFINE_GRADS()
   DEFINE_VMAP()
   DEFINE_NAME(Matmul)
-  DEFINE_DEFAULT_IS_EQUIVALENT()
+  bool is_equivalent(const Primitive& other) const override;
   std::vector<Shape> output_shapes(const std::vector<array>& inputs) override;
+  MatmulPrecision state() const {
+    return precision_;
+  }
+
+  MatmulPrecision precision() const {
+    return precision_;
+  }
+
+ private:
+  MatmulPrecision precision_;
 };
 
 class Maximum : public UnaryPrimitive {
@@ -2282,6 +2396,29 @@ class Unflatten : public UnaryPrimitive {
   void eval(const std::vector<array>& inputs, array& out);
 };
 
+class Unique : public Primitive {
+ public:
+  explicit Unique(Stream stream, bool return_inverse, bool return_counts)
+      : Primitive(stream),
+        return_inverse_(return_inverse),
+        return_counts_(return_counts) {}
+
+  void eval_cpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+  void eval_gpu(const std::vector<array>& inputs, std::vector<array>& outputs)
+      override;
+
+  DEFINE_NAME(Unique)
+  bool is_equivalent(const Primitive& other) const override;
+  auto state() const {
+    return std::make_pair(return_inverse_, return_counts_);
+  }
+
+ private:
+  bool return_inverse_;
+  bool return_counts_;
+};
+
 class View : public UnaryPrimitive {
  public:
   explicit View(Stream stream, Dtype dtype)
@@ -1,8 +1,10 @@
 // Copyright © 2023-2024 Apple Inc.
 
+#include <algorithm>
 #include <cmath>
 #include <sstream>
 
+#include "mlx/fast_primitives.h"
 #include "mlx/linalg.h"
 #include "mlx/ops.h"
 #include "mlx/primitives.h"
@@ -33,11 +35,9 @@ array key(uint64_t seed) {
   return array({k1, k2});
 }
 
-array bits(
-    const Shape& shape,
-    int width /* 4 */,
-    const std::optional<array>& key_ /*= nullopt */,
-    StreamOrDevice s /* = {} */) {
+// Get the key of a random op, the next key of the default sequence if none is
+// given.
+inline array get_key(const std::optional<array>& key_) {
   auto key = key_ ? *key_ : KeySequence::default_().next();
   if (key.dtype() != uint32) {
     std::ostringstream msg;
@@ -50,7 +50,15 @@ array bits(
     msg << "[bits] Expected key shape (2) but received " << key.shape() << ".";
     throw std::invalid_argument(msg.str());
   }
+  return key;
+}
 
+array bits(
+    const Shape& shape,
+    int width /* 4 */,
+    const std::optional<array>& key_ /*= nullopt */,
+    StreamOrDevice s /* = {} */) {
+  auto key = get_key(key_);
   auto get_dtype = [width]() {
     switch (width) {
       case 4:
@@ -92,6 +100,49 @@ T below_one() {
   return f;
 }
 
+// Get the upper bound of the random values of uniform, they are between
+// [0, nextafter(1.0, 0.0)] since samples must be in [low, high)
+inline float uniform_upper(Dtype dtype) {
+  switch (dtype) {
+    case float32:
+      return std::nextafter(1.0f, 0.0f);
+    case float16:
+      return below_one<float16_t>();
+    case bfloat16:
+      return below_one<bfloat16_t>();
+    default:
+      throw std::runtime_error("[uniform] Unsupported type.");
+  }
+}
+
+// Sample |shape| values of |dtype| with the fused kernel of the distribution
+// when the backend has one, the inputs are the key followed by the parameters
+// of the distribution.
+inline array sample_distribution(
+    fast::RandomDistribution::Kind kind,
+    float upper,
+    const Shape& shape,
+    Dtype dtype,
+    std::vector<array> inputs,
+    std::function<std::vector<array>(std::vector<array>)> fallback,
+    Stream s) {
+  if (fast::RandomDistribution::use_fallback(s)) {
+    return fallback(std::move(inputs))[0];
+  }
+  return array(
+      shape,
+      dtype,
+      std::make_shared<fast::RandomDistribution>(
+          s, std::move(fallback), kind, upper),
+      std::move(inputs));
+}
+
+// Whether the parameter |a| of a distribution is a single value which does
+// not change the shape of the samples.
+inline bool is_scalar_param(const array& a, const Shape& shape) {
+  return a.size() == 1 && a.ndim() <= shape.size();
+}
+
 array uniform(
     const array& low,
     const array& high,
@@ -108,8 +159,8 @@ array uniform(
   auto stream = to_stream(s);
   auto lo = astype(low, dtype, stream);
   auto hi = astype(high, dtype, stream);
-  auto range = subtract(hi, lo, stream);
-  auto out_shape = broadcast_shapes(shape, range.shape());
+  auto out_shape =
+      broadcast_shapes(shape, broadcast_shapes(lo.shape(), hi.shape()));
   if (out_shape != shape) {
     std::ostringstream msg;
     msg << "[uniform] Cannot generate random values of shape " << shape
@@ -117,27 +168,29 @@ array uniform(
     throw std::invalid_argument(msg.str());
   }
 
-  // Get random values between [0, nextafter(1.0, 0.0)] since samples must
-  // be in [low, high)
-  auto get_upper = [&dtype]() {
-    switch (dtype) {
-      case float32:
-        return array(std::nextafter(1.0f, 0.0f), float32);
-      case float16:
-        return array(below_one<float16_t>(), float32);
-      case bfloat16:
-        return array(below_one<bfloat16_t>(), float32);
-      default:
-        throw std::runtime_error("[uniform] Unsupported type.");
-    }
+  auto upper = uniform_upper(dtype);
+  auto fallback = [shape, dtype, upper, stream](std::vector<array> inputs) {
+    auto& lo = inputs[1];
+    auto& hi = inputs[2];
+    auto range = subtract(hi, lo, stream);
+    auto maxval = array(std::numeric_limits<uint32_t>::max(), float32);
+    auto out = bits(shape, size_of(float32), inputs[0], stream);
+    out = divide(out, maxval, stream);
+    out = astype(minimum(out, array(upper, float32), stream), dtype, stream);
+    return std::vector<array>{add(multiply(range, out, stream), lo, stream)};
   };
-
-  auto upper = get_upper();
-  auto maxval = array(std::numeric_limits<uint32_t>::max(), float32);
-  auto out = bits(shape, size_of(float32), key, stream);
-  out = divide(out, maxval, stream);
-  out = astype(minimum(out, upper, stream), dtype, stream);
-  return add(multiply(range, out, stream), lo, stream);
+  std::vector<array> inputs = {get_key(key), lo, hi};
+  if (lo.size() != 1 || hi.size() != 1) {
+    return fallback(std::move(inputs))[0];
+  }
+  return sample_distribution(
+      fast::RandomDistribution::Uniform,
+      upper,
+      shape,
+      dtype,
+      std::move(inputs),
+      std::move(fallback),
+      stream);
 }
 
 array uniform(
@@ -187,20 +240,42 @@ array normal(
   }
 
   auto stream = to_stream(s);
-  auto low = array(std::nextafter(-1.0f, 0.0f), float32);
-  auto high = array(1.0f, float32);
-  auto samples = uniform(low, high, shape, float32, key, stream);
   auto applied_scale = array(std::sqrt(2.0), dtype);
   if (scale.has_value()) {
     applied_scale =
         multiply(applied_scale, astype(*scale, dtype, stream), stream);
   }
-  samples = astype(erfinv(samples, stream), dtype, stream);
-  samples = multiply(applied_scale, samples, stream);
+  std::vector<array> inputs = {get_key(key), applied_scale};
   if (loc.has_value()) {
-    samples = add(astype(*loc, dtype, stream), samples, stream);
+    inputs.push_back(astype(*loc, dtype, stream));
   }
-  return samples;
+
+  auto fallback = [shape, dtype, stream](std::vector<array> inputs) {
+    auto low = array(std::nextafter(-1.0f, 0.0f), float32);
+    auto high = array(1.0f, float32);
+    auto samples = uniform(low, high, shape, float32, inputs[0], stream);
+    samples = astype(erfinv(samples, stream), dtype, stream);
+    samples = multiply(inputs[1], samples, stream);
+    if (inputs.size() > 2) {
+      samples = add(inputs[2], samples, stream);
+    }
+    return std::vector<array>{samples};
+  };
+  bool fused = dtype != float64 &&
+      std::all_of(inputs.begin() + 1, inputs.end(), [&](const array& a) {
+                 return is_scalar_param(a, shape);
+               });
+  if (!fused) {
+    return fallback(std::move(inputs))[0];
+  }
+  return sample_distribution(
+      fast::RandomDistribution::Normal,
+      uniform_upper(float32),
+      shape,
+      dtype,
+      std::move(inputs),
+      std::move(fallback),
+      stream);
 }
 
 array multivariate_normal(
@@ -300,12 +375,28 @@ array bernoulli(
           static_cast<float>(std::numeric_limits<uint32_t>::max()),
           std::numeric_limits<float>::max()),
       float32);
-  auto res = less(bits(shape, key, s), multiply(p, upper, s), s);
-  if (res.shape() != shape) {
-    throw std::invalid_argument(
-        "[bernoulli] shape of `p` is incompatible with argument `shape`.");
+  auto stream = to_stream(s);
+  auto fallback = [shape, stream](std::vector<array> inputs) {
+    return std::vector<array>{
+        less(bits(shape, inputs[0], stream), inputs[1], stream)};
+  };
+  std::vector<array> inputs = {get_key(key), multiply(p, upper, stream)};
+  if (inputs[1].dtype() != float32 || !is_scalar_param(p, shape)) {
+    auto res = fallback(std::move(inputs))[0];
+    if (res.shape() != shape) {
+      throw std::invalid_argument(
+          "[bernoulli] shape of `p` is incompatible with argument `shape`.");
+    }
+    return res;
   }
-  return res;
+  return sample_distribution(
+      fast::RandomDistribution::Bernoulli,
+      0.0f,
+      shape,
+      bool_,
+      std::move(inputs),
+      std::move(fallback),
+      stream);
 }
 
 array bernoulli(
@@ -364,8 +455,23 @@ array gumbel(
     const std::optional<array>& key /*= nullopt */,
     StreamOrDevice s /* = {} */) {
   // -log(-log(uniform(shape)))
-  return negative(
-      log(negative(log(uniform(shape, dtype, key, s), s), s), s), s);
+  auto stream = to_stream(s);
+  auto fallback = [shape, dtype, stream](std::vector<array> inputs) {
+    auto u = uniform(shape, dtype, inputs[0], stream);
+    return std::vector<array>{
+        negative(log(negative(log(u, stream), stream), stream), stream)};
+  };
+  if (!issubdtype(dtype, floating) || dtype == float64) {
+    return fallback({get_key(key)})[0];
+  }
+  return sample_distribution(
+      fast::RandomDistribution::Gumbel,
+      uniform_upper(dtype),
+      shape,
+      dtype,
+      {get_key(key)},
+      std::move(fallback),
+      stream);
 }
 
 int get_valid_axis(int axis, int ndim) {
@@ -1,6 +1,9 @@
 // Copyright © 2023 Apple Inc.
 
+#include <sstream>
+
 #include "mlx/scheduler.h"
+#include "mlx/backend/common/numa.h"
 #include "mlx/backend/gpu/available.h"
 #include "mlx/backend/gpu/eval.h"
 
@@ -26,12 +29,37 @@ Stream get_stream(int index) {
   return scheduler::scheduler().get_stream(index);
 }
 
-Stream new_stream(Device d) {
+void set_numa_node(Stream s, int node) {
+  if (s.device != Device::cpu) {
+    throw std::invalid_argument(
+        "[set_numa_node] Only cpu streams can be placed on a NUMA node.");
+  }
+  if (node < -1 || node >= numa::num_nodes()) {
+    std::ostringstream msg;
+    msg << "[set_numa_node] Invalid node " << node << " with "
+        << numa::num_nodes() << " NUMA nodes.";
+    throw std::invalid_argument(msg.str());
+  }
+  numa::set_stream_node(s.index, node);
+  // The stream thread binds itself once the tasks already enqueued ran.
+  scheduler::enqueue(s, [node]() { numa::bind_thread(node); });
+}
+
+Stream new_stream(
+    Device d,
+    int priority /* = 0 */,
+    float sm_fraction /* = 1.0f */) {
   if (!gpu::is_available() && d == Device::gpu) {
     throw std::invalid_argument(
         "[new_stream] Cannot make gpu stream without gpu backend.");
   }
-  return scheduler::scheduler().new_stream(d);
+  if (!(sm_fraction > 0 && sm_fraction <= 1)) {
+    std::ostringstream msg;
+    msg << "[new_stream] The fraction of the SMs must be in (0, 1] but got "
+        << sm_fraction << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  return scheduler::scheduler().new_stream(d, priority, sm_fraction);
 }
 
 Stream new_stream() {
@@ -47,6 +75,7 @@ void synchronize(Stream s) {
   } else {
     gpu::synchronize(s);
   }
+  scheduler::check_error();
 }
 
 void synchronize() {
@@ -69,5 +98,45 @@ Scheduler& scheduler() {
 #endif
 }
 
+namespace {
+
+struct DeferredError {
+  std::atomic<bool> pending{false};
+  std::mutex mtx;
+  std::exception_ptr error;
+};
+
+DeferredError& deferred_error() {
+  static DeferredError deferred;
+  return deferred;
+}
+
+} // namespace
+
+void set_error(std::exception_ptr error) {
+  auto& deferred = deferred_error();
+  std::lock_guard lock(deferred.mtx);
+  if (!deferred.error) {
+    deferred.error = std::move(error);
+    deferred.pending = true;
+  }
+}
+
+void check_error() {
+  auto& deferred = deferred_error();
+  if (!deferred.pending) {
+    return;
+  }
+  std::exception_ptr error;
+  {
+    std::lock_guard lock(deferred.mtx);
+    std::swap(error, deferred.error);
+    deferred.pending = false;
+  }
+  if (error) {
+    std::rethrow_exception(error);
+  }
+}
+
 } // namespace scheduler
 } // namespace mlx::core
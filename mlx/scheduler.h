@@ -2,10 +2,17 @@
 
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
 #include <future>
-#include <queue>
+#include <mutex>
+#include <new>
+#include <optional>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 
 #include "mlx/backend/gpu/eval.h"
@@ -14,14 +21,198 @@
 
 namespace mlx::core::scheduler {
 
+// A move-only void() callable which stores the closures up to
+// |inline_size| bytes in place, so enqueuing a task does not allocate for
+// its captures. Larger closures are moved to the heap.
+class Task {
+ public:
+  static constexpr size_t inline_size = 112;
+
+  Task() = default;
+
+  template <
+      typename F,
+      typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, Task>>>
+  Task(F&& f) {
+    using D = std::decay_t<F>;
+    if constexpr (
+        sizeof(D) <= inline_size &&
+        alignof(D) <= alignof(std::max_align_t) &&
+        std::is_nothrow_move_constructible_v<D>) {
+      new (storage_) D(std::forward<F>(f));
+      ops_ = &inline_ops<D>;
+    } else {
+      new (storage_) D*(new D(std::forward<F>(f)));
+      ops_ = &heap_ops<D>;
+    }
+  }
+
+  Task(Task&& other) noexcept : ops_(other.ops_) {
+    if (ops_) {
+      ops_->move(storage_, other.storage_);
+      other.ops_ = nullptr;
+    }
+  }
+
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      reset();
+      ops_ = other.ops_;
+      if (ops_) {
+        ops_->move(storage_, other.storage_);
+        other.ops_ = nullptr;
+      }
+    }
+    return *this;
+  }
+
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+
+  ~Task() {
+    reset();
+  }
+
+  explicit operator bool() const {
+    return ops_ != nullptr;
+  }
+
+  void operator()() {
+    ops_->call(storage_);
+  }
+
+  void reset() {
+    if (ops_) {
+      ops_->destroy(storage_);
+      ops_ = nullptr;
+    }
+  }
+
+ private:
+  struct Ops {
+    void (*call)(void*);
+    // Move constructs the closure in |dst| and destroys the one in |src|.
+    void (*move)(void* dst, void* src);
+    void (*destroy)(void*);
+  };
+
+  template <typename D>
+  static constexpr Ops inline_ops = {
+      [](void* p) { (*static_cast<D*>(p))(); },
+      [](void* dst, void* src) {
+        new (dst) D(std::move(*static_cast<D*>(src)));
+        static_cast<D*>(src)->~D();
+      },
+      [](void* p) { static_cast<D*>(p)->~D(); }};
+
+  template <typename D>
+  static constexpr Ops heap_ops = {
+      [](void* p) { (**static_cast<D**>(p))(); },
+      [](void* dst, void* src) { new (dst) D*(*static_cast<D**>(src)); },
+      [](void* p) { delete *static_cast<D**>(p); }};
+
+  alignas(std::max_align_t) unsigned char storage_[inline_size];
+  const Ops* ops_{nullptr};
+};
+
+// An unbounded FIFO of tasks with a single consumer. The tasks are stored in
+// linked segments of |segment_size| slots. The consumer never takes a lock:
+// the producer publishes a slot with a release store of the number of slots
+// written in the segment and the consumer acquires it. Several threads may
+// enqueue to a stream (the evaluating thread, synchronize, events) so the
+// producers are serialized by a mutex which is uncontended in the common
+// case of one producer.
+class TaskQueue {
+ public:
+  static constexpr int segment_size = 256;
+
+  TaskQueue() : head_(new Segment), tail_(head_) {}
+
+  TaskQueue(const TaskQueue&) = delete;
+  TaskQueue& operator=(const TaskQueue&) = delete;
+
+  ~TaskQueue() {
+    while (head_) {
+      auto next = head_->next.load(std::memory_order_relaxed);
+      delete head_;
+      head_ = next;
+    }
+  }
+
+  // Called by the producers.
+  void push(Task task) {
+    std::lock_guard<std::mutex> lk(producer_mtx_);
+    if (tail_pos_ == segment_size) {
+      auto s = new Segment;
+      tail_->next.store(s, std::memory_order_release);
+      tail_ = s;
+      tail_pos_ = 0;
+    }
+    tail_->slots[tail_pos_++] = std::move(task);
+    // Sequentially consistent so the store is ordered before the producer
+    // checks whether the consumer sleeps.
+    tail_->written.store(tail_pos_, std::memory_order_seq_cst);
+  }
+
+  // Called by the consumer, runs the next task in its slot and returns
+  // false when the queue is empty.
+  bool run_one() {
+    if (head_pos_ == segment_size) {
+      auto next = head_->next.load(std::memory_order_acquire);
+      if (next == nullptr) {
+        return false;
+      }
+      delete head_;
+      head_ = next;
+      head_pos_ = 0;
+    }
+    if (head_pos_ == head_->written.load(std::memory_order_acquire)) {
+      return false;
+    }
+    auto& task = head_->slots[head_pos_++];
+    task();
+    task.reset();
+    return true;
+  }
+
+  // Called by the consumer.
+  bool empty() const {
+    if (head_pos_ == segment_size) {
+      return head_->next.load(std::memory_order_seq_cst) == nullptr;
+    }
+    return head_pos_ == head_->written.load(std::memory_order_seq_cst);
+  }
+
+ private:
+  struct Segment {
+    Task slots[segment_size];
+    std::atomic<int> written{0};
+    std::atomic<Segment*> next{nullptr};
+  };
+
+  // Owned by the consumer.
+  Segment* head_;
+  int head_pos_{0};
+
+  // Owned by the producers.
+  std::mutex producer_mtx_;
+  Segment* tail_;
+  int tail_pos_{0};
+};
+
 struct StreamThread {
+  // The number of times the thread polls the queue before it sleeps, the
+  // tasks of an eval are usually enqueued faster than they run.
+  static constexpr int spin_count = 1 << 10;
+
+  TaskQueue q;
   std::mutex mtx;
-  std::queue<std::function<void()>> q;
   std::condition_variable cond;
-  bool stop;
+  std::atomic<bool> sleeping{false};
+  std::atomic<bool> stop{false};
   std::thread thread;
 
-  StreamThread() : stop(false), thread(&StreamThread::thread_fn, this) {}
+  StreamThread() : thread(&StreamThread::thread_fn, this) {}
 
   ~StreamThread() {
     {
@@ -34,32 +225,35 @@ struct StreamThread {
 
   void thread_fn() {
     while (true) {
-      std::function<void()> task;
-      {
-        std::unique_lock<std::mutex> lk(mtx);
-        cond.wait(lk, [this] { return !this->q.empty() || this->stop; });
-        if (q.empty() && stop) {
-          return;
-        }
-        task = std::move(q.front());
-        q.pop();
+      bool ran = false;
+      for (int i = 0; i < spin_count && !ran; ++i) {
+        ran = q.run_one();
+      }
+      if (ran) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lk(mtx);
+      sleeping.store(true, std::memory_order_seq_cst);
+      cond.wait(lk, [this] { return !q.empty() || stop; });
+      sleeping.store(false, std::memory_order_relaxed);
+      if (stop && q.empty()) {
+        return;
       }
-
-      task();
     }
   }
 
   template <typename F>
   void enqueue(F&& f) {
-    {
-      std::lock_guard<std::mutex> lk(mtx);
-      if (stop) {
-        throw std::runtime_error(
-            "Cannot enqueue work after stream is stopped.");
-      }
-      q.emplace(std::forward<F>(f));
+    if (stop) {
+      throw std::runtime_error("Cannot enqueue work after stream is stopped.");
+    }
+    q.push(Task(std::forward<F>(f)));
+    // The consumer sets |sleeping| before it checks the queue under the
+    // lock, so either it sees the task or the producer sees it sleeping.
+    if (sleeping.load(std::memory_order_seq_cst)) {
+      { std::lock_guard<std::mutex> lk(mtx); }
+      cond.notify_one();
     }
-    cond.notify_one();
   }
 };
 
@@ -67,9 +261,10 @@ class Scheduler {
  public:
   Scheduler() : n_active_tasks_(0) {
     if (is_available(Device::gpu)) {
-      default_streams_.insert({Device::gpu, new_stream(Device::gpu)});
+      default_streams_[static_cast<int>(Device::gpu)] =
+          new_stream(Device::gpu);
     }
-    default_streams_.insert({Device::cpu, new_stream(Device::cpu)});
+    default_streams_[static_cast<int>(Device::cpu)] = new_stream(Device::cpu);
   }
 
   // Not copyable or moveable
@@ -78,8 +273,9 @@ class Scheduler {
   Scheduler& operator=(const Scheduler&) = delete;
   Scheduler& operator=(Scheduler&&) = delete;
 
-  Stream new_stream(const Device& d) {
-    streams_.emplace_back(streams_.size(), d);
+  Stream
+  new_stream(const Device& d, int priority = 0, float sm_fraction = 1.0f) {
+    streams_.emplace_back(streams_.size(), d, priority, sm_fraction);
     if (d == Device::gpu) {
       threads_.push_back(nullptr);
       gpu::new_stream(streams_.back());
@@ -93,14 +289,14 @@ class Scheduler {
   void enqueue(const Stream& stream, F&& f);
 
   Stream get_default_stream(const Device& d) const {
-    return default_streams_.at(d.type);
+    return default_streams_[static_cast<int>(d.type)].value();
   }
   Stream get_stream(int index) const {
     return streams_.at(index);
   }
 
   void set_default_stream(const Stream& s) {
-    default_streams_.at(s.device.type) = s;
+    default_streams_[static_cast<int>(s.device.type)] = s;
   }
 
   void notify_new_task(const Stream& stream) {
@@ -133,6 +329,17 @@ class Scheduler {
     }
   }
 
+  // Wait until an active task completes, return at once when there is none.
+  void wait_for_completion() {
+    std::unique_lock<std::mutex> lk(mtx);
+    int n_tasks_old = n_active_tasks();
+    if (n_tasks_old > 0) {
+      completion_cv.wait(lk, [this, n_tasks_old] {
+        return this->n_active_tasks() < n_tasks_old;
+      });
+    }
+  }
+
   ~Scheduler() {
     for (auto s : streams_) {
       synchronize(s);
@@ -148,7 +355,8 @@ class Scheduler {
   int n_active_tasks_;
   std::vector<StreamThread*> threads_;
   std::vector<Stream> streams_;
-  std::unordered_map<Device::DeviceType, Stream> default_streams_;
+  // Indexed by the device type, as every operation looks it up.
+  std::array<std::optional<Stream>, 2> default_streams_;
   std::condition_variable completion_cv;
   std::mutex mtx;
 };
@@ -181,4 +389,15 @@ inline void wait_for_one() {
   scheduler().wait_for_one();
 }
 
+inline void wait_for_completion() {
+  scheduler().wait_for_completion();
+}
+
+// Record the error of a task which can not throw on the thread of its
+// stream, the first one is thrown by the next wait for an evaluation.
+void set_error(std::exception_ptr error);
+
+// Throw the recorded error, if any, and clear it.
+void check_error();
+
 } // namespace mlx::core::scheduler
@@ -0,0 +1,134 @@
+// Copyright © 2025 Apple Inc.
+
+#include <string>
+
+#include "mlx/serve/c_api.h"
+#include "mlx/serve/engine.h"
+
+using namespace mlx::core;
+
+struct mlx_serve_engine_ {
+  mlx_serve_engine_(const char* path, const serve::EngineConfig& config)
+      : engine(std::string(path), config) {}
+  serve::Engine engine;
+};
+
+namespace {
+
+thread_local std::string last_error;
+
+void set_error(const std::exception& e) {
+  last_error = e.what();
+}
+
+Dtype to_dtype(mlx_serve_dtype dtype) {
+  switch (dtype) {
+    case MLX_SERVE_FLOAT16:
+      return float16;
+    case MLX_SERVE_BFLOAT16:
+      return bfloat16;
+    case MLX_SERVE_FLOAT32:
+      return float32;
+  }
+  throw std::invalid_argument("[mlx_serve_engine_new] Invalid dtype.");
+}
+
+} // namespace
+
+extern "C" {
+
+mlx_serve_config mlx_serve_default_config(void) {
+  serve::EngineConfig defaults{};
+  mlx_serve_config config;
+  config.num_layers = 0;
+  config.n_kv_heads = 0;
+  config.head_dim = 0;
+  config.dtype = MLX_SERVE_FLOAT16;
+  config.num_pages = defaults.num_pages;
+  config.page_size = defaults.page_size;
+  config.max_context = defaults.max_context;
+  config.max_batch_size = defaults.max_batch_size;
+  config.prefill_chunk_size = defaults.prefill_chunk_size;
+  config.kv_memory_fraction = defaults.kv_memory_fraction;
+  config.enable_prefix_cache = defaults.enable_prefix_cache;
+  return config;
+}
+
+mlx_serve_engine* mlx_serve_engine_new(
+    const char* path,
+    const mlx_serve_config* config) {
+  try {
+    serve::EngineConfig c;
+    c.num_layers = config->num_layers;
+    c.n_kv_heads = config->n_kv_heads;
+    c.head_dim = config->head_dim;
+    c.dtype = to_dtype(config->dtype);
+    c.num_pages = config->num_pages;
+    c.page_size = config->page_size;
+    c.max_context = config->max_context;
+    c.max_batch_size = config->max_batch_size;
+    c.prefill_chunk_size = config->prefill_chunk_size;
+    c.kv_memory_fraction = config->kv_memory_fraction;
+    c.enable_prefix_cache = config->enable_prefix_cache != 0;
+    return new mlx_serve_engine_(path, c);
+  } catch (const std::exception& e) {
+    set_error(e);
+    return nullptr;
+  }
+}
+
+void mlx_serve_engine_free(mlx_serve_engine* engine) {
+  delete engine;
+}
+
+int mlx_serve_add_request(
+    mlx_serve_engine* engine,
+    const int* prompt,
+    size_t prompt_len,
+    int max_tokens,
+    float temperature,
+    const int* stop_tokens,
+    size_t num_stop_tokens) {
+  try {
+    serve::Request request;
+    request.prompt.assign(prompt, prompt + prompt_len);
+    request.max_tokens = max_tokens;
+    request.temperature = temperature;
+    request.stop_tokens.assign(stop_tokens, stop_tokens + num_stop_tokens);
+    return engine->engine.add_request(std::move(request));
+  } catch (const std::exception& e) {
+    set_error(e);
+    return -1;
+  }
+}
+
+int mlx_serve_step(
+    mlx_serve_engine* engine,
+    mlx_serve_token* out,
+    size_t capacity) {
+  try {
+    size_t max_batch_size = engine->engine.config().max_batch_size;
+    if (capacity < max_batch_size) {
+      throw std::invalid_argument(
+          "[mlx_serve_step] The output must hold max_batch_size tokens.");
+    }
+    auto events = engine->engine.step();
+    for (size_t i = 0; i < events.size(); ++i) {
+      out[i] = {events[i].request, events[i].token, events[i].finished};
+    }
+    return events.size();
+  } catch (const std::exception& e) {
+    set_error(e);
+    return -1;
+  }
+}
+
+int mlx_serve_has_work(const mlx_serve_engine* engine) {
+  return engine->engine.has_work();
+}
+
+const char* mlx_serve_last_error(void) {
+  return last_error.c_str();
+}
+
+} // extern "C"
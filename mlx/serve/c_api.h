@@ -0,0 +1,87 @@
+/* Copyright © 2025 Apple Inc. */
+
+#ifndef MLX_SERVE_C_API_H
+#define MLX_SERVE_C_API_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* An engine generating the tokens of requests with an exported model. */
+typedef struct mlx_serve_engine_ mlx_serve_engine;
+
+typedef enum {
+  MLX_SERVE_FLOAT16,
+  MLX_SERVE_BFLOAT16,
+  MLX_SERVE_FLOAT32,
+} mlx_serve_dtype;
+
+/* See mlx::core::serve::EngineConfig. */
+typedef struct {
+  int num_layers;
+  int n_kv_heads;
+  int head_dim;
+  mlx_serve_dtype dtype;
+  int num_pages;
+  int page_size;
+  int max_context;
+  int max_batch_size;
+  int prefill_chunk_size;
+  float kv_memory_fraction;
+  int enable_prefix_cache;
+} mlx_serve_config;
+
+typedef struct {
+  int request;
+  int token;
+  int finished;
+} mlx_serve_token;
+
+/* The default configuration, the model dimensions must still be set. */
+mlx_serve_config mlx_serve_default_config(void);
+
+/*
+ * Load the model exported to |path| and make an engine for it, or return
+ * NULL on error.
+ */
+mlx_serve_engine* mlx_serve_engine_new(
+    const char* path,
+    const mlx_serve_config* config);
+
+void mlx_serve_engine_free(mlx_serve_engine* engine);
+
+/*
+ * Queue a request and return its id, or -1 on error. A temperature of 0
+ * takes the most likely tokens.
+ */
+int mlx_serve_add_request(
+    mlx_serve_engine* engine,
+    const int* prompt,
+    size_t prompt_len,
+    int max_tokens,
+    float temperature,
+    const int* stop_tokens,
+    size_t num_stop_tokens);
+
+/*
+ * Run a step and write the tokens read in it to |out|, which must hold
+ * max_batch_size tokens. Return the number of tokens, or -1 on error.
+ */
+int mlx_serve_step(
+    mlx_serve_engine* engine,
+    mlx_serve_token* out,
+    size_t capacity);
+
+/* Whether there are requests queued or running. */
+int mlx_serve_has_work(const mlx_serve_engine* engine);
+
+/* The message of the last error of the thread. */
+const char* mlx_serve_last_error(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
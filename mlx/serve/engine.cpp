@@ -0,0 +1,320 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "mlx/memory.h"
+#include "mlx/ops.h"
+#include "mlx/random.h"
+#include "mlx/serve/engine.h"
+#include "mlx/transforms.h"
+
+namespace mlx::core::serve {
+
+namespace {
+
+int ceil_div(int a, int b) {
+  return (a + b - 1) / b;
+}
+
+} // namespace
+
+Engine::Engine(Model model, EngineConfig config)
+    : model_(std::move(model)),
+      config_(config),
+      prefix_cache_(config.page_size) {
+  if (config_.num_layers <= 0 || config_.n_kv_heads <= 0 ||
+      config_.head_dim <= 0) {
+    throw std::invalid_argument(
+        "[Engine::Engine] The number of layers, key value heads and the head "
+        "dimension must be positive.");
+  }
+  if (config_.num_pages < 0 || config_.page_size <= 0 ||
+      config_.max_context <= 0) {
+    throw std::invalid_argument(
+        "[Engine::Engine] The page size and the maximum context must be "
+        "positive and the number of pages non-negative.");
+  }
+  if (config_.max_batch_size <= 0 || config_.prefill_chunk_size <= 0) {
+    throw std::invalid_argument(
+        "[Engine::Engine] The maximum batch size and the prefill chunk size "
+        "must be positive.");
+  }
+  max_pages_ = ceil_div(config_.max_context, config_.page_size);
+
+  if (config_.num_pages == 0) {
+    size_t page_bytes = 2 * size_of(config_.dtype) * config_.num_layers *
+        config_.n_kv_heads * config_.page_size * config_.head_dim;
+    size_t limit = get_memory_limit();
+    size_t active = get_active_memory();
+    size_t available = limit > active ? limit - active : 0;
+    config_.num_pages = std::min<double>(
+        available * config_.kv_memory_fraction / page_bytes,
+        std::numeric_limits<int>::max());
+    if (config_.num_pages == 0) {
+      throw std::runtime_error(
+          "[Engine::Engine] Not enough memory left for the page pools.");
+    }
+  }
+
+  Shape pool_shape = {
+      config_.num_pages,
+      config_.n_kv_heads,
+      config_.page_size,
+      config_.head_dim};
+  for (int i = 0; i < config_.num_layers; ++i) {
+    k_pages_.push_back(zeros(pool_shape, config_.dtype));
+    v_pages_.push_back(zeros(pool_shape, config_.dtype));
+  }
+  eval(k_pages_);
+  eval(v_pages_);
+
+  // Pages are taken from the back so the first ones are used first.
+  for (int i = config_.num_pages - 1; i >= 0; --i) {
+    free_pages_.push_back(i);
+  }
+}
+
+Engine::Engine(const std::string& path, EngineConfig config)
+    : Engine(
+          [fn = import_function(path)](const Kwargs& kwargs) {
+            return fn(kwargs);
+          },
+          config) {}
+
+int Engine::pages_needed(const Request& request) const {
+  return ceil_div(
+      request.prompt.size() + request.max_tokens, config_.page_size);
+}
+
+int Engine::add_request(Request request) {
+  if (request.prompt.empty()) {
+    throw std::invalid_argument("[Engine::add_request] Empty prompt.");
+  }
+  if (request.max_tokens <= 0) {
+    throw std::invalid_argument(
+        "[Engine::add_request] The maximum tokens must be positive.");
+  }
+  if (request.temperature < 0) {
+    throw std::invalid_argument(
+        "[Engine::add_request] The temperature must be non-negative.");
+  }
+  int total = request.prompt.size() + request.max_tokens;
+  if (total > config_.max_context) {
+    std::ostringstream msg;
+    msg << "[Engine::add_request] The prompt and maximum tokens (" << total
+        << ") exceed the maximum context (" << config_.max_context << ").";
+    throw std::invalid_argument(msg.str());
+  }
+  if (pages_needed(request) > config_.num_pages) {
+    std::ostringstream msg;
+    msg << "[Engine::add_request] The request needs "
+        << pages_needed(request) << " pages but there are only "
+        << config_.num_pages << ".";
+    throw std::invalid_argument(msg.str());
+  }
+  auto seq = std::make_unique<Sequence>();
+  seq->id = next_id_++;
+  seq->request = std::move(request);
+  waiting_.push_back(std::move(seq));
+  return waiting_.back()->id;
+}
+
+void Engine::admit() {
+  // Admit in order so a long request is not passed over forever.
+  while (!waiting_.empty() &&
+      running_.size() < static_cast<size_t>(config_.max_batch_size)) {
+    auto& seq = waiting_.front();
+    auto& prompt = seq->request.prompt;
+    std::vector<PrefixCache::Node*> cached;
+    if (config_.enable_prefix_cache) {
+      // The last token of the prompt is run for the logits of the first
+      // generated token.
+      cached = prefix_cache_.match(prompt, prompt.size() - 1);
+    }
+    int n = pages_needed(seq->request) - cached.size();
+    int missing = n - static_cast<int>(free_pages_.size());
+    if (missing > prefix_cache_.num_evictable()) {
+      prefix_cache_.release(cached);
+      break;
+    }
+    auto evicted = prefix_cache_.evict(missing);
+    free_pages_.insert(free_pages_.end(), evicted.begin(), evicted.end());
+
+    for (auto node : cached) {
+      seq->pages.push_back(PrefixCache::page(node));
+    }
+    seq->pages.insert(
+        seq->pages.end(), free_pages_.end() - n, free_pages_.end());
+    free_pages_.resize(free_pages_.size() - n);
+    seq->num_prefilled = cached.size() * config_.page_size;
+    seq->cached = std::move(cached);
+    running_.push_back(std::move(seq));
+    waiting_.pop_front();
+  }
+}
+
+void Engine::finish(Sequence& seq) {
+  seq.finished = true;
+  seq.next = std::nullopt;
+  // The first pages belong to the prefix cache.
+  prefix_cache_.release(seq.cached);
+  free_pages_.insert(
+      free_pages_.end(),
+      seq.pages.rbegin(),
+      seq.pages.rend() - seq.cached.size());
+  seq.pages.clear();
+  seq.cached.clear();
+}
+
+array Engine::run_model(
+    const std::vector<Sequence*>& seqs,
+    const array& tokens,
+    const std::vector<int>& context_lens) {
+  int batch = seqs.size();
+  std::vector<int32_t> table(batch * max_pages_, 0);
+  for (int b = 0; b < batch; ++b) {
+    std::copy(
+        seqs[b]->pages.begin(),
+        seqs[b]->pages.end(),
+        table.begin() + b * max_pages_);
+  }
+
+  Kwargs kwargs;
+  kwargs.insert({"tokens", tokens});
+  kwargs.insert({"block_table", array(table.begin(), {batch, max_pages_})});
+  kwargs.insert(
+      {"context_lens", array(context_lens.begin(), {batch}, int32)});
+  for (int i = 0; i < config_.num_layers; ++i) {
+    kwargs.insert({"k_pages_" + std::to_string(i), k_pages_[i]});
+    kwargs.insert({"v_pages_" + std::to_string(i), v_pages_[i]});
+  }
+
+  auto outputs = model_(kwargs);
+  if (outputs.size() != 1 + 2 * static_cast<size_t>(config_.num_layers)) {
+    std::ostringstream msg;
+    msg << "[Engine::step] The model returned " << outputs.size()
+        << " arrays but the logits and " << 2 * config_.num_layers
+        << " page pools were expected.";
+    throw std::runtime_error(msg.str());
+  }
+  for (int i = 0; i < config_.num_layers; ++i) {
+    k_pages_[i] = outputs[1 + i];
+    v_pages_[i] = outputs[1 + config_.num_layers + i];
+  }
+  return outputs[0];
+}
+
+array Engine::sample(const array& logits, const std::vector<Sequence*>& seqs) {
+  auto greedy = astype(argmax(logits, -1), int32);
+  std::vector<float> temps;
+  for (auto seq : seqs) {
+    temps.push_back(seq->request.temperature);
+  }
+  if (std::all_of(temps.begin(), temps.end(), [](float t) { return t == 0; })) {
+    return greedy;
+  }
+  int batch = seqs.size();
+  auto t = array(temps.begin(), {batch}, float32);
+  auto mask = greater(t, array(0.0f));
+  auto scaled = divide(
+      astype(logits, float32),
+      expand_dims(where(mask, t, array(1.0f)), -1));
+  auto sampled = astype(random::categorical(scaled, -1), int32);
+  return where(mask, sampled, greedy);
+}
+
+std::vector<TokenEvent> Engine::step() {
+  admit();
+
+  // The sequences whose token sampled in the last step is read in this one,
+  // and those of them which run another token in the meantime. The last
+  // token of a request is only read.
+  std::vector<Sequence*> reading;
+  std::vector<Sequence*> decoding;
+  for (auto& seq : running_) {
+    if (seq->next) {
+      reading.push_back(seq.get());
+      if (seq->num_generated + 1 < seq->request.max_tokens) {
+        decoding.push_back(seq.get());
+      }
+    }
+  }
+
+  std::vector<array> pending;
+
+  // Run a chunk of the first prompt which is not in the cache yet.
+  for (auto& seq : running_) {
+    auto& prompt = seq->request.prompt;
+    if (seq->num_prefilled == static_cast<int>(prompt.size())) {
+      continue;
+    }
+    int start = seq->num_prefilled;
+    int len = std::min<int>(config_.prefill_chunk_size, prompt.size() - start);
+    auto tokens = array(prompt.begin() + start, {1, len}, int32);
+    auto logits = run_model({seq.get()}, tokens, {start});
+    seq->num_prefilled += len;
+    if (seq->num_prefilled == static_cast<int>(prompt.size())) {
+      if (config_.enable_prefix_cache) {
+        prefix_cache_.insert(prompt, prompt.size(), seq->pages, seq->cached);
+      }
+      seq->next = sample(logits, {seq.get()});
+      pending.push_back(*seq->next);
+    }
+    break;
+  }
+
+  // Run the next token of the sequences being generated, fed with the
+  // tokens of the last step before they are read.
+  std::vector<array> decoded;
+  if (!decoding.empty()) {
+    int batch = decoding.size();
+    std::vector<array> tokens;
+    std::vector<int> context_lens;
+    for (auto seq : decoding) {
+      tokens.push_back(*seq->next);
+      context_lens.push_back(seq->request.prompt.size() + seq->num_generated);
+    }
+    auto logits = run_model(
+        decoding, reshape(concatenate(tokens), {batch, 1}), context_lens);
+    auto next = sample(logits, decoding);
+    pending.push_back(next);
+    for (int b = 0; b < batch; ++b) {
+      decoded.push_back(slice(next, {b}, {b + 1}));
+    }
+  }
+
+  pending.insert(pending.end(), k_pages_.begin(), k_pages_.end());
+  pending.insert(pending.end(), v_pages_.begin(), v_pages_.end());
+  async_eval(std::move(pending));
+
+  // Read the tokens of the last step while this one runs.
+  std::vector<TokenEvent> events;
+  size_t d = 0;
+  for (auto seq : reading) {
+    int token = seq->next->item<int>();
+    seq->num_generated++;
+    auto& stop = seq->request.stop_tokens;
+    bool finished = seq->num_generated == seq->request.max_tokens ||
+        std::find(stop.begin(), stop.end(), token) != stop.end();
+    events.push_back({seq->id, token, finished});
+    bool decoded_next = d < decoding.size() && decoding[d] == seq;
+    if (finished) {
+      finish(*seq);
+    } else {
+      seq->next = decoded[d];
+    }
+    d += decoded_next;
+  }
+  running_.erase(
+      std::remove_if(
+          running_.begin(),
+          running_.end(),
+          [](const auto& seq) { return seq->finished; }),
+      running_.end());
+  return events;
+}
+
+} // namespace mlx::core::serve
@@ -0,0 +1,163 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mlx/array.h"
+#include "mlx/export.h"
+#include "mlx/serve/prefix_cache.h"
+
+namespace mlx::core::serve {
+
+/**
+ * A model run by the engine. It is called with the keyword arguments:
+ *
+ *  - "tokens": int32 (B, L), the next L tokens of the B sequences.
+ *  - "block_table": int32 (B, max_pages), the pages of each sequence.
+ *  - "context_lens": int32 (B,), the tokens of each sequence already in the
+ *    cache, so the tokens are at the positions context_lens[b] + [0, L).
+ *  - "k_pages_{i}", "v_pages_{i}": the key and value page pools of the layer
+ *    i, of shape (num_pages, n_kv_heads, page_size, head_dim).
+ *
+ * and returns the logits of shape (B, vocab_size) of the last of the L
+ * tokens followed by the updated key pools and the updated value pools of the
+ * layers, as written by fast::paged_kv_write.
+ */
+using Model = std::function<std::vector<array>(const Kwargs&)>;
+
+struct EngineConfig {
+  // The shape of the page pools of the model.
+  int num_layers;
+  int n_kv_heads;
+  int head_dim;
+  Dtype dtype{float16};
+  // The pages of the pools, or 0 to take kv_memory_fraction of the memory
+  // left under the memory limit.
+  int num_pages{1024};
+  int page_size{16};
+  float kv_memory_fraction{0.5f};
+
+  // The most tokens of a sequence, prompt and generated ones, which sets the
+  // width of the block tables.
+  int max_context{4096};
+  // The most sequences run at once.
+  int max_batch_size{32};
+  // The most prompt tokens run in one call of the model.
+  int prefill_chunk_size{512};
+  // Share the pages of the prompts starting with the same tokens.
+  bool enable_prefix_cache{true};
+};
+
+struct Request {
+  std::vector<int> prompt;
+  int max_tokens{256};
+  // Sample from the logits divided by the temperature, or take their argmax
+  // when it is 0.
+  float temperature{0.0f};
+  // The tokens which end the generation, they are returned.
+  std::vector<int> stop_tokens;
+};
+
+// A token generated for a request, the last one of the request is finished.
+struct TokenEvent {
+  int request;
+  int token;
+  bool finished;
+};
+
+/**
+ * Generates the tokens of requests with a model with continuous batching.
+ *
+ * Each step runs a chunk of the prompt of one request and one token of all
+ * the requests which are done with their prompt, and admits the waiting
+ * requests as the finished ones leave. The next step is built and started
+ * with async_eval before the tokens of the previous step are read, so the
+ * host work overlaps with the model.
+ *
+ * A request holds the pages for its prompt and max_tokens from the time it is
+ * admitted, so the running requests never run out of pages. The full pages of
+ * the prompts are kept in a PrefixCache once they are computed, and the
+ * prompts starting with their tokens use them instead of running them again.
+ */
+class Engine {
+ public:
+  Engine(Model model, EngineConfig config);
+
+  // Load a model exported with export_function and shapeless set, as the
+  // batch size and the number of tokens change between the calls.
+  Engine(const std::string& path, EngineConfig config);
+
+  Engine(const Engine&) = delete;
+  Engine& operator=(const Engine&) = delete;
+
+  // Queue |request| and return its id.
+  int add_request(Request request);
+
+  // Run a step and return the tokens read in it.
+  std::vector<TokenEvent> step();
+
+  // Whether there are requests queued or running.
+  bool has_work() const {
+    return !waiting_.empty() || !running_.empty();
+  }
+  int num_waiting() const {
+    return waiting_.size();
+  }
+  int num_running() const {
+    return running_.size();
+  }
+  // The pages free or held only by the prefix cache.
+  int num_free_pages() const {
+    return free_pages_.size() + prefix_cache_.num_evictable();
+  }
+  int num_cached_pages() const {
+    return prefix_cache_.num_pages();
+  }
+  const EngineConfig& config() const {
+    return config_;
+  }
+
+ private:
+  struct Sequence {
+    int id;
+    Request request;
+    std::vector<int> pages;
+    // The nodes of the prefix cache held, whose pages are the first pages.
+    std::vector<PrefixCache::Node*> cached;
+    // The prompt tokens in the cache.
+    int num_prefilled{0};
+    // The tokens returned.
+    int num_generated{0};
+    // The token sampled and not yet returned, fed to the next step.
+    std::optional<array> next;
+    bool finished{false};
+  };
+
+  void admit();
+  int pages_needed(const Request& request) const;
+  array run_model(
+      const std::vector<Sequence*>& seqs,
+      const array& tokens,
+      const std::vector<int>& context_lens);
+  array sample(const array& logits, const std::vector<Sequence*>& seqs);
+  void finish(Sequence& seq);
+
+  Model model_;
+  EngineConfig config_;
+  int max_pages_;
+  std::vector<array> k_pages_;
+  std::vector<array> v_pages_;
+  std::vector<int> free_pages_;
+  PrefixCache prefix_cache_;
+  std::deque<std::unique_ptr<Sequence>> waiting_;
+  std::vector<std::unique_ptr<Sequence>> running_;
+  int next_id_{0};
+};
+
+} // namespace mlx::core::serve
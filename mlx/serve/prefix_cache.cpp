@@ -0,0 +1,149 @@
+// Copyright © 2025 Apple Inc.
+
+#include <algorithm>
+#include <queue>
+
+#include "mlx/serve/prefix_cache.h"
+
+namespace mlx::core::serve {
+
+namespace {
+
+struct BlockHash {
+  size_t operator()(const std::vector<int>& block) const {
+    // FNV-1a over the tokens of the page.
+    uint64_t h = 14695981039346656037ull;
+    for (int t : block) {
+      h = (h ^ static_cast<uint32_t>(t)) * 1099511628211ull;
+    }
+    return h;
+  }
+};
+
+} // namespace
+
+struct PrefixCache::Node {
+  int page{-1};
+  Node* parent{nullptr};
+  std::unordered_map<std::vector<int>, std::unique_ptr<Node>, BlockHash>
+      children;
+  // The requests holding the node.
+  int refs{0};
+  uint64_t last_use{0};
+
+  bool is_leaf() const {
+    return children.empty() && parent != nullptr;
+  }
+};
+
+PrefixCache::PrefixCache(int page_size)
+    : page_size_(page_size), root_(std::make_unique<Node>()) {}
+
+PrefixCache::~PrefixCache() = default;
+
+int PrefixCache::page(const Node* node) {
+  return node->page;
+}
+
+void PrefixCache::touch(Node* node) {
+  node->last_use = ++clock_;
+}
+
+std::vector<PrefixCache::Node*> PrefixCache::match(
+    const std::vector<int>& tokens,
+    int max_tokens) {
+  std::vector<Node*> path;
+  Node* node = root_.get();
+  std::vector<int> block(page_size_);
+  for (int start = 0; start + page_size_ <= max_tokens; start += page_size_) {
+    std::copy(
+        tokens.begin() + start,
+        tokens.begin() + start + page_size_,
+        block.begin());
+    auto it = node->children.find(block);
+    if (it == node->children.end()) {
+      break;
+    }
+    node = it->second.get();
+    num_evictable_ -= node->refs == 0;
+    node->refs++;
+    touch(node);
+    path.push_back(node);
+  }
+  return path;
+}
+
+void PrefixCache::insert(
+    const std::vector<int>& tokens,
+    int num_tokens,
+    const std::vector<int>& pages,
+    std::vector<Node*>& path) {
+  Node* node = path.empty() ? root_.get() : path.back();
+  std::vector<int> block(page_size_);
+  for (int i = path.size(); (i + 1) * page_size_ <= num_tokens; ++i) {
+    std::copy(
+        tokens.begin() + i * page_size_,
+        tokens.begin() + (i + 1) * page_size_,
+        block.begin());
+    if (node->children.count(block)) {
+      break;
+    }
+    auto child = std::make_unique<Node>();
+    child->page = pages[i];
+    child->parent = node;
+    child->refs = 1;
+    touch(child.get());
+    node = node->children.emplace(block, std::move(child)).first->second.get();
+    num_nodes_++;
+    path.push_back(node);
+  }
+}
+
+void PrefixCache::release(const std::vector<Node*>& path) {
+  // From the leaf up so the parents are still touched after their children.
+  for (auto it = path.rbegin(); it != path.rend(); ++it) {
+    (*it)->refs--;
+    touch(*it);
+    num_evictable_ += (*it)->refs == 0;
+  }
+}
+
+std::vector<int> PrefixCache::evict(int n) {
+  std::vector<int> pages;
+  if (n <= 0 || num_evictable_ == 0) {
+    return pages;
+  }
+  auto older = [](Node* a, Node* b) { return a->last_use > b->last_use; };
+  std::priority_queue<Node*, std::vector<Node*>, decltype(older)> leaves(
+      older);
+  std::vector<Node*> stack = {root_.get()};
+  while (!stack.empty()) {
+    Node* node = stack.back();
+    stack.pop_back();
+    if (node->refs == 0 && node->is_leaf()) {
+      leaves.push(node);
+    }
+    for (auto& [_, child] : node->children) {
+      stack.push_back(child.get());
+    }
+  }
+  while (static_cast<int>(pages.size()) < n && !leaves.empty()) {
+    Node* node = leaves.top();
+    leaves.pop();
+    Node* parent = node->parent;
+    pages.push_back(node->page);
+    num_nodes_--;
+    num_evictable_--;
+    auto it = std::find_if(
+        parent->children.begin(), parent->children.end(), [&](auto& c) {
+          return c.second.get() == node;
+        });
+    parent->children.erase(it);
+    if (parent->refs == 0 && parent->is_leaf()) {
+      leaves.push(parent);
+    }
+  }
+  return pages;
+}
+
+} // namespace mlx::core::serve
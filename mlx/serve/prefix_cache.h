@@ -0,0 +1,76 @@
+// Copyright © 2025 Apple Inc.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace mlx::core::serve {
+
+/**
+ * An index of the full pages of the key value cache by the tokens before and
+ * in them, so requests starting with the same tokens share their pages.
+ *
+ * It is a radix tree with an edge per page: a node holds the page of the
+ * page_size tokens of its edge following those of its parents. The pages of
+ * the tree are only read, a request writes its tokens after the shared pages
+ * to its own ones. A page stays in the tree once its requests are done, until
+ * it is evicted in least recently used order to make room for new requests.
+ */
+class PrefixCache {
+ public:
+  struct Node;
+
+  explicit PrefixCache(int page_size);
+  ~PrefixCache();
+
+  PrefixCache(const PrefixCache&) = delete;
+  PrefixCache& operator=(const PrefixCache&) = delete;
+
+  // Find the longest path of the tree matching the full pages of the first
+  // |max_tokens| of |tokens| and hold its nodes.
+  std::vector<Node*> match(const std::vector<int>& tokens, int max_tokens);
+
+  // Add the full pages of the first |num_tokens| of |tokens| stored in
+  // |pages| after the held nodes |path|, which is extended with the new
+  // nodes. The pages of the new nodes are owned by the tree. It stops at a
+  // page cached by another request in the meantime, whose copy stays owned by
+  // the caller.
+  void insert(
+      const std::vector<int>& tokens,
+      int num_tokens,
+      const std::vector<int>& pages,
+      std::vector<Node*>& path);
+
+  // Let go of the nodes held by a request.
+  void release(const std::vector<Node*>& path);
+
+  // Remove up to |n| pages no request holds, least recently used first, and
+  // return them.
+  std::vector<int> evict(int n);
+
+  // The pages no request holds, which can all be evicted as a request
+  // holding a node holds its parents.
+  int num_evictable() const {
+    return num_evictable_;
+  }
+  // The pages in the tree.
+  int num_pages() const {
+    return num_nodes_;
+  }
+
+  static int page(const Node* node);
+
+ private:
+  void touch(Node* node);
+
+  int page_size_;
+  std::unique_ptr<Node> root_;
+  uint64_t clock_{0};
+  int num_nodes_{0};
+  int num_evictable_{0};
+};
+
+} // namespace mlx::core::serve
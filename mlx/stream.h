@@ -9,7 +9,20 @@ namespace mlx::core {
 struct Stream {
   int index;
   Device device;
+  // The higher the more urgent, the work of a GPU stream is run before the
+  // work of the streams of lower priority on the same GPU.
+  int priority{0};
+  // The fraction of the SMs of the GPU the work of a GPU stream runs on, 1
+  // for all of them.
+  float sm_fraction{1.0f};
   explicit Stream(int index, Device device) : index(index), device(device) {}
+  explicit Stream(int index, Device device, int priority)
+      : index(index), device(device), priority(priority) {}
+  explicit Stream(int index, Device device, int priority, float sm_fraction)
+      : index(index),
+        device(device),
+        priority(priority),
+        sm_fraction(sm_fraction) {}
 };
 
 /** Get the default stream for the given device. */
@@ -18,12 +31,28 @@ Stream default_stream(Device d);
 /** Make the stream the default for its device. */
 void set_default_stream(Stream s);
 
-/** Make a new stream on the given device. */
-Stream new_stream(Device d);
+/**
+ * Make a new stream on the given device. The priority only applies to CUDA
+ * streams, which support a few levels, and is clamped to them.
+ *
+ * A CUDA stream with an SM fraction below 1 runs on a partition of the SMs
+ * of its own, in a green context with CUDA 12.4 and later, so the other
+ * streams can not take them. The partitions of the streams are disjoint and
+ * rounded up to the granularity of the GPU, the streams without one use all
+ * the SMs. The SM fraction is ignored by the other backends.
+ */
+Stream new_stream(Device d, int priority = 0, float sm_fraction = 1.0f);
 
 /** Get the stream with the given index. */
 Stream get_stream(int index);
 
+/**
+ * Run the thread of the CPU stream on the cores of the given NUMA node and
+ * allocate the outputs of the stream from its memory, -1 lets the stream
+ * use all the nodes.
+ */
+void set_numa_node(Stream s, int node);
+
 inline bool operator==(const Stream& lhs, const Stream& rhs) {
   return lhs.index == rhs.index;
 }
@@ -1,16 +1,25 @@
 // Copyright © 2023-2024 Apple Inc.
 #include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
 #include <deque>
 #include <future>
+#include <iostream>
+#include <mutex>
 #include <numeric>
 #include <set>
 #include <sstream>
 #include <stack>
+#include <typeinfo>
 #include <unordered_map>
 #include <unordered_set>
 
+#include "mlx/backend/cpu/encoder.h"
 #include "mlx/backend/cpu/eval.h"
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/backend/gpu/eval.h"
+#include "mlx/fast_primitives.h"
 #include "mlx/fence.h"
 #include "mlx/memory.h"
 #include "mlx/ops.h"
@@ -36,6 +45,315 @@ class Synchronizer : public Primitive {
   DEFINE_NAME(Synchronize);
 };
 
+namespace {
+
+// The order of the tape built for a graph, as the indices of its arrays in
+// the order they are first visited by the DFS.
+struct Schedule {
+  size_t num_nodes;
+  size_t num_edges;
+  std::vector<int> order;
+};
+
+inline uint64_t hash_combine(uint64_t seed, uint64_t value) {
+  return seed ^ (value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2));
+}
+
+// Hashed when the DFS leaves an array, so the hash tells apart the graphs
+// whose arrays are visited in the same order from different parents.
+constexpr uint64_t dfs_pop_marker = ~uint64_t(0);
+
+// The hash of an array of the graph, with the primitive and stream of the
+// unscheduled ones.
+uint64_t node_hash(const array& a) {
+  uint64_t h = hash_combine(static_cast<uint64_t>(a.dtype().val()), a.ndim());
+  for (auto dim : a.shape()) {
+    h = hash_combine(h, dim);
+  }
+  if (a.status() == array::Status::unscheduled) {
+    h = hash_combine(h, typeid(a.primitive()).hash_code());
+    h = hash_combine(h, a.primitive().stream().index + 1);
+    h = hash_combine(h, a.siblings().size());
+  }
+  return h;
+}
+
+// Whether each array of |tape| appears once and after its unscheduled
+// inputs, the tape runs from its back to its front.
+bool runs_after_inputs(const std::deque<array>& tape) {
+  std::unordered_map<std::uintptr_t, size_t> positions;
+  for (size_t i = 0; i < tape.size(); ++i) {
+    if (!positions.emplace(tape[i].id(), i).second) {
+      return false;
+    }
+    for (auto& s : tape[i].siblings()) {
+      positions.emplace(s.id(), i);
+    }
+  }
+  for (size_t i = 0; i < tape.size(); ++i) {
+    for (auto& in : tape[i].inputs()) {
+      if (in.status() != array::Status::unscheduled) {
+        continue;
+      }
+      auto it = positions.find(in.id());
+      if (it == positions.end() || it->second <= i) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// The schedules of the recently evaluated graphs by hash of their structure,
+// the graphs of a training loop are usually the same at each step.
+std::unordered_map<uint64_t, Schedule>& schedule_cache() {
+  thread_local std::unordered_map<uint64_t, Schedule> cache;
+  return cache;
+}
+
+// The cost of the CPU fallbacks, updated from the CPU stream threads.
+struct GPUFallbacks {
+  std::mutex mtx;
+  std::unordered_map<std::string, GPUFallbackInfo> info;
+  std::unordered_set<std::string> warned;
+};
+
+GPUFallbacks& gpu_fallbacks() {
+  static GPUFallbacks fallbacks;
+  return fallbacks;
+}
+
+// The names of the primitives in MLX_GPU_CPU_FALLBACK_PRIMITIVES, separated
+// by commas, which fall back as if the GPU backend did not implement them.
+const std::unordered_set<std::string>& forced_fallbacks() {
+  static std::unordered_set<std::string> names = []() {
+    std::unordered_set<std::string> names;
+    if (auto value = std::getenv("MLX_GPU_CPU_FALLBACK_PRIMITIVES"); value) {
+      std::istringstream ss(value);
+      std::string name;
+      while (std::getline(ss, name, ',')) {
+        if (!name.empty()) {
+          names.insert(name);
+        }
+      }
+    }
+    return names;
+  }();
+  return names;
+}
+
+// Move the primitive of |a| to the CPU when the GPU backend does not
+// implement it. The fences between the streams are then inserted as for
+// any other input on another stream. The primitive itself is moved, so the
+// siblings of |a| and the graphs which share it, such as a retained graph
+// evaluated again, also run on the CPU from then on.
+bool fallback_to_cpu(array& a) {
+  if (!env::gpu_cpu_fallback() || a.primitive().device() != Device::gpu) {
+    return false;
+  }
+  auto name = a.primitive().name();
+  auto& forced = forced_fallbacks();
+  if (gpu::is_supported(a.primitive()) && forced.find(name) == forced.end()) {
+    return false;
+  }
+  a.primitive().set_stream(default_stream(Device::cpu));
+  if (env::gpu_cpu_fallback() < 2) {
+    return true;
+  }
+  auto& fallbacks = gpu_fallbacks();
+  std::lock_guard lock(fallbacks.mtx);
+  if (fallbacks.warned.insert(name).second) {
+    std::cerr << "[eval] " << name << " has no GPU implementation and runs "
+              << "on the CPU, see mx.gpu_fallback_info() for the cost."
+              << std::endl;
+  }
+  return true;
+}
+
+// The bytes of the outputs of the primitive of |a|.
+size_t output_bytes(const array& a) {
+  size_t bytes = a.nbytes();
+  for (auto& s : a.siblings()) {
+    bytes += s.nbytes();
+  }
+  return bytes;
+}
+
+// The order in which to run the unscheduled arrays of the graph of
+// |outputs| to free the intermediates the earliest. The arrays are run
+// depth first, so a layer of the gradient of a model runs before the next
+// one and frees the activations it reads. The inputs of an array run in the
+// order of a Sethi-Ullman labelling: first the ones whose graph holds the
+// most memory at once net of its output, and the smaller outputs first on
+// ties. The graph of an input is estimated as if it were a tree.
+std::vector<array> memory_order(const std::vector<array>& outputs) {
+  struct Estimate {
+    size_t peak;
+    size_t out;
+  };
+  std::unordered_map<std::uintptr_t, Estimate> estimates;
+  auto unscheduled = [](const array& a) {
+    return a.status() == array::Status::unscheduled;
+  };
+  auto ordered_inputs = [&](const array& a) {
+    std::vector<array> inputs;
+    std::unordered_set<std::uintptr_t> seen;
+    for (auto& in : a.inputs()) {
+      if (unscheduled(in) && seen.insert(in.id()).second) {
+        inputs.push_back(in);
+      }
+    }
+    std::sort(inputs.begin(), inputs.end(), [&](auto& x, auto& y) {
+      auto& ex = estimates[x.id()];
+      auto& ey = estimates[y.id()];
+      return ex.peak - ex.out > ey.peak - ey.out ||
+          (ex.peak - ex.out == ey.peak - ey.out && ex.out < ey.out);
+    });
+    return inputs;
+  };
+
+  // Estimate the memory of the graph of each array after its inputs
+  std::vector<std::pair<array, bool>> stack;
+  for (auto& o : outputs) {
+    if (unscheduled(o)) {
+      stack.emplace_back(o, false);
+    }
+  }
+  while (!stack.empty()) {
+    auto [a, expanded] = stack.back();
+    if (estimates.find(a.id()) != estimates.end()) {
+      stack.pop_back();
+      continue;
+    }
+    if (!expanded) {
+      stack.back().second = true;
+      for (auto& in : a.inputs()) {
+        if (unscheduled(in) && estimates.find(in.id()) == estimates.end()) {
+          stack.emplace_back(in, false);
+        }
+      }
+      continue;
+    }
+    stack.pop_back();
+    size_t peak = 0;
+    size_t held = 0;
+    for (auto& in : ordered_inputs(a)) {
+      auto& e = estimates[in.id()];
+      peak = std::max(peak, held + e.peak);
+      held += e.out;
+    }
+    size_t out = output_bytes(a);
+    Estimate e{std::max(peak, held + out), out};
+    estimates[a.id()] = e;
+    for (auto& s : a.siblings()) {
+      estimates[s.id()] = e;
+    }
+  }
+
+  // Run each array after its ordered inputs
+  struct Frame {
+    array a;
+    std::vector<array> inputs;
+    int next;
+  };
+  std::vector<array> order;
+  std::unordered_set<std::uintptr_t> visited;
+  std::vector<Frame> frames;
+  auto visit = [&](const array& a) {
+    visited.insert(a.id());
+    for (auto& s : a.siblings()) {
+      visited.insert(s.id());
+    }
+    frames.push_back({a, ordered_inputs(a), 0});
+  };
+  for (auto& o : outputs) {
+    if (!unscheduled(o) || visited.find(o.id()) != visited.end()) {
+      continue;
+    }
+    visit(o);
+    while (!frames.empty()) {
+      auto& f = frames.back();
+      if (f.next < f.inputs.size()) {
+        auto in = f.inputs[f.next++];
+        if (visited.find(in.id()) == visited.end()) {
+          visit(in);
+        }
+        continue;
+      }
+      order.push_back(std::move(f.a));
+      frames.pop_back();
+    }
+  }
+  return order;
+}
+
+// The most memory held at once by the arrays made by running |order|. The
+// |outputs| are kept and the other arrays are freed after their last use,
+// the buffers shared by views or donated are counted more than once.
+size_t peak_memory(
+    const std::vector<array>& order,
+    const std::vector<array>& outputs) {
+  std::unordered_map<std::uintptr_t, int> uses;
+  for (auto& a : order) {
+    for (auto& o : a.outputs()) {
+      uses.emplace(o.id(), 0);
+    }
+  }
+  auto used_inputs = [&uses](const array& a) {
+    std::vector<array> inputs;
+    std::unordered_set<std::uintptr_t> seen;
+    for (auto& in : a.inputs()) {
+      if (uses.find(in.id()) != uses.end() && seen.insert(in.id()).second) {
+        inputs.push_back(in);
+      }
+    }
+    return inputs;
+  };
+  for (auto& a : order) {
+    for (auto& in : used_inputs(a)) {
+      uses[in.id()]++;
+    }
+  }
+  std::unordered_set<std::uintptr_t> kept;
+  for (auto& o : outputs) {
+    kept.insert(o.id());
+  }
+
+  size_t live = 0;
+  size_t peak = 0;
+  auto release = [&](const array& a) {
+    if (uses[a.id()] == 0 && kept.find(a.id()) == kept.end()) {
+      live -= a.nbytes();
+    }
+  };
+  for (auto& a : order) {
+    live += output_bytes(a);
+    peak = std::max(peak, live);
+    for (auto& in : used_inputs(a)) {
+      uses[in.id()]--;
+      release(in);
+    }
+    for (auto& o : a.outputs()) {
+      release(o);
+    }
+  }
+  return peak;
+}
+
+} // namespace
+
+std::unordered_map<std::string, GPUFallbackInfo> gpu_fallback_info() {
+  auto& fallbacks = gpu_fallbacks();
+  std::lock_guard lock(fallbacks.mtx);
+  return fallbacks.info;
+}
+
+void reset_gpu_fallback_info() {
+  auto& fallbacks = gpu_fallbacks();
+  std::lock_guard lock(fallbacks.mtx);
+  fallbacks.info.clear();
+}
+
 // Initialize the static tracing members from transforms_impl.h
 //
 // These are used to implement the in_tracing() function the returns true if we
@@ -64,6 +382,11 @@ array eval_impl(std::vector<array> outputs, bool async) {
   // Map of array id that needs fence and stream it's computed on
   std::unordered_map<uintptr_t, uint32_t> needs_fence;
 
+  // The arrays moved to the CPU because the GPU does not implement them,
+  // and the arrays computed on the GPU which they use
+  std::unordered_set<uintptr_t> fallbacks;
+  std::unordered_set<uintptr_t> host_inputs;
+
   auto synchronizer = array(
       {}, bool_, std::make_shared<Synchronizer>(stream), std::move(outputs));
 
@@ -74,9 +397,25 @@ array eval_impl(std::vector<array> outputs, bool async) {
   std::unordered_map<uint32_t, Event> events;
   events.emplace(stream.index, Event{stream});
 
+  // The active memory once the tasks were waited for under memory pressure
+  size_t drained_memory = 0;
+
   {
-    // Record the degree of each input
-    std::unordered_map<std::uintptr_t, int> cache;
+    // Record the degree of each input and its index in the order of the DFS,
+    // the siblings have the same degree and index
+    struct Node {
+      int degree;
+      int index;
+    };
+    std::unordered_map<std::uintptr_t, Node> cache;
+
+    // The arrays in the order of the DFS and a hash of the tree of the DFS,
+    // its other edges and the arrays, which is the key of the schedule
+    // cache. Only the unscheduled arrays, which are not detached, are read
+    // from |nodes|.
+    std::vector<std::reference_wrapper<array>> nodes = {synchronizer};
+    uint64_t graph_hash = stream.index;
+    size_t num_edges = 0;
 
     std::stack<std::pair<std::reference_wrapper<array>, int>> dfs;
     dfs.emplace(synchronizer, 0);
@@ -108,6 +447,14 @@ array eval_impl(std::vector<array> outputs, bool async) {
                 "Please file an issue here:\n"
                 "https://github.com/ml-explore/mlx/issues.");
           }
+          if (fallback_to_cpu(in)) {
+            fallbacks.insert(in.id());
+            for (auto& x : in.inputs()) {
+              if (x.status() == array::Status::unscheduled) {
+                host_inputs.insert(x.id());
+              }
+            }
+          }
           if (a.primitive().stream() != in.primitive().stream()) {
             needs_fence.emplace(in.id(), in.primitive().stream().index);
           }
@@ -115,18 +462,25 @@ array eval_impl(std::vector<array> outputs, bool async) {
 
         // All siblings have the same degree
         auto cache_it = cache.find(in.id());
+        int index;
         if (cache_it == cache.end()) {
+          index = nodes.size();
+          nodes.push_back(in);
           dfs.emplace(in, 0);
-          cache.insert({in.id(), 1});
+          cache.insert({in.id(), {1, index}});
           for (auto& s : in.siblings()) {
-            cache.insert({s.id(), 1});
+            cache.insert({s.id(), {1, index}});
           }
+          graph_hash = hash_combine(graph_hash, node_hash(in));
         } else {
-          cache_it->second++;
+          index = cache_it->second.index;
+          cache_it->second.degree++;
           for (auto& s : in.siblings()) {
-            cache[s.id()]++;
+            cache[s.id()].degree++;
           }
         }
+        graph_hash = hash_combine(graph_hash, index);
+        num_edges++;
         continue;
       }
       if ((a.status() != array::Status::unscheduled) && !a.is_tracer() &&
@@ -134,13 +488,48 @@ array eval_impl(std::vector<array> outputs, bool async) {
         // If the array is evaluated and is no longer a tracer, detach it
         a.detach();
       }
+      graph_hash = hash_combine(graph_hash, dfs_pop_marker);
       dfs.pop();
     }
 
+    // Replay the schedule of the same graph if it was evaluated recently,
+    // and rebuild it if an array would run before its inputs.
+    auto& schedules = schedule_cache();
+    int max_schedules = env::eval_schedule_cache_size();
+    if (auto it = schedules.find(graph_hash); it != schedules.end() &&
+        it->second.num_nodes == nodes.size() &&
+        it->second.num_edges == num_edges) {
+      for (int index : it->second.order) {
+        tape.push_back(nodes[index]);
+      }
+      if (runs_after_inputs(tape)) {
+        cache.clear();
+      } else {
+        tape.clear();
+      }
+    }
+    Schedule schedule{nodes.size(), num_edges, {0}};
+    bool cache_schedule = tape.empty() && max_schedules > 0;
+
+    // Or run the arrays in the order which frees memory the earliest
+    if (tape.empty() && env::eval_memory_schedule()) {
+      tape.push_back(synchronizer);
+      auto order = memory_order(synchronizer.inputs());
+      for (auto it = order.rbegin(); it != order.rend(); ++it) {
+        if (cache_schedule) {
+          schedule.order.push_back(cache[it->id()].index);
+        }
+        tape.push_back(std::move(*it));
+      }
+      cache.clear();
+    }
+
     // Build the tape in BFS order with a width limit
     int max_width = env::bfs_max_width();
     dfs = std::stack<std::pair<std::reference_wrapper<array>, int>>();
-    tape.push_back(synchronizer);
+    if (tape.empty()) {
+      tape.push_back(synchronizer);
+    }
     for (int i = 0; !cache.empty() && (i < tape.size() || !dfs.empty());) {
       auto& a = (i >= tape.size()) ? dfs.top().first.get() : tape[i];
       int j = 0;
@@ -164,16 +553,19 @@ array eval_impl(std::vector<array> outputs, bool async) {
         }
 
         auto it = cache.find(in.id());
-        it->second -= 1;
+        it->second.degree -= 1;
 
-        if (it->second != 0) {
+        if (it->second.degree != 0) {
           for (auto& s : in.siblings()) {
-            cache[s.id()] -= 1;
+            cache[s.id()].degree -= 1;
           }
           continue;
         }
 
         // Remove input and siblings from cache
+        if (cache_schedule) {
+          schedule.order.push_back(it->second.index);
+        }
         cache.erase(it);
         for (auto& s : in.siblings()) {
           cache.erase(s.id());
@@ -182,6 +574,14 @@ array eval_impl(std::vector<array> outputs, bool async) {
         tape.push_back(in);
       }
     }
+    if (cache_schedule) {
+      // Drop the old schedules when full, the recent ones are cached again
+      // at their next evaluation.
+      if (schedules.size() >= static_cast<size_t>(max_schedules)) {
+        schedules.clear();
+      }
+      schedules.insert_or_assign(graph_hash, std::move(schedule));
+    }
   }
 
   while (!tape.empty()) {
@@ -219,13 +619,53 @@ array eval_impl(std::vector<array> outputs, bool async) {
 
     if (arr.primitive().device() == Device::gpu) {
       gpu::eval(arr);
+      if (!host_inputs.empty()) {
+        if (host_inputs.count(arr.id())) {
+          gpu::prefetch_to_host(arr);
+        }
+        for (auto& s : arr.siblings()) {
+          if (host_inputs.count(s.id())) {
+            gpu::prefetch_to_host(s);
+          }
+        }
+      }
+    } else if (fallbacks.count(arr.id())) {
+      size_t transfer_bytes = 0;
+      for (auto& in : arr.inputs()) {
+        if (host_inputs.count(in.id()) &&
+            in.primitive().device() == Device::gpu) {
+          transfer_bytes += in.nbytes();
+        }
+      }
+      auto& encoder = cpu::get_command_encoder(stream);
+      auto start = std::make_shared<std::chrono::steady_clock::time_point>();
+      encoder.dispatch(
+          [start]() { *start = std::chrono::steady_clock::now(); });
+      cpu::eval(arr);
+      encoder.dispatch([start,
+                        name = std::string(arr.primitive().name()),
+                        transfer_bytes]() {
+        std::chrono::duration<double> time =
+            std::chrono::steady_clock::now() - *start;
+        auto& fallbacks = gpu_fallbacks();
+        std::lock_guard lock(fallbacks.mtx);
+        auto& info = fallbacks.info[name];
+        info.count++;
+        info.transfer_bytes += transfer_bytes;
+        info.cpu_time += time.count();
+      });
     } else {
       cpu::eval(arr);
     }
 
-    if (scheduler::n_active_tasks() > MAX_ACTIVE_TASKS ||
-        (get_active_memory() > get_memory_limit() &&
-         scheduler::n_active_tasks() > 0)) {
+    // Over the memory limit the scheduling pauses until the running tasks
+    // free their buffers, and again only once the memory grew by an eighth
+    // of the limit so the arrays which stay alive do not pause every step.
+    size_t memory_limit = get_memory_limit();
+    size_t active_memory = get_active_memory();
+    bool memory_pressure = active_memory > memory_limit &&
+        active_memory > drained_memory + memory_limit / 8;
+    if (scheduler::n_active_tasks() > MAX_ACTIVE_TASKS || memory_pressure) {
       // Commit any open streams
       for (auto& [_, e] : events) {
         if (e.stream().device == Device::gpu) {
@@ -233,9 +673,12 @@ array eval_impl(std::vector<array> outputs, bool async) {
         }
       }
       scheduler::wait_for_one();
-      while (get_active_memory() > get_memory_limit() &&
-             scheduler::n_active_tasks() > 0) {
-        scheduler::wait_for_one();
+      if (memory_pressure) {
+        while (get_active_memory() > memory_limit &&
+               scheduler::n_active_tasks() > 0) {
+          scheduler::wait_for_completion();
+        }
+        drained_memory = get_active_memory();
       }
     }
 
@@ -274,18 +717,105 @@ array eval_impl(std::vector<array> outputs, bool async) {
   return synchronizer;
 }
 
-void async_eval(std::vector<array> outputs) {
-  if (outputs.empty()) {
+struct EvalFuture::State {
+  std::mutex mtx;
+  std::condition_variable cond;
+  // The streams which have not completed their part of the evaluation.
+  int pending;
+  // Whether the callbacks have run.
+  bool done{false};
+  std::vector<std::function<void()>> callbacks;
+
+  // Called from each stream once the work of the evaluation in it is done,
+  // the waiters are woken up after the callbacks, including the ones added
+  // by the callbacks.
+  void complete() {
+    std::unique_lock lk(mtx);
+    if (--pending > 0) {
+      return;
+    }
+    while (!callbacks.empty()) {
+      auto ready = std::move(callbacks);
+      callbacks.clear();
+      lk.unlock();
+      for (auto& callback : ready) {
+        callback();
+      }
+      lk.lock();
+    }
+    done = true;
+    lk.unlock();
+    cond.notify_all();
+  }
+};
+
+bool EvalFuture::done() const {
+  if (!state_) {
+    return true;
+  }
+  std::lock_guard lk(state_->mtx);
+  return state_->done;
+}
+
+void EvalFuture::wait() const {
+  if (!state_) {
     return;
   }
+  {
+    std::unique_lock lk(state_->mtx);
+    state_->cond.wait(lk, [this] { return state_->done; });
+  }
+  scheduler::check_error();
+}
 
-  if (std::none_of(outputs.begin(), outputs.end(), [](array& x) {
+void EvalFuture::then(std::function<void()> callback) const {
+  if (state_) {
+    std::lock_guard lk(state_->mtx);
+    if (!state_->done) {
+      state_->callbacks.push_back(std::move(callback));
+      return;
+    }
+  }
+  callback();
+}
+
+EvalFuture async_eval(std::vector<array> outputs) {
+  // The streams whose work enqueued so far includes the evaluation.
+  std::vector<Stream> streams;
+  if (std::any_of(outputs.begin(), outputs.end(), [](array& x) {
         return x.status() == array::Status::unscheduled;
       })) {
-    return;
+    streams.push_back(eval_impl(std::move(outputs), true).event().stream());
+  } else {
+    // The outputs are done or scheduled by a previous evaluation.
+    for (auto& x : outputs) {
+      auto& e = x.event();
+      if (e.valid() && !e.is_signaled() &&
+          std::find(streams.begin(), streams.end(), e.stream()) ==
+              streams.end()) {
+        streams.push_back(e.stream());
+      }
+    }
+  }
+  if (streams.empty()) {
+    return EvalFuture();
+  }
+
+  auto state = std::make_shared<EvalFuture::State>();
+  state->pending = streams.size();
+  for (auto& s : streams) {
+    auto complete = [state]() { state->complete(); };
+    if (s.device == Device::gpu) {
+      gpu::add_completed_handler(s, std::move(complete));
+    } else {
+      scheduler::enqueue(s, std::move(complete));
+    }
   }
+  return EvalFuture(std::move(state));
+}
 
-  eval_impl(std::move(outputs), true);
+size_t projected_peak_memory(const std::vector<array>& outputs) {
+  return get_active_memory() + peak_memory(memory_order(outputs), outputs);
 }
 
 void eval(std::vector<array> outputs) {
@@ -303,6 +833,84 @@ void eval(std::vector<array> outputs) {
   }
 
   eval_impl(std::move(outputs), false).event().wait();
+  scheduler::check_error();
+}
+
+namespace {
+
+// The background stream reading the loads prefetched to |d|.
+Stream prefetch_stream(Device d) {
+  static std::mutex mtx;
+  static std::vector<Stream> streams;
+  std::lock_guard lock(mtx);
+  for (auto& s : streams) {
+    if (s.device == d) {
+      return s;
+    }
+  }
+  return streams.emplace_back(new_stream(d));
+}
+
+// The unscheduled loads in the graph of |a| which are not in |seen|.
+std::vector<array> unscheduled_loads(
+    const array& a,
+    std::unordered_set<std::uintptr_t>& seen) {
+  std::vector<array> loads;
+  std::vector<array> stack = {a};
+  while (!stack.empty()) {
+    auto x = std::move(stack.back());
+    stack.pop_back();
+    if (x.status() != array::Status::unscheduled || !x.has_primitive() ||
+        !seen.insert(x.id()).second) {
+      continue;
+    }
+    if (typeid(x.primitive()) == typeid(Load)) {
+      loads.push_back(std::move(x));
+      continue;
+    }
+    for (auto& in : x.inputs()) {
+      stack.push_back(in);
+    }
+  }
+  return loads;
+}
+
+} // namespace
+
+EvalFuture prefetch(
+    const std::vector<array>& arrays,
+    StreamOrDevice s /* = {} */,
+    std::optional<size_t> max_bytes /* = std::nullopt */) {
+  Stream stream = std::holds_alternative<Stream>(s)
+      ? std::get<Stream>(s)
+      : prefetch_stream(
+            to_stream(s, cu::is_available() ? Device::gpu : Device::cpu)
+                .device);
+  if (stream.device == Device::gpu && !cu::is_available()) {
+    throw std::invalid_argument("[prefetch] Must run on a CPU stream.");
+  }
+
+  // The loads of each array are scheduled together, in the order of the
+  // arrays, and the ones over the budget are only moved to the stream.
+  std::unordered_set<std::uintptr_t> seen;
+  size_t scheduled_bytes = 0;
+  bool over_budget = false;
+  EvalFuture future;
+  for (auto& a : arrays) {
+    auto loads = unscheduled_loads(a, seen);
+    size_t bytes = 0;
+    for (auto& load : loads) {
+      load.primitive().set_stream(stream);
+      bytes += load.nbytes();
+    }
+    over_budget |= max_bytes && scheduled_bytes + bytes > *max_bytes;
+    if (loads.empty() || over_budget) {
+      continue;
+    }
+    scheduled_bytes += bytes;
+    future = async_eval(std::move(loads));
+  }
+  return future;
 }
 
 std::pair<std::vector<array>, std::vector<array>> vjp(
@@ -1030,6 +1638,233 @@ std::function<std::vector<array>(const std::vector<array>&)> custom_vjp(
   return custom_function(fun, fun_vjp, std::nullopt, std::nullopt);
 }
 
+namespace {
+
+// The graph of a checkpointed function recorded as primitives so that it can
+// be replayed without holding on to the intermediate arrays. The values are
+// indexed with the primals first followed by the outputs of the nodes in
+// order and the negative indices refer to the constants.
+struct CheckpointTape {
+  struct Node {
+    std::shared_ptr<Primitive> primitive;
+    std::vector<int> inputs;
+    std::vector<Shape> shapes;
+    std::vector<Dtype> dtypes;
+    bool saved;
+  };
+  bool recorded{false};
+  std::vector<Node> nodes;
+  std::vector<array> constants;
+  std::vector<int> outputs;
+};
+
+// Record the graph from the primals to the outputs in the tape, unless it is
+// already recorded, and return the outputs of the nodes that |save| keeps.
+std::vector<array> record_checkpoint(
+    CheckpointTape& tape,
+    const std::vector<array>& primals,
+    const std::vector<array>& outputs,
+    const std::function<bool(const Primitive&)>& save) {
+  bool record = !tape.recorded;
+  std::unordered_map<std::uintptr_t, int> index;
+  std::unordered_set<std::uintptr_t> untraced;
+  int num_values = 0;
+  int num_constants = 0;
+  for (auto& p : primals) {
+    index.insert({p.id(), num_values++});
+  }
+
+  // The arrays which do not depend on the primals are kept as constants
+  auto constant = [&](const array& a) {
+    auto [it, inserted] = index.insert({a.id(), -1 - num_constants});
+    if (inserted) {
+      num_constants++;
+      if (record) {
+        tape.constants.push_back(a);
+      }
+    }
+    return it->second;
+  };
+
+  std::vector<array> saved;
+  std::function<bool(const array&)> recurse;
+  recurse = [&](const array& a) {
+    if (auto it = index.find(a.id()); it != index.end()) {
+      return it->second >= 0;
+    }
+    if (untraced.find(a.id()) != untraced.end() || !a.has_primitive()) {
+      return false;
+    }
+    bool traced = false;
+    for (auto& in : a.inputs()) {
+      traced |= recurse(in);
+    }
+    if (!traced) {
+      for (auto& s : a.outputs()) {
+        untraced.insert(s.id());
+      }
+      return false;
+    }
+
+    bool keep = save(a.primitive());
+    if (record) {
+      CheckpointTape::Node node{a.primitive_ptr(), {}, {}, {}, keep};
+      for (auto& in : a.inputs()) {
+        auto it = index.find(in.id());
+        node.inputs.push_back(it != index.end() ? it->second : constant(in));
+      }
+      for (auto& o : a.outputs()) {
+        node.shapes.push_back(o.shape());
+        node.dtypes.push_back(o.dtype());
+      }
+      tape.nodes.push_back(std::move(node));
+    } else {
+      for (auto& in : a.inputs()) {
+        if (index.find(in.id()) == index.end()) {
+          constant(in);
+        }
+      }
+    }
+    for (auto& o : a.outputs()) {
+      if (keep) {
+        saved.push_back(o);
+      }
+      index.insert({o.id(), num_values++});
+    }
+    return true;
+  };
+
+  for (auto& out : outputs) {
+    int idx = recurse(out) ? index.at(out.id()) : constant(out);
+    if (record) {
+      tape.outputs.push_back(idx);
+    }
+  }
+  tape.recorded = true;
+  return saved;
+}
+
+// Replay the tape from the primals reusing the outputs and the saved values
+// of the forward pass and run it backwards to compute the vjps.
+std::vector<array> replay_checkpoint(
+    const CheckpointTape& tape,
+    const std::vector<array>& primals,
+    const std::vector<array>& cotangents,
+    const std::vector<array>& outputs) {
+  int num_outputs = tape.outputs.size();
+  std::unordered_map<int, array> known;
+  for (int i = 0; i < num_outputs; i++) {
+    if (tape.outputs[i] >= 0) {
+      known.insert({tape.outputs[i], outputs[i]});
+    }
+  }
+
+  // Recompute the forward pass after it is done like checkpoint does
+  std::vector<array> values = depends(primals, outputs);
+  auto value = [&](int idx) -> const array& {
+    return idx >= 0 ? values[idx] : tape.constants[-1 - idx];
+  };
+  int saved = num_outputs;
+  for (auto& node : tape.nodes) {
+    int start = values.size();
+    if (node.saved) {
+      values.insert(
+          values.end(),
+          outputs.begin() + saved,
+          outputs.begin() + saved + node.shapes.size());
+      saved += node.shapes.size();
+      continue;
+    }
+    bool all_known = true;
+    for (int i = 0; i < node.shapes.size(); i++) {
+      all_known &= known.find(start + i) != known.end();
+    }
+    if (all_known) {
+      for (int i = 0; i < node.shapes.size(); i++) {
+        values.push_back(known.at(start + i));
+      }
+      continue;
+    }
+    std::vector<array> inputs;
+    for (int idx : node.inputs) {
+      inputs.push_back(value(idx));
+    }
+    auto outs = array::make_arrays(
+        node.shapes, node.dtypes, node.primitive, std::move(inputs));
+    values.insert(values.end(), outs.begin(), outs.end());
+  }
+
+  // Run the tape backwards like vjp does
+  std::unordered_map<int, array> cotan_map;
+  auto accumulate = [&cotan_map](int idx, array cotan, Stream s) {
+    if (auto it = cotan_map.find(idx); it != cotan_map.end()) {
+      it->second = add(it->second, cotan, s);
+    } else {
+      cotan_map.insert({idx, std::move(cotan)});
+    }
+  };
+  for (int i = 0; i < num_outputs; i++) {
+    if (tape.outputs[i] >= 0) {
+      accumulate(
+          tape.outputs[i], cotangents[i], default_stream(default_device()));
+    }
+  }
+  for (int n = tape.nodes.size() - 1, end = values.size(); n >= 0; n--) {
+    auto& node = tape.nodes[n];
+    int start = end - node.shapes.size();
+    end = start;
+    if (auto& p = *node.primitive; typeid(p) == typeid(StopGradient)) {
+      continue;
+    }
+
+    auto s = node.primitive->stream();
+    std::vector<array> cotans;
+    bool has_cotans = false;
+    for (int i = 0; i < node.shapes.size(); i++) {
+      if (auto it = cotan_map.find(start + i); it != cotan_map.end()) {
+        cotans.push_back(cotan_map.extract(it).mapped());
+        has_cotans = true;
+      } else {
+        cotans.push_back(zeros_like(values[start + i], s));
+      }
+    }
+    if (!has_cotans) {
+      continue;
+    }
+
+    std::vector<array> inputs;
+    std::vector<int> argnums;
+    for (int i = 0; i < node.inputs.size(); i++) {
+      inputs.push_back(value(node.inputs[i]));
+      if (node.inputs[i] >= 0) {
+        argnums.push_back(i);
+      }
+    }
+    std::vector<array> outs(
+        values.begin() + start, values.begin() + start + node.shapes.size());
+    std::vector<array> vjps;
+    {
+      detail::RetainGraph retain;
+      vjps = node.primitive->vjp(inputs, cotans, argnums, outs);
+    }
+    for (int i = 0; i < argnums.size(); i++) {
+      accumulate(node.inputs[argnums[i]], std::move(vjps[i]), s);
+    }
+  }
+
+  std::vector<array> vjps;
+  for (int i = 0; i < primals.size(); i++) {
+    if (auto it = cotan_map.find(i); it != cotan_map.end()) {
+      vjps.push_back(std::move(it->second));
+    } else {
+      vjps.push_back(zeros_like(primals[i]));
+    }
+  }
+  return vjps;
+}
+
+} // namespace
+
 std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
     std::function<std::vector<array>(const std::vector<array>&)> fun) {
   auto vjp_fun = [fun](
@@ -1043,4 +1878,42 @@ std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
   return custom_vjp(fun, vjp_fun);
 }
 
+std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
+    std::function<std::vector<array>(const std::vector<array>&)> fun,
+    std::function<bool(const Primitive&)> save) {
+  return [fun = std::move(fun),
+          save = std::move(save)](const std::vector<array>& primals) {
+    // The tape is recorded by the first call of the forward, the calls made
+    // by the other transformations only return the same saved outputs.
+    auto tape = std::make_shared<CheckpointTape>();
+    auto forward = [fun, save, tape](const std::vector<array>& primals) {
+      auto outputs = fun(primals);
+      auto saved = record_checkpoint(*tape, primals, outputs, save);
+      outputs.insert(outputs.end(), saved.begin(), saved.end());
+      return outputs;
+    };
+    auto vjp_fun = [tape](
+                       const std::vector<array>& primals,
+                       const std::vector<array>& cotangents,
+                       const std::vector<array>& outputs) {
+      return replay_checkpoint(*tape, primals, cotangents, outputs);
+    };
+    auto outputs = custom_vjp(forward, vjp_fun)(primals);
+    outputs.erase(outputs.begin() + tape->outputs.size(), outputs.end());
+    return outputs;
+  };
+}
+
+bool save_matmuls(const Primitive& p) {
+  auto& t = typeid(p);
+  return t == typeid(Matmul) || t == typeid(AddMM) ||
+      t == typeid(BlockMaskedMM) || t == typeid(GatherMM) ||
+      t == typeid(SegmentedMM) || t == typeid(QuantizedMatmul) ||
+      t == typeid(GatherQMM) || t == typeid(Convolution) ||
+      t == typeid(fast::FusedMatmul) || t == typeid(fast::Fp8Matmul) ||
+      t == typeid(fast::Int8Matmul) ||
+      t == typeid(fast::ScaledDotProductAttention) ||
+      t == typeid(fast::QuantizedScaledDotProductAttention);
+}
+
 } // namespace mlx::core
@@ -2,26 +2,111 @@
 
 #pragma once
 
+#include <functional>
+#include <memory>
 #include <optional>
+#include <string>
+#include <unordered_map>
 
 #include "mlx/array.h"
+#include "mlx/utils.h"
 
 namespace mlx::core {
 
-void async_eval(std::vector<array> outputs);
+/**
+ * The completion of an evaluation started with async_eval. The callbacks
+ * run on the thread which completes the evaluation, the CPU stream thread
+ * or the thread of the GPU completion handlers, so no thread waits for the
+ * evaluations in flight. They must be quick and must not evaluate arrays.
+ */
+class EvalFuture {
+ public:
+  // A future which is already done.
+  EvalFuture() = default;
+
+  // Whether the evaluation is done.
+  bool done() const;
+
+  // Block until the evaluation is done.
+  void wait() const;
+
+  // Call |callback| once the evaluation is done, right away from this thread
+  // if it is done already.
+  void then(std::function<void()> callback) const;
+
+ private:
+  struct State;
+  explicit EvalFuture(std::shared_ptr<State> state)
+      : state_(std::move(state)) {}
+  friend EvalFuture async_eval(std::vector<array> outputs);
+
+  std::shared_ptr<State> state_;
+};
+
+EvalFuture async_eval(std::vector<array> outputs);
 
 template <typename... Arrays, typename = enable_for_arrays_t<Arrays...>>
-void async_eval(Arrays&&... outputs) {
-  async_eval(std::vector<array>{std::forward<Arrays>(outputs)...});
+EvalFuture async_eval(Arrays&&... outputs) {
+  return async_eval(std::vector<array>{std::forward<Arrays>(outputs)...});
 }
 
 void eval(std::vector<array> outputs);
 
+/**
+ * Start reading the arrays loaded from files in the graphs of |arrays|, such
+ * as the weights of a model built from load_safetensors, ahead of their
+ * first use.
+ *
+ * The unscheduled Load primitives are moved to a background I/O stream of
+ * the device of |s|, or to |s| itself when it is a stream, so the
+ * evaluations using them wait for them through fences instead of running
+ * them in turn with their compute. The loads are scheduled in the order of
+ * |arrays|, for instance layer by layer, as long as they add up to at most
+ * |max_bytes| bytes, and the next ones are read on the I/O stream when
+ * first evaluated.
+ * The device defaults to the GPU with the CUDA backend, which reads the
+ * arrays to the GPU through pinned buffers, and to the CPU otherwise.
+ *
+ * Returns the completion of the scheduled loads.
+ */
+EvalFuture prefetch(
+    const std::vector<array>& arrays,
+    StreamOrDevice s = {},
+    std::optional<size_t> max_bytes = std::nullopt);
+
+/**
+ * The peak memory projected for evaluating |outputs| in the order used with
+ * MLX_EVAL_MEMORY_SCHEDULE set, without evaluating them. It is the active
+ * memory and the most memory held at once by the arrays made by the
+ * evaluation, which overestimates the arrays sharing buffers.
+ */
+size_t projected_peak_memory(const std::vector<array>& outputs);
+
 template <typename... Arrays, typename = enable_for_arrays_t<Arrays...>>
 void eval(Arrays&&... outputs) {
   eval(std::vector<array>{std::forward<Arrays>(outputs)...});
 }
 
+/**
+ * The cost of the primitives run on the CPU because the GPU backend does
+ * not implement them, with MLX_GPU_CPU_FALLBACK set. The inputs computed
+ * on the GPU are moved to the host for them. The primitives named in
+ * MLX_GPU_CPU_FALLBACK_PRIMITIVES, separated by commas, fall back too.
+ */
+struct GPUFallbackInfo {
+  // The number of times the primitive ran on the CPU.
+  size_t count{0};
+  // The bytes of the inputs computed on the GPU.
+  size_t transfer_bytes{0};
+  // The time spent running the primitive on the CPU in seconds.
+  double cpu_time{0};
+};
+
+/** The cost of the CPU fallbacks by name of the primitive. */
+std::unordered_map<std::string, GPUFallbackInfo> gpu_fallback_info();
+
+void reset_gpu_fallback_info();
+
 /**
  *  Computes the output and vector-Jacobian product (VJP) of a function.
  *
@@ -226,4 +311,21 @@ std::function<std::vector<array>(const std::vector<array>&)> custom_vjp(
 std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
     std::function<std::vector<array>(const std::vector<array>&)> fun);
 
+/**
+ * Checkpoint the gradient of a function but keep the outputs of the
+ * primitives for which |save| returns true. Only the rest of the intermediate
+ * state is recalculated, from the inputs and the saved outputs, when we need
+ * to compute the gradient.
+ */
+std::function<std::vector<array>(const std::vector<array>&)> checkpoint(
+    std::function<std::vector<array>(const std::vector<array>&)> fun,
+    std::function<bool(const Primitive&)> save);
+
+/**
+ * A checkpoint policy which saves the outputs of the matrix multiplications,
+ * the convolutions and the attention and recomputes the cheap elementwise
+ * operations, reductions and normalizations.
+ */
+bool save_matmuls(const Primitive& p);
+
 } // namespace mlx::core
@@ -31,6 +31,20 @@ Stream to_stream(StreamOrDevice s, Device default_) {
   }
 }
 
+namespace {
+
+thread_local MatmulPrecision matmul_precision_ = MatmulPrecision::Default;
+
+} // namespace
+
+MatmulPrecision default_matmul_precision() {
+  return matmul_precision_;
+}
+
+void set_default_matmul_precision(MatmulPrecision precision) {
+  matmul_precision_ = precision;
+}
+
 void PrintFormatter::print(std::ostream& os, bool val) {
   if (capitalize_bool) {
     os << (val ? "True" : "False");
@@ -37,6 +37,45 @@ struct StreamContext {
   Stream _stream;
 };
 
+/**
+ * The lowest precision the backends may use for the products and the sums of
+ * the matmuls, which they may exceed. Only the CUDA backend uses the reduced
+ * ones, the CPU and Metal gemms always compute at least in the type of the
+ * inputs with a float32 accumulation.
+ */
+enum class MatmulPrecision {
+  // TF32 for float32 on CUDA unless MLX_ENABLE_TF32=0.
+  Default,
+  // Float32 products and sums.
+  Float32,
+  // Float32 inputs rounded to TF32 on the tensor cores.
+  TF32,
+  // Float32 inputs rounded to bfloat16 on the tensor cores.
+  BFloat16,
+  // Float16 sums for float16 inputs, and float32 inputs rounded to float16.
+  Float16,
+};
+
+/** The precision of the matmuls made by the thread. */
+MatmulPrecision default_matmul_precision();
+void set_default_matmul_precision(MatmulPrecision precision);
+
+/** Sets the precision of the matmuls made by the thread in a scope. */
+struct MatmulPrecisionContext {
+ public:
+  explicit MatmulPrecisionContext(MatmulPrecision precision)
+      : _precision(default_matmul_precision()) {
+    set_default_matmul_precision(precision);
+  }
+
+  ~MatmulPrecisionContext() {
+    set_default_matmul_precision(_precision);
+  }
+
+ private:
+  MatmulPrecision _precision;
+};
+
 struct PrintFormatter {
   inline void print(std::ostream& os, bool val);
   inline void print(std::ostream& os, int16_t val);
@@ -132,6 +171,34 @@ inline int bfs_max_width() {
   return bfs_max_width_;
 }
 
+// The number of graph schedules cached by eval, 0 disables the cache.
+inline int eval_schedule_cache_size() {
+  static int eval_schedule_cache_size_ =
+      get_var("MLX_EVAL_SCHEDULE_CACHE_SIZE", 64);
+  return eval_schedule_cache_size_;
+}
+
+// Whether eval runs the arrays depth first, in the order which frees the
+// intermediates the earliest, instead of breadth first. It lowers the peak
+// memory of the gradients of deep models.
+inline bool eval_memory_schedule() {
+  static bool eval_memory_schedule_ = get_var("MLX_EVAL_MEMORY_SCHEDULE", 0);
+  return eval_memory_schedule_;
+}
+
+// The number of entries of the cache of compiled functions, the least
+// recently used is evicted beyond it. 0 does not bound the cache.
+inline int compile_cache_size() {
+  static int compile_cache_size_ = get_var("MLX_COMPILE_CACHE_SIZE", 4096);
+  return compile_cache_size_;
+}
+
+// The number of threads of the pool running the chunks of the CPU kernels.
+inline int cpu_threads(int default_value) {
+  static int cpu_threads_ = get_var("MLX_CPU_THREADS", default_value);
+  return cpu_threads_;
+}
+
 inline int max_ops_per_buffer(int default_value) {
   static int max_ops_per_buffer_ =
       get_var("MLX_MAX_OPS_PER_BUFFER", default_value);
@@ -149,6 +216,68 @@ inline bool metal_fast_synch() {
   return metal_fast_synch;
 }
 
+// The largest ratio of the size of a cached buffer to the requested size for
+// the buffer to be reused, in percent.
+inline int max_cache_overallocation() {
+  static int max_cache_overallocation_ =
+      get_var("MLX_MAX_CACHE_OVERALLOCATION", 200);
+  return max_cache_overallocation_;
+}
+
+// Quantize the activations of the CPU quantized matmuls to int8 per group
+// of the weights, trading some precision for the integer dot products.
+inline bool cpu_qmm_int8() {
+  static bool cpu_qmm_int8_ = get_var("MLX_CPU_QMM_INT8", 0);
+  return cpu_qmm_int8_;
+}
+
+// The NUMA placement of the CPU threads and memory: 0 leaves it to the OS,
+// 1 runs the threads on the nodes and the pages are placed on first touch,
+// 2 also binds the large allocations to the node of their stream with
+// mbind, or interleaves them over the nodes.
+inline int cpu_numa() {
+  static int cpu_numa_ = get_var("MLX_CPU_NUMA", 1);
+  return cpu_numa_;
+}
+
+// Map the large CPU buffers from the reserved huge pages of hugetlbfs
+// rather than relying on the transparent huge pages.
+inline bool cpu_hugetlb() {
+  static bool cpu_hugetlb_ = get_var("MLX_CPU_HUGETLB", 0);
+  return cpu_hugetlb_;
+}
+
+// Read the files with io_uring on Linux when the kernel supports it, and
+// bypass the page cache with O_DIRECT reads.
+inline bool use_io_uring() {
+  static bool use_io_uring_ = get_var("MLX_IO_URING", 1);
+  return use_io_uring_;
+}
+
+inline bool io_direct() {
+  static bool io_direct_ = get_var("MLX_IO_DIRECT", 0);
+  return io_direct_;
+}
+
+inline bool export_kernels() {
+  static bool export_kernels_ = get_var("MLX_EXPORT_KERNELS", 1);
+  return export_kernels_;
+}
+
+// Cache the compiled Metal pipelines on disk, in the directory given by
+// MLX_METAL_CACHE_DIR.
+inline bool metal_binary_archive() {
+  static bool metal_binary_archive_ = get_var("MLX_METAL_BINARY_ARCHIVE", 1);
+  return metal_binary_archive_;
+}
+
+// Run the primitives without a GPU implementation on the CPU rather than
+// failing the evaluation, and from 2 warn the first time each one does.
+inline int gpu_cpu_fallback() {
+  static int gpu_cpu_fallback_ = get_var("MLX_GPU_CPU_FALLBACK", 0);
+  return gpu_cpu_fallback_;
+}
+
 inline bool enable_tf32() {
   static bool enable_tf32_ = get_var("MLX_ENABLE_TF32", 1);
   return enable_tf32_;
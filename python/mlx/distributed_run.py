@@ -788,8 +788,14 @@ def main():
     else:
         hosts = parse_hostlist(parser, args.hosts, args.repeat_hosts)
 
-    # Check if the script is a file and convert it to a full path
-    if (script := Path(rest[0])).exists():
+    # Check if the script is a file and convert it to a full path, the
+    # executables that aren't python scripts, like the C++ benchmarks, are
+    # run directly
+    script = Path(rest[0])
+    is_executable = script.is_file() and os.access(script, os.X_OK)
+    if is_executable and script.suffix != ".py":
+        rest[0] = str(script.resolve())
+    elif script.exists():
         rest[0:1] = [sys.executable, str(script.resolve())]
     elif (command := shutil.which(rest[0])) is not None:
         rest[0] = command
@@ -2,4 +2,9 @@
 
 from mlx.nn import init, losses
 from mlx.nn.layers import *
-from mlx.nn.utils import average_gradients, value_and_grad
+from mlx.nn.utils import (
+    GradientReducer,
+    average_gradients,
+    pipeline_value_and_grad,
+    value_and_grad,
+)
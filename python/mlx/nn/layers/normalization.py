@@ -58,8 +58,7 @@ class InstanceNorm(Module):
     def __call__(self, x: mx.array) -> mx.array:
         reduction_axes = tuple(range(1, x.ndim - 1))
         # Compute stats
-        mean = mx.mean(x, axis=reduction_axes, keepdims=True)
-        var = mx.var(x, axis=reduction_axes, keepdims=True)
+        mean, var = mx.fast.moments(x, axis=reduction_axes, keepdims=True)
         # Normalize
         x = (x - mean) * mx.rsqrt(var + self.eps)
         # Scale and shift if necessary
@@ -220,8 +219,7 @@ class GroupNorm(Module):
         x = x.reshape(batch, -1, num_groups)
 
         # Normalize
-        means = mx.mean(x, axis=1, keepdims=True)
-        var = mx.var(x, axis=1, keepdims=True)
+        means, var = mx.fast.moments(x, axis=1, keepdims=True)
         x = (x - means) * mx.rsqrt(var + self.eps)
         x = x.reshape(batch, *rest, dims)
 
@@ -328,10 +326,7 @@ class BatchNorm(Module):
         """
         reduction_axes = tuple(range(0, x.ndim - 1))
 
-        mean = mx.mean(x, axis=reduction_axes)
-        var = mx.var(x, axis=reduction_axes)
-
-        return mean, var
+        return mx.fast.moments(x, axis=reduction_axes)
 
     def __call__(self, x: mx.array) -> mx.array:
         """
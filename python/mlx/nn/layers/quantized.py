@@ -98,10 +98,11 @@ class QuantizedEmbedding(Module):
         self.freeze()
 
     def __call__(self, x):
-        return mx.dequantize(
-            self["weight"][x],
-            scales=self["scales"][x],
-            biases=self["biases"][x],
+        return mx.fast.quantized_embedding(
+            self["weight"],
+            self["scales"],
+            self["biases"],
+            x,
             group_size=self.group_size,
             bits=self.bits,
         )
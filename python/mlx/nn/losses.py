@@ -83,24 +83,29 @@ def cross_entropy(
             f"Targets shape {targets.shape} does not match logits shape {logits.shape}."
         )
 
-    if targets_as_probs:
-        score = mx.sum(logits * targets, axis=axis)
+    last_axis = axis in (-1, logits.ndim - 1)
+    if not targets_as_probs and label_smoothing == 0 and last_axis:
+        # The fused loss does not materialize the softmax sized temporaries
+        loss = mx.fast.cross_entropy(logits, targets)
     else:
-        score = mx.take_along_axis(logits, targets[..., None], axis).squeeze(-1)
-
-    logsumexp_logits = mx.logsumexp(logits, axis=axis)
-    if label_smoothing > 0:
-        # Adjust the true class score with label smoothing
-        adjusted_score = (1 - label_smoothing) * score
-
-        # Calculate the mean logit across the classes for smoothed loss
-        mean_logits = logits.mean(axis=axis)
-        smoothed_loss = -mean_logits * label_smoothing
-
-        # Combine the adjusted score and smoothed loss with the logsumexp logits
-        loss = logsumexp_logits - adjusted_score + smoothed_loss
-    else:
-        loss = logsumexp_logits - score
+        if targets_as_probs:
+            score = mx.sum(logits * targets, axis=axis)
+        else:
+            score = mx.take_along_axis(logits, targets[..., None], axis).squeeze(-1)
+
+        logsumexp_logits = mx.logsumexp(logits, axis=axis)
+        if label_smoothing > 0:
+            # Adjust the true class score with label smoothing
+            adjusted_score = (1 - label_smoothing) * score
+
+            # Calculate the mean logit across the classes for smoothed loss
+            mean_logits = logits.mean(axis=axis)
+            smoothed_loss = -mean_logits * label_smoothing
+
+            # Combine the adjusted score and smoothed loss with the logsumexp logits
+            loss = logsumexp_logits - adjusted_score + smoothed_loss
+        else:
+            loss = logsumexp_logits - score
 
     # Apply weights if provided
     if weights is not None:
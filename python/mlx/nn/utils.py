@@ -1,7 +1,7 @@
 # Copyright © 2023-2024 Apple Inc.
 
 from functools import reduce, wraps
-from typing import Any, Callable, Optional
+from typing import Any, Callable, Optional, Union
 
 import mlx.core as mx
 
@@ -38,7 +38,11 @@ def value_and_grad(model: Module, fn: Callable):
     return wrapped_value_grad_fn
 
 
-def checkpoint(module: Module, fn: Optional[Callable] = None):
+def checkpoint(
+    module: Module,
+    fn: Optional[Callable] = None,
+    policy: Union[None, str, Callable[[str], bool]] = None,
+):
     """Transform the passed callable to one that performs gradient
     checkpointing with respect to the trainable parameters of the module (and
     the callable's inputs).
@@ -48,6 +52,10 @@ def checkpoint(module: Module, fn: Optional[Callable] = None):
             performing gradient checkpointing.
         fn (Callable, optional): The function to checkpoint. If not provided it
             defaults to the provided module.
+        policy (str or Callable, optional): Which intermediate states to keep
+            as well, see :func:`mlx.core.checkpoint`. For instance
+            ``"matmuls"`` keeps the outputs of the matrix multiplications and
+            recomputes the cheap operations. Default: ``None``.
 
     Returns:
         A callable that saves the inputs and outputs during the forward pass
@@ -62,7 +70,7 @@ def checkpoint(module: Module, fn: Optional[Callable] = None):
         module.update(params)
         return fn(*args, **kwargs)
 
-    checkpointed_fn = mx.checkpoint(inner_fn)
+    checkpointed_fn = mx.checkpoint(inner_fn, policy=policy)
 
     @wraps(fn)
     def wrapped_checkpointed_fn(*args, **kwargs):
@@ -159,3 +167,310 @@ def average_gradients(
             )
 
         return tree_unflatten(new_flat_grads)
+
+
+class GradientReducer:
+    """Average gradients across processes in buckets reduced asynchronously.
+
+    The gradients are flattened into buckets of about ``bucket_size`` bytes in
+    reverse order, which is roughly the order the backward pass produces them
+    in. Each bucket is averaged with a single all reduce on a dedicated
+    communication stream and evaluated asynchronously as soon as it is full,
+    so the communication of a bucket overlaps with the computation of the
+    gradients of the next ones. The cross-stream dependencies are synchronized
+    with fences by the scheduler.
+
+    The returned gradients depend only on their own bucket, so the optimizer
+    update of a parameter waits only for the bucket of its gradient.
+
+    Since it evaluates the buckets the reducer can't be used in a compiled
+    function, use :func:`average_gradients` instead.
+
+    Example:
+        >>> reducer = nn.GradientReducer()
+        >>> loss, grads = loss_and_grad_fn(model, x, y)
+        >>> grads = reducer(grads)
+        >>> optimizer.update(model, grads)
+        >>> mx.eval(model.parameters(), optimizer.state)
+
+    Args:
+        group (Optional[mlx.core.distributed.Group]): The group of processes to
+            average the gradients. If set to ``None`` the global group is used.
+            Default: ``None``.
+        bucket_size (int): The size in bytes of the buckets. Default:
+            ``25MiB``.
+        communication_type (Optional[mlx.core.Dtype]): If provided cast to this
+            type before performing the communication. Default: ``None``.
+        stream (Union[None, mlx.core.Stream, mlx.core.Device]): The stream to
+            communicate on or the device to create it on. The NCCL backend
+            needs a GPU stream. Default: a new stream on the CPU.
+        compression (Optional[str]): Send the float32 buckets as ``"bf16"``
+            or ``"fp8"`` with :func:`mlx.core.distributed.all_sum`. The
+            rounding error of each bucket is kept and added to the bucket of
+            the next call (error feedback). Default: ``None``.
+    """
+
+    def __init__(
+        self,
+        group: Optional[mx.distributed.Group] = None,
+        bucket_size: int = 25 * 1024**2,
+        communication_type: Optional[mx.Dtype] = None,
+        stream=None,
+        compression: Optional[str] = None,
+    ):
+        if compression is not None and communication_type is not None:
+            raise ValueError(
+                "[GradientReducer] Only one of communication_type and "
+                "compression can be set."
+            )
+        self.group = group or mx.distributed.init()
+        self.bucket_size = bucket_size
+        self.communication_type = communication_type
+        self.compression = compression
+        self._residuals = {}
+        if isinstance(stream, mx.Stream):
+            self.stream = stream
+        else:
+            self.stream = mx.new_stream(stream or mx.cpu)
+
+    def _round_to_wire(self, x):
+        if self.compression == "bf16":
+            return x.astype(mx.bfloat16).astype(mx.float32)
+        # The float8 values with a scale per block of 256
+        n = x.size
+        x = mx.pad(x, (0, -n % 256)).reshape(-1, 256)
+        scale = x.abs().max(axis=1, keepdims=True) / 448
+        scale = mx.where(scale > 0, scale, 1)
+        x = mx.from_fp8(mx.to_fp8(x / scale), mx.float32) * scale
+        return x.reshape(-1)[:n]
+
+    def _reduce(self, bucket, index):
+        N = self.group.size()
+        dt = bucket[0][1].dtype
+        x = mx.concatenate([v.reshape(-1) for _, v in bucket])
+        residuals = []
+        if self.compression is not None and dt == mx.float32:
+            # Error feedback, the rounding error is sent with the next step
+            r = self._residuals.get(index)
+            if r is not None and r.size == x.size:
+                x = x + r
+            r = x - self._round_to_wire(x)
+            self._residuals[index] = r
+            residuals.append(r)
+            x = mx.distributed.all_sum(
+                x,
+                compression=self.compression,
+                group=self.group,
+                stream=self.stream,
+            )
+        else:
+            if self.communication_type is not None:
+                x = x.astype(self.communication_type)
+            x = mx.distributed.all_sum(x, group=self.group, stream=self.stream)
+        x = x.astype(dt) / N
+        indices = reduce(lambda acc, kv: acc + [acc[-1] + kv[1].size], bucket, [0])
+        parts = mx.split(x, indices[1:-1])
+        grads = [(k, p.reshape(v.shape)) for (k, v), p in zip(bucket, parts)]
+        mx.async_eval([g for _, g in grads] + residuals)
+        return grads
+
+    def __call__(self, gradients: Any):
+        """Return the average of ``gradients`` across the group.
+
+        Args:
+            gradients (Any): The Python tree containing the gradients (it
+                should have the same structure across processes).
+        """
+        if self.group.size() == 1:
+            return gradients
+
+        # A bucket per dtype, filled in reverse order and launched when full
+        flat_grads = tree_flatten(gradients)
+        if len(flat_grads) == 0:
+            return gradients
+        itemsize = self.communication_type and self.communication_type.size
+        buckets = {}
+        reduced = []
+        n_buckets = 0
+        for k, v in reversed(flat_grads):
+            bucket, size = buckets.get(v.dtype, ([], 0))
+            bucket.append((k, v))
+            size += v.size * (itemsize or v.dtype.size)
+            if size >= self.bucket_size:
+                reduced.extend(self._reduce(bucket, n_buckets))
+                n_buckets += 1
+                bucket, size = [], 0
+            buckets[v.dtype] = (bucket, size)
+        for bucket, _ in buckets.values():
+            if bucket:
+                reduced.extend(self._reduce(bucket, n_buckets))
+                n_buckets += 1
+
+        reduced = dict(reduced)
+        return tree_unflatten([(k, reduced[k]) for k, _ in flat_grads])
+
+
+def pipeline_value_and_grad(
+    model: Module,
+    loss_fn: Callable,
+    num_microbatches: int,
+    group: Optional[mx.distributed.Group] = None,
+    stream=None,
+):
+    """Transform a stage of a pipeline to a function that computes the loss
+    and the gradients of the stage with a 1F1B micro-batch schedule.
+
+    Each process of the group holds the consecutive stage ``model`` of the
+    pipeline of its rank. The batch is split into ``num_microbatches`` along
+    its first axis and each stage runs the forward passes of the first
+    micro-batches until the pipeline is full, then alternates one forward and
+    one backward pass, and finishes with the remaining backward passes. So a
+    stage keeps the activations of at most as many micro-batches as there
+    are stages after it, instead of all of them.
+
+    The activations and their gradients are sent to the neighbouring stages
+    with :func:`mlx.core.distributed.send` and
+    :func:`mlx.core.distributed.recv` on a dedicated communication stream.
+    They are evaluated asynchronously in the order of the schedule, which
+    matches the order of the neighbouring stages, so the transfers overlap
+    with the computation of the other micro-batches.
+
+    The returned function takes the inputs ``x`` and the targets ``y`` of the
+    batch. The first stage uses ``x`` and the last one passes the outputs of
+    the model and ``y`` to ``loss_fn``. The other stages only use the shape
+    and type of ``x`` as those of the activations they receive for the whole
+    batch and ignore ``y``. It returns the average loss of the micro-batches
+    on the last stage (``None`` on the others) and the gradients of the
+    average loss wrt the trainable parameters of ``model``.
+
+    Example:
+        >>> step = nn.pipeline_value_and_grad(stage, loss_fn, 8)
+        >>> loss, grads = step(x, y)
+        >>> optimizer.update(stage, grads)
+        >>> mx.eval(stage.parameters(), optimizer.state)
+
+    Args:
+        model (mlx.nn.Module): The stage of the pipeline of this process.
+        loss_fn (Callable): The scalar loss computed by the last stage from
+            the outputs of the model and the targets.
+        num_microbatches (int): The number of micro-batches the batch is
+            split into.
+        group (Optional[mlx.core.distributed.Group]): The group of the stages
+            of the pipeline. If set to ``None`` the global group is used.
+            Default: ``None``.
+        stream (Union[None, mlx.core.Stream, mlx.core.Device]): The stream to
+            communicate on or the device to create it on. The NCCL backend
+            needs a GPU stream. Default: a new stream on the CPU.
+    """
+    group = group or mx.distributed.init()
+    rank = group.rank()
+    n = group.size()
+    first = rank == 0
+    last = rank == n - 1
+    if isinstance(stream, mx.Stream):
+        comm = stream
+    else:
+        comm = mx.new_stream(stream or mx.cpu)
+    # The shape and type of the outputs of the stage for an input
+    out_shapes = {}
+
+    def stage_fn(keys, x, y):
+        def fn(*args):
+            n_params = len(keys)
+            model.update(tree_unflatten(list(zip(keys, args[:n_params]))))
+            out = model(args[n_params] if n_params < len(args) else x)
+            if y is not None:
+                out = loss_fn(out, y) / num_microbatches
+            return out
+
+        return fn
+
+    @wraps(loss_fn)
+    def wrapped_pipeline_fn(x, y=None):
+        M = num_microbatches
+        if x.shape[0] % M != 0:
+            raise ValueError(
+                f"[pipeline_value_and_grad] The batch size {x.shape[0]} is not "
+                f"divisible by the number of micro-batches {M}."
+            )
+        xs = mx.split(x, M)
+        ys = mx.split(y, M) if last else [None] * M
+
+        flat_params = tree_flatten(model.trainable_parameters())
+        keys = [k for k, _ in flat_params]
+        params = [v for _, v in flat_params]
+        grads = None
+        loss = None
+        # The cotangents to receive and the vector-Jacobian products of the
+        # micro-batches between their forward and backward passes
+        pending = {}
+
+        def recv_input(i):
+            if first:
+                return xs[i]
+            x = mx.distributed.recv_like(xs[i], rank - 1, group=group, stream=comm)
+            mx.async_eval(x)
+            return x
+
+        def forward(i, x):
+            nonlocal loss
+            # The first stage needs no gradient wrt its input
+            primals = params if first else params + [x]
+            fn = stage_fn(keys, x, ys[i])
+            if last:
+                argnums = list(range(len(primals)))
+                value, vjps = mx.value_and_grad(fn, argnums=argnums)(*primals)
+                loss = value if loss is None else loss + value
+                pending[i] = (None, vjps)
+                return
+            key = (x.shape, x.dtype)
+            if key not in out_shapes:
+                out = fn(*primals)
+                out_shapes[key] = (out.shape, out.dtype)
+            shape, dtype = out_shapes[key]
+            cotangent = mx.distributed.recv(
+                shape, dtype, rank + 1, group=group, stream=comm
+            )
+            (out,), vjps = mx.vjp(fn, primals, [cotangent])
+            pending[i] = (cotangent, vjps)
+            mx.async_eval(mx.distributed.send(out, rank + 1, group=group, stream=comm))
+
+        def backward(i):
+            nonlocal grads
+            cotangent, vjps = pending.pop(i)
+            if cotangent is not None:
+                mx.async_eval(cotangent)
+            vjps = list(vjps)
+            if grads is None:
+                grads = vjps[: len(params)]
+            else:
+                grads = [g + v for g, v in zip(grads, vjps)]
+            mx.async_eval(grads)
+            return None if first else vjps[-1]
+
+        def send_grad(dx):
+            if dx is not None:
+                mx.async_eval(
+                    mx.distributed.send(dx, rank - 1, group=group, stream=comm)
+                )
+
+        # Each step receives the input of the next forward pass before sending
+        # the gradient of the previous stage, which is the order that stage
+        # sends and receives them in.
+        warmup = min(n - rank - 1, M)
+        for i in range(warmup):
+            forward(i, recv_input(i))
+        x = recv_input(warmup) if warmup < M else None
+        for j in range(M - warmup):
+            forward(warmup + j, x)
+            dx = backward(j)
+            if warmup + j + 1 < M:
+                x = recv_input(warmup + j + 1)
+            send_grad(dx)
+        for j in range(M - warmup, M):
+            send_grad(backward(j))
+
+        model.update(tree_unflatten(flat_params))
+        return loss, tree_unflatten(list(zip(keys, grads)))
+
+    return wrapped_pipeline_fn
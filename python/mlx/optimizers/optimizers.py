@@ -7,6 +7,10 @@ from mlx.nn import Module
 from mlx.utils import tree_flatten, tree_map, tree_merge, tree_reduce, tree_unflatten
 
 
+def _are_numbers(*values):
+    return all(isinstance(v, (int, float)) for v in values)
+
+
 class Optimizer:
     """The base class for all optimizers. It allows us to implement an
     optimizer on a per-parameter basis and apply it to a parameter tree.
@@ -106,8 +110,55 @@ class Optimizer:
         self.state["step"] = self.step + 1
 
         # Apply the update
+        return self._apply_all(gradients, parameters)
+
+    def _apply_all(self, gradients: dict, parameters: dict):
         return tree_map(self.apply_single, gradients, parameters, self.state)
 
+    def _apply_fused(
+        self,
+        gradients: dict,
+        parameters: dict,
+        state_keys: Tuple[str, ...],
+        fused_step: Callable,
+    ):
+        """Apply the update to all the parameters at once with ``fused_step``,
+        which takes the lists of parameters, gradients and states, or return
+        ``None`` if their types differ.
+        """
+        leaves = []
+        tree_map(
+            lambda g, p, s: leaves.append((g, p, s)),
+            gradients,
+            parameters,
+            self.state,
+        )
+        for g, p, s in leaves:
+            arrays = [g] + [s.get(k) for k in state_keys]
+            if not isinstance(p, mx.array) or not mx.issubdtype(
+                p.dtype, mx.floating
+            ):
+                return None
+            for a in arrays:
+                if not isinstance(a, mx.array) or a.dtype != p.dtype:
+                    return None
+                if a.shape != p.shape:
+                    return None
+        if not leaves:
+            return None
+
+        gradients_list, parameters_list, states = zip(*leaves)
+        outputs = fused_step(
+            list(parameters_list),
+            list(gradients_list),
+            *([s[k] for s in states] for k in state_keys),
+        )
+        for k, values in zip(state_keys, outputs[1:]):
+            for s, v in zip(states, values):
+                s[k] = v
+        new_parameters = iter(outputs[0])
+        return tree_map(lambda _: next(new_parameters), gradients)
+
     def apply_single(self, gradient: mx.array, parameter: mx.array, state: dict):
         """To be extended by derived classes to implement the optimizer's update.
 
@@ -243,6 +294,11 @@ class SGD(Optimizer):
         weight_decay (float, optional): The weight decay (L2 penalty). Default: ``0``
         dampening (float, optional): Dampening for momentum :math:`\tau`. Default: ``0``
         nesterov (bool, optional): Enables Nesterov momentum. Default: ``False``
+        stochastic_rounding (bool, optional): Round the updated ``bfloat16``
+          parameters at random with :func:`mlx.core.fast.stochastic_round`
+          instead of to the nearest, so that small updates are not lost in
+          ``bfloat16`` training. It applies to the fused update of all the
+          parameters. Default: ``False``
     """
 
     def __init__(
@@ -252,6 +308,7 @@ class SGD(Optimizer):
         weight_decay: float = 0.0,
         dampening: float = 0.0,
         nesterov: bool = False,
+        stochastic_rounding: bool = False,
     ):
         if nesterov and (momentum <= 0 or dampening != 0):
             raise ValueError(
@@ -264,6 +321,7 @@ class SGD(Optimizer):
         self.weight_decay = weight_decay
         self.dampening = dampening
         self.nesterov = nesterov
+        self.stochastic_rounding = stochastic_rounding
 
     def init_single(self, parameter: mx.array, state: dict):
         """Initialize optimizer state"""
@@ -293,6 +351,32 @@ class SGD(Optimizer):
         state["v"] = v
         return parameter - self.learning_rate.astype(gradient.dtype) * update
 
+    def _apply_all(self, gradients: dict, parameters: dict):
+        hyperparameters = (self.momentum, self.weight_decay, self.dampening)
+        if type(self).apply_single is SGD.apply_single and _are_numbers(
+            *hyperparameters
+        ):
+            with_momentum = self.momentum > 0
+            updated = self._apply_fused(
+                gradients,
+                parameters,
+                ("v",) if with_momentum else (),
+                lambda p, g, v=[]: mx.fast.sgd_step(
+                    p,
+                    g,
+                    v,
+                    self.learning_rate,
+                    momentum=self.momentum,
+                    weight_decay=self.weight_decay,
+                    dampening=self.dampening,
+                    nesterov=self.nesterov,
+                    stochastic_rounding=self.stochastic_rounding,
+                ),
+            )
+            if updated is not None:
+                return updated
+        return super()._apply_all(gradients, parameters)
+
 
 class RMSprop(Optimizer):
     r"""The RMSprop optimizer [1].
@@ -488,6 +572,11 @@ class Adam(Optimizer):
           denominator to improve numerical stability. Default: ``1e-8``
         bias_correction (bool, optional): If set to ``True``, bias correction
           is applied. Default: ``False``
+        stochastic_rounding (bool, optional): Round the updated ``bfloat16``
+          parameters at random with :func:`mlx.core.fast.stochastic_round`
+          instead of to the nearest, so that small updates are not lost in
+          ``bfloat16`` training. It applies to the fused update of all the
+          parameters. Default: ``False``
     """
 
     def __init__(
@@ -496,6 +585,7 @@ class Adam(Optimizer):
         betas: List[float] = [0.9, 0.999],
         eps: float = 1e-8,
         bias_correction: bool = False,
+        stochastic_rounding: bool = False,
     ):
         super().__init__()
 
@@ -503,6 +593,7 @@ class Adam(Optimizer):
         self.betas = betas
         self.eps = eps
         self.bias_correction = bias_correction
+        self.stochastic_rounding = stochastic_rounding
 
     def init_single(self, parameter: mx.array, state: dict):
         """Initialize optimizer state"""
@@ -534,6 +625,35 @@ class Adam(Optimizer):
         else:
             return parameter - lr * m / (mx.sqrt(v) + eps)
 
+    def _apply_adamw(self, gradients: dict, parameters: dict, weight_decay):
+        if not _are_numbers(*self.betas, self.eps, weight_decay):
+            return None
+        b1, b2 = self.betas
+        return self._apply_fused(
+            gradients,
+            parameters,
+            ("m", "v"),
+            lambda p, g, m, v: mx.fast.adamw_step(
+                p,
+                g,
+                m,
+                v,
+                self.learning_rate,
+                betas=(b1, b2),
+                eps=self.eps,
+                weight_decay=weight_decay,
+                step=self.step if self.bias_correction else None,
+                stochastic_rounding=self.stochastic_rounding,
+            ),
+        )
+
+    def _apply_all(self, gradients: dict, parameters: dict):
+        if type(self).apply_single is Adam.apply_single:
+            updated = self._apply_adamw(gradients, parameters, 0.0)
+            if updated is not None:
+                return updated
+        return super()._apply_all(gradients, parameters)
+
 
 class AdamW(Adam):
     r"""The AdamW optimizer [1]. We update the weights with a weight_decay
@@ -559,6 +679,11 @@ class AdamW(Adam):
           Default: ``0``.
         bias_correction (bool, optional): If set to ``True``, bias correction
           is applied. Default: ``False``
+        stochastic_rounding (bool, optional): Round the updated ``bfloat16``
+          parameters at random with :func:`mlx.core.fast.stochastic_round`
+          instead of to the nearest, so that small updates are not lost in
+          ``bfloat16`` training. It applies to the fused update of all the
+          parameters. Default: ``False``
     """
 
     def __init__(
@@ -568,12 +693,14 @@ class AdamW(Adam):
         eps: float = 1e-8,
         weight_decay: float = 0.01,
         bias_correction: bool = False,
+        stochastic_rounding: bool = False,
     ):
         super().__init__(
             learning_rate=learning_rate,
             betas=betas,
             eps=eps,
             bias_correction=bias_correction,
+            stochastic_rounding=stochastic_rounding,
         )
         self.weight_decay = weight_decay
 
@@ -587,6 +714,13 @@ class AdamW(Adam):
             gradient, parameter * (1 - lr * self.weight_decay), state
         )
 
+    def _apply_all(self, gradients: dict, parameters: dict):
+        if type(self).apply_single is AdamW.apply_single:
+            updated = self._apply_adamw(gradients, parameters, self.weight_decay)
+            if updated is not None:
+                return updated
+        return super()._apply_all(gradients, parameters)
+
 
 class Adamax(Adam):
     r"""The Adamax optimizer, a variant of Adam based on the infinity norm [1].
@@ -672,6 +806,11 @@ class Lion(Optimizer):
           :math:`(\beta_1, \beta_2)` used for computing the gradient
           momentum and update direction. Default: ``(0.9, 0.99)``
         weight_decay (float, optional): The weight decay :math:`\lambda`. Default: ``0.0``
+        stochastic_rounding (bool, optional): Round the updated ``bfloat16``
+          parameters at random with :func:`mlx.core.fast.stochastic_round`
+          instead of to the nearest, so that small updates are not lost in
+          ``bfloat16`` training. It applies to the fused update of all the
+          parameters. Default: ``False``
     """
 
     def __init__(
@@ -679,12 +818,14 @@ class Lion(Optimizer):
         learning_rate: Union[float, Callable[[mx.array], mx.array]],
         betas: List[float] = [0.9, 0.99],
         weight_decay: float = 0.0,
+        stochastic_rounding: bool = False,
     ):
         super().__init__()
 
         self._maybe_schedule("learning_rate", learning_rate)
         self.betas = betas
         self.weight_decay = weight_decay
+        self.stochastic_rounding = stochastic_rounding
 
     def init_single(self, parameter: mx.array, state: dict):
         """Initialize optimizer state"""
@@ -704,6 +845,29 @@ class Lion(Optimizer):
             parameter = (1 - lr * weight_decay) * parameter
         return parameter - lr * mx.sign(c)
 
+    def _apply_all(self, gradients: dict, parameters: dict):
+        if type(self).apply_single is Lion.apply_single and _are_numbers(
+            *self.betas, self.weight_decay
+        ):
+            b1, b2 = self.betas
+            updated = self._apply_fused(
+                gradients,
+                parameters,
+                ("m",),
+                lambda p, g, m: mx.fast.lion_step(
+                    p,
+                    g,
+                    m,
+                    self.learning_rate,
+                    betas=(b1, b2),
+                    weight_decay=max(self.weight_decay, 0.0),
+                    stochastic_rounding=self.stochastic_rounding,
+                ),
+            )
+            if updated is not None:
+                return updated
+        return super()._apply_all(gradients, parameters)
+
 
 class Adafactor(Optimizer):
     r"""The Adafactor optimizer.
@@ -455,6 +455,16 @@ void init_array(nb::module_& m) {
             new (&arr) mx::array(nd_array_to_mlx(state, std::nullopt));
           })
       .def("__dlpack__", [](const mx::array& a) { return mlx_to_dlpack(a); })
+      .def_prop_ro(
+          "__cuda_array_interface__",
+          &mlx_to_cuda_array_interface,
+          R"pbdoc(
+            The CUDA array interface (version 3) of the array.
+
+            The array is evaluated without waiting for it and the ``stream``
+            is the CUDA stream computing it, which the consumer waits on
+            before reading the memory. Only available with the CUDA back-end.
+          )pbdoc")
       .def(
           "__dlpack_device__",
           [](const mx::array& a) {
@@ -480,7 +490,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("addition", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             return mx::add(a, b);
           },
           "other"_a)
@@ -490,7 +500,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace addition", v);
             }
-            a.overwrite_descriptor(mx::add(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(mx::add(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -501,7 +511,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("addition", v);
             }
-            return mx::add(a, to_array(v, a.dtype()));
+            return mx::add(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -510,7 +520,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("subtraction", v);
             }
-            return mx::subtract(a, to_array(v, a.dtype()));
+            return mx::subtract(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -519,7 +529,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace subtraction", v);
             }
-            a.overwrite_descriptor(mx::subtract(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(mx::subtract(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -530,7 +540,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("subtraction", v);
             }
-            return mx::subtract(to_array(v, a.dtype()), a);
+            return mx::subtract(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -539,7 +549,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("multiplication", v);
             }
-            return mx::multiply(a, to_array(v, a.dtype()));
+            return mx::multiply(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -548,7 +558,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace multiplication", v);
             }
-            a.overwrite_descriptor(mx::multiply(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(mx::multiply(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -559,7 +569,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("multiplication", v);
             }
-            return mx::multiply(a, to_array(v, a.dtype()));
+            return mx::multiply(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -568,7 +578,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return mx::divide(a, to_array(v, a.dtype()));
+            return mx::divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -581,7 +591,7 @@ void init_array(nb::module_& m) {
               throw std::invalid_argument(
                   "In place division cannot cast to non-floating point type.");
             }
-            a.overwrite_descriptor(divide(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(divide(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -592,7 +602,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return mx::divide(to_array(v, a.dtype()), a);
+            return mx::divide(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -601,7 +611,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return mx::divide(a, to_array(v, a.dtype()));
+            return mx::divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -610,7 +620,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("division", v);
             }
-            return mx::divide(to_array(v, a.dtype()), a);
+            return mx::divide(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -619,7 +629,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("floor division", v);
             }
-            return mx::floor_divide(a, to_array(v, a.dtype()));
+            return mx::floor_divide(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -628,7 +638,8 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace floor division", v);
             }
-            a.overwrite_descriptor(mx::floor_divide(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(
+                mx::floor_divide(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -639,7 +650,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("floor division", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             return mx::floor_divide(b, a);
           },
           "other"_a)
@@ -649,7 +660,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("modulus", v);
             }
-            return mx::remainder(a, to_array(v, a.dtype()));
+            return mx::remainder(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -658,7 +669,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace modulus", v);
             }
-            a.overwrite_descriptor(mx::remainder(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(mx::remainder(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -669,7 +680,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("modulus", v);
             }
-            return mx::remainder(to_array(v, a.dtype()), a);
+            return mx::remainder(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -679,7 +690,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               return false;
             }
-            return mx::equal(a, to_array(v, a.dtype()));
+            return mx::equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -688,7 +699,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("less than", v);
             }
-            return mx::less(a, to_array(v, a.dtype()));
+            return mx::less(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -697,7 +708,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("less than or equal", v);
             }
-            return mx::less_equal(a, to_array(v, a.dtype()));
+            return mx::less_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -706,7 +717,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("greater than", v);
             }
-            return mx::greater(a, to_array(v, a.dtype()));
+            return mx::greater(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -715,7 +726,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("greater than or equal", v);
             }
-            return mx::greater_equal(a, to_array(v, a.dtype()));
+            return mx::greater_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -725,7 +736,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               return true;
             }
-            return mx::not_equal(a, to_array(v, a.dtype()));
+            return mx::not_equal(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def("__neg__", [](const mx::array& a) { return -a; })
@@ -758,7 +769,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("power", v);
             }
-            return mx::power(a, to_array(v, a.dtype()));
+            return mx::power(a, to_operand(v, a.dtype()));
           },
           "other"_a)
       .def(
@@ -767,7 +778,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("power", v);
             }
-            return mx::power(to_array(v, a.dtype()), a);
+            return mx::power(to_operand(v, a.dtype()), a);
           },
           "other"_a)
       .def(
@@ -776,7 +787,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace power", v);
             }
-            a.overwrite_descriptor(mx::power(a, to_array(v, a.dtype())));
+            a.overwrite_descriptor(mx::power(a, to_operand(v, a.dtype())));
             return a;
           },
           "other"_a,
@@ -799,7 +810,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("bitwise and", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -814,7 +825,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace bitwise and", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -831,7 +842,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("bitwise or", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -846,7 +857,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace bitwise or", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -863,7 +874,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("left shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -878,7 +889,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace left shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -895,7 +906,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("right shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -910,7 +921,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace right shift", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -927,7 +938,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("bitwise xor", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -942,7 +953,7 @@ void init_array(nb::module_& m) {
             if (!is_comparable_with_array(v)) {
               throw_invalid_operation("inplace bitwise xor", v);
             }
-            auto b = to_array(v, a.dtype());
+            auto b = to_operand(v, a.dtype());
             if (mx::issubdtype(a.dtype(), mx::inexact) ||
                 mx::issubdtype(b.dtype(), mx::inexact)) {
               throw std::invalid_argument(
@@ -1492,4 +1503,45 @@ void init_array(nb::module_& m) {
           nb::kw_only(),
           "stream"_a = nb::none(),
           "See :func:`view`.");
+
+  m.def(
+      "from_dlpack",
+      &dlpack_to_mlx,
+      "x"_a,
+      R"pbdoc(
+      Make an array from an object supporting the DLPack protocol.
+
+      The tensors of CUDA memory, for instance of PyTorch, CuPy or JAX, are
+      wrapped without a copy and the array keeps the tensor alive. The
+      producer orders its pending work on the tensor before the default GPU
+      stream. The array is only readable by the GPU unless the memory is
+      managed. The other tensors are copied like with :class:`array`.
+
+      Args:
+          x: An object with the ``__dlpack__`` and ``__dlpack_device__``
+            methods. The CUDA tensors must be row contiguous.
+
+      Returns:
+          array: The array sharing the memory of ``x``.
+      )pbdoc");
+
+  m.def(
+      "to_host",
+      &mlx_to_host,
+      "arrays"_a,
+      R"pbdoc(
+      Read back several arrays with a single wait.
+
+      The arrays are evaluated together and, on CUDA, their memory is moved
+      to the host at once instead of one page fault at a time. Prefer it to
+      calling :meth:`array.item` or :meth:`array.tolist` on each of many
+      small results.
+
+      Args:
+          arrays (list(array)): The arrays to read.
+
+      Returns:
+          list(numpy.ndarray): Read only NumPy views of the memory of the
+          arrays. The views keep the arrays alive.
+      )pbdoc");
 }
@@ -5,6 +5,8 @@
 #include "python/src/convert.h"
 #include "python/src/utils.h"
 
+#include "mlx/backend/cuda/cuda.h"
+#include "mlx/transforms.h"
 #include "mlx/utils.h"
 
 enum PyScalarT {
@@ -39,16 +41,28 @@ template <typename T>
 mx::array nd_array_to_mlx_contiguous(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
     const mx::Shape& shape,
-    mx::Dtype dtype) {
+    mx::Dtype dtype,
+    bool to_device) {
   // Make a copy of the numpy buffer
   // Get buffer ptr pass to array constructor
   auto data_ptr = nd_array.data();
+  // The large arrays for the GPU are copied there through pinned memory
+  // when their type is kept.
+  if constexpr (!std::is_same_v<T, mx::complex128_t>) {
+    if (to_device && nd_array.nbytes() >= (1 << 20) &&
+        dtype == mx::TypeToDtype<T>() &&
+        mx::default_device() == mx::Device::gpu && mx::cu::is_available()) {
+      nb::gil_scoped_release nogil;
+      return mx::cu::from_host(data_ptr, shape, dtype);
+    }
+  }
   return mx::array(static_cast<const T*>(data_ptr), shape, dtype);
 }
 
 mx::array nd_array_to_mlx(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
-    std::optional<mx::Dtype> dtype) {
+    std::optional<mx::Dtype> dtype,
+    bool to_device /* = true */) {
   // Compute the shape and size
   mx::Shape shape;
   for (int i = 0; i < nd_array.ndim(); i++) {
@@ -59,49 +73,49 @@ mx::array nd_array_to_mlx(
   // Copy data and make array
   if (type == nb::dtype<bool>()) {
     return nd_array_to_mlx_contiguous<bool>(
-        nd_array, shape, dtype.value_or(mx::bool_));
+        nd_array, shape, dtype.value_or(mx::bool_), to_device);
   } else if (type == nb::dtype<uint8_t>()) {
     return nd_array_to_mlx_contiguous<uint8_t>(
-        nd_array, shape, dtype.value_or(mx::uint8));
+        nd_array, shape, dtype.value_or(mx::uint8), to_device);
   } else if (type == nb::dtype<uint16_t>()) {
     return nd_array_to_mlx_contiguous<uint16_t>(
-        nd_array, shape, dtype.value_or(mx::uint16));
+        nd_array, shape, dtype.value_or(mx::uint16), to_device);
   } else if (type == nb::dtype<uint32_t>()) {
     return nd_array_to_mlx_contiguous<uint32_t>(
-        nd_array, shape, dtype.value_or(mx::uint32));
+        nd_array, shape, dtype.value_or(mx::uint32), to_device);
   } else if (type == nb::dtype<uint64_t>()) {
     return nd_array_to_mlx_contiguous<uint64_t>(
-        nd_array, shape, dtype.value_or(mx::uint64));
+        nd_array, shape, dtype.value_or(mx::uint64), to_device);
   } else if (type == nb::dtype<int8_t>()) {
     return nd_array_to_mlx_contiguous<int8_t>(
-        nd_array, shape, dtype.value_or(mx::int8));
+        nd_array, shape, dtype.value_or(mx::int8), to_device);
   } else if (type == nb::dtype<int16_t>()) {
     return nd_array_to_mlx_contiguous<int16_t>(
-        nd_array, shape, dtype.value_or(mx::int16));
+        nd_array, shape, dtype.value_or(mx::int16), to_device);
   } else if (type == nb::dtype<int32_t>()) {
     return nd_array_to_mlx_contiguous<int32_t>(
-        nd_array, shape, dtype.value_or(mx::int32));
+        nd_array, shape, dtype.value_or(mx::int32), to_device);
   } else if (type == nb::dtype<int64_t>()) {
     return nd_array_to_mlx_contiguous<int64_t>(
-        nd_array, shape, dtype.value_or(mx::int64));
+        nd_array, shape, dtype.value_or(mx::int64), to_device);
   } else if (type == nb::dtype<mx::float16_t>()) {
     return nd_array_to_mlx_contiguous<mx::float16_t>(
-        nd_array, shape, dtype.value_or(mx::float16));
+        nd_array, shape, dtype.value_or(mx::float16), to_device);
   } else if (type == nb::bfloat16) {
     return nd_array_to_mlx_contiguous<mx::bfloat16_t>(
-        nd_array, shape, dtype.value_or(mx::bfloat16));
+        nd_array, shape, dtype.value_or(mx::bfloat16), to_device);
   } else if (type == nb::dtype<float>()) {
     return nd_array_to_mlx_contiguous<float>(
-        nd_array, shape, dtype.value_or(mx::float32));
+        nd_array, shape, dtype.value_or(mx::float32), to_device);
   } else if (type == nb::dtype<double>()) {
     return nd_array_to_mlx_contiguous<double>(
-        nd_array, shape, dtype.value_or(mx::float32));
+        nd_array, shape, dtype.value_or(mx::float32), to_device);
   } else if (type == nb::dtype<std::complex<float>>()) {
     return nd_array_to_mlx_contiguous<mx::complex64_t>(
-        nd_array, shape, dtype.value_or(mx::complex64));
+        nd_array, shape, dtype.value_or(mx::complex64), to_device);
   } else if (type == nb::dtype<std::complex<double>>()) {
     return nd_array_to_mlx_contiguous<mx::complex128_t>(
-        nd_array, shape, dtype.value_or(mx::complex64));
+        nd_array, shape, dtype.value_or(mx::complex64), to_device);
   } else {
     throw std::invalid_argument("Cannot convert numpy array to mlx array.");
   }
@@ -110,6 +124,7 @@ mx::array nd_array_to_mlx(
 template <typename T, typename... NDParams>
 nb::ndarray<NDParams...> mlx_to_nd_array_impl(
     mx::array a,
+    nb::object owner,
     std::optional<nb::dlpack::dtype> t = {}) {
   {
     nb::gil_scoped_release nogil;
@@ -120,40 +135,42 @@ nb::ndarray<NDParams...> mlx_to_nd_array_impl(
       a.data<T>(),
       a.ndim(),
       shape.data(),
-      /* owner= */ nb::none(),
+      owner,
       a.strides().data(),
       t.value_or(nb::dtype<T>()));
 }
 
 template <typename... NDParams>
-nb::ndarray<NDParams...> mlx_to_nd_array(const mx::array& a) {
+nb::ndarray<NDParams...> mlx_to_nd_array(
+    const mx::array& a,
+    nb::object owner = nb::none()) {
   switch (a.dtype()) {
     case mx::bool_:
-      return mlx_to_nd_array_impl<bool, NDParams...>(a);
+      return mlx_to_nd_array_impl<bool, NDParams...>(a, owner);
     case mx::uint8:
-      return mlx_to_nd_array_impl<uint8_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<uint8_t, NDParams...>(a, owner);
     case mx::uint16:
-      return mlx_to_nd_array_impl<uint16_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<uint16_t, NDParams...>(a, owner);
     case mx::uint32:
-      return mlx_to_nd_array_impl<uint32_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<uint32_t, NDParams...>(a, owner);
     case mx::uint64:
-      return mlx_to_nd_array_impl<uint64_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<uint64_t, NDParams...>(a, owner);
     case mx::int8:
-      return mlx_to_nd_array_impl<int8_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<int8_t, NDParams...>(a, owner);
     case mx::int16:
-      return mlx_to_nd_array_impl<int16_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<int16_t, NDParams...>(a, owner);
     case mx::int32:
-      return mlx_to_nd_array_impl<int32_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<int32_t, NDParams...>(a, owner);
     case mx::int64:
-      return mlx_to_nd_array_impl<int64_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<int64_t, NDParams...>(a, owner);
     case mx::float16:
-      return mlx_to_nd_array_impl<mx::float16_t, NDParams...>(a);
+      return mlx_to_nd_array_impl<mx::float16_t, NDParams...>(a, owner);
     case mx::bfloat16:
       throw nb::type_error("bfloat16 arrays cannot be converted to NumPy.");
     case mx::float32:
-      return mlx_to_nd_array_impl<float, NDParams...>(a);
+      return mlx_to_nd_array_impl<float, NDParams...>(a, owner);
     case mx::float64:
-      return mlx_to_nd_array_impl<double, NDParams...>(a);
+      return mlx_to_nd_array_impl<double, NDParams...>(a, owner);
     case mx::complex64:
       return mlx_to_nd_array_impl<std::complex<float>, NDParams...>(a);
     default:
@@ -169,6 +186,261 @@ nb::ndarray<> mlx_to_dlpack(const mx::array& a) {
   return mlx_to_nd_array<>(a);
 }
 
+nb::list mlx_to_host(const std::vector<mx::array>& arrays) {
+  std::vector<mx::array> host;
+  {
+    nb::gil_scoped_release nogil;
+    if (mx::cu::is_available()) {
+      // Move the pages of all the arrays at once and wait a single time.
+      mx::cu::prefetch(arrays, /* to_host = */ true);
+      mx::synchronize(mx::default_stream(mx::Device::gpu));
+    } else {
+      mx::eval(arrays);
+    }
+    // The device memory only readable by the GPU is copied.
+    for (auto& a : arrays) {
+      host.push_back(mx::cu::readable_by_host(a));
+    }
+  }
+  nb::list out;
+  for (auto& a : host) {
+    auto held = new mx::array(a);
+    nb::capsule owner(held, [](void* p) noexcept {
+      delete static_cast<mx::array*>(p);
+    });
+    out.append(mlx_to_nd_array<nb::numpy, nb::ro>(a, owner));
+  }
+  return out;
+}
+
+// Release the Python |owner| of foreign memory once the last array using
+// the memory is freed, possibly from another thread.
+template <typename T>
+std::function<void()> release_with_gil(T owner) {
+  auto ptr = std::make_shared<T>(std::move(owner));
+  return [ptr]() {
+    nb::gil_scoped_acquire gil;
+    *ptr = T();
+  };
+}
+
+mx::Dtype dlpack_to_mlx_dtype(nb::dlpack::dtype type) {
+  if (type == nb::dtype<bool>()) {
+    return mx::bool_;
+  } else if (type == nb::dtype<uint8_t>()) {
+    return mx::uint8;
+  } else if (type == nb::dtype<uint16_t>()) {
+    return mx::uint16;
+  } else if (type == nb::dtype<uint32_t>()) {
+    return mx::uint32;
+  } else if (type == nb::dtype<uint64_t>()) {
+    return mx::uint64;
+  } else if (type == nb::dtype<int8_t>()) {
+    return mx::int8;
+  } else if (type == nb::dtype<int16_t>()) {
+    return mx::int16;
+  } else if (type == nb::dtype<int32_t>()) {
+    return mx::int32;
+  } else if (type == nb::dtype<int64_t>()) {
+    return mx::int64;
+  } else if (type == nb::dtype<mx::float16_t>()) {
+    return mx::float16;
+  } else if (type == nb::bfloat16) {
+    return mx::bfloat16;
+  } else if (type == nb::dtype<float>()) {
+    return mx::float32;
+  } else if (type == nb::dtype<double>()) {
+    return mx::float64;
+  } else if (type == nb::dtype<std::complex<float>>()) {
+    return mx::complex64;
+  } else {
+    throw std::invalid_argument("[from_dlpack] Unsupported DLPack type.");
+  }
+}
+
+mx::array dlpack_to_mlx(nb::object obj) {
+  // See
+  // https://github.com/dmlc/dlpack/blob/5c210da409e7f1e51ddf445134a4376fdbd70d7d/include/dlpack/dlpack.h#L74
+  constexpr int kDLCUDA = 2;
+  constexpr int kDLCUDAManaged = 13;
+  auto device = nb::cast<nb::tuple>(obj.attr("__dlpack_device__")());
+  int device_type = nb::cast<int>(device[0]);
+  if (device_type != kDLCUDA && device_type != kDLCUDAManaged) {
+    return nd_array_to_mlx(
+        nb::cast<nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu>>(obj),
+        std::nullopt);
+  }
+  if (!mx::cu::is_available()) {
+    throw std::invalid_argument(
+        "[from_dlpack] CUDA tensors require the CUDA back-end.");
+  }
+
+  // The producer orders its work on the tensor before the GPU stream.
+  auto s = mx::default_stream(mx::Device::gpu);
+  auto capsule =
+      obj.attr("__dlpack__")(nb::arg("stream") = mx::cu::cuda_stream(s));
+  auto nd_array = nb::cast<nb::ndarray<>>(capsule);
+  mx::Shape shape;
+  for (int i = 0; i < nd_array.ndim(); i++) {
+    shape.push_back(check_shape_dim(nd_array.shape(i)));
+  }
+  int64_t stride = 1;
+  for (int i = nd_array.ndim() - 1; i >= 0; i--) {
+    if (nd_array.shape(i) > 1 && nd_array.stride(i) != stride) {
+      throw std::invalid_argument(
+          "[from_dlpack] Only row contiguous tensors can be imported without "
+          "a copy.");
+    }
+    stride *= nd_array.shape(i);
+  }
+  auto dtype = dlpack_to_mlx_dtype(nd_array.dtype());
+
+  void* data = const_cast<void*>(nd_array.data());
+  int device_id = nd_array.device_id();
+  return mx::cu::from_device_memory(
+      data,
+      std::move(shape),
+      dtype,
+      device_id,
+      release_with_gil(std::move(nd_array)));
+}
+
+// The type strings of the array interfaces, see
+// https://numpy.org/doc/stable/reference/arrays.interface.html
+std::string mlx_to_typestr(mx::Dtype dtype) {
+  switch (dtype) {
+    case mx::bool_:
+      return "|b1";
+    case mx::uint8:
+      return "|u1";
+    case mx::uint16:
+      return "<u2";
+    case mx::uint32:
+      return "<u4";
+    case mx::uint64:
+      return "<u8";
+    case mx::int8:
+      return "|i1";
+    case mx::int16:
+      return "<i2";
+    case mx::int32:
+      return "<i4";
+    case mx::int64:
+      return "<i8";
+    case mx::float16:
+      return "<f2";
+    case mx::float32:
+      return "<f4";
+    case mx::float64:
+      return "<f8";
+    case mx::complex64:
+      return "<c8";
+    default:
+      throw nb::type_error(
+          "[__cuda_array_interface__] The type has no type string.");
+  }
+}
+
+mx::Dtype typestr_to_mlx(const std::string& typestr) {
+  static const std::unordered_map<std::string, mx::Dtype> types = {
+      {"|b1", mx::bool_},
+      {"|u1", mx::uint8},
+      {"<u2", mx::uint16},
+      {"<u4", mx::uint32},
+      {"<u8", mx::uint64},
+      {"|i1", mx::int8},
+      {"<i2", mx::int16},
+      {"<i4", mx::int32},
+      {"<i8", mx::int64},
+      {"<f2", mx::float16},
+      {"<f4", mx::float32},
+      {"<f8", mx::float64},
+      {"<c8", mx::complex64},
+  };
+  auto it = types.find(typestr);
+  if (it == types.end()) {
+    throw std::invalid_argument(
+        "[array] Unsupported __cuda_array_interface__ type " + typestr + ".");
+  }
+  return it->second;
+}
+
+nb::dict mlx_to_cuda_array_interface(const mx::array& a) {
+  if (!mx::cu::is_available()) {
+    throw nb::attribute_error(
+        "[__cuda_array_interface__] The CUDA back-end is not available.");
+  }
+  auto typestr = mlx_to_typestr(a.dtype());
+  std::uintptr_t stream;
+  {
+    nb::gil_scoped_release nogil;
+    stream = mx::cu::evaluation_stream(a);
+  }
+  nb::list shape;
+  nb::list strides;
+  for (int i = 0; i < a.ndim(); i++) {
+    shape.append(a.shape(i));
+    strides.append(a.strides(i) * a.itemsize());
+  }
+  nb::dict interface;
+  interface["shape"] = nb::tuple(shape);
+  interface["typestr"] = typestr;
+  interface["data"] = nb::make_tuple(
+      reinterpret_cast<std::uintptr_t>(a.data<void>()), false);
+  interface["version"] = 3;
+  if (a.flags().row_contiguous) {
+    interface["strides"] = nb::none();
+  } else {
+    interface["strides"] = nb::tuple(strides);
+  }
+  if (stream == 0) {
+    interface["stream"] = nb::none();
+  } else {
+    interface["stream"] = stream;
+  }
+  return interface;
+}
+
+mx::array cuda_array_interface_to_mlx(nb::object obj) {
+  auto interface = nb::cast<nb::dict>(obj.attr("__cuda_array_interface__"));
+  auto dtype = typestr_to_mlx(nb::cast<std::string>(interface["typestr"]));
+  mx::Shape shape;
+  for (auto dim : nb::cast<nb::tuple>(interface["shape"])) {
+    shape.push_back(check_shape_dim(nb::cast<int64_t>(dim)));
+  }
+  if (interface.contains("strides") && !interface["strides"].is_none()) {
+    auto strides = nb::cast<nb::tuple>(interface["strides"]);
+    int64_t stride = dtype.size();
+    for (int i = shape.size() - 1; i >= 0; i--) {
+      if (shape[i] > 1 && nb::cast<int64_t>(strides[i]) != stride) {
+        throw std::invalid_argument(
+            "[array] Only row contiguous __cuda_array_interface__ arrays are "
+            "supported.");
+      }
+      stride *= shape[i];
+    }
+  }
+  if (interface.contains("mask") && !interface["mask"].is_none()) {
+    throw std::invalid_argument(
+        "[array] Masked __cuda_array_interface__ arrays are not supported.");
+  }
+  auto data =
+      nb::cast<std::uintptr_t>(nb::cast<nb::tuple>(interface["data"])[0]);
+
+  // The GPU waits for the pending work of the producer on the array.
+  if (interface.contains("stream") && !interface["stream"].is_none()) {
+    mx::cu::wait_for_stream(
+        nb::cast<std::uintptr_t>(interface["stream"]),
+        mx::default_stream(mx::Device::gpu));
+  }
+  return mx::cu::from_device_memory(
+      reinterpret_cast<void*>(data),
+      std::move(shape),
+      dtype,
+      -1,
+      release_with_gil(obj));
+}
+
 nb::object to_scalar(mx::array& a) {
   if (a.size() != 1) {
     throw std::invalid_argument(
@@ -486,7 +758,13 @@ mx::array create_array(ArrayInitType v, std::optional<mx::Dtype> t) {
   } else if (auto pv = std::get_if<mx::array>(&v); pv) {
     return mx::astype(*pv, t.value_or((*pv).dtype()));
   } else {
-    auto arr = to_array_with_accessor(std::get<ArrayLike>(v).obj);
+    auto& obj = std::get<ArrayLike>(v).obj;
+    if (mx::cu::is_available() &&
+        nb::hasattr(obj, "__cuda_array_interface__")) {
+      auto arr = cuda_array_interface_to_mlx(obj);
+      return mx::astype(arr, t.value_or(arr.dtype()));
+    }
+    auto arr = to_array_with_accessor(obj);
     return mx::astype(arr, t.value_or(arr.dtype()));
   }
 }
@@ -30,13 +30,27 @@ using ArrayInitType = std::variant<
     nb::tuple,
     ArrayLike>;
 
+// The large arrays are copied straight to the GPU when it is the default
+// device, unless |to_device| is false.
 mx::array nd_array_to_mlx(
     nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd_array,
-    std::optional<mx::Dtype> dtype);
+    std::optional<mx::Dtype> dtype,
+    bool to_device = true);
 
 nb::ndarray<nb::numpy> mlx_to_np_array(const mx::array& a);
 nb::ndarray<> mlx_to_dlpack(const mx::array& a);
 
+// Evaluate the arrays, move them to the host together and return read only
+// NumPy views of their memory.
+nb::list mlx_to_host(const std::vector<mx::array>& arrays);
+
+// Import a DLPack tensor, without a copy when it is in CUDA memory.
+mx::array dlpack_to_mlx(nb::object obj);
+
+// Export and import the __cuda_array_interface__ (v3) of CUDA memory.
+nb::dict mlx_to_cuda_array_interface(const mx::array& a);
+mx::array cuda_array_interface_to_mlx(nb::object obj);
+
 nb::object to_scalar(mx::array& a);
 
 nb::object tolist(mx::array& a);
@@ -0,0 +1,498 @@
+// Copyright © 2025 Apple Inc.
+
+#include <deque>
+
+#include <nanobind/nanobind.h>
+#include <nanobind/ndarray.h>
+#include <nanobind/stl/pair.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/unordered_map.h>
+#include <nanobind/stl/variant.h>
+#include <nanobind/stl/vector.h>
+
+#include "mlx/backend/cuda/cuda.h"
+#include "python/src/convert.h"
+#include "python/src/trees.h"
+
+namespace mx = mlx::core;
+namespace nb = nanobind;
+using namespace nb::literals;
+
+// Iterates over the batches of a Python iterable copied to the GPU ahead of
+// their use. The batches are trees, the structure of each one is kept until
+// it is returned.
+class PyBatchPrefetcher {
+ public:
+  PyBatchPrefetcher(nb::object batches, int ahead)
+      : batches_(nb::iter(batches)),
+        prefetcher_([this]() { return next_batch(); }, ahead) {}
+
+  nb::object next() {
+    std::optional<mx::cu::BatchPrefetcher::Batch> batch;
+    {
+      nb::gil_scoped_release nogil;
+      batch = prefetcher_.next();
+    }
+    if (!batch) {
+      throw nb::stop_iteration();
+    }
+    auto out = structures_.front().unflatten(*batch);
+    structures_.pop_front();
+    return out;
+  }
+
+ private:
+  // Called by the prefetcher without the GIL.
+  std::optional<mx::cu::BatchPrefetcher::Batch> next_batch() {
+    nb::gil_scoped_acquire gil;
+    auto batch = nb::steal(PyIter_Next(batches_.ptr()));
+    if (!batch.is_valid()) {
+      if (PyErr_Occurred()) {
+        throw nb::python_error();
+      }
+      return std::nullopt;
+    }
+    // The NumPy arrays stay on the host until they are staged.
+    batch = tree_map(batch, [](nb::handle leaf) -> nb::object {
+      nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu> nd;
+      if (!nb::isinstance<mx::array>(leaf) && nb::try_cast(leaf, nd)) {
+        return nb::cast(nd_array_to_mlx(nd, std::nullopt, false));
+      }
+      return nb::borrow(leaf);
+    });
+    auto [arrays, structure] = TreeDef::flatten(batch, false);
+    structures_.push_back(std::move(structure));
+    return arrays;
+  }
+
+  nb::object batches_;
+  std::deque<TreeDef> structures_;
+  mx::cu::BatchPrefetcher prefetcher_;
+};
+
+void init_cuda(nb::module_& m) {
+  nb::module_ cuda = m.def_submodule("cuda", "mlx.cuda");
+  cuda.def(
+      "is_available",
+      &mx::cu::is_available,
+      R"pbdoc(
+      Check if the CUDA back-end is available.
+      )pbdoc");
+  cuda.def(
+      "graph_cache_info",
+      &mx::cu::graph_cache_info,
+      R"pbdoc(
+      Get the counters of the cache of CUDA graph executables.
+
+      The graphs of the commands are cached by topology with at most
+      ``MLX_CUDA_GRAPH_CACHE_SIZE`` executables per stream, and the least
+      recently used one is evicted when the cache is full. The counters are
+      summed over the streams:
+
+      * ``"hits"``: the graphs found in the cache.
+      * ``"misses"``: the graphs not found in the cache.
+      * ``"instantiations"``: the executables created, for the misses and
+        for the cached executables that could not be updated to a new graph.
+      * ``"evictions"``: the executables evicted from a full cache.
+      * ``"capacity"``: the maximum number of executables cached per stream.
+
+      Returns:
+          dict: The counters, empty when CUDA is not available.
+      )pbdoc");
+  cuda.def(
+      "reset_graph_cache_info",
+      &mx::cu::reset_graph_cache_info,
+      R"pbdoc(
+      Reset the counters of :func:`graph_cache_info` to zero.
+      )pbdoc");
+  cuda.def(
+      "dispatch_info",
+      &mx::cu::dispatch_info,
+      R"pbdoc(
+      Get the counters splitting the time of the ops evaluated on the GPU.
+
+      The counters are summed over the streams, the times are in
+      microseconds:
+
+      * ``"evals"``: the primitives evaluated.
+      * ``"nodes"``: the graph nodes launched.
+      * ``"graphs"``: the graphs launched.
+      * ``"dispatch_us"``: the host time of evaluating the primitives and
+        adding their nodes to the graphs.
+      * ``"update_us"``: the host time of updating the cached graph
+        executables.
+      * ``"instantiate_us"``: the host time of instantiating graph
+        executables.
+      * ``"launch_us"``: the rest of the host time of committing the graphs,
+        including their launch.
+      * ``"gpu_us"``: the GPU time of the timed graphs.
+      * ``"gpu_nodes"``: the nodes of the timed graphs.
+      * ``"retire_us"``: the time of running the completion handlers, which
+        release the buffers of the finished graphs.
+
+      Returns:
+          dict: The counters, empty when CUDA is not available.
+      )pbdoc");
+  cuda.def(
+      "reset_dispatch_info",
+      &mx::cu::reset_dispatch_info,
+      R"pbdoc(
+      Reset the counters of :func:`dispatch_info` to zero.
+      )pbdoc");
+  cuda.def(
+      "precompile_kernels",
+      &mx::cu::precompile_kernels,
+      nb::call_guard<nb::gil_scoped_release>(),
+      R"pbdoc(
+      Load the kernels JIT compiled by previous runs.
+
+      The sources of the kernels are cached in ``MLX_PTX_CACHE_DIR`` along
+      with their binaries for each GPU architecture and NVRTC version. This
+      loads all of them for the GPU, compiling the ones without a binary for
+      it. Use it to warm up a pre-populated cache before the first
+      evaluation.
+
+      Returns:
+          int: The number of kernel modules loaded, ``0`` when CUDA is not
+          available.
+      )pbdoc");
+  cuda.def(
+      "prefetch",
+      &mx::cu::prefetch,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "arrays"_a,
+      "to_host"_a = false,
+      R"pbdoc(
+      Prefetch the memory of arrays to the GPU or to the host.
+
+      The arrays are in managed memory which is otherwise moved on demand by
+      page faults, at the first access of a kernel or of the host. The
+      memory written by the host is also prefetched when a kernel first
+      reads it. The arrays are evaluated first.
+
+      Args:
+          arrays (list(array)): The arrays to prefetch.
+          to_host (bool, optional): Prefetch to the host instead of the GPU.
+            Default: ``False``.
+      )pbdoc");
+  cuda.def(
+      "set_read_mostly",
+      &mx::cu::set_read_mostly,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "arrays"_a,
+      R"pbdoc(
+      Advise that the memory of arrays, such as weights, is mostly read.
+
+      The GPU and the host then keep a copy of the memory they read instead
+      of moving it back and forth, and a write invalidates the copies. The
+      arrays are evaluated first, and the advice lasts until their memory is
+      freed.
+
+      Args:
+          arrays (list(array)): The mostly read arrays.
+      )pbdoc");
+  cuda.def(
+      "set_l2_persisting",
+      &mx::cu::set_l2_persisting,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "arrays"_a,
+      "persisting"_a = true,
+      R"pbdoc(
+      Keep the memory of arrays in the L2 cache of the GPU.
+
+      The arrays, such as the norms and small weights of a model or the
+      recent pages of a KV cache read at every step of a decode, are read
+      through the persisting part of the L2 so the streaming reads of the
+      large weights do not evict them. The persisting L2 is reserved on the
+      first use, at most ``MLX_CUDA_L2_PERSISTING_MB``, and shared between
+      the persisting arrays. With ``MLX_CUDA_L2_AUTO_PERSIST=1`` the small
+      arrays read by the kernels of several graphs are also kept. The GPUs
+      before sm_80 have no persisting L2.
+
+      The arrays are evaluated first, and they are kept until their memory
+      is freed.
+
+      Args:
+          arrays (list(array)): The arrays to keep in the L2.
+          persisting (bool, optional): Stop keeping the arrays when
+            ``False``. Default: ``True``.
+      )pbdoc");
+  cuda.def(
+      "offload",
+      &mx::cu::offload,
+      nb::call_guard<nb::gil_scoped_release>(),
+      "layers"_a,
+      "ahead"_a = 1,
+      R"pbdoc(
+      Offload the arrays of layers to the host.
+
+      The memory of the arrays, such as the weights of the layers of a model
+      larger than the GPU memory, is kept on the host where the GPU reads it
+      through its mapping. When a kernel reads a layer, the next ``ahead``
+      layers are prefetched to the GPU on a stream of their own while the
+      layer is computed, and the other layers are moved back to the host.
+
+      The arrays are evaluated first. The previously offloaded layers are
+      restored, and an empty list only restores them.
+
+      Args:
+          layers (list(list(array))): The arrays of each layer, in the order
+            the layers are read. The first layer follows the last.
+          ahead (int, optional): The number of layers prefetched ahead of
+            the layer being computed. Default: ``1``.
+      )pbdoc");
+  cuda.def(
+      "start_profiling",
+      &mx::cu::start_profiling,
+      R"pbdoc(
+      Start timing the primitives evaluated on the GPU.
+
+      The kernels of each primitive are enclosed by a pair of CUDA events.
+      While profiling, each primitive is committed in a CUDA graph of its
+      own so the primitives of a stream run one at a time, which makes the
+      evaluation slower than without profiling. The records of a previous
+      run are discarded.
+      )pbdoc");
+  cuda.def(
+      "stop_profiling",
+      &mx::cu::stop_profiling,
+      R"pbdoc(
+      Stop timing the primitives, the records are kept until the next
+      :func:`start_profiling`.
+      )pbdoc");
+  cuda.def(
+      "profiling_info",
+      &mx::cu::profiling_info,
+      R"pbdoc(
+      Get the GPU time of the primitives timed since :func:`start_profiling`.
+
+      The primitives are keyed by name and each has:
+
+      * ``"count"``: the number of evaluations.
+      * ``"time_ms"``: the total GPU time in milliseconds.
+      * ``"bytes"``: the total size of the inputs and outputs.
+      * ``"bandwidth_gbps"``: the bytes over the time in GB/s.
+
+      Waits for the GPU to finish the timed primitives.
+
+      Returns:
+          dict: The stats of the primitives, empty when CUDA is not
+          available.
+      )pbdoc");
+  cuda.def(
+      "save_profiling_trace",
+      &mx::cu::save_profiling_trace,
+      "path"_a,
+      R"pbdoc(
+      Save the primitives timed since :func:`start_profiling` to a JSON file
+      in the Chrome trace event format, which can be opened in Perfetto or
+      ``chrome://tracing``.
+
+      Each primitive is a complete event whose process is the GPU and whose
+      thread is the stream, with its bytes and bandwidth as arguments.
+
+      Args:
+          path (str): The path of the trace file.
+      )pbdoc");
+  cuda.def(
+      "start_memory_tracing",
+      &mx::cu::start_memory_tracing,
+      R"pbdoc(
+      Start tracing the GPU buffers allocated and freed.
+
+      Each buffer is tagged with the primitive being evaluated when it was
+      allocated, or ``"<unattributed>"`` outside of an evaluation, and marked
+      as a temporary when the primitive only used it while running. The
+      records of a previous trace are discarded.
+      )pbdoc");
+  cuda.def(
+      "stop_memory_tracing",
+      &mx::cu::stop_memory_tracing,
+      R"pbdoc(
+      Stop tracing the buffers, the records are kept until the next
+      :func:`start_memory_tracing`.
+      )pbdoc");
+  cuda.def(
+      "memory_trace_peak",
+      &mx::cu::memory_trace_peak,
+      "top_n"_a = 10,
+      R"pbdoc(
+      Get the tags holding the most memory when the traced memory was the
+      highest.
+
+      Args:
+          top_n (int, optional): The number of tags to return, all of them
+            when negative. Default: ``10``.
+
+      Returns:
+          list(tuple(str, int)): The tags and their bytes in decreasing
+          order of bytes. The temporaries of a primitive are tagged with its
+          name followed by ``" (temporary)"``.
+      )pbdoc");
+  cuda.def(
+      "save_memory_trace",
+      &mx::cu::save_memory_trace,
+      "path"_a,
+      "top_n"_a = 10,
+      R"pbdoc(
+      Save the traced buffers as JSON to a file.
+
+      The file has the ``"peak_memory"`` in bytes, the ``"peak"`` tags as
+      returned by :func:`memory_trace_peak` and the ``"allocations"`` with
+      their tag, size, device, whether they are temporaries, and their
+      allocation and free times in microseconds since the start of the
+      trace. The free time is ``null`` for the buffers still alive.
+
+      Args:
+          path (str): The path of the trace file.
+          top_n (int, optional): The number of tags at the peak.
+            Default: ``10``.
+      )pbdoc");
+
+  cuda.def(
+      "ipc_export",
+      [](const mx::array& a) {
+        auto [copy, handle] = [&a]() {
+          nb::gil_scoped_release nogil;
+          return mx::cu::ipc_export(a);
+        }();
+        return std::make_pair(copy, nb::bytes(handle.data(), handle.size()));
+      },
+      "a"_a,
+      nb::sig("def ipc_export(a: array) -> tuple[array, bytes]"),
+      R"pbdoc(
+      Share a copy of an array with the other processes of the host through
+      CUDA IPC.
+
+      The array is evaluated and copied to device memory, since the managed
+      memory of the arrays can not be shared. The handle also holds an event
+      recorded after the copy, which the importing processes wait for on the
+      GPU. The memory is freed with the copy, so keep the copy alive until
+      the other processes are done with their imported arrays.
+
+      Example:
+          >>> shared, handle = mx.cuda.ipc_export(x)
+          >>> # Send the handle to another process, which calls
+          >>> y = mx.cuda.ipc_import(handle)
+
+      Args:
+          a (array): The array to share.
+
+      Returns:
+          tuple(array, bytes): The copy and its handle.
+      )pbdoc");
+  cuda.def(
+      "ipc_import",
+      [](nb::bytes handle, mx::StreamOrDevice s) {
+        return mx::cu::ipc_import(
+            std::string(handle.c_str(), handle.size()), s);
+      },
+      "handle"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def ipc_import(handle: bytes, *, stream: "
+          "Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+      Map an array exported by :func:`ipc_export` in another process of the
+      host, without copying it.
+
+      The GPU stream waits on the GPU for the copy of the exporting process
+      before its next kernels, so the array should be read on that stream.
+      The memory is unmapped once the array and the arrays sharing its memory
+      are freed.
+
+      Args:
+          handle (bytes): The handle returned by :func:`ipc_export`.
+          stream (Stream, optional): The GPU stream reading the array.
+            Default: the default GPU stream.
+
+      Returns:
+          array: The array sharing the memory of the exported copy.
+      )pbdoc");
+
+  nb::class_<PyBatchPrefetcher>(
+      cuda,
+      "BatchPrefetcher",
+      R"pbdoc(
+      Copy the batches of a data loader to the GPU ahead of their use.
+
+      Iterating over it returns the batches of ``batches`` while the next
+      ``ahead`` ones are copied. The arrays and NumPy arrays of the batches
+      are copied through pinned memory on a GPU stream of their own, so the
+      copies overlap with the current step, which need not evaluate the
+      batches itself. The steps using a batch wait for its copies on the GPU.
+
+      The batches can be arrays or trees of them, and the other leaves are
+      returned as is. Without the CUDA back-end the batches are returned
+      unchanged.
+
+      Example:
+          >>> for x, y in mx.cuda.BatchPrefetcher(loader, ahead=2):
+          ...     loss = step(x, y)
+          ...     mx.eval(loss)
+      )pbdoc")
+      .def(
+          nb::init<nb::object, int>(),
+          "batches"_a,
+          "ahead"_a = 2,
+          R"pbdoc(
+          Args:
+              batches (Iterable): The batches to copy.
+              ahead (int, optional): The number of batches copied ahead.
+                Default: ``2``.
+          )pbdoc")
+      .def("__next__", &PyBatchPrefetcher::next)
+      .def("__iter__", [](nb::handle self) { return nb::borrow(self); });
+
+  nb::class_<mx::cu::GrowableArray>(
+      cuda,
+      "GrowableArray",
+      R"pbdoc(
+      An array grown along its first axis in place, such as a KV cache
+      appended to at each step.
+
+      The rows are stored in a range of addresses reserved for
+      ``max_length`` rows on the GPU, and the pages of memory are mapped as
+      rows are appended. Appending copies only the new rows instead of the
+      whole array like :func:`mlx.core.concatenate`, the address of the
+      array never changes, and no memory is taken for the rows not appended
+      yet. The rows are written on the default GPU stream, where the arrays
+      returned by :meth:`data` should be read. Without the CUDA back-end the
+      rows are concatenated.
+
+      Example:
+          >>> keys = mx.cuda.GrowableArray((8, 64), mx.float16, 4096)
+          >>> keys.append(k)
+          >>> out = attention(q, keys.data())
+      )pbdoc")
+      .def(
+          nb::init<mx::Shape, mx::Dtype, int>(),
+          "shape"_a,
+          "dtype"_a,
+          "max_length"_a,
+          R"pbdoc(
+          Args:
+              shape (tuple(int)): The shape of the rows.
+              dtype (Dtype): The type of the array.
+              max_length (int): The most rows the array can grow to.
+          )pbdoc")
+      .def(
+          "append",
+          &mx::cu::GrowableArray::append,
+          "x"_a,
+          nb::call_guard<nb::gil_scoped_release>(),
+          R"pbdoc(
+          Append the rows of ``x``, of shape ``(n, *shape)``. It is
+          evaluated first.
+          )pbdoc")
+      .def(
+          "data",
+          &mx::cu::GrowableArray::data,
+          R"pbdoc(
+          Get the array of the rows appended so far, which shares their
+          memory.
+          )pbdoc")
+      .def("__len__", &mx::cu::GrowableArray::length)
+      .def_prop_ro("max_length", &mx::cu::GrowableArray::max_length);
+}
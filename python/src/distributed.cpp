@@ -33,6 +33,7 @@ void init_distributed(nb::module_& parent_module) {
       .def(
           "split",
           &mx::distributed::Group::split,
+          nb::call_guard<nb::gil_scoped_release>(),
           "color"_a,
           "key"_a = -1,
           nb::sig("def split(self, color: int, key: int = -1) -> Group"),
@@ -50,6 +51,42 @@ void init_distributed(nb::module_& parent_module) {
                 of the processes.
           )pbdoc");
 
+  m.def(
+      "hierarchical_group",
+      &mx::distributed::hierarchical_group,
+      "local"_a,
+      "cross"_a,
+      nb::sig("def hierarchical_group(local: Group, cross: Group) -> Group"),
+      R"pbdoc(
+      Combine a group within a node with a group across the nodes.
+
+      The ``local`` group contains the processes of a node and ``cross`` the
+      processes with the same local rank on the other nodes. They can come
+      from different backends, for instance NCCL in the node and the ring
+      across nodes, or from splitting the same group.
+
+      :func:`all_sum` on the returned group reduce scatters in the node,
+      all reduces the shards across nodes and all gathers them in the node,
+      so that only a shard of the data crosses the slower links.
+      :func:`all_max`, :func:`all_min` and :func:`all_gather` are also
+      supported.
+
+      Args:
+        local (Group): The group of the processes of this node.
+        cross (Group): The group of the processes on the other nodes with
+          the same rank in their node.
+
+      Returns:
+        Group: A group of all the processes.
+
+      Example:
+
+        >>> world = mx.distributed.init()
+        >>> local = world.split(world.rank() // 8)
+        >>> cross = world.split(world.rank() % 8)
+        >>> group = mx.distributed.hierarchical_group(local, cross)
+      )pbdoc");
+
   m.def(
       "is_available",
       &mx::distributed::is_available,
@@ -60,6 +97,7 @@ void init_distributed(nb::module_& parent_module) {
   m.def(
       "init",
       &mx::distributed::init,
+      nb::call_guard<nb::gil_scoped_release>(),
       "strict"_a = false,
       "backend"_a = "any",
       nb::sig("def init(strict: bool = False, backend: str = 'any') -> Group"),
@@ -79,7 +117,7 @@ void init_distributed(nb::module_& parent_module) {
             in case ``mx.distributed.is_available()`` returns False otherwise
             it throws a runtime error. Default: ``False``
           backend (str, optional): Which distributed backend to initialize.
-            Possible values ``mpi``, ``ring``, ``any``. If set to ``any`` all
+            Possible values ``mpi``, ``ring``, ``nccl``, ``any``. If set to ``any`` all
             available backends are tried and the first one that succeeds
             becomes the global group which will be returned in subsequent
             calls. Default: ``any``
@@ -91,23 +129,46 @@ void init_distributed(nb::module_& parent_module) {
   m.def(
       "all_sum",
       [](const ScalarOrArray& x,
+         std::optional<std::string> compression,
          std::optional<mx::distributed::Group> group,
          mx::StreamOrDevice s) {
-        return mx::distributed::all_sum(to_array(x), group, s);
+        if (!compression) {
+          return mx::distributed::all_sum(to_array(x), group, s);
+        }
+        mx::distributed::Compression c;
+        if (*compression == "bf16") {
+          c = mx::distributed::Compression::BFloat16;
+        } else if (*compression == "fp8") {
+          c = mx::distributed::Compression::Float8;
+        } else {
+          throw std::invalid_argument(
+              "[all_sum] The compression must be 'bf16' or 'fp8' but got '" +
+              *compression + "'.");
+        }
+        return mx::distributed::compressed_all_sum(to_array(x), c, group, s);
       },
       "x"_a,
       nb::kw_only(),
+      "compression"_a = nb::none(),
       "group"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def all_sum(x: array, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+          "def all_sum(x: array, *, compression: Optional[str] = None, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         All reduce sum.
 
         Sum the ``x`` arrays from all processes in the group.
 
+        With ``compression`` the float32 values are sent as ``"bf16"`` or as
+        ``"fp8"`` (e4m3 with a float32 scale per block of 256 values) and the
+        partial sums are accumulated in float32. It halves or quarters the
+        data sent at the cost of precision and is supported by the ring and
+        MPI backends.
+
         Args:
           x (array): Input array.
+          compression (str, optional): The format to send the values in,
+            ``"bf16"`` or ``"fp8"``. Default: ``None``.
           group (Group): The group of processes that will participate in the
             reduction. If set to ``None`` the global group is used. Default:
             ``None``.
@@ -206,6 +267,173 @@ void init_distributed(nb::module_& parent_module) {
           array: The concatenation of all ``x`` arrays.
       )pbdoc");
 
+  m.def(
+      "reduce_scatter",
+      [](const ScalarOrArray& x,
+         std::optional<mx::distributed::Group> group,
+         mx::StreamOrDevice s) {
+        return mx::distributed::reduce_scatter(to_array(x), group, s);
+      },
+      "x"_a,
+      nb::kw_only(),
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def reduce_scatter(x: array, *, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Sum arrays across processes and scatter the result.
+
+        The sum of the ``x`` arrays is split in as many equal chunks along the
+        first axis as processes and each process receives the chunk of its
+        rank. It is equivalent to slicing the result of :func:`all_sum` but
+        each process only sends and receives its share of the data.
+
+        Args:
+          x (array): Input array. The first axis must be divisible by the
+            size of the group.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the default stream of the default device is used.
+
+        Returns:
+          array: The chunk of the sum of all ``x`` arrays of this process.
+      )pbdoc");
+
+  m.def(
+      "all_to_all",
+      [](const ScalarOrArray& x,
+         std::optional<std::vector<int>> send_sizes,
+         std::optional<std::vector<int>> recv_sizes,
+         std::optional<mx::distributed::Group> group,
+         mx::StreamOrDevice s) {
+        if (send_sizes.has_value() != recv_sizes.has_value()) {
+          throw std::invalid_argument(
+              "[all_to_all] Both send_sizes and recv_sizes must be provided.");
+        }
+        if (send_sizes) {
+          return mx::distributed::all_to_all(
+              to_array(x), *send_sizes, *recv_sizes, group, s);
+        }
+        return mx::distributed::all_to_all(to_array(x), group, s);
+      },
+      "x"_a,
+      nb::kw_only(),
+      "send_sizes"_a = nb::none(),
+      "recv_sizes"_a = nb::none(),
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def all_to_all(x: array, *, send_sizes: Optional[Sequence[int]] = None, recv_sizes: Optional[Sequence[int]] = None, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Exchange chunks of an array between all processes.
+
+        The ``x`` array is split along the first axis and the i-th chunk is
+        sent to the process of rank i. The chunks received are concatenated
+        in rank order. By default the chunks have equal sizes, otherwise
+        ``send_sizes[i]`` rows are sent to and ``recv_sizes[i]`` rows are
+        received from rank i.
+
+        Args:
+          x (array): Input array.
+          send_sizes (Sequence[int], optional): The rows sent to each
+            process. Default: ``None``.
+          recv_sizes (Sequence[int], optional): The rows received from each
+            process. Default: ``None``.
+          group (Group): The group of processes that will participate in the
+            exchange. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the default stream of the default device is used.
+
+        Returns:
+          array: The concatenation of the chunks received.
+      )pbdoc");
+
+  m.def(
+      "matmul_all_sum",
+      [](const mx::array& x,
+         const mx::array& w,
+         int chunks,
+         std::optional<mx::distributed::Group> group,
+         mx::StreamOrDevice s) {
+        return mx::distributed::matmul_all_sum(x, w, chunks, group, s);
+      },
+      "x"_a,
+      "w"_a,
+      nb::kw_only(),
+      "chunks"_a = 1,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def matmul_all_sum(x: array, w: array, *, chunks: int = 1, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Multiply arrays and sum the products across processes.
+
+        This is the row-parallel linear layer, where each process has a
+        shard of the input features of ``x`` and of the rows of ``w``. It is
+        equivalent to ``all_sum(x @ w)``, but the rows of ``x`` are split
+        in ``chunks`` and the sum of a chunk overlaps the product of the next
+        one.
+
+        Args:
+          x (array): Input array with shape ``(..., K)``.
+          w (array): Weight array with shape ``(K, N)``.
+          chunks (int): The number of chunks of the rows of ``x``. Default:
+            ``1``.
+          group (Group): The group of processes that will participate in the
+            reduction. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the default stream of the default device is used.
+
+        Returns:
+          array: The sum of the products with shape ``(..., N)``.
+      )pbdoc");
+
+  m.def(
+      "all_gather_matmul",
+      [](const mx::array& x,
+         const mx::array& w,
+         int chunks,
+         std::optional<mx::distributed::Group> group,
+         mx::StreamOrDevice s) {
+        return mx::distributed::all_gather_matmul(x, w, chunks, group, s);
+      },
+      "x"_a,
+      "w"_a,
+      nb::kw_only(),
+      "chunks"_a = 1,
+      "group"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def all_gather_matmul(x: array, w: array, *, chunks: int = 1, group: Optional[Group] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Gather arrays from all processes and multiply them.
+
+        This is the column-parallel linear layer with the rows of the input
+        sharded across processes, e.g. along the sequence. It is equivalent
+        to ``all_gather(x) @ w``, but the rows of ``x`` are split in
+        ``chunks`` and the product of a gathered chunk overlaps the gather of
+        the next one. The chunks have equal sizes, so fewer chunks are used
+        when the rows are not divisible by ``chunks``.
+
+        Args:
+          x (array): Input array with shape ``(..., K)``.
+          w (array): Weight array with shape ``(K, N)``.
+          chunks (int): The number of chunks of the rows of ``x``. Default:
+            ``1``.
+          group (Group): The group of processes that will participate in the
+            gather. If set to ``None`` the global group is used. Default:
+            ``None``.
+          stream (Stream, optional): Stream or device. Defaults to ``None``
+            in which case the default stream of the default device is used.
+
+        Returns:
+          array: The product of the gathered ``x`` with ``w``.
+      )pbdoc");
+
   m.def(
       "send",
       [](const ScalarOrArray& x,
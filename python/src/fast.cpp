@@ -8,6 +8,7 @@
 #include <nanobind/stl/variant.h>
 #include <nanobind/stl/vector.h>
 
+#include "python/src/random.h"
 #include "python/src/utils.h"
 
 #include "mlx/fast.h"
@@ -17,6 +18,47 @@ namespace mx = mlx::core;
 namespace nb = nanobind;
 using namespace nb::literals;
 
+namespace {
+
+std::vector<std::pair<std::string, mx::fast::TemplateArg>> to_template_args(
+    const std::optional<std::vector<std::pair<std::string, nb::object>>>&
+        template_args_,
+    const std::string& tag) {
+  std::vector<std::pair<std::string, mx::fast::TemplateArg>> template_args;
+  if (template_args_) {
+    for (const auto& [name, value] : template_args_.value()) {
+      // Handle bool, int and dtype template args
+      if (nb::isinstance<bool>(value)) {
+        bool bool_val = nb::cast<bool>(value);
+        template_args.emplace_back(name, bool_val);
+      } else if (nb::isinstance<int>(value)) {
+        int int_val = nb::cast<int>(value);
+        template_args.emplace_back(name, int_val);
+      } else if (nb::isinstance<mx::Dtype>(value)) {
+        mx::Dtype dtype = nb::cast<mx::Dtype>(value);
+        template_args.emplace_back(name, dtype);
+      } else {
+        throw std::invalid_argument(
+            "[" + tag +
+            "] Invalid template argument. Must be `mlx.core.Dtype`, `int` or `bool`.");
+      }
+    }
+  }
+  return template_args;
+}
+
+// The key of the stochastic rounding of the optimizer steps, if any.
+std::optional<mx::array> rounding_key(
+    bool stochastic_rounding,
+    const std::optional<mx::array>& key) {
+  if (!stochastic_rounding) {
+    return std::nullopt;
+  }
+  return key ? key.value() : default_key().next();
+}
+
+} // namespace
+
 void init_fast(nb::module_& parent_module) {
   auto m =
       parent_module.def_submodule("fast", "mlx.core.fast: fast operations");
@@ -77,6 +119,70 @@ void init_fast(nb::module_& parent_module) {
             array: The output array.
       )pbdoc");
 
+  m.def(
+      "add_rms_norm",
+      &mx::fast::add_rms_norm,
+      "x"_a,
+      "residual"_a,
+      "weight"_a.none(),
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def add_rms_norm(x: array, residual: array, weight: Optional[array], eps: float, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Residual add followed by root Mean Square normalization (RMS norm).
+
+        Computes ``h = x + residual`` and the RMS norm of ``h`` in a single
+        kernel, which saves a round trip of ``h`` through memory.
+
+        Args:
+            x (array): Input array.
+            residual (array): The residual to add to ``x``. It must have the
+              same shape as ``x``.
+            weight (array, optional): A multiplicative weight to scale the result by.
+              The ``weight`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no scaling happens.
+            eps (float): A small additive constant for numerical stability.
+
+        Returns:
+            tuple(array, array): The sum ``h`` and its normalization.
+      )pbdoc");
+
+  m.def(
+      "add_layer_norm",
+      &mx::fast::add_layer_norm,
+      "x"_a,
+      "residual"_a,
+      "weight"_a.none(),
+      "bias"_a.none(),
+      "eps"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def add_layer_norm(x: array, residual: array, weight: Optional[array], bias: Optional[array], eps: float, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Residual add followed by layer normalization.
+
+        Computes ``h = x + residual`` and the layer norm of ``h`` in a single
+        kernel, which saves a round trip of ``h`` through memory.
+
+        Args:
+            x (array): Input array.
+            residual (array): The residual to add to ``x``. It must have the
+              same shape as ``x``.
+            weight (array, optional): A multiplicative weight to scale the result by.
+              The ``weight`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no scaling happens.
+            bias (array, optional): An additive offset to be added to the result.
+              The ``bias`` should be one-dimensional with the same size
+              as the last axis of ``x``. If set to ``None`` then no translation happens.
+            eps (float): A small additive constant for numerical stability.
+
+        Returns:
+            tuple(array, array): The sum ``h`` and its normalization.
+      )pbdoc");
+
   m.def(
       "rope",
       [](const mx::array& a,
@@ -114,7 +220,49 @@ void init_fast(nb::module_& parent_module) {
               each dimension in the positional encodings. Exactly one of ``base`` and
               ``freqs`` must be ``None``.
             scale (float): The scale used to scale the positions.
-            offset (int or array): The position offset to start at.
+            offset (int or array): The position offset to start at, or one
+              offset per position along the second to last axis.
+            freqs (array, optional): Optional frequencies to use with RoPE.
+              If set, the ``base`` parameter must be ``None``. Default: ``None``.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+
+  m.def(
+      "rope_varlen",
+      &mx::fast::rope_varlen,
+      "a"_a,
+      "dims"_a,
+      nb::kw_only(),
+      "traditional"_a,
+      "base"_a.none(),
+      "scale"_a,
+      "cu_seqlens"_a,
+      "freqs"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def rope_varlen(a: array, dims: int, *, traditional: bool, base: Optional[float], scale: float, cu_seqlens: array, freqs: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Apply rotary positional encoding to packed sequences.
+
+        The tokens of the sequences are packed one after the other like the
+        inputs of :func:`varlen_attention`, and each token is rotated by its
+        position in its own sequence.
+
+        Args:
+            a (array): Input array of shape ``(total_tokens, n_heads, head_dim)``.
+            dims (int): The feature dimensions to be rotated. If the input feature
+              is larger than dims then the rest is left unchanged.
+            traditional (bool): If set to ``True`` choose the traditional
+              implementation which rotates consecutive dimensions.
+            base (float, optional): The base used to compute angular frequency for
+              each dimension in the positional encodings. Exactly one of ``base`` and
+              ``freqs`` must be ``None``.
+            scale (float): The scale used to scale the positions.
+            cu_seqlens (array): The offsets of the sequences of shape
+              ``(num_seqs + 1,)``, the sequence ``b`` holds the tokens
+              ``cu_seqlens[b]`` up to ``cu_seqlens[b + 1]``.
             freqs (array, optional): Optional frequencies to use with RoPE.
               If set, the ``base`` parameter must be ``None``. Default: ``None``.
 
@@ -122,6 +270,59 @@ void init_fast(nb::module_& parent_module) {
             array: The output array.
       )pbdoc");
 
+  m.def(
+      "rope_qkv",
+      &mx::fast::rope_qkv,
+      "qkv"_a,
+      "k_cache"_a,
+      "v_cache"_a,
+      nb::kw_only(),
+      "n_heads"_a,
+      "n_kv_heads"_a,
+      "dims"_a,
+      "traditional"_a,
+      "base"_a.none(),
+      "scale"_a,
+      "offset"_a,
+      "freqs"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def rope_qkv(qkv: array, k_cache: array, v_cache: array, *, n_heads: int, n_kv_heads: int, dims: int, traditional: bool, base: Optional[float], scale: float, offset: int, freqs: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> tuple[array, array, array]"),
+      R"pbdoc(
+        Split a fused query, key and value projection into heads, apply
+        rotary positional encoding to the queries and keys, and write the keys
+        and values to the caches.
+
+        This is equivalent to, but faster than, reshaping and transposing the
+        projection, applying :func:`rope` to the queries and keys and updating
+        the caches with ``k_cache[:, :, offset : offset + L] = keys`` and the
+        same for the values.
+
+        Args:
+            qkv (array): The projection of shape
+              ``(B, L, (n_heads + 2 * n_kv_heads) * head_dim)``.
+            k_cache (array): The key cache of shape
+              ``(B, n_kv_heads, S, head_dim)``.
+            v_cache (array): The value cache with the same shape as ``k_cache``.
+            n_heads (int): The number of query heads.
+            n_kv_heads (int): The number of key and value heads.
+            dims (int): The feature dimensions of a head to be rotated.
+            traditional (bool): If set to ``True`` choose the traditional
+              implementation which rotates consecutive dimensions.
+            base (float, optional): The base used to compute angular frequency for
+              each dimension in the positional encodings. Exactly one of ``base`` and
+              ``freqs`` must be ``None``.
+            scale (float): The scale used to scale the positions.
+            offset (int): The position of the first token, the keys and values
+              are written at this position of the caches.
+            freqs (array, optional): Optional frequencies to use with RoPE.
+              If set, the ``base`` parameter must be ``None``. Default: ``None``.
+
+        Returns:
+            tuple(array, array, array): The queries of shape
+            ``(B, n_heads, L, head_dim)`` and the updated key and value caches.
+      )pbdoc");
+
   m.def(
       "scaled_dot_product_attention",
       [](const mx::array& queries,
@@ -129,8 +330,28 @@ void init_fast(nb::module_& parent_module) {
          const mx::array& values,
          const float scale,
          const std::variant<std::monostate, std::string, mx::array>& mask,
+         int window_size,
+         int num_sinks,
+         const std::optional<mx::array>& tree_mask,
          mx::StreamOrDevice s) {
         bool has_mask = !std::holds_alternative<std::monostate>(mask);
+        if (tree_mask) {
+          if (has_mask) {
+            throw std::invalid_argument(
+                "[scaled_dot_product_attention] The mask and the tree_mask "
+                "cannot be given together.");
+          }
+          return mx::fast::scaled_dot_product_attention(
+              queries,
+              keys,
+              values,
+              scale,
+              "tree",
+              {*tree_mask},
+              window_size,
+              num_sinks,
+              s);
+        }
         bool has_str_mask =
             has_mask && std::holds_alternative<std::string>(mask);
         bool has_arr_mask = has_mask && std::holds_alternative<mx::array>(mask);
@@ -138,23 +359,40 @@ void init_fast(nb::module_& parent_module) {
         if (has_mask) {
           if (has_str_mask) {
             auto mask_str = std::get<std::string>(mask);
-            if (mask_str != "causal") {
+            if (mask_str != "causal" && mask_str != "chunked") {
               std::ostringstream msg;
               msg << "[scaled_dot_product_attention] invalid mask option '"
-                  << mask_str << "'. Must be 'causal', or an array.";
+                  << mask_str
+                  << "'. Must be 'causal', 'chunked', or an array.";
               throw std::invalid_argument(msg.str());
             }
             return mx::fast::scaled_dot_product_attention(
-                queries, keys, values, scale, mask_str, {}, s);
+                queries,
+                keys,
+                values,
+                scale,
+                mask_str,
+                {},
+                window_size,
+                num_sinks,
+                s);
           } else {
             auto mask_arr = std::get<mx::array>(mask);
             return mx::fast::scaled_dot_product_attention(
-                queries, keys, values, scale, "", {mask_arr}, s);
+                queries,
+                keys,
+                values,
+                scale,
+                "",
+                {mask_arr},
+                window_size,
+                num_sinks,
+                s);
           }
 
         } else {
           return mx::fast::scaled_dot_product_attention(
-              queries, keys, values, scale, "", {}, s);
+              queries, keys, values, scale, "", {}, window_size, num_sinks, s);
         }
       },
       "q"_a,
@@ -163,9 +401,12 @@ void init_fast(nb::module_& parent_module) {
       nb::kw_only(),
       "scale"_a,
       "mask"_a = nb::none(),
+      "window_size"_a = 0,
+      "num_sinks"_a = 0,
+      "tree_mask"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def scaled_dot_product_attention(q: array, k: array, v: array, *, scale: float,  mask: Union[None, str, array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+          "def scaled_dot_product_attention(q: array, k: array, v: array, *, scale: float,  mask: Union[None, str, array] = None, window_size: int = 0, num_sinks: int = 0, tree_mask: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         A fast implementation of multi-head attention: ``O = softmax(Q @ K.T, dim=-1) @ V``.
 
@@ -203,6 +444,22 @@ void init_fast(nb::module_& parent_module) {
                can have at most 4 dimensions and must be broadcast-compatible with
                the shape ``[B, N, T_q, T_kv]``. If an additive mask is given its
                type must promote to the promoted type of ``q``, ``k``, and ``v``.
+               The string type ``"chunked"`` is the causal mask within chunks
+               of ``window_size`` positions.
+            window_size (int, optional): With the ``"causal"`` mask, the number
+               of the last positions up to its own a query attends to. With the
+               ``"chunked"`` mask, the size of the chunks. The kernels skip the
+               keys outside of the windows. Default: ``0``, no window.
+            num_sinks (int, optional): The number of first keys all the queries
+               attend to besides their window. Default: ``0``.
+            tree_mask (array, optional): For the verification of draft tokens,
+               the queries are the last ``T_q`` keys and all see the keys
+               before them. The boolean or additive ``tree_mask``, broadcast
+               compatible with ``[B, N, T_q, T_q]``, masks the scores between
+               the queries, with the ancestors of each draft in a tree or
+               ``mx.tril`` for a chain. On CUDA the few queries are computed
+               in one pass over the cache. Cannot be combined with ``mask``.
+               Default: ``None``.
         Returns:
             array: The output array.
 
@@ -223,142 +480,1027 @@ void init_fast(nb::module_& parent_module) {
       )pbdoc");
 
   m.def(
-      "metal_kernel",
-      [](const std::string& name,
-         const std::vector<std::string>& input_names,
-         const std::vector<std::string>& output_names,
-         const std::string& source,
-         const std::string& header,
-         bool ensure_row_contiguous,
-         bool atomic_outputs) {
-        auto kernel = mx::fast::metal_kernel(
-            name,
-            input_names,
-            output_names,
-            source,
-            header,
-            ensure_row_contiguous,
-            atomic_outputs);
-        return nb::cpp_function(
-            [kernel = std::move(kernel)](
-                const std::vector<ScalarOrArray>& inputs_,
-                const std::vector<mx::Shape>& output_shapes,
-                const std::vector<mx::Dtype>& output_dtypes,
-                std::tuple<int, int, int> grid,
-                std::tuple<int, int, int> threadgroup,
-                const std::optional<
-                    std::vector<std::pair<std::string, nb::object>>>&
-                    template_args_ = std::nullopt,
-                std::optional<float> init_value = std::nullopt,
-                bool verbose = false,
-                mx::StreamOrDevice s = {}) {
-              std::vector<mx::array> inputs;
-              for (const auto& value : inputs_) {
-                inputs.push_back(to_array(value, std::nullopt));
-              }
-              std::vector<std::pair<std::string, mx::fast::TemplateArg>>
-                  template_args;
-              if (template_args_) {
-                for (const auto& [name, value] : template_args_.value()) {
-                  // Handle bool, int and dtype template args
-                  if (nb::isinstance<bool>(value)) {
-                    bool bool_val = nb::cast<bool>(value);
-                    template_args.emplace_back(name, bool_val);
-                  } else if (nb::isinstance<int>(value)) {
-                    int int_val = nb::cast<int>(value);
-                    template_args.emplace_back(name, int_val);
-                  } else if (nb::isinstance<mx::Dtype>(value)) {
-                    mx::Dtype dtype = nb::cast<mx::Dtype>(value);
-                    template_args.emplace_back(name, dtype);
-                  } else {
-                    throw std::invalid_argument(
-                        "[metal_kernel] Invalid template argument. Must be `mlx.core.Dtype`, `int` or `bool`.");
-                  }
-                }
-              }
-              return kernel(
-                  inputs,
-                  output_shapes,
-                  output_dtypes,
-                  grid,
-                  threadgroup,
-                  template_args,
-                  init_value,
-                  verbose,
-                  s);
-            },
-            nb::kw_only(),
-            "inputs"_a,
-            "output_shapes"_a,
-            "output_dtypes"_a,
-            "grid"_a,
-            "threadgroup"_a,
-            "template"_a = nb::none(),
-            "init_value"_a = nb::none(),
-            "verbose"_a = false,
-            "stream"_a = nb::none(),
-            nb::sig(
-                "def __call__(self, *, inputs: List[Union[scalar, array]], output_shapes: List[Sequence[int]], output_dtypes: List[Dtype], grid: tuple[int, int, int], threadgroup: tuple[int, int, int], template: Optional[List[Tuple[str, Union[bool, int, Dtype]]]] = None, init_value: Optional[float] = None, verbose: bool = false, stream: Union[None, Stream, Device] = None)"),
-            R"pbdoc(
-            Run the kernel.
+      "quantized_scaled_dot_product_attention",
+      [](const mx::array& queries,
+         const mx::array& keys,
+         const mx::array& k_scales,
+         const mx::array& k_biases,
+         const mx::array& values,
+         const mx::array& v_scales,
+         const mx::array& v_biases,
+         const float scale,
+         const std::variant<std::monostate, std::string, mx::array>& mask,
+         int group_size,
+         int bits,
+         mx::StreamOrDevice s) {
+        std::string mask_mode;
+        std::vector<mx::array> mask_arrs;
+        if (std::holds_alternative<std::string>(mask)) {
+          mask_mode = std::get<std::string>(mask);
+        } else if (std::holds_alternative<mx::array>(mask)) {
+          mask_arrs.push_back(std::get<mx::array>(mask));
+        }
+        return mx::fast::quantized_scaled_dot_product_attention(
+            queries,
+            keys,
+            k_scales,
+            k_biases,
+            values,
+            v_scales,
+            v_biases,
+            scale,
+            mask_mode,
+            mask_arrs,
+            group_size,
+            bits,
+            s);
+      },
+      "q"_a,
+      "k"_a,
+      "k_scales"_a,
+      "k_biases"_a,
+      "v"_a,
+      "v_scales"_a,
+      "v_biases"_a,
+      nb::kw_only(),
+      "scale"_a,
+      "mask"_a = nb::none(),
+      "group_size"_a = 64,
+      "bits"_a = 8,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_scaled_dot_product_attention(q: array, k: array, k_scales: array, k_biases: array, v: array, v_scales: array, v_biases: array, *, scale: float, mask: Union[None, str, array] = None, group_size: int = 64, bits: int = 8, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Scaled dot product attention with quantized keys and values.
 
-            Args:
-              inputs (List[array]): The inputs passed to the Metal kernel.
-              output_shapes (List[Sequence[int]]): The list of shapes for each output in ``output_names``.
-              output_dtypes (List[Dtype]): The list of data types for each output in ``output_names``.
-              grid (tuple[int, int, int]): 3-tuple specifying the grid to launch the kernel with.
-                This will be passed to ``MTLComputeCommandEncoder::dispatchThreads``.
-              threadgroup (tuple[int, int, int]): 3-tuple specifying the threadgroup size to use.
-                This will be passed to ``MTLComputeCommandEncoder::dispatchThreads``.
-              template (List[Tuple[str, Union[bool, int, Dtype]]], optional): Template arguments.
-                  These will be added as template arguments to the kernel definition. Default: ``None``.
-              init_value (float, optional): Optional value to use to initialize all of the output arrays.
-                  By default, output arrays are uninitialized. Default: ``None``.
-              verbose (bool, optional): Whether to print the full generated source code of the kernel
-                  when it is run. Default: ``False``.
-              stream (mx.stream, optional): Stream to run the kernel on. Default: ``None``.
+        The keys and values are given as returned by :func:`mlx.core.quantize`
+        and are dequantized as they are read, which lets the caches of long
+        contexts take a half or a quarter of the memory for 8 and 4 bits.
 
-            Returns:
-              List[array]: The list of output arrays.)pbdoc");
-      },
-      "name"_a,
-      "input_names"_a,
-      "output_names"_a,
-      "source"_a,
-      "header"_a = "",
-      "ensure_row_contiguous"_a = true,
-      "atomic_outputs"_a = false,
+        Args:
+            q (array): Queries with shape ``[B, N_q, T_q, D]``.
+            k (array): Quantized keys with shape ``[B, N_kv, T_kv, D * bits / 32]``.
+            k_scales (array): The scales of the keys.
+            k_biases (array): The biases of the keys.
+            v (array): Quantized values with the same shape as ``k``.
+            v_scales (array): The scales of the values.
+            v_biases (array): The biases of the values.
+            scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1))``).
+            mask (Union[None, str, array], optional): The mask to apply to the
+               query-key scores, see :func:`scaled_dot_product_attention`.
+            group_size (int, optional): The group size of the quantization.
+              Default: ``64``.
+            bits (int, optional): The number of bits of the quantization.
+              Default: ``8``.
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+  m.def(
+      "quantized_kv_write",
+      &mx::fast::quantized_kv_write,
+      "cache"_a,
+      "scales"_a,
+      "biases"_a,
+      "x"_a,
+      nb::kw_only(),
+      "offset"_a,
+      "group_size"_a = 64,
+      "bits"_a = 8,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_kv_write(cache: array, scales: array, biases: array, x: array, *, offset: int, group_size: int = 64, bits: int = 8, stream: Union[None, Stream, Device] = None) -> tuple[array, array, array]"),
       R"pbdoc(
-      A jit-compiled custom Metal kernel defined from a source string.
+        Quantize keys or values and write them to a quantized cache.
 
-      Full documentation: :ref:`custom_metal_kernels`.
+        This is equivalent to quantizing ``x`` with :func:`mlx.core.quantize`
+        and writing the results at ``[:, :, offset : offset + L]`` of the
+        cache, the scales and the biases.
 
-      Args:
-        name (str): Name for the kernel.
-        input_names (List[str]): The parameter names of the inputs in the
-           function signature.
-        output_names (List[str]): The parameter names of the outputs in the
-           function signature.
-        source (str): Source code. This is the body of a function in Metal,
-           the function signature will be automatically generated.
-        header (str): Header source code to include before the main function.
-           Useful for helper functions or includes that should live outside of
-           the main function body.
-        ensure_row_contiguous (bool): Whether to ensure the inputs are row contiguous
-           before the kernel runs. Default: ``True``.
-        atomic_outputs (bool): Whether to use atomic outputs in the function signature
-           e.g. ``device atomic<float>``. Default: ``False``.
+        Args:
+            cache (array): The quantized cache with shape
+              ``[B, N_kv, S, D * bits / 32]``.
+            scales (array): The scales with shape ``[B, N_kv, S, D / group_size]``.
+            biases (array): The biases with the same shape as ``scales``.
+            x (array): The new keys or values with shape ``[B, N_kv, L, D]``.
+            offset (int): The position of the first new token in the cache.
+            group_size (int, optional): The group size of the quantization.
+              Default: ``64``.
+            bits (int, optional): The number of bits of the quantization.
+              Default: ``8``.
 
-      Returns:
-        Callable ``metal_kernel``.
+        Returns:
+            tuple(array, array, array): The updated cache, scales and biases.
+      )pbdoc");
+  m.def(
+      "paged_kv_write",
+      &mx::fast::paged_kv_write,
+      "k_pages"_a,
+      "v_pages"_a,
+      "keys"_a,
+      "values"_a,
+      "block_table"_a,
+      "context_lens"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def paged_kv_write(k_pages: array, v_pages: array, keys: array, values: array, block_table: array, context_lens: array, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        Write keys and values to paged caches.
 
-      Example:
+        The position ``p`` of the sequence ``b`` is stored in the slot
+        ``p % page_size`` of the page ``block_table[b, p // page_size]``.
 
-        .. code-block:: python
+        Args:
+            k_pages (array): The key pages of shape
+              ``(num_pages, n_kv_heads, page_size, head_dim)``.
+            v_pages (array): The value pages with the same shape as ``k_pages``.
+            keys (array): The new keys of shape ``(B, n_kv_heads, L, head_dim)``.
+            values (array): The new values with the same shape as ``keys``.
+            block_table (array): The pages of each sequence with shape
+              ``(B, max_pages)``.
+            context_lens (array): The number of tokens already in each
+              sequence, the new ones are written after them.
 
-          def exp_elementwise(a: mx.array):
-              source = '''
-                  uint elem = thread_position_in_grid.x;
+        Returns:
+            tuple(array, array): The updated key and value pages.
+      )pbdoc");
+  m.def(
+      "varlen_attention",
+      &mx::fast::varlen_attention,
+      "q"_a,
+      "k"_a,
+      "v"_a,
+      "cu_seqlens_q"_a,
+      "cu_seqlens_k"_a,
+      nb::kw_only(),
+      "scale"_a,
+      "causal"_a = false,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def varlen_attention(q: array, k: array, v: array, cu_seqlens_q: array, cu_seqlens_k: array, *, scale: float, causal: bool = False, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        The attention of sequences of different lengths packed together.
+
+        The tokens of the sequences are packed one after the other without
+        padding. The queries of a sequence only attend to the keys and values
+        of the same sequence. With ``causal`` the queries are the last
+        positions of their sequence and attend to its positions up to their
+        own.
+
+        Args:
+            q (array): Queries with shape ``(total_q, n_heads, head_dim)``.
+            k (array): Keys with shape ``(total_k, n_kv_heads, head_dim)``.
+            v (array): Values with shape ``(total_k, n_kv_heads, head_dim)``.
+            cu_seqlens_q (array): The offsets of the queries of the sequences
+              of shape ``(num_seqs + 1,)``, the sequence ``b`` holds the
+              queries ``cu_seqlens_q[b]`` up to ``cu_seqlens_q[b + 1]``.
+            cu_seqlens_k (array): The offsets of the keys and values of the
+              sequences, with the same shape as ``cu_seqlens_q``.
+            scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1))``).
+            causal (bool, optional): Whether to apply a causal mask in each
+              sequence. Default: ``False``.
+
+        Returns:
+            array: The output array of shape ``(total_q, n_heads, head_dim)``.
+      )pbdoc");
+  m.def(
+      "paged_attention",
+      &mx::fast::paged_attention,
+      "q"_a,
+      "k_pages"_a,
+      "v_pages"_a,
+      "block_table"_a,
+      "context_lens"_a,
+      nb::kw_only(),
+      "scale"_a,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def paged_attention(q: array, k_pages: array, v_pages: array, block_table: array, context_lens: array, *, scale: float, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        The causal attention to the keys and values of paged caches.
+
+        The queries are the last ``L`` positions of their sequence and attend
+        to its positions up to their own. See :func:`paged_kv_write` for the
+        layout of the pages.
+
+        Args:
+            q (array): Queries with shape ``(B, n_heads, L, head_dim)``.
+            k_pages (array): The key pages of shape
+              ``(num_pages, n_kv_heads, page_size, head_dim)``.
+            v_pages (array): The value pages with the same shape as ``k_pages``.
+            block_table (array): The pages of each sequence with shape
+              ``(B, max_pages)``.
+            context_lens (array): The number of tokens of each sequence.
+            scale (float): Scale for queries (typically ``1.0 / sqrt(q.shape(-1))``).
+
+        Returns:
+            array: The output array.
+      )pbdoc");
+
+  nb::class_<mx::fast::PagedKVCache>(
+      m,
+      "PagedKVCache",
+      R"pbdoc(
+        A key and value cache of fixed size pages shared by sequences.
+
+        A sequence only holds the pages its tokens use, and gives them back to
+        the pool when it is freed.
+      )pbdoc")
+      .def(
+          nb::init<int, int, int, int, mx::Dtype, mx::StreamOrDevice>(),
+          "num_pages"_a,
+          "page_size"_a,
+          "n_kv_heads"_a,
+          "head_dim"_a,
+          "dtype"_a = mx::float16,
+          nb::kw_only(),
+          "stream"_a = nb::none(),
+          nb::sig(
+              "def __init__(self, num_pages: int, page_size: int, n_kv_heads: int, head_dim: int, dtype: Dtype = float16, *, stream: Union[None, Stream, Device] = None)"))
+      .def(
+          "add_sequence",
+          &mx::fast::PagedKVCache::add_sequence,
+          "Add an empty sequence and return its id.")
+      .def(
+          "free_sequence",
+          &mx::fast::PagedKVCache::free_sequence,
+          "seq"_a,
+          "Return the pages of a sequence to the pool.")
+      .def(
+          "append",
+          &mx::fast::PagedKVCache::append,
+          "seqs"_a,
+          "keys"_a,
+          "values"_a,
+          R"pbdoc(
+            Append keys and values of shape ``(B, n_kv_heads, L, head_dim)``
+            to the ``B`` sequences ``seqs``.
+          )pbdoc")
+      .def(
+          "attention",
+          &mx::fast::PagedKVCache::attention,
+          "seqs"_a,
+          "q"_a,
+          nb::kw_only(),
+          "scale"_a,
+          R"pbdoc(
+            The attention of the queries of shape ``(B, n_heads, L, head_dim)``
+            to the sequences ``seqs``, see :func:`paged_attention`.
+          )pbdoc")
+      .def(
+          "block_table",
+          &mx::fast::PagedKVCache::block_table,
+          "seqs"_a,
+          "The block table and the lengths of the sequences.")
+      .def("length", &mx::fast::PagedKVCache::length, "seq"_a)
+      .def_prop_ro("k_pages", &mx::fast::PagedKVCache::k_pages)
+      .def_prop_ro("v_pages", &mx::fast::PagedKVCache::v_pages)
+      .def_prop_ro("page_size", &mx::fast::PagedKVCache::page_size)
+      .def_prop_ro("num_free_pages", &mx::fast::PagedKVCache::num_free_pages);
+
+  m.def(
+      "quantized_embedding",
+      &mx::fast::quantized_embedding,
+      "w"_a,
+      "scales"_a,
+      "biases"_a,
+      "indices"_a,
+      "group_size"_a = 64,
+      "bits"_a = 4,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def quantized_embedding(w: array, scales: array, biases: array, indices: array, group_size: int = 64, bits: int = 4, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Look up the rows of a quantized embedding table.
+
+        Computes ``mx.dequantize(w[indices], scales[indices],
+        biases[indices], group_size, bits)`` in one kernel which reads only
+        the selected packed rows, without gathering them first.
+
+        Args:
+            w (array): The quantized table of :func:`~mlx.core.quantize`
+              with shape ``(V, D * bits / 32)``.
+            scales (array): The scales with shape ``(V, D / group_size)``.
+            biases (array): The biases with shape ``(V, D / group_size)``.
+            indices (array): The integer rows to look up.
+            group_size (int, optional): The group size of the quantization.
+              Default: ``64``.
+            bits (int, optional): The bits of the quantization.
+              Default: ``4``.
+
+        Returns:
+            array: The dequantized rows with shape ``indices.shape + (D,)``.
+      )pbdoc");
+
+  m.def(
+      "fp8_matmul",
+      &mx::fast::fp8_matmul,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def fp8_matmul(x: array, w: array, scales: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Matrix multiplication with a float8 ``e4m3`` weight matrix.
+
+        Computes ``x @ (from_fp8(w) * scales[:, None]).T`` where ``w`` are
+        the float8 values of :func:`to_fp8`. On CUDA GPUs with compute
+        capability 8.9 or higher, and ``float16`` or ``bfloat16`` inputs,
+        ``x`` is quantized to float8 with a per-tensor scale and multiplied
+        by the float8 tensor cores. Otherwise ``w`` is converted to the type
+        of ``x``.
+
+        Args:
+            x (array): Input array with at least two dimensions.
+            w (array): The ``uint8`` float8 weights with shape ``(N, K)``.
+            scales (array): The scale of ``w``, with one element for a
+              per-tensor scale or ``N`` elements for per-channel scales.
+
+        Returns:
+            array: The output array with the last axis of size ``N``.
+      )pbdoc");
+
+  m.def(
+      "int8_matmul",
+      &mx::fast::int8_matmul,
+      "x"_a,
+      "w"_a,
+      "scales"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def int8_matmul(x: array, w: array, scales: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Matrix multiplication with an ``int8`` weight matrix and ``int8``
+        activations.
+
+        Each row of ``x`` is quantized to ``int8`` with the scale
+        ``max(abs(row)) / 127``, multiplied by ``w`` with ``int32``
+        accumulation and the result is scaled back by the scales of the
+        rows of ``x`` and by ``scales``. On CUDA GPUs the product runs on
+        the integer tensor cores when the last dimension of ``x`` and the
+        first of ``w`` are multiples of 16.
+
+        Args:
+            x (array): Input array with at least two dimensions.
+            w (array): The ``int8`` weights with shape ``(N, K)``, for
+              instance from :func:`quantize` with ``mode="int8"``.
+            scales (array): The scale of ``w``, with one element for a
+              per-tensor scale or ``N`` elements for per-channel scales.
+
+        Returns:
+            array: The output array with the last axis of size ``N``.
+      )pbdoc");
+
+  m.def(
+      "swiglu",
+      &mx::fast::swiglu,
+      "x"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def swiglu(x: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        The SwiGLU gated activation of the concatenated gate and up
+        projections.
+
+        Computes ``silu(a) * b`` where ``a, b = mx.split(x, 2, axis=-1)`` in
+        one pass, so that the MLP of a LLaMA-style model only needs one
+        matmul with the concatenated gate and up weights and no
+        intermediates of the activation. The gradient of both halves is
+        also computed in one pass.
+
+        Args:
+            x (array): Input array whose last axis holds the gate followed
+              by the up projection.
+
+        Returns:
+            array: The output array with half the size of the last axis.
+      )pbdoc");
+  m.def(
+      "geglu",
+      &mx::fast::geglu,
+      "x"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def geglu(x: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        The GeGLU gated activation of the concatenated gate and up
+        projections.
+
+        Computes ``gelu(a) * b`` where ``a, b = mx.split(x, 2, axis=-1)``,
+        with the exact ``gelu``, see :func:`swiglu`.
+
+        Args:
+            x (array): Input array whose last axis holds the gate followed
+              by the up projection.
+
+        Returns:
+            array: The output array with half the size of the last axis.
+      )pbdoc");
+
+  m.def(
+      "moe_route",
+      &mx::fast::moe_route,
+      "logits"_a,
+      "k"_a,
+      "normalize"_a = true,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def moe_route(logits: array, k: int, normalize: bool = True, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array, array, array]"),
+      R"pbdoc(
+        Route the tokens of a mixture of experts.
+
+        Computes the softmax of the router ``logits``, the top ``k``
+        experts of each token and their weights, the number of tokens of
+        each expert and the permutation which groups the tokens by expert.
+        On CUDA GPUs all of it runs in three small kernels instead of a
+        softmax, a sort and a histogram.
+
+        Args:
+            logits (array): The router logits with shape ``(..., E)``.
+            k (int): The number of experts of each token.
+            normalize (bool, optional): Renormalize the weights of the top
+              ``k`` experts to add up to 1. Default: ``True``.
+
+        Returns:
+            tuple(array, array, array, array): The ``uint32`` indices of the
+            experts with shape ``(..., k)`` from the most likely one, their
+            weights with shape ``(..., k)``, the ``uint32`` number of tokens
+            of each expert with shape ``(E,)`` and the ``uint32``
+            permutation which stably sorts the flattened indices by expert.
+      )pbdoc");
+
+  m.def(
+      "max_with_index",
+      &mx::fast::max_with_index,
+      "a"_a,
+      "axis"_a = -1,
+      "keepdims"_a = false,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def max_with_index(a: array, axis: int = -1, keepdims: bool = False, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        The maximum along an axis and its index.
+
+        Equivalent to ``(mx.max(a, axis), mx.argmax(a, axis))`` in a single
+        pass over ``a``, such as for the logits of a greedy decoding step.
+        On CUDA GPUs long rows are split across thread blocks when there
+        are too few rows to fill the GPU.
+
+        Args:
+            a (array): Input array.
+            axis (int, optional): The axis to reduce over. Default: ``-1``.
+            keepdims (bool, optional): Keep the reduced axis as a singleton
+              dimension. Default: ``False``.
+
+        Returns:
+            tuple(array, array): The maximum values and their ``uint32``
+            indices.
+      )pbdoc");
+  m.def(
+      "min_with_index",
+      &mx::fast::min_with_index,
+      "a"_a,
+      "axis"_a = -1,
+      "keepdims"_a = false,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def min_with_index(a: array, axis: int = -1, keepdims: bool = False, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        The minimum along an axis and its index.
+
+        Equivalent to ``(mx.min(a, axis), mx.argmin(a, axis))`` in a single
+        pass over ``a``, see :func:`max_with_index`.
+
+        Args:
+            a (array): Input array.
+            axis (int, optional): The axis to reduce over. Default: ``-1``.
+            keepdims (bool, optional): Keep the reduced axis as a singleton
+              dimension. Default: ``False``.
+
+        Returns:
+            tuple(array, array): The minimum values and their ``uint32``
+            indices.
+      )pbdoc");
+
+  m.def(
+      "moments",
+      [](const mx::array& a,
+         const IntOrVec& axis,
+         bool keepdims,
+         int ddof,
+         mx::StreamOrDevice s) {
+        return mx::fast::moments(
+            a, get_reduce_axes(axis, a.ndim()), keepdims, ddof, s);
+      },
+      "a"_a,
+      "axis"_a = nb::none(),
+      "keepdims"_a = false,
+      "ddof"_a = 0,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def moments(a: array, axis: Union[None, int, Sequence[int]] = None, keepdims: bool = False, ddof: int = 0, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array]"),
+      R"pbdoc(
+        The mean and the variance over the given axes.
+
+        Equivalent to ``(mx.mean(a, axis), mx.var(a, axis, ddof=ddof))`` in
+        a single pass over ``a`` with Welford's algorithm, such as for the
+        statistics of a normalization layer. Non floating point inputs are
+        cast to ``float32``.
+
+        Args:
+            a (array): Input array.
+            axis (int or list(int), optional): Optional axis or axes to
+              reduce over. Defaults to reducing over the entire array.
+            keepdims (bool, optional): Keep the reduced axes as singleton
+              dimensions. Default: ``False``.
+            ddof (int, optional): The divisor of the variance is
+              ``N - ddof`` where ``N`` is the number of reduced elements.
+              Default: ``0``.
+
+        Returns:
+            tuple(array, array): The mean and the variance.
+      )pbdoc");
+
+  m.def(
+      "lora_matmul",
+      &mx::fast::lora_matmul,
+      "x"_a,
+      "w"_a,
+      "a"_a,
+      "b"_a,
+      "indices"_a,
+      "scale"_a = 1.0f,
+      nb::kw_only(),
+      "sorted_indices"_a = false,
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def lora_matmul(x: array, w: array, a: array, b: array, indices: array, scale: float = 1.0, *, sorted_indices: bool = False, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Matrix multiplication with a different LoRA adapter for each row.
+
+        Computes ``x @ w + scale * (x @ a[i]) @ b[i]`` where ``i`` is the
+        adapter of each row of ``x``, so that a batch of requests using
+        many adapters is served with one base matmul. The low rank products
+        use :func:`gather_mm` and their sum is added in the epilogue of the
+        base matmul.
+
+        Args:
+            x (array): Input array with shape ``(..., K)``.
+            w (array): The base weights with shape ``(K, N)``.
+            a (array): The down projections of the ``L`` adapters with shape
+              ``(L, K, r)``.
+            b (array): The up projections of the adapters with shape
+              ``(L, r, N)``.
+            indices (array): The adapter of each row of ``x`` with shape
+              ``x.shape[:-1]``.
+            scale (float, optional): The scale of the low rank update.
+              Default: ``1.0``.
+            sorted_indices (bool, optional): Whether the rows are sorted by
+              adapter, which lets the rows of an adapter be multiplied
+              together. Default: ``False``.
+
+        Returns:
+            array: The output array with shape ``(..., N)``.
+      )pbdoc");
+
+  m.def(
+      "cross_entropy",
+      &mx::fast::cross_entropy,
+      "logits"_a,
+      "targets"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def cross_entropy(logits: array, targets: array, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Cross entropy loss of class index targets.
+
+        Computes ``logsumexp(logits, axis=-1) - take_along_axis(logits,
+        targets[..., None], axis=-1)[..., 0]`` in one pass over each row of
+        ``logits``. The gradient ``softmax(logits) - one_hot(targets)`` is
+        also written directly, without the intermediate softmax.
+
+        Args:
+            logits (array): The unnormalized logits, with the classes in the
+              last axis.
+            targets (array): The integer class indices, with the shape of
+              ``logits`` without the last axis. The negative indices count
+              from the last class, as in :func:`take_along_axis`. The
+              indices must be in ``[-C, C)`` for ``C`` classes.
+
+        Returns:
+            array: The loss of each row of ``logits``.
+      )pbdoc");
+
+  m.def(
+      "stochastic_round",
+      [](const mx::array& a,
+         const std::optional<mx::array>& key_,
+         mx::StreamOrDevice s) {
+        auto key = key_ ? key_.value() : default_key().next();
+        return mx::fast::stochastic_round(a, key, s);
+      },
+      "a"_a,
+      nb::kw_only(),
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def stochastic_round(a: array, *, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Cast to ``bfloat16`` rounding each value at random.
+
+        A value is rounded up to the next ``bfloat16`` with the probability
+        of its distance to the previous one, so the rounding is unbiased and
+        small updates of ``bfloat16`` parameters are not lost. The random
+        bits are those of ``mx.random.bits(a.shape, 4, key)``.
+
+        Args:
+            a (array): The floating point input.
+            key (array, optional): A PRNG key. Default: ``None``.
+
+        Returns:
+            array: The rounded ``bfloat16`` array.
+      )pbdoc");
+
+  m.def(
+      "sgd_step",
+      [](const std::vector<mx::array>& params,
+         const std::vector<mx::array>& grads,
+         const std::vector<mx::array>& momenta,
+         const ScalarOrArray& learning_rate,
+         float momentum,
+         float weight_decay,
+         float dampening,
+         bool nesterov,
+         bool stochastic_rounding,
+         const std::optional<mx::array>& key,
+         mx::StreamOrDevice s) {
+        return mx::fast::sgd_step(
+            params,
+            grads,
+            momenta,
+            to_array(learning_rate),
+            momentum,
+            weight_decay,
+            dampening,
+            nesterov,
+            rounding_key(stochastic_rounding, key),
+            s);
+      },
+      "params"_a,
+      "grads"_a,
+      "momenta"_a,
+      "learning_rate"_a,
+      nb::kw_only(),
+      "momentum"_a = 0.0,
+      "weight_decay"_a = 0.0,
+      "dampening"_a = 0.0,
+      "nesterov"_a = false,
+      "stochastic_rounding"_a = false,
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def sgd_step(params: Sequence[array], grads: Sequence[array], momenta: Sequence[array], learning_rate: Union[float, array], *, momentum: float = 0.0, weight_decay: float = 0.0, dampening: float = 0.0, nesterov: bool = False, stochastic_rounding: bool = False, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> list[list[array]]"),
+      R"pbdoc(
+        Apply the update of :class:`mlx.optimizers.SGD` to all the
+        parameters at once.
+
+        The parameters of each type are updated by a single kernel, in place
+        when the inputs are donated. The gradients and the momenta have the
+        shapes of the parameters.
+
+        Args:
+            params (list(array)): The parameters.
+            grads (list(array)): The gradients of the parameters.
+            momenta (list(array)): The momenta, ignored without a
+              ``momentum``.
+            learning_rate (float or array): The learning rate.
+            momentum (float, optional): The momentum strength. Default: ``0``.
+            weight_decay (float, optional): The weight decay. Default: ``0``.
+            dampening (float, optional): The dampening of the momentum.
+              Default: ``0``.
+            nesterov (bool, optional): Use the Nesterov momentum.
+              Default: ``False``.
+            stochastic_rounding (bool, optional): Round the new ``bfloat16``
+              parameters with :func:`stochastic_round`. Default: ``False``.
+            key (array, optional): The PRNG key of the rounding.
+              Default: ``None``.
+
+        Returns:
+            list(list(array)): The new parameters and, with a momentum, the
+            new momenta.
+      )pbdoc");
+
+  m.def(
+      "adamw_step",
+      [](const std::vector<mx::array>& params,
+         const std::vector<mx::array>& grads,
+         const std::vector<mx::array>& m_,
+         const std::vector<mx::array>& v,
+         const ScalarOrArray& learning_rate,
+         const std::tuple<float, float>& betas,
+         float eps,
+         float weight_decay,
+         const std::optional<mx::array>& step,
+         bool stochastic_rounding,
+         const std::optional<mx::array>& key,
+         mx::StreamOrDevice s) {
+        return mx::fast::adamw_step(
+            params,
+            grads,
+            m_,
+            v,
+            to_array(learning_rate),
+            std::get<0>(betas),
+            std::get<1>(betas),
+            eps,
+            weight_decay,
+            step,
+            rounding_key(stochastic_rounding, key),
+            s);
+      },
+      "params"_a,
+      "grads"_a,
+      "m"_a,
+      "v"_a,
+      "learning_rate"_a,
+      nb::kw_only(),
+      "betas"_a = std::make_tuple(0.9f, 0.999f),
+      "eps"_a = 1e-8,
+      "weight_decay"_a = 0.01,
+      "step"_a = nb::none(),
+      "stochastic_rounding"_a = false,
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def adamw_step(params: Sequence[array], grads: Sequence[array], m: Sequence[array], v: Sequence[array], learning_rate: Union[float, array], *, betas: Tuple[float, float] = (0.9, 0.999), eps: float = 1e-08, weight_decay: float = 0.01, step: Optional[array] = None, stochastic_rounding: bool = False, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> list[list[array]]"),
+      R"pbdoc(
+        Apply the update of :class:`mlx.optimizers.AdamW` to all the
+        parameters at once.
+
+        The parameters of each type are updated by a single kernel, in place
+        when the inputs are donated. The gradients and the moments have the
+        shapes of the parameters.
+
+        Args:
+            params (list(array)): The parameters.
+            grads (list(array)): The gradients of the parameters.
+            m (list(array)): The first moments.
+            v (list(array)): The second moments.
+            learning_rate (float or array): The learning rate.
+            betas (Tuple[float, float], optional): The coefficients of the
+              running averages. Default: ``(0.9, 0.999)``.
+            eps (float, optional): The term added to the denominator.
+              Default: ``1e-8``.
+            weight_decay (float, optional): The weight decay. Default:
+              ``0.01``.
+            step (array, optional): The step of the bias correction, which is
+              not applied if it is not given. Default: ``None``.
+            stochastic_rounding (bool, optional): Round the new ``bfloat16``
+              parameters with :func:`stochastic_round`. Default: ``False``.
+            key (array, optional): The PRNG key of the rounding.
+              Default: ``None``.
+
+        Returns:
+            list(list(array)): The new parameters, first moments and second
+            moments.
+      )pbdoc");
+
+  m.def(
+      "lion_step",
+      [](const std::vector<mx::array>& params,
+         const std::vector<mx::array>& grads,
+         const std::vector<mx::array>& m_,
+         const ScalarOrArray& learning_rate,
+         const std::tuple<float, float>& betas,
+         float weight_decay,
+         bool stochastic_rounding,
+         const std::optional<mx::array>& key,
+         mx::StreamOrDevice s) {
+        return mx::fast::lion_step(
+            params,
+            grads,
+            m_,
+            to_array(learning_rate),
+            std::get<0>(betas),
+            std::get<1>(betas),
+            weight_decay,
+            rounding_key(stochastic_rounding, key),
+            s);
+      },
+      "params"_a,
+      "grads"_a,
+      "m"_a,
+      "learning_rate"_a,
+      nb::kw_only(),
+      "betas"_a = std::make_tuple(0.9f, 0.99f),
+      "weight_decay"_a = 0.0,
+      "stochastic_rounding"_a = false,
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def lion_step(params: Sequence[array], grads: Sequence[array], m: Sequence[array], learning_rate: Union[float, array], *, betas: Tuple[float, float] = (0.9, 0.99), weight_decay: float = 0.0, stochastic_rounding: bool = False, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> list[list[array]]"),
+      R"pbdoc(
+        Apply the update of :class:`mlx.optimizers.Lion` to all the
+        parameters at once.
+
+        The parameters of each type are updated by a single kernel, in place
+        when the inputs are donated.
+
+        Args:
+            params (list(array)): The parameters.
+            grads (list(array)): The gradients of the parameters.
+            m (list(array)): The momenta.
+            learning_rate (float or array): The learning rate.
+            betas (Tuple[float, float], optional): The coefficients of the
+              update direction and of the momentum. Default: ``(0.9, 0.99)``.
+            weight_decay (float, optional): The weight decay. Default: ``0``.
+            stochastic_rounding (bool, optional): Round the new ``bfloat16``
+              parameters with :func:`stochastic_round`. Default: ``False``.
+            key (array, optional): The PRNG key of the rounding.
+              Default: ``None``.
+
+        Returns:
+            list(list(array)): The new parameters and momenta.
+      )pbdoc");
+
+  m.def(
+      "sample_top_k_top_p",
+      [](const mx::array& logits,
+         float temperature,
+         int top_k,
+         float top_p,
+         const std::optional<mx::array>& key_,
+         mx::StreamOrDevice s) {
+        auto key = key_ ? key_.value() : default_key().next();
+        return mx::fast::sample_top_k_top_p(
+            logits, temperature, top_k, top_p, key, s);
+      },
+      "logits"_a,
+      nb::kw_only(),
+      "temperature"_a = 1.0,
+      "top_k"_a = 0,
+      "top_p"_a = 1.0,
+      "key"_a = nb::none(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def sample_top_k_top_p(logits: array, *, temperature: float = 1.0, top_k: int = 0, top_p: float = 1.0, key: Optional[array] = None, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Sample from the logits with temperature, top-k and top-p (nucleus)
+        sampling.
+
+        Each row of ``logits / temperature`` keeps its ``top_k`` largest
+        logits, then the smallest set of the largest ones with a probability
+        of at least ``top_p``, and an index is sampled from the softmax of
+        the kept logits. This is done in one pass per row without sorting
+        the logits.
+
+        Args:
+            logits (array): The unnormalized logits, with the vocabulary in
+              the last axis.
+            temperature (float, optional): The temperature, ``0`` takes the
+              largest logit. Default: ``1.0``.
+            top_k (int, optional): The number of largest logits to keep,
+              ``0`` keeps all of them. Default: ``0``.
+            top_p (float, optional): The probability mass of the kept logits,
+              in ``(0, 1]``. Default: ``1.0``.
+            key (array, optional): A PRNG key. Default: ``None``.
+
+        Returns:
+            array: The ``uint32`` sampled indices, with the shape of
+            ``logits`` without the last axis.
+      )pbdoc");
+
+  m.def(
+      "metal_kernel",
+      [](const std::string& name,
+         const std::vector<std::string>& input_names,
+         const std::vector<std::string>& output_names,
+         const std::string& source,
+         const std::string& header,
+         bool ensure_row_contiguous,
+         bool atomic_outputs) {
+        auto kernel = mx::fast::metal_kernel(
+            name,
+            input_names,
+            output_names,
+            source,
+            header,
+            ensure_row_contiguous,
+            atomic_outputs);
+        return nb::cpp_function(
+            [kernel = std::move(kernel)](
+                const std::vector<ScalarOrArray>& inputs_,
+                const std::vector<mx::Shape>& output_shapes,
+                const std::vector<mx::Dtype>& output_dtypes,
+                std::tuple<int, int, int> grid,
+                std::tuple<int, int, int> threadgroup,
+                const std::optional<
+                    std::vector<std::pair<std::string, nb::object>>>&
+                    template_args_ = std::nullopt,
+                std::optional<float> init_value = std::nullopt,
+                bool verbose = false,
+                mx::StreamOrDevice s = {}) {
+              std::vector<mx::array> inputs;
+              for (const auto& value : inputs_) {
+                inputs.push_back(to_array(value, std::nullopt));
+              }
+              auto template_args =
+                  to_template_args(template_args_, "metal_kernel");
+              return kernel(
+                  inputs,
+                  output_shapes,
+                  output_dtypes,
+                  grid,
+                  threadgroup,
+                  template_args,
+                  init_value,
+                  verbose,
+                  s);
+            },
+            nb::kw_only(),
+            "inputs"_a,
+            "output_shapes"_a,
+            "output_dtypes"_a,
+            "grid"_a,
+            "threadgroup"_a,
+            "template"_a = nb::none(),
+            "init_value"_a = nb::none(),
+            "verbose"_a = false,
+            "stream"_a = nb::none(),
+            nb::sig(
+                "def __call__(self, *, inputs: List[Union[scalar, array]], output_shapes: List[Sequence[int]], output_dtypes: List[Dtype], grid: tuple[int, int, int], threadgroup: tuple[int, int, int], template: Optional[List[Tuple[str, Union[bool, int, Dtype]]]] = None, init_value: Optional[float] = None, verbose: bool = false, stream: Union[None, Stream, Device] = None)"),
+            R"pbdoc(
+            Run the kernel.
+
+            Args:
+              inputs (List[array]): The inputs passed to the Metal kernel.
+              output_shapes (List[Sequence[int]]): The list of shapes for each output in ``output_names``.
+              output_dtypes (List[Dtype]): The list of data types for each output in ``output_names``.
+              grid (tuple[int, int, int]): 3-tuple specifying the grid to launch the kernel with.
+                This will be passed to ``MTLComputeCommandEncoder::dispatchThreads``.
+              threadgroup (tuple[int, int, int]): 3-tuple specifying the threadgroup size to use.
+                This will be passed to ``MTLComputeCommandEncoder::dispatchThreads``.
+              template (List[Tuple[str, Union[bool, int, Dtype]]], optional): Template arguments.
+                  These will be added as template arguments to the kernel definition. Default: ``None``.
+              init_value (float, optional): Optional value to use to initialize all of the output arrays.
+                  By default, output arrays are uninitialized. Default: ``None``.
+              verbose (bool, optional): Whether to print the full generated source code of the kernel
+                  when it is run. Default: ``False``.
+              stream (mx.stream, optional): Stream to run the kernel on. Default: ``None``.
+
+            Returns:
+              List[array]: The list of output arrays.)pbdoc");
+      },
+      "name"_a,
+      "input_names"_a,
+      "output_names"_a,
+      "source"_a,
+      "header"_a = "",
+      "ensure_row_contiguous"_a = true,
+      "atomic_outputs"_a = false,
+      R"pbdoc(
+      A jit-compiled custom Metal kernel defined from a source string.
+
+      Full documentation: :ref:`custom_metal_kernels`.
+
+      Args:
+        name (str): Name for the kernel.
+        input_names (List[str]): The parameter names of the inputs in the
+           function signature.
+        output_names (List[str]): The parameter names of the outputs in the
+           function signature.
+        source (str): Source code. This is the body of a function in Metal,
+           the function signature will be automatically generated.
+        header (str): Header source code to include before the main function.
+           Useful for helper functions or includes that should live outside of
+           the main function body.
+        ensure_row_contiguous (bool): Whether to ensure the inputs are row contiguous
+           before the kernel runs. Default: ``True``.
+        atomic_outputs (bool): Whether to use atomic outputs in the function signature
+           e.g. ``device atomic<float>``. Default: ``False``.
+
+      Returns:
+        Callable ``metal_kernel``.
+
+      Example:
+
+        .. code-block:: python
+
+          def exp_elementwise(a: mx.array):
+              source = '''
+                  uint elem = thread_position_in_grid.x;
                   T tmp = inp[elem];
                   out[elem] = metal::exp(tmp);
               '''
@@ -384,4 +1526,153 @@ void init_fast(nb::module_& parent_module) {
           b = exp_elementwise(a)
           assert mx.allclose(b, mx.exp(a))
      )pbdoc");
+
+  m.def(
+      "cuda_kernel",
+      [](const std::string& name,
+         const std::vector<std::string>& input_names,
+         const std::vector<std::string>& output_names,
+         const std::string& source,
+         const std::string& header,
+         bool ensure_row_contiguous,
+         int shared_memory) {
+        auto kernel = mx::fast::cuda_kernel(
+            name,
+            input_names,
+            output_names,
+            source,
+            header,
+            ensure_row_contiguous,
+            shared_memory);
+        return nb::cpp_function(
+            [kernel = std::move(kernel)](
+                const std::vector<ScalarOrArray>& inputs_,
+                const std::vector<mx::Shape>& output_shapes,
+                const std::vector<mx::Dtype>& output_dtypes,
+                std::tuple<int, int, int> grid,
+                std::tuple<int, int, int> threadgroup,
+                const std::optional<
+                    std::vector<std::pair<std::string, nb::object>>>&
+                    template_args_ = std::nullopt,
+                std::optional<float> init_value = std::nullopt,
+                bool verbose = false,
+                mx::StreamOrDevice s = {}) {
+              std::vector<mx::array> inputs;
+              for (const auto& value : inputs_) {
+                inputs.push_back(to_array(value, std::nullopt));
+              }
+              auto template_args =
+                  to_template_args(template_args_, "cuda_kernel");
+              return kernel(
+                  inputs,
+                  output_shapes,
+                  output_dtypes,
+                  grid,
+                  threadgroup,
+                  template_args,
+                  init_value,
+                  verbose,
+                  s);
+            },
+            nb::kw_only(),
+            "inputs"_a,
+            "output_shapes"_a,
+            "output_dtypes"_a,
+            "grid"_a,
+            "threadgroup"_a,
+            "template"_a = nb::none(),
+            "init_value"_a = nb::none(),
+            "verbose"_a = false,
+            "stream"_a = nb::none(),
+            nb::sig(
+                "def __call__(self, *, inputs: List[Union[scalar, array]], output_shapes: List[Sequence[int]], output_dtypes: List[Dtype], grid: tuple[int, int, int], threadgroup: tuple[int, int, int], template: Optional[List[Tuple[str, Union[bool, int, Dtype]]]] = None, init_value: Optional[float] = None, verbose: bool = false, stream: Union[None, Stream, Device] = None)"),
+            R"pbdoc(
+            Run the kernel.
+
+            Args:
+              inputs (List[array]): The inputs passed to the CUDA kernel.
+              output_shapes (List[Sequence[int]]): The list of shapes for each output in ``output_names``.
+              output_dtypes (List[Dtype]): The list of data types for each output in ``output_names``.
+              grid (tuple[int, int, int]): 3-tuple specifying the number of threads to launch
+                in each dimension. Like ``metal_kernel`` this is a grid of threads and not of
+                blocks, so the kernel has to check its bounds when the grid is not a multiple
+                of the threadgroup.
+              threadgroup (tuple[int, int, int]): 3-tuple specifying the block size to use.
+              template (List[Tuple[str, Union[bool, int, Dtype]]], optional): Template arguments.
+                  These will be added as template arguments to the kernel definition. Default: ``None``.
+              init_value (float, optional): Optional value to use to initialize all of the output arrays.
+                  By default, output arrays are uninitialized. Default: ``None``.
+              verbose (bool, optional): Whether to print the full generated source code of the kernel
+                  when it is run. Default: ``False``.
+              stream (mx.stream, optional): Stream to run the kernel on. Default: ``None``.
+
+            Returns:
+              List[array]: The list of output arrays.)pbdoc");
+      },
+      "name"_a,
+      "input_names"_a,
+      "output_names"_a,
+      "source"_a,
+      "header"_a = "",
+      "ensure_row_contiguous"_a = true,
+      "shared_memory"_a = 0,
+      R"pbdoc(
+      A jit-compiled custom CUDA kernel defined from a source string.
+
+      The kernel is compiled with NVRTC the first time it runs with a given
+      set of template arguments and is cached afterwards.
+
+      Args:
+        name (str): Name for the kernel.
+        input_names (List[str]): The parameter names of the inputs in the
+           function signature.
+        output_names (List[str]): The parameter names of the outputs in the
+           function signature.
+        source (str): Source code. This is the body of a ``__global__``
+           function in CUDA, the function signature will be automatically
+           generated. The inputs are ``const T*`` and the outputs ``T*``, and
+           ``{name}_shape``, ``{name}_strides`` and ``{name}_ndim`` are added
+           for the inputs which use them in the source.
+        header (str): Header source code to include before the main function.
+           Useful for helper functions or includes that should live outside of
+           the main function body.
+        ensure_row_contiguous (bool): Whether to ensure the inputs are row contiguous
+           before the kernel runs. Default: ``True``.
+        shared_memory (int): The bytes of dynamic shared memory to launch the
+           kernel with, used through ``extern __shared__`` arrays. Default: ``0``.
+
+      Returns:
+        Callable ``cuda_kernel``.
+
+      Example:
+
+        .. code-block:: python
+
+          def exp_elementwise(a: mx.array):
+              source = '''
+                  auto elem = cooperative_groups::this_grid().thread_rank();
+                  if (elem < inp_shape[0]) {
+                      out[elem] = exp(static_cast<float>(inp[elem]));
+                  }
+              '''
+
+              kernel = mx.fast.cuda_kernel(
+                  name="myexp",
+                  input_names=["inp"],
+                  output_names=["out"],
+                  source=source
+              )
+              outputs = kernel(
+                  inputs=[a],
+                  grid=(a.size, 1, 1),
+                  threadgroup=(256, 1, 1),
+                  output_shapes=[a.shape],
+                  output_dtypes=[mx.float32],
+              )
+              return outputs[0]
+
+          a = mx.random.normal(shape=(4096,))
+          b = exp_elementwise(a)
+          assert mx.allclose(b, mx.exp(a))
+     )pbdoc");
 }
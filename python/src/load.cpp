@@ -170,9 +170,11 @@ class PyFileReader : public mx::io::Reader {
 std::pair<
     std::unordered_map<std::string, mx::array>,
     std::unordered_map<std::string, std::string>>
-mlx_load_safetensor_helper(nb::object file, mx::StreamOrDevice s) {
+mlx_load_safetensor_helper(nb::object file, mx::StreamOrDevice s, bool mmap) {
   if (nb::isinstance<nb::str>(file)) { // Assume .safetensors file path string
-    return mx::load_safetensors(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return mx::load_safetensors(path, s, mmap);
   } else if (is_istream_object(file)) {
     // If we don't own the stream and it was passed to us, eval immediately
     auto res = mx::load_safetensors(std::make_shared<PyFileReader>(file), s);
@@ -191,7 +193,9 @@ mlx_load_safetensor_helper(nb::object file, mx::StreamOrDevice s) {
 
 mx::GGUFLoad mlx_load_gguf_helper(nb::object file, mx::StreamOrDevice s) {
   if (nb::isinstance<nb::str>(file)) { // Assume .gguf file path string
-    return mx::load_gguf(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return mx::load_gguf(path, s);
   }
 
   throw std::invalid_argument("[load_gguf] Input must be a string");
@@ -242,7 +246,9 @@ std::unordered_map<std::string, mx::array> mlx_load_npz_helper(
 
 mx::array mlx_load_npy_helper(nb::object file, mx::StreamOrDevice s) {
   if (nb::isinstance<nb::str>(file)) { // Assume .npy file path string
-    return mx::load(nb::cast<std::string>(file), s);
+    auto path = nb::cast<std::string>(file);
+    nb::gil_scoped_release nogil;
+    return mx::load(path, s);
   } else if (is_istream_object(file)) {
     // If we don't own the stream and it was passed to us, eval immediately
     auto arr = mx::load(std::make_shared<PyFileReader>(file), s);
@@ -260,6 +266,7 @@ LoadOutputTypes mlx_load_helper(
     nb::object file,
     std::optional<std::string> format,
     bool return_metadata,
+    bool mmap,
     mx::StreamOrDevice s) {
   if (!format.has_value()) {
     std::string fname;
@@ -284,7 +291,7 @@ LoadOutputTypes mlx_load_helper(
         "[load] metadata not supported for format " + format.value());
   }
   if (format.value() == "safetensors") {
-    auto [dict, metadata] = mlx_load_safetensor_helper(file, s);
+    auto [dict, metadata] = mlx_load_safetensor_helper(file, s, mmap);
     if (return_metadata) {
       return std::make_pair(dict, metadata);
     }
@@ -2,6 +2,11 @@
 
 #include "mlx/memory.h"
 #include <nanobind/nanobind.h>
+#include <nanobind/stl/optional.h>
+#include <nanobind/stl/string.h>
+#include <nanobind/stl/unordered_map.h>
+
+#include <optional>
 
 namespace mx = mlx::core;
 namespace nb = nanobind;
@@ -10,41 +15,104 @@ using namespace nb::literals;
 void init_memory(nb::module_& m) {
   m.def(
       "get_active_memory",
-      &mx::get_active_memory,
+      [](std::optional<mx::Device> device) {
+        return device ? mx::get_active_memory(*device)
+                      : mx::get_active_memory();
+      },
+      "device"_a = nb::none(),
       R"pbdoc(
       Get the actively used memory in bytes.
 
       Note, this will not always match memory use reported by the system because
       it does not include cached memory buffers.
+
+      Args:
+        device (Device, optional): Only count the memory of this device.
+          Default: ``None``, the memory of all the devices.
       )pbdoc");
   m.def(
       "get_peak_memory",
-      &mx::get_peak_memory,
+      [](std::optional<mx::Device> device) {
+        return device ? mx::get_peak_memory(*device) : mx::get_peak_memory();
+      },
+      "device"_a = nb::none(),
       R"pbdoc(
       Get the peak amount of used memory in bytes.
 
       The maximum memory used recorded from the beginning of the program
       execution or since the last call to :func:`reset_peak_memory`.
+
+      Args:
+        device (Device, optional): Only count the memory of this device.
+          Default: ``None``, the memory of all the devices.
       )pbdoc");
   m.def(
       "reset_peak_memory",
-      &mx::reset_peak_memory,
+      [](std::optional<mx::Device> device) {
+        device ? mx::reset_peak_memory(*device) : mx::reset_peak_memory();
+      },
+      "device"_a = nb::none(),
       R"pbdoc(
       Reset the peak memory to zero.
+
+      Args:
+        device (Device, optional): Only reset the peak memory of this device.
+          Default: ``None``, reset it for all the devices.
       )pbdoc");
   m.def(
       "get_cache_memory",
-      &mx::get_cache_memory,
+      [](std::optional<mx::Device> device) {
+        return device ? mx::get_cache_memory(*device) : mx::get_cache_memory();
+      },
+      "device"_a = nb::none(),
       R"pbdoc(
       Get the cache size in bytes.
 
       The cache includes memory not currently used that has not been returned
       to the system allocator.
+
+      Args:
+        device (Device, optional): Only count the memory of this device.
+          Default: ``None``, the memory of all the devices.
+      )pbdoc");
+  m.def(
+      "get_cache_info",
+      &mx::get_cache_info,
+      R"pbdoc(
+      Get the counters of the memory cache.
+
+      The counters are summed over the devices:
+
+      * ``"hits"``: the allocations served from the cache.
+      * ``"misses"``: the allocations not served from the cache.
+      * ``"evictions"``: the cached buffers freed to make room or by
+        clearing the cache.
+      * ``"requested_bytes"``: the bytes requested by the hits.
+      * ``"reused_bytes"``: the bytes of the buffers reused for the hits.
+        The difference with ``"requested_bytes"`` is the memory lost to
+        reusing larger buffers.
+
+      A cached buffer is only reused for a request when it is at most
+      ``MLX_MAX_CACHE_OVERALLOCATION`` percent of the requested size, 200 by
+      default.
+
+      Returns:
+          dict: The counters, empty when there is no memory cache.
+      )pbdoc");
+  m.def(
+      "reset_cache_info",
+      &mx::reset_cache_info,
+      R"pbdoc(
+      Reset the counters of :func:`get_cache_info` to zero.
       )pbdoc");
   m.def(
       "set_memory_limit",
-      &mx::set_memory_limit,
+      [](size_t limit, std::optional<mx::Device> device) {
+        return device ? mx::set_memory_limit(limit, *device)
+                      : mx::set_memory_limit(limit);
+      },
       "limit"_a,
+      "device"_a = nb::none(),
       R"pbdoc(
       Set the memory limit.
 
@@ -58,14 +126,20 @@ void init_memory(nb::module_& m) {
 
       Args:
         limit (int): Memory limit in bytes.
+        device (Device, optional): Only set the limit of this device.
+          Default: ``None``, set the limit of each device.
 
       Returns:
         int: The previous memory limit in bytes.
       )pbdoc");
   m.def(
       "set_cache_limit",
-      &mx::set_cache_limit,
+      [](size_t limit, std::optional<mx::Device> device) {
+        return device ? mx::set_cache_limit(limit, *device)
+                      : mx::set_cache_limit(limit);
+      },
       "limit"_a,
+      "device"_a = nb::none(),
       R"pbdoc(
       Set the free cache limit.
 
@@ -78,6 +152,8 @@ void init_memory(nb::module_& m) {
 
       Args:
         limit (int): The cache limit in bytes.
+        device (Device, optional): Only set the limit of this device.
+          Default: ``None``, set the limit of each device.
 
       Returns:
         int: The previous cache limit in bytes.
@@ -116,10 +192,17 @@ void init_memory(nb::module_& m) {
       )pbdoc");
   m.def(
       "clear_cache",
-      &mx::clear_cache,
+      [](std::optional<mx::Device> device) {
+        device ? mx::clear_cache(*device) : mx::clear_cache();
+      },
+      "device"_a = nb::none(),
       R"pbdoc(
       Clear the memory cache.
 
       After calling this, :func:`get_cache_memory` should return ``0``.
+
+      Args:
+        device (Device, optional): Only clear the cache of this device.
+          Default: ``None``, clear the cache of all the devices.
       )pbdoc");
 }
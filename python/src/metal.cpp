@@ -88,6 +88,21 @@ void init_metal(nb::module_& m) {
       R"pbdoc(
       Stop a Metal capture.
       )pbdoc");
+  metal.def(
+      "save_binary_archive",
+      &mx::metal::save_binary_archive,
+      R"pbdoc(
+      Write the compiled Metal pipelines to the binary archive on disk.
+
+      The archive is loaded at startup so that the pipelines it holds are
+      not compiled again, and the pipelines compiled since are written to it
+      at exit. Running a workload and calling this function, for instance
+      while building an image, pre-warms the archive for the next processes.
+
+      The archive is stored in ``MLX_METAL_CACHE_DIR``, by default a
+      directory of the temporary directory, with one archive per GPU and OS
+      build. Set ``MLX_METAL_BINARY_ARCHIVE=0`` to disable it.
+      )pbdoc");
   metal.def(
       "device_info",
       &mx::metal::device_info,
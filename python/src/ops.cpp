@@ -2,6 +2,7 @@
 
 #include <numeric>
 #include <ostream>
+#include <sstream>
 #include <variant>
 
 #include <nanobind/nanobind.h>
@@ -44,6 +45,127 @@ double scalar_to_double(Scalar s) {
   }
 }
 
+// The group size and bits default to 64 and 4 for the affine quantization
+// and are fixed by the format for the block scaled ones.
+std::pair<int, int> quantization_params(
+    std::optional<int> group_size,
+    std::optional<int> bits,
+    const std::string& mode) {
+  if (mode == "nvfp4") {
+    return {group_size.value_or(16), bits.value_or(4)};
+  } else if (mode == "mxfp4") {
+    return {group_size.value_or(32), bits.value_or(4)};
+  } else if (mode == "mxfp8") {
+    return {group_size.value_or(32), bits.value_or(8)};
+  } else if (mode == "int8") {
+    return {group_size.value_or(64), bits.value_or(8)};
+  }
+  return {group_size.value_or(64), bits.value_or(4)};
+}
+
+mx::MatmulPrecision matmul_precision_from_string(const std::string& p) {
+  if (p == "default") {
+    return mx::MatmulPrecision::Default;
+  } else if (p == "float32") {
+    return mx::MatmulPrecision::Float32;
+  } else if (p == "tf32") {
+    return mx::MatmulPrecision::TF32;
+  } else if (p == "bfloat16") {
+    return mx::MatmulPrecision::BFloat16;
+  } else if (p == "float16") {
+    return mx::MatmulPrecision::Float16;
+  }
+  throw std::invalid_argument(
+      "[matmul_precision] Precision must be one of 'default', 'float32', "
+      "'tf32', 'bfloat16' or 'float16' but got '" +
+      p + "'.");
+}
+
+// Wrap the Python |fun| to be called, and dropped, by the thread of a CPU
+// stream. The arrays, or NumPy arrays, it returns are checked against the
+// |shapes| and |dtypes| of the outputs in Python. When it raises the error
+// is raised by the next evaluation, as a RuntimeError since it leaves the
+// thread of the stream without the Python exception.
+std::function<std::vector<mx::array>(const std::vector<mx::array>&)>
+host_function(
+    nb::callable fun,
+    std::vector<mx::Shape> shapes,
+    std::vector<mx::Dtype> dtypes) {
+  std::shared_ptr<nb::object> holder(
+      new nb::object(std::move(fun)), [](nb::object* obj) {
+        nb::gil_scoped_acquire gil;
+        delete obj;
+      });
+  return [holder = std::move(holder),
+          shapes = std::move(shapes),
+          dtypes = std::move(dtypes)](const std::vector<mx::array>& inputs) {
+    nb::gil_scoped_acquire gil;
+    auto to_output = [&](nb::handle obj, size_t i) {
+      mx::array out = nb::isinstance<mx::array>(obj)
+          ? nb::cast<mx::array>(obj)
+          : nd_array_to_mlx(
+                nb::cast<nb::ndarray<nb::ro, nb::c_contig, nb::device::cpu>>(
+                    obj),
+                dtypes[i],
+                /* to_device = */ false);
+      if (out.shape() != shapes[i] || out.dtype() != dtypes[i] ||
+          out.status() == mx::array::Status::unscheduled) {
+        std::ostringstream msg;
+        msg << "[host_callback] Expected the output " << i
+            << " to be a computed array of shape " << shapes[i]
+            << " and type " << dtypes[i] << ".";
+        throw std::invalid_argument(msg.str());
+      }
+      return out;
+    };
+    std::vector<mx::array> outputs;
+    try {
+      nb::object result = (*holder)(nb::cast(inputs));
+      bool is_sequence = nb::isinstance<nb::list>(result) ||
+          nb::isinstance<nb::tuple>(result);
+      size_t num_results = is_sequence ? nb::len(result) : 1;
+      if (num_results != shapes.size()) {
+        std::ostringstream msg;
+        msg << "[host_callback] Expected " << shapes.size()
+            << " arrays from the function but got " << num_results << ".";
+        throw std::invalid_argument(msg.str());
+      }
+      if (is_sequence) {
+        for (auto obj : result) {
+          outputs.push_back(to_output(obj, outputs.size()));
+        }
+      } else {
+        outputs.push_back(to_output(result, 0));
+      }
+      return outputs;
+    } catch (nb::python_error& e) {
+      throw std::runtime_error(e.what());
+    }
+  };
+}
+
+// Create the MatmulPrecisionContext on enter and delete on exit.
+class PyMatmulPrecisionContext {
+ public:
+  PyMatmulPrecisionContext(const std::string& precision)
+      : _precision(matmul_precision_from_string(precision)), _inner(nullptr) {}
+
+  void enter() {
+    _inner = new mx::MatmulPrecisionContext(_precision);
+  }
+
+  void exit() {
+    if (_inner != nullptr) {
+      delete _inner;
+      _inner = nullptr;
+    }
+  }
+
+ private:
+  mx::MatmulPrecision _precision;
+  mx::MatmulPrecisionContext* _inner;
+};
+
 void init_ops(nb::module_& m) {
   m.def(
       "reshape",
@@ -278,6 +400,39 @@ void init_ops(nb::module_& m) {
             array: The sum of ``a`` and ``b``.
       )pbdoc");
   m.def(
+      "add_inplace",
+      [](const mx::array& a, const ScalarOrArray& b, mx::StreamOrDevice s) {
+        return mx::add_inplace(a, to_array(b, a.dtype()), s);
+      },
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def add_inplace(a: array, b: Union[scalar, array], stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Element-wise addition written over the buffer of ``a``.
+
+        The result has the shape and type of ``a``, ``b`` is broadcast and
+        cast to it. This is useful to accumulate gradients without keeping
+        two copies of them:
+
+        .. code-block:: python
+
+          acc = tree_map(mx.add_inplace, acc, grads)
+
+        Evaluating the result raises an error when the buffer of ``a``
+        can't be reused, for instance when ``a`` is still referenced by
+        other arrays or by Python variables at that point.
+
+        Args:
+            a (array): Input array.
+            b (array): Input array or scalar.
+
+        Returns:
+            array: The sum of ``a`` and ``b``.
+      )pbdoc");
+  m.def(
       "subtract",
       [](const ScalarOrArray& a_,
          const ScalarOrArray& b_,
@@ -637,13 +792,24 @@ void init_ops(nb::module_& m) {
       )pbdoc");
   m.def(
       "matmul",
-      &mx::matmul,
+      [](const mx::array& a,
+         const mx::array& b,
+         const std::optional<std::string>& precision,
+         mx::StreamOrDevice s) {
+        if (precision) {
+          mx::MatmulPrecisionContext ctx(
+              matmul_precision_from_string(*precision));
+          return mx::matmul(a, b, s);
+        }
+        return mx::matmul(a, b, s);
+      },
       nb::arg(),
       nb::arg(),
       nb::kw_only(),
+      "precision"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def matmul(a: array, b: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def matmul(a: array, b: array, /, *, precision: Optional[str] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Matrix multiplication.
 
@@ -663,6 +829,10 @@ void init_ops(nb::module_& m) {
         Args:
             a (array): Input array or scalar.
             b (array): Input array or scalar.
+            precision (str, optional): The lowest precision of the products
+              and sums, one of ``"default"``, ``"float32"``, ``"tf32"``,
+              ``"bfloat16"`` or ``"float16"``. See :func:`matmul_precision`.
+              Default: ``None`` which uses the current precision.
 
         Returns:
             array: The matrix product of ``a`` and ``b``.
@@ -1604,6 +1774,34 @@ void init_ops(nb::module_& m) {
         Returns:
             array: The output array.
       )pbdoc");
+  m.def(
+      "bincount",
+      &mx::bincount,
+      nb::arg(),
+      "length"_a,
+      "weights"_a = nb::none(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def bincount(x: array, /, length: int, weights: Optional[array] = None, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Count the occurrences of the values of an integer array.
+
+        The values out of ``[0, length)`` are ignored. With ``weights``, the
+        weights of the values are summed instead of counting them.
+
+        Args:
+            x (array): Input array of integers.
+            length (int): The number of bins.
+            weights (array, optional): The weights of the values, of the shape
+              of ``x``.
+
+        Returns:
+            array: The ``int32`` counts of shape ``(length,)``, or the sums of
+            the weights. Floating point weights are summed in ``float32`` or
+            ``float64`` and returned in their type, integer weights are summed
+            in ``int32`` or ``int64``.
+      )pbdoc");
   m.def(
       "full",
       [](const std::variant<int, mx::Shape>& shape,
@@ -2813,6 +3011,47 @@ void init_ops(nb::module_& m) {
         Returns:
             array: The top ``k`` elements from the input.
       )pbdoc");
+  m.def(
+      "unique",
+      [](const mx::array& a,
+         bool return_inverse,
+         bool return_counts,
+         mx::StreamOrDevice s) {
+        return mx::unique(a, return_inverse, return_counts, s);
+      },
+      nb::arg(),
+      "return_inverse"_a = false,
+      "return_counts"_a = false,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def unique(a: array, /, return_inverse: bool = False, return_counts: bool = False, *, stream: Union[None, Stream, Device] = None) -> list[array]"),
+      R"pbdoc(
+        The sorted unique values of the flattened input.
+
+        The number of unique values depends on the data so the values have
+        the size of ``a`` and are returned with their number ``num_unique``.
+        The values after the first ``num_unique`` repeat the largest one and
+        have a count of ``0``. NaNs are all unique.
+
+        Example:
+
+          >>> values, n = mx.unique(mx.array([3, 1, 3, 2]))
+          >>> values[:n.item()]
+          array([1, 2, 3], dtype=int32)
+
+        Args:
+            a (array): Input array.
+            return_inverse (bool, optional): Also return the indices of the
+              elements of ``a`` in the unique values. Default: ``False``.
+            return_counts (bool, optional): Also return the number of times
+              each unique value occurs. Default: ``False``.
+
+        Returns:
+            list(array): The values, the ``int32`` scalar ``num_unique``,
+            the ``int32`` inverse indices of the shape of ``a`` if
+            ``return_inverse`` and the ``int32`` counts if ``return_counts``.
+      )pbdoc");
   m.def(
       "broadcast_to",
       [](const ScalarOrArray& a, const mx::Shape& shape, mx::StreamOrDevice s) {
@@ -3975,9 +4214,10 @@ void init_ops(nb::module_& m) {
       "format"_a = nb::none(),
       "return_metadata"_a = false,
       nb::kw_only(),
+      "mmap"_a = false,
       "stream"_a = nb::none(),
       nb::sig(
-          "def load(file: str, /, format: Optional[str] = None, return_metadata: bool = False, *, stream: Union[None, Stream, Device] = None) -> Union[array, dict[str, array]]"),
+          "def load(file: str, /, format: Optional[str] = None, return_metadata: bool = False, *, mmap: bool = False, stream: Union[None, Stream, Device] = None) -> Union[array, dict[str, array]]"),
       R"pbdoc(
         Load array(s) from a binary file.
 
@@ -3992,6 +4232,10 @@ void init_ops(nb::module_& m) {
             return_metadata (bool, optional): Load the metadata for formats
               which support matadata. The metadata will be returned as an
               additional dictionary. Default: ``False``.
+            mmap (bool, optional): Map a ``.safetensors`` file given by its
+              path in memory. The arrays loaded on the CPU then share the
+              pages of the file rather than copying them, and the GPU copies
+              them without staging. Default: ``False``.
         Returns:
             array or dict:
                 A single array if loading from a ``.npy`` file or a dict
@@ -4001,8 +4245,11 @@ void init_ops(nb::module_& m) {
 
         Warning:
 
-          When loading unsupported quantization formats from GGUF, tensors
-          will automatically cast to ``mx.float16``
+          The ``Q4_0``, ``Q4_1``, ``Q4_K``, ``Q5_K`` and ``Q8_0`` formats of
+          GGUF are loaded as the weights, scales and biases of
+          :func:`quantize` with a group size of 32. When loading other
+          quantization formats from GGUF, tensors will automatically cast
+          to ``mx.float16``
       )pbdoc");
   m.def(
       "save_safetensors",
@@ -4143,18 +4390,40 @@ void init_ops(nb::module_& m) {
       )pbdoc");
   m.def(
       "quantized_matmul",
-      &mx::quantized_matmul,
+      [](mx::array x,
+         mx::array w,
+         mx::array scales,
+         std::optional<mx::array> biases,
+         bool transpose,
+         std::optional<int> group_size_,
+         std::optional<int> bits_,
+         const std::string& mode,
+         mx::StreamOrDevice s) {
+        auto [group_size, bits] =
+            quantization_params(group_size_, bits_, mode);
+        return mx::quantized_matmul(
+            std::move(x),
+            std::move(w),
+            std::move(scales),
+            std::move(biases),
+            transpose,
+            group_size,
+            bits,
+            mode,
+            s);
+      },
       nb::arg(),
       nb::arg(),
       "scales"_a,
-      "biases"_a,
+      "biases"_a = nb::none(),
       "transpose"_a = true,
-      "group_size"_a = 64,
-      "bits"_a = 4,
+      "group_size"_a = nb::none(),
+      "bits"_a = nb::none(),
+      "mode"_a = "affine",
       nb::kw_only(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def quantized_matmul(x: array, w: array, /, scales: array, biases: array, transpose: bool = True, group_size: int = 64, bits: int = 4, *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def quantized_matmul(x: array, w: array, /, scales: array, biases: Optional[array] = None, transpose: bool = True, group_size: Optional[int] = None, bits: Optional[int] = None, mode: str = 'affine', *, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Perform the matrix multiplication with the quantized matrix ``w``. The
         quantization uses one floating point scale and bias per ``group_size`` of
@@ -4165,28 +4434,46 @@ void init_ops(nb::module_& m) {
           x (array): Input array
           w (array): Quantized matrix packed in unsigned integers
           scales (array): The scales to use per ``group_size`` elements of ``w``
-          biases (array): The biases to use per ``group_size`` elements of ``w``
+          biases (array, optional): The biases to use per ``group_size``
+            elements of ``w``. Only used by the ``"affine"`` mode.
           transpose (bool, optional): Defines whether to multiply with the
             transposed ``w`` or not, namely whether we are performing
             ``x @ w.T`` or ``x @ w``. Default: ``True``.
           group_size (int, optional): The size of the group in ``w`` that
-            shares a scale and bias. Default: ``64``.
+            shares a scale and bias. Default: ``64`` for the ``"affine"``
+            mode and the group size of the format otherwise.
           bits (int, optional): The number of bits occupied by each element in
-            ``w``. Default: ``4``.
+            ``w``. Default: ``4`` for the ``"affine"`` mode and the bits of
+            the format otherwise.
+          mode (str, optional): The quantization mode, see :func:`quantize`.
+            Default: ``"affine"``.
 
         Returns:
           array: The result of the multiplication of ``x`` with ``w``.
       )pbdoc");
   m.def(
       "quantize",
-      &mx::quantize,
+      [](const mx::array& w,
+         std::optional<int> group_size_,
+         std::optional<int> bits_,
+         const std::string& mode,
+         mx::StreamOrDevice s) {
+        auto [group_size, bits] =
+            quantization_params(group_size_, bits_, mode);
+        auto out = mx::quantize(w, group_size, bits, mode, s);
+        if (out.size() == 3) {
+          return nb::make_tuple(out[0], out[1], out[2]);
+        }
+        return nb::make_tuple(out[0], out[1]);
+      },
       nb::arg(),
-      "group_size"_a = 64,
-      "bits"_a = 4,
+      "group_size"_a = nb::none(),
+      "bits"_a = nb::none(),
+      "mode"_a = "affine",
       nb::kw_only(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def quantize(w: array, /, group_size: int = 64, bits : int = 4, *, stream: Union[None, Stream, Device] = None) -> tuple[array, array, array]"),
+          "def quantize(w: array, /, group_size: Optional[int] = None, bits: Optional[int] = None, mode: str = 'affine', *, stream: Union[None, Stream, Device] = None) -> list[array]"),
       R"pbdoc(
         Quantize the matrix ``w`` using ``bits`` bits per element.
 
@@ -4222,32 +4509,73 @@ void init_ops(nb::module_& m) {
         save :math:`s` and :math:`\beta` which are the returned ``scales`` and
         ``biases`` respectively.
 
+        The block scaled floating point modes quantize each group to small
+        floating point values which share a power of 2 or float8 scale:
+
+        ===========  ==========  ====  ======================
+        mode         group_size  bits  scale
+        ===========  ==========  ====  ======================
+        ``mxfp4``    32          4     ``e8m0``
+        ``nvfp4``    16          4     ``e4m3``
+        ``mxfp8``    32          8     ``e8m0``
+        ===========  ==========  ====  ======================
+
+        The 4 bit values are ``e2m1`` and the 8 bit values ``e4m3``, both
+        rounded to the nearest even value and saturated. The scales are
+        returned as ``uint8`` and there are no biases.
+
+        The ``"int8"`` mode quantizes each row of ``w`` symmetrically to
+        ``int8`` with the ``float32`` scale :math:`\max_i |w_i| / 127`, the
+        ``group_size`` is not used. With this mode :func:`quantized_matmul`
+        also quantizes the rows of ``x`` and multiplies the ``int8`` values,
+        see :func:`fast.int8_matmul`.
+
         Args:
           w (array): Matrix to be quantized
           group_size (int, optional): The size of the group in ``w`` that shares a
-            scale and bias. Default: ``64``.
+            scale and bias. Default: ``64`` for the ``"affine"`` mode and the
+            group size of the format otherwise.
           bits (int, optional): The number of bits occupied by each element of
-            ``w`` in the returned quantized matrix. Default: ``4``.
+            ``w`` in the returned quantized matrix. Default: ``4`` for the
+            ``"affine"`` mode and the bits of the format otherwise.
+          mode (str, optional): The quantization mode, one of ``"affine"``,
+            ``"mxfp4"``, ``"nvfp4"``, ``"mxfp8"`` or ``"int8"``. Default:
+            ``"affine"``.
 
         Returns:
           tuple: A tuple containing
 
           * w_q (array): The quantized version of ``w``
           * scales (array): The scale to multiply each element with, namely :math:`s`
-          * biases (array): The biases to add to each element, namely :math:`\beta`
+          * biases (array): The biases to add to each element, namely
+            :math:`\beta`. Only returned by the ``"affine"`` mode.
       )pbdoc");
   m.def(
       "dequantize",
-      &mx::dequantize,
+      [](const mx::array& w,
+         const mx::array& scales,
+         const std::optional<mx::array>& biases,
+         std::optional<int> group_size_,
+         std::optional<int> bits_,
+         const std::string& mode,
+         std::optional<mx::Dtype> dtype,
+         mx::StreamOrDevice s) {
+        auto [group_size, bits] =
+            quantization_params(group_size_, bits_, mode);
+        return mx::dequantize(
+            w, scales, biases, group_size, bits, mode, dtype, s);
+      },
       nb::arg(),
       "scales"_a,
-      "biases"_a,
-      "group_size"_a = 64,
-      "bits"_a = 4,
+      "biases"_a = nb::none(),
+      "group_size"_a = nb::none(),
+      "bits"_a = nb::none(),
+      "mode"_a = "affine",
       nb::kw_only(),
+      "dtype"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def dequantize(w: array, /, scales: array, biases: array, group_size: int = 64, bits: int = 4, *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def dequantize(w: array, /, scales: array, biases: Optional[array] = None, group_size: Optional[int] = None, bits: Optional[int] = None, mode: str = 'affine', *, dtype: Optional[Dtype] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Dequantize the matrix ``w`` using the provided ``scales`` and
         ``biases`` and the ``group_size`` and ``bits`` configuration.
@@ -4263,15 +4591,73 @@ void init_ops(nb::module_& m) {
         Args:
           w (array): Matrix to be quantized
           scales (array): The scales to use per ``group_size`` elements of ``w``
-          biases (array): The biases to use per ``group_size`` elements of ``w``
+          biases (array, optional): The biases to use per ``group_size``
+            elements of ``w``. Only used by the ``"affine"`` mode.
           group_size (int, optional): The size of the group in ``w`` that shares a
-            scale and bias. Default: ``64``.
+            scale and bias. Default: ``64`` for the ``"affine"`` mode and the
+            group size of the format otherwise.
           bits (int, optional): The number of bits occupied by each element in
-            ``w``. Default: ``4``.
+            ``w``. Default: ``4`` for the ``"affine"`` mode and the bits of
+            the format otherwise.
+          mode (str, optional): The quantization mode, see :func:`quantize`.
+            Default: ``"affine"``.
+          dtype (Dtype, optional): The type of the result. Default: the type
+            of ``scales`` for the ``"affine"`` and ``"int8"`` modes and
+            ``bfloat16`` otherwise.
 
         Returns:
           array: The dequantized version of ``w``
       )pbdoc");
+  m.def(
+      "to_fp8",
+      &mx::to_fp8,
+      nb::arg(),
+      nb::kw_only(),
+      "format"_a = "e4m3",
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def to_fp8(x: array, /, *, format: str = 'e4m3', stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Convert an array to float8 ``e4m3`` or ``e5m2`` values.
+
+        The values are rounded to the nearest even float8 value. The
+        ``e4m3`` values saturate at the largest finite value ``448`` and
+        the ``e5m2`` values overflow to infinity past ``57344``. The result
+        stores the raw bits of each value as ``uint8``.
+
+        Args:
+          x (array): The floating point input array.
+          format (str, optional): The float8 format, ``"e4m3"`` or
+            ``"e5m2"``. Default: ``"e4m3"``.
+
+        Returns:
+          array: The float8 values of ``x`` as ``uint8``.
+      )pbdoc");
+  m.def(
+      "from_fp8",
+      &mx::from_fp8,
+      nb::arg(),
+      "dtype"_a = mx::bfloat16,
+      nb::kw_only(),
+      "format"_a = "e4m3",
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def from_fp8(x: array, /, dtype: Dtype = bfloat16, *, format: str = 'e4m3', stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Convert float8 ``e4m3`` or ``e5m2`` values, stored as ``uint8``, to
+        a floating point type.
+
+        Args:
+          x (array): The ``uint8`` array of float8 values, as produced by
+            :func:`to_fp8`.
+          dtype (Dtype, optional): The floating point type of the result.
+            Default: ``bfloat16``.
+          format (str, optional): The float8 format, ``"e4m3"`` or
+            ``"e5m2"``. Default: ``"e4m3"``.
+
+        Returns:
+          array: The values of ``x`` in ``dtype``.
+      )pbdoc");
   m.def(
       "gather_qmm",
       &mx::gather_qmm,
@@ -4343,6 +4729,36 @@ void init_ops(nb::module_& m) {
         Returns:
           array: The result per segment of shape ``MxN``.
       )pbdoc");
+  m.def(
+      "sparse_matmul",
+      &mx::sparse_matmul,
+      nb::arg(),
+      nb::arg(),
+      nb::arg(),
+      nb::arg(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def sparse_matmul(indptr: array, indices: array, values: array, b: array, /, *, stream: Union[None, Stream, Device] = None) -> array"),
+      R"pbdoc(
+        Multiply a sparse matrix in the compressed sparse row (CSR) format by
+        the dense matrix ``b``.
+
+        The sparse matrix ``a`` of ``M`` rows has the ``nnz`` nonzeros of its
+        row ``i`` at ``indptr[i]:indptr[i + 1]`` in ``indices``, their
+        columns, and ``values``.
+
+        Args:
+          indptr (array): The offsets of the rows in ``indices`` and
+            ``values``, an ``int32`` array of size ``M + 1``.
+          indices (array): The columns of the nonzeros, an ``int32`` array of
+            size ``nnz``.
+          values (array): The nonzeros, an array of size ``nnz``.
+          b (array): Input array of shape ``KxN``.
+
+        Returns:
+          array: The result of shape ``MxN``.
+      )pbdoc");
   m.def(
       "tensordot",
       [](const mx::array& a,
@@ -4449,16 +4865,30 @@ void init_ops(nb::module_& m) {
     )pbdoc");
   m.def(
       "addmm",
-      &mx::addmm,
+      [](const mx::array& c,
+         const mx::array& a,
+         const mx::array& b,
+         float alpha,
+         float beta,
+         const std::optional<std::string>& precision,
+         mx::StreamOrDevice s) {
+        if (precision) {
+          mx::MatmulPrecisionContext ctx(
+              matmul_precision_from_string(*precision));
+          return mx::addmm(c, a, b, alpha, beta, s);
+        }
+        return mx::addmm(c, a, b, alpha, beta, s);
+      },
       nb::arg(),
       nb::arg(),
       nb::arg(),
       "alpha"_a = 1.0f,
       "beta"_a = 1.0f,
       nb::kw_only(),
+      "precision"_a = nb::none(),
       "stream"_a = nb::none(),
       nb::sig(
-          "def addmm(c: array, a: array, b: array, /, alpha: float = 1.0, beta: float = 1.0,  *, stream: Union[None, Stream, Device] = None) -> array"),
+          "def addmm(c: array, a: array, b: array, /, alpha: float = 1.0, beta: float = 1.0,  *, precision: Optional[str] = None, stream: Union[None, Stream, Device] = None) -> array"),
       R"pbdoc(
         Matrix multiplication with addition and optional scaling.
 
@@ -4472,10 +4902,71 @@ void init_ops(nb::module_& m) {
             alpha (float, optional): Scaling factor for the
                 matrix product of ``a`` and ``b`` (default: ``1``)
             beta (float, optional): Scaling factor for ``c`` (default: ``1``)
+            precision (str, optional): The lowest precision of the matrix
+              product, see :func:`matmul`. Default: ``None``.
 
         Returns:
             array: ``alpha * (a @ b)  + beta * c``
       )pbdoc");
+  nb::class_<PyMatmulPrecisionContext>(m, "MatmulPrecisionContext", R"pbdoc(
+        A context manager for setting the precision of the matmuls.
+
+        See :func:`matmul_precision` for usage.
+
+        Args:
+            precision (str): The precision to set as the default.
+  )pbdoc")
+      .def(nb::init<const std::string&>(), "precision"_a)
+      .def("__enter__", [](PyMatmulPrecisionContext& c) { c.enter(); })
+      .def(
+          "__exit__",
+          [](PyMatmulPrecisionContext& c,
+             const std::optional<nb::type_object>& exc_type,
+             const std::optional<nb::object>& exc_value,
+             const std::optional<nb::object>& traceback) { c.exit(); },
+          "exc_type"_a = nb::none(),
+          "exc_value"_a = nb::none(),
+          "traceback"_a = nb::none());
+  m.def(
+      "matmul_precision",
+      [](const std::string& precision) {
+        return PyMatmulPrecisionContext(precision);
+      },
+      "precision"_a,
+      R"pbdoc(
+        Create a context manager to set the precision of the matmuls.
+
+        The precision applies to the :func:`matmul`, :func:`addmm` and the
+        ``@`` operator called in the context, and to their gradients. It is
+        the lowest precision the backend may use for the products and the
+        sums, which it may exceed. The CUDA backend selects the cuBLAS
+        compute type from it, the CPU and Metal backends always compute at
+        least in the type of the inputs with a ``float32`` accumulation.
+
+        * ``"default"``: TF32 for ``float32`` inputs on CUDA unless
+          ``MLX_ENABLE_TF32=0``.
+        * ``"float32"``: ``float32`` products and sums.
+        * ``"tf32"``: ``float32`` inputs rounded to TF32.
+        * ``"bfloat16"``: ``float32`` inputs rounded to ``bfloat16``.
+        * ``"float16"``: ``float16`` sums for ``float16`` inputs and
+          ``float32`` inputs rounded to ``float16``.
+
+        Args:
+            precision (str): The precision to set as the default.
+
+        Returns:
+            A context manager that sets the precision of the matmuls.
+
+        Example:
+
+        .. code-block::python
+
+          import mlx.core as mx
+
+          with mx.matmul_precision("float32"):
+              # Exact float32 matmuls on CUDA.
+              c = a @ b
+      )pbdoc");
   m.def(
       "block_masked_mm",
       &mx::block_masked_mm,
@@ -5017,11 +5508,65 @@ void init_ops(nb::module_& m) {
         Returns:
             array: The transformed array.
       )pbdoc");
+  m.def(
+      "host_callback",
+      [](nb::callable fun,
+         const std::vector<mx::array>& inputs,
+         std::vector<mx::Shape> output_shapes,
+         const std::vector<mx::Dtype>& output_dtypes,
+         mx::StreamOrDevice s) {
+        auto fn = host_function(std::move(fun), output_shapes, output_dtypes);
+        return mx::host_callback(
+            std::move(fn), inputs, std::move(output_shapes), output_dtypes, s);
+      },
+      "fun"_a,
+      "inputs"_a,
+      "output_shapes"_a,
+      "output_dtypes"_a,
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def host_callback(fun: Callable[[list[array]], Union[array, Sequence[array]]], inputs: list[array], output_shapes: Sequence[Sequence[int]], output_dtypes: Sequence[Dtype], *, stream: Union[None, Stream, Device] = None) -> list[array]"),
+      R"pbdoc(
+        Call a Python function on the host as part of the lazy graph.
+
+        ``fun`` is called with the computed ``inputs`` on a CPU stream, the
+        default one unless ``stream`` is given. The work of the other streams
+        which doesn't use the outputs keeps running meanwhile, so a step such
+        as logging or a lookup on the host doesn't need to evaluate and drain
+        the GPU.
+
+        ``fun`` runs on the thread of the stream and must not evaluate
+        arrays. It returns an array, or a list of arrays, of the given shapes
+        and types made from host data, for instance with :func:`array` from
+        NumPy arrays, which are also accepted. If it raises or returns arrays
+        of other shapes or types, the error is raised by the next evaluation
+        and the outputs are NaN, or zeros for the types without NaN.
+
+        Example:
+
+          >>> def log(xs):
+          ...     print("loss:", xs[0].item())
+          ...     return xs[0]
+          ...
+          >>> (loss,) = mx.host_callback(log, [loss], [()], [mx.float32])
+
+        Args:
+            fun (Callable): The function called with the list of inputs.
+            inputs (list(array)): The inputs of ``fun``.
+            output_shapes (list(Sequence[int])): The shapes of the outputs.
+            output_dtypes (list(Dtype)): The types of the outputs.
+
+        Returns:
+            list(array): The outputs returned by ``fun``.
+      )pbdoc");
   m.def(
       "einsum_path",
-      [](const std::string& equation, const nb::args& operands) {
+      [](const std::string& equation,
+         const nb::args& operands,
+         const std::string& optimize) {
         auto arrays_list = nb::cast<std::vector<mx::array>>(operands);
-        auto [path, str] = mx::einsum_path(equation, arrays_list);
+        auto [path, str] = mx::einsum_path(equation, arrays_list, optimize);
         // Convert to list of tuples
         std::vector<nb::tuple> tuple_path;
         for (auto& p : path) {
@@ -5031,7 +5576,10 @@ void init_ops(nb::module_& m) {
       },
       "subscripts"_a,
       "operands"_a,
-      nb::sig("def einsum_path(subscripts: str, *operands)"),
+      nb::kw_only(),
+      "optimize"_a = "greedy",
+      nb::sig(
+          "def einsum_path(subscripts: str, *operands, optimize: str = 'greedy')"),
       R"pbdoc(
 
       Compute the contraction order for the given Einstein summation.
@@ -5039,6 +5587,11 @@ void init_ops(nb::module_& m) {
       Args:
         subscripts (str): The Einstein summation convention equation.
         *operands (array): The input arrays.
+        optimize (str, optional): ``"greedy"`` finds the path greedily, as
+          :func:`numpy.einsum_path` does. ``"optimal"`` searches for the
+          cheapest path when there are at most 8 operands, preferring the
+          contractions done by a single matmul. That is the path used by
+          :func:`einsum`. Default: ``"greedy"``.
 
       Returns:
         tuple(list(tuple(int, int)), str):
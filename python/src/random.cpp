@@ -7,6 +7,7 @@
 
 #include <chrono>
 
+#include "python/src/random.h"
 #include "python/src/utils.h"
 
 #include "mlx/ops.h"
@@ -16,35 +17,6 @@ namespace mx = mlx::core;
 namespace nb = nanobind;
 using namespace nb::literals;
 
-class PyKeySequence {
- public:
-  explicit PyKeySequence(uint64_t seed) {
-    state_.append(mx::random::key(seed));
-  }
-
-  void seed(uint64_t seed) {
-    state_[0] = mx::random::key(seed);
-  }
-
-  mx::array next() {
-    auto out = mx::random::split(nb::cast<mx::array>(state_[0]));
-    state_[0] = out.first;
-    return out.second;
-  }
-
-  nb::list state() {
-    return state_;
-  }
-
-  void release() {
-    nb::gil_scoped_acquire gil;
-    state_.release().dec_ref();
-  }
-
- private:
-  nb::list state_;
-};
-
 PyKeySequence& default_key() {
   auto get_current_time_seed = []() {
     auto now = std::chrono::system_clock::now();
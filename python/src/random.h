@@ -0,0 +1,43 @@
+// Copyright © 2023-2024 Apple Inc.
+
+#pragma once
+
+#include <nanobind/nanobind.h>
+
+#include "mlx/array.h"
+#include "mlx/random.h"
+
+namespace mx = mlx::core;
+namespace nb = nanobind;
+
+class PyKeySequence {
+ public:
+  explicit PyKeySequence(uint64_t seed) {
+    state_.append(mx::random::key(seed));
+  }
+
+  void seed(uint64_t seed) {
+    state_[0] = mx::random::key(seed);
+  }
+
+  mx::array next() {
+    auto out = mx::random::split(nb::cast<mx::array>(state_[0]));
+    state_[0] = out.first;
+    return out.second;
+  }
+
+  nb::list state() {
+    return state_;
+  }
+
+  void release() {
+    nb::gil_scoped_acquire gil;
+    state_.release().dec_ref();
+  }
+
+ private:
+  nb::list state_;
+};
+
+// The global PRNG of the python random module.
+PyKeySequence& default_key();
@@ -49,6 +49,8 @@ void init_stream(nb::module_& m) {
       A stream for running operations on a given device.
       )pbdoc")
       .def_ro("device", &mx::Stream::device)
+      .def_ro("priority", &mx::Stream::priority)
+      .def_ro("sm_fraction", &mx::Stream::sm_fraction)
       .def(
           "__repr__",
           [](const mx::Stream& s) {
@@ -83,9 +85,52 @@ void init_stream(nb::module_& m) {
       )pbdoc");
   m.def(
       "new_stream",
-      &mx::new_stream,
+      [](mx::Device device, int priority, float sm_fraction) {
+        return mx::new_stream(device, priority, sm_fraction);
+      },
       "device"_a,
-      R"pbdoc(Make a new stream on the given device.)pbdoc");
+      "priority"_a = 0,
+      "sm_fraction"_a = 1.0f,
+      R"pbdoc(
+        Make a new stream on the given device.
+
+        The work of the GPU streams of higher priority runs before the work
+        of the ones of lower priority, for instance to keep a stream of
+        short latency critical kernels responsive next to a stream of long
+        ones. The priority only applies to the CUDA streams, where the
+        levels above ``0`` are limited and the larger values are clamped.
+
+        A CUDA stream with an ``sm_fraction`` below ``1`` runs on a
+        partition of the SMs of its own, in a green context with CUDA 12.4
+        and later, for instance to guarantee SMs to a stream decoding next
+        to a stream of large prefills. The partitions of the streams are
+        disjoint and rounded up to the granularity of the GPU, the streams
+        without one use all the SMs, so the prefill stream should take the
+        rest of them.
+
+        Args:
+          device (Device): The device of the stream.
+          priority (int, optional): The priority of the stream, ``0`` for
+            the default and larger for more urgent. Default: ``0``.
+          sm_fraction (float, optional): The fraction of the SMs the work
+            of the stream runs on, in ``(0, 1]``. Default: ``1``.
+      )pbdoc");
+  m.def(
+      "set_numa_node",
+      &mx::set_numa_node,
+      "stream"_a,
+      "node"_a,
+      R"pbdoc(
+        Place a CPU stream on a NUMA node.
+
+        The thread of the stream runs on the cores of the node and the
+        outputs of the stream are allocated from its memory.
+
+        Args:
+          stream (stream): The CPU stream to place.
+          node (int): The index of the node, ``-1`` lets the stream use
+            all the nodes.
+      )pbdoc");
 
   nb::class_<PyStreamContext>(m, "StreamContext", R"pbdoc(
         A context manager for setting the current device and stream.
@@ -133,6 +178,7 @@ void init_stream(nb::module_& m) {
   m.def(
       "synchronize",
       [](const std::optional<mx::Stream>& s) {
+        nb::gil_scoped_release nogil;
         s ? mx::synchronize(s.value()) : mx::synchronize();
       },
       "stream"_a = nb::none(),
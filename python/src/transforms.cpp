@@ -1,6 +1,7 @@
 // Copyright © 2023-2024 Apple Inc.
 
 #include <algorithm>
+#include <map>
 #include <numeric>
 #include <sstream>
 #include <unordered_set>
@@ -9,13 +10,16 @@
 #include <nanobind/stl/optional.h>
 #include <nanobind/stl/pair.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/unordered_map.h>
 #include <nanobind/stl/unordered_set.h>
 #include <nanobind/stl/variant.h>
 #include <nanobind/stl/vector.h>
 
 #include "mlx/array.h"
+#include "mlx/backend/cuda/cuda.h"
 #include "mlx/compile.h"
 #include "mlx/compile_impl.h"
+#include "mlx/primitives.h"
 #include "mlx/transforms.h"
 #include "mlx/transforms_impl.h"
 #include "mlx/utils.h"
@@ -121,13 +125,21 @@ auto py_value_and_grad(
       }
     }
 
-    // Collect the arrays
+    // Collect the arrays and the structures of the arguments with gradients
     std::vector<mx::array> arrays;
     std::vector<int> counts(1, 0);
     std::vector<int> gradient_indices;
+    std::vector<TreeDef> gradient_structures;
     for (int i = 0, j = 0; i < args.size(); ++i) {
       bool needs_grad = (j < argnums.size() && argnums[j] == i);
-      auto argsi = tree_flatten(args[i], /* strict = */ needs_grad);
+      std::vector<mx::array> argsi;
+      if (needs_grad) {
+        auto [flat, structure] = TreeDef::flatten(args[i]);
+        argsi = std::move(flat);
+        gradient_structures.push_back(std::move(structure));
+      } else {
+        argsi = tree_flatten(args[i], /* strict = */ false);
+      }
       if (needs_grad) {
         auto old_size = gradient_indices.size();
         gradient_indices.resize(old_size + argsi.size());
@@ -143,7 +155,14 @@ auto py_value_and_grad(
     for (auto item : kwargs) {
       bool needs_grad =
           (argnames.find(nb::cast<std::string>(item.first)) != argnames.end());
-      auto argsk = tree_flatten(item.second, /* strict = */ needs_grad);
+      std::vector<mx::array> argsk;
+      if (needs_grad) {
+        auto [flat, structure] = TreeDef::flatten(item.second);
+        argsk = std::move(flat);
+        gradient_structures.push_back(std::move(structure));
+      } else {
+        argsk = tree_flatten(item.second, /* strict = */ false);
+      }
       if (needs_grad) {
         auto old_size = gradient_indices.size();
         gradient_indices.resize(old_size + argsk.size());
@@ -157,15 +176,16 @@ auto py_value_and_grad(
     }
     std::partial_sum(counts.cbegin(), counts.cend(), counts.begin());
 
-    // value_out will hold the output of the python function in order to be
-    // able to reconstruct the python tree of extra return values
-    nb::object py_value_out;
+    // value_structure will hold the structure of the output of the python
+    // function in order to be able to reconstruct the python tree of extra
+    // return values
+    TreeDef value_structure;
     auto value_and_grads = mx::value_and_grad(
         [&fun,
          &arrays,
          &args,
          &kwargs,
-         &py_value_out,
+         &value_structure,
          &error_msg_tag,
          scalar_func_only](const std::vector<mx::array>& a) {
           nb::list tree;
@@ -174,7 +194,7 @@ auto py_value_and_grad(
           tree_fill(tree, a);
 
           // Call the python function
-          py_value_out = fun(*tree[0], **tree[1]);
+          nb::object py_value_out = fun(*tree[0], **tree[1]);
 
           // Replace the tracers with the originals. Don't overwrite
           // locations which were written to during the call to fun
@@ -229,7 +249,9 @@ auto py_value_and_grad(
             }
           }
 
-          return tree_flatten(py_value_out, false);
+          auto [value, structure] = TreeDef::flatten(py_value_out, false);
+          value_structure = std::move(structure);
+          return value;
         },
         gradient_indices)(arrays);
 
@@ -253,11 +275,12 @@ auto py_value_and_grad(
 
     // Collect the gradients for the positional arguments
     if (argnums.size() == 1) {
-      positional_grads = tree_unflatten(args[argnums[0]], gradients, counts[0]);
+      positional_grads =
+          gradient_structures[0].unflatten(gradients, counts[0]);
     } else if (argnums.size() > 1) {
       nb::list grads_;
       for (int i = 0; i < argnums.size(); i++) {
-        grads_.append(tree_unflatten(args[argnums[i]], gradients, counts[i]));
+        grads_.append(gradient_structures[i].unflatten(gradients, counts[i]));
       }
       positional_grads = nb::tuple(grads_);
     } else {
@@ -273,8 +296,9 @@ auto py_value_and_grad(
       for (auto item : kwargs) {
         auto k = nb::cast<std::string>(item.first);
         if (argnames.find(k) != argnames.end()) {
-          grads_[k.c_str()] = tree_unflatten(
-              nb::borrow(item.second), gradients, counts[i++ + argnums.size()]);
+          int j = i++ + argnums.size();
+          grads_[k.c_str()] =
+              gradient_structures[j].unflatten(gradients, counts[j]);
         }
       }
       keyword_grads = grads_;
@@ -283,7 +307,7 @@ auto py_value_and_grad(
     }
 
     // Put the values back in the container
-    nb::object return_value = tree_unflatten(py_value_out, value);
+    nb::object return_value = value_structure.unflatten(value);
     return std::make_pair(return_value, py_grads);
   };
 }
@@ -388,9 +412,9 @@ auto py_vmap(
   };
 }
 
-std::unordered_map<std::uintptr_t, nb::object>& tree_cache() {
+std::unordered_map<std::uintptr_t, TreeDef>& tree_cache() {
   // This map is used to Cache the tree structure of the outputs
-  static std::unordered_map<std::uintptr_t, nb::object> tree_cache_;
+  static std::unordered_map<std::uintptr_t, TreeDef> tree_cache_;
   return tree_cache_;
 }
 
@@ -400,18 +424,29 @@ struct PyCompiledFun {
   nb::object captured_inputs;
   nb::object captured_outputs;
   bool shapeless;
+  bool cuda_graph;
   mutable size_t num_outputs{0};
+  TreeDef captured_inputs_structure;
+
+  using CallFun =
+      std::function<std::vector<mx::array>(const std::vector<mx::array>&)>;
+  // The CUDA graph functions by constants, they record the compiled function
+  // of the current call.
+  std::map<std::vector<uint64_t>, CallFun> graph_funs;
+  std::shared_ptr<CallFun> graph_call{std::make_shared<CallFun>()};
 
   PyCompiledFun(
       const nb::callable& fun,
       nb::object inputs,
       nb::object outputs,
-      bool shapeless)
+      bool shapeless,
+      bool cuda_graph)
       : fun(fun),
         fun_id(reinterpret_cast<std::uintptr_t>(fun.ptr())),
         captured_inputs(inputs),
         captured_outputs(outputs),
-        shapeless(shapeless) {}
+        shapeless(shapeless),
+        cuda_graph(cuda_graph) {}
 
   PyCompiledFun(const PyCompiledFun&) = delete;
   PyCompiledFun& operator=(const PyCompiledFun&) = delete;
@@ -423,7 +458,10 @@ struct PyCompiledFun {
     captured_inputs = std::move(other.captured_inputs);
     captured_outputs = std::move(other.captured_outputs);
     shapeless = other.shapeless;
+    cuda_graph = other.cuda_graph;
     num_outputs = other.num_outputs;
+    graph_funs = std::move(other.graph_funs);
+    graph_call = std::move(other.graph_call);
   };
 
   nb::object call_impl(const nb::args& args, const nb::kwargs& kwargs) {
@@ -504,7 +542,7 @@ struct PyCompiledFun {
       auto [outputs, py_outputs] =
           tree_flatten_with_structure(std::move(tree_outputs), false);
 
-      tree_cache().insert({fun_id, py_outputs});
+      tree_cache().insert({fun_id, std::move(py_outputs)});
 
       num_outputs = outputs.size();
       if (!captured_outputs.is_none()) {
@@ -523,7 +561,7 @@ struct PyCompiledFun {
     };
 
     if (!captured_inputs.is_none()) {
-      auto flat_in_captures = tree_flatten(captured_inputs, false);
+      auto flat_in_captures = flatten_captured_inputs();
       inputs.insert(
           inputs.end(),
           std::make_move_iterator(flat_in_captures.begin()),
@@ -531,8 +569,24 @@ struct PyCompiledFun {
     }
 
     // Compile and call
-    auto outputs =
-        mx::detail::compile(compile_fun, fun_id, shapeless, constants)(inputs);
+    auto compiled =
+        mx::detail::compile(compile_fun, fun_id, shapeless, constants);
+    std::vector<mx::array> outputs;
+    if (cuda_graph) {
+      auto it = graph_funs.find(constants);
+      if (it == graph_funs.end()) {
+        auto graph_fun = mx::cu::graph_function(
+            [call = graph_call](const std::vector<mx::array>& a) {
+              return (*call)(a);
+            });
+        it = graph_funs.emplace(constants, std::move(graph_fun)).first;
+      }
+      *graph_call = std::move(compiled);
+      outputs = it->second(inputs);
+      *graph_call = nullptr;
+    } else {
+      outputs = compiled(inputs);
+    }
     if (!captured_outputs.is_none()) {
       std::vector<mx::array> captures(
           std::make_move_iterator(outputs.begin() + num_outputs),
@@ -541,43 +595,81 @@ struct PyCompiledFun {
     }
 
     // Put the outputs back in the container
-    nb::object py_outputs = tree_cache().at(fun_id);
-    return tree_unflatten_from_structure(py_outputs, outputs);
+    return tree_unflatten_from_structure(tree_cache().at(fun_id), outputs);
   }
 
   nb::object operator()(const nb::args& args, const nb::kwargs& kwargs) const {
     return const_cast<PyCompiledFun*>(this)->call_impl(args, kwargs);
   };
 
+  // Flatten the captured inputs, such as the state of a model, with their
+  // structure of the previous call unless it changed.
+  std::vector<mx::array> flatten_captured_inputs() {
+    try {
+      return captured_inputs_structure.flatten_up_to(captured_inputs);
+    } catch (const std::invalid_argument&) {
+      auto [flat, structure] = TreeDef::flatten(captured_inputs, false);
+      captured_inputs_structure = std::move(structure);
+      return flat;
+    }
+  }
+
   ~PyCompiledFun() {
     nb::gil_scoped_acquire gil;
 
     tree_cache().erase(fun_id);
     mx::detail::compile_erase(fun_id);
+    graph_funs.clear();
     fun.reset();
     captured_inputs.reset();
     captured_outputs.reset();
+    captured_inputs_structure.reset();
   }
 };
 
 class PyCheckpointedFun {
  public:
-  PyCheckpointedFun(nb::callable fun) : fun_(std::move(fun)) {}
+  PyCheckpointedFun(nb::callable fun, nb::object policy)
+      : fun_(std::move(fun)) {
+    if (nb::isinstance<nb::str>(policy)) {
+      if (nb::cast<std::string>(policy) != "matmuls") {
+        throw std::invalid_argument(
+            "[checkpoint] The policy must be None, \"matmuls\" or a callable.");
+      }
+      save_ = &mx::save_matmuls;
+    } else if (nb::isinstance<nb::callable>(policy)) {
+      // The primitives may outlive the function so the policy is released
+      // with the GIL held.
+      std::shared_ptr<nb::object> holder(
+          new nb::object(std::move(policy)), [](nb::object* obj) {
+            nb::gil_scoped_acquire gil;
+            delete obj;
+          });
+      save_ = [holder = std::move(holder)](const mx::Primitive& p) {
+        nb::gil_scoped_acquire gil;
+        return nb::cast<bool>((*holder)(p.name()));
+      };
+    } else if (!policy.is_none()) {
+      throw std::invalid_argument(
+          "[checkpoint] The policy must be None, \"matmuls\" or a callable.");
+    }
+  }
   ~PyCheckpointedFun() {
     nb::gil_scoped_acquire gil;
 
     fun_.reset();
+    save_ = nullptr;
   }
 
   struct InnerFunction {
     nb::object fun_;
-    nb::object args_structure_;
-    std::weak_ptr<nb::object> output_structure_;
+    TreeDef args_structure_;
+    std::weak_ptr<TreeDef> output_structure_;
 
     InnerFunction(
         nb::object fun,
-        nb::object args_structure,
-        std::weak_ptr<nb::object> output_structure)
+        TreeDef args_structure,
+        std::weak_ptr<TreeDef> output_structure)
         : fun_(std::move(fun)),
           args_structure_(std::move(args_structure)),
           output_structure_(output_structure) {}
@@ -594,20 +686,21 @@ class PyCheckpointedFun {
       auto [outputs, output_structure] =
           tree_flatten_with_structure(fun_(*args[0], **args[1]), false);
       if (auto s = output_structure_.lock()) {
-        *s = output_structure;
+        *s = std::move(output_structure);
       }
       return outputs;
     }
   };
 
   nb::object call_impl(const nb::args& args, const nb::kwargs& kwargs) {
-    auto output_structure = std::make_shared<nb::object>();
+    auto output_structure = std::make_shared<TreeDef>();
     auto full_args = nb::make_tuple(args, kwargs);
     auto [inputs, args_structure] =
         tree_flatten_with_structure(full_args, false);
 
-    auto outputs = mx::checkpoint(
-        InnerFunction(fun_, args_structure, output_structure))(inputs);
+    auto inner = InnerFunction(fun_, args_structure, output_structure);
+    auto outputs = save_ ? mx::checkpoint(std::move(inner), save_)(inputs)
+                         : mx::checkpoint(std::move(inner))(inputs);
 
     return tree_unflatten_from_structure(*output_structure, outputs);
   }
@@ -618,6 +711,7 @@ class PyCheckpointedFun {
 
  private:
   nb::callable fun_;
+  std::function<bool(const mx::Primitive&)> save_;
 };
 
 int py_custom_function_tp_traverse(PyObject* self, visitproc visit, void* arg);
@@ -641,10 +735,10 @@ int py_custom_function_tp_clear(PyObject* self);
  * needed).
  *
  *    - An nb::callable which holds the passed function or transform
- *    - An nb::object holding input structure, namely the `(args, kwargs)`
+ *    - A TreeDef holding the input structure, namely the `(args, kwargs)`
  *      passed to the function in order to be able to recreate the arguments
  *      from the input arrays.
- *    - A std::shared_ptr<nb::object> holding the output structure name the
+ *    - A std::shared_ptr<TreeDef> holding the output structure name the
  *      structure of the return value of `fun`. It is a shared_ptr so that it
  *      can be set when the function is called and then used in the `vjp`
  *      transform. We delete the object only when the shared_ptr is about to be
@@ -661,13 +755,13 @@ class PyCustomFunction {
 
   struct InnerFunction {
     nb::callable fun_;
-    nb::object input_structure_;
-    std::shared_ptr<nb::object> output_structure_;
+    TreeDef input_structure_;
+    std::shared_ptr<TreeDef> output_structure_;
 
     InnerFunction(
         nb::callable fun,
-        nb::object input_structure,
-        std::shared_ptr<nb::object> output_structure)
+        TreeDef input_structure,
+        std::shared_ptr<TreeDef> output_structure)
         : fun_(std::move(fun)),
           input_structure_(std::move(input_structure)),
           output_structure_(std::move(output_structure)) {}
@@ -695,13 +789,13 @@ class PyCustomFunction {
 
   struct InnerVJPFunction {
     nb::callable vjp_fun_;
-    nb::object input_structure_;
-    std::shared_ptr<nb::object> output_structure_;
+    TreeDef input_structure_;
+    std::shared_ptr<TreeDef> output_structure_;
 
     InnerVJPFunction(
         nb::callable vjp_fun,
-        nb::object input_structure,
-        std::shared_ptr<nb::object> output_structure)
+        TreeDef input_structure,
+        std::shared_ptr<TreeDef> output_structure)
         : vjp_fun_(std::move(vjp_fun)),
           input_structure_(std::move(input_structure)),
           output_structure_(std::move(output_structure)) {}
@@ -743,9 +837,9 @@ class PyCustomFunction {
 
   struct InnerJVPFunction {
     nb::callable jvp_fun_;
-    nb::object input_structure_;
+    TreeDef input_structure_;
 
-    InnerJVPFunction(nb::callable jvp_fun, nb::object input_structure)
+    InnerJVPFunction(nb::callable jvp_fun, TreeDef input_structure)
         : jvp_fun_(std::move(jvp_fun)),
           input_structure_(std::move(input_structure)) {}
     ~InnerJVPFunction() {
@@ -798,9 +892,9 @@ class PyCustomFunction {
 
   struct InnerVmapFunction {
     nb::callable vmap_fun_;
-    nb::object input_structure_;
+    TreeDef input_structure_;
 
-    InnerVmapFunction(nb::callable vmap_fun, nb::object input_structure)
+    InnerVmapFunction(nb::callable vmap_fun, TreeDef input_structure)
         : vmap_fun_(std::move(vmap_fun)),
           input_structure_(std::move(input_structure)) {}
     ~InnerVmapFunction() {
@@ -874,14 +968,14 @@ class PyCustomFunction {
 
     // Extract the inputs and their structure in capturable vars
     std::vector<mx::array> input_arrays;
-    nb::object input_structure;
+    TreeDef input_structure;
     auto full_args = nb::make_tuple(args, kwargs);
     std::tie(input_arrays, input_structure) =
         tree_flatten_with_structure(full_args, false);
 
     // The output structure will be stored here to be used in the custom vjp
     // function
-    auto output_structure = std::make_shared<nb::object>();
+    auto output_structure = std::make_shared<TreeDef>();
 
     // Make a function that calls fun_ in the forward pass and vjp_ in the
     // backward pass. Then call it immediately and return the results.
@@ -926,8 +1020,8 @@ class PyCustomFunction {
 
  private:
   std::optional<InnerVJPFunction> make_vjp_function(
-      nb::object input_structure,
-      std::shared_ptr<nb::object> output_structure) {
+      TreeDef input_structure,
+      std::shared_ptr<TreeDef> output_structure) {
     if (!vjp_fun_.has_value()) {
       return std::nullopt;
     }
@@ -936,7 +1030,7 @@ class PyCustomFunction {
   }
 
   std::optional<InnerJVPFunction> make_jvp_function(
-      nb::object input_structure) {
+      TreeDef input_structure) {
     if (!jvp_fun_.has_value()) {
       return std::nullopt;
     }
@@ -945,7 +1039,7 @@ class PyCustomFunction {
   }
 
   std::optional<InnerVmapFunction> make_vmap_function(
-      nb::object input_structure) {
+      TreeDef input_structure) {
     if (!vmap_fun_.has_value()) {
       return std::nullopt;
     }
@@ -992,6 +1086,25 @@ PyType_Slot py_custom_function_slots[] = {
     {Py_tp_clear, (void*)py_custom_function_tp_clear},
     {0, 0}};
 
+// Wrap the Python callable |fn| to be called, and dropped, by the threads
+// which complete the evaluations and do not hold the GIL. The exceptions it
+// raises are reported as unraisable.
+std::function<void()> python_callback(nb::object fn) {
+  std::shared_ptr<nb::object> holder(
+      new nb::object(std::move(fn)), [](nb::object* obj) {
+        nb::gil_scoped_acquire gil;
+        delete obj;
+      });
+  return [holder = std::move(holder)]() {
+    nb::gil_scoped_acquire gil;
+    try {
+      (*holder)();
+    } catch (nb::python_error& e) {
+      e.discard_as_unraisable("mlx.core.EvalFuture callback");
+    }
+  };
+}
+
 void init_transforms(nb::module_& m) {
   nb::class_<PyCustomFunction>(
       m,
@@ -1156,17 +1269,90 @@ void init_transforms(nb::module_& m) {
               :class:`list`, :class:`tuple` or :class:`dict`. Leaves which are not
               arrays are ignored.
       )pbdoc");
+  m.def(
+      "projected_peak_memory",
+      [](const nb::args& args) {
+        std::vector<mx::array> arrays = tree_flatten(args, false);
+        return mx::projected_peak_memory(arrays);
+      },
+      nb::arg(),
+      nb::sig("def projected_peak_memory(*args) -> int"),
+      R"pbdoc(
+        The peak memory projected for evaluating arrays, without evaluating
+        them.
+
+        It is the projection for the order in which the arrays are
+        evaluated with ``MLX_EVAL_MEMORY_SCHEDULE=1``. The arrays are then
+        evaluated depth first, freeing the intermediate arrays as early as
+        possible, which lowers the peak memory of the gradients of deep
+        models. The projection is the active memory and the most memory held
+        at once by the arrays made by the evaluation. The arrays which share
+        memory, e.g. views, are counted more than once.
+
+        Args:
+            *args (arrays or trees of arrays): Each argument can be a single array
+              or a tree of arrays. If a tree is given the nodes can be a Python
+              :class:`list`, :class:`tuple` or :class:`dict`. Leaves which are not
+              arrays are ignored.
+
+        Returns:
+            int: The projected peak memory in bytes.
+      )pbdoc");
+  nb::class_<mx::EvalFuture>(
+      m,
+      "EvalFuture",
+      R"pbdoc(
+        The completion of an evaluation started with :func:`async_eval`.
+
+        It can be awaited in a coroutine of :mod:`asyncio`, which needs no
+        thread waiting for the evaluation.
+      )pbdoc")
+      .def("done", &mx::EvalFuture::done, "Whether the evaluation is done.")
+      .def(
+          "wait",
+          &mx::EvalFuture::wait,
+          nb::call_guard<nb::gil_scoped_release>(),
+          "Block until the evaluation is done.")
+      .def(
+          "then",
+          [](const mx::EvalFuture& f, nb::callable callback) {
+            f.then(python_callback(std::move(callback)));
+          },
+          "callback"_a,
+          R"pbdoc(
+            Call ``callback`` without arguments once the evaluation is done.
+
+            The callback runs on the thread which completes the evaluation,
+            or right away if the evaluation is done already. It should be
+            quick and it must not evaluate arrays, e.g. hand the result to
+            another thread or to an event loop with
+            :meth:`asyncio.loop.call_soon_threadsafe`.
+          )pbdoc")
+      .def("__await__", [](const mx::EvalFuture& f) {
+        auto asyncio = nb::module_::import_("asyncio");
+        auto functools = nb::module_::import_("functools");
+        auto loop = asyncio.attr("get_running_loop")();
+        auto fut = loop.attr("create_future")();
+        // The result is set from the thread of the loop, unless the await
+        // was cancelled.
+        auto set_done = nb::cpp_function([](nb::object fut) {
+          if (!nb::cast<bool>(fut.attr("done")())) {
+            fut.attr("set_result")(nb::none());
+          }
+        });
+        f.then(python_callback(functools.attr("partial")(
+            loop.attr("call_soon_threadsafe"), set_done, fut)));
+        return fut.attr("__await__")();
+      });
   m.def(
       "async_eval",
       [](const nb::args& args) {
         std::vector<mx::array> arrays = tree_flatten(args, false);
-        {
-          nb::gil_scoped_release nogil;
-          async_eval(arrays);
-        }
+        nb::gil_scoped_release nogil;
+        return async_eval(arrays);
       },
       nb::arg(),
-      nb::sig("def async_eval(*args)"),
+      nb::sig("def async_eval(*args) -> EvalFuture"),
       R"pbdoc(
         Asynchronously evaluate an :class:`array` or tree of :class:`array`.
 
@@ -1180,6 +1366,10 @@ void init_transforms(nb::module_& m) {
               :class:`list`, :class:`tuple` or :class:`dict`. Leaves which are not
               arrays are ignored.
 
+        Returns:
+            EvalFuture: The completion of the evaluation, which can be waited
+            for, awaited or given callbacks with :meth:`EvalFuture.then`.
+
         Example:
             >>> x = mx.array(1.0)
             >>> y = mx.exp(x)
@@ -1192,6 +1382,52 @@ void init_transforms(nb::module_& m) {
             >>> mx.async_eval(z)
             >>> print(z)
       )pbdoc");
+  m.def(
+      "prefetch",
+      [](const nb::object& arrays,
+         std::optional<size_t> max_bytes,
+         mx::StreamOrDevice s) {
+        std::vector<mx::array> flat = tree_flatten(arrays, false);
+        nb::gil_scoped_release nogil;
+        return mx::prefetch(flat, s, max_bytes);
+      },
+      nb::arg(),
+      "max_bytes"_a = nb::none(),
+      nb::kw_only(),
+      "stream"_a = nb::none(),
+      nb::sig(
+          "def prefetch(arrays: Any, /, max_bytes: Optional[int] = None, *, stream: Union[None, Stream, Device] = None) -> EvalFuture"),
+      R"pbdoc(
+        Start reading the arrays loaded from files ahead of their first use.
+
+        The lazy loads in the graphs of ``arrays``, such as the weights of a
+        model built from :func:`load`, are moved to a background I/O stream
+        of the device of ``stream``, or to ``stream`` itself when it is a
+        stream, so the computations using them wait only for the arrays they
+        read. The loads are scheduled in the order of ``arrays``, for
+        instance layer by layer, as long as they add up to at most
+        ``max_bytes`` bytes, and the next ones are read on the I/O stream
+        when first evaluated. The first layers of a model can then compute
+        while the next ones are read.
+
+        The device defaults to the GPU with the CUDA backend, which reads the
+        arrays to the GPU through pinned buffers, and to the CPU otherwise.
+
+        Args:
+            arrays (array or tree of arrays): The arrays whose loads to read.
+              Leaves which are not arrays are ignored.
+            max_bytes (int, optional): The most bytes of loads scheduled
+              right away. Default: ``None``, all of them.
+
+        Returns:
+            EvalFuture: The completion of the scheduled loads.
+
+        Example:
+            >>> weights = mx.load("model.safetensors")
+            >>> model.load_weights(list(weights.items()))
+            >>> mx.prefetch(model.parameters())
+            >>> y = model(x)
+      )pbdoc");
   m.def(
       "jvp",
       [](const nb::callable& fun,
@@ -1413,7 +1649,8 @@ void init_transforms(nb::module_& m) {
       [](const nb::callable& fun,
          const nb::object& inputs,
          const nb::object& outputs,
-         bool shapeless) {
+         bool shapeless,
+         bool cuda_graph) {
         //  Try to get the name
         auto n =
             nb::hasattr(fun, "__name__") ? fun.attr("__name__") : nb::none();
@@ -1439,7 +1676,7 @@ void init_transforms(nb::module_& m) {
         auto sig_str = sig.str();
         return mlx_func(
             nb::cpp_function(
-                PyCompiledFun{fun, inputs, outputs, shapeless},
+                PyCompiledFun{fun, inputs, outputs, shapeless, cuda_graph},
                 nb::name(name.c_str()),
                 nb::sig(sig_str.c_str()),
                 doc.c_str()),
@@ -1451,8 +1688,9 @@ void init_transforms(nb::module_& m) {
       "inputs"_a = nb::none(),
       "outputs"_a = nb::none(),
       "shapeless"_a = false,
+      "cuda_graph"_a = false,
       nb::sig(
-          "def compile(fun: Callable, inputs: Optional[object] = None, outputs: Optional[object] = None, shapeless: bool = False) -> Callable"),
+          "def compile(fun: Callable, inputs: Optional[object] = None, outputs: Optional[object] = None, shapeless: bool = False, cuda_graph: bool = False) -> Callable"),
       R"pbdoc(
         Returns a compiled function which produces the same output as ``fun``.
 
@@ -1476,6 +1714,14 @@ void init_transforms(nb::module_& m) {
               such functions with shapeless enabled will throw. Note, changing the number
               of dimensions or type of any input will result in a recompilation even with
               ``shapeless`` set to ``True``. Default: ``False``
+            cuda_graph (bool, optional): Record the kernels of the compiled
+              function in a single CUDA graph at the first call with given input
+              shapes, and only launch the graph at the next calls instead of
+              evaluating the operations again. The inputs that change between
+              calls are copied to the buffers of the graph and its outputs are
+              copied out. The function must run on the default GPU stream and
+              not depend on values read on the host. Ignored without CUDA.
+              Default: ``False``
 
         Returns:
             Callable: A compiled function which has the same input arguments
@@ -1495,10 +1741,108 @@ void init_transforms(nb::module_& m) {
         Globally enable compilation. This will override the environment
         variable ``MLX_DISABLE_COMPILE`` if set.
       )pbdoc");
+  m.def(
+      "compile_cache_info",
+      &mx::compile_cache_info,
+      R"pbdoc(
+        Get the counters of the cache of compiled functions.
+
+        The cache has an entry for each compiled function and signature of
+        its inputs, with at most ``MLX_COMPILE_CACHE_SIZE`` entries, and the
+        least recently used one is evicted when it is full:
+
+        * ``"entries"``: the entries in the cache.
+        * ``"hits"``: the calls which found their entry.
+        * ``"misses"``: the calls which traced the function for a new entry.
+        * ``"evictions"``: the entries evicted from a full cache.
+        * ``"capacity"``: the maximum number of entries, ``0`` when not
+          bounded.
+
+        Returns:
+            dict[str, int]: The counters of the cache.
+      )pbdoc");
+  m.def(
+      "reset_compile_cache_info",
+      &mx::reset_compile_cache_info,
+      R"pbdoc(
+        Reset the counters of :func:`compile_cache_info` to zero.
+      )pbdoc");
+  m.def(
+      "gpu_fallback_info",
+      []() {
+        nb::dict out;
+        for (auto& [name, info] : mx::gpu_fallback_info()) {
+          nb::dict d;
+          d["count"] = info.count;
+          d["transfer_bytes"] = info.transfer_bytes;
+          d["cpu_time"] = info.cpu_time;
+          out[name.c_str()] = d;
+        }
+        return out;
+      },
+      nb::sig("def gpu_fallback_info() -> dict[str, dict]"),
+      R"pbdoc(
+        Get the cost of the operations run on the CPU because the GPU
+        backend does not implement them.
+
+        With ``MLX_GPU_CPU_FALLBACK=1`` such operations are moved to the CPU
+        stream when they are evaluated instead of failing, and with ``2``
+        a warning is also printed the first time. The operations stay on the
+        CPU stream, including when a graph which holds them is evaluated
+        again. The primitives named in ``MLX_GPU_CPU_FALLBACK_PRIMITIVES``,
+        separated by commas, fall back as well. The inputs computed on the
+        GPU are moved to the host for them. For each operation by name of
+        its primitive:
+
+        * ``"count"``: the times it ran on the CPU.
+        * ``"transfer_bytes"``: the bytes of its inputs computed on the GPU.
+        * ``"cpu_time"``: the time it took on the CPU in seconds.
+
+        Returns:
+            dict[str, dict]: The cost of the fallbacks.
+      )pbdoc");
+  m.def(
+      "reset_gpu_fallback_info",
+      &mx::reset_gpu_fallback_info,
+      R"pbdoc(
+        Reset the counters of :func:`gpu_fallback_info`.
+      )pbdoc");
   m.def(
       "checkpoint",
-      [](nb::callable fun) { return mlx_func(PyCheckpointedFun{fun}, fun); },
-      "fun"_a);
+      [](nb::callable fun, nb::object policy) {
+        return mlx_func(PyCheckpointedFun{fun, policy}, fun);
+      },
+      "fun"_a,
+      nb::kw_only(),
+      "policy"_a = nb::none(),
+      nb::sig(
+          "def checkpoint(fun: Callable, *, policy: Union[None, str, Callable[[str], bool]] = None) -> Callable"),
+      R"pbdoc(
+        Returns a function which recomputes the intermediate state of ``fun``
+        when its gradient is computed instead of keeping it in memory.
+
+        The ``policy`` selects the intermediate arrays which are kept. With
+        ``None`` only the inputs and the outputs are kept and everything else
+        is recomputed. With ``"matmuls"`` the outputs of the matrix
+        multiplications, the convolutions and the attention are kept and only
+        the cheap operations, such as the elementwise operations and the
+        normalizations, are recomputed from them. A callable is called with
+        the name of each primitive of ``fun``, e.g. ``"Matmul"``, and keeps
+        its outputs when it returns ``True``.
+
+        Under :func:`compile` the recomputed operations are fused like the rest
+        of the backward pass.
+
+        Args:
+            fun (Callable): A function which takes a variable number of
+              :class:`array` or trees of :class:`array` and returns
+              a variable number of :class:`array` or trees of :class:`array`.
+            policy (str or Callable, optional): Which intermediate arrays to
+              keep. Default: ``None``.
+
+        Returns:
+            Callable: The checkpointed function.
+      )pbdoc");
 
   // Register static Python object cleanup before the interpreter exits
   auto atexit = nb::module_::import_("atexit");
@@ -253,51 +253,193 @@ nb::object tree_unflatten(
   });
 }
 
-nb::object structure_sentinel() {
-  static nb::object sentinel;
+std::pair<std::vector<mx::array>, TreeDef> TreeDef::flatten(
+    nb::handle tree,
+    bool strict /* = true */) {
+  std::pair<std::vector<mx::array>, TreeDef> result;
+  result.second.record(tree, result.first, strict);
+  return result;
+}
 
-  if (sentinel.ptr() == nullptr) {
-    sentinel = nb::capsule(&sentinel);
-    // probably not needed but this should make certain that we won't ever
-    // delete the sentinel
-    sentinel.inc_ref();
+void TreeDef::record(
+    nb::handle tree,
+    std::vector<mx::array>& leaves,
+    bool strict) {
+  if (PyList_Check(tree.ptr())) {
+    Py_ssize_t size = PyList_GET_SIZE(tree.ptr());
+    nodes_.push_back({Kind::list, static_cast<int>(size)});
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      record(PyList_GET_ITEM(tree.ptr(), i), leaves, strict);
+    }
+  } else if (PyTuple_Check(tree.ptr())) {
+    Py_ssize_t size = PyTuple_GET_SIZE(tree.ptr());
+    nodes_.push_back({Kind::tuple, static_cast<int>(size)});
+    for (Py_ssize_t i = 0; i < size; ++i) {
+      record(PyTuple_GET_ITEM(tree.ptr(), i), leaves, strict);
+    }
+  } else if (PyDict_Check(tree.ptr())) {
+    nodes_.push_back(
+        {Kind::dict, static_cast<int>(PyDict_Size(tree.ptr()))});
+    PyObject* key;
+    PyObject* value;
+    Py_ssize_t pos = 0;
+    while (PyDict_Next(tree.ptr(), &pos, &key, &value)) {
+      keys_.push_back(nb::borrow(key));
+      record(value, leaves, strict);
+    }
+  } else if (nb::isinstance<mx::array>(tree)) {
+    nodes_.push_back({Kind::array, 0});
+    leaves.push_back(nb::cast<mx::array>(tree));
+    num_leaves_++;
+  } else if (!strict) {
+    nodes_.push_back({Kind::constant, 0});
+    constants_.push_back(nb::borrow(tree));
+  } else {
+    throw std::invalid_argument(
+        "[tree_flatten] The argument should contain only arrays");
   }
+}
 
-  return sentinel;
+std::vector<mx::array> TreeDef::flatten_up_to(nb::handle tree) const {
+  if (nodes_.empty()) {
+    throw std::invalid_argument("[tree_flatten] The structure is empty.");
+  }
+  std::vector<mx::array> leaves;
+  leaves.reserve(num_leaves_);
+  size_t node = 0;
+  size_t key = 0;
+  flatten_node(tree, node, key, leaves);
+  return leaves;
 }
 
-std::pair<std::vector<mx::array>, nb::object> tree_flatten_with_structure(
-    nb::object tree,
-    bool strict /* = true */) {
-  auto sentinel = structure_sentinel();
-  std::vector<mx::array> flat_tree;
-  auto structure = tree_map(
-      tree,
-      [&flat_tree, sentinel = std::move(sentinel), strict](nb::handle obj) {
-        if (nb::isinstance<mx::array>(obj)) {
-          flat_tree.push_back(nb::cast<mx::array>(obj));
-          return sentinel;
-        } else if (!strict) {
-          return nb::cast<nb::object>(obj);
-        } else {
-          throw std::invalid_argument(
-              "[tree_flatten] The argument should contain only arrays");
+void TreeDef::flatten_node(
+    nb::handle tree,
+    size_t& node,
+    size_t& key,
+    std::vector<mx::array>& leaves) const {
+  auto mismatch = []() {
+    throw std::invalid_argument(
+        "[tree_flatten] The tree does not have the recorded structure.");
+  };
+  auto& n = nodes_[node++];
+  switch (n.kind) {
+    case Kind::list:
+      if (!PyList_Check(tree.ptr()) || PyList_GET_SIZE(tree.ptr()) != n.size) {
+        mismatch();
+      }
+      for (int i = 0; i < n.size; ++i) {
+        flatten_node(PyList_GET_ITEM(tree.ptr(), i), node, key, leaves);
+      }
+      break;
+    case Kind::tuple:
+      if (!PyTuple_Check(tree.ptr()) ||
+          PyTuple_GET_SIZE(tree.ptr()) != n.size) {
+        mismatch();
+      }
+      for (int i = 0; i < n.size; ++i) {
+        flatten_node(PyTuple_GET_ITEM(tree.ptr(), i), node, key, leaves);
+      }
+      break;
+    case Kind::dict: {
+      if (!PyDict_Check(tree.ptr()) || PyDict_Size(tree.ptr()) != n.size) {
+        mismatch();
+      }
+      PyObject* k;
+      PyObject* value;
+      Py_ssize_t pos = 0;
+      while (PyDict_Next(tree.ptr(), &pos, &k, &value)) {
+        auto& expected = keys_[key++];
+        if (k != expected.ptr() &&
+            PyObject_RichCompareBool(k, expected.ptr(), Py_EQ) != 1) {
+          mismatch();
         }
-      });
+        flatten_node(value, node, key, leaves);
+      }
+      break;
+    }
+    case Kind::array:
+      if (!nb::isinstance<mx::array>(tree)) {
+        mismatch();
+      }
+      leaves.push_back(nb::cast<mx::array>(tree));
+      break;
+    case Kind::constant:
+      // An array in place of a constant would otherwise be dropped.
+      if (nb::isinstance<mx::array>(tree)) {
+        mismatch();
+      }
+      break;
+  }
+}
+
+nb::object TreeDef::unflatten(
+    const std::vector<mx::array>& values,
+    int index /* = 0 */) const {
+  if (nodes_.empty()) {
+    throw std::invalid_argument("[tree_unflatten] The structure is empty.");
+  }
+  size_t node = 0;
+  size_t key = 0;
+  size_t constant = 0;
+  return unflatten_node(node, key, constant, values, index);
+}
 
-  return {flat_tree, structure};
+nb::object TreeDef::unflatten_node(
+    size_t& node,
+    size_t& key,
+    size_t& constant,
+    const std::vector<mx::array>& values,
+    int& index) const {
+  auto& n = nodes_[node++];
+  switch (n.kind) {
+    case Kind::list: {
+      auto list = nb::steal(PyList_New(n.size));
+      for (int i = 0; i < n.size; ++i) {
+        auto child = unflatten_node(node, key, constant, values, index);
+        PyList_SET_ITEM(list.ptr(), i, child.release().ptr());
+      }
+      return list;
+    }
+    case Kind::tuple: {
+      auto tuple = nb::steal(PyTuple_New(n.size));
+      for (int i = 0; i < n.size; ++i) {
+        auto child = unflatten_node(node, key, constant, values, index);
+        PyTuple_SET_ITEM(tuple.ptr(), i, child.release().ptr());
+      }
+      return tuple;
+    }
+    case Kind::dict: {
+      nb::dict dict;
+      for (int i = 0; i < n.size; ++i) {
+        auto& k = keys_[key++];
+        dict[k] = unflatten_node(node, key, constant, values, index);
+      }
+      return dict;
+    }
+    case Kind::array:
+      return nb::cast(values[index++]);
+    case Kind::constant:
+    default:
+      return constants_[constant++];
+  }
+}
+
+void TreeDef::reset() {
+  nodes_.clear();
+  keys_.clear();
+  constants_.clear();
+  num_leaves_ = 0;
+}
+
+std::pair<std::vector<mx::array>, TreeDef> tree_flatten_with_structure(
+    nb::object tree,
+    bool strict /* = true */) {
+  return TreeDef::flatten(tree, strict);
 }
 
 nb::object tree_unflatten_from_structure(
-    nb::object structure,
+    const TreeDef& structure,
     const std::vector<mx::array>& values,
     int index /* = 0 */) {
-  auto sentinel = structure_sentinel();
-  return tree_map(structure, [&](nb::handle obj) {
-    if (obj.is(sentinel)) {
-      return nb::cast(values[index++]);
-    } else {
-      return nb::cast<nb::object>(obj);
-    }
-  });
+  return structure.unflatten(values, index);
 }
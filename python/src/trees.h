@@ -52,11 +52,82 @@ nb::object tree_unflatten(
     const std::vector<mx::array>& values,
     int index = 0);
 
-std::pair<std::vector<mx::array>, nb::object> tree_flatten_with_structure(
+/**
+ * The structure of a tree of lists, tuples and dicts, recorded once by
+ * flattening a tree. It flattens and unflattens the trees with the same
+ * structure in a loop over its nodes, without visiting the Python objects
+ * through the generic tree functions.
+ *
+ * The leaves which are not arrays are kept in the structure as constants.
+ * It holds Python objects so it must be destroyed, or reset, with the GIL.
+ */
+class TreeDef {
+ public:
+  TreeDef() = default;
+
+  /**
+   * Flatten |tree| into its arrays and record its structure. If strict is
+   * true, then the function will throw if the tree contains a leaf which is
+   * not an array.
+   */
+  static std::pair<std::vector<mx::array>, TreeDef> flatten(
+      nb::handle tree,
+      bool strict = true);
+
+  /**
+   * Flatten |tree|, which must have the recorded structure, without
+   * recording it again. It throws if the structures differ.
+   */
+  std::vector<mx::array> flatten_up_to(nb::handle tree) const;
+
+  /**
+   * Build a tree of the recorded structure with the arrays of |values|
+   * starting at |index|.
+   */
+  nb::object unflatten(const std::vector<mx::array>& values, int index = 0)
+      const;
+
+  int num_leaves() const {
+    return num_leaves_;
+  }
+
+  void reset();
+
+ private:
+  enum class Kind : uint8_t { array, constant, list, tuple, dict };
+
+  // The nodes in depth first order with the number of children of the
+  // containers.
+  struct Node {
+    Kind kind;
+    int size;
+  };
+
+  void record(nb::handle tree, std::vector<mx::array>& leaves, bool strict);
+  void flatten_node(
+      nb::handle tree,
+      size_t& node,
+      size_t& key,
+      std::vector<mx::array>& leaves) const;
+  nb::object unflatten_node(
+      size_t& node,
+      size_t& key,
+      size_t& constant,
+      const std::vector<mx::array>& values,
+      int& index) const;
+
+  std::vector<Node> nodes_;
+  // The keys of the dicts and the constant leaves in the order of the nodes.
+  std::vector<nb::object> keys_;
+  std::vector<nb::object> constants_;
+  int num_leaves_{0};
+};
+
+std::pair<std::vector<mx::array>, TreeDef> tree_flatten_with_structure(
     nb::object tree,
     bool strict = true);
 
 nb::object tree_unflatten_from_structure(
-    nb::object structure,
+    const TreeDef& structure,
     const std::vector<mx::array>& values,
     int index = 0);
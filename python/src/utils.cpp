@@ -5,9 +5,34 @@
 #include "mlx/utils.h"
 #include "python/src/convert.h"
 
-mx::array to_array(
+namespace {
+
+// The Python scalars which are small whole numbers, such as the 1 of x + 1,
+// are made once per thread and dtype rather than for every operation.
+template <typename T>
+mx::array shared_scalar(T val, mx::Dtype dtype) {
+  constexpr int lo = -1;
+  constexpr int hi = 8;
+  if (!(val >= lo && val <= hi) || val != static_cast<int>(val) ||
+      (val == 0 && std::signbit(val))) {
+    return mx::array(val, dtype);
+  }
+  thread_local std::vector<std::optional<mx::array>> scalars;
+  size_t i = static_cast<size_t>(dtype.val()) * (hi - lo + 1) +
+      static_cast<int>(val) - lo;
+  if (i >= scalars.size()) {
+    scalars.resize(i + 1);
+  }
+  if (!scalars[i]) {
+    scalars[i] = mx::array(val, dtype);
+  }
+  return *scalars[i];
+}
+
+mx::array to_array_impl(
     const ScalarOrArray& v,
-    std::optional<mx::Dtype> dtype /* = std::nullopt */) {
+    std::optional<mx::Dtype> dtype,
+    bool shared) {
   if (auto pv = std::get_if<nb::bool_>(&v); pv) {
     return mx::array(nb::cast<bool>(*pv), dtype.value_or(mx::bool_));
   } else if (auto pv = std::get_if<nb::int_>(&v); pv) {
@@ -28,12 +53,13 @@ mx::array to_array(
     }
 
     // bool_ is an exception and is always promoted
-    return mx::array(val, (out_t == mx::bool_) ? mx::int32 : out_t);
+    out_t = (out_t == mx::bool_) ? mx::int32 : out_t;
+    return shared ? shared_scalar(val, out_t) : mx::array(val, out_t);
   } else if (auto pv = std::get_if<nb::float_>(&v); pv) {
+    auto val = nb::cast<float>(*pv);
     auto out_t = dtype.value_or(mx::float32);
-    return mx::array(
-        nb::cast<float>(*pv),
-        mx::issubdtype(out_t, mx::floating) ? out_t : mx::float32);
+    out_t = mx::issubdtype(out_t, mx::floating) ? out_t : mx::float32;
+    return shared ? shared_scalar(val, out_t) : mx::array(val, out_t);
   } else if (auto pv = std::get_if<std::complex<float>>(&v); pv) {
     return mx::array(static_cast<mx::complex64_t>(*pv), mx::complex64);
   } else if (auto pv = std::get_if<mx::array>(&v); pv) {
@@ -47,6 +73,18 @@ mx::array to_array(
   }
 }
 
+} // namespace
+
+mx::array to_array(
+    const ScalarOrArray& v,
+    std::optional<mx::Dtype> dtype /* = std::nullopt */) {
+  return to_array_impl(v, dtype, false);
+}
+
+mx::array to_operand(const ScalarOrArray& v, mx::Dtype dtype) {
+  return to_array_impl(v, dtype, true);
+}
+
 std::pair<mx::array, mx::array> to_arrays(
     const ScalarOrArray& a,
     const ScalarOrArray& b) {
@@ -75,10 +113,10 @@ std::pair<mx::array, mx::array> to_arrays(
       auto arr_b = get_mlx_array(b);
       return {arr_a, arr_b};
     }
-    return {arr_a, to_array(b, arr_a.dtype())};
+    return {arr_a, to_operand(b, arr_a.dtype())};
   } else if (is_mlx_array(b)) {
     auto arr_b = get_mlx_array(b);
-    return {to_array(a, arr_b.dtype()), arr_b};
+    return {to_operand(a, arr_b.dtype()), arr_b};
   } else {
     return {to_array(a), to_array(b)};
   }
@@ -71,6 +71,11 @@ mx::array to_array(
     const ScalarOrArray& v,
     std::optional<mx::Dtype> dtype = std::nullopt);
 
+// Convert the operand of an operation with an array of the given dtype. The
+// small Python scalars are shared arrays, so the result must only be used as
+// an input of the operation.
+mx::array to_operand(const ScalarOrArray& v, mx::Dtype dtype);
+
 std::pair<mx::array, mx::array> to_arrays(
     const ScalarOrArray& a,
     const ScalarOrArray& b);
@@ -6,7 +6,11 @@ import mlx.core as mx
 import mlx.nn as nn
 import mlx_tests
 from mlx.nn.layers.distributed import shard_inplace, shard_linear
-from mlx.nn.utils import average_gradients
+from mlx.nn.utils import (
+    GradientReducer,
+    average_gradients,
+    pipeline_value_and_grad,
+)
 
 
 class MLXDistributedCommonTestCase(mlx_tests.MLXTestCase):
@@ -63,6 +67,68 @@ class MLXDistributedCommonTestCase(mlx_tests.MLXTestCase):
         finally:
             mx.distributed.all_sum = original_all_sum
 
+    def test_gradient_reducer(self):
+        original_all_sum = mx.distributed.all_sum
+        n_calls = 0
+
+        def new_all_sum(x, **kwargs):
+            nonlocal n_calls
+            n_calls += 1
+            return original_all_sum(x, **kwargs)
+
+        mx.distributed.all_sum = new_all_sum
+
+        try:
+            grads = {
+                "a": [mx.ones(10) for i in range(10)],
+                "b": mx.ones((4, 5), dtype=mx.float16),
+            }
+            new_grads = GradientReducer(bucket_size=4 * 50)(grads)
+            mx.eval(new_grads)
+            self.assertEqual(len(new_grads["a"]), 10)
+            self.assertTrue(all(mx.all(g == 1) for g in new_grads["a"]))
+            self.assertEqual(new_grads["b"].dtype, mx.float16)
+            self.assertEqual(new_grads["b"].shape, (4, 5))
+            self.assertTrue(mx.all(new_grads["b"] == 1))
+            # Two buckets of float32 and one of float16
+            self.assertEqual(n_calls, 3)
+        finally:
+            mx.distributed.all_sum = original_all_sum
+
+    def test_pipeline_value_and_grad(self):
+        world = mx.distributed.init()
+        n = world.size()
+        mx.random.seed(0xF0F0F0F0)
+        stages = [nn.Linear(16, 16) for _ in range(n)]
+        x = mx.random.normal((8, 16))
+        y = mx.random.normal((8, 16))
+        mx.eval(stages, x, y)
+
+        def loss_fn(out, y):
+            return nn.losses.mse_loss(out, y)
+
+        def full_loss(params):
+            stages[world.rank()].update(params)
+            h = x
+            for stage in stages:
+                h = stage(h)
+            return loss_fn(h, y)
+
+        stage = stages[world.rank()]
+        expected_loss, expected_grads = mx.value_and_grad(full_loss)(
+            stage.trainable_parameters()
+        )
+        for num_microbatches in [1, 2, 4]:
+            step = pipeline_value_and_grad(stage, loss_fn, num_microbatches)
+            loss, grads = step(x, y)
+            mx.eval(loss, grads)
+            if world.rank() == n - 1:
+                self.assertTrue(mx.allclose(loss, expected_loss, atol=1e-5))
+            else:
+                self.assertIsNone(loss)
+            for k in ["weight", "bias"]:
+                self.assertTrue(mx.allclose(grads[k], expected_grads[k], atol=1e-5))
+
     def test_donation(self):
         x = mx.random.normal((1024,))
         mx.eval(x)
@@ -81,6 +147,108 @@ class MLXDistributedCommonTestCase(mlx_tests.MLXTestCase):
 
         self.assertEqual(all_sum_only, all_sum_with_binary)
 
+    def test_compressed_all_sum(self):
+        world = mx.distributed.init()
+        n = world.size()
+        r = world.rank()
+
+        mx.random.seed(0)
+        x = mx.random.normal((n, 3000))
+        for compression, rtol in [("bf16", 1e-2), ("fp8", 1e-1)]:
+            y = mx.distributed.all_sum(x[r], compression=compression)
+            z = x.sum(0)
+            self.assertEqual(y.dtype, mx.float32)
+            err = (y - z).abs().mean() / z.abs().mean()
+            self.assertLessEqual(err.item(), rtol)
+
+            # Every process ends with the same values
+            y0 = mx.distributed.all_gather(y[None])
+            self.assertTrue(mx.all(y0 == y))
+
+        with self.assertRaises(ValueError):
+            mx.distributed.all_sum(x[r], compression="int4")
+
+    def test_reduce_scatter(self):
+        world = mx.distributed.init()
+        n = world.size()
+        r = world.rank()
+
+        x = mx.arange(n * 6, dtype=mx.float32).reshape(n * 2, 3) * (r + 1)
+        y = mx.distributed.reduce_scatter(x)
+        total = mx.arange(n * 6, dtype=mx.float32).reshape(n * 2, 3)
+        total = total * (n * (n + 1) // 2)
+        self.assertTrue(mx.array_equal(y, total[2 * r : 2 * r + 2]))
+
+        # The gradient is gathered from all the processes
+        def fun(x):
+            return (mx.distributed.reduce_scatter(x) * (r + 1)).sum()
+
+        dx = mx.grad(fun)(x)
+        expected = mx.repeat(mx.arange(1, n + 1, dtype=mx.float32), 2)
+        expected = mx.broadcast_to(expected[:, None], x.shape)
+        self.assertTrue(mx.array_equal(dx, expected))
+
+    def test_all_to_all(self):
+        world = mx.distributed.init()
+        n = world.size()
+        r = world.rank()
+
+        x = mx.full((n * 2, 3), r, dtype=mx.int32) * n + mx.repeat(
+            mx.arange(n), 2
+        )[:, None]
+        y = mx.distributed.all_to_all(x)
+        expected = mx.repeat(mx.arange(n) * n + r, 2)
+        self.assertTrue(mx.array_equal(y[:, 0], expected))
+
+        # Rank r sends r + 1 rows to every other rank
+        send_sizes = [r + 1] * n
+        recv_sizes = [i + 1 for i in range(n)]
+        x = mx.full((n * (r + 1), 2), r, dtype=mx.float32)
+        y = mx.distributed.all_to_all(
+            x, send_sizes=send_sizes, recv_sizes=recv_sizes
+        )
+        expected = mx.concatenate(
+            [mx.full((i + 1, 2), i, dtype=mx.float32) for i in range(n)]
+        )
+        self.assertTrue(mx.array_equal(y, expected))
+
+        # The cotangents go back to the rank they came from
+        def fun(x):
+            y = mx.distributed.all_to_all(
+                x, send_sizes=send_sizes, recv_sizes=recv_sizes
+            )
+            return (y * (r + 1)).sum()
+
+        dx = mx.grad(fun)(x)
+        expected = mx.repeat(mx.arange(1, n + 1, dtype=mx.float32), r + 1)
+        expected = mx.broadcast_to(expected[:, None], x.shape)
+        self.assertTrue(mx.array_equal(dx, expected))
+
+    def test_sharded_matmul(self):
+        world = mx.distributed.init()
+        n = world.size()
+        r = world.rank()
+
+        mx.random.seed(0xF0F0F0F0)
+        x = mx.random.normal((2, 6, n * 8))
+        w = mx.random.normal((n * 8, 16))
+        xs = x[..., r * 8 : (r + 1) * 8]
+        ws = w[r * 8 : (r + 1) * 8]
+        expected = x @ w
+        for chunks in [1, 3, 16]:
+            y = mx.distributed.matmul_all_sum(xs, ws, chunks=chunks)
+            self.assertTrue(mx.allclose(y, expected, atol=1e-4, rtol=1e-4))
+
+        # The rows of x are sharded and the columns of w
+        x = mx.random.normal((n * 4, 3, 8))
+        w = mx.random.normal((8, n * 4))
+        xs = x[r * 4 : (r + 1) * 4]
+        ws = w[:, r * 4 : (r + 1) * 4]
+        expected = x @ ws
+        for chunks in [1, 2, 5]:
+            y = mx.distributed.all_gather_matmul(xs, ws, chunks=chunks)
+            self.assertTrue(mx.allclose(y, expected, atol=1e-4, rtol=1e-4))
+
     def test_shard_linear(self):
         # Seed the prng to have the same inputs and weights generated everywhere
         mx.random.seed(0xF0F0F0F0)
@@ -21,8 +21,34 @@ class TestRingDistributed(mlx_distributed_tests.MLXDistributedCommonTestCase):
         self.assertEqual(world.size(), world2.size())
         self.assertEqual(world.rank(), world2.rank())
 
-        with self.assertRaises(RuntimeError):
-            sub = world.split(world.rank() % 2)
+        sub = world.split(world.rank() % 2)
+        self.assertEqual(sub.size(), 4)
+        self.assertEqual(sub.rank(), world.rank() // 2)
+
+        x = mx.distributed.all_sum(mx.array(world.rank()), group=sub)
+        self.assertEqual(x.item(), sum(range(world.rank() % 2, 8, 2)))
+
+        sub = world.split(world.rank() // 2, key=-world.rank())
+        self.assertEqual(sub.size(), 2)
+        self.assertEqual(sub.rank(), 1 - world.rank() % 2)
+
+    def test_hierarchical_group(self):
+        world = mx.distributed.init()
+        local = world.split(world.rank() // 4)
+        cross = world.split(world.rank() % 4)
+        group = mx.distributed.hierarchical_group(local, cross)
+        self.assertEqual(group.size(), 8)
+        self.assertEqual(group.rank(), world.rank())
+
+        x = mx.arange(10, dtype=mx.float32).reshape(2, 5) * (world.rank() + 1)
+        y = mx.distributed.all_sum(x, group=group)
+        self.assertTrue(mx.array_equal(y, mx.distributed.all_sum(x)))
+
+        y = mx.distributed.all_max(x, group=group)
+        self.assertTrue(mx.array_equal(y, mx.arange(10).reshape(2, 5) * 8))
+
+        y = mx.distributed.all_gather(x, group=group)
+        self.assertTrue(mx.array_equal(y, mx.distributed.all_gather(x)))
 
     def test_all_reduce(self):
         world = mx.distributed.init()
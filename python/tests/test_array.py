@@ -832,6 +832,20 @@ class TestArray(mlx_tests.MLXTestCase):
             y = f(x, v)
             self.assertEqual(y.dtype, dtype_out)
 
+    def test_python_scalar_operands(self):
+        # The small scalars are shared, the in place updates must not change
+        # them for the later operations
+        x = mx.zeros((2,), mx.float16)
+        x += 1
+        x *= 2
+        y = mx.zeros((2,), mx.float16) + 1
+        self.assertEqual(x.tolist(), [2.0, 2.0])
+        self.assertEqual(y.tolist(), [1.0, 1.0])
+        self.assertEqual((mx.array(3) - 1).item(), 2)
+        self.assertEqual((mx.array(3) - 1.0).item(), 2.0)
+        self.assertEqual((1.0 / (mx.array(1.0) * -0.0)).item(), -float("inf"))
+        self.assertEqual((mx.array(1.0) + 0.5).item(), 1.5)
+
     def test_array_comparison(self):
         a = mx.array([0.0, 1.0, 5.0])
         b = mx.array([-1.0, 2.0, 5.0])
@@ -1416,6 +1430,17 @@ class TestArray(mlx_tests.MLXTestCase):
         src = src.at[0:1].add(update)
         self.assertTrue(mx.array_equal(src, mx.array([[2.0, 4.0]])))
 
+        # Large scatters with repeated rows are split between the CPU threads
+        idx = mx.array(np.random.randint(0, 64, size=(4096,)))
+        upd = mx.random.normal((4096, 32))
+        with mx.stream(mx.cpu):
+            a = mx.zeros((64, 32)).at[idx].add(upd)
+            b = mx.take(a, idx, axis=0)
+        expected = np.zeros((64, 32), dtype=np.float32)
+        np.add.at(expected, np.array(idx), np.array(upd))
+        self.assertTrue(np.allclose(a, expected, atol=1e-4))
+        self.assertTrue(np.array_equal(b, np.array(a)[np.array(idx)]))
+
     def test_slice_negative_step(self):
         a_np = np.arange(20)
         a_mx = mx.array(a_np)
@@ -1575,6 +1600,16 @@ class TestArray(mlx_tests.MLXTestCase):
         self.assertTrue(a_np.flags.owndata)
         self.assertTrue(a_np.flags.writeable)
 
+    def test_large_np_array_conversion(self):
+        # Large enough to be copied through the pinned memory on CUDA
+        x = np.arange(1 << 19, dtype=np.float32).reshape(512, 1024)
+        a = mx.array(x)
+        x[0, 0] = -1
+        self.assertEqual(a[0, 0].item(), 0)
+        self.assertTrue(np.array_equal(np.array(a[1:]), x[1:]))
+        self.assertEqual(mx.array(x.astype(np.int16)).dtype, mx.int16)
+        self.assertEqual(mx.array(x, mx.int32)[2, 3].item(), 2 * 1024 + 3)
+
     def test_buffer_protocol(self):
         dtypes_list = [
             (mx.bool_, np.bool_, None),
@@ -1867,6 +1902,51 @@ class TestArray(mlx_tests.MLXTestCase):
         y = np.from_dlpack(x)
         self.assertTrue(mx.array_equal(y, x))
 
+    def test_from_dlpack(self):
+        x = np.arange(6, dtype=np.float32).reshape(2, 3)
+        y = mx.from_dlpack(x)
+        self.assertEqual(y.dtype, mx.float32)
+        self.assertTrue(mx.array_equal(y, x))
+
+        x = mx.array([[1, 2], [3, 4]], dtype=mx.int16)
+        y = mx.from_dlpack(x)
+        self.assertEqual(y.dtype, mx.int16)
+        self.assertTrue(mx.array_equal(y, x))
+        del x
+        self.assertTrue(mx.array_equal(y, mx.array([[1, 2], [3, 4]])))
+
+    def test_to_host(self):
+        a = mx.arange(6, dtype=mx.float32).reshape(2, 3)
+        b = mx.array([1, 2, 3], dtype=mx.int16)[::2]
+        x, y, z = mx.to_host([a + 1, b, mx.array(True)])
+        self.assertTrue(np.array_equal(x, np.arange(1, 7).reshape(2, 3)))
+        self.assertEqual(x.dtype, np.float32)
+        self.assertEqual(y.tolist(), [1, 3])
+        self.assertEqual(y.dtype, np.int16)
+        self.assertEqual(z.item(), True)
+        self.assertFalse(x.flags.writeable)
+        self.assertEqual(mx.to_host([]), [])
+
+    def test_cuda_array_interface(self):
+        x = mx.arange(6, dtype=mx.float32).reshape(2, 3)
+        if not mx.cuda.is_available():
+            self.assertFalse(hasattr(x, "__cuda_array_interface__"))
+            return
+
+        interface = (x + 1).__cuda_array_interface__
+        self.assertEqual(interface["version"], 3)
+        self.assertEqual(interface["shape"], (2, 3))
+        self.assertEqual(interface["typestr"], "<f4")
+        self.assertIsNone(interface["strides"])
+
+        class Producer:
+            def __init__(self, x):
+                self.x = x
+                self.__cuda_array_interface__ = x.__cuda_array_interface__
+
+        y = mx.array(Producer(x + 1))
+        self.assertTrue(mx.array_equal(y, x + 1))
+
     def test_getitem_with_list(self):
         a = mx.array([1, 2, 3, 4, 5])
         idx = [0, 2, 4]
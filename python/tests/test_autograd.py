@@ -797,6 +797,36 @@ class TestAutograd(mlx_tests.MLXTestCase):
         grad_fn(model)
         self.assertEqual(model[1].item(), 2.0)
 
+    def test_checkpoint_policy(self):
+        def fun(x, w1, w2):
+            y = mx.exp(x @ w1) * 0.5
+            y = mx.maximum(y @ w2, 0.0) + x
+            return (y * y).sum()
+
+        x = mx.random.normal((4, 8))
+        w1 = mx.random.normal((8, 8)) / 8
+        w2 = mx.random.normal((8, 8)) / 8
+        expected = mx.grad(fun, argnums=(0, 1, 2))(x, w1, w2)
+
+        policies = [None, "matmuls", lambda name: name in ("Exp", "Maximum")]
+        for policy in policies:
+            grad_fn = mx.grad(mx.checkpoint(fun, policy=policy), (0, 1, 2))
+            for grads in [grad_fn(x, w1, w2), mx.compile(grad_fn)(x, w1, w2)]:
+                for g, e in zip(grads, expected):
+                    self.assertTrue(mx.allclose(g, e, atol=1e-5))
+
+        names = []
+
+        def policy(name):
+            names.append(name)
+            return False
+
+        mx.grad(mx.checkpoint(fun, policy=policy))(x, w1, w2)
+        self.assertEqual(names.count("Matmul"), 2)
+
+        with self.assertRaises(ValueError):
+            mx.checkpoint(fun, policy="everything")
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
@@ -519,6 +519,47 @@ class TestBlas(mlx_tests.MLXTestCase):
                                     )
                                     self.assertTrue(np.array_equal(c_mlx, c_npy))
 
+    def test_small_m_matmul(self):
+        # Few rows of a, as in the decode of a batch of sequences.
+        for M in (2, 5, 8):
+            for K, N in ((64, 33), (4096, 16), (31, 1024)):
+                for transpose_b in (False, True):
+                    a_np = np.random.normal(size=(M, K)).astype(np.float32)
+                    b_np = np.random.normal(size=(K, N)).astype(np.float32)
+                    a = mx.array(a_np)
+                    b = mx.array(b_np.T) if transpose_b else mx.array(b_np)
+                    if transpose_b:
+                        b = b.T
+                    out = a @ b
+                    self.assertTrue(np.allclose(out, a_np @ b_np, atol=1e-3))
+
+        # Batched with different matrices.
+        a_np = np.random.normal(size=(3, 4, 128)).astype(np.float32)
+        b_np = np.random.normal(size=(3, 128, 65)).astype(np.float32)
+        out = mx.array(a_np) @ mx.array(b_np)
+        self.assertTrue(np.allclose(out, a_np @ b_np, atol=1e-3))
+
+    def test_matmul_broadcast_batches(self):
+        # Broadcasted outer batches, as the shared heads of GQA.
+        q_np = np.random.normal(size=(2, 4, 3, 16, 32)).astype(np.float32)
+        k_np = np.random.normal(size=(2, 4, 1, 32, 24)).astype(np.float32)
+        out = mx.array(q_np) @ mx.array(k_np)
+        self.assertTrue(np.allclose(out, q_np @ k_np, atol=1e-3))
+
+        # Transposed and broadcasted
+        k_np = np.random.normal(size=(2, 1, 3, 24, 32)).astype(np.float32)
+        out = mx.array(q_np) @ mx.swapaxes(mx.array(k_np), -1, -2)
+        expected = q_np @ np.swapaxes(k_np, -1, -2)
+        self.assertTrue(np.allclose(out, expected, atol=1e-3))
+
+        # Sliced matrices with larger leading dimensions
+        a_np = np.random.normal(size=(3, 64, 96)).astype(np.float32)
+        b_np = np.random.normal(size=(3, 96, 80)).astype(np.float32)
+        a = mx.array(a_np)[:, :, :64]
+        b = mx.array(b_np)[:, :64, :32]
+        expected = a_np[:, :, :64] @ b_np[:, :64, :32]
+        self.assertTrue(np.allclose(a @ b, expected, atol=1e-3))
+
     def test_mismatch_stride_mm(self):
         np.random.seed(0)
         a_npy = np.random.normal(0.0, 1.0 / 128, (4, 16, 16)).astype(np.float32)
@@ -1209,6 +1250,22 @@ class TestBlas(mlx_tests.MLXTestCase):
         self.assertTrue(mx.allclose(dc1[0], dc2[0], atol=1e-4))
         self.assertTrue(mx.allclose(dc1[1], dc2[1], atol=1e-4))
 
+    def test_gather_mm_large_batch(self):
+        # More batch elements than the grid holds in one launch.
+        a = mx.random.normal((70000, 2, 8))
+        b = mx.random.normal((4, 8, 8))
+        rhs = mx.random.randint(0, 4, shape=(70000,))
+        c1 = a @ b[rhs]
+        c2 = mx.gather_mm(a, b, rhs_indices=rhs)
+        self.assertTrue(mx.allclose(c1, c2, atol=1e-4))
+
+        a = mx.random.normal((2, 70000))
+        b = mx.random.normal((70000, 2))
+        segments = mx.stack([mx.arange(70000), mx.arange(1, 70001)], axis=1)
+        c1 = a.T[:, :, None] * b[:, None, :]
+        c2 = mx.segmented_mm(a, b, segments.astype(mx.uint32))
+        self.assertTrue(mx.allclose(c1, c2, atol=1e-4))
+
     def test_segmented_mm(self):
         def segmented_mm_ref(a, b, s):
             s = s.tolist()
@@ -1271,6 +1328,65 @@ class TestBlas(mlx_tests.MLXTestCase):
         c = mx.segmented_mm(a, a.T, s)
         self.assertEqual(c.shape, (2, 2, 4, 10, 10))
 
+    def test_sparse_matmul(self):
+        def to_csr(a):
+            rows, cols = np.nonzero(a)
+            indptr = np.searchsorted(rows, np.arange(a.shape[0] + 1))
+            return (
+                mx.array(indptr.astype(np.int32)),
+                mx.array(cols.astype(np.int32)),
+                mx.array(a[rows, cols]),
+            )
+
+        np.random.seed(0)
+        devices = [mx.cpu]
+        if mx.cuda.is_available():
+            devices.append(mx.gpu)
+        for device in devices:
+            for M, K, N, density in [(1, 1, 1, 1.0), (64, 33, 17, 0.1)]:
+                a = np.random.normal(size=(M, K)).astype(np.float32)
+                a *= np.random.uniform(size=(M, K)) < density
+                b = mx.random.normal((K, N))
+                indptr, indices, values = to_csr(a)
+                out = mx.sparse_matmul(
+                    indptr, indices, values, b, stream=device
+                )
+                expected = mx.array(a) @ b
+                self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+                # The gradients of the values and of b.
+                def loss(values, b):
+                    c = mx.sparse_matmul(
+                        indptr, indices, values, b, stream=device
+                    )
+                    return (c * c).sum()
+
+                def dense_loss(a, b):
+                    return ((a @ b) ** 2).sum()
+
+                d_values, d_b = mx.grad(loss, argnums=(0, 1))(values, b)
+                d_a, d_b_expected = mx.grad(dense_loss, argnums=(0, 1))(
+                    mx.array(a), b
+                )
+                rows = np.repeat(np.arange(M), np.diff(np.array(indptr)))
+                d_values_expected = d_a[mx.array(rows), indices]
+                self.assertTrue(
+                    mx.allclose(d_values, d_values_expected, atol=1e-3)
+                )
+                self.assertTrue(mx.allclose(d_b, d_b_expected, atol=1e-3))
+
+            # An empty sparse matrix multiplies to zeros.
+            indptr = mx.zeros((5,), dtype=mx.int32)
+            empty = mx.array([], dtype=mx.int32)
+            values = empty.astype(mx.float32)
+            b = mx.ones((3, 2))
+            out = mx.sparse_matmul(indptr, empty, values, b, stream=device)
+            self.assertTrue(mx.array_equal(out, mx.zeros((4, 2))))
+
+        with self.assertRaises(ValueError):
+            indptr = mx.array([0, 1], dtype=mx.int64)
+            mx.sparse_matmul(indptr, mx.array([0]), mx.array([1.0]), mx.ones((1, 1)))
+
     def test_gemv_gemm_same_precision(self):
         mx.random.seed(0)
         N = 256
@@ -1342,6 +1458,33 @@ class TestBlas(mlx_tests.MLXTestCase):
         c_np = np.matmul(a, b)
         self.assertTrue(np.allclose(out, out_np))
 
+    def test_matmul_precision(self):
+        a = mx.random.normal((64, 128))
+        b = mx.random.normal((128, 32))
+        c = mx.random.normal((64, 32))
+        expected = np.matmul(np.array(a), np.array(b))
+        for precision in ["default", "float32", "tf32", "bfloat16", "float16"]:
+            out = mx.matmul(a, b, precision=precision)
+            self.assertTrue(np.allclose(out, expected, rtol=1e-1, atol=1e-1))
+            out = mx.addmm(c, a, b, precision=precision)
+            self.assertTrue(
+                np.allclose(out, expected + np.array(c), rtol=1e-1, atol=1e-1)
+            )
+
+        out = mx.matmul(a, b, precision="float32")
+        self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+        with mx.matmul_precision("float32"):
+            out = a @ b
+            dout = mx.grad(lambda a: (a @ b).sum())(a)
+        self.assertTrue(np.allclose(out, expected, rtol=1e-4, atol=1e-4))
+        expected = np.broadcast_to(np.array(b).sum(axis=1), a.shape)
+        self.assertTrue(np.allclose(dout, expected, rtol=1e-4, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.matmul(a, b, precision="float8")
+        with self.assertRaises(ValueError):
+            mx.matmul_precision("float8")
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
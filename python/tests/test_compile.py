@@ -305,6 +305,26 @@ class TestCompile(mlx_tests.MLXTestCase):
         cdfdx = mx.grad(outer)(x)
         self.assertTrue(mx.allclose(dfdx, cdfdx))
 
+    def test_compile_capture_structure_change(self):
+        state = {"y": mx.array(2), "z": None}
+
+        @partial(mx.compile, inputs=state)
+        def test_state(x):
+            if state["z"] is not None:
+                x = x + state["z"]
+            return x + state["y"]
+
+        self.assertEqual(test_state(mx.array(1)).item(), 3)
+        self.assertEqual(test_state(mx.array(1)).item(), 3)
+
+        # An array in place of a leaf which was not
+        state["z"] = mx.array(10)
+        self.assertEqual(test_state(mx.array(1)).item(), 13)
+
+        # A new key
+        state["w"] = mx.array(5)
+        self.assertEqual(test_state(mx.array(1)).item(), 13)
+
     def test_compile_capture(self):
         # Test update captured state outside compiled function
         state = {"y": mx.array(2)}
@@ -1014,6 +1034,161 @@ class TestCompile(mlx_tests.MLXTestCase):
         self.assertTrue(mx.allclose(d[0], d_hat[0]))
         self.assertTrue(mx.allclose(d[1], d_hat[1]))
 
+    def test_compile_matmul_bias_relu(self):
+        def linear(x, w, b):
+            return x @ w.T + b
+
+        def linear_relu(x, w, b):
+            return mx.maximum(x @ w.T + b, 0)
+
+        def matmul_relu(x, w):
+            return mx.maximum(x @ w, 0)
+
+        x = mx.random.normal((2, 8, 16))
+        w = mx.random.normal((32, 16))
+        b = mx.random.normal((32,))
+        for fun in [linear, linear_relu]:
+            out = mx.compile(fun)(x, w, b)
+            self.assertTrue(mx.allclose(out, fun(x, w, b), atol=1e-4))
+        out = mx.compile(matmul_relu)(x, w.T)
+        self.assertTrue(mx.allclose(out, matmul_relu(x, w.T), atol=1e-4))
+
+        # The intermediate outputs are kept.
+        def fun(x, w, b):
+            y = x @ w.T
+            return y, mx.maximum(y + b, 0)
+
+        outs = mx.compile(fun)(x, w, b)
+        for out, expected in zip(outs, fun(x, w, b)):
+            self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+        # Gradients go through the fused matmul.
+        loss = lambda x, w, b: linear_relu(x, w, b).sum()
+        grads = mx.compile(mx.grad(loss, argnums=(0, 1, 2)))(x, w, b)
+        expected = mx.grad(loss, argnums=(0, 1, 2))(x, w, b)
+        for g, e in zip(grads, expected):
+            self.assertTrue(mx.allclose(g, e, atol=1e-4))
+
+    def test_compile_constants_across_shapes(self):
+        # The fused kernels read the constants, such as the scale of a mean,
+        # so the kernels shared by the lengths compute with their own.
+        fun = mx.compile(lambda x: mx.exp(x - x.mean(axis=-1, keepdims=True)))
+        for n in [3, 5, 8, 13]:
+            x = mx.arange(n, dtype=mx.float32)
+            expected = mx.exp(x - (n - 1) / 2)
+            self.assertTrue(mx.allclose(fun(x), expected, atol=1e-5))
+
+    def test_compile_cache_info(self):
+        fun = mx.compile(lambda x: x * 2 + 1)
+        mx.reset_compile_cache_info()
+        for n in range(1, 9):
+            self.assertTrue(mx.array_equal(fun(mx.ones((n,))), mx.full((n,), 3)))
+        for n in range(1, 9):
+            fun(mx.ones((n,)))
+        info = mx.compile_cache_info()
+        self.assertEqual(info["misses"], 8)
+        self.assertEqual(info["hits"], 8)
+        self.assertGreaterEqual(info["entries"], 8)
+
+        # The entries of a function are removed with it.
+        entries = info["entries"]
+        del fun
+        self.assertEqual(mx.compile_cache_info()["entries"], entries - 8)
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_compile_cuda_graph(self):
+        def step(x, w, offset):
+            h = mx.fast.rms_norm(x, None, 1e-5)
+            y = mx.maximum(h @ w, 0) + offset
+            return y, y.sum(axis=-1)
+
+        w = mx.random.normal((64, 64))
+        graph_step = mx.compile(step, cuda_graph=True)
+        xs = [mx.random.normal((4, 64)) for _ in range(4)]
+        for offset in [1.0, 1.0, 2.0]:
+            # The outputs of a call are not changed by the next calls.
+            outs = [graph_step(x, w, offset) for x in xs]
+            for x, out in zip(xs, outs):
+                for o, expected in zip(out, step(x, w, offset)):
+                    self.assertTrue(mx.allclose(o, expected, atol=1e-4))
+
+        # The outputs of a call can be the inputs of the next.
+        x = xs[0]
+        expected = xs[0]
+        for _ in range(3):
+            x = graph_step(x, w, 1.0)[0]
+            expected = step(expected, w, 1.0)[0]
+        self.assertTrue(mx.allclose(x, expected, atol=1e-4))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_compile_cuda_graph_memory(self):
+        def step(x, w):
+            for _ in range(32):
+                x = (x @ w) * 0.5
+            return (x,)
+
+        x = mx.random.normal((1024, 256))
+        w = mx.random.normal((256, 256)) / 16
+        mx.eval(x, w)
+        graph_step = mx.compile(step, cuda_graph=True)
+        mx.synchronize()
+        mx.clear_cache()
+        active = mx.get_active_memory()
+        out = graph_step(x, w)[0]
+        mx.synchronize()
+        # The intermediates share a few slots of an arena instead of each
+        # keeping its buffer.
+        self.assertLess(mx.get_active_memory() - active, 8 * x.nbytes)
+        expected = step(x, w)[0]
+        self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+        self.assertTrue(mx.allclose(graph_step(x, w)[0], expected, atol=1e-4))
+
+    def test_compile_views_between_elementwise(self):
+        # The views of the outputs of elementwise ops are moved to their
+        # operands so that the ops around them fuse
+        def attn_scores(q, bias):
+            q = mx.exp(q * 0.5).reshape(2, 8, 4, 16).transpose(0, 2, 1, 3)
+            return mx.tanh(q + bias) * 2
+
+        def strided(x, y):
+            z = (x + y)[:, ::2]
+            return mx.sigmoid(z.T) + 1
+
+        def chained(x):
+            y = mx.abs(x).T.reshape(-1)
+            return mx.sqrt(y), y
+
+        q = mx.random.normal((2, 8, 64))
+        bias = mx.random.normal((2, 4, 8, 16))
+        x = mx.random.normal((16, 32))
+        y = mx.random.normal((16, 32))
+        for fn, args in [
+            (attn_scores, (q, bias)),
+            (strided, (x, y)),
+            (chained, (x,)),
+        ]:
+            expected = fn(*args)
+            out = mx.compile(fn)(*args)
+            if not isinstance(expected, tuple):
+                expected, out = (expected,), (out,)
+            for e, o in zip(expected, out):
+                self.assertEqual(e.shape, o.shape)
+                self.assertTrue(mx.allclose(e, o))
+
+    def test_compile_large_cpu(self):
+        # The large outputs are split in chunks across the CPU threads
+        def fun(x, y):
+            return mx.exp(x) * y + 1, mx.abs(x - y)
+
+        with mx.stream(mx.cpu):
+            x = mx.random.normal((300, 1001))
+            y = mx.random.normal((1001,))
+            for a, b in [(x, x[::-1]), (x, y), (x.T, x.T), (x[:, ::3], y[::3])]:
+                expected = fun(a, b)
+                out = mx.compile(fun)(a, b)
+                for e, o in zip(expected, out):
+                    self.assertTrue(mx.allclose(e, o))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
@@ -1186,6 +1186,36 @@ class TestConv(mlx_tests.MLXTestCase):
         y_hat = mx.conv2d(x, w)
         self.assertTrue(mx.allclose(y, y_hat))
 
+    def test_conv_vjp_matches_cpu(self):
+        # The batch of 64 splits the reduction of the weight gradient
+        for kwargs in [
+            {},
+            {"stride": 2, "padding": 1},
+            {"dilation": 2, "groups": 4},
+        ]:
+            x = mx.random.normal(shape=(64, 12, 12, 16))
+            w = mx.random.normal(shape=(8, 3, 3, 16 // kwargs.get("groups", 1)))
+
+            def loss(x, w, stream):
+                return mx.conv2d(x, w, stream=stream, **kwargs).square().sum()
+
+            grads = mx.grad(loss, argnums=(0, 1))(x, w, mx.cpu)
+            grads_hat = mx.grad(loss, argnums=(0, 1))(x, w, None)
+            for g, g_hat in zip(grads, grads_hat):
+                self.assertTrue(mx.allclose(g, g_hat, rtol=1e-3, atol=1e-2))
+
+        # Transposed convolutions flip the weight
+        x = mx.random.normal(shape=(4, 9, 9, 8))
+        w = mx.random.normal(shape=(8, 3, 3, 8))
+
+        def loss(x, w, stream):
+            return mx.conv_transpose2d(x, w, stride=2, stream=stream).sum()
+
+        grads = mx.grad(loss, argnums=(0, 1))(x, w, mx.cpu)
+        grads_hat = mx.grad(loss, argnums=(0, 1))(x, w, None)
+        for g, g_hat in zip(grads, grads_hat):
+            self.assertTrue(mx.allclose(g, g_hat, rtol=1e-3, atol=1e-2))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
@@ -112,6 +112,33 @@ class TestStream(mlx_tests.MLXTestCase):
         b = mx.add(x, y, stream=s_cpu)
         self.assertEqual(a.item(), b.item())
 
+    def test_stream_priority(self):
+        s = mx.new_stream(mx.default_device())
+        self.assertEqual(s.priority, 0)
+
+        s_high = mx.new_stream(mx.default_device(), priority=1)
+        self.assertEqual(s_high.priority, 1)
+        s_low = mx.new_stream(mx.default_device(), priority=-1)
+        x = mx.ones((64, 64))
+        a = mx.matmul(x, x, stream=s_low)
+        b = mx.add(x, 1, stream=s_high)
+        self.assertTrue(mx.array_equal(a + b, mx.full((64, 64), 66.0)))
+
+    def test_stream_sm_fraction(self):
+        s = mx.new_stream(mx.default_device())
+        self.assertEqual(s.sm_fraction, 1.0)
+
+        s_decode = mx.new_stream(mx.default_device(), sm_fraction=0.25)
+        self.assertEqual(s_decode.sm_fraction, 0.25)
+        x = mx.ones((64, 64))
+        a = mx.matmul(x, x, stream=s_decode)
+        self.assertTrue(mx.array_equal(a, mx.full((64, 64), 64.0)))
+
+        with self.assertRaises(ValueError):
+            mx.new_stream(mx.default_device(), sm_fraction=0.0)
+        with self.assertRaises(ValueError):
+            mx.new_stream(mx.default_device(), sm_fraction=1.5)
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
@@ -40,6 +40,20 @@ class TestEinsum(mlx_tests.MLXTestCase):
         path = mx.einsum_path("ij,jk,kl", a, b, c)
         self.assertEqual(path[0], [(1, 2), (0, 1)])
 
+    def test_optimal_path(self):
+        a = mx.zeros((5, 8))
+        b = mx.zeros((8, 10))
+        c = mx.zeros((10, 7))
+        path = mx.einsum_path("ij,jk,kl", a, b, c, optimize="optimal")
+        self.assertEqual(path[0], [(0, 1), (0, 1)])
+
+        # The greedy path makes the smallest intermediate first
+        path = mx.einsum_path("ij,jk,kl", a, b, c)
+        self.assertEqual(path[0], [(1, 2), (0, 1)])
+
+        with self.assertRaises(ValueError):
+            mx.einsum_path("ij,jk", a, b, optimize="fastest")
+
     def test_longer_paths(self):
         chars = "abcdefghijklmopqABC"
         sizes = [2, 3, 4, 5, 4, 3, 2, 6, 5, 4, 3, 2, 5, 7, 4, 3, 2, 3, 4]
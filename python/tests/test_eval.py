@@ -1,10 +1,17 @@
 # Copyright © 2023 Apple Inc.
 
+import asyncio
+import json
+import os
+import subprocess
+import sys
+import threading
 import unittest
 from functools import partial
 
 import mlx.core as mx
 import mlx_tests
+import numpy as np
 
 
 class TestEval(mlx_tests.MLXTestCase):
@@ -59,6 +66,85 @@ class TestEval(mlx_tests.MLXTestCase):
             self.assertEqual(x.item(), 3)
             self.assertEqual(y.item(), 4)
 
+    def test_async_eval_future(self):
+        x = mx.array([1, 2, 3])
+        y = 2 * x
+        future = mx.async_eval(y)
+        done = threading.Event()
+        future.then(done.set)
+        future.wait()
+        self.assertTrue(future.done())
+        self.assertTrue(done.wait(timeout=10))
+        self.assertTrue(mx.array_equal(y, mx.array([2, 4, 6])))
+
+        # Done already, the callback runs right away
+        calls = []
+        mx.async_eval(y).then(lambda: calls.append(1))
+        self.assertEqual(calls, [1])
+
+        async def run():
+            z = mx.exp(x)
+            await mx.async_eval(z)
+            return z
+
+        z = asyncio.run(run())
+        self.assertTrue(mx.allclose(z, mx.exp(x)))
+
+    def test_projected_peak_memory(self):
+        x = mx.ones((256,))
+        mx.eval(x)
+        y = mx.exp(x)
+        z = y * y
+        # y is freed once z is made
+        peak = mx.projected_peak_memory({"z": z})
+        self.assertEqual(peak - mx.get_active_memory(), 2048)
+        self.assertEqual(mx.projected_peak_memory(x), mx.get_active_memory())
+
+    def test_gpu_fallback_info(self):
+        mx.reset_gpu_fallback_info()
+        # Nothing falls back unless MLX_GPU_CPU_FALLBACK is set
+        mx.eval(mx.exp(mx.ones((8,))))
+        if os.environ.get("MLX_GPU_CPU_FALLBACK", "0") == "0":
+            self.assertEqual(mx.gpu_fallback_info(), {})
+
+    @unittest.skipIf(not mx.is_available(mx.gpu), "GPU is not available")
+    def test_gpu_fallback(self):
+        # Exp falls back as if the GPU did not implement it, with its input
+        # computed on the GPU and its output used there.
+        script = (
+            "import json; import mlx.core as mx; "
+            "x = mx.arange(8, dtype=mx.float32) * 0.5; "
+            "y = mx.exp(x) + 1; "
+            "mx.eval(y); "
+            "info = mx.gpu_fallback_info()['Exp']; "
+            "print(json.dumps([y.tolist(), info['count'], info['transfer_bytes']]))"
+        )
+
+        def run(level):
+            env = dict(
+                os.environ,
+                MLX_GPU_CPU_FALLBACK=level,
+                MLX_GPU_CPU_FALLBACK_PRIMITIVES="Exp",
+            )
+            return subprocess.run(
+                [sys.executable, "-c", script],
+                capture_output=True,
+                text=True,
+                env=env,
+                check=True,
+            )
+
+        out = run("1")
+        y, count, transfer_bytes = json.loads(out.stdout)
+        expected = np.exp(np.arange(8, dtype=np.float32) * 0.5) + 1
+        self.assertTrue(np.allclose(y, expected))
+        self.assertEqual(count, 1)
+        self.assertEqual(transfer_bytes, 32)
+        self.assertEqual(out.stderr, "")
+
+        # The warning is only printed from level 2
+        self.assertIn("Exp", run("2").stderr)
+
     def test_async_eval_in_trace(self):
         def fun(x):
             y = x + 1.0
@@ -195,6 +281,53 @@ class TestEval(mlx_tests.MLXTestCase):
         mx.eval(z)
         mx.set_memory_limit(old_limit)
 
+    def test_host_callback(self):
+        calls = []
+
+        def fun(xs):
+            calls.append([x.tolist() for x in xs])
+            return [mx.array(np.array(xs[0]) + xs[1].item()), mx.array(len(calls))]
+
+        # The inputs come from the default device and the outputs feed back
+        # into the graph.
+        x = mx.exp(mx.zeros((2, 3)))
+        y = mx.array(2.0)
+        a, n = mx.host_callback(fun, [x.T, y], [(3, 2), ()], [mx.float32, mx.int32])
+        self.assertEqual(a.shape, (3, 2))
+        self.assertEqual(n.dtype, mx.int32)
+        self.assertEqual(calls, [])
+        out = a * 2
+        self.assertTrue(mx.array_equal(out, mx.full((3, 2), 6.0)))
+        self.assertEqual(n.item(), 1)
+        self.assertEqual(len(calls), 1)
+
+        # A single array and NumPy arrays, converted to the output type.
+        (b,) = mx.host_callback(
+            lambda xs: np.array(xs[0]) + 1, [mx.arange(4)], [(4,)], [mx.float32]
+        )
+        self.assertTrue(mx.array_equal(b, mx.arange(1, 5)))
+        self.assertEqual(b.dtype, mx.float32)
+
+        with self.assertRaises(ValueError):
+            mx.host_callback(fun, [x, y], [(2, 3)], [mx.float32, mx.int32])
+
+        # The errors of the function are raised by the next evaluation and
+        # the outputs are NaN.
+        def fails(xs):
+            raise KeyError("missing")
+
+        (c,) = mx.host_callback(fails, [x], [(2, 3)], [mx.float32])
+        out = c + 1
+        with self.assertRaises(RuntimeError):
+            mx.eval(out)
+        self.assertTrue(mx.isnan(out).all())
+
+        (d,) = mx.host_callback(lambda xs: xs[0], [x], [(3, 2)], [mx.float32])
+        with self.assertRaises(ValueError):
+            mx.eval(d)
+        self.assertTrue(mx.isnan(d).all())
+        self.assertEqual((x + 1).sum().item(), 12.0)
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
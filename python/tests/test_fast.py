@@ -277,6 +277,59 @@ class TestFast(mlx_tests.MLXTestCase):
                 g2 = mx.grad(f2)(x, y)
                 self.assertLess(mx.abs(g1 - g2).max(), 1e-5)
 
+    def test_rope_qkv(self):
+        B, L, S, D = 2, 5, 16, 32
+        n_heads, n_kv_heads, offset = 4, 2, 3
+        freqs = mx.random.uniform(shape=(D // 4,))
+        for traditional in (True, False):
+            for dims, base, f in ((D, 10000.0, None), (D // 2, None, freqs)):
+                qkv = mx.random.uniform(shape=(B, L, (n_heads + 2 * n_kv_heads) * D))
+                k_cache = mx.random.uniform(shape=(B, n_kv_heads, S, D))
+                v_cache = mx.random.uniform(shape=(B, n_kv_heads, S, D))
+
+                x = qkv.reshape(B, L, -1, D).transpose(0, 2, 1, 3)
+                q = x[:, :n_heads]
+                k = x[:, n_heads : n_heads + n_kv_heads]
+                v = x[:, n_heads + n_kv_heads :]
+                q = rope_orig(q, dims, traditional, base, 1.0, offset, f)
+                k = rope_orig(k, dims, traditional, base, 1.0, offset, f)
+                expected_k = mx.array(k_cache)
+                expected_k[:, :, offset : offset + L] = k
+                expected_v = mx.array(v_cache)
+                expected_v[:, :, offset : offset + L] = v
+
+                out_q, out_k, out_v = mx.fast.rope_qkv(
+                    qkv,
+                    k_cache,
+                    v_cache,
+                    n_heads=n_heads,
+                    n_kv_heads=n_kv_heads,
+                    dims=dims,
+                    traditional=traditional,
+                    base=base,
+                    scale=1.0,
+                    offset=offset,
+                    freqs=f,
+                )
+                self.assertEqual(out_q.shape, (B, n_heads, L, D))
+                self.assertLess(mx.abs(out_q - q).max(), 1e-5)
+                self.assertLess(mx.abs(out_k - expected_k).max(), 1e-5)
+                self.assertTrue(mx.array_equal(out_v, expected_v))
+
+        with self.assertRaises(ValueError):
+            mx.fast.rope_qkv(
+                qkv,
+                k_cache,
+                v_cache,
+                n_heads=n_heads,
+                n_kv_heads=n_kv_heads,
+                dims=D,
+                traditional=False,
+                base=10000.0,
+                scale=1.0,
+                offset=S - L + 1,
+            )
+
     def test_rms_norm(self):
         # Per dtype absolute tolerance
         tolerances = {mx.float32: 1e-6, mx.float16: 1e-3, mx.bfloat16: 1e-2}
@@ -368,6 +421,16 @@ class TestFast(mlx_tests.MLXTestCase):
         gx2 = mx.grad(f4, argnums=(0,))(x, y)
         self.assertLess(mx.abs(gx1 - gx2).max(), 1e-5)
 
+        # More rows than blocks and rows longer than the sums kept per thread.
+        D = 12288
+        x = mx.random.uniform(shape=(4, 128, D))
+        w = mx.random.uniform(shape=(D,))
+        y = mx.random.uniform(shape=(4, 128, D))
+        gx1, gw1 = mx.grad(f1, argnums=(0, 1))(x, w, y)
+        gx2, gw2 = mx.grad(f2, argnums=(0, 1))(x, w, y)
+        self.assertLess(mx.abs(gx1 - gx2).max(), 1e-5)
+        self.assertLess(mx.abs(gw1 - gw2).max() / mx.abs(gw1).mean(), 5e-5)
+
         def gf(f):
             def inner(x, w, y):
                 gx, gw = mx.grad(f, argnums=(0, 1))(x, w, y)
@@ -503,6 +566,19 @@ class TestFast(mlx_tests.MLXTestCase):
         self.assertLess(mx.abs(gw1 - gw2).max() / mx.abs(gw1).mean(), 5e-5)
         self.assertLess(mx.abs(gb1 - gb2).max() / mx.abs(gb1).mean(), 5e-5)
 
+        # More rows than blocks and rows longer than the sums kept per thread.
+        D = 12288
+        x = mx.random.uniform(shape=(4, 128, D))
+        w = mx.random.uniform(shape=(D,))
+        b = mx.random.uniform(shape=(D,))
+        y = mx.random.uniform(shape=(4, 128, D))
+
+        gx1, gw1, gb1 = mx.grad(f1, argnums=(0, 1, 2))(x, w, b, y)
+        gx2, gw2, gb2 = mx.grad(f2, argnums=(0, 1, 2))(x, w, b, y)
+        self.assertLess(mx.abs(gx1 - gx2).max(), 5e-5)
+        self.assertLess(mx.abs(gw1 - gw2).max() / mx.abs(gw1).mean(), 5e-5)
+        self.assertLess(mx.abs(gb1 - gb2).max() / mx.abs(gb1).mean(), 5e-5)
+
         def gf(f):
             def inner(x, w, b, y):
                 gx, gw, gb = mx.grad(f, argnums=(0, 1, 2))(x, w, b, y)
@@ -543,6 +619,412 @@ class TestFast(mlx_tests.MLXTestCase):
         self.assertLess(mx.abs(gw1 - gw2).max() / mx.abs(gw1).mean(), 1e-5)
         self.assertLess(mx.abs(gb1 - gb2).max() / mx.abs(gb1).mean(), 1e-5)
 
+    def test_add_norm(self):
+        tolerances = {mx.float32: 1e-5, mx.float16: 5e-3, mx.bfloat16: 5e-2}
+        eps = 1e-5
+        for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+            for dims in [31, 32, 4096 + 3]:
+                x = mx.random.uniform(shape=(3, dims)).astype(dtype)
+                r = mx.random.uniform(shape=(3, dims)).astype(dtype)
+                w = mx.random.uniform(shape=(dims,)).astype(dtype)
+                b = mx.random.uniform(shape=(dims,)).astype(dtype)
+                tol = tolerances[dtype]
+
+                h, y = mx.fast.add_rms_norm(x, r, w, eps)
+                self.assertLess(mx.abs(h - (x + r)).max(), tol)
+                y_ref = mx.fast.rms_norm(x + r, w, eps)
+                self.assertLess(mx.abs(y - y_ref).max(), tol)
+
+                h, y = mx.fast.add_rms_norm(x, r, None, eps)
+                y_ref = mx.fast.rms_norm(x + r, None, eps)
+                self.assertLess(mx.abs(y - y_ref).max(), tol)
+
+                h, y = mx.fast.add_layer_norm(x, r, w, b, eps)
+                self.assertLess(mx.abs(h - (x + r)).max(), tol)
+                y_ref = layer_norm(x + r, w, b, eps)
+                self.assertLess(mx.abs(y - y_ref).max(), tol)
+
+                h, y = mx.fast.add_layer_norm(x, r, None, None, eps)
+                y_ref = layer_norm(x + r, None, None, eps)
+                self.assertLess(mx.abs(y - y_ref).max(), tol)
+
+        # Transposed inputs and gradients
+        x = mx.random.uniform(shape=(16, 8)).T
+        r = mx.random.uniform(shape=(8, 16))
+        w = mx.random.uniform(shape=(16,))
+        _, y = mx.fast.add_rms_norm(x, r, w, eps)
+        self.assertLess(mx.abs(y - rms_norm(x + r, w, eps)).max(), 1e-5)
+
+        f1 = lambda x, r: mx.fast.add_rms_norm(x, r, w, eps)[1].sum()
+        f2 = lambda x, r: rms_norm(x + r, w, eps).sum()
+        g1 = mx.grad(f1, argnums=(0, 1))(x, r)
+        g2 = mx.grad(f2, argnums=(0, 1))(x, r)
+        self.assertLess(mx.abs(g1[0] - g2[0]).max(), 1e-5)
+        self.assertLess(mx.abs(g1[1] - g2[1]).max(), 1e-5)
+
+        with self.assertRaises(ValueError):
+            mx.fast.add_rms_norm(x, r[:4], w, eps)
+
+    def test_cross_entropy(self):
+        def ref(logits, targets):
+            score = mx.take_along_axis(logits, targets[..., None], -1)[..., 0]
+            return mx.logsumexp(logits, axis=-1) - score
+
+        for dtype, tol in [(mx.float32, 1e-5), (mx.float16, 1e-2)]:
+            for shape in [(4, 37), (2, 3, 1000), (5, 5000)]:
+                logits = (4 * mx.random.normal(shape)).astype(dtype)
+                targets = mx.random.randint(0, shape[-1], shape[:-1])
+                loss = mx.fast.cross_entropy(logits, targets)
+                self.assertEqual(loss.dtype, dtype)
+                self.assertLess(mx.abs(loss - ref(logits, targets)).max(), tol)
+
+        # Gradients, with transposed inputs
+        logits = mx.random.normal((7, 3, 300)).swapaxes(0, 1)
+        targets = mx.random.randint(0, 300, (7, 3)).T
+        w = mx.random.uniform(shape=(3, 7))
+        f1 = lambda x: (mx.fast.cross_entropy(x, targets) * w).sum()
+        f2 = lambda x: (ref(x, targets) * w).sum()
+        self.assertLess(mx.abs(f1(logits) - f2(logits)).max(), 1e-4)
+        g1 = mx.grad(f1)(logits)
+        g2 = mx.grad(f2)(logits)
+        self.assertLess(mx.abs(g1 - g2).max(), 1e-5)
+
+        # The negative targets count from the last class
+        logits = mx.random.normal((6, 300))
+        targets = mx.array([-1, -300, -150, 0, 299, -2])
+        loss = mx.fast.cross_entropy(logits, targets)
+        self.assertLess(mx.abs(loss - ref(logits, targets)).max(), 1e-5)
+        f1 = lambda x: mx.fast.cross_entropy(x, targets).sum()
+        f2 = lambda x: ref(x, targets).sum()
+        g1 = mx.grad(f1)(logits)
+        g2 = mx.grad(f2)(logits)
+        self.assertLess(mx.abs(g1 - g2).max(), 1e-5)
+
+        with self.assertRaises(ValueError):
+            mx.fast.cross_entropy(logits, targets[:2])
+        with self.assertRaises(ValueError):
+            mx.fast.cross_entropy(logits, targets.astype(mx.float32))
+
+    def test_gated_activation(self):
+        def swiglu(x):
+            a, b = mx.split(x, 2, axis=-1)
+            return a * mx.sigmoid(a) * b
+
+        def geglu(x):
+            a, b = mx.split(x, 2, axis=-1)
+            return a * (1 + mx.erf(a / math.sqrt(2))) / 2 * b
+
+        for fast_fn, ref_fn in [(mx.fast.swiglu, swiglu), (mx.fast.geglu, geglu)]:
+            for dtype, tol in [(mx.float32, 1e-5), (mx.bfloat16, 5e-2)]:
+                with self.subTest(fn=ref_fn.__name__, dtype=dtype):
+                    x = mx.random.normal(shape=(3, 8, 64)).astype(dtype)
+                    out = fast_fn(x)
+                    self.assertEqual(out.shape, (3, 8, 32))
+                    self.assertEqual(out.dtype, dtype)
+                    expected = ref_fn(x)
+                    self.assertTrue(mx.allclose(out, expected, atol=tol, rtol=tol))
+
+                    cotan = mx.random.normal(shape=(3, 8, 32)).astype(dtype)
+                    _, (vjp,) = mx.vjp(fast_fn, [x], [cotan])
+                    _, (expected,) = mx.vjp(ref_fn, [x], [cotan])
+                    self.assertTrue(mx.allclose(vjp, expected, atol=tol, rtol=tol))
+
+        # Non contiguous inputs
+        x = mx.random.normal(shape=(64, 8)).T
+        self.assertTrue(mx.allclose(mx.fast.swiglu(x), swiglu(x), atol=1e-5))
+
+        with self.assertRaises(ValueError):
+            mx.fast.swiglu(mx.zeros((4, 7)))
+
+    def test_moe_route(self):
+        for E, k in [(8, 2), (64, 6), (3, 3)]:
+            for normalize in [True, False]:
+                logits = mx.random.normal(shape=(5, 7, E))
+                indices, weights, counts, perm = mx.fast.moe_route(
+                    logits, k, normalize
+                )
+                self.assertEqual(indices.shape, (5, 7, k))
+                self.assertEqual(indices.dtype, mx.uint32)
+                self.assertEqual(weights.shape, (5, 7, k))
+
+                probs = mx.softmax(logits, axis=-1)
+                expected = mx.argsort(-probs, axis=-1)[..., :k]
+                self.assertTrue(mx.array_equal(indices, expected))
+                expected = mx.take_along_axis(probs, expected, axis=-1)
+                if normalize:
+                    expected = expected / expected.sum(axis=-1, keepdims=True)
+                self.assertTrue(mx.allclose(weights, expected, atol=1e-5))
+
+                flat = indices.flatten()
+                expected = (flat[:, None] == mx.arange(E)).sum(axis=0)
+                self.assertTrue(mx.array_equal(counts, expected))
+                self.assertTrue(mx.array_equal(perm, mx.argsort(flat)))
+
+        # The token dtype is kept for the weights
+        logits = mx.random.normal(shape=(16, 8)).astype(mx.float16)
+        _, weights, _, _ = mx.fast.moe_route(logits, 2)
+        self.assertEqual(weights.dtype, mx.float16)
+
+        with self.assertRaises(ValueError):
+            mx.fast.moe_route(logits, 9)
+        with self.assertRaises(ValueError):
+            mx.fast.moe_route(logits.astype(mx.int32), 2)
+
+    def test_max_with_index(self):
+        # Long rows with few of them are reduced across several blocks
+        for shape in [(4, 7), (1, 262144), (3, 100000), (5, 6, 9)]:
+            x = mx.random.normal(shape=shape)
+            for axis in range(-len(shape), len(shape)):
+                vals, idx = mx.fast.max_with_index(x, axis)
+                self.assertEqual(idx.dtype, mx.uint32)
+                self.assertTrue(mx.array_equal(vals, mx.max(x, axis)))
+                self.assertTrue(mx.array_equal(idx, mx.argmax(x, axis)))
+                vals, idx = mx.fast.min_with_index(x, axis, keepdims=True)
+                self.assertTrue(mx.array_equal(vals, mx.min(x, axis, True)))
+                self.assertTrue(mx.array_equal(idx, mx.argmin(x, axis, True)))
+
+        # The first of the ties is returned
+        x = mx.zeros((2, 100000), dtype=mx.float16)
+        x[:, 70000] = 1
+        x[:, 90000] = 1
+        vals, idx = mx.fast.max_with_index(x)
+        self.assertEqual(vals.dtype, mx.float16)
+        self.assertEqual(idx.tolist(), [70000, 70000])
+
+        x = mx.random.randint(0, 10, shape=(8, 16))
+        vals, idx = mx.fast.max_with_index(x[:, ::2], axis=0)
+        self.assertTrue(mx.array_equal(vals, mx.max(x[:, ::2], 0)))
+        self.assertTrue(mx.array_equal(idx, mx.argmax(x[:, ::2], 0)))
+
+        with self.assertRaises(ValueError):
+            mx.fast.max_with_index(mx.zeros((4,)), axis=1)
+        with self.assertRaises(ValueError):
+            mx.fast.max_with_index(mx.zeros((0,)))
+
+    def test_moments(self):
+        # Long reductions with few outputs are split across several blocks
+        for shape in [(4, 7), (2, 100000), (100000, 3), (3, 5, 6, 7)]:
+            x = mx.random.normal(shape=shape)
+            axes = [None, 0, -1, (0, 1)]
+            if len(shape) > 2:
+                axes += [(1, 2), (0, 2), (1, 3), (0, 1, 2, 3)]
+            for axis in axes:
+                mean, var = mx.fast.moments(x, axis)
+                self.assertTrue(mx.allclose(mean, mx.mean(x, axis), atol=1e-5))
+                self.assertTrue(mx.allclose(var, mx.var(x, axis), atol=1e-5))
+                mean, var = mx.fast.moments(x, axis, keepdims=True, ddof=1)
+                self.assertTrue(mx.allclose(mean, mx.mean(x, axis, True), atol=1e-5))
+                self.assertTrue(
+                    mx.allclose(var, mx.var(x, axis, True, ddof=1), atol=1e-5)
+                )
+
+        # A large offset does not cancel out the variance
+        x = mx.random.normal(shape=(8, 4096)) + 1000
+        _, var = mx.fast.moments(x, axis=1)
+        self.assertTrue(mx.allclose(var, mx.var(x - 1000, axis=1), rtol=1e-3))
+
+        x = mx.random.normal(shape=(16, 8, 4)).astype(mx.float16)
+        mean, var = mx.fast.moments(x.transpose(2, 0, 1), axis=(1, 2))
+        self.assertEqual(mean.dtype, mx.float16)
+        self.assertTrue(mx.allclose(mean, mx.mean(x, (0, 1)), atol=1e-3))
+        self.assertTrue(mx.allclose(var, mx.var(x, (0, 1)), atol=1e-2))
+
+        x = mx.random.randint(0, 10, shape=(6, 5))
+        mean, var = mx.fast.moments(x, axis=0)
+        self.assertEqual(mean.dtype, mx.float32)
+        self.assertTrue(mx.allclose(var, mx.var(x, 0)))
+
+        with self.assertRaises(ValueError):
+            mx.fast.moments(mx.zeros((4,)), axis=1)
+        with self.assertRaises(ValueError):
+            mx.fast.moments(mx.zeros((4, 4)), axis=(0, -2))
+
+    def test_lora_matmul(self):
+        K, N, r, L = 64, 48, 8, 5
+        w = mx.random.normal(shape=(K, N)) / 8
+        a = mx.random.normal(shape=(L, K, r)) / 8
+        b = mx.random.normal(shape=(L, r, N)) / 8
+        x = mx.random.normal(shape=(3, 7, K))
+        indices = mx.random.randint(0, L, shape=(3, 7))
+
+        def reference(x, indices, scale):
+            a_rows = a[indices]
+            b_rows = b[indices]
+            update = (x[..., None, :] @ a_rows @ b_rows).squeeze(-2)
+            return x @ w + scale * update
+
+        out = mx.fast.lora_matmul(x, w, a, b, indices, 0.5)
+        self.assertEqual(out.shape, (3, 7, N))
+        self.assertTrue(mx.allclose(out, reference(x, indices, 0.5), atol=1e-4))
+
+        # Rows grouped by adapter
+        flat_x = x.reshape(-1, K)
+        order = mx.argsort(indices.flatten())
+        flat_x = flat_x[order]
+        flat_indices = indices.flatten()[order]
+        out = mx.fast.lora_matmul(flat_x, w, a, b, flat_indices, sorted_indices=True)
+        expected = reference(flat_x, flat_indices, 1.0)
+        self.assertTrue(mx.allclose(out, expected, atol=1e-4))
+
+        with self.assertRaises(ValueError):
+            mx.fast.lora_matmul(x, w, a, b, indices.flatten())
+        with self.assertRaises(ValueError):
+            mx.fast.lora_matmul(x, w, a[:, :-1], b, indices)
+
+    def test_optimizer_step(self):
+        # Mixed types and sizes, including a transposed gradient
+        shapes = [(3, 5), (1000,), (1,), (70, 70)]
+        dtypes = [mx.float32, mx.float16, mx.float32, mx.float32]
+        params = [mx.random.normal(s).astype(t) for s, t in zip(shapes, dtypes)]
+        grads = [mx.random.normal(p.shape).astype(p.dtype) for p in params]
+        grads[-1] = grads[-1].T
+        m = [mx.random.normal(p.shape).astype(p.dtype) for p in params]
+        v = [mx.random.uniform(shape=p.shape).astype(p.dtype) for p in params]
+        lr = mx.array(0.1)
+
+        def check(outputs, expected):
+            for out, ref in zip(outputs, expected):
+                for o, r in zip(out, ref):
+                    self.assertEqual(o.dtype, r.dtype)
+                    tol = 1e-2 if o.dtype == mx.float16 else 1e-5
+                    self.assertTrue(mx.allclose(o, r, atol=tol, rtol=tol))
+
+        for nesterov in [False, True]:
+            out = mx.fast.sgd_step(
+                params,
+                grads,
+                m,
+                lr,
+                momentum=0.9,
+                weight_decay=0.01,
+                nesterov=nesterov,
+            )
+            g = [g + 0.01 * p for g, p in zip(grads, params)]
+            new_m = [0.9 * b + g for b, g in zip(m, g)]
+            upd = [g + 0.9 * b if nesterov else b for g, b in zip(g, new_m)]
+            new_p = [p - 0.1 * u for p, u in zip(params, upd)]
+            check(out, [new_p, new_m])
+
+        out = mx.fast.sgd_step(params, grads, [], 0.1)
+        check(out, [[p - 0.1 * g for p, g in zip(params, grads)]])
+
+        step = mx.array(3, mx.uint64)
+        for bias_step in [None, step]:
+            out = mx.fast.adamw_step(
+                params, grads, m, v, lr, weight_decay=0.1, step=bias_step
+            )
+            new_m = [0.9 * a + 0.1 * g for a, g in zip(m, grads)]
+            new_v = [0.999 * a + 0.001 * g * g for a, g in zip(v, grads)]
+            c1, c2 = 0.1, 1.0
+            if bias_step is not None:
+                c1 = 0.1 / (1 - 0.9**3)
+                c2 = (1 - 0.999**3) ** -0.5
+            new_p = [
+                p * (1 - 0.1 * 0.1) - c1 * a / (mx.sqrt(b) * c2 + 1e-8)
+                for p, a, b in zip(params, new_m, new_v)
+            ]
+            check(out, [new_p, new_m, new_v])
+
+        out = mx.fast.lion_step(params, grads, m, lr, weight_decay=0.1)
+        c = [mx.sign(0.9 * a + 0.1 * g) for a, g in zip(m, grads)]
+        new_p = [p * (1 - 0.1 * 0.1) - 0.1 * s for p, s in zip(params, c)]
+        new_m = [0.99 * a + 0.01 * g for a, g in zip(m, grads)]
+        check(out, [new_p, new_m])
+
+        with self.assertRaises(ValueError):
+            mx.fast.lion_step(params, grads[:2], m, lr)
+        with self.assertRaises(ValueError):
+            mx.fast.lion_step(params, grads[::-1], m, lr)
+
+    def test_stochastic_round(self):
+        key = mx.random.key(0)
+
+        def reference(x, key):
+            bits = mx.random.bits(x.shape, 4, key) & 0xFFFF
+            u = (x.astype(mx.float32).view(mx.uint32) + bits) >> 16
+            return u.astype(mx.uint16).view(mx.bfloat16)
+
+        for dtype in [mx.float32, mx.float16]:
+            for shape in [(1,), (7,), (33, 17)]:
+                x = mx.random.normal(shape).astype(dtype)
+                out = mx.fast.stochastic_round(x, key=key)
+                self.assertEqual(out.dtype, mx.bfloat16)
+                self.assertTrue(mx.array_equal(out, reference(x, key)))
+        x = mx.random.normal((16, 16))
+        out = mx.fast.stochastic_round(x.T, key=key)
+        self.assertTrue(mx.array_equal(out, reference(x.T, key)))
+
+        # One of the two closest values, unbiased on average
+        x = mx.full((10000,), 1 + 2**-10)
+        out = mx.fast.stochastic_round(x, key=key).astype(mx.float32)
+        self.assertTrue(mx.all((out == 1) | (out == 1 + 2**-7)))
+        self.assertAlmostEqual(out.mean().item(), 1 + 2**-10, delta=2e-4)
+
+        # The same key gives the same rounding
+        a = mx.fast.stochastic_round(x, key=key)
+        b = mx.fast.stochastic_round(x, key=key)
+        self.assertTrue(mx.array_equal(a, b))
+
+        # Updates below half a bfloat16 step are kept on average
+        params = [mx.ones((10000,), mx.bfloat16), mx.ones((3,), mx.bfloat16)]
+        grads = [mx.ones_like(p) for p in params]
+        lr = 2**-10
+        out = mx.fast.sgd_step(params, grads, [], lr)
+        self.assertTrue(mx.all(out[0][0] == 1))
+        out = mx.fast.sgd_step(params, grads, [], lr, stochastic_rounding=True, key=key)
+        keys = mx.random.split(key, 2)
+        for i, (p, g) in enumerate(zip(params, grads)):
+            new_p = p.astype(mx.float32) - lr * g.astype(mx.float32)
+            self.assertTrue(mx.array_equal(out[0][i], reference(new_p, keys[i])))
+        self.assertAlmostEqual(
+            out[0][0].astype(mx.float32).mean().item(), 1 - lr, delta=2e-4
+        )
+
+        m = [mx.zeros_like(p) for p in params]
+        for step in [mx.fast.adamw_step, mx.fast.lion_step]:
+            args = (m, m) if step is mx.fast.adamw_step else (m,)
+            out = step(params, grads, *args, lr, stochastic_rounding=True)
+            for o in out:
+                for a in o:
+                    self.assertEqual(a.dtype, mx.bfloat16)
+
+    def test_sample_top_k_top_p(self):
+        sample = mx.fast.sample_top_k_top_p
+        logits = 4 * mx.random.normal((6, 1000))
+        greedy = mx.argmax(logits, axis=-1)
+        self.assertTrue(mx.array_equal(sample(logits, top_k=1), greedy))
+        self.assertTrue(mx.array_equal(sample(logits, top_p=1e-6), greedy))
+        self.assertTrue(mx.array_equal(sample(logits, temperature=0), greedy))
+
+        # The samples are the ones of the composite with the same key
+        key = mx.random.key(3)
+        for dtype in [mx.float32, mx.float16]:
+            for args in [
+                {},
+                {"top_k": 50},
+                {"top_p": 0.9},
+                {"top_k": 8, "top_p": 0.5},
+            ]:
+                x = logits.astype(dtype)
+                a = sample(x, temperature=0.7, key=key, **args)
+                b = sample(x, temperature=0.7, key=key, stream=mx.cpu, **args)
+                self.assertEqual(a.dtype, mx.uint32)
+                self.assertTrue(mx.array_equal(a, b))
+
+        # Only the kept logits are sampled with their renormalized probability
+        logits = mx.broadcast_to(mx.array([0.0, 1.0, 2.0, 3.0]), (4000, 4))
+        counts = lambda s: [(s == i).sum().item() for i in range(4)]
+        c = counts(sample(logits, top_k=2))
+        self.assertEqual(c[0] + c[1], 0)
+        self.assertAlmostEqual(c[3] / 4000, 1 / (1 + math.exp(-1)), delta=0.05)
+        c = counts(sample(logits, top_p=0.7))
+        self.assertEqual(c[0] + c[1], 0)
+
+        with self.assertRaises(ValueError):
+            sample(logits, top_p=0.0)
+        with self.assertRaises(ValueError):
+            sample(logits, top_k=-1)
+
     def test_fast_transforms(self):
         x = mx.random.uniform(shape=(2, 2, 8))
 
@@ -770,6 +1252,117 @@ class TestFast(mlx_tests.MLXTestCase):
         out = call_kernel(a, source)
         self.assertTrue(mx.array_equal(out, mx.ones_like(out)))
 
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_cuda_kernel_args(self):
+        mx.random.seed(7)
+        a = mx.random.normal(shape=(3, 6))
+        c = mx.random.normal(shape=(2, 2)).astype(mx.bfloat16)
+
+        kernel = mx.fast.cuda_kernel(
+            name="arg_test",
+            input_names=["a", "b", "c", "d"],
+            output_names=["out1", "out2"],
+            source="""
+                auto elem = cooperative_groups::this_grid().thread_rank();
+                if (elem >= 6) {
+                    return;
+                }
+                if (elem < 4) {
+                    if (e) {
+                        out1[elem] =
+                            a[1] + b[2] + static_cast<float>(c[3]) + d[0] + f;
+                    } else {
+                        out1[elem] = 1;
+                    }
+                }
+                out2[elem] = a[1] + b[2] + static_cast<float>(c[1]) - d[0];
+            """,
+        )
+        out = kernel(
+            inputs=[
+                a,
+                mx.array([3, 4, 5]),
+                c,
+                7.3,
+            ],
+            template=[
+                ("e", True),
+                ("f", 3),
+                ("T", mx.float16),
+            ],
+            grid=(6, 1, 1),
+            threadgroup=(4, 1, 1),
+            output_shapes=[(2, 2), (3, 2)],
+            output_dtypes=[mx.float32, mx.int32],
+            stream=mx.gpu,
+        )
+
+        self.assertTrue(mx.allclose(out[0], mx.full((2, 2), 14.0484)))
+        self.assertTrue(mx.allclose(out[1], mx.full((3, 2), -2, dtype=mx.int32)))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_cuda_kernel_strides(self):
+        mx.random.seed(7)
+        a = mx.random.normal(shape=(3, 6))
+        source = """
+            auto elem = cooperative_groups::this_grid().thread_rank();
+            auto loc = elem_to_loc(
+                elem, inp_shape.data(), inp_strides.data(), inp_ndim);
+            out[elem] = exp(inp[loc]);
+        """
+        source_contig = """
+            auto elem = cooperative_groups::this_grid().thread_rank();
+            out[elem] = exp(inp[elem]);
+        """
+
+        # non contiguous
+        a = mx.tile(a[::2], [4, 1])
+
+        for contig in [True, False]:
+            kernel = mx.fast.cuda_kernel(
+                name="myexp" + str(contig),
+                input_names=["inp"],
+                output_names=["out"],
+                source=source_contig if contig else source,
+                ensure_row_contiguous=contig,
+            )
+            outputs = kernel(
+                inputs=[a],
+                grid=(a.size, 1, 1),
+                threadgroup=(a.size, 1, 1),
+                output_shapes=[a.shape],
+                output_dtypes=[a.dtype],
+                stream=mx.gpu,
+            )
+            self.assertTrue(mx.allclose(mx.exp(a), outputs[0]))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_cuda_kernel_shared_memory(self):
+        a = mx.arange(256, dtype=mx.float32)
+        kernel = mx.fast.cuda_kernel(
+            name="reverse",
+            input_names=["inp"],
+            output_names=["out"],
+            source="""
+                extern __shared__ float smem[];
+                auto block = cooperative_groups::this_thread_block();
+                int i = block.thread_rank();
+                smem[i] = inp[i];
+                block.sync();
+                out[i] = smem[block.size() - 1 - i];
+            """,
+            shared_memory=256 * 4,
+        )
+        out = kernel(
+            inputs=[a],
+            grid=(256, 1, 1),
+            threadgroup=(256, 1, 1),
+            output_shapes=[a.shape],
+            output_dtypes=[a.dtype],
+            stream=mx.gpu,
+        )[0]
+        self.assertTrue(mx.array_equal(out, a[::-1]))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
@@ -513,6 +513,213 @@ class TestFastSDPA(mlx_tests.MLXTestCase):
         ref = mlx_ref_attn(q, k, v, mask=mask)
         self.assertTrue(mx.allclose(ref, out, atol=1e-4, rtol=1e-4))
 
+    def test_paged_attention(self):
+        D = 64
+        n_heads, n_kv_heads, page_size = 4, 2, 16
+        cache = mx.fast.PagedKVCache(
+            num_pages=8,
+            page_size=page_size,
+            n_kv_heads=n_kv_heads,
+            head_dim=D,
+            dtype=mx.float32,
+        )
+        seqs = [cache.add_sequence(), cache.add_sequence()]
+
+        # Sequences of different lengths, one prompt at a time then decoding.
+        keys = [[], []]
+        values = [[], []]
+        for i, L in enumerate([20, 5]):
+            k = mx.random.normal(shape=(1, n_kv_heads, L, D))
+            v = mx.random.normal(shape=(1, n_kv_heads, L, D))
+            cache.append([seqs[i]], k, v)
+            keys[i].append(k)
+            values[i].append(v)
+        self.assertEqual(cache.num_free_pages, 5)
+
+        for _ in range(3):
+            k = mx.random.normal(shape=(2, n_kv_heads, 1, D))
+            v = mx.random.normal(shape=(2, n_kv_heads, 1, D))
+            cache.append(seqs, k, v)
+            q = mx.random.normal(shape=(2, n_heads, 1, D))
+            out = cache.attention(seqs, q, scale=1.0)
+            for i in range(2):
+                keys[i].append(k[i : i + 1])
+                values[i].append(v[i : i + 1])
+                ref = mlx_ref_attn(
+                    q[i : i + 1],
+                    mx.concatenate(keys[i], axis=2),
+                    mx.concatenate(values[i], axis=2),
+                )
+                self.assertTrue(mx.allclose(ref, out[i : i + 1], atol=1e-4))
+
+        self.assertEqual(cache.length(seqs[0]), 23)
+        cache.free_sequence(seqs[0])
+        self.assertEqual(cache.num_free_pages, 7)
+
+        with self.assertRaises(RuntimeError):
+            k = mx.zeros((1, n_kv_heads, 8 * page_size, D))
+            cache.append([seqs[1]], k, k)
+
+    def test_sdpa_window(self):
+        D = 64
+        B, n_heads, n_kv_heads, kL = 2, 4, 2, 200
+        k = mx.random.normal(shape=(B, n_kv_heads, kL, D)).astype(mx.float16)
+        v = mx.random.normal(shape=(B, n_kv_heads, kL, D)).astype(mx.float16)
+        for qL in (1, 5, 100):
+            q = mx.random.normal(shape=(B, n_heads, qL, D)).astype(mx.float16)
+            pos = mx.arange(kL - qL, kL)[:, None]
+            keys = mx.arange(kL)[None]
+            for mode, window, sinks in [
+                ("causal", 48, 0),
+                ("causal", 48, 4),
+                ("chunked", 64, 0),
+                ("chunked", 64, 2),
+            ]:
+                if mode == "causal":
+                    first = pos - window + 1
+                else:
+                    first = pos // window * window
+                mask = (keys <= pos) & ((keys >= first) | (keys < sinks))
+                out = mx.fast.scaled_dot_product_attention(
+                    q,
+                    k,
+                    v,
+                    scale=D**-0.5,
+                    mask=mode,
+                    window_size=window,
+                    num_sinks=sinks,
+                )
+                ref = mlx_ref_attn(q, k, v, scale=D**-0.5, mask=mask)
+                self.assertTrue(mx.allclose(ref, out, atol=1e-2))
+
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(q, k, v, scale=1.0, mask="chunked")
+
+    def test_sdpa_tree_mask(self):
+        D = 64
+        B, n_heads, n_kv_heads = 2, 4, 2
+        np.random.seed(0)
+        for kL, qL in [(200, 1), (200, 5), (2000, 7), (200, 12)]:
+            k = mx.random.normal(shape=(B, n_kv_heads, kL, D)).astype(mx.float16)
+            v = mx.random.normal(shape=(B, n_kv_heads, kL, D)).astype(mx.float16)
+            q = mx.random.normal(shape=(B, n_heads, qL, D)).astype(mx.float16)
+            # A random tree of the drafts, each one sees its ancestors.
+            parents = [-1] + [np.random.randint(0, i) for i in range(1, qL)]
+            tree = np.eye(qL, dtype=bool)
+            for i in range(1, qL):
+                tree[i] |= tree[parents[i]]
+            tree = mx.array(tree)
+            mask = mx.concatenate([mx.ones((qL, kL - qL), mx.bool_), tree], -1)
+            ref = mlx_ref_attn(q, k, v, scale=D**-0.5, mask=mask)
+            out = mx.fast.scaled_dot_product_attention(
+                q, k, v, scale=D**-0.5, tree_mask=tree
+            )
+            self.assertTrue(mx.allclose(ref, out, atol=1e-2))
+
+            # Additive masks and a chain of drafts, the causal mask.
+            chain = mx.where(mx.tril(mx.ones((qL, qL))), 0, -np.inf)
+            out = mx.fast.scaled_dot_product_attention(
+                q, k, v, scale=D**-0.5, tree_mask=chain.astype(mx.float16)
+            )
+            ref = mlx_ref_attn(q, k, v, scale=D**-0.5, mask="causal")
+            self.assertTrue(mx.allclose(ref, out, atol=1e-2))
+
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(
+                q, k, v, scale=1.0, mask="causal", tree_mask=tree
+            )
+        with self.assertRaises(ValueError):
+            mx.fast.scaled_dot_product_attention(
+                q, k[:, :, :4], v[:, :, :4], scale=1.0, tree_mask=tree
+            )
+
+    def test_varlen_attention(self):
+        D = 64
+        n_heads, n_kv_heads = 4, 2
+        q_lens = [20, 5, 70]
+        k_lens = [20, 9, 70]
+        cu_q = mx.array([0] + q_lens).cumsum()
+        cu_k = mx.array([0] + k_lens).cumsum()
+        q = mx.random.normal(shape=(sum(q_lens), n_heads, D)).astype(mx.float16)
+        k = mx.random.normal(shape=(sum(k_lens), n_kv_heads, D)).astype(mx.float16)
+        v = mx.random.normal(shape=(sum(k_lens), n_kv_heads, D)).astype(mx.float16)
+
+        # The packed tokens of each sequence moved to (1, n_heads, L, D).
+        def seq(x, cu, i):
+            return mx.swapaxes(x[cu[i].item() : cu[i + 1].item()], 0, 1)[None]
+
+        for causal in (False, True):
+            out = mx.fast.varlen_attention(
+                q, k, v, cu_q, cu_k, scale=D**-0.5, causal=causal
+            )
+            self.assertEqual(out.shape, q.shape)
+            for i in range(len(q_lens)):
+                ref = mlx_ref_attn(
+                    seq(q, cu_q, i),
+                    seq(k, cu_k, i),
+                    seq(v, cu_k, i),
+                    scale=D**-0.5,
+                    mask="causal" if causal else None,
+                )
+                self.assertTrue(mx.allclose(ref, seq(out, cu_q, i), atol=1e-2))
+
+        x = mx.random.normal(shape=(sum(q_lens), n_heads, D))
+        out = mx.fast.rope_varlen(
+            x, D, traditional=False, base=10000.0, scale=1.0, cu_seqlens=cu_q
+        )
+        for i in range(len(q_lens)):
+            ref = mx.fast.rope(
+                seq(x, cu_q, i),
+                D,
+                traditional=False,
+                base=10000.0,
+                scale=1.0,
+                offset=0,
+            )
+            self.assertTrue(mx.allclose(ref, seq(out, cu_q, i), atol=1e-5))
+
+    def test_quantized_sdpa(self):
+        B, n_heads, n_kv_heads, S, D = 2, 4, 2, 64, 128
+        for bits in (4, 8):
+            for group_size in (32, 64):
+                cache = mx.zeros((B, n_kv_heads, S, D * bits // 32), mx.uint32)
+                scales = mx.zeros((B, n_kv_heads, S, D // group_size))
+                biases = mx.zeros((B, n_kv_heads, S, D // group_size))
+
+                x = mx.random.normal(shape=(B, n_kv_heads, 10, D))
+                cache, scales, biases = mx.fast.quantized_kv_write(
+                    cache,
+                    scales,
+                    biases,
+                    x,
+                    offset=3,
+                    group_size=group_size,
+                    bits=bits,
+                )
+                xq, xs, xb = mx.quantize(x, group_size=group_size, bits=bits)
+                self.assertTrue(mx.array_equal(cache[:, :, 3:13], xq))
+                self.assertTrue(mx.allclose(scales[:, :, 3:13], xs))
+                self.assertTrue(mx.allclose(biases[:, :, 3:13], xb))
+                self.assertTrue(mx.all(cache[:, :, :3] == 0))
+
+                k = cache[:, :, :13], scales[:, :, :13], biases[:, :, :13]
+                v = tuple(mx.array(a) for a in k)
+                q = mx.random.normal(shape=(B, n_heads, 1, D))
+                k_ref = mx.dequantize(*k, group_size=group_size, bits=bits)
+                v_ref = mx.dequantize(*v, group_size=group_size, bits=bits)
+                for mask in (None, "causal"):
+                    out = mx.fast.quantized_scaled_dot_product_attention(
+                        q,
+                        *k,
+                        *v,
+                        scale=D**-0.5,
+                        mask=mask,
+                        group_size=group_size,
+                        bits=bits,
+                    )
+                    ref = mlx_ref_attn(q, k_ref, v_ref, scale=D**-0.5, mask=mask)
+                    self.assertTrue(mx.allclose(ref, out, atol=1e-4, rtol=1e-4))
+
 
 class TestSDPA(mlx_tests.MLXTestCase):
     @property
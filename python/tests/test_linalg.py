@@ -182,6 +182,24 @@ class TestLinalg(mlx_tests.MLXTestCase):
                 mx.allclose(M @ M_inv, mx.eye(M.shape[0]), rtol=0, atol=1e-5)
             )
 
+    def test_batched_small_factorizations(self):
+        # Batches of small matrices are split between the threads and
+        # inverted or factorized several at a time.
+        mx.random.seed(3)
+        for N in (1, 2, 3, 4, 6):
+            A = mx.random.normal((37, N, N))
+            A_inv = mx.linalg.inv(A, stream=mx.cpu)
+            eye = mx.broadcast_to(mx.eye(N), A.shape)
+            self.assertTrue(mx.allclose(A @ A_inv, eye, rtol=0, atol=1e-4))
+
+            S = A @ A.swapaxes(-1, -2) + N * eye
+            L = mx.linalg.cholesky(S, stream=mx.cpu)
+            U = mx.linalg.cholesky(S, upper=True, stream=mx.cpu)
+            self.assertTrue(mx.all(L == mx.tril(L)))
+            self.assertTrue(mx.all(U == mx.triu(U)))
+            self.assertTrue(mx.allclose(L @ L.swapaxes(-1, -2), S, atol=1e-4))
+            self.assertTrue(mx.allclose(U.swapaxes(-1, -2) @ U, S, atol=1e-4))
+
     def test_tri_inverse(self):
         for upper in (False, True):
             A = mx.array([[1, 0, 0], [6, -5, 0], [-9, 8, 7]], dtype=mx.float32)
@@ -400,6 +418,13 @@ class TestLinalg(mlx_tests.MLXTestCase):
         A_np = A_np + A_np.T.conj()
         check_eigs_and_vecs(A_np)
 
+        # The complex matrices are not supported on the GPU
+        if mx.is_available(mx.gpu):
+            with self.assertRaises(ValueError):
+                mx.linalg.eigh(mx.array(A_np), stream=mx.gpu)
+            with self.assertRaises(ValueError):
+                mx.linalg.eigvalsh(mx.array(A_np), stream=mx.gpu)
+
         # Test error cases
         with self.assertRaises(ValueError):
             mx.linalg.eigh(mx.array([1.0, 2.0]))  # 1D array
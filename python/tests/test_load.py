@@ -400,6 +400,31 @@ class TestLoad(mlx_tests.MLXTestCase):
 
         self.assertEqual(load_only, load_with_binary)
 
+    def test_prefetch(self):
+        save_file = os.path.join(self.test_dir, "prefetch.safetensors")
+        layers = {f"layer_{i}": mx.random.normal((64, 64)) for i in range(4)}
+        mx.save_safetensors(save_file, layers)
+
+        for max_bytes in [None, 0, 2 * 64 * 64 * 4]:
+            weights = mx.load(save_file)
+            params = [weights[f"layer_{i}"] for i in range(4)]
+            y = mx.ones((64,))
+            for w in params:
+                y = w @ y
+            mx.prefetch(params, max_bytes).wait()
+            expected = mx.ones((64,))
+            for i in range(4):
+                expected = layers[f"layer_{i}"] @ expected
+            self.assertTrue(mx.allclose(y, expected, atol=1e-3, rtol=1e-3))
+
+        # The loads are moved to the given device and the other leaves of
+        # a tree are ignored.
+        weights = mx.load(save_file)
+        future = mx.prefetch({"w": weights, "n": 3}, stream=mx.cpu)
+        future.wait()
+        for name, w in weights.items():
+            self.assertTrue(mx.array_equal(w, layers[name]))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
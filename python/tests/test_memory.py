@@ -1,9 +1,15 @@
 # Copyright © 2023-2024 Apple Inc.
 
+import json
+import os
+import subprocess
+import sys
+import tempfile
 import unittest
 
 import mlx.core as mx
 import mlx_tests
+import numpy as np
 
 
 class TestMemory(mlx_tests.MLXTestCase):
@@ -48,6 +54,24 @@ class TestMemory(mlx_tests.MLXTestCase):
         mx.reset_peak_memory()
         self.assertEqual(mx.get_peak_memory(), 0)
 
+    def test_cache_info(self):
+        mx.clear_cache()
+        mx.reset_cache_info()
+        for _ in range(3):
+            a = mx.zeros((4096,))
+            mx.eval(a)
+            del a
+        mx.clear_cache()
+        info = mx.get_cache_info()
+        self.assertGreater(info["hits"], 0)
+        self.assertGreater(info["misses"], 0)
+        self.assertGreater(info["evictions"], 0)
+        self.assertGreaterEqual(info["reused_bytes"], info["requested_bytes"])
+        self.assertLess(info["reused_bytes"], 2 * info["requested_bytes"])
+
+        mx.reset_cache_info()
+        self.assertEqual(mx.get_cache_info()["hits"], 0)
+
     @unittest.skipIf(not mx.metal.is_available(), "Metal is not available")
     def test_wired_memory(self):
         old_limit = mx.set_wired_limit(1000)
@@ -58,6 +82,188 @@ class TestMemory(mlx_tests.MLXTestCase):
         with self.assertRaises(ValueError):
             mx.set_wired_limit(max_size + 10)
 
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_graph_cache_info(self):
+        mx.cuda.reset_graph_cache_info()
+        a = mx.ones((8,))
+        for _ in range(3):
+            mx.eval(a + 1)
+        info = mx.cuda.graph_cache_info()
+        self.assertGreater(info["hits"], 0)
+        self.assertGreater(info["misses"], 0)
+        self.assertGreaterEqual(info["instantiations"], info["misses"])
+        self.assertGreater(info["capacity"], 0)
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_dispatch_info(self):
+        a = mx.ones((16,))
+        mx.eval(a)
+        mx.synchronize()
+        mx.cuda.reset_dispatch_info()
+        for _ in range(10):
+            a = a + 1
+        mx.eval(a)
+        mx.synchronize()
+        info = mx.cuda.dispatch_info()
+        self.assertGreaterEqual(info["evals"], 10)
+        self.assertGreaterEqual(info["nodes"], 10)
+        self.assertGreaterEqual(info["graphs"], 1)
+        self.assertGreater(info["dispatch_us"], 0)
+        self.assertGreater(info["launch_us"], 0)
+
+        mx.cuda.reset_dispatch_info()
+        self.assertEqual(mx.cuda.dispatch_info()["evals"], 0)
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_prefetch(self):
+        w = mx.random.normal((512, 512))
+        x = mx.ones((512, 512))
+        mx.cuda.set_read_mostly([w])
+        mx.cuda.prefetch([w, x])
+        y = w @ x
+        mx.cuda.prefetch([y], to_host=True)
+        self.assertTrue(mx.allclose(y, w.sum(axis=1, keepdims=True) * x))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_l2_persisting(self):
+        norm = mx.random.normal((1024,))
+        w = mx.random.normal((1024, 1024))
+        x = mx.random.normal((4, 1024))
+        expected = (x * norm) @ w
+        mx.cuda.set_l2_persisting([norm])
+        for _ in range(3):
+            self.assertTrue(mx.allclose((x * norm) @ w, expected))
+        mx.cuda.set_l2_persisting([norm], persisting=False)
+        self.assertTrue(mx.allclose((x * norm) @ w, expected))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_offload(self):
+        layers = [mx.random.normal((256, 256)) for _ in range(4)]
+        x = mx.random.normal((8, 256))
+        expected = x
+        for w in layers:
+            expected = expected @ w
+        mx.eval(expected)
+
+        mx.cuda.offload([[w] for w in layers], ahead=1)
+        for _ in range(2):
+            y = x
+            for w in layers:
+                y = y @ w
+            self.assertTrue(mx.allclose(y, expected, rtol=1e-4, atol=1e-4))
+        mx.cuda.offload([])
+
+    def test_batch_prefetcher(self):
+        def loader():
+            for i in range(5):
+                x = np.full((64, 32), i, dtype=np.float32)
+                yield {"x": x, "y": mx.arange(4) + i, "index": i}
+
+        batches = list(mx.cuda.BatchPrefetcher(loader(), ahead=2))
+        self.assertEqual(len(batches), 5)
+        for i, batch in enumerate(batches):
+            self.assertEqual(batch["index"], i)
+            self.assertEqual(batch["x"].dtype, mx.float32)
+            self.assertTrue(mx.array_equal(batch["x"], mx.full((64, 32), i)))
+            self.assertEqual((batch["y"] * 2).tolist(), [2 * (j + i) for j in range(4)])
+
+        self.assertEqual(list(mx.cuda.BatchPrefetcher([])), [])
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_ipc(self):
+        x = mx.arange(12, dtype=mx.float32).reshape(3, 4) * 2
+        shared, handle = mx.cuda.ipc_export(x)
+        self.assertEqual(shared.shape, x.shape)
+        self.assertTrue(mx.array_equal(shared + 0, x))
+
+        # The memory can only be mapped by another process
+        script = (
+            "import sys; import mlx.core as mx; "
+            "y = mx.cuda.ipc_import(bytes.fromhex(sys.argv[1])); "
+            "print(y.shape, (y + 1).sum().item())"
+        )
+        out = subprocess.run(
+            [sys.executable, "-c", script, handle.hex()],
+            capture_output=True,
+            text=True,
+            check=True,
+        ).stdout
+        self.assertEqual(out.split(), ["(3,", "4)", "144.0"])
+
+        with self.assertRaises(ValueError):
+            mx.cuda.ipc_import(b"invalid")
+
+    def test_growable_array(self):
+        a = mx.cuda.GrowableArray((3, 4), mx.float32, 64)
+        self.assertEqual(len(a), 0)
+        self.assertEqual(a.max_length, 64)
+        self.assertEqual(a.data().shape, (0, 3, 4))
+
+        rows = [mx.random.normal((n, 3, 4)) for n in [1, 5, 2]]
+        for i, x in enumerate(rows):
+            a.append(x)
+            expected = mx.concatenate(rows[: i + 1])
+            self.assertEqual(len(a), expected.shape[0])
+            self.assertTrue(mx.array_equal(a.data(), expected))
+
+        # The rows can be transposed when appended
+        x = mx.random.normal((4, 3, 2)).transpose(2, 1, 0)
+        a.append(x)
+        self.assertTrue(mx.array_equal(a.data()[-2:], x))
+
+        with self.assertRaises(ValueError):
+            a.append(mx.zeros((64, 3, 4)))
+        with self.assertRaises(ValueError):
+            a.append(mx.zeros((1, 4, 3)))
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_profiling(self):
+        a = mx.ones((1024, 1024))
+        mx.eval(a)
+        mx.cuda.start_profiling()
+        for _ in range(3):
+            mx.eval(a + 1)
+        mx.cuda.stop_profiling()
+        mx.eval(a + 2)
+        info = mx.cuda.profiling_info()
+        self.assertEqual(info["Add"]["count"], 3)
+        self.assertGreater(info["Add"]["time_ms"], 0)
+        self.assertGreaterEqual(info["Add"]["bytes"], 3 * 2 * a.nbytes)
+        self.assertGreater(info["Add"]["bandwidth_gbps"], 0)
+
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "trace.json")
+            mx.cuda.save_profiling_trace(path)
+            with open(path) as f:
+                events = json.load(f)["traceEvents"]
+        self.assertEqual(len(events), 3)
+        self.assertEqual(events[0]["name"], "Add")
+        self.assertEqual(events[0]["ph"], "X")
+
+    @unittest.skipIf(not mx.cuda.is_available(), "CUDA is not available")
+    def test_memory_tracing(self):
+        a = mx.ones((1024, 1024))
+        mx.eval(a)
+        mx.cuda.start_memory_tracing()
+        b = mx.exp(a)
+        c = b @ b
+        mx.eval(c)
+        del b
+        mx.cuda.stop_memory_tracing()
+        peak = dict(mx.cuda.memory_trace_peak(-1))
+        self.assertGreaterEqual(peak["Exp"], a.nbytes)
+        self.assertGreaterEqual(peak["Matmul"], a.nbytes)
+
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "memory.json")
+            mx.cuda.save_memory_trace(path)
+            with open(path) as f:
+                trace = json.load(f)
+        self.assertGreaterEqual(trace["peak_memory"], 2 * a.nbytes)
+        tags = {r["tag"] for r in trace["allocations"]}
+        self.assertIn("Exp", tags)
+        self.assertIn("Matmul", tags)
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
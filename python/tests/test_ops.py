@@ -231,6 +231,39 @@ class TestOps(mlx_tests.MLXTestCase):
         self.assertEqual(z.dtype, mx.float32)
         self.assertEqual(z.item(), 4)
 
+    def test_add_inplace(self):
+        x = mx.ones((4, 4))
+        mx.eval(x)
+        x = mx.add_inplace(x, mx.full((4,), 2.0))
+        self.assertTrue(mx.array_equal(x, mx.full((4, 4), 3.0)))
+
+        # Accumulate without keeping the previous sums
+        acc = mx.zeros((8,))
+        for i in range(4):
+            acc = mx.add_inplace(acc, mx.ones((8,)))
+            mx.eval(acc)
+        self.assertTrue(mx.array_equal(acc, mx.full((8,), 4.0)))
+
+        # The scalars are updated in place too
+        acc = mx.array(0.0)
+        for i in range(4):
+            acc = mx.add_inplace(acc, 1.0)
+            mx.eval(acc)
+        self.assertEqual(acc.item(), 4.0)
+
+        x = mx.add_inplace(mx.ones((2,), mx.float16), 1)
+        self.assertEqual(x.dtype, mx.float16)
+
+        with self.assertRaises(ValueError):
+            mx.add_inplace(mx.ones((4,)), mx.ones((2, 4)))
+
+        # The first input is still referenced
+        y = mx.ones((4,))
+        mx.eval(y)
+        z = mx.add_inplace(y, 1)
+        with self.assertRaises(RuntimeError):
+            mx.eval(z)
+
     def test_subtract(self):
         x = mx.array(4.0)
         y = mx.array(3.0)
@@ -597,6 +630,21 @@ class TestOps(mlx_tests.MLXTestCase):
 
         self.assertListEqual(mx.transpose(x, axes=(0, 2, 1)).tolist(), expected)
 
+    def test_transpose_large(self):
+        np.random.seed(0)
+        for shape in [(64, 96), (33, 67), (3, 128, 40), (5, 31, 130)]:
+            x_np = np.random.randint(-100, 100, shape)
+            axes = (1, 0) if len(shape) == 2 else (0, 2, 1)
+            for dt in ["int8", "float16", "float32", "int64"]:
+                x = mx.array(x_np.astype(dt))
+                y = mx.contiguous(mx.transpose(x, axes))
+                self.assertTrue(np.array_equal(y, x_np.transpose(axes)))
+                y = mx.transpose(x, axes).astype(mx.float32)
+                self.assertTrue(np.array_equal(y, x_np.transpose(axes)))
+                y = mx.contiguous(mx.transpose(x[..., 1:, ::2], axes))
+                ref = x_np[..., 1:, ::2].transpose(axes)
+                self.assertTrue(np.array_equal(y, ref))
+
     def test_move_swap_axes(self):
         x = mx.zeros((2, 3, 4))
         self.assertEqual(mx.moveaxis(x, 0, 2).shape, (3, 4, 2))
@@ -760,6 +808,13 @@ class TestOps(mlx_tests.MLXTestCase):
         x = mx.broadcast_to(mx.random.uniform(shape=(2, 1, 8)), (2, 2, 8))
         self.assertTrue(mx.allclose(mx.logsumexp(x), logsumexp(x)))
 
+        # Few very long rows
+        for shape in [(1, 262144), (3, 100003)]:
+            x = 10 * mx.random.normal(shape=shape)
+            self.assertTrue(
+                mx.allclose(mx.logsumexp(x, axis=-1), logsumexp(x, axes=-1)[:, 0])
+            )
+
     def test_mean(self):
         x = mx.array(
             [
@@ -1203,6 +1258,26 @@ class TestOps(mlx_tests.MLXTestCase):
         out = mx.take(a, mx.array([[1]]), axis=0)
         self.assertEqual(out.shape, (1, 1, 4))
 
+        # Whole rows, like the lookup of an embedding table
+        for shape, dtype in [
+            ((100, 64), mx.float32),
+            ((100, 3), mx.float16),
+            ((50, 4, 5), mx.int8),
+            ((7,), mx.float32),
+        ]:
+            table = mx.random.normal(shape=shape).astype(dtype)
+            table_npy = np.array(table)
+            idx = mx.random.randint(-shape[0], shape[0], shape=(3, 9))
+            idx_npy = np.array(idx)
+            expected = np.take(table_npy, idx_npy, axis=0)
+            self.assertTrue(np.array_equal(mx.take(table, idx, axis=0), expected))
+            # Strided indices and rows
+            out = mx.take(table, idx.T, axis=0)
+            self.assertTrue(np.array_equal(out, expected.swapaxes(0, 1)))
+            out = mx.take(table[1::3], idx[:, :4] % 2, axis=0)
+            expected = np.take(table_npy[1::3], idx_npy[:, :4] % 2, axis=0)
+            self.assertTrue(np.array_equal(out, expected))
+
     def test_take_along_axis(self):
         a_np = np.arange(8).reshape(2, 2, 2)
         a_mlx = mx.array(a_np)
@@ -1261,6 +1336,99 @@ class TestOps(mlx_tests.MLXTestCase):
         self.assertEqual(b.size, 0)
         self.assertEqual(b.shape, a.shape)
 
+    def test_scatter_add_repeated_indices(self):
+        np.random.seed(0)
+        idx_np = np.random.randint(0, 8, size=(8192,))
+        idx_np[:3000] = 3
+        upd_np = np.random.randint(-2, 3, size=(8192, 96)).astype(np.float32)
+        out_np = np.zeros((64, 96), np.float32)
+        np.add.at(out_np, idx_np, upd_np)
+        for dt in [mx.float32, mx.float16]:
+            out = mx.zeros((64, 96), dt)
+            out = out.at[mx.array(idx_np)].add(mx.array(upd_np).astype(dt))
+            self.assertTrue(np.array_equal(out.astype(mx.float32), out_np))
+
+        # The vjp of take_along_axis scatters along an axis
+        x = mx.zeros((16, 64))
+        idx_np = np.random.randint(0, 4, size=(16, 1024))
+        idx = mx.array(idx_np)
+        grad = mx.grad(lambda x: mx.take_along_axis(x, idx, axis=1).sum())(x)
+        grad_np = np.zeros((16, 64), np.float32)
+        np.add.at(grad_np, (np.arange(16)[:, None], idx_np), 1)
+        self.assertTrue(np.array_equal(grad, grad_np))
+
+    def test_bincount(self):
+        np.random.seed(0)
+        for length in [8, 300, 2000, 10000]:
+            x_np = np.random.randint(-2, length + 2, size=(4, 4096))
+            x_np[:, :1000] = 3
+            in_range = (x_np >= 0) & (x_np < length)
+            expected = np.bincount(x_np[in_range], minlength=length)
+            x = mx.array(x_np)
+            out = mx.bincount(x, length)
+            self.assertEqual(out.dtype, mx.int32)
+            self.assertTrue(np.array_equal(out, expected))
+
+            w_np = np.random.randint(-2, 3, size=x_np.shape)
+            expected = np.bincount(
+                x_np[in_range], weights=w_np[in_range], minlength=length
+            )
+            for dt in [mx.float32, mx.float16, mx.int32, mx.int64]:
+                out = mx.bincount(x, length, mx.array(w_np).astype(dt))
+                self.assertTrue(np.array_equal(out.astype(mx.float32), expected))
+        self.assertEqual(mx.bincount(x, length, mx.ones(x.shape)).dtype, mx.float32)
+        self.assertEqual(mx.bincount(mx.array([], mx.int32), 3).tolist(), [0, 0, 0])
+        self.assertEqual(mx.bincount(mx.array([1, 2]), 0).shape, (0,))
+
+        # The weights get the cotangents of their bins.
+        x = mx.array([0, 2, 2, 5, -1])
+        w = mx.ones((5,))
+        cotan = mx.array([1.0, 2.0, 3.0])
+        _, vjps = mx.vjp(lambda w: mx.bincount(x, 3, w), [w], [cotan])
+        self.assertEqual(vjps[0].tolist(), [1.0, 3.0, 3.0, 0.0, 0.0])
+
+        with self.assertRaises(ValueError):
+            mx.bincount(mx.array([1.0]), 2)
+        with self.assertRaises(ValueError):
+            mx.bincount(mx.array([1]), 2, mx.ones((2,)))
+
+    def test_unique(self):
+        np.random.seed(0)
+        for dt in ["int32", "uint8", "int64", "float32", "float16", "bool"]:
+            x_np = np.random.randint(0, 20, size=(3, 500)).astype(dt)
+            x = mx.array(x_np)
+            values, n, inverse, counts = mx.unique(x, True, True)
+            e_values, e_inverse, e_counts = np.unique(
+                x_np, return_inverse=True, return_counts=True
+            )
+            k = len(e_values)
+            self.assertEqual(n.item(), k)
+            self.assertEqual(values.dtype, x.dtype)
+            self.assertEqual(inverse.shape, x.shape)
+            self.assertTrue(np.array_equal(values[:k], e_values))
+            self.assertTrue(np.all(np.array(values[k:]) == e_values[-1]))
+            self.assertTrue(np.array_equal(inverse.flatten(), e_inverse.flatten()))
+            self.assertTrue(np.array_equal(counts[:k], e_counts))
+            self.assertEqual(counts[k:].sum().item(), 0)
+
+        x = mx.array([2.0, float("nan"), 1.0, 2.0, float("nan")])
+        values, n = mx.unique(x)
+        self.assertEqual(n.item(), 4)
+        self.assertEqual(values[:2].tolist(), [1.0, 2.0])
+        self.assertTrue(mx.isnan(values[2:4]).all().item())
+
+        values, n, counts = mx.unique(mx.array([5, 5, 5]), return_counts=True)
+        self.assertEqual(values.tolist(), [5, 5, 5])
+        self.assertEqual(n.item(), 1)
+        self.assertEqual(counts.tolist(), [3, 0, 0])
+
+        values, n = mx.unique(mx.array([], mx.float32))
+        self.assertEqual(values.shape, (0,))
+        self.assertEqual(n.item(), 0)
+
+        with self.assertRaises(ValueError):
+            mx.unique(mx.array([1 + 1j]))
+
     def test_split(self):
         a = mx.array([1, 2, 3])
         splits = mx.split(a, 3)
@@ -1726,6 +1894,17 @@ class TestOps(mlx_tests.MLXTestCase):
             x = mx.full((n,), vals=-float("inf"))
             self.assertTrue(mx.all(mx.isnan(mx.softmax(x))))
 
+        # Few very long rows
+        for shape in [(1, 262144), (3, 100003)]:
+            a_npy = np.random.randn(*shape).astype(np.float32)
+            b_mlx = mx.softmax(mx.array(a_npy), axis=-1)
+            self.assertTrue(np.allclose(np_softmax(a_npy, -1), b_mlx, atol=1e-6))
+        a = np.full(200000, -np.inf)
+        a[123456] = 0.0
+        a = mx.softmax(mx.array(a))
+        self.assertFalse(np.any(np.isnan(a)))
+        self.assertEqual(a[123456], 1)
+
         # Transposed inputs
         a = mx.random.uniform(shape=(32, 32, 32))
         b = mx.softmax(a, axis=-1)
@@ -1759,6 +1938,15 @@ class TestOps(mlx_tests.MLXTestCase):
         out = mx.concatenate([a, b], axis=1)
         self.assertTrue(mx.array_equal(out, b))
 
+        # Concatenate more inputs than a single kernel copies
+        xs = [mx.arange(15 * (i % 4)).reshape(5, i % 4, 3) for i in range(40)]
+        xs = [x.T if i % 3 else x.T.reshape(3, -1, 5) for i, x in enumerate(xs)]
+        for dtype in (mx.uint8, mx.float16, mx.int32, mx.complex64):
+            out = mx.concatenate([x.astype(dtype) for x in xs], axis=1)
+            expected = np.concatenate([np.array(x) for x in xs], axis=1)
+            self.assertEqual(out.dtype, dtype)
+            self.assertTrue(np.array_equal(out, expected))
+
     def test_meshgrid(self):
         x = mx.array([1, 2, 3], dtype=mx.int32)
         y = np.array([1, 2, 3], dtype=np.int32)
@@ -2046,6 +2234,34 @@ class TestOps(mlx_tests.MLXTestCase):
             expected = mx.repeat(expected[:, None], 2, axis=1)
             self.assertTrue(mx.array_equal(expected, out))
 
+        # Single long rows, strided and reversed
+        s = 100003
+        a = mx.random.randint(-100, 100, (2 * s,))
+        npa = np.array(a)
+        for x, npx in [(a[:s], npa[:s]), (a[::2], npa[::2]), (a[::-2], npa[::-2])]:
+            out = mx.cumsum(x)
+            self.assertTrue(np.array_equal(np.cumsum(npx), out))
+            out = mx.cumsum(x, inclusive=False)
+            self.assertTrue(np.array_equal(np.cumsum(npx)[:-1], out[1:]))
+            self.assertEqual(out[0].item(), 0)
+            out = mx.cummax(x, reverse=True)
+            self.assertTrue(
+                np.array_equal(np.maximum.accumulate(npx[::-1])[::-1], out)
+            )
+        out = mx.cumsum(mx.ones((s,), mx.bool_))
+        self.assertTrue(mx.array_equal(out, mx.arange(1, s + 1, dtype=mx.int32)))
+
+        # Rows long enough to be scanned in chunks on the CPU
+        s = 300007
+        npx = np.random.randint(-100, 100, (s,)).astype(np.int32)
+        x = mx.array(npx)
+        with mx.stream(mx.cpu):
+            out = mx.cumsum(x, reverse=True, inclusive=False)
+            self.assertTrue(np.array_equal(np.cumsum(npx[::-1])[::-1][1:], out[:-1]))
+            self.assertEqual(out[-1].item(), 0)
+            out = mx.cummin(x)
+            self.assertTrue(np.array_equal(np.minimum.accumulate(npx), out))
+
         # Test donation
         def fn(its):
             x = mx.ones((32,))
@@ -2176,6 +2392,24 @@ class TestOps(mlx_tests.MLXTestCase):
             b_mx = mx.sort(a_mx)
             self.assertTrue(np.array_equal(b_np, b_mx))
 
+            a_np = np.random.permutation(2**22).astype(np.int32)
+            c_mx = mx.argsort(mx.array(a_np))
+            self.assertTrue(np.array_equal(np.argsort(a_np), c_mx))
+
+        # Sort along strided axes of every kind of dtype
+        for dtype in ("bool", "uint8", "int16", "float16", "bfloat16", "int64"):
+            a_np = np.random.randint(0, 100, size=(40, 300, 3))
+            a_mx = mx.array(a_np).astype(getattr(mx, dtype))
+            a_np = np.array(a_mx.astype(mx.int64))
+            for axis in (0, 1):
+                b_mx = mx.sort(a_mx, axis=axis)
+                self.assertEqual(b_mx.dtype, a_mx.dtype)
+                b_mx = b_mx.astype(mx.int64)
+                self.assertTrue(np.array_equal(np.sort(a_np, axis=axis), b_mx))
+                c_np = np.argsort(a_np, axis=axis, kind="stable")
+                c_mx = mx.argsort(a_mx, axis=axis)
+                self.assertTrue(np.array_equal(c_np, c_mx))
+
         # 1D strided sort
         a = mx.array([[4, 3], [2, 1], [5, 4], [3, 2]])
         out = mx.argsort(a[:, 1])
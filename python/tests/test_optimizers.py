@@ -391,6 +391,37 @@ class TestOptimizers(mlx_tests.MLXTestCase):
         )
         self.assertTrue(mx.allclose(impure_params["bias"], uncompiled_params["bias"]))
 
+    def test_fused_update(self):
+        # The fused update matches the update of each parameter
+        params = {
+            "w": [mx.random.normal((10, 4)), mx.random.normal((4,))],
+            "h": mx.random.normal((3,)).astype(mx.float16),
+        }
+        grads = tree_map(lambda x: mx.random.normal(x.shape).astype(x.dtype), params)
+        optimizers = [
+            lambda: opt.SGD(0.1, momentum=0.9, weight_decay=0.01),
+            lambda: opt.SGD(0.1),
+            lambda: opt.Adam(0.1, bias_correction=True),
+            lambda: opt.AdamW(0.1),
+            lambda: opt.Lion(0.1, weight_decay=0.1),
+        ]
+        for make in optimizers:
+            fused = make()
+            unfused = make()
+            unfused._apply_all = partial(opt.Optimizer._apply_all, unfused)
+            for _ in range(2):
+                p1 = fused.apply_gradients(grads, params)
+                p2 = unfused.apply_gradients(grads, params)
+                self.assertTrue(
+                    tree_equal(
+                        lambda a, b: a.dtype == b.dtype
+                        and mx.allclose(a, b, atol=1e-2, rtol=1e-2),
+                        p1,
+                        p2,
+                    )
+                )
+                params = p1
+
     def test_update_lr_compiled(self):
         params = {"w": mx.ones((5, 5))}
         grads = tree_map(lambda x: mx.ones_like(x), params)
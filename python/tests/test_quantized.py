@@ -27,6 +27,53 @@ class TestQuantized(mlx_tests.MLXTestCase):
                 a_hat = mx.dequantize(w_q, scales, biases, gs, b)
                 self.assertTrue(mx.all(a_hat == 0))
 
+    def test_block_scaled_quantize(self):
+        # The e2m1 values and the ties which round to even
+        w = mx.array(
+            [0.0, 0.5, 1.0, 1.5, 2.0, 3.0, 4.0, 6.0, -0.5, -6.0, 0.25, 0.75]
+            + [1.25, 1.75, 2.5, 3.5, 5.0, 7.0]
+            + [1.0] * 14
+        ).reshape(1, 32)
+        w_q, scales = mx.quantize(w, mode="mxfp4")
+        self.assertEqual(w_q.shape, (1, 4))
+        self.assertEqual(scales.dtype, mx.uint8)
+        self.assertEqual(scales.item(), 127)
+        w_hat = mx.dequantize(w_q, scales, mode="mxfp4", dtype=mx.float32)
+        expected = mx.array(
+            [0.0, 0.5, 1.0, 1.5, 2.0, 3.0, 4.0, 6.0, -0.5, -6.0, 0.0, 1.0]
+            + [1.0, 2.0, 2.0, 4.0, 4.0, 6.0]
+            + [1.0] * 14
+        ).reshape(1, 32)
+        self.assertTrue(mx.array_equal(w_hat, expected))
+
+        w = mx.random.normal(shape=(128, 512))
+        for mode, gs, bits, tol in [
+            ("mxfp4", 32, 4, 0.26),
+            ("nvfp4", 16, 4, 0.2),
+            ("mxfp8", 32, 8, 0.13),
+        ]:
+            with self.subTest(mode=mode):
+                w_q, scales = mx.quantize(w, mode=mode)
+                self.assertEqual(w_q.shape, (128, 512 * bits // 32))
+                self.assertEqual(scales.shape, (128, 512 // gs))
+                w_hat = mx.dequantize(w_q, scales, mode=mode, dtype=mx.float32)
+                errors = (w - w_hat).abs().reshape(*scales.shape, -1)
+                amax = w.abs().reshape(*scales.shape, -1).max(axis=-1)
+                self.assertTrue((errors.max(axis=-1) <= tol * amax).all())
+
+                x = mx.random.normal(shape=(4, 512))
+                y = mx.quantized_matmul(x, w_q, scales, mode=mode)
+                self.assertTrue(mx.allclose(y, x @ w_hat.T, atol=1e-4))
+
+                a_q, a_scales = mx.quantize(mx.zeros((32, 64)), mode=mode)
+                a_hat = mx.dequantize(a_q, a_scales, mode=mode)
+                self.assertTrue(mx.all(a_hat == 0))
+
+        with self.assertRaises(ValueError):
+            mx.quantize(w, group_size=64, mode="mxfp4")
+        with self.assertRaises(ValueError):
+            mx.quantize(w, mode="int4")
+
     def test_qmm(self):
         key = mx.random.key(0)
         k1, k2 = mx.random.split(key)
@@ -168,6 +215,16 @@ class TestQuantized(mlx_tests.MLXTestCase):
                 self.assertEqual(y_q.shape, y_hat.shape)
                 self.assertLess((y_q - y_hat).abs().max(), 1e-3)
 
+    def test_qmv_large_batch(self):
+        # More batch elements than the grid holds in one launch.
+        w = mx.random.normal((64, 64))
+        w_q, scales, biases = mx.quantize(w, 64, 4)
+        w_hat = mx.dequantize(w_q, scales, biases, 64, 4)
+        for x_shape in [(70000, 1, 64), (70000, 8, 64)]:
+            x = mx.random.normal(x_shape)
+            y_q = mx.quantized_matmul(x, w_q, scales, biases, True, 64, 4)
+            self.assertTrue(mx.allclose(y_q, x @ w_hat.T, atol=1e-3, rtol=1e-3))
+
     def test_qvm(self):
         key = mx.random.key(0)
         k1, k2 = mx.random.split(key)
@@ -617,6 +674,110 @@ class TestQuantized(mlx_tests.MLXTestCase):
                 num_ds = (out_up - out_down) / (2 * eps)
                 self.assertAlmostEqual(dparams[p][idx], num_ds, delta=2e-2)
 
+    def test_fp8(self):
+        # All the float8 values survive a round trip
+        codes = mx.arange(256).astype(mx.uint8)
+        self.assertTrue(mx.array_equal(mx.to_fp8(mx.from_fp8(codes)), codes))
+
+        x = mx.array([1000.0, -1000.0, 17.0, 0.3, 0.0])
+        expected = mx.array([448.0, -448.0, 16.0, 0.3125, 0.0])
+        out = mx.from_fp8(mx.to_fp8(x), mx.float32)
+        self.assertTrue(mx.array_equal(out, expected))
+
+        # The e5m2 values other than NaN survive a round trip
+        values = mx.from_fp8(codes, mx.float32, format="e5m2")
+        out = mx.to_fp8(values, format="e5m2")
+        out = mx.where(mx.isnan(values), codes, out)
+        self.assertTrue(mx.array_equal(out, codes))
+
+        x = mx.array([1e5, -60000.0, 17.0, 0.3, 1e-6, 0.0])
+        expected = mx.array([float("inf"), -57344.0, 16.0, 0.3125, 0.0, 0.0])
+        out = mx.from_fp8(mx.to_fp8(x, format="e5m2"), format="e5m2")
+        self.assertTrue(mx.array_equal(out.astype(mx.float32), expected))
+
+        with self.assertRaises(ValueError):
+            mx.to_fp8(x, format="e3m4")
+
+    def test_fp8_matmul(self):
+        w = mx.random.normal(shape=(64, 128))
+        w_q = mx.to_fp8(w)
+        for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+            for scales in [mx.array([0.5]), mx.random.uniform(shape=(64,))]:
+                with self.subTest(dtype=dtype, per_channel=scales.size > 1):
+                    x = mx.random.normal(shape=(2, 16, 128)).astype(dtype)
+                    out = mx.fast.fp8_matmul(x, w_q, scales)
+                    w_hat = mx.from_fp8(w_q, mx.float32) * scales[:, None]
+                    expected = x.astype(mx.float32) @ w_hat.T
+                    self.assertEqual(out.dtype, dtype)
+                    self.assertEqual(out.shape, (2, 16, 64))
+                    # x is also quantized to float8 on the fast path
+                    tol = 0.1 * mx.abs(expected).max().item()
+                    self.assertTrue(mx.allclose(out, expected, atol=tol))
+
+    def test_int8_matmul(self):
+        w = mx.random.normal(shape=(64, 128))
+        w_q, scales = mx.quantize(w, mode="int8")
+        self.assertEqual(w_q.dtype, mx.int8)
+        self.assertEqual(scales.shape, (64, 1))
+        w_hat = mx.dequantize(w_q, scales, mode="int8")
+        self.assertTrue(mx.allclose(w, w_hat, atol=scales.max().item()))
+
+        for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+            with self.subTest(dtype=dtype):
+                x = mx.random.normal(shape=(2, 16, 128)).astype(dtype)
+                out = mx.quantized_matmul(x, w_q, scales, mode="int8")
+                expected = x.astype(mx.float32) @ w_hat.T
+                self.assertEqual(out.dtype, dtype)
+                self.assertEqual(out.shape, (2, 16, 64))
+                # x is also quantized to int8
+                tol = 0.05 * mx.abs(expected).max().item()
+                self.assertTrue(mx.allclose(out, expected, atol=tol))
+
+        # Per-tensor scale
+        x = mx.random.normal(shape=(4, 128))
+        out = mx.fast.int8_matmul(x, w_q, mx.array([0.5]))
+        expected = x @ (0.5 * w_q.astype(mx.float32)).T
+        tol = 0.05 * mx.abs(expected).max().item()
+        self.assertTrue(mx.allclose(out, expected, atol=tol))
+
+        with self.assertRaises(ValueError):
+            mx.quantized_matmul(x, w_q, scales, transpose=False, mode="int8")
+
+    def test_quantized_embedding(self):
+        V, D = 100, 256
+        table = mx.random.normal(shape=(V, D))
+        for bits in [2, 3, 4, 5, 6, 8]:
+            for group_size in [32, 64, 128]:
+                for dtype in [mx.float32, mx.float16]:
+                    w, scales, biases = mx.quantize(
+                        table.astype(dtype), group_size, bits
+                    )
+                    idx = mx.random.randint(-V, V, shape=(3, 7))
+                    out = mx.fast.quantized_embedding(
+                        w, scales, biases, idx, group_size, bits
+                    )
+                    expected = mx.dequantize(
+                        w[idx], scales[idx], biases[idx], group_size, bits
+                    )
+                    self.assertEqual(out.shape, (3, 7, D))
+                    self.assertEqual(out.dtype, dtype)
+                    self.assertTrue(mx.allclose(out, expected))
+
+        # Strided indices and scalar indices
+        w, scales, biases = mx.quantize(table)
+        idx = mx.arange(20).reshape(4, 5).T
+        out = mx.fast.quantized_embedding(w, scales, biases, idx)
+        expected = mx.dequantize(w[idx], scales[idx], biases[idx])
+        self.assertTrue(mx.allclose(out, expected))
+        out = mx.fast.quantized_embedding(w, scales, biases, mx.array(3))
+        self.assertEqual(out.shape, (D,))
+        self.assertTrue(mx.allclose(out, mx.dequantize(w, scales, biases)[3]))
+
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_embedding(w, scales, biases, idx, bits=8)
+        with self.assertRaises(ValueError):
+            mx.fast.quantized_embedding(w, scales, biases, idx.astype(mx.float32))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
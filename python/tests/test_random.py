@@ -387,6 +387,37 @@ class TestRandom(mlx_tests.MLXTestCase):
         self.assertEqual(sample.shape, (3, 4, 2))
         self.assertEqual(sample.dtype, mx.float16)
 
+    def test_distributions_match_bits(self):
+        key = mx.random.key(7)
+        for shape in [(1,), (7,), (4, 33)]:
+            bits = mx.random.bits(shape, key=key)
+            u = mx.minimum(bits.astype(mx.float32) / 2**32, 1.0 - 2**-24)
+            expected = 3.0 * u - 1.0
+            out = mx.random.uniform(-1.0, 2.0, shape, key=key)
+            self.assertTrue(mx.array_equal(out, expected))
+
+            expected = bits < 0.25 * (2**32 + 2**9)
+            out = mx.random.bernoulli(0.25, shape, key=key)
+            self.assertTrue(mx.array_equal(out, expected))
+
+        # The fused samples match the composite of the cpu
+        shape = (9, 5)
+        for dtype in [mx.float32, mx.float16, mx.bfloat16]:
+            samplers = [
+                lambda s: mx.random.uniform(
+                    shape=shape, dtype=dtype, key=key, stream=s
+                ),
+                lambda s: mx.random.normal(
+                    shape, dtype, 1.0, 2.0, key=key, stream=s
+                ),
+                lambda s: mx.random.gumbel(shape, dtype, key=key, stream=s),
+            ]
+            for sample in samplers:
+                a = sample(mx.default_device())
+                b = sample(mx.cpu)
+                self.assertEqual(a.dtype, dtype)
+                self.assertTrue(mx.allclose(a, b, rtol=1e-2, atol=1e-2))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner()
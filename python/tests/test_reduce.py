@@ -210,6 +210,28 @@ class TestReduce(mlx_tests.MLXTestCase):
                     ref = getattr(np, op)(np_arr, axis=axis)
                     self.assertTrue(np.array_equal(out, ref, equal_nan=True))
 
+    def test_strided_and_broadcasted_reductions(self):
+        np.random.seed(0)
+        x_np = np.random.randint(-1, 2, (8, 16, 32)).astype(np.int32)
+        x = mx.array(x_np)
+        b_np = np.broadcast_to(x_np[:, :1, :], (8, 16, 32))
+        b = mx.broadcast_to(x[:, :1, :], (8, 16, 32))
+        views = [
+            (x.transpose(2, 0, 1), x_np.transpose(2, 0, 1)),
+            (x[::2, 1:, ::3], x_np[::2, 1:, ::3]),
+            (x[:, :, 1:], x_np[:, :, 1:]),
+            (b, b_np),
+            (b.transpose(1, 2, 0), b_np.transpose(1, 2, 0)),
+        ]
+        for a, a_np in views:
+            for op in ["sum", "max", "min", "prod"]:
+                for axes in [0, 1, 2, (0, 1), (1, 2), (0, 2), None]:
+                    out = getattr(mx, op)(a, axis=axes)
+                    ref = getattr(np, op)(a_np, axis=axes)
+                    self.assertTrue(np.array_equal(out, ref))
+            out = mx.mean(a.astype(mx.float32), axis=1)
+            self.assertTrue(np.allclose(out, np.mean(a_np, axis=1)))
+
 
 if __name__ == "__main__":
     mlx_tests.MLXTestRunner(failfast=True)
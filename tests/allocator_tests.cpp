@@ -5,6 +5,7 @@
 #include "doctest/doctest.h"
 
 #include "mlx/allocator.h"
+#include "mlx/memory.h"
 
 using namespace mlx::core;
 
@@ -39,3 +40,25 @@ TEST_CASE("test large allocations") {
     allocator::free(buffer);
   }
 }
+
+TEST_CASE("test allocator cache") {
+  clear_cache();
+  reset_cache_info();
+  // The small buffers and the large ones backed by huge pages.
+  for (size_t size : {size_t(1000), size_t(3) << 20}) {
+    for (int i = 0; i < 3; ++i) {
+      auto buffer = allocator::malloc(size);
+      CHECK_EQ(allocator::allocator().size(buffer), size);
+      static_cast<char*>(buffer.raw_ptr())[size - 1] = 1;
+      allocator::free(buffer);
+    }
+  }
+  CHECK(get_cache_memory() >= (size_t(3) << 20));
+  auto info = get_cache_info();
+  CHECK(info["hits"] > 0);
+  CHECK(info["reused_bytes"] >= info["requested_bytes"]);
+
+  clear_cache();
+  CHECK_EQ(get_cache_memory(), 0);
+  CHECK(get_cache_info()["evictions"] > 0);
+}
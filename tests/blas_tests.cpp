@@ -108,3 +108,20 @@ TEST_CASE("test matmul") {
   out = matmul(transpose(a, {0, 2, 1}), transpose(b, {0, 2, 1}));
   CHECK(array_equal(out, full({2, 4, 4}, 2.0f)).item<bool>());
 }
+
+TEST_CASE("test half precision matmul") {
+  // Larger than the tiles of the packed GEMM and not a multiple of them,
+  // with odd depths for the pairs of bfloat16.
+  auto a = random::uniform({2, 70, 301}, float32, random::key(0));
+  auto b = random::uniform({301, 260}, float32, random::key(1));
+  auto expected = matmul(a, b, Device::cpu);
+  for (auto t : {float16, bfloat16}) {
+    auto out = matmul(astype(a, t), astype(b, t), Device::cpu);
+    CHECK(allclose(astype(out, float32), expected, 2e-2, 2e-1).item<bool>());
+    out = matmul(
+        transpose(astype(transpose(a, {0, 2, 1}), t), {0, 2, 1}),
+        transpose(astype(transpose(b), t)),
+        Device::cpu);
+    CHECK(allclose(astype(out, float32), expected, 2e-2, 2e-1).item<bool>());
+  }
+}
@@ -53,3 +53,30 @@ TEST_CASE("test checkpointing") {
   CHECK_EQ(g[1].item<float>(), 66.0f);
   CHECK_EQ(cnt, 2);
 }
+
+TEST_CASE("test checkpointing with a policy") {
+  auto x = reshape(arange(6.0f), {2, 3}) / 6;
+  auto w = reshape(arange(9.0f), {3, 3}) / 9;
+
+  int cnt = 0;
+  auto fn = [&cnt](const std::vector<array>& inputs) {
+    cnt++;
+    auto y = exp(matmul(inputs[0], inputs[1]));
+    return std::vector<array>{sum(matmul(y, inputs[1]) * inputs[0])};
+  };
+  auto one = array(1.0f);
+  auto [_, expected] = vjp(fn, {x, w}, {one});
+
+  std::vector<std::function<bool(const Primitive&)>> policies = {
+      save_matmuls,
+      [](const Primitive&) { return false; },
+      [](const Primitive&) { return true; }};
+  for (auto& policy : policies) {
+    cnt = 0;
+    auto [z, g] = vjp(checkpoint(fn, policy), {x, w}, {one});
+    CHECK(allclose(g[0], expected[0]).item<bool>());
+    CHECK(allclose(g[1], expected[1]).item<bool>());
+    // The recomputation replays the recorded graph
+    CHECK_EQ(cnt, 1);
+  }
+}
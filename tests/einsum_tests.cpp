@@ -50,6 +50,26 @@ TEST_CASE("test einsum path") {
   CHECK_EQ(path, expected);
 }
 
+TEST_CASE("test einsum optimal path") {
+  // Greedily the smallest intermediate is made first, though making the
+  // other one costs fewer FLOPs.
+  auto operands = {ones({5, 8}), ones({8, 10}), ones({10, 7})};
+  std::vector<std::vector<int>> expected = {{1, 2}, {0, 1}};
+  CHECK_EQ(einsum_path("ij,jk,kl", operands).first, expected);
+  expected = {{0, 1}, {0, 1}};
+  CHECK_EQ(einsum_path("ij,jk,kl", operands, "optimal").first, expected);
+  CHECK_THROWS(einsum_path("ij,jk,kl", operands, "fastest"));
+
+  // The cached path is the same
+  CHECK_EQ(einsum_path("ij,jk,kl", operands, "optimal").first, expected);
+
+  auto x = full({5, 8}, 2.0f);
+  auto y = full({8, 10}, 1.0f);
+  auto z = full({10, 7}, 0.5f);
+  auto out = einsum("ij,jk,kl", {x, y, z});
+  CHECK(array_equal(out, full({5, 7}, 80.0f)).item<bool>());
+}
+
 TEST_CASE("test einsum") {
   CHECK_THROWS(einsum("i,j", {array({1.0})}));
   CHECK_THROWS(einsum("ijk", {full({2, 2}, 2.0f)}));
@@ -91,3 +91,105 @@ TEST_CASE("test eval graph retention when not tracing") {
   CHECK(!a.has_primitive());
   CHECK(a.is_available());
 }
+
+TEST_CASE("test eval repeated graphs") {
+  // The same graph is evaluated with other values, with shared arrays,
+  // arrays with siblings and arrays of another stream.
+  auto s = new_stream(default_device());
+  for (int i = 1; i < 4; ++i) {
+    auto x = full({4}, static_cast<float>(i));
+    auto y = exp(x);
+    auto qr = divmod(y + x, array(2.0f));
+    auto z = add(qr[0], y, s);
+    auto out = z * qr[1] + y;
+    eval(out);
+
+    auto ey = std::exp(static_cast<float>(i));
+    auto q = std::floor((ey + i) / 2);
+    auto r = ey + i - 2 * q;
+    auto expected = full({4}, (q + ey) * r + ey);
+    CHECK(allclose(out, expected, 1e-4, 1e-4).item<bool>());
+  }
+}
+
+TEST_CASE("test async eval future") {
+  auto x = full({4}, 2.0f);
+  auto y = exp(x);
+  std::atomic<int> calls{0};
+  auto future = async_eval(y);
+  future.then([&calls]() { calls++; });
+  future.wait();
+  CHECK(future.done());
+  CHECK(allclose(y, full({4}, std::exp(2.0f))).item<bool>());
+
+  // The callbacks run before the waiters are woken up or right away.
+  CHECK_EQ(calls, 1);
+  async_eval(y).then([&calls]() { calls++; });
+  CHECK_EQ(calls, 2);
+}
+
+TEST_CASE("test projected peak memory") {
+  auto x = ones({256});
+  eval(x);
+  auto y = exp(x);
+  auto z = multiply(y, y);
+  // y is freed once z is made
+  CHECK_EQ(projected_peak_memory({z}) - get_active_memory(), 2048);
+  CHECK_EQ(projected_peak_memory({y, z}) - get_active_memory(), 2048);
+  CHECK_EQ(projected_peak_memory({x}), get_active_memory());
+  CHECK(allclose(z, exp(2 * x)).item<bool>());
+}
+
+TEST_CASE("test host callback errors") {
+  // The errors of the function can not be raised on the thread of the
+  // stream, the next wait throws them and the outputs are NaNs or zeros.
+  auto x = ones({3});
+  auto wrong_count = host_callback(
+      [](const std::vector<array>&) { return std::vector<array>{}; },
+      {x},
+      {{3}},
+      {float32});
+  CHECK_THROWS_AS(eval(wrong_count), std::runtime_error);
+  CHECK(all(isnan(wrong_count[0])).item<bool>());
+
+  auto wrong_shape = host_callback(
+      [](const std::vector<array>&) {
+        return std::vector<array>{ones({2}, int32)};
+      },
+      {x},
+      {{3}},
+      {int32});
+  CHECK_THROWS_AS(wrong_shape[0].eval(), std::runtime_error);
+  CHECK(array_equal(wrong_shape[0], zeros({3}, int32)).item<bool>());
+
+  // The error is thrown by the wait for the arrays which use the outputs.
+  auto throws = host_callback(
+      [](const std::vector<array>&) -> std::vector<array> {
+        throw std::invalid_argument("Failed.");
+      },
+      {x},
+      {{3}},
+      {float32});
+  auto y = throws[0] + x;
+  CHECK_THROWS_AS(eval(y), std::invalid_argument);
+  CHECK(all(isnan(y)).item<bool>());
+  CHECK(array_equal(x + x, full({3}, 2.0f)).item<bool>());
+}
+
+TEST_CASE("test eval graphs with the same edges") {
+  // The graphs have as many arrays and edges but the DFS leaves their
+  // arrays in another order, so the schedule of the first does not run the
+  // second.
+  StreamOrDevice s = Device::cpu;
+  auto c = array(0.5f);
+  auto d = array(0.25f);
+  auto x = add(exp(exp(c, s), s), exp(d, s), s);
+  eval(x);
+  auto y = exp(exp(add(c, exp(d, s), s), s), s);
+  eval(y);
+
+  CHECK(allclose(x, array(std::exp(std::exp(0.5f)) + std::exp(0.25f)))
+            .item<bool>());
+  CHECK(allclose(y, array(std::exp(std::exp(0.5f + std::exp(0.25f)))))
+            .item<bool>());
+}
@@ -364,3 +364,21 @@ TEST_CASE("test fftshift and ifftshift") {
   CHECK_THROWS_AS(fft::ifftshift(x, {3}), std::invalid_argument);
   CHECK_THROWS_AS(fft::ifftshift(x, {-5}), std::invalid_argument);
 }
+
+TEST_CASE("test batched ffts") {
+  // Large enough for the rows to be split over the CPU threads
+  auto x = random::uniform({257, 512});
+  auto y = fft::rfft(x, -1, Device::cpu);
+  for (int i : {0, 100, 256}) {
+    auto row = slice(x, {i, 0}, {i + 1, 512});
+    auto expected = fft::rfft(row, -1, Device::cpu);
+    CHECK(allclose(slice(y, {i, 0}, {i + 1, 257}), expected)
+              .item<bool>());
+  }
+  CHECK(allclose(fft::irfft(y, 512, -1, Device::cpu), x, 1e-5, 1e-5)
+            .item<bool>());
+
+  auto z = astype(x, complex64);
+  auto w = fft::ifft(fft::fft(z, 0, Device::cpu), 0, Device::cpu);
+  CHECK(allclose(w, z, 1e-5, 1e-5).item<bool>());
+}
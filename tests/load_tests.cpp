@@ -1,6 +1,7 @@
 // Copyright © 2023 Apple Inc.
 
 #include <filesystem>
+#include <fstream>
 #include <stdexcept>
 #include <vector>
 
@@ -14,6 +15,105 @@ std::string get_temp_file(const std::string& name) {
   return std::filesystem::temp_directory_path().append(name).string();
 }
 
+// The GGML types of the tensors written by write_gguf.
+enum GGMLType : uint32_t {
+  GGML_F32 = 0,
+  GGML_F16 = 1,
+  GGML_Q8_0 = 8,
+  GGML_Q4_K = 12,
+  GGML_Q5_K = 13,
+  GGML_Q6_K = 14,
+};
+
+struct GGUFTensor {
+  std::string name;
+  // In the order of GGML, the reverse of the order of MLX.
+  std::vector<uint64_t> dims;
+  GGMLType type;
+  std::vector<uint8_t> data;
+};
+
+template <typename T>
+void append_bytes(std::vector<uint8_t>& data, T value) {
+  auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  data.insert(data.end(), bytes, bytes + sizeof(T));
+}
+
+// Write a GGUF file without metadata, which save_gguf can not do for the
+// types other than those of MLX.
+void write_gguf(const std::string& file, std::vector<GGUFTensor> tensors) {
+  constexpr size_t alignment = 32;
+  std::vector<uint8_t> header;
+  append_bytes(header, uint32_t(0x46554747)); // GGUF
+  append_bytes(header, uint32_t(3));
+  append_bytes(header, uint64_t(tensors.size()));
+  append_bytes(header, uint64_t(0));
+  uint64_t offset = 0;
+  for (auto& t : tensors) {
+    append_bytes(header, uint64_t(t.name.size()));
+    header.insert(header.end(), t.name.begin(), t.name.end());
+    append_bytes(header, uint32_t(t.dims.size()));
+    for (auto dim : t.dims) {
+      append_bytes(header, dim);
+    }
+    append_bytes(header, uint32_t(t.type));
+    append_bytes(header, offset);
+    t.data.resize((t.data.size() + alignment - 1) / alignment * alignment);
+    offset += t.data.size();
+  }
+  header.resize((header.size() + alignment - 1) / alignment * alignment);
+  std::ofstream f(file, std::ios::binary);
+  f.write(reinterpret_cast<const char*>(header.data()), header.size());
+  for (auto& t : tensors) {
+    f.write(reinterpret_cast<const char*>(t.data.data()), t.data.size());
+  }
+}
+
+// The 6 bit scale and min of the sub-block |j| of a K-quant super-block, as
+// in get_scale_min_k4 of ggml.
+std::pair<int, int> ggml_scale_min_k4(int j, const uint8_t* q) {
+  if (j < 4) {
+    return {q[j] & 63, q[j + 4] & 63};
+  }
+  return {
+      (q[j + 4] & 0xF) | ((q[j - 4] >> 6) << 4),
+      (q[j + 4] >> 4) | ((q[j] >> 6) << 4)};
+}
+
+// The weights of Q4_K and Q5_K super-blocks, as in dequantize_row_q4_K and
+// dequantize_row_q5_K of ggml.
+std::vector<float> ggml_dequantize_q_k(const std::vector<uint8_t>& data) {
+  bool q5 = data.size() % 176 == 0;
+  size_t block_bytes = q5 ? 176 : 144;
+  std::vector<float> y;
+  for (size_t b = 0; b < data.size(); b += block_bytes) {
+    const uint8_t* x = data.data() + b;
+    float d = *reinterpret_cast<const float16_t*>(x);
+    float min = *reinterpret_cast<const float16_t*>(x + 2);
+    const uint8_t* scales = x + 4;
+    const uint8_t* qh = x + 16;
+    const uint8_t* ql = x + (q5 ? 48 : 16);
+    uint8_t u1 = 1;
+    uint8_t u2 = 2;
+    for (int is = 0; is < 8; is += 2) {
+      auto [sc1, m1] = ggml_scale_min_k4(is, scales);
+      auto [sc2, m2] = ggml_scale_min_k4(is + 1, scales);
+      for (int l = 0; l < 32; ++l) {
+        int q = (ql[l] & 0xF) + (q5 && (qh[l] & u1) ? 16 : 0);
+        y.push_back(d * sc1 * q - min * m1);
+      }
+      for (int l = 0; l < 32; ++l) {
+        int q = (ql[l] >> 4) + (q5 && (qh[l] & u2) ? 16 : 0);
+        y.push_back(d * sc2 * q - min * m2);
+      }
+      ql += 32;
+      u1 <<= 2;
+      u2 <<= 2;
+    }
+  }
+  return y;
+}
+
 TEST_CASE("test save_safetensors") {
   std::string file_path = get_temp_file("test_arr.safetensors");
   auto map = std::unordered_map<std::string, array>();
@@ -40,6 +140,84 @@ TEST_CASE("test save_safetensors") {
   CHECK(array_equal(test2, ones({2, 2})).item<bool>());
 }
 
+TEST_CASE("test save_safetensors async") {
+  std::string file_path = get_temp_file("test_async.safetensors");
+  auto a = arange(1 << 20, float32);
+  auto b = transpose(reshape(arange(6, int32), {2, 3}));
+  auto saved = save_safetensors_async(
+      file_path, {{"a", a}, {"b", b}}, {{"step", "1"}});
+  // The arrays can be used while they are written.
+  auto c = add(a, array(1.0f));
+  eval(c);
+  saved.get();
+
+  auto [dict, metadata] = load_safetensors(file_path);
+  CHECK_EQ(metadata.at("step"), "1");
+  CHECK(array_equal(dict.at("a"), a).item<bool>());
+  CHECK(array_equal(dict.at("b"), b).item<bool>());
+}
+
+TEST_CASE("test mmap safetensors") {
+  std::string file_path = get_temp_file("test_mmap.safetensors");
+  auto map = std::unordered_map<std::string, array>();
+  map.insert({"a", arange(1000, float32)});
+  map.insert({"b", array({1, 2, 3}, uint8)});
+  map.insert({"c", full({10}, 2, int64)});
+  save_safetensors(file_path, map);
+  {
+    auto [dict, metadata] = load_safetensors(file_path, {}, true);
+    CHECK_EQ(dict.size(), 3);
+    for (auto& [k, v] : map) {
+      CHECK(array_equal(dict.at(k), v).item<bool>());
+    }
+    // Writing to the pages through a donation does not change the file.
+    auto a = dict.at("a");
+    eval(a);
+    dict.clear();
+    auto b = add(std::move(a), array(1.0f));
+    CHECK(array_equal(b, arange(1, 1001, float32)).item<bool>());
+  }
+  auto [dict, metadata] = load_safetensors(file_path);
+  CHECK(array_equal(dict.at("a"), arange(1000, float32)).item<bool>());
+}
+
+TEST_CASE("test load large safetensors") {
+  // Several reads of the io_uring or the threads, at unaligned offsets.
+  std::string file_path = get_temp_file("test_large.safetensors");
+  auto map = std::unordered_map<std::string, array>();
+  map.insert({"a", array({1, 2, 3}, uint8)});
+  map.insert({"b", arange(3 << 20, int32)});
+  save_safetensors(file_path, map);
+  auto [dict, metadata] = load_safetensors(file_path);
+  CHECK(array_equal(dict.at("a"), map.at("a")).item<bool>());
+  CHECK(array_equal(dict.at("b"), map.at("b")).item<bool>());
+}
+
+TEST_CASE("test load sharded safetensors") {
+  std::vector<std::string> files = {
+      get_temp_file("test_shard_0.safetensors"),
+      get_temp_file("test_shard_1.safetensors")};
+  save_safetensors(
+      files[0],
+      {{"a", arange(1000, float32)}, {"b", array({1, 2, 3}, int32)}},
+      {{"format", "mlx"}});
+  save_safetensors(files[1], {{"c", ones({64, 64}, bfloat16)}});
+
+  // A budget smaller than the arrays evaluates them one at a time.
+  auto [dict, metadata] = load_sharded(files, float16, 16);
+  CHECK_EQ(dict.size(), 3);
+  CHECK_EQ(metadata.at("format"), "mlx");
+  CHECK_EQ(dict.at("a").dtype(), float16);
+  CHECK_EQ(dict.at("b").dtype(), int32);
+  CHECK_EQ(dict.at("c").dtype(), float16);
+  CHECK(array_equal(dict.at("a"), arange(1000, float16)).item<bool>());
+  CHECK(array_equal(dict.at("b"), array({1, 2, 3}, int32)).item<bool>());
+  CHECK(array_equal(dict.at("c"), ones({64, 64}, float16)).item<bool>());
+
+  // The names of the arrays are unique across the shards.
+  CHECK_THROWS_AS(load_sharded({files[0], files[0]}), std::invalid_argument);
+}
+
 TEST_CASE("test gguf") {
   std::string file_path = get_temp_file("test_arr.gguf");
   using dict = std::unordered_map<std::string, array>;
@@ -201,6 +379,110 @@ TEST_CASE("test gguf metadata") {
   }
 }
 
+TEST_CASE("test gguf tensor types") {
+  std::string file_path = get_temp_file("test_types.gguf");
+
+  std::vector<uint8_t> a_data;
+  for (int i = 0; i < 8; ++i) {
+    append_bytes(a_data, static_cast<float>(i));
+  }
+  std::vector<uint8_t> b_data;
+  for (float x : {1.0f, -2.0f, 0.5f}) {
+    append_bytes(b_data, float16_t(x));
+  }
+  // A Q6_K super-block of 256 weights: 128 bytes of the low 4 bits, 64
+  // bytes of the high 2 bits, 16 int8 scales and the 16 bit scale. Each
+  // half of 128 weights has 64 weights of 1 - 32 then 64 of 2 - 32.
+  std::vector<uint8_t> c_data(128, 0x21);
+  c_data.resize(128 + 64, 0);
+  c_data.resize(128 + 64 + 16, 1);
+  append_bytes(c_data, float16_t(0.5f));
+
+  write_gguf(
+      file_path,
+      {{"a", {4, 2}, GGML_F32, a_data},
+       {"b", {3}, GGML_F16, b_data},
+       {"c", {256}, GGML_Q6_K, c_data}});
+  auto c_half =
+      concatenate({full({64}, -15.5f, float16), full({64}, -15.0f, float16)});
+  std::unordered_map<std::string, array> expected = {
+      {"a", reshape(arange(8, float32), {2, 4})},
+      {"b", array({1.0f, -2.0f, 0.5f}, float16)},
+      {"c", concatenate({c_half, c_half})}};
+  auto check_loaded = [&expected](const std::string& file) {
+    auto [loaded_weights, loaded_metadata] = load_gguf(file);
+    CHECK_EQ(loaded_weights.size(), 3);
+    for (auto& [k, v] : expected) {
+      auto& loaded = loaded_weights.at(k);
+      CHECK_EQ(loaded.dtype(), v.dtype());
+      CHECK(array_equal(loaded, v).item<bool>());
+    }
+    return loaded_weights;
+  };
+
+  // The loaded arrays are saved and loaded again, the dequantized ones as
+  // float16.
+  auto loaded_weights = check_loaded(file_path);
+  std::string saved_path = get_temp_file("test_types_saved.gguf");
+  save_gguf(saved_path, loaded_weights);
+  check_loaded(saved_path);
+
+  // The converted tensors are waited for before throwing the error of one
+  // of them, here a name which is already loaded.
+  std::vector<uint8_t> q8_0_block;
+  append_bytes(q8_0_block, float16_t(1.0f));
+  q8_0_block.resize(34, 0);
+  std::vector<GGUFTensor> tensors = {
+      {"d.scales", {1}, GGML_F32, std::vector<uint8_t>(4, 0)},
+      {"d.weight", {32}, GGML_Q8_0, q8_0_block}};
+  for (int i = 0; i < 16; ++i) {
+    std::vector<uint8_t> data;
+    for (int j = 0; j < 64; ++j) {
+      data.insert(data.end(), q8_0_block.begin(), q8_0_block.end());
+    }
+    tensors.push_back(
+        {"e" + std::to_string(i) + ".weight", {32 * 64}, GGML_Q8_0, data});
+  }
+  file_path = get_temp_file("test_duplicate.gguf");
+  write_gguf(file_path, tensors);
+  CHECK_THROWS_AS(load_gguf(file_path), std::runtime_error);
+}
+
+TEST_CASE("test gguf k-quants") {
+  std::string file_path = get_temp_file("test_k_quants.gguf");
+
+  // Two super-blocks of pseudo-random bytes, with small scales so that the
+  // weights are nearly exact in float16.
+  uint32_t state = 1;
+  auto next_byte = [&state]() {
+    state = state * 1664525 + 1013904223;
+    return static_cast<uint8_t>(state >> 24);
+  };
+  for (auto [type, bits] : {std::pair{GGML_Q4_K, 4}, {GGML_Q5_K, 5}}) {
+    std::vector<uint8_t> data;
+    for (int b = 0; b < 2; ++b) {
+      append_bytes(data, float16_t(1.0f / 64));
+      append_bytes(data, float16_t(1.0f / 128));
+      int num_bytes = 12 + (bits == 5 ? 32 : 0) + 128;
+      for (int i = 0; i < num_bytes; ++i) {
+        data.push_back(next_byte());
+      }
+    }
+    auto reference = ggml_dequantize_q_k(data);
+    auto expected = array(reference.data(), {2, 256});
+
+    write_gguf(file_path, {{"q.weight", {256, 2}, type, data}});
+    auto [loaded_weights, loaded_metadata] = load_gguf(file_path);
+    auto& w = loaded_weights.at("q.weight");
+    auto& scales = loaded_weights.at("q.scales");
+    auto& biases = loaded_weights.at("q.biases");
+    CHECK_EQ(w.shape(), Shape{2, 256 * bits / 32});
+    CHECK_EQ(scales.shape(), Shape{2, 8});
+    auto out = dequantize(w, scales, biases, 32, bits);
+    CHECK(allclose(astype(out, float32), expected, 1e-3, 1e-2).item<bool>());
+  }
+}
+
 TEST_CASE("test single array serialization") {
   // Basic test
   {
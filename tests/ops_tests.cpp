@@ -1841,6 +1841,23 @@ TEST_CASE("test arithmetic binary ops") {
   CHECK_EQ(logaddexp(x, y).item<complex64_t>(), complex64_t{1, 1});
 }
 
+TEST_CASE("test add inplace") {
+  auto x = ones({4, 4});
+  eval(x);
+  auto ptr = x.data<float>();
+  x = add_inplace(x, full({4}, 2.0f));
+  eval(x);
+  CHECK_EQ(x.data<float>(), ptr);
+  CHECK(array_equal(x, full({4, 4}, 3.0f)).item<bool>());
+
+  // The second input is cast to the type of the first
+  x = add_inplace(x, array(1));
+  CHECK_EQ(x.dtype(), float32);
+  CHECK(array_equal(x, full({4, 4}, 4.0f)).item<bool>());
+
+  CHECK_THROWS_AS(add_inplace(ones({4}), ones({2, 4})), std::invalid_argument);
+}
+
 TEST_CASE("test broadcast") {
   auto s = broadcast_shapes({1}, {1, 2});
   CHECK_EQ(s, Shape{1, 2});
@@ -3563,6 +3580,30 @@ TEST_CASE("test topk") {
   }
 }
 
+TEST_CASE("test sort and partition of long rows") {
+  // Long enough rows to be sorted on the radix of their keys
+  auto x = random::randint(-1000, 1000, {3, 5000});
+  for (auto t : {int32, int64, float32, float16}) {
+    auto xt = astype(x, t);
+    auto y = sort(xt, -1);
+    auto lo = slice(y, {0, 0}, {3, 4999});
+    auto hi = slice(y, {0, 1}, {3, 5000});
+    CHECK(all(less_equal(lo, hi)).item<bool>());
+    CHECK(array_equal(take_along_axis(xt, argsort(xt, -1), -1), y)
+              .item<bool>());
+
+    auto top = topk(xt, 10, -1);
+    CHECK(array_equal(sort(top, -1), slice(y, {0, 4990}, {3, 5000}))
+              .item<bool>());
+  }
+
+  // NaNs sort last
+  auto z = astype(slice(x, {0, 0}, {1, 5000}), float32);
+  z = where(equal(z, array(0.0f)), array(NAN), z);
+  auto y = sort(z, -1);
+  CHECK(isnan(slice(y, {0, 4999}, {1, 5000})).item<bool>());
+}
+
 TEST_CASE("test meshgrid") {
   // Test default
   auto x = array({1, 2, 3}, {3});
@@ -3932,6 +3973,38 @@ TEST_CASE("test bitwise shift operations") {
   CHECK(array_equal(right_shift_bool_result, full({4}, 0, uint8)).item<bool>());
 }
 
+TEST_CASE("test conv2d with many channels") {
+  // The sum over the channels of the ones at each position of the kernel
+  // within the input, 4, 6 or 9 with the padding.
+  for (int C : {3, 64}) {
+    auto x = ones({2, 9, 10, C});
+    auto w = ones({64, 3, 3, C});
+    auto y = conv2d(x, w, {1, 1}, {1, 1});
+    CHECK_EQ(y.shape(), Shape{2, 9, 10, 64});
+    auto counts = array({4.0f, 6.0f, 6.0f, 9.0f}, {1, 2, 2, 1});
+    auto samples = slice(y, {0, 0, 0, 0}, {2, 5, 6, 64}, {1, 4, 5, 1});
+    CHECK(allclose(samples, broadcast_to(counts * C, samples.shape()))
+              .item<bool>());
+  }
+
+  // Splitting the channels gives the same result
+  auto x = random::normal({1, 12, 12, 64});
+  auto w = random::normal({64, 3, 3, 64});
+  auto y = conv2d(x, w, {1, 1}, {1, 1});
+  auto y_split =
+      conv2d(
+          slice(x, {0, 0, 0, 0}, {1, 12, 12, 32}),
+          slice(w, {0, 0, 0, 0}, {64, 3, 3, 32}),
+          {1, 1},
+          {1, 1}) +
+      conv2d(
+          slice(x, {0, 0, 0, 32}, {1, 12, 12, 64}),
+          slice(w, {0, 0, 0, 32}, {64, 3, 3, 64}),
+          {1, 1},
+          {1, 1});
+  CHECK(allclose(y, y_split, 1e-3, 1e-3).item<bool>());
+}
+
 TEST_CASE("test conv_transpose1d with output_padding") {
   auto in = array({1.0, 2.0, 3.0}, {1, 1, 3});
   auto wt = array({1.0, 1.0, 1.0}, {1, 1, 3});
@@ -34,6 +34,17 @@ TEST_CASE("test stream management") {
   } else {
     CHECK_THROWS_AS(new_stream(Device::gpu), std::invalid_argument);
   }
+
+  auto s3 = new_stream(default_device(), 2);
+  CHECK_EQ(s3.priority, 2);
+  CHECK_EQ(get_stream(s3.index).priority, 2);
+  CHECK_EQ(s2.priority, 0);
+
+  auto s4 = new_stream(default_device(), 0, 0.5f);
+  CHECK_EQ(s4.sm_fraction, 0.5f);
+  CHECK_EQ(get_stream(s4.index).sm_fraction, 0.5f);
+  CHECK_THROWS_AS(new_stream(default_device(), 0, 0.0f), std::invalid_argument);
+  CHECK_THROWS_AS(new_stream(default_device(), 0, 2.0f), std::invalid_argument);
 }
 
 TEST_CASE("test asynchronous launch") {
@@ -119,3 +130,102 @@ TEST_CASE("test scheduler races") {
   }
   eval(a, y);
 }
+
+TEST_CASE("test parallel cpu kernels") {
+  // Large enough for the elementwise kernels to be split into chunks, on
+  // two streams sharing the pool of threads.
+  auto s1 = new_stream(Device::cpu);
+  auto s2 = new_stream(Device::cpu);
+  int n = (1 << 20) + 3;
+  auto x = arange(n, float32, s1);
+  auto y = arange(n, float32, s2);
+  std::vector<array> outs;
+  for (int i = 0; i < 4; ++i) {
+    outs.push_back(add(exp(multiply(x, array(0.0f), s1), s1), x, s1));
+    outs.push_back(subtract(y, abs(y, s2), s2));
+  }
+  eval(outs);
+  auto expected = arange(n, float32) + 1.0f;
+  for (int i = 0; i < 4; ++i) {
+    CHECK(array_equal(outs[2 * i], expected).item<bool>());
+    CHECK(array_equal(outs[2 * i + 1], zeros({n})).item<bool>());
+  }
+}
+
+TEST_CASE("test parallel cpu reductions and copies") {
+  auto s = new_stream(Device::cpu);
+  int n = (1 << 20) + 5;
+  int m = (1 << 18) + 1;
+
+  // The whole input split in parts, and the rows and columns in chunks.
+  CHECK_EQ(sum(ones({n}, int32, s), s).item<int>(), n);
+  auto a = reshape(arange(4 * m, float32, s), {m, 4}, s);
+  auto expected = arange(m, float32, s) * 16.0f + 6.0f;
+  CHECK(array_equal(sum(a, 1, false, s), expected, s).item<bool>());
+  auto last = reshape(slice(a, {m - 1, 0}, {m, 4}, s), {4}, s);
+  CHECK(array_equal(max(a, 0, false, s), last, s).item<bool>());
+
+  // A strided copy split in blocks of its last 3 dims.
+  auto b = reshape(arange(12 * n, int32, s), {2, n, 3, 2}, s);
+  auto c = copy(transpose(b, {1, 0, 3, 2}, s), s);
+  CHECK(array_equal(transpose(c, {1, 0, 3, 2}, s), b, s).item<bool>());
+}
+
+TEST_CASE("test stream task queue") {
+  // Tasks from several threads, with closures stored inline and on the
+  // heap, run once each and in order per thread.
+  auto s = new_stream(Device::cpu);
+  int n = 10000;
+  std::vector<std::vector<int>> seen(3);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 3; ++t) {
+    threads.emplace_back([&, t]() {
+      for (int i = 0; i < n; ++i) {
+        if (i % 3 == 0) {
+          std::array<int, 64> big{};
+          big[0] = i;
+          scheduler::enqueue(s, [&seen, t, big]() {
+            seen[t].push_back(big[0]);
+          });
+        } else {
+          scheduler::enqueue(s, [&seen, t, i]() { seen[t].push_back(i); });
+        }
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+  synchronize(s);
+  for (auto& v : seen) {
+    CHECK_EQ(v.size(), n);
+    bool in_order = true;
+    for (int i = 0; i < v.size(); ++i) {
+      in_order &= v[i] == i;
+    }
+    CHECK(in_order);
+  }
+
+  // Many small ops, batched by their measured time.
+  auto x = zeros({4}, float32, s);
+  for (int i = 0; i < 5000; ++i) {
+    x = add(x, array(1.0f), s);
+  }
+  CHECK(array_equal(x, full({4}, 5000.0f), s).item<bool>());
+}
+
+TEST_CASE("test stream numa node") {
+  auto s = new_stream(Device::cpu);
+  set_numa_node(s, 0);
+  int n = (1 << 20) + 7;
+  auto x = add(arange(n, float32, s), array(1.0f), s);
+  auto expected = arange(1.0, n + 1.0, float32, s);
+  CHECK(array_equal(x, expected, s).item<bool>());
+  set_numa_node(s, -1);
+  CHECK_THROWS_AS(set_numa_node(s, -2), std::invalid_argument);
+  CHECK_THROWS_AS(set_numa_node(s, 1 << 20), std::invalid_argument);
+  if (is_available(Device::gpu)) {
+    auto s_gpu = new_stream(Device::gpu);
+    CHECK_THROWS_AS(set_numa_node(s_gpu, 0), std::invalid_argument);
+  }
+}
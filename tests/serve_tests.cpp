@@ -0,0 +1,177 @@
+// Copyright © 2025 Apple Inc.
+
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+#include "doctest/doctest.h"
+
+#include "mlx/mlx.h"
+#include "mlx/serve/engine.h"
+
+using namespace mlx::core;
+
+namespace {
+
+constexpr int vocab_size = 64;
+
+// A model which writes the tokens to the cache and predicts the position of
+// the next token.
+std::vector<array> toy_model(const Kwargs& kwargs) {
+  auto& tokens = kwargs.at("tokens");
+  auto& context_lens = kwargs.at("context_lens");
+  int B = tokens.shape(0);
+  int L = tokens.shape(1);
+  auto keys = broadcast_to(
+      reshape(astype(tokens, float32), {B, 1, L, 1}), {B, 1, L, 2});
+  auto [k_pages, v_pages] = fast::paged_kv_write(
+      kwargs.at("k_pages_0"),
+      kwargs.at("v_pages_0"),
+      keys,
+      keys,
+      kwargs.at("block_table"),
+      context_lens);
+  auto next = add(context_lens, array(L));
+  auto logits = multiply(
+      astype(equal(expand_dims(next, 1), arange(vocab_size)), float32),
+      array(100.0f));
+  return {logits, k_pages, v_pages};
+}
+
+serve::EngineConfig toy_config() {
+  serve::EngineConfig config;
+  config.num_layers = 1;
+  config.n_kv_heads = 1;
+  config.head_dim = 2;
+  config.dtype = float32;
+  config.num_pages = 8;
+  config.page_size = 4;
+  config.max_context = 32;
+  config.max_batch_size = 4;
+  config.prefill_chunk_size = 3;
+  return config;
+}
+
+// Run the engine until it is done and return the tokens of each request.
+std::map<int, std::vector<int>> run(serve::Engine& engine) {
+  std::map<int, std::vector<int>> tokens;
+  std::map<int, bool> finished;
+  while (engine.has_work()) {
+    for (auto& e : engine.step()) {
+      CHECK_FALSE(finished[e.request]);
+      tokens[e.request].push_back(e.token);
+      finished[e.request] = e.finished;
+    }
+  }
+  for (auto& [id, f] : finished) {
+    CHECK(f);
+  }
+  return tokens;
+}
+
+} // namespace
+
+TEST_CASE("test serve engine generate") {
+  serve::Engine engine(toy_model, toy_config());
+  int id = engine.add_request({{5, 6, 7, 8, 9}, 4});
+  auto tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{5, 6, 7, 8});
+  CHECK_EQ(engine.num_free_pages(), 8);
+
+  // One token
+  id = engine.add_request({{1, 2}, 1});
+  tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{2});
+
+  // Stop tokens are returned and end the request
+  id = engine.add_request({{1, 2}, 10, 0.0f, {4}});
+  tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{2, 3, 4});
+  CHECK_EQ(engine.num_free_pages(), 8);
+
+  // Sampling
+  id = engine.add_request({{1, 2, 3}, 3, 1.0f});
+  tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{3, 4, 5});
+}
+
+TEST_CASE("test serve engine batching") {
+  serve::Engine engine(toy_model, toy_config());
+
+  // Each request needs 3 pages so only 2 run at once
+  std::vector<int> ids;
+  std::vector<int> prompt_lens = {1, 7, 4, 2};
+  for (int n : prompt_lens) {
+    ids.push_back(engine.add_request({std::vector<int>(n, 0), 12 - n, 0.5f}));
+  }
+  engine.step();
+  CHECK_EQ(engine.num_running(), 2);
+  CHECK_EQ(engine.num_waiting(), 2);
+
+  auto tokens = run(engine);
+  for (size_t i = 0; i < ids.size(); ++i) {
+    std::vector<int> expected;
+    for (int t = prompt_lens[i]; t < 12; ++t) {
+      expected.push_back(t);
+    }
+    CHECK_EQ(tokens[ids[i]], expected);
+  }
+  CHECK_EQ(engine.num_free_pages(), 8);
+}
+
+TEST_CASE("test serve engine prefix cache") {
+  int num_tokens = 0;
+  auto model = [&num_tokens](const Kwargs& kwargs) {
+    num_tokens += kwargs.at("tokens").size();
+    return toy_model(kwargs);
+  };
+  serve::Engine engine(model, toy_config());
+
+  std::vector<int> prompt = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+  int id = engine.add_request({prompt, 2});
+  auto tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{9, 10});
+  CHECK_EQ(num_tokens, 10);
+  CHECK_EQ(engine.num_cached_pages(), 2);
+  CHECK_EQ(engine.num_free_pages(), 8);
+
+  // Only the last token of the prompt is run
+  num_tokens = 0;
+  id = engine.add_request({prompt, 2});
+  tokens = run(engine);
+  CHECK_EQ(tokens[id], std::vector<int>{9, 10});
+  CHECK_EQ(num_tokens, 2);
+
+  // A different prompt evicts the cached pages to fit
+  num_tokens = 0;
+  id = engine.add_request({std::vector<int>(20, 1), 12});
+  tokens = run(engine);
+  CHECK_EQ(tokens[id].size(), 12);
+  CHECK_EQ(num_tokens, 31);
+  CHECK_EQ(engine.num_cached_pages(), 5);
+  CHECK_EQ(engine.num_free_pages(), 8);
+
+  // Disabled
+  auto config = toy_config();
+  config.enable_prefix_cache = false;
+  serve::Engine uncached(model, config);
+  for (int i = 0; i < 2; ++i) {
+    num_tokens = 0;
+    uncached.add_request({prompt, 2});
+    run(uncached);
+    CHECK_EQ(num_tokens, 10);
+  }
+  CHECK_EQ(uncached.num_cached_pages(), 0);
+}
+
+TEST_CASE("test serve engine errors") {
+  serve::Engine engine(toy_model, toy_config());
+  CHECK_THROWS_AS(engine.add_request({{}, 4}), std::invalid_argument);
+  CHECK_THROWS_AS(engine.add_request({{1}, 0}), std::invalid_argument);
+  CHECK_THROWS_AS(engine.add_request({{1}, 40}), std::invalid_argument);
+  CHECK_FALSE(engine.has_work());
+
+  auto config = toy_config();
+  config.page_size = 0;
+  CHECK_THROWS_AS(serve::Engine(toy_model, config), std::invalid_argument);
+}